@@ -33,6 +33,7 @@
 #define sbpl_collision_attached_bodies_collision_model_h
 
 // standard includes
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -78,6 +79,11 @@ public:
     auto attachedBodyIndices(int lidx) const -> const std::vector<int>&;
 
     int version() const;
+
+    void clearModelCache();
+
+    void setUseDistanceFields(bool enabled);
+    bool useDistanceFields() const;
     ///@}
 
     /// \name Attached Bodies Collision Model
@@ -94,6 +100,10 @@ public:
     size_t voxelsModelCount() const;
     auto   voxelsModel(int vmidx) const -> const CollisionVoxelsModel&;
 
+    bool   hasDistanceFieldModel(int abidx) const;
+    auto   distanceFieldModel(int abidx) const
+            -> const CollisionDistanceFieldModel*;
+
     size_t groupCount() const;
     auto   group(int gidx) const -> const CollisionGroupModel&;
     bool   hasGroup(const std::string& group_name) const;
@@ -114,6 +124,7 @@ private:
 
         CollisionSpheresModel* spheres_model;
         CollisionVoxelsModel* voxels_model;
+        CollisionDistanceFieldModel* distance_field_model;
     };
 
     const RobotCollisionModel*                  m_model;
@@ -132,13 +143,52 @@ private:
     // Collision Model
     std::vector<std::unique_ptr<CollisionSpheresModel>> m_spheres_models;
     std::vector<std::unique_ptr<CollisionVoxelsModel>>  m_voxels_models;
+    std::vector<std::unique_ptr<CollisionDistanceFieldModel>> m_distance_field_models;
     std::vector<CollisionGroupModel>                    m_group_models;
     hash_map<std::string, int>                          m_group_name_to_index;
 
     int m_version;
 
+    // whether to create distance field models for newly attached bodies
+    bool m_use_distance_fields;
+
+    // models of previously attached bodies, in the frame of the body's first
+    // shape, keyed on the model resolutions, the content of the body's shapes,
+    // and their offsets from the first shape
+    struct BodyModelKey
+    {
+        std::vector<int> types;
+        std::vector<double> params;
+        std::vector<std::uint32_t> indices;
+
+        bool operator==(const BodyModelKey& o) const;
+    };
+
+    struct BodyModelKeyHash
+    {
+        auto operator()(const BodyModelKey& key) const -> size_t;
+    };
+
+    struct CachedBodyModel
+    {
+        bool has_spheres = false;
+        CollisionSphereModelTree spheres;
+
+        bool has_voxels = false;
+        std::vector<Eigen::Vector3d> voxels;
+
+        bool has_distance_field = false;
+        CollisionDistanceFieldModel distance_field;
+    };
+
+    hash_map<BodyModelKey, CachedBodyModel, BodyModelKeyHash> m_body_models;
+
     int generateAttachedBodyIndex();
 
+    auto cachedBodyModel(
+        const std::vector<shapes::ShapeConstPtr>& shapes,
+        const Affine3dVector& transforms) -> CachedBodyModel*;
+
     CollisionSpheresModel* createSpheresModel(
         int abidx,
         const std::string& id,
@@ -151,6 +201,12 @@ private:
         const std::vector<shapes::ShapeConstPtr>& shapes,
         const Affine3dVector& transforms);
 
+    CollisionDistanceFieldModel* createDistanceFieldModel(
+        int abidx,
+        const std::string& id,
+        const std::vector<shapes::ShapeConstPtr>& shapes,
+        const Affine3dVector& transforms);
+
     void generateSpheresModel(
         const std::string& id,
         const std::vector<shapes::ShapeConstPtr>& shapes,
@@ -244,6 +300,12 @@ int AttachedBodiesCollisionModel::version() const
     return m_version;
 }
 
+inline
+bool AttachedBodiesCollisionModel::useDistanceFields() const
+{
+    return m_use_distance_fields;
+}
+
 inline
 size_t AttachedBodiesCollisionModel::sphereModelCount() const
 {
@@ -320,6 +382,25 @@ const CollisionVoxelsModel& AttachedBodiesCollisionModel::voxelsModel(
     return *m_voxels_models[vmidx];
 }
 
+inline
+bool AttachedBodiesCollisionModel::hasDistanceFieldModel(int abidx) const
+{
+    auto it = m_attached_bodies.find(abidx);
+    ASSERT_RANGE(it != m_attached_bodies.end());
+    return it->second.distance_field_model;
+}
+
+/// \brief Return the distance field model of an attached body or nullptr if it
+///     has none
+inline
+const CollisionDistanceFieldModel*
+AttachedBodiesCollisionModel::distanceFieldModel(int abidx) const
+{
+    auto it = m_attached_bodies.find(abidx);
+    ASSERT_RANGE(it != m_attached_bodies.end());
+    return it->second.distance_field_model;
+}
+
 inline
 size_t AttachedBodiesCollisionModel::groupCount() const
 {
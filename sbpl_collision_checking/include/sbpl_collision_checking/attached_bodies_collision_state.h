@@ -122,6 +122,11 @@ private:
     RobotCollisionState*                    m_state;
 
     std::vector<CollisionSpheresState>      m_spheres_states;
+
+    // link index of the attached body of each spheres state, resolved once
+    // per model version so that checking a sphere for a stale position during
+    // traversal does not look up its attached body
+    std::vector<int>                        m_spheres_state_links;
     std::vector<int>                        m_voxels_state_versions;
     std::vector<CollisionVoxelsState>       m_voxels_states;
     std::vector<CollisionGroupState>        m_group_states;
@@ -284,9 +289,9 @@ bool AttachedBodiesCollisionState::sphereStateDirty(
     reinitCollisionState();
     ASSERT_VECTOR_RANGE(m_spheres_states, sidx.ss);
     const CollisionSpheresState& spheres_state = m_spheres_states[sidx.ss];
-    const int bidx = spheres_state.model->link_index;
-    int body_version = attachedBodyTransformVersion(bidx);
-    return attachedBodyTransformDirty(bidx) || spheres_state.spheres[sidx.s].version != body_version;
+    const int lidx = m_spheres_state_links[sidx.ss];
+    return m_state->linkTransformDirty(lidx) ||
+            spheres_state.spheres[sidx.s].version != m_state->linkTransformVersion(lidx);
 }
 
 inline
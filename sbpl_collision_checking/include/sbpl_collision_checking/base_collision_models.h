@@ -33,6 +33,7 @@
 #define sbpl_collision_base_collision_models_h
 
 // standard includes
+#include <cstdint>
 #include <ostream>
 #include <string>
 #include <vector>
@@ -102,11 +103,19 @@ public:
     CollisionSphereModelTree& operator=(const CollisionSphereModelTree&) = delete;
     CollisionSphereModelTree& operator=(CollisionSphereModelTree&&) = delete;
 
-    void buildFrom(const std::vector<CollisionSphereConfig>& spheres);
-    void buildFrom(const std::vector<CollisionSphereModel>& spheres);
+    void buildFrom(
+        const std::vector<CollisionSphereConfig>& spheres,
+        bool balanced = false);
+    void buildFrom(
+        const std::vector<CollisionSphereModel>& spheres,
+        bool balanced = false);
 
     void buildFrom(const std::vector<const CollisionSphereModel*>& spheres);
 
+    void buildFrom(
+        const CollisionSphereModelTree& tree,
+        const Eigen::Affine3d& transform);
+
     const CollisionSphereModel* root() const { return &m_tree.back(); }
 
     /// \name Vector-like Element Access
@@ -143,7 +152,8 @@ private:
     template <typename Sphere>
     size_t buildRecursive(
         typename std::vector<const Sphere*>::iterator msfirst,
-        typename std::vector<const Sphere*>::iterator mslast);
+        typename std::vector<const Sphere*>::iterator mslast,
+        bool balanced);
 
     size_t buildMetaRecursive(
         std::vector<const CollisionSphereModel*>::iterator msfirst,
@@ -174,16 +184,85 @@ struct CollisionSpheresModel
 
 std::ostream& operator<<(std::ostream& o, const CollisionSpheresModel& csm);
 
+/// \brief Packed set of the cells of a box in a voxel grid
+///
+/// Each row of cells along x starts on a new 64-bit word, so that the rows of
+/// two sets may be compared 64 cells at a time regardless of their origins.
+struct CollisionVoxelsBitset
+{
+    Eigen::Vector3i origin = Eigen::Vector3i::Zero(); // index of the first cell
+    int size_x = 0;
+    int size_y = 0;
+    int size_z = 0;
+    int row_words = 0;
+    std::vector<std::uint64_t> bits;
+
+    void reset(const Eigen::Vector3i& origin, int size_x, int size_y, int size_z);
+    void clear();
+
+    bool empty() const { return bits.empty(); }
+
+    /// Set the cell with grid index (x, y, z), which must be inside the box
+    void set(int x, int y, int z);
+
+    /// Return the cells [x, x + 64) of row (y, z), zero outside the box
+    auto word(int x, int y, int z) const -> std::uint64_t;
+
+    /// Call fn(x, y, z) for the grid index of each set cell
+    template <typename Fn>
+    void forEach(Fn fn) const;
+};
+
 /// \brief Collision Voxels Model Specification
 struct CollisionVoxelsModel
 {
     int link_index; // -1 if not attached to a link
     double voxel_res;
     std::vector<Eigen::Vector3d> voxels; // in the link frame
+
+    // the voxels as a bitset over the lattice, in the link frame, whose cell
+    // (i, j, k) is centered at lattice_offset + voxel_res * (i, j, k); empty
+    // if the voxels do not lie on a common lattice
+    Eigen::Vector3d lattice_offset = Eigen::Vector3d::Zero();
+    CollisionVoxelsBitset bitset;
+
+    bool buildBitset();
 };
 
 std::ostream& operator<<(std::ostream& o, const CollisionVoxelsModel& cvm);
 
+/// \brief Collision Distance Field Model Specification
+///
+/// A signed distance field, sampled on a grid around a body in the body's own
+/// frame. Queried distances are lower bounds on the distance to the body's
+/// surface and are negative inside the body.
+struct CollisionDistanceFieldModel
+{
+    int link_index; // -1 if not attached to a link
+    Eigen::Affine3d pose; // of the body frame in the link frame
+
+    double res;
+    Eigen::Vector3d origin; // center of cell (0, 0, 0), in the body frame
+    int size_x;
+    int size_y;
+    int size_z;
+    double margin; // minimum distance from the body to the field border
+    std::vector<float> dist;
+
+    // bounding sphere of the body, in the body frame
+    Eigen::Vector3d center;
+    double radius;
+
+    bool buildFrom(
+        const std::vector<Eigen::Vector3d>& voxels,
+        double voxel_res,
+        double margin);
+
+    double distance(const Eigen::Vector3d& p) const;
+};
+
+std::ostream& operator<<(std::ostream& o, const CollisionDistanceFieldModel& cdfm);
+
 /// \brief Collision Group Model Specification
 struct CollisionGroupModel
 {
@@ -211,6 +290,24 @@ int CollisionSphereModel::index() const
     return std::distance(&parent->spheres[0], this);
 }
 
+template <typename Fn>
+void CollisionVoxelsBitset::forEach(Fn fn) const
+{
+    for (int z = 0; z < size_z; ++z) {
+    for (int y = 0; y < size_y; ++y) {
+        const std::uint64_t* row = &bits[(z * size_y + y) * row_words];
+        for (int w = 0; w < row_words; ++w) {
+            std::uint64_t word = row[w];
+            while (word) {
+                const int b = __builtin_ctzll(word);
+                word &= word - 1;
+                fn(origin.x() + 64 * w + b, origin.y() + y, origin.z() + z);
+            }
+        }
+    }
+    }
+}
+
 } // namespace collision
 } // namespace smpl
 
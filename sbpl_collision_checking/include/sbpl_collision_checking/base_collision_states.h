@@ -133,6 +133,20 @@ public:
     bool empty() const { return m_tree.empty(); }
     size_t size() const { return m_tree.size(); }
 
+    /// \name Structure-of-Arrays Layout
+    ///
+    /// The model-frame centers and radii of the spheres and the indices of
+    /// their children (-1 for leaves), each stored contiguously in the order
+    /// of the sphere states, for loops over all spheres of the tree.
+    ///@{
+    const double* centersX() const { return m_center_x.data(); }
+    const double* centersY() const { return m_center_y.data(); }
+    const double* centersZ() const { return m_center_z.data(); }
+    const double* radii() const { return m_radius.data(); }
+    const int* leftIndices() const { return m_left.data(); }
+    const int* rightIndices() const { return m_right.data(); }
+    ///@}
+
     // TODO: swap?
 
 private:
@@ -140,6 +154,16 @@ private:
     friend std::ostream& operator<<(std::ostream& o, const CollisionSphereStateTree& tree);
 
     container_type m_tree;
+
+    std::vector<double> m_center_x;
+    std::vector<double> m_center_y;
+    std::vector<double> m_center_z;
+    std::vector<double> m_radius;
+    std::vector<int> m_left;
+    std::vector<int> m_right;
+
+    void copyFrom(const CollisionSphereStateTree& o);
+    void moveFrom(CollisionSphereStateTree&& o);
 };
 
 std::ostream& operator<<(std::ostream& o, const CollisionSphereStateTree& tree);
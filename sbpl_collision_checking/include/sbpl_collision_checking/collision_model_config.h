@@ -76,6 +76,15 @@ struct CollisionSpheresModelConfig
     std::string link_name;
     bool autogenerate;
     double radius; // relevant if autogenerate = true
+
+    // relevant if autogenerate = true; if positive, generate a minimal set of
+    // spheres of varying radius overshooting the geometry by at most this
+    // distance, rather than spheres of uniform radius
+    double max_overshoot = 0.0;
+
+    // build a hierarchy split at the median, rather than the centroid
+    bool balanced = false;
+
     std::vector<CollisionSphereConfig> spheres;
 
     static bool Load(XmlRpc::XmlRpcValue& config, CollisionSpheresModelConfig& cfg);
@@ -112,6 +121,10 @@ struct CollisionModelConfig
     std::vector<CollisionVoxelModelConfig>      voxel_models;
     std::vector<CollisionGroupConfig>           groups;
 
+    // optional file in which generated spheres and voxels are cached, so that
+    // later loads of the same model skip their generation
+    std::string                                 cache_path;
+
     // TODO: change this to search for params under "robot_collision_model"
     // and provide another Load function operating directly on the XmlRpc
     static bool Load(const ros::NodeHandle& nh, CollisionModelConfig& cfg);
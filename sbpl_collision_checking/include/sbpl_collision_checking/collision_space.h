@@ -40,8 +40,12 @@
 
 // system includes
 #include <Eigen/Dense>
+#include <smpl/cancellation.h>
 #include <smpl/collision_checker.h>
+#include <smpl/memory_usage.h>
+#include <smpl/distance_map/shared_distance_map.h>
 #include <smpl/occupancy_grid.h>
+#include <smpl/worker_pool.h>
 #include <visualization_msgs/MarkerArray.h>
 
 // project includes
@@ -57,7 +61,25 @@
 namespace smpl {
 namespace collision {
 
-class CollisionSpace : public CollisionChecker
+/// The strategy used to validate motions between two states
+enum class MotionCheckMode
+{
+    /// Check waypoints interpolated at a fixed resolution of sphere motion
+    Sampled,
+
+    /// Advance along the motion by the largest step the clearance at the
+    /// current state and the worst-case sphere motion provably allow
+    ConservativeAdvancement
+};
+
+class CollisionSpace :
+    public CollisionChecker,
+    public CollisionCheckerCloneExtension,
+    public CollisionDistanceExtension,
+    public MemoryUsageExtension,
+    public CancellationExtension,
+    public CollisionWorldVersionExtension,
+    public CollisionClearanceExtension
 {
 public:
 
@@ -95,6 +117,22 @@ public:
 
     void setPadding(double padding);
 
+    void setCacheWorldShapeVoxels(bool enabled);
+
+    void setAttachedBodyDistanceFields(bool enabled);
+
+    void setIntervalSkipping(bool enabled);
+    bool intervalSkipping() const { return m_interval_skipping; }
+
+    void setCapsuleBroadPhase(bool enabled);
+    bool capsuleBroadPhase() const;
+
+    void setMotionCheckMode(MotionCheckMode mode);
+    auto motionCheckMode() const -> MotionCheckMode { return m_motion_check_mode; }
+
+    void setBatchThreadCount(int num_threads);
+    int batchThreadCount() const { return m_batch_thread_count; }
+
     /// \name Self Collisions
     ///@{
     auto allowedCollisionMatrix() const -> const AllowedCollisionMatrix&;
@@ -105,10 +143,15 @@ public:
     /// \name World Collision Model
     ///@{
     bool insertObject(const CollisionObject* object);
+    bool insertObjects(const CollisionObject* const* objects, size_t n);
     bool removeObject(const CollisionObject* object);
     bool moveShapes(const CollisionObject* object);
     bool insertShapes(const CollisionObject* object);
     bool removeShapes(const CollisionObject* object);
+
+    void beginUpdate();
+    bool commitUpdate();
+    bool publishUpdates(bool wait = false);
     ///@}
 
     /// \name Attached Objects
@@ -187,17 +230,87 @@ public:
         CollisionDetails& details);
     bool collisionDetails(const double* state, CollisionDetails& details);
 
+    /// \name Incremental Collision Checking
+    ///
+    /// Check states that differ from a common reference state in a single
+    /// planning variable, e.g. the successors of a state, without rewriting
+    /// the full joint vector for each check. Only the transforms of the links
+    /// below the modified joint are recomputed.
+    ///@{
+    void setReferenceState(const std::vector<double>& state);
+    bool checkCollisionDelta(int vidx, double value, double& dist);
+    ///@}
+
     /// \name Required Functions from Extension
     ///@{
     Extension* getExtension(size_t class_code) override;
     ///@}
 
+    /// \name Required Functions from CollisionDistanceExtension
+    ///@{
+    double distanceToCollision(const RobotState& state) override;
+
+    double distanceToCollision(
+        const RobotState& start,
+        const RobotState& finish) override;
+    ///@}
+
+    /// \name Reimplemented Functions from CollisionDistanceExtension
+    ///@{
+    bool collisionCostGradient(
+        const RobotState& state,
+        double clearance,
+        double& cost,
+        std::vector<double>& gradient) override;
+    ///@}
+
+    /// \name Required Functions from MemoryUsageExtension
+    ///@{
+    auto memoryUsage() const -> std::size_t override;
+    ///@}
+
+    /// \name Required Functions from CollisionCheckerCloneExtension
+    ///@{
+    auto clone() -> std::unique_ptr<CollisionChecker> override;
+    ///@}
+
+    /// \name Required Functions from CancellationExtension
+    ///@{
+    void setCancellationToken(const CancellationToken* token) override {
+        m_cancel = token;
+    }
+    ///@}
+
+    /// \name Required Functions from CollisionWorldVersionExtension
+    ///@{
+    auto worldVersion() const -> std::uint64_t override;
+    ///@}
+
+    /// \name Required Functions from CollisionClearanceExtension
+    ///@{
+    double motionClearance(
+        const RobotState& start,
+        const RobotState& finish) override;
+
+    double worldGrowth() const override;
+    auto growthEpoch() const -> std::uint64_t override;
+    ///@}
+
     /// \name Required Functions from CollisionChecker
     ///@{
     bool isStateValid(
         const RobotState& state,
         bool verbose = false) override;
 
+    bool isStateValid(
+        RobotStateView state,
+        bool verbose = false) override;
+
+    bool areStatesValid(
+        const RobotState* states,
+        size_t n,
+        bool* out = nullptr) override;
+
     bool isStateToStateValid(
         const RobotState& start,
         const RobotState& finish,
@@ -220,6 +333,10 @@ private:
     OccupancyGrid*                  m_grid;
     std::vector<std::string>        m_planning_variables;
 
+    // the grid's distance map, if it is attached from another process, whose
+    // updates are counted by worldVersion()
+    const SharedDistanceMap*        m_shared_map = nullptr;
+
     RobotCollisionModelConstPtr         m_rcm;
     AttachedBodiesCollisionModelPtr     m_abcm;
 
@@ -229,6 +346,31 @@ private:
     AttachedBodiesCollisionStatePtr m_abcs;
     std::vector<double>             m_joint_vars;
 
+    // index of the joint variable in m_rcs that has been moved away from its
+    // value in m_joint_vars by checkCollisionDelta, or -1
+    int                             m_delta_var = -1;
+
+    bool                            m_interval_skipping = false;
+    MotionCheckMode                 m_motion_check_mode = MotionCheckMode::Sampled;
+
+    // work list of waypoint index intervals for isStateToStateValid
+    std::vector<std::pair<int, int>> m_intervals;
+
+    // threads and per-thread collision spaces for checking large batches in
+    // areStatesValid; the first thread checks with this collision space and
+    // each remaining thread with its own clone, created on demand
+    int                                         m_batch_thread_count = 1;
+    std::unique_ptr<WorkerPool>                 m_batch_pool;
+    std::vector<std::unique_ptr<CollisionSpace>> m_batch_workers;
+
+    // once expired, areStatesValid stops checking and reports the remaining
+    // states of the batch as invalid
+    const CancellationToken*        m_cancel = nullptr;
+
+    // incremented by changes to the robot and its configuration that are not
+    // made through the world collision model; see worldVersion()
+    std::uint64_t                   m_version = 0;
+
     WorldCollisionModelPtr          m_wcm;
     SelfCollisionModelPtr           m_scm;
 
@@ -239,6 +381,10 @@ private:
     // Planning Joint Information
     std::vector<int>                m_planning_joint_to_collision_model_indices;
 
+    // leaf spheres of the group, whose obstacle costs make up the cost of
+    // collisionCostGradient; gathered on first use
+    std::vector<SphereIndex>        m_cost_spheres;
+
     size_t planningVariableCount() const {
         return m_planning_joint_to_collision_model_indices.size();
     }
@@ -255,6 +401,17 @@ private:
         const std::vector<double>& vals);
     void updateState(std::vector<double>& state, const double* vals);
     void copyState();
+    void restoreDeltaVar();
+
+    bool checkMotionConservativeAdvancement(
+        const RobotState& start,
+        const RobotState& finish);
+
+    bool areStatesValidParallel(const RobotState* states, size_t n, bool* out);
+
+    int singleChangedVariable(
+        const std::vector<double>& start,
+        const std::vector<double>& finish) const;
 
     bool withinJointPositionLimits(const std::vector<double>& positions) const;
 };
@@ -34,6 +34,7 @@
 #define sbpl_collision_robot_collision_model_h
 
 // standard includes
+#include <cstdint>
 #include <memory>
 #include <ostream>
 #include <string>
@@ -52,6 +53,9 @@
 #include <sbpl_collision_checking/types.h>
 
 namespace smpl {
+
+class WorkerPool;
+
 namespace collision {
 
 typedef Eigen::Affine3d (*JointTransformFunction)(
@@ -76,6 +80,12 @@ enum JointType
 };
 
 /// \brief Represents the collision model of the robot used for planning.
+///
+/// Meshes are loaded, and spheres and voxels are generated, in parallel across
+/// links. If the configuration names a cache_path, the generated spheres and
+/// voxels are restored from that file when their link geometry and generation
+/// parameters are unchanged, and the file is rewritten whenever anything had
+/// to be generated.
 class RobotCollisionModel
 {
 public:
@@ -279,7 +289,9 @@ private:
         const ::urdf::ModelInterface& urdf,
         const CollisionModelConfig& config);
 
-    bool initCollisionShapes(const ::urdf::ModelInterface& urdf);
+    bool initCollisionShapes(
+        const ::urdf::ModelInterface& urdf,
+        WorkerPool& pool);
     bool createCollisionShape(const ::urdf::Collision& collision);
 
     bool expandGroups(
@@ -289,6 +301,7 @@ private:
     bool generateSphereModels(
         int urdf_link_index,
         double radius,
+        double max_overshoot,
         std::vector<CollisionSphereModel>& spheres) const;
 
     bool generateBoundingSpheres(
@@ -296,6 +309,14 @@ private:
         double radius,
         std::vector<CollisionSphereModel>& spheres) const;
 
+    bool generateCoveringSpheres(
+        const CollisionGeometry* geom,
+        double max_overshoot,
+        std::vector<CollisionSphereModel>& spheres) const;
+
+    auto linkGeometryHash(int urdf_link_index, std::uint64_t seed) const
+        -> std::uint64_t;
+
     bool checkCollisionModelConfig(const CollisionModelConfig& config);
 
     bool checkCollisionModelReferences() const;
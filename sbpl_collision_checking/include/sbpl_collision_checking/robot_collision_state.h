@@ -524,12 +524,37 @@ inline bool RobotCollisionState::updateSphereStates()
     return updated;
 }
 
+/// All spheres of a spheres state are attached to the same link, so the link
+/// transform is brought up to date once and the out-of-date spheres are then
+/// transformed in a single pass over the tree's center arrays.
 inline bool RobotCollisionState::updateSphereStates(int ssidx)
 {
+    CollisionSpheresState& spheres_state = m_spheres_states[ssidx];
+    const int lidx = spheres_state.model->link_index;
+
+    updateLinkTransform(lidx);
+
+    const int link_version = m_link_transform_versions[lidx];
+    const Eigen::Affine3d& T_model_link = m_link_transforms[lidx];
+    const Eigen::Matrix3d R = T_model_link.linear();
+    const Eigen::Vector3d t = T_model_link.translation();
+
+    auto& spheres = spheres_state.spheres;
+    const double* cx = spheres.centersX();
+    const double* cy = spheres.centersY();
+    const double* cz = spheres.centersZ();
+
     bool updated = false;
-    const CollisionSpheresState& spheres_state = m_spheres_states[ssidx];
-    for (size_t sidx = 0; sidx < spheres_state.spheres.size(); ++sidx) {
-        updated |= updateSphereState(SphereIndex(ssidx, sidx));
+    for (size_t sidx = 0; sidx < spheres.size(); ++sidx) {
+        CollisionSphereState& sphere_state = spheres[sidx];
+        if (sphere_state.version == link_version) {
+            continue;
+        }
+        sphere_state.pos.x() = R(0, 0) * cx[sidx] + R(0, 1) * cy[sidx] + R(0, 2) * cz[sidx] + t.x();
+        sphere_state.pos.y() = R(1, 0) * cx[sidx] + R(1, 1) * cy[sidx] + R(1, 2) * cz[sidx] + t.y();
+        sphere_state.pos.z() = R(2, 0) * cx[sidx] + R(2, 1) * cy[sidx] + R(2, 2) * cz[sidx] + t.z();
+        sphere_state.version = link_version;
+        updated = true;
     }
     return updated;
 }
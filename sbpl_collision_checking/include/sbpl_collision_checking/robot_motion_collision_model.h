@@ -33,6 +33,7 @@
 #define SBPL_COLLISION_ROBOT_COLLISION_MOTION_MODEL_H
 
 // standard includes
+#include <cstdint>
 #include <vector>
 
 // system includes
@@ -154,6 +155,30 @@ private:
     // reference
     std::vector<Eigen::Vector3d> m_mr_centers;
     std::vector<double> m_mr_radii;
+
+    enum class VarMotion : std::uint8_t
+    {
+        None,               // fixed, or a secondary variable of its joint
+        Angular,            // revolute
+        ContinuousAngular,  // continuous, moves along the shortest arc
+        Linear,             // prismatic
+        Planar,             // first of the (x, y, theta) variables
+        Floating            // first of the (x, y, z) translation variables
+    };
+
+    // motion bound of a single variable: the distance any sphere travels per
+    // unit of angular motion (the MR sphere's lever arm about the joint axis)
+    struct VarMotionBound
+    {
+        VarMotion type;
+        double lever;
+    };
+
+    // one entry per joint variable, so that motion bounds are evaluated in a
+    // single pass over the variables without consulting the robot model
+    std::vector<VarMotionBound> m_var_bounds;
+
+    void initVarMotionBounds();
 };
 
 inline
@@ -33,8 +33,11 @@
 #define sbpl_collision_self_collision_model_h
 
 // standard includes
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 // system includes
 #include <smpl/forward.h>
@@ -72,6 +75,9 @@ public:
 
     void setPadding(double padding);
 
+    void setCapsuleBroadPhase(bool enabled);
+    bool capsuleBroadPhase() const { return m_capsule_broad_phase; }
+
     void setWorldToModelTransform(const Eigen::Affine3d& transform);
 
     bool checkCollision(
@@ -117,6 +123,11 @@ public:
         const AllowedCollisionsInterface& aci,
         const int gidx);
 
+    double worldCollisionDistance(
+        const RobotCollisionState& state,
+        const AttachedBodiesCollisionState& ab_state,
+        const int gidx);
+
     bool collisionDetails(
         const RobotCollisionState& state,
         const AttachedBodiesCollisionState& ab_state,
@@ -148,15 +159,60 @@ private:
     std::vector<int>                        m_voxels_indices;
     std::vector<int>                        m_ab_voxels_indices;
 
+    // grid cells inserted into the occupancy grid for each robot voxels state
+    // outside the group, by voxels state index, so that a moved voxels state
+    // updates only the cells it entered or left
+    std::vector<CollisionVoxelsBitset>      m_voxels_cells;
+    CollisionVoxelsBitset                   m_moved_voxels_cells;
+
     // cached set of spheres state pairs that should be checked for self
     // collisions when using the internal allowed collision matrix
     std::vector<std::pair<int, int>>        m_checked_spheres_states;
     std::vector<std::pair<int, int>>        m_checked_attached_body_spheres_states;
     std::vector<std::pair<int, int>>        m_checked_attached_body_robot_spheres_states;
 
+    // broad phase data for m_checked_spheres_states: the distinct spheres
+    // states referenced by the pairs, packed positions and radii of their root
+    // spheres, the indices of each pair into the packed arrays, and whether
+    // the root spheres of each pair overlap
+    std::vector<int>                        m_bp_states;
+    std::vector<double>                     m_bp_x;
+    std::vector<double>                     m_bp_y;
+    std::vector<double>                     m_bp_z;
+    std::vector<double>                     m_bp_r;
+    std::vector<int>                        m_bp_first;
+    std::vector<int>                        m_bp_second;
+    std::vector<std::uint8_t>               m_bp_overlap;
+
+    // capsules bounding the leaf spheres of each packed spheres state, in the
+    // link frame (endpoint, segment vector, and radius) and, when the capsule
+    // broad phase is enabled, their endpoints and segment vectors in the model
+    // frame
+    bool                                    m_capsule_broad_phase;
+    std::vector<int>                        m_bp_links;
+    std::vector<Eigen::Vector3d>            m_bp_cap_p;
+    std::vector<Eigen::Vector3d>            m_bp_cap_u;
+    std::vector<double>                     m_bp_cap_r;
+    std::vector<double>                     m_bp_px;
+    std::vector<double>                     m_bp_py;
+    std::vector<double>                     m_bp_pz;
+    std::vector<double>                     m_bp_ux;
+    std::vector<double>                     m_bp_uy;
+    std::vector<double>                     m_bp_uz;
+
     AllowedCollisionMatrix                  m_acm;
     double                                  m_padding;
 
+    // m_acm compiled to a symmetric bit matrix over acm slots, with a bit set
+    // for each pair of slots that is always allowed to collide. Robot links
+    // occupy slots [0, linkCount()); attached bodies occupy the slots after
+    // them, which are released on detach and reused by later attachments
+    int                                     m_acm_stride;
+    std::vector<std::uint64_t>              m_acm_bits;
+    std::vector<int>                        m_acm_slot_bodies;
+    std::unordered_map<int, int>            m_acm_body_slots;
+    int                                     m_acm_ab_version;
+
     // queue storage for sphere hierarchy traversal
     using SpherePair =
             std::pair<const CollisionSphereState*, const CollisionSphereState*>;
@@ -166,6 +222,29 @@ private:
     std::vector<Eigen::Vector3d> m_v_rem;
     std::vector<Eigen::Vector3d> m_v_ins;
 
+    // the stages of checkCollision, run in order of the collisions each has
+    // recently found per unit of time it takes; rejection counts decay so the
+    // order follows the region of the configuration space being searched
+    enum CheckStage
+    {
+        RobotVoxelsStage = 0,
+        AttachedBodyVoxelsStage,
+        RobotSpheresStage,
+        AttachedBodySpheresStage,
+        CheckStageCount
+    };
+
+    int                                     m_stage_order[CheckStageCount];
+    double                                  m_stage_rejections[CheckStageCount];
+    double                                  m_stage_cost[CheckStageCount];
+    unsigned int                            m_check_count;
+
+    // the leaf sphere last found in collision with the occupancy grid and the
+    // index of the pair of spheres states last found in self collision, each
+    // tested first by the next check
+    const CollisionSphereState*             m_last_world_hit;
+    int                                     m_last_self_pair;
+
 #if SCDL_USE_META_TREE
     // cached group information for building meta trees
     typedef hash_map<const CollisionSphereModel*, const CollisionSphereState*> ModelStateMap;
@@ -178,12 +257,30 @@ private:
 
     void initAllowedCollisionMatrix();
 
+    int acmSlotCount() const;
+    int acmBodySlot(int abidx) const;
+    int acmSlot(const std::string& name) const;
+    auto acmSlotName(int slot) const -> const std::string&;
+    bool acmAllowed(int slot1, int slot2) const;
+    void setAcmAllowed(int slot1, int slot2, bool allowed);
+    void compileAllowedCollisionMatrix();
+    void compileAcmSlot(int slot);
+    void growAcmSlots(int old_count, int new_count);
+    void updateAcmAttachedBodies();
+
     bool checkCommonInputs(
         const RobotCollisionState& state,
         const AttachedBodiesCollisionState& ab_state,
         const int gidx) const;
 
     void prepareState(int gidx, const double* state);
+
+    bool checkStages(const AllowedCollisionsInterface* aci, double& dist);
+    bool checkStage(
+        int stage,
+        const AllowedCollisionsInterface* aci,
+        double& dist);
+    void updateStageOrder();
     void updateGroup(int gidx);
     void copyState(const double* state);
     void updateVoxelsStates();
@@ -206,6 +303,10 @@ private:
     bool checkRobotAttachedBodySpheresStateCollisions(
         const AllowedCollisionsInterface& aci,
         double& dist);
+    bool checkAttachedBodyRobotSpheresStateCollision(
+        int ss1i,
+        int ss2i,
+        double& dist);
 
     bool checkSpheresStateCollision(
         RobotCollisionState& stateA,
@@ -229,6 +330,7 @@ private:
     void updateRobotCheckedSphereIndices();
     void updateRobotAttachedBodyCheckedSphereIndices();
     void updateAttachedBodyCheckedSphereIndices();
+    void updateRobotBroadPhase();
 
     void updateMetaSphereTrees();
 
@@ -33,8 +33,12 @@
 #define SBPL_COLLISION_CHECKING_WORLD_COLLISION_MODEL_H
 
 // standard includes
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
 // system includes
@@ -42,10 +46,17 @@
 #include <smpl/occupancy_grid.h>
 #include <visualization_msgs/MarkerArray.h>
 
+// project includes
+#include <sbpl_collision_checking/types.h>
+
 namespace smpl {
+
+class WorkerPool;
+
 namespace collision {
 
 struct CollisionObject;
+struct CollisionShape;
 
 class WorldCollisionModel
 {
@@ -53,11 +64,13 @@ public:
 
     WorldCollisionModel(OccupancyGrid* grid);
     WorldCollisionModel(const WorldCollisionModel& o, OccupancyGrid* grid);
+    ~WorldCollisionModel();
 
     auto grid() -> OccupancyGrid* { return m_grid; }
     auto grid() const -> const OccupancyGrid* { return m_grid; }
 
     bool insertObject(const CollisionObject* object);
+    bool insertObjects(const CollisionObject* const* objects, size_t n);
     bool removeObject(const CollisionObject* object);
 
     bool moveShapes(const CollisionObject* object);
@@ -71,12 +84,54 @@ public:
 
     void reset();
 
+    /// \name Batched Updates
+    ///
+    /// Updates made between beginUpdate() and the matching commitUpdate() are
+    /// recorded rather than applied to the grid, and are applied by
+    /// commitUpdate() as a single update of the distance map, in which cells
+    /// freed and occupied again by the batch are left untouched. Batches may
+    /// be nested; only the outermost commitUpdate() applies the batch.
+    ///
+    /// If the grid is double buffered, the batch is staged on a background
+    /// thread, and publishUpdates() publishes it by swapping the grid's
+    /// buffers. publishUpdates() must not be called concurrently with lookups.
+    ///@{
+    void beginUpdate();
+    bool commitUpdate();
+    bool publishUpdates(bool wait = false);
+    bool updating() const { return m_batch_depth > 0; }
+    ///@}
+
     auto getWorldVisualization() const -> visualization_msgs::MarkerArray;
     auto getCollisionWorldVisualization() const -> visualization_msgs::MarkerArray;
 
     void setPadding(double padding) { m_padding = padding; }
     double padding() const { return m_padding; }
 
+    void setCacheShapeVoxels(bool enabled);
+    bool cacheShapeVoxels() const { return m_cache_shape_voxels; }
+
+    void setVoxelizeThreadCount(int num_threads);
+    int voxelizeThreadCount() const { return m_voxelize_thread_count; }
+
+    /// \brief Return a counter that changes whenever the modeled world does
+    ///
+    /// Incremented by every successful update made through this model. Two
+    /// equal versions imply the occupancy of the grid is unchanged, as long as
+    /// the grid is not modified directly.
+    auto version() const -> std::uint64_t { return m_version; }
+
+    /// \brief Return the total growth of the modeled obstacles
+    ///
+    /// Every update that adds obstacles grows the world by an upper bound on
+    /// the distance from an added voxel to the voxels occupied before the
+    /// update. A robot configuration with a clearance of c from the obstacles
+    /// keeps a clearance of at least c minus the growth since. Updates whose
+    /// growth can not be bounded, e.g. voxels added beyond the range of the
+    /// distance map, change growthEpoch() instead.
+    double growth() const { return m_growth; }
+    auto growthEpoch() const -> std::uint64_t { return m_growth_epoch; }
+
 private:
 
     OccupancyGrid* m_grid;
@@ -93,6 +148,70 @@ private:
 
     double m_padding;
 
+    // body-frame voxelizations of bounded shapes, keyed on the shape geometry
+    // and the resolution it was voxelized for
+    struct ShapeVoxelsKey {
+        int type;
+        double res;
+        std::vector<double> params;
+        std::vector<std::uint32_t> indices;
+
+        bool operator==(const ShapeVoxelsKey& o) const;
+    };
+    struct ShapeVoxelsKeyHash {
+        auto operator()(const ShapeVoxelsKey& key) const -> size_t;
+    };
+    hash_map<ShapeVoxelsKey, VoxelList, ShapeVoxelsKeyHash> m_shape_voxels;
+    bool m_cache_shape_voxels;
+
+    // voxelizes the shapes of inserted and moved objects in parallel. not
+    // copied, so that copies of this model begin single-threaded
+    int m_voxelize_thread_count;
+    std::unique_ptr<WorkerPool> m_voxelize_pool;
+
+    std::uint64_t m_version;
+
+    double m_growth;
+    std::uint64_t m_growth_epoch;
+
+    // growth of the updates staged into a double buffered grid, added to
+    // m_growth when they are published
+    double m_staged_growth;
+
+    // voxels freed and occupied by updates in the current batch
+    int m_batch_depth;
+    VoxelList m_batch_removed;
+    VoxelList m_batch_added;
+
+    // stages committed batches into a double buffered grid
+    std::thread m_stage_thread;
+    std::atomic<bool> m_staging;
+
+    void joinStageThread();
+
+    double addedReach(const VoxelList& voxels) const;
+    void grow(double reach);
+
+    void removeVoxels(const std::vector<VoxelList>& voxels);
+    void addVoxels(const std::vector<VoxelList>& voxels);
+
+    bool voxelizeObject(
+        const CollisionObject& object,
+        std::vector<VoxelList>& all_voxels);
+
+    void voxelizeObjects(
+        const CollisionObject* const* objects,
+        size_t n,
+        std::vector<std::vector<VoxelList>>& all_voxels,
+        std::vector<char>& voxelized);
+
+    void cacheBodyVoxels(
+        const std::vector<const CollisionShape*>& shapes,
+        double res,
+        std::vector<const VoxelList*>& body_voxels);
+
+    void runVoxelize(size_t count, const std::function<void(size_t)>& job);
+
     ////////////////////
     // Generic Shapes //
     ////////////////////
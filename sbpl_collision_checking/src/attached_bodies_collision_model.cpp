@@ -29,6 +29,12 @@
 
 /// \author Andrew Dornbush
 
+// standard includes
+#include <cmath>
+
+// system includes
+#include <boost/functional/hash.hpp>
+
 // project includes
 #include <sbpl_collision_checking/attached_bodies_collision_model.h>
 #include <sbpl_collision_checking/debug.h>
@@ -39,6 +45,24 @@ namespace collision {
 
 static const char* ABM_LOGGER = "attached_bodies_model";
 
+// TODO: yeah...
+static const double AB_SPHERE_RADIUS = 0.025;
+static const double AB_VOXEL_RES = 0.01;
+static const double AB_DISTANCE_FIELD_MARGIN = 0.05;
+
+// Return the offsets of a body's shapes from its first shape.
+static
+Affine3dVector BodyTransforms(const Affine3dVector& transforms)
+{
+    Affine3dVector body_transforms(transforms.size());
+    const Eigen::Affine3d T_body_link = transforms.front().inverse();
+    body_transforms.front() = Eigen::Affine3d::Identity();
+    for (size_t i = 1; i < transforms.size(); ++i) {
+        body_transforms[i] = T_body_link * transforms[i];
+    }
+    return body_transforms;
+}
+
 AttachedBodiesCollisionModel::AttachedBodiesCollisionModel(
     const RobotCollisionModel* model)
 :
@@ -51,7 +75,9 @@ AttachedBodiesCollisionModel::AttachedBodiesCollisionModel(
     m_voxels_models(),
     m_group_models(),
     m_group_name_to_index(),
-    m_version(0)
+    m_version(0),
+    m_use_distance_fields(false),
+    m_body_models()
 {
     m_link_attached_bodies.resize(m_model->linkCount());
 
@@ -107,9 +133,17 @@ bool AttachedBodiesCollisionModel::attachBody(
         ab.voxels_model = nullptr;
     }
 
+    if (m_use_distance_fields) {
+        ab.distance_field_model =
+                createDistanceFieldModel(abidx, id, shapes, transforms);
+    } else {
+        ab.distance_field_model = nullptr;
+    }
+
     ROS_DEBUG_NAMED(ABM_LOGGER, " -> Link Index: %d", ab.link_index);
     ROS_DEBUG_NAMED(ABM_LOGGER, " -> Spheres Model: %p", ab.spheres_model);
     ROS_DEBUG_NAMED(ABM_LOGGER, " -> Voxels Model: %p", ab.voxels_model);
+    ROS_DEBUG_NAMED(ABM_LOGGER, " -> Distance Field Model: %p", ab.distance_field_model);
 
     m_attached_bodies[abidx] = std::move(ab);
 
@@ -170,6 +204,16 @@ bool AttachedBodiesCollisionModel::detachBody(const std::string& id)
         m_voxels_models.erase(it, m_voxels_models.end());
     }
 
+    if (abit->second.distance_field_model) {
+        auto it = std::remove_if(
+                m_distance_field_models.begin(), m_distance_field_models.end(),
+                [&](const std::unique_ptr<CollisionDistanceFieldModel>& dfm)
+                {
+                    return dfm.get() == abit->second.distance_field_model;
+                });
+        m_distance_field_models.erase(it, m_distance_field_models.end());
+    }
+
     if (abit->second.spheres_model) {
         auto it = std::remove_if(m_spheres_models.begin(), m_spheres_models.end(),
                 [&](const std::unique_ptr<CollisionSpheresModel>& sm)
@@ -207,10 +251,6 @@ CollisionSpheresModel* AttachedBodiesCollisionModel::createSpheresModel(
 {
     ROS_DEBUG_NAMED(ABM_LOGGER, "  Generate spheres model");
 
-    // create configuration spheres and a spheres model for this body
-    CollisionSpheresModelConfig config;
-    generateSpheresModel(id, shapes, transforms, config);
-
     // initialize a new spheres model
     m_spheres_models.emplace_back(new CollisionSpheresModel);
     ROS_DEBUG_NAMED(ABM_LOGGER, "  Spheres Model Count %zu", m_spheres_models.size());
@@ -218,7 +258,32 @@ CollisionSpheresModel* AttachedBodiesCollisionModel::createSpheresModel(
     CollisionSpheresModel* spheres_model = m_spheres_models.back().get();
 
     spheres_model->link_index = abidx;
-    spheres_model->spheres.buildFrom(config.spheres);
+
+    auto* cached = cachedBodyModel(shapes, transforms);
+    if (cached) {
+        if (!cached->has_spheres) {
+            // create configuration spheres for this body relative to its first
+            // shape, named only by index
+            CollisionSpheresModelConfig config;
+            generateSpheresModel("", shapes, BodyTransforms(transforms), config);
+            cached->spheres.buildFrom(config.spheres);
+            cached->has_spheres = true;
+        } else {
+            ROS_DEBUG_NAMED(ABM_LOGGER, "  Reuse cached spheres model");
+        }
+
+        spheres_model->spheres.buildFrom(cached->spheres, transforms.front());
+        for (auto& sphere : spheres_model->spheres.m_tree) {
+            if (sphere.isLeaf()) {
+                sphere.name = id + sphere.name;
+            }
+        }
+    } else {
+        // create configuration spheres and a spheres model for this body
+        CollisionSpheresModelConfig config;
+        generateSpheresModel(id, shapes, transforms, config);
+        spheres_model->spheres.buildFrom(config.spheres);
+    }
     ROS_DEBUG_NAMED(ABM_LOGGER, "  Spheres Model: %p", spheres_model);
 
     // TODO: possible make this more automatic?
@@ -250,10 +315,30 @@ CollisionVoxelsModel* AttachedBodiesCollisionModel::createVoxelsModel(
     // attach to the attached body
     voxels_model->link_index = abidx;
 
-    const double AB_VOXEL_RES = 0.01;
     voxels_model->voxel_res = AB_VOXEL_RES;
 
-    if (!voxelizeAttachedBody(shapes, transforms, *voxels_model)) {
+    auto* cached = cachedBodyModel(shapes, transforms);
+    if (cached) {
+        if (!cached->has_voxels) {
+            // voxelize the body relative to its first shape
+            CollisionVoxelsModel body_model;
+            body_model.voxel_res = AB_VOXEL_RES;
+            if (voxelizeAttachedBody(shapes, BodyTransforms(transforms), body_model)) {
+                cached->voxels = std::move(body_model.voxels);
+                cached->has_voxels = true;
+            } else {
+                ROS_ERROR_NAMED(ABM_LOGGER, "Failed to voxelize attached body '%s'", id.c_str());
+            }
+        } else {
+            ROS_DEBUG_NAMED(ABM_LOGGER, "  Reuse cached voxels model");
+        }
+
+        auto& T_link_body = transforms.front();
+        voxels_model->voxels.reserve(cached->voxels.size());
+        for (auto& voxel : cached->voxels) {
+            voxels_model->voxels.push_back(T_link_body * voxel);
+        }
+    } else if (!voxelizeAttachedBody(shapes, transforms, *voxels_model)) {
         ROS_ERROR_NAMED(ABM_LOGGER, "Failed to voxelize attached body '%s'", id.c_str());
         // TODO: anything to do in this case
     }
@@ -261,6 +346,56 @@ CollisionVoxelsModel* AttachedBodiesCollisionModel::createVoxelsModel(
     return voxels_model;
 }
 
+CollisionDistanceFieldModel*
+AttachedBodiesCollisionModel::createDistanceFieldModel(
+    int abidx,
+    const std::string& id,
+    const std::vector<shapes::ShapeConstPtr>& shapes,
+    const Affine3dVector& transforms)
+{
+    ROS_DEBUG_NAMED(ABM_LOGGER, "  Generate distance field model");
+
+    CollisionDistanceFieldModel field;
+
+    auto* cached = cachedBodyModel(shapes, transforms);
+    if (cached && cached->has_distance_field) {
+        ROS_DEBUG_NAMED(ABM_LOGGER, "  Reuse cached distance field model");
+        field = cached->distance_field;
+    } else {
+        // the field is built in the frame of the body's first shape, from a
+        // voxelization of the body's surface in that frame
+        CollisionVoxelsModel body_model;
+        body_model.voxel_res = AB_VOXEL_RES;
+        if (cached && cached->has_voxels) {
+            body_model.voxels = cached->voxels;
+        } else if (!voxelizeAttachedBody(
+                shapes, BodyTransforms(transforms), body_model))
+        {
+            ROS_ERROR_NAMED(ABM_LOGGER, "Failed to voxelize attached body '%s'", id.c_str());
+            return nullptr;
+        }
+
+        if (!field.buildFrom(
+                body_model.voxels, AB_VOXEL_RES, AB_DISTANCE_FIELD_MARGIN))
+        {
+            ROS_WARN_NAMED(ABM_LOGGER, "Attached body '%s' has no voxels to build a distance field from", id.c_str());
+            return nullptr;
+        }
+
+        if (cached) {
+            cached->distance_field = field;
+            cached->has_distance_field = true;
+        }
+    }
+
+    m_distance_field_models.emplace_back(
+            new CollisionDistanceFieldModel(std::move(field)));
+    auto* distance_field_model = m_distance_field_models.back().get();
+    distance_field_model->link_index = abidx;
+    distance_field_model->pose = transforms.front();
+    return distance_field_model;
+}
+
 void AttachedBodiesCollisionModel::generateSpheresModel(
     const std::string& id,
     const std::vector<shapes::ShapeConstPtr>& shapes,
@@ -277,8 +412,7 @@ void AttachedBodiesCollisionModel::generateSpheresModel(
     // here and disallow use of the special character on config-generated
     // spheres
 
-    // TODO: yeah...
-    const double object_enclosing_sphere_radius = 0.025;
+    const double object_enclosing_sphere_radius = AB_SPHERE_RADIUS;
 
     // voxelize the object
     std::vector<Eigen::Vector3d> voxels;
@@ -344,6 +478,126 @@ bool AttachedBodiesCollisionModel::voxelizeAttachedBody(
     return true;
 }
 
+/// \brief Enable or disable distance field models for attached bodies
+///
+/// When enabled, each subsequently attached body is given a signed distance
+/// field, in its own frame, which collision checks against the world and the
+/// robot use in place of the body's spheres. Bodies already attached are
+/// unaffected.
+void AttachedBodiesCollisionModel::setUseDistanceFields(bool enabled)
+{
+    m_use_distance_fields = enabled;
+}
+
+/// \brief Discard the models cached from previously attached bodies
+///
+/// Bodies currently attached are unaffected.
+void AttachedBodiesCollisionModel::clearModelCache()
+{
+    m_body_models.clear();
+}
+
+bool AttachedBodiesCollisionModel::BodyModelKey::operator==(
+    const BodyModelKey& o) const
+{
+    return types == o.types && params == o.params && indices == o.indices;
+}
+
+auto AttachedBodiesCollisionModel::BodyModelKeyHash::operator()(
+    const BodyModelKey& key) const -> size_t
+{
+    size_t seed = 0;
+    boost::hash_combine(seed, boost::hash_range(begin(key.types), end(key.types)));
+    boost::hash_combine(seed, boost::hash_range(begin(key.params), end(key.params)));
+    boost::hash_combine(seed, boost::hash_range(begin(key.indices), end(key.indices)));
+    return seed;
+}
+
+// Append the geometry of a shape to a body model key. Return false if models
+// of the shape may not be cached.
+static
+bool AppendShapeKey(
+    const shapes::Shape& shape,
+    std::vector<double>& params,
+    std::vector<std::uint32_t>& indices)
+{
+    switch (shape.type) {
+    case shapes::SPHERE: {
+        auto& sphere = static_cast<const shapes::Sphere&>(shape);
+        params.push_back(sphere.radius);
+        return true;
+    }
+    case shapes::CYLINDER: {
+        auto& cylinder = static_cast<const shapes::Cylinder&>(shape);
+        params.push_back(cylinder.radius);
+        params.push_back(cylinder.length);
+        return true;
+    }
+    case shapes::CONE: {
+        auto& cone = static_cast<const shapes::Cone&>(shape);
+        params.push_back(cone.radius);
+        params.push_back(cone.length);
+        return true;
+    }
+    case shapes::BOX: {
+        auto& box = static_cast<const shapes::Box&>(shape);
+        params.insert(params.end(), box.size, box.size + 3);
+        return true;
+    }
+    case shapes::MESH: {
+        auto& mesh = static_cast<const shapes::Mesh&>(shape);
+        params.push_back((double)mesh.vertex_count);
+        params.insert(
+                params.end(),
+                mesh.vertices, mesh.vertices + 3 * mesh.vertex_count);
+        indices.push_back(mesh.triangle_count);
+        indices.insert(
+                indices.end(),
+                mesh.triangles, mesh.triangles + 3 * mesh.triangle_count);
+        return true;
+    }
+    default:
+        // planes are unbounded and octrees may be modified in place
+        return false;
+    }
+}
+
+// Return the cached models for a body, creating an empty entry for a body not
+// seen before. Return null if the body's models may not be cached.
+auto AttachedBodiesCollisionModel::cachedBodyModel(
+    const std::vector<shapes::ShapeConstPtr>& shapes,
+    const Affine3dVector& transforms) -> CachedBodyModel*
+{
+    if (shapes.empty() || shapes.size() != transforms.size()) {
+        return nullptr;
+    }
+
+    BodyModelKey key;
+    key.params.push_back(AB_SPHERE_RADIUS);
+    key.params.push_back(AB_VOXEL_RES);
+
+    auto body_transforms = BodyTransforms(transforms);
+    for (size_t i = 0; i < shapes.size(); ++i) {
+        key.types.push_back((int)shapes[i]->type);
+        if (!AppendShapeKey(*shapes[i], key.params, key.indices)) {
+            return nullptr;
+        }
+
+        // round the offsets from the first shape, which are recomputed for
+        // each attachment, so that equal offsets compare equal
+        if (i > 0) {
+            auto& T = body_transforms[i];
+            for (int r = 0; r < 3; ++r) {
+                for (int c = 0; c < 4; ++c) {
+                    key.params.push_back(std::round(T(r, c) * 1e9) * 1e-9);
+                }
+            }
+        }
+    }
+
+    return &m_body_models[std::move(key)];
+}
+
 inline
 int AttachedBodiesCollisionModel::generateAttachedBodyIndex()
 {
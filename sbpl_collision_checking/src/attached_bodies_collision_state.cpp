@@ -84,24 +84,25 @@ bool AttachedBodiesCollisionState::updateSphereState(
 {
     reinitCollisionState();
 
+    // called for each sphere a traversal descends into, so only the spheres
+    // reached are transformed, each at most once per link transform version
     CollisionSpheresState& spheres_state = m_spheres_states[sidx.ss];
-    const int bidx = spheres_state.model->link_index;
-    const int body_version = attachedBodyTransformVersion(bidx);
+    const int lidx = m_spheres_state_links[sidx.ss];
     CollisionSphereState& sphere_state = spheres_state.spheres[sidx.s];
 
-    if (!attachedBodyTransformDirty(bidx) &&
-        sphere_state.version == body_version)
+    if (!m_state->linkTransformDirty(lidx) &&
+        sphere_state.version == m_state->linkTransformVersion(lidx))
     {
         return false;
     }
 
-    updateAttachedBodyTransform(bidx);
+    m_state->updateLinkTransform(lidx);
 
     ROS_DEBUG_NAMED(ABS_LOGGER, "Updating position of sphere '%s'", sphere_state.model->name.c_str());
-    const Eigen::Affine3d& T_model_body = attachedBodyTransform(bidx);
+    const Eigen::Affine3d& T_model_body = m_state->linkTransform(lidx);
     sphere_state.pos = T_model_body * sphere_state.model->center;
 
-    sphere_state.version = attachedBodyTransformVersion(bidx);
+    sphere_state.version = m_state->linkTransformVersion(lidx);
     return true;
 }
 
@@ -116,10 +117,13 @@ void AttachedBodiesCollisionState::reinitCollisionState()
     // initialize spheres states
     m_spheres_states.assign(
             m_model->spheresModelCount(), CollisionSpheresState());
+    m_spheres_state_links.resize(m_model->spheresModelCount());
     for (size_t i = 0; i < m_model->spheresModelCount(); ++i) {
         CollisionSpheresState& spheres_state = m_spheres_states[i];
         spheres_state.model = &m_model->spheresModel(i);
         spheres_state.spheres.buildFrom(&spheres_state);
+        m_spheres_state_links[i] =
+                m_model->attachedBodyLinkIndex(spheres_state.model->link_index);
     }
 
     // initialize voxels states
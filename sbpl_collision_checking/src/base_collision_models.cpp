@@ -30,6 +30,10 @@
 /// \author Andrew Dornbush
 
 // standard includes
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
 #include <sstream>
 
 // system includes
@@ -181,8 +185,14 @@ CollisionSphereModelTree::CollisionSphereModelTree(CollisionSphereModelTree&& o)
 {
 }
 
+/// \brief Build the bounding sphere hierarchy over a set of leaf spheres
+///
+/// By default, each level is split at the centroid of its spheres along the
+/// largest axis of their bounding box. If \p balanced is set, each level is
+/// instead split at the median sphere, giving a hierarchy of minimal depth.
 void CollisionSphereModelTree::buildFrom(
-    const std::vector<CollisionSphereConfig>& spheres)
+    const std::vector<CollisionSphereConfig>& spheres,
+    bool balanced)
 {
     m_tree.clear();
 
@@ -193,7 +203,7 @@ void CollisionSphereModelTree::buildFrom(
         sptrs[i] = &spheres[i];
     }
 
-    buildRecursive<CollisionSphereConfig>(sptrs.begin(), sptrs.end());
+    buildRecursive<CollisionSphereConfig>(sptrs.begin(), sptrs.end(), balanced);
 
     // rewire the child pointers
     size_t leaf_count = 0;
@@ -221,8 +231,12 @@ void CollisionSphereModelTree::buildFrom(
     // array to see if efficiency is affected
 }
 
+/// \brief Build the bounding sphere hierarchy over a set of leaf spheres
+///
+/// See buildFrom(const std::vector<CollisionSphereConfig>&, bool).
 void CollisionSphereModelTree::buildFrom(
-    const std::vector<CollisionSphereModel>& spheres)
+    const std::vector<CollisionSphereModel>& spheres,
+    bool balanced)
 {
     m_tree.clear();
 
@@ -232,7 +246,7 @@ void CollisionSphereModelTree::buildFrom(
         sptrs[i] = &spheres[i];
     }
 
-    buildRecursive<CollisionSphereModel>(sptrs.begin(), sptrs.end());
+    buildRecursive<CollisionSphereModel>(sptrs.begin(), sptrs.end(), balanced);
 
     const CollisionSphereModel* root = &m_tree[0];
     size_t leaf_count = 0;
@@ -286,6 +300,26 @@ void CollisionSphereModelTree::buildFrom(
     ROS_DEBUG("%zu leaves", leaf_count);
 }
 
+/// \brief Copy the hierarchy of another tree, transforming all spheres
+///
+/// Rigid transformations preserve the bounding relationship between parent
+/// and child spheres, so this is equivalent to rebuilding the hierarchy from
+/// the transformed leaf spheres, without the cost of partitioning them.
+void CollisionSphereModelTree::buildFrom(
+    const CollisionSphereModelTree& tree,
+    const Eigen::Affine3d& transform)
+{
+    m_tree = tree.m_tree;
+    for (size_t i = 0; i < m_tree.size(); ++i) {
+        CollisionSphereModel& sphere = m_tree[i];
+        sphere.center = transform * sphere.center;
+        if (!sphere.isLeaf()) {
+            sphere.left = &m_tree[sphere.left - tree.m_tree.data()];
+            sphere.right = &m_tree[sphere.right - tree.m_tree.data()];
+        }
+    }
+}
+
 double CollisionSphereModelTree::maxRadius() const
 {
     auto radius_comp = [](
@@ -362,7 +396,8 @@ void InitCollisionSphereModelFromSphere(
 template <typename Sphere>
 size_t CollisionSphereModelTree::buildRecursive(
     typename std::vector<const Sphere*>::iterator msfirst,
-    typename std::vector<const Sphere*>::iterator mslast)
+    typename std::vector<const Sphere*>::iterator mslast,
+    bool balanced)
 {
     if (mslast == msfirst) {
         ROS_DEBUG("Zero spheres base case");
@@ -428,15 +463,34 @@ size_t CollisionSphereModelTree::buildRecursive(
             return std::partition(first, last, SpherePartitionerZ<Sphere>(compact_bounding_sphere_center.z()));
         }
     };
-    // split the tree along the largest axis by the centroid
-    auto msmid = part(split_axis, msfirst, mslast);
-    if (msfirst == msmid || msmid == mslast) {
-        msmid = msfirst + (std::distance(msfirst, mslast) >> 1);
+    typename std::vector<const Sphere*>::iterator msmid;
+    if (balanced) {
+        // split the tree along the largest axis at the median sphere
+        auto coord = [split_axis](const Sphere* s) {
+            if (split_axis == 0) {
+                return get_x(*s);
+            } else if (split_axis == 1) {
+                return get_y(*s);
+            } else {
+                return get_z(*s);
+            }
+        };
+        msmid = msfirst + (count >> 1);
+        std::nth_element(msfirst, msmid, mslast,
+                [&](const Sphere* a, const Sphere* b) {
+                    return coord(a) < coord(b);
+                });
+    } else {
+        // split the tree along the largest axis by the centroid
+        msmid = part(split_axis, msfirst, mslast);
+        if (msfirst == msmid || msmid == mslast) {
+            msmid = msfirst + (std::distance(msfirst, mslast) >> 1);
+        }
     }
 
     // recurse on both subtrees
-    const size_t left_idx = buildRecursive<Sphere>(msfirst, msmid);
-    const size_t right_idx = buildRecursive<Sphere>(msmid, mslast);
+    const size_t left_idx = buildRecursive<Sphere>(msfirst, msmid, balanced);
+    const size_t right_idx = buildRecursive<Sphere>(msmid, mslast, balanced);
 
     const CollisionSphereModel& sl = m_tree[left_idx];
     const CollisionSphereModel& sr = m_tree[right_idx];
@@ -668,6 +722,280 @@ int CollisionSphereModelTree::computeLargestBoundingBoxAxis(
     return 0; // all the same
 }
 
+// Compute the squared distance transform of a sampled function along one line
+// (Felzenszwalb and Huttenlocher). v and z are scratch space of at least n and
+// n + 1 elements.
+static
+void SquaredDistanceTransform(
+    const double* f, int n, double* d, int* v, double* z)
+{
+    const double inf = std::numeric_limits<double>::infinity();
+    int k = 0;
+    v[0] = 0;
+    z[0] = -inf;
+    z[1] = inf;
+    for (int q = 1; q < n; ++q) {
+        double s;
+        while (true) {
+            const int p = v[k];
+            s = ((f[q] + q * q) - (f[p] + p * p)) / (2 * (q - p));
+            if (s <= z[k]) {
+                --k;
+            } else {
+                break;
+            }
+        }
+        ++k;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = inf;
+    }
+
+    k = 0;
+    for (int q = 0; q < n; ++q) {
+        while (z[k + 1] < q) {
+            ++k;
+        }
+        d[q] = (q - v[k]) * (q - v[k]) + f[v[k]];
+    }
+}
+
+/// \brief Build the distance field from a voxelization of the body's surface
+///
+/// The voxel centers must lie on the lattice of multiples of \p voxel_res in
+/// the body frame, which is the case for voxels returned by VoxelizeShape with
+/// a zero grid origin. Cells enclosed by the surface are treated as interior.
+///
+/// \param margin The minimum distance from the body to the border of the field
+/// \return false if there are no voxels to build the field from
+bool CollisionDistanceFieldModel::buildFrom(
+    const std::vector<Eigen::Vector3d>& voxels,
+    double voxel_res,
+    double margin)
+{
+    if (voxels.empty()) {
+        return false;
+    }
+
+    Eigen::Vector3d vmin = voxels.front();
+    Eigen::Vector3d vmax = voxels.front();
+    for (auto& v : voxels) {
+        vmin = vmin.cwiseMin(v);
+        vmax = vmax.cwiseMax(v);
+    }
+
+    const int border = std::max(1, (int)std::ceil(margin / voxel_res));
+    const int imin = (int)std::round(vmin.x() / voxel_res) - border;
+    const int jmin = (int)std::round(vmin.y() / voxel_res) - border;
+    const int kmin = (int)std::round(vmin.z() / voxel_res) - border;
+    const int imax = (int)std::round(vmax.x() / voxel_res) + border;
+    const int jmax = (int)std::round(vmax.y() / voxel_res) + border;
+    const int kmax = (int)std::round(vmax.z() / voxel_res) + border;
+
+    this->res = voxel_res;
+    this->origin = Eigen::Vector3d(imin, jmin, kmin) * voxel_res;
+    this->size_x = imax - imin + 1;
+    this->size_y = jmax - jmin + 1;
+    this->size_z = kmax - kmin + 1;
+    this->margin = border * voxel_res;
+
+    // the surface voxels occupy half a voxel diagonal around their centers
+    const double extent = 0.5 * std::sqrt(3.0) * voxel_res;
+    this->center = 0.5 * (vmin + vmax);
+    this->radius = 0.5 * (vmax - vmin).norm() + extent;
+
+    const int sx = size_x, sy = size_y, sz = size_z;
+    auto cell = [&](int x, int y, int z) { return (z * sy + y) * sx + x; };
+
+    const double big = std::numeric_limits<double>::max() / 4;
+    std::vector<double> sqrd(sx * sy * sz, big);
+    for (auto& v : voxels) {
+        const int x = (int)std::round(v.x() / voxel_res) - imin;
+        const int y = (int)std::round(v.y() / voxel_res) - jmin;
+        const int z = (int)std::round(v.z() / voxel_res) - kmin;
+        sqrd[cell(x, y, z)] = 0.0;
+    }
+
+    // flood fill the exterior from the border, which no voxel touches
+    std::vector<bool> outside(sqrd.size(), false);
+    std::vector<int> open;
+    auto visit = [&](int x, int y, int z) {
+        if (x < 0 || x >= sx || y < 0 || y >= sy || z < 0 || z >= sz) {
+            return;
+        }
+        const int c = cell(x, y, z);
+        if (outside[c] || sqrd[c] == 0.0) {
+            return;
+        }
+        outside[c] = true;
+        open.push_back(c);
+    };
+    visit(0, 0, 0);
+    while (!open.empty()) {
+        const int c = open.back();
+        open.pop_back();
+        const int x = c % sx;
+        const int y = (c / sx) % sy;
+        const int z = c / (sx * sy);
+        visit(x - 1, y, z);
+        visit(x + 1, y, z);
+        visit(x, y - 1, z);
+        visit(x, y + 1, z);
+        visit(x, y, z - 1);
+        visit(x, y, z + 1);
+    }
+
+    // separable squared euclidean distance transform, in cells
+    const int n = std::max(sx, std::max(sy, sz));
+    std::vector<double> f(n), d(n), zs(n + 1);
+    std::vector<int> vs(n);
+    auto transform_line = [&](int first, int stride, int count) {
+        for (int i = 0; i < count; ++i) {
+            f[i] = sqrd[first + i * stride];
+        }
+        SquaredDistanceTransform(f.data(), count, d.data(), vs.data(), zs.data());
+        for (int i = 0; i < count; ++i) {
+            sqrd[first + i * stride] = d[i];
+        }
+    };
+    for (int z = 0; z < sz; ++z) {
+        for (int y = 0; y < sy; ++y) {
+            transform_line(cell(0, y, z), 1, sx);
+        }
+    }
+    for (int z = 0; z < sz; ++z) {
+        for (int x = 0; x < sx; ++x) {
+            transform_line(cell(x, 0, z), sx, sy);
+        }
+    }
+    for (int y = 0; y < sy; ++y) {
+        for (int x = 0; x < sx; ++x) {
+            transform_line(cell(x, y, 0), sx * sy, sz);
+        }
+    }
+
+    dist.resize(sqrd.size());
+    for (size_t c = 0; c < sqrd.size(); ++c) {
+        const double dc = std::sqrt(sqrd[c]) * voxel_res;
+        if (outside[c]) {
+            dist[c] = (float)(dc - extent);
+        } else {
+            dist[c] = (float)(-dc - extent);
+        }
+    }
+
+    return true;
+}
+
+/// \brief Return a lower bound on the signed distance from a point, in the
+///     body frame, to the surface of the body
+double CollisionDistanceFieldModel::distance(const Eigen::Vector3d& p) const
+{
+    const Eigen::Vector3d q = (p - origin) / res;
+    const int x = (int)std::round(q.x());
+    const int y = (int)std::round(q.y());
+    const int z = (int)std::round(q.z());
+    if (x < 0 || x >= size_x || y < 0 || y >= size_y || z < 0 || z >= size_z) {
+        // the body lies at least the margin inside the field border
+        const Eigen::Vector3d hi(size_x - 1, size_y - 1, size_z - 1);
+        const Eigen::Vector3d qc = q.cwiseMax(Eigen::Vector3d::Zero()).cwiseMin(hi);
+        return (q - qc).norm() * res + margin - 0.5 * std::sqrt(3.0) * res;
+    }
+
+    // the nearest cell center is within half a cell diagonal
+    return dist[(z * size_y + y) * size_x + x] - 0.5 * std::sqrt(3.0) * res;
+}
+
+void CollisionVoxelsBitset::reset(
+    const Eigen::Vector3i& origin,
+    int size_x,
+    int size_y,
+    int size_z)
+{
+    this->origin = origin;
+    this->size_x = size_x;
+    this->size_y = size_y;
+    this->size_z = size_z;
+    this->row_words = (size_x + 63) / 64;
+    bits.assign((size_t)row_words * size_y * size_z, 0);
+}
+
+void CollisionVoxelsBitset::clear()
+{
+    reset(Eigen::Vector3i::Zero(), 0, 0, 0);
+}
+
+void CollisionVoxelsBitset::set(int x, int y, int z)
+{
+    const int cx = x - origin.x();
+    const int cy = y - origin.y();
+    const int cz = z - origin.z();
+    assert(cx >= 0 && cx < size_x && cy >= 0 && cy < size_y && cz >= 0 && cz < size_z);
+    bits[(cz * size_y + cy) * row_words + (cx >> 6)] |= std::uint64_t(1) << (cx & 63);
+}
+
+auto CollisionVoxelsBitset::word(int x, int y, int z) const -> std::uint64_t
+{
+    const int cy = y - origin.y();
+    const int cz = z - origin.z();
+    if (cy < 0 || cy >= size_y || cz < 0 || cz >= size_z) {
+        return 0;
+    }
+
+    const std::uint64_t* row = &bits[(cz * size_y + cy) * row_words];
+    auto row_word = [&](int w) -> std::uint64_t {
+        return w >= 0 && w < row_words ? row[w] : 0;
+    };
+
+    // floor division, since x may precede the box
+    const int cx = x - origin.x();
+    const int w = cx >= 0 ? cx / 64 : -((63 - cx) / 64);
+    const int b = cx - 64 * w;
+    if (b == 0) {
+        return row_word(w);
+    }
+    return (row_word(w) >> b) | (row_word(w + 1) << (64 - b));
+}
+
+/// Build the bitset of the voxels over the lattice they lie on, if any. The
+/// voxels must be centered on a common lattice of spacing voxel_res, as
+/// voxelized shapes are.
+bool CollisionVoxelsModel::buildBitset()
+{
+    bitset.clear();
+    if (voxels.empty() || voxel_res <= 0.0) {
+        return false;
+    }
+
+    const Eigen::Vector3d& v0 = voxels.front();
+    lattice_offset = Eigen::Vector3d(
+            v0.x() - voxel_res * std::round(v0.x() / voxel_res),
+            v0.y() - voxel_res * std::round(v0.y() / voxel_res),
+            v0.z() - voxel_res * std::round(v0.z() / voxel_res));
+
+    const double tol = 1e-3;
+    std::vector<Eigen::Vector3i> cells(voxels.size());
+    Eigen::Vector3i imin = Eigen::Vector3i::Constant(std::numeric_limits<int>::max());
+    Eigen::Vector3i imax = Eigen::Vector3i::Constant(std::numeric_limits<int>::min());
+    for (size_t i = 0; i < voxels.size(); ++i) {
+        const Eigen::Vector3d q = (voxels[i] - lattice_offset) / voxel_res;
+        const Eigen::Vector3d r(std::round(q.x()), std::round(q.y()), std::round(q.z()));
+        if ((q - r).cwiseAbs().maxCoeff() > tol) {
+            return false;
+        }
+        cells[i] = r.cast<int>();
+        imin = imin.cwiseMin(cells[i]);
+        imax = imax.cwiseMax(cells[i]);
+    }
+
+    const Eigen::Vector3i size = imax - imin + Eigen::Vector3i::Ones();
+    bitset.reset(imin, size.x(), size.y(), size.z());
+    for (auto& c : cells) {
+        bitset.set(c.x(), c.y(), c.z());
+    }
+    return true;
+}
+
 std::ostream& operator<<(std::ostream& o, const CollisionSphereModelTree& tree)
 {
     o << tree.m_tree;
@@ -688,6 +1016,14 @@ std::ostream& operator<<(std::ostream& o, const CollisionVoxelsModel& cvm)
     return o;
 }
 
+std::ostream& operator<<(std::ostream& o, const CollisionDistanceFieldModel& cdfm)
+{
+    o << "{ link_index: " << cdfm.link_index << ", res: " << cdfm.res <<
+            ", size: (" << cdfm.size_x << ", " << cdfm.size_y << ", " <<
+            cdfm.size_z << "), margin: " << cdfm.margin << " }";
+    return o;
+}
+
 std::ostream& operator<<(std::ostream& o, const CollisionGroupModel& cgm)
 {
     o << "{ name: " << cgm.name << ", link_indices: " << cgm.link_indices << " }";
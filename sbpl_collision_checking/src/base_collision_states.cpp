@@ -48,66 +48,59 @@ std::ostream& operator<<(std::ostream& o, const CollisionSphereState& css)
 
 void CollisionSphereStateTree::buildFrom(CollisionSpheresState* parent_state)
 {
-    m_tree.resize(parent_state->model->spheres.size());
+    const auto& spheres = parent_state->model->spheres;
+
+    m_tree.resize(spheres.size());
+    m_center_x.resize(spheres.size());
+    m_center_y.resize(spheres.size());
+    m_center_z.resize(spheres.size());
+    m_radius.resize(spheres.size());
+    m_left.resize(spheres.size());
+    m_right.resize(spheres.size());
+
     for (size_t i = 0; i < m_tree.size(); ++i) {
-        const CollisionSphereModel& sm = parent_state->model->spheres[i];
+        const CollisionSphereModel& sm = spheres[i];
         CollisionSphereState& state = m_tree[i];
         state.model = &sm; // map sphere state to sphere model
         state.parent_state = parent_state; // map sphere state to parent state
         state.pos = sm.center;
+
+        m_center_x[i] = sm.center.x();
+        m_center_y[i] = sm.center.y();
+        m_center_z[i] = sm.center.z();
+        m_radius[i] = sm.radius;
+
         if (sm.isLeaf()) {
             state.left = nullptr;
             state.right = nullptr;
+            m_left[i] = -1;
+            m_right[i] = -1;
         } else {
-            state.left = &m_tree[0] + sm.left->index();
-            state.right = &m_tree[0] + sm.right->index();
+            m_left[i] = sm.left->index();
+            m_right[i] = sm.right->index();
+            state.left = &m_tree[0] + m_left[i];
+            state.right = &m_tree[0] + m_right[i];
         }
     }
 }
 
 CollisionSphereStateTree::CollisionSphereStateTree(
     CollisionSphereStateTree&& o)
-:
-    m_tree(std::move(o.m_tree))
 {
+    moveFrom(std::move(o));
 }
 
 CollisionSphereStateTree::CollisionSphereStateTree(
     const CollisionSphereStateTree& o)
 {
-    m_tree = o.m_tree;
-    for (size_t i = 0; i < m_tree.size(); ++i) {
-        if (o.m_tree[i].isLeaf()) {
-            const auto ldiff = std::distance(
-                    o.root(), (const CollisionSphereState*)o.m_tree[i].left);
-            const auto rdiff = std::distance(
-                    o.root(), (const CollisionSphereState*)o.m_tree[i].right);
-            m_tree[i].left = &m_tree[0] + ldiff;
-            m_tree[i].right = &m_tree[0] + rdiff;
-        } else {
-            m_tree[i].left = nullptr;
-            m_tree[i].right = nullptr;
-        }
-    }
+    copyFrom(o);
 }
 
 CollisionSphereStateTree& CollisionSphereStateTree::operator=(
     const CollisionSphereStateTree& rhs)
 {
     if (this != &rhs) {
-        m_tree = rhs.m_tree;
-        for (size_t i = 0; i < m_tree.size(); ++i) {
-            if (rhs.m_tree[i].isLeaf()) {
-                m_tree[i].left = &m_tree[0] + std::distance(
-                        rhs.root(), (const CollisionSphereState*)rhs.m_tree[i].left);
-                m_tree[i].right = &m_tree[0] + std::distance(
-                        rhs.root(), (const CollisionSphereState*)rhs.m_tree[i].right);
-            }
-            else {
-                m_tree[i].left = nullptr;
-                m_tree[i].right = nullptr;
-            }
-        }
+        copyFrom(rhs);
     }
     return *this;
 }
@@ -116,11 +109,46 @@ CollisionSphereStateTree& CollisionSphereStateTree::operator=(
     CollisionSphereStateTree&& rhs)
 {
     if (this != &rhs) {
-        m_tree = std::move(rhs.m_tree);
+        moveFrom(std::move(rhs));
     }
     return *this;
 }
 
+/// Copy the sphere states and rewire the child pointers of the copies, using
+/// the child index arrays, to point into this tree
+void CollisionSphereStateTree::copyFrom(const CollisionSphereStateTree& o)
+{
+    m_tree = o.m_tree;
+    m_center_x = o.m_center_x;
+    m_center_y = o.m_center_y;
+    m_center_z = o.m_center_z;
+    m_radius = o.m_radius;
+    m_left = o.m_left;
+    m_right = o.m_right;
+    for (size_t i = 0; i < m_tree.size(); ++i) {
+        if (m_left[i] >= 0) {
+            m_tree[i].left = &m_tree[0] + m_left[i];
+            m_tree[i].right = &m_tree[0] + m_right[i];
+        } else {
+            m_tree[i].left = nullptr;
+            m_tree[i].right = nullptr;
+        }
+    }
+}
+
+/// Moving the underlying vectors preserves their storage, so the child
+/// pointers remain valid
+void CollisionSphereStateTree::moveFrom(CollisionSphereStateTree&& o)
+{
+    m_tree = std::move(o.m_tree);
+    m_center_x = std::move(o.m_center_x);
+    m_center_y = std::move(o.m_center_y);
+    m_center_z = std::move(o.m_center_z);
+    m_radius = std::move(o.m_radius);
+    m_left = std::move(o.m_left);
+    m_right = std::move(o.m_right);
+}
+
 std::ostream& operator<<(std::ostream& o, const CollisionSphereStateTree& tree)
 {
     o << tree.m_tree;
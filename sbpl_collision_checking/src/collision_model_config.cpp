@@ -262,21 +262,49 @@ bool CollisionSpheresModelConfig::Load(
         autogenerate = (bool)auto_value;
     }
 
+    bool balanced = false;
+    if (config.hasMember("balanced")) {
+        XmlRpc::XmlRpcValue& balanced_value = config["balanced"];
+        if (balanced_value.getType() != XmlRpc::XmlRpcValue::TypeBoolean) {
+            ROS_ERROR("Spheres model config 'balanced' element must be a boolean");
+            return false;
+        }
+
+        balanced = (bool)balanced_value;
+    }
+
     double radius = 0.0;
+    double max_overshoot = 0.0;
     std::vector<CollisionSphereConfig> spheres;
 
     if (autogenerate) {
-        // read in radius
-        if (!config.hasMember("radius")) {
-            ROS_ERROR("Spheres model config with 'auto' element true must have a 'radius' element");
-            return false;
+        // read in the maximum overshoot, which replaces the radius
+        if (config.hasMember("max_overshoot")) {
+            XmlRpc::XmlRpcValue& max_overshoot_value = config["max_overshoot"];
+            if (!IsNumeric(max_overshoot_value)) {
+                ROS_ERROR("Spheres model config 'max_overshoot' element must be numeric");
+                return false;
+            }
+            max_overshoot = ToDouble(max_overshoot_value);
+            if (max_overshoot <= 0.0) {
+                ROS_ERROR("Spheres model config 'max_overshoot' element must be positive");
+                return false;
+            }
         }
-        XmlRpc::XmlRpcValue& radius_value = config["radius"];
-        if (!IsNumeric(radius_value)) {
-            ROS_ERROR("Spheres model config 'radius' element must be numeric");
-            return false;
+
+        // read in radius
+        if (max_overshoot <= 0.0) {
+            if (!config.hasMember("radius")) {
+                ROS_ERROR("Spheres model config with 'auto' element true must have a 'radius' or 'max_overshoot' element");
+                return false;
+            }
+            XmlRpc::XmlRpcValue& radius_value = config["radius"];
+            if (!IsNumeric(radius_value)) {
+                ROS_ERROR("Spheres model config 'radius' element must be numeric");
+                return false;
+            }
+            radius = ToDouble(radius_value);
         }
-        radius = ToDouble(radius_value);
     }
     else {
         // read in spheres
@@ -294,6 +322,8 @@ bool CollisionSpheresModelConfig::Load(
     cfg.link_name = (std::string)link_name_value;
     cfg.autogenerate = autogenerate;
     cfg.radius = radius;
+    cfg.max_overshoot = max_overshoot;
+    cfg.balanced = balanced;
     cfg.spheres = std::move(spheres);
     return true;
 }
@@ -572,11 +602,22 @@ bool CollisionModelConfig::Load(
         ROS_WARN("No key '%s' found in robot collision model config", groups_key);
     }
 
+    std::string cache_path;
+    const char* cache_path_key = "cache_path";
+    if (config.hasMember(cache_path_key)) {
+        if (config[cache_path_key].getType() != XmlRpc::XmlRpcValue::TypeString) {
+            ROS_ERROR("Robot collision model config '%s' element must be a string", cache_path_key);
+            return false;
+        }
+        cache_path = (std::string)config[cache_path_key];
+    }
+
     // TODO: check references to spheres in collision_groups?
 
     cfg.spheres_models = std::move(spheres_models_config);
     cfg.voxel_models = std::move(voxels_models_config);
     cfg.groups = std::move(groups_config);
+    cfg.cache_path = std::move(cache_path);
     return true;
 }
 
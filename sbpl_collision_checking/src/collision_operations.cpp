@@ -70,5 +70,106 @@ std::vector<SphereIndex> GatherSphereIndices(
     return sphere_indices;
 }
 
+/// \brief Check the occupied cells of an occupancy grid against the distance
+///     field of a body
+///
+/// The cells around the body are divided recursively, skipping regions that
+/// the distance map shows to be free or the distance field shows to be clear
+/// of the body, so that only occupied cells close to the body are visited.
+///
+/// \param pose The pose of the body frame of the distance field
+/// \param[out] dist The squared distance from the first occupied cell found in
+///     collision to the body; unmodified if no collision was found
+bool CheckDistanceFieldVoxelsCollisions(
+    const OccupancyGrid& grid,
+    const CollisionDistanceFieldModel& field,
+    const Eigen::Affine3d& pose,
+    double padding,
+    double& dist)
+{
+    // test the body's bounding sphere first
+    const Eigen::Vector3d c = pose * field.center;
+    const double r = field.radius + padding;
+    if (grid.getSquaredDist(c.x(), c.y(), c.z()) >= r * r) {
+        return true;
+    }
+
+    struct Region
+    {
+        int lo[3];
+        int hi[3];
+    };
+
+    const int size[3] = { grid.numCellsX(), grid.numCellsY(), grid.numCellsZ() };
+    Region bounds;
+    grid.worldToGrid(c.x() - r, c.y() - r, c.z() - r,
+            bounds.lo[0], bounds.lo[1], bounds.lo[2]);
+    grid.worldToGrid(c.x() + r, c.y() + r, c.z() + r,
+            bounds.hi[0], bounds.hi[1], bounds.hi[2]);
+    for (int i = 0; i < 3; ++i) {
+        bounds.lo[i] = std::max(bounds.lo[i], 0);
+        bounds.hi[i] = std::min(bounds.hi[i], size[i] - 1);
+        if (bounds.lo[i] > bounds.hi[i]) {
+            return true;
+        }
+    }
+
+    const Eigen::Affine3d T_body_world = pose.inverse();
+    const double res = grid.resolution();
+
+    std::vector<Region> regions;
+    regions.push_back(bounds);
+    while (!regions.empty()) {
+        const Region region = regions.back();
+        regions.pop_back();
+
+        // distance from the middle cell to the farthest cell of the region
+        int mid[3];
+        Eigen::Vector3d half;
+        for (int i = 0; i < 3; ++i) {
+            mid[i] = (region.lo[i] + region.hi[i]) / 2;
+            half[i] = res * (region.hi[i] - mid[i]);
+        }
+        const double h = half.norm();
+
+        // no occupied cells in the region
+        const double obs_dist = grid.getDistance(mid[0], mid[1], mid[2]);
+        if (obs_dist > h) {
+            continue;
+        }
+
+        Eigen::Vector3d p;
+        grid.gridToWorld(mid[0], mid[1], mid[2], p.x(), p.y(), p.z());
+        const double d = field.distance(T_body_world * p);
+
+        // all cells in the region are clear of the body
+        if (d - h >= padding) {
+            continue;
+        }
+
+        if (h == 0.0) {
+            ROS_DEBUG_NAMED(COP_LOGGER, "    *collision* cell (%d, %d, %d), dist: %0.3fm", mid[0], mid[1], mid[2], d);
+            dist = d > 0.0 ? d * d : 0.0;
+            return false;
+        }
+
+        // split the region along its longest axis
+        int axis = 0;
+        for (int i = 1; i < 3; ++i) {
+            if (region.hi[i] - region.lo[i] > region.hi[axis] - region.lo[axis]) {
+                axis = i;
+            }
+        }
+        Region left = region;
+        Region right = region;
+        left.hi[axis] = mid[axis];
+        right.lo[axis] = mid[axis] + 1;
+        regions.push_back(right);
+        regions.push_back(left);
+    }
+
+    return true;
+}
+
 } // namespace collision
 } // namespace smpl
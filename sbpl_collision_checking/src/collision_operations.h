@@ -61,6 +61,22 @@ bool CheckVoxelsCollisions(
     double padding,
     double& dist);
 
+template <typename StateType>
+bool CheckDistanceFieldCollisions(
+    StateType& state,
+    std::vector<const CollisionSphereState*>& q,
+    const CollisionDistanceFieldModel& field,
+    const Eigen::Affine3d& pose,
+    double padding,
+    double& dist);
+
+bool CheckDistanceFieldVoxelsCollisions(
+    const OccupancyGrid& grid,
+    const CollisionDistanceFieldModel& field,
+    const Eigen::Affine3d& pose,
+    double padding,
+    double& dist);
+
 static const char* COP_LOGGER = "collision_operations";
 
 /// Check a single sphere against an occupancy grid
@@ -93,6 +109,13 @@ std::vector<SphereIndex> GatherSphereIndices(
 
 /// Check sphere hierarchies for collisions against an occupancy grid
 ///
+/// Spheres are taken from the queue in batches, whose distances are looked up
+/// with a single call to OccupancyGrid::getSquaredDists(). The spheres of a
+/// batch are then handled in order, so the check still stops at the first
+/// colliding leaf and only descends into spheres that are not collision-free.
+/// Spheres whose clearance, from OccupancyGrid::getClearanceFromPoint(),
+/// already covers their radius are accepted before the batched lookup.
+///
 /// \param state The aggregate state of the collision trees. Must have a method
 ///     updateSphereState(const SphereIndex&)
 /// \param q A queue for maintaining the list of remaining spheres to check,
@@ -101,14 +124,117 @@ std::vector<SphereIndex> GatherSphereIndices(
 /// \param padding Padding to be applied to each sphere
 /// \param dist The distance to the occupancy grid that caused the check to
 ///     fail, if any
+/// \param hit If non-null, set to the leaf sphere found in collision, if any
 template <typename StateType>
 bool CheckVoxelsCollisions(
     StateType& state,
     std::vector<const CollisionSphereState*>& q,
     const OccupancyGrid& grid,
     double padding,
+    double& dist,
+    const CollisionSphereState** hit = nullptr)
+{
+    const int batch_size = 8;
+    const CollisionSphereState* batch[batch_size];
+    double x[batch_size], y[batch_size], z[batch_size];
+    double sqrd_dists[batch_size];
+
+    while (!q.empty()) {
+        int count = 0;
+        while (count < batch_size && !q.empty()) {
+            const CollisionSphereState* s = q.back();
+            q.pop_back();
+
+            if (s->parent_state->index != -1) {
+                state.updateSphereState(SphereIndex(s->parent_state->index, s->index()));
+            }
+
+            // spheres well clear of the nearest obstacle are settled by the
+            // compact clearance field without reading the distance map
+            const double effective_radius = s->model->radius + padding;
+            if (grid.getClearanceFromPoint(s->pos.x(), s->pos.y(), s->pos.z()) >= effective_radius) {
+                continue;
+            }
+
+            batch[count] = s;
+            x[count] = s->pos.x();
+            y[count] = s->pos.y();
+            z[count] = s->pos.z();
+            ++count;
+        }
+
+        grid.getSquaredDists(x, y, z, count, sqrd_dists);
+
+        for (int i = 0; i < count; ++i) {
+            const CollisionSphereState* s = batch[i];
+            const double obs_dist = sqrd_dists[i];
+
+            ROS_DEBUG_NAMED(COP_LOGGER, "Checking sphere '%s' with radius %0.3f at (%0.3f, %0.3f, %0.3f)", s->model->name.c_str(), s->model->radius, s->pos.x(), s->pos.y(), s->pos.z());
+
+            const double effective_radius = s->model->radius + padding;
+            if (obs_dist >= effective_radius * effective_radius) {
+                ROS_DEBUG_NAMED(COP_LOGGER, " dist^2: %0.3f -> ok!", obs_dist);
+                continue; // no collision -> ok!
+            }
+
+            if (s->isLeaf()) {
+                if (s->parent_state->index == -1) { // meta-leaf
+                    const CollisionSphereState* sl = s->left->left;
+                    const CollisionSphereState* sr = s->right->right;
+
+                    if (sl && sr) {
+                        if (sl->model->radius > sr->model->radius) {
+                            q.push_back(sr);
+                            q.push_back(sl);
+                        } else {
+                            q.push_back(sl);
+                            q.push_back(sr);
+                        }
+                    } else if (sl) {
+                        q.push_back(sl);
+                    } else if (sr) {
+                        q.push_back(sr);
+                    }
+                } else { // normal leaf
+                    const CollisionSphereModel* sm = s->model;
+                    dist = obs_dist;
+                    if (hit) {
+                        *hit = s;
+                    }
+                    ROS_DEBUG_NAMED(COP_LOGGER, "    *collision* name: %s, pos: (%0.3f, %0.3f, %0.3f), radius: %0.3fm, dist: %0.3fm", sm->name.c_str(), s->pos.x(), s->pos.y(), s->pos.z(), sm->radius, obs_dist);
+                    return false;
+                }
+            } else { // recurse on both children
+                if (s->left->model->radius > s->right->model->radius) {
+                    q.push_back(s->right);
+                    q.push_back(s->left);
+                } else {
+                    q.push_back(s->left);
+                    q.push_back(s->right);
+                }
+            }
+        }
+    }
+
+    ROS_DEBUG_NAMED(COP_LOGGER, "No voxels collisions");
+    return true;
+}
+
+/// \brief Check sphere trees against the distance field of a body
+/// \param q The roots of the sphere trees to check
+/// \param pose The pose of the body frame of the distance field
+/// \param[out] dist The squared distance from the first leaf sphere found in
+///     collision to the body; unmodified if no collision was found
+template <typename StateType>
+bool CheckDistanceFieldCollisions(
+    StateType& state,
+    std::vector<const CollisionSphereState*>& q,
+    const CollisionDistanceFieldModel& field,
+    const Eigen::Affine3d& pose,
+    double padding,
     double& dist)
 {
+    const Eigen::Affine3d T_body_world = pose.inverse();
     while (!q.empty()) {
         const CollisionSphereState* s = q.back();
         q.pop_back();
@@ -117,50 +243,26 @@ bool CheckVoxelsCollisions(
             state.updateSphereState(SphereIndex(s->parent_state->index, s->index()));
         }
 
-        ROS_DEBUG_NAMED(COP_LOGGER, "Checking sphere '%s' with radius %0.3f at (%0.3f, %0.3f, %0.3f)", s->model->name.c_str(), s->model->radius, s->pos.x(), s->pos.y(), s->pos.z());
-
-        double obs_dist;
-        if (CheckSphereCollision(grid, *s, padding, obs_dist)) {
-            ROS_DEBUG_NAMED(COP_LOGGER, " dist^2: %0.3f -> ok!", obs_dist);
+        const double d = field.distance(T_body_world * s->pos);
+        if (d >= s->model->radius + padding) {
             continue; // no collision -> ok!
         }
 
         if (s->isLeaf()) {
-            if (s->parent_state->index == -1) { // meta-leaf
-                const CollisionSphereState* sl = s->left->left;
-                const CollisionSphereState* sr = s->right->right;
+            ROS_DEBUG_NAMED(COP_LOGGER, "    *collision* name: %s, pos: (%0.3f, %0.3f, %0.3f), radius: %0.3fm, dist: %0.3fm", s->model->name.c_str(), s->pos.x(), s->pos.y(), s->pos.z(), s->model->radius, d);
+            dist = d > 0.0 ? d * d : 0.0;
+            return false;
+        }
 
-                if (sl && sr) {
-                    if (sl->model->radius > sr->model->radius) {
-                        q.push_back(sr);
-                        q.push_back(sl);
-                    } else {
-                        q.push_back(sl);
-                        q.push_back(sr);
-                    }
-                } else if (sl) {
-                    q.push_back(sl);
-                } else if (sr) {
-                    q.push_back(sr);
-                }
-            } else { // normal leaf
-                const CollisionSphereModel* sm = s->model;
-                dist = obs_dist;
-                ROS_DEBUG_NAMED(COP_LOGGER, "    *collision* name: %s, pos: (%0.3f, %0.3f, %0.3f), radius: %0.3fm, dist: %0.3fm", sm->name.c_str(), s->pos.x(), s->pos.y(), s->pos.z(), sm->radius, obs_dist);
-                return false;
-            }
-        } else { // recurse on both children
-            if (s->left->model->radius > s->right->model->radius) {
-                q.push_back(s->right);
-                q.push_back(s->left);
-            } else {
-                q.push_back(s->left);
-                q.push_back(s->right);
-            }
+        if (s->left->model->radius > s->right->model->radius) {
+            q.push_back(s->right);
+            q.push_back(s->left);
+        } else {
+            q.push_back(s->left);
+            q.push_back(s->right);
         }
     }
 
-    ROS_DEBUG_NAMED(COP_LOGGER, "No voxels collisions");
     return true;
 }
 
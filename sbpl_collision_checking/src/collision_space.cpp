@@ -34,6 +34,8 @@
 
 // standard includes
 #include <assert.h>
+#include <algorithm>
+#include <atomic>
 #include <limits>
 #include <utility>
 #include <queue>
@@ -44,10 +46,13 @@
 #include <leatherman/print.h>
 #include <leatherman/viz.h>
 #include <smpl/angles.h>
+#include <smpl/telemetry.h>
 #include <smpl/debug/marker_conversions.h>
 
 #include <sbpl_collision_checking/shapes.h>
 
+#include "collision_operations.h"
+
 namespace smpl {
 namespace collision {
 
@@ -85,6 +90,8 @@ bool CollisionSpace::setJointPosition(
     if (m_rcm->hasJointVar(name)) {
         int jidx = m_rcm->jointVarIndex(name);
         m_joint_vars[jidx] = position;
+        m_batch_workers.clear();
+        ++m_version;
         return true;
     } else {
         return false;
@@ -96,6 +103,7 @@ bool CollisionSpace::setJointPosition(
 void CollisionSpace::setWorldToModelTransform(
     const Eigen::Affine3d& transform)
 {
+    restoreDeltaVar();
     m_rcs->setWorldToModelTransform(transform);
     const int vfidx = m_rcm->jointVarIndexFirst(0);
     const int vlidx = m_rcm->jointVarIndexLast(0);
@@ -104,6 +112,64 @@ void CollisionSpace::setWorldToModelTransform(
             m_rcs->getJointVarPositions() + vlidx,
             m_joint_vars.data() + vfidx);
     m_scm->setWorldToModelTransform(transform);
+    m_batch_workers.clear();
+    ++m_version;
+}
+
+/// \brief Enable skipping waypoints of motions that are provably free
+///
+/// When enabled, isStateToStateValid measures the clearance at the midpoint of
+/// each interval it bisects and skips the remaining waypoints of the interval
+/// if the worst-case sphere motion over it can not close that clearance.
+void CollisionSpace::setIntervalSkipping(bool enabled)
+{
+    m_interval_skipping = enabled;
+}
+
+/// \brief Enable the capsule broad phase for self collisions
+///
+/// See SelfCollisionModel::setCapsuleBroadPhase.
+void CollisionSpace::setCapsuleBroadPhase(bool enabled)
+{
+    m_scm->setCapsuleBroadPhase(enabled);
+    m_batch_workers.clear();
+}
+
+bool CollisionSpace::capsuleBroadPhase() const
+{
+    return m_scm->capsuleBroadPhase();
+}
+
+/// \brief Select the strategy used by isStateToStateValid
+void CollisionSpace::setMotionCheckMode(MotionCheckMode mode)
+{
+    m_motion_check_mode = mode;
+}
+
+/// \brief Set the number of threads used to check large batches of states
+///
+/// With more than one thread, areStatesValid divides batches of at least as
+/// many states as threads among the threads, each checking with its own clone
+/// of this collision space. The clones are created on the first such batch and
+/// recreated after the robot state, padding, or allowed collision matrix of
+/// this collision space changes. The shapes of objects inserted into or moved
+/// within the world are voxelized with as many threads.
+void CollisionSpace::setBatchThreadCount(int num_threads)
+{
+    num_threads = std::max(num_threads, 1);
+    if (num_threads == m_batch_thread_count) {
+        return;
+    }
+    m_batch_thread_count = num_threads;
+    if (m_wcm) {
+        m_wcm->setVoxelizeThreadCount(num_threads);
+    }
+    m_batch_workers.clear();
+    if (num_threads > 1) {
+        m_batch_pool.reset(new WorkerPool(num_threads));
+    } else {
+        m_batch_pool.reset();
+    }
 }
 
 /// \brief Set the padding applied to the collision model
@@ -111,6 +177,26 @@ void CollisionSpace::setPadding(double padding)
 {
     m_wcm->setPadding(padding);
     m_scm->setPadding(padding);
+    m_batch_workers.clear();
+    ++m_version;
+}
+
+/// \brief Enable caching of body-frame voxelizations of world object shapes
+///
+/// Useful when the same objects are moved through the world repeatedly. See
+/// WorldCollisionModel::setCacheShapeVoxels().
+void CollisionSpace::setCacheWorldShapeVoxels(bool enabled)
+{
+    m_wcm->setCacheShapeVoxels(enabled);
+}
+
+/// \brief Enable or disable distance field models for attached objects
+///
+/// Objects attached while enabled are checked against the world and the robot
+/// using a signed distance field in place of their spheres.
+void CollisionSpace::setAttachedBodyDistanceFields(bool enabled)
+{
+    m_abcm->setUseDistanceFields(enabled);
 }
 
 /// \brief Return the allowed collision matrix
@@ -125,7 +211,9 @@ const AllowedCollisionMatrix& CollisionSpace::allowedCollisionMatrix() const
 void CollisionSpace::updateAllowedCollisionMatrix(
     const AllowedCollisionMatrix& acm)
 {
-    return m_scm->updateAllowedCollisionMatrix(acm);
+    m_scm->updateAllowedCollisionMatrix(acm);
+    m_batch_workers.clear();
+    ++m_version;
 }
 
 /// \brief Set the allowed collision matrix
@@ -134,6 +222,8 @@ void CollisionSpace::setAllowedCollisionMatrix(
     const AllowedCollisionMatrix& acm)
 {
     m_scm->setAllowedCollisionMatrix(acm);
+    m_batch_workers.clear();
+    ++m_version;
 }
 
 /// \brief Insert an object into the world
@@ -149,6 +239,24 @@ bool CollisionSpace::insertObject(const CollisionObject* object)
     return true;
 }
 
+/// \brief Insert a set of objects into the world
+///
+/// The objects are voxelized in parallel and the distance map is updated once
+/// for the whole set. See WorldCollisionModel::insertObjects().
+///
+/// \param objects The objects
+/// \param n The number of objects
+/// \return true if all objects were inserted; false otherwise
+bool CollisionSpace::insertObjects(const CollisionObject* const* objects, size_t n)
+{
+    if (!m_wcm->insertObjects(objects, n)) {
+        ROS_WARN_NAMED(LOG, "Failed to add some of %zu objects to world collision model.", n);
+        return false;
+    }
+
+    return true;
+}
+
 /// \brief Remove an object from the world
 /// \param object The object
 /// \return true if the object was removed; false otherwise
@@ -188,6 +296,31 @@ bool CollisionSpace::removeShapes(const CollisionObject* object)
     return m_wcm->removeShapes(object);
 }
 
+/// \brief Begin a batch of world updates
+///
+/// The voxels freed and occupied by the objects inserted, removed, and moved
+/// before the matching call to commitUpdate() are merged into a single update
+/// of the distance map. See WorldCollisionModel::commitUpdate().
+void CollisionSpace::beginUpdate()
+{
+    m_wcm->beginUpdate();
+}
+
+/// \brief End a batch of world updates begun by beginUpdate()
+/// \return false if no batch was begun; true otherwise
+bool CollisionSpace::commitUpdate()
+{
+    return m_wcm->commitUpdate();
+}
+
+/// \brief Publish the world updates staged into a double buffered grid
+/// \param wait Whether to wait for an update still being staged
+/// \return true if updates were published; false otherwise
+bool CollisionSpace::publishUpdates(bool wait)
+{
+    return m_wcm->publishUpdates(wait);
+}
+
 /// \brief Attach a collision object to the robot
 /// \param id The name of the object
 /// \param shapes The shapes composing the object
@@ -200,7 +333,11 @@ bool CollisionSpace::attachObject(
     const Affine3dVector& transforms,
     const std::string& link_name)
 {
-    return m_abcm->attachBody(id, shapes, transforms, link_name);
+    if (!m_abcm->attachBody(id, shapes, transforms, link_name)) {
+        return false;
+    }
+    ++m_version;
+    return true;
 }
 
 /// \brief Detach a collision object from the robot
@@ -208,7 +345,11 @@ bool CollisionSpace::attachObject(
 /// \return true if the object was detached; false otherwise
 bool CollisionSpace::detachObject(const std::string& id)
 {
-    return m_abcm->detachBody(id);
+    if (!m_abcm->detachBody(id)) {
+        return false;
+    }
+    ++m_version;
+    return true;
 }
 
 /// \brief Return a visualization of the current world
@@ -389,18 +530,376 @@ bool CollisionSpace::collisionDetails(
     return m_scm->collisionDetails(*m_rcs, *m_abcs, m_gidx, details);
 }
 
+/// \brief Set the state subsequent calls to checkCollisionDelta are relative to
+void CollisionSpace::setReferenceState(const std::vector<double>& state)
+{
+    updateState(state);
+}
+
+/// \brief Check a state that differs from the reference state only in a single
+///     planning variable
+/// \param vidx The index of the planning variable
+/// \param value The position of the planning variable
+/// \param dist The distance to the nearest obstacle
+/// \return true if the state is collision-free; false otherwise
+bool CollisionSpace::checkCollisionDelta(int vidx, double value, double& dist)
+{
+    assert(vidx >= 0 && vidx < (int)planningVariableCount());
+    const int jidx = m_planning_joint_to_collision_model_indices[vidx];
+    if (m_delta_var != jidx) {
+        restoreDeltaVar();
+    }
+    m_rcs->setJointVarPosition(jidx, value);
+    m_delta_var = jidx;
+    return m_scm->checkCollision(*m_rcs, *m_abcs, m_gidx, dist);
+}
+
 Extension* CollisionSpace::getExtension(size_t class_code)
 {
-    if (class_code == GetClassCode<CollisionChecker>()) {
+    if (class_code == GetClassCode<CollisionChecker>() ||
+        class_code == GetClassCode<CollisionCheckerCloneExtension>() ||
+        class_code == GetClassCode<CollisionDistanceExtension>() ||
+        class_code == GetClassCode<MemoryUsageExtension>() ||
+        class_code == GetClassCode<CancellationExtension>() ||
+        class_code == GetClassCode<CollisionWorldVersionExtension>() ||
+        class_code == GetClassCode<CollisionClearanceExtension>())
+    {
         return this;
     }
     return nullptr;
 }
 
+double CollisionSpace::distanceToCollision(const RobotState& state)
+{
+    return collisionDistance(state);
+}
+
+/// Return the smallest distance to collision of the waypoints interpolated
+/// along a motion, or 0 if the motion can not be interpolated.
+double CollisionSpace::distanceToCollision(
+    const RobotState& start,
+    const RobotState& finish)
+{
+    std::vector<RobotState> path;
+    if (!interpolatePath(start, finish, path)) {
+        return 0.0;
+    }
+
+    double dist = std::numeric_limits<double>::max();
+    for (auto& waypoint : path) {
+        dist = std::min(dist, collisionDistance(waypoint));
+    }
+    return dist;
+}
+
+/// The cost is summed over the leaf spheres of the group, each measured
+/// against the distance map with the world padding applied, and the gradient
+/// of each sphere's cost is carried to the planning variables through the
+/// Jacobian of the sphere center. Attached bodies and self collisions do not
+/// contribute. Planar and floating joints are treated as fixed.
+bool CollisionSpace::collisionCostGradient(
+    const RobotState& state,
+    double clearance,
+    double& cost,
+    std::vector<double>& gradient)
+{
+    assert(state.size() == planningVariableCount());
+    if (clearance <= 0.0) {
+        return false;
+    }
+
+    if (m_cost_spheres.empty()) {
+        m_cost_spheres = GatherSphereIndices(*m_rcs, m_gidx);
+    }
+
+    updateState(state);
+
+    cost = 0.0;
+    gradient.assign(planningVariableCount(), 0.0);
+
+    const double padding = m_wcm->padding();
+    for (const SphereIndex& sidx : m_cost_spheres) {
+        m_rcs->updateSphereState(sidx);
+        const CollisionSphereState& ss = m_rcs->sphereState(sidx);
+        const Eigen::Vector3d& p = ss.pos;
+
+        Eigen::Vector3d dgrad;
+        const double d = m_grid->getDistanceGradient(p.x(), p.y(), p.z(), dgrad) -
+                ss.model->radius - padding;
+        if (d >= clearance) {
+            continue;
+        }
+
+        // cost of the sphere and its derivative with respect to d
+        double dcost;
+        if (d < 0.0) {
+            cost += 0.5 * clearance - d;
+            dcost = -1.0;
+        } else {
+            cost += (clearance - d) * (clearance - d) / (2.0 * clearance);
+            dcost = (d - clearance) / clearance;
+        }
+        if (dgrad.isZero()) {
+            continue;
+        }
+
+        const Eigen::Vector3d pgrad = dcost * dgrad;
+        const int lidx = m_rcs->spheresState(sidx.ss).model->link_index;
+        const int ljidx = m_rcm->linkParentJointIndex(lidx);
+        for (size_t vidx = 0; vidx < planningVariableCount(); ++vidx) {
+            const int jvidx = m_planning_joint_to_collision_model_indices[vidx];
+            const int jidx = m_rcm->jointVarJointIndex(jvidx);
+            if (ljidx != jidx && !m_rcm->isDescendantJoint(ljidx, jidx)) {
+                continue;
+            }
+
+            const JointType type = m_rcm->jointType(jidx);
+            if (type != REVOLUTE && type != CONTINUOUS && type != PRISMATIC) {
+                continue;
+            }
+
+            // joint frame in the model frame
+            Eigen::Affine3d T_model_joint = m_rcm->jointOrigin(jidx);
+            const int plidx = m_rcm->jointParentLinkIndex(jidx);
+            if (plidx >= 0) {
+                T_model_joint = m_rcs->linkTransform(plidx) * T_model_joint;
+            }
+            const Eigen::Vector3d axis =
+                    T_model_joint.linear() * m_rcm->jointAxis(jidx);
+
+            // motion of the sphere center per unit of the variable
+            Eigen::Vector3d dp;
+            if (type == PRISMATIC) {
+                dp = axis;
+            } else {
+                dp = axis.cross(p - T_model_joint.translation());
+            }
+            gradient[vidx] += pgrad.dot(dp);
+        }
+    }
+
+    return true;
+}
+
+/// Return the memory held by the buffers of this collision space and of its
+/// batch workers. The robot and world collision models are shared between
+/// clones and the occupancy grid is reported by its distance map, so neither
+/// is counted.
+auto CollisionSpace::memoryUsage() const -> std::size_t
+{
+    auto usage = MemoryUsage(m_joint_vars);
+    usage += MemoryUsage(m_intervals);
+    usage += MemoryUsage(m_planning_joint_to_collision_model_indices);
+    usage += MemoryUsage(m_batch_workers);
+    for (auto& worker : m_batch_workers) {
+        usage += sizeof(CollisionSpace) + worker->memoryUsage();
+    }
+    return usage;
+}
+
+/// Return the version of the collision world. The world collision model's
+/// version, this collision space's version, and the number of updates published
+/// to a shared distance map only increase, so their sum changes whenever either
+/// the world or the robot's configuration does.
+auto CollisionSpace::worldVersion() const -> std::uint64_t
+{
+    auto version = m_wcm->version() + m_version;
+    if (m_shared_map != nullptr) {
+        version += m_shared_map->version();
+    }
+    return version;
+}
+
+/// Return the smallest clearance from the world of the waypoints that
+/// isStateToStateValid() checks along a motion, or 0 if the motion can not be
+/// certified: with conservative advancement, which does not check discrete
+/// waypoints, or with attached bodies, whose clearance is not computed.
+double CollisionSpace::motionClearance(
+    const RobotState& start,
+    const RobotState& finish)
+{
+    if (m_motion_check_mode == MotionCheckMode::ConservativeAdvancement ||
+        m_abcm->attachedBodyCount() > 0)
+    {
+        return 0.0;
+    }
+
+    std::vector<RobotState> path;
+    if (!interpolatePath(start, finish, path)) {
+        return 0.0;
+    }
+
+    double clearance = std::numeric_limits<double>::infinity();
+    for (auto& waypoint : path) {
+        updateState(waypoint);
+        clearance = std::min(
+                clearance,
+                m_scm->worldCollisionDistance(*m_rcs, *m_abcs, m_gidx));
+    }
+    return std::max(clearance, 0.0);
+}
+
+double CollisionSpace::worldGrowth() const
+{
+    return m_wcm->growth();
+}
+
+/// Changes to the padding, the allowed collision matrix, or a shared distance
+/// map are not bounded by the growth of the world and begin a new epoch.
+auto CollisionSpace::growthEpoch() const -> std::uint64_t
+{
+    auto epoch = m_wcm->growthEpoch() + m_version;
+    if (m_shared_map != nullptr) {
+        epoch += m_shared_map->version();
+    }
+    return epoch;
+}
+
+/// Create a collision space that shares the robot and motion models, the
+/// attached bodies model, the world collision model, and the occupancy grid
+/// with this collision space, but keeps its own robot state and self collision
+/// model, so that the two may check states concurrently. Objects inserted into
+/// the world or attached to the robot through either are visible to both;
+/// the padding, allowed collision matrix, world-to-model transform, and joint
+/// positions are copied.
+auto CollisionSpace::clone() -> std::unique_ptr<CollisionChecker>
+{
+    std::unique_ptr<CollisionSpace> cspace(new CollisionSpace);
+    cspace->m_grid = m_grid;
+    cspace->m_shared_map = m_shared_map;
+    cspace->m_planning_variables = m_planning_variables;
+    cspace->m_rcm = m_rcm;
+    cspace->m_abcm = m_abcm;
+    cspace->m_rmcm = m_rmcm;
+    cspace->m_rcs = std::make_shared<RobotCollisionState>(m_rcm.get());
+    cspace->m_abcs = std::make_shared<AttachedBodiesCollisionState>(
+            m_abcm.get(), cspace->m_rcs.get());
+    cspace->m_wcm = m_wcm;
+    cspace->m_scm = std::make_shared<SelfCollisionModel>(
+            m_grid, m_rcm.get(), m_abcm.get());
+    cspace->m_scm->setPadding(m_wcm->padding());
+    cspace->m_scm->setAllowedCollisionMatrix(m_scm->allowedCollisionMatrix());
+    cspace->m_scm->setWorldToModelTransform(m_rcs->worldToModelTransform());
+    cspace->m_scm->setCapsuleBroadPhase(m_scm->capsuleBroadPhase());
+    cspace->m_group_name = m_group_name;
+    cspace->m_gidx = m_gidx;
+    cspace->m_planning_joint_to_collision_model_indices =
+            m_planning_joint_to_collision_model_indices;
+    cspace->m_interval_skipping = m_interval_skipping;
+    cspace->m_motion_check_mode = m_motion_check_mode;
+    cspace->m_version = m_version;
+
+    restoreDeltaVar();
+    cspace->m_joint_vars = m_joint_vars;
+    cspace->copyState();
+
+    // The self collision model inserts the voxels of the links outside the
+    // group into the shared grid during its first check. Those voxels coincide
+    // with the ones this collision space has already inserted, so the grid is
+    // left as is, but the update must happen now rather than concurrently with
+    // checks made by other collision spaces.
+    double dist;
+    (void)cspace->m_scm->checkCollision(
+            *cspace->m_rcs, *cspace->m_abcs, cspace->m_gidx, dist);
+
+    return std::move(cspace);
+}
+
 bool CollisionSpace::isStateValid(const RobotState& state, bool verbose)
 {
+    return isStateValid(RobotStateView(state), verbose);
+}
+
+bool CollisionSpace::isStateValid(RobotStateView state, bool verbose)
+{
+    assert(state.size() == planningVariableCount());
+    TelemetryTimer timer(TelemetryEvent::StateCheck);
     double dist = std::numeric_limits<double>::max();
-    return checkCollision(state, dist);
+    return checkCollision(state.data(), dist);
+}
+
+/// Consecutive states of a batch are typically nearby points along a path, so
+/// each is written directly into the robot collision state, which recomputes
+/// only the link transforms affected by the variables that changed.
+bool CollisionSpace::areStatesValid(
+    const RobotState* states,
+    size_t n,
+    bool* out)
+{
+    if (m_batch_pool && n >= (size_t)m_batch_thread_count) {
+        return areStatesValidParallel(states, n, out);
+    }
+
+    bool all_valid = true;
+    for (size_t i = 0; i < n; ++i) {
+        if (Expired(m_cancel)) {
+            if (out != nullptr) {
+                std::fill(out + i, out + n, false);
+            }
+            return false;
+        }
+        assert(states[i].size() == planningVariableCount());
+        TelemetryTimer timer(TelemetryEvent::StateCheck);
+        updateState(states[i].data());
+        double dist = std::numeric_limits<double>::max();
+        bool valid = m_scm->checkCollision(*m_rcs, *m_abcs, m_gidx, dist);
+        if (out != nullptr) {
+            out[i] = valid;
+        } else if (!valid) {
+            return false;
+        }
+        all_valid &= valid;
+    }
+    return all_valid;
+}
+
+bool CollisionSpace::areStatesValidParallel(
+    const RobotState* states,
+    size_t n,
+    bool* out)
+{
+    // clones are created here rather than inside the job, since cloning
+    // updates the shared occupancy grid
+    if (m_batch_workers.empty()) {
+        for (int i = 1; i < m_batch_thread_count; ++i) {
+            auto checker = clone();
+            m_batch_workers.emplace_back(
+                    static_cast<CollisionSpace*>(checker.release()));
+        }
+    }
+
+    restoreDeltaVar();
+
+    std::atomic<bool> all_valid(true);
+    m_batch_pool->run(n, [&](int tid, size_t i)
+    {
+        // without an output array, the answer is known at the first invalid
+        // state, and the remaining items are skipped
+        if (out == nullptr && !all_valid.load(std::memory_order_relaxed)) {
+            return;
+        }
+        if (Expired(m_cancel)) {
+            if (out != nullptr) {
+                out[i] = false;
+            }
+            all_valid.store(false, std::memory_order_relaxed);
+            return;
+        }
+        assert(states[i].size() == planningVariableCount());
+        TelemetryTimer timer(TelemetryEvent::StateCheck);
+        CollisionSpace* cspace =
+                tid == 0 ? this : m_batch_workers[tid - 1].get();
+        double dist = std::numeric_limits<double>::max();
+        const bool valid = cspace->checkCollision(states[i].data(), dist);
+        if (out != nullptr) {
+            out[i] = valid;
+        }
+        if (!valid) {
+            all_valid.store(false, std::memory_order_relaxed);
+        }
+    });
+
+    return all_valid.load();
 }
 
 bool CollisionSpace::isStateToStateValid(
@@ -408,6 +907,11 @@ bool CollisionSpace::isStateToStateValid(
     const RobotState& finish,
     bool verbose)
 {
+    TelemetryTimer timer(TelemetryEvent::MotionCheck);
+    if (m_motion_check_mode == MotionCheckMode::ConservativeAdvancement) {
+        return checkMotionConservativeAdvancement(start, finish);
+    }
+
     const double res = 0.05;
 
     MotionInterpolation interp(m_rcm.get());
@@ -419,32 +923,76 @@ bool CollisionSpace::isStateToStateValid(
             res,
             interp);
 
-    const int inc_cc = 5;
-
     RobotState interm;
 
-    // TODO: Looks like the idea here is to collision check the path starting at
-    // the most coarse resolution (just the endpoints) and increasing the
-    // granularity until all points are checked. This could probably be made
-    // irrespective of the number of waypoints by bisecting the path and
-    // checking the endpoints recursively.
-    if (interp.waypointCount() > inc_cc) {
-        // try to find collisions that might come later in the path earlier
-        for (int i = 0; i < inc_cc; i++) {
-            for (size_t j = i; j < interp.waypointCount(); j = j + inc_cc) {
-                interp.interpolate(j, interm, m_planning_joint_to_collision_model_indices);
-                if (!isStateValid(interm, verbose)) {
-                    return false;
-                }
-            }
+    // successors typically differ from their parent in a single variable, in
+    // which case the waypoints are checked as deltas from the start state so
+    // that only the transforms below the moving joint are recomputed
+    const int delta_vidx = singleChangedVariable(start, finish);
+    if (delta_vidx >= 0) {
+        setReferenceState(start);
+    }
+    auto check_waypoint = [&](int widx)
+    {
+        interp.interpolate(widx, interm, m_planning_joint_to_collision_model_indices);
+        if (delta_vidx >= 0) {
+            double dist = std::numeric_limits<double>::max();
+            return checkCollisionDelta(delta_vidx, interm[delta_vidx], dist);
         }
-    } else {
-        for (size_t i = 0; i < interp.waypointCount(); i++) {
-            interp.interpolate(i, interm, m_planning_joint_to_collision_model_indices);
-            if (!isStateValid(interm, verbose)) {
-                return false;
+        return isStateValid(interm, verbose);
+    };
+
+    const int wcount = interp.waypointCount();
+    if (wcount == 0) {
+        return true;
+    }
+
+    // check the endpoints, then the midpoints of successively finer intervals
+    // between them, so that collisions anywhere along the path are found
+    // after a few checks
+    if (!check_waypoint(0) || !check_waypoint(wcount - 1)) {
+        return false;
+    }
+
+    // an upper bound on the distance any sphere moves between consecutive
+    // waypoints, for proving intervals free from the clearance at their
+    // midpoints
+    double step_motion = 0.0;
+    if (m_interval_skipping) {
+        step_motion = m_rmcm->getMaxSphereMotion(
+                start, finish, m_planning_joint_to_collision_model_indices);
+        step_motion /= (double)(wcount - 1);
+    }
+
+    auto& intervals = m_intervals;
+    intervals.clear();
+    intervals.emplace_back(0, wcount - 1);
+    for (size_t i = 0; i < intervals.size(); ++i) {
+        const int lo = intervals[i].first;
+        const int hi = intervals[i].second;
+        if (hi - lo < 2) {
+            continue;
+        }
+
+        const int mid = lo + (hi - lo) / 2;
+        if (!check_waypoint(mid)) {
+            return false;
+        }
+
+        if (m_interval_skipping) {
+            // no sphere within the interval strays further than this from its
+            // position at the midpoint; spheres of two links may approach one
+            // another at twice that rate
+            const double reach = step_motion * (double)std::max(mid - lo, hi - mid);
+            const double clearance =
+                    m_scm->collisionDistance(*m_rcs, *m_abcs, m_gidx);
+            if (2.0 * reach < clearance) {
+                continue;
             }
         }
+
+        intervals.emplace_back(lo, mid);
+        intervals.emplace_back(mid, hi);
     }
 
     return true;
@@ -551,6 +1099,8 @@ bool CollisionSpace::init(
     const std::vector<std::string>& planning_joints)
 {
     m_grid = grid;
+    m_shared_map = dynamic_cast<const SharedDistanceMap*>(
+            m_grid->getDistanceField().get());
     m_rcm = rcm;
     if (!m_rcm) {
         ROS_ERROR_NAMED(LOG, "Failed to initialize the Robot Collision Model");
@@ -588,6 +1138,7 @@ bool CollisionSpace::init(
     m_rcs = std::make_shared<RobotCollisionState>(m_rcm.get());
     m_abcs = std::make_shared<AttachedBodiesCollisionState>(m_abcm.get(), m_rcs.get());
     m_wcm = std::make_shared<WorldCollisionModel>(m_grid);
+    m_wcm->setVoxelizeThreadCount(m_batch_thread_count);
     m_scm = std::make_shared<SelfCollisionModel>(m_grid, m_rcm.get(), m_abcm.get());
 
     m_joint_vars.assign(
@@ -630,6 +1181,89 @@ void CollisionSpace::updateState(
 void CollisionSpace::copyState()
 {
     m_rcs->setJointVarPositions(m_joint_vars.data());
+    m_delta_var = -1;
+}
+
+/// Return the robot collision state's copy of the joint variable modified by
+/// checkCollisionDelta to its reference position.
+void CollisionSpace::restoreDeltaVar()
+{
+    if (m_delta_var >= 0) {
+        m_rcs->setJointVarPosition(m_delta_var, m_joint_vars[m_delta_var]);
+        m_delta_var = -1;
+    }
+}
+
+/// Check a motion by conservative advancement. From each checked state along
+/// the motion, advance by the largest step over which no sphere can move
+/// further than half of the clearance at that state (spheres of two links may
+/// approach one another at twice the rate of a single sphere). Steps are never
+/// shorter than half the resolution of the occupancy grid, below which the
+/// distance field can not resolve the clearance.
+bool CollisionSpace::checkMotionConservativeAdvancement(
+    const RobotState& start,
+    const RobotState& finish)
+{
+    const double max_motion = m_rmcm->getMaxSphereMotion(
+            start, finish, m_planning_joint_to_collision_model_indices);
+
+    MotionInterpolation interp(m_rcm.get());
+    interp.setEndpoints(start, finish, m_planning_joint_to_collision_model_indices);
+    const RobotState& diffs = interp.diffs();
+
+    const int delta_vidx = singleChangedVariable(start, finish);
+    if (delta_vidx >= 0) {
+        setReferenceState(start);
+    }
+
+    const double min_motion = 0.5 * m_grid->resolution();
+
+    RobotState interm(start.size());
+    double alpha = 0.0;
+    while (true) {
+        double dist = std::numeric_limits<double>::max();
+        if (delta_vidx >= 0) {
+            const double value = start[delta_vidx] + alpha * diffs[delta_vidx];
+            if (!checkCollisionDelta(delta_vidx, value, dist)) {
+                return false;
+            }
+        } else {
+            for (size_t i = 0; i < start.size(); ++i) {
+                interm[i] = start[i] + alpha * diffs[i];
+            }
+            updateState(interm);
+            if (!m_scm->checkCollision(*m_rcs, *m_abcs, m_gidx, dist)) {
+                return false;
+            }
+        }
+
+        if (alpha >= 1.0 || max_motion == 0.0) {
+            return true;
+        }
+
+        const double clearance =
+                m_scm->collisionDistance(*m_rcs, *m_abcs, m_gidx);
+        const double step = std::max(0.5 * clearance, min_motion) / max_motion;
+        alpha = std::min(1.0, alpha + step);
+    }
+}
+
+/// Return the index of the only planning variable that differs between two
+/// states, or -1 if they differ in none or in more than one variable.
+int CollisionSpace::singleChangedVariable(
+    const std::vector<double>& start,
+    const std::vector<double>& finish) const
+{
+    int changed = -1;
+    for (size_t vidx = 0; vidx < start.size(); ++vidx) {
+        if (start[vidx] != finish[vidx]) {
+            if (changed >= 0) {
+                return -1;
+            }
+            changed = (int)vidx;
+        }
+    }
+    return changed;
 }
 
 /// \brief Check whether the planning joint variables are within limits
@@ -35,8 +35,13 @@
 // standard includes
 #include <assert.h>
 #include <stdlib.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <functional>
 #include <stack>
+#include <thread>
 #include <utility>
 
 // system includes
@@ -46,6 +51,7 @@
 #include <ros/console.h>
 #include <smpl/geometry/voxelize.h>
 #include <smpl/geometry/bounding_spheres.h>
+#include <smpl/worker_pool.h>
 #include <urdf/model.h>
 
 // project includes
@@ -58,6 +64,164 @@ namespace collision {
 
 static const char* LOG = "robot_model";
 
+namespace {
+
+/// Spheres and voxels generated for links of a previously loaded model, keyed
+/// by a hash of the link geometry and the generation parameters
+struct GeneratedModelCache
+{
+    struct Sphere
+    {
+        double center[3];
+        double radius;
+        std::int32_t priority;
+        std::int32_t geom_index; // -1 if not attached to a geometry
+        std::int32_t shape_index;
+    };
+
+    hash_map<std::uint64_t, std::vector<Sphere>> spheres;
+    hash_map<std::uint64_t, std::vector<Eigen::Vector3d>> voxels;
+};
+
+const char CACHE_MAGIC[8] = { 'S', 'B', 'P', 'L', 'C', 'C', 'M', '1' };
+
+const std::uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+const std::uint64_t FNV_PRIME = 1099511628211ull;
+
+// FNV-1a
+auto HashBytes(std::uint64_t h, const void* data, size_t size) -> std::uint64_t
+{
+    auto* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; ++i) {
+        h ^= bytes[i];
+        h *= FNV_PRIME;
+    }
+    return h;
+}
+
+template <class T>
+auto HashValue(std::uint64_t h, const T& value) -> std::uint64_t
+{
+    return HashBytes(h, &value, sizeof(value));
+}
+
+template <class T>
+void WriteValue(std::ostream& o, const T& value)
+{
+    o.write((const char*)&value, sizeof(value));
+}
+
+template <class T>
+bool ReadValue(std::istream& i, T& value)
+{
+    return (bool)i.read((char*)&value, sizeof(value));
+}
+
+template <class T>
+void WriteArray(std::ostream& o, const std::vector<T>& values)
+{
+    WriteValue(o, (std::uint64_t)values.size());
+    o.write((const char*)values.data(), values.size() * sizeof(T));
+}
+
+template <class T>
+bool ReadArray(std::istream& i, std::vector<T>& values)
+{
+    std::uint64_t size;
+    if (!ReadValue(i, size)) {
+        return false;
+    }
+
+    // guard against allocating for a truncated or corrupt file
+    auto pos = i.tellg();
+    i.seekg(0, std::ios::end);
+    auto remaining = (std::uint64_t)(i.tellg() - pos);
+    i.seekg(pos);
+    if (size > remaining / sizeof(T)) {
+        return false;
+    }
+
+    values.resize(size);
+    return (bool)i.read((char*)values.data(), size * sizeof(T));
+}
+
+template <class Map>
+bool ReadEntries(std::istream& i, Map& entries)
+{
+    std::uint64_t count;
+    if (!ReadValue(i, count)) {
+        return false;
+    }
+    for (std::uint64_t n = 0; n < count; ++n) {
+        std::uint64_t key;
+        if (!ReadValue(i, key) || !ReadArray(i, entries[key])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <class Map>
+void WriteEntries(std::ostream& o, const Map& entries)
+{
+    WriteValue(o, (std::uint64_t)entries.size());
+    for (auto& entry : entries) {
+        WriteValue(o, entry.first);
+        WriteArray(o, entry.second);
+    }
+}
+
+bool ReadGeneratedModelCache(
+    const std::string& path,
+    GeneratedModelCache& cache)
+{
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs) {
+        return false;
+    }
+
+    char magic[sizeof(CACHE_MAGIC)];
+    if (!ifs.read(magic, sizeof(magic)) ||
+        std::memcmp(magic, CACHE_MAGIC, sizeof(magic)) != 0)
+    {
+        ROS_WARN_NAMED(LOG, "Ignoring collision model cache '%s' with unrecognized format", path.c_str());
+        return false;
+    }
+
+    if (!ReadEntries(ifs, cache.spheres) || !ReadEntries(ifs, cache.voxels)) {
+        ROS_WARN_NAMED(LOG, "Ignoring truncated collision model cache '%s'", path.c_str());
+        cache.spheres.clear();
+        cache.voxels.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool WriteGeneratedModelCache(
+    const std::string& path,
+    const GeneratedModelCache& cache)
+{
+    // write to a temporary file first so that a concurrent or interrupted
+    // write never leaves a partial cache behind
+    auto tmp_path = path + ".tmp";
+    {
+        std::ofstream ofs(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!ofs) {
+            return false;
+        }
+        ofs.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        WriteEntries(ofs, cache.spheres);
+        WriteEntries(ofs, cache.voxels);
+        if (!ofs) {
+            return false;
+        }
+    }
+    return std::rename(tmp_path.c_str(), path.c_str()) == 0;
+}
+
+} // namespace
+
 auto RobotCollisionModel::Load(
     const ::urdf::ModelInterface& urdf,
     const CollisionModelConfig& config)
@@ -521,39 +685,41 @@ bool RobotCollisionModel::initCollisionModel(
         return false;
     }
 
-    if (!initCollisionShapes(urdf)) {
+    WorkerPool pool(std::max(1, (int)std::thread::hardware_concurrency()));
+
+    if (!initCollisionShapes(urdf, pool)) {
         ROS_ERROR("Failed to initialize collision shapes");
         return false;
     }
 
-    // initialize spheres models
-    m_spheres_models.reserve(config.spheres_models.size());
-    for (auto& spheres_config : config.spheres_models) {
+    GeneratedModelCache cache;
+    if (!config.cache_path.empty() &&
+        ReadGeneratedModelCache(config.cache_path, cache))
+    {
+        ROS_DEBUG_NAMED(LOG, "Read %zu spheres models and %zu voxels models from cache '%s'", cache.spheres.size(), cache.voxels.size(), config.cache_path.c_str());
+    }
+
+    // the entries of the cache to write back, limited to those referenced by
+    // this model
+    GeneratedModelCache next_cache;
+    bool generated_any = false;
+
+    // initialize spheres models. autogenerated spheres are generated for all
+    // links in parallel and the trees are then built in configuration order
+    auto spheres_count = config.spheres_models.size();
+    std::vector<std::vector<CollisionSphereModel>> sphere_lists(spheres_count);
+    std::vector<int> spheres_urdf_links(spheres_count, -1);
+    std::vector<std::uint64_t> spheres_keys(spheres_count, 0);
+    std::vector<size_t> spheres_to_generate;
+    for (size_t i = 0; i < spheres_count; ++i) {
+        auto& spheres_config = config.spheres_models[i];
         if (!hasLink(spheres_config.link_name)) {
             ROS_WARN("Missing link '%s' for spheres configuration", spheres_config.link_name.c_str());
             continue;
         }
 
-        std::vector<CollisionSphereModel> sphere_models;
-        if (spheres_config.autogenerate) {
-            std::vector<CollisionSphereModel> auto_spheres;
-
-            auto lit = urdf.links_.find(spheres_config.link_name);
-            if (lit == end(urdf.links_)) {
-                continue;
-            }
-
-            auto urdf_link_index = std::distance(begin(urdf.links_), lit);
-
-            if (!generateSphereModels(
-                    urdf_link_index, spheres_config.radius, auto_spheres))
-            {
-                continue;
-            }
-
-            sphere_models = std::move(auto_spheres);
-        }
-        else {
+        auto& sphere_models = sphere_lists[i];
+        if (!spheres_config.autogenerate) {
             for (auto& sphere_config : spheres_config.spheres) {
                 CollisionSphereModel sphere_model;
                 sphere_model.name = sphere_config.name;
@@ -562,13 +728,91 @@ bool RobotCollisionModel::initCollisionModel(
                 sphere_model.priority = sphere_config.priority;
                 sphere_models.push_back(std::move(sphere_model));
             }
+            continue;
+        }
+
+        auto lit = urdf.links_.find(spheres_config.link_name);
+        if (lit == end(urdf.links_)) {
+            continue;
+        }
+
+        auto urdf_link_index = (int)std::distance(begin(urdf.links_), lit);
+        spheres_urdf_links[i] = urdf_link_index;
+
+        auto key = HashValue(FNV_OFFSET_BASIS, 's');
+        key = HashValue(key, spheres_config.radius);
+        key = HashValue(key, spheres_config.max_overshoot);
+        key = linkGeometryHash(urdf_link_index, key);
+        spheres_keys[i] = key;
+
+        auto cit = cache.spheres.find(key);
+        if (cit == end(cache.spheres)) {
+            spheres_to_generate.push_back(i);
+            continue;
+        }
+
+        auto& geoms = m_link_geometries[urdf_link_index].geometries;
+        for (auto& cached : cit->second) {
+            CollisionSphereModel sphere_model;
+            sphere_model.center = Eigen::Vector3d(
+                    cached.center[0], cached.center[1], cached.center[2]);
+            sphere_model.radius = cached.radius;
+            sphere_model.priority = cached.priority;
+            if (cached.geom_index >= 0 &&
+                cached.geom_index < (std::int32_t)geoms.size())
+            {
+                sphere_model.geom = &geoms[cached.geom_index];
+            }
+            sphere_model.shape_index = cached.shape_index;
+            sphere_models.push_back(std::move(sphere_model));
+        }
+        next_cache.spheres[key] = cit->second;
+    }
+
+    std::vector<char> spheres_generated(spheres_count, 0);
+    pool.run(spheres_to_generate.size(), [&](int, size_t n) {
+        auto i = spheres_to_generate[n];
+        auto& spheres_config = config.spheres_models[i];
+        spheres_generated[i] = generateSphereModels(
+                spheres_urdf_links[i],
+                spheres_config.radius,
+                spheres_config.max_overshoot,
+                sphere_lists[i]);
+    });
+
+    for (auto i : spheres_to_generate) {
+        if (!spheres_generated[i]) {
+            sphere_lists[i].clear();
+            continue;
         }
 
+        auto* geoms = m_link_geometries[spheres_urdf_links[i]].geometries.data();
+        auto& cached_spheres = next_cache.spheres[spheres_keys[i]];
+        for (auto& sphere_model : sphere_lists[i]) {
+            GeneratedModelCache::Sphere cached;
+            cached.center[0] = sphere_model.center.x();
+            cached.center[1] = sphere_model.center.y();
+            cached.center[2] = sphere_model.center.z();
+            cached.radius = sphere_model.radius;
+            cached.priority = sphere_model.priority;
+            cached.geom_index = sphere_model.geom != NULL
+                    ? (std::int32_t)(sphere_model.geom - geoms)
+                    : -1;
+            cached.shape_index = sphere_model.shape_index;
+            cached_spheres.push_back(cached);
+        }
+        generated_any = true;
+    }
+
+    m_spheres_models.reserve(spheres_count);
+    for (size_t i = 0; i < spheres_count; ++i) {
+        auto& spheres_config = config.spheres_models[i];
+        auto& sphere_models = sphere_lists[i];
         if (!sphere_models.empty()) {
             m_spheres_models.push_back(CollisionSpheresModel());
             auto& spheres_model = m_spheres_models.back();
 
-            spheres_model.spheres.buildFrom(sphere_models);
+            spheres_model.spheres.buildFrom(sphere_models, spheres_config.balanced);
             spheres_model.link_index = linkIndex(spheres_config.link_name);
 
             for (auto& sphere : spheres_model.spheres.m_tree) {
@@ -579,14 +823,67 @@ bool RobotCollisionModel::initCollisionModel(
 
     // initialize voxels models
     m_voxels_models.resize(config.voxel_models.size());
+    std::vector<std::uint64_t> voxels_keys(m_voxels_models.size(), 0);
+    std::vector<char> voxels_keyed(m_voxels_models.size(), 0);
+    std::vector<size_t> voxels_to_generate;
     for (size_t i = 0; i < m_voxels_models.size(); ++i) {
         CollisionVoxelsModel& voxels_model = m_voxels_models[i];
         const std::string& link_name = config.voxel_models[i].link_name;
         voxels_model.link_index = linkIndex(link_name);
         voxels_model.voxel_res = config.voxel_models[i].res;
-        if (!voxelizeLink(urdf, link_name, voxels_model)) {
+
+        // links missing from the urdf are left for voxelizeLink to report
+        auto lit = urdf.links_.find(link_name);
+        if (lit == end(urdf.links_)) {
+            voxels_to_generate.push_back(i);
+            continue;
+        }
+
+        auto key = HashValue(FNV_OFFSET_BASIS, 'v');
+        key = HashValue(key, voxels_model.voxel_res);
+        key = linkGeometryHash((int)std::distance(begin(urdf.links_), lit), key);
+        voxels_keys[i] = key;
+        voxels_keyed[i] = 1;
+
+        auto cit = cache.voxels.find(key);
+        if (cit == end(cache.voxels)) {
+            voxels_to_generate.push_back(i);
+            continue;
+        }
+
+        voxels_model.voxels = cit->second;
+        next_cache.voxels[key] = cit->second;
+    }
+
+    std::vector<char> voxels_generated(m_voxels_models.size(), 0);
+    pool.run(voxels_to_generate.size(), [&](int, size_t n) {
+        auto i = voxels_to_generate[n];
+        const std::string& link_name = config.voxel_models[i].link_name;
+        voxels_generated[i] = voxelizeLink(urdf, link_name, m_voxels_models[i]);
+        if (!voxels_generated[i]) {
             ROS_ERROR_NAMED(LOG, "Failed to voxelize link '%s'", link_name.c_str());
         }
+    });
+
+    for (auto i : voxels_to_generate) {
+        if (voxels_generated[i] && voxels_keyed[i]) {
+            next_cache.voxels[voxels_keys[i]] = m_voxels_models[i].voxels;
+            generated_any = true;
+        }
+    }
+
+    if (!config.cache_path.empty() && generated_any) {
+        if (WriteGeneratedModelCache(config.cache_path, next_cache)) {
+            ROS_DEBUG_NAMED(LOG, "Wrote collision model cache '%s'", config.cache_path.c_str());
+        } else {
+            ROS_WARN_NAMED(LOG, "Failed to write collision model cache '%s'", config.cache_path.c_str());
+        }
+    }
+
+    for (auto& voxels_model : m_voxels_models) {
+        if (!voxels_model.voxels.empty() && !voxels_model.buildBitset()) {
+            ROS_DEBUG_NAMED(LOG, "Voxels of link '%s' do not lie on a common lattice", m_link_names[voxels_model.link_index].c_str());
+        }
     }
 
     // initialize groups
@@ -636,20 +933,52 @@ bool RobotCollisionModel::initCollisionModel(
     return true;
 }
 
-bool RobotCollisionModel::initCollisionShapes(const ::urdf::ModelInterface& urdf)
+bool RobotCollisionModel::initCollisionShapes(
+    const ::urdf::ModelInterface& urdf,
+    WorkerPool& pool)
 {
-    // create all collision shapes
+    std::vector<const ::urdf::Collision*> collisions;
     for (auto& link_with_name : urdf.links_) {
         auto& link = link_with_name.second;
         if (!link->collision_array.empty()) {
             for (auto& collision : link->collision_array) {
-                createCollisionShape(*collision);
+                collisions.push_back(collision.get());
             }
         } else if (link->collision) {
-            createCollisionShape(*link->collision);
+            collisions.push_back(link->collision.get());
+        }
+    }
+
+    // load all mesh resources up front, in parallel, into buffers that are
+    // referenced by the mesh shapes in order of creation
+    std::vector<const ::urdf::Mesh*> meshes;
+    for (auto* collision : collisions) {
+        if (collision->geometry->type == ::urdf::Geometry::MESH) {
+            meshes.push_back(static_cast<const ::urdf::Mesh*>(
+                    collision->geometry.get()));
         }
     }
 
+    m_vertex_buffers.resize(meshes.size());
+    m_index_buffers.resize(meshes.size());
+    pool.run(meshes.size(), [&](int, size_t i) {
+        if (!leatherman::getMeshComponentsFromResource(
+                meshes[i]->filename,
+                Eigen::Vector3d::Ones(),
+                m_vertex_buffers[i],
+                m_index_buffers[i]))
+        {
+            ROS_ERROR_NAMED(LOG, "Failed to load mesh from '%s'", meshes[i]->filename.c_str());
+            m_vertex_buffers[i].clear();
+            m_index_buffers[i].clear();
+        }
+    });
+
+    // create all collision shapes
+    for (auto* collision : collisions) {
+        createCollisionShape(*collision);
+    }
+
     // collision shape arrays are now stable...map links to collision shapes
 
     size_t box_index = 0;
@@ -755,16 +1084,9 @@ bool RobotCollisionModel::createCollisionShape(const ::urdf::Collision& collisio
     {
         auto& mesh = static_cast<::urdf::Mesh&>(*collision.geometry);
 
-        std::vector<double> vertex_data;
-        std::vector<std::uint32_t> index_data;
-        if (!leatherman::getMeshComponentsFromResource(
-            mesh.filename,
-            Eigen::Vector3d::Ones(),
-            vertex_data,
-            index_data))
-        {
-            return false;
-        }
+        // mesh data is loaded in initCollisionShapes
+        auto& vertex_data = m_vertex_buffers[m_mesh_shapes.size()];
+        auto& index_data = m_index_buffers[m_mesh_shapes.size()];
 
         MeshShape mesh_shape;
         mesh_shape.triangles = index_data.data();
@@ -774,10 +1096,6 @@ bool RobotCollisionModel::createCollisionShape(const ::urdf::Collision& collisio
         ROS_DEBUG_NAMED(LOG, "Loaded mesh from '%s' with %zu vertices and %zu triangles", mesh.filename.c_str(), mesh_shape.vertex_count, mesh_shape.triangle_count);
 
         m_mesh_shapes.push_back(std::move(mesh_shape));
-
-        m_vertex_buffers.push_back(std::move(vertex_data));
-        m_index_buffers.push_back(std::move(index_data));
-
         break;
     }
     case ::urdf::Geometry::SPHERE:
@@ -935,16 +1253,26 @@ bool RobotCollisionModel::expandGroups(
     return true;
 }
 
+/// Generate the sphere models for all geometries of a link. With a positive
+/// max_overshoot, a minimal set of covering spheres is generated instead of
+/// spheres of uniform radius.
 bool RobotCollisionModel::generateSphereModels(
     int urdf_link_index,
     double radius,
+    double max_overshoot,
     std::vector<CollisionSphereModel>& spheres) const
 {
     auto& geoms = m_link_geometries[urdf_link_index];
     for (size_t gidx = 0; gidx < geoms.geometries.size(); ++gidx) {
         auto& geom = geoms.geometries[gidx];
-        if (!generateBoundingSpheres(&geom, radius, spheres)) {
-            return false;
+        if (max_overshoot > 0.0) {
+            if (!generateCoveringSpheres(&geom, max_overshoot, spheres)) {
+                return false;
+            }
+        } else {
+            if (!generateBoundingSpheres(&geom, radius, spheres)) {
+                return false;
+            }
         }
     }
 
@@ -1028,6 +1356,142 @@ bool RobotCollisionModel::generateBoundingSpheres(
     return true;
 }
 
+/// Append a minimal set of spheres, of varying radius, covering the surface of
+/// a geometry and overshooting it by at most max_overshoot.
+///
+/// Each covering sphere may span many triangles of a mesh, so these spheres
+/// are not associated with the geometry for narrow-phase checks.
+bool RobotCollisionModel::generateCoveringSpheres(
+    const CollisionGeometry* geom,
+    double max_overshoot,
+    std::vector<CollisionSphereModel>& spheres) const
+{
+    std::vector<Eigen::Vector3d> centers;
+    std::vector<double> radii;
+    switch (geom->shape->type) {
+    case ShapeType::Mesh:
+    {
+        auto* mesh = static_cast<const MeshShape*>(geom->shape);
+        ROS_DEBUG_NAMED(LOG, "  mesh: { triangles: %zu  vertices: %zu }", mesh->triangle_count, mesh->vertex_count);
+        geometry::ComputeMeshCoveringSpheres(
+                mesh->vertices,
+                mesh->vertex_count,
+                mesh->triangles,
+                mesh->triangle_count,
+                max_overshoot,
+                centers,
+                radii);
+        break;
+    }
+    case ShapeType::Box:
+    {
+        auto* box = static_cast<const BoxShape*>(geom->shape);
+        ROS_DEBUG_NAMED(LOG, "box: { dims: %f, %f, %f }", box->size[0], box->size[1], box->size[2]);
+        geometry::ComputeBoxCoveringSpheres(
+                box->size[0],
+                box->size[1],
+                box->size[2],
+                max_overshoot,
+                centers,
+                radii);
+        break;
+    }
+    case ShapeType::Cylinder:
+    {
+        auto* cyl = static_cast<const CylinderShape*>(geom->shape);
+        ROS_DEBUG_NAMED(LOG, "cylinder: { radius: %f, height: %f }", cyl->radius, cyl->height);
+        geometry::ComputeCylinderCoveringSpheres(
+                cyl->radius,
+                cyl->height,
+                max_overshoot,
+                centers,
+                radii);
+        break;
+    }
+    case ShapeType::Cone:
+    {
+        auto* cone = static_cast<const ConeShape*>(geom->shape);
+        ROS_DEBUG_NAMED(LOG, "cone: { radius: %f, height: %f }", cone->radius, cone->height);
+        geometry::ComputeConeCoveringSpheres(
+                cone->radius,
+                cone->height,
+                max_overshoot,
+                centers,
+                radii);
+        break;
+    }
+    case ShapeType::Sphere:
+    {
+        // a sphere is its own minimal covering
+        auto* sph = static_cast<const SphereShape*>(geom->shape);
+        ROS_DEBUG_NAMED(LOG, "sphere: { radius: %0.3f }", sph->radius);
+        centers.push_back(Eigen::Vector3d::Zero());
+        radii.push_back(sph->radius);
+        break;
+    }
+    default:
+        ROS_ERROR_NAMED(LOG, "Unsupported geometry type for covering sphere generation");
+        return false;
+    }
+
+    spheres.reserve(spheres.size() + centers.size());
+    for (size_t sidx = 0; sidx < centers.size(); ++sidx) {
+        CollisionSphereModel sphere;
+        sphere.center = geom->offset * centers[sidx];
+        sphere.radius = radii[sidx];
+        sphere.priority = 1;
+        spheres.push_back(std::move(sphere));
+    }
+    ROS_DEBUG_NAMED(LOG, "Autogenerated %zu covering spheres for geometry", centers.size());
+
+    return true;
+}
+
+/// Combine a hash of all geometry of a link, including its mesh data, into a
+/// seed hash. Used to key cached spheres and voxels generated for the link.
+auto RobotCollisionModel::linkGeometryHash(
+    int urdf_link_index,
+    std::uint64_t seed) const
+    -> std::uint64_t
+{
+    auto h = seed;
+    for (auto& geom : m_link_geometries[urdf_link_index].geometries) {
+        h = HashBytes(h, geom.offset.matrix().data(), 16 * sizeof(double));
+        h = HashValue(h, geom.shape->type);
+        switch (geom.shape->type) {
+        case ShapeType::Sphere:
+            h = HashValue(h, static_cast<const SphereShape*>(geom.shape)->radius);
+            break;
+        case ShapeType::Cylinder: {
+            auto* cyl = static_cast<const CylinderShape*>(geom.shape);
+            h = HashValue(h, cyl->radius);
+            h = HashValue(h, cyl->height);
+            break;
+        }
+        case ShapeType::Cone: {
+            auto* cone = static_cast<const ConeShape*>(geom.shape);
+            h = HashValue(h, cone->radius);
+            h = HashValue(h, cone->height);
+            break;
+        }
+        case ShapeType::Box:
+            h = HashValue(h, static_cast<const BoxShape*>(geom.shape)->size);
+            break;
+        case ShapeType::Mesh: {
+            auto* mesh = static_cast<const MeshShape*>(geom.shape);
+            h = HashValue(h, mesh->vertex_count);
+            h = HashBytes(h, mesh->vertices, 3 * mesh->vertex_count * sizeof(double));
+            h = HashValue(h, mesh->triangle_count);
+            h = HashBytes(h, mesh->triangles, 3 * mesh->triangle_count * sizeof(std::uint32_t));
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    return h;
+}
+
 bool RobotCollisionModel::checkCollisionModelConfig(
     const CollisionModelConfig& config)
 {
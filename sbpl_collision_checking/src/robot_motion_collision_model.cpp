@@ -264,6 +264,8 @@ RobotMotionCollisionModel::RobotMotionCollisionModel(
     m_mr_centers = std::move(mr_centers);
     m_mr_radii = std::move(mr_radii);
 
+    initVarMotionBounds();
+
     for (size_t jidx = 0; jidx < rcm->jointCount(); ++jidx) {
         const Eigen::Vector3d &mr_center = m_mr_centers[jidx];
         const double mr_radius = m_mr_radii[jidx];
@@ -274,6 +276,40 @@ RobotMotionCollisionModel::RobotMotionCollisionModel(
     }
 }
 
+void RobotMotionCollisionModel::initVarMotionBounds()
+{
+    m_var_bounds.assign(
+            m_rcm->jointVarCount(), VarMotionBound{ VarMotion::None, 0.0 });
+    for (size_t jidx = 0; jidx < m_rcm->jointCount(); ++jidx) {
+        // fixed joints own no variables
+        if (m_rcm->jointType(jidx) == JointType::FIXED) {
+            continue;
+        }
+
+        auto& bound = m_var_bounds[m_rcm->jointVarIndexFirst(jidx)];
+        bound.lever = m_mr_centers[jidx].norm() + m_mr_radii[jidx];
+        switch (m_rcm->jointType(jidx)) {
+        case JointType::FIXED:
+            break;
+        case JointType::CONTINUOUS:
+            bound.type = VarMotion::ContinuousAngular;
+            break;
+        case JointType::REVOLUTE:
+            bound.type = VarMotion::Angular;
+            break;
+        case JointType::PRISMATIC:
+            bound.type = VarMotion::Linear;
+            break;
+        case JointType::PLANAR:
+            bound.type = VarMotion::Planar;
+            break;
+        case JointType::FLOATING:
+            bound.type = VarMotion::Floating;
+            break;
+        }
+    }
+}
+
 double RobotMotionCollisionModel::getMaxSphereMotion(
     const RobotState& start,
     const RobotState& finish) const
@@ -282,39 +318,33 @@ double RobotMotionCollisionModel::getMaxSphereMotion(
     assert(finish.size() == m_rcm->jointVarCount());
 
     double motion = 0.0;
-    for (size_t jidx; jidx < m_rcm->jointCount(); ++jidx) {
-        size_t fvidx = m_rcm->jointVarIndexFirst(jidx);
-
-        double dist = 0.0;
-        switch (m_rcm->jointType(jidx)) {
-        case JointType::FIXED:
+    for (size_t vidx = 0; vidx < m_var_bounds.size(); ++vidx) {
+        const VarMotionBound& bound = m_var_bounds[vidx];
+        switch (bound.type) {
+        case VarMotion::None:
             break;
-        case JointType::CONTINUOUS:
-            dist = angles::shortest_angle_dist(finish[fvidx], start[fvidx]);
-            motion += (m_mr_centers[jidx].norm() + m_mr_radii[jidx]) * dist;
+        case VarMotion::ContinuousAngular:
+            motion += bound.lever *
+                    angles::shortest_angle_dist(finish[vidx], start[vidx]);
             break;
-        case JointType::REVOLUTE:
-            dist = std::fabs(finish[fvidx] - start[fvidx]);
-            motion += (m_mr_centers[jidx].norm() + m_mr_radii[jidx]) * dist;
+        case VarMotion::Angular:
+            motion += bound.lever * std::fabs(finish[vidx] - start[vidx]);
             break;
-        case JointType::PRISMATIC:
-            dist = std::fabs(finish[fvidx] - start[fvidx]);
-            motion += dist;
+        case VarMotion::Linear:
+            motion += std::fabs(finish[vidx] - start[vidx]);
             break;
-        case JointType::PLANAR: {
-            const double dx = finish[fvidx + 0] - start[fvidx + 0];
-            const double dy = finish[fvidx + 1] - start[fvidx + 1];
+        case VarMotion::Planar: {
+            const double dx = finish[vidx + 0] - start[vidx + 0];
+            const double dy = finish[vidx + 1] - start[vidx + 1];
             const double dth = angles::shortest_angle_dist(
-                    finish[fvidx + 2], start[fvidx + 2]);
-            dist = std::sqrt(dx * dx + dy * dy);
-            motion += dist + dth * (m_mr_centers[jidx].norm() + m_mr_radii[jidx]);
+                    finish[vidx + 2], start[vidx + 2]);
+            motion += std::sqrt(dx * dx + dy * dy) + dth * bound.lever;
         }   break;
-        case JointType::FLOATING: {
-            const double dx = finish[fvidx + 0] - start[fvidx + 0];
-            const double dy = finish[fvidx + 1] - start[fvidx + 1];
-            const double dz = finish[fvidx + 2] - start[fvidx + 2];
-            dist = std::sqrt(dx * dx + dy * dy + dz * dz);
-            motion += dist;
+        case VarMotion::Floating: {
+            const double dx = finish[vidx + 0] - start[vidx + 0];
+            const double dy = finish[vidx + 1] - start[vidx + 1];
+            const double dz = finish[vidx + 2] - start[vidx + 2];
+            motion += std::sqrt(dx * dx + dy * dy + dz * dz);
         }   break;
         }
     }
@@ -328,36 +358,30 @@ double RobotMotionCollisionModel::getMaxSphereMotion(
     assert(diff.size() == m_rcm->jointVarCount());
 
     double motion = 0.0;
-    for (size_t jidx = 0; jidx < m_rcm->jointVarCount(); ++jidx) {
-        const int fvidx = m_rcm->jointVarIndexFirst(jidx);
-
-        double dist = 0.0;
-        switch (m_rcm->jointType(jidx)) {
-        case JointType::FIXED:
+    for (size_t vidx = 0; vidx < m_var_bounds.size(); ++vidx) {
+        const VarMotionBound& bound = m_var_bounds[vidx];
+        switch (bound.type) {
+        case VarMotion::None:
             break;
-        case JointType::CONTINUOUS:
-        case JointType::REVOLUTE:
-            dist = std::fabs(diff[fvidx]);
-            motion += (m_mr_centers[jidx].norm() + m_mr_radii[jidx]) * dist;
+        case VarMotion::ContinuousAngular:
+        case VarMotion::Angular:
+            motion += bound.lever * std::fabs(diff[vidx]);
             break;
-        case JointType::PRISMATIC:
-            dist = std::fabs(diff[fvidx]);
-            motion += dist;
+        case VarMotion::Linear:
+            motion += std::fabs(diff[vidx]);
             break;
-        case JointType::PLANAR: {
-            const double dx = diff[fvidx + 0];
-            const double dy = diff[fvidx + 1];
-            const double dth = diff[fvidx + 2];
-            dist = std::sqrt(dx * dx + dy * dy);
+        case VarMotion::Planar: {
+            const double dx = diff[vidx + 0];
+            const double dy = diff[vidx + 1];
+            const double dth = std::fabs(diff[vidx + 2]);
             // TODO: see above
-            motion += dist + dth * (m_mr_centers[jidx].norm() + m_mr_radii[jidx]);
+            motion += std::sqrt(dx * dx + dy * dy) + dth * bound.lever;
         }   break;
-        case JointType::FLOATING: {
-            const double dx = diff[fvidx + 0];
-            const double dy = diff[fvidx + 1];
-            const double dz = diff[fvidx + 2];
-            dist = std::sqrt(dx * dx + dy * dy + dz * dz);
-            motion += dist;
+        case VarMotion::Floating: {
+            const double dx = diff[vidx + 0];
+            const double dy = diff[vidx + 1];
+            const double dz = diff[vidx + 2];
+            motion += std::sqrt(dx * dx + dy * dy + dz * dz);
         }   break;
         }
     }
@@ -376,40 +400,30 @@ double RobotMotionCollisionModel::getMaxSphereMotion(
     assert(start.size() == variables.size());
 
     double motion = 0.0;
-    for (auto i = 0; i < start.size(); ++i) {
-        auto vidx = variables[i];
-        auto jidx = m_rcm->jointVarJointIndex(vidx);
-
-        auto dist = 0.0;
-        switch (m_rcm->jointType(jidx)) {
-        case JointType::FIXED:
+    for (size_t i = 0; i < start.size(); ++i) {
+        const VarMotionBound& bound = m_var_bounds[variables[i]];
+        switch (bound.type) {
+        case VarMotion::None:
             break;
-        case JointType::CONTINUOUS:
-            dist = angles::shortest_angle_dist(finish[i], start[i]);
-            motion += (m_mr_centers[jidx].norm() + m_mr_radii[jidx]) * dist;
+        case VarMotion::ContinuousAngular:
+            motion += bound.lever *
+                    angles::shortest_angle_dist(finish[i], start[i]);
             break;
-        case JointType::REVOLUTE:
-            dist = std::fabs(finish[i] - start[i]);
-            motion += (m_mr_centers[jidx].norm() + m_mr_radii[jidx]) * dist;
+        case VarMotion::Angular:
+            motion += bound.lever * std::fabs(finish[i] - start[i]);
             break;
-        case JointType::PRISMATIC:
-            dist = std::fabs(finish[i] - start[i]);
-            motion += dist;
-            break;
-        case JointType::PLANAR:
-        {
-            auto fvidx = m_rcm->jointVarIndexFirst(jidx);
-            if (vidx == fvidx) {
-                // assume the three variables are stored contiguously
-                auto dx = finish[i] - start[i];
-                auto dy = finish[i + 1] - start[i + 1];
-                auto dth = finish[i + 2] - start[i + 2];
-                auto dist = std::sqrt(dx * dx + dy * dy);
-                motion += dist + dth * (m_mr_centers[jidx].norm() + m_mr_radii[jidx]);
-            }
+        case VarMotion::Linear:
+            motion += std::fabs(finish[i] - start[i]);
             break;
-        }
-        case JointType::FLOATING:
+        case VarMotion::Planar: {
+            // assume the three variables are stored contiguously
+            const double dx = finish[i] - start[i];
+            const double dy = finish[i + 1] - start[i + 1];
+            const double dth = angles::shortest_angle_dist(
+                    finish[i + 2], start[i + 2]);
+            motion += std::sqrt(dx * dx + dy * dy) + dth * bound.lever;
+        }   break;
+        case VarMotion::Floating:
             break;
         }
     }
@@ -425,24 +439,18 @@ double RobotMotionCollisionModel::getMaxSphereMotion(
 
     double motion = 0.0;
     for (size_t i = 0; i < diff.size(); ++i) {
-        const int vidx = variables[i];
-        const int jidx = m_rcm->jointVarJointIndex(vidx);
-
-        double dist = 0.0;
-        switch (m_rcm->jointType(jidx)) {
-        case JointType::FIXED:
+        const VarMotionBound& bound = m_var_bounds[variables[i]];
+        switch (bound.type) {
+        case VarMotion::ContinuousAngular:
+        case VarMotion::Angular:
+            motion += bound.lever * std::fabs(diff[i]);
             break;
-        case JointType::CONTINUOUS:
-        case JointType::REVOLUTE:
-            dist = std::fabs(diff[i]);
-            motion += (m_mr_centers[jidx].norm() + m_mr_radii[jidx]) * dist;
-            break;
-        case JointType::PRISMATIC:
-            dist = std::fabs(diff[i]);
-            motion += dist;
+        case VarMotion::Linear:
+            motion += std::fabs(diff[i]);
             break;
-        case JointType::PLANAR:
-        case JointType::FLOATING:
+        case VarMotion::None:
+        case VarMotion::Planar:
+        case VarMotion::Floating:
             break;
         }
     }
@@ -31,7 +31,14 @@
 
 #include <sbpl_collision_checking/self_collision_model.h>
 
+// standard includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
 // system includes
+#include <Eigen/Eigenvalues>
 #include <leatherman/print.h>
 #include <smpl/geometry/triangle.h>
 #include <smpl/geometry/intersect.h>
@@ -44,6 +51,247 @@ namespace collision {
 
 static const char* SCM_LOGGER = "self";
 
+// every STAGE_SAMPLE_PERIOD'th call to checkCollision times its stages; the
+// stage order is recomputed, and the rejection counts decayed, every
+// STAGE_UPDATE_PERIOD calls
+static const unsigned int STAGE_SAMPLE_PERIOD = 16;
+static const unsigned int STAGE_UPDATE_PERIOD = 256;
+static const double STAGE_REJECTION_DECAY = 0.5;
+static const double STAGE_COST_RATE = 0.1;
+static const double STAGE_COST_INIT = 1.0e-6;
+
+/// Compute a capsule, the segment p + s * u, s in [0, 1], inflated by r, that
+/// bounds the leaf spheres of a sphere tree. The segment runs along the
+/// principal axis of the leaf sphere centers.
+static void ComputeBoundingCapsule(
+    const CollisionSphereModelTree& spheres,
+    Eigen::Vector3d& p,
+    Eigen::Vector3d& u,
+    double& r)
+{
+    Eigen::Vector3d mean(Eigen::Vector3d::Zero());
+    int leaf_count = 0;
+    for (const CollisionSphereModel& sphere : spheres) {
+        if (sphere.isLeaf()) {
+            mean += sphere.center;
+            ++leaf_count;
+        }
+    }
+
+    if (leaf_count == 0) {
+        p = spheres.root()->center;
+        u = Eigen::Vector3d::Zero();
+        r = spheres.root()->radius;
+        return;
+    }
+
+    mean /= leaf_count;
+
+    Eigen::Matrix3d cov(Eigen::Matrix3d::Zero());
+    for (const CollisionSphereModel& sphere : spheres) {
+        if (sphere.isLeaf()) {
+            const Eigen::Vector3d d = sphere.center - mean;
+            cov += d * d.transpose();
+        }
+    }
+
+    // eigenvalues are sorted in increasing order
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(cov);
+    const Eigen::Vector3d axis = solver.eigenvectors().col(2).normalized();
+
+    double tmin = std::numeric_limits<double>::infinity();
+    double tmax = -std::numeric_limits<double>::infinity();
+    for (const CollisionSphereModel& sphere : spheres) {
+        if (sphere.isLeaf()) {
+            const double t = axis.dot(sphere.center - mean);
+            tmin = std::min(tmin, t);
+            tmax = std::max(tmax, t);
+        }
+    }
+
+    // every leaf center projects onto the segment, so the distance to the
+    // segment is the distance to the axis
+    r = 0.0;
+    for (const CollisionSphereModel& sphere : spheres) {
+        if (sphere.isLeaf()) {
+            const Eigen::Vector3d d = sphere.center - mean;
+            const double perp = (d - axis.dot(d) * axis).norm();
+            r = std::max(r, perp + sphere.radius);
+        }
+    }
+
+    p = mean + tmin * axis;
+    u = (tmax - tmin) * axis;
+}
+
+/// Return the squared distance between the segments p1 + s * u1 and
+/// p2 + t * u2, s, t in [0, 1].
+static inline double SegmentSegmentDistanceSqrd(
+    double p1x, double p1y, double p1z,
+    double u1x, double u1y, double u1z,
+    double p2x, double p2y, double p2z,
+    double u2x, double u2y, double u2z)
+{
+    auto clamp01 = [](double v) { return std::min(1.0, std::max(0.0, v)); };
+    const double eps = 1e-12;
+
+    const double rx = p1x - p2x;
+    const double ry = p1y - p2y;
+    const double rz = p1z - p2z;
+    const double a = u1x * u1x + u1y * u1y + u1z * u1z;
+    const double e = u2x * u2x + u2y * u2y + u2z * u2z;
+    const double f = u2x * rx + u2y * ry + u2z * rz;
+
+    double s, t;
+    if (a <= eps && e <= eps) {
+        s = t = 0.0;
+    } else if (a <= eps) {
+        s = 0.0;
+        t = clamp01(f / e);
+    } else {
+        const double c = u1x * rx + u1y * ry + u1z * rz;
+        if (e <= eps) {
+            t = 0.0;
+            s = clamp01(-c / a);
+        } else {
+            const double b = u1x * u2x + u1y * u2y + u1z * u2z;
+            const double denom = a * e - b * b;
+            s = denom > eps ? clamp01((b * f - c * e) / denom) : 0.0;
+            t = (b * s + f) / e;
+            if (t < 0.0) {
+                t = 0.0;
+                s = clamp01(-c / a);
+            } else if (t > 1.0) {
+                t = 1.0;
+                s = clamp01((b - c) / a);
+            }
+        }
+    }
+
+    const double dx = rx + s * u1x - t * u2x;
+    const double dy = ry + s * u1y - t * u2y;
+    const double dz = rz + s * u1z - t * u2z;
+    return dx * dx + dy * dy + dz * dz;
+}
+
+/// Compute the grid cells containing a set of points.
+static void ComputeGridCells(
+    const OccupancyGrid& grid,
+    const std::vector<Eigen::Vector3d>& points,
+    CollisionVoxelsBitset& cells)
+{
+    if (points.empty()) {
+        cells.clear();
+        return;
+    }
+
+    std::vector<Eigen::Vector3i> indices(points.size());
+    Eigen::Vector3i imin = Eigen::Vector3i::Constant(std::numeric_limits<int>::max());
+    Eigen::Vector3i imax = Eigen::Vector3i::Constant(std::numeric_limits<int>::min());
+    for (size_t i = 0; i < points.size(); ++i) {
+        auto& p = points[i];
+        auto& c = indices[i];
+        grid.worldToGrid(p.x(), p.y(), p.z(), c.x(), c.y(), c.z());
+        imin = imin.cwiseMin(c);
+        imax = imax.cwiseMax(c);
+    }
+
+    const Eigen::Vector3i size = imax - imin + Eigen::Vector3i::Ones();
+    cells.reset(imin, size.x(), size.y(), size.z());
+    for (auto& c : indices) {
+        cells.set(c.x(), c.y(), c.z());
+    }
+}
+
+/// Compute the grid cells of a voxels model at a pose without transforming
+/// its voxels. This is possible when the pose maps the model's lattice onto
+/// the grid's cells: the resolutions match and the rotation permutes the axes,
+/// possibly reversing some. Without rotation, the cells are the model's bitset
+/// itself, moved to a new origin.
+///
+/// \return false if the pose does not map the lattice onto the grid's cells
+static bool TransformGridCells(
+    const OccupancyGrid& grid,
+    const CollisionVoxelsModel& model,
+    const Eigen::Affine3d& pose,
+    CollisionVoxelsBitset& cells)
+{
+    const CollisionVoxelsBitset& bits = model.bitset;
+    if (bits.empty()) {
+        return false;
+    }
+
+    const double res = grid.resolution();
+    if (std::fabs(model.voxel_res - res) > 1e-6 * res) {
+        return false;
+    }
+
+    const double tol = 1e-9;
+    Eigen::Matrix3i perm;
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            const double r = std::round(pose.linear()(i, j));
+            if (std::fabs(pose.linear()(i, j) - r) > tol) {
+                return false;
+            }
+            perm(i, j) = (int)r;
+        }
+    }
+
+    // all voxels share the offset of the first lattice cell from its grid
+    // cell's boundaries
+    const Eigen::Vector3d p0 = pose *
+            (model.lattice_offset + model.voxel_res * bits.origin.cast<double>());
+    Eigen::Vector3i c0;
+    grid.worldToGrid(p0.x(), p0.y(), p0.z(), c0.x(), c0.y(), c0.z());
+
+    if (perm == Eigen::Matrix3i::Identity()) {
+        cells = bits;
+        cells.origin = c0;
+        return true;
+    }
+
+    const Eigen::Vector3i extent =
+            perm * Eigen::Vector3i(bits.size_x - 1, bits.size_y - 1, bits.size_z - 1);
+    const Eigen::Vector3i size = extent.cwiseAbs() + Eigen::Vector3i::Ones();
+    cells.reset(
+            c0 + extent.cwiseMin(Eigen::Vector3i::Zero()),
+            size.x(), size.y(), size.z());
+    bits.forEach([&](int x, int y, int z) {
+        const Eigen::Vector3i c = c0 + perm * (Eigen::Vector3i(x, y, z) - bits.origin);
+        cells.set(c.x(), c.y(), c.z());
+    });
+    return true;
+}
+
+/// Append the centers of the cells set in a but not in b, comparing 64 cells
+/// of a row at a time.
+static void AppendCellDifference(
+    const OccupancyGrid& grid,
+    const CollisionVoxelsBitset& a,
+    const CollisionVoxelsBitset& b,
+    std::vector<Eigen::Vector3d>& centers)
+{
+    for (int z = 0; z < a.size_z; ++z) {
+    for (int y = 0; y < a.size_y; ++y) {
+        const int gy = a.origin.y() + y;
+        const int gz = a.origin.z() + z;
+        const std::uint64_t* row = &a.bits[(z * a.size_y + y) * a.row_words];
+        for (int w = 0; w < a.row_words; ++w) {
+            const int gx = a.origin.x() + 64 * w;
+            std::uint64_t diff = row[w] & ~b.word(gx, gy, gz);
+            while (diff) {
+                const int bit = __builtin_ctzll(diff);
+                diff &= diff - 1;
+                Eigen::Vector3d p;
+                grid.gridToWorld(gx + bit, gy, gz, p.x(), p.y(), p.z());
+                centers.push_back(p);
+            }
+        }
+    }
+    }
+}
+
 SelfCollisionModel::SelfCollisionModel(
     OccupancyGrid* grid,
     const RobotCollisionModel* rcm,
@@ -57,11 +305,19 @@ SelfCollisionModel::SelfCollisionModel(
     m_gidx(-1),
     m_voxels_indices(),
     m_ab_voxels_indices(),
+    m_voxels_cells(rcm->voxelsModelCount()),
+    m_moved_voxels_cells(),
     m_checked_spheres_states(),
     m_checked_attached_body_spheres_states(),
     m_checked_attached_body_robot_spheres_states(),
     m_acm(),
     m_padding(0.0),
+    m_acm_stride(0),
+    m_acm_bits(),
+    m_acm_slot_bodies(),
+    m_acm_body_slots(),
+    m_acm_ab_version(-1),
+    m_capsule_broad_phase(false),
 #if SCDL_USE_META_TREE
     m_model_state_map(),
     m_root_models(),
@@ -70,8 +326,16 @@ SelfCollisionModel::SelfCollisionModel(
     m_meta_state(),
 #endif
     m_q(),
-    m_vq()
+    m_vq(),
+    m_check_count(0),
+    m_last_world_hit(nullptr),
+    m_last_self_pair(-1)
 {
+    for (int i = 0; i < CheckStageCount; ++i) {
+        m_stage_order[i] = i;
+        m_stage_rejections[i] = 0.0;
+        m_stage_cost[i] = STAGE_COST_INIT;
+    }
     initAllowedCollisionMatrix();
 }
 
@@ -106,10 +370,204 @@ void SelfCollisionModel::initAllowedCollisionMatrix()
             m_acm.setEntry(link_name, child_link_name, true);
         }
     }
+    compileAllowedCollisionMatrix();
     // NOTE: no need to update checked sphere indices here, they will be updated
     // when the first request with a valid group index is received
 }
 
+static bool AllowedAlways(
+    const AllowedCollisionMatrix& acm,
+    const std::string& name1,
+    const std::string& name2)
+{
+    collision_detection::AllowedCollision::Type type;
+    return acm.getEntry(name1, name2, type) &&
+            type == collision_detection::AllowedCollision::ALWAYS;
+}
+
+int SelfCollisionModel::acmSlotCount() const
+{
+    return (int)m_rcm->linkCount() + (int)m_acm_slot_bodies.size();
+}
+
+/// Return the acm slot of an attached body, or -1 if the body has not been
+/// assigned one.
+int SelfCollisionModel::acmBodySlot(int abidx) const
+{
+    auto it = m_acm_body_slots.find(abidx);
+    if (it == m_acm_body_slots.end()) {
+        return -1;
+    }
+    return it->second;
+}
+
+/// Return the acm slot of a link or attached body, or -1 if no link or attached
+/// body has the name.
+int SelfCollisionModel::acmSlot(const std::string& name) const
+{
+    if (m_rcm->hasLink(name)) {
+        return m_rcm->linkIndex(name);
+    }
+    if (m_abcm->hasAttachedBody(name)) {
+        return acmBodySlot(m_abcm->attachedBodyIndex(name));
+    }
+    return -1;
+}
+
+/// Return the name of the link or attached body occupying an acm slot. The slot
+/// must not be a released attached body slot.
+auto SelfCollisionModel::acmSlotName(int slot) const -> const std::string&
+{
+    const int link_count = (int)m_rcm->linkCount();
+    if (slot < link_count) {
+        return m_rcm->linkName(slot);
+    }
+    return m_abcm->attachedBodyName(m_acm_slot_bodies[slot - link_count]);
+}
+
+/// Return whether a pair of acm slots is always allowed to collide. Slots of -1
+/// are never allowed to collide.
+bool SelfCollisionModel::acmAllowed(int slot1, int slot2) const
+{
+    if (slot1 < 0 || slot2 < 0) {
+        return false;
+    }
+    const std::uint64_t word =
+            m_acm_bits[(size_t)slot1 * m_acm_stride + (slot2 >> 6)];
+    return (word >> (slot2 & 63)) & 1;
+}
+
+void SelfCollisionModel::setAcmAllowed(int slot1, int slot2, bool allowed)
+{
+    std::uint64_t& w12 = m_acm_bits[(size_t)slot1 * m_acm_stride + (slot2 >> 6)];
+    std::uint64_t& w21 = m_acm_bits[(size_t)slot2 * m_acm_stride + (slot1 >> 6)];
+    const std::uint64_t b12 = std::uint64_t(1) << (slot2 & 63);
+    const std::uint64_t b21 = std::uint64_t(1) << (slot1 & 63);
+    if (allowed) {
+        w12 |= b12;
+        w21 |= b21;
+    } else {
+        w12 &= ~b12;
+        w21 &= ~b21;
+    }
+}
+
+/// Compile the allowed collision matrix over the robot links and the currently
+/// attached bodies, assigning attached bodies new slots.
+void SelfCollisionModel::compileAllowedCollisionMatrix()
+{
+    const int link_count = (int)m_rcm->linkCount();
+
+    std::vector<int> bodies;
+    m_abcm->attachedBodyIndices(bodies);
+    m_acm_slot_bodies = bodies;
+    m_acm_body_slots.clear();
+    for (size_t i = 0; i < bodies.size(); ++i) {
+        m_acm_body_slots[bodies[i]] = link_count + (int)i;
+    }
+    m_acm_ab_version = m_abcm->version();
+
+    const int slot_count = acmSlotCount();
+    m_acm_stride = (slot_count + 63) / 64;
+    m_acm_bits.assign((size_t)slot_count * m_acm_stride, 0);
+    for (int s1 = 0; s1 < slot_count; ++s1) {
+        const std::string& name1 = acmSlotName(s1);
+        for (int s2 = s1 + 1; s2 < slot_count; ++s2) {
+            if (AllowedAlways(m_acm, name1, acmSlotName(s2))) {
+                setAcmAllowed(s1, s2, true);
+            }
+        }
+    }
+}
+
+/// Compile the row and column of an attached body slot against all other
+/// occupied slots.
+void SelfCollisionModel::compileAcmSlot(int slot)
+{
+    const int link_count = (int)m_rcm->linkCount();
+    const int slot_count = acmSlotCount();
+    const std::string& name = acmSlotName(slot);
+    for (int s = 0; s < slot_count; ++s) {
+        if (s == slot ||
+            (s >= link_count && m_acm_slot_bodies[s - link_count] == -1))
+        {
+            continue;
+        }
+        setAcmAllowed(slot, s, AllowedAlways(m_acm, name, acmSlotName(s)));
+    }
+}
+
+/// Widen the compiled matrix from old_count to new_count slots, preserving the
+/// bits of existing slots.
+void SelfCollisionModel::growAcmSlots(int old_count, int new_count)
+{
+    const int stride = (new_count + 63) / 64;
+    std::vector<std::uint64_t> bits((size_t)new_count * stride, 0);
+    for (int s = 0; s < old_count; ++s) {
+        std::copy(
+                m_acm_bits.begin() + (size_t)s * m_acm_stride,
+                m_acm_bits.begin() + (size_t)(s + 1) * m_acm_stride,
+                bits.begin() + (size_t)s * stride);
+    }
+    m_acm_bits.swap(bits);
+    m_acm_stride = stride;
+}
+
+/// Bring the attached body slots up to date with the attached bodies model.
+/// Detached bodies have their slots cleared and released; only newly attached
+/// bodies have their entries looked up in the allowed collision matrix.
+void SelfCollisionModel::updateAcmAttachedBodies()
+{
+    if (m_acm_ab_version == m_abcm->version()) {
+        return;
+    }
+    m_acm_ab_version = m_abcm->version();
+
+    const int link_count = (int)m_rcm->linkCount();
+
+    std::vector<int> bodies;
+    m_abcm->attachedBodyIndices(bodies);
+    std::sort(bodies.begin(), bodies.end());
+
+    // release the slots of detached bodies; attached body indices are never
+    // reused by the model
+    for (size_t i = 0; i < m_acm_slot_bodies.size(); ++i) {
+        const int abidx = m_acm_slot_bodies[i];
+        if (abidx == -1 ||
+            std::binary_search(bodies.begin(), bodies.end(), abidx))
+        {
+            continue;
+        }
+        const int slot = link_count + (int)i;
+        for (int s = 0; s < acmSlotCount(); ++s) {
+            setAcmAllowed(slot, s, false);
+        }
+        m_acm_slot_bodies[i] = -1;
+        m_acm_body_slots.erase(abidx);
+    }
+
+    // assign slots to newly attached bodies
+    for (int abidx : bodies) {
+        if (m_acm_body_slots.find(abidx) != m_acm_body_slots.end()) {
+            continue;
+        }
+        auto fit = std::find(
+                m_acm_slot_bodies.begin(), m_acm_slot_bodies.end(), -1);
+        int slot;
+        if (fit != m_acm_slot_bodies.end()) {
+            *fit = abidx;
+            slot = link_count + (int)std::distance(m_acm_slot_bodies.begin(), fit);
+        } else {
+            const int old_count = acmSlotCount();
+            m_acm_slot_bodies.push_back(abidx);
+            growAcmSlots(old_count, acmSlotCount());
+            slot = old_count;
+        }
+        m_acm_body_slots[abidx] = slot;
+        compileAcmSlot(slot);
+    }
+}
+
 /// Check that the input states are related to the collision models passed to
 /// the constructor.
 bool SelfCollisionModel::checkCommonInputs(
@@ -139,6 +597,15 @@ void SelfCollisionModel::prepareState(
     int gidx,
     const double* state)
 {
+    if (m_acm_ab_version != m_abcm->version()) {
+        ROS_DEBUG_NAMED(SCM_LOGGER, "Update attached bodies in the allowed collision matrix");
+        updateAcmAttachedBodies();
+        // the checked pairs of a new group are prepared by updateGroup
+        if (gidx == m_gidx) {
+            updateAttachedBodyCheckedSphereIndices();
+            updateRobotAttachedBodyCheckedSphereIndices();
+        }
+    }
     updateGroup(gidx);
     copyState(state);
     updateVoxelsStates();
@@ -160,21 +627,28 @@ void SelfCollisionModel::updateAllowedCollisionMatrix(
     const AllowedCollisionMatrix& acm)
 {
     ROS_DEBUG_NAMED(SCM_LOGGER, "Update allowed collision matrix");
+    updateAcmAttachedBodies();
+
     std::vector<std::string> all_entries;
 
     acm.getAllEntryNames(all_entries);
 
+    std::vector<int> slots(all_entries.size());
+    for (size_t i = 0; i < all_entries.size(); ++i) {
+        slots[i] = acmSlot(all_entries[i]);
+    }
+
     collision_detection::AllowedCollision::Type type;
     for (size_t i = 0; i < all_entries.size(); ++i) {
         for (size_t j = i + 1; j < all_entries.size(); ++j) {
             const std::string& entry1 = all_entries[i];
             const std::string& entry2 = all_entries[j];
             if (acm.getEntry(entry1, entry2, type)) {
-                if (type != collision_detection::AllowedCollision::NEVER) {
-                    m_acm.setEntry(entry1, entry2, false);
-                }
-                else {
-                    m_acm.setEntry(entry1, entry2, true);
+                const bool allowed =
+                        type == collision_detection::AllowedCollision::NEVER;
+                m_acm.setEntry(entry1, entry2, allowed);
+                if (slots[i] != -1 && slots[j] != -1) {
+                    setAcmAllowed(slots[i], slots[j], allowed);
                 }
             }
         }
@@ -187,6 +661,7 @@ void SelfCollisionModel::setAllowedCollisionMatrix(
 {
     ROS_DEBUG_NAMED(SCM_LOGGER, "Overwrite allowed collision matrix");
     m_acm = acm;
+    compileAllowedCollisionMatrix();
     updateCheckedSpheresIndices();
 }
 
@@ -197,6 +672,15 @@ void SelfCollisionModel::setPadding(double padding)
     m_padding = padding;
 }
 
+/// Enable a second broad phase level for self collisions between robot links.
+/// Pairs of links whose root spheres overlap are additionally tested with
+/// capsules bounding their spheres, which fit elongated links far more tightly,
+/// before their sphere trees are descended.
+void SelfCollisionModel::setCapsuleBroadPhase(bool enabled)
+{
+    m_capsule_broad_phase = enabled;
+}
+
 void SelfCollisionModel::setWorldToModelTransform(
     const Eigen::Affine3d& transform)
 {
@@ -215,15 +699,7 @@ bool SelfCollisionModel::checkCollision(
 
     prepareState(gidx, state.getJointVarPositions());
 
-    if (!checkRobotVoxelsStateCollisions(dist) ||
-        !checkAttachedBodyVoxelsStateCollisions(dist) ||
-        !checkRobotSpheresStateCollisions(dist) ||
-        !checkAttachedBodySpheresStateCollisions(dist))
-    {
-        return false;
-    }
-
-    return true;
+    return checkStages(nullptr, dist);
 }
 
 bool SelfCollisionModel::checkCollision(
@@ -239,17 +715,88 @@ bool SelfCollisionModel::checkCollision(
 
     prepareState(gidx, state.getJointVarPositions());
 
-    if (!checkRobotVoxelsStateCollisions(dist) ||
-        !checkAttachedBodyVoxelsStateCollisions(dist) ||
-        !checkRobotSpheresStateCollisions(aci, dist) ||
-        !checkAttachedBodySpheresStateCollisions(aci, dist))
-    {
-        return false;
+    return checkStages(&aci, dist);
+}
+
+/// Run the stages of a collision check, the robot and attached bodies against
+/// the occupancy grid and against themselves, until one finds a collision. The
+/// result does not depend on the order of the stages, so they are run in the
+/// order most likely to find a collision soonest.
+bool SelfCollisionModel::checkStages(
+    const AllowedCollisionsInterface* aci,
+    double& dist)
+{
+    const bool sample = m_check_count % STAGE_SAMPLE_PERIOD == 0;
+    if (++m_check_count % STAGE_UPDATE_PERIOD == 0) {
+        updateStageOrder();
+    }
+
+    for (int i = 0; i < CheckStageCount; ++i) {
+        const int stage = m_stage_order[i];
+        bool valid;
+        if (sample) {
+            const auto then = std::chrono::steady_clock::now();
+            valid = checkStage(stage, aci, dist);
+            const std::chrono::duration<double> elapsed =
+                    std::chrono::steady_clock::now() - then;
+            m_stage_cost[stage] +=
+                    STAGE_COST_RATE * (elapsed.count() - m_stage_cost[stage]);
+        } else {
+            valid = checkStage(stage, aci, dist);
+        }
+
+        if (!valid) {
+            m_stage_rejections[stage] += 1.0;
+            return false;
+        }
     }
 
     return true;
 }
 
+bool SelfCollisionModel::checkStage(
+    int stage,
+    const AllowedCollisionsInterface* aci,
+    double& dist)
+{
+    switch (stage) {
+    case RobotVoxelsStage:
+        return checkRobotVoxelsStateCollisions(dist);
+    case AttachedBodyVoxelsStage:
+        return checkAttachedBodyVoxelsStateCollisions(dist);
+    case RobotSpheresStage:
+        if (aci) {
+            return checkRobotSpheresStateCollisions(*aci, dist);
+        }
+        return checkRobotSpheresStateCollisions(dist);
+    case AttachedBodySpheresStage:
+        if (aci) {
+            return checkAttachedBodySpheresStateCollisions(*aci, dist);
+        }
+        return checkAttachedBodySpheresStateCollisions(dist);
+    default:
+        return true;
+    }
+}
+
+/// Order the stages by the collisions they recently found per unit cost and
+/// decay the collision counts. Stages that have found no collisions keep their
+/// relative default order.
+void SelfCollisionModel::updateStageOrder()
+{
+    double score[CheckStageCount];
+    for (int i = 0; i < CheckStageCount; ++i) {
+        score[i] = m_stage_rejections[i] / std::max(m_stage_cost[i], 1.0e-9);
+        m_stage_rejections[i] *= STAGE_REJECTION_DECAY;
+    }
+    for (int i = 0; i < CheckStageCount; ++i) {
+        m_stage_order[i] = i;
+    }
+    std::stable_sort(
+            m_stage_order, m_stage_order + CheckStageCount,
+            [&](int a, int b) { return score[a] > score[b]; });
+}
+
 bool SelfCollisionModel::checkMotionCollision(
     RobotCollisionState& state,
     AttachedBodiesCollisionState& ab_state,
@@ -360,6 +907,25 @@ double SelfCollisionModel::collisionDistance(
     return d;
 }
 
+/// Return a lower bound on the distance between the robot and the occupied
+/// voxels of the grid, without regard to self collisions. The distance of
+/// attached bodies is not yet computed.
+double SelfCollisionModel::worldCollisionDistance(
+    const RobotCollisionState& state,
+    const AttachedBodiesCollisionState& ab_state,
+    const int gidx)
+{
+    if (!checkCommonInputs(state, ab_state, gidx)) {
+        return 0.0;
+    }
+
+    prepareState(gidx, state.getJointVarPositions());
+
+    return std::min(
+            robotVoxelsCollisionDistance(),
+            attachedBodyVoxelsCollisionDistance());
+}
+
 bool SelfCollisionModel::collisionDetails(
     const RobotCollisionState& state,
     const AttachedBodiesCollisionState& ab_state,
@@ -420,6 +986,8 @@ void SelfCollisionModel::updateGroup(int gidx)
 
     ROS_DEBUG_NAMED(SCM_LOGGER, "Update Self Collision Model from group %d to group %d", m_gidx, gidx);
 
+    m_last_world_hit = nullptr;
+
     // switch to new voxels state context
 
     std::vector<int> old_ov_indices = m_voxels_indices;
@@ -449,11 +1017,12 @@ void SelfCollisionModel::updateGroup(int gidx)
             std::back_inserter(ovidx_ins));
     ROS_DEBUG_NAMED(SCM_LOGGER, "ovidx_ins: %s", to_string(ovidx_ins).c_str());
 
-    // gather the voxels to be removed
+    // gather the cells to be removed
     std::vector<Eigen::Vector3d> v_rem;
     for (int vsidx : ovidx_rem) {
-        const CollisionVoxelsState& vs = m_rcs.voxelsState(vsidx);
-        v_rem.insert(v_rem.end(), vs.voxels.begin(), vs.voxels.end());
+        auto& cells = m_voxels_cells[vsidx];
+        AppendCellDifference(*m_grid, cells, CollisionVoxelsBitset(), v_rem);
+        cells.clear();
     }
 
     // gather the voxels to be inserted
@@ -461,6 +1030,7 @@ void SelfCollisionModel::updateGroup(int gidx)
     for (int vsidx : ovidx_ins) {
         const CollisionVoxelsState& vs = m_rcs.voxelsState(vsidx);
         v_ins.insert(v_ins.end(), vs.voxels.begin(), vs.voxels.end());
+        ComputeGridCells(*m_grid, vs.voxels, m_voxels_cells[vsidx]);
     }
 
     // insert/remove the voxels
@@ -574,27 +1144,30 @@ void SelfCollisionModel::updateVoxelsStates()
     auto& v_rem = m_v_rem; v_rem.clear();
     auto& v_ins = m_v_ins; v_ins.clear();
 
+    // only the cells that robot voxels states entered or left are updated
     for (int vsidx : m_voxels_indices) {
         if (m_rcs.voxelsStateDirty(vsidx)) {
+            m_rcs.updateVoxelsState(vsidx);
             const CollisionVoxelsState& voxels_state = m_rcs.voxelsState(vsidx);
 
-            // copy over voxels to be removed before updating
-            const size_t prev_size = v_rem.size();
-            v_rem.insert(
-                    v_rem.end(),
-                    voxels_state.voxels.begin(),
-                    voxels_state.voxels.end());
-            const size_t curr_size = v_rem.size();
-
-            m_rcs.updateVoxelsState(vsidx);
+            auto& moved_cells = m_moved_voxels_cells;
+            const CollisionVoxelsModel& model = *voxels_state.model;
+            if (!TransformGridCells(
+                    *m_grid,
+                    model,
+                    m_rcs.linkTransform(model.link_index),
+                    moved_cells))
+            {
+                ComputeGridCells(*m_grid, voxels_state.voxels, moved_cells);
+            }
 
-            // copy over voxels to be inserted
-            v_ins.insert(
-                    v_ins.end(),
-                    voxels_state.voxels.begin(),
-                    voxels_state.voxels.end());
+            auto& cells = m_voxels_cells[vsidx];
+            const size_t prev_size = v_rem.size() + v_ins.size();
+            AppendCellDifference(*m_grid, cells, moved_cells, v_rem);
+            AppendCellDifference(*m_grid, moved_cells, cells, v_ins);
+            std::swap(cells, moved_cells);
 
-            ROS_DEBUG_NAMED(SCM_LOGGER, "  Update Occupancy Grid with change to Collision Voxels State (%zu displaced)", curr_size - prev_size);
+            ROS_DEBUG_NAMED(SCM_LOGGER, "  Update Occupancy Grid with change to Collision Voxels State (%zu cells changed)", v_rem.size() + v_ins.size() - prev_size);
         }
     }
 
@@ -649,6 +1222,18 @@ bool SelfCollisionModel::checkRobotVoxelsStateCollisions(double& dist)
 #if SCDL_USE_META_TREE
     q.push_back(m_meta_state.spheres.root());
 #else
+    // a configuration in collision is likely near the last one found in
+    // collision, often with the same sphere
+    if (m_last_world_hit) {
+        const CollisionSphereState* s = m_last_world_hit;
+        m_rcs.updateSphereState(SphereIndex(s->parent_state->index, s->index()));
+        double d;
+        if (!CheckSphereCollision(*m_grid, *s, m_padding, d)) {
+            dist = d;
+            return false;
+        }
+    }
+
     for (const int ssidx : m_rcs.groupSpheresStateIndices(m_gidx)) {
         const auto& ss = m_rcs.spheresState(ssidx);
         const CollisionSphereState* s = ss.spheres.root();
@@ -656,7 +1241,12 @@ bool SelfCollisionModel::checkRobotVoxelsStateCollisions(double& dist)
     }
 #endif
 
-    return CheckVoxelsCollisions(m_rcs, q, *m_grid, m_padding, dist);
+    const CollisionSphereState* hit = nullptr;
+    if (!CheckVoxelsCollisions(m_rcs, q, *m_grid, m_padding, dist, &hit)) {
+        m_last_world_hit = hit;
+        return false;
+    }
+    return true;
 }
 
 bool SelfCollisionModel::checkAttachedBodyVoxelsStateCollisions(
@@ -669,6 +1259,21 @@ bool SelfCollisionModel::checkAttachedBodyVoxelsStateCollisions(
 
     for (const int ssidx : m_abcs.groupSpheresStateIndices(m_gidx)) {
         const auto& ss = m_abcs.spheresState(ssidx);
+
+        const int abidx = ss.model->link_index;
+        auto* field = m_abcm->distanceFieldModel(abidx);
+        if (field) {
+            m_abcs.updateAttachedBodyTransform(abidx);
+            const Eigen::Affine3d pose =
+                    m_abcs.attachedBodyTransform(abidx) * field->pose;
+            if (!CheckDistanceFieldVoxelsCollisions(
+                    *m_grid, *field, pose, m_padding, dist))
+            {
+                return false;
+            }
+            continue;
+        }
+
         const CollisionSphereState* s = ss.spheres.root();
         q.push_back(s);
     }
@@ -680,7 +1285,88 @@ bool SelfCollisionModel::checkRobotSpheresStateCollisions(double& dist)
 {
     ROS_DEBUG_NAMED(SCM_LOGGER, "Check robot links vs robot links");
 
-    for (const auto& ss_pair : m_checked_spheres_states) {
+    // check the pair of links last found in collision before the broad phase
+    if (m_last_self_pair >= 0) {
+        const auto& ss_pair = m_checked_spheres_states[m_last_self_pair];
+        auto& ss1 = m_rcs.spheresState(ss_pair.first);
+        auto& ss2 = m_rcs.spheresState(ss_pair.second);
+        if (!checkSpheresStateCollision(
+                m_rcs, m_rcs, ss_pair.first, ss_pair.second, ss1, ss2, dist))
+        {
+            return false;
+        }
+    }
+
+    // broad phase: test the root spheres of all pairs in one sweep over the
+    // packed arrays and descend the sphere trees only for the overlapping ones
+    for (size_t i = 0; i < m_bp_states.size(); ++i) {
+        const int ssidx = m_bp_states[i];
+        const CollisionSphereState* root = m_rcs.spheresState(ssidx).spheres.root();
+        m_rcs.updateSphereState(SphereIndex(ssidx, root->index()));
+        m_bp_x[i] = root->pos.x();
+        m_bp_y[i] = root->pos.y();
+        m_bp_z[i] = root->pos.z();
+    }
+
+    const double* x = m_bp_x.data();
+    const double* y = m_bp_y.data();
+    const double* z = m_bp_z.data();
+    const double* r = m_bp_r.data();
+    const int* first = m_bp_first.data();
+    const int* second = m_bp_second.data();
+    std::uint8_t* overlap = m_bp_overlap.data();
+    const size_t pair_count = m_bp_overlap.size();
+    for (size_t p = 0; p < pair_count; ++p) {
+        const int a = first[p];
+        const int b = second[p];
+        const double dx = x[b] - x[a];
+        const double dy = y[b] - y[a];
+        const double dz = z[b] - z[a];
+        const double cr = r[a] + r[b];
+        overlap[p] = dx * dx + dy * dy + dz * dz <= cr * cr;
+    }
+
+    // the last colliding pair was checked above
+    if (m_last_self_pair >= 0) {
+        overlap[m_last_self_pair] = 0;
+    }
+
+    if (m_capsule_broad_phase) {
+        // the root sphere updates above brought the link transforms up to date
+        for (size_t i = 0; i < m_bp_states.size(); ++i) {
+            const Eigen::Affine3d& T = m_rcs.linkTransform(m_bp_links[i]);
+            const Eigen::Vector3d p = T * m_bp_cap_p[i];
+            const Eigen::Vector3d u = T.linear() * m_bp_cap_u[i];
+            m_bp_px[i] = p.x();
+            m_bp_py[i] = p.y();
+            m_bp_pz[i] = p.z();
+            m_bp_ux[i] = u.x();
+            m_bp_uy[i] = u.y();
+            m_bp_uz[i] = u.z();
+        }
+
+        const double* cr = m_bp_cap_r.data();
+        for (size_t p = 0; p < pair_count; ++p) {
+            if (!overlap[p]) {
+                continue;
+            }
+            const int a = first[p];
+            const int b = second[p];
+            const double d2 = SegmentSegmentDistanceSqrd(
+                    m_bp_px[a], m_bp_py[a], m_bp_pz[a],
+                    m_bp_ux[a], m_bp_uy[a], m_bp_uz[a],
+                    m_bp_px[b], m_bp_py[b], m_bp_pz[b],
+                    m_bp_ux[b], m_bp_uy[b], m_bp_uz[b]);
+            const double rr = cr[a] + cr[b];
+            overlap[p] = d2 <= rr * rr;
+        }
+    }
+
+    for (size_t p = 0; p < pair_count; ++p) {
+        if (!overlap[p]) {
+            continue;
+        }
+        const auto& ss_pair = m_checked_spheres_states[p];
         int ss1i = ss_pair.first;
         int ss2i = ss_pair.second;
         auto& ss1 = m_rcs.spheresState(ss1i);
@@ -689,6 +1375,7 @@ bool SelfCollisionModel::checkRobotSpheresStateCollisions(double& dist)
         if (!checkSpheresStateCollision(
                 m_rcs, m_rcs, ss1i, ss2i, ss1, ss2, dist))
         {
+            m_last_self_pair = (int)p;
             return false;
         }
     }
@@ -823,12 +1510,7 @@ bool SelfCollisionModel::checkRobotAttachedBodySpheresStateCollisions(
     for (const auto& ss_pair : m_checked_attached_body_robot_spheres_states) {
         int ss1i = ss_pair.first;
         int ss2i = ss_pair.second;
-        const CollisionSpheresState& ss1 = m_abcs.spheresState(ss1i);
-        const CollisionSpheresState& ss2 = m_rcs.spheresState(ss2i);
-
-        if (!checkSpheresStateCollision(
-                m_abcs, m_rcs, ss1i, ss2i, ss1, ss2, dist))
-        {
+        if (!checkAttachedBodyRobotSpheresStateCollision(ss1i, ss2i, dist)) {
             return false;
         }
     }
@@ -868,11 +1550,7 @@ bool SelfCollisionModel::checkRobotAttachedBodySpheresStateCollisions(
 
             const int ss1i = m_abcs.attachedBodySpheresStateIndex(bidx);
             const int ss2i = m_rcs.linkSpheresStateIndex(lidx);
-            const CollisionSpheresState& ss1 = m_abcs.spheresState(ss1i);
-            const CollisionSpheresState& ss2 = m_rcs.spheresState(ss2i);
-            if (!checkSpheresStateCollision(
-                    m_abcs, m_rcs, ss1i, ss2i, ss1, ss2, dist))
-            {
+            if (!checkAttachedBodyRobotSpheresStateCollision(ss1i, ss2i, dist)) {
                 return false;
             }
         }
@@ -881,6 +1559,34 @@ bool SelfCollisionModel::checkRobotAttachedBodySpheresStateCollisions(
     return true;
 }
 
+/// Check an attached body against a robot link, using the body's distance
+/// field, if it has one, in place of its spheres.
+bool SelfCollisionModel::checkAttachedBodyRobotSpheresStateCollision(
+    int ss1i,
+    int ss2i,
+    double& dist)
+{
+    const CollisionSpheresState& ss1 = m_abcs.spheresState(ss1i);
+    const CollisionSpheresState& ss2 = m_rcs.spheresState(ss2i);
+
+    const int abidx = ss1.model->link_index;
+    auto* field = m_abcm->distanceFieldModel(abidx);
+    if (!field) {
+        return checkSpheresStateCollision(
+                m_abcs, m_rcs, ss1i, ss2i, ss1, ss2, dist);
+    }
+
+    m_abcs.updateAttachedBodyTransform(abidx);
+    const Eigen::Affine3d pose =
+            m_abcs.attachedBodyTransform(abidx) * field->pose;
+
+    auto& q = m_vq;
+    q.clear();
+    const CollisionSphereState* s = ss2.spheres.root();
+    q.push_back(s);
+    return CheckDistanceFieldCollisions(m_rcs, q, *field, pose, m_padding, dist);
+}
+
 bool CheckGeometryCollision(
     const CollisionGeometry& shape1,
     const CollisionGeometry& shape2,
@@ -1243,6 +1949,7 @@ void SelfCollisionModel::updateCheckedSpheresIndices()
 void SelfCollisionModel::updateRobotCheckedSphereIndices()
 {
     m_checked_spheres_states.clear();
+    m_last_self_pair = -1;
 
     const auto& group_link_indices = m_rcm->groupLinkIndices(m_gidx);
     for (int l1 = 0; l1 < group_link_indices.size(); ++l1) {
@@ -1251,35 +1958,81 @@ void SelfCollisionModel::updateRobotCheckedSphereIndices()
         if (!l1_has_spheres) {
             continue;
         }
-        const std::string& l1_name = m_rcm->linkName(lidx1);
         for (int l2 = l1 + 1; l2 < group_link_indices.size(); ++l2) {
             const int lidx2 = group_link_indices[l2];
             const bool l2_has_spheres = m_rcm->hasSpheresModel(lidx2);
             if (!l2_has_spheres) {
                 continue;
             }
-            const std::string& l2_name = m_rcm->linkName(lidx2);
 
-            collision_detection::AllowedCollision::Type type;
-            if (m_acm.getEntry(l1_name, l2_name, type)) {
-                if (type != collision_detection::AllowedCollision::ALWAYS) {
-                    m_checked_spheres_states.emplace_back(
-                            m_rcs.linkSpheresStateIndex(lidx1),
-                            m_rcs.linkSpheresStateIndex(lidx2));
-                }
-            }
-            else {
+            if (!acmAllowed(lidx1, lidx2)) {
                 m_checked_spheres_states.emplace_back(
                         m_rcs.linkSpheresStateIndex(lidx1),
                         m_rcs.linkSpheresStateIndex(lidx2));
             }
         }
     }
+
+    updateRobotBroadPhase();
+}
+
+/// Pack the root spheres of the spheres states in m_checked_spheres_states for
+/// the broad phase of checkRobotSpheresStateCollisions.
+void SelfCollisionModel::updateRobotBroadPhase()
+{
+    m_bp_states.clear();
+    for (const auto& ss_pair : m_checked_spheres_states) {
+        m_bp_states.push_back(ss_pair.first);
+        m_bp_states.push_back(ss_pair.second);
+    }
+    std::sort(m_bp_states.begin(), m_bp_states.end());
+    m_bp_states.erase(
+            std::unique(m_bp_states.begin(), m_bp_states.end()),
+            m_bp_states.end());
+
+    m_bp_x.assign(m_bp_states.size(), 0.0);
+    m_bp_y.assign(m_bp_states.size(), 0.0);
+    m_bp_z.assign(m_bp_states.size(), 0.0);
+    m_bp_r.resize(m_bp_states.size());
+    for (size_t i = 0; i < m_bp_states.size(); ++i) {
+        const auto& ss = m_rcs.spheresState(m_bp_states[i]);
+        m_bp_r[i] = ss.spheres.root()->model->radius;
+    }
+
+    m_bp_links.resize(m_bp_states.size());
+    m_bp_cap_p.resize(m_bp_states.size());
+    m_bp_cap_u.resize(m_bp_states.size());
+    m_bp_cap_r.resize(m_bp_states.size());
+    for (size_t i = 0; i < m_bp_states.size(); ++i) {
+        const auto& ss = m_rcs.spheresState(m_bp_states[i]);
+        m_bp_links[i] = ss.model->link_index;
+        ComputeBoundingCapsule(
+                ss.model->spheres, m_bp_cap_p[i], m_bp_cap_u[i], m_bp_cap_r[i]);
+    }
+    m_bp_px.assign(m_bp_states.size(), 0.0);
+    m_bp_py.assign(m_bp_states.size(), 0.0);
+    m_bp_pz.assign(m_bp_states.size(), 0.0);
+    m_bp_ux.assign(m_bp_states.size(), 0.0);
+    m_bp_uy.assign(m_bp_states.size(), 0.0);
+    m_bp_uz.assign(m_bp_states.size(), 0.0);
+
+    auto packed_index = [&](int ssidx)
+    {
+        auto it = std::lower_bound(m_bp_states.begin(), m_bp_states.end(), ssidx);
+        return (int)std::distance(m_bp_states.begin(), it);
+    };
+
+    m_bp_first.resize(m_checked_spheres_states.size());
+    m_bp_second.resize(m_checked_spheres_states.size());
+    m_bp_overlap.resize(m_checked_spheres_states.size());
+    for (size_t p = 0; p < m_checked_spheres_states.size(); ++p) {
+        m_bp_first[p] = packed_index(m_checked_spheres_states[p].first);
+        m_bp_second[p] = packed_index(m_checked_spheres_states[p].second);
+    }
 }
 
 void SelfCollisionModel::updateRobotAttachedBodyCheckedSphereIndices()
 {
-    // TODO: see note in updateAttachedBodyCheckedSphereIndices()
     m_checked_attached_body_robot_spheres_states.clear();
 
     const auto& group_body_indices = m_abcm->groupLinkIndices(m_gidx);
@@ -1290,24 +2043,15 @@ void SelfCollisionModel::updateRobotAttachedBodyCheckedSphereIndices()
         if (!b1_has_spheres) {
             continue;
         }
-        const std::string& b1_name = m_abcm->attachedBodyName(bidx1);
+        const int b1_slot = acmBodySlot(bidx1);
         for (int l1 = 0; l1 < group_link_indices.size(); ++l1) {
             const int lidx = group_link_indices[l1];
             const bool l1_has_spheres = m_rcm->hasSpheresModel(lidx);
             if (!l1_has_spheres) {
                 continue;
             }
-            const std::string& l1_name = m_rcm->linkName(lidx);
 
-            collision_detection::AllowedCollision::Type type;
-            if (m_acm.getEntry(b1_name, l1_name, type)) {
-                if (type != collision_detection::AllowedCollision::ALWAYS) {
-                    m_checked_attached_body_robot_spheres_states.emplace_back(
-                            m_abcs.attachedBodySpheresStateIndex(bidx1),
-                            m_rcs.linkSpheresStateIndex(lidx));
-                }
-            }
-            else {
+            if (!acmAllowed(b1_slot, lidx)) {
                 m_checked_attached_body_robot_spheres_states.emplace_back(
                         m_abcs.attachedBodySpheresStateIndex(bidx1),
                         m_rcs.linkSpheresStateIndex(lidx));
@@ -1318,8 +2062,6 @@ void SelfCollisionModel::updateRobotAttachedBodyCheckedSphereIndices()
 
 void SelfCollisionModel::updateAttachedBodyCheckedSphereIndices()
 {
-    // TODO: need to call this function whenever the attached bodies model has
-    // a body added or removed from it
     m_checked_attached_body_spheres_states.clear();
     const auto& group_body_indices = m_abcm->groupLinkIndices(m_gidx);
     for (int b1 = 0; b1 < group_body_indices.size(); ++b1) {
@@ -1328,24 +2070,15 @@ void SelfCollisionModel::updateAttachedBodyCheckedSphereIndices()
         if (!b1_has_spheres) {
             continue;
         }
-        const std::string& b1_name = m_abcm->attachedBodyName(bidx1);
+        const int b1_slot = acmBodySlot(bidx1);
         for (int b2 = b1 + 1; b2 < group_body_indices.size(); ++b2) {
             const int bidx2 = group_body_indices[b2];
             const bool b2_has_spheres = m_abcm->hasSpheresModel(bidx2);
             if (!b2_has_spheres) {
                 continue;
             }
-            const std::string& b2_name = m_abcm->attachedBodyName(bidx2);
 
-            collision_detection::AllowedCollision::Type type;
-            if (m_acm.getEntry(b1_name, b2_name, type)) {
-                if (type != collision_detection::AllowedCollision::ALWAYS) {
-                    m_checked_attached_body_spheres_states.emplace_back(
-                            m_abcs.attachedBodySpheresStateIndex(bidx1),
-                            m_abcs.attachedBodySpheresStateIndex(bidx2));
-                }
-            }
-            else {
+            if (!acmAllowed(b1_slot, acmBodySlot(bidx2))) {
                 m_checked_attached_body_spheres_states.emplace_back(
                         m_abcs.attachedBodySpheresStateIndex(bidx1),
                         m_abcs.attachedBodySpheresStateIndex(bidx2));
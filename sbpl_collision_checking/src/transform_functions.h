@@ -124,7 +124,7 @@ Eigen::Affine3d ComputeRevoluteJointTransformX(
     t(0,2) = cth * o(0,2) - sth * o(0,1);
     t(1,2) = cth * o(1,2) - sth * o(1,1);
     t(2,2) = cth * o(2,2) - sth * o(2,1);
-    t(3,0) = 0.0;
+    t(3,2) = 0.0;
 
     t(0,3) = o(0,3);
     t(1,3) = o(1,3);
@@ -159,7 +159,7 @@ Eigen::Affine3d ComputeRevoluteJointTransformY(
     t(0,2) = sth * o(0,0) + cth * o(0,2);
     t(1,2) = sth * o(1,0) + cth * o(1,2);
     t(2,2) = sth * o(2,0) + cth * o(2,2);
-    t(3,0) = 0.0;
+    t(3,2) = 0.0;
 
     t(0,3) = o(0,3);
     t(1,3) = o(1,3);
@@ -194,7 +194,7 @@ Eigen::Affine3d ComputeRevoluteJointTransformZ(
     t(0,2) = o(0, 2);
     t(1,2) = o(1, 2);
     t(2,2) = o(2, 2);
-    t(3,0) = 0.0;
+    t(3,2) = 0.0;
 
     t(0,3) = o(0, 3);
     t(1,3) = o(1, 3);
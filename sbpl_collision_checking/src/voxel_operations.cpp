@@ -1,6 +1,7 @@
 #include <sbpl_collision_checking/voxel_operations.h>
 
 // standard includes
+#include <cstddef>
 #include <utility>
 
 // system includes
@@ -13,16 +14,46 @@
 namespace smpl {
 namespace collision {
 
-std::vector<std::uint32_t> ConvertToVertexIndices(
-    const std::vector<shape_msgs::MeshTriangle>& triangles)
-{
-    std::vector<std::uint32_t> triangle_indices(3 * triangles.size());
-    for (int j = 0; j < triangles.size(); ++j) {
-        triangle_indices[3 * j + 0] = triangles[j].vertex_indices[0];
-        triangle_indices[3 * j + 1] = triangles[j].vertex_indices[1];
-        triangle_indices[3 * j + 2] = triangles[j].vertex_indices[2];
+// Views the vertex and triangle arrays of a mesh message in place. The
+// coordinates of geometry_msgs::Point and the indices of
+// shape_msgs::MeshTriangle are laid out contiguously, so each element is
+// addressed with the struct size as the stride.
+static
+geometry::MeshView MakeMeshView(const shape_msgs::Mesh& mesh)
+{
+    static_assert(
+            offsetof(geometry_msgs::Point, y) == offsetof(geometry_msgs::Point, x) + sizeof(double) &&
+            offsetof(geometry_msgs::Point, z) == offsetof(geometry_msgs::Point, y) + sizeof(double),
+            "geometry_msgs::Point coordinates must be contiguous");
+    static_assert(
+            sizeof(shape_msgs::MeshTriangle::_vertex_indices_type) == 3 * sizeof(std::uint32_t),
+            "shape_msgs::MeshTriangle indices must be contiguous");
+
+    geometry::MeshView view;
+    if (!mesh.vertices.empty()) {
+        view.vertices = &mesh.vertices[0].x;
+        view.vertex_count = mesh.vertices.size();
+        view.vertex_stride = sizeof(geometry_msgs::Point);
     }
-    return triangle_indices;
+    if (!mesh.triangles.empty()) {
+        view.triangles = &mesh.triangles[0].vertex_indices[0];
+        view.triangle_count = mesh.triangles.size();
+        view.triangle_stride = sizeof(shape_msgs::MeshTriangle);
+    }
+    return view;
+}
+
+// Views the flat vertex and triangle arrays of a mesh shape in place
+template <typename Mesh>
+static
+geometry::MeshView MakeMeshView(const Mesh& mesh)
+{
+    geometry::MeshView view;
+    view.vertices = mesh.vertices;
+    view.vertex_count = mesh.vertex_count;
+    view.triangles = mesh.triangles;
+    view.triangle_count = mesh.triangle_count;
+    return view;
 }
 
 static
@@ -490,16 +521,7 @@ bool VoxelizeMesh(
     const Eigen::Vector3d& go,
     std::vector<Eigen::Vector3d>& voxels)
 {
-    // TODO: eww mesh duplication
-    std::vector<Eigen::Vector3d> vertices(mesh.vertex_count);
-    for (unsigned int i = 0; i < mesh.vertex_count; ++i) {
-        vertices[i] = Eigen::Vector3d(
-                mesh.vertices[3 * i + 0],
-                mesh.vertices[3 * i + 1],
-                mesh.vertices[3 * i + 2]);
-    }
-    std::vector<std::uint32_t> indices(mesh.triangles, mesh.triangles + 3 * mesh.triangle_count);
-    geometry::VoxelizeMesh(vertices, indices, pose, res, go, voxels, false);
+    geometry::VoxelizeMesh(MakeMeshView(mesh), pose, res, go, voxels, false);
     return true;
 }
 
@@ -661,16 +683,7 @@ bool VoxelizeMesh(
     const Eigen::Vector3d& go,
     std::vector<Eigen::Vector3d>& voxels)
 {
-    // TODO: eww mesh duplication
-    std::vector<Eigen::Vector3d> vertices(mesh.vertex_count);
-    for (unsigned int i = 0; i < mesh.vertex_count; ++i) {
-        vertices[i] = Eigen::Vector3d(
-                mesh.vertices[3 * i + 0],
-                mesh.vertices[3 * i + 1],
-                mesh.vertices[3 * i + 2]);
-    }
-    std::vector<std::uint32_t> indices(mesh.triangles, mesh.triangles + 3 * mesh.triangle_count);
-    geometry::VoxelizeMesh(vertices, indices, pose, res, go, voxels, false);
+    geometry::VoxelizeMesh(MakeMeshView(mesh), pose, res, go, voxels, false);
     return true;
 }
 
@@ -812,22 +825,10 @@ bool VoxelizeMesh(
     const Eigen::Vector3d& go,
     std::vector<Eigen::Vector3d>& voxels)
 {
-    std::vector<Eigen::Vector3d> vertices;
-    vertices.resize(mesh.vertices.size());
-    for (size_t vidx = 0; vidx < mesh.vertices.size(); ++vidx) {
-        const geometry_msgs::Point& vertex = mesh.vertices[vidx];
-        vertices[vidx] = Eigen::Vector3d(vertex.x, vertex.y, vertex.z);
-    }
-
-    std::vector<std::uint32_t> indices = ConvertToVertexIndices(mesh.triangles);
-
     Eigen::Affine3d eigen_pose;
     tf::poseMsgToEigen(pose, eigen_pose);
 
-    std::vector<Eigen::Vector3d> sbpl_voxels;
-    geometry::VoxelizeMesh(vertices, indices, eigen_pose, res, go, sbpl_voxels, false);
-
-    voxels.insert(voxels.end(), sbpl_voxels.begin(), sbpl_voxels.end());
+    geometry::VoxelizeMesh(MakeMeshView(mesh), eigen_pose, res, go, voxels, false);
     return true;
 }
 
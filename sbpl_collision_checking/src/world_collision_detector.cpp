@@ -159,6 +159,23 @@ bool WorldCollisionDetector::checkAttachedBodySpheresStateCollisions(
 
     for (const int ssidx : state.groupSpheresStateIndices(gidx)) {
         const auto& ss = state.spheresState(ssidx);
+
+        // bodies with a distance field are checked against the occupied
+        // cells around them in place of their spheres
+        const int abidx = ss.model->link_index;
+        auto* field = state.model()->distanceFieldModel(abidx);
+        if (field) {
+            state.updateAttachedBodyTransform(abidx);
+            const Eigen::Affine3d pose =
+                    state.attachedBodyTransform(abidx) * field->pose;
+            if (!CheckDistanceFieldVoxelsCollisions(
+                    *m_wcm->grid(), *field, pose, m_wcm->padding(), dist))
+            {
+                return false;
+            }
+            continue;
+        }
+
         const CollisionSphereState* s = ss.spheres.root();
         q.push_back(s);
     }
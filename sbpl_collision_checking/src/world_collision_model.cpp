@@ -33,11 +33,17 @@
 
 // standard includes
 #include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <tuple>
 #include <utility>
 
 // system includes
+#include <boost/functional/hash.hpp>
 #include <eigen_conversions/eigen_msg.h>
 #include <leatherman/utils.h>
+#include <smpl/worker_pool.h>
 
 // project includes
 #include <sbpl_collision_checking/voxel_operations.h>
@@ -48,6 +54,67 @@ namespace collision {
 
 static const char* LOG = "world";
 
+// Compute the grid cells occupied by $old_voxels but not $new_voxels, and the
+// cells occupied by $new_voxels but not $old_voxels. In a reference-counted
+// grid, cells are compared as multisets, so that a cell covered by several
+// shapes keeps its reference count consistent. Cells outside the grid are
+// ignored.
+static
+void DiffVoxels(
+    const OccupancyGrid& grid,
+    const std::vector<std::vector<Eigen::Vector3d>>& old_voxels,
+    const std::vector<std::vector<Eigen::Vector3d>>& new_voxels,
+    std::vector<Eigen::Vector3d>& removed_voxels,
+    std::vector<Eigen::Vector3d>& added_voxels)
+{
+    auto cell_less = [](const Eigen::Vector3i& a, const Eigen::Vector3i& b) {
+        return std::tie(a.x(), a.y(), a.z()) < std::tie(b.x(), b.y(), b.z());
+    };
+
+    auto to_cells = [&](const std::vector<std::vector<Eigen::Vector3d>>& voxels)
+    {
+        std::vector<Eigen::Vector3i> cells;
+        for (auto& voxel_list : voxels) {
+            for (auto& v : voxel_list) {
+                Eigen::Vector3i c;
+                grid.worldToGrid(v.x(), v.y(), v.z(), c.x(), c.y(), c.z());
+                if (grid.isInBounds(c.x(), c.y(), c.z())) {
+                    cells.push_back(c);
+                }
+            }
+        }
+        std::sort(begin(cells), end(cells), cell_less);
+        if (!grid.refCounted()) {
+            cells.erase(std::unique(begin(cells), end(cells)), end(cells));
+        }
+        return cells;
+    };
+
+    auto old_cells = to_cells(old_voxels);
+    auto new_cells = to_cells(new_voxels);
+
+    auto to_voxels = [&](
+        const std::vector<Eigen::Vector3i>& a,
+        const std::vector<Eigen::Vector3i>& b,
+        std::vector<Eigen::Vector3d>& voxels)
+    {
+        std::vector<Eigen::Vector3i> cells;
+        std::set_difference(
+                begin(a), end(a), begin(b), end(b),
+                std::back_inserter(cells),
+                cell_less);
+        voxels.reserve(cells.size());
+        for (auto& c : cells) {
+            Eigen::Vector3d v;
+            grid.gridToWorld(c.x(), c.y(), c.z(), v.x(), v.y(), v.z());
+            voxels.push_back(v);
+        }
+    };
+
+    to_voxels(old_cells, new_cells, removed_voxels);
+    to_voxels(new_cells, old_cells, added_voxels);
+}
+
 /// \class WorldCollisionModel
 ///
 /// This class manages the collision representations for a set of objects in a
@@ -62,10 +129,23 @@ static const char* LOG = "world";
 ///
 /// The collision model disallows duplicates of the same object, with uniqueness
 /// determined by the object's address.
+///
+/// Optionally, the body-frame voxelization of each bounded shape may be cached,
+/// keyed on the shape's geometry and the grid resolution. Inserting or moving
+/// an object with a cached shape then only transforms the cached voxels into
+/// the grid, rather than revoxelizing its geometry. See setCacheShapeVoxels().
 
 WorldCollisionModel::WorldCollisionModel(OccupancyGrid* grid) :
     m_grid(grid),
-    m_padding(0.0)
+    m_padding(0.0),
+    m_cache_shape_voxels(false),
+    m_voxelize_thread_count(1),
+    m_version(0),
+    m_growth(0.0),
+    m_growth_epoch(0),
+    m_staged_growth(0.0),
+    m_batch_depth(0),
+    m_staging(false)
 {
 }
 
@@ -75,54 +155,109 @@ WorldCollisionModel::WorldCollisionModel(
 :
     m_grid(grid),
     m_object_models(o.m_object_models),
-    m_padding(o.m_padding)
+    m_padding(o.m_padding),
+    m_shape_voxels(o.m_shape_voxels),
+    m_cache_shape_voxels(o.m_cache_shape_voxels),
+    m_voxelize_thread_count(1),
+    m_version(o.m_version),
+    m_growth(o.m_growth),
+    m_growth_epoch(o.m_growth_epoch),
+    m_staged_growth(0.0),
+    m_batch_depth(o.m_batch_depth),
+    m_batch_removed(o.m_batch_removed),
+    m_batch_added(o.m_batch_added),
+    m_staging(false)
 {
+    // NOTE: updates staged into a double buffered grid but not yet published
+    // are not copied
+
     // TODO: check for different voxel origin/resolution/etc here...if they
     // differ, need to do a deep copy + revoxelization of the objects over just
     // a simple deep copy
-    *grid = *m_grid;
+    *grid = *o.m_grid;
+}
+
+WorldCollisionModel::~WorldCollisionModel()
+{
+    joinStageThread();
 }
 
 /// Add an object to the collision model. The object will be automatically
 /// rasterized and the distance map updated.
 bool WorldCollisionModel::insertObject(const CollisionObject* object)
 {
-    if (!checkObjectInsert(object)) {
-        ROS_ERROR_NAMED(LOG, "Rejecting addition of collision object '%s'", object->id.c_str());
-        return false;
-    }
-
-    const double res = m_grid->resolution();
-    const Eigen::Vector3d origin(
-            m_grid->originX(), m_grid->originY(), m_grid->originZ());
+    return insertObjects(&object, 1);
+}
 
-    const Eigen::Vector3d gmin(
-            m_grid->originX(), m_grid->originY(), m_grid->originZ());
+/// Add a set of objects to the collision model. The shapes of all objects are
+/// voxelized in parallel (see setVoxelizeThreadCount()), and the distance map
+/// is updated once for the whole set. Objects that are rejected or fail to
+/// voxelize are skipped.
+///
+/// \return true if all objects were inserted; false otherwise
+bool WorldCollisionModel::insertObjects(
+    const CollisionObject* const* objects,
+    size_t n)
+{
+    std::vector<const CollisionObject*> accepted;
+    accepted.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        auto* object = objects[i];
+        if (!checkObjectInsert(object) ||
+            std::find(begin(accepted), end(accepted), object) != end(accepted))
+        {
+            ROS_ERROR_NAMED(LOG, "Rejecting addition of collision object '%s'", object->id.c_str());
+            continue;
+        }
+        accepted.push_back(object);
+    }
 
-    const Eigen::Vector3d gmax(
-            m_grid->originX() + m_grid->sizeX(),
-            m_grid->originY() + m_grid->sizeY(),
-            m_grid->originZ() + m_grid->sizeZ());
+    std::vector<std::vector<VoxelList>> all_voxels;
+    std::vector<char> voxelized;
+    voxelizeObjects(accepted.data(), accepted.size(), all_voxels, voxelized);
 
-    std::vector<std::vector<Eigen::Vector3d>> all_voxels;
-    if (!VoxelizeObject(*object, res, origin, gmin, gmax, all_voxels)) {
-        ROS_ERROR_NAMED(LOG, "Failed to voxelize object '%s'", object->id.c_str());
-        return false;
-    }
+    auto all_inserted = accepted.size() == n;
+    size_t voxel_count = 0;
+    auto first_model = m_object_models.size();
+    for (size_t i = 0; i < accepted.size(); ++i) {
+        if (!voxelized[i]) {
+            ROS_ERROR_NAMED(LOG, "Failed to voxelize object '%s'", accepted[i]->id.c_str());
+            all_inserted = false;
+            continue;
+        }
 
-    {
         ObjectCollisionModel model;
-        model.object = object;
-        model.cached_voxels = std::move(all_voxels);
+        model.object = accepted[i];
+        model.cached_voxels = std::move(all_voxels[i]);
+        for (auto& voxel_list : model.cached_voxels) {
+            voxel_count += voxel_list.size();
+        }
         m_object_models.push_back(std::move(model));
     }
 
-    for (auto& voxel_list : m_object_models.back().cached_voxels) {
-        ROS_DEBUG_NAMED(LOG, "Adding %zu voxels from collision object '%s' to the distance transform", voxel_list.size(), object->id.c_str());
-        m_grid->addPointsToField(voxel_list);
+    if (m_object_models.size() == first_model) {
+        return all_inserted;
     }
 
-    return true;
+    ROS_DEBUG_NAMED(LOG, "Adding %zu voxels from %zu collision objects to the distance transform", voxel_count, m_object_models.size() - first_model);
+    if (updating()) {
+        for (size_t i = first_model; i < m_object_models.size(); ++i) {
+            addVoxels(m_object_models[i].cached_voxels);
+        }
+        return all_inserted;
+    }
+
+    VoxelList voxels;
+    voxels.reserve(voxel_count);
+    for (size_t i = first_model; i < m_object_models.size(); ++i) {
+        for (auto& voxel_list : m_object_models[i].cached_voxels) {
+            voxels.insert(end(voxels), begin(voxel_list), end(voxel_list));
+        }
+    }
+    grow(addedReach(voxels));
+    m_grid->addPointsToField(voxels);
+    ++m_version;
+    return all_inserted;
 }
 
 /// Remove an object from the collision model. The voxels occupied by this
@@ -137,25 +272,68 @@ bool WorldCollisionModel::removeObject(const CollisionObject* object)
     auto* model = getObjectCollisionModel(object);
     assert(model != NULL);
 
-    for (auto& voxel_list : model->cached_voxels) {
-        ROS_DEBUG_NAMED(LOG, "Removing %zu grid cells from the distance transform", voxel_list.size());
-        m_grid->removePointsFromField(voxel_list);
-    }
+    ROS_DEBUG_NAMED(LOG, "Removing voxels from collision object '%s' from the distance transform", object->id.c_str());
+    removeVoxels(model->cached_voxels);
 
     auto rit = std::remove_if(begin(m_object_models), end(m_object_models),
             [&](const ObjectCollisionModel& model) {
                 return model.object == object;
             });
     m_object_models.erase(rit, end(m_object_models));
+    if (!updating()) {
+        ++m_version;
+    }
     return true;
 }
 
 /// Update the collision model in response to a collision object moving or
-/// shapes moving with a collision object.
+/// shapes moving with a collision object. Only the cells whose occupancy
+/// changes are updated in the distance map. With shape voxel caching enabled,
+/// the object's shapes are not revoxelized.
 bool WorldCollisionModel::moveShapes(const CollisionObject* object)
 {
-    // TODO: optimized version
-    return removeObject(object) && insertObject(object);
+    if (!checkObjectMoveShape(object)) {
+        ROS_ERROR_NAMED(LOG, "Rejecting move of collision object '%s'", object->id.c_str());
+        return false;
+    }
+
+    auto mit = std::find_if(begin(m_object_models), end(m_object_models),
+            [object](const ObjectCollisionModel& model) {
+                return model.object == object;
+            });
+    assert(mit != end(m_object_models));
+
+    std::vector<VoxelList> all_voxels;
+    if (!voxelizeObject(*object, all_voxels)) {
+        // match remove-then-insert, which would leave the object removed
+        ROS_ERROR_NAMED(LOG, "Failed to voxelize object '%s'", object->id.c_str());
+        removeObject(object);
+        return false;
+    }
+
+    VoxelList removed_voxels;
+    VoxelList added_voxels;
+    DiffVoxels(
+            *m_grid,
+            mit->cached_voxels, all_voxels,
+            removed_voxels, added_voxels);
+
+    mit->cached_voxels = std::move(all_voxels);
+
+    ROS_DEBUG_NAMED(LOG, "Moving collision object '%s' frees %zu cells and occupies %zu cells", object->id.c_str(), removed_voxels.size(), added_voxels.size());
+    if (updating()) {
+        m_batch_removed.insert(
+                end(m_batch_removed),
+                begin(removed_voxels), end(removed_voxels));
+        m_batch_added.insert(
+                end(m_batch_added),
+                begin(added_voxels), end(added_voxels));
+        return true;
+    }
+    grow(addedReach(added_voxels));
+    m_grid->updatePointsInField(removed_voxels, added_voxels);
+    ++m_version;
+    return true;
 }
 
 /// Update the collision model in response to shapes being added to a collision
@@ -195,12 +373,56 @@ bool WorldCollisionModel::hasObjectWithName(const std::string& id) const
 /// reinserting all object occupied voxels, and updating the distance map
 void WorldCollisionModel::reset()
 {
+    // the objects already reflect the updates of the current batch
+    joinStageThread();
+    m_batch_removed.clear();
+    m_batch_added.clear();
+
     m_grid->reset();
     for (auto& model : m_object_models) {
         for (auto& voxel_list : model.cached_voxels) {
             m_grid->addPointsToField(voxel_list);
         }
     }
+    ++m_version;
+    ++m_growth_epoch;
+    m_staged_growth = 0.0;
+}
+
+/// Enable or disable caching of body-frame shape voxelizations.
+///
+/// When enabled, the voxels for spheres, cylinders, cones, boxes, and meshes
+/// are computed once in the shape's frame, at half the grid resolution, and
+/// cached against the shape's geometry. Objects containing an identical shape
+/// are later voxelized by transforming the cached voxels by the shape pose and
+/// marking each grid cell within half a cell of a transformed voxel. The result
+/// is conservative: it contains the voxels of a direct voxelization at the
+/// same pose, but the voxelized surface may be up to one cell thicker. Planes
+/// and octrees are always voxelized directly.
+///
+/// Disabling the cache discards all cached voxelizations.
+void WorldCollisionModel::setCacheShapeVoxels(bool enabled)
+{
+    m_cache_shape_voxels = enabled;
+    if (!enabled) {
+        m_shape_voxels.clear();
+    }
+}
+
+/// Set the number of threads used to voxelize the shapes of inserted and
+/// moved objects. Copies of this model begin with a single thread.
+void WorldCollisionModel::setVoxelizeThreadCount(int num_threads)
+{
+    num_threads = std::max(num_threads, 1);
+    if (num_threads == m_voxelize_thread_count) {
+        return;
+    }
+    m_voxelize_thread_count = num_threads;
+    if (num_threads > 1) {
+        m_voxelize_pool.reset(new WorkerPool(num_threads));
+    } else {
+        m_voxelize_pool.reset();
+    }
 }
 
 /// Return a visualization of the objects in the collision model.
@@ -317,6 +539,278 @@ auto WorldCollisionModel::getObjectCollisionModel(
     return NULL;
 }
 
+bool WorldCollisionModel::ShapeVoxelsKey::operator==(
+    const ShapeVoxelsKey& o) const
+{
+    return type == o.type &&
+            res == o.res &&
+            params == o.params &&
+            indices == o.indices;
+}
+
+auto WorldCollisionModel::ShapeVoxelsKeyHash::operator()(
+    const ShapeVoxelsKey& key) const -> size_t
+{
+    size_t seed = 0;
+    boost::hash_combine(seed, key.type);
+    boost::hash_combine(seed, key.res);
+    boost::hash_combine(seed, boost::hash_range(begin(key.params), end(key.params)));
+    boost::hash_combine(seed, boost::hash_range(begin(key.indices), end(key.indices)));
+    return seed;
+}
+
+// Construct the cache key for a shape's geometry. Return false if the shape's
+// voxelization may not be cached.
+static
+bool MakeShapeVoxelsKey(
+    const CollisionShape& shape,
+    std::vector<double>& params,
+    std::vector<std::uint32_t>& indices)
+{
+    switch (shape.type) {
+    case ShapeType::Sphere: {
+        auto& sphere = static_cast<const SphereShape&>(shape);
+        params = { sphere.radius };
+        return true;
+    }
+    case ShapeType::Cylinder: {
+        auto& cylinder = static_cast<const CylinderShape&>(shape);
+        params = { cylinder.radius, cylinder.height };
+        return true;
+    }
+    case ShapeType::Cone: {
+        auto& cone = static_cast<const ConeShape&>(shape);
+        params = { cone.radius, cone.height };
+        return true;
+    }
+    case ShapeType::Box: {
+        auto& box = static_cast<const BoxShape&>(shape);
+        params = { box.size[0], box.size[1], box.size[2] };
+        return true;
+    }
+    case ShapeType::Mesh: {
+        auto& mesh = static_cast<const MeshShape&>(shape);
+        params.assign(mesh.vertices, mesh.vertices + 3 * mesh.vertex_count);
+        indices.assign(mesh.triangles, mesh.triangles + 3 * mesh.triangle_count);
+        return true;
+    }
+    default:
+        // planes are unbounded and octrees may be modified in place
+        return false;
+    }
+}
+
+// Transform body-frame voxels by $pose and mark the voxels of the grid, with
+// origin $go and resolution $res, that lie within half a grid cell of any
+// transformed voxel center. Duplicate voxels are removed.
+static
+void TransformBodyVoxels(
+    const std::vector<Eigen::Vector3d>& body_voxels,
+    const Eigen::Affine3d& pose,
+    double res,
+    const Eigen::Vector3d& go,
+    std::vector<Eigen::Vector3d>& voxels)
+{
+    // the body voxels are sampled at half the grid resolution, so a cube one
+    // grid cell wide around each transformed center bounds the volume of the
+    // body voxel, in any orientation
+    const double r = 0.5 * res;
+
+    std::vector<Eigen::Vector3i> cells;
+    cells.reserve(body_voxels.size());
+    for (auto& v : body_voxels) {
+        const Eigen::Vector3d p = pose * v;
+        const Eigen::Vector3i lo(
+                (int)std::floor((p.x() - r - go.x()) / res + 0.5),
+                (int)std::floor((p.y() - r - go.y()) / res + 0.5),
+                (int)std::floor((p.z() - r - go.z()) / res + 0.5));
+        const Eigen::Vector3i hi(
+                (int)std::floor((p.x() + r - go.x()) / res + 0.5),
+                (int)std::floor((p.y() + r - go.y()) / res + 0.5),
+                (int)std::floor((p.z() + r - go.z()) / res + 0.5));
+        for (int x = lo.x(); x <= hi.x(); ++x) {
+        for (int y = lo.y(); y <= hi.y(); ++y) {
+        for (int z = lo.z(); z <= hi.z(); ++z) {
+            cells.emplace_back(x, y, z);
+        }
+        }
+        }
+    }
+
+    auto cell_less = [](const Eigen::Vector3i& a, const Eigen::Vector3i& b) {
+        return std::tie(a.x(), a.y(), a.z()) < std::tie(b.x(), b.y(), b.z());
+    };
+    std::sort(begin(cells), end(cells), cell_less);
+    cells.erase(std::unique(begin(cells), end(cells)), end(cells));
+
+    voxels.reserve(voxels.size() + cells.size());
+    for (auto& c : cells) {
+        voxels.push_back(go + res * c.cast<double>());
+    }
+}
+
+// Voxelize all shapes of an object in the grid, using cached body-frame
+// voxelizations where possible.
+bool WorldCollisionModel::voxelizeObject(
+    const CollisionObject& object,
+    std::vector<VoxelList>& all_voxels)
+{
+    auto* pobject = &object;
+    std::vector<std::vector<VoxelList>> object_voxels;
+    std::vector<char> voxelized;
+    voxelizeObjects(&pobject, 1, object_voxels, voxelized);
+    if (!voxelized[0]) {
+        all_voxels.clear();
+        return false;
+    }
+    all_voxels = std::move(object_voxels[0]);
+    return true;
+}
+
+// Voxelize all shapes of a set of objects in the grid, one work item per
+// shape, each into its own voxel list. $voxelized[i] is set if every shape of
+// the i'th object was voxelized; otherwise $all_voxels[i] is left empty.
+void WorldCollisionModel::voxelizeObjects(
+    const CollisionObject* const* objects,
+    size_t n,
+    std::vector<std::vector<VoxelList>>& all_voxels,
+    std::vector<char>& voxelized)
+{
+    const double res = m_grid->resolution();
+    const Eigen::Vector3d origin(
+            m_grid->originX(), m_grid->originY(), m_grid->originZ());
+
+    const Eigen::Vector3d gmin(
+            m_grid->originX(), m_grid->originY(), m_grid->originZ());
+
+    const Eigen::Vector3d gmax(
+            m_grid->originX() + m_grid->sizeX(),
+            m_grid->originY() + m_grid->sizeY(),
+            m_grid->originZ() + m_grid->sizeZ());
+
+    all_voxels.clear();
+    all_voxels.resize(n);
+    voxelized.assign(n, 1);
+
+    // (object, shape) index of each work item
+    std::vector<std::pair<size_t, size_t>> items;
+    std::vector<const CollisionShape*> shapes;
+    for (size_t i = 0; i < n; ++i) {
+        all_voxels[i].resize(objects[i]->shapes.size());
+        for (size_t j = 0; j < objects[i]->shapes.size(); ++j) {
+            items.emplace_back(i, j);
+            shapes.push_back(objects[i]->shapes[j]);
+        }
+    }
+
+    std::vector<const VoxelList*> body_voxels(items.size(), NULL);
+    if (m_cache_shape_voxels) {
+        cacheBodyVoxels(shapes, res, body_voxels);
+    }
+
+    std::vector<char> shape_voxelized(items.size(), 1);
+    runVoxelize(items.size(), [&](size_t k)
+    {
+        auto& object = *objects[items[k].first];
+        auto& pose = object.shape_poses[items[k].second];
+        auto& voxels = all_voxels[items[k].first][items[k].second];
+        if (body_voxels[k] != NULL) {
+            TransformBodyVoxels(*body_voxels[k], pose, res, origin, voxels);
+        } else if (!VoxelizeShape(*shapes[k], pose, res, origin, gmin, gmax, voxels)) {
+            shape_voxelized[k] = 0;
+        }
+    });
+
+    for (size_t k = 0; k < items.size(); ++k) {
+        if (!shape_voxelized[k]) {
+            voxelized[items[k].first] = 0;
+        }
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (!voxelized[i]) {
+            all_voxels[i].clear();
+        }
+    }
+}
+
+// Look up the cached body-frame voxels of each shape, voxelizing, in
+// parallel, the shapes that have not been seen before. $body_voxels[k] is left
+// null for shapes that may not be cached.
+void WorldCollisionModel::cacheBodyVoxels(
+    const std::vector<const CollisionShape*>& shapes,
+    double res,
+    std::vector<const VoxelList*>& body_voxels)
+{
+    std::vector<ShapeVoxelsKey> keys(shapes.size());
+    std::vector<char> cacheable(shapes.size(), 0);
+
+    // the first of the shapes sharing each key that is not yet cached
+    std::vector<size_t> unseen;
+    hash_map<ShapeVoxelsKey, size_t, ShapeVoxelsKeyHash> pending;
+    for (size_t k = 0; k < shapes.size(); ++k) {
+        keys[k].type = (int)shapes[k]->type;
+        keys[k].res = res;
+        if (!MakeShapeVoxelsKey(*shapes[k], keys[k].params, keys[k].indices)) {
+            continue;
+        }
+        cacheable[k] = 1;
+        if (m_shape_voxels.find(keys[k]) == end(m_shape_voxels) &&
+            pending.emplace(keys[k], unseen.size()).second)
+        {
+            unseen.push_back(k);
+        }
+    }
+
+    // sample the bodies at half resolution; see TransformBodyVoxels()
+    std::vector<VoxelList> unseen_voxels(unseen.size());
+    std::vector<char> unseen_voxelized(unseen.size(), 0);
+    const double body_res = 0.5 * res;
+    runVoxelize(unseen.size(), [&](size_t u)
+    {
+        unseen_voxelized[u] = VoxelizeShape(
+                *shapes[unseen[u]],
+                Eigen::Affine3d::Identity(),
+                body_res,
+                Eigen::Vector3d::Zero(),
+                unseen_voxels[u]);
+    });
+
+    for (size_t u = 0; u < unseen.size(); ++u) {
+        if (!unseen_voxelized[u]) {
+            continue;
+        }
+        auto& key = keys[unseen[u]];
+        ROS_DEBUG_NAMED(LOG, "Cache %zu body voxels for shape of type %d", unseen_voxels[u].size(), key.type);
+        m_shape_voxels.emplace(key, std::move(unseen_voxels[u]));
+    }
+
+    // shapes that failed to voxelize in the body frame are voxelized directly
+    for (size_t k = 0; k < shapes.size(); ++k) {
+        if (!cacheable[k]) {
+            continue;
+        }
+        auto it = m_shape_voxels.find(keys[k]);
+        if (it != end(m_shape_voxels)) {
+            body_voxels[k] = &it->second;
+        }
+    }
+}
+
+// Run $job on each of $count work items, on the voxelization threads if there
+// are several of them.
+void WorldCollisionModel::runVoxelize(
+    size_t count,
+    const std::function<void(size_t)>& job)
+{
+    if (m_voxelize_pool && count > 1) {
+        m_voxelize_pool->run(count, [&](int tid, size_t i) { job(i); });
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        job(i);
+    }
+}
+
 // Return true if the model does not already contain this object and the object
 // is not malformed.
 bool WorldCollisionModel::checkObjectInsert(const CollisionObject* object) const
@@ -363,6 +857,174 @@ bool WorldCollisionModel::checkObjectRemoveShape(const CollisionObject* object)
     return haveObject(object);
 }
 
+/// Begin a batch of updates. See commitUpdate().
+void WorldCollisionModel::beginUpdate()
+{
+    ++m_batch_depth;
+}
+
+/// End a batch of updates begun by beginUpdate(). At the end of the outermost
+/// batch, the voxels freed and occupied by the batch are merged into a single
+/// update of the distance map, with a cell that is both freed and occupied
+/// left untouched. For grids without reference counting, the merged update
+/// behaves as if all cells were freed before any were occupied.
+///
+/// If the grid is double buffered, the update is staged on a background
+/// thread, and takes effect once published by publishUpdates(); otherwise it
+/// is applied immediately.
+///
+/// \return false if no batch was begun; true otherwise
+bool WorldCollisionModel::commitUpdate()
+{
+    if (m_batch_depth == 0) {
+        ROS_WARN_NAMED(LOG, "Commit without a matching call to beginUpdate");
+        return false;
+    }
+    if (--m_batch_depth > 0) {
+        return true;
+    }
+
+    std::vector<VoxelList> old_voxels(1);
+    std::vector<VoxelList> new_voxels(1);
+    old_voxels[0].swap(m_batch_removed);
+    new_voxels[0].swap(m_batch_added);
+
+    VoxelList removed_voxels;
+    VoxelList added_voxels;
+    DiffVoxels(*m_grid, old_voxels, new_voxels, removed_voxels, added_voxels);
+
+    ROS_DEBUG_NAMED(LOG, "Commit update that frees %zu cells and occupies %zu cells (%zu and %zu before merging)", removed_voxels.size(), added_voxels.size(), old_voxels[0].size(), new_voxels[0].size());
+
+    if (removed_voxels.empty() && added_voxels.empty()) {
+        return true;
+    }
+
+    // measured against the published grid, which lookups are made against
+    // until the update is published
+    auto reach = addedReach(added_voxels);
+
+    if (m_grid->doubleBuffered()) {
+        if (std::isinf(reach)) {
+            ++m_growth_epoch;
+        } else {
+            m_staged_growth += reach;
+        }
+        joinStageThread();
+        m_staging = true;
+        m_stage_thread = std::thread(
+                [this](const VoxelList& removed, const VoxelList& added) {
+                    m_grid->stageUpdatePoints(removed, added);
+                    m_staging = false;
+                },
+                std::move(removed_voxels),
+                std::move(added_voxels));
+        return true;
+    }
+
+    grow(reach);
+    m_grid->updatePointsInField(removed_voxels, added_voxels);
+    ++m_version;
+    return true;
+}
+
+/// Publish the updates staged into a double buffered grid by commitUpdate(),
+/// by swapping the grid's buffers. If \p wait is false and an update is still
+/// being staged, nothing is published. Must not be called concurrently with
+/// lookups into the grid.
+///
+/// \return true if updates were published; false otherwise
+bool WorldCollisionModel::publishUpdates(bool wait)
+{
+    if (!wait && m_staging) {
+        return false;
+    }
+    joinStageThread();
+
+    if (!m_grid->swapBuffers()) {
+        return false;
+    }
+    m_growth += m_staged_growth;
+    m_staged_growth = 0.0;
+    ++m_version;
+    return true;
+}
+
+void WorldCollisionModel::joinStageThread()
+{
+    if (m_stage_thread.joinable()) {
+        m_stage_thread.join();
+    }
+}
+
+// Return an upper bound on the distance from any of $voxels to the voxels
+// occupied in the grid, or infinity if one lies beyond the range of the
+// distance map. Distances are padded by one cell for the quantization of the
+// distance map.
+double WorldCollisionModel::addedReach(const VoxelList& voxels) const
+{
+    auto max_dist = m_grid->getDistanceField()->getUninitializedDistance();
+    auto reach = -1.0;
+    for (auto& v : voxels) {
+        if (!m_grid->isInBounds(v.x(), v.y(), v.z())) {
+            continue;
+        }
+        auto d = m_grid->getDistanceFromPoint(v.x(), v.y(), v.z());
+        if (d >= max_dist) {
+            return std::numeric_limits<double>::infinity();
+        }
+        reach = std::max(reach, d);
+    }
+    if (reach < 0.0) {
+        return 0.0;
+    }
+    return reach + m_grid->resolution();
+}
+
+// Grow the world by $reach, or begin a new growth epoch if the growth is
+// unbounded.
+void WorldCollisionModel::grow(double reach)
+{
+    if (std::isinf(reach)) {
+        ++m_growth_epoch;
+    } else {
+        m_growth += reach;
+    }
+}
+
+void WorldCollisionModel::removeVoxels(const std::vector<VoxelList>& voxels)
+{
+    for (auto& voxel_list : voxels) {
+        if (updating()) {
+            m_batch_removed.insert(
+                    end(m_batch_removed),
+                    begin(voxel_list), end(voxel_list));
+        } else {
+            m_grid->removePointsFromField(voxel_list);
+        }
+    }
+}
+
+void WorldCollisionModel::addVoxels(const std::vector<VoxelList>& voxels)
+{
+    if (!updating()) {
+        // measured before any of the voxels are added
+        auto reach = 0.0;
+        for (auto& voxel_list : voxels) {
+            reach = std::max(reach, addedReach(voxel_list));
+        }
+        grow(reach);
+    }
+    for (auto& voxel_list : voxels) {
+        if (updating()) {
+            m_batch_added.insert(
+                    end(m_batch_added),
+                    begin(voxel_list), end(voxel_list));
+        } else {
+            m_grid->addPointsToField(voxel_list);
+        }
+    }
+}
+
 void WorldCollisionModel::removeAllObjects()
 {
     // while loop since m_object_models is not stable here
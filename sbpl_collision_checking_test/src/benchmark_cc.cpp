@@ -30,6 +30,7 @@
 /// \author Andrew Dornbush
 
 // standard includes
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
 #include <chrono>
@@ -43,7 +44,13 @@
 #include <smpl/distance_map/sparse_distance_map.h>
 #include <smpl/distance_map/euclid_distance_map.h>
 #include <smpl/occupancy_grid.h>
+#include <sbpl_collision_checking/attached_bodies_collision_model.h>
+#include <sbpl_collision_checking/attached_bodies_collision_state.h>
 #include <sbpl_collision_checking/collision_space.h>
+#include <sbpl_collision_checking/robot_collision_state.h>
+#include <sbpl_collision_checking/self_collision_model.h>
+#include <sbpl_collision_checking/world_collision_detector.h>
+#include <sbpl_collision_checking/world_collision_model.h>
 #include <urdf/model.h>
 
 #include "pr2_allowed_collision_pairs.h"
@@ -154,6 +161,18 @@ public:
 
     ProfileResults profileCollisionChecks(double time_limit);
     ProfileResults profileDistanceChecks(double time_limit);
+
+    struct MicroResults
+    {
+        std::string name;
+        int call_count;
+        double total_time;
+        double p50_latency;
+        double p99_latency;
+    };
+
+    std::vector<MicroResults> profilePrimitives(double time_limit);
+
     int exportCheckedStates(const char* filename, int count);
     int verifyCheckedStates(const char* filename);
 
@@ -167,8 +186,28 @@ private:
     std::default_random_engine m_rng;
     ros::Publisher m_pub;
 
+    // collision models that share the grid and robot model of the collision
+    // space, for measuring the primitives it is composed of in isolation
+    smpl::collision::RobotCollisionStatePtr m_rcs;
+    smpl::collision::AttachedBodiesCollisionModelPtr m_abcm;
+    smpl::collision::AttachedBodiesCollisionStatePtr m_abcs;
+    smpl::collision::WorldCollisionModelPtr m_wcm;
+    smpl::collision::WorldCollisionDetectorPtr m_wcd;
+    smpl::collision::SelfCollisionModelPtr m_scm;
+    int m_gidx = -1;
+    std::vector<int> m_planning_vars;
+
     std::vector<double> createRandomState();
 
+    void insertTabletop();
+    void setPrimitiveState(const std::vector<double>& variables);
+
+    template <class CheckFun>
+    MicroResults profilePrimitive(
+        const char* name,
+        double time_limit,
+        CheckFun check);
+
     void initACM(smpl::collision::AllowedCollisionMatrix& acm);
 };
 
@@ -229,6 +268,22 @@ bool CollisionSpaceProfiler::init()
     m_pub = m_nh.advertise<visualization_msgs::MarkerArray>(
             "visualization_markers", 100);
 
+    m_rcs = std::make_shared<smpl::collision::RobotCollisionState>(m_rcm.get());
+    m_abcm = std::make_shared<smpl::collision::AttachedBodiesCollisionModel>(
+            m_rcm.get());
+    m_abcs = std::make_shared<smpl::collision::AttachedBodiesCollisionState>(
+            m_abcm.get(), m_rcs.get());
+    m_wcm = std::make_shared<smpl::collision::WorldCollisionModel>(m_grid.get());
+    m_wcd = std::make_shared<smpl::collision::WorldCollisionDetector>(
+            m_rcm.get(), m_wcm.get());
+    m_scm = std::make_shared<smpl::collision::SelfCollisionModel>(
+            m_grid.get(), m_rcm.get(), m_abcm.get());
+    m_scm->setAllowedCollisionMatrix(acm);
+    m_gidx = m_rcm->groupIndex(group_name);
+    for (auto& joint_name : m_planning_joints) {
+        m_planning_vars.push_back(m_rcm->jointVarIndex(joint_name));
+    }
+
     return true;
 }
 
@@ -279,6 +334,137 @@ CollisionSpaceProfiler::profileDistanceChecks(double time_limit)
     return res;
 }
 
+/// Measure the latency of each of the collision checking primitives over a
+/// fixed set of random states. Each primitive is called repeatedly until its
+/// calls have taken time_limit seconds in total.
+auto CollisionSpaceProfiler::profilePrimitives(double time_limit)
+    -> std::vector<MicroResults>
+{
+    insertTabletop();
+
+    // generate the states ahead of time so that the measurements include only
+    // the calls under test
+    const int state_count = 1000;
+    std::vector<std::vector<double>> states;
+    std::vector<std::vector<double>> nearby_states;
+    std::normal_distribution<double> perturbation(0.0, 0.05);
+    for (int i = 0; i < state_count; ++i) {
+        states.push_back(createRandomState());
+        auto nearby = states.back();
+        for (auto& v : nearby) {
+            v += perturbation(m_rng);
+        }
+        nearby_states.push_back(std::move(nearby));
+    }
+
+    std::vector<smpl::RobotState> batch(
+            states.begin(), states.begin() + std::min(state_count, 64));
+
+    std::vector<MicroResults> results;
+
+    results.push_back(profilePrimitive(
+            "CollisionSpace::isStateValid", time_limit,
+            [&](int i) { m_cspace.isStateValid(states[i]); }));
+
+    results.push_back(profilePrimitive(
+            "CollisionSpace::isStateToStateValid", time_limit,
+            [&](int i) { m_cspace.isStateToStateValid(states[i], nearby_states[i]); }));
+
+    results.push_back(profilePrimitive(
+            "CollisionSpace::areStatesValid (x64)", time_limit,
+            [&](int i) { m_cspace.areStatesValid(batch.data(), batch.size()); }));
+
+    results.push_back(profilePrimitive(
+            "RobotCollisionState::updateSphereStates", time_limit,
+            [&](int i)
+            {
+                for (size_t j = 0; j < m_planning_vars.size(); ++j) {
+                    m_rcs->setJointVarPosition(m_planning_vars[j], states[i][j]);
+                }
+                m_rcs->updateSphereStates();
+            }));
+
+    results.push_back(profilePrimitive(
+            "WorldCollisionDetector::checkCollision", time_limit,
+            [&](int i)
+            {
+                setPrimitiveState(states[i]);
+                double dist;
+                m_wcd->checkCollision(*m_rcs, *m_abcs, m_gidx, dist);
+            }));
+
+    results.push_back(profilePrimitive(
+            "SelfCollisionModel::checkCollision", time_limit,
+            [&](int i)
+            {
+                setPrimitiveState(states[i]);
+                double dist;
+                m_scm->checkCollision(*m_rcs, *m_abcs, m_gidx, dist);
+            }));
+
+    return results;
+}
+
+template <class CheckFun>
+auto CollisionSpaceProfiler::profilePrimitive(
+    const char* name,
+    double time_limit,
+    CheckFun check)
+    -> MicroResults
+{
+    ROS_INFO("Profile %s for %0.3f seconds", name, time_limit);
+
+    std::vector<double> latencies;
+    double elapsed = 0.0;
+    for (int i = 0; ros::ok() && elapsed < time_limit; i = (i + 1) % 1000) {
+        auto start = std::chrono::high_resolution_clock::now();
+        check(i);
+        auto finish = std::chrono::high_resolution_clock::now();
+        auto latency = std::chrono::duration<double>(finish - start).count();
+        latencies.push_back(latency);
+        elapsed += latency;
+    }
+
+    MicroResults res;
+    res.name = name;
+    res.call_count = (int)latencies.size();
+    res.total_time = elapsed;
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        res.p50_latency = latencies[latencies.size() / 2];
+        res.p99_latency = latencies[(latencies.size() * 99) / 100];
+    } else {
+        res.p50_latency = res.p99_latency = 0.0;
+    }
+    return res;
+}
+
+// Update the isolated robot state to a state of the planning variables,
+// without updating the sphere states, which the checks do themselves
+void CollisionSpaceProfiler::setPrimitiveState(
+    const std::vector<double>& variables)
+{
+    for (size_t j = 0; j < m_planning_vars.size(); ++j) {
+        m_rcs->setJointVarPosition(m_planning_vars[j], variables[j]);
+    }
+}
+
+// Fill a table top in front of the robot, matching the first object of
+// smpl_test's tabletop scene, so that world checks are not trivially free
+void CollisionSpaceProfiler::insertTabletop()
+{
+    const double res = m_grid->resolution();
+    std::vector<Eigen::Vector3d> points;
+    for (double x = 0.55 - 0.2; x <= 0.55 + 0.2; x += res) {
+    for (double y = -0.75; y <= 0.75; y += res) {
+    for (double z = 0.6 - 0.01; z <= 0.6 + 0.01; z += res) {
+        points.emplace_back(x, y, z);
+    }
+    }
+    }
+    m_grid->addPointsToField(points);
+}
+
 std::vector<double> CollisionSpaceProfiler::createRandomState()
 {
     std::vector<double> out;
@@ -416,6 +602,18 @@ int main(int argc, char *argv[])
             ROS_INFO("checks / second: %g", res.check_count / time_limit);
             ROS_INFO("seconds / check: %g", time_limit / res.check_count);
         }
+    } else if (0 == strcmp(cmd, "micro")) {
+        const double time_limit = argc > 2 ? std::atof(argv[2]) : 2.0;
+        auto results = prof.profilePrimitives(time_limit);
+        ROS_INFO("%-42s %12s %12s %12s %14s", "primitive", "calls", "p50 (us)", "p99 (us)", "calls / second");
+        for (auto& res : results) {
+            ROS_INFO("%-42s %12d %12.3f %12.3f %14.0f",
+                    res.name.c_str(),
+                    res.call_count,
+                    1e6 * res.p50_latency,
+                    1e6 * res.p99_latency,
+                    res.total_time > 0.0 ? res.call_count / res.total_time : 0.0);
+        }
     } else if (0 == strcmp(cmd, "load")) {
         return 0;
     }
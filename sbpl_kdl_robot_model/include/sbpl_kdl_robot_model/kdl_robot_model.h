@@ -35,7 +35,10 @@
 
 // standard includes
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
 
 // system includes
 #include <kdl/chain.hpp>
@@ -75,6 +78,13 @@ public:
 
     void printRobotModelInformation();
 
+    /// \name ForwardKinematicsInterface
+    /// @{
+    auto computeFK(const RobotState& state) -> Eigen::Affine3d override;
+    auto computeFK(RobotStateView state) -> Eigen::Affine3d override;
+    void computeFKBatch(const double* states, int n, Eigen::Affine3d* poses) override;
+    /// @}
+
     /// \name RedundantManipulatorInterface
     /// @{
     const int redundantVariableCount() const override { return 0; }
@@ -83,6 +93,11 @@ public:
         const Eigen::Affine3d& pose,
         const RobotState& start,
         RobotState& solution) override;
+    int computeFastIKBatch(
+        const Eigen::Affine3d* poses,
+        const RobotState* seeds,
+        int n,
+        RobotState* solutions) override;
     /// @}
 
     /// \name InverseKinematicsInterface Interface
@@ -119,15 +134,29 @@ public:
     KDL::Tree m_tree;
     KDL::Chain m_chain;
 
-    std::unique_ptr<KDL::ChainFkSolverPos_recursive>    m_fk_solver;
-    std::unique_ptr<KDL::ChainIkSolverVel_pinv>         m_ik_vel_solver;
-    std::unique_ptr<KDL::ChainIkSolverPos_NR_JL>        m_ik_solver;
+    // KDL solvers and scratch storage used by a single thread
+    struct SolverContext
+    {
+        std::unique_ptr<KDL::ChainFkSolverPos_recursive>    fk_solver;
+        std::unique_ptr<KDL::ChainIkSolverVel_pinv>         ik_vel_solver;
+        std::unique_ptr<KDL::ChainIkSolverPos_NR_JL>        ik_solver;
+        KDL::JntArray jnt_pos_in;
+        KDL::JntArray jnt_pos_out;
+        KDL::Frame frame;
+    };
+
+    // solver contexts, created lazily for each thread that calls into the
+    // model, so that FK and IK may be computed concurrently
+    std::unordered_map<std::thread::id, std::unique_ptr<SolverContext>> m_solvers;
+    std::mutex m_solvers_mutex;
 
     // ik solver settings
+    KDL::JntArray m_q_min;
+    KDL::JntArray m_q_max;
     int m_max_iterations;
     double m_kdl_eps;
 
-    // temporary storage
+    // temporary storage for derived models
     KDL::JntArray m_jnt_pos_in;
     KDL::JntArray m_jnt_pos_out;
 
@@ -135,6 +164,16 @@ public:
     int m_free_angle;
     double m_search_discretization;
     double m_timeout;
+
+private:
+
+    auto getSolverContext() -> SolverContext*;
+
+    // computeFastIK for a pose already expressed in the kinematics frame
+    bool computeFastIKKinematicsFrame(
+        const Eigen::Affine3d& pose,
+        const RobotState& start,
+        RobotState& solution);
 };
 
 } // namespace smpl
@@ -144,35 +144,27 @@ bool Init(
         return false; // this shouldn't happen either
     }
 
-    // FK solver
-    model->m_fk_solver = make_unique<KDL::ChainFkSolverPos_recursive>(model->m_chain);
-
-    // IK Velocity solver
-    model->m_ik_vel_solver = make_unique<KDL::ChainIkSolverVel_pinv>(model->m_chain);
-
-    // IK solver
-    KDL::JntArray q_min(model->jointVariableCount());
-    KDL::JntArray q_max(model->jointVariableCount());
+    // IK solver limits; the solvers themselves are created per thread
+    model->m_q_min.resize(model->jointVariableCount());
+    model->m_q_max.resize(model->jointVariableCount());
     for (size_t i = 0; i < model->jointVariableCount(); ++i) {
         if (model->vprops[i].continuous) {
-            q_min(i) = -M_PI;
-            q_max(i) = M_PI;
+            model->m_q_min(i) = -M_PI;
+            model->m_q_max(i) = M_PI;
         } else {
-            q_min(i) = model->vprops[i].min_position;
-            q_max(i) = model->vprops[i].max_position;
+            model->m_q_min(i) = model->vprops[i].min_position;
+            model->m_q_max(i) = model->vprops[i].max_position;
         }
     }
 
     model->m_max_iterations = 200;
     model->m_kdl_eps = 0.001;
-    model->m_ik_solver = make_unique<KDL::ChainIkSolverPos_NR_JL>(
-            model->m_chain,
-            q_min,
-            q_max,
-            *model->m_fk_solver,
-            *model->m_ik_vel_solver,
-            model->m_max_iterations,
-            model->m_kdl_eps);
+
+    // the transform to the kinematics frame is read, never written, by the
+    // solvers
+    UpdateLinkTransform(&model->robot_state, model->m_kinematics_link);
+
+    model->m_solvers.clear();
 
     model->m_jnt_pos_in.resize(model->m_chain.getNrOfJoints());
     model->m_jnt_pos_out.resize(model->m_chain.getNrOfJoints());
@@ -211,6 +203,68 @@ void NormalizeAngles(KDLRobotModel* model, KDL::JntArray* q)
     }
 }
 
+auto KDLRobotModel::getSolverContext() -> SolverContext*
+{
+    std::lock_guard<std::mutex> lock(m_solvers_mutex);
+    auto& context = m_solvers[std::this_thread::get_id()];
+    if (!context) {
+        context = make_unique<SolverContext>();
+        context->fk_solver = make_unique<KDL::ChainFkSolverPos_recursive>(m_chain);
+        context->ik_vel_solver = make_unique<KDL::ChainIkSolverVel_pinv>(m_chain);
+        context->ik_solver = make_unique<KDL::ChainIkSolverPos_NR_JL>(
+                m_chain,
+                m_q_min,
+                m_q_max,
+                *context->fk_solver,
+                *context->ik_vel_solver,
+                m_max_iterations,
+                m_kdl_eps);
+        context->jnt_pos_in.resize(m_chain.getNrOfJoints());
+        context->jnt_pos_out.resize(m_chain.getNrOfJoints());
+    }
+    return context.get();
+}
+
+auto KDLRobotModel::computeFK(const RobotState& state) -> Eigen::Affine3d
+{
+    return computeFK(RobotStateView(state));
+}
+
+auto KDLRobotModel::computeFK(RobotStateView state) -> Eigen::Affine3d
+{
+    auto* context = getSolverContext();
+    for (size_t i = 0; i < state.size(); ++i) {
+        context->jnt_pos_in(i) = state[i];
+    }
+
+    context->fk_solver->JntToCart(context->jnt_pos_in, context->frame);
+
+    Eigen::Affine3d T_kinematics_link;
+    tf::transformKDLToEigen(context->frame, T_kinematics_link);
+    return *GetLinkTransform(&this->robot_state, m_kinematics_link) * T_kinematics_link;
+}
+
+void KDLRobotModel::computeFKBatch(
+    const double* states,
+    int n,
+    Eigen::Affine3d* poses)
+{
+    auto* context = getSolverContext();
+    auto& T_map_kinematics = *GetLinkTransform(&this->robot_state, m_kinematics_link);
+    auto dim = (int)jointVariableCount();
+    for (auto i = 0; i < n; ++i) {
+        for (auto j = 0; j < dim; ++j) {
+            context->jnt_pos_in(j) = states[i * dim + j];
+        }
+
+        context->fk_solver->JntToCart(context->jnt_pos_in, context->frame);
+
+        Eigen::Affine3d T_kinematics_link;
+        tf::transformKDLToEigen(context->frame, T_kinematics_link);
+        poses[i] = T_map_kinematics * T_kinematics_link;
+    }
+}
+
 static
 double GetSolverMinPosition(KDLRobotModel* model, int vidx)
 {
@@ -231,15 +285,19 @@ bool KDLRobotModel::computeIKSearch(
     KDL::Frame frame_des;
     tf::transformEigenToKDL(T_map_kinematics->inverse() * pose, frame_des);
 
+    auto* context = getSolverContext();
+    auto& jnt_pos_in = context->jnt_pos_in;
+    auto& jnt_pos_out = context->jnt_pos_out;
+
     // seed configuration
     for (size_t i = 0; i < start.size(); i++) {
-        m_jnt_pos_in(i) = start[i];
+        jnt_pos_in(i) = start[i];
     }
 
     // must be normalized for CartToJntSearch
-    NormalizeAngles(this, &m_jnt_pos_in);
+    NormalizeAngles(this, &jnt_pos_in);
 
-    auto initial_guess = m_jnt_pos_in(m_free_angle);
+    auto initial_guess = jnt_pos_in(m_free_angle);
 
     auto start_time = smpl::clock::now();
     auto loop_time = 0.0;
@@ -253,19 +311,19 @@ bool KDLRobotModel::computeIKSearch(
                     this->m_search_discretization);
 
     while (loop_time < this->m_timeout) {
-        if (m_ik_solver->CartToJnt(m_jnt_pos_in, frame_des, m_jnt_pos_out) >= 0) {
-            NormalizeAngles(this, &m_jnt_pos_out);
+        if (context->ik_solver->CartToJnt(jnt_pos_in, frame_des, jnt_pos_out) >= 0) {
+            NormalizeAngles(this, &jnt_pos_out);
             solution.resize(start.size());
             for (size_t i = 0; i < solution.size(); ++i) {
-                solution[i] = m_jnt_pos_out(i);
+                solution[i] = jnt_pos_out(i);
             }
             return true;
         }
         if (!getCount(count, num_positive_increments, -num_negative_increments)) {
             return false;
         }
-        m_jnt_pos_in(m_free_angle) = initial_guess + this->m_search_discretization * count;
-        ROS_DEBUG("%d, %f", count, m_jnt_pos_in(m_free_angle));
+        jnt_pos_in(m_free_angle) = initial_guess + this->m_search_discretization * count;
+        ROS_DEBUG("%d, %f", count, jnt_pos_in(m_free_angle));
         loop_time = to_seconds(smpl::clock::now() - start_time);
     }
 
@@ -313,26 +371,62 @@ bool KDLRobotModel::computeFastIK(
 {
     // transform into kinematics frame and convert to kdl
     auto* T_map_kinematics = GetLinkTransform(&this->robot_state, m_kinematics_link);
+    return computeFastIKKinematicsFrame(
+            T_map_kinematics->inverse() * pose, start, solution);
+}
+
+int KDLRobotModel::computeFastIKBatch(
+    const Eigen::Affine3d* poses,
+    const RobotState* seeds,
+    int n,
+    RobotState* solutions)
+{
+    // the kinematics frame is fixed across the batch
+    auto T_kinematics_map =
+            GetLinkTransform(&this->robot_state, m_kinematics_link)->inverse();
+
+    auto found = 0;
+    for (auto i = 0; i < n; ++i) {
+        if (computeFastIKKinematicsFrame(
+                T_kinematics_map * poses[i], seeds[i], solutions[i]))
+        {
+            ++found;
+        } else {
+            solutions[i].clear();
+        }
+    }
+    return found;
+}
+
+bool KDLRobotModel::computeFastIKKinematicsFrame(
+    const Eigen::Affine3d& pose,
+    const RobotState& start,
+    RobotState& solution)
+{
     KDL::Frame frame_des;
-    tf::transformEigenToKDL(T_map_kinematics->inverse() * pose, frame_des);
+    tf::transformEigenToKDL(pose, frame_des);
+
+    auto* context = getSolverContext();
+    auto& jnt_pos_in = context->jnt_pos_in;
+    auto& jnt_pos_out = context->jnt_pos_out;
 
     // seed configuration
     for (size_t i = 0; i < start.size(); i++) {
-        m_jnt_pos_in(i) = start[i];
+        jnt_pos_in(i) = start[i];
     }
 
     // must be normalized for CartToJntSearch
-    NormalizeAngles(this, &m_jnt_pos_in);
+    NormalizeAngles(this, &jnt_pos_in);
 
-    if (m_ik_solver->CartToJnt(m_jnt_pos_in, frame_des, m_jnt_pos_out) < 0) {
+    if (context->ik_solver->CartToJnt(jnt_pos_in, frame_des, jnt_pos_out) < 0) {
         return false;
     }
 
-    NormalizeAngles(this, &m_jnt_pos_out);
+    NormalizeAngles(this, &jnt_pos_out);
 
     solution.resize(start.size());
     for (size_t i = 0; i < solution.size(); ++i) {
-        solution[i] = m_jnt_pos_out(i);
+        solution[i] = jnt_pos_out(i);
     }
 
     return true;
@@ -345,7 +439,11 @@ void KDLRobotModel::printRobotModelInformation()
 
 auto KDLRobotModel::getExtension(size_t class_code) -> Extension*
 {
-    if (class_code == GetClassCode<InverseKinematicsInterface>()) return this;
+    if (class_code == GetClassCode<InverseKinematicsInterface>() ||
+        class_code == GetClassCode<RedundantManipulatorInterface>())
+    {
+        return this;
+    }
     return URDFRobotModel::getExtension(class_code);
 }
 
@@ -62,8 +62,36 @@ class RPYSolver
         int solution_num,
         std::vector<double>& solution) const;
 
+    /// \brief Solve for several target orientations from the same start
+    ///
+    /// The start frames are computed once for the whole batch.
+    ///
+    /// \param rpys \p n consecutive { r, p, y } target orientations
+    /// \param solutions Array of \p n solutions; solutions[i] is left empty if
+    ///     the i'th orientation is not attainable
+    /// \return The number of solutions found
+    int computeRPYOnlyBatch(
+        const double* rpys,
+        int n,
+        const std::vector<double>& start,
+        const std::vector<double>& forearm_roll_link_pose,
+        const std::vector<double>& endeff_link_pose,
+        int solution_num,
+        std::vector<double>* solutions) const;
+
   private:
 
+    // start orientation of the hand, expressed in the forearm frame, that is
+    // independent of the target orientation
+    struct StartFrame
+    {
+        double v1[3];
+        double rot_world_trans[9];
+        double hand1_fo[6];
+        double grip1_fo[6];
+        double indicator1_fo[6];
+    };
+
     double wrist_pitch_min_limit_;
     double wrist_pitch_max_limit_;
 
@@ -93,6 +121,17 @@ class RPYSolver
         double yaw1, double pitch1, double roll1,
         double yaw2, double pitch2, double roll2,
         int attempt) const;
+
+    void computeStartFrame(
+        StartFrame* frame,
+        double phi, double theta, double psi,
+        double yaw1, double pitch1, double roll1) const;
+
+    void orientationSolver(
+        double* output,
+        const StartFrame& frame,
+        double yaw2, double pitch2, double roll2,
+        int attempt) const;
 };
 
 } // namespace smpl
@@ -61,12 +61,22 @@ public:
 
     /// \name Reimplemented Functions from KDLRobotModel
     ///@{
+    const int redundantVariableCount() const override { return 1; }
+    const int redundantVariableIndex(int vidx) const override { return PR2_FREE_ANGLE_INDEX; }
+
     bool computeIK(
         const Eigen::Affine3d& pose,
         const RobotState& start,
         RobotState& solution,
         ik_option::IkOption option = ik_option::UNRESTRICTED) override;
 
+    int computeIKBatch(
+        const Eigen::Affine3d* poses,
+        const RobotState* seeds,
+        int n,
+        RobotState* solutions,
+        ik_option::IkOption option = ik_option::UNRESTRICTED) override;
+
     bool computeFastIK(
         const Eigen::Affine3d& pose,
         const RobotState& start,
@@ -75,6 +85,9 @@ public:
 
 private:
 
+    // the upper arm roll joint parameterizes the analytical solutions
+    static const int PR2_FREE_ANGLE_INDEX = 2;
+
     std::unique_ptr<pr2_arm_kinematics::PR2ArmIKSolver> pr2_ik_solver_;
 
     std::unique_ptr<RPYSolver> m_rpy_solver;
@@ -82,6 +95,10 @@ private:
     std::string m_forearm_roll_link_name;
     std::string m_wrist_pitch_joint_name;
     std::string m_end_effector_link_name;
+    void computeWristPoses(
+        const RobotState& start,
+        std::vector<double>& forearm_pose,
+        std::vector<double>& end_effector_pose);
 };
 
 } // namespace smpl
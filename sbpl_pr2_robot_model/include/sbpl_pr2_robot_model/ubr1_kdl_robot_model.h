@@ -59,6 +59,13 @@ public:
         RobotState& solution,
         ik_option::IkOption option = ik_option::UNRESTRICTED) override;
 
+    int computeIKBatch(
+        const Eigen::Affine3d* poses,
+        const RobotState* seeds,
+        int n,
+        RobotState* solutions,
+        ik_option::IkOption option = ik_option::UNRESTRICTED) override;
+
 private:
 
     std::unique_ptr<RPYSolver> m_rpy_solver;
@@ -66,6 +73,10 @@ private:
     std::string m_forearm_roll_link_name;
     std::string m_wrist_pitch_joint_name;
     std::string m_end_effector_link_name;
+    void computeWristPoses(
+        const RobotState& start,
+        std::vector<double>& forearm_pose,
+        std::vector<double>& end_effector_pose);
 };
 
 } // namespace smpl
@@ -31,6 +31,9 @@
 /// \author Benjamin Cohen
 /// \author Andrew Dornbush
 
+// standard includes
+#include <algorithm>
+
 // project includes
 #include <sbpl_pr2_robot_model/sbpl_math.h>
 #include <sbpl_pr2_robot_model/orientation_solver.h>
@@ -82,12 +85,169 @@ bool RPYSolver::computeRPYOnly(
     return true;
 }
 
+int RPYSolver::computeRPYOnlyBatch(
+    const double* rpys,
+    int n,
+    const std::vector<double>& start,
+    const std::vector<double>& forearm_roll_link_pose,
+    const std::vector<double>& endeff_link_pose,
+    int solution_num,
+    std::vector<double>* solutions) const
+{
+    // the start orientation is shared by every target
+    StartFrame frame;
+    computeStartFrame(
+        &frame,
+        forearm_roll_link_pose[5], forearm_roll_link_pose[4], forearm_roll_link_pose[3],
+        endeff_link_pose[5], endeff_link_pose[4], endeff_link_pose[3]);
+
+    auto found = 0;
+    for (int i = 0; i < n; ++i) {
+        auto* rpy = rpys + 3 * i;
+
+        double hand_rotations[4];
+        orientationSolver(
+                hand_rotations, frame, rpy[2], rpy[1], rpy[0], solution_num);
+
+        auto& solution = solutions[i];
+        if (hand_rotations[0] == 0) {
+            solution.clear();
+            continue;
+        }
+
+        solution = start;
+        solution[4] += hand_rotations[1];
+        solution[5] += hand_rotations[2];
+        solution[6] += hand_rotations[3];
+        ++found;
+    }
+
+    return found;
+}
+
 void RPYSolver::orientationSolver(
     double* output,
     double phi, double theta, double psi,
     double yaw1, double pitch1, double roll1,
     double yaw2, double pitch2, double roll2,
     int attempt) const
+{
+    StartFrame frame;
+    computeStartFrame(&frame, phi, theta, psi, yaw1, pitch1, roll1);
+    orientationSolver(output, frame, yaw2, pitch2, roll2, attempt);
+}
+
+void RPYSolver::computeStartFrame(
+    StartFrame* frame,
+    double phi, double theta, double psi,
+    double yaw1, double pitch1, double roll1) const
+{
+    // The PR2 FK is defined such that pitch is negative upward. Hence, the
+    // input pitch values are negated, because the following portion of the code
+    // was written assuming that pitch is positive upward.
+
+    theta = -theta;
+    pitch1 = -pitch1;
+
+    frame->v1[0] = cos(theta) * cos(phi);
+    frame->v1[1] = cos(theta) * sin(phi);
+    frame->v1[2] = sin(theta);
+
+    double hand1[] = { 0, -0.5, 0, 0, 0.5, 0 };
+    double grip1[] = { 0, 0, 0, 1, 0, 0 };
+    double indicator1[] = { -2.5, 0, 0, -2.5, 0, 1 };
+    double grip1_vect[3];
+    double ind1_vect[3];
+    double comp1_vect[3], project1_vect[3];
+    double rot1[9], rot2[9], rot3[9];
+    double temp[6], temp1[9], temp2[9], temp3[9], temp_var, temp_vect[3];
+    double w[3], w_hat[9];
+    double rot_world[9];
+    double identity[] = { 1, 0, 0, 0, 1, 0, 0, 0, 1 };
+    double unit_x[3] = { 1, 0, 0 };
+    double fs_angle;
+    double c_delta;
+
+    create_rotation_matrix(rot_world, phi, theta, psi);
+    transpose(frame->rot_world_trans, rot_world, 3, 3);
+
+    // The start orientation in the world frame
+    rot1[0] = cos(yaw1);      rot1[3] = -sin(yaw1);     rot1[6] = 0;
+    rot1[1] = sin(yaw1);      rot1[4] = cos(yaw1);      rot1[7] = 0;
+    rot1[2] = 0;              rot1[5] = 0;              rot1[8] = 1;
+
+    rot2[0] = cos(pitch1);    rot2[3] = 0;              rot2[6] = -sin(pitch1);
+    rot2[1] = 0;              rot2[4] = 1;              rot2[7] = 0;
+    rot2[2] = sin(pitch1);    rot2[5] = 0;              rot2[8] = cos(pitch1);
+
+    // Yaw and pitch rotations
+    multiply(rot3, rot1, 3, 3, rot2, 3);
+    multiply(temp, rot3, 3, 3, hand1, 2);
+    equate(hand1, temp, 3, 2);
+    multiply(temp, rot3, 3, 3, grip1, 2);
+    equate(grip1, temp, 3, 2);
+
+    // Unit vector along grip
+    w[0] = grip1[3];
+    w[1] = grip1[4];
+    w[2] = grip1[5];
+
+    w_hat[0] = 0;         w_hat[3] = -w[2];     w_hat[6] = w[1];
+    w_hat[1] = w[2];      w_hat[4] = 0;         w_hat[7] = -w[0];
+    w_hat[2] = -w[1];     w_hat[5] = w[0];      w_hat[8] = 0;
+
+    scalar_multiply(temp1, w_hat, 3, 3, sin(roll1));
+    multiply(temp2, w_hat, 3, 3, w_hat, 3);
+    scalar_multiply(temp3, temp2, 3, 3, 1 - cos(roll1));
+    matrix_add(temp2, temp1, temp3, 3, 3);
+    matrix_add(rot1, identity, temp2, 3, 3);
+
+    multiply(temp1, rot1, 3, 3, hand1, 2);
+    equate(hand1, temp1, 3, 2);
+
+    // The start orientation in the forearm frame
+    multiply(frame->hand1_fo, frame->rot_world_trans, 3, 3, hand1, 2);
+    multiply(frame->grip1_fo, frame->rot_world_trans, 3, 3, grip1, 2);
+
+    grip1_vect[0] = frame->grip1_fo[3];
+    grip1_vect[1] = frame->grip1_fo[4];
+    grip1_vect[2] = frame->grip1_fo[5];
+
+    temp_var = dot_product(grip1_vect, unit_x, 3);
+    scalar_multiply(comp1_vect, unit_x, 3, 1, temp_var);
+    subtract(project1_vect, grip1_vect, comp1_vect, 3, 1);
+
+    ind1_vect[0] = indicator1[3] - indicator1[0];
+    ind1_vect[1] = indicator1[4] - indicator1[1];
+    ind1_vect[2] = indicator1[5] - indicator1[2];
+
+    if (!check_equality(grip1_vect, comp1_vect, 3)) {
+        c_delta = dot_product(ind1_vect, project1_vect, 3) / vect_norm(project1_vect, 3);
+        fs_angle = acos(c_delta);
+
+        cross_product(temp_vect, ind1_vect, project1_vect);
+
+        if (vect_divide(temp_vect, unit_x, 3) < 0) {
+            fs_angle=-fs_angle;
+        }
+
+        rot1[0] = 1;    rot1[3] = 0;                rot1[6] = 0;
+        rot1[1] = 0;    rot1[4] = cos(fs_angle);    rot1[7] = -sin(fs_angle);
+        rot1[2] = 0;    rot1[5] = sin(fs_angle);    rot1[8] = cos(fs_angle);
+
+        multiply(temp, rot1, 3, 3, indicator1, 2);
+        equate(frame->indicator1_fo, temp, 3, 2);
+    }
+    else {
+        equate(frame->indicator1_fo, indicator1, 3, 2);
+    }
+}
+
+void RPYSolver::orientationSolver(
+    double* output,
+    const StartFrame& frame,
+    double yaw2, double pitch2, double roll2,
+    int attempt) const
 {
     ////////////////////////////////////////////////////////////////////////////
     // Is the desired orientation possible to attain with the given joint
@@ -98,15 +258,10 @@ void RPYSolver::orientationSolver(
     double wrist_pitch_limit_max = wrist_pitch_min_limit_;
     double wrist_pitch_limit_min = wrist_pitch_max_limit_;
 
-    // The PR2 FK is defined such that pitch is negative upward. Hence, the
-    // input pitch values are negated, because the following portion of the code
-    // was written assuming that pitch is positive upward.
-
-    theta = -theta;
-    pitch1 = -pitch1;
+    // pitch is positive upward below (see computeStartFrame)
     pitch2 = -pitch2;
 
-    double v1[] = { cos(theta) * cos(phi), cos(theta) * sin(phi), sin(theta) };
+    double v1[] = { frame.v1[0], frame.v1[1], frame.v1[2] };
     double v2[] = { cos(pitch2) * cos(yaw2), cos(pitch2) * sin(yaw2), sin(pitch2) };
     double dp_v = dot_product(v1, v2, 3);
     double check_flag = dp_v < 0;
@@ -126,78 +281,44 @@ void RPYSolver::orientationSolver(
     // Firstly, all variables are declared and some defined //
     //////////////////////////////////////////////////////////
 
-    double hand1[] = { 0, -0.5, 0, 0, 0.5, 0 };
     double hand2[] = { 0, -0.5, 0, 0, 0.5, 0 };
     double hand1_fo[6];
     double hand2_fo[6];
     double hand1_vect[3], hand2_vect[3];
-    double grip1[] = { 0, 0, 0, 1, 0, 0 };
     double grip2[] = { 0, 0, 0, 1, 0, 0 };
     double grip1_fo[6];
     double grip2_fo[6];
     double grip1_vect[3], grip2_vect[3];
-    double indicator1[] = { -2.5, 0, 0, -2.5, 0, 1 };
     double indicator2[] = { -2.5, 0, 0, -2.5, 0, 1 };
     double indicator1_fo[6];
     double indicator2_fo[6];
     double ind1_vect[3], ind2_vect[3];
-    double comp1_vect[3], comp2_vect[3], project1_vect[3], project2_vect[3];
+    double comp2_vect[3], project2_vect[3];
     double rot1[9], rot2[9], rot3[9];
     double temp[6], temp1[9], temp2[9], temp3[9], temp_var, temp_vect[3], temp2_vect[3];
     double w[3], w_hat[9];
-    double rot_world[9], rot_world_trans[9];
+    double rot_world_trans[9];
     double identity[] = { 1, 0, 0, 0, 1, 0, 0, 0, 1 };
     double unit_x[3] = { 1, 0, 0 };
     double zero_vect[3] = { 0, 0, 0 };
-    double fo_rm_roll, wrist_pitch, wrist_roll, fs_angle, fe_angle;
+    double fo_rm_roll, wrist_pitch, wrist_roll, fe_angle;
 
     // Flag returned indicates whether desired orientation is possible with
     // wrist limits. 1-possible, 0-impossible
     double is_orient_possible_flag = 1;
 
-    double c_alpha, c_beta, c_gamma, c_delta, c_eps;
+    double c_alpha, c_beta, c_gamma, c_eps;
 
     ///////////////////////////////////
     // Accepting the input arguments //
     ///////////////////////////////////
 
-    create_rotation_matrix(rot_world, phi, theta, psi);
-    transpose(rot_world_trans, rot_world, 3, 3);
-
-    // The start and the end orientations in the world frame
-    rot1[0] = cos(yaw1);      rot1[3] = -sin(yaw1);     rot1[6] = 0;
-    rot1[1] = sin(yaw1);      rot1[4] = cos(yaw1);      rot1[7] = 0;
-    rot1[2] = 0;              rot1[5] = 0;              rot1[8] = 1;
-
-    rot2[0] = cos(pitch1);    rot2[3] = 0;              rot2[6] = -sin(pitch1);
-    rot2[1] = 0;              rot2[4] = 1;              rot2[7] = 0;
-    rot2[2] = sin(pitch1);    rot2[5] = 0;              rot2[8] = cos(pitch1);
-
-    // Yaw and pitch rotations
-    multiply(rot3, rot1, 3, 3, rot2, 3);
-    multiply(temp, rot3, 3, 3, hand1, 2);
-    equate(hand1, temp, 3, 2);
-    multiply(temp, rot3, 3, 3, grip1, 2);
-    equate(grip1, temp, 3, 2);
-
-    // Unit vector along grip
-    w[0] = grip1[3];
-    w[1] = grip1[4];
-    w[2] = grip1[5];
-
-    w_hat[0] = 0;         w_hat[3] = -w[2];     w_hat[6] = w[1];
-    w_hat[1] = w[2];      w_hat[4] = 0;         w_hat[7] = -w[0];
-    w_hat[2] = -w[1];     w_hat[5] = w[0];      w_hat[8] = 0;
-
-    scalar_multiply(temp1, w_hat, 3, 3, sin(roll1));
-    multiply(temp2, w_hat, 3, 3, w_hat, 3);
-    scalar_multiply(temp3, temp2, 3, 3, 1 - cos(roll1));
-    matrix_add(temp2, temp1, temp3, 3, 3);
-    matrix_add(rot1, identity, temp2, 3, 3);
-
-    multiply(temp1, rot1, 3, 3, hand1, 2);
-    equate(hand1, temp1, 3, 2);
+    std::copy(frame.rot_world_trans, frame.rot_world_trans + 9, rot_world_trans);
+    std::copy(frame.hand1_fo, frame.hand1_fo + 6, hand1_fo);
+    std::copy(frame.grip1_fo, frame.grip1_fo + 6, grip1_fo);
+    std::copy(frame.indicator1_fo, frame.indicator1_fo + 6, indicator1_fo);
 
+    // The end orientation in the world frame
     rot1[0] = cos(yaw2);      rot1[3] = -sin(yaw2);     rot1[6] = 0;
     rot1[1] = sin(yaw2);      rot1[4] = cos(yaw2);      rot1[7] = 0;
     rot1[2] = 0;              rot1[5] = 0;              rot1[8] = 1;
@@ -231,20 +352,10 @@ void RPYSolver::orientationSolver(
     multiply(temp1, rot1, 3, 3, hand2, 2);
     equate(hand2, temp1, 3, 2);
 
-    // The start and the end orientations in the forearm frame
-    multiply(hand1_fo, rot_world_trans, 3, 3, hand1, 2);
+    // The end orientation in the forearm frame
     multiply(hand2_fo, rot_world_trans, 3, 3, hand2, 2);
-    multiply(grip1_fo, rot_world_trans, 3, 3, grip1, 2);
     multiply(grip2_fo, rot_world_trans, 3, 3, grip2, 2);
 
-    grip1_vect[0] = grip1_fo[3];
-    grip1_vect[1] = grip1_fo[4];
-    grip1_vect[2] = grip1_fo[5];
-
-    temp_var = dot_product(grip1_vect, unit_x, 3);
-    scalar_multiply(comp1_vect, unit_x, 3, 1, temp_var);
-    subtract(project1_vect, grip1_vect, comp1_vect, 3, 1);
-
     grip2_vect[0] = grip2_fo[3];
     grip2_vect[1] = grip2_fo[4];
     grip2_vect[2] = grip2_fo[5];
@@ -253,35 +364,10 @@ void RPYSolver::orientationSolver(
     scalar_multiply(comp2_vect, unit_x, 3, 1, temp_var);
     subtract(project2_vect, grip2_vect, comp2_vect, 3, 1);
 
-    ind1_vect[0] = indicator1[3] - indicator1[0];
-    ind1_vect[1] = indicator1[4] - indicator1[1];
-    ind1_vect[2] = indicator1[5] - indicator1[2];
-
     ind2_vect[0] = indicator2[3] - indicator2[0];
     ind2_vect[1] = indicator2[4] - indicator2[1];
     ind2_vect[2] = indicator2[5] - indicator2[2];
 
-    if (!check_equality(grip1_vect, comp1_vect, 3)) {
-        c_delta = dot_product(ind1_vect, project1_vect, 3) / vect_norm(project1_vect, 3);
-        fs_angle = acos(c_delta);
-
-        cross_product(temp_vect, ind1_vect, project1_vect);
-
-        if (vect_divide(temp_vect, unit_x, 3) < 0) {
-            fs_angle=-fs_angle;
-        }
-
-        rot1[0] = 1;    rot1[3] = 0;                rot1[6] = 0;
-        rot1[1] = 0;    rot1[4] = cos(fs_angle);    rot1[7] = -sin(fs_angle);
-        rot1[2] = 0;    rot1[5] = sin(fs_angle);    rot1[8] = cos(fs_angle);
-
-        multiply(temp, rot1, 3, 3, indicator1, 2);
-        equate(indicator1_fo, temp, 3, 2);
-    }
-    else {
-        equate(indicator1_fo, indicator1, 3, 2);
-    }
-
     if (!check_equality(grip2_vect, comp2_vect, 3)) {
         c_eps = dot_product(ind2_vect, project2_vect, 3) / vect_norm(project2_vect, 3);
         fe_angle = acos(c_eps);
@@ -54,7 +54,8 @@ bool PR2KDLRobotModel::init(
     }
 
     // PR2 Specific IK Solver
-    pr2_ik_solver_.reset(new pr2_arm_kinematics::PR2ArmIKSolver(m_urdf, base_link, tip_link, 0.02, 2));
+    pr2_ik_solver_.reset(new pr2_arm_kinematics::PR2ArmIKSolver(
+            m_urdf, base_link, tip_link, 0.02, PR2_FREE_ANGLE_INDEX));
     if (!pr2_ik_solver_->active_) {
         ROS_ERROR("The PR2 IK solver is NOT active.");
         return false;
@@ -115,36 +116,9 @@ bool PR2KDLRobotModel::computeIK(
     NormalizeAngles(this, &m_jnt_pos_in);
 
     if (option == ik_option::RESTRICT_XYZ && m_rpy_solver) {
-        for (auto i = 0; i < this->getPlanningJoints().size(); ++i) {
-            auto& var_name = this->getPlanningJoints()[i];
-            auto* var = GetVariable(this->robot_model, &var_name);
-            SetVariablePosition(&this->robot_state, var, start[i]);
-        }
-
-        auto* forearm_link = GetLink(this->robot_model, &m_forearm_roll_link_name);
-        auto* end_effector_link = GetLink(this->robot_model, &m_end_effector_link_name);
-        UpdateLinkTransform(&this->robot_state, forearm_link);
-        UpdateLinkTransform(&this->robot_state, end_effector_link);
-
-        auto* forearm_pose = GetLinkTransform(&this->robot_state, forearm_link);
-        auto* end_effector_pose = GetLinkTransform(&this->robot_state, end_effector_link);
-
-        KDL::Frame fpose;
-        KDL::Frame epose;
-        tf::transformEigenToKDL(*forearm_pose, fpose);
-        tf::transformEigenToKDL(*end_effector_pose, epose);
-
-        std::vector<double> vfpose(6, 0.0);
-        vfpose[0] = fpose.p.x();
-        vfpose[1] = fpose.p.y();
-        vfpose[2] = fpose.p.z();
-        fpose.M.GetRPY(vfpose[3], vfpose[4], vfpose[5]);
-
-        std::vector<double> vepose(6, 0.0);
-        vepose[0] = epose.p.x();
-        vepose[1] = epose.p.y();
-        vepose[2] = epose.p.z();
-        epose.M.GetRPY(vepose[3], vepose[4], vepose[5]);
+        std::vector<double> vfpose;
+        std::vector<double> vepose;
+        computeWristPoses(start, vfpose, vepose);
 
         std::vector<double> rpy(3, 0.0);
         frame_des.M.GetRPY(rpy[0], rpy[1], rpy[2]);
@@ -165,15 +139,20 @@ bool PR2KDLRobotModel::computeIK(
             return false;
         }
 
+        NormalizeAngles(this, &m_jnt_pos_out);
+
         solution.resize(start.size());
         for (size_t i = 0; i < solution.size(); ++i) {
             solution[i] = m_jnt_pos_out(i);
         }
+        return true;
     }
 
     return KDLRobotModel::computeIK(pose, start, solution, option);
 }
 
+/// Solve for the arm in closed form with the upper arm roll held at its value
+/// in \p start, without searching over the redundant joint.
 bool PR2KDLRobotModel::computeFastIK(
     const Eigen::Affine3d& pose,
     const RobotState& start,
@@ -194,6 +173,8 @@ bool PR2KDLRobotModel::computeFastIK(
         return false;
     }
 
+    NormalizeAngles(this, &m_jnt_pos_out);
+
     solution.resize(start.size());
     for (size_t i = 0; i < solution.size(); ++i) {
         solution[i] = m_jnt_pos_out(i);
@@ -202,4 +183,86 @@ bool PR2KDLRobotModel::computeFastIK(
     return true;
 }
 
+void PR2KDLRobotModel::computeWristPoses(
+    const RobotState& start,
+    std::vector<double>& forearm_pose,
+    std::vector<double>& end_effector_pose)
+{
+    for (auto i = 0; i < this->getPlanningJoints().size(); ++i) {
+        auto& var_name = this->getPlanningJoints()[i];
+        auto* var = GetVariable(this->robot_model, &var_name);
+        SetVariablePosition(&this->robot_state, var, start[i]);
+    }
+
+    auto* forearm_link = GetLink(this->robot_model, &m_forearm_roll_link_name);
+    auto* end_effector_link = GetLink(this->robot_model, &m_end_effector_link_name);
+    UpdateLinkTransform(&this->robot_state, forearm_link);
+    UpdateLinkTransform(&this->robot_state, end_effector_link);
+
+    auto* T_forearm = GetLinkTransform(&this->robot_state, forearm_link);
+    auto* T_end_effector = GetLinkTransform(&this->robot_state, end_effector_link);
+
+    KDL::Frame fpose;
+    KDL::Frame epose;
+    tf::transformEigenToKDL(*T_forearm, fpose);
+    tf::transformEigenToKDL(*T_end_effector, epose);
+
+    forearm_pose.resize(6);
+    forearm_pose[0] = fpose.p.x();
+    forearm_pose[1] = fpose.p.y();
+    forearm_pose[2] = fpose.p.z();
+    fpose.M.GetRPY(forearm_pose[3], forearm_pose[4], forearm_pose[5]);
+
+    end_effector_pose.resize(6);
+    end_effector_pose[0] = epose.p.x();
+    end_effector_pose[1] = epose.p.y();
+    end_effector_pose[2] = epose.p.z();
+    epose.M.GetRPY(end_effector_pose[3], end_effector_pose[4], end_effector_pose[5]);
+}
+
+/// Wrist-only (RESTRICT_XYZ) requests that share a seed are solved together by
+/// the RPY solver; other requests are solved one at a time.
+int PR2KDLRobotModel::computeIKBatch(
+    const Eigen::Affine3d* poses,
+    const RobotState* seeds,
+    int n,
+    RobotState* solutions,
+    ik_option::IkOption option)
+{
+    if (option != ik_option::RESTRICT_XYZ || !m_rpy_solver) {
+        return KDLRobotModel::computeIKBatch(poses, seeds, n, solutions, option);
+    }
+
+    auto T_kinematics_map =
+            GetLinkTransform(&this->robot_state, this->m_kinematics_link)->inverse();
+
+    std::vector<double> vfpose;
+    std::vector<double> vepose;
+    std::vector<double> rpys;
+    auto found = 0;
+    for (auto first = 0; first < n; ) {
+        auto last = first + 1;
+        while (last < n && seeds[last] == seeds[first]) {
+            ++last;
+        }
+
+        computeWristPoses(seeds[first], vfpose, vepose);
+
+        rpys.resize(3 * (last - first));
+        for (auto i = first; i < last; ++i) {
+            KDL::Frame frame_des;
+            tf::transformEigenToKDL(T_kinematics_map * poses[i], frame_des);
+            auto* rpy = &rpys[3 * (i - first)];
+            frame_des.M.GetRPY(rpy[0], rpy[1], rpy[2]);
+        }
+
+        found += m_rpy_solver->computeRPYOnlyBatch(
+                rpys.data(), last - first, seeds[first], vfpose, vepose, 1,
+                solutions + first);
+        first = last;
+    }
+
+    return found;
+}
+
 } // namespace smpl
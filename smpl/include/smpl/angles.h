@@ -34,6 +34,7 @@
 
 // standard includes
 #include <cmath>
+#include <cstddef>
 
 // system includes
 #include <Eigen/Core>
@@ -125,6 +126,75 @@ inline double unwind(double ai, double af)
     return af;
 }
 
+/// \name Batched Angle Functions
+///
+/// Variants of the above that operate on arrays of angles, such as the joint
+/// variables of a state. They are written without branches, so that compilers
+/// may vectorize them, and may differ from their scalar counterparts in the
+/// last bit, or in the sign of angles exactly at -pi or pi.
+///@{
+
+/// Normalize each of \p n angles into the range [-pi, pi].
+inline void normalize_angles(double* angles, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        angles[i] -= 2.0 * M_PI * std::nearbyint(angles[i] * (0.5 / M_PI));
+    }
+}
+
+/// Normalize each of \p n angles into the range [0, 2 * pi].
+inline void normalize_angles_positive(double* angles, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        angles[i] -= 2.0 * M_PI * std::floor(angles[i] * (0.5 / M_PI));
+    }
+}
+
+/// Compute the shortest signed difference between each of \p n pairs of
+/// angles. \p diffs may alias \p af or \p ai.
+inline void shortest_angle_diffs(
+    const double* af,
+    const double* ai,
+    double* diffs,
+    std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        auto d = af[i] - ai[i];
+        diffs[i] = d - 2.0 * M_PI * std::nearbyint(d * (0.5 / M_PI));
+    }
+}
+
+/// Compute the shortest distance between each of \p n pairs of angles.
+/// \p dists may alias \p af or \p ai.
+inline void shortest_angle_dists(
+    const double* af,
+    const double* ai,
+    double* dists,
+    std::size_t n)
+{
+    shortest_angle_diffs(af, ai, dists, n);
+    for (std::size_t i = 0; i < n; ++i) {
+        dists[i] = std::fabs(dists[i]);
+    }
+}
+
+/// Return whether each of \p n values lies within its limits. Unbounded
+/// values should be given infinite limits. NaN values are outside any limits.
+inline bool within_limits(
+    const double* values,
+    const double* min_limits,
+    const double* max_limits,
+    std::size_t n)
+{
+    int within = 1;
+    for (std::size_t i = 0; i < n; ++i) {
+        within &= (values[i] >= min_limits[i]) & (values[i] <= max_limits[i]);
+    }
+    return within != 0;
+}
+
+///@}
+
 template <typename T>
 void get_euler_zyx(const Eigen::Matrix<T, 3, 3>& rot, T& y, T& p, T& r)
 {
@@ -0,0 +1,142 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_ARENA_H
+#define SMPL_ARENA_H
+
+// standard includes
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace smpl {
+
+/// A chunked, monotonic allocator for objects that share a lifetime.
+///
+/// Memory is handed out sequentially from large blocks, so objects allocated
+/// one after another are contiguous in memory and individual allocations cost
+/// a pointer bump. Objects are never freed individually. Instead, reset()
+/// makes all memory available for reuse in constant time while keeping the
+/// blocks allocated, and release() returns the blocks to the system.
+///
+/// The arena does not run destructors. Owners of objects with non-trivial
+/// destructors must destroy them before calling reset() or release().
+///
+/// An optional capacity limit bounds the total size of the blocks the arena
+/// allocates. Allocations that would grow the arena past its limit throw
+/// std::bad_alloc from allocate() and return nullptr from tryAllocate().
+class Arena
+{
+public:
+
+    static const std::size_t DefaultBlockSize = 64 * 1024;
+
+    explicit Arena(std::size_t block_size = DefaultBlockSize);
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    Arena(Arena&& o);
+    Arena& operator=(Arena&& o);
+
+    /// Allocate uninitialized memory for an object of the given size and
+    /// alignment.
+    void* allocate(std::size_t size, std::size_t align = alignof(std::max_align_t));
+
+    /// Allocate uninitialized memory as with allocate(), or return nullptr if
+    /// the allocation would grow the arena past its capacity limit.
+    void* tryAllocate(std::size_t size, std::size_t align = alignof(std::max_align_t));
+
+    /// Construct an object of type T in memory allocated from the arena.
+    template <class T, class... Args>
+    T* construct(Args&&... args)
+    {
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    /// Construct an object of type T in memory allocated from the arena, or
+    /// return nullptr if the arena has reached its capacity limit.
+    template <class T, class... Args>
+    T* tryConstruct(Args&&... args)
+    {
+        void* p = tryAllocate(sizeof(T), alignof(T));
+        if (p == nullptr) {
+            return nullptr;
+        }
+        return new (p) T(std::forward<Args>(args)...);
+    }
+
+    /// Make all memory handed out by the arena available for reuse. All
+    /// pointers to objects allocated from the arena are invalidated.
+    void reset();
+
+    /// Reset the arena and free all of its blocks.
+    void release();
+
+    /// Total size, in bytes, of the blocks owned by the arena.
+    std::size_t capacity() const { return m_capacity; }
+
+    /// Number of bytes handed out since the last call to reset().
+    std::size_t used() const { return m_used; }
+
+    /// Limit the total size of the blocks owned by the arena, or remove the
+    /// limit if \p limit is 0. Blocks already allocated are kept.
+    void setCapacityLimit(std::size_t limit) { m_capacity_limit = limit; }
+    std::size_t capacityLimit() const { return m_capacity_limit; }
+
+private:
+
+    struct Block
+    {
+        char* data;
+        std::size_t size;
+    };
+
+    std::vector<Block> m_blocks;
+    std::size_t m_block_size;
+
+    // index of the block allocations are currently made from and the offset of
+    // the next free byte in that block
+    std::size_t m_curr;
+    std::size_t m_offset;
+
+    std::size_t m_capacity;
+    std::size_t m_used;
+
+    std::size_t m_capacity_limit;
+};
+
+} // namespace smpl
+
+#endif
@@ -34,25 +34,64 @@
 #define SMPL_BFS3D_H
 
 #include <stdio.h>
+#include <cstdint>
+#include <limits>
+#include <memory>
 #include <queue>
 #include <thread>
 #include <tuple>
 #include <iostream>
+#include <vector>
+
+#include <smpl/cancellation.h>
+#include <smpl/worker_pool.h>
 
 namespace smpl {
 
-class BFS_3D
+/// \brief Breadth-first search over a 3D grid of cells with 26-connectivity.
+///
+/// Distances are stored in cells of type Cell. Narrower unsigned cell types
+/// reduce memory and saturate at their largest distance (2 less than the type's
+/// maximum value), so a saturated distance underestimates the true distance.
+/// Distances are reported as int regardless of the cell type, with WALL and
+/// UNDISCOVERED as sentinels.
+template <typename Cell>
+class BasicBFS_3D
 {
 public:
 
     static const int WALL = 0x7FFFFFFF;
     static const int UNDISCOVERED = 0xFFFFFFFF;
 
-    BFS_3D(int length, int width, int height);
-    ~BFS_3D();
+    BasicBFS_3D(int length, int width, int height);
+    ~BasicBFS_3D();
 
     void getDimensions(int* length, int* width, int* height);
 
+    /// \brief Set the number of threads used to propagate distances.
+    ///
+    /// With more than one thread, the search expands its wavefront one
+    /// distance level at a time and splits each level among the threads.
+    /// getDistance() may still be called while the search is running.
+    void setThreadCount(int count);
+    int threadCount() const { return m_pool ? m_pool->numThreads() : 1; }
+
+    /// \brief Expand the search lazily, only as far as queries require.
+    ///
+    /// In lazy mode, run() only seeds the search with the start cells. Each
+    /// query for an undiscovered cell then resumes the search, in the calling
+    /// thread, until that cell has been discovered or no cells remain. Since
+    /// the BFS discovers cells in order of distance, the returned distances
+    /// are the same as those of a full search. Takes effect on the next run().
+    void setLazy(bool lazy);
+    bool lazy() const { return m_lazy; }
+
+    /// \brief Stop the background search early once a token expires.
+    ///
+    /// The unexpanded cells of a stopped search are kept, and queries resume
+    /// it as in lazy mode, so the returned distances are unaffected.
+    void setCancellationToken(const CancellationToken* token) { m_cancel = token; }
+
     void setWall(int x, int y, int z);
 
     // \brief Clear cells around a given cell until freespace is encountered.
@@ -72,6 +111,19 @@ public:
 
     void run_components(int gx, int gy, int gz);
 
+    /// \brief Update walls and repair the distances of the last search.
+    ///
+    /// Each list holds (x, y, z) cell coordinates, packed as in run(). Cells
+    /// in \p added become walls and cells in \p removed become free. Instead
+    /// of searching again from the start cells, only the distances of the
+    /// cells whose shortest path ran through a new wall, or that may be
+    /// shortened through a removed wall, are recomputed. The repair runs in
+    /// the calling thread and waits for a running search to finish first. If
+    /// no search has been run yet, the walls are only updated.
+    void updateWalls(
+        const std::vector<int>& added,
+        const std::vector<int>& removed);
+
     bool inBounds(int x, int y, int z) const;
 
     /// \brief Return the distance, in cells, to the nearest occupied cell.
@@ -87,6 +139,20 @@ public:
     /// from the region of the grid containing the start cell.
     bool isUndiscovered(int x, int y, int z) const;
 
+    /// \brief Copy out the distance grid, including its border of walls.
+    ///
+    /// This function is blocking if the BFS is running.
+    void copyDistances(std::vector<int>& distances) const;
+
+    /// \brief Replace the distance grid with one from copyDistances().
+    ///
+    /// The distances should come from a search over the same walls, e.g. an
+    /// earlier search for the same start cells. Waits for a running search to
+    /// finish first.
+    ///
+    /// \return false if the distances are for a grid of different size
+    bool restoreDistances(const std::vector<int>& distances);
+
     int getNearestFreeNodeDist(int x, int y, int z);
     bool isWall(int x, int y, int z) const;
 
@@ -96,6 +162,9 @@ public:
     int countUndiscovered() const;
     int countDiscovered() const;
 
+    /// Return the number of bytes held by the distance grid and search queues
+    auto memoryUsage() const -> std::size_t;
+
 private:
 
     std::thread m_search_thread;
@@ -103,16 +172,36 @@ private:
     int m_dim_x, m_dim_y, m_dim_z;
     int m_dim_xy, m_dim_xyz;
 
-    int volatile* m_distance_grid;
+    Cell volatile* m_distance_grid;
 
+    // allocated only while a search is in progress or resumable
     int* m_queue;
-    int m_queue_head, m_queue_tail;
+
+    // mutable to let queries resume a lazy search
+    mutable int m_queue_head, m_queue_tail;
 
     volatile bool m_running;
 
+    // whether the distance grid holds the result of a search
+    bool m_searched;
+
+    bool m_lazy;
+
+    const CancellationToken* m_cancel;
+
     int m_neighbor_offsets[26];
-    std::vector<bool> m_closed;
-    std::vector<int> m_distances;
+
+    // pool for expanding the cells of a level in parallel and the cells of the
+    // next level discovered by each of its threads
+    std::unique_ptr<WorkerPool> m_pool;
+    std::vector<std::vector<int>> m_next_cells;
+
+    static constexpr Cell WallCell();
+    static constexpr Cell UndiscoveredCell();
+    static constexpr Cell MaxCellDistance();
+    static Cell NextCellDistance(Cell c);
+    static int ToDistance(Cell c);
+    static Cell ToCell(int distance);
 
     int getNode(int x, int y, int z) const;
     bool getCoord(int node, int& x, int& y, int& z) const;
@@ -121,11 +210,12 @@ private:
     bool isWall(int node) const;
     int isUndiscovered(int node) const;
     int neighbor(int node, int neighbor) const;
+    int cellDistance(int node) const;
 
     void search(
         int width,
         int planeSize,
-        int volatile* distance_grid,
+        Cell volatile* distance_grid,
         int* queue,
         int& queue_head,
         int& queue_tail);
@@ -133,67 +223,93 @@ private:
     void search(
         int width,
         int planeSize,
-        int volatile* distance_grid,
+        Cell volatile* distance_grid,
         int* queue,
         int& queue_head,
         int& queue_tail,
-        int volatile* frontier_grid,
+        Cell volatile* frontier_grid,
         int* frontier_queue,
         int& frontier_queue_head,
         int& frontier_queue_tail);
 
+    void parallel_search(
+        Cell volatile* distance_grid,
+        int* queue,
+        int& queue_head,
+        int& queue_tail);
+
+    void start_search();
+    void reserve_queue();
+    void release_queue();
+    std::size_t queue_size() const
+    { return (std::size_t)(m_dim_x - 2) * (m_dim_y - 2) * (m_dim_z - 2); }
+    void rerun_from_start_cells();
+
+    // expand a lazy search until the node is discovered or to completion
+    void resume_search(int node) const;
+    void finish_search() const;
+    void expand_next() const;
+
     template <typename Visitor>
     void visit_free_cells(int node, const Visitor& visitor);
 };
 
-inline bool BFS_3D::inBounds(int x, int y, int z) const
+template <typename Cell>
+const int BasicBFS_3D<Cell>::WALL;
+
+template <typename Cell>
+const int BasicBFS_3D<Cell>::UNDISCOVERED;
+
+template <typename Cell>
+inline bool BasicBFS_3D<Cell>::inBounds(int x, int y, int z) const
 {
     return !(x < 0 || y < 0 || z < 0 ||
             x >= m_dim_x - 2 || y >= m_dim_y - 2 || z >= m_dim_z - 2);
 }
 
+template <typename Cell>
 template <typename InputIt>
-void BFS_3D::run(InputIt cells_begin, InputIt cells_end)
+void BasicBFS_3D<Cell>::run(InputIt cells_begin, InputIt cells_end)
 {
     if (m_running) {
         return;
     }
 
+    // reap the thread of the previous, completed search
+    if (m_search_thread.joinable()) {
+        m_search_thread.join();
+    }
+
     for (int i = 0; i < m_dim_xyz; i++) {
-        if (m_distance_grid[i] != WALL) {
-            m_distance_grid[i] = UNDISCOVERED;
+        if (m_distance_grid[i] != WallCell()) {
+            m_distance_grid[i] = UndiscoveredCell();
         }
     }
 
+    reserve_queue();
     m_queue_head = 0;
 
     // seed the search with all start cells
     int xyz[3];
     int ind = 0;
     int start_count = 0;
-    for (auto it = cells_begin; it != cells_end;) {
+    for (auto it = cells_begin; it != cells_end; ++it) {
+        xyz[ind++] = *it;
         if (ind == 3) {
             auto origin = getNode(xyz[0], xyz[1], xyz[2]);
             m_queue[start_count++] = origin;
             m_distance_grid[origin] = 0;
             ind = 0;
-        } else {
-            xyz[ind++] = *it++;
         }
     }
 
     m_queue_tail = start_count;
 
-    // fire off background thread to compute bfs
-    m_search_thread = std::thread([&]()
-    {
-        this->search(m_dim_x, m_dim_xy, m_distance_grid, m_queue, m_queue_head, m_queue_tail);
-    });
-
-    m_running = true;
+    start_search();
 }
 
-inline int BFS_3D::getNode(int x, int y, int z) const
+template <typename Cell>
+inline int BasicBFS_3D<Cell>::getNode(int x, int y, int z) const
 {
     if (!inBounds(x, y, z)) {
         return -1;
@@ -202,7 +318,8 @@ inline int BFS_3D::getNode(int x, int y, int z) const
     return (z + 1) * m_dim_xy + (y + 1) * m_dim_x + (x + 1);
 }
 
-inline bool BFS_3D::getCoord(int node, int& x, int& y, int& z) const
+template <typename Cell>
+inline bool BasicBFS_3D<Cell>::getCoord(int node, int& x, int& y, int& z) const
 {
     if (node < 0 || node >= m_dim_xyz) {
         return false;
@@ -217,31 +334,103 @@ inline bool BFS_3D::getCoord(int node, int& x, int& y, int& z) const
     return true;
 }
 
-inline void BFS_3D::setWall(int node)
+template <typename Cell>
+inline void BasicBFS_3D<Cell>::setWall(int node)
 {
-    m_distance_grid[node] = WALL;
+    m_distance_grid[node] = WallCell();
 }
 
-inline void BFS_3D::unsetWall(int node)
+template <typename Cell>
+inline void BasicBFS_3D<Cell>::unsetWall(int node)
 {
-    m_distance_grid[node] = UNDISCOVERED;
+    m_distance_grid[node] = UndiscoveredCell();
 }
 
-inline bool BFS_3D::isWall(int node) const
+template <typename Cell>
+inline bool BasicBFS_3D<Cell>::isWall(int node) const
 {
-    return m_distance_grid[node] == WALL;
+    return m_distance_grid[node] == WallCell();
 }
 
-inline int BFS_3D::isUndiscovered(int node) const
+template <typename Cell>
+inline int BasicBFS_3D<Cell>::isUndiscovered(int node) const
 {
-    return m_distance_grid[node] < 0;
+    return m_distance_grid[node] == UndiscoveredCell();
 }
 
-inline int BFS_3D::neighbor(int node, int neighbor) const
+template <typename Cell>
+inline int BasicBFS_3D<Cell>::neighbor(int node, int neighbor) const
 {
     return node + m_neighbor_offsets[neighbor];
 }
 
+template <typename Cell>
+inline int BasicBFS_3D<Cell>::cellDistance(int node) const
+{
+    return ToDistance(m_distance_grid[node]);
+}
+
+template <typename Cell>
+constexpr Cell BasicBFS_3D<Cell>::WallCell()
+{
+    return std::numeric_limits<Cell>::max();
+}
+
+template <typename Cell>
+constexpr Cell BasicBFS_3D<Cell>::UndiscoveredCell()
+{
+    return std::numeric_limits<Cell>::is_signed ?
+            Cell(-1) : Cell(std::numeric_limits<Cell>::max() - 1);
+}
+
+template <typename Cell>
+constexpr Cell BasicBFS_3D<Cell>::MaxCellDistance()
+{
+    return std::numeric_limits<Cell>::is_signed ?
+            Cell(std::numeric_limits<Cell>::max() - 1) :
+            Cell(std::numeric_limits<Cell>::max() - 2);
+}
+
+template <typename Cell>
+inline Cell BasicBFS_3D<Cell>::NextCellDistance(Cell c)
+{
+    return c < MaxCellDistance() ? Cell(c + 1) : c;
+}
+
+template <typename Cell>
+inline int BasicBFS_3D<Cell>::ToDistance(Cell c)
+{
+    if (c == WallCell()) {
+        return WALL;
+    } else if (c == UndiscoveredCell()) {
+        return UNDISCOVERED;
+    } else {
+        return (int)c;
+    }
+}
+
+template <typename Cell>
+inline Cell BasicBFS_3D<Cell>::ToCell(int distance)
+{
+    if (distance == WALL) {
+        return WallCell();
+    } else if (distance == UNDISCOVERED) {
+        return UndiscoveredCell();
+    } else if (distance > (int)MaxCellDistance()) {
+        return MaxCellDistance();
+    } else {
+        return (Cell)distance;
+    }
+}
+
+extern template class BasicBFS_3D<int>;
+extern template class BasicBFS_3D<std::uint16_t>;
+extern template class BasicBFS_3D<std::uint8_t>;
+
+using BFS_3D = BasicBFS_3D<int>;
+using BFS_3D16 = BasicBFS_3D<std::uint16_t>;
+using BFS_3D8 = BasicBFS_3D<std::uint8_t>;
+
 } // namespace smpl
 
 #endif
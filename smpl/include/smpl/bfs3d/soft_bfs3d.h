@@ -0,0 +1,189 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_SOFT_BFS3D_H
+#define SMPL_SOFT_BFS3D_H
+
+// standard includes
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// project includes
+#include <smpl/worker_pool.h>
+
+namespace smpl {
+
+/// \brief Dijkstra's search over a 3D grid of weighted cells with
+///     26-connectivity.
+///
+/// The soft-cost counterpart of BFS_3D: entering a free cell costs that cell's
+/// cost, an integer in [1, MaxCellCost], rather than one step. Since cell
+/// costs are small integers, open cells are kept in a bucket queue indexed by
+/// distance, and the cells of one distance are expanded together, split among
+/// the search threads.
+///
+/// After a search, cell costs may be changed with updateCellCosts(), which
+/// repairs the distances around the changed cells instead of searching again.
+class SoftBFS_3D
+{
+public:
+
+    static const int WALL = 0x7FFFFFFF;
+    static const int UNDISCOVERED = 0xFFFFFFFF;
+
+    static const int MaxCellCost = 255;
+
+    /// All cells are free, with a cost of 1, initially.
+    SoftBFS_3D(int length, int width, int height);
+
+    void getDimensions(int* length, int* width, int* height) const;
+
+    /// \brief Set the number of threads used to propagate distances.
+    void setThreadCount(int count);
+    int threadCount() const { return m_pool ? m_pool->numThreads() : 1; }
+
+    bool inBounds(int x, int y, int z) const;
+
+    /// \brief Set the cost of a cell, clamped to [1, MaxCellCost], or WALL.
+    ///
+    /// Takes effect on the next run(); see updateCellCosts() to change the
+    /// costs of a finished search.
+    void setCellCost(int x, int y, int z, int cost);
+    void setWall(int x, int y, int z) { setCellCost(x, y, z, WALL); }
+
+    /// \brief Return the cost of a cell, or WALL.
+    int getCellCost(int x, int y, int z) const;
+    bool isWall(int x, int y, int z) const;
+
+    /// \brief Run the search from a set of start cells, packed as (x, y, z)
+    ///     cell coordinates, at distance 0.
+    ///
+    /// The search runs to completion in the calling thread, with the help of
+    /// the search threads.
+    template <typename InputIt>
+    void run(InputIt cells_begin, InputIt cells_end);
+
+    void run(int x, int y, int z);
+
+    /// \brief Change the costs of cells and repair the distances of the last
+    ///     search.
+    ///
+    /// \p cells holds (x, y, z) cell coordinates, packed as in run(), and
+    /// \p costs the new cost of each cell, as for setCellCost(). The distances
+    /// of the cells whose shortest path ran through a more expensive cell are
+    /// cleared, and distances are then propagated from the border of the
+    /// cleared cells and from the cheaper cells, so only the region affected
+    /// by the change is searched. The repair runs in the calling thread. If no
+    /// search has been run yet, the costs are only updated.
+    void updateCellCosts(
+        const std::vector<int>& cells,
+        const std::vector<int>& costs);
+
+    /// \brief Return the sum of the costs of the cells along the cheapest path
+    ///     from a start cell, excluding the start cell, or WALL or
+    ///     UNDISCOVERED.
+    int getDistance(int x, int y, int z) const;
+
+    /// Return the number of bytes held by the cell costs and distances
+    auto memoryUsage() const -> std::size_t;
+
+private:
+
+    int m_dim_x, m_dim_y, m_dim_z;
+    int m_dim_xy, m_dim_xyz;
+
+    // cell costs, including a border of walls, with walls stored as 0
+    std::vector<std::uint8_t> m_costs;
+
+    // distances, with unreached cells at Unreached
+    std::vector<int> m_dist;
+
+    // start cells of the last search, sorted
+    std::vector<int> m_start_nodes;
+
+    // whether m_dist holds the result of a search
+    bool m_searched;
+
+    int m_neighbor_offsets[26];
+
+    std::unique_ptr<WorkerPool> m_pool;
+
+    // (node, distance) entries discovered by each search thread
+    std::vector<std::vector<std::pair<int, int>>> m_discovered;
+
+    static const int Unreached = 0x7FFFFFFF;
+
+    int getNode(int x, int y, int z) const;
+    bool isStart(int node) const;
+    bool isSupported(int node) const;
+    int bestNeighborDistance(int node) const;
+    void search(const std::vector<int>& start_nodes);
+};
+
+template <typename InputIt>
+void SoftBFS_3D::run(InputIt cells_begin, InputIt cells_end)
+{
+    std::vector<int> start_nodes;
+    int xyz[3];
+    int ind = 0;
+    for (auto it = cells_begin; it != cells_end; ++it) {
+        xyz[ind++] = *it;
+        if (ind == 3) {
+            auto node = getNode(xyz[0], xyz[1], xyz[2]);
+            if (node >= 0) {
+                start_nodes.push_back(node);
+            }
+            ind = 0;
+        }
+    }
+    search(start_nodes);
+}
+
+inline bool SoftBFS_3D::inBounds(int x, int y, int z) const
+{
+    return !(x < 0 || y < 0 || z < 0 ||
+            x >= m_dim_x - 2 || y >= m_dim_y - 2 || z >= m_dim_z - 2);
+}
+
+inline int SoftBFS_3D::getNode(int x, int y, int z) const
+{
+    if (!inBounds(x, y, z)) {
+        return -1;
+    }
+
+    return (z + 1) * m_dim_xy + (y + 1) * m_dim_x + (x + 1);
+}
+
+} // namespace smpl
+
+#endif
@@ -0,0 +1,141 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_CANCELLATION_H
+#define SMPL_CANCELLATION_H
+
+// standard includes
+#include <atomic>
+#include <cstddef>
+
+// project includes
+#include <smpl/extension.h>
+#include <smpl/time.h>
+
+namespace smpl {
+
+/// A request to stop work, shared by the components that carry out a planning
+/// request.
+///
+/// The token expires when cancel() is called, from any thread, or when its
+/// deadline passes. Long-running loops poll expired() and wind down, returning
+/// the best result found so far, soon after it does.
+class CancellationToken
+{
+public:
+
+    CancellationToken() : m_cancelled(false), m_deadline(NoDeadline()) { }
+
+    CancellationToken(const CancellationToken&) = delete;
+    CancellationToken& operator=(const CancellationToken&) = delete;
+
+    void cancel() { m_cancelled.store(true, std::memory_order_relaxed); }
+
+    bool cancelled() const { return m_cancelled.load(std::memory_order_relaxed); }
+
+    /// Set the absolute time at which the token expires
+    void setDeadline(const clock::time_point& deadline)
+    {
+        m_deadline.store(deadline.time_since_epoch().count(), std::memory_order_relaxed);
+    }
+
+    void clearDeadline() { m_deadline.store(NoDeadline(), std::memory_order_relaxed); }
+
+    auto deadline() const -> clock::time_point
+    {
+        return clock::time_point(clock::duration(
+                m_deadline.load(std::memory_order_relaxed)));
+    }
+
+    bool hasDeadline() const
+    {
+        return m_deadline.load(std::memory_order_relaxed) != NoDeadline();
+    }
+
+    bool expired() const
+    {
+        return cancelled() || (hasDeadline() && clock::now() >= deadline());
+    }
+
+    /// Return the time, in seconds, until the deadline, or 0 if the token has
+    /// expired. Without a deadline, \p unbounded is returned.
+    double remaining(double unbounded) const
+    {
+        if (cancelled()) {
+            return 0.0;
+        }
+        if (!hasDeadline()) {
+            return unbounded;
+        }
+        auto left = to_seconds(deadline() - clock::now());
+        return left > 0.0 ? left : 0.0;
+    }
+
+    /// Clear the cancellation and the deadline, for reuse by another request
+    void reset()
+    {
+        m_cancelled.store(false, std::memory_order_relaxed);
+        clearDeadline();
+    }
+
+private:
+
+    std::atomic<bool> m_cancelled;
+    std::atomic<clock::rep> m_deadline;
+
+    static constexpr clock::rep NoDeadline()
+    {
+        return clock::duration::max().count();
+    }
+};
+
+/// Return whether a token, which may be null, has expired
+inline bool Expired(const CancellationToken* token)
+{
+    return token != nullptr && token->expired();
+}
+
+/// Lets a planner component, such as a search, heuristic, or collision
+/// checker, stop its long-running work early when a cancellation token expires
+class CancellationExtension : public virtual Extension
+{
+public:
+
+    virtual ~CancellationExtension() { }
+
+    /// Set the token to poll, or stop polling if \p token is null. The token
+    /// must outlive its use by the component.
+    virtual void setCancellationToken(const CancellationToken* token) = 0;
+};
+
+} // namespace smpl
+
+#endif
@@ -34,6 +34,8 @@
 #define SMPL_COLLISION_CHECKER_H
 
 // standard includes
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -60,6 +62,30 @@ public:
     /// \return Whether the state is valid
     virtual bool isStateValid(const RobotState& state, bool verbose = false) = 0;
 
+    /// \brief Return whether a state, viewed without copying, is valid.
+    ///
+    /// The default implementation copies the state and calls the RobotState
+    /// overload. Implementations that read the joint variables directly should
+    /// override this.
+    virtual bool isStateValid(RobotStateView state, bool verbose = false);
+
+    /// \brief Return whether a sequence of states are all valid.
+    ///
+    /// The default implementation calls isStateValid for each state.
+    /// Implementations may override this to amortize per-state overhead over
+    /// the batch.
+    ///
+    /// \param[in] states The array of states to check
+    /// \param[in] n The number of states
+    /// \param[out] out If non-null, out[i] is set to whether states[i] is
+    ///     valid and every state is checked; otherwise checking stops at the
+    ///     first invalid state
+    /// \return Whether all states are valid
+    virtual bool areStatesValid(
+        const RobotState* states,
+        size_t n,
+        bool* out = nullptr);
+
     /// \brief Return whether the interpolated path between two points is valid.
     ///
     /// Need not include the endpoints.
@@ -109,6 +135,86 @@ public:
     virtual double distanceToCollision(
         const RobotState& start,
         const RobotState& finish) = 0;
+
+    /// Compute the obstacle cost of a state and its gradient with respect to
+    /// the planning variables.
+    ///
+    /// The cost penalizes each collision sphere, or other primitive, whose
+    /// distance d to the nearest obstacle falls below \p clearance, as in
+    /// CHOMP: (clearance - d)^2 / (2 * clearance) for 0 <= d < clearance and
+    /// clearance / 2 - d for d < 0. The default implementation is unsupported.
+    ///
+    /// \param[out] gradient The gradient of the cost, with one entry per
+    ///     planning variable
+    /// \return false if cost gradients are not supported
+    virtual bool collisionCostGradient(
+        const RobotState& state,
+        double clearance,
+        double& cost,
+        std::vector<double>& gradient);
+};
+
+/// Extension for collision checkers that can produce independent copies of
+/// themselves for use from multiple threads.
+///
+/// A clone must observe the same environment as the checker it was created from
+/// (changes to the world are visible to both), but must keep its own scratch
+/// state so that the original and all of its clones may be queried
+/// concurrently.
+class CollisionCheckerCloneExtension : public virtual Extension
+{
+public:
+
+    virtual ~CollisionCheckerCloneExtension() { }
+
+    virtual auto clone() -> std::unique_ptr<CollisionChecker> = 0;
+};
+
+/// \brief Extension for collision checkers that version their environment
+///
+/// The version must change whenever a change to the environment or the
+/// checker's configuration may change the result of a collision check, so that
+/// results computed against an older version may be detected as stale.
+class CollisionWorldVersionExtension : public virtual Extension
+{
+public:
+
+    virtual ~CollisionWorldVersionExtension() { }
+
+    virtual auto worldVersion() const -> std::uint64_t = 0;
+};
+
+/// \brief Extension for collision checkers that can certify that a valid
+///     motion remains valid as obstacles are added to the world
+///
+/// A motion is certified by its clearance c, a lower bound on the distance
+/// between the robot and the world obstacles at the configurations
+/// isStateToStateValid() checks along it. An obstacle added at a distance r
+/// from the obstacles already present can come no closer than c - r to the
+/// robot, by the triangle inequality, so the motion remains valid while c
+/// exceeds the growth of the world since it was certified.
+class CollisionClearanceExtension : public virtual Extension
+{
+public:
+
+    virtual ~CollisionClearanceExtension() { }
+
+    /// Return the clearance of a valid motion, or 0 if the motion can not be
+    /// certified.
+    virtual double motionClearance(
+        const RobotState& start,
+        const RobotState& finish) = 0;
+
+    /// Return the total growth of the world: the sum, over every update that
+    /// added obstacles, of an upper bound on the distance from an added
+    /// obstacle to the obstacles present before the update. Removing
+    /// obstacles does not contribute.
+    virtual double worldGrowth() const = 0;
+
+    /// Return a counter that changes whenever the world or the checker changes
+    /// in a way not bounded by worldGrowth(), which invalidates all
+    /// certificates.
+    virtual auto growthEpoch() const -> std::uint64_t = 0;
 };
 
 } // namespace smpl
@@ -45,9 +45,29 @@ public:
 
     bool parseStream(std::istream& is, bool has_header = false);
 
+    /// \name Numeric Mode
+    /// Parse a file whose records are all numbers directly into a buffer of
+    /// doubles, without storing each field as a string. The header, if
+    /// present, is still available via nameAt(). Records with the wrong number
+    /// of fields are skipped, as in parseStream(); a field that is not a
+    /// number fails the parse. Fields are only available via valueAt() and
+    /// record().
+    ///@{
+    bool parseNumericFile(const std::string& path, bool has_header = false);
+    bool parseNumeric(const char* begin, const char* end, bool has_header = false);
+
+    double valueAt(size_t ri, size_t fi) const;
+
+    /// Return a pointer to the fieldCount() values of a numeric record.
+    const double* record(size_t ri) const { return &m_values[ri * m_field_count]; }
+    ///@}
+
     size_t fieldCount() const { return m_field_count; }
 
     size_t recordCount() const {
+        if (m_numeric) {
+            return m_field_count != 0 ? m_values.size() / m_field_count : 0;
+        }
         if (m_has_header) {
             return m_fields.size() / m_field_count - 1;
         } else {
@@ -55,7 +75,12 @@ public:
         }
     }
 
-    size_t totalFieldCount() const { return m_fields.size() - m_field_count; }
+    size_t totalFieldCount() const {
+        if (m_numeric) {
+            return m_values.size();
+        }
+        return m_fields.size() - m_field_count;
+    }
 
     bool hasHeader() const { return m_has_header; }
     const std::string& nameAt(size_t ni) const;
@@ -64,12 +89,17 @@ public:
 
 private:
 
-    bool m_has_header;
-    size_t m_field_count;
+    bool m_has_header = false;
+    bool m_numeric = false;
+    size_t m_field_count = 0;
 
-    /// storage for all header names and fields
+    /// storage for all header names and fields; only the header names in
+    /// numeric mode
     std::vector<std::string> m_fields;
 
+    /// storage for all fields in numeric mode
+    std::vector<double> m_values;
+
     bool parseRecord(
         std::istream& s,
         std::istream::pos_type& pos,
@@ -0,0 +1,126 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_ASYNC_VISUALIZER_H
+#define SMPL_ASYNC_VISUALIZER_H
+
+// standard includes
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// project includes
+#include <smpl/debug/visualize.h>
+
+namespace smpl {
+namespace visual {
+
+/// A visualizer that hands markers to another visualizer on a background
+/// thread, so that publishing them does not block the thread that produced
+/// them.
+///
+/// Each level has its own bounded queue, so that a flood of debug markers
+/// cannot displace markers of higher levels. When a queue is full, either the
+/// oldest queued batch or the new batch is dropped. Higher levels are
+/// published first. The publish rate may be limited, in which case queued
+/// batches are dropped as they are displaced.
+class AsyncVisualizer : public VisualizerBase
+{
+public:
+
+    enum struct DropPolicy
+    {
+        DropOldest,
+        DropNewest
+    };
+
+    /// \param max_rate The maximum number of batches forwarded per second,
+    ///     or 0 for no limit
+    explicit AsyncVisualizer(
+        VisualizerBase* target,
+        std::size_t queue_size = 16,
+        DropPolicy policy = DropPolicy::DropOldest,
+        double max_rate = 0.0);
+
+    /// Publishes the queued markers before returning
+    ~AsyncVisualizer();
+
+    AsyncVisualizer(const AsyncVisualizer&) = delete;
+    AsyncVisualizer& operator=(const AsyncVisualizer&) = delete;
+
+    void visualize(Level level, const visual::Marker& marker) override;
+    void visualize(Level level, const std::vector<visual::Marker>& markers) override;
+#ifdef SMPL_HAS_VISUALIZATION_MSGS
+    void visualize(Level level, const visualization_msgs::Marker& marker) override;
+    void visualize(Level level, const visualization_msgs::MarkerArray& markers) override;
+#endif
+
+    /// Block until all markers queued so far have been published
+    void flush();
+
+    /// Number of batches dropped from full queues
+    auto dropped() const -> std::size_t;
+
+private:
+
+    struct Batch
+    {
+        std::vector<visual::Marker> markers;
+#ifdef SMPL_HAS_VISUALIZATION_MSGS
+        visualization_msgs::MarkerArray msgs;
+#endif
+    };
+
+    VisualizerBase* m_target;
+    std::size_t m_queue_size;
+    DropPolicy m_policy;
+    clock::duration m_min_period;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_queued;
+    std::condition_variable m_idle;
+    std::deque<Batch> m_queues[(int)Level::NumLevels];
+    bool m_publishing;
+    bool m_stop;
+    std::size_t m_dropped;
+
+    std::thread m_thread;
+
+    void push(Level level, Batch&& batch);
+    void run();
+};
+
+} // namespace visual
+} // namespace smpl
+
+#endif
@@ -178,17 +178,21 @@ namespace viz = visual;
         } \
     } while (0)
 
+// The clock is only read when the location is enabled, so that a throttled
+// location costs no more than any other while disabled
 #define SV_SHOW_THROTTLE(rate, level, name, markers) \
     do { \
         static ::smpl::clock::time_point last_hit; \
         static auto rate_dur = \
                 ::std::chrono::duration_cast<::smpl::clock::duration>( \
                         ::std::chrono::duration<double>(1.0 / (double)rate)); \
-        auto now = ::smpl::clock::now(); \
-        SV_SHOW_DEFINE_LOCATION(last_hit + rate_dur <= now, level, name); \
+        SV_SHOW_DEFINE_LOCATION(true, level, name); \
         if (__sv_define_location__enabled) { \
-            last_hit = now; \
-            ::smpl::visual::visualize(level, markers); \
+            auto now = ::smpl::clock::now(); \
+            if (last_hit + rate_dur <= now) { \
+                last_hit = now; \
+                ::smpl::visual::visualize(level, markers); \
+            } \
         } \
     } while (0)
 
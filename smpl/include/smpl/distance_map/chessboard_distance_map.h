@@ -29,6 +29,11 @@
 
 /// \author Andrew Dornbush
 
+// standard includes
+#include <cstddef>
+#include <vector>
+
+// project includes
 #include <smpl/distance_map/distance_map.h>
 
 namespace smpl {
@@ -46,11 +51,29 @@ public:
     DistanceMapInterface* clone() const override
     { return new ChessboardDistanceMap(*this); }
 
+    /// Set the number of threads used to recompute the distance map after a
+    /// large batch of obstacle insertions. Batches large enough that
+    /// incremental propagation would touch most of the grid are handled by
+    /// separable sweeps along each axis, which give the same distances as
+    /// propagation; with more than one thread, the lines of each sweep are
+    /// split into slabs and run concurrently.
+    void setThreadCount(int count) { m_thread_count = count < 1 ? 1 : count; }
+    int threadCount() const { return m_thread_count; }
+
+    void addPointsToMap(const std::vector<Vector3>& points) override;
+
     friend class DistanceMap<ChessboardDistanceMap>;
 
 private:
 
+    static const char* fileType() { return "chessboard"; }
+
+    int m_thread_count = 1;
+
     int distance(const Cell& n, const Cell& s);
+
+    bool preferFullTransform(std::size_t point_count) const;
+    void computeFullTransform();
 };
 
 } // namespace smpl
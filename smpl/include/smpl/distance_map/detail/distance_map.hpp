@@ -35,10 +35,15 @@
 #include "../distance_map.h"
 
 // standard includes
+#include <cassert>
 #include <cmath>
 #include <algorithm>
 #include <set>
 
+// project includes
+#include <smpl/console/console.h>
+#include <smpl/memory_usage.h>
+
 namespace smpl {
 
 #define VECTOR_BUCKET_LIST_INSERT(o, key) \
@@ -120,6 +125,7 @@ DistanceMap<Derived>::DistanceMap(
         size_x, size_y, size_z,
         resolution),
     m_cells(),
+    m_clearance(),
     m_max_dist(max_dist),
     m_inv_res(1.0 / resolution),
     m_dmax_int((int)std::ceil(m_max_dist * m_inv_res)),
@@ -145,6 +151,13 @@ DistanceMap<Derived>::DistanceMap(
         m_sqrt_table[i] = m_res * std::sqrt((double)i);
     }
 
+    // clearances are rounded down so that they never exceed the distance
+    m_clearance_table.resize(m_dmax_sqrd_int + 1, 0);
+    for (int i = 0; i < m_dmax_sqrd_int + 1; ++i) {
+        const double d = std::floor(m_sqrt_table[i] * m_inv_res + 1e-9);
+        m_clearance_table[i] = (std::uint8_t)std::min(d, 255.0);
+    }
+
     // init neighbors for forward propagation
     CreateNeighborUpdateList(m_neighbors, m_indices, m_neighbor_ranges);
 
@@ -164,6 +177,7 @@ DistanceMap<Derived>::DistanceMap(
 
     // initialize non-border free cells
     m_cells.resize(cell_count_x, cell_count_y, cell_count_z);
+    m_clearance.resize(cell_count_x, cell_count_y, cell_count_z);
     for (int x = 1; x < m_cells.xsize() - 1; ++x) {
     for (int y = 1; y < m_cells.ysize() - 1; ++y) {
     for (int z = 1; z < m_cells.zsize() - 1; ++z) {
@@ -178,12 +192,14 @@ DistanceMap<Derived>::DistanceMap(
 
     initBorderCells();
     propagateBorder();
+    updateClearances();
 }
 
 template <class Derived>
 DistanceMap<Derived>::DistanceMap(const DistanceMap& o) :
     DistanceMapInterface(o),
     m_cells(o.m_cells),
+    m_clearance(o.m_clearance),
     m_max_dist(o.m_max_dist),
     m_inv_res(o.m_inv_res),
     m_dmax_int(o.m_dmax_int),
@@ -195,6 +211,7 @@ DistanceMap<Derived>::DistanceMap(const DistanceMap& o) :
     m_neighbor_offsets(o.m_neighbor_offsets),
     m_neighbor_dirs(o.m_neighbor_dirs),
     m_sqrt_table(o.m_sqrt_table),
+    m_clearance_table(o.m_clearance_table),
     m_open(o.m_open),
     m_rem_stack(o.m_rem_stack)
 {
@@ -205,6 +222,7 @@ template <class Derived>
 DistanceMap<Derived>::DistanceMap(DistanceMap&& o) :
     DistanceMapInterface(std::move(o)),
     m_cells(std::move(o.m_cells)),
+    m_clearance(std::move(o.m_clearance)),
     m_max_dist(std::move(o.m_max_dist)),
     m_inv_res(std::move(o.m_inv_res)),
     m_dmax_int(std::move(o.m_dmax_int)),
@@ -216,6 +234,7 @@ DistanceMap<Derived>::DistanceMap(DistanceMap&& o) :
     m_neighbor_offsets(std::move(o.m_neighbor_offsets)),
     m_neighbor_dirs(std::move(o.m_neighbor_dirs)),
     m_sqrt_table(std::move(o.m_sqrt_table)),
+    m_clearance_table(std::move(o.m_clearance_table)),
     m_open(std::move(o.m_open)),
     m_rem_stack(std::move(o.m_rem_stack))
 {
@@ -227,6 +246,7 @@ auto DistanceMap<Derived>::operator=(const DistanceMap& rhs) -> DistanceMap&
     static_cast<DistanceMapInterface&>(*this) = rhs;
     if (this != &rhs) {
         m_cells = rhs.m_cells;
+        m_clearance = rhs.m_clearance;
         m_max_dist = rhs.m_max_dist;
         m_inv_res = rhs.m_inv_res;
         m_dmax_int = rhs.m_dmax_int;
@@ -238,6 +258,7 @@ auto DistanceMap<Derived>::operator=(const DistanceMap& rhs) -> DistanceMap&
         m_neighbor_offsets = rhs.m_neighbor_offsets;
         m_neighbor_dirs = rhs.m_neighbor_dirs;
         m_sqrt_table = rhs.m_sqrt_table;
+        m_clearance_table = rhs.m_clearance_table;
         m_open = rhs.m_open;
         m_rem_stack = rhs.m_rem_stack;
         rewire(rhs);
@@ -251,6 +272,7 @@ auto DistanceMap<Derived>::operator=(DistanceMap&& rhs) -> DistanceMap&
     static_cast<DistanceMapInterface&>(*this) = std::move(rhs);
     if (this != &rhs) {
         m_cells = std::move(rhs.m_cells);
+        m_clearance = std::move(rhs.m_clearance);
         m_max_dist = std::move(rhs.m_max_dist);
         m_inv_res = std::move(rhs.m_inv_res);
         m_dmax_int = std::move(rhs.m_dmax_int);
@@ -262,6 +284,7 @@ auto DistanceMap<Derived>::operator=(DistanceMap&& rhs) -> DistanceMap&
         m_neighbor_offsets = std::move(rhs.m_neighbor_offsets);
         m_neighbor_dirs = std::move(rhs.m_neighbor_dirs);
         m_sqrt_table = std::move(rhs.m_sqrt_table);
+        m_clearance_table = std::move(rhs.m_clearance_table);
         m_open = std::move(rhs.m_open);
         m_rem_stack = std::move(rhs.m_rem_stack);
     }
@@ -269,6 +292,17 @@ auto DistanceMap<Derived>::operator=(DistanceMap&& rhs) -> DistanceMap&
 }
 
 /// Return the distance value for an invalid cell.
+template <typename Derived>
+auto DistanceMap<Derived>::memoryUsage() const -> std::size_t
+{
+    return m_cells.size() * sizeof(Cell) +
+            m_clearance.size() * sizeof(std::uint8_t) +
+            MemoryUsage(m_sqrt_table) +
+            MemoryUsage(m_clearance_table) +
+            MemoryUsage(m_open) +
+            MemoryUsage(m_rem_stack);
+}
+
 template <typename Derived>
 double DistanceMap<Derived>::maxDistance() const
 {
@@ -355,6 +389,7 @@ void DistanceMap<Derived>::removePointsFromMap(
 
         c.dist = m_dmax_sqrd_int;
         c.dir = NO_UPDATE_DIR;
+        updateClearance(c);
         m_rem_stack.push_back(&c);
     }
 
@@ -415,6 +450,7 @@ void DistanceMap<Derived>::updatePointsInMap(
         c.dist_new = m_dmax_sqrd_int;
         c.dist = m_dmax_sqrd_int;
         c.obs = nullptr;
+        updateClearance(c);
         m_rem_stack.push_back(&c);
     }
 
@@ -451,6 +487,7 @@ void DistanceMap<Derived>::reset()
     initBorderCells();
 
     propagateBorder();
+    updateClearances();
 }
 
 /// Return the number of cells along the x axis.
@@ -492,6 +529,104 @@ double DistanceMap<Derived>::getCellDistance(int x, int y, int z) const
     return getDistance(x, y, z);
 }
 
+/// The points are processed in fixed-size blocks. The conversion to grid
+/// coordinates is done for a whole block at once, in a branch-free loop the
+/// compiler can vectorize, before gathering the distances of the cells.
+template <typename Derived>
+void DistanceMap<Derived>::getMetricSquaredDistances(
+    const double* x, const double* y, const double* z,
+    int count,
+    double* dists) const
+{
+    const int block_size = 8;
+
+    const double ox = m_origin_x - m_res;
+    const double oy = m_origin_y - m_res;
+    const double oz = m_origin_z - m_res;
+
+    // valid cells lie in [0, size - 2) along each axis
+    const unsigned int xmax = m_cells.xsize() - 2;
+    const unsigned int ymax = m_cells.ysize() - 2;
+    const unsigned int zmax = m_cells.zsize() - 2;
+
+    int gx[block_size], gy[block_size], gz[block_size];
+    for (int first = 0; first < count; first += block_size) {
+        const int n = std::min(block_size, count - first);
+
+        for (int i = 0; i < n; ++i) {
+            gx[i] = (int)(m_inv_res * (x[first + i] - ox) + 0.5) - 1;
+            gy[i] = (int)(m_inv_res * (y[first + i] - oy) + 0.5) - 1;
+            gz[i] = (int)(m_inv_res * (z[first + i] - oz) + 0.5) - 1;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            // same as isCellValid(), with one unsigned comparison per axis
+            if ((unsigned int)gx[i] < xmax &&
+                (unsigned int)gy[i] < ymax &&
+                (unsigned int)gz[i] < zmax)
+            {
+                int d2 = m_cells(gx[i] + 1, gy[i] + 1, gz[i] + 1).dist;
+                double d = m_sqrt_table[d2];
+                dists[first + i] = d * d;
+            } else {
+                dists[first + i] = 0.0;
+            }
+        }
+    }
+}
+
+/// Processed in blocks, as getMetricSquaredDistances(). The conversion is done
+/// in double precision so that the results match getMetricDistance().
+template <typename Derived>
+void DistanceMap<Derived>::getMetricDistances(
+    const float* xyz, std::size_t n, float* dists) const
+{
+    const std::size_t block_size = 8;
+
+    const double ox = m_origin_x - m_res;
+    const double oy = m_origin_y - m_res;
+    const double oz = m_origin_z - m_res;
+
+    int gxyz[3 * block_size];
+    for (std::size_t first = 0; first < n; first += block_size) {
+        const std::size_t count = std::min(block_size, n - first);
+
+        const float* p = xyz + 3 * first;
+        for (std::size_t i = 0; i < count; ++i) {
+            gxyz[3 * i + 0] = (int)(m_inv_res * (p[3 * i + 0] - ox) + 0.5) - 1;
+            gxyz[3 * i + 1] = (int)(m_inv_res * (p[3 * i + 1] - oy) + 0.5) - 1;
+            gxyz[3 * i + 2] = (int)(m_inv_res * (p[3 * i + 2] - oz) + 0.5) - 1;
+        }
+
+        getCellDistances(gxyz, count, dists + first);
+    }
+}
+
+template <typename Derived>
+void DistanceMap<Derived>::getCellDistances(
+    const int* xyz, std::size_t n, float* dists) const
+{
+    // valid cells lie in [0, size - 2) along each axis
+    const unsigned int xmax = m_cells.xsize() - 2;
+    const unsigned int ymax = m_cells.ysize() - 2;
+    const unsigned int zmax = m_cells.zsize() - 2;
+
+    for (std::size_t i = 0; i < n; ++i) {
+        const int x = xyz[3 * i + 0];
+        const int y = xyz[3 * i + 1];
+        const int z = xyz[3 * i + 2];
+        // same as isCellValid(), with one unsigned comparison per axis
+        if ((unsigned int)x < xmax &&
+            (unsigned int)y < ymax &&
+            (unsigned int)z < zmax)
+        {
+            dists[i] = (float)m_sqrt_table[m_cells(x + 1, y + 1, z + 1).dist];
+        } else {
+            dists[i] = 0.0f;
+        }
+    }
+}
+
 /// Return the point in world coordinates marking the center of the cell at the
 /// given effective grid coordinates.
 template <typename Derived>
@@ -525,6 +660,38 @@ bool DistanceMap<Derived>::isCellValid(int x, int y, int z) const
         z >= 0 && z < m_cells.zsize() - 2;
 }
 
+template <typename Derived>
+bool DistanceMap<Derived>::getView(DistanceMapView& view) const
+{
+    if (m_cells.xsize() < 3 || m_cells.ysize() < 3 || m_cells.zsize() < 3) {
+        return false;
+    }
+
+    auto dist_ptr = [&](int x, int y, int z) {
+        return reinterpret_cast<const char*>(&m_cells(x, y, z).dist);
+    };
+
+    // cell (0, 0, 0) is preceded by a layer of border cells along each axis
+    view.dist = dist_ptr(1, 1, 1);
+    view.stride_x = dist_ptr(2, 1, 1) - view.dist;
+    view.stride_y = dist_ptr(1, 2, 1) - view.dist;
+    view.stride_z = dist_ptr(1, 1, 2) - view.dist;
+    view.size_x = m_cells.xsize() - 2;
+    view.size_y = m_cells.ysize() - 2;
+    view.size_z = m_cells.zsize() - 2;
+    view.grid_origin_x = m_origin_x - m_res;
+    view.grid_origin_y = m_origin_y - m_res;
+    view.grid_origin_z = m_origin_z - m_res;
+    view.inv_res = m_inv_res;
+    view.sqrt_table = m_sqrt_table.data();
+    view.res = m_res;
+    view.clearance = &m_clearance(1, 1, 1);
+    view.clearance_stride_x = &m_clearance(2, 1, 1) - view.clearance;
+    view.clearance_stride_y = &m_clearance(1, 2, 1) - view.clearance;
+    view.clearance_stride_z = &m_clearance(1, 1, 2) - view.clearance;
+    return true;
+}
+
 template <typename Derived>
 void DistanceMap<Derived>::rewire(const DistanceMap& o)
 {
@@ -547,6 +714,115 @@ void DistanceMap<Derived>::rewire(const DistanceMap& o)
     }
 }
 
+/// Write the contents of the distance map to a binary snapshot that can later
+/// be restored with load() into a map of the same type and geometry.
+template <typename Derived>
+bool DistanceMap<Derived>::save(const std::string& path) const
+{
+    DistanceMapFileHeader header;
+    initFileHeader(header);
+
+    DistanceMapFileWriter writer;
+    if (!writer.open(path, header)) {
+        return false;
+    }
+
+    // all distances are settled between modifications, so the open list is
+    // empty and there is no bucket state to record
+    assert(m_rem_stack.empty());
+
+    std::vector<CellRecord> records(m_cells.zsize());
+    const Cell* cells = m_cells.data();
+    for (size_t i = 0; i < m_cells.size(); i += records.size()) {
+        for (size_t j = 0; j < records.size(); ++j) {
+            const Cell& c = cells[i + j];
+            CellRecord& r = records[j];
+            r.dist = c.dist;
+            r.dist_new = c.dist_new;
+            r.obs = c.obs ? (std::int32_t)(c.obs - cells) : -1;
+            r.dir = c.dir;
+        }
+        if (!writer.write(records.data(), records.size())) {
+            break;
+        }
+    }
+
+    return writer.close();
+}
+
+/// Restore the contents of the distance map from a snapshot written by save().
+/// The snapshot is memory-mapped and must have been written by a map of the
+/// same type, size, resolution, and maximum distance. On failure, the map is
+/// left unmodified.
+template <typename Derived>
+bool DistanceMap<Derived>::load(const std::string& path)
+{
+    DistanceMapFileReader reader;
+    if (!reader.open(path)) {
+        return false;
+    }
+
+    DistanceMapFileHeader expected;
+    initFileHeader(expected);
+    if (!CheckDistanceMapFileHeader(expected, reader.header())) {
+        return false;
+    }
+    if (reader.header().record_count != m_cells.size()) {
+        SMPL_ERROR("Distance map snapshot '%s' has %llu cells (expected %zu)", path.c_str(), (unsigned long long)reader.header().record_count, m_cells.size());
+        return false;
+    }
+
+    const CellRecord* records = static_cast<const CellRecord*>(reader.records());
+    Cell* cells = m_cells.data();
+    const std::int32_t cell_count = (std::int32_t)m_cells.size();
+    for (std::int32_t i = 0; i < cell_count; ++i) {
+        if (records[i].obs >= cell_count ||
+            records[i].dir < 0 || records[i].dir >= NUM_DIRECTIONS)
+        {
+            SMPL_ERROR("Distance map snapshot '%s' contains an invalid cell", path.c_str());
+            return false;
+        }
+    }
+
+    for (std::int32_t i = 0; i < cell_count; ++i) {
+        const CellRecord& r = records[i];
+        Cell& c = cells[i];
+        c.dist = r.dist;
+        c.dist_new = r.dist_new;
+#if SMPL_DMAP_RETURN_CHANGED_CELLS
+        c.dist_old = r.dist;
+#endif
+        c.obs = r.obs >= 0 ? cells + r.obs : nullptr;
+        c.bucket = -1;
+        c.dir = r.dir;
+    }
+
+    for (auto& bucket : m_open) {
+        bucket.clear();
+    }
+    m_rem_stack.clear();
+    m_bucket = (int)m_open.size();
+    updateClearances();
+    return true;
+}
+
+template <typename Derived>
+void DistanceMap<Derived>::initFileHeader(DistanceMapFileHeader& header) const
+{
+    InitDistanceMapFileHeader(header, Derived::fileType(), sizeof(CellRecord));
+    header.cell_count_x = m_cells.xsize();
+    header.cell_count_y = m_cells.ysize();
+    header.cell_count_z = m_cells.zsize();
+    header.origin[0] = m_origin_x;
+    header.origin[1] = m_origin_y;
+    header.origin[2] = m_origin_z;
+    header.size[0] = m_size_x;
+    header.size[1] = m_size_y;
+    header.size[2] = m_size_z;
+    header.resolution = m_res;
+    header.max_dist = m_max_dist;
+}
+
 template <typename Derived>
 void DistanceMap<Derived>::initBorderCells()
 {
@@ -690,6 +966,7 @@ void DistanceMap<Derived>::propagate()
 
             if (s->dist_new < s->dist) {
                 s->dist = s->dist_new;
+                updateClearance(*s);
 
                 // foreach n in adj(min)
                 lower(s);
@@ -703,6 +980,7 @@ void DistanceMap<Derived>::propagate()
             } else {
                 s->dist = m_dmax_sqrd_int;
                 s->dir = NO_UPDATE_DIR;
+                updateClearance(*s);
                 raise(s);
                 if (s->dist != s->dist_new) {
                     updateVertex(s);
@@ -750,6 +1028,7 @@ void DistanceMap<Derived>::propagateRemovals()
                     n->dist = m_dmax_sqrd_int;
                     n->obs = nullptr;
                     n->dir = NO_UPDATE_DIR;
+                    updateClearance(*n);
                     m_rem_stack.push_back(n);
                 }
             } else {
@@ -774,6 +1053,7 @@ void DistanceMap<Derived>::propagateBorder()
             {
                 assert(s->dist_new <= s->dist);
                 s->dist = s->dist_new;
+                updateClearance(*s);
 
                 // foreach n in adj(min)
                 lowerBounded(s);
@@ -803,6 +1083,24 @@ void DistanceMap<Derived>::resetCell(Cell& c) const
     c.dir = NO_UPDATE_DIR;
 }
 
+template <typename Derived>
+void DistanceMap<Derived>::updateClearance(const Cell& c)
+{
+    m_clearance.data()[&c - m_cells.data()] = m_clearance_table[c.dist];
+}
+
+/// Recompute the clearance of every cell, after a modification that bypasses
+/// the incremental updates.
+template <typename Derived>
+void DistanceMap<Derived>::updateClearances()
+{
+    const Cell* cells = m_cells.data();
+    std::uint8_t* clearance = m_clearance.data();
+    for (size_t i = 0; i < m_cells.size(); ++i) {
+        clearance[i] = m_clearance_table[cells[i].dist];
+    }
+}
+
 } // namespace smpl
 
 #endif
@@ -34,6 +34,10 @@
 
 // standard includes
 #include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
 #include <utility>
 
 // system includes
@@ -70,6 +74,94 @@ struct Eigen_Vector3i_compare
     }
 };
 
+/// Version of the binary distance map snapshot format. Increment whenever the
+/// layout of DistanceMapFileHeader or of any map's cell records changes.
+static const std::uint32_t DISTANCE_MAP_FILE_VERSION = 1;
+
+/// Fixed-size header at the start of a distance map snapshot. The header is
+/// followed immediately by record_count cell records of record_size bytes,
+/// whose layout is defined by the map type that wrote the snapshot. Values are
+/// stored in host byte order.
+struct DistanceMapFileHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t record_size;
+    char type[32];
+    std::int32_t cell_count_x;
+    std::int32_t cell_count_y;
+    std::int32_t cell_count_z;
+    std::int32_t reserved;
+    std::uint64_t record_count;
+    double origin[3];
+    double size[3];
+    double resolution;
+    double max_dist;
+};
+
+void InitDistanceMapFileHeader(
+    DistanceMapFileHeader& header,
+    const char* type,
+    std::size_t record_size);
+
+/// Check that the header read from a snapshot describes a map with the same
+/// type, record layout, and geometry as the expected header. Logs the first
+/// mismatch.
+bool CheckDistanceMapFileHeader(
+    const DistanceMapFileHeader& expected,
+    const DistanceMapFileHeader& actual);
+
+/// Streams a header and a sequence of cell records into a snapshot file. The
+/// record count in the header is patched on close().
+class DistanceMapFileWriter
+{
+public:
+
+    DistanceMapFileWriter() = default;
+    ~DistanceMapFileWriter();
+
+    DistanceMapFileWriter(const DistanceMapFileWriter&) = delete;
+    DistanceMapFileWriter& operator=(const DistanceMapFileWriter&) = delete;
+
+    bool open(const std::string& path, const DistanceMapFileHeader& header);
+    bool write(const void* records, std::size_t count);
+    bool close();
+
+private:
+
+    std::FILE* m_file = nullptr;
+    std::string m_path;
+    DistanceMapFileHeader m_header;
+    bool m_ok = false;
+};
+
+/// Read-only memory mapping of a snapshot file. The mapping is shared, so
+/// processes loading the same snapshot share its pages in the page cache.
+class DistanceMapFileReader
+{
+public:
+
+    DistanceMapFileReader() = default;
+    ~DistanceMapFileReader();
+
+    DistanceMapFileReader(const DistanceMapFileReader&) = delete;
+    DistanceMapFileReader& operator=(const DistanceMapFileReader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    auto header() const -> const DistanceMapFileHeader&
+    { return *static_cast<const DistanceMapFileHeader*>(m_data); }
+
+    const void* records() const
+    { return static_cast<const char*>(m_data) + sizeof(DistanceMapFileHeader); }
+
+private:
+
+    void* m_data = nullptr;
+    std::size_t m_size = 0;
+};
+
 } // namespace smpl
 
 #endif
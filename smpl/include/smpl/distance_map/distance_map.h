@@ -34,6 +34,8 @@
 
 // standard includes
 #include <array>
+#include <cstdint>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -89,9 +91,22 @@ public:
 
     double getUninitializedDistance() const override;
 
+    auto memoryUsage() const -> std::size_t override;
+
     double getMetricDistance(double x, double y, double z) const override;
     double getCellDistance(int x, int y, int z) const override;
 
+    void getMetricSquaredDistances(
+        const double* x, const double* y, const double* z,
+        int count,
+        double* dists) const override;
+
+    void getMetricDistances(
+        const float* xyz, std::size_t n, float* dists) const override;
+
+    void getCellDistances(
+        const int* xyz, std::size_t n, float* dists) const override;
+
     void gridToWorld(
         int x, int y, int z,
         double& world_x, double& world_y, double& world_z) const override;
@@ -101,6 +116,14 @@ public:
         int& x, int& y, int& z) const override;
 
     bool isCellValid(int x, int y, int z) const override;
+
+    bool getView(DistanceMapView& view) const override;
+    ///@}
+
+    /// \name Snapshots
+    ///@{
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
     ///@}
 
     friend Derived;
@@ -127,8 +150,23 @@ private:
 
     static constexpr int NO_UPDATE_DIR = dirnum(0, 0, 0);
 
+    // Snapshot record for each cell, including the border cells, in grid
+    // order. The nearest obstacle is stored as an index into the grid, or -1.
+    struct CellRecord
+    {
+        std::int32_t dist;
+        std::int32_t dist_new;
+        std::int32_t obs;
+        std::int32_t dir;
+    };
+
     Grid3<Cell> m_cells;
 
+    // Clearance of each cell, in cells, rounded down and saturated at 255,
+    // kept up to date with m_cells. Collision checks read this instead of the
+    // much larger cells when a lower bound on the distance is sufficient.
+    Grid3<std::uint8_t> m_clearance;
+
     double m_max_dist;
     double m_inv_res;
 
@@ -166,6 +204,9 @@ private:
 
     std::vector<double> m_sqrt_table;
 
+    // clearance value for each squared cell distance
+    std::vector<std::uint8_t> m_clearance_table;
+
     typedef std::vector<Cell*> bucket_type;
     typedef std::vector<bucket_type> bucket_list;
     bucket_list m_open;
@@ -190,6 +231,11 @@ private:
     void propagateBorder();
 
     void resetCell(Cell& c) const;
+
+    void updateClearance(const Cell& c);
+    void updateClearances();
+
+    void initFileHeader(DistanceMapFileHeader& header) const;
 };
 
 } // namespace smpl
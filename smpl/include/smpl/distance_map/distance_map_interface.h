@@ -33,6 +33,8 @@
 #define SMPL_DISTANCE_MAP_INTERFACE_H
 
 // standard includes
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 // system includes
@@ -44,6 +46,91 @@
 
 namespace smpl {
 
+/// A raw view of a distance map that stores the squared cell distances of its
+/// cells in a dense grid. Lookups through a view are the same as those made
+/// through DistanceMapInterface::getCellDistance() and
+/// DistanceMapInterface::getMetricDistance(), but may be inlined by the caller
+/// rather than made through a virtual call.
+///
+/// A view remains valid until its distance map is destroyed or assigned to.
+struct DistanceMapView
+{
+    // squared distance, in cells, of cell (0, 0, 0), and the byte offsets
+    // between adjacent cells along each axis
+    const char* dist;
+    std::ptrdiff_t stride_x;
+    std::ptrdiff_t stride_y;
+    std::ptrdiff_t stride_z;
+
+    int size_x;
+    int size_y;
+    int size_z;
+
+    // origin of cell (-1, -1, -1) and the inverse resolution, as used by
+    // worldToGrid()
+    double grid_origin_x;
+    double grid_origin_y;
+    double grid_origin_z;
+    double inv_res;
+
+    // metric distance for each squared cell distance
+    const double* sqrt_table;
+
+    // clearance, in cells, of cell (0, 0, 0), rounded down and saturated at
+    // 255, and the offsets between adjacent clearances along each axis
+    const std::uint8_t* clearance;
+    std::ptrdiff_t clearance_stride_x;
+    std::ptrdiff_t clearance_stride_y;
+    std::ptrdiff_t clearance_stride_z;
+    double res;
+
+    bool isCellValid(int x, int y, int z) const
+    {
+        return (unsigned int)x < (unsigned int)size_x &&
+                (unsigned int)y < (unsigned int)size_y &&
+                (unsigned int)z < (unsigned int)size_z;
+    }
+
+    void worldToGrid(double wx, double wy, double wz, int& x, int& y, int& z) const
+    {
+        x = (int)(inv_res * (wx - grid_origin_x) + 0.5) - 1;
+        y = (int)(inv_res * (wy - grid_origin_y) + 0.5) - 1;
+        z = (int)(inv_res * (wz - grid_origin_z) + 0.5) - 1;
+    }
+
+    double getCellDistance(int x, int y, int z) const
+    {
+        if (!isCellValid(x, y, z)) {
+            return 0.0;
+        }
+        const char* p = dist + x * stride_x + y * stride_y + z * stride_z;
+        return sqrt_table[*reinterpret_cast<const int*>(p)];
+    }
+
+    double getMetricDistance(double wx, double wy, double wz) const
+    {
+        int x, y, z;
+        worldToGrid(wx, wy, wz, x, y, z);
+        return getCellDistance(x, y, z);
+    }
+
+    /// Return a lower bound on getMetricDistance(), read from the quantized
+    /// clearances, which is exact to within one cell.
+    double getMetricClearance(double wx, double wy, double wz) const
+    {
+        int x, y, z;
+        worldToGrid(wx, wy, wz, x, y, z);
+        if (!isCellValid(x, y, z)) {
+            return 0.0;
+        }
+        const std::uint8_t* p = clearance +
+                x * clearance_stride_x +
+                y * clearance_stride_y +
+                z * clearance_stride_z;
+        return res * (double)*p;
+    }
+};
+
 /// Abstract base class for Distance Map implementations. This class specifies
 /// methods for returning distances to the nearest occupied cells, both in
 /// cell units and metric units.
@@ -102,6 +189,10 @@ public:
     virtual int numCellsZ() const = 0;
 
     virtual double getUninitializedDistance() const = 0;
+
+    /// Return the approximate number of bytes of memory held by the map, or 0
+    /// if unknown
+    virtual auto memoryUsage() const -> std::size_t { return 0; }
     ///@}
 
     /// \name Distance Lookups
@@ -114,6 +205,55 @@ public:
 
     virtual double getCellSquaredDistance(int x, int y, int z) const
     { double d = getCellDistance(x, y, z); return d * d; }
+
+    /// Compute getMetricSquaredDistance() for a batch of points, given as
+    /// separate arrays of coordinates.
+    virtual void getMetricSquaredDistances(
+        const double* x, const double* y, const double* z,
+        int count,
+        double* dists) const
+    {
+        for (int i = 0; i < count; ++i) {
+            dists[i] = getMetricSquaredDistance(x[i], y[i], z[i]);
+        }
+    }
+
+    /// Return the distance of a point, as by getMetricDistance(), and store
+    /// the gradient of the distance at the point in \p grad. The default
+    /// implementation takes central differences one cell to either side of
+    /// the point; the gradient is zero where the distance is flat, including
+    /// beyond the maximum distance.
+    virtual double getMetricDistanceGradient(
+        double x, double y, double z, Vector3& grad) const
+    {
+        const double h = 2.0 * m_res;
+        grad.x() = (getMetricDistance(x + m_res, y, z) - getMetricDistance(x - m_res, y, z)) / h;
+        grad.y() = (getMetricDistance(x, y + m_res, z) - getMetricDistance(x, y - m_res, z)) / h;
+        grad.z() = (getMetricDistance(x, y, z + m_res) - getMetricDistance(x, y, z - m_res)) / h;
+        return getMetricDistance(x, y, z);
+    }
+
+    /// Compute getMetricDistance() for a batch of \p n points, given as
+    /// consecutive (x, y, z) triples in \p xyz.
+    virtual void getMetricDistances(
+        const float* xyz, std::size_t n, float* dists) const
+    {
+        for (std::size_t i = 0; i < n; ++i) {
+            dists[i] = (float)getMetricDistance(
+                    xyz[3 * i + 0], xyz[3 * i + 1], xyz[3 * i + 2]);
+        }
+    }
+
+    /// Compute getCellDistance() for a batch of \p n cells, given as
+    /// consecutive (x, y, z) triples in \p xyz.
+    virtual void getCellDistances(
+        const int* xyz, std::size_t n, float* dists) const
+    {
+        for (std::size_t i = 0; i < n; ++i) {
+            dists[i] = (float)getCellDistance(
+                    xyz[3 * i + 0], xyz[3 * i + 1], xyz[3 * i + 2]);
+        }
+    }
     ///@}
 
     /// \name Conversions Between Cell and Metric Coordinates
@@ -129,6 +269,12 @@ public:
     virtual bool isCellValid(int x, int y, int z) const = 0;
     ///@}
 
+    /// Fill in a raw view of the map, if it is stored as a dense grid of
+    /// squared cell distances.
+    ///
+    /// \return false if the map does not support raw views
+    virtual bool getView(DistanceMapView& view) const { return false; }
+
 protected:
 
     double m_origin_x;
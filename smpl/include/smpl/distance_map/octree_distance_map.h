@@ -0,0 +1,147 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_OCTREE_DISTANCE_MAP_H
+#define SMPL_OCTREE_DISTANCE_MAP_H
+
+// standard includes
+#include <cstdint>
+#include <vector>
+
+// project includes
+#include <smpl/distance_map/distance_map_interface.h>
+#include <smpl/octree/octree.h>
+#include <smpl/spatial.h>
+
+namespace smpl {
+
+/// A distance map that stores only the occupancy of its cells, in an octree,
+/// and computes distances on demand by a nearest-neighbor search of the tree.
+///
+/// Each node stores the number of occupied cells beneath it. Nodes that are
+/// entirely free or entirely occupied are collapsed into leaves, so memory is
+/// proportional to the surface area of the obstacles rather than to the volume
+/// of the map, and a distance query skips a free region of any size with a
+/// single test. Queries are exact Euclidean distances between cell centers,
+/// up to the maximum distance, which is returned for cells farther from any
+/// obstacle. Insertion and removal are O(log n) per cell, with no propagation.
+///
+/// This map suits large, sparse worlds, such as a CollisionSpace over a whole
+/// building, where a dense map would not fit in memory. Note that a
+/// reference-counted OccupancyGrid keeps a dense count for every cell, so the
+/// grid wrapping this map should not be reference counted in that case.
+class OcTreeDistanceMap : public DistanceMapInterface
+{
+public:
+
+    OcTreeDistanceMap(
+        double origin_x, double origin_y, double origin_z,
+        double size_x, double size_y, double size_z,
+        double resolution,
+        double max_dist);
+
+    double maxDistance() const;
+
+    double getDistance(double x, double y, double z) const;
+    double getDistance(int x, int y, int z) const;
+
+    bool isOccupied(int x, int y, int z) const;
+
+    /// \name Required Functions from DistanceMapInterface
+    ///@{
+    DistanceMapInterface* clone() const override;
+
+    void addPointsToMap(const std::vector<Vector3>& points) override;
+    void removePointsFromMap(const std::vector<Vector3>& points) override;
+    void updatePointsInMap(
+        const std::vector<Vector3>& old_points,
+        const std::vector<Vector3>& new_points) override;
+
+    void reset() override;
+
+    int numCellsX() const override;
+    int numCellsY() const override;
+    int numCellsZ() const override;
+
+    double getUninitializedDistance() const override;
+
+    auto memoryUsage() const -> std::size_t override { return m_tree.mem_usage(); }
+
+    double getMetricDistance(double x, double y, double z) const override;
+    double getCellDistance(int x, int y, int z) const override;
+
+    double getMetricSquaredDistance(double x, double y, double z) const override;
+    double getCellSquaredDistance(int x, int y, int z) const override;
+
+    void gridToWorld(
+        int x, int y, int z,
+        double& world_x, double& world_y, double& world_z) const override;
+
+    void worldToGrid(
+        double world_x, double world_y, double world_z,
+        int& x, int& y, int& z) const override;
+
+    bool isCellValid(int x, int y, int z) const override;
+    ///@}
+
+private:
+
+    using Tree = OcTree<std::uint32_t>;
+    using Node = Tree::node_type;
+
+    // the number of occupied cells beneath each node
+    Tree m_tree;
+
+    // the tree covers a cube of 2^depth cells along each axis
+    int m_depth;
+
+    int m_cell_count_x;
+    int m_cell_count_y;
+    int m_cell_count_z;
+
+    double m_max_dist;
+    double m_inv_res;
+
+    // max distance in cells, squared, plus one
+    int m_dmax_sqrd_int;
+
+    std::vector<Node*> m_path;
+
+    bool addCell(int x, int y, int z);
+    bool removeCell(int x, int y, int z);
+
+    int nearestSquaredDistance(int x, int y, int z) const;
+};
+
+} // namespace smpl
+
+#endif
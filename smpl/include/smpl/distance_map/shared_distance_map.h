@@ -0,0 +1,236 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_SHARED_DISTANCE_MAP_H
+#define SMPL_SHARED_DISTANCE_MAP_H
+
+// standard includes
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// project includes
+#include <smpl/distance_map/distance_map_interface.h>
+
+namespace smpl {
+
+#define SHARED_DISTANCE_MAP_MAGIC "SMPLDMAP"
+#define SHARED_DISTANCE_MAP_VERSION 1
+
+/// Fixed-size header at the start of a shared distance map. The header is
+/// followed by two copies of the metric distances of the cells, each a
+/// float[cell_count_x * cell_count_y * cell_count_z] with x varying fastest.
+///
+/// The copies are kept consistent with a latched sequence counter. The
+/// publisher increments the sequence before rewriting each copy, and readers
+/// read the copy selected by the low bit of the sequence, retrying if the
+/// sequence changed while they read. Readers never wait for a whole update to
+/// finish, and every completed read sees the distances of a single update.
+struct SharedDistanceMapHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::int32_t cell_count_x;
+    std::int32_t cell_count_y;
+    std::int32_t cell_count_z;
+    double origin_x;
+    double origin_y;
+    double origin_z;
+    double size_x;
+    double size_y;
+    double size_z;
+    double resolution;
+    double uninitialized_distance;
+
+    // twice the number of completed updates, plus one while an update is
+    // rewriting the first copy
+    std::atomic<std::uint64_t> sequence;
+};
+
+/// \brief Publishes the distances of a distance map as a POSIX shared memory
+///     object, to be attached by other processes as a SharedDistanceMap.
+///
+/// A single process, e.g. the one receiving perception updates, maintains the
+/// distance map and publishes it after each update; planner processes on the
+/// same host attach the object instead of voxelizing and propagating the same
+/// world themselves.
+class SharedDistanceMapPublisher
+{
+public:
+
+    SharedDistanceMapPublisher() = default;
+    ~SharedDistanceMapPublisher();
+
+    SharedDistanceMapPublisher(const SharedDistanceMapPublisher&) = delete;
+    SharedDistanceMapPublisher& operator=(const SharedDistanceMapPublisher&) = delete;
+
+    /// Create the shared memory object name (e.g. "/smpl_world"), with the
+    /// geometry of \p map, replacing any previous object of that name, and
+    /// publish the distances of \p map. Processes attached to a replaced
+    /// object keep reading its last distances until they attach again.
+    bool create(const std::string& name, const DistanceMapInterface& map);
+
+    /// Stop publishing. The object remains attachable until it is removed
+    /// with UnpublishSharedDistanceMap().
+    void close();
+
+    bool isOpen() const { return m_data != nullptr; }
+
+    /// Publish the distances of \p map, which must have the geometry the
+    /// object was created with.
+    bool publish(const DistanceMapInterface& map);
+
+    /// Return the number of updates published.
+    auto version() const -> std::uint64_t;
+
+private:
+
+    void* m_data = nullptr;
+    std::size_t m_size = 0;
+    SharedDistanceMapHeader* m_header = nullptr;
+    float* m_cells = nullptr;
+};
+
+/// Remove the name of a shared distance map. The memory is released once
+/// the publisher and every attached process have closed it.
+bool UnpublishSharedDistanceMap(const std::string& name);
+
+/// \brief A read-only distance map attached to a SharedDistanceMapPublisher in
+///     another process.
+///
+/// Lookups see the most recently published distances. Each lookup, including
+/// each batch lookup, sees the distances of a single update; separate lookups
+/// may see different updates, which version() allows to be detected.
+///
+/// The modifiers have no effect: the world is modified through the map of the
+/// publishing process. This includes the voxels of robot links outside the
+/// planning group, which a collision space inserts into its grid, so the
+/// publisher's map must contain them if they are to be checked against. Raw
+/// views are not supported, since the distances may change under them.
+class SharedDistanceMap : public DistanceMapInterface
+{
+public:
+
+    ~SharedDistanceMap();
+
+    /// Return the number of updates published, as of this call.
+    auto version() const -> std::uint64_t;
+
+    /// \name Required Functions from DistanceMapInterface
+    ///@{
+    DistanceMapInterface* clone() const override;
+
+    void addPointsToMap(const std::vector<Vector3>& points) override;
+    void removePointsFromMap(const std::vector<Vector3>& points) override;
+    void updatePointsInMap(
+        const std::vector<Vector3>& old_points,
+        const std::vector<Vector3>& new_points) override;
+
+    void reset() override;
+
+    int numCellsX() const override;
+    int numCellsY() const override;
+    int numCellsZ() const override;
+
+    double getUninitializedDistance() const override;
+
+    auto memoryUsage() const -> std::size_t override;
+
+    double getMetricDistance(double x, double y, double z) const override;
+    double getCellDistance(int x, int y, int z) const override;
+
+    void getMetricSquaredDistances(
+        const double* x, const double* y, const double* z,
+        int count,
+        double* dists) const override;
+
+    void getMetricDistances(
+        const float* xyz, std::size_t n, float* dists) const override;
+
+    void getCellDistances(
+        const int* xyz, std::size_t n, float* dists) const override;
+
+    void gridToWorld(
+        int x, int y, int z,
+        double& world_x, double& world_y, double& world_z) const override;
+
+    void worldToGrid(
+        double world_x, double world_y, double world_z,
+        int& x, int& y, int& z) const override;
+
+    bool isCellValid(int x, int y, int z) const override;
+    ///@}
+
+private:
+
+    // unmapped once the map and all of its clones are destroyed
+    struct Mapping
+    {
+        void* data;
+        std::size_t size;
+        ~Mapping();
+    };
+
+    std::shared_ptr<Mapping> m_mapping;
+    const SharedDistanceMapHeader* m_header;
+    const float* m_cells;
+    std::size_t m_cell_count;
+    int m_cell_count_x;
+    int m_cell_count_y;
+    int m_cell_count_z;
+    double m_inv_res;
+
+    SharedDistanceMap(const std::shared_ptr<Mapping>& mapping);
+
+    auto cellIndex(int x, int y, int z) const -> std::size_t
+    {
+        return ((std::size_t)z * m_cell_count_y + y) * m_cell_count_x + x;
+    }
+
+    auto beginRead(std::uint64_t& sequence) const -> const float*;
+    bool endRead(std::uint64_t sequence) const;
+
+    friend auto AttachSharedDistanceMap(const std::string& name)
+        -> std::unique_ptr<SharedDistanceMap>;
+};
+
+/// Attach, read-only, the shared distance map published under name.
+///
+/// \return The attached map, or null if no valid map is published under name
+auto AttachSharedDistanceMap(const std::string& name)
+    -> std::unique_ptr<SharedDistanceMap>;
+
+} // namespace smpl
+
+#endif
@@ -34,6 +34,8 @@
 
 // standard includes
 #include <array>
+#include <cstdint>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -42,19 +44,29 @@
 #include <Eigen/StdVector>
 
 // project includes
-#include <smpl/grid/sparse_grid.h>
+#include <smpl/grid/brick_grid.h>
 #include <smpl/distance_map/distance_map_interface.h>
 #include <smpl/spatial.h>
 #include "detail/distance_map_common.h"
 
 namespace smpl {
 
+/// A distance map whose cells are stored in dense 8x8x8 bricks that are only
+/// allocated within the propagation distance of an obstacle. Cells in
+/// unallocated bricks implicitly have the maximum distance, so memory is
+/// proportional to the volume near obstacles rather than to the size of the
+/// map. Bricks left without any obstacle references after a removal are
+/// released.
 class SparseDistanceMap : public DistanceMapInterface
 {
 public:
 
+    // Cells refer to their nearest obstacle cells by coordinate rather than by
+    // address, so that bricks may be shared between copies of the map and
+    // duplicated independently when modified.
     struct Cell
     {
+        // coordinates of the nearest obstacle cell, or -1 if unknown
         int ox;
         int oy;
         int oz;
@@ -64,18 +76,22 @@ public:
 #if SMPL_DMAP_RETURN_CHANGED_CELLS
         int dist_old;
 #endif
-        Cell* obs;
         int bucket;
         int dir;
 
         int pos;
 
-        // NOTE: vacuous true here for interoperability with SparseGrid::prune.
+        // NOTE: vacuous true here for interoperability with BrickGrid::prune.
         // This shouldn't be used to do unconditional pruning, but should be
         // used in conjunction with conditional pruning to remove cells with
         // unknown nearest obstacles, and which must not be referred to by any
         // other cell as its nearest obstacle.
         bool operator==(const Cell& rhs) const { return true; }
+
+        bool hasObstacle() const { return ox >= 0; }
+
+        bool isObstacle(int x, int y, int z) const
+        { return ox == x && oy == y && oz == z; }
     };
 
     SparseDistanceMap(
@@ -84,6 +100,12 @@ public:
         double resolution,
         double max_dist);
 
+    SparseDistanceMap(const SparseDistanceMap& o);
+    SparseDistanceMap(SparseDistanceMap&& o) = default;
+
+    auto operator=(const SparseDistanceMap& rhs) -> SparseDistanceMap&;
+    auto operator=(SparseDistanceMap&& rhs) -> SparseDistanceMap& = default;
+
     double maxDistance() const;
 
     double getDistance(double x, double y, double z) const;
@@ -109,6 +131,8 @@ public:
 
     double getUninitializedDistance() const override;
 
+    auto memoryUsage() const -> std::size_t override;
+
     double getMetricDistance(double x, double y, double z) const override;
     double getCellDistance(int x, int y, int z) const override;
 
@@ -126,14 +150,35 @@ public:
     bool isCellValid(int x, int y, int z) const override;
     ///@}
 
+    /// \name Snapshots
+    ///@{
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+    ///@}
+
     double resolution() const { return 1.0 / m_inv_res; }
-    auto cells() -> SparseGrid<Cell>& { return m_cells; }
+    auto cells() -> BrickGrid<Cell>& { return m_cells; }
 
 public:
 
     static constexpr int NO_UPDATE_DIR = dirnum(0, 0, 0);
 
-    SparseGrid<Cell> m_cells;
+    // Snapshot record for each cell that has a nearest obstacle. All other
+    // cells have the uninitialized value.
+    struct CellRecord
+    {
+        std::int32_t x;
+        std::int32_t y;
+        std::int32_t z;
+        std::int32_t dist;
+        std::int32_t dist_new;
+        std::int32_t ox;
+        std::int32_t oy;
+        std::int32_t oz;
+        std::int32_t dir;
+    };
+
+    BrickGrid<Cell> m_cells;
 
     int m_cell_count_x;
     int m_cell_count_y;
@@ -171,6 +216,10 @@ public:
     // index
     std::array<int, NEIGHBOR_LIST_SIZE> m_neighbor_dirs;
 
+    // Map from a (source, target) update direction pair to the offset of the
+    // target cell from a source cell in the interior of a brick
+    std::array<int, NEIGHBOR_LIST_SIZE> m_brick_neighbor_offsets;
+
     std::vector<double> m_sqrt_table;
 
     struct bucket_element
@@ -207,6 +256,7 @@ public:
     /// DistanceMap
     ///@{
     int distance(int nx, int ny, int nz, const Cell& s);
+    bool nearestObstacleValid(const Cell& c) const;
 
     void lower(Cell* s, int sx, int sy, int sz);
     void raise(Cell* s, int sx, int sy, int sz);
@@ -218,6 +268,10 @@ public:
     void propagateBorder();
     ///@}
 
+    void rewire();
+
+    void initFileHeader(DistanceMapFileHeader& header) const;
+
     double getTrueMetricSquaredDistance(double x, double y, double z) const;
     double getInterpMetricSquaredDistance(double x, double y, double z) const;
 };
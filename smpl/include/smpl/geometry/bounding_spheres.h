@@ -85,6 +85,46 @@ void ComputeMeshBoundingSpheres(
     std::vector<Vector3>& centers,
     std::vector<std::uint32_t>& triangle_indices);
 
+void ComputeBoxCoveringSpheres(
+    double length, double width, double height,
+    double max_overshoot,
+    std::vector<Vector3>& centers,
+    std::vector<double>& radii);
+
+void ComputeSphereCoveringSpheres(
+    double cradius,
+    double max_overshoot,
+    std::vector<Vector3>& centers,
+    std::vector<double>& radii);
+
+void ComputeCylinderCoveringSpheres(
+    double cradius, double cheight,
+    double max_overshoot,
+    std::vector<Vector3>& centers,
+    std::vector<double>& radii);
+
+void ComputeConeCoveringSpheres(
+    double cradius, double cheight,
+    double max_overshoot,
+    std::vector<Vector3>& centers,
+    std::vector<double>& radii);
+
+void ComputeMeshCoveringSpheres(
+    const std::vector<Vector3>& vertices,
+    const std::vector<std::uint32_t>& indices,
+    double max_overshoot,
+    std::vector<Vector3>& centers,
+    std::vector<double>& radii);
+
+void ComputeMeshCoveringSpheres(
+    const double* vertex_data,
+    size_t vertex_count,
+    const std::uint32_t* triangle_data,
+    size_t triangle_count,
+    double max_overshoot,
+    std::vector<Vector3>& centers,
+    std::vector<double>& radii);
+
 } // namespace geometry
 } // namespace smpl
 
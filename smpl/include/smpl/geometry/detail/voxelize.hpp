@@ -30,6 +30,8 @@
 #ifndef SMPL_VOXELIZE_HPP
 #define SMPL_VOXELIZE_HPP
 
+#include <limits>
+
 #include <smpl/geometry/utils.h>
 
 namespace smpl {
@@ -48,6 +50,23 @@ void VoxelizeTriangle(
     const Vector3& b,
     const Vector3& c,
     VoxelGrid<Discretizer>& vg)
+{
+    VoxelizeTriangle(
+            a, b, c, vg,
+            std::numeric_limits<int>::min(),
+            std::numeric_limits<int>::max());
+}
+
+/// Each voxel is tested independently of the others, so voxelizing a triangle
+/// over disjoint x ranges fills the same voxels as voxelizing it at once.
+template <typename Discretizer>
+void VoxelizeTriangle(
+    const Vector3& a,
+    const Vector3& b,
+    const Vector3& c,
+    VoxelGrid<Discretizer>& vg,
+    int min_gx,
+    int max_gx)
 {
     Vector3 p1 = a;
     Vector3 p2 = b;
@@ -126,7 +145,7 @@ void VoxelizeTriangle(
     const GridCoord maxgc = vg.worldToGrid(maxwc);
 
     // consider all voxels that this triangle can voxelize
-    for (int gx = mingc.x; gx <= maxgc.x; gx++) {
+    for (int gx = std::max(mingc.x, min_gx); gx <= std::min(maxgc.x, max_gx); gx++) {
     for (int gy = mingc.y; gy <= maxgc.y; gy++) {
     for (int gz = mingc.z; gz <= maxgc.z; gz++) {
         const GridCoord gc(gx, gy, gz);
@@ -27,6 +27,12 @@
 // POSSIBILITY OF SUCH DAMAGE.
 //////////////////////////////////////////////////////////////////////////////
 
+// standard includes
+#include <cstdint>
+
+// project includes
+#include <smpl/spatial.h>
+
 namespace smpl {
 namespace geometry {
 
@@ -34,5 +40,46 @@ struct Triangle;
 
 bool Intersects(const Triangle& tr1, const Triangle& tr2, double eps = 1e-4);
 
+bool Intersects(
+    const Triangle& tr,
+    const Vector3& box_center,
+    const Vector3& box_half_extents);
+
+/// \name Batch Intersection Tests
+///
+/// The batch tests take their geometry as structure-of-arrays and write one
+/// byte per element of the batch to \p hits, 1 if the element intersects and 0
+/// otherwise. They are vectorized with AVX or SSE2 when the library is built
+/// with support for them.
+///@{
+void Intersects(
+    const Triangle& tr,
+    const double* box_center_x,
+    const double* box_center_y,
+    const double* box_center_z,
+    int count,
+    const Vector3& box_half_extents,
+    std::uint8_t* hits);
+
+void Intersects(
+    const double* ax, const double* ay, const double* az,
+    const double* bx, const double* by, const double* bz,
+    const double* cx, const double* cy, const double* cz,
+    int count,
+    const Vector3& box_center,
+    const Vector3& box_half_extents,
+    std::uint8_t* hits);
+
+void Intersects(
+    const double* sphere_center_x,
+    const double* sphere_center_y,
+    const double* sphere_center_z,
+    const double* sphere_radius,
+    int count,
+    const Vector3& box_center,
+    const Vector3& box_half_extents,
+    std::uint8_t* hits);
+///@}
+
 } // namespace geometry
 } // namespace smpl
@@ -0,0 +1,116 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_KD_TREE_H
+#define SMPL_KD_TREE_H
+
+// standard includes
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+namespace smpl {
+namespace geometry {
+
+/// \brief Static kd-tree over points in R^n answering k-nearest-neighbor and
+///     radius queries under the Euclidean metric.
+///
+/// The tree is built once over a copy of the points and stores them in tree
+/// order, so queries touch contiguous memory. Results are reported as indices
+/// into the original point array.
+class KDTree
+{
+public:
+
+    void build(const double* points, std::size_t count, std::size_t dim);
+    void clear();
+
+    auto size() const -> std::size_t { return m_index.size(); }
+    auto dimension() const -> std::size_t { return m_dim; }
+
+    /// Number of bytes allocated for the points and the tree.
+    auto memoryUsage() const -> std::size_t
+    {
+        return m_points.capacity() * sizeof(double) +
+                m_index.capacity() * sizeof(std::size_t) +
+                m_split.capacity() * sizeof(std::uint16_t);
+    }
+
+    void nearest(
+        const double* query,
+        std::size_t k,
+        std::vector<std::size_t>& indices) const;
+
+    void radius(
+        const double* query,
+        double radius,
+        std::vector<std::size_t>& indices) const;
+
+private:
+
+    using Candidate = std::pair<double, std::size_t>;
+
+    std::size_t m_dim = 0;
+
+    // points in tree order and the original index of each
+    std::vector<double> m_points;
+    std::vector<std::size_t> m_index;
+
+    // split dimension of the subtree whose pivot is at each position
+    std::vector<std::uint16_t> m_split;
+
+    auto point(std::size_t i) const -> const double*
+    { return m_points.data() + i * m_dim; }
+
+    double squaredDistance(const double* query, std::size_t i) const;
+
+    void buildRange(const double* points, std::size_t lo, std::size_t hi);
+
+    void nearestRange(
+        const double* query,
+        std::size_t k,
+        std::size_t lo,
+        std::size_t hi,
+        std::vector<Candidate>& heap) const;
+
+    void radiusRange(
+        const double* query,
+        double r2,
+        std::size_t lo,
+        std::size_t hi,
+        std::vector<std::size_t>& indices) const;
+};
+
+} // namespace geometry
+} // namespace smpl
+
+#endif
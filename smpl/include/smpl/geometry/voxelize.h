@@ -31,6 +31,8 @@
 #define SMPL_VOXELIZE_H
 
 // standard includes
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 // project includes
@@ -40,6 +42,39 @@
 namespace smpl {
 namespace geometry {
 
+/// \brief A non-owning view of an indexed triangle mesh stored in foreign
+///     containers
+///
+/// The coordinates of vertex i are the three consecutive doubles found
+/// vertex_stride bytes after those of vertex i - 1, and the indices of triangle
+/// t are the three consecutive uint32s found triangle_stride bytes after those
+/// of triangle t - 1. Flat arrays use strides of 3 * sizeof(double) and
+/// 3 * sizeof(std::uint32_t); arrays of message structs use the size of the
+/// struct.
+struct MeshView
+{
+    const double* vertices = nullptr;
+    std::size_t vertex_count = 0;
+    std::size_t vertex_stride = 3 * sizeof(double);
+
+    const std::uint32_t* triangles = nullptr;
+    std::size_t triangle_count = 0;
+    std::size_t triangle_stride = 3 * sizeof(std::uint32_t);
+
+    Vector3 vertex(std::size_t i) const
+    {
+        auto* v = reinterpret_cast<const double*>(
+                reinterpret_cast<const char*>(vertices) + i * vertex_stride);
+        return Vector3(v[0], v[1], v[2]);
+    }
+
+    const std::uint32_t* triangle(std::size_t t) const
+    {
+        return reinterpret_cast<const std::uint32_t*>(
+                reinterpret_cast<const char*>(triangles) + t * triangle_stride);
+    }
+};
+
 void VoxelizeBox(
     double length,
     double width,
@@ -200,6 +235,14 @@ void VoxelizeMesh(
     std::vector<Vector3>& voxels,
     bool fill = false);
 
+void VoxelizeMesh(
+    const MeshView& mesh,
+    const Affine3& pose,
+    double res,
+    const Vector3& voxel_origin,
+    std::vector<Vector3>& voxels,
+    bool fill = false);
+
 void VoxelizePlane(
     double a, double b, double c, double d,
     const Vector3& min,
@@ -251,6 +294,16 @@ void VoxelizeTriangle(
     const Vector3& c,
     VoxelGrid<Discretizer>& vg);
 
+/// \brief Voxelize the part of a triangle in the grid x range [min_gx, max_gx]
+template <typename Discretizer>
+void VoxelizeTriangle(
+    const Vector3& a,
+    const Vector3& b,
+    const Vector3& c,
+    VoxelGrid<Discretizer>& vg,
+    int min_gx,
+    int max_gx);
+
 } // namespace geometry
 } // namespace smpl
 
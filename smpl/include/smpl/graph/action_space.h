@@ -60,6 +60,18 @@ public:
     /// CollisionChecker's isStateToStateValid function during a search.
     virtual bool apply(const RobotState& parent, std::vector<Action>& actions) = 0;
 
+    /// \brief Return the set of actions available from a state, reusing the
+    ///     storage of a caller-owned buffer.
+    ///
+    /// The first \p count elements of \p actions are overwritten with the
+    /// available actions; the buffer only grows, so callers that keep it
+    /// across expansions avoid reallocating waypoints. The default
+    /// implementation forwards to apply().
+    virtual bool applyBuffered(
+        const RobotState& parent,
+        std::vector<Action>& actions,
+        size_t& count);
+
     virtual void updateStart(const RobotState& state) { }
     virtual void updateGoal(const GoalConstraint& goal) { }
 
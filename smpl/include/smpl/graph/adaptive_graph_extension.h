@@ -49,6 +49,17 @@ public:
     virtual bool isExecutable(const std::vector<int>& states) const = 0;
     virtual bool setPlanMode() = 0;
     virtual bool setTrackMode(const std::vector<int>& states) = 0;
+
+    /// \brief Prepare the graph for a plan-mode search on another thread
+    ///     while a track-mode search runs.
+    ///
+    /// Once enabled, the mode set by setTrackMode() applies only to searches
+    /// on the thread that called it; searches on other threads see the graph
+    /// in plan mode. setPlanMode(), setTrackMode(), and addHighDimRegion()
+    /// must not be called while a search on another thread is running.
+    ///
+    /// \return false if the graph does not support concurrent searches
+    virtual bool enableConcurrentPlanning() { return false; }
 };
 
 } // namespace smpl
@@ -34,7 +34,10 @@
 
 // standard includes
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <ostream>
+#include <thread>
 #include <tuple>
 #include <vector>
 
@@ -42,7 +45,7 @@
 #include <smpl/graph/adaptive_graph_extension.h>
 #include <smpl/graph/motion_primitive.h>
 #include <smpl/graph/workspace_lattice_base.h>
-#include <smpl/grid/grid.h>
+#include <smpl/grid/sparse_grid.h>
 #include <smpl/occupancy_grid.h>
 #include <smpl/time.h>
 #include <smpl/types.h>
@@ -144,6 +147,7 @@ public:
     bool isExecutable(const std::vector<int>& states) const override;
     bool setTrackMode(const std::vector<int>& tunnel) override;
     bool setPlanMode() override;
+    bool enableConcurrentPlanning() override;
     ///@}
 
     /// \name Required Public Functions from RobotPlanningSpcae
@@ -204,6 +208,11 @@ private:
 
     std::vector<AdaptiveState*> m_states;
 
+    // guards m_states, the state lookup tables, StateID2IndexMapping, and
+    // m_hi_action_checks, which are shared by concurrent plan and track
+    // searches
+    mutable std::mutex m_states_mutex;
+
     clock::time_point m_t_start;
     mutable bool m_near_goal = false;
 
@@ -216,7 +225,27 @@ private:
     int m_region_radius = 1;
     int m_tunnel_radius = 3;
 
-    bool m_plan_mode = true;
+    // thread running the track-mode search; searches on any other thread
+    // see the graph in plan mode
+    std::thread::id m_track_thread;
+
+    // kinematics and collision checking used to generate successors
+    struct Models
+    {
+        RobotModel* robot = nullptr;
+        InverseKinematicsInterface* ik = nullptr;
+        RedundantManipulatorInterface* rm = nullptr;
+        ForwardKinematicsInterface* fk = nullptr;
+        CollisionChecker* checker = nullptr;
+    };
+
+    Models m_models;
+
+    // independent copies of the models for plan-mode searches running
+    // concurrently with a track-mode search
+    Models m_plan_models;
+    std::unique_ptr<RobotModel> m_robot_clone;
+    std::unique_ptr<CollisionChecker> m_checker_clone;
 
     struct AdaptiveGridCell
     {
@@ -225,8 +254,28 @@ private:
         bool trak_hd;
 
         AdaptiveGridCell() : grow_count(0), plan_hd(false), trak_hd(false) { }
+
+        bool operator==(const AdaptiveGridCell& o) const
+        {
+            return grow_count == o.grow_count &&
+                    plan_hd == o.plan_hd &&
+                    trak_hd == o.trak_hd;
+        }
     };
-    Grid3<AdaptiveGridCell> m_dim_grid;
+
+    // stored sparsely, since high-dimensional regions and tunnels typically
+    // cover a small fraction of the workspace
+    SparseGrid<AdaptiveGridCell> m_dim_grid;
+
+    // cells marked by the current tunnel, unmarked by the next call to
+    // setTunnel
+    std::vector<Eigen::Vector3i> m_tunnel_cells;
+
+    // outcome of checking each action of a high-dimensional state, retained
+    // across plan and track iterations of the same request, since the
+    // adaptive planner re-expands the same states on every iteration
+    enum ActionCheck : char { ACTION_UNCHECKED = 0, ACTION_VALID, ACTION_INVALID };
+    hash_map<int, std::vector<char>> m_hi_action_checks;
 
     bool initMotionPrimitives();
 
@@ -238,13 +287,18 @@ private:
         std::vector<int>* costs);
 
     void GetSuccs(
+        int state_id,
         const AdaptiveWorkspaceState& state,
         std::vector<int>* succs,
         std::vector<int>* costs);
 
     int reserveHashEntry(bool hid);
 
+    bool isPlanMode() const;
+    auto models() const -> const Models&;
+
     bool isHighDimensional(int gx, int gy, int gz) const;
+    bool isHighDimensional(int gx, int gy, int gz, bool plan_mode) const;
 
     AdaptiveState* getHashEntry(int state_id) const;
     AdaptiveWorkspaceState* getHiHashEntry(int state_id) const;
@@ -253,8 +307,8 @@ private:
     int getHiHashEntry(const WorkspaceCoord& coord);
     int getLoHashEntry(int x, int y, int z);
 
-    int createHiState(const WorkspaceCoord& coord, const RobotState& state);
-    int createLoState(int x, int y, int z, double wx, double wy, double wz);
+    int getOrCreateHiState(const WorkspaceCoord& coord, const RobotState& state);
+    int getOrCreateLoState(int x, int y, int z, double wx, double wy, double wz);
 
     void getActions(
         const AdaptiveWorkspaceState& state,
@@ -0,0 +1,119 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_COORD_TABLE_H
+#define SMPL_COORD_TABLE_H
+
+// standard includes
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace smpl {
+
+/// A table assigning consecutive ids to fixed-width integer coordinates.
+///
+/// Coordinates are stored inline, one row of width() integers per id, in a
+/// single flat array. Lookups go through an open-addressing index with linear
+/// probing that records the hash of each coordinate next to its id, so
+/// finding or inserting a coordinate never allocates (outside of growing the
+/// table) and rarely compares more than one row.
+///
+/// Rows may also be reserved without being indexed, for entries that must
+/// have an id and a coordinate but should never be found by lookup.
+class CoordTable
+{
+public:
+
+    explicit CoordTable(int width = 0);
+
+    /// Set the number of integers per coordinate. Clears the table.
+    void setWidth(int width);
+    int width() const { return m_width; }
+
+    /// Number of ids handed out, including reserved ids.
+    int size() const { return m_size; }
+
+    /// Return the id of a coordinate of width() integers, or -1 if it has not
+    /// been inserted.
+    int find(const int* coord) const;
+
+    /// Assign the next id to a coordinate and index it. The coordinate must
+    /// not already be in the table.
+    int insert(const int* coord);
+
+    /// Assign the next id to a zero coordinate without indexing it.
+    int reserve();
+
+    auto coord(int id) -> int* { return &m_coords[(std::size_t)id * m_width]; }
+    auto coord(int id) const -> const int*
+    {
+        return &m_coords[(std::size_t)id * m_width];
+    }
+
+    /// Remove all coordinates, retaining allocated storage.
+    void clear();
+
+    /// Number of bytes allocated for coordinates and the index.
+    auto memoryUsage() const -> std::size_t
+    {
+        return m_coords.capacity() * sizeof(int) +
+                m_slots.capacity() * sizeof(Slot);
+    }
+
+private:
+
+    struct Slot
+    {
+        std::uint32_t hash;
+        int id; // -1 if the slot is empty
+    };
+
+    int m_width;
+    int m_size;
+
+    std::vector<int> m_coords;
+
+    // index from coordinates to ids; the number of slots is always a power of
+    // two and at least twice the number of indexed ids
+    std::vector<Slot> m_slots;
+    std::size_t m_indexed;
+
+    auto hash(const int* coord) const -> std::uint32_t;
+    bool equal(const int* a, const int* b) const;
+    void place(std::uint32_t hash, int id);
+    void grow();
+};
+
+} // namespace smpl
+
+#endif
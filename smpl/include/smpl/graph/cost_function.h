@@ -32,18 +32,65 @@
 #ifndef SMPL_COST_FUNCTION_H
 #define SMPL_COST_FUNCTION_H
 
+// project includes
+#include <smpl/types.h>
+
 namespace smpl {
 
+class CollisionChecker;
+class CollisionDistanceExtension;
+
+/// Computes the costs of the edges of a planning space, where an edge is an
+/// action applied to a state, ending at the last waypoint of the action.
 class CostFunction
 {
 public:
 
-    CostFunction();
-    virtual ~CostFunction() { }
+    virtual ~CostFunction();
+
+    virtual int getCost(const RobotState& state, const Action& action) = 0;
+
+    /// Return a lower bound on getCost() that is cheap to compute. Lazy
+    /// searches are given the lower bound for each successor until the edge
+    /// is evaluated, so edges never evaluated cost nothing beyond the bound.
+    /// The default implementation returns getCost().
+    virtual int getCostLowerBound(const RobotState& state, const Action& action);
+};
+
+/// A constant cost per edge, raised by up to a factor of (1 + weight) as the
+/// distance to collision along the edge falls from the clearance to zero. The
+/// constant cost is the lower bound.
+class ClearanceCostFunction : public CostFunction
+{
+public:
+
+    bool init(CollisionChecker* checker);
+
+    int baseCost() const { return m_base_cost; }
+    void setBaseCost(int cost) { m_base_cost = cost; }
+
+    double clearance() const { return m_clearance; }
+    void setClearance(double clearance) { m_clearance = clearance; }
 
-    virtual int getCost(const RobotState& state, const RobotState& state) const = 0;
+    double weight() const { return m_weight; }
+    void setWeight(double weight) { m_weight = weight; }
+
+    /// \name Required Public Functions from CostFunction
+    ///@{
+    int getCost(const RobotState& state, const Action& action) override;
+    ///@}
+
+    /// \name Reimplemented Public Functions from CostFunction
+    ///@{
+    int getCostLowerBound(const RobotState& state, const Action& action) override;
+    ///@}
 
 private:
+
+    CollisionDistanceExtension* m_cdist_iface = nullptr;
+    int m_base_cost = 1000;
+    double m_clearance = 0.0;
+    double m_weight = 0.0;
 };
 
 } // namespace smpl
@@ -157,6 +157,17 @@ struct ExperienceGraph
     // removal
     std::vector<std::ptrdiff_t> m_shift;
 
+    // compacted storage, valid while m_compact is set. Incident edges of node
+    // n are m_adjacency[m_adjacency_offsets[n], m_adjacency_offsets[n + 1]);
+    // waypoints of edge e are m_state_dim-sized blocks of m_waypoint_pool
+    // starting at m_waypoint_offsets[e] * m_state_dim.
+    bool m_compact = false;
+    std::size_t m_state_dim = 0;
+    std::vector<std::size_t> m_adjacency_offsets;
+    Node::adjacent_edge_container m_adjacency;
+    std::vector<std::size_t> m_waypoint_offsets;
+    std::vector<double> m_waypoint_pool;
+
     auto nodes() const -> std::pair<node_iterator, node_iterator>;
     auto edges() const -> std::pair<edge_iterator, edge_iterator>;
 
@@ -189,11 +200,22 @@ struct ExperienceGraph
 
     void clear();
 
+    void compact();
+    void expand();
+    bool compacted() const { return m_compact; }
+
+    /// Return the number of bytes allocated for nodes, edges, and waypoints
+    auto mem_usage() const -> std::size_t;
+
     auto state(node_id id) const -> const RobotState&;
     auto state(node_id id) -> RobotState&;
 
     auto waypoints(edge_id id) const -> const std::vector<RobotState>&;
     auto waypoints(edge_id id) -> std::vector<RobotState>&;
+
+    auto waypoint_count(edge_id id) const -> std::size_t;
+    auto waypoint(edge_id id, std::size_t i) const
+        -> std::pair<const double*, const double*>;
 };
 
 } // namespace smpl
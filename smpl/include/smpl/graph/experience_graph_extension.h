@@ -44,16 +44,82 @@ class ExperienceGraphExtension : public virtual Extension
 {
 public:
 
+    /// Load an experience graph from a directory of demonstrations, a binary
+    /// experience graph file, or a graph published to shared memory, named
+    /// by "shm:" followed by the shared memory object name.
     virtual bool loadExperienceGraph(const std::string& path) = 0;
 
+    /// Append a path to the experience graph. States within merge_radius of
+    /// an existing node, in joint space, are merged into that node rather
+    /// than inserted; a radius of zero merges nothing. Heuristics attached to
+    /// the planning space are notified of the new nodes and edges.
+    virtual bool insertExperienceGraphPath(
+        const std::vector<RobotState>& path,
+        double merge_radius) = 0;
+
     virtual void getExperienceGraphNodes(
         int state_id,
         std::vector<ExperienceGraph::node_id>& nodes) = 0;
 
+    /// Find the k experience graph nodes nearest to a state in joint space,
+    /// in order of increasing distance.
+    virtual void getNearestExperienceGraphNodes(
+        const RobotState& state,
+        int k,
+        std::vector<ExperienceGraph::node_id>& nodes) = 0;
+
+    /// Find the experience graph nodes within a joint-space distance of a
+    /// state, in no particular order.
+    virtual void getExperienceGraphNodesInRadius(
+        const RobotState& state,
+        double radius,
+        std::vector<ExperienceGraph::node_id>& nodes) = 0;
+
     virtual bool shortcut(int first_id, int second_id, int& cost) = 0;
 
     virtual bool snap(int first_id, int second_id, int& cost) = 0;
 
+    /// Check the shortcut transitions from a state to each of \p n states.
+    /// The cost of the i'th transition is stored in \p costs[i], or -1 if
+    /// the transition is invalid. The default implementation calls shortcut
+    /// once per transition.
+    ///
+    /// \return The number of valid transitions
+    virtual int shortcutBatch(
+        int first_id,
+        const int* second_ids,
+        int n,
+        int* costs)
+    {
+        auto count = 0;
+        for (auto i = 0; i < n; ++i) {
+            if (shortcut(first_id, second_ids[i], costs[i])) {
+                ++count;
+            } else {
+                costs[i] = -1;
+            }
+        }
+        return count;
+    }
+
+    /// Batch variant of snap, with the same conventions as shortcutBatch.
+    virtual int snapBatch(
+        int first_id,
+        const int* second_ids,
+        int n,
+        int* costs)
+    {
+        auto count = 0;
+        for (auto i = 0; i < n; ++i) {
+            if (snap(first_id, second_ids[i], costs[i])) {
+                ++count;
+            } else {
+                costs[i] = -1;
+            }
+        }
+        return count;
+    }
+
     virtual const ExperienceGraph* getExperienceGraph() const = 0;
     virtual ExperienceGraph* getExperienceGraph() = 0;
 
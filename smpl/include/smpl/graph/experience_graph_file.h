@@ -0,0 +1,193 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_EXPERIENCE_GRAPH_FILE_H
+#define SMPL_EXPERIENCE_GRAPH_FILE_H
+
+// standard includes
+#include <cstdint>
+#include <string>
+#include <utility>
+
+// project includes
+#include <smpl/graph/experience_graph.h>
+
+namespace smpl {
+
+#define EXPERIENCE_GRAPH_FILE_MAGIC "SMPLEGPH"
+#define EXPERIENCE_GRAPH_FILE_VERSION 1
+
+/// Fixed-size header at the start of a binary experience graph file. The
+/// header is followed by these sections, each a contiguous array of 8-byte
+/// values:
+///
+///     node states        double[node_count * dof]
+///     adjacency offsets  uint64[node_count + 1]
+///     adjacency          uint64[2 * adjacency offsets[node_count]]
+///     edge endpoints     uint64[2 * edge_count]
+///     waypoint offsets   uint64[edge_count + 1]
+///     waypoints          double[waypoint_count * dof]
+///
+/// Adjacency is stored in compressed sparse row form as (edge id, node id)
+/// pairs, matching ExperienceGraph::Node::edges.
+struct ExperienceGraphFileHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t dof;
+    std::uint64_t node_count;
+    std::uint64_t edge_count;
+    std::uint64_t waypoint_count;
+};
+
+/// Prefix that names a POSIX shared memory object, rather than a file, in the
+/// paths accepted by ExperienceGraphFile::open() and the egraph lattices'
+/// loadExperienceGraph().
+#define EXPERIENCE_GRAPH_SHARED_PREFIX "shm:"
+
+/// Read-only memory mapping of a binary experience graph file. The mapping is
+/// shared, so planner processes opening the same file share its pages in the
+/// page cache. The graph may also be attached from a POSIX shared memory
+/// object published with PublishExperienceGraph(), which keeps one copy per
+/// host without touching the filesystem.
+class ExperienceGraphFile
+{
+public:
+
+    using node_id = ExperienceGraph::node_id;
+    using edge_id = ExperienceGraph::edge_id;
+
+    struct Adjacency
+    {
+        std::uint64_t edge;
+        std::uint64_t node;
+    };
+
+    ExperienceGraphFile() = default;
+    ~ExperienceGraphFile();
+
+    ExperienceGraphFile(const ExperienceGraphFile&) = delete;
+    ExperienceGraphFile& operator=(const ExperienceGraphFile&) = delete;
+
+    /// Map the experience graph file at path, or, if path is of the form
+    /// "shm:<name>", attach the shared memory object <name>.
+    bool open(const std::string& path);
+
+    /// Attach, read-only, the shared memory object published under name.
+    bool openShared(const std::string& name);
+
+    void close();
+
+    bool isOpen() const { return m_data != nullptr; }
+
+    auto dof() const -> std::size_t { return header().dof; }
+    auto num_nodes() const -> std::size_t { return header().node_count; }
+    auto num_edges() const -> std::size_t { return header().edge_count; }
+
+    /// Return a pointer to the dof() joint positions of a node.
+    const double* state(node_id id) const
+    { return m_states + id * dof(); }
+
+    auto adjacency(node_id id) const
+        -> std::pair<const Adjacency*, const Adjacency*>
+    {
+        return std::make_pair(
+                m_adjacency + m_adjacency_offsets[id],
+                m_adjacency + m_adjacency_offsets[id + 1]);
+    }
+
+    auto source(edge_id id) const -> node_id { return m_edge_nodes[2 * id]; }
+    auto target(edge_id id) const -> node_id { return m_edge_nodes[2 * id + 1]; }
+
+    auto num_waypoints(edge_id id) const -> std::size_t
+    { return m_waypoint_offsets[id + 1] - m_waypoint_offsets[id]; }
+
+    /// Return a pointer to the num_waypoints(id) * dof() joint positions of
+    /// the waypoints along an edge, stored contiguously.
+    const double* waypoints(edge_id id) const
+    { return m_waypoints + m_waypoint_offsets[id] * dof(); }
+
+private:
+
+    void* m_data = nullptr;
+    std::size_t m_size = 0;
+
+    const double* m_states = nullptr;
+    const std::uint64_t* m_adjacency_offsets = nullptr;
+    const Adjacency* m_adjacency = nullptr;
+    const std::uint64_t* m_edge_nodes = nullptr;
+    const std::uint64_t* m_waypoint_offsets = nullptr;
+    const double* m_waypoints = nullptr;
+
+    auto header() const -> const ExperienceGraphFileHeader&
+    { return *static_cast<const ExperienceGraphFileHeader*>(m_data); }
+
+    bool map(int fd, const std::string& what);
+};
+
+/// Return true if the file at path begins with the binary experience graph
+/// magic number.
+bool IsExperienceGraphFile(const std::string& path);
+
+/// Write an experience graph in the binary format read by
+/// ExperienceGraphFile. All node states and waypoints must have the same
+/// number of variables.
+bool WriteExperienceGraphFile(
+    const std::string& path,
+    const ExperienceGraph& egraph);
+
+/// Return true if path names a shared memory experience graph, i.e. begins
+/// with EXPERIENCE_GRAPH_SHARED_PREFIX.
+bool IsSharedExperienceGraph(const std::string& path);
+
+/// Publish an experience graph, in the binary file format, as the POSIX shared
+/// memory object name (e.g. "/smpl_egraph"), replacing any previous object of
+/// that name. Planner processes attach it with ExperienceGraphFile::openShared.
+/// Processes that are already attached keep their mapping of the previous
+/// graph until they close it.
+bool PublishExperienceGraph(
+    const std::string& name,
+    const ExperienceGraph& egraph);
+
+/// Remove the name of a shared memory experience graph. The memory is released
+/// once every attached process has closed it.
+bool UnpublishExperienceGraph(const std::string& name);
+
+/// Append the nodes and edges stored in a binary experience graph file to an
+/// experience graph. The ids of the appended nodes begin at the previous node
+/// count.
+void AppendExperienceGraphFile(
+    const ExperienceGraphFile& file,
+    ExperienceGraph& egraph);
+
+} // namespace smpl
+
+#endif
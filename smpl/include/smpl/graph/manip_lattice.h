@@ -45,57 +45,53 @@
 
 // project includes
 #include <smpl/angles.h>
+#include <smpl/arena.h>
 #include <smpl/time.h>
 #include <smpl/collision_checker.h>
+#include <smpl/memory_usage.h>
 #include <smpl/occupancy_grid.h>
 #include <smpl/planning_params.h>
 #include <smpl/robot_model.h>
 #include <smpl/types.h>
+#include <smpl/worker_pool.h>
 #include <smpl/graph/robot_planning_space.h>
 #include <smpl/graph/action_space.h>
+#include <smpl/graph/packed_coord_table.h>
+#include <smpl/graph/pose_goal_set.h>
 
 namespace smpl {
 
+class CostFunction;
 class RobotHeuristic;
 
 typedef std::vector<int> RobotCoord;
 
+/// The state of a lattice entry. The discrete coordinate of each entry is
+/// stored separately, packed in the lattice's coordinate table.
 struct ManipLatticeState
 {
-    RobotCoord coord;   // discrete coordinate
     RobotState state;   // corresponding continuous coordinate
-};
-
-inline
-bool operator==(const ManipLatticeState& a, const ManipLatticeState& b)
-{
-    return a.coord == b.coord;
-}
-
-} // namespace smpl
 
-namespace std {
-
-template <>
-struct hash<smpl::ManipLatticeState>
-{
-    typedef smpl::ManipLatticeState argument_type;
-    typedef std::size_t result_type;
-    result_type operator()(const argument_type& s) const;
+    // planning frame pose of the state, computed on its first projection.
+    // the orientation is stored as a single-precision (w, x, y, z) quaternion
+    double position[3];
+    float orientation[4];
+    bool projected;
 };
 
-} // namespace std
-
-namespace smpl {
-
 /// \class Discrete space constructed by expliciting discretizing each joint
 class ManipLattice :
     public RobotPlanningSpace,
     public PoseProjectionExtension,
-    public ExtractRobotStateExtension
+    public ExtractRobotStateExtension,
+    public MemoryUsageExtension,
+    public GoalSetExtension,
+    public StateRetirementExtension
 {
 public:
 
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
     ~ManipLattice();
 
     bool init(
@@ -115,7 +111,80 @@ public:
 
     auto getDiscreteCenter(const RobotState& state) const -> RobotState;
 
-    void clearStates();
+    void clearStates() override;
+
+    /// \brief Set the number of threads used to check the actions of a state.
+    ///
+    /// With more than one thread, the actions generated by each call to
+    /// GetSuccs are collision checked concurrently. Successors are still
+    /// reported in action order, so search results are unaffected. Each
+    /// additional thread uses its own clone of the collision checker, which
+    /// must support CollisionCheckerCloneExtension, and calls
+    /// RobotModel::checkJointLimits concurrently. A count of 1 (the default)
+    /// checks actions serially on the calling thread.
+    bool setActionCheckThreadCount(int count);
+    int actionCheckThreadCount() const;
+
+    /// \brief Check the actions of a state in order of increasing successor
+    ///     f-value.
+    ///
+    /// Successor f-values are the edge cost plus the goal heuristic of the
+    /// successor; a successor state is created for every action before it is
+    /// checked. With early exit enabled, checking stops after the first batch
+    /// of actions (one per check thread) containing a valid successor whose
+    /// f-value does not exceed the parent's, in the style of partial expansion
+    /// A*. The unchecked successors are dropped rather than deferred, so early
+    /// exit gives up completeness and suboptimality bounds in exchange for
+    /// fewer collision checks and is meant for first-solution planning.
+    void setOrderedExpansion(bool enable, bool early_exit = false);
+    bool orderedExpansion() const;
+    bool orderedExpansionEarlyExit() const;
+
+    /// \brief Limit the memory used to store lattice states, or remove the
+    ///     limit if \p bytes is 0.
+    ///
+    /// Once the states created since the last call to clearStates() hold
+    /// \p bytes of memory, no new states are created and actions leading to
+    /// states that have not been visited are dropped from GetSuccs, so the
+    /// search continues over the states it already has rather than growing
+    /// without bound.
+    void setMemoryLimit(std::size_t bytes);
+    auto memoryLimit() const -> std::size_t;
+    bool memoryLimitReached() const;
+
+    /// \brief Enable or disable memoizing the validity of the actions of each
+    ///     state.
+    ///
+    /// Action results are remembered per state for the first 64 actions, keyed
+    /// by a fingerprint of the state's action list, so re-expanding a state or
+    /// evaluating one of its edges again does not repeat collision checks for
+    /// the same motions. The memo is only used when the collision checker
+    /// provides CollisionWorldVersionExtension and is discarded whenever the
+    /// world version changes. Enabled by default.
+    void setActionValidityMemo(bool enable);
+    bool actionValidityMemo() const;
+
+    /// \brief Enable or disable exposing the goal as a set of goal states.
+    ///
+    /// When enabled, successors that satisfy the goal keep their own state IDs
+    /// rather than being mapped to the goal state ID, and the lattice provides
+    /// GoalSetExtension, with one goal per pose of a MULTIPLE_POSE_GOAL goal
+    /// constraint and a single goal otherwise. This lets a goal-set search
+    /// (see ARAStar::setGoalSetSearch) tell which goal it reached. Disabled by
+    /// default.
+    void setGoalSetStates(bool enable);
+    bool goalSetStates() const;
+
+    /// \brief Set the function computing the costs of edges, which must
+    ///     outlive the lattice, or restore the constant cost per edge if
+    ///     \p fn is null.
+    ///
+    /// GetLazySuccs reports the cost function's lower bound for each
+    /// successor, and the exact cost is computed only when the search
+    /// evaluates the edge through GetTrueCost. With ordered expansion, actions
+    /// are ordered by their lower bounds.
+    void setCostFunction(CostFunction* fn) { m_cost_fn = fn; }
+    auto costFunction() const -> CostFunction* { return m_cost_fn; }
 
     /// \name Reimplemented Public Functions from RobotPlanningSpace
     ///@{
@@ -127,6 +196,11 @@ public:
     int GetTrueCost(int parent_id, int child_id) override;
     ///@}
 
+    /// \name Required Public Functions from StateRetirementExtension
+    ///@{
+    void retireStates(const int* state_ids, std::size_t count) override;
+    ///@}
+
     /// \name Required Public Functions from ExtractRobotStateExtension
     ///@{
     auto extractState(int state_id) -> const RobotState& override;
@@ -137,6 +211,11 @@ public:
     bool projectToPose(int state_id, Affine3& pos) override;
     ///@}
 
+    /// \name Reimplemented Public Functions from PointProjectionExtension
+    ///@{
+    bool projectToPoint(int state_id, Vector3& pos) override;
+    ///@}
+
     /// \name Required Public Functions from RobotPlanningSpace
     ///@{
     bool setStart(const RobotState& state) override;
@@ -148,11 +227,22 @@ public:
         std::vector<RobotState>& path) override;
     ///@}
 
+    /// \name Required Public Functions from GoalSetExtension
+    ///@{
+    int goalCount() override;
+    int goalIndex(int state_id) override;
+    ///@}
+
     /// \name Required Public Functions from Extension
     ///@{
     virtual Extension* getExtension(size_t class_code) override;
     ///@}
 
+    /// \name Required Public Functions from MemoryUsageExtension
+    ///@{
+    auto memoryUsage() const -> std::size_t override;
+    ///@}
+
     /// \name Required Public Functions from DiscreteSpaceInformation
     ///@{
     void GetSuccs(
@@ -175,20 +265,37 @@ protected:
     ///@}
 
     ManipLatticeState* getHashEntry(int state_id) const;
+    auto getHashEntryCoord(int state_id) const -> RobotCoord;
 
     int getHashEntry(const RobotCoord& coord);
     int createHashEntry(const RobotCoord& coord, const RobotState& state);
     int getOrCreateState(const RobotCoord& coord, const RobotState& state);
     int reserveHashEntry();
+    int reserveHashEntry(const RobotCoord& coord, const RobotState& state);
 
     Affine3 computePlanningFrameFK(const RobotState& state) const;
+    void updateProjection(ManipLatticeState* entry);
 
     int cost(
         ManipLatticeState* HashEntry1,
         ManipLatticeState* HashEntry2,
         bool bState2IsGoal) const;
 
+    int actionCost(
+        const RobotState& state,
+        const Action& action,
+        bool lower_bound = false);
+
     bool checkAction(const RobotState& state, const Action& action);
+    bool checkAction(
+        const RobotState& state,
+        const Action& action,
+        CollisionChecker* checker);
+
+    void checkMotions(
+        const RobotState& state,
+        const std::vector<const RobotState*>& targets,
+        std::vector<char>& valid);
 
     bool isGoal(const RobotState& state);
 
@@ -209,27 +316,121 @@ private:
     std::vector<int> m_coord_vals;
     std::vector<double> m_coord_deltas;
 
+    // per-variable terms that let stateToCoord and coordToState treat
+    // continuous, bounded, and unbounded variables alike: the value of
+    // coordinate 0, the period (2 * pi or 0) the value is wrapped into, 1 if
+    // the value is rounded symmetrically about 0 (unbounded) and 0 otherwise,
+    // and the coordinate that wraps around to 0 (continuous) or 0
+    std::vector<double> m_coord_offsets;
+    std::vector<double> m_coord_periods;
+    std::vector<double> m_coord_symmetric;
+    std::vector<int> m_coord_wraps;
+
+    // bounds of the joint state goal region, checked by isGoal
+    std::vector<double> m_goal_min_angles;
+    std::vector<double> m_goal_max_angles;
+
     int m_goal_state_id = -1;
     int m_start_state_id = -1;
 
-    // maps from coords to stateID
-    typedef ManipLatticeState StateKey;
-    typedef PointerValueHash<StateKey> StateHash;
-    typedef PointerValueEqual<StateKey> StateEqual;
-    hash_map<StateKey*, int, StateHash, StateEqual> m_state_to_id;
+    // maps from coords to stateID and from stateID to coords. each joint is
+    // packed into as few bits as cover its discretization
+    PackedCoordTable m_coord_table;
 
-    // maps from stateID to coords
+    // maps from stateID to states
     std::vector<ManipLatticeState*> m_states;
 
+    // backing storage for the states in m_states
+    Arena m_state_arena;
+
+    // storage of retired states, whose ids map to null in m_states, for reuse
+    // by new states
+    std::vector<ManipLatticeState*> m_free_entries;
+    std::size_t m_retired_count = 0;
+
     std::string m_viz_frame_id;
 
+    // pool for checking actions in parallel and a collision checker for each
+    // of its background threads
+    std::unique_ptr<WorkerPool> m_check_pool;
+    std::vector<std::unique_ptr<CollisionChecker>> m_check_clones;
+
+    // expansion buffers reused across GetSuccs/GetLazySuccs/GetTrueCost so
+    // that successor generation does not reallocate waypoints per expansion
+    std::vector<Action> m_action_buffer;
+    std::vector<char> m_valid_buffer;
+    RobotCoord m_succ_coord;
+
+    struct OrderedAction
+    {
+        size_t index;
+        int succ_id;
+        int cost;
+        int f;
+        bool is_goal;
+    };
+
+    bool m_ordered_expansion = false;
+    bool m_ordered_early_exit = false;
+    std::vector<OrderedAction> m_ordered_actions;
+
+    std::size_t m_memory_limit = 0;
+    bool m_memory_limit_reached = false;
+
+    // validity of the first 64 actions of a state, as bits of 'valid' for the
+    // actions whose bits are set in 'known', computed for the action list with
+    // the given fingerprint
+    struct ActionMemo
+    {
+        std::uint64_t fingerprint;
+        std::uint64_t known;
+        std::uint64_t valid;
+    };
+
+    CollisionWorldVersionExtension* m_world_version_iface = nullptr;
+    bool m_action_memo_enabled = true;
+    std::uint64_t m_action_memo_version = 0;
+    std::vector<ActionMemo> m_action_memos; // indexed by state id
+    std::vector<size_t> m_unknown_actions;
+
+    // goal poses of an XYZ_RPY_GOAL or MULTIPLE_POSE_GOAL goal constraint,
+    // prepared for isGoal
+    PoseGoalSet m_goal_poses;
+
+    bool m_goal_set_states = false;
+
+    CostFunction* m_cost_fn = nullptr;
+
     bool setGoalPose(const GoalConstraint& goal);
     bool setGoalPoses(const GoalConstraint& goal);
     bool setGoalConfiguration(const GoalConstraint& goal);
     bool setUserGoal(const GoalConstraint& goal);
 
+    void addHashEntry(int state_id, const RobotState& state);
+    auto constructEntry(const RobotState& state) -> ManipLatticeState*;
+
     void startNewSearch();
 
+    void getOrderedSuccs(
+        int state_id,
+        ManipLatticeState* parent_entry,
+        size_t action_count,
+        std::vector<int>* succs,
+        std::vector<int>* costs);
+
+    void checkActions(
+        const RobotState& state,
+        const std::vector<Action>& actions,
+        size_t count,
+        std::vector<char>& valid,
+        ActionMemo* memo);
+
+    auto getActionMemo(
+        int state_id,
+        const std::vector<Action>& actions,
+        size_t count)
+        -> ActionMemo*;
+
     /// \name planning
     ///@{
     ///@}
@@ -48,7 +48,11 @@
 #include <smpl/graph/action_space.h>
 #include <smpl/graph/manip_lattice.h>
 #include <smpl/graph/motion_primitive.h>
+#include <smpl/graph/motion_primitive_file.h>
+#include <smpl/ik_sampler.h>
+#include <smpl/collision_checker.h>
 #include <smpl/planning_params.h>
+#include <smpl/reachability_map.h>
 #include <smpl/robot_model.h>
 
 namespace smpl {
@@ -65,6 +69,11 @@ public:
 
     bool load(const std::string& action_filename);
 
+    /// Write the long and short distance motion primitives to a binary motion
+    /// primitive file, which may be passed to load() in place of the text
+    /// file.
+    bool save(const std::string& path) const;
+
     void addMotionPrim(
         const std::vector<double>& mprim,
         bool short_dist_mprim,
@@ -78,19 +87,60 @@ public:
     int longDistCount() const;
     int shortDistCount() const;
 
+    /// Return the joint space path length of the i'th motion primitive, in
+    /// iteration order, or 0 for adaptive motions.
+    double primitiveCost(size_t i) const;
+
+    /// Return the largest displacement of any joint variable along the i'th
+    /// motion primitive, in iteration order, or 0 for adaptive motions.
+    double primitiveMaxDisplacement(size_t i) const;
+
+    /// Return the largest displacement of any joint variable along any long
+    /// or short distance motion primitive.
+    double maxPrimitiveDisplacement() const;
+
     bool useAmp(MotionPrimitive::Type type) const;
     bool useMultipleIkSolutions() const;
     bool useLongAndShortPrims() const;
+    bool useIkCache() const;
     double ampThresh(MotionPrimitive::Type type) const;
 
     void useAmp(MotionPrimitive::Type type, bool enable);
     void useMultipleIkSolutions(bool enable);
     void useLongAndShortPrims(bool enable);
+    void useIkCache(bool enable);
     void ampThresh(MotionPrimitive::Type type, double thresh);
 
+    void clearIkCache();
+    auto ikCacheHits() const -> size_t { return m_ik_cache_hits; }
+    auto ikCacheMisses() const -> size_t { return m_ik_cache_misses; }
+
+    bool setIkSampling(int seed_count, int thread_count = 1);
+    int ikSamplingSeeds() const;
+
+    /// Add the seed from a reachability map, which must outlive this action
+    /// space, to the seeds of IK sampling.
+    void setReachabilityMap(const ReachabilityMap* map);
+
+    bool useClearanceScaling() const { return m_use_clearance_scaling; }
+    bool useClearanceScaling(bool enable);
+    void setClearanceScaling(
+        double min_clearance,
+        double max_clearance,
+        int max_scale);
+
+    /// Return the multiple of the long distance motion primitives applied to
+    /// a state, which grows with the state's distance to collision.
+    int clearanceScale(const RobotState& state);
+
     /// \name Required Public Functions from ActionSpace
     ///@{
     bool apply(const RobotState& parent, std::vector<Action>& actions) override;
+    void updateGoal(const GoalConstraint& goal) override;
+    bool applyBuffered(
+        const RobotState& parent,
+        std::vector<Action>& actions,
+        size_t& count) override;
     ///@}
 
 protected:
@@ -106,6 +156,74 @@ protected:
     bool m_use_multiple_ik_solutions        = false;
     bool m_use_long_and_short_dist_mprims   = false;
 
+    // long and short distance primitives compiled into one flat table of
+    // joint deltas, indexed by position in m_mprims; adaptive motions have
+    // no entry (waypoint_count == 0)
+    struct CompiledPrimitive
+    {
+        size_t offset = 0;
+        size_t waypoint_count = 0;
+        size_t dim = 0;
+        double cost = 0.0;
+        double max_displacement = 0.0;
+    };
+
+    std::vector<CompiledPrimitive> m_compiled_prims;
+    std::vector<double> m_prim_deltas;
+
+    // the binary motion primitive file the primitives were loaded from, if
+    // any. While the primitive set is unmodified, the compiled deltas are read
+    // directly from its shared mapping.
+    std::unique_ptr<MotionPrimitiveFile> m_prim_file;
+
+    // m_prim_deltas or the deltas of m_prim_file
+    const double* m_prim_delta_data = nullptr;
+
+    // scratch storage for the actions of adaptive motions
+    std::vector<Action> m_amp_actions;
+
+    void compilePrimitives();
+    bool loadBinary(const std::string& path);
+
+    // IK results for the current goal, keyed on the discretized seed state
+    // followed by the IK option and whether multiple solutions were
+    // requested. Failures are cached as entries without solutions.
+    struct IkCacheKeyHash
+    {
+        typedef std::vector<int> argument_type;
+        typedef std::size_t result_type;
+
+        result_type operator()(const argument_type& s) const;
+    };
+
+    bool m_use_ik_cache = false;
+    hash_map<std::vector<int>, std::vector<RobotState>, IkCacheKeyHash> m_ik_cache;
+    std::vector<int> m_ik_cache_key;
+    size_t m_ik_cache_hits = 0;
+    size_t m_ik_cache_misses = 0;
+
+    // solves adaptive motions from several seeds when enabled
+    std::unique_ptr<IKSampler> m_ik_sampler;
+    const ReachabilityMap* m_reachability_map = nullptr;
+
+    // long distance primitives are scaled by an integer multiple, so that
+    // their successors remain on the lattice, from 1 at or below
+    // m_clearance_min up to m_max_step_scale at or above m_clearance_max
+    CollisionDistanceExtension* m_cdist_iface = nullptr;
+    bool m_use_clearance_scaling = false;
+    double m_clearance_min = 0.1;
+    double m_clearance_max = 0.5;
+    int m_max_step_scale = 1;
+
+    // scale for the state currently being expanded
+    int m_step_scale = 1;
+
+    bool computeIkSolutions(
+        const RobotState& state,
+        const Affine3& goal,
+        ik_option::IkOption option,
+        std::vector<RobotState>& solutions);
+
     bool applyMotionPrimitive(
         const RobotState& state,
         const MotionPrimitive& mp,
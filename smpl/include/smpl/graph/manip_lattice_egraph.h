@@ -32,6 +32,7 @@
 #ifndef SMPL_MANIP_LATTICE_EGRAPH_H
 #define SMPL_MANIP_LATTICE_EGRAPH_H
 
+#include <smpl/geometry/kd_tree.h>
 #include <smpl/graph/experience_graph.h>
 #include <smpl/graph/experience_graph_extension.h>
 #include <smpl/graph/manip_lattice.h>
@@ -47,16 +48,32 @@ public:
     bool extractPath(
         const std::vector<int>& ids,
         std::vector<RobotState>& path) override;
+
+    void clearStates() override;
     ///@}
 
     /// \name Required Public Functions from ExperienceGraphExtension
     ///@{
     bool loadExperienceGraph(const std::string& path) override;
 
+    bool insertExperienceGraphPath(
+        const std::vector<RobotState>& path,
+        double merge_radius) override;
+
     void getExperienceGraphNodes(
         int state_id,
         std::vector<ExperienceGraph::node_id>& nodes) override;
 
+    void getNearestExperienceGraphNodes(
+        const RobotState& state,
+        int k,
+        std::vector<ExperienceGraph::node_id>& nodes) override;
+
+    void getExperienceGraphNodesInRadius(
+        const RobotState& state,
+        double radius,
+        std::vector<ExperienceGraph::node_id>& nodes) override;
+
     bool shortcut(
         int first_id,
         int second_id,
@@ -67,17 +84,43 @@ public:
         int second_id,
         int& cost) override;
 
+    int shortcutBatch(
+        int first_id,
+        const int* second_ids,
+        int n,
+        int* costs) override;
+
+    int snapBatch(
+        int first_id,
+        const int* second_ids,
+        int n,
+        int* costs) override;
+
     const ExperienceGraph* getExperienceGraph() const override;
     ExperienceGraph* getExperienceGraph() override;
 
     int getStateID(ExperienceGraph::node_id n) const override;
     ///@}
 
+    bool saveExperienceGraph(const std::string& path) const;
+
+    /// Set the number of threads used to parse and discretize the
+    /// demonstrations in a directory passed to loadExperienceGraph(). The
+    /// demonstrations are always merged into the experience graph serially,
+    /// in filename order, so the result does not depend on the thread count.
+    void setExperienceGraphLoadThreadCount(int count);
+    int experienceGraphLoadThreadCount() const { return m_egraph_load_threads; }
+
     /// \name Reimplemented Public Functions from Extension
     ///@{
     Extension* getExtension(size_t class_code) override;
     ///@}
 
+    /// \name Reimplemented Public Functions from MemoryUsageExtension
+    ///@{
+    auto memoryUsage() const -> std::size_t override;
+    ///@}
+
 private:
 
     struct RobotCoordHash
@@ -102,6 +145,15 @@ private:
     // map from experience graph node ids to state ids
     std::vector<int> m_egraph_state_ids;
 
+    // joint-space index over experience graph node states
+    geometry::KDTree m_egraph_index;
+
+    int m_egraph_load_threads = 1;
+
+    // scratch for snapBatch
+    std::vector<const RobotState*> m_snap_targets;
+    std::vector<char> m_snap_valid;
+
     bool findShortestExperienceGraphPath(
         ExperienceGraph::node_id u,
         ExperienceGraph::node_id s,
@@ -111,6 +163,19 @@ private:
         const std::string& filepath,
         std::vector<RobotState>& egraph_states) const;
 
+    bool loadExperienceGraphFile(const std::string& path);
+
+    void addExperienceGraphPath(
+        const std::vector<RobotState>& path,
+        double merge_radius);
+
+    void addExperienceGraphPath(
+        const std::vector<RobotState>& path,
+        const std::vector<RobotCoord>& coords,
+        double merge_radius);
+
+    void updateExperienceGraphIndex();
+
     void rasterizeExperienceGraph();
 };
 
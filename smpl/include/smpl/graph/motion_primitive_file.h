@@ -0,0 +1,179 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef SMPL_MOTION_PRIMITIVE_FILE_H
+#define SMPL_MOTION_PRIMITIVE_FILE_H
+
+// standard includes
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// project includes
+#include <smpl/types.h>
+#include <smpl/graph/motion_primitive.h>
+
+namespace smpl {
+
+#define MOTION_PRIMITIVE_FILE_MAGIC "SMPLMPRM"
+#define MOTION_PRIMITIVE_FILE_VERSION 1
+
+/// Fixed-size header at the start of a binary motion primitive file. The
+/// header is followed by these sections:
+///
+///     resolutions double[dof]
+///     primitives  MotionPrimitiveRecord[primitive_count]
+///     deltas      double[waypoint_count * dof]
+///
+/// Only long and short distance primitives are stored. Their deltas are in
+/// radians, already scaled by the lattice resolutions they were generated
+/// for, and each waypoint is relative to the state the primitive is applied
+/// to.
+struct MotionPrimitiveFileHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t dof;
+    std::uint64_t primitive_count;
+    std::uint64_t waypoint_count;
+};
+
+struct MotionPrimitiveRecord
+{
+    std::uint32_t type;             // MotionPrimitive::Type
+    std::uint32_t waypoint_count;
+    std::uint64_t first_waypoint;   // index into the delta section
+    double cost;                    // see MotionPrimitiveCost
+    double max_displacement;        // see MotionPrimitiveMaxDisplacement
+};
+
+/// Prefix that names a POSIX shared memory object, rather than a file, in the
+/// paths accepted by MotionPrimitiveFile::open() and
+/// ManipLatticeActionSpace::load().
+#define MOTION_PRIMITIVE_SHARED_PREFIX "shm:"
+
+/// Read-only memory mapping of a binary motion primitive file. The file is
+/// validated once, when it is opened. The mapping is shared, so planner
+/// processes opening the same file, or attaching the same shared memory object
+/// published with PublishMotionPrimitives(), share a single copy of the
+/// primitives on the host.
+class MotionPrimitiveFile
+{
+public:
+
+    MotionPrimitiveFile() = default;
+    ~MotionPrimitiveFile();
+
+    MotionPrimitiveFile(const MotionPrimitiveFile&) = delete;
+    MotionPrimitiveFile& operator=(const MotionPrimitiveFile&) = delete;
+
+    /// Map the motion primitive file at path, or, if path is of the form
+    /// "shm:<name>", attach the shared memory object <name>.
+    bool open(const std::string& path);
+
+    /// Attach, read-only, the shared memory object published under name.
+    bool openShared(const std::string& name);
+
+    void close();
+
+    bool isOpen() const { return m_data != nullptr; }
+
+    auto dof() const -> std::size_t { return header().dof; }
+    auto num_primitives() const -> std::size_t { return header().primitive_count; }
+
+    /// Return a pointer to the dof() lattice resolutions the primitives were
+    /// generated for.
+    const double* resolutions() const { return m_resolutions; }
+
+    auto record(std::size_t i) const -> const MotionPrimitiveRecord&
+    { return m_records[i]; }
+
+    /// Return a pointer to the deltas of all primitives.
+    const double* deltas() const { return m_deltas; }
+
+    /// Return a pointer to the record(i).waypoint_count * dof() joint deltas
+    /// of the waypoints of the i'th primitive, stored contiguously.
+    const double* deltas(std::size_t i) const
+    { return m_deltas + m_records[i].first_waypoint * dof(); }
+
+private:
+
+    void* m_data = nullptr;
+    std::size_t m_size = 0;
+
+    const double* m_resolutions = nullptr;
+    const MotionPrimitiveRecord* m_records = nullptr;
+    const double* m_deltas = nullptr;
+
+    auto header() const -> const MotionPrimitiveFileHeader&
+    { return *static_cast<const MotionPrimitiveFileHeader*>(m_data); }
+
+    bool map(int fd, const std::string& what);
+};
+
+/// Return the joint space length of the path through the waypoints of a
+/// primitive, starting from the state it is applied to.
+double MotionPrimitiveCost(const Action& deltas);
+
+/// Return the largest displacement of any joint variable, from the state the
+/// primitive is applied to, over all of its waypoints.
+double MotionPrimitiveMaxDisplacement(const Action& deltas);
+
+/// Return true if the file at path begins with the binary motion primitive
+/// magic number.
+bool IsMotionPrimitiveFile(const std::string& path);
+
+/// Return true if path names a shared memory motion primitive set, i.e. begins
+/// with MOTION_PRIMITIVE_SHARED_PREFIX.
+bool IsSharedMotionPrimitives(const std::string& path);
+
+/// Write the long and short distance primitives of a motion primitive set in
+/// the binary format read by MotionPrimitiveFile. All waypoints must have the
+/// same number of variables as there are resolutions.
+bool WriteMotionPrimitiveFile(
+    const std::string& path,
+    const std::vector<MotionPrimitive>& prims,
+    const std::vector<double>& resolutions);
+
+/// Publish a motion primitive set, in the binary file format, as the POSIX
+/// shared memory object name (e.g. "/smpl_mprims"), replacing any previous
+/// object of that name.
+bool PublishMotionPrimitives(
+    const std::string& name,
+    const std::vector<MotionPrimitive>& prims,
+    const std::vector<double>& resolutions);
+
+/// Remove the name of a shared memory motion primitive set. The memory is
+/// released once every attached process has closed it.
+bool UnpublishMotionPrimitives(const std::string& name);
+
+} // namespace smpl
+
+#endif
@@ -0,0 +1,161 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_PACKED_COORD_TABLE_H
+#define SMPL_PACKED_COORD_TABLE_H
+
+// standard includes
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace smpl {
+
+/// A table assigning consecutive ids to fixed-width integer coordinates,
+/// stored bit-packed.
+///
+/// Each column is given the range of values it is expected to hold and is
+/// stored in as few bits as cover that range, packed into 64-bit words with
+/// no column split across two words. Rows of up to eight 8-bit or four 16-bit
+/// columns, for instance, take a single word. Inserting a coordinate with a
+/// value outside the range of its column widens that column to 32 bits and
+/// repacks the table, so any coordinate may be stored, but only coordinates
+/// within the ranges are stored compactly.
+///
+/// Lookups go through an open-addressing index with linear probing, as in
+/// CoordTable, that hashes and compares the packed words of each row.
+class PackedCoordTable
+{
+public:
+
+    PackedCoordTable();
+
+    /// Set the number of integers per coordinate, expecting any value in each
+    /// column. Clears the table.
+    void setWidth(int width);
+
+    /// Set the number of integers per coordinate, min.size(), and the range
+    /// [min[i], max[i]] of values expected in each column. Clears the table.
+    void setRanges(const std::vector<int>& min, const std::vector<int>& max);
+
+    int width() const { return (int)m_columns.size(); }
+
+    /// Number of 64-bit words per packed coordinate.
+    int wordCount() const { return m_word_count; }
+
+    /// Number of ids handed out, including reserved ids.
+    int size() const { return m_size; }
+
+    /// Return the id of a coordinate of width() integers, or -1 if it has not
+    /// been inserted.
+    int find(const int* coord) const;
+
+    /// Assign the next id to a coordinate and index it. The coordinate must
+    /// not already be in the table.
+    int insert(const int* coord);
+
+    /// Assign the next id to a zero coordinate without indexing it.
+    int reserve();
+
+    /// Copy the coordinate with the given id into \p coord.
+    void get(int id, int* coord) const;
+
+    /// Replace the coordinate of a reserved id.
+    void set(int id, const int* coord);
+
+    /// Remove all coordinates, retaining allocated storage, and restore the
+    /// ranges of any widened columns.
+    void clear();
+
+    /// Number of bytes allocated for coordinates and the index.
+    auto memoryUsage() const -> std::size_t
+    {
+        return m_words.capacity() * sizeof(std::uint64_t) +
+                m_slots.capacity() * sizeof(Slot);
+    }
+
+private:
+
+    struct Column
+    {
+        std::int64_t min;
+        int bits;
+        int word;
+        int shift;
+    };
+
+    struct Slot
+    {
+        std::uint32_t hash;
+        int id; // -1 if the slot is empty
+    };
+
+    std::vector<Column> m_columns;
+    int m_word_count;
+    int m_size;
+
+    // ranges given to setRanges(), restored by clear()
+    std::vector<int> m_min;
+    std::vector<int> m_max;
+
+    std::vector<std::uint64_t> m_words;
+
+    // index from packed coordinates to ids; the number of slots is always a
+    // power of two and at least twice the number of indexed ids
+    std::vector<Slot> m_slots;
+    std::size_t m_indexed;
+
+    void layout();
+    bool fits(const int* coord) const;
+    void pack(const int* coord, std::uint64_t* row) const;
+    void unpack(const std::uint64_t* row, int* coord) const;
+    void widen(const int* coord);
+
+    auto row(int id) -> std::uint64_t*
+    {
+        return m_words.data() + (std::size_t)id * m_word_count;
+    }
+
+    auto row(int id) const -> const std::uint64_t*
+    {
+        return m_words.data() + (std::size_t)id * m_word_count;
+    }
+
+    auto hash(const std::uint64_t* row) const -> std::uint32_t;
+    bool equal(const std::uint64_t* a, const std::uint64_t* b) const;
+    void place(std::uint32_t hash, int id);
+    void grow();
+};
+
+} // namespace smpl
+
+#endif
@@ -0,0 +1,96 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_POSE_GOAL_SET_H
+#define SMPL_POSE_GOAL_SET_H
+
+// standard includes
+#include <cstddef>
+#include <vector>
+
+// project includes
+#include <smpl/spatial.h>
+
+namespace smpl {
+
+/// A precomputed test for whether a pose lies within tolerance of any pose in
+/// a set of goal poses, as required by XYZ_RPY_GOAL and MULTIPLE_POSE_GOAL
+/// goal constraints.
+///
+/// A pose is within tolerance of a goal pose if each coordinate of its position
+/// differs from the goal's by no more than the corresponding xyz tolerance and
+/// the angle between the orientations is less than the first rpy tolerance.
+/// The goal poses are stored as separate coordinate arrays sorted by x, so a
+/// query only visits the goals in the slab of x within tolerance of the pose
+/// and tests their positions in branch-free batches before comparing any
+/// orientations. Orientations are compared by the absolute dot product of
+/// unit quaternions against a threshold computed from the tolerance, which
+/// avoids an acos per goal.
+class PoseGoalSet
+{
+public:
+
+    void assign(
+        const Affine3* poses,
+        std::size_t count,
+        const double xyz_tolerance[3],
+        const double rpy_tolerance[3]);
+
+    void clear();
+
+    auto size() const -> std::size_t { return m_x.size(); }
+    bool empty() const { return m_x.empty(); }
+
+    bool contains(const Affine3& pose) const { return find(pose) >= 0; }
+
+    /// Return the index, in the order given to assign(), of a goal pose the
+    /// pose is within tolerance of, or -1 if there is none.
+    int find(const Affine3& pose) const;
+
+private:
+
+    std::vector<double> m_x;
+    std::vector<double> m_y;
+    std::vector<double> m_z;
+    std::vector<double> m_qw;
+    std::vector<double> m_qx;
+    std::vector<double> m_qy;
+    std::vector<double> m_qz;
+    std::vector<int> m_index; // index of each goal pose given to assign()
+
+    double m_xyz_tolerance[3] = { 0.0, 0.0, 0.0 };
+
+    // orientations match when |q . qg| exceeds this value
+    double m_min_abs_dot = 1.0;
+};
+
+} // namespace smpl
+
+#endif
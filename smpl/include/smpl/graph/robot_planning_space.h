@@ -76,6 +76,11 @@ public:
     virtual bool eraseHeuristic(const RobotHeuristic* h);
     virtual bool hasHeuristic(const RobotHeuristic* h);
 
+    /// Discard all states generated so far, retaining allocated storage where
+    /// possible. State ids are reissued afterwards, so any search over this
+    /// space must be restarted from scratch.
+    virtual void clearStates();
+
     RobotModel* robot() { return m_robot; }
     const RobotModel* robot() const { return m_robot; }
 
@@ -182,6 +187,38 @@ public:
     virtual const RobotState& extractState(int state_id) = 0;
 };
 
+/// Exposes the goal of a planning space as a set of goals, so that a search
+/// can tell which goal a state satisfies. A planning space that otherwise maps
+/// every state satisfying its goal onto a single goal state ID keeps the
+/// states' own IDs while it provides this extension.
+class GoalSetExtension : public virtual Extension
+{
+public:
+
+    virtual ~GoalSetExtension() { }
+
+    /// Return the number of goals in the goal set.
+    virtual int goalCount() = 0;
+
+    /// Return the index of a goal satisfied by a state, or -1 if the state
+    /// satisfies none of the goals.
+    virtual int goalIndex(int state_id) = 0;
+};
+
+/// Extension for planning spaces that can release the storage of states that
+/// a search no longer needs, to bound memory during long searches.
+class StateRetirementExtension : public virtual Extension
+{
+public:
+
+    virtual ~StateRetirementExtension() { }
+
+    /// Release the storage of states. State ids remain stable: a retired
+    /// state is recreated, under the same id, when it is generated again, and
+    /// must not be referred to by id until then.
+    virtual void retireStates(const int* state_ids, std::size_t count) = 0;
+};
+
 inline
 size_t RobotPlanningSpace::numHeuristics() const
 {
@@ -19,7 +19,8 @@ public:
     double m_ik_amp_thresh = 0.2;
 
     void apply(
-        const WorkspaceLatticeState& state,
+        const WorkspaceCoord& coord,
+        const RobotState& state,
         std::vector<WorkspaceAction>& actions) override;
 };
 
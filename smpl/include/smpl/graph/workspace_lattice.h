@@ -35,16 +35,21 @@
 
 // standard includes
 #include <chrono>
+#include <memory>
 #include <vector>
 
 // system includes
 #include <sbpl/headers.h>
 
 // project includes
+#include <smpl/arena.h>
 #include <smpl/collision_checker.h>
+#include <smpl/ik_sampler.h>
+#include <smpl/reachability_map.h>
 #include <smpl/robot_model.h>
 #include <smpl/time.h>
 #include <smpl/types.h>
+#include <smpl/graph/coord_table.h>
 #include <smpl/graph/motion_primitive.h>
 #include <smpl/graph/robot_planning_space.h>
 #include <smpl/graph/workspace_lattice_base.h>
@@ -67,15 +72,48 @@ struct WorkspaceLattice :
     WorkspaceLatticeState* m_start_entry = NULL;
     int m_start_state_id = -1;
 
-    // maps state -> id
-    using StateKey = WorkspaceLatticeState;
-    using StateHash = PointerValueHash<StateKey>;
-    using StateEqual = PointerValueEqual<StateKey>;
-    hash_map<StateKey*, int, StateHash, StateEqual> m_state_to_id;
+    // maps from coords to stateID and from stateID to coords
+    CoordTable m_coord_table;
 
     // maps id -> state
     std::vector<WorkspaceLatticeState*> m_states;
 
+    // backing storage for the states in m_states
+    Arena m_state_arena;
+
+    // scratch coordinates reused by successor generation
+    WorkspaceCoord m_parent_coord;
+    WorkspaceCoord m_succ_coord;
+
+    // scratch buffers for solving the final waypoints of lazy successors
+    std::vector<WorkspaceState> m_lazy_final_states;
+    std::vector<RobotState> m_lazy_seeds;
+    std::vector<RobotState> m_lazy_final_rstates;
+    std::vector<std::size_t> m_lazy_ik_misses;
+    std::vector<RobotState> m_lazy_ik_miss_rstates;
+
+    // IK solutions for waypoints, keyed by the workspace coordinate of the
+    // waypoint, which includes the free angle bins. Solutions are shared by
+    // all parents that reach the same coordinate. Failures are cached as empty
+    // states.
+    struct IkCacheKeyHash
+    {
+        typedef WorkspaceCoord argument_type;
+        typedef std::size_t result_type;
+
+        result_type operator()(const argument_type& s) const;
+    };
+
+    bool m_use_ik_cache = false;
+    hash_map<WorkspaceCoord, RobotState, IkCacheKeyHash> m_ik_cache;
+    WorkspaceCoord m_ik_cache_key;
+    std::size_t m_ik_cache_hits = 0;
+    std::size_t m_ik_cache_misses = 0;
+
+    // solves goal poses from several seeds when enabled
+    std::unique_ptr<IKSampler> m_ik_sampler;
+    const ReachabilityMap* m_reachability_map = nullptr;
+
     clock::time_point m_t_start;
     mutable bool m_near_goal = false; // mutable for assignment in isGoal
 
@@ -88,6 +126,32 @@ struct WorkspaceLattice :
     void setVisualizationFrameId(const std::string& frame_id);
     auto visualizationFrameId() const -> const std::string&;
 
+    /// Reuse the IK solution of a waypoint for every waypoint with the same
+    /// workspace coordinate. The cache is cleared when the start state is set.
+    bool useIkCache() const { return m_use_ik_cache; }
+    void useIkCache(bool enable);
+    void clearIkCache();
+    auto ikCacheHits() const -> std::size_t { return m_ik_cache_hits; }
+    auto ikCacheMisses() const -> std::size_t { return m_ik_cache_misses; }
+
+    /// Solve IK for goal poses from \p seed_count seeds on \p thread_count
+    /// threads, accepting only collision-free solutions. A seed count of 1
+    /// uses a single IK query from the given seed.
+    bool setIkSampling(int seed_count, int thread_count = 1);
+    int ikSamplingSeeds() const;
+
+    /// Seed goal IK from a reachability map, which must outlive this lattice.
+    /// When IK from the given seed fails, or when sampling seeds, the map's
+    /// seed for the goal pose is tried as well.
+    void setReachabilityMap(const ReachabilityMap* map);
+    auto reachabilityMap() const -> const ReachabilityMap*
+    { return m_reachability_map; }
+
+    bool computeGoalIK(
+        const Affine3& pose,
+        const RobotState& seed,
+        RobotState& solution);
+
     /// \name Reimplemented Public Functions from WorkspaceLatticeBase
     ///@{
     bool init(
@@ -106,6 +170,7 @@ struct WorkspaceLattice :
     ///@{
     bool setStart(const RobotState& state) override;
     bool setGoal(const GoalConstraint& goal) override;
+    void clearStates() override;
     ///@}
 
     /// \name Required Public Functions from RobotPlanningSpace
@@ -158,8 +223,18 @@ struct WorkspaceLattice :
     bool setUserGoal(const GoalConstraint& goal);
 
     int reserveHashEntry();
+    int reserveHashEntry(const WorkspaceCoord& coord, const RobotState& state);
     int createState(const WorkspaceCoord& coord);
+    void addHashEntry(int state_id);
     auto getState(int state_id) const -> WorkspaceLatticeState*;
+    auto getStateCoord(int state_id) const -> const int*;
+    void getStateCoord(int state_id, WorkspaceCoord& coord) const;
+    bool stateHasCoord(int state_id, const WorkspaceCoord& coord) const;
+
+    bool solveWaypoint(
+        const WorkspaceState& waypoint,
+        const RobotState& seed,
+        RobotState& ostate);
 
     bool checkAction(
         const RobotState& state,
@@ -170,10 +245,10 @@ struct WorkspaceLattice :
         const WorkspaceLatticeState& src,
         const WorkspaceLatticeState& dst);
 
-    bool checkLazyAction(
+    void checkLazyActions(
         const RobotState& state,
-        const WorkspaceAction& action,
-        RobotState* final_rstate = nullptr);
+        const std::vector<WorkspaceAction>& actions,
+        std::vector<RobotState>& final_rstates);
 
     bool isGoal(const WorkspaceState& state, const RobotState& robot_state) const;
 
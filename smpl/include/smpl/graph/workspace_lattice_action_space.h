@@ -13,8 +13,11 @@ struct WorkspaceLatticeActionSpace
 {
     virtual ~WorkspaceLatticeActionSpace() { }
 
+    /// \brief Append the actions available from a lattice entry, given its
+    ///     discrete coordinate and its robot state.
     virtual void apply(
-        const WorkspaceLatticeState& state,
+        const WorkspaceCoord& coord,
+        const RobotState& state,
         std::vector<WorkspaceAction>& actions) = 0;
 };
 
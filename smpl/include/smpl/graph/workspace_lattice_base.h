@@ -96,6 +96,14 @@ public:
     bool stateWorkspaceToRobot(
         const WorkspaceState& state, const RobotState& seed, RobotState& ostate) const;
 
+    // solve for n workspace states at once; ostates[i] is left empty if no
+    // solution was found. Returns the number of solutions found.
+    int stateWorkspaceToRobotBatch(
+        const WorkspaceState* states,
+        const RobotState* seeds,
+        int n,
+        RobotState* ostates) const;
+
     // TODO: variants of workspace -> robot that don't restrict redundant angles
     // TODO: variants of workspace -> robot that take in a full seed state
 
@@ -2,6 +2,7 @@
 #define SMPL_WORKSPACE_LATTICE_EGRAPH_H
 
 #include <smpl/types.h>
+#include <smpl/geometry/kd_tree.h>
 #include <smpl/graph/workspace_lattice.h>
 #include <smpl/graph/experience_graph_extension.h>
 #include <smpl/graph/experience_graph.h>
@@ -33,6 +34,9 @@ public:
     // map from state id back to e-graph node
     hash_map<int, ExperienceGraph::node_id> m_state_to_egraph_node;
 
+    // joint-space index over e-graph node states
+    geometry::KDTree m_egraph_index;
+
     void getUniqueSuccs(
         int state_id,
         std::vector<int>* succs,
@@ -58,30 +62,53 @@ public:
 
     void getOrigStateSuccs(
         smpl::WorkspaceLatticeState* state,
+        const WorkspaceCoord& coord,
         std::vector<int>* succs,
         std::vector<int>* costs);
 
     void getOrigStateBridgeSuccs(
         WorkspaceLatticeState* state,
+        const WorkspaceCoord& coord,
         std::vector<int>* succs,
         std::vector<int>* costs);
 
     void getOrigStateOrigSuccs(
         WorkspaceLatticeState* state,
+        const WorkspaceCoord& coord,
         std::vector<int>* succs,
         std::vector<int>* costs);
 
-    void insertExperienceGraphPath(const std::vector<smpl::RobotState>& path);
+    void addExperienceGraphPath(
+        const std::vector<smpl::RobotState>& path,
+        double merge_radius);
     void clearExperienceGraph();
 
+    bool loadExperienceGraphFile(const std::string& path);
+    bool saveExperienceGraph(const std::string& path) const;
+    void updateExperienceGraphIndex();
+
     /// \name ExperienceGraphExtension Interface
     ///@{
     bool loadExperienceGraph(const std::string& path) override;
 
+    bool insertExperienceGraphPath(
+        const std::vector<RobotState>& path,
+        double merge_radius) override;
+
     void getExperienceGraphNodes(
         int state_id,
         std::vector<ExperienceGraph::node_id>& nodes) override;
 
+    void getNearestExperienceGraphNodes(
+        const RobotState& state,
+        int k,
+        std::vector<ExperienceGraph::node_id>& nodes) override;
+
+    void getExperienceGraphNodesInRadius(
+        const RobotState& state,
+        double radius,
+        std::vector<ExperienceGraph::node_id>& nodes) override;
+
     bool shortcut(int src_id, int dst_id, int& cost) override;
 
     bool snap(int first_id, int second_id, int& cost) override;
@@ -97,6 +124,8 @@ public:
     bool extractPath(
         const std::vector<int>& ids,
         std::vector<RobotState>& path) override;
+
+    void clearStates() override;
     ///@}
 
     /// \name DiscreteSpaceInformation Interface
@@ -29,34 +29,15 @@ using WorkspaceCoord = std::vector<int>;
 
 using WorkspaceAction = std::vector<WorkspaceState>;
 
+/// The state of a lattice entry. The discrete coordinate of each entry is
+/// stored separately, inline in the lattice's coordinate table.
 struct WorkspaceLatticeState
 {
-    WorkspaceCoord coord;
-    RobotState state;
+    RobotState state;   // corresponding continuous coordinate
 };
 
-std::ostream& operator<<(std::ostream& o, const WorkspaceLatticeState& s);
-
-inline
-bool operator==(const WorkspaceLatticeState& a, const WorkspaceLatticeState& b)
-{
-    return a.coord == b.coord;
-}
-
 } // namespace smpl
 
-namespace std {
-
-template <>
-struct hash<smpl::WorkspaceLatticeState>
-{
-    typedef smpl::WorkspaceLatticeState argument_type;
-    typedef std::size_t result_type;
-    result_type operator()(const argument_type& s) const;
-};
-
-} // namespace std
-
 
 #endif
 
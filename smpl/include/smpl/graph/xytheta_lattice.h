@@ -0,0 +1,255 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_XYTHETA_LATTICE_H
+#define SMPL_XYTHETA_LATTICE_H
+
+// standard includes
+#include <utility>
+#include <vector>
+
+// project includes
+#include <smpl/occupancy_grid.h>
+#include <smpl/spatial.h>
+#include <smpl/types.h>
+#include <smpl/graph/coord_table.h>
+#include <smpl/graph/robot_planning_space.h>
+#include <smpl/steer/swept_footprint.h>
+#include <smpl/unicycle/pose_2d.h>
+
+namespace smpl {
+
+/// A motion primitive of an (x, y, theta) lattice, expressed relative to the
+/// center of the cell in which it starts.
+struct XYThetaPrimitive
+{
+    int start_heading;
+    int end_heading;
+    int dx;
+    int dy;
+    int cost;
+
+    /// Poses along the motion, relative to the start cell center, ending at
+    /// the end pose. The start pose is not included.
+    std::vector<Pose2D> poses;
+
+    /// Cells swept by the footprint over the whole motion, start pose
+    /// included, relative to the start cell.
+    std::vector<std::pair<int, int>> cells;
+
+    /// The swept cells, packed for testing against an OccupancySlice
+    SweptFootprint swept;
+};
+
+/// \class Discrete (x, y, theta) space for a mobile base
+///
+/// Positions are discretized to the cells of an occupancy grid and headings to
+/// a fixed number of directions. Motion primitives are generated once, at
+/// initialization, for every start heading: each is a minimum-length Dubins
+/// curve to a nearby lattice pose, optionally plus backward motions, turns in
+/// place and constant body velocities of a steer model. Each primitive stores
+/// its cost, its intermediate poses and the grid cells swept by the robot
+/// footprint along it, so checking a successor is a test of those cells
+/// against a bitmap of the grid rather than a call to the collision checker.
+/// Cells of a single horizontal slice of the grid with a distance of zero are
+/// obstacles. The bitmap is rebuilt on every call to setStart(); call
+/// updateOccupancySlice() if the grid changes during a search.
+///
+/// The robot model must have three variables, x, y and theta, in that order.
+class XYThetaLattice :
+    public RobotPlanningSpace,
+    public PoseProjectionExtension,
+    public ExtractRobotStateExtension
+{
+public:
+
+    struct Params
+    {
+        /// Number of discrete headings; must be a multiple of 4.
+        int num_headings = 16;
+
+        /// Minimum turning radius, in meters.
+        double turning_radius = 1.0;
+
+        /// Length of the longest forward primitive, in cells. Primitives of
+        /// one cell and of this length are generated for each heading change.
+        int long_primitive_cells = 4;
+
+        /// Largest heading change of a single primitive, in discrete headings.
+        int max_heading_change = 1;
+
+        /// Generate primitives that drive straight backward, with costs scaled
+        /// by this multiplier; 0 disables them.
+        double backward_cost_mult = 0.0;
+
+        /// Cost of turning in place by one discrete heading; 0 disables
+        /// turns in place.
+        int turn_in_place_cost = 0;
+
+        /// Additional primitives that drive a constant body-frame velocity
+        /// (vx, vy, vtheta), e.g. one computed with WheelToBody for a steer
+        /// model, for body_velocity_duration seconds. The end pose is snapped
+        /// to the nearest lattice pose and the snapping error is spread
+        /// evenly over the motion.
+        std::vector<Vector3> body_velocities;
+        double body_velocity_duration = 1.0;
+
+        /// Footprint polygon in the robot frame, in meters. An empty footprint
+        /// sweeps only the cells along the primitive.
+        std::vector<Vector2> footprint;
+
+        /// Height, in the grid frame, of the slice of cells checked for
+        /// obstacles.
+        double height = 0.0;
+    };
+
+    ~XYThetaLattice();
+
+    bool init(
+        RobotModel* robot,
+        CollisionChecker* checker,
+        const OccupancyGrid* grid,
+        const Params& params);
+
+    auto params() const -> const Params& { return m_params; }
+    auto grid() const -> const OccupancyGrid* { return m_grid; }
+
+    int numHeadings() const { return m_params.num_headings; }
+    double headingAngle(int heading) const;
+    int angleToHeading(double theta) const;
+
+    /// Return the primitives that start at a heading.
+    auto primitives(int heading) const -> const std::vector<XYThetaPrimitive>&
+    { return m_prims[heading]; }
+
+    /// Return the cells covered by the footprint at a heading, relative to the
+    /// cell of the robot.
+    auto footprintCells(int heading) const
+        -> const std::vector<std::pair<int, int>>&
+    { return m_footprint_cells[heading]; }
+
+    /// Return whether none of a set of cells, offset by (x, y), is an obstacle
+    /// or out of bounds.
+    bool cellsFree(int x, int y, const std::vector<std::pair<int, int>>& cells) const;
+
+    /// Return whether a swept footprint, offset by (x, y), is free, according
+    /// to the current occupancy slice.
+    bool sweptFree(int x, int y, const SweptFootprint& swept) const
+    { return m_slice.isFree(x, y, swept); }
+
+    /// Rebuild the occupancy slice from the grid.
+    void updateOccupancySlice();
+
+    void clearStates() override;
+
+    /// \name Required Public Functions from ExtractRobotStateExtension
+    ///@{
+    auto extractState(int state_id) -> const RobotState& override;
+    ///@}
+
+    /// \name Required Public Functions from PoseProjectionExtension
+    ///@{
+    bool projectToPose(int state_id, Affine3& pose) override;
+    ///@}
+
+    /// \name Required Public Functions from RobotPlanningSpace
+    ///@{
+    bool setStart(const RobotState& state) override;
+    bool setGoal(const GoalConstraint& goal) override;
+    int getStartStateID() const override;
+    int getGoalStateID() const override;
+
+    /// Return the states along a path, including the intermediate poses of
+    /// the primitives between lattice states.
+    bool extractPath(
+        const std::vector<int>& ids,
+        std::vector<RobotState>& path) override;
+    ///@}
+
+    /// \name Required Public Functions from Extension
+    ///@{
+    Extension* getExtension(size_t class_code) override;
+    ///@}
+
+    /// \name Required Public Functions from DiscreteSpaceInformation
+    ///@{
+    void GetSuccs(
+        int state_id,
+        std::vector<int>* succs,
+        std::vector<int>* costs) override;
+    void GetPreds(
+        int state_id,
+        std::vector<int>* preds,
+        std::vector<int>* costs) override;
+    void PrintState(int state_id, bool verbose, FILE* fout = nullptr) override;
+    ///@}
+
+private:
+
+    const OccupancyGrid* m_grid = nullptr;
+    int m_grid_z = 0;
+    Params m_params;
+
+    // primitives indexed by start heading, and the (start heading, index)
+    // pairs of the primitives that end at each heading
+    std::vector<std::vector<XYThetaPrimitive>> m_prims;
+    std::vector<std::vector<std::pair<int, int>>> m_prims_to;
+
+    std::vector<std::vector<std::pair<int, int>>> m_footprint_cells;
+    std::vector<SweptFootprint> m_footprint_swept;
+
+    OccupancySlice m_slice;
+
+    // maps between (x, y, heading) coordinates and state ids
+    CoordTable m_coord_table;
+    std::vector<RobotState> m_states;
+
+    int m_start_state_id = -1;
+    int m_goal_state_id = -1;
+
+    void makePrimitives();
+    bool makePrimitive(
+        int heading,
+        const Pose2D& end_pose,
+        XYThetaPrimitive& prim) const;
+    void makeBodyVelocityPrimitives();
+    void addSweptCells(const Pose2D& pose, std::vector<std::pair<int, int>>& cells) const;
+
+    auto coordToState(const int* coord) const -> RobotState;
+    void stateToCoord(const RobotState& state, int* coord) const;
+    int getOrCreateState(const int* coord);
+
+    bool isGoal(const RobotState& state) const;
+    auto stateAt(int x, int y, const Pose2D& offset) const -> RobotState;
+};
+
+} // namespace smpl
+
+#endif
@@ -0,0 +1,167 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_BRICK_GRID_H
+#define SMPL_BRICK_GRID_H
+
+// standard includes
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+namespace smpl {
+
+/// This class represents a resizeable three-dimensional array of sparse data,
+/// stored as a flat table of dense bricks of (2^BrickBits)^3 cells. Bricks are
+/// allocated on first non-const access to any of their cells; cells in
+/// unallocated bricks implicitly have the grid's default value.
+///
+/// Compared to SparseGrid, lookups are a constant-time table index followed by
+/// an offset into the brick, and the memory overhead for untouched regions is
+/// one pointer per brick. This makes it suitable for large, mostly uniform
+/// volumes whose non-uniform regions are spatially clustered, such as the
+/// cells of a distance map within the propagation distance of an obstacle.
+///
+/// Copies of a grid share their bricks. A shared brick is duplicated on the
+/// first non-const access to any of its cells, so copying a grid costs one
+/// pointer per brick and each copy then pays only for the bricks it modifies.
+///
+/// Pointers and references to cells in allocated bricks remain valid until the
+/// brick is released by prune(), reset(), or resize(), or until the grid is
+/// copied, after which the brick may be duplicated by the next non-const
+/// access to it.
+template <class T, int BrickBits = 3>
+class BrickGrid
+{
+public:
+
+    using value_type        = T;
+    using size_type         = std::size_t;
+    using reference         = value_type&;
+    using const_reference   = const value_type&;
+    using index_type        = int;
+
+    static constexpr int BRICK_SIZE = 1 << BrickBits;
+    static constexpr int BRICK_CELL_COUNT = BRICK_SIZE * BRICK_SIZE * BRICK_SIZE;
+
+    BrickGrid();
+    BrickGrid(const T& value);
+    BrickGrid(size_type size_x, size_type size_y, size_type size_z);
+    BrickGrid(
+        size_type size_x, size_type size_y, size_type size_z,
+        const T& value);
+
+    BrickGrid(const BrickGrid& o);
+    BrickGrid(BrickGrid&& o) = default;
+
+    BrickGrid& operator=(const BrickGrid& rhs);
+    BrickGrid& operator=(BrickGrid&& rhs) = default;
+
+    /// \name Size Properties
+    ///@{
+    size_type size() const;
+    size_type size_x() const { return m_size[0]; }
+    size_type size_y() const { return m_size[1]; }
+    size_type size_z() const { return m_size[2]; }
+
+    size_type brick_count() const;
+    size_type allocated_brick_count() const;
+
+    /// Number of allocated bricks that are shared with copies of this grid.
+    size_type shared_brick_count() const;
+
+    size_type mem_usage() const;
+    ///@}
+
+    /// \name Element Access
+    ///@{
+    const_reference operator()(index_type x, index_type y, index_type z) const;
+
+    reference operator()(index_type x, index_type y, index_type z);
+
+    const_reference get(index_type x, index_type y, index_type z) const;
+
+    bool allocated(index_type x, index_type y, index_type z) const;
+
+    /// Return whether all 26 neighbors of a cell lie in the same brick. The
+    /// neighbor in direction (dx, dy, dz) of such a cell is located at
+    /// neighbor_offset(dx, dy, dz) from the cell.
+    static bool brick_interior(index_type x, index_type y, index_type z);
+    static int neighbor_offset(int dx, int dy, int dz);
+    ///@}
+
+    /// \name Modifiers
+    ///@{
+    void reset(const T& value);
+    void assign(const T& value);
+
+    void set(index_type x, index_type y, index_type z, const T& data);
+
+    void prune();
+
+    template <class UnaryPredicate>
+    void prune(UnaryPredicate p);
+
+    void resize(size_type size_x, size_type size_y, size_type size_z);
+    void resize(size_type size_x, size_type size_y, size_type size_z, const T& value);
+    ///@}
+
+    /// Call c(value, first_x, first_y, first_z, last_x, last_y, last_z) for
+    /// each allocated cell and for each unallocated brick, in which case the
+    /// value is the default value.
+    template <typename Callable>
+    void accept_coords(Callable c) const;
+
+private:
+
+    struct Brick
+    {
+        T cells[BRICK_CELL_COUNT];
+    };
+
+    std::vector<std::shared_ptr<Brick>> m_bricks;
+    T m_value;
+
+    size_type m_size[3];
+    size_type m_brick_dims[3];
+
+    size_type brick_index(index_type x, index_type y, index_type z) const;
+    static int cell_index(index_type x, index_type y, index_type z);
+
+    Brick* create_brick();
+};
+
+} // namespace smpl
+
+#include "detail/brick_grid.hpp"
+
+#endif
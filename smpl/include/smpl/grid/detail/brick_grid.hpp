@@ -0,0 +1,345 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_BRICK_GRID_HPP
+#define SMPL_BRICK_GRID_HPP
+
+#include "../brick_grid.h"
+
+// standard includes
+#include <assert.h>
+#include <algorithm>
+
+namespace smpl {
+
+template <class T, int BrickBits>
+BrickGrid<T, BrickBits>::BrickGrid() :
+    m_bricks(),
+    m_value()
+{
+    m_size[0] = m_size[1] = m_size[2] = 0;
+    m_brick_dims[0] = m_brick_dims[1] = m_brick_dims[2] = 0;
+}
+
+template <class T, int BrickBits>
+BrickGrid<T, BrickBits>::BrickGrid(const T& value) :
+    m_bricks(),
+    m_value(value)
+{
+    m_size[0] = m_size[1] = m_size[2] = 0;
+    m_brick_dims[0] = m_brick_dims[1] = m_brick_dims[2] = 0;
+}
+
+template <class T, int BrickBits>
+BrickGrid<T, BrickBits>::BrickGrid(
+    size_type size_x,
+    size_type size_y,
+    size_type size_z)
+:
+    BrickGrid()
+{
+    resize(size_x, size_y, size_z);
+}
+
+template <class T, int BrickBits>
+BrickGrid<T, BrickBits>::BrickGrid(
+    size_type size_x,
+    size_type size_y,
+    size_type size_z,
+    const T& value)
+:
+    BrickGrid(value)
+{
+    resize(size_x, size_y, size_z);
+}
+
+/// Construct a copy of a grid that shares its bricks until they are modified.
+template <class T, int BrickBits>
+BrickGrid<T, BrickBits>::BrickGrid(const BrickGrid& o) :
+    m_bricks(o.m_bricks),
+    m_value(o.m_value)
+{
+    std::copy(o.m_size, o.m_size + 3, m_size);
+    std::copy(o.m_brick_dims, o.m_brick_dims + 3, m_brick_dims);
+}
+
+template <class T, int BrickBits>
+BrickGrid<T, BrickBits>&
+BrickGrid<T, BrickBits>::operator=(const BrickGrid& rhs)
+{
+    if (this != &rhs) {
+        BrickGrid tmp(rhs);
+        *this = std::move(tmp);
+    }
+    return *this;
+}
+
+template <class T, int BrickBits>
+typename BrickGrid<T, BrickBits>::size_type
+BrickGrid<T, BrickBits>::size() const
+{
+    return m_size[0] * m_size[1] * m_size[2];
+}
+
+template <class T, int BrickBits>
+typename BrickGrid<T, BrickBits>::size_type
+BrickGrid<T, BrickBits>::brick_count() const
+{
+    return m_bricks.size();
+}
+
+template <class T, int BrickBits>
+typename BrickGrid<T, BrickBits>::size_type
+BrickGrid<T, BrickBits>::allocated_brick_count() const
+{
+    return std::count_if(
+            m_bricks.begin(), m_bricks.end(),
+            [](const std::shared_ptr<Brick>& b) { return (bool)b; });
+}
+
+template <class T, int BrickBits>
+typename BrickGrid<T, BrickBits>::size_type
+BrickGrid<T, BrickBits>::shared_brick_count() const
+{
+    return std::count_if(
+            m_bricks.begin(), m_bricks.end(),
+            [](const std::shared_ptr<Brick>& b) { return b && b.use_count() > 1; });
+}
+
+template <class T, int BrickBits>
+typename BrickGrid<T, BrickBits>::size_type
+BrickGrid<T, BrickBits>::mem_usage() const
+{
+    return sizeof(*this) +
+            m_bricks.capacity() * sizeof(std::shared_ptr<Brick>) +
+            allocated_brick_count() * sizeof(Brick);
+}
+
+template <class T, int BrickBits>
+typename BrickGrid<T, BrickBits>::const_reference
+BrickGrid<T, BrickBits>::operator()(
+    index_type x,
+    index_type y,
+    index_type z) const
+{
+    return get(x, y, z);
+}
+
+template <class T, int BrickBits>
+typename BrickGrid<T, BrickBits>::reference
+BrickGrid<T, BrickBits>::operator()(index_type x, index_type y, index_type z)
+{
+    std::shared_ptr<Brick>& b = m_bricks[brick_index(x, y, z)];
+    if (!b) {
+        b.reset(create_brick());
+    } else if (b.use_count() > 1) {
+        b = std::make_shared<Brick>(*b);
+    }
+    return b->cells[cell_index(x, y, z)];
+}
+
+template <class T, int BrickBits>
+typename BrickGrid<T, BrickBits>::const_reference
+BrickGrid<T, BrickBits>::get(index_type x, index_type y, index_type z) const
+{
+    const Brick* b = m_bricks[brick_index(x, y, z)].get();
+    return b ? b->cells[cell_index(x, y, z)] : m_value;
+}
+
+template <class T, int BrickBits>
+bool BrickGrid<T, BrickBits>::allocated(
+    index_type x,
+    index_type y,
+    index_type z) const
+{
+    return (bool)m_bricks[brick_index(x, y, z)];
+}
+
+template <class T, int BrickBits>
+bool BrickGrid<T, BrickBits>::brick_interior(
+    index_type x,
+    index_type y,
+    index_type z)
+{
+    const unsigned int mask = BRICK_SIZE - 1;
+    const unsigned int last = BRICK_SIZE - 2;
+    return ((x & mask) - 1u < last) &
+            ((y & mask) - 1u < last) &
+            ((z & mask) - 1u < last);
+}
+
+template <class T, int BrickBits>
+int BrickGrid<T, BrickBits>::neighbor_offset(int dx, int dy, int dz)
+{
+    return (dx << (2 * BrickBits)) + (dy << BrickBits) + dz;
+}
+
+/// Reset so that all cells have identical values. Releases all bricks.
+template <class T, int BrickBits>
+void BrickGrid<T, BrickBits>::reset(const T& value)
+{
+    m_value = value;
+    for (auto& b : m_bricks) {
+        b.reset();
+    }
+}
+
+template <class T, int BrickBits>
+void BrickGrid<T, BrickBits>::assign(const T& value)
+{
+    return reset(value);
+}
+
+template <class T, int BrickBits>
+void BrickGrid<T, BrickBits>::set(
+    index_type x, index_type y, index_type z, const T& data)
+{
+    (*this)(x, y, z) = data;
+}
+
+/// Release all bricks whose cells are all equal to the default value.
+template <class T, int BrickBits>
+void BrickGrid<T, BrickBits>::prune()
+{
+    prune([&](const T& value) { return value == m_value; });
+}
+
+/// Release all bricks whose cells all satisfy the predicate. Their cells take
+/// on the default value.
+template <class T, int BrickBits>
+template <class UnaryPredicate>
+void BrickGrid<T, BrickBits>::prune(UnaryPredicate p)
+{
+    for (auto& b : m_bricks) {
+        if (b && std::all_of(b->cells, b->cells + BRICK_CELL_COUNT, p)) {
+            b.reset();
+        }
+    }
+}
+
+template <class T, int BrickBits>
+void BrickGrid<T, BrickBits>::resize(
+    size_type size_x,
+    size_type size_y,
+    size_type size_z)
+{
+    resize(size_x, size_y, size_z, m_value);
+}
+
+/// Resize the grid. All bricks are released and all cells take on the given
+/// value.
+template <class T, int BrickBits>
+void BrickGrid<T, BrickBits>::resize(
+    size_type size_x,
+    size_type size_y,
+    size_type size_z,
+    const T& value)
+{
+    m_size[0] = size_x;
+    m_size[1] = size_y;
+    m_size[2] = size_z;
+    for (int i = 0; i < 3; ++i) {
+        m_brick_dims[i] = (m_size[i] + BRICK_SIZE - 1) >> BrickBits;
+    }
+    m_bricks.clear();
+    m_bricks.resize(m_brick_dims[0] * m_brick_dims[1] * m_brick_dims[2]);
+    m_value = value;
+}
+
+template <class T, int BrickBits>
+template <typename Callable>
+void BrickGrid<T, BrickBits>::accept_coords(Callable c) const
+{
+    for (size_type bx = 0; bx < m_brick_dims[0]; ++bx) {
+    for (size_type by = 0; by < m_brick_dims[1]; ++by) {
+    for (size_type bz = 0; bz < m_brick_dims[2]; ++bz) {
+        const size_type first_x = bx << BrickBits;
+        const size_type first_y = by << BrickBits;
+        const size_type first_z = bz << BrickBits;
+        const size_type last_x = std::min(first_x + BRICK_SIZE, m_size[0]);
+        const size_type last_y = std::min(first_y + BRICK_SIZE, m_size[1]);
+        const size_type last_z = std::min(first_z + BRICK_SIZE, m_size[2]);
+
+        const Brick* b =
+                m_bricks[(bx * m_brick_dims[1] + by) * m_brick_dims[2] + bz].get();
+        if (!b) {
+            c(m_value, first_x, first_y, first_z, last_x, last_y, last_z);
+            continue;
+        }
+
+        for (size_type x = first_x; x < last_x; ++x) {
+        for (size_type y = first_y; y < last_y; ++y) {
+        for (size_type z = first_z; z < last_z; ++z) {
+            c(b->cells[cell_index(x, y, z)], x, y, z, x + 1, y + 1, z + 1);
+        }
+        }
+        }
+    }
+    }
+    }
+}
+
+template <class T, int BrickBits>
+typename BrickGrid<T, BrickBits>::size_type
+BrickGrid<T, BrickBits>::brick_index(
+    index_type x,
+    index_type y,
+    index_type z) const
+{
+    assert(x >= 0 && x < (index_type)m_size[0]);
+    assert(y >= 0 && y < (index_type)m_size[1]);
+    assert(z >= 0 && z < (index_type)m_size[2]);
+    const size_type bx = (size_type)x >> BrickBits;
+    const size_type by = (size_type)y >> BrickBits;
+    const size_type bz = (size_type)z >> BrickBits;
+    return (bx * m_brick_dims[1] + by) * m_brick_dims[2] + bz;
+}
+
+template <class T, int BrickBits>
+int BrickGrid<T, BrickBits>::cell_index(index_type x, index_type y, index_type z)
+{
+    const int mask = BRICK_SIZE - 1;
+    return ((((x & mask) << BrickBits) | (y & mask)) << BrickBits) | (z & mask);
+}
+
+template <class T, int BrickBits>
+typename BrickGrid<T, BrickBits>::Brick*
+BrickGrid<T, BrickBits>::create_brick()
+{
+    Brick* b = new Brick;
+    std::fill(b->cells, b->cells + BRICK_CELL_COUNT, m_value);
+    return b;
+}
+
+} // namespace smpl
+
+#endif
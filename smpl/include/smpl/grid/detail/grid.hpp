@@ -35,62 +35,164 @@
 #include "../grid.h"
 
 #include <algorithm>
+#include <limits>
+#include <new>
 #include <stdexcept>
+#include <utility>
+
+#include <smpl/large_alloc.h>
 
 namespace smpl {
 
-template <typename T>
-Grid3<T>::Grid3() : m_data(nullptr), m_dims()
+inline
+void RowMajorLayout::init(std::size_t xdim, std::size_t ydim, std::size_t zdim)
+{
+    m_xdim = xdim;
+    m_ydim = ydim;
+    m_zdim = zdim;
+}
+
+inline
+std::size_t RowMajorLayout::index(
+    std::size_t x,
+    std::size_t y,
+    std::size_t z) const
+{
+    return m_zdim * (x * m_ydim + y) + z;
+}
+
+inline
+void RowMajorLayout::coord(
+    std::size_t i,
+    std::size_t& x,
+    std::size_t& y,
+    std::size_t& z) const
+{
+    x = i / (m_ydim * m_zdim);
+    y = (i - x * m_ydim * m_zdim) / m_zdim;
+    z = i - (x * m_ydim * m_zdim) - y * m_zdim;
+}
+
+template <int BrickBits>
+const int MortonLayout<BrickBits>::BrickSize;
+
+template <int BrickBits>
+const int MortonLayout<BrickBits>::BrickCells;
+
+template <int BrickBits>
+void MortonLayout<BrickBits>::init(
+    std::size_t xdim,
+    std::size_t ydim,
+    std::size_t zdim)
+{
+    m_xbricks = (xdim + BrickSize - 1) >> BrickBits;
+    m_ybricks = (ydim + BrickSize - 1) >> BrickBits;
+    m_zbricks = (zdim + BrickSize - 1) >> BrickBits;
+}
+
+template <int BrickBits>
+std::size_t MortonLayout<BrickBits>::index(
+    std::size_t x,
+    std::size_t y,
+    std::size_t z) const
+{
+    const std::size_t brick =
+            ((x >> BrickBits) * m_ybricks + (y >> BrickBits)) * m_zbricks +
+            (z >> BrickBits);
+
+    // interleave the bits of the coordinates within the brick, z lowest
+    std::size_t offset = 0;
+    for (int b = 0; b < BrickBits; ++b) {
+        offset |= ((z >> b) & 1) << (3 * b + 0);
+        offset |= ((y >> b) & 1) << (3 * b + 1);
+        offset |= ((x >> b) & 1) << (3 * b + 2);
+    }
+
+    return brick * BrickCells + offset;
+}
+
+template <int BrickBits>
+void MortonLayout<BrickBits>::coord(
+    std::size_t i,
+    std::size_t& x,
+    std::size_t& y,
+    std::size_t& z) const
+{
+    const std::size_t brick = i / BrickCells;
+    const std::size_t offset = i % BrickCells;
+
+    const std::size_t bx = brick / (m_ybricks * m_zbricks);
+    const std::size_t by = (brick - bx * m_ybricks * m_zbricks) / m_zbricks;
+    const std::size_t bz = brick - (bx * m_ybricks * m_zbricks) - by * m_zbricks;
+
+    x = bx << BrickBits;
+    y = by << BrickBits;
+    z = bz << BrickBits;
+    for (int b = 0; b < BrickBits; ++b) {
+        z |= ((offset >> (3 * b + 0)) & 1) << b;
+        y |= ((offset >> (3 * b + 1)) & 1) << b;
+        x |= ((offset >> (3 * b + 2)) & 1) << b;
+    }
+}
+
+template <typename T, typename Layout>
+Grid3<T, Layout>::Grid3() : m_data(nullptr), m_dims(), m_layout()
 {
     m_dims[0] = 0;
     m_dims[1] = 0;
     m_dims[2] = 0;
 }
 
-template <typename T>
-Grid3<T>::Grid3(
+template <typename T, typename Layout>
+Grid3<T, Layout>::Grid3(
     size_type xdim,
     size_type ydim,
     size_type zdim,
     const T& value)
 :
-    m_data(new T[xdim * ydim * zdim]),
-    m_dims()
+    m_data(nullptr),
+    m_dims(),
+    m_layout()
 {
-    std::fill(m_data, m_data + (xdim * ydim * zdim), value);
+    m_layout.init(xdim, ydim, zdim);
+    m_data = AllocateCells(m_layout.capacity());
+    std::fill(m_data, m_data + m_layout.capacity(), value);
     m_dims[0] = xdim;
     m_dims[1] = ydim;
     m_dims[2] = zdim;
 }
 
-template <typename T>
-Grid3<T>::Grid3(
+template <typename T, typename Layout>
+Grid3<T, Layout>::Grid3(
     size_type xdim,
     size_type ydim,
     size_type zdim)
 :
-    m_data(new T[xdim * ydim * zdim]),
-    m_dims()
+    m_data(nullptr),
+    m_dims(),
+    m_layout()
 {
+    m_layout.init(xdim, ydim, zdim);
+    m_data = AllocateCells(m_layout.capacity());
     m_dims[0] = xdim;
     m_dims[1] = ydim;
     m_dims[2] = zdim;
 }
 
-template <typename T>
-Grid3<T>::Grid3(const Grid3& other) :
-    m_data(new T[other.m_dims[0] * other.m_dims[1] * other.m_dims[2]]),
-    m_dims()
+template <typename T, typename Layout>
+Grid3<T, Layout>::Grid3(const Grid3& other) :
+    m_data(AllocateCells(other.size())),
+    m_dims(),
+    m_layout(other.m_layout)
 {
-    size_type total_size = other.m_dims[0] * other.m_dims[1] * other.m_dims[2];
-    std::copy(other.m_data, other.m_data + total_size, m_data);
+    std::copy(other.m_data, other.m_data + other.size(), m_data);
     m_dims[0] = other.m_dims[0];
     m_dims[1] = other.m_dims[1];
     m_dims[2] = other.m_dims[2];
 }
 
-template <typename T>
-Grid3<T>::Grid3(Grid3&& other)
+template <typename T, typename Layout>
+Grid3<T, Layout>::Grid3(Grid3&& other) : m_layout(other.m_layout)
 {
     m_data = other.m_data;
     m_dims[0] = other.m_dims[0];
@@ -100,75 +202,74 @@ Grid3<T>::Grid3(Grid3&& other)
     other.m_dims[0] = 0;
     other.m_dims[1] = 0;
     other.m_dims[2] = 0;
+    other.m_layout = Layout();
 }
 
-template <typename T>
-Grid3<T>::~Grid3()
+template <typename T, typename Layout>
+Grid3<T, Layout>::~Grid3()
 {
      if (m_data) {
-         delete [] m_data;
+         DeallocateCells(m_data, size());
      }
      m_dims[0] = 0;
      m_dims[1] = 0;
      m_dims[2] = 0;
 }
 
-template <typename T>
-Grid3<T>& Grid3<T>::operator=(const Grid3& rhs)
+template <typename T, typename Layout>
+Grid3<T, Layout>& Grid3<T, Layout>::operator=(const Grid3& rhs)
 {
     if (this != &rhs) {
         if (m_data) {
-            delete [] m_data;
+            DeallocateCells(m_data, size());
         }
 
-        size_type total_size = rhs.m_dims[0] * rhs.m_dims[1] * rhs.m_dims[2];
-        m_data = new T[total_size];
-        std::copy(rhs.m_data, rhs.m_data + total_size, m_data);
+        m_data = AllocateCells(rhs.size());
+        std::copy(rhs.m_data, rhs.m_data + rhs.size(), m_data);
         m_dims[0] = rhs.m_dims[0];
         m_dims[1] = rhs.m_dims[1];
         m_dims[2] = rhs.m_dims[2];
+        m_layout = rhs.m_layout;
     }
     return *this;
 }
 
-template <typename T>
-Grid3<T>& Grid3<T>::operator=(Grid3&& rhs)
+template <typename T, typename Layout>
+Grid3<T, Layout>& Grid3<T, Layout>::operator=(Grid3&& rhs)
 {
     if (this != &rhs) {
         if (m_data) {
-            delete [] m_data;
+            DeallocateCells(m_data, size());
         }
 
         m_data = rhs.m_data;
         m_dims[0] = rhs.m_dims[0];
         m_dims[1] = rhs.m_dims[1];
         m_dims[2] = rhs.m_dims[2];
+        m_layout = rhs.m_layout;
         rhs.m_data = nullptr;
         rhs.m_dims[0] = 0;
         rhs.m_dims[1] = 0;
         rhs.m_dims[2] = 0;
+        rhs.m_layout = Layout();
     }
     return *this;
 }
 
-template <typename T>
-void Grid3<T>::assign(
+template <typename T, typename Layout>
+void Grid3<T, Layout>::assign(
     size_type xdim,
     size_type ydim,
     size_type zdim,
     const T& value)
 {
-    size_type total_size = xdim * ydim * zdim;
-    resize(total_size);
-    m_dims[0] = xdim;
-    m_dims[1] = ydim;
-    m_dims[2] = zdim;
-    std::fill(m_data, m_data + total_size, value);
+    resize(xdim, ydim, zdim);
+    std::fill(m_data, m_data + size(), value);
 }
 
-template <typename T>
-typename Grid3<T>::reference
-Grid3<T>::at(size_type x, size_type y, size_type z)
+template <typename T, typename Layout>
+typename Grid3<T, Layout>::reference
+Grid3<T, Layout>::at(size_type x, size_type y, size_type z)
 {
     if (!in_bounds(x, y, z)) {
         throw std::out_of_range("Grid3<T>::at called with invalid coordinates");
@@ -176,9 +277,9 @@ Grid3<T>::at(size_type x, size_type y, size_type z)
     return m_data[coord_to_index(x, y, z)];
 }
 
-template <typename T>
-typename Grid3<T>::const_reference
-Grid3<T>::at(size_type x, size_type y, size_type z) const
+template <typename T, typename Layout>
+typename Grid3<T, Layout>::const_reference
+Grid3<T, Layout>::at(size_type x, size_type y, size_type z) const
 {
     if (!in_bounds(x, y, z)) {
         throw std::out_of_range("Grid3<T>::at called with invalid coordinates");
@@ -186,164 +287,169 @@ Grid3<T>::at(size_type x, size_type y, size_type z) const
     return m_data[coord_to_index(x, y, z)];
 }
 
-template <typename T>
-typename Grid3<T>::reference
-Grid3<T>::operator[](size_type pos)
+template <typename T, typename Layout>
+typename Grid3<T, Layout>::reference
+Grid3<T, Layout>::operator[](size_type pos)
 {
     return m_data[pos];
 }
 
-template <typename T>
-typename Grid3<T>::const_reference
-Grid3<T>::operator[](size_type pos) const
+template <typename T, typename Layout>
+typename Grid3<T, Layout>::const_reference
+Grid3<T, Layout>::operator[](size_type pos) const
 {
     return m_data[pos];
 }
 
-template <typename T>
-typename Grid3<T>::reference
-Grid3<T>::operator()(size_type x, size_type y, size_type z)
+template <typename T, typename Layout>
+typename Grid3<T, Layout>::reference
+Grid3<T, Layout>::operator()(size_type x, size_type y, size_type z)
 {
     return m_data[coord_to_index(x, y, z)];
 }
 
-template <typename T>
-typename Grid3<T>::const_reference
-Grid3<T>::operator()(size_type x, size_type y, size_type z) const
+template <typename T, typename Layout>
+typename Grid3<T, Layout>::const_reference
+Grid3<T, Layout>::operator()(size_type x, size_type y, size_type z) const
 {
     return m_data[coord_to_index(x, y, z)];
 }
 
-template <typename T>
-T* Grid3<T>::data()
+template <typename T, typename Layout>
+T* Grid3<T, Layout>::data()
 {
     return m_data;
 }
 
-template <typename T>
-const T* Grid3<T>::data() const
+template <typename T, typename Layout>
+const T* Grid3<T, Layout>::data() const
 {
     return m_data;
 }
 
-template <typename T>
-typename Grid3<T>::iterator Grid3<T>::begin()
+template <typename T, typename Layout>
+typename Grid3<T, Layout>::iterator Grid3<T, Layout>::begin()
 {
     return m_data;
 }
 
-template <typename T>
-typename Grid3<T>::const_iterator Grid3<T>::begin() const
+template <typename T, typename Layout>
+typename Grid3<T, Layout>::const_iterator Grid3<T, Layout>::begin() const
 {
     return m_data;
 }
 
-template <typename T>
-typename Grid3<T>::const_iterator Grid3<T>::cbegin() const
+template <typename T, typename Layout>
+typename Grid3<T, Layout>::const_iterator Grid3<T, Layout>::cbegin() const
 {
     return m_data;
 }
 
-template <typename T>
-typename Grid3<T>::iterator Grid3<T>::end()
+template <typename T, typename Layout>
+typename Grid3<T, Layout>::iterator Grid3<T, Layout>::end()
 {
     return m_data + size();
 }
 
-template <typename T>
-typename Grid3<T>::const_iterator Grid3<T>::end() const
+template <typename T, typename Layout>
+typename Grid3<T, Layout>::const_iterator Grid3<T, Layout>::end() const
 {
     return m_data + size();
 }
 
-template <typename T>
-typename Grid3<T>::const_iterator Grid3<T>::cend() const
+template <typename T, typename Layout>
+typename Grid3<T, Layout>::const_iterator Grid3<T, Layout>::cend() const
 {
     return m_data + size();
 }
 
-template <typename T>
-typename Grid3<T>::reverse_iterator Grid3<T>::rbegin()
+template <typename T, typename Layout>
+typename Grid3<T, Layout>::reverse_iterator Grid3<T, Layout>::rbegin()
 {
     // TODO: implement
     return reverse_iterator(begin());
 }
 
-template <typename T>
-typename Grid3<T>::const_reverse_iterator
-Grid3<T>::rbegin() const
+template <typename T, typename Layout>
+typename Grid3<T, Layout>::const_reverse_iterator
+Grid3<T, Layout>::rbegin() const
 {
     // TODO: implement
     return const_reverse_iterator(begin());
 }
 
-template <typename T>
-typename Grid3<T>::const_reverse_iterator
-Grid3<T>::crbegin() const
+template <typename T, typename Layout>
+typename Grid3<T, Layout>::const_reverse_iterator
+Grid3<T, Layout>::crbegin() const
 {
     // TODO: implement
     return const_reverse_iterator(begin());
 }
 
-template <typename T>
-typename Grid3<T>::reverse_iterator Grid3<T>::rend()
+template <typename T, typename Layout>
+typename Grid3<T, Layout>::reverse_iterator Grid3<T, Layout>::rend()
 {
     // TODO: implement
     return reverse_iterator(end());
 }
 
-template <typename T>
-typename Grid3<T>::const_reverse_iterator
-Grid3<T>::rend() const
+template <typename T, typename Layout>
+typename Grid3<T, Layout>::const_reverse_iterator
+Grid3<T, Layout>::rend() const
 {
     // TODO: implement
     return const_reverse_iterator(end());
 }
 
-template <typename T>
-typename Grid3<T>::const_reverse_iterator
-Grid3<T>::crend() const
+template <typename T, typename Layout>
+typename Grid3<T, Layout>::const_reverse_iterator
+Grid3<T, Layout>::crend() const
 {
     // TODO: implement
     return const_reverse_iterator(end());
 }
 
-template <typename T>
-typename Grid3<T>::size_type Grid3<T>::size() const
+/// Return the number of cells of storage, which includes any padding added by
+/// the layout.
+template <typename T, typename Layout>
+typename Grid3<T, Layout>::size_type Grid3<T, Layout>::size() const
 {
-    return m_dims[0] * m_dims[1] * m_dims[2];
+    return m_layout.capacity();
 }
 
-template <typename T>
-typename Grid3<T>::size_type Grid3<T>::max_size() const
+template <typename T, typename Layout>
+typename Grid3<T, Layout>::size_type Grid3<T, Layout>::max_size() const
 {
     return std::numeric_limits<size_type>::max();
 }
 
-template <typename T>
-void Grid3<T>::clear()
+template <typename T, typename Layout>
+void Grid3<T, Layout>::clear()
 {
     if (m_data) {
-        delete [] m_data;
+        DeallocateCells(m_data, size());
         m_data = nullptr;
     }
     m_dims[0] = 0;
     m_dims[1] = 0;
     m_dims[2] = 0;
+    m_layout = Layout();
 }
 
-template <typename T>
-void Grid3<T>::resize(size_type xdim, size_type ydim, size_type zdim)
+template <typename T, typename Layout>
+void Grid3<T, Layout>::resize(size_type xdim, size_type ydim, size_type zdim)
 {
-    size_type total_size = xdim * ydim * zdim;
-    resize(total_size);
+    Layout layout;
+    layout.init(xdim, ydim, zdim);
+    resize(layout.capacity());
+    m_layout = layout;
     m_dims[0] = xdim;
     m_dims[1] = ydim;
     m_dims[2] = zdim;
 }
 
-template <typename T>
-void Grid3<T>::resize(
+template <typename T, typename Layout>
+void Grid3<T, Layout>::resize(
     size_type xdim,
     size_type ydim,
     size_type zdim,
@@ -352,49 +458,79 @@ void Grid3<T>::resize(
     assign(xdim, ydim, zdim, value);
 }
 
-template <typename T>
-void Grid3<T>::swap(Grid3& other)
+template <typename T, typename Layout>
+void Grid3<T, Layout>::swap(Grid3& other)
 {
-    // TODO: implement
+    using std::swap;
+    swap(m_data, other.m_data);
+    swap(m_dims[0], other.m_dims[0]);
+    swap(m_dims[1], other.m_dims[1]);
+    swap(m_dims[2], other.m_dims[2]);
+    swap(m_layout, other.m_layout);
 }
 
-template <typename T>
-typename Grid3<T>::size_type
-Grid3<T>::coord_to_index(size_type x, size_type y, size_type z) const
+template <typename T, typename Layout>
+typename Grid3<T, Layout>::size_type
+Grid3<T, Layout>::coord_to_index(size_type x, size_type y, size_type z) const
 {
-    return m_dims[2] * (x * m_dims[1] + y) + z;
+    return m_layout.index(x, y, z);
 }
 
-template <typename T>
+template <typename T, typename Layout>
 void
-Grid3<T>::index_to_coord(
+Grid3<T, Layout>::index_to_coord(
     size_type i,
     size_type& x,
     size_type& y,
     size_type& z) const
 {
-    x = i / (m_dims[1] * m_dims[2]);
-    y = (i - x * m_dims[1] * m_dims[2]) / m_dims[2];
-    z = i - (x * m_dims[1] * m_dims[2]) - y * m_dims[2];
+    m_layout.coord(i, x, y, z);
 }
 
-template <typename T>
-bool Grid3<T>::in_bounds(size_type x, size_type y, size_type z) const
+template <typename T, typename Layout>
+bool Grid3<T, Layout>::in_bounds(size_type x, size_type y, size_type z) const
 {
     return x < m_dims[0] & y < m_dims[1] & z < m_dims[2];
 }
 
-template <typename T>
-void Grid3<T>::resize(size_type count)
+template <typename T, typename Layout>
+void Grid3<T, Layout>::resize(size_type count)
 {
     if (size() != count) {
         if (m_data) {
-            delete [] m_data;
+            DeallocateCells(m_data, size());
         }
-        m_data = new T[count];
+        m_data = AllocateCells(count);
     }
 }
 
+/// Cell storage is obtained through AllocateLarge(), so that large grids are
+/// subject to the process-wide LargeAllocOptions.
+template <typename T, typename Layout>
+T* Grid3<T, Layout>::AllocateCells(size_type count)
+{
+    T* data = static_cast<T*>(AllocateLarge(count * sizeof(T)));
+    for (size_type i = 0; i < count; ++i) {
+        new (data + i) T;
+    }
+    return data;
+}
+
+template <typename T, typename Layout>
+void Grid3<T, Layout>::DeallocateCells(T* data, size_type count)
+{
+    for (size_type i = 0; i < count; ++i) {
+        data[i].~T();
+    }
+    DeallocateLarge(data, count * sizeof(T));
+}
+
+template <typename T, typename Layout>
+void swap(Grid3<T, Layout>& lhs, Grid3<T, Layout>& rhs)
+{
+    lhs.swap(rhs);
+}
+
 } // namespace smpl
 
 #endif
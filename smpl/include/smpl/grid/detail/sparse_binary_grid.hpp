@@ -4,6 +4,7 @@
 #include "../sparse_binary_grid.h"
 
 #include <stdio.h>
+#include <algorithm>
 
 namespace smpl {
 
@@ -257,6 +258,87 @@ void SparseBinaryGrid<Allocator>::resize(
     m_grid.resize(reduced(size_x), reduced(size_y), reduced(size_z), initval(value));
 }
 
+/// Set the value of every cell in a sequence of cell coordinates. Each element
+/// must provide its coordinates via operator[](0..2), as with Eigen::Vector3i
+/// or std::array<int, 3>. The tree is pruned once after all cells are set.
+template <class Allocator>
+template <class InputIt>
+void SparseBinaryGrid<Allocator>::set_cells(
+    InputIt first,
+    InputIt last,
+    bool value)
+{
+    for (; first != last; ++first) {
+        set_lazy((*first)[0], (*first)[1], (*first)[2], value);
+    }
+    m_grid.prune();
+}
+
+template <class Allocator>
+void SparseBinaryGrid<Allocator>::set_union(const SparseBinaryGrid& o)
+{
+    m_grid.combine(o.m_grid, [](std::uint8_t a, std::uint8_t b)
+    {
+        return (std::uint8_t)(a | b);
+    });
+}
+
+template <class Allocator>
+void SparseBinaryGrid<Allocator>::set_intersection(const SparseBinaryGrid& o)
+{
+    m_grid.combine(o.m_grid, [](std::uint8_t a, std::uint8_t b)
+    {
+        return (std::uint8_t)(a & b);
+    });
+}
+
+template <class Allocator>
+void SparseBinaryGrid<Allocator>::set_difference(const SparseBinaryGrid& o)
+{
+    m_grid.combine(o.m_grid, [](std::uint8_t a, std::uint8_t b)
+    {
+        return (std::uint8_t)(a & ~b);
+    });
+}
+
+/// Return the number of set cells within the box [min, max).
+template <class Allocator>
+auto SparseBinaryGrid<Allocator>::count(
+    index_type min_x, index_type min_y, index_type min_z,
+    index_type max_x, index_type max_y, index_type max_z) const -> size_type
+{
+    Box box = {
+        { std::max(min_x, 0), std::max(min_y, 0), std::max(min_z, 0) },
+        {
+            std::min(max_x, (index_type)size_x()),
+            std::min(max_y, (index_type)size_y()),
+            std::min(max_z, (index_type)size_z())
+        }
+    };
+    return count_node(m_grid.tree().root(), 0, 0, 0, 1u << max_depth(), box);
+}
+
+/// Find a set cell within the box [min, max). Cells are searched in the
+/// depth-first order of the underlying tree. Return false if no cell within
+/// the box is set.
+template <class Allocator>
+bool SparseBinaryGrid<Allocator>::find_first(
+    index_type min_x, index_type min_y, index_type min_z,
+    index_type max_x, index_type max_y, index_type max_z,
+    index_type& x, index_type& y, index_type& z) const
+{
+    Box box = {
+        { std::max(min_x, 0), std::max(min_y, 0), std::max(min_z, 0) },
+        {
+            std::min(max_x, (index_type)size_x()),
+            std::min(max_y, (index_type)size_y()),
+            std::min(max_z, (index_type)size_z())
+        }
+    };
+    return find_first_node(
+            m_grid.tree().root(), 0, 0, 0, 1u << max_depth(), box, x, y, z);
+}
+
 template <class Allocator>
 template <class Pred>
 auto SparseBinaryGrid<Allocator>::mem_usage_full(const Pred& pred) -> size_type
@@ -271,6 +353,131 @@ void SparseBinaryGrid<Allocator>::accept_coords(Callable c)
     return m_grid.accept_coords(c);
 }
 
+// Intersect the box with the original cells covered by a node with the given
+// first reduced coordinates and span. Return false if the intersection is
+// empty.
+template <class Allocator>
+bool SparseBinaryGrid<Allocator>::clip_node(
+    const Box& box,
+    index_type first_x, index_type first_y, index_type first_z,
+    size_type span,
+    Box& clipped) const
+{
+    const index_type first[3] = { first_x, first_y, first_z };
+    for (int i = 0; i < 3; ++i) {
+        clipped.min[i] = std::max(box.min[i], first[i] << 1);
+        clipped.max[i] = std::min(box.max[i], (index_type)((first[i] + span) << 1));
+        if (clipped.min[i] >= clipped.max[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <class Allocator>
+auto SparseBinaryGrid<Allocator>::count_node(
+    const node_type* n,
+    index_type first_x, index_type first_y, index_type first_z,
+    size_type span,
+    const Box& box) const -> size_type
+{
+    Box c;
+    if (!clip_node(box, first_x, first_y, first_z, span, c)) {
+        return 0;
+    }
+
+    if (n->children) {
+        const index_type half = span >> 1;
+        size_type total = 0;
+        for (int i = 0; i < 8; ++i) {
+            total += count_node(
+                    &n->children[i],
+                    first_x + ((i >> 2) & 1) * half,
+                    first_y + ((i >> 1) & 1) * half,
+                    first_z + (i & 1) * half,
+                    half,
+                    box);
+        }
+        return total;
+    }
+
+    if (n->value == 0x00) {
+        return 0;
+    }
+
+    // number of cells with even and odd coordinates along each axis
+    size_type parity_count[3][2];
+    for (int i = 0; i < 3; ++i) {
+        for (int p = 0; p < 2; ++p) {
+            parity_count[i][p] =
+                    (c.max[i] + 1 - p) / 2 - (c.min[i] + 1 - p) / 2;
+        }
+    }
+
+    // the value's bit pattern repeats every 2 cells along each axis
+    size_type total = 0;
+    for (int bit = 0; bit < 8; ++bit) {
+        if (n->value & (1 << bit)) {
+            total += parity_count[0][(bit >> 2) & 1] *
+                    parity_count[1][(bit >> 1) & 1] *
+                    parity_count[2][bit & 1];
+        }
+    }
+    return total;
+}
+
+template <class Allocator>
+bool SparseBinaryGrid<Allocator>::find_first_node(
+    const node_type* n,
+    index_type first_x, index_type first_y, index_type first_z,
+    size_type span,
+    const Box& box,
+    index_type& x, index_type& y, index_type& z) const
+{
+    Box c;
+    if (!clip_node(box, first_x, first_y, first_z, span, c)) {
+        return false;
+    }
+
+    if (n->children) {
+        const index_type half = span >> 1;
+        for (int i = 0; i < 8; ++i) {
+            if (find_first_node(
+                    &n->children[i],
+                    first_x + ((i >> 2) & 1) * half,
+                    first_y + ((i >> 1) & 1) * half,
+                    first_z + (i & 1) * half,
+                    half,
+                    box,
+                    x, y, z))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    if (n->value == 0x00) {
+        return false;
+    }
+
+    // the value's bit pattern repeats every 2 cells along each axis, so a set
+    // cell, if any, lies within 2 cells of the clipped corner
+    for (index_type cx = c.min[0]; cx < std::min(c.min[0] + 2, c.max[0]); ++cx) {
+    for (index_type cy = c.min[1]; cy < std::min(c.min[1] + 2, c.max[1]); ++cy) {
+    for (index_type cz = c.min[2]; cz < std::min(c.min[2] + 2, c.max[2]); ++cz) {
+        if (n->value & get_mask(cx, cy, cz)) {
+            x = cx;
+            y = cy;
+            z = cz;
+            return true;
+        }
+    }
+    }
+    }
+    return false;
+}
+
 template <class Allocator>
 std::uint8_t SparseBinaryGrid<Allocator>::initval(bool value) const
 {
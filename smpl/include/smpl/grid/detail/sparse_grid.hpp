@@ -36,10 +36,14 @@
 
 // standard includes
 #include <assert.h>
+#include <algorithm>
 #include <limits>
 
 namespace smpl {
 
+template <class T, class Allocator>
+constexpr int SparseGrid<T, Allocator>::block_size;
+
 template <class T, class Allocator>
 SparseGrid<T, Allocator>::SparseGrid() :
     m_tree(),
@@ -276,7 +280,49 @@ SparseGrid<T, Allocator>::get(index_type x, index_type y, index_type z) const
     return get_node(m_max_depth, m_tree.root(), x, y, z)->value;
 }
 
+/// Copy the values of the block_size^3 cells starting at (x, y, z) into
+/// \p values, stored in the same x-major order as Grid3, with
+/// values[(i * block_size + j) * block_size + k] holding cell
+/// (x + i, y + j, z + k). The block origin must be a multiple of block_size
+/// and the grid must be at least block_size cells deep. The octree is
+/// traversed once per block rather than once per cell, and uniform subtrees
+/// are copied with a fill.
+template <class T, class Allocator>
+void SparseGrid<T, Allocator>::get_block(
+    index_type x, index_type y, index_type z, T* values) const
+{
+    assert(m_max_depth >= 3);
+    assert(x % block_size == 0 && y % block_size == 0 && z % block_size == 0);
+    get_block_node(m_max_depth, m_tree.root(), x, y, z, values);
+}
+
+/// Set the values of the block_size^3 cells starting at (x, y, z) from
+/// \p values, in the layout described for get_block(). Subtrees of the block
+/// that hold a single value are stored as one leaf, and the block and its
+/// ancestors are collapsed where possible, so the result is pruned as if each
+/// cell had been assigned with set().
+template <class T, class Allocator>
+void SparseGrid<T, Allocator>::set_block(
+    index_type x, index_type y, index_type z, const T* values)
+{
+    assert(m_max_depth >= 3);
+    assert(x % block_size == 0 && y % block_size == 0 && z % block_size == 0);
+    set_block_node(m_max_depth, m_tree.root(), x, y, z, values);
+}
+
 /// Return the approximate number of bytes used by an equivalent dense grid.
+/// Replace the value of every cell with op(value, o_value), where o_value is
+/// the value of the corresponding cell in another grid of the same size. The
+/// operation is applied once per pair of overlapping leaf nodes rather than
+/// once per cell, and subtrees that become uniform are collapsed.
+template <class T, class Allocator>
+template <class BinaryOp>
+void SparseGrid<T, Allocator>::combine(const SparseGrid& o, BinaryOp op)
+{
+    assert(m_max_depth == o.m_max_depth);
+    combine_node(m_tree.root(), o.m_tree.root(), op);
+}
+
 template <class T, class Allocator>
 template <class Pred>
 typename SparseGrid<T, Allocator>::size_type
@@ -322,6 +368,16 @@ void SparseGrid<T, Allocator>::accept_coords(Callable c)
     accept_coords(c, m_tree.root(), 0, 0, 0, max_coord, max_coord, max_coord);
 }
 
+/// Return the range of leaves of the underlying octree. Leaves span the full
+/// 2^max_depth() extent of the tree and may extend past the grid's size.
+template <class T, class Allocator>
+auto SparseGrid<T, Allocator>::leaves() const
+    -> std::pair<leaf_iterator, leaf_iterator>
+{
+    return std::make_pair(
+            leaf_iterator(m_tree.root(), m_max_depth), leaf_iterator());
+}
+
 template <class T, class Allocator>
 int SparseGrid<T, Allocator>::compute_max_depth(
     size_type size_x,
@@ -587,6 +643,220 @@ bool SparseGrid<T, Allocator>::prune(node_type* n, UnaryPredicate p)
     }
 }
 
+template <class T, class Allocator>
+template <class BinaryOp>
+void SparseGrid<T, Allocator>::combine_node(
+    node_type* n,
+    const node_type* o,
+    BinaryOp op)
+{
+    if (!o->children) {
+        const T& ovalue = o->value;
+        transform_node(n, [&](const T& value) { return op(value, ovalue); });
+        return;
+    }
+
+    if (!n->children) {
+        m_tree.expand_node(n);
+    }
+
+    for (int i = 0; i < 8; ++i) {
+        combine_node(&n->children[i], &o->children[i], op);
+    }
+    collapse_leaves(n);
+}
+
+template <class T, class Allocator>
+template <class UnaryOp>
+void SparseGrid<T, Allocator>::transform_node(node_type* n, UnaryOp op)
+{
+    if (!n->children) {
+        n->value = op(n->value);
+        return;
+    }
+
+    for (node_type* c = n->children; c != n->children + 8; ++c) {
+        transform_node(c, op);
+    }
+    collapse_leaves(n);
+}
+
+/// Collapse a node whose children are all leaves with identical values.
+template <class T, class Allocator>
+bool SparseGrid<T, Allocator>::collapse_leaves(node_type* n)
+{
+    for (node_type* c = n->children; c != n->children + 8; ++c) {
+        if (c->children) {
+            return false;
+        }
+    }
+    if (collapsible(n)) {
+        m_tree.collapse_node(n, n->children[0].value);
+        return true;
+    }
+    return false;
+}
+
+template <class T, class Allocator>
+void SparseGrid<T, Allocator>::get_block_node(
+    int rdepth,
+    const node_type* n,
+    index_type x,
+    index_type y,
+    index_type z,
+    T* values) const
+{
+    if (rdepth == 3) {
+        read_block(rdepth, n, 0, 0, 0, values);
+        return;
+    }
+
+    if (!n->children) {
+        std::fill(values, values + block_size * block_size * block_size, n->value);
+        return;
+    }
+
+    --rdepth;
+
+    index_type x_loc = x >> rdepth;
+    index_type y_loc = y >> rdepth;
+    index_type z_loc = z >> rdepth;
+    index_type cidx = x_loc << 2 | y_loc << 1 | z_loc;
+
+    get_block_node(
+            rdepth, &n->children[cidx],
+            x - (x_loc << rdepth),
+            y - (y_loc << rdepth),
+            z - (z_loc << rdepth),
+            values);
+}
+
+/// Return whether the node is a leaf after the block has been written.
+template <class T, class Allocator>
+bool SparseGrid<T, Allocator>::set_block_node(
+    int rdepth,
+    node_type* n,
+    index_type x,
+    index_type y,
+    index_type z,
+    const T* values)
+{
+    if (rdepth == 3) {
+        write_block(rdepth, n, 0, 0, 0, values);
+        return !n->children;
+    }
+
+    --rdepth;
+
+    index_type x_loc = x >> rdepth;
+    index_type y_loc = y >> rdepth;
+    index_type z_loc = z >> rdepth;
+    index_type cidx = x_loc << 2 | y_loc << 1 | z_loc;
+
+    if (n->children) {
+        // need to recurse
+    } else if (std::all_of(
+            values, values + block_size * block_size * block_size,
+            [&](const T& value) { return std::equal_to<T>()(value, n->value); }))
+    {
+        return true;
+    } else {
+        m_tree.expand_node(n);
+    }
+
+    if (set_block_node(rdepth, &n->children[cidx],
+            x - (x_loc << rdepth),
+            y - (y_loc << rdepth),
+            z - (z_loc << rdepth),
+            values))
+    {
+        return collapse_leaves(n);
+    }
+
+    return false;
+}
+
+// Copy the cells of the (2^rdepth)^3 subtree rooted at n into the block at
+// offset (ox, oy, oz).
+template <class T, class Allocator>
+void SparseGrid<T, Allocator>::read_block(
+    int rdepth,
+    const node_type* n,
+    index_type ox,
+    index_type oy,
+    index_type oz,
+    T* values) const
+{
+    if (!n->children) {
+        index_type span = 1 << rdepth;
+        for (index_type i = ox; i < ox + span; ++i) {
+        for (index_type j = oy; j < oy + span; ++j) {
+            auto* row = values + (i * block_size + j) * block_size;
+            std::fill(row + oz, row + oz + span, n->value);
+        }
+        }
+        return;
+    }
+
+    --rdepth;
+    index_type half = 1 << rdepth;
+    for (int c = 0; c < 8; ++c) {
+        read_block(
+                rdepth, &n->children[c],
+                ox + ((c >> 2) & 1) * half,
+                oy + ((c >> 1) & 1) * half,
+                oz + (c & 1) * half,
+                values);
+    }
+}
+
+// Write the cells of the block at offset (ox, oy, oz) into the
+// (2^rdepth)^3 subtree rooted at n, storing uniform regions as leaves.
+template <class T, class Allocator>
+void SparseGrid<T, Allocator>::write_block(
+    int rdepth,
+    node_type* n,
+    index_type ox,
+    index_type oy,
+    index_type oz,
+    const T* values)
+{
+    index_type span = 1 << rdepth;
+    const T& first = values[(ox * block_size + oy) * block_size + oz];
+    bool uniform = true;
+    for (index_type i = ox; uniform && i < ox + span; ++i) {
+    for (index_type j = oy; uniform && j < oy + span; ++j) {
+        auto* row = values + (i * block_size + j) * block_size;
+        uniform = std::all_of(row + oz, row + oz + span,
+                [&](const T& value) { return std::equal_to<T>()(value, first); });
+    }
+    }
+
+    if (uniform) {
+        if (n->children) {
+            m_tree.collapse_node(n, first);
+        } else {
+            n->value = first;
+        }
+        return;
+    }
+
+    if (!n->children) {
+        m_tree.expand_node(n);
+    }
+
+    --rdepth;
+    index_type half = 1 << rdepth;
+    for (int c = 0; c < 8; ++c) {
+        write_block(
+                rdepth, &n->children[c],
+                ox + ((c >> 2) & 1) * half,
+                oy + ((c >> 1) & 1) * half,
+                oz + (c & 1) * half,
+                values);
+    }
+}
+
 template <class T, class Allocator>
 template <typename Callable>
 void SparseGrid<T, Allocator>::accept_coords(
@@ -616,6 +886,81 @@ void SparseGrid<T, Allocator>::accept_coords(
     }
 }
 
+template <class T, class Allocator>
+SparseGrid<T, Allocator>::leaf_iterator::leaf_iterator(
+    const node_type* root,
+    int max_depth)
+{
+    m_stack.push_back(Frame{ root, 0, 0, 0, max_depth });
+    descend();
+}
+
+template <class T, class Allocator>
+auto SparseGrid<T, Allocator>::leaf_iterator::operator++() -> leaf_iterator&
+{
+    m_stack.pop_back();
+    descend();
+    return *this;
+}
+
+template <class T, class Allocator>
+auto SparseGrid<T, Allocator>::leaf_iterator::operator++(int) -> leaf_iterator
+{
+    leaf_iterator i(*this);
+    ++(*this);
+    return i;
+}
+
+/// Iterators compare equal when both are past the end or both refer to the
+/// same leaf.
+template <class T, class Allocator>
+bool SparseGrid<T, Allocator>::leaf_iterator::operator==(
+    const leaf_iterator& i) const
+{
+    if (m_stack.empty() || i.m_stack.empty()) {
+        return m_stack.empty() && i.m_stack.empty();
+    }
+    return m_stack.back().n == i.m_stack.back().n;
+}
+
+template <class T, class Allocator>
+bool SparseGrid<T, Allocator>::leaf_iterator::operator!=(
+    const leaf_iterator& i) const
+{
+    return !(*this == i);
+}
+
+// Replace internal nodes at the top of the stack with their children until a
+// leaf is on top, and record it. Children are pushed in reverse so that they
+// are visited in the same order as accept_coords().
+template <class T, class Allocator>
+void SparseGrid<T, Allocator>::leaf_iterator::descend()
+{
+    while (!m_stack.empty() && m_stack.back().n->children) {
+        auto f = m_stack.back();
+        m_stack.pop_back();
+        auto rdepth = f.rdepth - 1;
+        index_type half = 1 << rdepth;
+        for (int c = 7; c >= 0; --c) {
+            m_stack.push_back(Frame{
+                    &f.n->children[c],
+                    f.x + ((c >> 2) & 1) * half,
+                    f.y + ((c >> 1) & 1) * half,
+                    f.z + (c & 1) * half,
+                    rdepth });
+        }
+    }
+
+    if (!m_stack.empty()) {
+        auto& f = m_stack.back();
+        m_leaf.value = &f.n->value;
+        m_leaf.x = f.x;
+        m_leaf.y = f.y;
+        m_leaf.z = f.z;
+        m_leaf.size = size_type(1) << f.rdepth;
+    }
+}
+
 } // namespace smpl
 
 #endif
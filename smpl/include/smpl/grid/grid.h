@@ -37,7 +37,59 @@
 
 namespace smpl {
 
-template <typename T>
+/// Layout policy for Grid3 storing cells in row-major order, with the z
+/// coordinate varying fastest.
+class RowMajorLayout
+{
+public:
+
+    void init(std::size_t xdim, std::size_t ydim, std::size_t zdim);
+
+    /// Return the number of cells of storage required by the grid.
+    std::size_t capacity() const { return m_xdim * m_ydim * m_zdim; }
+
+    std::size_t index(std::size_t x, std::size_t y, std::size_t z) const;
+    void coord(std::size_t i, std::size_t& x, std::size_t& y, std::size_t& z) const;
+
+private:
+
+    std::size_t m_xdim = 0;
+    std::size_t m_ydim = 0;
+    std::size_t m_zdim = 0;
+};
+
+/// Layout policy for Grid3 storing cells in cubic bricks of 2^BrickBits cells
+/// along each axis. The cells within a brick are stored in Morton (Z-curve)
+/// order and the bricks are stored in row-major order, so that the neighbors of
+/// a cell usually lie in the same few cache lines and pages. The dimensions of
+/// the grid are padded to multiples of the brick size.
+template <int BrickBits = 2>
+class MortonLayout
+{
+public:
+
+    static const int BrickSize = 1 << BrickBits;
+    static const int BrickCells = 1 << (3 * BrickBits);
+
+    void init(std::size_t xdim, std::size_t ydim, std::size_t zdim);
+
+    std::size_t capacity() const { return m_xbricks * m_ybricks * m_zbricks * BrickCells; }
+
+    std::size_t index(std::size_t x, std::size_t y, std::size_t z) const;
+    void coord(std::size_t i, std::size_t& x, std::size_t& y, std::size_t& z) const;
+
+private:
+
+    std::size_t m_xbricks = 0;
+    std::size_t m_ybricks = 0;
+    std::size_t m_zbricks = 0;
+};
+
+/// A dense 3D grid of cells. The order in which cells are stored is determined
+/// by the Layout policy. Linear access through data(), operator[], and the
+/// iterators covers all cells of storage, which, for layouts that pad the
+/// grid, include cells outside of the grid's dimensions.
+template <typename T, typename Layout = RowMajorLayout>
 class Grid3
 {
 public:
@@ -132,12 +184,16 @@ private:
 
     value_type* m_data;
     size_type m_dims[3];
+    Layout m_layout;
 
     void resize(size_type count);
+
+    static T* AllocateCells(size_type count);
+    static void DeallocateCells(T* data, size_type count);
 };
 
-template <typename T>
-void swap(Grid3<T>& lhs, Grid3<T>& rhs);
+template <typename T, typename Layout>
+void swap(Grid3<T, Layout>& lhs, Grid3<T, Layout>& rhs);
 
 } // namespace smpl
 
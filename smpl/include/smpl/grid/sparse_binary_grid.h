@@ -38,10 +38,11 @@
 
 // project includes
 #include <smpl/grid/sparse_grid.h>
+#include <smpl/octree/pool_allocator.h>
 
 namespace smpl {
 
-template <class Allocator = std::allocator<std::uint8_t>>
+template <class Allocator = OcTreePoolAllocator<std::uint8_t>>
 class SparseBinaryGrid
 {
     struct packed_bool_ref;
@@ -110,6 +111,28 @@ public:
 
     void resize(size_type size_x, size_type size_y, size_type size_z);
     void resize(size_type size_x, size_type size_y, size_type size_z, bool value);
+
+    template <class InputIt>
+    void set_cells(InputIt first, InputIt last, bool value);
+    ///@}
+
+    /// \name Bulk Operations
+    /// Operations between grids require grids of the same size. Each operation
+    /// visits leaf nodes rather than cells, processing the 8 cells packed into
+    /// a leaf's value at once, or a whole uniform subtree at once.
+    ///@{
+    void set_union(const SparseBinaryGrid& o);
+    void set_intersection(const SparseBinaryGrid& o);
+    void set_difference(const SparseBinaryGrid& o);
+
+    size_type count(
+        index_type min_x, index_type min_y, index_type min_z,
+        index_type max_x, index_type max_y, index_type max_z) const;
+
+    bool find_first(
+        index_type min_x, index_type min_y, index_type min_z,
+        index_type max_x, index_type max_y, index_type max_z,
+        index_type& x, index_type& y, index_type& z) const;
     ///@}
 
     template <class Pred>
@@ -142,6 +165,34 @@ private:
     SparseGrid<std::uint8_t, Allocator> m_grid;
     size_type m_osize[3];
 
+    using node_type = typename GridType::node_type;
+
+    // Bounding box of original cells, [min, max) along each axis
+    struct Box
+    {
+        index_type min[3];
+        index_type max[3];
+    };
+
+    bool clip_node(
+        const Box& box,
+        index_type first_x, index_type first_y, index_type first_z,
+        size_type span,
+        Box& clipped) const;
+
+    size_type count_node(
+        const node_type* n,
+        index_type first_x, index_type first_y, index_type first_z,
+        size_type span,
+        const Box& box) const;
+
+    bool find_first_node(
+        const node_type* n,
+        index_type first_x, index_type first_y, index_type first_z,
+        size_type span,
+        const Box& box,
+        index_type& x, index_type& y, index_type& z) const;
+
     std::uint8_t initval(bool value) const;
     size_type reduced(size_type s) const;
     std::uint8_t get_mask(int x, int y, int z) const;
@@ -33,10 +33,15 @@
 #define SMPL_SPARSE_GRID_H
 
 // standard includes
+#include <cstddef>
+#include <iterator>
 #include <memory>
+#include <utility>
+#include <vector>
 
 // project includes
 #include <smpl/octree/octree.h>
+#include <smpl/octree/pool_allocator.h>
 
 namespace smpl {
 
@@ -68,7 +73,14 @@ namespace smpl {
 /// set() to skip automatic pruning of nodes. The underlying octree may then be
 /// explicitly pruned by calling the prune() function, which will prune all
 /// nodes where applicable for maximum compression.
-template <class T, class Allocator = std::allocator<T>>
+///
+/// For bulk access, get_block() and set_block() read and write aligned bricks
+/// of block_size^3 cells with a single traversal of the octree, and leaves()
+/// streams the leaves of the octree as uniform cubes of cells.
+///
+/// By default, octree nodes are allocated from a per-grid OcTreePoolAllocator,
+/// which recycles the blocks of children freed by pruning.
+template <class T, class Allocator = OcTreePoolAllocator<T>>
 class SparseGrid
 {
 public:
@@ -82,6 +94,22 @@ public:
     using const_reference   = const value_type&;
     using index_type        = int;
 
+    /// The edge length of the bricks accessed by get_block() and set_block()
+    static constexpr int block_size = 8;
+
+    /// A uniform cube of cells, [x, x + size) x [y, y + size) x [z, z + size),
+    /// represented by one leaf of the octree.
+    struct leaf_type
+    {
+        const T* value;
+        index_type x;
+        index_type y;
+        index_type z;
+        size_type size;
+    };
+
+    struct leaf_iterator;
+
     SparseGrid();
     SparseGrid(const T& value);
     SparseGrid(size_type size_x, size_type size_y, size_type size_z);
@@ -118,6 +146,8 @@ public:
     reference operator()(index_type x, index_type y, index_type z);
 
     const_reference get(index_type x, index_type y, index_type z) const;
+
+    void get_block(index_type x, index_type y, index_type z, T* values) const;
     ///@}
 
     /// \name Modifiers
@@ -128,6 +158,8 @@ public:
     void set(index_type x, index_type y, index_type z, const T& data);
     void set_lazy(index_type x, index_type y, index_type z, const T& data);
 
+    void set_block(index_type x, index_type y, index_type z, const T* values);
+
     void prune();
 
     template <class UnaryPredicate>
@@ -135,6 +167,9 @@ public:
 
     void resize(size_type size_x, size_type size_y, size_type size_z);
     void resize(size_type size_x, size_type size_y, size_type size_z, const T& value);
+
+    template <class BinaryOp>
+    void combine(const SparseGrid& o, BinaryOp op);
     ///@}
 
     template <class Pred>
@@ -146,6 +181,11 @@ public:
     template <typename Callable>
     void accept_coords(Callable c);
 
+    /// \name Iteration
+    ///@{
+    std::pair<leaf_iterator, leaf_iterator> leaves() const;
+    ///@}
+
     const TreeType &tree() const { return m_tree; }
 
 private:
@@ -204,6 +244,46 @@ private:
     template <class UnaryPredicate>
     bool prune(node_type* n, UnaryPredicate p);
 
+    template <class BinaryOp>
+    void combine_node(node_type* n, const node_type* o, BinaryOp op);
+
+    template <class UnaryOp>
+    void transform_node(node_type* n, UnaryOp op);
+
+    bool collapse_leaves(node_type* n);
+
+    void get_block_node(
+        int rdepth,
+        const node_type* n,
+        index_type x,
+        index_type y,
+        index_type z,
+        T* values) const;
+
+    bool set_block_node(
+        int rdepth,
+        node_type* n,
+        index_type x,
+        index_type y,
+        index_type z,
+        const T* values);
+
+    void read_block(
+        int rdepth,
+        const node_type* n,
+        index_type ox,
+        index_type oy,
+        index_type oz,
+        T* values) const;
+
+    void write_block(
+        int rdepth,
+        node_type* n,
+        index_type ox,
+        index_type oy,
+        index_type oz,
+        const T* values);
+
     template <typename Callable>
     void accept_coords(
         Callable c, node_type* n,
@@ -211,6 +291,45 @@ private:
         size_type last_x, size_type last_y, size_type last_z);
 };
 
+/// Iterates over the leaves of a SparseGrid in depth-first order, yielding the
+/// origin, size, and value of each leaf. Unlike accept_coords(), iteration may
+/// be interleaved with other work and stopped early.
+template <class T, class Allocator>
+struct SparseGrid<T, Allocator>::leaf_iterator
+{
+    using value_type        = leaf_type;
+    using reference         = const leaf_type&;
+    using pointer           = const leaf_type*;
+    using difference_type   = std::ptrdiff_t;
+    using iterator_category = std::forward_iterator_tag;
+
+    leaf_iterator() = default;
+    leaf_iterator(const node_type* root, int max_depth);
+
+    leaf_iterator& operator++();
+    leaf_iterator operator++(int);
+    reference operator*() const { return m_leaf; }
+    pointer operator->() const { return &m_leaf; }
+    bool operator==(const leaf_iterator& i) const;
+    bool operator!=(const leaf_iterator& i) const;
+
+private:
+
+    struct Frame
+    {
+        const node_type* n;
+        index_type x;
+        index_type y;
+        index_type z;
+        int rdepth;
+    };
+
+    std::vector<Frame> m_stack;
+    leaf_type m_leaf;
+
+    void descend();
+};
+
 } // namespace smpl
 
 #include "detail/sparse_grid.hpp"
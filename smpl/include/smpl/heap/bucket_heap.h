@@ -0,0 +1,203 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_BUCKET_HEAP_H
+#define SMPL_BUCKET_HEAP_H
+
+#include <cstdlib>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <smpl/heap/dary_heap.h>
+#include <smpl/heap/intrusive_heap.h>
+
+namespace smpl {
+
+/// Provides an intrusive bucket queue for elements with integer priorities.
+/// Objects inserted into the queue must derive from the \p heap_element class
+/// and the queue provides the same interface as \p intrusive_heap and
+/// \p dary_heap, so that it may be substituted for either.
+///
+/// Elements are stored in an array of buckets, one per integer key in the
+/// range of keys currently in the queue. Insertion, erasure, and priority
+/// updates take constant time. Extracting the minimum takes time proportional
+/// to the number of empty buckets skipped, which is amortized constant when
+/// the minimum key changes gradually, as it does in best-first searches with
+/// integer edge costs. Keys are not required to be monotone; elements may be
+/// inserted with a key smaller than the current minimum.
+///
+/// Memory usage is proportional to the difference between the largest and
+/// smallest keys in the queue, so this queue is unsuitable when keys span a
+/// very large range (for instance, when elements with "infinite" priority are
+/// inserted). Elements with equal keys are extracted in LIFO order.
+///
+/// As with \p dary_heap, the key for each element is cached. The key is
+/// obtained by calling the \p KeyOf function object on the element during
+/// push(), update(), increase(), decrease(), and make().
+template <class T, class KeyOf>
+class bucket_heap
+{
+public:
+
+    static_assert(std::is_base_of<heap_element, T>::value, "T must extend heap_element");
+
+    typedef KeyOf key_of;
+    typedef typename detail::key_of_result<T, KeyOf>::type key_type;
+
+    static_assert(std::is_integral<key_type>::value, "bucket_heap requires integral keys");
+
+    struct node
+    {
+        key_type key;
+        T* elem;
+        std::size_t pos; // index into the element's bucket
+    };
+
+    typedef std::vector<node> container_type;
+    typedef typename container_type::size_type size_type;
+
+    /// Iterates over the elements in the queue in unspecified order,
+    /// dereferencing to a pointer to the element.
+    class const_iterator :
+        public std::iterator<std::random_access_iterator_tag, T*>
+    {
+    public:
+
+        typedef typename container_type::const_iterator base_iterator;
+        typedef typename std::iterator_traits<base_iterator>::difference_type difference_type;
+
+        const_iterator() = default;
+        explicit const_iterator(base_iterator it) : m_it(it) { }
+
+        T* operator*() const { return m_it->elem; }
+
+        const_iterator& operator++() { ++m_it; return *this; }
+        const_iterator operator++(int) { const_iterator it(*this); ++m_it; return it; }
+        const_iterator& operator--() { --m_it; return *this; }
+        const_iterator operator--(int) { const_iterator it(*this); --m_it; return it; }
+
+        const_iterator& operator+=(difference_type n) { m_it += n; return *this; }
+        const_iterator& operator-=(difference_type n) { m_it -= n; return *this; }
+        const_iterator operator+(difference_type n) const { return const_iterator(m_it + n); }
+        const_iterator operator-(difference_type n) const { return const_iterator(m_it - n); }
+        difference_type operator-(const_iterator o) const { return m_it - o.m_it; }
+
+        bool operator==(const_iterator o) const { return m_it == o.m_it; }
+        bool operator!=(const_iterator o) const { return m_it != o.m_it; }
+
+    private:
+
+        base_iterator m_it;
+    };
+
+    typedef const_iterator iterator;
+
+    bucket_heap(const key_of& key = key_of());
+
+    template <class InputIt>
+    bucket_heap(InputIt first, InputIt last);
+
+    template <class InputIt>
+    bucket_heap(const key_of& key, InputIt first, InputIt last);
+
+    bucket_heap(const bucket_heap&) = delete;
+
+    bucket_heap(bucket_heap&& o);
+
+    bucket_heap& operator=(const bucket_heap&) = delete;
+    bucket_heap& operator=(bucket_heap&& rhs);
+
+    T* min() const;
+    auto min_key() const -> const key_type&;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    bool empty() const;
+    size_type size() const;
+    size_type max_size() const;
+    void reserve(size_type new_cap);
+
+    void clear();
+    void push(T* e);
+
+    /// Insert an element without restoring the heap order or reading its
+    /// key. make() must be called before any operation other than append(),
+    /// contains(), size(), or iteration.
+    void append(T* e);
+    void pop();
+    bool contains(T* e);
+    void update(T* e);
+    void increase(T* e);
+    void decrease(T* e);
+    void erase(T* e);
+
+    void make();
+
+    void swap(bucket_heap& o);
+
+private:
+
+    typedef std::vector<size_type> bucket_type;
+
+    // element slots; heap_element::m_heap_index stores (slot + 1) so that 0
+    // continues to mean "not in the heap"
+    container_type m_nodes;
+
+    // m_buckets[b] holds the slots of all elements with key (m_base + b)
+    std::vector<bucket_type> m_buckets;
+    key_type m_base;
+
+    // index of the lowest non-empty bucket, when the queue is non-empty
+    size_type m_min;
+
+    KeyOf m_key;
+
+    size_type bucket_index(key_type key) const;
+    void ensure_bucket(key_type key);
+    void bucket_insert(size_type slot);
+    void bucket_remove(size_type slot);
+    void slot_remove(size_type slot);
+    void advance_min();
+    void rekey(T* e);
+};
+
+template <class T, class KeyOf>
+void swap(bucket_heap<T, KeyOf>& lhs, bucket_heap<T, KeyOf>& rhs);
+
+} // namespace smpl
+
+#include "detail/bucket_heap.hpp"
+
+#endif
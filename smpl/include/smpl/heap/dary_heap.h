@@ -0,0 +1,207 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_DARY_HEAP_H
+#define SMPL_DARY_HEAP_H
+
+#include <cstdlib>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <smpl/heap/intrusive_heap.h>
+
+namespace smpl {
+
+namespace detail {
+
+template <class T, class KeyOf>
+struct key_of_result
+{
+    using type = typename std::decay<
+            decltype(std::declval<const KeyOf&>()(std::declval<const T&>()))>::type;
+};
+
+} // namespace detail
+
+/// Provides an intrusive d-ary heap implementation with keys stored inline in
+/// the heap array. Objects inserted into the heap must derive from the
+/// \p heap_element class, as with \p intrusive_heap; the two heaps may be used
+/// interchangeably for the same element types.
+///
+/// Unlike \p intrusive_heap, the priority of each element is cached alongside
+/// its pointer, so comparisons during sifting never dereference the element.
+/// The priority is obtained by calling the \p KeyOf function object on the
+/// element whenever it is inserted or its position is updated via push(),
+/// update(), increase(), decrease(), or make(). Modifying an element's
+/// priority without calling one of these leaves the cached key stale.
+///
+/// The arity \p D trades the depth of the heap for the number of comparisons
+/// per level. Larger arities reduce the number of cache lines touched by
+/// sift-up at the cost of more comparisons during sift-down. An arity of 4
+/// places all children of a node within a single cache line for word-sized
+/// keys.
+template <
+    class T,
+    class KeyOf,
+    std::size_t D = 4,
+    class KeyCompare = std::less<typename detail::key_of_result<T, KeyOf>::type>>
+class dary_heap
+{
+public:
+
+    static_assert(std::is_base_of<heap_element, T>::value, "T must extend heap_element");
+    static_assert(D >= 2, "heap arity must be at least 2");
+
+    typedef KeyOf key_of;
+    typedef KeyCompare key_compare;
+    typedef typename detail::key_of_result<T, KeyOf>::type key_type;
+
+    struct node
+    {
+        key_type key;
+        T* elem;
+    };
+
+    typedef std::vector<node> container_type;
+    typedef typename container_type::size_type size_type;
+
+    /// Iterates over the elements in the heap in unspecified order,
+    /// dereferencing to a pointer to the element.
+    class const_iterator :
+        public std::iterator<std::random_access_iterator_tag, T*>
+    {
+    public:
+
+        typedef typename container_type::const_iterator base_iterator;
+        typedef typename std::iterator_traits<base_iterator>::difference_type difference_type;
+
+        const_iterator() = default;
+        explicit const_iterator(base_iterator it) : m_it(it) { }
+
+        T* operator*() const { return m_it->elem; }
+
+        const_iterator& operator++() { ++m_it; return *this; }
+        const_iterator operator++(int) { const_iterator it(*this); ++m_it; return it; }
+        const_iterator& operator--() { --m_it; return *this; }
+        const_iterator operator--(int) { const_iterator it(*this); --m_it; return it; }
+
+        const_iterator& operator+=(difference_type n) { m_it += n; return *this; }
+        const_iterator& operator-=(difference_type n) { m_it -= n; return *this; }
+        const_iterator operator+(difference_type n) const { return const_iterator(m_it + n); }
+        const_iterator operator-(difference_type n) const { return const_iterator(m_it - n); }
+        difference_type operator-(const_iterator o) const { return m_it - o.m_it; }
+
+        bool operator==(const_iterator o) const { return m_it == o.m_it; }
+        bool operator!=(const_iterator o) const { return m_it != o.m_it; }
+
+    private:
+
+        base_iterator m_it;
+    };
+
+    typedef const_iterator iterator;
+
+    dary_heap(const key_of& key = key_of(), const key_compare& comp = key_compare());
+
+    template <class InputIt>
+    dary_heap(InputIt first, InputIt last);
+
+    template <class InputIt>
+    dary_heap(const key_of& key, InputIt first, InputIt last);
+
+    dary_heap(const dary_heap&) = delete;
+
+    dary_heap(dary_heap&& o);
+
+    dary_heap& operator=(const dary_heap&) = delete;
+    dary_heap& operator=(dary_heap&& rhs);
+
+    T* min() const;
+    auto min_key() const -> const key_type&;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    bool empty() const;
+    size_type size() const;
+    size_type max_size() const;
+    void reserve(size_type new_cap);
+
+    void clear();
+    void push(T* e);
+
+    /// Insert an element without restoring the heap order or reading its
+    /// key. make() must be called before any operation other than append(),
+    /// contains(), size(), or iteration.
+    void append(T* e);
+    void pop();
+    bool contains(T* e);
+    void update(T* e);
+    void increase(T* e);
+    void decrease(T* e);
+    void erase(T* e);
+
+    void make();
+
+    void swap(dary_heap& o);
+
+private:
+
+    container_type m_data;
+    KeyOf m_key;
+    KeyCompare m_comp;
+
+    // heap_element::m_heap_index stores (position + 1) so that 0 continues to
+    // mean "not in the heap"
+    static size_type position(const T* e);
+    void place(size_type pos, const node& n);
+
+    static size_type parent(size_type pos);
+    static size_type first_child(size_type pos);
+
+    void percolate_down(size_type pos);
+    void percolate_up(size_type pos);
+};
+
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+void swap(
+    dary_heap<T, KeyOf, D, KeyCompare>& lhs,
+    dary_heap<T, KeyOf, D, KeyCompare>& rhs);
+
+} // namespace smpl
+
+#include "detail/dary_heap.hpp"
+
+#endif
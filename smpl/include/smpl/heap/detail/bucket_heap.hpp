@@ -0,0 +1,414 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_BUCKET_HEAP_HPP
+#define SMPL_BUCKET_HEAP_HPP
+
+#include "../bucket_heap.h"
+
+#include <assert.h>
+#include <algorithm>
+#include <limits>
+
+namespace smpl {
+
+template <class T, class KeyOf>
+bucket_heap<T, KeyOf>::bucket_heap(const key_of& key) :
+    m_nodes(),
+    m_buckets(),
+    m_base(0),
+    m_min(0),
+    m_key(key)
+{
+}
+
+template <class T, class KeyOf>
+template <class InputIt>
+bucket_heap<T, KeyOf>::bucket_heap(InputIt first, InputIt last) :
+    m_nodes(),
+    m_buckets(),
+    m_base(0),
+    m_min(0),
+    m_key()
+{
+    for (; first != last; ++first) {
+        T* e = *first;
+        m_nodes.push_back(node{ key_type(), e, 0 });
+        e->m_heap_index = m_nodes.size();
+    }
+    make();
+}
+
+template <class T, class KeyOf>
+template <class InputIt>
+bucket_heap<T, KeyOf>::bucket_heap(
+    const key_of& key,
+    InputIt first,
+    InputIt last)
+:
+    m_nodes(),
+    m_buckets(),
+    m_base(0),
+    m_min(0),
+    m_key(key)
+{
+    for (; first != last; ++first) {
+        T* e = *first;
+        m_nodes.push_back(node{ key_type(), e, 0 });
+        e->m_heap_index = m_nodes.size();
+    }
+    make();
+}
+
+template <class T, class KeyOf>
+bucket_heap<T, KeyOf>::bucket_heap(bucket_heap&& o) :
+    m_nodes(std::move(o.m_nodes)),
+    m_buckets(std::move(o.m_buckets)),
+    m_base(o.m_base),
+    m_min(o.m_min),
+    m_key(std::move(o.m_key))
+{
+}
+
+template <class T, class KeyOf>
+bucket_heap<T, KeyOf>&
+bucket_heap<T, KeyOf>::operator=(bucket_heap&& rhs)
+{
+    if (this != &rhs) {
+        m_nodes = std::move(rhs.m_nodes);
+        m_buckets = std::move(rhs.m_buckets);
+        m_base = rhs.m_base;
+        m_min = rhs.m_min;
+        m_key = std::move(rhs.m_key);
+    }
+    return *this;
+}
+
+template <class T, class KeyOf>
+T* bucket_heap<T, KeyOf>::min() const
+{
+    assert(!empty());
+    assert(!m_buckets[m_min].empty());
+    return m_nodes[m_buckets[m_min].back()].elem;
+}
+
+template <class T, class KeyOf>
+auto bucket_heap<T, KeyOf>::min_key() const -> const key_type&
+{
+    assert(!empty());
+    assert(!m_buckets[m_min].empty());
+    return m_nodes[m_buckets[m_min].back()].key;
+}
+
+template <class T, class KeyOf>
+typename bucket_heap<T, KeyOf>::const_iterator
+bucket_heap<T, KeyOf>::begin() const
+{
+    return const_iterator(m_nodes.begin());
+}
+
+template <class T, class KeyOf>
+typename bucket_heap<T, KeyOf>::const_iterator
+bucket_heap<T, KeyOf>::end() const
+{
+    return const_iterator(m_nodes.end());
+}
+
+template <class T, class KeyOf>
+bool bucket_heap<T, KeyOf>::empty() const
+{
+    return m_nodes.empty();
+}
+
+template <class T, class KeyOf>
+typename bucket_heap<T, KeyOf>::size_type
+bucket_heap<T, KeyOf>::size() const
+{
+    return m_nodes.size();
+}
+
+template <class T, class KeyOf>
+typename bucket_heap<T, KeyOf>::size_type
+bucket_heap<T, KeyOf>::max_size() const
+{
+    return m_nodes.max_size();
+}
+
+template <class T, class KeyOf>
+void bucket_heap<T, KeyOf>::reserve(size_type new_cap)
+{
+    m_nodes.reserve(new_cap);
+}
+
+template <class T, class KeyOf>
+void bucket_heap<T, KeyOf>::clear()
+{
+    // only touch the buckets that are in use
+    for (auto& n : m_nodes) {
+        m_buckets[bucket_index(n.key)].clear();
+        n.elem->m_heap_index = 0;
+    }
+    m_nodes.clear();
+    m_min = 0;
+}
+
+template <class T, class KeyOf>
+void bucket_heap<T, KeyOf>::push(T* e)
+{
+    assert(e);
+    auto key = m_key(*e);
+
+    if (empty()) {
+        // all buckets are empty, so the range may be re-based for free
+        m_base = key;
+        m_min = 0;
+    }
+
+    m_nodes.push_back(node{ key, e, 0 });
+    e->m_heap_index = m_nodes.size();
+    bucket_insert(m_nodes.size() - 1);
+}
+
+template <class T, class KeyOf>
+void bucket_heap<T, KeyOf>::append(T* e)
+{
+    assert(e);
+    m_nodes.push_back(node{ key_type(), e, 0 });
+    e->m_heap_index = m_nodes.size();
+}
+
+template <class T, class KeyOf>
+void bucket_heap<T, KeyOf>::pop()
+{
+    assert(!empty());
+    erase(min());
+}
+
+template <class T, class KeyOf>
+bool bucket_heap<T, KeyOf>::contains(T* e)
+{
+    assert(e);
+    return e->m_heap_index != 0;
+}
+
+template <class T, class KeyOf>
+void bucket_heap<T, KeyOf>::update(T* e)
+{
+    assert(e && contains(e));
+    rekey(e);
+}
+
+template <class T, class KeyOf>
+void bucket_heap<T, KeyOf>::increase(T* e)
+{
+    assert(e && contains(e));
+    rekey(e);
+}
+
+template <class T, class KeyOf>
+void bucket_heap<T, KeyOf>::decrease(T* e)
+{
+    assert(e && contains(e));
+    rekey(e);
+}
+
+template <class T, class KeyOf>
+void bucket_heap<T, KeyOf>::erase(T* e)
+{
+    assert(e && contains(e));
+    auto slot = e->m_heap_index - 1;
+    bucket_remove(slot);
+    slot_remove(slot);
+    e->m_heap_index = 0;
+    advance_min();
+}
+
+template <class T, class KeyOf>
+void bucket_heap<T, KeyOf>::make()
+{
+    for (auto& b : m_buckets) {
+        b.clear();
+    }
+
+    if (m_nodes.empty()) {
+        m_min = 0;
+        return;
+    }
+
+    auto min_key = m_key(*m_nodes.front().elem);
+    for (auto& n : m_nodes) {
+        n.key = m_key(*n.elem);
+        min_key = std::min(min_key, n.key);
+    }
+
+    m_base = min_key;
+    m_min = 0;
+    for (size_type i = 0; i < m_nodes.size(); ++i) {
+        bucket_insert(i);
+    }
+}
+
+template <class T, class KeyOf>
+void bucket_heap<T, KeyOf>::swap(bucket_heap& o)
+{
+    if (this != &o) {
+        using std::swap;
+        swap(m_nodes, o.m_nodes);
+        swap(m_buckets, o.m_buckets);
+        swap(m_base, o.m_base);
+        swap(m_min, o.m_min);
+        swap(m_key, o.m_key);
+    }
+}
+
+template <class T, class KeyOf>
+inline
+typename bucket_heap<T, KeyOf>::size_type
+bucket_heap<T, KeyOf>::bucket_index(key_type key) const
+{
+    assert(key >= m_base);
+    return (size_type)(key - m_base);
+}
+
+// Grow the bucket array so that it covers the bucket for key. Buckets are
+// added in proportion to the current size so that growth is amortized
+// constant. The (empty) buckets are rotated into place, so that allocated
+// bucket storage continues to be reused.
+template <class T, class KeyOf>
+void bucket_heap<T, KeyOf>::ensure_bucket(key_type key)
+{
+    if (key < m_base) {
+        auto shift = (size_type)(m_base - key);
+        auto slack = m_buckets.size() >> 1;
+        if (key >= std::numeric_limits<key_type>::min() + (key_type)slack) {
+            shift += slack;
+        }
+        m_buckets.resize(m_buckets.size() + shift);
+        std::rotate(m_buckets.begin(), m_buckets.end() - shift, m_buckets.end());
+        m_base -= (key_type)shift;
+        m_min += shift;
+    } else if (bucket_index(key) >= m_buckets.size()) {
+        auto size = std::max(bucket_index(key) + 1, 2 * m_buckets.size());
+        m_buckets.resize(size);
+    }
+}
+
+template <class T, class KeyOf>
+inline
+void bucket_heap<T, KeyOf>::bucket_insert(size_type slot)
+{
+    auto& n = m_nodes[slot];
+    ensure_bucket(n.key);
+    auto b = bucket_index(n.key);
+    n.pos = m_buckets[b].size();
+    m_buckets[b].push_back(slot);
+    if (b < m_min) {
+        m_min = b;
+    }
+}
+
+template <class T, class KeyOf>
+inline
+void bucket_heap<T, KeyOf>::bucket_remove(size_type slot)
+{
+    auto& n = m_nodes[slot];
+    auto& bucket = m_buckets[bucket_index(n.key)];
+    auto moved = bucket.back();
+    bucket[n.pos] = moved;
+    m_nodes[moved].pos = n.pos;
+    bucket.pop_back();
+}
+
+// Move the last slot into the vacated slot. The element in the vacated slot
+// must already have been removed from its bucket.
+template <class T, class KeyOf>
+inline
+void bucket_heap<T, KeyOf>::slot_remove(size_type slot)
+{
+    auto last = m_nodes.size() - 1;
+    if (slot != last) {
+        auto& n = m_nodes[slot];
+        n = m_nodes[last];
+        n.elem->m_heap_index = slot + 1;
+        m_buckets[bucket_index(n.key)][n.pos] = slot;
+    }
+    m_nodes.pop_back();
+}
+
+// Advance the minimum bucket index past empty buckets. When the skipped prefix
+// makes up more than half of the bucket array, the array is re-based at the
+// minimum key so that it tracks the range of keys in use rather than the range
+// of all keys ever inserted.
+template <class T, class KeyOf>
+inline
+void bucket_heap<T, KeyOf>::advance_min()
+{
+    if (empty()) {
+        m_min = 0;
+        return;
+    }
+
+    while (m_buckets[m_min].empty()) {
+        ++m_min;
+    }
+
+    if (m_min > 64 && m_min > (m_buckets.size() >> 1)) {
+        std::rotate(m_buckets.begin(), m_buckets.begin() + m_min, m_buckets.end());
+        m_base += (key_type)m_min;
+        m_min = 0;
+    }
+}
+
+template <class T, class KeyOf>
+void bucket_heap<T, KeyOf>::rekey(T* e)
+{
+    auto slot = e->m_heap_index - 1;
+    auto key = m_key(*e);
+    if (key == m_nodes[slot].key) {
+        return;
+    }
+
+    bucket_remove(slot);
+    m_nodes[slot].key = key;
+    bucket_insert(slot);
+    advance_min();
+}
+
+template <class T, class KeyOf>
+void swap(bucket_heap<T, KeyOf>& lhs, bucket_heap<T, KeyOf>& rhs)
+{
+    lhs.swap(rhs);
+}
+
+} // namespace smpl
+
+#endif
@@ -0,0 +1,379 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_DARY_HEAP_HPP
+#define SMPL_DARY_HEAP_HPP
+
+#include "../dary_heap.h"
+
+#include <assert.h>
+
+namespace smpl {
+
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+dary_heap<T, KeyOf, D, KeyCompare>::dary_heap(
+    const key_of& key,
+    const key_compare& comp)
+:
+    m_data(),
+    m_key(key),
+    m_comp(comp)
+{
+}
+
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+template <class InputIt>
+dary_heap<T, KeyOf, D, KeyCompare>::dary_heap(InputIt first, InputIt last) :
+    m_data(),
+    m_key(),
+    m_comp()
+{
+    for (; first != last; ++first) {
+        T* e = *first;
+        m_data.push_back(node{ m_key(*e), e });
+        e->m_heap_index = m_data.size();
+    }
+    make();
+}
+
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+template <class InputIt>
+dary_heap<T, KeyOf, D, KeyCompare>::dary_heap(
+    const key_of& key,
+    InputIt first,
+    InputIt last)
+:
+    m_data(),
+    m_key(key),
+    m_comp()
+{
+    for (; first != last; ++first) {
+        T* e = *first;
+        m_data.push_back(node{ m_key(*e), e });
+        e->m_heap_index = m_data.size();
+    }
+    make();
+}
+
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+dary_heap<T, KeyOf, D, KeyCompare>::dary_heap(dary_heap&& o) :
+    m_data(std::move(o.m_data)),
+    m_key(std::move(o.m_key)),
+    m_comp(std::move(o.m_comp))
+{
+}
+
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+dary_heap<T, KeyOf, D, KeyCompare>&
+dary_heap<T, KeyOf, D, KeyCompare>::operator=(dary_heap&& rhs)
+{
+    if (this != &rhs) {
+        m_data = std::move(rhs.m_data);
+        m_key = std::move(rhs.m_key);
+        m_comp = std::move(rhs.m_comp);
+    }
+    return *this;
+}
+
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+T* dary_heap<T, KeyOf, D, KeyCompare>::min() const
+{
+    assert(!m_data.empty());
+    return m_data.front().elem;
+}
+
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+auto dary_heap<T, KeyOf, D, KeyCompare>::min_key() const -> const key_type&
+{
+    assert(!m_data.empty());
+    return m_data.front().key;
+}
+
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+typename dary_heap<T, KeyOf, D, KeyCompare>::const_iterator
+dary_heap<T, KeyOf, D, KeyCompare>::begin() const
+{
+    return const_iterator(m_data.begin());
+}
+
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+typename dary_heap<T, KeyOf, D, KeyCompare>::const_iterator
+dary_heap<T, KeyOf, D, KeyCompare>::end() const
+{
+    return const_iterator(m_data.end());
+}
+
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+bool dary_heap<T, KeyOf, D, KeyCompare>::empty() const
+{
+    return m_data.empty();
+}
+
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+typename dary_heap<T, KeyOf, D, KeyCompare>::size_type
+dary_heap<T, KeyOf, D, KeyCompare>::size() const
+{
+    return m_data.size();
+}
+
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+typename dary_heap<T, KeyOf, D, KeyCompare>::size_type
+dary_heap<T, KeyOf, D, KeyCompare>::max_size() const
+{
+    return m_data.max_size();
+}
+
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+void dary_heap<T, KeyOf, D, KeyCompare>::reserve(size_type new_cap)
+{
+    m_data.reserve(new_cap);
+}
+
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+void dary_heap<T, KeyOf, D, KeyCompare>::clear()
+{
+    for (auto& n : m_data) {
+        n.elem->m_heap_index = 0;
+    }
+    m_data.clear();
+}
+
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+void dary_heap<T, KeyOf, D, KeyCompare>::push(T* e)
+{
+    assert(e);
+    m_data.push_back(node{ m_key(*e), e });
+    e->m_heap_index = m_data.size();
+    percolate_up(m_data.size() - 1);
+}
+
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+void dary_heap<T, KeyOf, D, KeyCompare>::append(T* e)
+{
+    assert(e);
+    m_data.push_back(node{ key_type(), e });
+    e->m_heap_index = m_data.size();
+}
+
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+void dary_heap<T, KeyOf, D, KeyCompare>::pop()
+{
+    assert(!empty());
+    m_data.front().elem->m_heap_index = 0;
+    if (m_data.size() > 1) {
+        place(0, m_data.back());
+        m_data.pop_back();
+        percolate_down(0);
+    } else {
+        m_data.pop_back();
+    }
+}
+
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+bool dary_heap<T, KeyOf, D, KeyCompare>::contains(T* e)
+{
+    assert(e);
+    return e->m_heap_index != 0;
+}
+
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+void dary_heap<T, KeyOf, D, KeyCompare>::update(T* e)
+{
+    assert(e && contains(e));
+    auto pos = position(e);
+    auto key = m_key(*e);
+    if (m_comp(key, m_data[pos].key)) {
+        m_data[pos].key = std::move(key);
+        percolate_up(pos);
+    } else {
+        m_data[pos].key = std::move(key);
+        percolate_down(pos);
+    }
+}
+
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+void dary_heap<T, KeyOf, D, KeyCompare>::increase(T* e)
+{
+    assert(e && contains(e));
+    auto pos = position(e);
+    m_data[pos].key = m_key(*e);
+    percolate_down(pos);
+}
+
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+void dary_heap<T, KeyOf, D, KeyCompare>::decrease(T* e)
+{
+    assert(e && contains(e));
+    auto pos = position(e);
+    m_data[pos].key = m_key(*e);
+    percolate_up(pos);
+}
+
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+void dary_heap<T, KeyOf, D, KeyCompare>::erase(T* e)
+{
+    assert(e && contains(e));
+    auto pos = position(e);
+    e->m_heap_index = 0;
+    if (pos + 1 == m_data.size()) {
+        m_data.pop_back();
+        return;
+    }
+
+    place(pos, m_data.back());
+    m_data.pop_back();
+
+    // the replacement may belong either above or below the vacated position
+    if (pos != 0 && m_comp(m_data[pos].key, m_data[parent(pos)].key)) {
+        percolate_up(pos);
+    } else {
+        percolate_down(pos);
+    }
+}
+
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+void dary_heap<T, KeyOf, D, KeyCompare>::make()
+{
+    for (auto& n : m_data) {
+        n.key = m_key(*n.elem);
+    }
+
+    if (m_data.size() < 2) {
+        return;
+    }
+
+    for (auto i = parent(m_data.size() - 1) + 1; i > 0; --i) {
+        percolate_down(i - 1);
+    }
+}
+
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+void dary_heap<T, KeyOf, D, KeyCompare>::swap(dary_heap& o)
+{
+    if (this != &o) {
+        using std::swap;
+        swap(m_data, o.m_data);
+        swap(m_key, o.m_key);
+        swap(m_comp, o.m_comp);
+    }
+}
+
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+inline
+typename dary_heap<T, KeyOf, D, KeyCompare>::size_type
+dary_heap<T, KeyOf, D, KeyCompare>::position(const T* e)
+{
+    return e->m_heap_index - 1;
+}
+
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+inline
+void dary_heap<T, KeyOf, D, KeyCompare>::place(size_type pos, const node& n)
+{
+    m_data[pos] = n;
+    n.elem->m_heap_index = pos + 1;
+}
+
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+inline
+typename dary_heap<T, KeyOf, D, KeyCompare>::size_type
+dary_heap<T, KeyOf, D, KeyCompare>::parent(size_type pos)
+{
+    return (pos - 1) / D;
+}
+
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+inline
+typename dary_heap<T, KeyOf, D, KeyCompare>::size_type
+dary_heap<T, KeyOf, D, KeyCompare>::first_child(size_type pos)
+{
+    return D * pos + 1;
+}
+
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+inline
+void dary_heap<T, KeyOf, D, KeyCompare>::percolate_down(size_type pos)
+{
+    const auto n = m_data.size();
+    node tmp = m_data[pos];
+    for (;;) {
+        auto c = first_child(pos);
+        if (c >= n) {
+            break;
+        }
+
+        // find the minimum child among the (up to D) contiguous children
+        auto last = c + D < n ? c + D : n;
+        auto best = c;
+        for (auto i = c + 1; i < last; ++i) {
+            if (m_comp(m_data[i].key, m_data[best].key)) {
+                best = i;
+            }
+        }
+
+        if (!m_comp(m_data[best].key, tmp.key)) {
+            break;
+        }
+
+        place(pos, m_data[best]);
+        pos = best;
+    }
+    place(pos, tmp);
+}
+
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+inline
+void dary_heap<T, KeyOf, D, KeyCompare>::percolate_up(size_type pos)
+{
+    node tmp = m_data[pos];
+    while (pos != 0) {
+        auto p = parent(pos);
+        if (!m_comp(tmp.key, m_data[p].key)) {
+            break;
+        }
+        place(pos, m_data[p]);
+        pos = p;
+    }
+    place(pos, tmp);
+}
+
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+void swap(
+    dary_heap<T, KeyOf, D, KeyCompare>& lhs,
+    dary_heap<T, KeyOf, D, KeyCompare>& rhs)
+{
+    lhs.swap(rhs);
+}
+
+} // namespace smpl
+
+#endif
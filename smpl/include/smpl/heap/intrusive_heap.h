@@ -40,6 +40,12 @@ namespace smpl {
 template <class T, class Compare>
 class intrusive_heap;
 
+template <class T, class KeyOf, std::size_t D, class KeyCompare>
+class dary_heap;
+
+template <class T, class KeyOf>
+class bucket_heap;
+
 struct heap_element
 {
 
@@ -51,6 +57,12 @@ private:
 
     template <class T, class Compare>
     friend class intrusive_heap;
+
+    template <class T, class KeyOf, std::size_t D, class KeyCompare>
+    friend class dary_heap;
+
+    template <class T, class KeyOf>
+    friend class bucket_heap;
 };
 
 /// Provides an intrusive binary heap implementation. Objects inserted into the
@@ -29,25 +29,50 @@
 
 /// \author Andrew Dornbush
 
-// project includes
-#include <smpl/heuristic/robot_heuristic.h>
-
 #ifndef SMPL_ATTRACTOR_HEURISTIC_H
 #define SMPL_ATTRACTOR_HEURISTIC_H
 
+// standard includes
+#include <memory>
+#include <vector>
+
+// project includes
+#include <smpl/heuristic/robot_heuristic.h>
+#include <smpl/memory_usage.h>
+
 namespace smpl {
 
 class OccupancyGrid;
+class WorkerPool;
 
-class AttractorHeuristic : public RobotHeuristic
+/// Heuristic attracting states toward a fixed robot state.
+///
+/// By default, the attraction is the joint space distance to the attractor,
+/// computed for joint state goals only. With the attractor field enabled,
+/// the workspace distance from the projection of a state to the planning link
+/// position of the attractor is precomputed for every cell of the occupancy
+/// grid when the goal is updated, so that evaluating a state costs one
+/// projection and one lookup.
+class AttractorHeuristic :
+    public RobotHeuristic,
+    public MemoryUsageExtension
 {
 public:
 
+    ~AttractorHeuristic();
+
     bool init(RobotPlanningSpace* space, const OccupancyGrid* grid);
 
-    void setAttractor(const RobotState& state) { m_attractor = state; }
+    void setAttractor(const RobotState& state)
+    { m_attractor = state; m_field.clear(); }
     const RobotState& attractor() const { return m_attractor; }
 
+    bool useField() const { return m_use_field; }
+    void setUseField(bool use);
+
+    int threadCount() const { return m_thread_count; }
+    void setThreadCount(int count);
+
     /// \name Required Functions from RobotHeuristic
     ///@{
     double getMetricGoalDistance(double x, double y, double z) override;
@@ -59,6 +84,16 @@ public:
     Extension* getExtension(size_t class_code) override;
     ///@}
 
+    /// \name Required Public Functions from MemoryUsageExtension
+    ///@{
+    auto memoryUsage() const -> std::size_t override;
+    ///@}
+
+    /// \name Reimplemented Public Functions from RobotPlanningSpaceObserver
+    ///@{
+    void updateGoal(const GoalConstraint& goal) override;
+    ///@}
+
     /// \name Required Functions from Heuristic
     ///@{
     int GetGoalHeuristic(int state_id) override;
@@ -70,7 +105,21 @@ private:
 
     const OccupancyGrid* m_grid = nullptr;
     ExtractRobotStateExtension* m_ers = nullptr;
+    PointProjectionExtension* m_pp = nullptr;
+    ForwardKinematicsInterface* m_fk_iface = nullptr;
     RobotState m_attractor;
+
+    bool m_use_field = false;
+    int m_thread_count = 1;
+    std::unique_ptr<WorkerPool> m_pool;
+
+    // attraction of each grid cell, indexed x-fastest; empty until the field
+    // has been computed for the current attractor
+    std::vector<int> m_field;
+    Vector3 m_attractor_pos;
+
+    void computeField();
+    int fieldAttraction(const Vector3& p) const;
 };
 
 } // namespace smpl
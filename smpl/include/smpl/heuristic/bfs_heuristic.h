@@ -33,17 +33,66 @@
 #define SMPL_BFS_HEURISTIC_H
 
 // standard includes
+#include <cstdint>
+#include <functional>
+#include <list>
 #include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 // project includes
 #include <smpl/occupancy_grid.h>
 #include <smpl/bfs3d/bfs3d.h>
+#include <smpl/cancellation.h>
 #include <smpl/debug/marker.h>
 #include <smpl/heuristic/robot_heuristic.h>
+#include <smpl/memory_usage.h>
 
 namespace smpl {
 
-class BfsHeuristic : public RobotHeuristic
+/// \brief Registry of goal searches shared between BfsHeuristics.
+///
+/// Heuristics given the same registry share one search, and the memory of its
+/// distance grid, when they search the same occupancy grid, in the same
+/// version of the collision world, with the same inflation radius and goal
+/// cells. The search is run by the first heuristic to acquire it and is freed
+/// when the last heuristic using it moves on to another goal. Heuristics only
+/// use the registry while they update their goals or walls.
+class BfsSearchRegistry
+{
+public:
+
+    struct Key
+    {
+        const OccupancyGrid* grid;
+        std::uint64_t world_version;
+        double inflation_radius;
+
+        // packed (x, y, z) coordinates of the goal cells
+        std::vector<int> goal;
+    };
+
+    using SearchFactory = std::function<std::shared_ptr<BFS_3D16>()>;
+
+    /// \brief Return the search for a key, running it with \p make if no
+    ///     heuristic holds it.
+    auto acquire(const Key& key, const SearchFactory& make)
+        -> std::shared_ptr<const BFS_3D16>;
+
+    /// \brief Return the number of searches held by some heuristic.
+    int size() const;
+
+private:
+
+    mutable std::mutex m_mutex;
+    std::vector<std::pair<Key, std::weak_ptr<const BFS_3D16>>> m_searches;
+};
+
+class BfsHeuristic :
+    public RobotHeuristic,
+    public MemoryUsageExtension,
+    public CancellationExtension
 {
 public:
 
@@ -55,9 +104,50 @@ public:
     void setInflationRadius(double radius);
     int costPerCell() const { return m_cost_per_cell; }
     void setCostPerCell(int cost);
+    int threadCount() const { return m_thread_count; }
+    void setThreadCount(int count);
+
+    /// \brief Compute distances to the goal only as far as queries require.
+    ///
+    /// See BFS_3D::setLazy(). Lazy searches are not stored in the goal cache.
+    bool lazy() const { return m_lazy; }
+    void setLazy(bool lazy);
+
+    /// \brief Set the number of recent goals whose searches are kept.
+    ///
+    /// When a cached goal is requested again, its finished distances are
+    /// restored instead of running the BFS. Each entry holds a full copy of
+    /// the distance grid. The cache is cleared when the walls change. The
+    /// default size of 0 disables the cache.
+    int goalCacheSize() const { return m_goal_cache_size; }
+    void setGoalCacheSize(int size);
+
+    /// \brief Store cached distances as run-length encoded 16-bit values.
+    ///
+    /// Trades a decode on each cache hit for less memory per entry. Searches
+    /// with distances that do not fit in 16 bits are stored uncompressed.
+    bool goalCacheCompression() const { return m_compress_goal_cache; }
+    void setGoalCacheCompression(bool compress);
+
+    /// \brief Share goal searches with the other heuristics of a registry.
+    ///
+    /// Shared searches are only used when the collision checker of the
+    /// planning space provides CollisionWorldVersionExtension and the search
+    /// is not lazy. They are not cancelled by the cancellation token, since
+    /// other heuristics may still be using them, and are not stored in the
+    /// goal cache. Pass NULL to stop sharing.
+    auto searchRegistry() const -> BfsSearchRegistry* { return m_registry; }
+    void setSearchRegistry(BfsSearchRegistry* registry);
 
     auto grid() const -> const OccupancyGrid* { return m_grid; }
 
+    /// \brief Resynchronize the BFS walls with the occupancy grid.
+    ///
+    /// Call after the occupancy grid has changed. The distances to the
+    /// current goal are repaired around the cells whose occupancy changed
+    /// instead of being recomputed from the goal.
+    void updateWalls();
+
     auto getWallsVisualization() const -> visual::Marker;
     auto getValuesVisualization() -> visual::Marker;
 
@@ -72,6 +162,16 @@ public:
     Extension* getExtension(size_t class_code) override;
     ///@}
 
+    /// \name Required Public Functions from MemoryUsageExtension
+    ///@{
+    auto memoryUsage() const -> std::size_t override;
+    ///@}
+
+    /// \name Required Public Functions from CancellationExtension
+    ///@{
+    void setCancellationToken(const CancellationToken* token) override;
+    ///@}
+
     /// \name Reimplemented Public Functions from RobotPlanningSpaceObserver
     ///@{
     void updateGoal(const GoalConstraint& goal) override;
@@ -88,11 +188,19 @@ private:
 
     const OccupancyGrid* m_grid = nullptr;
 
-    std::unique_ptr<BFS_3D> m_bfs;
+    std::unique_ptr<BFS_3D16> m_bfs;
     PointProjectionExtension* m_pp = nullptr;
 
+    // the search for the current goal, when it is held through m_registry
+    // rather than run in m_bfs. m_bfs keeps its walls up to date either way
+    BfsSearchRegistry* m_registry = nullptr;
+    std::shared_ptr<const BFS_3D16> m_shared;
+
     double m_inflation_radius = 0.0;
     int m_cost_per_cell = 1;
+    int m_thread_count = 1;
+    bool m_lazy = false;
+    const CancellationToken* m_cancel = nullptr;
 
     struct CellCoord
     {
@@ -102,8 +210,35 @@ private:
     };
     std::vector<CellCoord> m_goal_cells;
 
+    struct CachedSearch
+    {
+        // packed (x, y, z) coordinates of the goal cells
+        std::vector<int> goal;
+
+        // distance grid, or its compressed runs if non-empty
+        std::vector<int> distances;
+        std::vector<std::uint16_t> runs;
+    };
+
+    // searches for recent goals, most recently used first
+    std::list<CachedSearch> m_goal_cache;
+    int m_goal_cache_size = 0;
+    bool m_compress_goal_cache = false;
+
+    // goal cells of the search in m_bfs and whether it is in the cache
+    std::vector<int> m_search_goal;
+    bool m_search_cached = true;
+
+    auto bfs() const -> const BFS_3D16& { return m_shared ? *m_shared : *m_bfs; }
+    auto makeBfs() const -> std::unique_ptr<BFS_3D16>;
     void syncGridAndBfs();
-    int getBfsCostToGoal(const BFS_3D& bfs, int x, int y, int z) const;
+    bool acquireSharedSearch(const std::vector<int>& goal);
+    void cacheSearch();
+    bool restoreSearch(const std::vector<int>& goal);
+    void runSearch(const std::vector<int>& goal);
+    void addGoalRegion(const Vector3& pos, const double tolerance[3]);
+    void runGoalSearch();
+    int getBfsCostToGoal(const BFS_3D16& bfs, int x, int y, int z) const;
 };
 
 } // namespace smpl
@@ -0,0 +1,138 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_DUBINS_HEURISTIC_H
+#define SMPL_DUBINS_HEURISTIC_H
+
+// standard includes
+#include <stddef.h>
+#include <vector>
+
+// project includes
+#include <smpl/heuristic/robot_heuristic.h>
+#include <smpl/unicycle/pose_2d.h>
+
+namespace smpl {
+
+/// \brief Heuristic estimating the length of the shortest Dubins path, with a
+///     fixed turning radius, from the (x, y, yaw) projection of a state to
+///     the goal pose.
+///
+/// Requires the planning space to provide PoseProjectionExtension. The
+/// heuristic is a lower bound on the cost of any forward-only path whose
+/// curvature is bounded by the turning radius; it is not admissible for
+/// spaces that allow reversing or turning in place.
+///
+/// Since the Dubins distance depends only on the start pose expressed in the
+/// frame of the goal, an optional lookup table over goal-relative poses may
+/// be precomputed once and reused across goals. Table values are taken at
+/// the nearest sample, so the estimate may differ from the exact distance by
+/// up to the error introduced by the table resolution. Poses outside the
+/// table fall back to the exact computation.
+class DubinsHeuristic : public RobotHeuristic
+{
+public:
+
+    bool init(RobotPlanningSpace* space);
+
+    void setTurningRadius(double radius);
+    auto turningRadius() const -> double { return m_radius; }
+
+    /// \brief Precompute a lookup table of Dubins distances in the goal frame
+    /// \param half_extent The table covers goal-relative x and y in
+    ///     [-half_extent, half_extent]
+    /// \param res The spacing of the table samples in x and y
+    /// \param num_headings The number of relative heading samples
+    bool setLookupTable(double half_extent, double res, int num_headings);
+    void clearLookupTable();
+    bool hasLookupTable() const { return !m_table.empty(); }
+
+    /// \brief Return the Dubins distance, in meters, between two poses
+    double dubinsDistance(const Pose2D& from, const Pose2D& to) const;
+
+    /// \brief Compute the goal heuristics of a batch of states
+    ///
+    /// Equivalent to calling GetGoalHeuristic for each state, but the states
+    /// are projected first and their distances are computed in one call to
+    /// ComputeDubinsDistances.
+    void getGoalHeuristics(const int* state_ids, size_t count, int* values);
+
+    /// \name Required Public Functions from RobotHeuristic
+    ///@{
+    double getMetricGoalDistance(double x, double y, double z) override;
+    double getMetricStartDistance(double x, double y, double z) override;
+    ///@}
+
+    /// \name Required Public Functions from Extension
+    ///@{
+    Extension* getExtension(size_t class_code) override;
+    ///@}
+
+    /// \name Required Public Functions from Heuristic
+    ///@{
+    int GetGoalHeuristic(int state_id) override;
+    int GetStartHeuristic(int state_id) override;
+    int GetFromToHeuristic(int from_id, int to_id) override;
+    ///@}
+
+private:
+
+    static constexpr double FIXED_POINT_RATIO = 1000.0;
+
+    PoseProjectionExtension* m_pose_ext = nullptr;
+
+    double m_radius = 1.0;
+
+    // goal-frame lookup table, indexed by (x, y, heading)
+    std::vector<float> m_table;
+    double m_table_extent = 0.0;
+    double m_table_res = 0.0;
+    int m_table_width = 0;
+    int m_table_headings = 0;
+
+    // scratch buffers for batched evaluation
+    std::vector<double> m_batch_sx;
+    std::vector<double> m_batch_sy;
+    std::vector<double> m_batch_sth;
+    std::vector<double> m_batch_gx;
+    std::vector<double> m_batch_gy;
+    std::vector<double> m_batch_gth;
+    std::vector<double> m_batch_dist;
+    std::vector<size_t> m_batch_index;
+
+    bool projectToPose2D(int state_id, Pose2D& pose) const;
+    auto goalPose2D() const -> Pose2D;
+    bool lookupDistance(const Pose2D& from, const Pose2D& to, double& dist) const;
+    int toHeuristic(double dist) const;
+};
+
+} // namespace smpl
+
+#endif
@@ -33,22 +33,27 @@
 #define SMPL_EGRAPH_BFS_HEURISTIC_H
 
 // standard includes
+#include <memory>
 #include <vector>
 
 // project includes
 #include <smpl/debug/marker.h>
+#include <smpl/geometry/kd_tree.h>
 #include <smpl/graph/experience_graph_extension.h>
 #include <smpl/grid/grid.h>
 #include <smpl/heap/intrusive_heap.h>
 #include <smpl/heuristic/egraph_heuristic.h>
 #include <smpl/heuristic/robot_heuristic.h>
+#include <smpl/memory_usage.h>
 #include <smpl/occupancy_grid.h>
+#include <smpl/worker_pool.h>
 
 namespace smpl {
 
 class DijkstraEgraphHeuristic3D :
     public RobotHeuristic,
-    public ExperienceGraphHeuristicExtension
+    public ExperienceGraphHeuristicExtension,
+    public MemoryUsageExtension
 {
 public:
 
@@ -56,12 +61,25 @@ public:
 
     auto grid() const -> const OccupancyGrid* { return m_grid; }
 
-    double weightEGraph() const { return m_eg_eps; }
-    void setWeightEGraph(double w);
+    double weightEGraph() const override { return m_eg_eps; }
+    void setWeightEGraph(double w) override;
 
     double inflationRadius() const { return m_inflation_radius; }
     void setInflationRadius(double radius);
 
+    /// Radius around a state's projected point within which experience graph
+    /// nodes are reported as equivalent states. A radius of zero reports only
+    /// nodes projected into the same cell.
+    double snapRadius() const { return m_snap_radius; }
+    void setSnapRadius(double radius);
+
+    /// Set the number of threads used to rebuild the per-goal data in
+    /// updateGoal(): the distance grid reset and the shortcut nodes of each
+    /// experience graph component. Distances are still expanded lazily on the
+    /// calling thread.
+    int threadCount() const { return m_pool ? m_pool->numThreads() : 1; }
+    void setThreadCount(int count);
+
     auto getWallsVisualization() -> visual::Marker;
     auto getValuesVisualization() -> visual::Marker;
 
@@ -74,6 +92,10 @@ public:
     void getShortcutSuccs(
         int state_id,
         std::vector<int>& ids) override;
+
+    void experienceGraphExtended(
+        ExperienceGraph::node_id first_node,
+        ExperienceGraph::edge_id first_edge) override;
     ///@}
 
     /// \name Required Public Functions from RobotHeuristic
@@ -87,6 +109,11 @@ public:
     Extension* getExtension(size_t class_code) override;
     ///@}
 
+    /// \name Required Public Functions from MemoryUsageExtension
+    ///@{
+    auto memoryUsage() const -> std::size_t override;
+    ///@}
+
     /// \name Reimplemented Public Functions from RobotPlanningSpaceObserver
     ///@{
     void updateGoal(const GoalConstraint& goal) override;
@@ -115,7 +142,9 @@ private:
         explicit Cell(int d) : heap_element(), dist(d) { }
     };
 
-    Grid3<Cell> m_dist_grid;
+    // stored in Morton-ordered bricks, so that the 26 neighbors of an expanded
+    // cell lie in a few cache lines
+    Grid3<Cell, MortonLayout<>> m_dist_grid;
 
     struct CellCompare
     {
@@ -126,6 +155,7 @@ private:
 
     double m_eg_eps = 1.0;
     double m_inflation_radius = 0.0;
+    double m_snap_radius = 0.0;
 
     intrusive_heap<Cell, CellCompare> m_open;
 
@@ -144,10 +174,17 @@ private:
     // map from experience graph nodes to their heuristic cell coordinates
     std::vector<Eigen::Vector3i> m_projected_nodes;
 
+    // projected points of experience graph nodes and an index over them
+    std::vector<Vector3> m_projected_points;
+    geometry::KDTree m_node_index;
+
     // map from experience graph nodes to their component ids
     std::vector<int> m_component_ids;
+    std::vector<std::vector<ExperienceGraph::node_id>> m_component_nodes;
     std::vector<std::vector<ExperienceGraph::node_id>> m_shortcut_nodes;
 
+    std::unique_ptr<WorkerPool> m_pool;
+
     struct HeuristicNode
     {
         std::vector<ExperienceGraph::node_id> up_nodes;
@@ -158,6 +195,7 @@ private:
     hash_map<Eigen::Vector3i, HeuristicNode, Vector3iHash> m_heur_nodes;
 
     void projectExperienceGraph();
+    void computeShortcutNodes(const Vector3& gp);
     int getGoalHeuristic(const Eigen::Vector3i& dp);
 
     void syncGridAndDijkstra();
@@ -34,6 +34,9 @@
 
 #include <vector>
 
+#include <smpl/extension.h>
+#include <smpl/graph/experience_graph.h>
+
 namespace smpl {
 
 class ExperienceGraphHeuristicExtension : public virtual Extension
@@ -52,6 +55,24 @@ public:
         int state_id,
         std::vector<int>& ids) = 0;
 
+    /// Return the factor by which distances off the experience graph are
+    /// inflated relative to distances along it.
+    virtual double weightEGraph() const = 0;
+
+    /// Set the experience graph inflation factor. The new factor applies from
+    /// the next goal update.
+    virtual void setWeightEGraph(double w) = 0;
+
+    /// Notify the heuristic that nodes and edges were appended to the
+    /// experience graph. Nodes from first_node and edges from first_edge are
+    /// new; the ids of existing nodes and edges are unchanged. Heuristics may
+    /// extend their precomputation for the current goal instead of waiting
+    /// for the next goal update.
+    virtual void experienceGraphExtended(
+        ExperienceGraph::node_id first_node,
+        ExperienceGraph::edge_id first_edge)
+    { }
+
 private:
 };
 
@@ -38,7 +38,9 @@
 
 namespace smpl {
 
-class EuclidDistHeuristic : public RobotHeuristic
+class EuclidDistHeuristic :
+    public RobotHeuristic,
+    public GoalSetHeuristicExtension
 {
 public:
 
@@ -67,6 +69,11 @@ public:
     int GetFromToHeuristic(int from_id, int to_id) override;
     ///@}
 
+    /// \name Required Public Functions from GoalSetHeuristicExtension
+    ///@{
+    int GetGoalHeuristic(int state_id, int goal_index) override;
+    ///@}
+
 private:
 
     static constexpr double FIXED_POINT_RATIO = 1000.0;
@@ -86,6 +93,8 @@ private:
         double x, double y, double z,
         double Y, double P, double R) const;
 
+    int computeHeuristic(int state_id, const Affine3& goal_pose);
+
     double computeDistance(const Affine3& a, const Affine3& b) const;
 
     double computeDistance(const Vector3& u, const Vector3& v) const;
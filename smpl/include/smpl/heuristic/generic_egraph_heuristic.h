@@ -48,13 +48,17 @@ public:
 
     bool init(RobotPlanningSpace* space, RobotHeuristic* h);
 
-    double weightEGraph() const { return m_eg_eps; }
-    void setWeightEGraph(double w);
+    double weightEGraph() const override { return m_eg_eps; }
+    void setWeightEGraph(double w) override;
 
     /// \name ExperienceGraphHeuristicExtension Interface
     ///@{
     void getEquivalentStates(int state_id, std::vector<int>& ids) override;
     void getShortcutSuccs(int state_id, std::vector<int>& ids) override;
+
+    void experienceGraphExtended(
+        ExperienceGraph::node_id first_node,
+        ExperienceGraph::edge_id first_edge) override;
     ///@}
 
     /// \name RobotHeuristic Interface
@@ -92,9 +96,13 @@ private:
 
     double m_eg_eps = 1.0;
 
+    int m_component_count = 0;
     std::vector<int> m_component_ids;
     std::vector<std::vector<ExperienceGraph::node_id>> m_shortcut_nodes;
 
+    // original goal heuristic of each experience graph node
+    std::vector<int> m_node_h;
+
     struct HeuristicNode : public heap_element
     {
         int dist;
@@ -113,6 +121,10 @@ private:
 
     std::vector<HeuristicNode> m_h_nodes;
     intrusive_heap<HeuristicNode, NodeCompare> m_open;
+
+    void computeComponents(const ExperienceGraph* eg);
+    void computeShortcutNodes(const ExperienceGraph* eg);
+    void propagateDistances(const ExperienceGraph* eg);
 };
 
 } // namespace smpl
@@ -34,16 +34,22 @@
 
 // standard includes
 #include <memory>
+#include <vector>
 
 // project includes
 #include <smpl/occupancy_grid.h>
 #include <smpl/debug/marker.h>
 #include <smpl/heuristic/robot_heuristic.h>
+#include <smpl/memory_usage.h>
 #include <smpl/bfs3d/bfs3d.h>
+#include <smpl/cancellation.h>
 
 namespace smpl {
 
-class MultiFrameBfsHeuristic : public RobotHeuristic
+class MultiFrameBfsHeuristic :
+    public RobotHeuristic,
+    public MemoryUsageExtension,
+    public CancellationExtension
 {
 public:
 
@@ -57,9 +63,20 @@ public:
     void setInflationRadius(double radius);
     int costPerCell() const { return m_cost_per_cell; }
     void setCostPerCell(int cost);
+    int threadCount() const { return m_thread_count; }
+    void setThreadCount(int count);
+    int eeCellScale() const { return m_ee_cell_scale; }
+    void setEeCellScale(int scale);
 
     auto grid() const -> const OccupancyGrid* { return m_grid; }
 
+    /// \brief Resynchronize the BFS walls with the occupancy grid.
+    ///
+    /// Call after the occupancy grid has changed. The distances to the
+    /// current goal are repaired around the cells whose occupancy changed
+    /// instead of being recomputed from the goal.
+    void updateWalls();
+
     auto getWallsVisualization() const -> visual::Marker;
     auto getValuesVisualization() const -> visual::Marker;
 
@@ -74,6 +91,16 @@ public:
     Extension* getExtension(size_t class_code) override;
     ///@}
 
+    /// \name Required Public Functions from MemoryUsageExtension
+    ///@{
+    auto memoryUsage() const -> std::size_t override;
+    ///@}
+
+    /// \name Required Public Functions from CancellationExtension
+    ///@{
+    void setCancellationToken(const CancellationToken* token) override;
+    ///@}
+
     /// \name Reimplemented Public Functions from RobotPlanningSpaceObserver
     ///@{
     void updateGoal(const GoalConstraint& goal) override;
@@ -94,18 +121,23 @@ private:
     ExtractRobotStateExtension* m_ers = nullptr;
     ForwardKinematicsInterface* m_fk_iface = nullptr;
 
-    std::unique_ptr<BFS_3D> m_bfs;
-    std::unique_ptr<BFS_3D> m_ee_bfs;
+    std::unique_ptr<BFS_3D16> m_bfs;
+    std::unique_ptr<BFS_3D16> m_ee_bfs;
 
     double m_pos_offset[3];
 
     double m_inflation_radius = 0.0;
     int m_cost_per_cell = 1;
+    int m_thread_count = 1;
+    int m_ee_cell_scale = 1;
+    const CancellationToken* m_cancel = nullptr;
 
     int getGoalHeuristic(int state_id, bool use_ee) const;
 
     void syncGridAndBfs();
-    int getBfsCostToGoal(const BFS_3D& bfs, int x, int y, int z) const;
+    int getBfsCostToGoal(
+        const BFS_3D16& bfs, int x, int y, int z, int cell_scale = 1) const;
+    void getWalls(std::vector<bool>& walls, std::vector<bool>& ee_walls) const;
 
     inline
     int combine_costs(int c1, int c2) const;
@@ -0,0 +1,90 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_POSE_BFS_HEURISTIC_H
+#define SMPL_POSE_BFS_HEURISTIC_H
+
+// standard includes
+#include <vector>
+
+// project includes
+#include <smpl/heuristic/bfs_heuristic.h>
+
+namespace smpl {
+
+struct WorkspaceLattice;
+
+/// \brief BFS heuristic for the Workspace Lattice that also accounts for the
+///     orientation of the planning link.
+///
+/// The BFS distance of the planning link to the goal position is added to the
+/// number of rotation steps from the state's orientation bin to the goal
+/// orientation, times the cost per cell. The rotation steps of every
+/// orientation bin of the lattice are tabulated when the goal is set, so
+/// the orientation term costs one lookup per state. Since each action of the
+/// lattice moves either the position or one rotation angle, the two terms
+/// add without overestimating the number of actions to the goal.
+class PoseBfsHeuristic : public BfsHeuristic
+{
+public:
+
+    bool init(RobotPlanningSpace* space, const OccupancyGrid* grid);
+
+    /// \name Reimplemented Public Functions from MemoryUsageExtension
+    ///@{
+    auto memoryUsage() const -> std::size_t override;
+    ///@}
+
+    /// \name Reimplemented Public Functions from RobotPlanningSpaceObserver
+    ///@{
+    void updateGoal(const GoalConstraint& goal) override;
+    ///@}
+
+    /// \name Reimplemented Public Functions from Heuristic
+    ///@{
+    int GetGoalHeuristic(int state_id) override;
+    ///@}
+
+private:
+
+    WorkspaceLattice* m_lattice = nullptr;
+
+    // cost of the rotation steps from each orientation bin, indexed by
+    // (R * P_count + P) * Y_count + Y, to the goal orientation. Empty unless
+    // the goal constrains orientation
+    std::vector<int> m_rot_costs;
+
+    void updateRotationCosts(const GoalConstraint& goal);
+};
+
+} // namespace smpl
+
+#endif
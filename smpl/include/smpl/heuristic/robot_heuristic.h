@@ -87,6 +87,19 @@ private:
     RobotPlanningSpace* m_space = nullptr;
 };
 
+/// Provides a heuristic estimate of the cost to each goal of a planning space
+/// that provides GoalSetExtension.
+class GoalSetHeuristicExtension : public virtual Extension
+{
+public:
+
+    virtual ~GoalSetHeuristicExtension() { }
+
+    /// Return the heuristic distance from a state to the goal with the given
+    /// index in the goal set.
+    virtual int GetGoalHeuristic(int state_id, int goal_index) = 0;
+};
+
 } // namespace smpl
 
 #endif
@@ -32,37 +32,107 @@
 #ifndef SMPL_SOFT_BFS_HEURISTIC_H
 #define SMPL_SOFT_BFS_HEURISTIC_H
 
-// system includes
-#include <sbpl/heuristics/heuristic.h>
+// standard includes
+#include <memory>
+#include <vector>
+
+// project includes
+#include <smpl/occupancy_grid.h>
+#include <smpl/bfs3d/soft_bfs3d.h>
+#include <smpl/heuristic/robot_heuristic.h>
+#include <smpl/memory_usage.h>
 
 namespace smpl {
 
-class SoftBfsHeuristic : public RobotHeuristic
+/// \brief BFS heuristic that also charges for passing close to obstacles.
+///
+/// Cells within the inflation radius of an obstacle are walls, as for
+/// BfsHeuristic. Entering a cell whose distance to the nearest obstacle is
+/// less than the clearance costs extra, rising linearly from nothing at the
+/// clearance to the clearance weight times the cost of a cell at the
+/// inflation radius, so the search is drawn toward paths that keep their
+/// distance from obstacles. The heuristic is not admissible with a positive
+/// clearance weight.
+///
+/// The costs to the goal are computed by SoftBFS_3D and are repaired, rather
+/// than recomputed, when the occupancy grid changes.
+class SoftBfsHeuristic :
+    public RobotHeuristic,
+    public MemoryUsageExtension
 {
 public:
 
-    SoftBfsHeuristic(
-        ManipLattice* env,
-        const OccupancyGridConstPtr& grid,
-        const PlanningParams* params);
+    virtual ~SoftBfsHeuristic();
+
+    bool init(RobotPlanningSpace* space, const OccupancyGrid* grid);
+
+    /// \name Parameters
+    ///
+    /// Take effect on the next call to init().
+    ///@{
+    double inflationRadius() const { return m_inflation_radius; }
+    void setInflationRadius(double radius) { m_inflation_radius = radius; }
+    double clearance() const { return m_clearance; }
+    void setClearance(double clearance) { m_clearance = clearance; }
+    double clearanceWeight() const { return m_clearance_weight; }
+    void setClearanceWeight(double weight) { m_clearance_weight = weight; }
+    int costPerCell() const { return m_cost_per_cell; }
+    void setCostPerCell(int cost) { m_cost_per_cell = cost; }
+    int threadCount() const { return m_thread_count; }
+    void setThreadCount(int count) { m_thread_count = count; }
+    ///@}
+
+    auto grid() const -> const OccupancyGrid* { return m_grid; }
 
-    bool setGoal(int x, int y, int z);
-    bool setGoal(double x, double y, double z);
+    /// \brief Resynchronize the cell costs with the occupancy grid.
+    ///
+    /// Call after the occupancy grid has changed. The costs to the current
+    /// goal are repaired around the cells whose cost changed.
+    void updateCosts();
 
-    visualization_msgs::MarkerArray getWallsVisualization() const;
-    visualization_msgs::MarkerArray getValuesVisualization() const;
+    /// \name Required Public Functions from RobotHeuristic
+    ///@{
+    double getMetricStartDistance(double x, double y, double z) override;
+    double getMetricGoalDistance(double x, double y, double z) override;
+    ///@}
 
-    double getMetricGoalDistance(double x, double y, double z);
+    /// \name Required Public Functions from Extension
+    ///@{
+    Extension* getExtension(size_t class_code) override;
+    ///@}
 
-    int GetGoalHeuristic(int state_id);
-    int GetStartHeuristic(int state_id);
-    int GetFromToHeuristic(int from_id, int to_id);
+    /// \name Required Public Functions from MemoryUsageExtension
+    ///@{
+    auto memoryUsage() const -> std::size_t override;
+    ///@}
+
+    /// \name Reimplemented Public Functions from RobotPlanningSpaceObserver
+    ///@{
+    void updateGoal(const GoalConstraint& goal) override;
+    ///@}
+
+    /// \name Required Public Functions from Heuristic
+    ///@{
+    int GetGoalHeuristic(int state_id) override;
+    int GetStartHeuristic(int state_id) override;
+    int GetFromToHeuristic(int from_id, int to_id) override;
+    ///@}
 
 private:
 
-    std::unique_ptr<BFS_3D> m_bfs;
+    const OccupancyGrid* m_grid = nullptr;
+
+    std::unique_ptr<SoftBFS_3D> m_bfs;
+    PointProjectionExtension* m_pp = nullptr;
+
+    double m_inflation_radius = 0.0;
+    double m_clearance = 0.0;
+    double m_clearance_weight = 0.0;
+    int m_cost_per_cell = 1;
+    int m_thread_count = 1;
 
-    void syncGridAndBfs();
+    int cellCost(int x, int y, int z) const;
+    int getCostToGoal(int x, int y, int z) const;
 };
 
 } // namespace smpl
@@ -35,6 +35,7 @@
 // standard includes
 #include <cstdlib>
 #include <limits>
+#include <memory>
 
 // system includes
 #include <Eigen/Core>
@@ -45,6 +46,7 @@
 #include <smpl/heuristic/egraph_heuristic.h>
 #include <smpl/graph/experience_graph.h>
 #include <smpl/grid/sparse_grid.h>
+#include <smpl/worker_pool.h>
 
 namespace smpl {
 
@@ -64,12 +66,17 @@ public:
 
     auto grid() const -> const OccupancyGrid* { return m_grid; }
 
-    double weightEGraph() const { return m_eg_eps; }
-    void setWeightEGraph(double w);
+    double weightEGraph() const override { return m_eg_eps; }
+    void setWeightEGraph(double w) override;
 
     double inflationRadius() const { return m_inflation_radius; }
     void setInflationRadius(double radius);
 
+    /// Set the number of threads used to select the shortcut nodes of each
+    /// experience graph component in updateGoal().
+    int threadCount() const { return m_pool ? m_pool->numThreads() : 1; }
+    void setThreadCount(int count);
+
     auto getWallsVisualization() -> visual::Marker;
     auto getValuesVisualization() -> visual::Marker;
 
@@ -77,6 +84,10 @@ public:
     ///@{
     void getEquivalentStates(int state_id, std::vector<int>& ids) override;
     void getShortcutSuccs(int state_id, std::vector<int>& ids) override;
+
+    void experienceGraphExtended(
+        ExperienceGraph::node_id first_node,
+        ExperienceGraph::edge_id first_edge) override;
     ///@}
 
     /// \name Required Public Functions from RobotHeuristic
@@ -158,10 +169,16 @@ private:
     // map from experience graph nodes to their heuristic cell coordinates
     std::vector<Eigen::Vector3i> m_projected_nodes;
 
+    // projected points of experience graph nodes
+    std::vector<Vector3> m_projected_points;
+
     // map from experience graph nodes to their component ids
     std::vector<int> m_component_ids;
+    std::vector<std::vector<ExperienceGraph::node_id>> m_component_nodes;
     std::vector<std::vector<ExperienceGraph::node_id>> m_shortcut_nodes;
 
+    std::unique_ptr<WorkerPool> m_pool;
+
     struct HeuristicNode
     {
         std::vector<ExperienceGraph::node_id> up_nodes;
@@ -172,6 +189,7 @@ private:
     hash_map<Eigen::Vector3i, HeuristicNode, Vector3iHash> m_heur_nodes;
 
     void projectExperienceGraph();
+    void computeShortcutNodes(const Vector3& gp);
     int getGoalHeuristic(const Eigen::Vector3i& dp);
 
     void syncGridAndDijkstra();
@@ -0,0 +1,137 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_IK_SAMPLER_H
+#define SMPL_IK_SAMPLER_H
+
+// standard includes
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// project includes
+#include <smpl/robot_model.h>
+#include <smpl/spatial.h>
+#include <smpl/types.h>
+
+namespace smpl {
+
+class CollisionChecker;
+class ReachabilityMap;
+class WorkerPool;
+
+/// Computes inverse kinematics solutions for a pose from several seeds.
+///
+/// The first seed is always the one supplied by the caller; the remaining
+/// seeds are drawn uniformly within the joint limits from a fixed random
+/// sequence, so the same query always yields the same result. If a
+/// reachability map is set, the second seed is the map's seed for the queried
+/// pose, when it has one. A solution is
+/// valid if it satisfies the joint limits and, if a collision checker was
+/// supplied, is collision-free.
+///
+/// With more than one thread, seeds are solved concurrently. Each additional
+/// thread uses its own clone of the robot model and collision checker, which
+/// requires both to support cloning.
+class IKSampler
+{
+public:
+
+    IKSampler();
+    ~IKSampler();
+
+    bool init(RobotModel* robot, CollisionChecker* checker, int thread_count = 1);
+
+    int threadCount() const;
+
+    void setSeedCount(int count);
+    int seedCount() const { return m_seed_count; }
+
+    void setRandomSeed(std::uint32_t seed) { m_random_seed = seed; }
+
+    void setReachabilityMap(const ReachabilityMap* map) { m_reachability_map = map; }
+    auto reachabilityMap() const -> const ReachabilityMap* { return m_reachability_map; }
+
+    /// Return the valid solution found from the lowest-numbered seed.
+    bool solve(
+        const Affine3& pose,
+        const RobotState& seed,
+        RobotState& solution,
+        ik_option::IkOption option = ik_option::UNRESTRICTED);
+
+    /// Return up to \p k distinct valid solutions, ordered by their joint
+    /// space distance to \p seed.
+    bool solve(
+        const Affine3& pose,
+        const RobotState& seed,
+        int k,
+        std::vector<RobotState>& solutions,
+        ik_option::IkOption option = ik_option::UNRESTRICTED);
+
+private:
+
+    struct Solver
+    {
+        RobotModel* robot = nullptr;
+        InverseKinematicsInterface* ik = nullptr;
+        CollisionChecker* checker = nullptr;
+    };
+
+    RobotModel* m_robot = nullptr;
+
+    // solvers[0] uses the models passed to init; the rest are clones owned
+    // by this sampler
+    std::vector<Solver> m_solvers;
+    std::vector<std::unique_ptr<RobotModel>> m_robot_clones;
+    std::vector<std::unique_ptr<CollisionChecker>> m_checker_clones;
+    std::unique_ptr<WorkerPool> m_pool;
+
+    int m_seed_count = 1;
+    std::uint32_t m_random_seed = 0;
+    const ReachabilityMap* m_reachability_map = nullptr;
+
+    std::vector<RobotState> m_seeds;
+    std::vector<RobotState> m_solutions;
+    std::vector<char> m_valid;
+
+    void sampleSeeds(const Affine3& pose, const RobotState& seed);
+
+    bool solveSeed(
+        const Solver& solver,
+        const Affine3& pose,
+        ik_option::IkOption option,
+        std::size_t i);
+
+    double distance(const RobotState& a, const RobotState& b) const;
+};
+
+} // namespace smpl
+
+#endif
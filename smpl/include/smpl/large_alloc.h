@@ -0,0 +1,130 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_LARGE_ALLOC_H
+#define SMPL_LARGE_ALLOC_H
+
+// standard includes
+#include <cstddef>
+#include <memory>
+
+namespace smpl {
+
+enum class HugePageMode
+{
+    None = 0,
+    Transparent,    ///< madvise the memory for transparent huge pages
+    Explicit        ///< map explicit (hugetlbfs) huge pages, falling back to
+                    ///< transparent huge pages if none are available
+};
+
+/// Options for the memory of large allocations, such as the cells of distance
+/// maps, BFS grids, and other Grid3s.
+struct LargeAllocOptions
+{
+    /// Do not bind the memory to a NUMA node.
+    static const int NoNode = -1;
+
+    /// Bind the memory to the NUMA node of the allocating thread.
+    static const int LocalNode = -2;
+
+    HugePageMode huge_pages = HugePageMode::None;
+    int numa_node = NoNode;
+};
+
+/// Allocations of at least this many bytes are mapped directly from the
+/// operating system, and are affected by LargeAllocOptions; smaller allocations
+/// are forwarded to ::operator new.
+static const std::size_t LargeAllocThreshold = std::size_t(1) << 20;
+
+/// Set the options used by AllocateLarge() when none are given. These are
+/// process-wide and affect only subsequent allocations.
+void SetLargeAllocOptions(const LargeAllocOptions& options);
+auto GetLargeAllocOptions() -> LargeAllocOptions;
+
+/// Allocate uninitialized memory, aligned for any fundamental type.
+void* AllocateLarge(std::size_t size);
+void* AllocateLarge(std::size_t size, const LargeAllocOptions& options);
+
+/// Free memory returned by AllocateLarge() for an allocation of \p size bytes.
+void DeallocateLarge(void* p, std::size_t size);
+
+/// Return the NUMA node of the CPU the calling thread is running on, or -1 if
+/// unknown.
+int CurrentNumaNode();
+
+/// A standard allocator serving its allocations through AllocateLarge(), for
+/// use with containers such as std::vector or SparseGrid. Allocators compare
+/// equal regardless of their options, since memory allocated by any of them
+/// may be freed by any other.
+template <class T>
+class LargeAllocator
+{
+public:
+
+    using value_type = T;
+
+    template <class U>
+    struct rebind { using other = LargeAllocator<U>; };
+
+    LargeAllocator() : m_options(GetLargeAllocOptions()) { }
+
+    explicit LargeAllocator(const LargeAllocOptions& options) :
+        m_options(options)
+    { }
+
+    template <class U>
+    LargeAllocator(const LargeAllocator<U>& o) : m_options(o.options()) { }
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(AllocateLarge(n * sizeof(T), m_options));
+    }
+
+    void deallocate(T* p, std::size_t n)
+    {
+        DeallocateLarge(p, n * sizeof(T));
+    }
+
+    auto options() const -> const LargeAllocOptions& { return m_options; }
+
+    bool operator==(const LargeAllocator&) const { return true; }
+    bool operator!=(const LargeAllocator&) const { return false; }
+
+private:
+
+    LargeAllocOptions m_options;
+};
+
+} // namespace smpl
+
+#endif
@@ -0,0 +1,89 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_MEMORY_USAGE_H
+#define SMPL_MEMORY_USAGE_H
+
+// standard includes
+#include <cstddef>
+#include <vector>
+
+// project includes
+#include <smpl/extension.h>
+
+namespace smpl {
+
+/// Reports the heap memory held by a planner component, such as a graph's
+/// state table, a heuristic's grids, or a search's states
+class MemoryUsageExtension : public virtual Extension
+{
+public:
+
+    virtual ~MemoryUsageExtension() { }
+
+    /// Return the approximate number of bytes of memory held by the component,
+    /// including memory reserved but not in use, and excluding memory held by
+    /// the other components it refers to
+    virtual auto memoryUsage() const -> std::size_t = 0;
+};
+
+/// Return the memory held by a component that provides a
+/// MemoryUsageExtension, or 0 if it does not
+template <class T>
+auto GetMemoryUsage(T* component) -> std::size_t
+{
+    if (component == nullptr) {
+        return 0;
+    }
+    auto* ext = component->template getExtension<MemoryUsageExtension>();
+    return ext != nullptr ? ext->memoryUsage() : 0;
+}
+
+/// Return the memory held by the elements of a vector
+template <class T, class Alloc>
+auto MemoryUsage(const std::vector<T, Alloc>& v) -> std::size_t
+{
+    return v.capacity() * sizeof(T);
+}
+
+template <class T, class Alloc1, class Alloc2>
+auto MemoryUsage(const std::vector<std::vector<T, Alloc1>, Alloc2>& v)
+    -> std::size_t
+{
+    auto usage = v.capacity() * sizeof(std::vector<T, Alloc1>);
+    for (auto& e : v) {
+        usage += MemoryUsage(e);
+    }
+    return usage;
+}
+
+} // namespace smpl
+
+#endif
@@ -0,0 +1,234 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_MOTION_VALIDITY_CACHE_H
+#define SMPL_MOTION_VALIDITY_CACHE_H
+
+// standard includes
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// project includes
+#include <smpl/collision_checker.h>
+#include <smpl/types.h>
+
+namespace smpl {
+
+/// A thread-safe cache of the results of motion validity checks.
+///
+/// Entries are keyed on the start and end states of a motion, quantized to a
+/// fixed resolution, and on the world version at the time of the check.
+/// Bumping the world version with invalidate() makes every existing entry
+/// stale without touching them; clear() additionally releases their storage.
+///
+/// The version of the collision world, recorded with setWorld(), is stored
+/// with each entry as well. An entry checked against another version of the
+/// world is stale, unless the motion was found valid and certified with a
+/// clearance that exceeds the growth of the world since it was checked, within
+/// the same growth epoch (see CollisionClearanceExtension).
+class MotionValidityCache
+{
+public:
+
+    explicit MotionValidityCache(double resolution = 1e-6);
+
+    MotionValidityCache(const MotionValidityCache&) = delete;
+    MotionValidityCache& operator=(const MotionValidityCache&) = delete;
+
+    double resolution() const { return m_resolution; }
+
+    auto worldVersion() const -> std::uint64_t { return m_version; }
+
+    /// Mark all entries stale, e.g. after the world has changed.
+    void invalidate();
+
+    /// Remove all entries.
+    void clear();
+
+    /// Remove the entries that are stale in the current world.
+    void removeStale();
+
+    /// Record the version of the world subsequent checks are made against,
+    /// and the growth epoch and growth of its obstacles.
+    void setWorld(std::uint64_t version, std::uint64_t epoch, double growth);
+
+    /// Look up the validity of the motion from start to finish. Return false
+    /// if the motion has not been checked since the last invalidation.
+    bool lookup(
+        const RobotState& start,
+        const RobotState& finish,
+        bool& valid) const;
+
+    /// Record the validity of the motion from start to finish, and, for a
+    /// valid motion, its clearance, or 0 if it is not certified.
+    void insert(
+        const RobotState& start,
+        const RobotState& finish,
+        bool valid,
+        double clearance = 0.0);
+
+    auto size() const -> std::size_t;
+
+    auto hits() const -> std::size_t { return m_hits; }
+    auto misses() const -> std::size_t { return m_misses; }
+
+private:
+
+    using Key = std::vector<std::int64_t>;
+
+    struct KeyHash
+    {
+        auto operator()(const Key& key) const -> std::size_t;
+    };
+
+    struct Entry
+    {
+        std::uint64_t version;
+        std::uint64_t world_version;
+        std::uint64_t epoch;
+        double growth;
+        double clearance;
+        bool valid;
+    };
+
+    static const int ShardCount = 16;
+
+    struct Shard
+    {
+        std::mutex mutex;
+        std::unordered_map<Key, Entry, KeyHash> entries;
+    };
+
+    double m_resolution;
+    std::atomic<std::uint64_t> m_version;
+    mutable std::unique_ptr<Shard[]> m_shards;
+
+    std::atomic<std::uint64_t> m_world_version;
+    std::atomic<std::uint64_t> m_epoch;
+    std::atomic<double> m_growth;
+
+    mutable std::atomic<std::size_t> m_hits;
+    mutable std::atomic<std::size_t> m_misses;
+
+    bool fresh(const Entry& entry) const;
+    void makeKey(const RobotState& start, const RobotState& finish, Key& key) const;
+    auto shard(const Key& key) const -> Shard&;
+};
+
+/// A collision checker that answers motion validity queries from a shared
+/// MotionValidityCache before forwarding them to another checker.
+///
+/// Other queries are forwarded unchanged, as are requests for extensions the
+/// wrapped checker provides. The checker can be cloned if the wrapped checker
+/// can; clones share the cache.
+///
+/// If the wrapped checker provides CollisionWorldVersionExtension, the cache
+/// follows the version of its world, so that results are kept across changes
+/// to the world only when they are known to still hold. With certification
+/// enabled, valid motions are certified with the clearance reported by a
+/// wrapped checker that provides CollisionClearanceExtension, at the cost of
+/// computing it for each valid motion checked.
+class CachedCollisionChecker :
+    public CollisionChecker,
+    public CollisionCheckerCloneExtension
+{
+public:
+
+    CachedCollisionChecker(CollisionChecker* checker, MotionValidityCache* cache);
+
+    auto checker() const -> CollisionChecker* { return m_checker; }
+    auto cache() const -> MotionValidityCache* { return m_cache; }
+
+    void setCertifyMotions(bool enabled) { m_certify = enabled; }
+    bool certifyMotions() const { return m_certify; }
+
+    /// Record the current version of the wrapped checker's world in the
+    /// cache. Called before every cached query.
+    void syncWorld();
+
+    /// \name Required Functions from CollisionChecker
+    ///@{
+    bool isStateValid(const RobotState& state, bool verbose = false) override;
+    bool isStateValid(RobotStateView state, bool verbose = false) override;
+
+    bool isStateToStateValid(
+        const RobotState& start,
+        const RobotState& finish,
+        bool verbose = false) override;
+
+    bool interpolatePath(
+        const RobotState& start,
+        const RobotState& finish,
+        std::vector<RobotState>& path) override;
+    ///@}
+
+    /// \name Reimplemented Functions from CollisionChecker
+    ///@{
+    bool areStatesValid(
+        const RobotState* states,
+        size_t n,
+        bool* out = nullptr) override;
+
+    auto getCollisionModelVisualization(const RobotState& state)
+        -> std::vector<visual::Marker> override;
+    ///@}
+
+    /// \name Required Functions from CollisionCheckerCloneExtension
+    ///@{
+    auto clone() -> std::unique_ptr<CollisionChecker> override;
+    ///@}
+
+    /// \name Required Functions from Extension
+    ///@{
+    auto getExtension(size_t class_code) -> Extension* override;
+    ///@}
+
+private:
+
+    CollisionChecker* m_checker;
+    MotionValidityCache* m_cache;
+
+    CollisionWorldVersionExtension* m_wver_iface;
+    CollisionClearanceExtension* m_clearance_iface;
+    bool m_certify;
+
+    // the wrapped checker, when this is a clone
+    std::unique_ptr<CollisionChecker> m_owned_checker;
+};
+
+} // namespace smpl
+
+#endif
@@ -35,6 +35,8 @@
 
 // standard includes
 #include <algorithm>
+#include <cstddef>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -45,6 +47,7 @@
 #include <smpl/forward.h>
 #include <smpl/debug/marker.h>
 #include <smpl/distance_map/distance_map_interface.h>
+#include <smpl/grid/brick_grid.h>
 #include <smpl/spatial.h>
 
 namespace smpl {
@@ -66,14 +69,22 @@ public:
 
     OccupancyGrid(const OccupancyGrid& o);
 
-    OccupancyGrid(OccupancyGrid&& o) = default;
+    OccupancyGrid(OccupancyGrid&& o);
+
+    ~OccupancyGrid();
 
     OccupancyGrid& operator=(const OccupancyGrid& rhs);
-    OccupancyGrid& operator=(OccupancyGrid&& rhs) = default;
+    OccupancyGrid& operator=(OccupancyGrid&& rhs);
 
     auto getDistanceField() const -> const std::shared_ptr<DistanceMapInterface>&
     { return m_grid; }
 
+    /// Return a raw view of the distance field, or nullptr if it is not stored
+    /// as a dense grid. The view is invalidated by swapBuffers() and by
+    /// assignment to the grid.
+    auto getDistanceMapView() const -> const DistanceMapView*
+    { return m_has_view ? &m_view : nullptr; }
+
     /// \name Modifiers
     ///@{
     void addPointsToField(const std::vector<Vector3>& points);
@@ -86,6 +97,62 @@ public:
     void reset();
     ///@}
 
+    /// \name Double-Buffered Modifiers
+    ///
+    /// With double buffering enabled, the grid keeps a shadow copy of its
+    /// distance map. Staged updates are applied to the shadow copy, and may be
+    /// made from another thread while lookups are made against the current
+    /// map. swapBuffers() publishes the staged updates by exchanging the two
+    /// maps; it must not be called concurrently with lookups. The immediate
+    /// modifiers above remain available and affect both maps.
+    ///@{
+    void setDoubleBuffered(bool enabled);
+    bool doubleBuffered() const { return (bool)m_shadow; }
+
+    void stageAddPoints(const std::vector<Vector3>& points);
+    void stageRemovePoints(const std::vector<Vector3>& points);
+    void stageUpdatePoints(
+        const std::vector<Vector3>& old_points,
+        const std::vector<Vector3>& new_points);
+
+    bool swapBuffers();
+    ///@}
+
+    /// \name Sensor Modifiers
+    ///
+    /// Sensor updates insert the cells containing the points observed by a
+    /// sensor and remove the cells passed through on the way to them that were
+    /// inserted by earlier sensor updates. Each update is applied as a single
+    /// call to updatePointsInField(). Cells inserted by the other modifiers are
+    /// never removed by sensor updates.
+    ///@{
+    struct CameraIntrinsics
+    {
+        double fx;
+        double fy;
+        double cx;
+        double cy;
+    };
+
+    void insertDepthImage(
+        const float* depth,
+        int width,
+        int height,
+        const CameraIntrinsics& intrinsics,
+        const Affine3& sensor_pose,
+        double max_range = -1.0);
+
+    void insertPointCloud(
+        const float* points,
+        int width,
+        int height,
+        int point_stride,
+        const Affine3& sensor_pose,
+        double max_range = -1.0);
+
+    void clearSensorCells();
+    ///@}
+
     /// \name Properties
     ///@{
     double originX() const { return m_grid->originX(); }
@@ -100,6 +167,8 @@ public:
 
     double resolution() const { return m_grid->resolution(); }
 
+    bool refCounted() const { return m_ref_counted; }
+
     const std::string& getReferenceFrame() const;
     void setReferenceFrame(const std::string& frame);
     ///@}
@@ -129,6 +198,15 @@ public:
 
     double getDistanceFromPoint(double x, double y, double z) const;
     double getSquaredDist(double x, double y, double z) const;
+    double getClearanceFromPoint(double x, double y, double z) const;
+    double getDistanceGradient(double x, double y, double z, Vector3& grad) const;
+    void getSquaredDists(
+        const double* x, const double* y, const double* z,
+        int count,
+        double* dists) const;
+    void getDistancesFromPoints(
+        const float* xyz, std::size_t count, float* dists) const;
+    void getDistances(const int* xyz, std::size_t count, float* dists) const;
 
     double getDistanceToBorder(int x, int y, int z) const;
 
@@ -161,12 +239,41 @@ private:
     std::shared_ptr<DistanceMapInterface> m_grid;
     std::string reference_frame_;
 
+    // raw view of m_grid, used by the distance lookups when available, to
+    // avoid a virtual call per lookup
+    DistanceMapView m_view;
+    bool m_has_view;
+
     bool m_ref_counted;
     int m_x_stride;
     int m_y_stride;
-    std::vector<int> m_counts;
+    BrickGrid<int> m_counts;
+
+    struct ShadowBuffer;
+    std::unique_ptr<ShadowBuffer> m_shadow;
+
+    // cells inserted by sensor updates, and the cells hit and passed through
+    // by the sensor update in progress
+    std::vector<bool> m_sensed;
+    std::vector<bool> m_sensor_hit;
+    std::vector<bool> m_sensor_passed;
+    std::vector<int> m_sensor_hit_cells;
+    std::vector<int> m_sensor_passed_cells;
 
     void initRefCounts();
+    void updateView();
+
+    auto filterAddedPoints(const std::vector<Vector3>& points)
+        -> std::vector<Vector3>;
+    auto filterRemovedPoints(const std::vector<Vector3>& points)
+        -> std::vector<Vector3>;
+
+    template <typename PointFunction>
+    void insertSensorRays(
+        const Affine3& sensor_pose,
+        int count,
+        double max_range,
+        PointFunction get_point);
 
     int coordToIndex(int x, int y, int z) const;
 
@@ -214,6 +321,9 @@ void OccupancyGrid::setReferenceFrame(const std::string& frame)
 inline
 double OccupancyGrid::getDistance(int x, int y, int z) const
 {
+    if (m_has_view) {
+        return m_view.getCellDistance(x, y, z);
+    }
     return m_grid->getCellDistance(x, y, z);
 }
 
@@ -221,15 +331,72 @@ double OccupancyGrid::getDistance(int x, int y, int z) const
 inline
 double OccupancyGrid::getDistanceFromPoint(double x, double y, double z) const
 {
+    if (m_has_view) {
+        return m_view.getMetricDistance(x, y, z);
+    }
     return m_grid->getMetricDistance(x, y, z);
 }
 
+/// Get the distance, in meters, to the nearest occupied cell, and its gradient
+/// at the point.
+inline
+double OccupancyGrid::getDistanceGradient(
+    double x, double y, double z, Vector3& grad) const
+{
+    return m_grid->getMetricDistanceGradient(x, y, z, grad);
+}
+
+/// Get a lower bound on the distance, in meters, to the nearest occupied cell,
+/// within one cell of getDistanceFromPoint(). The bound is read from the
+/// distance map's 8-bit clearance field, and is 0 if the map does not keep one.
+inline
+double OccupancyGrid::getClearanceFromPoint(double x, double y, double z) const
+{
+    if (m_has_view) {
+        return m_view.getMetricClearance(x, y, z);
+    }
+    return 0.0;
+}
+
 inline
 double OccupancyGrid::getSquaredDist(double x, double y, double z) const
 {
+    if (m_has_view) {
+        const double d = m_view.getMetricDistance(x, y, z);
+        return d * d;
+    }
     return m_grid->getMetricSquaredDistance(x, y, z);
 }
 
+/// Look up the squared distances of a batch of points at once, which avoids a
+/// virtual call per point.
+inline
+void OccupancyGrid::getSquaredDists(
+    const double* x, const double* y, const double* z,
+    int count,
+    double* dists) const
+{
+    m_grid->getMetricSquaredDistances(x, y, z, count, dists);
+}
+
+/// Look up the distances of a batch of points, given as consecutive (x, y, z)
+/// triples.
+inline
+void OccupancyGrid::getDistancesFromPoints(
+    const float* xyz, std::size_t count, float* dists) const
+{
+    m_grid->getMetricDistances(xyz, count, dists);
+}
+
+/// Look up the distances of a batch of cells, given as consecutive (x, y, z)
+/// triples.
+inline
+void OccupancyGrid::getDistances(
+    const int* xyz, std::size_t count, float* dists) const
+{
+    m_grid->getCellDistances(xyz, count, dists);
+}
+
 /// Get the distance to the, in meters, to the border.
 inline
 double OccupancyGrid::getDistanceToBorder(int x, int y, int z) const
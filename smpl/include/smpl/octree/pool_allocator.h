@@ -0,0 +1,207 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_OCTREE_POOL_ALLOCATOR_H
+#define SMPL_OCTREE_POOL_ALLOCATOR_H
+
+// standard includes
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace smpl {
+namespace detail {
+
+/// A pool of fixed-size memory blocks carved out of larger slabs. Freed blocks
+/// are kept on a free list and handed out again before new slabs are
+/// allocated. Slabs are only returned to the system when the pool is
+/// destroyed.
+class OcTreeBlockPool
+{
+public:
+
+    static const std::size_t BlocksPerSlab = 256;
+
+    OcTreeBlockPool(std::size_t block_size, std::size_t block_align) :
+        m_block_size(RoundUp(
+                block_size < sizeof(FreeBlock) ? sizeof(FreeBlock) : block_size,
+                block_align < alignof(FreeBlock) ? alignof(FreeBlock) : block_align)),
+        m_block_align(block_align < alignof(FreeBlock) ? alignof(FreeBlock) : block_align),
+        m_free(nullptr)
+    { }
+
+    ~OcTreeBlockPool()
+    {
+        for (auto* slab : m_slabs) {
+            ::operator delete(slab);
+        }
+    }
+
+    OcTreeBlockPool(const OcTreeBlockPool&) = delete;
+    OcTreeBlockPool& operator=(const OcTreeBlockPool&) = delete;
+
+    void* allocate()
+    {
+        if (!m_free) {
+            add_slab();
+        }
+        auto* b = m_free;
+        m_free = b->next;
+        return b;
+    }
+
+    void deallocate(void* p)
+    {
+        auto* b = static_cast<FreeBlock*>(p);
+        b->next = m_free;
+        m_free = b;
+    }
+
+    /// Total size, in bytes, of the slabs owned by the pool.
+    std::size_t capacity() const
+    {
+        return m_slabs.size() * slab_size();
+    }
+
+private:
+
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    std::size_t m_block_size;
+    std::size_t m_block_align;
+    FreeBlock* m_free;
+    std::vector<void*> m_slabs;
+
+    static std::size_t RoundUp(std::size_t n, std::size_t align)
+    {
+        return (n + align - 1) / align * align;
+    }
+
+    std::size_t slab_size() const
+    {
+        return m_block_size * BlocksPerSlab + m_block_align;
+    }
+
+    void add_slab()
+    {
+        m_slabs.reserve(m_slabs.size() + 1);
+        auto* slab = ::operator new(slab_size());
+        m_slabs.push_back(slab);
+
+        auto first = RoundUp((std::uintptr_t)slab, m_block_align);
+        // thread the new blocks onto the free list in address order
+        for (std::size_t i = BlocksPerSlab; i > 0; --i) {
+            auto* b = reinterpret_cast<FreeBlock*>(first + (i - 1) * m_block_size);
+            b->next = m_free;
+            m_free = b;
+        }
+    }
+};
+
+} // namespace detail
+
+/// An allocator for OcTree nodes that serves the blocks of 8 children
+/// allocated when a node is expanded from a pool of fixed-size blocks with
+/// free-list recycling, avoiding a trip through the general purpose heap for
+/// every expansion and collapse. Allocations of any other size are forwarded
+/// to ::operator new.
+///
+/// Copies of an allocator share its pool, which is not thread-safe, so trees
+/// sharing a pool must not be modified concurrently. A container copy obtains
+/// a new pool through select_on_container_copy_construction(), so copies of a
+/// tree may be used from different threads. Rebinding to another value type
+/// also creates a new pool.
+template <class T>
+class OcTreePoolAllocator
+{
+public:
+
+    using value_type = T;
+
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    template <class U>
+    struct rebind { using other = OcTreePoolAllocator<U>; };
+
+    OcTreePoolAllocator() :
+        m_pool(std::make_shared<detail::OcTreeBlockPool>(8 * sizeof(T), alignof(T)))
+    { }
+
+    // copies, including moves, share the pool, so that a moved-from tree
+    // remains usable
+    OcTreePoolAllocator(const OcTreePoolAllocator&) = default;
+    OcTreePoolAllocator& operator=(const OcTreePoolAllocator&) = default;
+
+    template <class U>
+    OcTreePoolAllocator(const OcTreePoolAllocator<U>&) : OcTreePoolAllocator() { }
+
+    T* allocate(std::size_t n)
+    {
+        if (n == 8) {
+            return static_cast<T*>(m_pool->allocate());
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n)
+    {
+        if (n == 8) {
+            m_pool->deallocate(p);
+        } else {
+            ::operator delete(p);
+        }
+    }
+
+    OcTreePoolAllocator select_on_container_copy_construction() const
+    {
+        return OcTreePoolAllocator();
+    }
+
+    /// Total size, in bytes, of the slabs owned by the allocator's pool.
+    std::size_t pool_capacity() const { return m_pool->capacity(); }
+
+    bool operator==(const OcTreePoolAllocator& o) const { return m_pool == o.m_pool; }
+    bool operator!=(const OcTreePoolAllocator& o) const { return m_pool != o.m_pool; }
+
+private:
+
+    std::shared_ptr<detail::OcTreeBlockPool> m_pool;
+};
+
+} // namespace smpl
+
+#endif
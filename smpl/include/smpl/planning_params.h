@@ -39,6 +39,7 @@
 #include <unordered_map>
 
 // system includes
+#include <boost/optional.hpp>
 #include <boost/variant.hpp>
 
 #define G_LOG "graph"
@@ -70,6 +71,92 @@ struct ParameterException : public std::runtime_error
 
 using Parameter = boost::variant<bool, int, double, std::string>;
 
+/// Typed copy of the parameters read by the planning space, heuristic, and
+/// search factories. Each field is kept in sync with the parameter of the same
+/// name by PlanningParams::addParam, so pipelines can be constructed without
+/// looking up or converting parameters by name. Fields without a sensible
+/// default are optional and left empty until the parameter is added.
+struct CompiledPlanningParams
+{
+    /// \name Planning Space
+    ///@{
+    boost::optional<std::string> discretization;
+    boost::optional<std::string> mprim_filename;
+    bool use_multiple_ik_solutions = false;
+    bool use_ik_cache = false;
+    int ik_sampling_seeds = 1;
+    int ik_sampling_threads = 1;
+    bool use_clearance_scaling = false;
+    double clearance_scaling_min = 0.1;
+    double clearance_scaling_max = 0.5;
+    int clearance_scaling_max_scale = 1;
+    bool use_xyz_snap_mprim = false;
+    bool use_rpy_snap_mprim = false;
+    bool use_xyzrpy_snap_mprim = false;
+    bool use_short_dist_mprims = false;
+    double xyz_snap_dist_thresh = 0.0;
+    double rpy_snap_dist_thresh = 0.0;
+    double xyzrpy_snap_dist_thresh = 0.0;
+    double short_dist_mprims_thresh = 0.0;
+    int action_check_threads = 1;
+    bool ordered_expansion = false;
+    bool ordered_expansion_early_exit = false;
+    double space_memory_limit = 0.0;
+    boost::optional<std::string> egraph_path;
+    int egraph_load_threads = 1;
+    ///@}
+
+    /// \name Heuristic
+    ///@{
+    double bfs_inflation_radius = 0.0;
+    int bfs_threads = 1;
+    double soft_bfs_clearance = 0.0;
+    double soft_bfs_clearance_weight = 0.0;
+    int mfbfs_ee_cell_scale = 1;
+    double offset_x = 0.0;
+    double offset_y = 0.0;
+    double offset_z = 0.0;
+    double x_coeff = 1.0;
+    double y_coeff = 1.0;
+    double z_coeff = 1.0;
+    double rot_coeff = 1.0;
+    double turning_radius = 1.0;
+    double dubins_table_extent = 0.0;
+    double dubins_table_res = 0.1;
+    int dubins_table_headings = 16;
+    double egraph_epsilon = 1.0;
+    ///@}
+
+    /// \name Search
+    ///@{
+    std::string open_list = "heap";
+    double epsilon = 1.0;
+    double epsilon_mha = 1.0;
+    double epsilon_plan = 1.0;
+    double epsilon_track = 1.0;
+    bool pipeline_plan_track = false;
+    double independence_epsilon = 1.0;
+    bool search_mode = false;
+    int thread_count = 1;
+    bool concurrent_successors = false;
+    boost::optional<bool> allow_partial_solutions;
+    boost::optional<bool> backward_search;
+    boost::optional<double> target_epsilon;
+    boost::optional<double> delta_epsilon;
+    boost::optional<bool> improve_solution;
+    boost::optional<bool> bound_expansions;
+    boost::optional<double> repair_time;
+    boost::optional<double> search_memory_limit;
+    boost::optional<bool> goal_set_search;
+    boost::optional<int> goal_set_count;
+    int egraph_successor_period = 1;
+    bool adaptive_egraph = false;
+    double min_egraph_epsilon = 1.0;
+    double max_egraph_epsilon = 10.0;
+    int egraph_adaptation_window = 5;
+    ///@}
+};
+
 class PlanningParams
 {
 public:
@@ -122,16 +209,25 @@ public:
 
     bool hasParam(const std::string& name) const;
 
+    /// Return the typed parameters read by the pipeline factories. A
+    /// ParameterException is thrown by addParam if the value of one of these
+    /// parameters can not be converted to the type of its field.
+    auto compiled() const -> const CompiledPlanningParams& { return m_compiled; }
+
 private:
 
     std::unordered_map<std::string, Parameter> params;
 
+    CompiledPlanningParams m_compiled;
+
     bool m_warn_defaults;
 
     void convertToBool(const Parameter& p, bool& val) const;
     void convertToInt(const Parameter& p, int& val) const;
     void convertToDouble(const Parameter& p, double& val) const;
     void convertToString(const Parameter& p, std::string& val) const;
+
+    void compileParam(const std::string& name, const Parameter& p);
 };
 
 } // namespace smpl
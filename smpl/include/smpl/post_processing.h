@@ -37,6 +37,7 @@
 #include <vector>
 
 // project includes
+#include <smpl/cancellation.h>
 #include <smpl/collision_checker.h>
 #include <smpl/robot_model.h>
 #include <smpl/planning_params.h>
@@ -44,22 +45,185 @@
 
 namespace smpl {
 
+/// Shortcut a path by replacing segments with the motions of a shortcut
+/// generator. Once \p token expires, the remaining segments are kept as they
+/// are.
 void ShortcutPath(
     RobotModel* rm,
     CollisionChecker* cc,
     const std::vector<RobotState>& pin,
     std::vector<RobotState>& pout,
-    ShortcutType type);
+    ShortcutType type,
+    const CancellationToken* token = nullptr);
+
+/// \brief Shortcut a path by replacing segments between randomly sampled
+///     pairs of waypoints with straight joint-space motions.
+///
+/// Each round samples a batch of candidate waypoint pairs that would shorten
+/// the path, validates the candidates concurrently with one collision checker
+/// per thread, and applies the non-overlapping valid candidates with the
+/// largest savings. Threads beyond the first require \p cc to provide a
+/// CollisionCheckerCloneExtension; otherwise candidates are checked serially.
+///
+/// \param thread_count The number of threads used to validate candidates
+/// \param allowed_time Time budget, in seconds. A non-positive budget is
+///     unbounded.
+/// \param batch_size The number of candidates sampled per round. Defaults to
+///     four per thread when non-positive.
+/// \param max_stalled_rounds The number of consecutive rounds without an
+///     improvement after which shortcutting stops
+/// \param token If non-null, shortcutting stops after the round in which the
+///     token expires
+void ParallelShortcutPath(
+    RobotModel* rm,
+    CollisionChecker* cc,
+    const std::vector<RobotState>& pin,
+    std::vector<RobotState>& pout,
+    int thread_count,
+    double allowed_time,
+    int batch_size = 0,
+    int max_stalled_rounds = 10,
+    const CancellationToken* token = nullptr);
+
+/// \brief Smooth a path within a time budget, returning the best path found
+///     when the budget runs out.
+///
+/// Rounds of randomized shortcuts, as in ParallelShortcutPath(), alternate
+/// with rounds of partial shortcuts, which straighten the motion of a single
+/// joint between two waypoints while the other joints keep their original
+/// motion. The path remains valid after every round. Smoothing may finish
+/// early, after \p max_stalled_rounds consecutive rounds without an
+/// improvement.
+///
+/// \param allowed_time Time budget, in seconds. The input path is returned
+///     unchanged when the budget is non-positive.
+/// \param thread_count The number of threads used to validate candidates
+/// \param token If non-null, smoothing stops after the round in which the
+///     token expires
+void AnytimeSmoothPath(
+    RobotModel* rm,
+    CollisionChecker* cc,
+    const std::vector<RobotState>& pin,
+    std::vector<RobotState>& pout,
+    double allowed_time,
+    int thread_count = 1,
+    int max_stalled_rounds = 20,
+    const CancellationToken* token = nullptr);
+
+/// \brief Smooth a path by gradient descent on a smoothness and obstacle cost,
+///     as in CHOMP.
+///
+/// The endpoints of the path are fixed. Each iteration moves the interior
+/// waypoints against the gradient of the path's squared velocity plus
+/// \p obstacle_weight times its obstacle cost, from
+/// CollisionDistanceExtension::collisionCostGradient(), both integrated over
+/// the path in normalized time so that the weight does not depend on the
+/// waypoint count.
+/// The step is taken under the metric of the smoothness cost, so that it is
+/// spread smoothly along the path, and is clamped to the joint position
+/// limits. The path is densely interpolated beforehand, since only the
+/// waypoints are pushed away from obstacles. Motions are validated only once
+/// iterating has finished; if the final path is invalid, earlier iterates are
+/// tried, halving the iteration count each time.
+///
+/// \param clearance The distance from obstacles below which the obstacle
+///     cost is positive
+/// \param step_size The fraction of the covariant step taken per iteration.
+///     A step size of 1 with no obstacle cost straightens the path in a
+///     single iteration.
+/// \return false, with \p pout set to \p pin, if \p cc does not support
+///     collision cost gradients or no optimized path was valid
+bool OptimizePath(
+    RobotModel* rm,
+    CollisionChecker* cc,
+    const std::vector<RobotState>& pin,
+    std::vector<RobotState>& pout,
+    int iterations = 20,
+    double clearance = 0.1,
+    double obstacle_weight = 100.0,
+    double step_size = 0.2,
+    const CancellationToken* token = nullptr);
+
+/// \brief Push a state that is slightly in collision out of collision.
+///
+/// Each iteration steps against the gradient of the obstacle cost from
+/// CollisionDistanceExtension::collisionCostGradient(), scaled so that no
+/// variable moves by more than \p max_step, and clamped to the joint position
+/// limits. A step that does not lower the cost is retried at half the size.
+/// Iterating stops at the first valid state.
+///
+/// \param clearance The distance from obstacles below which the obstacle
+///     cost is positive
+/// \return true, with \p repaired set to the first valid state, if \p state
+///     is valid or was repaired within \p iterations iterations; false, with
+///     \p repaired set to \p state, otherwise or if \p cc does not support
+///     collision cost gradients
+bool RepairState(
+    RobotModel* rm,
+    CollisionChecker* cc,
+    const RobotState& state,
+    RobotState& repaired,
+    int iterations = 10,
+    double clearance = 0.05,
+    double max_step = 0.05);
+
+/// \brief Time-parameterize a path under the joint velocity and acceleration
+///     limits of a robot model.
+///
+/// The robot follows the straight joint-space segments of the path with all
+/// joints synchronized, accelerating, cruising, and decelerating along each
+/// segment at the fastest rate any joint allows. Waypoints are passed at
+/// speed where the direction of the path changes little, with the speed at
+/// each waypoint bounded by the acceleration needed to round the corner
+/// within \p junction_deviation of it; the robot stops at sharp corners and
+/// at both ends of the path. Joints without a positive velocity or
+/// acceleration limit are not limited by it.
+///
+/// \param times The time from the start of the path at which each waypoint is
+///     reached
+/// \param velocities The joint velocities leaving each waypoint; zero at the
+///     last waypoint
+/// \return false if the waypoints do not all have one variable per planning
+///     joint of the robot model
+bool ComputeTrapezoidalTimeParameterization(
+    RobotModel* rm,
+    const std::vector<RobotState>& path,
+    std::vector<double>& times,
+    std::vector<RobotState>& velocities,
+    double junction_deviation = 0.01);
 
 bool InterpolatePath(
     CollisionChecker& cc,
     std::vector<RobotState>& path);
 
+/// \brief Interpolate a path at the resolution of a collision checker into a
+///     flat buffer.
+///
+/// The interpolated waypoints, of path.front().size() variables each, are
+/// stored back to back in \p opath. A segment whose interpolation collides is
+/// replaced by its end waypoint. \p opath keeps its capacity between calls,
+/// so interpolating similar paths into the same buffer does not allocate.
+bool InterpolatePath(
+    CollisionChecker& cc,
+    const std::vector<RobotState>& path,
+    std::vector<double>& opath);
+
 bool CreatePositionVelocityPath(
     RobotModel* rm,
     const std::vector<RobotState>& path,
     std::vector<RobotState>& opath);
 
+/// \brief Create a position-velocity path from a flat buffer of \p count
+///     waypoints of one variable per planning joint.
+///
+/// \p opath receives \p count waypoints of twice as many variables, the
+/// positions followed by the signs of the velocities, back to back.
+bool CreatePositionVelocityPath(
+    RobotModel* rm,
+    const double* path,
+    size_t count,
+    std::vector<double>& opath);
+
 bool ExtractPositionPath(
     RobotModel* rm,
     const std::vector<RobotState>& pv_path,
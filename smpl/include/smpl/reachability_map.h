@@ -0,0 +1,173 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_REACHABILITY_MAP_H
+#define SMPL_REACHABILITY_MAP_H
+
+// standard includes
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// project includes
+#include <smpl/spatial.h>
+#include <smpl/types.h>
+
+namespace smpl {
+
+class CollisionChecker;
+class RobotModel;
+
+#define REACHABILITY_MAP_FILE_MAGIC "SMPLRMAP"
+#define REACHABILITY_MAP_FILE_VERSION 1
+
+/// Fixed-size header at the start of a binary reachability map file. The
+/// header is followed by these sections, each a contiguous array of 4-byte
+/// values:
+///
+///     voxel counts   uint32[voxel_count]
+///     cells          int32[voxel_count * orientation_bins^3]
+///     seeds          float[seed_count * dof]
+///
+/// where voxel_count = size[0] * size[1] * size[2]. The voxel count is the
+/// number of orientation bins reached within a voxel. A cell holds the index
+/// of the seed that reached it, or -1.
+struct ReachabilityMapFileHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t dof;
+    std::uint32_t size[3];
+    std::uint32_t orientation_bins;
+    std::uint64_t seed_count;
+    double origin[3];
+    double resolution;
+};
+
+/// A precomputed map of the poses reachable by the planning link, built
+/// offline by sampling joint configurations within the joint limits.
+///
+/// Positions are binned into voxels and orientations into roll, pitch, and
+/// yaw bins. Each reached (voxel, orientation) cell stores the first
+/// configuration that reached it, which makes a good seed for inverse
+/// kinematics near that pose. Queries are constant-time lookups into dense
+/// arrays, so the map can reject implausible goals before any search or IK
+/// effort is spent.
+///
+/// Since the map is sampled, an empty cell does not prove a pose unreachable.
+/// Queries accept a pose if any cell in the neighborhood of its own cell was
+/// reached.
+///
+/// Loaded maps are read-only, shared memory mappings of the map file, so
+/// planner processes loading the same map share its pages.
+class ReachabilityMap
+{
+public:
+
+    ReachabilityMap() = default;
+    ~ReachabilityMap();
+
+    ReachabilityMap(const ReachabilityMap&) = delete;
+    ReachabilityMap& operator=(const ReachabilityMap&) = delete;
+
+    /// Build a map over the box [min, max] from \p sample_count random
+    /// configurations of \p robot, which must support forward kinematics.
+    /// If \p checker is given, only collision-free configurations are
+    /// recorded.
+    bool build(
+        RobotModel* robot,
+        CollisionChecker* checker,
+        const Vector3& min,
+        const Vector3& max,
+        double resolution,
+        int orientation_bins,
+        int sample_count,
+        std::uint32_t random_seed = 0);
+
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+    void clear();
+
+    bool empty() const { return m_cells == nullptr; }
+
+    auto dof() const -> std::size_t { return m_header.dof; }
+    auto seedCount() const -> std::size_t { return m_header.seed_count; }
+    auto resolution() const -> double { return m_header.resolution; }
+    auto orientationBins() const -> int { return m_header.orientation_bins; }
+
+    /// Return whether the planning link may reach \p pose.
+    bool reachable(const Affine3& pose) const;
+
+    /// Return whether the planning link may reach \p position in any
+    /// orientation.
+    bool reachable(const Vector3& position) const;
+
+    /// Return the fraction of orientation bins reached in the voxel
+    /// containing \p position, or 0 if it lies outside the map.
+    double capability(const Vector3& position) const;
+
+    /// Store in \p seed the configuration that reached the cell nearest to
+    /// \p pose. Returns false if no cell in its neighborhood was reached.
+    bool seed(const Affine3& pose, RobotState& seed) const;
+
+    auto memoryUsage() const -> std::size_t;
+
+private:
+
+    ReachabilityMapFileHeader m_header = { };
+
+    // mapping of a loaded map file
+    void* m_data = nullptr;
+    std::size_t m_size = 0;
+
+    // sections of a built map
+    std::vector<std::uint32_t> m_voxel_counts_data;
+    std::vector<std::int32_t> m_cells_data;
+    std::vector<float> m_seeds_data;
+
+    // views of the sections, into either the mapping or the vectors above
+    const std::uint32_t* m_voxel_counts = nullptr;
+    const std::int32_t* m_cells = nullptr;
+    const float* m_seeds = nullptr;
+
+    bool voxelCoord(const Vector3& position, int* coord) const;
+    void orientationCoord(const Affine3& pose, int* coord) const;
+
+    auto voxelCount() const -> std::size_t;
+    auto orientationCount() const -> std::size_t;
+
+    int findSeed(const Affine3& pose) const;
+};
+
+} // namespace smpl
+
+#endif
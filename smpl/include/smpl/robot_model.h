@@ -75,6 +75,13 @@ public:
     /// \brief Check a state for joint limit violations.
     virtual bool checkJointLimits(const RobotState& state, bool verbose = false) = 0;
 
+    /// \brief Check a state, viewed without copying, for joint limit
+    ///     violations.
+    ///
+    /// The default implementation copies the state and calls the RobotState
+    /// overload.
+    virtual bool checkJointLimits(RobotStateView state, bool verbose = false);
+
     size_t jointCount() const { return planning_joints_.size(); }
     size_t jointVariableCount() const { return planning_joints_.size(); }
 
@@ -100,6 +107,21 @@ public:
     ///
     /// \return true if forward kinematics were computed; false otherwise
     virtual Affine3 computeFK(const RobotState& state) = 0;
+
+    /// \brief Compute forward kinematics of the planning link for a state
+    ///     viewed without copying.
+    ///
+    /// The default implementation copies the state and calls the RobotState
+    /// overload.
+    virtual Affine3 computeFK(RobotStateView state);
+
+    /// \brief Compute forward kinematics of the planning link for a batch of
+    ///     states.
+    ///
+    /// \p states holds \p n consecutive states of jointVariableCount()
+    /// variables each. The pose of the i'th state is stored in \p poses[i].
+    /// The default implementation calls computeFK once per state.
+    virtual void computeFKBatch(const double* states, int n, Affine3* poses);
 };
 
 namespace ik_option {
@@ -136,6 +158,21 @@ public:
         const RobotState& start,
         std::vector<RobotState>& solutions,
         ik_option::IkOption option = ik_option::UNRESTRICTED) = 0;
+
+    /// \brief Compute an inverse kinematics solution for each of a batch of
+    ///     poses.
+    ///
+    /// The i'th solution is seeded from \p seeds[i] and stored in
+    /// \p solutions[i], which is left empty if no solution was found. The
+    /// default implementation calls computeIK once per pose.
+    ///
+    /// \return The number of solutions found
+    virtual int computeIKBatch(
+        const Affine3* poses,
+        const RobotState* seeds,
+        int n,
+        RobotState* solutions,
+        ik_option::IkOption option = ik_option::UNRESTRICTED);
 };
 
 class RedundantManipulatorInterface : public virtual RobotModel
@@ -155,6 +192,29 @@ public:
         const Affine3& pose,
         const RobotState& start,
         RobotState& solution) = 0;
+
+    /// \brief Batch variant of computeFastIK, with the same conventions as
+    ///     InverseKinematicsInterface::computeIKBatch.
+    virtual int computeFastIKBatch(
+        const Affine3* poses,
+        const RobotState* seeds,
+        int n,
+        RobotState* solutions);
+};
+
+/// \brief Extension for robot models that can produce independent copies of
+///     themselves for use from multiple threads.
+///
+/// A clone must describe the same robot as the model it was created from, but
+/// must keep its own kinematics solver state so that the original and all of
+/// its clones may be queried concurrently.
+class RobotModelCloneExtension : public virtual RobotModel
+{
+public:
+
+    virtual ~RobotModelCloneExtension() { }
+
+    virtual auto clone() -> std::unique_ptr<RobotModel> = 0;
 };
 
 /// \brief Convenience class allowing a component to implement all root
@@ -175,6 +235,9 @@ public:
     bool checkJointLimits(const RobotState& state, bool verbose = false) {
         return m_parent->checkJointLimits(state, verbose);
     }
+    bool checkJointLimits(RobotStateView state, bool verbose = false) {
+        return m_parent->checkJointLimits(state, verbose);
+    }
 
 private:
 
@@ -33,6 +33,7 @@
 #define SMPL_ADAPTIVE_PLANNER_H
 
 // standard includes
+#include <future>
 #include <random>
 
 // system includes
@@ -46,7 +47,7 @@
 
 namespace smpl {
 
-class AdaptivePlanner : public SBPLPlanner
+class AdaptivePlanner : public SBPLPlanner, public CancellationExtension
 {
 public:
 
@@ -68,6 +69,18 @@ public:
     double get_plan_eps() const { return m_eps_plan; }
     double get_track_eps() const { return m_eps_track; }
 
+    /// \brief Run the next plan phase speculatively while the track phase runs.
+    ///
+    /// The speculative plan assumes the track phase will fail or be rejected,
+    /// growing a high-dimensional region around a random state of the
+    /// planned path before the track phase starts; it is discarded if the
+    /// tracked path is accepted or only partial. Requires a graph that
+    /// supports AdaptiveGraphExtension::enableConcurrentPlanning and a
+    /// heuristic that supports concurrent queries; otherwise the phases run
+    /// sequentially.
+    void set_pipelining(bool enabled) { m_pipelining = enabled; }
+    bool get_pipelining() const { return m_pipelining; }
+
     /// \name Reimplemented Public Functions from SBPLPlanner
     ///@{
     int replan(std::vector<int>* solution, ReplanParams params) override;
@@ -98,11 +111,26 @@ public:
     void costs_changed(const StateChangeQuery& state_change) override;
     ///@}
 
+    /// \name Required Public Functions from Extension
+    ///@{
+    Extension* getExtension(size_t class_code) override;
+    ///@}
+
+    /// \name Required Public Functions from CancellationExtension
+    ///@{
+    void setCancellationToken(const CancellationToken* token) override;
+    ///@}
+
 private:
 
     ARAStar m_planner;
     ARAStar m_tracker;
 
+    const CancellationToken* m_cancel = nullptr;
+
+    // polled by m_planner during a speculative plan phase
+    CancellationToken m_speculation_cancel;
+
     AdaptiveGraphExtension* m_adaptive_graph;
 
     TimeParameters m_time_params;
@@ -114,6 +142,14 @@ private:
 
     double m_eps_plan;
     double m_eps_track;
+
+    bool m_pipelining = false;
+
+    auto startSpeculativePlan(
+        double time_remaining,
+        std::vector<int>* path,
+        int* cost)
+        -> std::future<int>;
 };
 
 } // namespace smpl
@@ -0,0 +1,208 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_ANASTAR_H
+#define SMPL_ANASTAR_H
+
+// standard includes
+#include <vector>
+
+// system includes
+#include <sbpl/heuristics/heuristic.h>
+#include <sbpl/planners/planner.h>
+
+// project includes
+#include <smpl/heap/dary_heap.h>
+#include <smpl/arena.h>
+#include <smpl/cancellation.h>
+#include <smpl/memory_usage.h>
+#include <smpl/time.h>
+
+namespace smpl {
+
+/// An implementation of the ANA* (Anytime Nonparametric A*) search algorithm.
+/// ANA* expands the state in OPEN with the greatest potential
+/// e(s) = (G - g(s)) / h(s), where G is the cost of the best solution found so
+/// far. Until the first solution is found, G is infinite and the search is a
+/// greedy search on the heuristic. Each solution found lowers G, after which
+/// the states in OPEN are reordered by their new potential and those that can
+/// not lead to a cheaper solution are pruned. The solution improves
+/// continuously, without the schedule of suboptimality bounds that ARA*
+/// requires, until OPEN is exhausted and the solution is optimal.
+///
+/// The suboptimality bound of the current solution, returned by
+/// get_solution_eps(), is the least potential of the states expanded since the
+/// first solution was found.
+///
+/// As with ARAStar, the search is resumed by subsequent calls to replan()
+/// while the start and goal state IDs are unchanged, under the same
+/// assumptions about the graph and heuristic.
+class ANAStar :
+    public SBPLPlanner,
+    public MemoryUsageExtension,
+    public CancellationExtension
+{
+public:
+
+    ANAStar(DiscreteSpaceInformation* space, Heuristic* heuristic);
+    ~ANAStar();
+
+    /// Limit the memory allocated for search states, or remove the limit if
+    /// \p bytes is 0. See ARAStar::setMemoryLimit().
+    void setMemoryLimit(std::size_t bytes) { m_state_arena.setCapacityLimit(bytes); }
+    auto memoryLimit() const -> std::size_t { return m_state_arena.capacityLimit(); }
+
+    /// Set whether replan() continues to improve the solution, within its
+    /// allowed time, after the first solution is found.
+    void setImproveSolution(bool improve) { m_improve = improve; }
+    bool improveSolution() const { return m_improve; }
+
+    /// \name Required Functions from SBPLPlanner
+    ///@{
+    int replan(double allowed_time_secs, std::vector<int>* solution) override;
+    int replan(double allowed_time_secs, std::vector<int>* solution, int* solcost) override;
+    int set_goal(int state_id) override;
+    int set_start(int state_id) override;
+    int force_planning_from_scratch() override;
+    int set_search_mode(bool bSearchUntilFirstSolution) override;
+    void costs_changed(const StateChangeQuery& stateChange) override;
+    ///@}
+
+    /// \name Reimplemented Functions from SBPLPlanner
+    ///@{
+    int replan(std::vector<int>* solution, ReplanParams params) override;
+    int replan(std::vector<int>* solution, ReplanParams params, int* solcost) override;
+    int force_planning_from_scratch_and_free_memory() override;
+    double get_solution_eps() const override;
+    int get_n_expands() const override;
+    double get_initial_eps() override;
+    double get_initial_eps_planning_time() override;
+    double get_final_eps_planning_time() override;
+    int get_n_expands_init_solution() override;
+    double get_final_epsilon() override;
+    void get_search_stats(std::vector<PlannerStats>* s) override;
+    void set_initialsolution_eps(double eps) override { }
+    ///@}
+
+    /// \name Required Functions from Extension
+    ///@{
+    Extension* getExtension(size_t class_code) override;
+    ///@}
+
+    /// \name Required Functions from MemoryUsageExtension
+    ///@{
+    auto memoryUsage() const -> std::size_t override;
+    ///@}
+
+    /// \name Required Functions from CancellationExtension
+    ///@{
+    void setCancellationToken(const CancellationToken* token) override {
+        m_cancel = token;
+    }
+    ///@}
+
+private:
+
+    struct SearchState : public heap_element
+    {
+        int state_id;       // corresponding graph state
+        unsigned int g;     // cost-to-come
+        unsigned int h;     // estimated cost-to-go
+        double key;         // h before the first solution, -e(s) after
+        unsigned short call_number;
+        SearchState* bp;
+    };
+
+    struct SearchStateKey
+    {
+        double operator()(const SearchState& s) const { return s.key; }
+    };
+
+    using OpenList = dary_heap<SearchState, SearchStateKey>;
+
+    DiscreteSpaceInformation* m_space;
+    Heuristic* m_heur;
+
+    std::vector<SearchState*> m_states;
+    Arena m_state_arena; // backing storage for the search states
+
+    int m_start_state_id;
+    int m_goal_state_id;
+
+    OpenList m_open;
+
+    std::vector<int> m_succs;
+    std::vector<int> m_costs;
+
+    int m_call_number;          // for lazy reinitialization of search states
+    int m_last_start_state_id;
+    int m_last_goal_state_id;
+
+    bool m_improve;
+    bool m_bounded;
+    clock::duration m_allowed_time;
+
+    unsigned int m_solution_cost;   // G
+    double m_solution_eps;          // suboptimality bound of the solution
+    std::vector<int> m_solution;
+
+    int m_expand_count_init;
+    clock::duration m_search_time_init;
+    int m_expand_count;
+    clock::duration m_search_time;
+
+    // stops the search, as if it ran out of time, once expired
+    const CancellationToken* m_cancel = nullptr;
+
+    bool timedOut(const clock::duration& elapsed_time) const;
+
+    int improvePath(
+        const clock::time_point& start_time,
+        SearchState* goal_state,
+        int& elapsed_expansions,
+        clock::duration& elapsed_time);
+
+    bool expand(SearchState* s);
+
+    void pruneOpen();
+    double computeKey(const SearchState* s) const;
+
+    SearchState* getSearchState(int state_id);
+    SearchState* createState(int state_id);
+    void reinitSearchState(SearchState* state);
+
+    void extractPath(SearchState* to_state, std::vector<int>& solution) const;
+};
+
+} // namespace smpl
+
+#endif
@@ -36,17 +36,42 @@
 #include <assert.h>
 #include <algorithm>
 #include <functional>
+#include <vector>
 
 // system includes
 #include <sbpl/heuristics/heuristic.h>
 #include <sbpl/planners/planner.h>
 
 // project includes
-#include <smpl/heap/intrusive_heap.h>
+#include <smpl/heap/bucket_heap.h>
+#include <smpl/heap/dary_heap.h>
+#include <smpl/arena.h>
+#include <smpl/cancellation.h>
+#include <smpl/memory_usage.h>
+#include <smpl/search/search_trace.h>
 #include <smpl/time.h>
 
 namespace smpl {
 
+class GoalSetExtension;
+class GoalSetHeuristicExtension;
+
+/// Selects a dary_heap as the OPEN list of BasicARAStar.
+struct DaryHeapOpenList
+{
+    template <class T, class KeyOf>
+    using type = dary_heap<T, KeyOf>;
+};
+
+/// Selects a bucket_heap as the OPEN list of BasicARAStar. Suitable for graphs
+/// with integer edge costs and heuristics whose f-values in OPEN span a
+/// modest range.
+struct BucketHeapOpenList
+{
+    template <class T, class KeyOf>
+    using type = bucket_heap<T, KeyOf>;
+};
+
 /// An implementation of the ARA* (Anytime Repairing A*) search algorithm. This
 /// algorithm runs a series of weighted A* searches with decreasing bounds on
 /// suboptimality to return the best solution found within a given time bound.
@@ -77,7 +102,28 @@ namespace smpl {
 ///
 /// * The heuristics for any encountered states remain constant, unless the goal
 ///   state ID has changed.
-class ARAStar : public SBPLPlanner
+///
+/// In backward search mode (setBackwardSearch()), the search is rooted at the
+/// goal state, expands predecessors (GetPreds), and is guided by the heuristic
+/// distance to the start state (GetStartHeuristic). The roles of the start and
+/// goal above are swapped: the tree is kept across changes to the start state
+/// ID, and is discarded only when the goal state ID changes.
+///
+/// In goal-set search mode (setGoalSetSearch()), the search looks for paths to
+/// a set of goals exposed by the graph through GoalSetExtension, rather than
+/// for a path to the goal state, and can return paths to several distinct
+/// goals from one search (see goalSolutions()). The goal state ID then serves
+/// only to tell when the goal has changed, which restarts the search.
+///
+/// The data structure used for the OPEN list is selected by \p OpenPolicy,
+/// which provides a member alias template type<T, KeyOf> naming a priority
+/// queue with the interface of dary_heap. Instantiations are provided for
+/// DaryHeapOpenList (ARAStar) and BucketHeapOpenList (BucketARAStar).
+template <class OpenPolicy>
+class BasicARAStar :
+    public SBPLPlanner,
+    public MemoryUsageExtension,
+    public CancellationExtension
 {
 public:
 
@@ -95,8 +141,8 @@ public:
         std::function<bool()> timed_out_fun;
     };
 
-    ARAStar(DiscreteSpaceInformation* space, Heuristic* heuristic);
-    ~ARAStar();
+    BasicARAStar(DiscreteSpaceInformation* space, Heuristic* heuristic);
+    ~BasicARAStar();
 
     void allowPartialSolutions(bool enabled) {
         m_allow_partial_solutions = enabled;
@@ -104,6 +150,93 @@ public:
 
     bool allowPartialSolutions() const { return m_allow_partial_solutions; }
 
+    /// Search from the goal to the start, so that the search tree may be reused
+    /// when only the start state changes between calls to replan(). Requires
+    /// the graph to implement GetPreds and the heuristic to implement
+    /// GetStartHeuristic. Partial solutions are not returned in this mode.
+    void setBackwardSearch(bool backward) {
+        if (backward != m_backward_search) {
+            m_backward_search = backward;
+            force_planning_from_scratch();
+        }
+    }
+
+    bool backwardSearch() const { return m_backward_search; }
+
+    /// How a goal-set search decides that it is done
+    enum class GoalSetTermination
+    {
+        FirstGoal,  ///< stop once any goal is reached
+        BestGoals   ///< stop once the cheapest goals are known within the bound
+    };
+
+    /// A path to one of the goals reached by a goal-set search
+    struct GoalSolution
+    {
+        int goal; ///< index of the goal in the goal set
+        std::vector<int> path;
+        int cost;
+    };
+
+    /// Search for paths to the goals of a goal set rather than to the goal
+    /// state. Requires the graph to provide GoalSetExtension. If the heuristic
+    /// provides GoalSetHeuristicExtension, the heuristic of a state is its
+    /// minimum over all goals; otherwise GetGoalHeuristic is used. Not
+    /// supported in backward search mode.
+    void setGoalSetSearch(bool enabled) {
+        if (enabled != m_goal_set_search) {
+            m_goal_set_search = enabled;
+            force_planning_from_scratch();
+        }
+    }
+
+    bool goalSetSearch() const { return m_goal_set_search; }
+
+    /// Set when a goal-set search stops. With FirstGoal, replan() returns the
+    /// path to the first goal reached, without a bound on its suboptimality or
+    /// further improvement. With BestGoals, replan() returns once the paths to
+    /// the \p count cheapest goals satisfy the current suboptimality bound, or
+    /// once every reachable goal has been found, if fewer are reachable.
+    void setGoalSetTermination(GoalSetTermination termination, int count = 1) {
+        m_goal_set_termination = termination;
+        m_goal_set_count = std::max(count, 1);
+        force_planning_from_scratch();
+    }
+
+    auto goalSetTermination() const -> GoalSetTermination {
+        return m_goal_set_termination;
+    }
+
+    int goalSetCount() const { return m_goal_set_count; }
+
+    /// Return the paths to distinct goals found by the last call to replan()
+    /// in goal-set search mode, cheapest first. The first is the solution
+    /// returned by replan().
+    auto goalSolutions() const -> const std::vector<GoalSolution>& {
+        return m_goal_solutions;
+    }
+
+    /// Limit the memory allocated for search states, or remove the limit if
+    /// \p bytes is 0. When a state expansion would exceed the limit, the state
+    /// is returned to OPEN and replan() stops as if it had run out of time,
+    /// returning the best solution found so far or, if partial solutions are
+    /// allowed, a partial one.
+    void setMemoryLimit(std::size_t bytes) { m_state_arena.setCapacityLimit(bytes); }
+    auto memoryLimit() const -> std::size_t { return m_state_arena.capacityLimit(); }
+
+    /// Discard the search states that cannot lie on a path cheaper than the
+    /// current solution once a solution is found, along with their graph
+    /// states if the graph provides StateRetirementExtension. A state is
+    /// discarded if its g-value plus its (uninflated) heuristic exceeds the
+    /// solution cost and it is not an ancestor of a kept state. The storage
+    /// of discarded states is reused for new states, which bounds the memory
+    /// used by long anytime searches. The heuristic should be admissible, so
+    /// that the discarded states cannot improve the solution. Not supported in
+    /// goal-set search mode. Changing the goal after states have been
+    /// discarded restarts the search.
+    void setStateRetirement(bool enabled) { m_retire_states = enabled; }
+    bool stateRetirement() const { return m_retire_states; }
+
     void setAllowedRepairTime(double allowed_time_secs) {
         m_time_params.max_allowed_time = to_duration(allowed_time_secs);
     }
@@ -134,11 +267,29 @@ public:
     void setBoundExpansions(bool bound) { m_time_params.bounded = bound; }
     bool boundExpansions() const { return m_time_params.bounded; }
 
+    /// Record the searches, heuristic evaluations, and expansions made by
+    /// subsequent calls to replan(), or stop recording if recorder is null.
+    /// The recorder must outlive its use by the search.
+    void setTraceRecorder(SearchTraceRecorder* recorder) { m_trace = recorder; }
+
     int replan(
         const TimeParameters &params,
         std::vector<int>* solution,
         int* cost);
 
+    /// The progress of a search advanced by step()
+    enum class StepStatus
+    {
+        Searching,  ///< the search is unfinished
+        Solved,     ///< the search is finished and has a solution
+        Failed      ///< the search is finished without a solution
+    };
+
+    /// Advance the search by a bounded number of expansions, so that many
+    /// searches may be interleaved on one thread.
+    auto step(int max_expansions, std::vector<int>* solution, int* cost)
+        -> StepStatus;
+
     /// \name Required Functions from SBPLPlanner
     ///@{
     int replan(double allowed_time_secs, std::vector<int>* solution) override;
@@ -166,6 +317,23 @@ public:
     void set_initialsolution_eps(double eps) override;
     ///@}
 
+    /// \name Required Functions from Extension
+    ///@{
+    Extension* getExtension(size_t class_code) override;
+    ///@}
+
+    /// \name Required Functions from MemoryUsageExtension
+    ///@{
+    auto memoryUsage() const -> std::size_t override;
+    ///@}
+
+    /// \name Required Functions from CancellationExtension
+    ///@{
+    void setCancellationToken(const CancellationToken* token) override {
+        m_cancel = token;
+    }
+    ///@}
+
 private:
 
     struct SearchState : public heap_element
@@ -178,16 +346,18 @@ private:
         unsigned short iteration_closed;
         unsigned short call_number;
         SearchState* bp;
+        int goal;           // index of the goal satisfied, or -1 (goal-set search)
         bool incons;
+        unsigned short h_epoch; // heuristic epoch h was computed in
     };
 
-    struct SearchStateCompare
+    struct SearchStateKey
     {
-        bool operator()(const SearchState& s1, const SearchState& s2) const {
-            return s1.f < s2.f;
-        }
+        unsigned int operator()(const SearchState& s) const { return s.f; }
     };
 
+    using OpenList = typename OpenPolicy::template type<SearchState, SearchStateKey>;
+
     DiscreteSpaceInformation* m_space;
     Heuristic* m_heur;
 
@@ -198,15 +368,29 @@ private:
     double m_delta_eps;
 
     bool m_allow_partial_solutions;
-
-    std::vector<SearchState*> m_states;
+    bool m_backward_search;
+
+    // search states, stored contiguously in pages of StatePageSize states
+    // and indexed directly by graph state id, so that a lookup costs a load
+    // from the small page table rather than a load from a table of pointers
+    // to scattered states. slots for ids not yet seen have a state_id of -1
+    static const int StatePageBits = 8;
+    static const int StatePageSize = 1 << StatePageBits;
+    std::vector<SearchState*> m_state_pages;
+    Arena m_state_arena; // backing storage for the pages
+    std::vector<SearchState*> m_free_pages; // emptied by state retirement
+
+    bool m_retire_states = false;
+    bool m_states_retired = false; // whether states of this search were retired
+    std::vector<char> m_retire_marks;
+    std::vector<int> m_retired_ids;
 
     int m_start_state_id;   // graph state id for the start state
     int m_goal_state_id;    // graph state id for the goal state
 
     // search state (not including the values of g, f, back pointers, and
     // closed list from m_stats)
-    intrusive_heap<SearchState, SearchStateCompare> m_open;
+    OpenList m_open;
     std::vector<SearchState*> m_incons;
     double m_curr_eps;
     int m_iteration;
@@ -215,8 +399,12 @@ private:
     std::vector<int> m_costs;
 
     int m_call_number;          // for lazy reinitialization of search states
-    int m_last_start_state_id;  // for lazy reinitialization of the search tree
-    int m_last_goal_state_id;   // for updating the search tree when the goal changes
+    int m_h_epoch;              // for lazy recomputation of heuristics
+    // for lazy reinitialization of the search tree when its root (the start, or
+    // the goal if searching backward) changes, and for updating the search
+    // tree when its target (the other end) changes
+    int m_last_start_state_id;
+    int m_last_goal_state_id;
     double m_last_eps;          // for updating the search tree when heuristics change
 
     int m_expand_count_init;
@@ -226,6 +414,25 @@ private:
 
     double m_satisfied_eps;
 
+    // result of the search loop of the last call to replan()
+    int m_replan_error = 0;
+
+    SearchTraceRecorder* m_trace = nullptr;
+
+    // stops the search, as if it ran out of time, once expired
+    const CancellationToken* m_cancel = nullptr;
+
+    bool m_goal_set_search = false;
+    GoalSetTermination m_goal_set_termination = GoalSetTermination::BestGoals;
+    int m_goal_set_count = 1;
+    GoalSetExtension* m_goal_set = nullptr;
+    GoalSetHeuristicExtension* m_goal_set_heur = nullptr;
+    int m_goal_count = 0;
+    std::vector<SearchState*> m_goal_states; // cheapest state reaching each goal
+    int m_goals_reached = 0;
+    unsigned int m_goal_bound = 0; // goal-set search is done once OPEN's min f reaches this
+    std::vector<GoalSolution> m_goal_solutions;
+
     void convertTimeParamsToReplanParams(
         const TimeParameters& t,
         ReplanParams& r) const;
@@ -239,18 +446,28 @@ private:
 
     int improvePath(
         const clock::time_point& start_time,
-        SearchState* goal_state,
+        SearchState* target_state,
         int& elapsed_expansions,
         clock::duration& elapsed_time);
 
-    void expand(SearchState* s);
+    bool expand(SearchState* s);
+
+    bool initGoalSet();
+    void resetGoalSet();
+    void updateGoalSet(SearchState* s);
+    bool targetReached(SearchState* min_state, SearchState* target_state) const;
+    void extractGoalSolutions(std::vector<int>& solution, int& cost);
 
+    unsigned int computeHeuristic(int state_id);
     void recomputeHeuristics();
+    void refreshHeuristic(SearchState* s);
     void reorderOpen();
     int computeKey(SearchState* s) const;
 
+    void retireStates(SearchState* target_state);
+
     SearchState* getSearchState(int state_id);
-    SearchState* createState(int state_id);
+    SearchState* createPage(int page);
     void reinitSearchState(SearchState* state);
 
     void extractPath(
@@ -259,6 +476,12 @@ private:
         int& cost) const;
 };
 
+extern template class BasicARAStar<DaryHeapOpenList>;
+extern template class BasicARAStar<BucketHeapOpenList>;
+
+using ARAStar = BasicARAStar<DaryHeapOpenList>;
+using BucketARAStar = BasicARAStar<BucketHeapOpenList>;
+
 } // namespace smpl
 
 #endif
@@ -37,7 +37,8 @@
 #include <sbpl/planners/planner.h>
 
 // project includes
-#include <smpl/heap/intrusive_heap.h>
+#include <smpl/cancellation.h>
+#include <smpl/heap/dary_heap.h>
 #include <smpl/time.h>
 
 namespace smpl {
@@ -72,7 +73,7 @@ namespace smpl {
 ///
 /// * The heuristics for any encountered states remain constant, unless the goal
 ///   state ID has changed.
-struct AWAStar : public SBPLPlanner
+struct AWAStar : public SBPLPlanner, public CancellationExtension
 {
 
     AWAStar(DiscreteSpaceInformation* space, Heuristic* heuristic);
@@ -108,6 +109,18 @@ struct AWAStar : public SBPLPlanner
     void set_initialsolution_eps(double eps) override { m_sus_eps = eps; }
     ///@}
 
+    /// \name Required Functions from Extension
+    ///@{
+    Extension* getExtension(size_t class_code) override;
+    ///@}
+
+    /// \name Required Functions from CancellationExtension
+    ///@{
+    void setCancellationToken(const CancellationToken* token) override {
+        m_cancel = token;
+    }
+    ///@}
+
     struct SearchState : public heap_element
     {
         SearchState* bp;
@@ -125,14 +138,12 @@ struct AWAStar : public SBPLPlanner
         std::uint8_t flags;
     };
 
-    struct SearchStateCompare
+    struct SearchStateKey
     {
-        bool operator()(const SearchState& s1, const SearchState& s2) const {
-            return s1.f < s2.f;
-        }
+        unsigned int operator()(const SearchState& s) const { return s.f; }
     };
 
-    using OpenList = intrusive_heap<SearchState, SearchStateCompare>;
+    using OpenList = dary_heap<SearchState, SearchStateKey>;
 
     DiscreteSpaceInformation*   m_space = nullptr;
     Heuristic*                  m_heur = nullptr;
@@ -156,6 +167,9 @@ struct AWAStar : public SBPLPlanner
     int                         m_min_sus;
     int                         m_expands;
 
+    // stops the search, as if it ran out of time, once expired
+    const CancellationToken*    m_cancel = nullptr;
+
     // search state (not including the values of g, f, back pointers, and
     // closed list from m_stats)
 
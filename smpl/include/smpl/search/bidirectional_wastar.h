@@ -0,0 +1,220 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_BIDIRECTIONAL_WASTAR_H
+#define SMPL_BIDIRECTIONAL_WASTAR_H
+
+// standard includes
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+// system includes
+#include <sbpl/heuristics/heuristic.h>
+#include <sbpl/planners/planner.h>
+
+// project includes
+#include <smpl/cancellation.h>
+#include <smpl/heap/dary_heap.h>
+#include <smpl/time.h>
+
+namespace smpl {
+
+/// A bidirectional weighted A* search that grows a forward search tree from
+/// the start, with GetSuccs() and GetGoalHeuristic(), and a backward search
+/// tree from the goal, with GetPreds() and GetStartHeuristic(), until the two
+/// meet.
+///
+/// Whenever a state is reached by both searches, the path through it is a
+/// candidate solution. The search stops once the best candidate costs no more
+/// than the smallest f-value, g + eps * h, left in either OPEN list, which
+/// bounds its cost by eps times the optimal cost if both heuristics are
+/// consistent. When run on a single thread, the direction with the smaller
+/// OPEN list is expanded next, so the search grows mostly from whichever end
+/// is more constrained, e.g. from a goal inside a narrow passage.
+///
+/// A direction whose OPEN list runs out stops and the other direction continues
+/// on its own. The backward search may therefore be used with graphs whose
+/// GetPreds() only generates some predecessors, or none for some goals; the
+/// solution bound then no longer holds, but the forward search still finds a
+/// path to the goal if one exists.
+///
+/// With two threads, each direction is searched on its own thread. The search
+/// bookkeeping is protected by a single lock and only successor generation
+/// runs outside of it. By default, calls to GetSuccs() and GetPreds() are
+/// serialized; graphs that support concurrent calls for distinct states may
+/// enable concurrent successor generation with allowConcurrentSuccessors().
+///
+/// Each call to replan() searches from scratch.
+class BidirectionalWAStar : public SBPLPlanner, public CancellationExtension
+{
+public:
+
+    BidirectionalWAStar(DiscreteSpaceInformation* space, Heuristic* heuristic);
+    ~BidirectionalWAStar();
+
+    /// Set the number of threads, 1 or 2, used to search.
+    void setThreadCount(int count) { m_thread_count = std::min(std::max(count, 1), 2); }
+    int threadCount() const { return m_thread_count; }
+
+    void allowConcurrentSuccessors(bool allow) { m_concurrent_succs = allow; }
+    bool allowConcurrentSuccessors() const { return m_concurrent_succs; }
+
+    /// \name Required Functions from SBPLPlanner
+    ///@{
+    int replan(double allowed_time_secs, std::vector<int>* solution) override;
+    int replan(double allowed_time_secs, std::vector<int>* solution, int* solcost) override;
+    int set_goal(int state_id) override;
+    int set_start(int state_id) override;
+    int force_planning_from_scratch() override;
+    int set_search_mode(bool bSearchUntilFirstSolution) override;
+    void costs_changed(const StateChangeQuery& stateChange) override;
+    ///@}
+
+    /// \name Reimplemented Functions from SBPLPlanner
+    ///@{
+    int replan(std::vector<int>* solution, ReplanParams params) override;
+    int replan(std::vector<int>* solution, ReplanParams params, int* solcost) override;
+    int force_planning_from_scratch_and_free_memory() override;
+    double get_solution_eps() const override;
+    int get_n_expands() const override;
+    double get_initial_eps() override;
+    double get_initial_eps_planning_time() override;
+    double get_final_eps_planning_time() override;
+    int get_n_expands_init_solution() override;
+    double get_final_epsilon() override;
+    void get_search_stats(std::vector<PlannerStats>* s) override;
+    void set_initialsolution_eps(double eps) override;
+    ///@}
+
+    /// \name Required Functions from Extension
+    ///@{
+    Extension* getExtension(size_t class_code) override;
+    ///@}
+
+    /// \name Required Functions from CancellationExtension
+    ///@{
+    void setCancellationToken(const CancellationToken* token) override {
+        m_cancel = token;
+    }
+    ///@}
+
+private:
+
+    enum Direction { FORWARD = 0, BACKWARD = 1 };
+
+    struct SearchState;
+
+    // the search values of a state in one direction
+    struct DirectionState : public heap_element
+    {
+        SearchState* state;
+        unsigned int g;     // cost-to-come (forward) or cost-to-go (backward)
+        unsigned int h;     // estimated cost to the other end
+        unsigned int f;     // g + eps * h
+        DirectionState* bp;
+        bool reached;       // whether h has been computed
+        bool closed;
+    };
+
+    struct SearchState
+    {
+        int state_id;
+        DirectionState dir[2];
+    };
+
+    struct DirectionStateKey
+    {
+        unsigned int operator()(const DirectionState& s) const { return s.f; }
+    };
+
+    using OpenList = dary_heap<DirectionState, DirectionStateKey>;
+
+    DiscreteSpaceInformation* m_space;
+    Heuristic* m_heur;
+
+    double m_eps = 1.0;
+    bool m_bounded = true;
+    int m_thread_count = 1;
+    bool m_concurrent_succs = false;
+
+    const CancellationToken* m_cancel = nullptr;
+
+    int m_start_state_id = -1;
+    int m_goal_state_id = -1;
+
+    std::vector<SearchState*> m_states;
+    OpenList m_open[2];
+
+    // f-value of the state being expanded in each direction, or INFINITECOST
+    unsigned int m_expanding_f[2];
+
+    // best path found so far, through the state where the searches met
+    unsigned int m_best_cost = INFINITECOST;
+    SearchState* m_meet_state = nullptr;
+
+    clock::time_point m_deadline;
+    bool m_terminate = false;
+    bool m_found = false;
+
+    int m_expand_count[2] = { 0, 0 };
+    clock::duration m_search_time = clock::duration::zero();
+
+    std::mutex m_lock;          // protects the search bookkeeping
+    std::mutex m_space_lock;    // serializes access to the graph
+
+    bool search();
+    void work(Direction d);
+    bool updateTermination();
+    auto minFBound(Direction d) const -> unsigned int;
+    bool timedOut() const;
+
+    auto popState(Direction d) -> SearchState*;
+    void generateNeighbors(
+        Direction d,
+        SearchState* s,
+        std::vector<int>& ids,
+        std::vector<int>& costs);
+    void updateNeighbors(
+        Direction d,
+        SearchState* s,
+        const std::vector<int>& ids,
+        const std::vector<int>& costs);
+
+    auto getSearchState(int state_id) -> SearchState*;
+    void reachState(Direction d, SearchState* s);
+    void clearStates();
+
+    void extractPath(std::vector<int>& solution, int& cost) const;
+};
+
+} // namespace smpl
+
+#endif
@@ -46,8 +46,8 @@
 
 namespace smpl {
 
-template <typename Derived>
-MHAStarBase<Derived>::MHAStarBase(
+template <typename Derived, typename EdgePolicy>
+MHAStarBase<Derived, EdgePolicy>::MHAStarBase(
     DiscreteSpaceInformation* environment,
     Heuristic* hanchor,
     Heuristic** heurs,
@@ -67,6 +67,7 @@ MHAStarBase<Derived>::MHAStarBase(
     m_start_state(nullptr),
     m_goal_state(nullptr),
     m_search_states(),
+    m_state_arena(),
     m_open(nullptr)
 {
     SMPL_INFO("Construct Focal MHA* Search with %d heuristics", hcount);
@@ -84,16 +85,16 @@ MHAStarBase<Derived>::MHAStarBase(
     m_params.repair_time = 0.0;
 }
 
-template <typename Derived>
-MHAStarBase<Derived>::~MHAStarBase()
+template <typename Derived, typename EdgePolicy>
+MHAStarBase<Derived, EdgePolicy>::~MHAStarBase()
 {
     clear();
 
     delete[] m_open;
 }
 
-template <typename Derived>
-int MHAStarBase<Derived>::set_start(int start_state_id)
+template <typename Derived, typename EdgePolicy>
+int MHAStarBase<Derived, EdgePolicy>::set_start(int start_state_id)
 {
     SMPL_INFO("Set start to %d", start_state_id);
     m_start_state = get_state(start_state_id);
@@ -104,8 +105,8 @@ int MHAStarBase<Derived>::set_start(int start_state_id)
     }
 }
 
-template <typename Derived>
-int MHAStarBase<Derived>::set_goal(int goal_state_id)
+template <typename Derived, typename EdgePolicy>
+int MHAStarBase<Derived, EdgePolicy>::set_goal(int goal_state_id)
 {
     SMPL_INFO("Set goal to %d", goal_state_id);
     m_goal_state = get_state(goal_state_id);
@@ -116,8 +117,8 @@ int MHAStarBase<Derived>::set_goal(int goal_state_id)
     }
 }
 
-template <typename Derived>
-int MHAStarBase<Derived>::replan(
+template <typename Derived, typename EdgePolicy>
+int MHAStarBase<Derived, EdgePolicy>::replan(
     double allocated_time_sec,
     std::vector<int>* solution)
 {
@@ -125,8 +126,8 @@ int MHAStarBase<Derived>::replan(
     return replan(allocated_time_sec, solution, &solcost);
 }
 
-template <typename Derived>
-int MHAStarBase<Derived>::replan(
+template <typename Derived, typename EdgePolicy>
+int MHAStarBase<Derived, EdgePolicy>::replan(
     double allocated_time_sec,
     std::vector<int>* solution,
     int* solcost)
@@ -136,8 +137,8 @@ int MHAStarBase<Derived>::replan(
     return replan(solution, params, solcost);
 }
 
-template <typename Derived>
-int MHAStarBase<Derived>::replan(
+template <typename Derived, typename EdgePolicy>
+int MHAStarBase<Derived, EdgePolicy>::replan(
     std::vector<int>* solution,
     ReplanParams params)
 {
@@ -145,8 +146,8 @@ int MHAStarBase<Derived>::replan(
     return replan(solution, params, &solcost);
 }
 
-template <typename Derived>
-int MHAStarBase<Derived>::replan(
+template <typename Derived, typename EdgePolicy>
+int MHAStarBase<Derived, EdgePolicy>::replan(
     std::vector<int>* solution,
     ReplanParams params,
     int* solcost)
@@ -159,6 +160,13 @@ int MHAStarBase<Derived>::replan(
 
     m_params = params;
 
+    if (m_trace != nullptr) {
+        m_trace->recordSearch(
+                m_start_state->state_id,
+                m_goal_state->state_id,
+                m_params.initial_eps);
+    }
+
     SMPL_INFO("Generic Search parameters:");
     SMPL_INFO("  Initial Epsilon: %0.3f", m_params.initial_eps);
     SMPL_INFO("  Final Epsilon: %0.3f", m_params.final_eps);
@@ -188,6 +196,7 @@ int MHAStarBase<Derived>::replan(
     reinit_state(m_goal_state);
     reinit_state(m_start_state);
     m_start_state->g = 0;
+    m_start_state->true_cost = true;
 
     SMPL_INFO("Insert start state into OPEN and PSET");
 
@@ -215,7 +224,7 @@ int MHAStarBase<Derived>::replan(
                 break;
             }
 
-            if (static_cast<Derived*>(this)->terminated()) {
+            if (solution_found()) {
                 m_eps_satisfied = m_eps;
                 extract_path(solution, solcost);
                 return 1;
@@ -223,6 +232,13 @@ int MHAStarBase<Derived>::replan(
 
             if (!m_open[hidx].empty()) {
                 MHASearchState* s = select_state(hidx);
+                if (s == nullptr) {
+                    continue;
+                }
+                if (EdgePolicy::Lazy && !s->true_cost) {
+                    evaluate(s);
+                    continue;
+                }
                 expand(s, hidx);
                 s->closed_in_add = true;
             } else {
@@ -231,17 +247,21 @@ int MHAStarBase<Derived>::replan(
         }
 
         if (!m_open[0].empty()) {
-            if (static_cast<Derived*>(this)->terminated()) {
+            if (solution_found()) {
                 m_eps_satisfied = m_eps;
                 extract_path(solution, solcost);
                 return 1;
             }
 
             MHASearchState* s = state_from_open_state(m_open[0].min());
-            expand(s, 0);
-            s->closed_in_anc = true;
+            if (EdgePolicy::Lazy && !s->true_cost) {
+                evaluate(s);
+            } else {
+                expand(s, 0);
+                s->closed_in_anc = true;
 
-            onClosedAnchor(s);
+                onClosedAnchor(s);
+            }
         }
 
         auto end_time = smpl::clock::now();
@@ -258,132 +278,159 @@ int MHAStarBase<Derived>::replan(
     return 0;
 }
 
-template <typename Derived>
-int MHAStarBase<Derived>::force_planning_from_scratch()
+template <typename Derived, typename EdgePolicy>
+int MHAStarBase<Derived, EdgePolicy>::force_planning_from_scratch()
 {
     return 0;
 }
 
-template <typename Derived>
-int MHAStarBase<Derived>::force_planning_from_scratch_and_free_memory()
+template <typename Derived, typename EdgePolicy>
+int MHAStarBase<Derived, EdgePolicy>::force_planning_from_scratch_and_free_memory()
 {
     return 0;
 }
 
-template <typename Derived>
-void MHAStarBase<Derived>::costs_changed(StateChangeQuery const & stateChange)
+template <typename Derived, typename EdgePolicy>
+void MHAStarBase<Derived, EdgePolicy>::costs_changed(StateChangeQuery const & stateChange)
 {
 }
 
-template <typename Derived>
-int MHAStarBase<Derived>::set_search_mode(bool bSearchUntilFirstSolution)
+template <typename Derived, typename EdgePolicy>
+int MHAStarBase<Derived, EdgePolicy>::set_search_mode(bool bSearchUntilFirstSolution)
 {
     return m_params.return_first_solution = bSearchUntilFirstSolution;
 }
 
-template <typename Derived>
-void MHAStarBase<Derived>::set_initialsolution_eps(double eps)
+template <typename Derived, typename EdgePolicy>
+void MHAStarBase<Derived, EdgePolicy>::set_initialsolution_eps(double eps)
 {
     m_params.initial_eps = eps;
 }
 
-template <typename Derived>
-double MHAStarBase<Derived>::get_initial_eps()
+template <typename Derived, typename EdgePolicy>
+double MHAStarBase<Derived, EdgePolicy>::get_initial_eps()
 {
     return m_params.initial_eps;
 }
 
-template <typename Derived>
-double MHAStarBase<Derived>::get_solution_eps() const
+template <typename Derived, typename EdgePolicy>
+double MHAStarBase<Derived, EdgePolicy>::get_solution_eps() const
 {
     return m_eps_satisfied;
 }
 
-template <typename Derived>
-double MHAStarBase<Derived>::get_final_epsilon()
+template <typename Derived, typename EdgePolicy>
+double MHAStarBase<Derived, EdgePolicy>::get_final_epsilon()
 {
     return m_eps_satisfied;
 }
 
-template <typename Derived>
-double MHAStarBase<Derived>::get_final_eps_planning_time()
+template <typename Derived, typename EdgePolicy>
+double MHAStarBase<Derived, EdgePolicy>::get_final_eps_planning_time()
 {
     return m_elapsed;
 }
 
-template <typename Derived>
-double MHAStarBase<Derived>::get_initial_eps_planning_time()
+template <typename Derived, typename EdgePolicy>
+double MHAStarBase<Derived, EdgePolicy>::get_initial_eps_planning_time()
 {
     return m_elapsed;
 }
 
-template <typename Derived>
-int MHAStarBase<Derived>::get_n_expands() const
+template <typename Derived, typename EdgePolicy>
+int MHAStarBase<Derived, EdgePolicy>::get_n_expands() const
 {
     return m_num_expansions;
 }
 
-template <typename Derived>
-int MHAStarBase<Derived>::get_n_expands_init_solution()
+template <typename Derived, typename EdgePolicy>
+int MHAStarBase<Derived, EdgePolicy>::get_n_expands_init_solution()
 {
     return m_num_expansions;
 }
 
-template <typename Derived>
-void MHAStarBase<Derived>::get_search_stats(std::vector<PlannerStats>* s)
+template <typename Derived, typename EdgePolicy>
+void MHAStarBase<Derived, EdgePolicy>::get_search_stats(std::vector<PlannerStats>* s)
+{
+}
+
+template <typename Derived, typename EdgePolicy>
+Extension* MHAStarBase<Derived, EdgePolicy>::getExtension(size_t class_code)
+{
+    if (class_code == GetClassCode<MemoryUsageExtension>() ||
+        class_code == GetClassCode<CancellationExtension>())
+    {
+        return this;
+    }
+    return nullptr;
+}
+
+/// Return the memory held by the search states and lists. Each OPEN list is
+/// counted by the number of states it holds.
+template <typename Derived, typename EdgePolicy>
+auto MHAStarBase<Derived, EdgePolicy>::memoryUsage() const -> std::size_t
 {
+    auto usage = m_state_arena.capacity();
+    usage += MemoryUsage(m_search_states);
+    usage += MemoryUsage(m_graph_to_search_state);
+    usage += MemoryUsage(m_lazy_preds);
+    for (int hidx = 0; hidx < num_heuristics(); ++hidx) {
+        usage += sizeof(rank_pq);
+        usage += m_open[hidx].size() * sizeof(MHASearchState::HeapData*);
+    }
+    return usage;
 }
 
-template <typename Derived>
-void MHAStarBase<Derived>::set_final_eps(double eps)
+template <typename Derived, typename EdgePolicy>
+void MHAStarBase<Derived, EdgePolicy>::set_final_eps(double eps)
 {
     m_params.final_eps = eps;
 }
 
-template <typename Derived>
-void MHAStarBase<Derived>::set_dec_eps(double eps)
+template <typename Derived, typename EdgePolicy>
+void MHAStarBase<Derived, EdgePolicy>::set_dec_eps(double eps)
 {
     m_params.dec_eps = eps;
 }
 
-template <typename Derived>
-void MHAStarBase<Derived>::set_max_expansions(int expansion_count)
+template <typename Derived, typename EdgePolicy>
+void MHAStarBase<Derived, EdgePolicy>::set_max_expansions(int expansion_count)
 {
     m_max_expansions = expansion_count;
 }
 
-template <typename Derived>
-void MHAStarBase<Derived>::set_max_time(double max_time)
+template <typename Derived, typename EdgePolicy>
+void MHAStarBase<Derived, EdgePolicy>::set_max_time(double max_time)
 {
     m_params.max_time = max_time;
 }
 
-template <typename Derived>
-double MHAStarBase<Derived>::get_final_eps() const
+template <typename Derived, typename EdgePolicy>
+double MHAStarBase<Derived, EdgePolicy>::get_final_eps() const
 {
     return m_params.final_eps;
 }
 
-template <typename Derived>
-double MHAStarBase<Derived>::get_dec_eps() const
+template <typename Derived, typename EdgePolicy>
+double MHAStarBase<Derived, EdgePolicy>::get_dec_eps() const
 {
     return m_params.dec_eps;
 }
 
-template <typename Derived>
-int MHAStarBase<Derived>::get_max_expansions() const
+template <typename Derived, typename EdgePolicy>
+int MHAStarBase<Derived, EdgePolicy>::get_max_expansions() const
 {
     return m_max_expansions;
 }
 
-template <typename Derived>
-double MHAStarBase<Derived>::get_max_time() const
+template <typename Derived, typename EdgePolicy>
+double MHAStarBase<Derived, EdgePolicy>::get_max_time() const
 {
     return m_params.max_time;
 }
 
-template <typename Derived>
-bool MHAStarBase<Derived>::check_params(const ReplanParams& params)
+template <typename Derived, typename EdgePolicy>
+bool MHAStarBase<Derived, EdgePolicy>::check_params(const ReplanParams& params)
 {
     if (params.initial_eps < 1.0) {
         SMPL_ERROR("Initial Epsilon must be greater than or equal to 1");
@@ -411,10 +458,12 @@ bool MHAStarBase<Derived>::check_params(const ReplanParams& params)
     return true;
 }
 
-template <typename Derived>
-bool MHAStarBase<Derived>::time_limit_reached() const
+template <typename Derived, typename EdgePolicy>
+bool MHAStarBase<Derived, EdgePolicy>::time_limit_reached() const
 {
-    if (m_params.return_first_solution) {
+    if (Expired(m_cancel)) {
+        return true;
+    } else if (m_params.return_first_solution) {
         return false;
     } else if (m_params.max_time > 0.0 && m_elapsed >= m_params.max_time) {
         return true;
@@ -425,8 +474,8 @@ bool MHAStarBase<Derived>::time_limit_reached() const
     }
 }
 
-template <typename Derived>
-MHASearchState* MHAStarBase<Derived>::get_state(int state_id)
+template <typename Derived, typename EdgePolicy>
+MHASearchState* MHAStarBase<Derived, EdgePolicy>::get_state(int state_id)
 {
     if (m_graph_to_search_state.size() < state_id + 1) {
         m_graph_to_search_state.resize(state_id + 1, -1);
@@ -437,7 +486,8 @@ MHASearchState* MHAStarBase<Derived>::get_state(int state_id)
         const size_t state_size =
                 sizeof(MHASearchState) +
                 sizeof(MHASearchState::HeapData) * (m_hcount);
-        MHASearchState* s = (MHASearchState*)malloc(state_size);
+        MHASearchState* s = (MHASearchState*)m_state_arena.allocate(
+                state_size, alignof(MHASearchState));
 
         // force construction to correctly initialize heap position to null
         new (s) MHASearchState;
@@ -459,29 +509,28 @@ MHASearchState* MHAStarBase<Derived>::get_state(int state_id)
     }
 }
 
-template <typename Derived>
-void MHAStarBase<Derived>::clear()
+template <typename Derived, typename EdgePolicy>
+void MHAStarBase<Derived, EdgePolicy>::clear()
 {
     clear_open_lists();
 
-    // free states
-    for (size_t i = 0; i < m_search_states.size(); ++i) {
-        // unmap graph to search state
-        MHASearchState* search_state = m_search_states[i];
+    // unmap graph to search states
+    std::fill(
+            m_graph_to_search_state.begin(),
+            m_graph_to_search_state.end(),
+            -1);
 
-        // free search state
-        free(m_search_states[i]);
-    }
-
-    // empty state table
+    // empty state table and free states
     m_search_states.clear();
+    m_state_arena.reset();
+    m_lazy_preds.clear();
 
     m_start_state = nullptr;
     m_goal_state = nullptr;
 }
 
-template <typename Derived>
-void MHAStarBase<Derived>::init_state(
+template <typename Derived, typename EdgePolicy>
+void MHAStarBase<Derived, EdgePolicy>::init_state(
     MHASearchState* state,
     int state_id)
 {
@@ -505,17 +554,22 @@ void MHAStarBase<Derived>::init_state(
 // Reinitialize the state for a new search. Maintains the state id. Resets the
 // cost-to-go to infinity. Removes the state from both closed lists. Recomputes
 // all heuristics for the state. Does NOT remove from the OPEN or PSET lists.
-template <typename Derived>
-void MHAStarBase<Derived>::reinit_state(MHASearchState* state)
+template <typename Derived, typename EdgePolicy>
+void MHAStarBase<Derived, EdgePolicy>::reinit_state(MHASearchState* state)
 {
     if (state->call_number != m_call_number) {
         state->call_number = m_call_number;
         state->g = INFINITECOST;
         state->bp = nullptr;
+        state->true_cost = false;
 
         state->closed_in_anc = false;
         state->closed_in_add = false;
 
+        if (EdgePolicy::Lazy) {
+            lazy_preds(state).clear();
+        }
+
         for (int i = 0; i < num_heuristics(); ++i) {
             state->od[i].h = compute_heuristic(state->state_id, i);
             state->od[i].f = INFINITECOST;
@@ -530,22 +584,22 @@ void MHAStarBase<Derived>::reinit_state(MHASearchState* state)
     }
 }
 
-template <typename Derived>
-void MHAStarBase<Derived>::reinit_search()
+template <typename Derived, typename EdgePolicy>
+void MHAStarBase<Derived, EdgePolicy>::reinit_search()
 {
     clear_open_lists();
 }
 
-template <typename Derived>
-void MHAStarBase<Derived>::clear_open_lists()
+template <typename Derived, typename EdgePolicy>
+void MHAStarBase<Derived, EdgePolicy>::clear_open_lists()
 {
     for (int i = 0; i < num_heuristics(); ++i) {
         m_open[i].clear();
     }
 }
 
-template <typename Derived>
-int MHAStarBase<Derived>::compute_key(MHASearchState* state, int hidx)
+template <typename Derived, typename EdgePolicy>
+int MHAStarBase<Derived, EdgePolicy>::compute_key(MHASearchState* state, int hidx)
 {
     if (hidx == 0) {
         return static_cast<Derived*>(this)->priority(state);
@@ -554,12 +608,24 @@ int MHAStarBase<Derived>::compute_key(MHASearchState* state, int hidx)
     }
 }
 
-template <typename Derived>
-void MHAStarBase<Derived>::expand(MHASearchState* state, int hidx)
+// A solution is found once the derived search's termination criterion holds
+// and, with lazy edge evaluation, the edge into the goal has been evaluated.
+template <typename Derived, typename EdgePolicy>
+bool MHAStarBase<Derived, EdgePolicy>::solution_found()
+{
+    if (EdgePolicy::Lazy && !m_goal_state->true_cost) {
+        return false;
+    }
+    return static_cast<Derived*>(this)->terminated();
+}
+
+template <typename Derived, typename EdgePolicy>
+void MHAStarBase<Derived, EdgePolicy>::expand(MHASearchState* state, int hidx)
 {
     SMPL_INFO("Expanding state %d in search %d", state->state_id, hidx);
 
     assert(!closed_in_add_search(state) || !closed_in_anc_search(state));
+    assert(state->true_cost);
 
     ++m_num_expansions;
 
@@ -572,62 +638,189 @@ void MHAStarBase<Derived>::expand(MHASearchState* state, int hidx)
 
     std::vector<int> succ_ids;
     std::vector<int> costs;
-    environment_->GetSuccs(state->state_id, &succ_ids, &costs);
+    std::vector<bool> true_costs;
+    auto then = smpl::clock::now();
+    if (EdgePolicy::Lazy) {
+        environment_->GetLazySuccs(
+                state->state_id, &succ_ids, &costs, &true_costs);
+        assert(succ_ids.size() == true_costs.size());
+    } else {
+        environment_->GetSuccs(state->state_id, &succ_ids, &costs);
+    }
+    if (m_trace != nullptr) {
+        auto graph_time = smpl::to_seconds(smpl::clock::now() - then);
+        m_trace->recordExpansion(
+                state->state_id, state->g, state->od[0].h,
+                graph_time, succ_ids, costs);
+    }
     assert(succ_ids.size() == costs.size());
 
     for (size_t sidx = 0; sidx < succ_ids.size(); ++sidx)  {
-        const int cost = costs[sidx];
         MHASearchState* succ_state = get_state(succ_ids[sidx]);
         reinit_state(succ_state);
 
+        if (EdgePolicy::Lazy) {
+            int cost = costs[sidx];
+            bool true_cost = true_costs[sidx];
+            if (!true_cost && closed_in_any_search(succ_state)) {
+                cost = environment_->GetTrueCost(
+                        state->state_id, succ_state->state_id);
+                if (cost < 0) {
+                    continue;
+                }
+                true_cost = true;
+            }
+            add_lazy_pred(succ_state, state, state->g + cost, true_cost);
+            continue;
+        }
+
         int new_g = state->g + costs[sidx];
         if (new_g < succ_state->g) {
             succ_state->g = new_g;
             succ_state->bp = state;
-            if (!closed_in_anc_search(succ_state)) {
-                succ_state->od[0].f = compute_key(succ_state, 0);
-                insert_or_update(succ_state, 0);
+            succ_state->true_cost = true;
+            insert_into_searches(succ_state);
+        }
+    }
+}
 
-                // unless it's been closed in an inadmissible search...
-                if (closed_in_add_search(succ_state)) {
-                    continue;
-                }
+// Evaluate the edge from the best candidate predecessor of a state and return
+// the state to the search with the cost of its best remaining candidate.
+template <typename Derived, typename EdgePolicy>
+void MHAStarBase<Derived, EdgePolicy>::evaluate(MHASearchState* state)
+{
+    assert(EdgePolicy::Lazy && !state->true_cost && state->bp != nullptr);
 
-                // insert into the P-SET for each heuristic
-                for (int hidx = 1; hidx < num_heuristics(); ++hidx) {
-                    succ_state->od[hidx].f = compute_key(succ_state, hidx);
-                    insert_or_update(succ_state, hidx);
-                }
-            }
+    SMPL_DEBUG("Evaluate edge %d -> %d", state->bp->state_id, state->state_id);
+
+    for (int hidx = 0; hidx < num_heuristics(); ++hidx) {
+        if (m_open[hidx].contains(&state->od[hidx])) {
+            m_open[hidx].erase(&state->od[hidx]);
+        }
+    }
+
+    auto& preds = lazy_preds(state);
+    auto better = [](const LazyPred& a, const LazyPred& b) { return a.g < b.g; };
+    auto best = std::min_element(begin(preds), end(preds), better);
+    assert(best != end(preds));
+
+    if (!best->true_cost) {
+        int cost = environment_->GetTrueCost(
+                best->pred->state_id, state->state_id);
+        if (cost < 0) {
+            preds.erase(best);
+        } else {
+            best->g = best->pred->g + cost;
+            best->true_cost = true;
         }
     }
+
+    best = std::min_element(begin(preds), end(preds), better);
+    if (best == end(preds)) {
+        state->g = INFINITECOST;
+        state->bp = nullptr;
+        state->true_cost = false;
+        return;
+    }
+
+    state->g = best->g;
+    state->bp = best->pred;
+    state->true_cost = best->true_cost;
+    insert_into_searches(state);
 }
 
-template <typename Derived>
-MHASearchState* MHAStarBase<Derived>::state_from_open_state(
+// Insert a state into OPEN and into the P-SET for each heuristic, or update its
+// position, unless it has been closed in the anchor search or, for the P-SETs,
+// in an inadmissible search.
+template <typename Derived, typename EdgePolicy>
+void MHAStarBase<Derived, EdgePolicy>::insert_into_searches(MHASearchState* state)
+{
+    if (closed_in_anc_search(state)) {
+        return;
+    }
+
+    state->od[0].f = compute_key(state, 0);
+    insert_or_update(state, 0);
+
+    // unless it's been closed in an inadmissible search...
+    if (closed_in_add_search(state)) {
+        return;
+    }
+
+    // insert into the P-SET for each heuristic
+    for (int hidx = 1; hidx < num_heuristics(); ++hidx) {
+        state->od[hidx].f = compute_key(state, hidx);
+        insert_or_update(state, hidx);
+    }
+}
+
+// Record a candidate predecessor of a state, unless an evaluated candidate
+// already reaches it as cheaply, and make it the state's back pointer if it is
+// the best candidate.
+template <typename Derived, typename EdgePolicy>
+void MHAStarBase<Derived, EdgePolicy>::add_lazy_pred(
+    MHASearchState* state,
+    MHASearchState* pred,
+    int g,
+    bool true_cost)
+{
+    auto& preds = lazy_preds(state);
+    for (auto& p : preds) {
+        if (p.pred != pred && p.true_cost && p.g <= g) {
+            return;
+        }
+    }
+    preds.push_back(LazyPred{ pred, g, true_cost });
+
+    if (g < state->g) {
+        state->g = g;
+        state->bp = pred;
+        state->true_cost = true_cost;
+        insert_into_searches(state);
+    }
+}
+
+template <typename Derived, typename EdgePolicy>
+auto MHAStarBase<Derived, EdgePolicy>::lazy_preds(MHASearchState* state)
+    -> std::vector<LazyPred>&
+{
+    size_t ssidx = m_graph_to_search_state[state->state_id];
+    if (m_lazy_preds.size() <= ssidx) {
+        m_lazy_preds.resize(ssidx + 1);
+    }
+    return m_lazy_preds[ssidx];
+}
+
+template <typename Derived, typename EdgePolicy>
+MHASearchState* MHAStarBase<Derived, EdgePolicy>::state_from_open_state(
     MHASearchState::HeapData* open_state)
 {
     return open_state->me;
 }
 
-template <typename Derived>
-int MHAStarBase<Derived>::compute_heuristic(int state_id, int hidx)
+template <typename Derived, typename EdgePolicy>
+int MHAStarBase<Derived, EdgePolicy>::compute_heuristic(int state_id, int hidx)
 {
+    int h;
     if (hidx == 0) {
-        return m_hanchor->GetGoalHeuristic(state_id);
+        h = m_hanchor->GetGoalHeuristic(state_id);
     } else {
-        return m_heurs[hidx - 1]->GetGoalHeuristic(state_id);
+        h = m_heurs[hidx - 1]->GetGoalHeuristic(state_id);
+    }
+    if (m_trace != nullptr) {
+        m_trace->recordHeuristic(state_id, hidx, h);
     }
+    return h;
 }
 
-template <typename Derived>
-int MHAStarBase<Derived>::get_minf(rank_pq& pq) const
+template <typename Derived, typename EdgePolicy>
+int MHAStarBase<Derived, EdgePolicy>::get_minf(rank_pq& pq) const
 {
-    return pq.min()->f;
+    return pq.min_key();
 }
 
-template <typename Derived>
-void MHAStarBase<Derived>::insert_or_update(MHASearchState* state, int hidx)
+template <typename Derived, typename EdgePolicy>
+void MHAStarBase<Derived, EdgePolicy>::insert_or_update(MHASearchState* state, int hidx)
 {
     if (m_open[hidx].contains(&state->od[hidx])) {
         m_open[hidx].update(&state->od[hidx]);
@@ -636,8 +829,8 @@ void MHAStarBase<Derived>::insert_or_update(MHASearchState* state, int hidx)
     }
 }
 
-template <typename Derived>
-MHASearchState* MHAStarBase<Derived>::select_state(int hidx)
+template <typename Derived, typename EdgePolicy>
+MHASearchState* MHAStarBase<Derived, EdgePolicy>::select_state(int hidx)
 {
     MHASearchState* state = state_from_open_state(m_open[hidx].min());
     MHASearchState::HeapData* min_open = m_open[0].min();
@@ -656,8 +849,8 @@ MHASearchState* MHAStarBase<Derived>::select_state(int hidx)
     return nullptr;
 }
 
-template <typename Derived>
-void MHAStarBase<Derived>::extract_path(std::vector<int>* solution_path, int* solcost)
+template <typename Derived, typename EdgePolicy>
+void MHAStarBase<Derived, EdgePolicy>::extract_path(std::vector<int>* solution_path, int* solcost)
 {
     SMPL_INFO("Extracting path");
     solution_path->clear();
@@ -674,20 +867,20 @@ void MHAStarBase<Derived>::extract_path(std::vector<int>* solution_path, int* so
     std::reverse(begin(*solution_path), end(*solution_path));
 }
 
-template <typename Derived>
-bool MHAStarBase<Derived>::closed_in_anc_search(MHASearchState* state) const
+template <typename Derived, typename EdgePolicy>
+bool MHAStarBase<Derived, EdgePolicy>::closed_in_anc_search(MHASearchState* state) const
 {
     return state->closed_in_anc;
 }
 
-template <typename Derived>
-bool MHAStarBase<Derived>::closed_in_add_search(MHASearchState* state) const
+template <typename Derived, typename EdgePolicy>
+bool MHAStarBase<Derived, EdgePolicy>::closed_in_add_search(MHASearchState* state) const
 {
     return state->closed_in_add;
 }
 
-template <typename Derived>
-bool MHAStarBase<Derived>::closed_in_any_search(MHASearchState* state) const
+template <typename Derived, typename EdgePolicy>
+bool MHAStarBase<Derived, EdgePolicy>::closed_in_any_search(MHASearchState* state) const
 {
     return state->closed_in_anc || state->closed_in_add;
 }
@@ -34,11 +34,13 @@
 
 // standard includes
 #include <stdint.h>
+#include <deque>
 
 // system includes
 #include <sbpl/planners/planner.h>
 
 // project includes
+#include <smpl/cancellation.h>
 #include <smpl/graph/experience_graph_extension.h>
 #include <smpl/graph/robot_planning_space.h>
 #include <smpl/heap/intrusive_heap.h>
@@ -47,7 +49,7 @@
 
 namespace smpl {
 
-class ExperienceGraphPlanner : public SBPLPlanner
+class ExperienceGraphPlanner : public SBPLPlanner, public CancellationExtension
 {
 public:
 
@@ -83,6 +85,45 @@ public:
     void costs_changed(const StateChangeQuery& state_change) override;
     ///@}
 
+    /// \name Adaptive Experience Graph Use
+    ///@{
+
+    /// Adapt the experience graph weight of the heuristic, and how often snap
+    /// and shortcut successors are generated, from the outcome of recent
+    /// requests. Once every adaptation window, the weight is raised if any
+    /// request failed or requests used much of their allotted time, and
+    /// lowered, to improve solution quality, if requests finished quickly.
+    /// Snap and shortcut successors are generated less often while few of
+    /// them turn out valid. Adjustments take effect from the next request.
+    void setAdaptive(bool adaptive);
+    bool adaptive() const { return m_adaptive; }
+
+    /// Set the range within which the experience graph weight is adapted.
+    void setWeightEGraphBounds(double min_weight, double max_weight);
+    double minWeightEGraph() const { return m_min_eg_weight; }
+    double maxWeightEGraph() const { return m_max_eg_weight; }
+
+    /// Set the number of requests between adaptations.
+    void setAdaptationWindow(int requests);
+    int adaptationWindow() const { return m_adapt_window; }
+
+    /// Generate snap and shortcut successors for every period-th expansion.
+    void setEGraphSuccessorPeriod(int period);
+    int egraphSuccessorPeriod() const { return m_egraph_succ_period; }
+    ///@}
+
+    /// \name Required Public Functions from Extension
+    ///@{
+    Extension* getExtension(size_t class_code) override;
+    ///@}
+
+    /// \name Required Public Functions from CancellationExtension
+    ///@{
+    void setCancellationToken(const CancellationToken* token) override {
+        m_cancel = token;
+    }
+    ///@}
+
 private:
 
     struct SearchState : public heap_element
@@ -103,6 +144,14 @@ private:
         }
     };
 
+    struct RequestStats
+    {
+        bool solved;
+        double time_fraction;
+        int egraph_attempts;
+        int egraph_successes;
+    };
+
     RobotPlanningSpace* m_space;
     ExperienceGraphExtension* m_ege;
 
@@ -121,12 +170,29 @@ private:
     double m_eps;
 
     int m_expand_count;
+    double m_search_time = 0.0;
+    int m_solution_cost = 0;
+
+    // snap and shortcut edges evaluated, and found valid, in this request
+    int m_egraph_attempts = 0;
+    int m_egraph_successes = 0;
+    int m_egraph_succ_period = 1;
+
+    bool m_adaptive = false;
+    double m_min_eg_weight = 1.0;
+    double m_max_eg_weight = 10.0;
+    int m_adapt_window = 5;
+    std::deque<RequestStats> m_recent;
+
+    const CancellationToken* m_cancel = nullptr;
 
     SearchState* getSearchState(int state_id);
     SearchState* createState(int state_id);
     void reinitSearchState(SearchState* state);
 
     void extractPath(std::vector<int>& solution, int& cost) const;
+
+    void adapt();
 };
 
 } // namespace smpl
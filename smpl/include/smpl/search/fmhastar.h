@@ -37,17 +37,20 @@
 
 namespace smpl {
 
-class FMHAstar : public MHAStarBase<FMHAstar>
+/// The edge evaluation policy, EagerEdgeEvaluation (FMHAstar) or
+/// LazyEdgeEvaluation (LazyFMHAstar), is passed on to MHAStarBase.
+template <typename EdgePolicy>
+class BasicFMHAstar : public MHAStarBase<BasicFMHAstar<EdgePolicy>, EdgePolicy>
 {
 public:
 
-    FMHAstar(
+    BasicFMHAstar(
         DiscreteSpaceInformation* environment,
         Heuristic* hanchor,
         Heuristic** heurs,
         int hcount);
 
-    friend class MHAStarBase<FMHAstar>;
+    friend class MHAStarBase<BasicFMHAstar<EdgePolicy>, EdgePolicy>;
 
 private:
 
@@ -56,6 +59,12 @@ private:
     bool satisfies_p_criterion(MHASearchState* state) const;
 };
 
+using FMHAstar = BasicFMHAstar<EagerEdgeEvaluation>;
+using LazyFMHAstar = BasicFMHAstar<LazyEdgeEvaluation>;
+
+extern template class BasicFMHAstar<EagerEdgeEvaluation>;
+extern template class BasicFMHAstar<LazyEdgeEvaluation>;
+
 } // namespace smpl
 
 #endif
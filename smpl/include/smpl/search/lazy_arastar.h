@@ -32,7 +32,7 @@
 #include <stdlib.h>
 #include <vector>
 
-#include <smpl/heap/intrusive_heap.h>
+#include <smpl/heap/dary_heap.h>
 #include <smpl/heuristic/robot_heuristic.h>
 
 #include <smpl/search/lazy_search_interface.h>
@@ -57,9 +57,9 @@ struct LazyARAStar
 {
     struct State;
 
-    struct StateCompare {
+    struct StateKey {
         const LazyARAStar* search_;
-        bool operator()(const State& s1, const State& s2) const;
+        int operator()(const State& s) const;
     };
 
     struct CandidatePred {
@@ -73,6 +73,9 @@ struct LazyARAStar
 
         lazy_list_type  cands;
 
+        // successors with unevaluated transitions from this state
+        std::vector<State*> lazy_succs;
+
         const State*    bp;             // current best predecessor
         const State*    ebp;            // best predecessor upon expansion
 
@@ -95,17 +98,26 @@ struct LazyARAStar
     State*                  start_state_ = nullptr;
     State*                  goal_state_ = nullptr;
 
-    using open_list_type = intrusive_heap<State, StateCompare>;
+    using open_list_type = dary_heap<State, StateKey>;
     open_list_type          open_;
 
     int32_t                 call_number_    = 0;
     double                  eps_            = 1.0;
 
+    // maximum number of transitions from one state evaluated together. When
+    // a transition is evaluated, the pending transitions from the same state
+    // to the most promising other successors on OPEN are evaluated with it.
+    int                     batch_size_     = 1;
+
     std::vector<int> succs_;
     std::vector<int> costs_;
     std::vector<bool> true_costs_;
 
-    LazyARAStar() : open_(StateCompare{this}) { }
+    std::vector<State*> batch_;
+    std::vector<int> batch_ids_;
+    std::vector<int> batch_costs_;
+
+    LazyARAStar() : open_(StateKey{this}) { }
 };
 
 } // namespace smpl
@@ -61,6 +61,22 @@ struct ILazySuccFun {
         std::vector<bool>& true_costs) = 0;
 
     virtual int GetSuccTrueCost(int state_id, int succ_id) = 0;
+
+    /// Compute the true costs of the transitions from a state to several of
+    /// its successors, storing -1 for invalid transitions. The default
+    /// implementation calls GetSuccTrueCost for each successor.
+    /// Implementations may override this to validate the transitions together
+    /// and share the work that depends only on the parent state.
+    virtual void GetSuccTrueCosts(
+        int state_id,
+        const int* succ_ids,
+        int count,
+        int* costs)
+    {
+        for (int i = 0; i < count; ++i) {
+            costs[i] = GetSuccTrueCost(state_id, succ_ids[i]);
+        }
+    }
 };
 
 struct ILazyPredFun {
@@ -0,0 +1,202 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_LPASTAR_H
+#define SMPL_LPASTAR_H
+
+// standard includes
+#include <utility>
+#include <vector>
+
+// system includes
+#include <sbpl/heuristics/heuristic.h>
+#include <sbpl/planners/planner.h>
+
+// project includes
+#include <smpl/cancellation.h>
+#include <smpl/heap/dary_heap.h>
+#include <smpl/time.h>
+
+namespace smpl {
+
+/// An implementation of LPA* (Lifelong Planning A*), an incremental search
+/// that repairs its search tree in response to changes in edge costs, rather
+/// than searching again from scratch.
+///
+/// Successors are generated lazily, as in A*, and the edges discovered by each
+/// expansion are kept with the search tree, so that the graph need not provide
+/// predecessors. When the edge costs of the graph change, e.g. because an
+/// obstacle has moved, the caller reports the states whose outgoing edges may
+/// have changed, via costs_changed() or updateEdges(). Their successors are
+/// generated again and the states whose cost-to-come is affected are returned
+/// to OPEN. The next call to replan() then expands only the part of the search
+/// tree affected by the changes.
+///
+/// The search tree is kept between calls to replan() as long as the start
+/// state, goal state, and epsilon stay the same. Changing any of these, or
+/// calling force_planning_from_scratch(), discards the tree. The assumptions
+/// that BasicARAStar makes about state IDs and heuristics apply here as well.
+///
+/// With epsilon equal to 1 and a consistent heuristic, the returned path is
+/// optimal. Larger values of epsilon inflate the
+/// heuristic and usually reduce the number of expansions, but the solution is
+/// then no longer guaranteed to be within epsilon of optimal.
+class LPAStar : public SBPLPlanner, public CancellationExtension
+{
+public:
+
+    LPAStar(DiscreteSpaceInformation* space, Heuristic* heuristic);
+    ~LPAStar();
+
+    /// Generate the successors of a set of states again and repair the search
+    /// tree around the edges whose costs changed. States that have not been
+    /// expanded by the search are ignored.
+    void updateEdges(const std::vector<int>& state_ids);
+
+    /// \name Required Functions from SBPLPlanner
+    ///@{
+    int replan(double allowed_time_secs, std::vector<int>* solution) override;
+    int replan(double allowed_time_secs, std::vector<int>* solution, int* solcost) override;
+    int set_goal(int state_id) override;
+    int set_start(int state_id) override;
+    int force_planning_from_scratch() override;
+    int set_search_mode(bool bSearchUntilFirstSolution) override;
+
+    /// Update the edges leaving the predecessors of the changed states, as
+    /// with updateEdges().
+    void costs_changed(const StateChangeQuery& stateChange) override;
+    ///@}
+
+    /// \name Reimplemented Functions from SBPLPlanner
+    ///@{
+    int replan(std::vector<int>* solution, ReplanParams params) override;
+    int replan(std::vector<int>* solution, ReplanParams params, int* solcost) override;
+    int force_planning_from_scratch_and_free_memory() override;
+    double get_solution_eps() const override;
+    int get_n_expands() const override;
+    double get_initial_eps() override;
+    double get_initial_eps_planning_time() override;
+    double get_final_eps_planning_time() override;
+    int get_n_expands_init_solution() override;
+    double get_final_epsilon() override;
+    void get_search_stats(std::vector<PlannerStats>* s) override;
+    void set_initialsolution_eps(double eps) override;
+    ///@}
+
+    /// \name Required Functions from Extension
+    ///@{
+    Extension* getExtension(size_t class_code) override;
+    ///@}
+
+    /// \name Required Functions from CancellationExtension
+    ///@{
+    void setCancellationToken(const CancellationToken* token) override {
+        m_cancel = token;
+    }
+    ///@}
+
+private:
+
+    struct SearchState;
+
+    struct Edge
+    {
+        SearchState* state;
+        unsigned int cost;
+    };
+
+    struct SearchState : public heap_element
+    {
+        int state_id;
+        unsigned int g;     // cost-to-come
+        unsigned int rhs;   // one-step lookahead cost-to-come
+        unsigned int h;     // estimated cost-to-go
+        std::pair<unsigned int, unsigned int> key; // key at insertion into OPEN
+        SearchState* bp;
+        bool expanded;      // whether succs have been generated
+        std::vector<Edge> succs;
+        std::vector<Edge> preds; // edges into this state discovered so far
+    };
+
+    struct SearchStateKey
+    {
+        auto operator()(const SearchState& s) const
+            -> std::pair<unsigned int, unsigned int>
+        {
+            return s.key;
+        }
+    };
+
+    using OpenList = dary_heap<SearchState, SearchStateKey>;
+
+    DiscreteSpaceInformation* m_space;
+    Heuristic* m_heur;
+
+    double m_eps = 1.0;
+    bool m_bounded = true;
+
+    const CancellationToken* m_cancel = nullptr;
+
+    int m_start_state_id = -1;
+    int m_goal_state_id = -1;
+
+    // search tree, kept between calls to replan() while the start, goal, and
+    // epsilon are unchanged
+    std::vector<SearchState*> m_states;
+    OpenList m_open;
+    SearchState* m_start_state = nullptr;
+    SearchState* m_goal_state = nullptr;
+    double m_tree_eps = 1.0;
+
+    std::vector<int> m_succs;
+    std::vector<int> m_costs;
+
+    int m_expand_count = 0;
+    clock::duration m_search_time = clock::duration::zero();
+    bool m_found = false;
+
+    bool computeShortestPath(const clock::time_point& deadline);
+    bool isPathConsistent() const;
+
+    void generateSuccessors(SearchState* s);
+    void updateRhs(SearchState* s);
+    void updateOpen(SearchState* s);
+    auto computeKey(const SearchState* s) const
+        -> std::pair<unsigned int, unsigned int>;
+
+    auto getSearchState(int state_id) -> SearchState*;
+    void clearTree();
+
+    bool extractPath(std::vector<int>& solution, int& cost) const;
+};
+
+} // namespace smpl
+
+#endif
@@ -34,20 +34,38 @@
 
 // standard includes
 #include <iomanip>
+#include <memory>
+#include <mutex>
 #include <ostream>
 #include <random>
+#include <vector>
 
 // system includes
 #include <sbpl/heuristics/heuristic.h>
 #include <sbpl/planners/planner.h>
 
 // project includes
+#include <smpl/arena.h>
 #include <smpl/heap/intrusive_heap.h>
 #include <smpl/search/mhastar_base.h> // for MHASearchState declaration
 #include <smpl/time.h>
+#include <smpl/worker_pool.h>
 
 namespace smpl {
 
+/// MHA* that chooses which inadmissible search to expand from with dynamic
+/// Thompson sampling (DTS): each search is rewarded when an expansion lowers the
+/// best heuristic value in its queue, and the next search is the one whose
+/// sample from its Beta posterior is largest.
+///
+/// With a batch size k greater than one, each round draws one sample per
+/// search, selects a state from each of the k searches with the largest
+/// samples, along with any anchor expansions that are due, and generates the
+/// successors of all selected states concurrently. The successors are then
+/// processed, and the rewards fed back into the posteriors, one search at a
+/// time. By default, calls to GetSuccs() are serialized; graphs that support
+/// concurrent calls to GetSuccs() for distinct states may enable concurrent
+/// successor generation with set_concurrent_successors().
 class MetaMHAstarDTS : public SBPLPlanner
 {
 public:
@@ -123,6 +141,13 @@ public:
 
     ///@}
 
+    /// Set the number of searches sampled, and states expanded, per round.
+    void    set_batch_size(int count);
+    void    set_concurrent_successors(bool allow);
+
+    int     get_batch_size() const;
+    bool    get_concurrent_successors() const;
+
 private:
 
     // Related objects
@@ -147,6 +172,7 @@ private:
     MHASearchState* m_goal_state;
 
     std::vector<MHASearchState*> m_search_states;
+    Arena m_state_arena; // backing storage for the search states
     std::vector<int> m_graph_to_search_state;
 
     std::minstd_rand m_rng;
@@ -174,6 +200,20 @@ private:
     // and satisfy the P-CRITERION
     rank_pq* m_open;
 
+    struct BatchExpansion
+    {
+        MHASearchState* state;
+        int hidx;
+        std::vector<int> succ_ids;
+        std::vector<int> costs;
+    };
+
+    int m_batch_size;
+    bool m_concurrent_succs;
+    std::unique_ptr<WorkerPool> m_pool;
+    std::mutex m_space_lock;
+    std::vector<BatchExpansion> m_batch;
+
     bool check_params(const ReplanParams& params);
 
     bool time_limit_reached() const;
@@ -187,8 +227,15 @@ private:
     void clear();
     int compute_key(MHASearchState* state, int hidx);
     int choose_search();
+    void choose_searches(int count, std::vector<int>& hidxs);
     void update_meta_method(int hidx);
     void expand(MHASearchState* state, int hidx);
+    void close_state(MHASearchState* state);
+    void update_successors(
+        MHASearchState* state,
+        const std::vector<int>& succ_ids,
+        const std::vector<int>& costs);
+    int batched_search(std::vector<int>* solution, int* solcost);
     MHASearchState* state_from_open_state(MHASearchState::HeapData* open_state);
     int compute_heuristic(int state_id, int hidx);
     int get_minf(rank_pq& pq) const;
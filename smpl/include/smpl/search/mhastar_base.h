@@ -43,7 +43,11 @@
 #include <sbpl/heuristics/heuristic.h>
 
 // project includes
-#include <smpl/heap/intrusive_heap.h>
+#include <smpl/arena.h>
+#include <smpl/cancellation.h>
+#include <smpl/heap/dary_heap.h>
+#include <smpl/memory_usage.h>
+#include <smpl/search/search_trace.h>
 
 namespace smpl {
 
@@ -53,6 +57,7 @@ struct MHASearchState
     int state_id;
     int g;
     MHASearchState* bp;
+    bool true_cost;     // whether the cost of the edge from bp is evaluated
     bool closed_in_anc;
     bool closed_in_add;
 
@@ -78,8 +83,31 @@ std::ostream &operator<<(std::ostream &o, const MHASearchState &s)
     return o;
 }
 
-template <typename Derived>
-class MHAStarBase : public SBPLPlanner
+/// Edge evaluation policy for MHAStarBase that generates successors with
+/// GetSuccs(), evaluating every outgoing edge of a state when it is expanded.
+struct EagerEdgeEvaluation
+{
+    static constexpr bool Lazy = false;
+};
+
+/// Edge evaluation policy for MHAStarBase that generates successors with
+/// GetLazySuccs() and defers calling GetTrueCost() for an edge until its
+/// target is selected for expansion. A state reached through an unevaluated
+/// edge is evaluated instead of expanded when selected: its edge is evaluated,
+/// it falls back to its next best predecessor if the edge is invalid, and it
+/// is returned to the search. Edges into states that have already been
+/// expanded are evaluated immediately, so that back pointers through
+/// unevaluated edges only ever lead to unexpanded states.
+struct LazyEdgeEvaluation
+{
+    static constexpr bool Lazy = true;
+};
+
+template <typename Derived, typename EdgePolicy = EagerEdgeEvaluation>
+class MHAStarBase :
+    public SBPLPlanner,
+    public MemoryUsageExtension,
+    public CancellationExtension
 {
 public:
 
@@ -137,6 +165,23 @@ public:
     void    get_search_stats(std::vector<PlannerStats>* s) override;
     ///@}
 
+    /// \name Required Functions from Extension
+    ///@{
+    Extension* getExtension(size_t class_code) override;
+    ///@}
+
+    /// \name Required Functions from MemoryUsageExtension
+    ///@{
+    auto memoryUsage() const -> std::size_t override;
+    ///@}
+
+    /// \name Required Functions from CancellationExtension
+    ///@{
+    void setCancellationToken(const CancellationToken* token) override {
+        m_cancel = token;
+    }
+    ///@}
+
     /// \name Homogeneous accessor methods for search mode and timing parameters
     // @{
 
@@ -152,6 +197,10 @@ public:
     int     get_max_expansions() const;
     double  get_max_time() const;
 
+    /// Record the searches, heuristic evaluations, and expansions made by
+    /// subsequent calls to replan(), or stop recording if recorder is null.
+    void    set_trace_recorder(SearchTraceRecorder* recorder) { m_trace = recorder; }
+
     ///@}
 
     friend Derived;
@@ -176,23 +225,24 @@ private:
 
     int m_call_number;
 
+    SearchTraceRecorder* m_trace = nullptr;
+
+    // stops the search, as if it reached its time limit, once expired
+    const CancellationToken* m_cancel = nullptr;
+
     MHASearchState* m_start_state;
     MHASearchState* m_goal_state;
 
     std::vector<MHASearchState*> m_search_states;
+    Arena m_state_arena; // backing storage for the search states
     std::vector<int> m_graph_to_search_state;
 
-    struct HeapCompare
+    struct HeapKey
     {
-        bool operator()(
-            const MHASearchState::HeapData& s,
-            const MHASearchState::HeapData& t) const
-        {
-            return s.f < t.f;
-        }
+        int operator()(const MHASearchState::HeapData& s) const { return s.f; }
     };
 
-    typedef intrusive_heap<MHASearchState::HeapData, HeapCompare> rank_pq;
+    typedef dary_heap<MHASearchState::HeapData, HeapKey> rank_pq;
 
     // m_open[0] contain the actual OPEN list sorted by g(s) + h(s)
     // m_open[i], i > 0, maintains a copy of the PSET for each additional
@@ -201,6 +251,17 @@ private:
     // and satisfy the P-CRITERION
     rank_pq* m_open;
 
+    // candidate predecessors of each search state, by index into
+    // m_search_states, with LazyEdgeEvaluation
+    struct LazyPred
+    {
+        MHASearchState* pred;
+        int g;
+        bool true_cost;
+    };
+
+    std::vector<std::vector<LazyPred>> m_lazy_preds;
+
     bool check_params(const ReplanParams& params);
 
     bool time_limit_reached() const;
@@ -213,7 +274,16 @@ private:
     void clear_open_lists();
     void clear();
     int compute_key(MHASearchState* state, int hidx);
+    bool solution_found();
     void expand(MHASearchState* state, int hidx);
+    void evaluate(MHASearchState* state);
+    void insert_into_searches(MHASearchState* state);
+    void add_lazy_pred(
+        MHASearchState* state,
+        MHASearchState* pred,
+        int g,
+        bool true_cost);
+    auto lazy_preds(MHASearchState* state) -> std::vector<LazyPred>&;
     MHASearchState* state_from_open_state(MHASearchState::HeapData* open_state);
     int compute_heuristic(int state_id, int hidx);
     int get_minf(rank_pq& pq) const;
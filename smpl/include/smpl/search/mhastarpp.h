@@ -36,17 +36,20 @@
 
 namespace smpl {
 
-class MHAStarPP : public MHAStarBase<MHAStarPP>
+/// The edge evaluation policy, EagerEdgeEvaluation (MHAStarPP) or
+/// LazyEdgeEvaluation (LazyMHAStarPP), is passed on to MHAStarBase.
+template <typename EdgePolicy>
+class BasicMHAStarPP : public MHAStarBase<BasicMHAStarPP<EdgePolicy>, EdgePolicy>
 {
 public:
 
-    MHAStarPP(
+    BasicMHAStarPP(
         DiscreteSpaceInformation* environment,
         Heuristic* hanchor,
         Heuristic** heurs,
         int hcount);
 
-    friend class MHAStarBase<MHAStarPP>;
+    friend class MHAStarBase<BasicMHAStarPP<EdgePolicy>, EdgePolicy>;
 
 private:
 
@@ -61,6 +64,12 @@ private:
     bool satisfies_p_criterion(MHASearchState* state) const;
 };
 
+using MHAStarPP = BasicMHAStarPP<EagerEdgeEvaluation>;
+using LazyMHAStarPP = BasicMHAStarPP<LazyEdgeEvaluation>;
+
+extern template class BasicMHAStarPP<EagerEdgeEvaluation>;
+extern template class BasicMHAStarPP<LazyEdgeEvaluation>;
+
 } // namespace smpl
 
 #endif
@@ -0,0 +1,237 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_PASE_H
+#define SMPL_PASE_H
+
+// standard includes
+#include <algorithm>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <set>
+#include <vector>
+
+// system includes
+#include <sbpl/heuristics/heuristic.h>
+#include <sbpl/planners/planner.h>
+
+// project includes
+#include <smpl/cancellation.h>
+#include <smpl/time.h>
+
+namespace smpl {
+
+/// An implementation of PA*SE (Parallel A* for Slow Expansions), a weighted A*
+/// search that expands multiple states from OPEN concurrently while keeping a
+/// single shared search tree.
+///
+/// A state s in OPEN may be expanded in parallel with other states only if no
+/// state ahead of it in OPEN, nor any state currently being expanded, could
+/// lower its cost-to-come. With a consistent pairwise heuristic h(s', s) this
+/// holds whenever
+///
+///     g(s) - g(s') <= eps_indep * h(s', s)
+///
+/// for every such state s'. States that are independent by this test are
+/// handed out to worker threads in f-value order. The cost of the returned
+/// solution is bounded by eps * eps_indep times the optimal cost, where eps is
+/// the heuristic inflation factor.
+///
+/// The search bookkeeping is protected by a single lock and only successor
+/// generation runs outside of it, so the planner helps most when expansions
+/// are expensive. By default, calls to GetSuccs() are serialized; graphs that
+/// support concurrent calls to GetSuccs() for distinct states may enable
+/// concurrent successor generation with allowConcurrentSuccessors().
+///
+/// Each call to replan() runs weighted A* from scratch with the initial
+/// epsilon and, if time remains, repeats the search with decreasing epsilon
+/// until the final epsilon is reached.
+class PASE : public SBPLPlanner, public CancellationExtension
+{
+public:
+
+    PASE(DiscreteSpaceInformation* space, Heuristic* heuristic);
+    ~PASE();
+
+    void setThreadCount(int count) { m_thread_count = std::max(count, 1); }
+    int threadCount() const { return m_thread_count; }
+
+    void allowConcurrentSuccessors(bool allow) { m_concurrent_succs = allow; }
+    bool allowConcurrentSuccessors() const { return m_concurrent_succs; }
+
+    void setIndependenceEpsilon(double eps) { m_indep_eps = std::max(eps, 1.0); }
+    double independenceEpsilon() const { return m_indep_eps; }
+
+    void setTargetEpsilon(double eps) { m_final_eps = std::max(eps, 1.0); }
+    double targetEpsilon() const { return m_final_eps; }
+
+    void setDeltaEpsilon(double eps) { m_delta_eps = eps; }
+    double deltaEpsilon() const { return m_delta_eps; }
+
+    void setImproveSolution(bool improve) { m_improve = improve; }
+    bool improveSolution() const { return m_improve; }
+
+    /// \name Required Functions from SBPLPlanner
+    ///@{
+    int replan(double allowed_time_secs, std::vector<int>* solution) override;
+    int replan(double allowed_time_secs, std::vector<int>* solution, int* solcost) override;
+    int set_goal(int state_id) override;
+    int set_start(int state_id) override;
+    int force_planning_from_scratch() override;
+    int set_search_mode(bool bSearchUntilFirstSolution) override;
+    void costs_changed(const StateChangeQuery& stateChange) override;
+    ///@}
+
+    /// \name Reimplemented Functions from SBPLPlanner
+    ///@{
+    int replan(std::vector<int>* solution, ReplanParams params) override;
+    int replan(std::vector<int>* solution, ReplanParams params, int* solcost) override;
+    int force_planning_from_scratch_and_free_memory() override;
+    double get_solution_eps() const override;
+    int get_n_expands() const override;
+    double get_initial_eps() override;
+    double get_initial_eps_planning_time() override;
+    double get_final_eps_planning_time() override;
+    int get_n_expands_init_solution() override;
+    double get_final_epsilon() override;
+    void get_search_stats(std::vector<PlannerStats>* s) override;
+    void set_initialsolution_eps(double eps) override;
+    ///@}
+
+    /// \name Required Functions from Extension
+    ///@{
+    Extension* getExtension(size_t class_code) override;
+    ///@}
+
+    /// \name Required Functions from CancellationExtension
+    ///@{
+    void setCancellationToken(const CancellationToken* token) override {
+        m_cancel = token;
+    }
+    ///@}
+
+private:
+
+    struct SearchState
+    {
+        int state_id;
+        unsigned int g;     // cost-to-come
+        unsigned int h;     // estimated cost-to-go
+        unsigned int f;     // (g + eps * h) at time of insertion into OPEN
+        unsigned int eg;    // g-value at time of expansion
+        unsigned short call_number;
+        bool open;
+        bool closed;
+        SearchState* bp;
+    };
+
+    // order states by f-value, breaking ties by state id so that the open
+    // list is a strict ordering over states
+    struct SearchStateCompare
+    {
+        bool operator()(const SearchState* s1, const SearchState* s2) const {
+            if (s1->f != s2->f) {
+                return s1->f < s2->f;
+            }
+            return s1->state_id < s2->state_id;
+        }
+    };
+
+    using OpenList = std::set<SearchState*, SearchStateCompare>;
+
+    DiscreteSpaceInformation* m_space;
+    Heuristic* m_heur;
+
+    int m_thread_count = 1;
+    bool m_concurrent_succs = false;
+
+    double m_initial_eps = 1.0;
+    double m_final_eps = 1.0;
+    double m_delta_eps = 1.0;
+    double m_indep_eps = 1.0;
+    bool m_improve = true;
+    bool m_bounded = true;
+
+    const CancellationToken* m_cancel = nullptr;
+
+    int m_start_state_id = -1;
+    int m_goal_state_id = -1;
+
+    std::vector<SearchState*> m_states;
+
+    std::mutex m_lock;
+    std::condition_variable m_cond;
+    std::mutex m_space_lock;
+
+    // search state, protected by m_lock
+    OpenList m_open;
+    std::vector<SearchState*> m_being_expanded;
+    SearchState* m_goal_state = nullptr;
+    double m_curr_eps = 1.0;
+    int m_call_number = 0;
+    bool m_terminate = false;
+    bool m_found_goal = false;
+    clock::time_point m_deadline;
+
+    int m_expand_count_init = 0;
+    clock::duration m_search_time_init = clock::duration::zero();
+    int m_expand_count = 0;
+    clock::duration m_search_time = clock::duration::zero();
+    double m_satisfied_eps = std::numeric_limits<double>::infinity();
+
+    bool search(double eps, const clock::time_point& deadline);
+    void work();
+
+    auto selectState() -> SearchState*;
+    bool isIndependent(SearchState* s, OpenList::iterator pos);
+
+    void updateSuccessors(
+        SearchState* s,
+        const std::vector<int>& succs,
+        const std::vector<int>& costs);
+
+    void insertOpen(SearchState* s);
+    void eraseOpen(SearchState* s);
+
+    unsigned int computeKey(SearchState* s) const;
+
+    SearchState* getSearchState(int state_id);
+    void reinitSearchState(SearchState* state);
+
+    void extractPath(
+        SearchState* to_state,
+        std::vector<int>& solution,
+        int& cost) const;
+};
+
+} // namespace smpl
+
+#endif
@@ -0,0 +1,189 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+#ifndef SMPL_SEARCH_TRACE_H
+#define SMPL_SEARCH_TRACE_H
+
+// standard includes
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// system includes
+#include <sbpl/discrete_space_information/environment.h>
+#include <sbpl/heuristics/heuristic.h>
+
+// project includes
+#include <smpl/types.h>
+
+namespace smpl {
+
+/// Records the expansions of a search to a binary file, so that the search
+/// may later be replayed over the recorded graph without the environment that
+/// generated it.
+///
+/// The file begins with the 8-byte magic "SMPLSTR1", followed by a sequence of
+/// records, each a one-byte tag and fixed-size fields in host byte order:
+///
+///     'S' int32 start id, int32 goal id, float64 epsilon
+///     'H' int32 state id, uint8 heuristic index, int32 heuristic value
+///     'E' int32 state id, uint32 g, uint32 h, float32 graph seconds,
+///         uint32 n, int32[n] successor ids, int32[n] edge costs
+///
+/// The graph time of an expansion is the time spent generating its
+/// successors, which includes their collision checks.
+class SearchTraceRecorder
+{
+public:
+
+    SearchTraceRecorder() = default;
+    ~SearchTraceRecorder();
+
+    SearchTraceRecorder(const SearchTraceRecorder&) = delete;
+    SearchTraceRecorder& operator=(const SearchTraceRecorder&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return m_file != nullptr; }
+
+    void recordSearch(int start_id, int goal_id, double eps);
+    void recordHeuristic(int state_id, int hidx, int h);
+    void recordExpansion(
+        int state_id,
+        unsigned int g,
+        unsigned int h,
+        double graph_time,
+        const std::vector<int>& succs,
+        const std::vector<int>& costs);
+
+private:
+
+    std::FILE* m_file = nullptr;
+    std::vector<char> m_buffer;
+
+    template <class T>
+    void write(const T& value);
+    void flush();
+};
+
+/// The contents of a search trace file
+struct SearchTrace
+{
+    struct Expansion
+    {
+        int state_id;
+        unsigned int g;
+        unsigned int h;
+        float graph_time;
+        std::uint32_t first_succ; // index into succs and costs
+        std::uint32_t succ_count;
+    };
+
+    int start_id = -1;
+    int goal_id = -1;
+    double eps = 1.0;
+
+    std::vector<Expansion> expansions;
+    std::vector<int> succs;
+    std::vector<int> costs;
+
+    // recorded heuristic values, indexed by heuristic index
+    std::vector<hash_map<int, int>> heuristics;
+
+    // index of the first recorded expansion of each expanded state
+    hash_map<int, std::size_t> expansion_of;
+
+    double graphTime() const;
+};
+
+bool ReadSearchTrace(const std::string& path, SearchTrace& trace);
+
+/// A graph whose states and edges are those expanded in a search trace.
+/// States that were never expanded in the trace have no successors.
+class SearchTraceSpace : public DiscreteSpaceInformation
+{
+public:
+
+    explicit SearchTraceSpace(const SearchTrace* trace) : m_trace(trace) { }
+
+    /// Number of requests for the successors of states the trace never
+    /// expanded
+    int missingExpansions() const { return m_missing; }
+
+    /// \name Required Functions from DiscreteSpaceInformation
+    ///@{
+    void GetSuccs(int state_id, std::vector<int>* succs, std::vector<int>* costs) override;
+    void GetPreds(int state_id, std::vector<int>* preds, std::vector<int>* costs) override;
+    int GetGoalHeuristic(int state_id) override { return 0; }
+    int GetStartHeuristic(int state_id) override { return 0; }
+    int GetFromToHeuristic(int from_id, int to_id) override { return 0; }
+    void PrintState(int state_id, bool verbose, FILE* fout = nullptr) override { }
+    bool InitializeEnv(const char*) override { return false; }
+    bool InitializeMDPCfg(MDPConfig*) override { return false; }
+    int SizeofCreatedEnv() override { return 0; }
+    void SetAllActionsandAllOutcomes(CMDPSTATE*) override { }
+    void SetAllPreds(CMDPSTATE*) override { }
+    void PrintEnv_Config(FILE*) override { }
+    ///@}
+
+private:
+
+    const SearchTrace* m_trace;
+    int m_missing = 0;
+};
+
+/// A heuristic returning the values recorded for one heuristic index in a
+/// search trace, and 0 for states whose heuristic was never recorded
+class SearchTraceHeuristic : public Heuristic
+{
+public:
+
+    SearchTraceHeuristic(const SearchTrace* trace, int hidx) :
+        Heuristic(nullptr),
+        m_trace(trace),
+        m_hidx(hidx)
+    { }
+
+    int missingValues() const { return m_missing; }
+
+    int GetGoalHeuristic(int state_id) override;
+    int GetStartHeuristic(int state_id) override { return 0; }
+    int GetFromToHeuristic(int from_id, int to_id) override { return 0; }
+
+private:
+
+    const SearchTrace* m_trace;
+    int m_hidx;
+    int m_missing = 0;
+};
+
+} // namespace smpl
+
+#endif
@@ -32,10 +32,15 @@
 #ifndef SMPL_SMHASTAR_H
 #define SMPL_SMHASTAR_H
 
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
 #include <sbpl/heuristics/heuristic.h>
 #include <sbpl/planners/planner.h>
 #include <sbpl/utils/heap.h>
 
+#include <smpl/arena.h>
 #include <smpl/heap/intrusive_heap.h>
 
 class DiscreteSpaceInformation;
@@ -53,6 +58,9 @@ struct SMHAState
     bool closed_in_anc;
     bool closed_in_add;
 
+    // whether the state is being expanded by a worker of a parallel search
+    bool expanding;
+
     struct HeapData : public heap_element
     {
         // TODO: rather than map back to the state, the heap could know its
@@ -68,6 +76,22 @@ struct SMHAState
     HeapData od[1]; // overallocated for additional n heuristics
 };
 
+/// Shared multi-heuristic A*.
+///
+/// With a thread count above one, the inadmissible searches are served
+/// concurrently on the shared state table. Each worker thread owns a subset of
+/// the inadmissible queues, visits them round robin, and selects a state to
+/// expand from one of them, or from the anchor search, by the same rule as the
+/// sequential search. The states being expanded are kept out of every queue
+/// and are accounted for in the termination test, so the returned solution
+/// keeps the w_1 * w_2 suboptimality bound of the anchor search.
+///
+/// The search bookkeeping is protected by a single lock and only successor
+/// generation runs outside of it. By default, access to the graph, including
+/// successor generation, is serialized; graphs that support concurrent calls to
+/// GetSuccs() for distinct states, concurrently with state lookups and
+/// heuristic queries, may enable concurrent successor generation with
+/// set_concurrent_successors().
 class SMHAStar : public SBPLPlanner
 {
 public:
@@ -174,6 +198,19 @@ public:
 
     ///@}
 
+    /// \name Parallel Search
+    ///@{
+
+    /// Set the number of worker threads. The number of threads used is at
+    /// most the number of inadmissible heuristics.
+    void    set_thread_count(int count);
+    void    set_concurrent_successors(bool allow);
+
+    int     get_thread_count() const;
+    bool    get_concurrent_successors() const;
+
+    ///@}
+
 private:
 
     // Related objects
@@ -200,6 +237,7 @@ private:
     SMHAState* m_goal_state = NULL;
 
     std::vector<SMHAState*> m_search_states;
+    Arena m_state_arena; // backing storage for the search states
 
     struct HeapCompare
     {
@@ -213,6 +251,19 @@ private:
     using OpenList = intrusive_heap<SMHAState::HeapData, HeapCompare>;
     OpenList* m_open = NULL; ///< sequence of (m_heur_count + 1) open lists
 
+    int m_thread_count = 1;
+    bool m_concurrent_succs = false;
+
+    std::mutex m_lock;
+    std::condition_variable m_cond;
+    std::mutex m_space_lock;
+
+    // parallel search state, protected by m_lock
+    std::vector<SMHAState*> m_being_expanded;
+    double m_search_start = 0.0;
+    bool m_terminate = false;
+    bool m_found_goal = false;
+
     bool check_params(const ReplanParams& params);
 
     bool time_limit_reached() const;
@@ -226,6 +277,14 @@ private:
     void clear();
     int compute_key(SMHAState* state, int hidx);
     void expand(SMHAState* state, int hidx);
+    void close_state(SMHAState* state, int hidx);
+    void update_successors(
+        SMHAState* state,
+        const std::vector<int>& succ_ids,
+        const std::vector<int>& costs);
+    int parallel_search(std::vector<int>* solution, int* solcost);
+    void work(int tid, int thread_count);
+    int get_minf_bound(int hidx);
     SMHAState* state_from_open_state(SMHAState::HeapData* open_state);
     int compute_heuristic(int state_id, int hidx);
     int get_minf(OpenList& pq) const;
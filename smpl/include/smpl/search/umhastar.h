@@ -37,17 +37,20 @@
 
 namespace smpl {
 
-class UMHAStar : public MHAStarBase<UMHAStar>
+/// The edge evaluation policy, EagerEdgeEvaluation (UMHAStar) or
+/// LazyEdgeEvaluation (LazyUMHAStar), is passed on to MHAStarBase.
+template <typename EdgePolicy>
+class BasicUMHAStar : public MHAStarBase<BasicUMHAStar<EdgePolicy>, EdgePolicy>
 {
 public:
 
-    UMHAStar(
+    BasicUMHAStar(
         DiscreteSpaceInformation* environment,
         Heuristic* hanchor,
         Heuristic** heurs,
         int hcount);
 
-    friend class MHAStarBase<UMHAStar>;
+    friend class MHAStarBase<BasicUMHAStar<EdgePolicy>, EdgePolicy>;
 
 private:
 
@@ -61,6 +64,12 @@ private:
     bool satisfies_p_criterion(MHASearchState* state) const;
 };
 
+using UMHAStar = BasicUMHAStar<EagerEdgeEvaluation>;
+using LazyUMHAStar = BasicUMHAStar<LazyEdgeEvaluation>;
+
+extern template class BasicUMHAStar<EagerEdgeEvaluation>;
+extern template class BasicUMHAStar<LazyEdgeEvaluation>;
+
 } // namespace smpl
 
 #endif
@@ -0,0 +1,151 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_SWEPT_FOOTPRINT_H
+#define SMPL_SWEPT_FOOTPRINT_H
+
+// standard includes
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+// project includes
+#include <smpl/spatial.h>
+#include <smpl/unicycle/pose_2d.h>
+
+namespace smpl {
+
+class OccupancyGrid;
+
+/// Append the cells, relative to the cell containing the origin, covered by a
+/// footprint polygon at a pose. A cell is covered if its center lies inside
+/// the footprint or within half a cell diagonal of its boundary, which
+/// includes every cell the footprint overlaps. An empty footprint covers only
+/// the cell containing the pose.
+void RasterizeFootprint(
+    const std::vector<Vector2>& footprint,
+    const Pose2D& pose,
+    double res,
+    std::vector<std::pair<int, int>>& cells);
+
+/// Return the poses reached by driving a constant body-frame velocity from a
+/// start pose, sampled at count evenly spaced times, ending at duration. The
+/// velocity may come from any of the steer models, e.g. via WheelToBody.
+auto IntegrateBodyVelocity(
+    const Pose2D& start,
+    double vx,
+    double vy,
+    double vtheta,
+    double duration,
+    int count)
+    -> std::vector<Pose2D>;
+
+/// The set of 2D cells, relative to a reference cell, swept by a footprint
+/// along a motion. The cells are kept both as a sorted list and as packed
+/// rows of 64-bit words, so that the whole set can be tested against an
+/// OccupancySlice with one AND per 64 cells.
+class SweptFootprint
+{
+public:
+
+    SweptFootprint() = default;
+    explicit SweptFootprint(std::vector<std::pair<int, int>> cells);
+
+    bool empty() const { return m_cells.empty(); }
+
+    auto cells() const -> const std::vector<std::pair<int, int>>&
+    { return m_cells; }
+
+    int minX() const { return m_min_x; }
+    int minY() const { return m_min_y; }
+    int maxX() const { return m_max_x; }
+    int maxY() const { return m_max_y; }
+
+    /// Number of 64-bit words in each row mask
+    int rowWords() const { return m_row_words; }
+
+    /// Return the mask of the row of cells with y = minY() + r. Bit i of the
+    /// word j is the cell with x = minX() + 64 * j + i.
+    auto rowMask(int r) const -> const uint64_t*
+    { return &m_masks[(size_t)r * m_row_words]; }
+
+private:
+
+    std::vector<std::pair<int, int>> m_cells;
+    std::vector<uint64_t> m_masks;
+    int m_min_x = 0;
+    int m_min_y = 0;
+    int m_max_x = -1;
+    int m_max_y = -1;
+    int m_row_words = 0;
+};
+
+/// A packed bitmap of the obstacle cells of one horizontal slice of an
+/// occupancy grid. The bitmap is a snapshot; call update() after the grid
+/// changes.
+class OccupancySlice
+{
+public:
+
+    bool init(const OccupancyGrid* grid, int z);
+
+    /// Rebuild the bitmap from the grid
+    void update();
+
+    auto grid() const -> const OccupancyGrid* { return m_grid; }
+    int z() const { return m_z; }
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+
+    bool occupied(int x, int y) const
+    {
+        return (m_bits[(size_t)y * m_row_words + (x >> 6)] >> (x & 63)) & 1;
+    }
+
+    /// Return whether every cell of a swept footprint, offset by (x, y), is
+    /// within the slice and free.
+    bool isFree(int x, int y, const SweptFootprint& swept) const;
+
+private:
+
+    const OccupancyGrid* m_grid = nullptr;
+    int m_z = 0;
+    int m_width = 0;
+    int m_height = 0;
+
+    // each row holds one extra zero word, so that 64 bits may be read
+    // starting at any column without a bounds check
+    int m_row_words = 0;
+    std::vector<uint64_t> m_bits;
+};
+
+} // namespace smpl
+
+#endif
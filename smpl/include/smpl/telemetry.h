@@ -0,0 +1,198 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+#ifndef SMPL_TELEMETRY_H
+#define SMPL_TELEMETRY_H
+
+// standard includes
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace smpl {
+
+/// The hot-path events counted and timed by the telemetry registry. Cache
+/// lookups are counted but not timed.
+enum class TelemetryEvent
+{
+    Expansion = 0,
+    SuccessorGenerated,
+    StateCheck,
+    MotionCheck,
+    ForwardKinematics,
+    HeuristicEvaluation,
+    IkCacheHit,
+    IkCacheMiss,
+    HeuristicCacheHit,
+    HeuristicCacheMiss,
+    ResultCacheHit,
+    ResultCacheMiss,
+    Count
+};
+
+auto to_cstring(TelemetryEvent event) -> const char*;
+
+static const int TelemetryEventCount = (int)TelemetryEvent::Count;
+
+/// Number of buckets in each duration histogram. Bucket b counts the events
+/// that lasted in [2^(b-1), 2^b) ticks; the last bucket also counts all longer
+/// events.
+static const int TelemetryBucketCount = 40;
+
+/// Totals across all threads at one point in time.
+///
+/// Timed events may nest (e.g. the state checks made by a motion check), so
+/// their times are not additive across events.
+///
+/// Snapshots taken at two points may be subtracted to obtain the totals over
+/// the interval between them.
+struct TelemetrySnapshot
+{
+    std::uint64_t counts[TelemetryEventCount] = { };
+
+    /// Time spent in timed events, in ticks
+    std::uint64_t ticks[TelemetryEventCount] = { };
+
+    std::uint64_t histogram[TelemetryEventCount][TelemetryBucketCount] = { };
+
+    /// Tick period as measured when the snapshot was taken
+    double seconds_per_tick = 0.0;
+
+    std::uint64_t count(TelemetryEvent e) const { return counts[(int)e]; }
+
+    double seconds(TelemetryEvent e) const {
+        return seconds_per_tick * (double)ticks[(int)e];
+    }
+};
+
+auto GetTelemetry() -> TelemetrySnapshot;
+
+auto operator-(const TelemetrySnapshot& a, const TelemetrySnapshot& b)
+    -> TelemetrySnapshot;
+
+namespace detail {
+
+/// Counters owned by a single thread. Only the owning thread writes them, so
+/// an update is an unsynchronized load and store; other threads may read
+/// them at any time to take a snapshot.
+struct TelemetryBlock
+{
+    std::atomic<std::uint64_t> counts[TelemetryEventCount];
+    std::atomic<std::uint64_t> ticks[TelemetryEventCount];
+    std::atomic<std::uint64_t> histogram[TelemetryEventCount][TelemetryBucketCount];
+
+    TelemetryBlock();
+};
+
+extern thread_local TelemetryBlock* g_telemetry_block;
+
+auto RegisterTelemetryThread() -> TelemetryBlock*;
+
+inline auto TelemetryThreadBlock() -> TelemetryBlock*
+{
+    TelemetryBlock* block = g_telemetry_block;
+    if (block == nullptr) {
+        block = RegisterTelemetryThread();
+    }
+    return block;
+}
+
+inline void TelemetryAdd(std::atomic<std::uint64_t>& c, std::uint64_t n)
+{
+    c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+inline int TelemetryBucket(std::uint64_t ticks)
+{
+    if (ticks == 0) {
+        return 0;
+    }
+    const int b = 64 - __builtin_clzll(ticks);
+    return b < TelemetryBucketCount ? b : TelemetryBucketCount - 1;
+}
+
+} // namespace detail
+
+/// Read the telemetry clock. The timestamp counter is used where available;
+/// otherwise, ticks are nanoseconds of a steady clock.
+inline auto TelemetryTicks() -> std::uint64_t
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/// Count n occurrences of an untimed event on the calling thread
+inline void TelemetryCount(TelemetryEvent event, std::uint64_t n = 1)
+{
+    auto* block = detail::TelemetryThreadBlock();
+    detail::TelemetryAdd(block->counts[(int)event], n);
+}
+
+/// Count one occurrence of an event, and record the time until the end of the
+/// enclosing scope as its duration.
+class TelemetryTimer
+{
+public:
+
+    explicit TelemetryTimer(TelemetryEvent event) :
+        m_event((int)event),
+        m_start(TelemetryTicks())
+    { }
+
+    ~TelemetryTimer()
+    {
+        const std::uint64_t elapsed = TelemetryTicks() - m_start;
+        auto* block = detail::TelemetryThreadBlock();
+        detail::TelemetryAdd(block->counts[m_event], 1);
+        detail::TelemetryAdd(block->ticks[m_event], elapsed);
+        detail::TelemetryAdd(
+                block->histogram[m_event][detail::TelemetryBucket(elapsed)], 1);
+    }
+
+    TelemetryTimer(const TelemetryTimer&) = delete;
+    TelemetryTimer& operator=(const TelemetryTimer&) = delete;
+
+private:
+
+    int m_event;
+    std::uint64_t m_start;
+};
+
+} // namespace smpl
+
+#endif
@@ -0,0 +1,128 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_TRACING_H
+#define SMPL_TRACING_H
+
+// standard includes
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/// Record a span named by the string literal name from this point to the end
+/// of the enclosing scope.
+#define SMPL_TRACE_SPAN(name) \
+    ::smpl::TraceSpan SMPL_TRACE_SPAN_NAME(__LINE__)(name)
+
+#define SMPL_TRACE_SPAN_NAME(line) SMPL_TRACE_SPAN_NAME_(line)
+#define SMPL_TRACE_SPAN_NAME_(line) smpl_trace_span_ ## line
+
+namespace smpl {
+
+/// A completed span, with timestamps in nanoseconds of a steady clock
+struct TraceEvent
+{
+    const char* name;
+    std::uint32_t thread;
+    std::uint64_t begin_ns;
+    std::uint64_t end_ns;
+};
+
+/// Enable or disable the recording of spans. Recording is disabled by
+/// default; while disabled, a span costs a single relaxed load.
+void SetTracingEnabled(bool enabled);
+
+/// Set the number of spans retained. Once full, each new span overwrites the
+/// oldest. Discards the recorded spans.
+void SetTraceCapacity(std::size_t capacity);
+
+void ClearTrace();
+
+/// Return the retained spans, oldest first
+auto GetTraceEvents() -> std::vector<TraceEvent>;
+
+/// Write the retained spans as a Chrome trace event JSON document, which may
+/// be loaded into chrome://tracing or Perfetto.
+void WriteChromeTrace(std::ostream& o);
+bool WriteChromeTrace(const std::string& path);
+
+namespace detail {
+
+extern std::atomic<bool> g_tracing_enabled;
+
+void RecordSpan(const char* name, std::uint64_t begin_ns, std::uint64_t end_ns);
+
+} // namespace detail
+
+inline bool TracingEnabled()
+{
+    return detail::g_tracing_enabled.load(std::memory_order_relaxed);
+}
+
+inline auto TraceNow() -> std::uint64_t
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// Record a span from construction to destruction, if tracing is enabled at
+/// construction. The name must outlive the trace, i.e. be a string literal.
+class TraceSpan
+{
+public:
+
+    explicit TraceSpan(const char* name) :
+        m_name(TracingEnabled() ? name : nullptr),
+        m_begin(m_name != nullptr ? TraceNow() : 0)
+    { }
+
+    ~TraceSpan()
+    {
+        if (m_name != nullptr) {
+            detail::RecordSpan(m_name, m_begin, TraceNow());
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+
+    const char* m_name;
+    std::uint64_t m_begin;
+};
+
+} // namespace smpl
+
+#endif
@@ -164,6 +164,42 @@ public:
 };
 #endif
 
+/// \brief Non-owning view of the joint variables of a robot state
+///
+/// Allows states stored in preallocated buffers to be passed to interfaces
+/// without copying them into a RobotState. The viewed storage must outlive
+/// the view.
+class RobotStateView
+{
+public:
+
+    using value_type = double;
+    using size_type = std::size_t;
+    using const_iterator = const double*;
+
+    RobotStateView() : m_data(nullptr), m_size(0) { }
+    RobotStateView(const double* data, size_type size) :
+        m_data(data), m_size(size)
+    { }
+    RobotStateView(const RobotState& state) :
+        m_data(state.data()), m_size(state.size())
+    { }
+
+    auto data() const -> const double* { return m_data; }
+    auto size() const -> size_type { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    auto operator[](size_type i) const -> const double& { return m_data[i]; }
+
+    auto begin() const -> const_iterator { return m_data; }
+    auto end() const -> const_iterator { return m_data + m_size; }
+
+private:
+
+    const double* m_data;
+    size_type m_size;
+};
+
 using Action = std::vector<RobotState>;
 
 } // namespace smpl
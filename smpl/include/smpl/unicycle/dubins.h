@@ -2,6 +2,7 @@
 #define SMPL_DUBINS_H
 
 // standard includes
+#include <stddef.h>
 #include <ostream>
 #include <vector>
 
@@ -69,6 +70,27 @@ int MakeDubinsPaths(
     double radius,
     DubinsMotion motions[6]);
 
+/// \brief Return the length, in meters, of the shortest Dubins path between
+///     two poses, considering all six (CSC and CCC) words.
+auto ComputeDubinsDistance(
+    const Pose2D& start,
+    const Pose2D& goal,
+    double radius) -> double;
+
+/// \brief Compute the lengths of the shortest Dubins paths between many
+///     (start, goal) pairs at once.
+///
+/// The poses are given as separate coordinate arrays, so that the loop over
+/// pairs is free of branches and may be vectorized by the compiler. Every
+/// word is evaluated for every pair and infeasible words are masked out,
+/// rather than skipped. Any of the output arrays may alias the input arrays.
+void ComputeDubinsDistances(
+    const double* start_x, const double* start_y, const double* start_theta,
+    const double* goal_x, const double* goal_y, const double* goal_theta,
+    double radius,
+    size_t count,
+    double* distances);
+
 } // namespace smpl
 
 #endif
@@ -0,0 +1,103 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_WORKER_POOL_H
+#define SMPL_WORKER_POOL_H
+
+// standard includes
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace smpl {
+
+/// A persistent set of worker threads for running short, data-parallel jobs.
+///
+/// The pool is meant for fork-join work inside hot loops (e.g. checking all of
+/// the actions generated by a single expansion), where the cost of spawning a
+/// thread per job would dominate. Threads are created once at construction and
+/// sleep between jobs.
+///
+/// The thread that calls run() participates in the job as worker 0, so a pool
+/// constructed with N threads spawns N - 1 background threads. Only one job may
+/// be run at a time; run() is not reentrant.
+class WorkerPool
+{
+public:
+
+    /// The job signature. The first argument is the index, in
+    /// [0, numThreads()), of the thread executing the work item, suitable for
+    /// indexing per-thread scratch data. The second argument is the index of
+    /// the work item.
+    using Job = std::function<void(int, std::size_t)>;
+
+    explicit WorkerPool(int num_threads = 1);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    int numThreads() const { return (int)m_threads.size() + 1; }
+
+    /// Invoke job(tid, i) for every i in [0, count) and block until all work
+    /// items have completed.
+    void run(std::size_t count, const Job& job);
+
+private:
+
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_job_ready;
+    std::condition_variable m_job_done;
+
+    const Job* m_job = nullptr;
+    std::size_t m_count = 0;
+    std::atomic<std::size_t> m_next;
+
+    // incremented for every job to wake the workers
+    unsigned long m_generation = 0;
+
+    // number of background workers still running the current job
+    int m_active = 0;
+
+    bool m_shutdown = false;
+
+    void work(int tid);
+    void runItems(int tid);
+};
+
+} // namespace smpl
+
+#endif
@@ -0,0 +1,169 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+/// \author Andrew Dornbush
+
+#include <smpl/arena.h>
+
+// standard includes
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <algorithm>
+
+namespace smpl {
+
+const std::size_t Arena::DefaultBlockSize;
+
+static auto AlignUp(uintptr_t p, std::size_t align) -> uintptr_t
+{
+    return (p + (align - 1)) & ~(uintptr_t)(align - 1);
+}
+
+Arena::Arena(std::size_t block_size) :
+    m_blocks(),
+    m_block_size(std::max(block_size, (std::size_t)64)),
+    m_curr(0),
+    m_offset(0),
+    m_capacity(0),
+    m_used(0),
+    m_capacity_limit(0)
+{
+}
+
+Arena::~Arena()
+{
+    release();
+}
+
+Arena::Arena(Arena&& o) :
+    m_blocks(std::move(o.m_blocks)),
+    m_block_size(o.m_block_size),
+    m_curr(o.m_curr),
+    m_offset(o.m_offset),
+    m_capacity(o.m_capacity),
+    m_used(o.m_used),
+    m_capacity_limit(o.m_capacity_limit)
+{
+    o.m_blocks.clear();
+    o.m_curr = 0;
+    o.m_offset = 0;
+    o.m_capacity = 0;
+    o.m_used = 0;
+}
+
+Arena& Arena::operator=(Arena&& o)
+{
+    if (this != &o) {
+        release();
+        m_blocks = std::move(o.m_blocks);
+        m_block_size = o.m_block_size;
+        m_curr = o.m_curr;
+        m_offset = o.m_offset;
+        m_capacity = o.m_capacity;
+        m_used = o.m_used;
+        m_capacity_limit = o.m_capacity_limit;
+        o.m_blocks.clear();
+        o.m_curr = 0;
+        o.m_offset = 0;
+        o.m_capacity = 0;
+        o.m_used = 0;
+    }
+    return *this;
+}
+
+void* Arena::allocate(std::size_t size, std::size_t align)
+{
+    void* p = tryAllocate(size, align);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* Arena::tryAllocate(std::size_t size, std::size_t align)
+{
+    assert(align != 0 && (align & (align - 1)) == 0);
+
+    // try to fit the allocation in the current block, then in any blocks
+    // retained from before the last reset
+    while (m_curr < m_blocks.size()) {
+        auto& block = m_blocks[m_curr];
+        auto base = (uintptr_t)block.data;
+        auto p = AlignUp(base + m_offset, align);
+        if (p + size <= base + block.size) {
+            m_used += (std::size_t)(p + size - (base + m_offset));
+            m_offset = (std::size_t)(p + size - base);
+            return (void*)p;
+        }
+        ++m_curr;
+        m_offset = 0;
+    }
+
+    // allocate a new block, oversized for allocations that are larger than
+    // the block size
+    Block block;
+    block.size = std::max(m_block_size, size + align);
+    if (m_capacity_limit != 0 && m_capacity + block.size > m_capacity_limit) {
+        return nullptr;
+    }
+    block.data = (char*)malloc(block.size);
+    if (!block.data) {
+        return nullptr;
+    }
+    m_blocks.push_back(block);
+    m_capacity += block.size;
+    m_curr = m_blocks.size() - 1;
+
+    auto base = (uintptr_t)block.data;
+    auto p = AlignUp(base, align);
+    m_offset = (std::size_t)(p + size - base);
+    m_used += m_offset;
+    return (void*)p;
+}
+
+void Arena::reset()
+{
+    m_curr = 0;
+    m_offset = 0;
+    m_used = 0;
+}
+
+void Arena::release()
+{
+    for (auto& block : m_blocks) {
+        free(block.data);
+    }
+    m_blocks.clear();
+    m_capacity = 0;
+    reset();
+}
+
+} // namespace smpl
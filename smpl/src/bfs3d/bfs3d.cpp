@@ -32,11 +32,17 @@
 
 #include <smpl/bfs3d/bfs3d.h>
 
+#include <algorithm>
+#include <functional>
+#include <queue>
+
 #include <smpl/console/console.h>
+#include <smpl/large_alloc.h>
 
 namespace smpl {
 
-BFS_3D::BFS_3D(int width, int height, int length) :
+template <typename Cell>
+BasicBFS_3D<Cell>::BasicBFS_3D(int width, int height, int length) :
     m_search_thread(),
     m_dim_x(),
     m_dim_y(),
@@ -46,9 +52,10 @@ BFS_3D::BFS_3D(int width, int height, int length) :
     m_queue_head(),
     m_queue_tail(),
     m_running(false),
-    m_neighbor_offsets(),
-    m_closed(),
-    m_distances()
+    m_searched(false),
+    m_lazy(false),
+    m_cancel(nullptr),
+    m_neighbor_offsets()
 {
     if (width <= 0 || height <= 0 || length <= 0) {
         return;
@@ -88,8 +95,8 @@ BFS_3D::BFS_3D(int width, int height, int length) :
     m_neighbor_offsets[24] = m_dim_x+1-m_dim_xy;
     m_neighbor_offsets[25] = m_dim_x-1-m_dim_xy;
 
-    m_distance_grid = new int[m_dim_xyz];
-    m_queue = new int[width * height * length];
+    m_distance_grid = static_cast<Cell*>(
+            AllocateLarge(m_dim_xyz * sizeof(Cell)));
 
     for (int node = 0; node < m_dim_xyz; node++) {
         int x = node % m_dim_x;
@@ -99,38 +106,39 @@ BFS_3D::BFS_3D(int width, int height, int length) :
             y == 0 || y == m_dim_y - 1 ||
             z == 0 || z == m_dim_z - 1)
         {
-            m_distance_grid[node] = WALL;
+            m_distance_grid[node] = WallCell();
         }
         else {
-            m_distance_grid[node] = UNDISCOVERED;
+            m_distance_grid[node] = UndiscoveredCell();
         }
     }
 
     m_running = false;
 }
 
-BFS_3D::~BFS_3D()
+template <typename Cell>
+BasicBFS_3D<Cell>::~BasicBFS_3D()
 {
     if (m_search_thread.joinable()) {
         m_search_thread.join();
     }
 
     if (m_distance_grid) {
-        delete[] m_distance_grid;
-    }
-    if (m_queue) {
-        delete[] m_queue;
+        DeallocateLarge(const_cast<Cell*>(m_distance_grid), m_dim_xyz * sizeof(Cell));
     }
+    release_queue();
 }
 
-void BFS_3D::getDimensions(int* width, int* height, int* length)
+template <typename Cell>
+void BasicBFS_3D<Cell>::getDimensions(int* width, int* height, int* length)
 {
     *width = m_dim_x - 2;
     *height = m_dim_y - 2;
     *length = m_dim_z - 2;
 }
 
-void BFS_3D::setWall(int x, int y, int z)
+template <typename Cell>
+void BasicBFS_3D<Cell>::setWall(int x, int y, int z)
 {
     if (m_running) {
         //error "Cannot modify grid while search is running"
@@ -138,31 +146,67 @@ void BFS_3D::setWall(int x, int y, int z)
     }
 
     int node = getNode(x, y, z);
-    m_distance_grid[node] = WALL;
+    m_distance_grid[node] = WallCell();
 }
 
-bool BFS_3D::isWall(int x, int y, int z) const
+template <typename Cell>
+void BasicBFS_3D<Cell>::setLazy(bool lazy)
+{
+    if (m_running) {
+        //error "Cannot change lazy mode while search is running"
+        return;
+    }
+    m_lazy = lazy;
+}
+
+template <typename Cell>
+void BasicBFS_3D<Cell>::setThreadCount(int count)
+{
+    if (m_running) {
+        //error "Cannot change thread count while search is running"
+        return;
+    }
+
+    if (count <= 1) {
+        m_pool.reset();
+        m_next_cells.clear();
+    } else {
+        m_pool.reset(new WorkerPool(count));
+        m_next_cells.resize(count);
+    }
+}
+
+template <typename Cell>
+bool BasicBFS_3D<Cell>::isWall(int x, int y, int z) const
 {
     int node = getNode(x, y, z);
-    return m_distance_grid[node] == WALL;
+    return m_distance_grid[node] == WallCell();
 }
 
-bool BFS_3D::isUndiscovered(int x, int y, int z) const
+template <typename Cell>
+bool BasicBFS_3D<Cell>::isUndiscovered(int x, int y, int z) const
 {
     int node = getNode(x, y, z);
-    while (m_running && m_distance_grid[node] < 0);
-    return m_distance_grid[node] == UNDISCOVERED;
+    while (m_running && m_distance_grid[node] == UndiscoveredCell());
+    resume_search(node);
+    return m_distance_grid[node] == UndiscoveredCell();
 }
 
-void BFS_3D::run(int x, int y, int z)
+template <typename Cell>
+void BasicBFS_3D<Cell>::run(int x, int y, int z)
 {
     if (m_running) {
         return;
     }
 
+    // reap the thread of the previous, completed search
+    if (m_search_thread.joinable()) {
+        m_search_thread.join();
+    }
+
     for (int i = 0; i < m_dim_xyz; i++) {
-        if (m_distance_grid[i] != WALL) {
-            m_distance_grid[i] = UNDISCOVERED;
+        if (m_distance_grid[i] != WallCell()) {
+            m_distance_grid[i] = UndiscoveredCell();
         }
     }
 
@@ -170,6 +214,7 @@ void BFS_3D::run(int x, int y, int z)
     int origin = getNode(x, y, z);
 
     // initialize the queue
+    reserve_queue();
     m_queue_head = 0;
     m_queue_tail = 1;
     m_queue[0] = origin;
@@ -177,27 +222,94 @@ void BFS_3D::run(int x, int y, int z)
     // initialize starting distance
     m_distance_grid[origin] = 0;
 
+    start_search();
+}
+
+template <typename Cell>
+void BasicBFS_3D<Cell>::start_search()
+{
+    m_searched = true;
+    if (m_lazy) {
+        return;
+    }
+
+    // mark the search as running before it starts, so that a search that
+    // completes immediately can not be marked as running afterwards
+    m_running = true;
+
     // fire off background thread to compute bfs
     m_search_thread = std::thread([&]()
     {
-        this->search(m_dim_x, m_dim_xy, m_distance_grid, m_queue, m_queue_head, m_queue_tail);
+        if (m_pool) {
+            this->parallel_search(m_distance_grid, m_queue, m_queue_head, m_queue_tail);
+        } else {
+            this->search(m_dim_x, m_dim_xy, m_distance_grid, m_queue, m_queue_head, m_queue_tail);
+        }
+        // keep the cells of a cancelled search for queries to resume
+        if (m_queue_head >= m_queue_tail) {
+            this->release_queue();
+        }
     });
+}
 
-    m_running = true;
+template <typename Cell>
+void BasicBFS_3D<Cell>::reserve_queue()
+{
+    if (!m_queue) {
+        m_queue = static_cast<int*>(AllocateLarge(queue_size() * sizeof(int)));
+    }
+}
+
+template <typename Cell>
+void BasicBFS_3D<Cell>::release_queue()
+{
+    if (m_queue) {
+        DeallocateLarge(m_queue, queue_size() * sizeof(int));
+        m_queue = nullptr;
+    }
+}
+
+// Restart the search from the cells at distance 0. A lazy search is left to be
+// resumed by queries; any other search is completed in the calling thread.
+template <typename Cell>
+void BasicBFS_3D<Cell>::rerun_from_start_cells()
+{
+    reserve_queue();
+    m_queue_head = 0;
+    m_queue_tail = 0;
+    for (int i = 0; i < m_dim_xyz; ++i) {
+        if (m_distance_grid[i] == 0) {
+            m_queue[m_queue_tail++] = i;
+        } else if (m_distance_grid[i] != WallCell()) {
+            m_distance_grid[i] = UndiscoveredCell();
+        }
+    }
+
+    if (!m_lazy) {
+        m_running = true;
+        search(m_dim_x, m_dim_xy, m_distance_grid, m_queue, m_queue_head, m_queue_tail);
+        if (m_queue_head >= m_queue_tail) {
+            release_queue();
+        }
+    }
 }
 
-void BFS_3D::run_components(int gx, int gy, int gz)
+template <typename Cell>
+void BasicBFS_3D<Cell>::run_components(int gx, int gy, int gz)
 {
+    // the combined distance field can not be repaired incrementally
+    m_searched = false;
+
     for (int i = 0; i < m_dim_xyz; i++) {
-        if (m_distance_grid[i] != WALL) {
-            m_distance_grid[i] = UNDISCOVERED;
+        if (m_distance_grid[i] != WallCell()) {
+            m_distance_grid[i] = UndiscoveredCell();
         }
     }
 
     // invert walls and free cells in an auxiliary bfs
     int length, width, height;
     getDimensions(&length, &width, &height);
-    BFS_3D wall_bfs(length, width, height);
+    BasicBFS_3D wall_bfs(length, width, height);
     for (int x = 0; x < length; ++x) {
         for (int y = 0; y < width; ++y) {
             for (int z = 0; z < height; ++z) {
@@ -210,21 +322,23 @@ void BFS_3D::run_components(int gx, int gy, int gz)
 
     // initialize the distance grid of the wall bfs
     for (int i = 0; i < m_dim_xyz; ++i) {
-        if (wall_bfs.m_distance_grid[i] != WALL) {
-            wall_bfs.m_distance_grid[i] = UNDISCOVERED;
+        if (wall_bfs.m_distance_grid[i] != WallCell()) {
+            wall_bfs.m_distance_grid[i] = UndiscoveredCell();
         }
     }
 
     // initialize the distance grid queue
+    reserve_queue();
+    wall_bfs.reserve_queue();
     wall_bfs.m_queue_head = 0;
     wall_bfs.m_queue_tail = 1;
 
-    int volatile* curr_distance_grid = m_distance_grid;
+    Cell volatile* curr_distance_grid = m_distance_grid;
     int* curr_queue = m_queue;
     int* curr_queue_head = &m_queue_head;
     int* curr_queue_tail = &m_queue_tail;
 
-    int volatile* next_distance_grid = wall_bfs.m_distance_grid;
+    Cell volatile* next_distance_grid = wall_bfs.m_distance_grid;
     int* next_queue = wall_bfs.m_queue;
     int* next_queue_head = &wall_bfs.m_queue_head;
     int* next_queue_tail = &wall_bfs.m_queue_tail;
@@ -268,13 +382,172 @@ void BFS_3D::run_components(int gx, int gy, int gz)
 
     // combine distance fields
     for (int i = 0; i < m_dim_xyz; ++i) {
-        if (wall_bfs.m_distance_grid[i] != WALL) {
+        if (wall_bfs.m_distance_grid[i] != WallCell()) {
             m_distance_grid[i] = wall_bfs.m_distance_grid[i];
         }
     }
+
+    release_queue();
+}
+
+template <typename Cell>
+void BasicBFS_3D<Cell>::updateWalls(
+    const std::vector<int>& added,
+    const std::vector<int>& removed)
+{
+    // let a running search finish, the repair starts from its final distances
+    if (m_search_thread.joinable()) {
+        m_search_thread.join();
+    }
+
+    // a partial lazy search is restarted rather than repaired
+    const bool restart = m_searched && m_lazy && m_queue_head < m_queue_tail;
+
+    if (!m_searched || restart) {
+        for (size_t i = 0; i + 2 < added.size(); i += 3) {
+            int node = getNode(added[i], added[i + 1], added[i + 2]);
+            if (node >= 0) {
+                setWall(node);
+            }
+        }
+        for (size_t i = 0; i + 2 < removed.size(); i += 3) {
+            int node = getNode(removed[i], removed[i + 1], removed[i + 2]);
+            if (node >= 0 && isWall(node)) {
+                unsetWall(node);
+            }
+        }
+
+        if (restart) {
+            rerun_from_start_cells();
+        }
+        return;
+    }
+
+    // (distance, node) entries, expanded in order of increasing distance
+    using QueueEntry = std::pair<int, int>;
+    using Queue = std::priority_queue<
+            QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>>;
+
+    // cells that lost their distance, whose free neighbors seed the repair
+    std::vector<int> cleared;
+
+    // place the new walls and queue up the cells that may have been reached
+    // through them
+    Queue check;
+    bool saturated = false;
+    for (size_t i = 0; i + 2 < added.size(); i += 3) {
+        int node = getNode(added[i], added[i + 1], added[i + 2]);
+        if (node < 0 || isWall(node)) {
+            continue;
+        }
+        int d = cellDistance(node);
+        setWall(node);
+        if (d == UNDISCOVERED) {
+            continue;
+        }
+        for (int n = 0; n < 26; ++n) {
+            int nn = neighbor(node, n);
+            if (cellDistance(nn) == d + 1) {
+                check.push(QueueEntry(d + 1, nn));
+            }
+        }
+    }
+
+    // clear the distances of cells no longer supported by a neighbor one
+    // step closer to the start cells. Cells are checked in order of
+    // increasing distance, so all of a cell's potential supporters have been
+    // settled by the time it is checked.
+    while (!check.empty()) {
+        QueueEntry e = check.top();
+        check.pop();
+        int d = e.first;
+        int node = e.second;
+        if (cellDistance(node) != d) {
+            continue; // cleared or checked already
+        }
+
+        // saturated distances do not identify the cells they were reached
+        // from, so the search is rerun instead
+        if (d >= (int)MaxCellDistance()) {
+            saturated = true;
+            break;
+        }
+
+        bool supported = false;
+        for (int n = 0; n < 26; ++n) {
+            if (cellDistance(neighbor(node, n)) == d - 1) {
+                supported = true;
+                break;
+            }
+        }
+        if (supported) {
+            continue;
+        }
+
+        m_distance_grid[node] = UndiscoveredCell();
+        cleared.push_back(node);
+        for (int n = 0; n < 26; ++n) {
+            int nn = neighbor(node, n);
+            if (cellDistance(nn) == d + 1) {
+                check.push(QueueEntry(d + 1, nn));
+            }
+        }
+    }
+
+    for (size_t i = 0; i + 2 < removed.size(); i += 3) {
+        int node = getNode(removed[i], removed[i + 1], removed[i + 2]);
+        if (node >= 0 && isWall(node)) {
+            unsetWall(node);
+            cleared.push_back(node);
+        }
+    }
+
+    if (saturated) {
+        rerun_from_start_cells();
+        return;
+    }
+
+    // propagate distances back into the cleared cells from their discovered
+    // neighbors, lowering the distances of cells that are now closer
+    Queue open;
+    for (int node : cleared) {
+        for (int n = 0; n < 26; ++n) {
+            int nn = neighbor(node, n);
+            int d = cellDistance(nn);
+            if (d != WALL && d != UNDISCOVERED) {
+                open.push(QueueEntry(d, nn));
+            }
+        }
+    }
+
+    while (!open.empty()) {
+        QueueEntry e = open.top();
+        open.pop();
+        int d = e.first;
+        int node = e.second;
+        if (cellDistance(node) != d) {
+            continue; // stale entry
+        }
+
+        for (int n = 0; n < 26; ++n) {
+            int nn = neighbor(node, n);
+            int nd = cellDistance(nn);
+            if (nd == WALL) {
+                continue;
+            }
+            int next = ToDistance(ToCell(d + 1));
+            if (nd == UNDISCOVERED || nd > next) {
+                m_distance_grid[nn] = ToCell(next);
+                open.push(QueueEntry(next, nn));
+            }
+        }
+    }
+
+    SMPL_DEBUG("Repaired %zu cells of the BFS", cleared.size());
 }
 
-bool BFS_3D::escapeCell(int x, int y, int z)
+template <typename Cell>
+bool BasicBFS_3D<Cell>::escapeCell(int x, int y, int z)
 {
     if (!inBounds(x, y, z)) {
         SMPL_ERROR("BFS goal is out of bounds");
@@ -320,8 +593,9 @@ bool BFS_3D::escapeCell(int x, int y, int z)
     return true;
 }
 
+template <typename Cell>
 template <typename Visitor>
-void BFS_3D::visit_free_cells(int node, const Visitor& visitor)
+void BasicBFS_3D<Cell>::visit_free_cells(int node, const Visitor& visitor)
 {
     if (isWall(node)) {
         return;
@@ -356,24 +630,59 @@ void BFS_3D::visit_free_cells(int node, const Visitor& visitor)
     }
 }
 
-int BFS_3D::getDistance(int x, int y, int z) const
+template <typename Cell>
+int BasicBFS_3D<Cell>::getDistance(int x, int y, int z) const
 {
     int node = getNode(x, y, z);
-    while (m_running && m_distance_grid[node] < 0);
-    return m_distance_grid[node];
+    while (m_running && m_distance_grid[node] == UndiscoveredCell());
+    resume_search(node);
+    return cellDistance(node);
+}
+
+template <typename Cell>
+void BasicBFS_3D<Cell>::copyDistances(std::vector<int>& distances) const
+{
+    while (m_running);
+    finish_search();
+    distances.resize(m_dim_xyz);
+    for (int i = 0; i < m_dim_xyz; ++i) {
+        distances[i] = cellDistance(i);
+    }
+}
+
+template <typename Cell>
+bool BasicBFS_3D<Cell>::restoreDistances(const std::vector<int>& distances)
+{
+    if (distances.size() != (size_t)m_dim_xyz) {
+        SMPL_ERROR("Distance grid size does not match BFS size");
+        return false;
+    }
+
+    if (m_search_thread.joinable()) {
+        m_search_thread.join();
+    }
+
+    for (int i = 0; i < m_dim_xyz; ++i) {
+        m_distance_grid[i] = ToCell(distances[i]);
+    }
+    m_queue_head = 0;
+    m_queue_tail = 0;
+    m_searched = true;
+    return true;
 }
 
-int BFS_3D::getNearestFreeNodeDist(int x, int y, int z)
+template <typename Cell>
+int BasicBFS_3D<Cell>::getNearestFreeNodeDist(int x, int y, int z)
 {
     // initialize closed set and distances
-    m_closed.assign(m_dim_xyz, false);
-    m_distances.assign(m_dim_xyz, -1);
+    std::vector<bool> closed(m_dim_xyz, false);
+    std::vector<int> distances(m_dim_xyz, -1);
 
     std::queue<std::tuple<int, int, int>> q;
     q.push(std::make_tuple(x, y, z));
 
     int n = getNode(x, y, z);
-    m_distances[n] = 0;
+    distances[n] = 0;
 
     while (!q.empty()) {
         std::tuple<int, int, int> ncoords = q.front();
@@ -388,9 +697,9 @@ int BFS_3D::getNearestFreeNodeDist(int x, int y, int z)
         n = getNode(nx, ny, nz);
 
         // mark as visited
-        m_closed[n] = true;
+        closed[n] = true;
 
-        int dist = m_distances[n];
+        int dist = distances[n];
 
         // goal == found a free cell
         if (!isWall(n)) {
@@ -410,8 +719,8 @@ int BFS_3D::getNearestFreeNodeDist(int x, int y, int z)
 {\
 if (inBounds(xn, yn, zn)) {\
     int nn = getNode(xn, yn, zn);\
-    if (!m_closed[nn] && (m_distances[nn] == -1 || dist + 1 < m_distances[nn])) {\
-        m_distances[nn] = dist + 1;\
+    if (!closed[nn] && (distances[nn] == -1 || dist + 1 < distances[nn])) {\
+        distances[nn] = dist + 1;\
         q.push(std::make_tuple(xn, yn, zn));\
     }\
 }\
@@ -451,56 +760,113 @@ if (inBounds(xn, yn, zn)) {\
     return -1;
 }
 
-int BFS_3D::countWalls() const
+template <typename Cell>
+int BasicBFS_3D<Cell>::countWalls() const
 {
     int count = 0;
     for (int i = 0; i < m_dim_xyz; ++i) {
-        if (m_distance_grid[i] == WALL) {
+        if (m_distance_grid[i] == WallCell()) {
             ++count;
         }
     }
     return count;
 }
 
-int BFS_3D::countUndiscovered() const
+template <typename Cell>
+int BasicBFS_3D<Cell>::countUndiscovered() const
 {
     int count = 0;
     for (int i = 0; i < m_dim_xyz; ++i) {
-        if (m_distance_grid[i] == UNDISCOVERED) {
+        if (m_distance_grid[i] == UndiscoveredCell()) {
             ++count;
         }
     }
     return count;
 }
 
-int BFS_3D::countDiscovered() const
+template <typename Cell>
+int BasicBFS_3D<Cell>::countDiscovered() const
 {
     int count = 0;
     for (int i = 0; i < m_dim_xyz; ++i) {
-        if (m_distance_grid[i] != WALL && m_distance_grid[i] >= 0) {
+        if (m_distance_grid[i] != WallCell() &&
+            m_distance_grid[i] != UndiscoveredCell()) {
             ++count;
         }
     }
     return count;
 }
 
+template <typename Cell>
+auto BasicBFS_3D<Cell>::memoryUsage() const -> std::size_t
+{
+    auto usage = (std::size_t)m_dim_xyz * sizeof(Cell);
+    if (m_queue) {
+        usage += (std::size_t)(m_dim_x - 2) * (m_dim_y - 2) * (m_dim_z - 2) * sizeof(int);
+    }
+    usage += m_next_cells.capacity() * sizeof(std::vector<int>);
+    for (auto& cells : m_next_cells) {
+        usage += cells.capacity() * sizeof(int);
+    }
+    return usage;
+}
+
+template <typename Cell>
+void BasicBFS_3D<Cell>::resume_search(int node) const
+{
+    // check the node first to stay off the queue of a running search
+    while (m_distance_grid[node] == UndiscoveredCell() &&
+            m_queue_head < m_queue_tail)
+    {
+        expand_next();
+    }
+}
+
+template <typename Cell>
+void BasicBFS_3D<Cell>::finish_search() const
+{
+    while (m_queue_head < m_queue_tail) {
+        expand_next();
+    }
+}
+
+template <typename Cell>
+void BasicBFS_3D<Cell>::expand_next() const
+{
+    int n = m_queue[m_queue_head++];
+    Cell cost = NextCellDistance(m_distance_grid[n]);
+    for (int i = 0; i < 26; ++i) {
+        int nn = n + m_neighbor_offsets[i];
+        if (m_distance_grid[nn] == UndiscoveredCell()) {
+            m_distance_grid[nn] = cost;
+            m_queue[m_queue_tail++] = nn;
+        }
+    }
+}
+
 #define EXPAND_NEIGHBOR(offset)                            \
-    if (distance_grid[currentNode + offset] < 0) {         \
+    if (distance_grid[currentNode + offset] == UndiscoveredCell()) { \
         queue[queue_tail++] = currentNode + offset;        \
         distance_grid[currentNode + offset] = currentCost; \
     }
 
-void BFS_3D::search(
+template <typename Cell>
+void BasicBFS_3D<Cell>::search(
     int width,
     int planeSize,
-    int volatile* distance_grid,
+    Cell volatile* distance_grid,
     int* queue,
     int& queue_head,
     int& queue_tail)
 {
     while (queue_head < queue_tail) {
+        // poll the token every so often, between whole cell expansions
+        if ((queue_head & 1023) == 0 && Expired(m_cancel)) {
+            break;
+        }
+
         int currentNode = queue[queue_head++];
-        int currentCost = distance_grid[currentNode] + 1;
+        Cell currentCost = NextCellDistance(distance_grid[currentNode]);
 
         EXPAND_NEIGHBOR(-width);
         EXPAND_NEIGHBOR(1);
@@ -536,33 +902,34 @@ void BFS_3D::search(
 
 #define EXPAND_NEIGHBOR_FRONTIER(offset) \
 {\
-    if (distance_grid[currentNode + offset] < 0) {\
+    if (distance_grid[currentNode + offset] == UndiscoveredCell()) {\
         queue[queue_tail++] = currentNode + offset;\
         distance_grid[currentNode + offset] = currentCost;\
     }\
-    else if (distance_grid[currentNode + offset] == WALL) {\
-        if (frontier_grid[currentNode + offset] < 0) {\
+    else if (distance_grid[currentNode + offset] == WallCell()) {\
+        if (frontier_grid[currentNode + offset] == UndiscoveredCell()) {\
             frontier_queue[frontier_queue_tail++] = currentNode + offset;\
             frontier_grid[currentNode + offset] = currentCost;\
         }\
     }\
 }
 
-void BFS_3D::search(
+template <typename Cell>
+void BasicBFS_3D<Cell>::search(
     int width,
     int planeSize,
-    int volatile* distance_grid,
+    Cell volatile* distance_grid,
     int* queue,
     int& queue_head,
     int& queue_tail,
-    int volatile* frontier_grid,
+    Cell volatile* frontier_grid,
     int* frontier_queue,
     int& frontier_queue_head,
     int& frontier_queue_tail)
 {
     while (queue_head < queue_tail) {
         int currentNode = queue[queue_head++];
-        int currentCost = distance_grid[currentNode] + 1;
+        Cell currentCost = NextCellDistance(distance_grid[currentNode]);
 
         EXPAND_NEIGHBOR_FRONTIER(-width);
         EXPAND_NEIGHBOR_FRONTIER(1);
@@ -596,4 +963,66 @@ void BFS_3D::search(
 
 #undef EXPAND_NEIGHBOR_FRONTIER
 
+// Level-synchronous variant of search(). Cells of the current level occupy
+// [queue_head, queue_tail) and are expanded in chunks by the worker pool.
+// Undiscovered neighbors are claimed with a compare-and-swap, so each cell is
+// assigned its final distance exactly once and may be read concurrently, and
+// is appended to the discovering thread's list of next-level cells. The lists
+// are then concatenated behind the current level to form the next one.
+template <typename Cell>
+void BasicBFS_3D<Cell>::parallel_search(
+    Cell volatile* distance_grid,
+    int* queue,
+    int& queue_head,
+    int& queue_tail)
+{
+    const int chunk_size = 1024;
+
+    while (queue_head < queue_tail && !Expired(m_cancel)) {
+        const int level_begin = queue_head;
+        const int level_end = queue_tail;
+
+        auto expand_chunk = [&](int tid, std::size_t chunk)
+        {
+            auto& next_cells = m_next_cells[tid];
+            int first = level_begin + (int)chunk * chunk_size;
+            int last = std::min(first + chunk_size, level_end);
+            for (int i = first; i != last; ++i) {
+                int node = queue[i];
+                Cell cost = NextCellDistance(distance_grid[node]);
+                for (int n = 0; n < 26; ++n) {
+                    int nn = node + m_neighbor_offsets[n];
+                    if (distance_grid[nn] == UndiscoveredCell() &&
+                        __sync_bool_compare_and_swap(
+                                &distance_grid[nn], UndiscoveredCell(), cost))
+                    {
+                        next_cells.push_back(nn);
+                    }
+                }
+            }
+        };
+
+        auto chunk_count = (std::size_t)
+                ((level_end - level_begin + chunk_size - 1) / chunk_size);
+        if (chunk_count == 1) {
+            // not worth waking the pool for
+            expand_chunk(0, 0);
+        } else {
+            m_pool->run(chunk_count, expand_chunk);
+        }
+
+        queue_head = level_end;
+        for (auto& next_cells : m_next_cells) {
+            std::copy(begin(next_cells), end(next_cells), queue + queue_tail);
+            queue_tail += (int)next_cells.size();
+            next_cells.clear();
+        }
+    }
+    m_running = false;
+}
+
+template class BasicBFS_3D<int>;
+template class BasicBFS_3D<std::uint16_t>;
+template class BasicBFS_3D<std::uint8_t>;
+
 } // namespace smpl
@@ -0,0 +1,403 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+/// \author Andrew Dornbush
+
+#include <smpl/bfs3d/soft_bfs3d.h>
+
+// standard includes
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <utility>
+
+namespace smpl {
+
+const int SoftBFS_3D::WALL;
+const int SoftBFS_3D::UNDISCOVERED;
+const int SoftBFS_3D::MaxCellCost;
+const int SoftBFS_3D::Unreached;
+
+// Convert a cell cost, or WALL, to its stored value
+static
+std::uint8_t ToStoredCost(int cost)
+{
+    if (cost == SoftBFS_3D::WALL) {
+        return 0;
+    }
+    return (std::uint8_t)std::max(1, std::min(cost, SoftBFS_3D::MaxCellCost));
+}
+
+SoftBFS_3D::SoftBFS_3D(int length, int width, int height) :
+    m_dim_x(length + 2),
+    m_dim_y(width + 2),
+    m_dim_z(height + 2),
+    m_dim_xy(m_dim_x * m_dim_y),
+    m_dim_xyz(m_dim_xy * m_dim_z),
+    m_costs(m_dim_xyz, 1),
+    m_dist(m_dim_xyz, Unreached),
+    m_searched(false),
+    m_discovered(1)
+{
+    int n = 0;
+    for (int dz = -1; dz <= 1; ++dz) {
+    for (int dy = -1; dy <= 1; ++dy) {
+    for (int dx = -1; dx <= 1; ++dx) {
+        if (dx == 0 && dy == 0 && dz == 0) {
+            continue;
+        }
+        m_neighbor_offsets[n++] = dz * m_dim_xy + dy * m_dim_x + dx;
+    }
+    }
+    }
+
+    // surround the grid with walls so that expansions need no bounds checks
+    for (int z = 0; z < m_dim_z; ++z) {
+    for (int y = 0; y < m_dim_y; ++y) {
+    for (int x = 0; x < m_dim_x; ++x) {
+        if (x == 0 || x == m_dim_x - 1 ||
+            y == 0 || y == m_dim_y - 1 ||
+            z == 0 || z == m_dim_z - 1)
+        {
+            m_costs[z * m_dim_xy + y * m_dim_x + x] = 0;
+        }
+    }
+    }
+    }
+}
+
+void SoftBFS_3D::getDimensions(int* length, int* width, int* height) const
+{
+    *length = m_dim_x - 2;
+    *width = m_dim_y - 2;
+    *height = m_dim_z - 2;
+}
+
+void SoftBFS_3D::setThreadCount(int count)
+{
+    if (count > 1) {
+        m_pool.reset(new WorkerPool(count));
+    } else {
+        m_pool.reset();
+    }
+    m_discovered.resize(threadCount());
+}
+
+void SoftBFS_3D::setCellCost(int x, int y, int z, int cost)
+{
+    auto node = getNode(x, y, z);
+    if (node >= 0) {
+        m_costs[node] = ToStoredCost(cost);
+    }
+}
+
+int SoftBFS_3D::getCellCost(int x, int y, int z) const
+{
+    auto node = getNode(x, y, z);
+    if (node < 0 || m_costs[node] == 0) {
+        return WALL;
+    }
+    return m_costs[node];
+}
+
+bool SoftBFS_3D::isWall(int x, int y, int z) const
+{
+    return getCellCost(x, y, z) == WALL;
+}
+
+void SoftBFS_3D::run(int x, int y, int z)
+{
+    int xyz[3] = { x, y, z };
+    run(xyz, xyz + 3);
+}
+
+int SoftBFS_3D::getDistance(int x, int y, int z) const
+{
+    auto node = getNode(x, y, z);
+    if (node < 0) {
+        return WALL;
+    }
+    if (m_dist[node] != Unreached) {
+        return m_dist[node];
+    }
+    return m_costs[node] == 0 ? WALL : UNDISCOVERED;
+}
+
+auto SoftBFS_3D::memoryUsage() const -> std::size_t
+{
+    auto usage = m_costs.capacity() * sizeof(std::uint8_t);
+    usage += m_dist.capacity() * sizeof(int);
+    usage += m_start_nodes.capacity() * sizeof(int);
+    for (auto& discovered : m_discovered) {
+        usage += discovered.capacity() * sizeof(discovered[0]);
+    }
+    return usage;
+}
+
+// Start cells are at distance 0 even when they are walls, as in BFS_3D
+bool SoftBFS_3D::isStart(int node) const
+{
+    return std::binary_search(begin(m_start_nodes), end(m_start_nodes), node);
+}
+
+// Return whether a reached cell is a start cell or is reached from a neighbor
+// at its distance less its cost
+bool SoftBFS_3D::isSupported(int node) const
+{
+    if (isStart(node)) {
+        return true;
+    }
+    const int cost = m_costs[node];
+    if (cost == 0) {
+        return false;
+    }
+    const int d = m_dist[node];
+    for (int n = 0; n < 26; ++n) {
+        auto nd = m_dist[node + m_neighbor_offsets[n]];
+        if (nd != Unreached && nd + cost == d) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Return the distance of a free cell through its cheapest reached neighbor
+int SoftBFS_3D::bestNeighborDistance(int node) const
+{
+    const int cost = m_costs[node];
+    int best = Unreached;
+    for (int n = 0; n < 26; ++n) {
+        auto nd = m_dist[node + m_neighbor_offsets[n]];
+        if (nd != Unreached) {
+            best = std::min(best, nd + cost);
+        }
+    }
+    return best;
+}
+
+// Dijkstra's search with a bucket queue (Dial's algorithm). Every queued
+// distance lies within MaxCellCost of the distance being expanded, so a ring
+// of MaxCellCost + 1 buckets holds them all. The cells of a bucket are final
+// when it is reached, since every cell cost is positive, and are expanded in
+// parallel chunks. Cells are lowered with compare-and-swap and queued by the
+// thread that lowered them; entries for cells lowered again later are stale
+// and skipped.
+void SoftBFS_3D::search(const std::vector<int>& start_nodes)
+{
+    std::fill(begin(m_dist), end(m_dist), Unreached);
+
+    m_start_nodes = start_nodes;
+    std::sort(begin(m_start_nodes), end(m_start_nodes));
+    m_start_nodes.erase(
+            std::unique(begin(m_start_nodes), end(m_start_nodes)),
+            end(m_start_nodes));
+
+    const int bucket_count = MaxCellCost + 1;
+    std::vector<std::vector<int>> buckets(bucket_count);
+    std::size_t pending = 0;
+    for (auto node : m_start_nodes) {
+        m_dist[node] = 0;
+        buckets[0].push_back(node);
+        ++pending;
+    }
+
+    const std::size_t chunk_size = 1024;
+
+    std::vector<int> level;
+    for (int d = 0; pending > 0; ++d) {
+        auto& bucket = buckets[d % bucket_count];
+        if (bucket.empty()) {
+            continue;
+        }
+        pending -= bucket.size();
+        level.swap(bucket);
+        bucket.clear();
+
+        auto expand_chunk = [&](int tid, std::size_t chunk)
+        {
+            auto& discovered = m_discovered[tid];
+            auto first = chunk * chunk_size;
+            auto last = std::min(first + chunk_size, level.size());
+            for (auto i = first; i != last; ++i) {
+                int node = level[i];
+                if (m_dist[node] != d) {
+                    continue; // stale entry
+                }
+                for (int n = 0; n < 26; ++n) {
+                    int nn = node + m_neighbor_offsets[n];
+                    int cost = m_costs[nn];
+                    if (cost == 0) {
+                        continue;
+                    }
+                    int nd = d + cost;
+                    int old = __atomic_load_n(&m_dist[nn], __ATOMIC_RELAXED);
+                    while (nd < old) {
+                        if (__sync_bool_compare_and_swap(&m_dist[nn], old, nd)) {
+                            discovered.emplace_back(nn, nd);
+                            break;
+                        }
+                        old = __atomic_load_n(&m_dist[nn], __ATOMIC_RELAXED);
+                    }
+                }
+            }
+        };
+
+        auto chunk_count = (level.size() + chunk_size - 1) / chunk_size;
+        if (chunk_count == 1 || !m_pool) {
+            for (std::size_t chunk = 0; chunk < chunk_count; ++chunk) {
+                expand_chunk(0, chunk);
+            }
+        } else {
+            m_pool->run(chunk_count, expand_chunk);
+        }
+
+        for (auto& discovered : m_discovered) {
+            for (auto& entry : discovered) {
+                buckets[entry.second % bucket_count].push_back(entry.first);
+            }
+            pending += discovered.size();
+            discovered.clear();
+        }
+    }
+
+    m_searched = true;
+}
+
+void SoftBFS_3D::updateCellCosts(
+    const std::vector<int>& cells,
+    const std::vector<int>& costs)
+{
+    if (!m_searched) {
+        for (size_t i = 0; i + 2 < cells.size() && i / 3 < costs.size(); i += 3) {
+            setCellCost(cells[i], cells[i + 1], cells[i + 2], costs[i / 3]);
+        }
+        return;
+    }
+
+    // (distance, node) entries, expanded in order of increasing distance
+    using QueueEntry = std::pair<int, int>;
+    using Queue = std::priority_queue<
+            QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>>;
+
+    // cells that lost their distance or became cheaper, which seed the repair
+    std::vector<int> reseed;
+
+    // apply the new costs and queue up the reached cells that became more
+    // expensive, whose distances may have increased
+    Queue check;
+    for (size_t i = 0; i + 2 < cells.size() && i / 3 < costs.size(); i += 3) {
+        auto node = getNode(cells[i], cells[i + 1], cells[i + 2]);
+        if (node < 0) {
+            continue;
+        }
+        auto old_cost = m_costs[node];
+        auto new_cost = ToStoredCost(costs[i / 3]);
+        if (new_cost == old_cost) {
+            continue;
+        }
+        m_costs[node] = new_cost;
+
+        auto more_expensive = new_cost == 0 || (old_cost != 0 && new_cost > old_cost);
+        if (!more_expensive) {
+            reseed.push_back(node);
+        } else if (m_dist[node] != Unreached) {
+            check.push(QueueEntry(m_dist[node], node));
+        }
+    }
+
+    // clear the distances of cells no longer supported by a neighbor. Cells
+    // are checked in order of increasing distance, so all of a cell's
+    // potential supporters have been settled by the time it is checked.
+    while (!check.empty()) {
+        QueueEntry e = check.top();
+        check.pop();
+        int d = e.first;
+        int node = e.second;
+        if (m_dist[node] != d) {
+            continue; // cleared or checked already
+        }
+
+        if (isSupported(node)) {
+            continue;
+        }
+
+        m_dist[node] = Unreached;
+        reseed.push_back(node);
+        for (int n = 0; n < 26; ++n) {
+            int nn = node + m_neighbor_offsets[n];
+            if (m_dist[nn] != Unreached && m_dist[nn] > d) {
+                check.push(QueueEntry(m_dist[nn], nn));
+            }
+        }
+    }
+
+    // give the reseeded cells their distances through their reached
+    // neighbors and propagate, lowering the distances of cells that are now
+    // closer
+    Queue open;
+    for (int node : reseed) {
+        int d;
+        if (isStart(node)) {
+            d = 0;
+        } else if (m_costs[node] == 0) {
+            continue;
+        } else {
+            d = bestNeighborDistance(node);
+        }
+        if (d < m_dist[node]) {
+            m_dist[node] = d;
+            open.push(QueueEntry(d, node));
+        }
+    }
+
+    while (!open.empty()) {
+        QueueEntry e = open.top();
+        open.pop();
+        int d = e.first;
+        int node = e.second;
+        if (m_dist[node] != d) {
+            continue; // stale entry
+        }
+
+        for (int n = 0; n < 26; ++n) {
+            int nn = node + m_neighbor_offsets[n];
+            int cost = m_costs[nn];
+            if (cost == 0) {
+                continue;
+            }
+            int nd = d + cost;
+            if (nd < m_dist[nn]) {
+                m_dist[nn] = nd;
+                open.push(QueueEntry(nd, nn));
+            }
+        }
+    }
+}
+
+} // namespace smpl
@@ -42,10 +42,42 @@ CollisionChecker::~CollisionChecker()
 {
 }
 
+bool CollisionChecker::isStateValid(RobotStateView state, bool verbose)
+{
+    return isStateValid(RobotState(state.begin(), state.end()), verbose);
+}
+
+bool CollisionChecker::areStatesValid(
+    const RobotState* states,
+    size_t n,
+    bool* out)
+{
+    auto all_valid = true;
+    for (size_t i = 0; i < n; ++i) {
+        auto valid = isStateValid(states[i], false);
+        if (out != nullptr) {
+            out[i] = valid;
+        } else if (!valid) {
+            return false;
+        }
+        all_valid &= valid;
+    }
+    return all_valid;
+}
+
 auto CollisionChecker::getCollisionModelVisualization(const RobotState& state)
     -> std::vector<visual::Marker>
 {
     return { };
 }
 
+bool CollisionDistanceExtension::collisionCostGradient(
+    const RobotState& state,
+    double clearance,
+    double& cost,
+    std::vector<double>& gradient)
+{
+    return false;
+}
+
 } // namespace smpl
@@ -1,275 +1,783 @@
-#include <smpl/console/detail/console_std.h>
-
-// standard includes
-#include <stdarg.h>
-#include <string.h>
-#include <iostream>
-#include <mutex>
-#include <unordered_map>
-
-#include <boost/program_options.hpp>
-
-// project includes
-#include <smpl/console/ansi.h>
-#include <smpl/console/nonstd.h>
-
-namespace smpl {
-namespace console {
-
-bool g_initialized = false;
-
-static bool g_unbuffered = false;
-static bool g_colored = false;
-static bool g_show_locations = false;
-
-static std::mutex g_init_mutex;
-static std::mutex g_locations_mutex;
-
-// map (fully-qualified logger name) -> (logger)
-static std::unordered_map<std::string, Logger> g_loggers;
-
-Logger* GetLogger(const std::string& name)
-{
-    auto lit = g_loggers.find(name);
-    if (lit == end(g_loggers)) {
-        bool inserted;
-        std::tie(lit, inserted) = g_loggers.insert(std::make_pair(name, Logger()));
-
-        // find or create the parent logger
-        Logger* parent;
-        std::string::size_type pos = name.size();
-        auto dotpos = name.find_last_of('.', pos);
-        if (dotpos == std::string::npos) {
-            parent = &g_loggers[""];
-        } else {
-            parent = GetLogger(name.substr(0, dotpos));
-        }
-
-        lit->second.parent = parent;
-        lit->second.level = parent->level;
-    }
-
-    return &lit->second;
-}
-
-void initialize()
-{
-    std::unique_lock<std::mutex> lock(g_init_mutex);
-
-    if (g_initialized) {
-        return;
-    }
-
-    // create the root logger
-    g_loggers[""] = Logger{ nullptr, LEVEL_INFO };
-
-    const char* config_filepath = getenv("SMPL_CONSOLE_CONFIG_FILE");
-    if (!config_filepath) {
-        g_initialized = true;
-        return;
-    }
-
-    // parse the config file
-    namespace po = boost::program_options;
-
-    po::options_description ops;
-    ops.add_options()
-            ("format.unbuffered", po::value<bool>(&g_unbuffered)->default_value(false))
-            ("format.colored", po::value<bool>(&g_colored)->default_value(false))
-            ("format.show_locations", po::value<bool>(&g_show_locations)->default_value(false))
-            ;
-
-    bool allow_unregistered = true;
-    auto pops = po::parse_config_file<char>(
-            config_filepath, ops, allow_unregistered);
-
-    po::variables_map vm;
-    po::store(pops, vm);
-    po::notify(vm);
-
-    for (auto& op : pops.options) {
-        if (op.unregistered) {
-            auto& levelstr = op.value.back();
-            Level level = LEVEL_COUNT;
-            if (levelstr == "INFO") {
-                level = LEVEL_INFO;
-            } else if (levelstr == "DEBUG") {
-                level = LEVEL_DEBUG;
-            } else if (levelstr == "WARN") {
-                level = LEVEL_WARN;
-            } else if (levelstr == "ERROR") {
-                level = LEVEL_ERROR;
-            } else if (levelstr == "FATAL") {
-                level = LEVEL_FATAL;
-            }
-
-            if (level != LEVEL_COUNT) { // format correct
-                Logger* logger = GetLogger(op.string_key);
-                logger->level = level;
-            }
-        }
-    }
-
-    g_initialized = true;
-}
-
-void InitializeLogLocation(
-    LogLocation* loc,
-    const std::string& name,
-    Level level)
-{
-    std::unique_lock<std::mutex> lock(g_locations_mutex);
-
-    if (loc->initialized) {
-        return;
-    }
-
-    loc->logger = GetLogger(name);
-    loc->level = level;
-    loc->enabled = level >= loc->logger->level;
-    loc->initialized = true;
-}
-
-void print(Level level, const char* filename, int line, const char* fmt, ...)
-{
-    va_list args;
-    va_start(args, fmt);
-
-    FILE* f;
-    if (level >= LEVEL_ERROR) {
-        f = stderr;
-    } else {
-        f = stdout;
-    }
-
-    if (g_colored) {
-        switch (level) {
-        case LEVEL_DEBUG:
-            fprintf(f, "%s", codes::green);
-            break;
-        case LEVEL_INFO:
-            fprintf(f, "%s", codes::white);
-            break;
-        case LEVEL_WARN:
-            fprintf(f, "%s", codes::yellow);
-            break;
-        case LEVEL_ERROR:
-            fprintf(f, "%s", codes::red);
-            break;
-        case LEVEL_FATAL:
-            fprintf(f, "%s", codes::red);
-            break;
-        default:
-            break;
-        }
-    }
-
-    switch (level) {
-    case LEVEL_DEBUG:
-        fprintf(f, "[DEBUG] ");
-        break;
-    case LEVEL_INFO:
-        fprintf(f, "[INFO]  ");
-        break;
-    case LEVEL_WARN:
-        fprintf(f, "[WARN]  ");
-        break;
-    case LEVEL_ERROR:
-        fprintf(f, "[ERROR] ");
-        break;
-    case LEVEL_FATAL:
-        fprintf(f, "[FATAL] ");
-        break;
-    default:
-        break;
-    }
-
-    vfprintf(f, fmt, args);
-
-    // print file and line
-    if (g_show_locations) {
-        const char* base = strrchr(filename, '\\');
-        if (base) {
-            fprintf(f, " [%s:%d]", base + 1, line);
-        } else {
-            fprintf(f, " [%s:%d]", filename, line);
-        }
-    }
-
-    if (g_colored) {
-        fprintf(f, "%s", codes::reset);
-    }
-
-    fprintf(f, "\n");
-
-    if (g_unbuffered) {
-        fflush(f);
-    }
-
-    va_end(args);
-}
-
-void print(Level level, const char* filename, int line, const std::stringstream& ss)
-{
-    auto& o = (level >= LEVEL_ERROR) ? std::cerr : std::cout;
-
-    if (g_colored) {
-        switch (level) {
-        case LEVEL_DEBUG:
-            o << green;
-            break;
-        case LEVEL_INFO:
-            o << white;
-            break;
-        case LEVEL_WARN:
-            o << yellow;
-            break;
-        case LEVEL_ERROR:
-            o << red;
-            break;
-        case LEVEL_FATAL:
-            o << red;
-            break;
-        default:
-            break;
-        }
-    }
-
-    switch (level) {
-    case LEVEL_DEBUG:
-        o << "[DEBUG] ";
-        break;
-    case LEVEL_INFO:
-        o << "[INFO]  ";
-        break;
-    case LEVEL_WARN:
-        o << "[WARN]  ";
-        break;
-    case LEVEL_ERROR:
-        o << "[ERROR] ";
-        break;
-    case LEVEL_FATAL:
-        o << "[FATAL] ";
-        break;
-    default:
-        break;
-    }
-
-    o << ss.str();
-
-    if (g_show_locations) {
-        o << " [" << filename << ':' << line << ']';
-    }
-
-    if (g_colored) {
-        o << reset;
-    }
-
-    o << '\n';
-    if (g_unbuffered) {
-        o << std::flush;
-    }
-}
-
-} // namespace console
-} // namespace smpl
+#include <smpl/console/detail/console_std.h>
+
+// standard includes
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include <boost/program_options.hpp>
+
+// project includes
+#include <smpl/console/ansi.h>
+#include <smpl/console/nonstd.h>
+
+namespace smpl {
+namespace console {
+
+bool g_initialized = false;
+
+static bool g_unbuffered = false;
+static bool g_colored = false;
+static bool g_show_locations = false;
+
+static std::mutex g_init_mutex;
+static std::mutex g_locations_mutex;
+
+static void PrintPrefix(FILE* f, Level level);
+static void PrintSuffix(FILE* f, const char* filename, int line);
+
+// map (fully-qualified logger name) -> (logger)
+static std::unordered_map<std::string, Logger> g_loggers;
+
+Logger* GetLogger(const std::string& name)
+{
+    auto lit = g_loggers.find(name);
+    if (lit == end(g_loggers)) {
+        bool inserted;
+        std::tie(lit, inserted) = g_loggers.insert(std::make_pair(name, Logger()));
+
+        // find or create the parent logger
+        Logger* parent;
+        std::string::size_type pos = name.size();
+        auto dotpos = name.find_last_of('.', pos);
+        if (dotpos == std::string::npos) {
+            parent = &g_loggers[""];
+        } else {
+            parent = GetLogger(name.substr(0, dotpos));
+        }
+
+        lit->second.parent = parent;
+        lit->second.level = parent->level;
+    }
+
+    return &lit->second;
+}
+
+void initialize()
+{
+    std::unique_lock<std::mutex> lock(g_init_mutex);
+
+    if (g_initialized) {
+        return;
+    }
+
+    // create the root logger
+    g_loggers[""] = Logger{ nullptr, LEVEL_INFO };
+
+    const char* config_filepath = getenv("SMPL_CONSOLE_CONFIG_FILE");
+    if (!config_filepath) {
+        g_initialized = true;
+        return;
+    }
+
+    // parse the config file
+    namespace po = boost::program_options;
+
+    bool async;
+    po::options_description ops;
+    ops.add_options()
+            ("format.unbuffered", po::value<bool>(&g_unbuffered)->default_value(false))
+            ("format.colored", po::value<bool>(&g_colored)->default_value(false))
+            ("format.show_locations", po::value<bool>(&g_show_locations)->default_value(false))
+            ("format.async", po::value<bool>(&async)->default_value(false))
+            ;
+
+    bool allow_unregistered = true;
+    auto pops = po::parse_config_file<char>(
+            config_filepath, ops, allow_unregistered);
+
+    po::variables_map vm;
+    po::store(pops, vm);
+    po::notify(vm);
+
+    for (auto& op : pops.options) {
+        if (op.unregistered) {
+            auto& levelstr = op.value.back();
+            Level level = LEVEL_COUNT;
+            if (levelstr == "INFO") {
+                level = LEVEL_INFO;
+            } else if (levelstr == "DEBUG") {
+                level = LEVEL_DEBUG;
+            } else if (levelstr == "WARN") {
+                level = LEVEL_WARN;
+            } else if (levelstr == "ERROR") {
+                level = LEVEL_ERROR;
+            } else if (levelstr == "FATAL") {
+                level = LEVEL_FATAL;
+            }
+
+            if (level != LEVEL_COUNT) { // format correct
+                Logger* logger = GetLogger(op.string_key);
+                logger->level = level;
+            }
+        }
+    }
+
+    if (async) {
+        set_async(true);
+    }
+
+    g_initialized = true;
+}
+
+void InitializeLogLocation(
+    LogLocation* loc,
+    const std::string& name,
+    Level level)
+{
+    std::unique_lock<std::mutex> lock(g_locations_mutex);
+
+    if (loc->initialized) {
+        return;
+    }
+
+    loc->logger = GetLogger(name);
+    loc->level = level;
+    loc->enabled = level >= loc->logger->level;
+    loc->initialized = true;
+}
+
+static
+void PrintPrefix(FILE* f, Level level)
+{
+    if (g_colored) {
+        switch (level) {
+        case LEVEL_DEBUG:
+            fprintf(f, "%s", codes::green);
+            break;
+        case LEVEL_INFO:
+            fprintf(f, "%s", codes::white);
+            break;
+        case LEVEL_WARN:
+            fprintf(f, "%s", codes::yellow);
+            break;
+        case LEVEL_ERROR:
+            fprintf(f, "%s", codes::red);
+            break;
+        case LEVEL_FATAL:
+            fprintf(f, "%s", codes::red);
+            break;
+        default:
+            break;
+        }
+    }
+
+    switch (level) {
+    case LEVEL_DEBUG:
+        fprintf(f, "[DEBUG] ");
+        break;
+    case LEVEL_INFO:
+        fprintf(f, "[INFO]  ");
+        break;
+    case LEVEL_WARN:
+        fprintf(f, "[WARN]  ");
+        break;
+    case LEVEL_ERROR:
+        fprintf(f, "[ERROR] ");
+        break;
+    case LEVEL_FATAL:
+        fprintf(f, "[FATAL] ");
+        break;
+    default:
+        break;
+    }
+}
+
+static
+void PrintSuffix(FILE* f, const char* filename, int line)
+{
+    // print file and line
+    if (g_show_locations) {
+        const char* base = strrchr(filename, '\\');
+        if (base) {
+            fprintf(f, " [%s:%d]", base + 1, line);
+        } else {
+            fprintf(f, " [%s:%d]", filename, line);
+        }
+    }
+
+    if (g_colored) {
+        fprintf(f, "%s", codes::reset);
+    }
+
+    fprintf(f, "\n");
+
+    if (g_unbuffered) {
+        fflush(f);
+    }
+}
+
+void print(Level level, const char* filename, int line, const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+
+    FILE* f;
+    if (level >= LEVEL_ERROR) {
+        flush();
+        f = stderr;
+    } else {
+        f = stdout;
+    }
+
+    PrintPrefix(f, level);
+    vfprintf(f, fmt, args);
+    PrintSuffix(f, filename, line);
+
+    va_end(args);
+}
+
+void print(Level level, const char* filename, int line, const std::stringstream& ss)
+{
+    if (level < LEVEL_ERROR && detail::g_async.load(std::memory_order_relaxed)) {
+        // the message is already formatted; only the I/O is deferred
+        detail::LogRecordBuilder record(level, filename, line, "%s");
+        record.arg(ss.str().c_str());
+        record.commit();
+        return;
+    }
+
+    if (level >= LEVEL_ERROR) {
+        flush();
+    }
+
+    auto& o = (level >= LEVEL_ERROR) ? std::cerr : std::cout;
+
+    if (g_colored) {
+        switch (level) {
+        case LEVEL_DEBUG:
+            o << green;
+            break;
+        case LEVEL_INFO:
+            o << white;
+            break;
+        case LEVEL_WARN:
+            o << yellow;
+            break;
+        case LEVEL_ERROR:
+            o << red;
+            break;
+        case LEVEL_FATAL:
+            o << red;
+            break;
+        default:
+            break;
+        }
+    }
+
+    switch (level) {
+    case LEVEL_DEBUG:
+        o << "[DEBUG] ";
+        break;
+    case LEVEL_INFO:
+        o << "[INFO]  ";
+        break;
+    case LEVEL_WARN:
+        o << "[WARN]  ";
+        break;
+    case LEVEL_ERROR:
+        o << "[ERROR] ";
+        break;
+    case LEVEL_FATAL:
+        o << "[FATAL] ";
+        break;
+    default:
+        break;
+    }
+
+    o << ss.str();
+
+    if (g_show_locations) {
+        o << " [" << filename << ':' << line << ']';
+    }
+
+    if (g_colored) {
+        o << reset;
+    }
+
+    o << '\n';
+    if (g_unbuffered) {
+        o << std::flush;
+    }
+}
+
+//////////////////////////
+// Asynchronous Logging //
+//////////////////////////
+
+namespace detail {
+
+std::atomic<bool> g_async(false);
+
+} // namespace detail
+
+// Single-producer, single-consumer ring of length-prefixed records. The
+// owning thread writes records; the writer thread reads them.
+struct LogRing
+{
+    std::unique_ptr<char[]> data;
+    std::size_t size; // power of two
+
+    std::atomic<std::size_t> head; // read position
+    std::atomic<std::size_t> tail; // write position
+
+    // records discarded because the ring was full
+    std::atomic<std::size_t> dropped;
+
+    explicit LogRing(std::size_t size) :
+        data(new char[size]),
+        size(size),
+        head(0),
+        tail(0),
+        dropped(0)
+    { }
+
+    void copyIn(std::size_t pos, const char* src, std::size_t n)
+    {
+        auto off = pos & (size - 1);
+        auto first = std::min(n, size - off);
+        memcpy(data.get() + off, src, first);
+        memcpy(data.get(), src + first, n - first);
+    }
+
+    void copyOut(std::size_t pos, char* dst, std::size_t n) const
+    {
+        auto off = pos & (size - 1);
+        auto first = std::min(n, size - off);
+        memcpy(dst, data.get() + off, first);
+        memcpy(dst + first, data.get(), n - first);
+    }
+
+    bool push(const char* record, std::uint32_t n)
+    {
+        auto h = head.load(std::memory_order_acquire);
+        auto t = tail.load(std::memory_order_relaxed);
+        if (size - (t - h) < sizeof(n) + n) {
+            dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+        copyIn(t, (const char*)&n, sizeof(n));
+        copyIn(t + sizeof(n), record, n);
+        tail.store(t + sizeof(n) + n, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(std::vector<char>& record)
+    {
+        auto t = tail.load(std::memory_order_acquire);
+        auto h = head.load(std::memory_order_relaxed);
+        if (h == t) {
+            return false;
+        }
+        std::uint32_t n;
+        copyOut(h, (char*)&n, sizeof(n));
+        record.resize(n);
+        copyOut(h + sizeof(n), record.data(), n);
+        head.store(h + sizeof(n) + n, std::memory_order_release);
+        return true;
+    }
+};
+
+struct AsyncLogger
+{
+    std::mutex rings_mutex;
+    std::vector<std::unique_ptr<LogRing>> rings;
+    std::size_t ring_size = 1 << 20;
+
+    // serializes draining between the writer thread and flush()
+    std::mutex drain_mutex;
+    std::vector<char> record;
+    std::string message;
+
+    bool started = false;
+    std::atomic<bool> stop;
+
+    AsyncLogger() : stop(false) { }
+};
+
+// Never destroyed, since the writer thread may outlive static destruction
+static
+auto GetAsyncLogger() -> AsyncLogger&
+{
+    static auto* logger = new AsyncLogger;
+    return *logger;
+}
+
+static thread_local LogRing* g_thread_ring = nullptr;
+static thread_local std::vector<char> g_record_buffer;
+
+static
+auto ThreadLogRing() -> LogRing*
+{
+    if (g_thread_ring == nullptr) {
+        auto& logger = GetAsyncLogger();
+        std::unique_lock<std::mutex> lock(logger.rings_mutex);
+        logger.rings.emplace_back(new LogRing(logger.ring_size));
+        g_thread_ring = logger.rings.back().get();
+    }
+    return g_thread_ring;
+}
+
+detail::LogRecordBuilder::LogRecordBuilder(
+    Level level,
+    const char* filename,
+    int line,
+    const char* fmt)
+:
+    m_buf(g_record_buffer)
+{
+    m_buf.clear();
+    m_buf.push_back((char)level);
+    put(filename);
+    put(line);
+    putString(fmt);
+}
+
+void detail::LogRecordBuilder::putString(const char* s)
+{
+    if (s == nullptr) {
+        s = "(null)";
+    }
+    std::uint32_t n = strlen(s);
+    put(n);
+    m_buf.insert(m_buf.end(), s, s + n);
+}
+
+void detail::LogRecordBuilder::commit()
+{
+    ThreadLogRing()->push(m_buf.data(), m_buf.size());
+}
+
+// Reads the arguments of a record in order. Arguments are converted to the
+// type required by their conversion specification, so that a mismatch
+// between the two is no worse than it would have been with printf.
+class LogArgReader
+{
+public:
+
+    LogArgReader(const char* p, const char* end) : m_p(p), m_end(end) { }
+
+    bool next()
+    {
+        if (m_p >= m_end) {
+            m_tag = '\0';
+            return false;
+        }
+        m_tag = *m_p++;
+        m_value = m_p;
+        switch (m_tag) {
+        case 'i':
+        case 'u':
+            m_p += sizeof(long long);
+            break;
+        case 'f':
+            m_p += sizeof(double);
+            break;
+        case 'F':
+            m_p += sizeof(long double);
+            break;
+        case 'p':
+            m_p += sizeof(const void*);
+            break;
+        case 's': {
+            std::uint32_t n;
+            memcpy(&n, m_p, sizeof(n));
+            m_string.assign(m_p + sizeof(n), n);
+            m_p += sizeof(n) + n;
+            break;
+        }
+        default:
+            break;
+        }
+        return true;
+    }
+
+    template <class T>
+    T get() const
+    {
+        switch (m_tag) {
+        case 'i':   return (T)load<long long>();
+        case 'u':   return (T)load<unsigned long long>();
+        case 'f':   return (T)load<double>();
+        case 'F':   return (T)load<long double>();
+        case 'p':   return (T)(std::uintptr_t)load<const void*>();
+        default:    return T(0);
+        }
+    }
+
+    auto pointer() const -> const void*
+    {
+        return m_tag == 'p' ? load<const void*>() : nullptr;
+    }
+
+    auto string() const -> const char*
+    {
+        return m_tag == 's' ? m_string.c_str() : "<?>";
+    }
+
+private:
+
+    const char* m_p;
+    const char* m_end;
+    char m_tag = '\0';
+    const char* m_value = nullptr;
+    std::string m_string;
+
+    template <class T>
+    T load() const
+    {
+        T v;
+        memcpy(&v, m_value, sizeof(v));
+        return v;
+    }
+};
+
+template <class T>
+static
+void AppendFormatted(std::string& out, const std::string& spec, T value)
+{
+    char buf[256];
+    auto n = snprintf(buf, sizeof(buf), spec.c_str(), value);
+    if (n < 0) {
+        return;
+    }
+    if ((std::size_t)n < sizeof(buf)) {
+        out.append(buf, n);
+    } else {
+        auto pos = out.size();
+        out.resize(pos + n + 1);
+        snprintf(&out[pos], n + 1, spec.c_str(), value);
+        out.resize(pos + n);
+    }
+}
+
+// Format a message from its format string and arguments, one conversion
+// specification at a time
+static
+void FormatRecord(const char* fmt, LogArgReader& args, std::string& out)
+{
+    out.clear();
+    std::string spec;
+    for (auto* p = fmt; *p != '\0'; ) {
+        if (*p != '%') {
+            out.push_back(*p++);
+            continue;
+        }
+        ++p;
+        if (*p == '%') {
+            out.push_back(*p++);
+            continue;
+        }
+
+        spec = "%";
+        while (*p != '\0' && strchr("-+ #0", *p) != nullptr) {
+            spec.push_back(*p++);
+        }
+        if (*p == '*') {
+            args.next();
+            spec += std::to_string(args.get<int>());
+            ++p;
+        }
+        while (*p >= '0' && *p <= '9') {
+            spec.push_back(*p++);
+        }
+        if (*p == '.') {
+            spec.push_back(*p++);
+            if (*p == '*') {
+                args.next();
+                spec += std::to_string(args.get<int>());
+                ++p;
+            }
+            while (*p >= '0' && *p <= '9') {
+                spec.push_back(*p++);
+            }
+        }
+
+        auto long_double = false;
+        while (*p != '\0' && strchr("hlLqjzt", *p) != nullptr) {
+            long_double |= (*p == 'L');
+            ++p;
+        }
+
+        auto conv = *p;
+        if (conv == '\0') {
+            break;
+        }
+        ++p;
+
+        args.next();
+        switch (conv) {
+        case 'd':
+        case 'i':
+            spec += "ll";
+            spec.push_back(conv);
+            AppendFormatted(out, spec, args.get<long long>());
+            break;
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            spec += "ll";
+            spec.push_back(conv);
+            AppendFormatted(out, spec, args.get<unsigned long long>());
+            break;
+        case 'c':
+            spec.push_back(conv);
+            AppendFormatted(out, spec, args.get<int>());
+            break;
+        case 'e':
+        case 'E':
+        case 'f':
+        case 'F':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            if (long_double) {
+                spec.push_back('L');
+                spec.push_back(conv);
+                AppendFormatted(out, spec, args.get<long double>());
+            } else {
+                spec.push_back(conv);
+                AppendFormatted(out, spec, args.get<double>());
+            }
+            break;
+        case 's':
+            spec.push_back(conv);
+            AppendFormatted(out, spec, args.string());
+            break;
+        case 'p':
+            spec.push_back(conv);
+            AppendFormatted(out, spec, args.pointer());
+            break;
+        case 'n':
+            break;
+        default:
+            out.push_back('%');
+            out.push_back(conv);
+            break;
+        }
+    }
+}
+
+static
+void WriteRecord(AsyncLogger& logger)
+{
+    auto& record = logger.record;
+    auto* p = record.data();
+    auto* end = record.data() + record.size();
+
+    auto level = (Level)*p++;
+    const char* filename;
+    memcpy(&filename, p, sizeof(filename));
+    p += sizeof(filename);
+    int line;
+    memcpy(&line, p, sizeof(line));
+    p += sizeof(line);
+    std::uint32_t fmt_len;
+    memcpy(&fmt_len, p, sizeof(fmt_len));
+    p += sizeof(fmt_len);
+    std::string fmt(p, fmt_len);
+    p += fmt_len;
+
+    LogArgReader args(p, end);
+    FormatRecord(fmt.c_str(), args, logger.message);
+
+    PrintPrefix(stdout, level);
+    fputs(logger.message.c_str(), stdout);
+    PrintSuffix(stdout, filename, line);
+}
+
+// Write all records queued so far. Returns whether any were written.
+static
+bool DrainRings(AsyncLogger& logger)
+{
+    std::unique_lock<std::mutex> drain_lock(logger.drain_mutex);
+
+    std::vector<LogRing*> rings;
+    {
+        std::unique_lock<std::mutex> lock(logger.rings_mutex);
+        for (auto& ring : logger.rings) {
+            rings.push_back(ring.get());
+        }
+    }
+
+    auto written = false;
+    for (auto* ring : rings) {
+        while (ring->pop(logger.record)) {
+            WriteRecord(logger);
+            written = true;
+        }
+        auto dropped = ring->dropped.exchange(0, std::memory_order_relaxed);
+        if (dropped != 0) {
+            PrintPrefix(stdout, LEVEL_WARN);
+            fprintf(stdout, "%zu log messages dropped from a full queue", dropped);
+            PrintSuffix(stdout, __FILE__, __LINE__);
+            written = true;
+        }
+    }
+
+    if (written) {
+        fflush(stdout);
+    }
+    return written;
+}
+
+static
+void FlushAtExit()
+{
+    auto& logger = GetAsyncLogger();
+    logger.stop = true;
+    DrainRings(logger);
+}
+
+void set_async(bool enabled, std::size_t ring_size)
+{
+    auto& logger = GetAsyncLogger();
+    if (!enabled) {
+        detail::g_async = false;
+        flush();
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(logger.rings_mutex);
+        // rounded up to a power of two; applies to threads that have not
+        // yet logged asynchronously
+        logger.ring_size = 64;
+        while (logger.ring_size < ring_size) {
+            logger.ring_size <<= 1;
+        }
+
+        if (!logger.started) {
+            logger.started = true;
+            std::thread([&logger]()
+            {
+                while (!logger.stop) {
+                    if (!DrainRings(logger)) {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    }
+                }
+            }).detach();
+            atexit(FlushAtExit);
+        }
+    }
+
+    detail::g_async = true;
+}
+
+void flush()
+{
+    DrainRings(GetAsyncLogger());
+}
+
+} // namespace console
+} // namespace smpl
@@ -32,8 +32,17 @@
 #include <smpl/csv_parser.h>
 
 // standard includes
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <stdexcept>
 
+// system includes
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #define CSV_DEBUG 0
 #if CSV_DEBUG
 #include <smpl/console/console.h>
@@ -47,8 +56,10 @@ namespace smpl {
 bool CSVParser::parseStream(std::istream& s, bool has_header)
 {
     m_has_header = has_header;
+    m_numeric = false;
 
     m_fields.clear();
+    m_values.clear();
 
     size_t fields_per_record = 0;
 
@@ -115,6 +126,316 @@ const std::string& CSVParser::fieldAt(size_t ri, size_t fi) const
     return m_fields[(ri + 1) * m_field_count + fi];
 }
 
+// Powers of ten that are exactly representable as doubles
+static const double kExactPow10[] =
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+static bool IsBlank(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+// Convert the number in [begin, end) with strtod, which needs a terminated
+// string. Return false unless the whole range is consumed.
+static bool ParseDoubleSlow(const char* begin, const char* end, double& value)
+{
+    char buf[64];
+    std::string long_buf;
+    const char* str;
+    size_t len = end - begin;
+    if (len < sizeof(buf)) {
+        std::memcpy(buf, begin, len);
+        buf[len] = '\0';
+        str = buf;
+    } else {
+        long_buf.assign(begin, end);
+        str = long_buf.c_str();
+    }
+
+    char* str_end;
+    value = std::strtod(str, &str_end);
+    return len != 0 && str_end == str + len;
+}
+
+// Convert the number in [begin, end), in the manner of std::from_chars.
+// Decimal numbers with at most 19 significant digits, a significand below
+// 2^53, and a decimal exponent of magnitude at most 22 are converted exactly
+// with a single multiplication or division. Everything else, including
+// "inf" and "nan", goes through strtod.
+static bool ParseDouble(const char* begin, const char* end, double& value)
+{
+    const char* p = begin;
+    bool negative = false;
+    if (p != end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        ++p;
+    }
+
+    std::uint64_t significand = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool any_digits = false;
+
+    // skip leading zeros so they don't count as significant digits
+    while (p != end && *p == '0') {
+        any_digits = true;
+        ++p;
+    }
+    while (p != end && *p >= '0' && *p <= '9') {
+        if (digits < 19) {
+            significand = 10 * significand + (*p - '0');
+        } else {
+            ++exponent;
+        }
+        ++digits;
+        any_digits = true;
+        ++p;
+    }
+    if (p != end && *p == '.') {
+        ++p;
+        if (digits == 0) {
+            while (p != end && *p == '0') {
+                any_digits = true;
+                --exponent;
+                ++p;
+            }
+        }
+        while (p != end && *p >= '0' && *p <= '9') {
+            if (digits < 19) {
+                significand = 10 * significand + (*p - '0');
+                --exponent;
+            }
+            ++digits;
+            any_digits = true;
+            ++p;
+        }
+    }
+
+    if (!any_digits) {
+        return ParseDoubleSlow(begin, end, value);
+    }
+
+    if (p != end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        bool negative_exp = false;
+        if (p != end && (*p == '-' || *p == '+')) {
+            negative_exp = *p == '-';
+            ++p;
+        }
+        if (p == end || *p < '0' || *p > '9') {
+            return ParseDoubleSlow(begin, end, value);
+        }
+        int e = 0;
+        while (p != end && *p >= '0' && *p <= '9') {
+            if (e < 100000) {
+                e = 10 * e + (*p - '0');
+            }
+            ++p;
+        }
+        exponent += negative_exp ? -e : e;
+    }
+
+    if (p != end) {
+        return ParseDoubleSlow(begin, end, value);
+    }
+
+    if (digits > 19 ||
+        significand > (std::uint64_t(1) << 53) ||
+        exponent < -22 || exponent > 22)
+    {
+        return ParseDoubleSlow(begin, end, value);
+    }
+
+    double v = (double)significand;
+    if (exponent < 0) {
+        v /= kExactPow10[-exponent];
+    } else {
+        v *= kExactPow10[exponent];
+    }
+    value = negative ? -v : v;
+    return true;
+}
+
+// Split a header line into names. Names may be quoted, with "" standing for a
+// literal quote.
+static void ParseHeaderLine(
+    const char* begin,
+    const char* end,
+    std::vector<std::string>& names)
+{
+    const char* p = begin;
+    while (true) {
+        std::string name;
+        if (p != end && *p == '"') {
+            ++p;
+            while (p != end) {
+                if (*p == '"') {
+                    if (p + 1 != end && p[1] == '"') {
+                        name.push_back('"');
+                        p += 2;
+                        continue;
+                    }
+                    ++p;
+                    break;
+                }
+                name.push_back(*p++);
+            }
+        }
+        while (p != end && *p != ',') {
+            name.push_back(*p++);
+        }
+        names.push_back(std::move(name));
+        if (p == end) {
+            break;
+        }
+        ++p; // skip comma
+    }
+}
+
+// Parse the comma-separated numbers of one record onto the end of values.
+// Blanks around a number and quotes around a field are ignored.
+static bool ParseNumericRecord(
+    const char* begin,
+    const char* end,
+    std::vector<double>& values)
+{
+    const char* p = begin;
+    while (true) {
+        const char* field_end = static_cast<const char*>(
+                std::memchr(p, ',', end - p));
+        if (field_end == nullptr) {
+            field_end = end;
+        }
+
+        const char* fb = p;
+        const char* fe = field_end;
+        while (fb != fe && IsBlank(*fb)) ++fb;
+        while (fe != fb && IsBlank(fe[-1])) --fe;
+        if (fe - fb >= 2 && *fb == '"' && fe[-1] == '"') {
+            ++fb;
+            --fe;
+        }
+
+        double value;
+        if (!ParseDouble(fb, fe, value)) {
+            PRINT("Failed to parse numeric field '%s'", std::string(fb, fe).c_str());
+            return false;
+        }
+        values.push_back(value);
+
+        if (field_end == end) {
+            return true;
+        }
+        p = field_end + 1;
+    }
+}
+
+bool CSVParser::parseNumeric(const char* begin, const char* end, bool has_header)
+{
+    m_has_header = has_header;
+    m_numeric = true;
+    m_field_count = 0;
+
+    m_fields.clear();
+    m_values.clear();
+
+    const char* p = begin;
+    bool first = true;
+    while (p != end) {
+        const char* line_end = static_cast<const char*>(
+                std::memchr(p, '\n', end - p));
+        const char* next = line_end != nullptr ? line_end + 1 : end;
+        if (line_end == nullptr) {
+            line_end = end;
+        }
+        if (line_end != p && line_end[-1] == '\r') {
+            --line_end;
+        }
+
+        if (first && has_header) {
+            ParseHeaderLine(p, line_end, m_fields);
+            m_field_count = m_fields.size();
+            first = false;
+            p = next;
+            continue;
+        }
+
+        if (line_end == p) {
+            p = next;
+            continue;
+        }
+
+        size_t prev_num_values = m_values.size();
+        if (!ParseNumericRecord(p, line_end, m_values)) {
+            m_values.resize(prev_num_values);
+            return false;
+        }
+
+        if (first) {
+            m_field_count = m_values.size();
+            first = false;
+        } else if (m_values.size() != prev_num_values + m_field_count) {
+            PRINT("Record contains insufficient fields (expected: %zu, actual: %zu)", m_field_count, m_values.size() - prev_num_values);
+            m_values.resize(prev_num_values);
+        }
+
+        p = next;
+    }
+
+    if (has_header && first) {
+        PRINT("Failed to parse header");
+        return false;
+    }
+
+    return true;
+}
+
+bool CSVParser::parseNumericFile(const std::string& path, bool has_header)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        PRINT("Failed to open '%s'", path.c_str());
+        return false;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    if (st.st_size == 0) {
+        ::close(fd);
+        return parseNumeric(nullptr, nullptr, has_header);
+    }
+
+    void* data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        PRINT("Failed to map '%s'", path.c_str());
+        return false;
+    }
+    ::madvise(data, st.st_size, MADV_SEQUENTIAL);
+
+    auto* begin = static_cast<const char*>(data);
+    bool res = parseNumeric(begin, begin + st.st_size, has_header);
+    ::munmap(data, st.st_size);
+    return res;
+}
+
+double CSVParser::valueAt(size_t ri, size_t fi) const
+{
+    if (!m_numeric || fi >= m_field_count ||
+        ri * m_field_count + fi >= m_values.size())
+    {
+        throw std::out_of_range("Invalid indices for numeric csv field");
+    }
+    return m_values[ri * m_field_count + fi];
+}
+
 bool CSVParser::parseRecord(
     std::istream& s,
     std::istream::pos_type& pos,
@@ -0,0 +1,207 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+
+#include <smpl/debug/async_visualizer.h>
+
+// standard includes
+#include <utility>
+
+namespace smpl {
+namespace visual {
+
+AsyncVisualizer::AsyncVisualizer(
+    VisualizerBase* target,
+    std::size_t queue_size,
+    DropPolicy policy,
+    double max_rate)
+:
+    m_target(target),
+    m_queue_size(queue_size),
+    m_policy(policy),
+    m_min_period(clock::duration::zero()),
+    m_publishing(false),
+    m_stop(false),
+    m_dropped(0)
+{
+    if (max_rate > 0.0) {
+        m_min_period = std::chrono::duration_cast<clock::duration>(
+                std::chrono::duration<double>(1.0 / max_rate));
+    }
+    m_thread = std::thread([this]() { run(); });
+}
+
+AsyncVisualizer::~AsyncVisualizer()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_queued.notify_one();
+    m_thread.join();
+}
+
+void AsyncVisualizer::visualize(Level level, const visual::Marker& marker)
+{
+    Batch batch;
+    batch.markers.push_back(marker);
+    push(level, std::move(batch));
+}
+
+void AsyncVisualizer::visualize(
+    Level level,
+    const std::vector<visual::Marker>& markers)
+{
+    Batch batch;
+    batch.markers = markers;
+    push(level, std::move(batch));
+}
+
+#ifdef SMPL_HAS_VISUALIZATION_MSGS
+void AsyncVisualizer::visualize(
+    Level level,
+    const visualization_msgs::Marker& marker)
+{
+    Batch batch;
+    batch.msgs.markers.push_back(marker);
+    push(level, std::move(batch));
+}
+
+void AsyncVisualizer::visualize(
+    Level level,
+    const visualization_msgs::MarkerArray& markers)
+{
+    Batch batch;
+    batch.msgs = markers;
+    push(level, std::move(batch));
+}
+#endif
+
+void AsyncVisualizer::flush()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [&]()
+    {
+        if (m_publishing) {
+            return false;
+        }
+        for (auto& queue : m_queues) {
+            if (!queue.empty()) {
+                return false;
+            }
+        }
+        return true;
+    });
+}
+
+auto AsyncVisualizer::dropped() const -> std::size_t
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_dropped;
+}
+
+void AsyncVisualizer::push(Level level, Batch&& batch)
+{
+    if (level < Level::Debug || level >= Level::NumLevels) {
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        auto& queue = m_queues[(int)level];
+        if (queue.size() >= m_queue_size) {
+            ++m_dropped;
+            if (m_policy == DropPolicy::DropNewest || queue.empty()) {
+                return;
+            }
+            queue.pop_front();
+        }
+        queue.push_back(std::move(batch));
+    }
+    m_queued.notify_one();
+}
+
+void AsyncVisualizer::run()
+{
+    auto last_publish = clock::time_point();
+    for (;;) {
+        Batch batch;
+        Level level;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_publishing = false;
+            m_idle.notify_all();
+
+            auto level_count = (int)Level::NumLevels;
+            auto highest = [&]()
+            {
+                for (int l = level_count - 1; l >= 0; --l) {
+                    if (!m_queues[l].empty()) {
+                        return l;
+                    }
+                }
+                return -1;
+            };
+
+            m_queued.wait(lock, [&]() { return m_stop || highest() >= 0; });
+
+            // drain the queues before stopping
+            auto l = highest();
+            if (l < 0) {
+                return;
+            }
+
+            if (!m_stop && m_min_period > clock::duration::zero()) {
+                // wait out the rate limit, letting the queues absorb and drop
+                // batches in the meantime
+                auto next_publish = last_publish + m_min_period;
+                m_queued.wait_until(lock, next_publish, [&]() { return m_stop; });
+                l = highest();
+            }
+
+            level = (Level)l;
+            batch = std::move(m_queues[l].front());
+            m_queues[l].pop_front();
+            m_publishing = true;
+        }
+
+        last_publish = clock::now();
+        if (!batch.markers.empty()) {
+            m_target->visualize(level, batch.markers);
+        }
+#ifdef SMPL_HAS_VISUALIZATION_MSGS
+        if (!batch.msgs.markers.empty()) {
+            m_target->visualize(level, batch.msgs);
+        }
+#endif
+    }
+}
+
+} // namespace visual
+} // namespace smpl
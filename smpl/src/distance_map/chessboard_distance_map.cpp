@@ -31,6 +31,9 @@
 
 #include <smpl/distance_map/chessboard_distance_map.h>
 
+// project includes
+#include <smpl/worker_pool.h>
+
 namespace smpl {
 
 ChessboardDistanceMap::ChessboardDistanceMap(
@@ -46,6 +49,32 @@ ChessboardDistanceMap::ChessboardDistanceMap(
 {
 }
 
+/// Add a set of obstacle points to the distance map. When the batch is large
+/// enough, the new obstacles are marked and all distances are recomputed with
+/// separable sweeps instead of being propagated incrementally from each new
+/// obstacle.
+void ChessboardDistanceMap::addPointsToMap(const std::vector<Vector3>& points)
+{
+    if (!preferFullTransform(points.size())) {
+        DistanceMap::addPointsToMap(points);
+        return;
+    }
+
+    for (const Vector3& p : points) {
+        int gx, gy, gz;
+        worldToGrid(p.x(), p.y(), p.z(), gx, gy, gz);
+        if (!isCellValid(gx, gy, gz)) {
+            continue;
+        }
+
+        Cell& c = m_cells(gx + 1, gy + 1, gz + 1);
+        c.dist_new = 0;
+        c.obs = &c;
+    }
+
+    computeFullTransform();
+}
+
 int ChessboardDistanceMap::distance(const Cell& n, const Cell& s)
 {
     int dx = n.x - s.x;
@@ -55,4 +84,115 @@ int ChessboardDistanceMap::distance(const Cell& n, const Cell& s)
     return dx * dx + dy * dy + dz * dz + s.dist_new;
 }
 
+// Incremental insertion touches up to (2 * dmax + 1)^3 cells per obstacle; once
+// that exceeds the size of the grid, a full transform does less work.
+bool ChessboardDistanceMap::preferFullTransform(std::size_t point_count) const
+{
+    const double w = 2.0 * m_dmax_int + 1.0;
+    return (double)point_count * w * w * w >= (double)m_cells.size();
+}
+
+// Recompute the distance to the nearest obstacle for every cell. Each step to
+// one of the 26 neighbors costs its squared length, which for unit steps is
+// also its L1 length, so the propagated distance is the L1 distance to the
+// nearest obstacle cell, capped at the maximum distance. That is computed
+// exactly by a forward and a backward sweep along each axis in turn, tracking
+// the nearest obstacle cell alongside the distance. The sweeps along x and y
+// advance over whole rows of z, so the inner loops run over contiguous cells,
+// and each sweep is split into independent slabs that run concurrently.
+//
+// The results are stored in dist_new and obs. Interior cells are rewritten
+// with dir = NO_UPDATE_DIR and cells beyond the maximum distance are reset to
+// the uninitialized state, the same as after propagate(). The border cells are
+// obstacles and are left untouched.
+void ChessboardDistanceMap::computeFullTransform()
+{
+    const int xs = m_cells.xsize();
+    const int ys = m_cells.ysize();
+    const int zs = m_cells.zsize();
+
+    // distances are capped at m_dmax_sqrd_int, so relaxation never overflows
+    // and never assigns an obstacle to a cell beyond the maximum distance
+    for (int x = 1; x < xs - 1; ++x) {
+    for (int y = 1; y < ys - 1; ++y) {
+    for (int z = 1; z < zs - 1; ++z) {
+        Cell& c = m_cells(x, y, z);
+        if (c.obs != &c) {
+            c.dist_new = m_dmax_sqrd_int;
+            c.obs = nullptr;
+        }
+    }
+    }
+    }
+
+    auto relax = [](Cell& c, const Cell& p) {
+        if (p.dist_new + 1 < c.dist_new) {
+            c.dist_new = p.dist_new + 1;
+            c.obs = p.obs;
+        }
+    };
+
+    // relax the row of cells starting at first from the row starting at prev
+    auto relax_row = [&](Cell* first, const Cell* prev) {
+        for (int z = 0; z < zs; ++z) {
+            relax(first[z], prev[z]);
+        }
+    };
+
+    WorkerPool pool(m_thread_count);
+
+    // sweeps along z; slabs of constant x
+    pool.run(xs, [&](int tid, std::size_t x) {
+        for (int y = 0; y < ys; ++y) {
+            Cell* line = &m_cells(x, y, 0);
+            for (int z = 1; z < zs; ++z) {
+                relax(line[z], line[z - 1]);
+            }
+            for (int z = zs - 2; z >= 0; --z) {
+                relax(line[z], line[z + 1]);
+            }
+        }
+    });
+
+    // sweeps along y; slabs of constant x
+    pool.run(xs, [&](int tid, std::size_t x) {
+        for (int y = 1; y < ys; ++y) {
+            relax_row(&m_cells(x, y, 0), &m_cells(x, y - 1, 0));
+        }
+        for (int y = ys - 2; y >= 0; --y) {
+            relax_row(&m_cells(x, y, 0), &m_cells(x, y + 1, 0));
+        }
+    });
+
+    // sweeps along x; slabs of constant y
+    pool.run(ys, [&](int tid, std::size_t y) {
+        for (int x = 1; x < xs; ++x) {
+            relax_row(&m_cells(x, y, 0), &m_cells(x - 1, y, 0));
+        }
+        for (int x = xs - 2; x >= 0; --x) {
+            relax_row(&m_cells(x, y, 0), &m_cells(x + 1, y, 0));
+        }
+    });
+
+    pool.run(xs - 2, [&](int tid, std::size_t i) {
+        const int x = (int)i + 1;
+        for (int y = 1; y < ys - 1; ++y) {
+        for (int z = 1; z < zs - 1; ++z) {
+            Cell& c = m_cells(x, y, z);
+            if (c.obs == nullptr || c.dist_new >= m_dmax_sqrd_int) {
+                c.dist_new = m_dmax_sqrd_int;
+                c.obs = nullptr;
+            }
+            c.dist = c.dist_new;
+#if SMPL_DMAP_RETURN_CHANGED_CELLS
+            c.dist_old = c.dist;
+#endif
+            c.bucket = -1;
+            c.dir = NO_UPDATE_DIR;
+            updateClearance(c);
+        }
+        }
+    });
+}
+
 } // namespace smpl
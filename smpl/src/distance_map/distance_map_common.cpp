@@ -31,6 +31,18 @@
 
 #include <smpl/distance_map/detail/distance_map_common.h>
 
+// standard includes
+#include <cstring>
+
+// system includes
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// project includes
+#include <smpl/console/console.h>
+
 namespace smpl {
 
 /// \param[out] neighbors Precomputed array of possibly 27-connected directions.
@@ -83,4 +95,180 @@ void CreateNeighborUpdateList(
     }
 }
 
+static const char DISTANCE_MAP_FILE_MAGIC[8] = { 'S', 'M', 'P', 'L', 'D', 'M', 'A', 'P' };
+
+void InitDistanceMapFileHeader(
+    DistanceMapFileHeader& header,
+    const char* type,
+    std::size_t record_size)
+{
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, DISTANCE_MAP_FILE_MAGIC, sizeof(header.magic));
+    header.version = DISTANCE_MAP_FILE_VERSION;
+    header.record_size = (std::uint32_t)record_size;
+    std::strncpy(header.type, type, sizeof(header.type) - 1);
+}
+
+bool CheckDistanceMapFileHeader(
+    const DistanceMapFileHeader& expected,
+    const DistanceMapFileHeader& actual)
+{
+    if (std::strncmp(expected.type, actual.type, sizeof(expected.type)) != 0) {
+        SMPL_ERROR("Distance map snapshot has type '%.32s' (expected '%.32s')", actual.type, expected.type);
+        return false;
+    }
+    if (expected.record_size != actual.record_size) {
+        SMPL_ERROR("Distance map snapshot has %u-byte cell records (expected %u)", actual.record_size, expected.record_size);
+        return false;
+    }
+    if (expected.cell_count_x != actual.cell_count_x ||
+        expected.cell_count_y != actual.cell_count_y ||
+        expected.cell_count_z != actual.cell_count_z)
+    {
+        SMPL_ERROR("Distance map snapshot has %d x %d x %d cells (expected %d x %d x %d)",
+                actual.cell_count_x, actual.cell_count_y, actual.cell_count_z,
+                expected.cell_count_x, expected.cell_count_y, expected.cell_count_z);
+        return false;
+    }
+    for (int i = 0; i < 3; ++i) {
+        if (expected.origin[i] != actual.origin[i] ||
+            expected.size[i] != actual.size[i])
+        {
+            SMPL_ERROR("Distance map snapshot origin or size differs from the map");
+            return false;
+        }
+    }
+    if (expected.resolution != actual.resolution ||
+        expected.max_dist != actual.max_dist)
+    {
+        SMPL_ERROR("Distance map snapshot has resolution %f and max distance %f (expected %f and %f)",
+                actual.resolution, actual.max_dist,
+                expected.resolution, expected.max_dist);
+        return false;
+    }
+    return true;
+}
+
+DistanceMapFileWriter::~DistanceMapFileWriter()
+{
+    if (m_file) {
+        std::fclose(m_file);
+    }
+}
+
+bool DistanceMapFileWriter::open(
+    const std::string& path,
+    const DistanceMapFileHeader& header)
+{
+    if (m_file) {
+        std::fclose(m_file);
+    }
+
+    m_path = path;
+    m_header = header;
+    m_header.record_count = 0;
+
+    m_file = std::fopen(path.c_str(), "wb");
+    if (!m_file) {
+        SMPL_ERROR("Failed to open '%s' for writing", path.c_str());
+        m_ok = false;
+        return false;
+    }
+
+    m_ok = std::fwrite(&m_header, sizeof(m_header), 1, m_file) == 1;
+    return m_ok;
+}
+
+bool DistanceMapFileWriter::write(const void* records, std::size_t count)
+{
+    if (!m_ok || count == 0) {
+        return m_ok;
+    }
+    m_ok = std::fwrite(records, m_header.record_size, count, m_file) == count;
+    m_header.record_count += count;
+    return m_ok;
+}
+
+bool DistanceMapFileWriter::close()
+{
+    if (!m_file) {
+        return false;
+    }
+
+    if (m_ok) {
+        m_ok = std::fseek(m_file, 0, SEEK_SET) == 0 &&
+                std::fwrite(&m_header, sizeof(m_header), 1, m_file) == 1;
+    }
+    m_ok = (std::fclose(m_file) == 0) && m_ok;
+    m_file = nullptr;
+
+    if (!m_ok) {
+        SMPL_ERROR("Failed to write distance map snapshot '%s'", m_path.c_str());
+    }
+    return m_ok;
+}
+
+DistanceMapFileReader::~DistanceMapFileReader()
+{
+    close();
+}
+
+bool DistanceMapFileReader::open(const std::string& path)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        SMPL_ERROR("Failed to open distance map snapshot '%s'", path.c_str());
+        return false;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(DistanceMapFileHeader)) {
+        SMPL_ERROR("Distance map snapshot '%s' is truncated", path.c_str());
+        ::close(fd);
+        return false;
+    }
+
+    void* data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        SMPL_ERROR("Failed to map distance map snapshot '%s'", path.c_str());
+        return false;
+    }
+
+    m_data = data;
+    m_size = st.st_size;
+
+    const DistanceMapFileHeader& h = header();
+    if (std::memcmp(h.magic, DISTANCE_MAP_FILE_MAGIC, sizeof(h.magic)) != 0) {
+        SMPL_ERROR("'%s' is not a distance map snapshot", path.c_str());
+        close();
+        return false;
+    }
+    if (h.version != DISTANCE_MAP_FILE_VERSION) {
+        SMPL_ERROR("Distance map snapshot '%s' has version %u (expected %u)", path.c_str(), h.version, DISTANCE_MAP_FILE_VERSION);
+        close();
+        return false;
+    }
+    if (h.record_size == 0 ||
+        h.record_count > (m_size - sizeof(DistanceMapFileHeader)) / h.record_size)
+    {
+        SMPL_ERROR("Distance map snapshot '%s' is truncated", path.c_str());
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void DistanceMapFileReader::close()
+{
+    if (m_data) {
+        ::munmap(m_data, m_size);
+        m_data = nullptr;
+        m_size = 0;
+    }
+}
+
 } // namespace smpl
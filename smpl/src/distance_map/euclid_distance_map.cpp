@@ -31,6 +31,13 @@
 
 #include <smpl/distance_map/euclid_distance_map.h>
 
+// standard includes
+#include <algorithm>
+#include <limits>
+
+// project includes
+#include <smpl/worker_pool.h>
+
 namespace smpl {
 
 EuclidDistanceMap::EuclidDistanceMap(
@@ -46,6 +53,32 @@ EuclidDistanceMap::EuclidDistanceMap(
 {
 }
 
+/// Add a set of obstacle points to the distance map. When more than one thread
+/// is configured and the batch is large enough, the new obstacles are marked
+/// and all distances are recomputed in parallel instead of being propagated
+/// incrementally from each new obstacle.
+void EuclidDistanceMap::addPointsToMap(const std::vector<Vector3>& points)
+{
+    if (!preferFullTransform(points.size())) {
+        DistanceMap::addPointsToMap(points);
+        return;
+    }
+
+    for (const Vector3& p : points) {
+        int gx, gy, gz;
+        worldToGrid(p.x(), p.y(), p.z(), gx, gy, gz);
+        if (!isCellValid(gx, gy, gz)) {
+            continue;
+        }
+
+        Cell& c = m_cells(gx + 1, gy + 1, gz + 1);
+        c.dist_new = 0;
+        c.obs = &c;
+    }
+
+    computeFullTransform();
+}
+
 int EuclidDistanceMap::distance(const Cell& n, const Cell& s)
 {
     int dx = n.x - s.obs->x;
@@ -55,4 +88,157 @@ int EuclidDistanceMap::distance(const Cell& n, const Cell& s)
     return dx * dx + dy * dy + dz * dz;
 }
 
+// Incremental insertion touches up to (2 * dmax + 1)^3 cells per obstacle; once
+// that exceeds the size of the grid, a full transform does less work.
+bool EuclidDistanceMap::preferFullTransform(std::size_t point_count) const
+{
+    if (m_thread_count <= 1) {
+        return false;
+    }
+    const double w = 2.0 * m_dmax_int + 1.0;
+    return (double)point_count * w * w * w >= (double)m_cells.size();
+}
+
+// Recompute the distance to the nearest obstacle for every cell with an exact
+// separable squared Euclidean distance transform (Felzenszwalb & Huttenlocher),
+// tracking the nearest obstacle cell alongside the distance. Each of the three
+// 1D passes runs along one axis and the lines of a pass are independent, so
+// each pass is split into slabs of lines that are processed concurrently; the
+// following pass along the next axis reconciles the values across slabs.
+//
+// The pass values are stored in place in dist_new and obs. Interior cells are
+// rewritten with dir = NO_UPDATE_DIR, so subsequent incremental updates
+// propagate from them to all neighbors, and cells beyond the maximum distance
+// are reset to the uninitialized state, the same as after propagate(). The
+// border cells are obstacles and are left untouched.
+void EuclidDistanceMap::computeFullTransform()
+{
+    const int INF = std::numeric_limits<int>::max();
+
+    const int xs = m_cells.xsize();
+    const int ys = m_cells.ysize();
+    const int zs = m_cells.zsize();
+
+    for (int x = 1; x < xs - 1; ++x) {
+    for (int y = 1; y < ys - 1; ++y) {
+    for (int z = 1; z < zs - 1; ++z) {
+        Cell& c = m_cells(x, y, z);
+        if (c.obs != &c) {
+            c.dist_new = INF;
+            c.obs = nullptr;
+        }
+    }
+    }
+    }
+
+    struct Scratch
+    {
+        std::vector<int> f;         // squared distances along the line
+        std::vector<Cell*> feat;    // nearest obstacle along the line
+        std::vector<int> v;         // parabola vertices in the lower envelope
+        std::vector<double> b;      // left boundaries of the envelope parabolas
+    };
+
+    const int max_len = std::max(xs, std::max(ys, zs));
+
+    WorkerPool pool(m_thread_count);
+    std::vector<Scratch> scratch(pool.numThreads());
+    for (Scratch& s : scratch) {
+        s.f.resize(max_len);
+        s.feat.resize(max_len);
+        s.v.resize(max_len);
+        s.b.resize(max_len);
+    }
+
+    // 1D lower envelope transform of the line starting at first with n cells
+    // spaced stride apart
+    auto transform_line = [&](Scratch& s, Cell* first, int n, int stride) {
+        for (int i = 0; i < n; ++i) {
+            s.f[i] = first[i * stride].dist_new;
+            s.feat[i] = first[i * stride].obs;
+        }
+
+        auto intersect = [&](int p, int q) {
+            const double fp = (double)s.f[p] + (double)p * p;
+            const double fq = (double)s.f[q] + (double)q * q;
+            return (fq - fp) / (2.0 * (q - p));
+        };
+
+        int k = -1;
+        for (int q = 0; q < n; ++q) {
+            if (s.f[q] == INF) {
+                continue;
+            }
+            double b = -std::numeric_limits<double>::infinity();
+            while (k >= 0) {
+                b = intersect(s.v[k], q);
+                if (b > s.b[k]) {
+                    break;
+                }
+                --k;
+                b = -std::numeric_limits<double>::infinity();
+            }
+            ++k;
+            s.v[k] = q;
+            s.b[k] = b;
+        }
+
+        if (k < 0) {
+            return; // no obstacles along this line
+        }
+
+        int j = 0;
+        for (int q = 0; q < n; ++q) {
+            while (j < k && s.b[j + 1] < q) {
+                ++j;
+            }
+            const int p = s.v[j];
+            Cell& c = first[q * stride];
+            c.dist_new = (q - p) * (q - p) + s.f[p];
+            c.obs = s.feat[p];
+        }
+    };
+
+    // pass along z; slabs of constant x
+    pool.run(xs, [&](int tid, std::size_t x) {
+        for (int y = 0; y < ys; ++y) {
+            transform_line(scratch[tid], &m_cells(x, y, 0), zs, 1);
+        }
+    });
+
+    // pass along y; slabs of constant x
+    pool.run(xs, [&](int tid, std::size_t x) {
+        for (int z = 0; z < zs; ++z) {
+            transform_line(scratch[tid], &m_cells(x, 0, z), ys, zs);
+        }
+    });
+
+    // pass along x; slabs of constant y
+    pool.run(ys, [&](int tid, std::size_t y) {
+        for (int z = 0; z < zs; ++z) {
+            transform_line(scratch[tid], &m_cells(0, y, z), xs, ys * zs);
+        }
+    });
+
+    pool.run(xs - 2, [&](int tid, std::size_t i) {
+        const int x = (int)i + 1;
+        for (int y = 1; y < ys - 1; ++y) {
+        for (int z = 1; z < zs - 1; ++z) {
+            Cell& c = m_cells(x, y, z);
+            if (c.obs == nullptr || c.dist_new >= m_dmax_sqrd_int) {
+                c.dist_new = m_dmax_sqrd_int;
+                c.obs = nullptr;
+            }
+            c.dist = c.dist_new;
+#if SMPL_DMAP_RETURN_CHANGED_CELLS
+            c.dist_old = c.dist;
+#endif
+            c.bucket = -1;
+            c.dir = NO_UPDATE_DIR;
+            updateClearance(c);
+        }
+        }
+    });
+}
+
 } // namespace smpl
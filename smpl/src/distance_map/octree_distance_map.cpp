@@ -0,0 +1,416 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+/// \author Andrew Dornbush
+
+#include <smpl/distance_map/octree_distance_map.h>
+
+// standard includes
+#include <algorithm>
+#include <cmath>
+
+namespace smpl {
+
+namespace {
+
+// The number of cells covered by a node at a given level above the cells
+inline std::uint32_t NodeVolume(int level)
+{
+    return std::uint32_t(1) << (3 * level);
+}
+
+inline int ChildIndex(int x, int y, int z, int level)
+{
+    return ((x >> level) & 1) | (((y >> level) & 1) << 1) | (((z >> level) & 1) << 2);
+}
+
+// Squared distance, in cells, from a cell to the nearest cell in the cube of
+// the given size with minimum corner (ox, oy, oz)
+inline int BoxSquaredDistance(
+    int x, int y, int z,
+    int ox, int oy, int oz,
+    int size)
+{
+    const int dx = std::max(std::max(ox - x, x - (ox + size - 1)), 0);
+    const int dy = std::max(std::max(oy - y, y - (oy + size - 1)), 0);
+    const int dz = std::max(std::max(oz - z, z - (oz + size - 1)), 0);
+    return dx * dx + dy * dy + dz * dz;
+}
+
+} // namespace
+
+OcTreeDistanceMap::OcTreeDistanceMap(
+    double origin_x, double origin_y, double origin_z,
+    double size_x, double size_y, double size_z,
+    double resolution,
+    double max_dist)
+:
+    DistanceMapInterface(
+            origin_x, origin_y, origin_z,
+            size_x, size_y, size_z,
+            resolution),
+    m_tree(0),
+    m_depth(0),
+    m_max_dist(max_dist),
+    m_inv_res(1.0 / resolution)
+{
+    m_cell_count_x = (int)(size_x * m_inv_res + 0.5);
+    m_cell_count_y = (int)(size_y * m_inv_res + 0.5);
+    m_cell_count_z = (int)(size_z * m_inv_res + 0.5);
+
+    const int max_count = std::max(
+            m_cell_count_x, std::max(m_cell_count_y, m_cell_count_z));
+    while ((1 << m_depth) < max_count) {
+        ++m_depth;
+    }
+
+    const double dmax = m_max_dist * m_inv_res;
+    m_dmax_sqrd_int = (int)(dmax * dmax) + 1;
+}
+
+/// Return the distance value for an invalid cell.
+double OcTreeDistanceMap::maxDistance() const
+{
+    return m_max_dist;
+}
+
+/// Return the distance of a cell from its nearest obstacle. A value of 0.0 is
+/// returned for obstacle cells and cells outside of the bounding volume.
+double OcTreeDistanceMap::getDistance(double x, double y, double z) const
+{
+    int gx, gy, gz;
+    worldToGrid(x, y, z, gx, gy, gz);
+    return getDistance(gx, gy, gz);
+}
+
+/// Return the distance of a cell from its nearest obstacle cell. A value of
+/// 0.0 is returned for obstacle cells and cells outside of the bounding volume.
+double OcTreeDistanceMap::getDistance(int x, int y, int z) const
+{
+    if (!isCellValid(x, y, z)) {
+        return 0.0;
+    }
+
+    const int d2 = nearestSquaredDistance(x, y, z);
+    if (d2 >= m_dmax_sqrd_int) {
+        return m_max_dist;
+    }
+    return m_res * std::sqrt((double)d2);
+}
+
+/// Test whether a cell is occupied.
+bool OcTreeDistanceMap::isOccupied(int x, int y, int z) const
+{
+    if (!isCellValid(x, y, z)) {
+        return false;
+    }
+
+    const Node* n = m_tree.root();
+    int level = m_depth;
+    while (n->children) {
+        --level;
+        n = n->child(ChildIndex(x, y, z, level));
+    }
+    return n->value != 0;
+}
+
+DistanceMapInterface* OcTreeDistanceMap::clone() const
+{
+    return new OcTreeDistanceMap(*this);
+}
+
+/// Add a set of obstacle points to the distance map. Points outside the map
+/// and cells that are already marked as obstacles will be ignored.
+void OcTreeDistanceMap::addPointsToMap(const std::vector<Vector3>& points)
+{
+    for (const Vector3& p : points) {
+        int gx, gy, gz;
+        worldToGrid(p.x(), p.y(), p.z(), gx, gy, gz);
+        if (isCellValid(gx, gy, gz)) {
+            addCell(gx, gy, gz);
+        }
+    }
+}
+
+/// Remove a set of obstacle points from the distance map. Points outside the
+/// map and cells that are not marked as obstacles will be ignored.
+void OcTreeDistanceMap::removePointsFromMap(const std::vector<Vector3>& points)
+{
+    for (const Vector3& p : points) {
+        int gx, gy, gz;
+        worldToGrid(p.x(), p.y(), p.z(), gx, gy, gz);
+        if (isCellValid(gx, gy, gz)) {
+            removeCell(gx, gy, gz);
+        }
+    }
+}
+
+/// Remove the cells of old_points and then add the cells of new_points. With
+/// no distances to propagate, this is the same as the set difference update
+/// made by the other distance maps.
+void OcTreeDistanceMap::updatePointsInMap(
+    const std::vector<Vector3>& old_points,
+    const std::vector<Vector3>& new_points)
+{
+    removePointsFromMap(old_points);
+    addPointsToMap(new_points);
+}
+
+/// Reset all points in the distance map to their uninitialized (free) values.
+void OcTreeDistanceMap::reset()
+{
+    m_tree.clear();
+    m_tree.root()->value = 0;
+}
+
+/// Return the number of cells along the x axis.
+int OcTreeDistanceMap::numCellsX() const
+{
+    return m_cell_count_x;
+}
+
+/// Return the number of cells along the y axis.
+int OcTreeDistanceMap::numCellsY() const
+{
+    return m_cell_count_y;
+}
+
+/// Return the number of cells along the z axis.
+int OcTreeDistanceMap::numCellsZ() const
+{
+    return m_cell_count_z;
+}
+
+double OcTreeDistanceMap::getUninitializedDistance() const
+{
+    return maxDistance();
+}
+
+double OcTreeDistanceMap::getMetricDistance(double x, double y, double z) const
+{
+    return getDistance(x, y, z);
+}
+
+double OcTreeDistanceMap::getCellDistance(int x, int y, int z) const
+{
+    return getDistance(x, y, z);
+}
+
+double OcTreeDistanceMap::getMetricSquaredDistance(
+    double x, double y, double z) const
+{
+    int gx, gy, gz;
+    worldToGrid(x, y, z, gx, gy, gz);
+    return getCellSquaredDistance(gx, gy, gz);
+}
+
+double OcTreeDistanceMap::getCellSquaredDistance(int x, int y, int z) const
+{
+    if (!isCellValid(x, y, z)) {
+        return 0.0;
+    }
+
+    const int d2 = nearestSquaredDistance(x, y, z);
+    if (d2 >= m_dmax_sqrd_int) {
+        return m_max_dist * m_max_dist;
+    }
+    return m_res * m_res * d2;
+}
+
+/// Return the point in world coordinates marking the center of the cell at the
+/// given effective grid coordinates.
+void OcTreeDistanceMap::gridToWorld(
+    int x, int y, int z,
+    double& world_x, double& world_y, double& world_z) const
+{
+    world_x = m_origin_x + x * m_res;
+    world_y = m_origin_y + y * m_res;
+    world_z = m_origin_z + z * m_res;
+}
+
+/// Return the effective grid coordinates of the cell containing the given point
+/// specified in world coordinates.
+void OcTreeDistanceMap::worldToGrid(
+    double world_x, double world_y, double world_z,
+    int& x, int& y, int& z) const
+{
+    x = (int)(m_inv_res * (world_x - (m_origin_x - m_res)) + 0.5) - 1;
+    y = (int)(m_inv_res * (world_y - (m_origin_y - m_res)) + 0.5) - 1;
+    z = (int)(m_inv_res * (world_z - (m_origin_z - m_res)) + 0.5) - 1;
+}
+
+/// Test if a cell is outside the bounding volume.
+bool OcTreeDistanceMap::isCellValid(int x, int y, int z) const
+{
+    return x >= 0 && x < m_cell_count_x &&
+        y >= 0 && y < m_cell_count_y &&
+        z >= 0 && z < m_cell_count_z;
+}
+
+/// Mark a cell as occupied, expanding free leaves on the way down to it and
+/// collapsing nodes that become fully occupied on the way back up.
+bool OcTreeDistanceMap::addCell(int x, int y, int z)
+{
+    if (isOccupied(x, y, z)) {
+        return false;
+    }
+
+    m_path.clear();
+    Node* n = m_tree.root();
+    for (int level = m_depth; level > 0; --level) {
+        m_path.push_back(n);
+        if (!n->children) {
+            m_tree.expand_node(n); // free leaf -> free children
+        }
+        ++n->value;
+        n = n->child(ChildIndex(x, y, z, level - 1));
+    }
+    n->value = 1;
+
+    for (int i = (int)m_path.size() - 1; i >= 0; --i) {
+        Node* p = m_path[i];
+        if (p->value != NodeVolume(m_depth - i)) {
+            break;
+        }
+        m_tree.collapse_node(p, p->value);
+    }
+    return true;
+}
+
+/// Mark a cell as free, expanding occupied leaves on the way down to it and
+/// collapsing nodes that become entirely free on the way back up.
+bool OcTreeDistanceMap::removeCell(int x, int y, int z)
+{
+    if (!isOccupied(x, y, z)) {
+        return false;
+    }
+
+    m_path.clear();
+    Node* n = m_tree.root();
+    for (int level = m_depth; level > 0; --level) {
+        m_path.push_back(n);
+        if (!n->children) {
+            // occupied leaf -> occupied children
+            m_tree.expand_node(n);
+            for (int i = 0; i < 8; ++i) {
+                n->child(i)->value = NodeVolume(level - 1);
+            }
+        }
+        --n->value;
+        n = n->child(ChildIndex(x, y, z, level - 1));
+    }
+    n->value = 0;
+
+    for (int i = (int)m_path.size() - 1; i >= 0; --i) {
+        Node* p = m_path[i];
+        if (p->value != 0) {
+            break;
+        }
+        m_tree.collapse_node(p, 0);
+    }
+    return true;
+}
+
+/// Return the squared distance, in cells, from a cell to the nearest occupied
+/// cell, or a value no less than the squared max distance if there is none
+/// within it. Nodes are visited nearest first, and nodes that are free or
+/// farther than the nearest cell found so far are skipped.
+int OcTreeDistanceMap::nearestSquaredDistance(int x, int y, int z) const
+{
+    struct Entry
+    {
+        const Node* node;
+        int level;
+        int ox;
+        int oy;
+        int oz;
+        int d2;
+    };
+
+    int best = m_dmax_sqrd_int;
+
+    // depth-first, with at most 8 entries pushed per level
+    Entry stack[8 * 32];
+    int top = 0;
+
+    const Node* root = m_tree.root();
+    if (root->value == 0) {
+        return best;
+    }
+    stack[top++] = Entry{
+        root, m_depth, 0, 0, 0,
+        BoxSquaredDistance(x, y, z, 0, 0, 0, 1 << m_depth) };
+
+    while (top > 0) {
+        const Entry e = stack[--top];
+        if (e.d2 >= best) {
+            continue;
+        }
+
+        if (!e.node->children) {
+            // fully occupied leaf
+            best = e.d2;
+            if (best == 0) {
+                break;
+            }
+            continue;
+        }
+
+        // push the occupied children, farthest first so that the nearest is
+        // visited next
+        Entry children[8];
+        int count = 0;
+        const int level = e.level - 1;
+        const int size = 1 << level;
+        for (int i = 0; i < 8; ++i) {
+            const Node* c = e.node->child(i);
+            if (c->value == 0) {
+                continue;
+            }
+            const int ox = e.ox + ((i & 1) ? size : 0);
+            const int oy = e.oy + ((i & 2) ? size : 0);
+            const int oz = e.oz + ((i & 4) ? size : 0);
+            const int d2 = BoxSquaredDistance(x, y, z, ox, oy, oz, size);
+            if (d2 >= best) {
+                continue;
+            }
+            children[count++] = Entry{ c, level, ox, oy, oz, d2 };
+        }
+        std::sort(children, children + count,
+                [](const Entry& a, const Entry& b) { return a.d2 > b.d2; });
+        for (int i = 0; i < count; ++i) {
+            stack[top++] = children[i];
+        }
+    }
+
+    return best;
+}
+
+} // namespace smpl
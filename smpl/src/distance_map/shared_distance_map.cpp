@@ -0,0 +1,459 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+/// \author Andrew Dornbush
+
+#include <smpl/distance_map/shared_distance_map.h>
+
+// standard includes
+#include <cstring>
+#include <new>
+
+// system includes
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// project includes
+#include <smpl/console/console.h>
+
+namespace smpl {
+
+static const char* LOG = "dmap.shared";
+
+static_assert(sizeof(SharedDistanceMapHeader) % sizeof(double) == 0,
+        "Shared distance map cells must be 8-byte aligned");
+
+static
+auto CellCount(const SharedDistanceMapHeader& h) -> std::size_t
+{
+    return (std::size_t)h.cell_count_x *
+            (std::size_t)h.cell_count_y *
+            (std::size_t)h.cell_count_z;
+}
+
+static
+auto SharedSize(const SharedDistanceMapHeader& h) -> std::size_t
+{
+    return sizeof(SharedDistanceMapHeader) + 2 * CellCount(h) * sizeof(float);
+}
+
+// Copy the distances of a map into one copy of the shared cells, through a raw
+// view where the map supports one.
+static
+void CopyDistances(
+    const DistanceMapInterface& map,
+    const SharedDistanceMapHeader& h,
+    float* cells)
+{
+    DistanceMapView view;
+    auto has_view = map.getView(view);
+    for (int z = 0; z < h.cell_count_z; ++z) {
+    for (int y = 0; y < h.cell_count_y; ++y) {
+    for (int x = 0; x < h.cell_count_x; ++x) {
+        *cells++ = has_view ?
+                (float)view.getCellDistance(x, y, z) :
+                (float)map.getCellDistance(x, y, z);
+    }
+    }
+    }
+}
+
+SharedDistanceMapPublisher::~SharedDistanceMapPublisher()
+{
+    close();
+}
+
+bool SharedDistanceMapPublisher::create(
+    const std::string& name,
+    const DistanceMapInterface& map)
+{
+    close();
+
+    if (!std::atomic<std::uint64_t>().is_lock_free()) {
+        SMPL_ERROR_NAMED(LOG, "Shared distance maps require lock-free 64-bit atomics");
+        return false;
+    }
+
+    SharedDistanceMapHeader h;
+    std::memset(h.magic, 0, sizeof(h.magic));
+    h.version = SHARED_DISTANCE_MAP_VERSION;
+    h.cell_count_x = map.numCellsX();
+    h.cell_count_y = map.numCellsY();
+    h.cell_count_z = map.numCellsZ();
+    h.origin_x = map.originX();
+    h.origin_y = map.originY();
+    h.origin_z = map.originZ();
+    h.size_x = map.sizeX();
+    h.size_y = map.sizeY();
+    h.size_z = map.sizeZ();
+    h.resolution = map.resolution();
+    h.uninitialized_distance = map.getUninitializedDistance();
+
+    // Resizing an object that other processes have mapped would fault their
+    // reads, so replace it with a fresh one.
+    ::shm_unlink(name.c_str());
+    int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        SMPL_ERROR_NAMED(LOG, "Failed to create shared distance map '%s'", name.c_str());
+        return false;
+    }
+
+    auto size = SharedSize(h);
+    void* data = MAP_FAILED;
+    if (::ftruncate(fd, size) == 0) {
+        data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        SMPL_ERROR_NAMED(LOG, "Failed to map shared distance map '%s'", name.c_str());
+        ::shm_unlink(name.c_str());
+        return false;
+    }
+
+    m_data = data;
+    m_size = size;
+    m_header = static_cast<SharedDistanceMapHeader*>(data);
+    std::memcpy((void*)m_header, &h, offsetof(SharedDistanceMapHeader, sequence));
+    new (&m_header->sequence) std::atomic<std::uint64_t>(0);
+    m_cells = reinterpret_cast<float*>(static_cast<char*>(data) + sizeof(SharedDistanceMapHeader));
+
+    // Write the magic number last so that a process attaching while the
+    // first distances are being copied rejects the object instead of
+    // reading partial distances.
+    CopyDistances(map, h, m_cells);
+    std::memcpy(m_cells + CellCount(h), m_cells, CellCount(h) * sizeof(float));
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(m_header->magic, SHARED_DISTANCE_MAP_MAGIC, sizeof(h.magic));
+
+    SMPL_INFO_NAMED(LOG, "Published distance map '%s' (%d x %d x %d cells, %zu bytes)", name.c_str(), h.cell_count_x, h.cell_count_y, h.cell_count_z, size);
+    return true;
+}
+
+void SharedDistanceMapPublisher::close()
+{
+    if (m_data != nullptr) {
+        ::munmap(m_data, m_size);
+        m_data = nullptr;
+        m_size = 0;
+        m_header = nullptr;
+        m_cells = nullptr;
+    }
+}
+
+bool SharedDistanceMapPublisher::publish(const DistanceMapInterface& map)
+{
+    if (!isOpen()) {
+        SMPL_ERROR_NAMED(LOG, "Shared distance map has not been created");
+        return false;
+    }
+
+    auto& h = *m_header;
+    if (map.numCellsX() != h.cell_count_x ||
+        map.numCellsY() != h.cell_count_y ||
+        map.numCellsZ() != h.cell_count_z)
+    {
+        SMPL_ERROR_NAMED(LOG, "Distance map has %d x %d x %d cells (expected %d x %d x %d)", map.numCellsX(), map.numCellsY(), map.numCellsZ(), h.cell_count_x, h.cell_count_y, h.cell_count_z);
+        return false;
+    }
+
+    auto count = CellCount(h);
+    auto* first = m_cells;
+    auto* second = m_cells + count;
+
+    // move readers to the second copy while the first is rewritten, then
+    // back to the first while the second is brought up to date
+    auto sequence = h.sequence.load(std::memory_order_relaxed);
+    h.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    CopyDistances(map, h, first);
+
+    h.sequence.store(sequence + 2, std::memory_order_release);
+    std::memcpy(second, first, count * sizeof(float));
+    return true;
+}
+
+auto SharedDistanceMapPublisher::version() const -> std::uint64_t
+{
+    return isOpen() ? m_header->sequence.load(std::memory_order_relaxed) / 2 : 0;
+}
+
+bool UnpublishSharedDistanceMap(const std::string& name)
+{
+    if (::shm_unlink(name.c_str()) != 0) {
+        SMPL_ERROR_NAMED(LOG, "Failed to remove shared distance map '%s'", name.c_str());
+        return false;
+    }
+    return true;
+}
+
+SharedDistanceMap::Mapping::~Mapping()
+{
+    ::munmap(data, size);
+}
+
+SharedDistanceMap::SharedDistanceMap(const std::shared_ptr<Mapping>& mapping) :
+    DistanceMapInterface(
+            static_cast<const SharedDistanceMapHeader*>(mapping->data)->origin_x,
+            static_cast<const SharedDistanceMapHeader*>(mapping->data)->origin_y,
+            static_cast<const SharedDistanceMapHeader*>(mapping->data)->origin_z,
+            static_cast<const SharedDistanceMapHeader*>(mapping->data)->size_x,
+            static_cast<const SharedDistanceMapHeader*>(mapping->data)->size_y,
+            static_cast<const SharedDistanceMapHeader*>(mapping->data)->size_z,
+            static_cast<const SharedDistanceMapHeader*>(mapping->data)->resolution),
+    m_mapping(mapping),
+    m_header(static_cast<const SharedDistanceMapHeader*>(mapping->data))
+{
+    m_cells = reinterpret_cast<const float*>(
+            static_cast<const char*>(mapping->data) + sizeof(SharedDistanceMapHeader));
+    m_cell_count = CellCount(*m_header);
+    m_cell_count_x = m_header->cell_count_x;
+    m_cell_count_y = m_header->cell_count_y;
+    m_cell_count_z = m_header->cell_count_z;
+    m_inv_res = 1.0 / m_res;
+}
+
+SharedDistanceMap::~SharedDistanceMap()
+{
+}
+
+auto SharedDistanceMap::version() const -> std::uint64_t
+{
+    return m_header->sequence.load(std::memory_order_acquire) / 2;
+}
+
+// Return the copy of the cells to read. The values read from it are
+// consistent if endRead() returns true for the same sequence.
+auto SharedDistanceMap::beginRead(std::uint64_t& sequence) const -> const float*
+{
+    sequence = m_header->sequence.load(std::memory_order_acquire);
+    return m_cells + (sequence & 1) * m_cell_count;
+}
+
+bool SharedDistanceMap::endRead(std::uint64_t sequence) const
+{
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return m_header->sequence.load(std::memory_order_relaxed) == sequence;
+}
+
+DistanceMapInterface* SharedDistanceMap::clone() const
+{
+    return new SharedDistanceMap(m_mapping);
+}
+
+void SharedDistanceMap::addPointsToMap(const std::vector<Vector3>& points)
+{
+    SMPL_WARN_ONCE("Shared distance maps are read-only; update the map of the publishing process");
+}
+
+void SharedDistanceMap::removePointsFromMap(const std::vector<Vector3>& points)
+{
+    SMPL_WARN_ONCE("Shared distance maps are read-only; update the map of the publishing process");
+}
+
+void SharedDistanceMap::updatePointsInMap(
+    const std::vector<Vector3>& old_points,
+    const std::vector<Vector3>& new_points)
+{
+    SMPL_WARN_ONCE("Shared distance maps are read-only; update the map of the publishing process");
+}
+
+void SharedDistanceMap::reset()
+{
+    SMPL_WARN_ONCE("Shared distance maps are read-only; update the map of the publishing process");
+}
+
+int SharedDistanceMap::numCellsX() const
+{
+    return m_cell_count_x;
+}
+
+int SharedDistanceMap::numCellsY() const
+{
+    return m_cell_count_y;
+}
+
+int SharedDistanceMap::numCellsZ() const
+{
+    return m_cell_count_z;
+}
+
+double SharedDistanceMap::getUninitializedDistance() const
+{
+    return m_header->uninitialized_distance;
+}
+
+/// Return the size of the mapping, which is shared with the publisher and all
+/// other attached processes.
+auto SharedDistanceMap::memoryUsage() const -> std::size_t
+{
+    return m_mapping->size;
+}
+
+double SharedDistanceMap::getMetricDistance(double x, double y, double z) const
+{
+    int gx, gy, gz;
+    worldToGrid(x, y, z, gx, gy, gz);
+    return getCellDistance(gx, gy, gz);
+}
+
+double SharedDistanceMap::getCellDistance(int x, int y, int z) const
+{
+    if (!isCellValid(x, y, z)) {
+        return 0.0;
+    }
+
+    auto i = cellIndex(x, y, z);
+    std::uint64_t sequence;
+    float d;
+    do {
+        d = beginRead(sequence)[i];
+    } while (!endRead(sequence));
+    return d;
+}
+
+void SharedDistanceMap::getMetricSquaredDistances(
+    const double* x, const double* y, const double* z,
+    int count,
+    double* dists) const
+{
+    std::uint64_t sequence;
+    do {
+        auto* cells = beginRead(sequence);
+        for (int i = 0; i < count; ++i) {
+            int gx, gy, gz;
+            worldToGrid(x[i], y[i], z[i], gx, gy, gz);
+            double d = isCellValid(gx, gy, gz) ? cells[cellIndex(gx, gy, gz)] : 0.0;
+            dists[i] = d * d;
+        }
+    } while (!endRead(sequence));
+}
+
+void SharedDistanceMap::getMetricDistances(
+    const float* xyz, std::size_t n, float* dists) const
+{
+    std::uint64_t sequence;
+    do {
+        auto* cells = beginRead(sequence);
+        for (std::size_t i = 0; i < n; ++i) {
+            int gx, gy, gz;
+            worldToGrid(xyz[3 * i + 0], xyz[3 * i + 1], xyz[3 * i + 2], gx, gy, gz);
+            dists[i] = isCellValid(gx, gy, gz) ? cells[cellIndex(gx, gy, gz)] : 0.0f;
+        }
+    } while (!endRead(sequence));
+}
+
+void SharedDistanceMap::getCellDistances(
+    const int* xyz, std::size_t n, float* dists) const
+{
+    std::uint64_t sequence;
+    do {
+        auto* cells = beginRead(sequence);
+        for (std::size_t i = 0; i < n; ++i) {
+            int gx = xyz[3 * i + 0];
+            int gy = xyz[3 * i + 1];
+            int gz = xyz[3 * i + 2];
+            dists[i] = isCellValid(gx, gy, gz) ? cells[cellIndex(gx, gy, gz)] : 0.0f;
+        }
+    } while (!endRead(sequence));
+}
+
+void SharedDistanceMap::gridToWorld(
+    int x, int y, int z,
+    double& world_x, double& world_y, double& world_z) const
+{
+    world_x = (m_origin_x - m_res) + (x + 1) * m_res;
+    world_y = (m_origin_y - m_res) + (y + 1) * m_res;
+    world_z = (m_origin_z - m_res) + (z + 1) * m_res;
+}
+
+void SharedDistanceMap::worldToGrid(
+    double world_x, double world_y, double world_z,
+    int& x, int& y, int& z) const
+{
+    x = (int)(m_inv_res * (world_x - (m_origin_x - m_res)) + 0.5) - 1;
+    y = (int)(m_inv_res * (world_y - (m_origin_y - m_res)) + 0.5) - 1;
+    z = (int)(m_inv_res * (world_z - (m_origin_z - m_res)) + 0.5) - 1;
+}
+
+bool SharedDistanceMap::isCellValid(int x, int y, int z) const
+{
+    return (unsigned int)x < (unsigned int)m_cell_count_x &&
+            (unsigned int)y < (unsigned int)m_cell_count_y &&
+            (unsigned int)z < (unsigned int)m_cell_count_z;
+}
+
+auto AttachSharedDistanceMap(const std::string& name)
+    -> std::unique_ptr<SharedDistanceMap>
+{
+    int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        SMPL_ERROR_NAMED(LOG, "Failed to open shared distance map '%s'", name.c_str());
+        return nullptr;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(SharedDistanceMapHeader)) {
+        SMPL_ERROR_NAMED(LOG, "Shared distance map '%s' is truncated", name.c_str());
+        ::close(fd);
+        return nullptr;
+    }
+
+    void* data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        SMPL_ERROR_NAMED(LOG, "Failed to map shared distance map '%s'", name.c_str());
+        return nullptr;
+    }
+
+    std::shared_ptr<SharedDistanceMap::Mapping> mapping(
+            new SharedDistanceMap::Mapping{ data, (std::size_t)st.st_size });
+
+    auto& h = *static_cast<const SharedDistanceMapHeader*>(data);
+    if (std::memcmp(h.magic, SHARED_DISTANCE_MAP_MAGIC, sizeof(h.magic)) != 0) {
+        SMPL_ERROR_NAMED(LOG, "'%s' is not a shared distance map", name.c_str());
+        return nullptr;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (h.version != SHARED_DISTANCE_MAP_VERSION) {
+        SMPL_ERROR_NAMED(LOG, "Shared distance map '%s' has version %u (expected %u)", name.c_str(), h.version, SHARED_DISTANCE_MAP_VERSION);
+        return nullptr;
+    }
+    if (h.cell_count_x < 0 || h.cell_count_y < 0 || h.cell_count_z < 0 ||
+        SharedSize(h) > mapping->size)
+    {
+        SMPL_ERROR_NAMED(LOG, "Shared distance map '%s' is truncated", name.c_str());
+        return nullptr;
+    }
+
+    return std::unique_ptr<SharedDistanceMap>(new SharedDistanceMap(mapping));
+}
+
+} // namespace smpl
@@ -34,6 +34,10 @@
 // standard includes
 #include <set>
 
+// project includes
+#include <smpl/console/console.h>
+#include <smpl/memory_usage.h>
+
 namespace smpl {
 
 SparseDistanceMap::SparseDistanceMap(
@@ -56,6 +60,7 @@ SparseDistanceMap::SparseDistanceMap(
     m_indices(),
     m_neighbor_ranges(),
     m_neighbor_dirs(),
+    m_brick_neighbor_offsets(),
     m_open(),
     m_rem_stack(),
     m_error(std::sqrt(3.0) * resolution)
@@ -65,6 +70,8 @@ SparseDistanceMap::SparseDistanceMap(
 
     for (size_t i = 0; i < m_indices.size(); ++i) {
         const Eigen::Vector3i& neighbor = m_neighbors[m_indices[i]];
+        m_brick_neighbor_offsets[i] = BrickGrid<Cell>::neighbor_offset(
+                neighbor.x(), neighbor.y(), neighbor.z());
 
         if (i < NON_BORDER_NEIGHBOR_LIST_SIZE) {
             m_neighbor_dirs[i] = dirnum(neighbor.x(), neighbor.y(), neighbor.z());
@@ -89,12 +96,72 @@ SparseDistanceMap::SparseDistanceMap(
     reset();
 }
 
+SparseDistanceMap::SparseDistanceMap(const SparseDistanceMap& o) :
+    DistanceMapInterface(o),
+    m_cells(o.m_cells),
+    m_cell_count_x(o.m_cell_count_x),
+    m_cell_count_y(o.m_cell_count_y),
+    m_cell_count_z(o.m_cell_count_z),
+    m_max_dist(o.m_max_dist),
+    m_inv_res(o.m_inv_res),
+    m_dmax_int(o.m_dmax_int),
+    m_dmax_sqrd_int(o.m_dmax_sqrd_int),
+    m_bucket(o.m_bucket),
+    m_neighbors(o.m_neighbors),
+    m_indices(o.m_indices),
+    m_neighbor_ranges(o.m_neighbor_ranges),
+    m_neighbor_dirs(o.m_neighbor_dirs),
+    m_brick_neighbor_offsets(o.m_brick_neighbor_offsets),
+    m_sqrt_table(o.m_sqrt_table),
+    m_open(o.m_open),
+    m_rem_stack(o.m_rem_stack),
+    m_error(o.m_error)
+{
+    rewire();
+}
+
+auto SparseDistanceMap::operator=(const SparseDistanceMap& rhs)
+    -> SparseDistanceMap&
+{
+    if (this != &rhs) {
+        DistanceMapInterface::operator=(rhs);
+        m_cells = rhs.m_cells;
+        m_cell_count_x = rhs.m_cell_count_x;
+        m_cell_count_y = rhs.m_cell_count_y;
+        m_cell_count_z = rhs.m_cell_count_z;
+        m_max_dist = rhs.m_max_dist;
+        m_inv_res = rhs.m_inv_res;
+        m_dmax_int = rhs.m_dmax_int;
+        m_dmax_sqrd_int = rhs.m_dmax_sqrd_int;
+        m_bucket = rhs.m_bucket;
+        m_neighbors = rhs.m_neighbors;
+        m_indices = rhs.m_indices;
+        m_neighbor_ranges = rhs.m_neighbor_ranges;
+        m_neighbor_dirs = rhs.m_neighbor_dirs;
+        m_brick_neighbor_offsets = rhs.m_brick_neighbor_offsets;
+        m_sqrt_table = rhs.m_sqrt_table;
+        m_open = rhs.m_open;
+        m_rem_stack = rhs.m_rem_stack;
+        m_error = rhs.m_error;
+        rewire();
+    }
+    return *this;
+}
+
 /// Return the distance value for an invalid cell.
 double SparseDistanceMap::maxDistance() const
 {
     return m_max_dist;
 }
 
+auto SparseDistanceMap::memoryUsage() const -> std::size_t
+{
+    return m_cells.mem_usage() +
+            MemoryUsage(m_sqrt_table) +
+            MemoryUsage(m_open) +
+            MemoryUsage(m_rem_stack);
+}
+
 /// Return the distance of a cell from its nearest obstacle. This function will
 /// also consider the distance to the nearest border cell. A value of 0.0 is
 /// returned for obstacle cells and cells outside of the bounding volume.
@@ -147,7 +214,6 @@ void SparseDistanceMap::addPointsToMap(
         if (c.dist_new > 0) {
             c.dir = NO_UPDATE_DIR;
             c.dist_new = 0;
-            c.obs = &c;
             c.ox = gx;
             c.oy = gy;
             c.oz = gz;
@@ -173,12 +239,11 @@ void SparseDistanceMap::removePointsFromMap(
 
         Cell& c = m_cells(gx, gy, gz); // force stable
 
-        if (c.obs != &c) {
+        if (!c.isObstacle(gx, gy, gz)) {
             continue;
         }
 
         c.dist_new = m_dmax_sqrd_int;
-        c.obs = nullptr;
         c.ox = c.oy = c.oz = -1;
 
         c.dist = m_dmax_sqrd_int;
@@ -233,13 +298,12 @@ void SparseDistanceMap::updatePointsInMap(
     // remove obstacle cells that were in the old cloud but not the new cloud
     for (const Eigen::Vector3i& p : old_not_new) {
         Cell& c = m_cells(p.x(), p.y(), p.z()); // force stable
-        if (c.obs != &c) {
+        if (!c.isObstacle(p.x(), p.y(), p.z())) {
             continue; // skip already-free cells
         }
         c.dir = NO_UPDATE_DIR;
         c.dist_new = m_dmax_sqrd_int;
         c.dist = m_dmax_sqrd_int;
-        c.obs = nullptr;
         c.ox = c.oy = c.oz = -1;
         m_rem_stack.emplace_back(p.x(), p.y(), p.z());
     }
@@ -254,7 +318,6 @@ void SparseDistanceMap::updatePointsInMap(
         }
         c.dir = NO_UPDATE_DIR;
         c.dist_new = 0;
-        c.obs = &c;
         c.ox = p.x();
         c.oy = p.y();
         c.oz = p.z();
@@ -274,7 +337,6 @@ void SparseDistanceMap::reset()
 #if SMPL_DMAP_RETURN_CHANGED_CELLS
     initial.dist_old = m_dmax_sqrd_int;
 #endif
-    initial.obs = nullptr;
     initial.ox = initial.oy = initial.oz = -1;
 
     initial.bucket = -1;
@@ -283,6 +345,147 @@ void SparseDistanceMap::reset()
     m_cells.reset(initial);
 }
 
+/// Write the contents of the distance map to a binary snapshot that can later
+/// be restored with load() into a map of the same geometry. Only cells with a
+/// nearest obstacle are recorded.
+bool SparseDistanceMap::save(const std::string& path) const
+{
+    DistanceMapFileHeader header;
+    initFileHeader(header);
+
+    DistanceMapFileWriter writer;
+    if (!writer.open(path, header)) {
+        return false;
+    }
+
+    std::vector<CellRecord> records;
+    records.reserve(4096);
+    bool ok = true;
+    auto flush = [&]() {
+        ok = ok && writer.write(records.data(), records.size());
+        records.clear();
+    };
+
+    m_cells.accept_coords([&](
+        const Cell& c,
+        int xmin, int ymin, int zmin,
+        int xmax, int ymax, int zmax)
+    {
+        if (!c.hasObstacle() && c.dist == m_dmax_sqrd_int) {
+            return;
+        }
+        xmax = std::min(xmax, m_cell_count_x);
+        ymax = std::min(ymax, m_cell_count_y);
+        zmax = std::min(zmax, m_cell_count_z);
+        for (int x = xmin; x < xmax; ++x) {
+        for (int y = ymin; y < ymax; ++y) {
+        for (int z = zmin; z < zmax; ++z) {
+            CellRecord r;
+            r.x = x;
+            r.y = y;
+            r.z = z;
+            r.dist = c.dist;
+            r.dist_new = c.dist_new;
+            r.ox = c.ox;
+            r.oy = c.oy;
+            r.oz = c.oz;
+            r.dir = c.dir;
+            records.push_back(r);
+            if (records.size() == records.capacity()) {
+                flush();
+            }
+        }
+        }
+        }
+    });
+    flush();
+
+    return writer.close() && ok;
+}
+
+/// Restore the contents of the distance map from a snapshot written by save().
+/// The snapshot is memory-mapped and must have been written by a map of the
+/// same size, resolution, and maximum distance. On failure, the map is left
+/// unmodified.
+bool SparseDistanceMap::load(const std::string& path)
+{
+    DistanceMapFileReader reader;
+    if (!reader.open(path)) {
+        return false;
+    }
+
+    DistanceMapFileHeader expected;
+    initFileHeader(expected);
+    if (!CheckDistanceMapFileHeader(expected, reader.header())) {
+        return false;
+    }
+
+    auto* records = static_cast<const CellRecord*>(reader.records());
+    const std::size_t count = reader.header().record_count;
+    for (std::size_t i = 0; i < count; ++i) {
+        const CellRecord& r = records[i];
+        if (!isCellValid(r.x, r.y, r.z) ||
+            (r.ox >= 0 && !isCellValid(r.ox, r.oy, r.oz)) ||
+            r.dir < 0 || r.dir >= NUM_DIRECTIONS)
+        {
+            SMPL_ERROR("Distance map snapshot '%s' contains an invalid cell", path.c_str());
+            return false;
+        }
+    }
+
+    reset();
+
+    for (std::size_t i = 0; i < count; ++i) {
+        const CellRecord& r = records[i];
+        Cell& c = m_cells(r.x, r.y, r.z); // force stable
+        c.dist = r.dist;
+        c.dist_new = r.dist_new;
+#if SMPL_DMAP_RETURN_CHANGED_CELLS
+        c.dist_old = r.dist;
+#endif
+        c.ox = r.ox;
+        c.oy = r.oy;
+        c.oz = r.oz;
+        c.bucket = -1;
+        c.dir = r.dir;
+    }
+
+    for (auto& bucket : m_open) {
+        bucket.clear();
+    }
+    m_rem_stack.clear();
+    m_bucket = (int)m_open.size();
+    return true;
+}
+
+// Point the open list references of copied cells at the cells in this map
+// rather than the map they were copied from. The open list is empty between
+// updates, so this usually leaves all bricks shared with the source map.
+void SparseDistanceMap::rewire()
+{
+    for (auto& bucket : m_open) {
+        for (auto& e : bucket) {
+            e.c = &m_cells(e.x, e.y, e.z);
+        }
+    }
+}
+
+void SparseDistanceMap::initFileHeader(DistanceMapFileHeader& header) const
+{
+    InitDistanceMapFileHeader(header, "sparse_euclid", sizeof(CellRecord));
+    header.cell_count_x = m_cell_count_x;
+    header.cell_count_y = m_cell_count_y;
+    header.cell_count_z = m_cell_count_z;
+    header.origin[0] = m_origin_x;
+    header.origin[1] = m_origin_y;
+    header.origin[2] = m_origin_z;
+    header.size[0] = m_size_x;
+    header.size[1] = m_size_y;
+    header.size[2] = m_size_z;
+    header.resolution = m_res;
+    header.max_dist = m_max_dist;
+}
+
 /// Return the number of cells along the x axis.
 int SparseDistanceMap::numCellsX() const
 {
@@ -397,10 +600,44 @@ int SparseDistanceMap::distance(int nx, int ny, int nz, const Cell& s)
     return dx * dx + dy * dy + dz * dz;
 }
 
+// Return whether a cell's nearest obstacle is still an obstacle
+bool SparseDistanceMap::nearestObstacleValid(const Cell& c) const
+{
+    return c.hasObstacle() &&
+            m_cells.get(c.ox, c.oy, c.oz).isObstacle(c.ox, c.oy, c.oz);
+}
+
 void SparseDistanceMap::lower(Cell* s, int sx, int sy, int sz)
 {
     int nfirst, nlast;
     std::tie(nfirst, nlast) = m_neighbor_ranges[s->dir];
+
+    // fast path for cells whose neighbors are all within the same brick, and
+    // therefore within the map and at fixed offsets from the cell
+    if (BrickGrid<Cell>::brick_interior(sx, sy, sz) &&
+        sx + 1 < m_cell_count_x &&
+        sy + 1 < m_cell_count_y &&
+        sz + 1 < m_cell_count_z)
+    {
+        for (int i = nfirst; i != nlast; ++i) {
+            Cell* n = s + m_brick_neighbor_offsets[i];
+            const Eigen::Vector3i& neighbor = m_neighbors[m_indices[i]];
+            const int nx = sx + neighbor.x();
+            const int ny = sy + neighbor.y();
+            const int nz = sz + neighbor.z();
+            int dp = distance(nx, ny, nz, *s);
+            if (dp < n->dist_new) {
+                n->dist_new = dp;
+                n->ox = s->ox;
+                n->oy = s->oy;
+                n->oz = s->oz;
+                n->dir = m_neighbor_dirs[i];
+                updateVertex(n, nx, ny, nz);
+            }
+        }
+        return;
+    }
+
     for (int i = nfirst; i != nlast; ++i) {
         const Eigen::Vector3i& neighbor = m_neighbors[m_indices[i]];
         const Eigen::Vector3i& nx = Eigen::Vector3i(sx, sy, sz) + neighbor;
@@ -414,7 +651,6 @@ void SparseDistanceMap::lower(Cell* s, int sx, int sy, int sz)
             int dp = distance(nx.x(), nx.y(), nx.z(), *s);
             if (dp < n->dist_new) {
                 n->dist_new = dp;
-                n->obs = s->obs;
                 n->ox = s->ox;
                 n->oy = s->oy;
                 n->oz = s->oz;
@@ -443,14 +679,15 @@ void SparseDistanceMap::raise(Cell* s, int sx, int sy, int sz)
 
 void SparseDistanceMap::waveout(Cell* n, int nx, int ny, int nz)
 {
-    if (n == n->obs) {
+    if (n->isObstacle(nx, ny, nz)) {
         return;
     }
 
     n->dist_new = m_dmax_sqrd_int;
-    Cell* obs_old = n->obs;
-    n->obs = nullptr;
-    n->ox = n->oy = n->oz = -1; // TODO(Andrew: required?)
+    const int ox_old = n->ox;
+    const int oy_old = n->oy;
+    const int oz_old = n->oz;
+    n->ox = n->oy = n->oz = -1;
 
     int nfirst, nlast;
     std::tie(nfirst, nlast) = m_neighbor_ranges[NO_UPDATE_DIR];
@@ -460,22 +697,20 @@ void SparseDistanceMap::waveout(Cell* n, int nx, int ny, int nz)
         if (!isCellValid(ax)) {
             continue;
         }
-        Cell* a = &m_cells(ax.x(), ax.y(), ax.z()); // force stable
-        auto valid = [](Cell* c) { return c && c->obs == c; };
-        if (valid(a->obs)) {
-            int dp = distance(nx, ny, nz, *a);
+        const Cell& a = m_cells.get(ax.x(), ax.y(), ax.z());
+        if (nearestObstacleValid(a)) {
+            int dp = distance(nx, ny, nz, a);
             if (dp < n->dist_new) {
                 n->dist_new = dp;
-                n->obs = a->obs;
-                n->ox = a->ox;
-                n->oy = a->oy;
-                n->oz = a->oz;
+                n->ox = a.ox;
+                n->oy = a.oy;
+                n->oz = a.oz;
                 n->dir = NO_UPDATE_DIR;
             }
         }
     }
 
-    if (n->obs != obs_old) {
+    if (n->ox != ox_old || n->oy != oy_old || n->oz != oz_old) {
 //        n->dir = NO_UPDATE_DIR;
         updateVertex(n, nx, ny, nz);
     }
@@ -537,12 +772,10 @@ void SparseDistanceMap::propagateRemovals()
                 continue;
             }
             Cell* n = &m_cells(nx.x(), nx.y(), nx.z()); // force stable
-            auto valid = [](Cell* c) { return c && c->obs == c; };
-            if (!valid(n->obs)) {
+            if (!nearestObstacleValid(*n)) {
                 if (n->dist_new != m_dmax_sqrd_int) {
                     n->dist_new = m_dmax_sqrd_int;
                     n->dist = m_dmax_sqrd_int;
-                    n->obs = nullptr;
                     n->ox = n->oy = n->oz = -1;
                     n->dir = NO_UPDATE_DIR;
                     m_rem_stack.emplace_back(nx.x(), nx.y(), nx.z());
@@ -556,7 +789,7 @@ void SparseDistanceMap::propagateRemovals()
     propagateBorder();
 
     // see note in Cell::operator==
-    m_cells.prune([&](const Cell& c) { return !c.obs; });
+    m_cells.prune([&](const Cell& c) { return !c.hasObstacle(); });
 }
 
 void SparseDistanceMap::propagateBorder()
@@ -671,7 +904,7 @@ double SparseDistanceMap::getTrueMetricSquaredDistance(
             if (SparseDistanceMap::isCellValid(gppx, gppy, gppz)) {
                 const Cell& c = m_cells.get(gppx, gppy, gppz);
 
-                if (c.obs) { // known nearest obstacle -> nearest distance to it
+                if (c.hasObstacle()) { // known nearest obstacle -> nearest distance to it
                     const double d2 = nearestEdgeDist(c.ox, c.oy, c.oz);
                     if (d2 < min_d2) {
                         min_d2 = d2;
@@ -687,7 +920,7 @@ double SparseDistanceMap::getTrueMetricSquaredDistance(
         for (int gppz = gpz - 1; gppz != gpz + 2; ++gppz) {
             const Cell& c = m_cells.get(gppx, gppy, gppz);
 
-            if (c.obs) { // known nearest obstacle -> nearest distance to it
+            if (c.hasObstacle()) { // known nearest obstacle -> nearest distance to it
                 const double d2 = nearestEdgeDist(c.ox, c.oy, c.oz);
                 if (d2 < min_d2) {
                     min_d2 = d2;
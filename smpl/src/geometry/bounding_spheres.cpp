@@ -30,10 +30,14 @@
 #include <smpl/geometry/bounding_spheres.h>
 
 // standard includes
+#include <cmath>
 #include <cstdio>
 #include <algorithm>
+#include <queue>
+#include <utility>
 
 // project includes
+#include <smpl/geometry/kd_tree.h>
 #include <smpl/geometry/voxelize.h>
 #include <smpl/geometry/mesh_utils.h>
 
@@ -314,5 +318,230 @@ void ComputeMeshBoundingSpheres(
             });
 }
 
+/// \brief Cover the surface of a box with a minimal set of spheres.
+///
+/// See ComputeMeshCoveringSpheres(). This function will only append spheres to
+/// the output vectors.
+void ComputeBoxCoveringSpheres(
+    double length, double width, double height,
+    double max_overshoot,
+    std::vector<Vector3>& centers,
+    std::vector<double>& radii)
+{
+    std::vector<Vector3> vertices;
+    std::vector<std::uint32_t> triangles;
+    CreateIndexedBoxMesh(length, width, height, vertices, triangles);
+    ComputeMeshCoveringSpheres(vertices, triangles, max_overshoot, centers, radii);
+}
+
+/// \brief Cover the surface of a sphere with a minimal set of spheres.
+///
+/// See ComputeMeshCoveringSpheres(). This function will only append spheres to
+/// the output vectors.
+void ComputeSphereCoveringSpheres(
+    double cradius,
+    double max_overshoot,
+    std::vector<Vector3>& centers,
+    std::vector<double>& radii)
+{
+    std::vector<Vector3> vertices;
+    std::vector<std::uint32_t> triangles;
+    CreateIndexedSphereMesh(cradius, 7, 8, vertices, triangles);
+    ComputeMeshCoveringSpheres(vertices, triangles, max_overshoot, centers, radii);
+}
+
+/// \brief Cover the surface of a cylinder with a minimal set of spheres.
+///
+/// See ComputeMeshCoveringSpheres(). This function will only append spheres to
+/// the output vectors.
+void ComputeCylinderCoveringSpheres(
+    double cradius, double cheight,
+    double max_overshoot,
+    std::vector<Vector3>& centers,
+    std::vector<double>& radii)
+{
+    std::vector<Vector3> vertices;
+    std::vector<std::uint32_t> triangles;
+    CreateIndexedCylinderMesh(cradius, cheight, vertices, triangles);
+    ComputeMeshCoveringSpheres(vertices, triangles, max_overshoot, centers, radii);
+}
+
+/// \brief Cover the surface of a cone with a minimal set of spheres.
+///
+/// See ComputeMeshCoveringSpheres(). This function will only append spheres to
+/// the output vectors.
+void ComputeConeCoveringSpheres(
+    double cradius, double cheight,
+    double max_overshoot,
+    std::vector<Vector3>& centers,
+    std::vector<double>& radii)
+{
+    std::vector<Vector3> vertices;
+    std::vector<std::uint32_t> triangles;
+    CreateIndexedConeMesh(cradius, cheight, vertices, triangles);
+    ComputeMeshCoveringSpheres(vertices, triangles, max_overshoot, centers, radii);
+}
+
+template <class VertexIndexer>
+void ComputeMeshCoveringSpheresInternal(
+    VertexIndexer indexer,
+    size_t vertex_count,
+    const std::uint32_t* indices,
+    size_t triangle_count,
+    double max_overshoot,
+    std::vector<Vector3>& centers,
+    std::vector<double>& radii)
+{
+    if (max_overshoot <= 0.0 || triangle_count == 0) {
+        return;
+    }
+
+    std::vector<Vector3> vertices(vertex_count);
+    for (size_t i = 0; i < vertex_count; ++i) {
+        vertices[i] = Vector3(indexer.x(i), indexer.y(i), indexer.z(i));
+    }
+    std::vector<std::uint32_t> triangles(indices, indices + 3 * triangle_count);
+
+    // sample the surface finely, so that the error from testing coverage and
+    // overshoot against surface voxel centers is a small fraction of the
+    // allowed overshoot, and sample candidate sphere centers more coarsely
+    // from the volume
+    const double surface_res = 0.25 * max_overshoot / std::sqrt(3.0);
+    const double half_diag = 0.125 * max_overshoot;
+    const double solid_res = max_overshoot / std::sqrt(3.0);
+
+    std::vector<Vector3> surface;
+    std::vector<Vector3> solid;
+    VoxelizeMesh(vertices, triangles, surface_res, Vector3::Zero(), surface, false);
+    VoxelizeMesh(vertices, triangles, solid_res, Vector3::Zero(), solid, true);
+    if (surface.empty()) {
+        return;
+    }
+
+    std::vector<double> surface_points(3 * surface.size());
+    for (size_t i = 0; i < surface.size(); ++i) {
+        surface_points[3 * i + 0] = surface[i].x();
+        surface_points[3 * i + 1] = surface[i].y();
+        surface_points[3 * i + 2] = surface[i].z();
+    }
+    KDTree tree;
+    tree.build(surface_points.data(), surface.size(), 3);
+
+    // candidate spheres are centered at solid voxels far enough from the
+    // surface to be certainly inside the mesh, as large as they can be without
+    // extending more than the allowed overshoot past the nearest surface
+    // voxel, and at the surface voxels themselves, with the allowed overshoot
+    // less the voxel's distance from the surface. a candidate covers the
+    // surface voxels that lie entirely within it
+    std::vector<Vector3> candidate_centers;
+    std::vector<double> candidate_radii;
+    std::vector<std::size_t> nbrs;
+    const double min_depth = 0.5 * max_overshoot + half_diag;
+    for (auto& p : solid) {
+        tree.nearest(p.data(), 1, nbrs);
+        const double d = (p - surface[nbrs.front()]).norm();
+        if (d > min_depth) {
+            candidate_centers.push_back(p);
+            candidate_radii.push_back(d - half_diag + max_overshoot);
+        }
+    }
+    for (auto& p : surface) {
+        candidate_centers.push_back(p);
+        candidate_radii.push_back(max_overshoot - half_diag);
+    }
+
+    // greedy set cover, lazily re-evaluating the number of surface voxels a
+    // candidate covers only when it reaches the top of the queue
+    std::vector<bool> covered(surface.size(), false);
+    size_t uncovered = surface.size();
+
+    using Candidate = std::pair<size_t, size_t>; // (gain, index)
+    std::priority_queue<Candidate> open;
+    for (size_t i = 0; i < candidate_centers.size(); ++i) {
+        auto& c = candidate_centers[i];
+        tree.radius(c.data(), candidate_radii[i] - half_diag, nbrs);
+        open.push(Candidate(nbrs.size(), i));
+    }
+
+    while (uncovered > 0 && !open.empty()) {
+        const size_t i = open.top().second;
+        open.pop();
+
+        auto& c = candidate_centers[i];
+        tree.radius(c.data(), candidate_radii[i] - half_diag, nbrs);
+        size_t gain = 0;
+        for (auto n : nbrs) {
+            if (!covered[n]) {
+                ++gain;
+            }
+        }
+
+        if (gain == 0) {
+            continue;
+        }
+
+        if (!open.empty() && gain < open.top().first) {
+            open.push(Candidate(gain, i));
+            continue;
+        }
+
+        for (auto n : nbrs) {
+            if (!covered[n]) {
+                covered[n] = true;
+                --uncovered;
+            }
+        }
+        centers.push_back(c);
+        radii.push_back(candidate_radii[i]);
+    }
+}
+
+/// \brief Cover the surface of a mesh with a minimal set of spheres.
+///
+/// Unlike ComputeMeshBoundingSpheres(), which places equal spheres along the
+/// surface, spheres of varying radius are chosen greedily from the interior of
+/// the mesh to cover its surface, each extending no further than
+/// \p max_overshoot past the surface. The mesh should be closed; the surface is
+/// sampled at a fraction of \p max_overshoot, so that coverage and overshoot
+/// hold up to a small discretization error. This is considerably more expensive than
+/// ComputeMeshBoundingSpheres() and is intended for offline model generation.
+///
+/// This function will only append spheres to the output vectors.
+void ComputeMeshCoveringSpheres(
+    const std::vector<Vector3>& vertices,
+    const std::vector<std::uint32_t>& indices,
+    double max_overshoot,
+    std::vector<Vector3>& centers,
+    std::vector<double>& radii)
+{
+    ComputeMeshCoveringSpheresInternal(
+            EigenVertexArrayIndexer(vertices),
+            vertices.size(),
+            indices.data(),
+            indices.size() / 3,
+            max_overshoot,
+            centers,
+            radii);
+}
+
+void ComputeMeshCoveringSpheres(
+    const double* vertex_data,
+    size_t vertex_count,
+    const std::uint32_t* triangle_data,
+    size_t triangle_count,
+    double max_overshoot,
+    std::vector<Vector3>& centers,
+    std::vector<double>& radii)
+{
+    ComputeMeshCoveringSpheresInternal(
+            DoubleArrayVertexArrayIndexer(vertex_data),
+            vertex_count,
+            triangle_data,
+            triangle_count,
+            max_overshoot,
+            centers,
+            radii);
+}
+
 } // namespace geometry
 } // namespace smpl
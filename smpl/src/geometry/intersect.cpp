@@ -32,6 +32,12 @@
 // standard includes
 #include <cmath>
 #include <algorithm>
+#include <limits>
+
+// system includes
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 // project includes
 #include <smpl/geometry/triangle.h>
@@ -40,6 +46,264 @@
 namespace smpl {
 namespace geometry {
 
+namespace {
+
+// Lanes of doubles processed together by the batch intersection tests. Each
+// lane type provides the same set of operations, so that the kernels below are
+// written once and instantiated for the widest available instruction set, with
+// the scalar lanes handling the remainder of each batch.
+
+struct ScalarLanes
+{
+    using V = double;
+    using M = bool;
+    static const int width = 1;
+
+    static V load(const double* p) { return *p; }
+    static V set1(double a) { return a; }
+    static V add(V a, V b) { return a + b; }
+    static V sub(V a, V b) { return a - b; }
+    static V mul(V a, V b) { return a * b; }
+    static V min(V a, V b) { return std::min(a, b); }
+    static V max(V a, V b) { return std::max(a, b); }
+    static V abs(V a) { return std::fabs(a); }
+    static M le(V a, V b) { return a <= b; }
+    static M and_(M a, M b) { return a && b; }
+    static int bits(M m) { return m ? 1 : 0; }
+};
+
+#if defined(__SSE2__)
+struct SSELanes
+{
+    using V = __m128d;
+    using M = __m128d;
+    static const int width = 2;
+
+    static V load(const double* p) { return _mm_loadu_pd(p); }
+    static V set1(double a) { return _mm_set1_pd(a); }
+    static V add(V a, V b) { return _mm_add_pd(a, b); }
+    static V sub(V a, V b) { return _mm_sub_pd(a, b); }
+    static V mul(V a, V b) { return _mm_mul_pd(a, b); }
+    static V min(V a, V b) { return _mm_min_pd(a, b); }
+    static V max(V a, V b) { return _mm_max_pd(a, b); }
+    static V abs(V a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+    static M le(V a, V b) { return _mm_cmple_pd(a, b); }
+    static M and_(M a, M b) { return _mm_and_pd(a, b); }
+    static int bits(M m) { return _mm_movemask_pd(m); }
+};
+#endif
+
+#if defined(__AVX__)
+struct AVXLanes
+{
+    using V = __m256d;
+    using M = __m256d;
+    static const int width = 4;
+
+    static V load(const double* p) { return _mm256_loadu_pd(p); }
+    static V set1(double a) { return _mm256_set1_pd(a); }
+    static V add(V a, V b) { return _mm256_add_pd(a, b); }
+    static V sub(V a, V b) { return _mm256_sub_pd(a, b); }
+    static V mul(V a, V b) { return _mm256_mul_pd(a, b); }
+    static V min(V a, V b) { return _mm256_min_pd(a, b); }
+    static V max(V a, V b) { return _mm256_max_pd(a, b); }
+    static V abs(V a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+    static M le(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+    static M and_(M a, M b) { return _mm256_and_pd(a, b); }
+    static int bits(M m) { return _mm256_movemask_pd(m); }
+};
+#endif
+
+#if defined(__AVX__)
+using WideLanes = AVXLanes;
+#elif defined(__SSE2__)
+using WideLanes = SSELanes;
+#else
+using WideLanes = ScalarLanes;
+#endif
+
+template <typename L>
+void StoreHits(typename L::M m, std::uint8_t* hits)
+{
+    const int b = L::bits(m);
+    for (int i = 0; i < L::width; ++i) {
+        hits[i] = (b >> i) & 1;
+    }
+}
+
+// A separating axis test of a triangle against a box, in the frame of the box
+// center, for the 13 axes of the Akenine-Moller test, reduced to an interval
+// [lo, hi] of the projection of the box center onto each axis. With the
+// triangle fixed, testing a box is 13 dot products and comparisons.
+struct TriangleBoxAxes
+{
+    double axis[13][3];
+    double lo[13];
+    double hi[13];
+
+    TriangleBoxAxes(const Triangle& tr, const Vector3& h)
+    {
+        const Vector3 e[3] = { tr.b - tr.a, tr.c - tr.b, tr.a - tr.c };
+        int k = 0;
+        auto add_axis = [&](const Vector3& u)
+        {
+            const double pa = u.dot(tr.a);
+            const double pb = u.dot(tr.b);
+            const double pc = u.dot(tr.c);
+            const double r =
+                    h.x() * std::fabs(u.x()) +
+                    h.y() * std::fabs(u.y()) +
+                    h.z() * std::fabs(u.z());
+            axis[k][0] = u.x();
+            axis[k][1] = u.y();
+            axis[k][2] = u.z();
+            lo[k] = std::min(pa, std::min(pb, pc)) - r;
+            hi[k] = std::max(pa, std::max(pb, pc)) + r;
+            ++k;
+        };
+        add_axis(Vector3::UnitX());
+        add_axis(Vector3::UnitY());
+        add_axis(Vector3::UnitZ());
+        add_axis(e[0].cross(e[1]));
+        for (int i = 0; i < 3; ++i) {
+            add_axis(Vector3::UnitX().cross(e[i]));
+            add_axis(Vector3::UnitY().cross(e[i]));
+            add_axis(Vector3::UnitZ().cross(e[i]));
+        }
+    }
+};
+
+template <typename L>
+void TriangleBoxesIntersect(
+    const TriangleBoxAxes& axes,
+    const double* x,
+    const double* y,
+    const double* z,
+    std::uint8_t* hits)
+{
+    const typename L::V cx = L::load(x);
+    const typename L::V cy = L::load(y);
+    const typename L::V cz = L::load(z);
+    typename L::M in = L::le(cx, cx); // all lanes set
+    for (int k = 0; k < 13; ++k) {
+        const typename L::V s = L::add(
+                L::mul(L::set1(axes.axis[k][0]), cx),
+                L::add(
+                        L::mul(L::set1(axes.axis[k][1]), cy),
+                        L::mul(L::set1(axes.axis[k][2]), cz)));
+        in = L::and_(in, L::and_(
+                L::le(L::set1(axes.lo[k]), s),
+                L::le(s, L::set1(axes.hi[k]))));
+    }
+    StoreHits<L>(in, hits);
+}
+
+// Test whether the interval of the projections p0, p1, p2 intersects [-r, r]
+template <typename L>
+typename L::M Overlaps(
+    typename L::V p0,
+    typename L::V p1,
+    typename L::V p2,
+    typename L::V r)
+{
+    const typename L::V lo = L::min(p0, L::min(p1, p2));
+    const typename L::V hi = L::max(p0, L::max(p1, p2));
+    return L::and_(
+            L::le(lo, r),
+            L::le(L::sub(L::set1(0.0), r), hi));
+}
+
+template <typename L>
+void TrianglesBoxIntersect(
+    const double* const v[9],
+    int i,
+    const Vector3& c,
+    const Vector3& h,
+    std::uint8_t* hits)
+{
+    using V = typename L::V;
+
+    // vertices relative to the box center
+    V p[3][3];
+    for (int j = 0; j < 3; ++j) {
+        for (int d = 0; d < 3; ++d) {
+            p[j][d] = L::sub(L::load(v[3 * j + d] + i), L::set1(c[d]));
+        }
+    }
+
+    const V hx = L::set1(h.x());
+    const V hy = L::set1(h.y());
+    const V hz = L::set1(h.z());
+    const V hv[3] = { hx, hy, hz };
+
+    // box face axes
+    typename L::M in = Overlaps<L>(p[0][0], p[1][0], p[2][0], hx);
+    in = L::and_(in, Overlaps<L>(p[0][1], p[1][1], p[2][1], hy));
+    in = L::and_(in, Overlaps<L>(p[0][2], p[1][2], p[2][2], hz));
+
+    V e[3][3];
+    for (int j = 0; j < 3; ++j) {
+        for (int d = 0; d < 3; ++d) {
+            e[j][d] = L::sub(p[(j + 1) % 3][d], p[j][d]);
+        }
+    }
+
+    // triangle normal axis
+    {
+        const V nx = L::sub(L::mul(e[0][1], e[1][2]), L::mul(e[0][2], e[1][1]));
+        const V ny = L::sub(L::mul(e[0][2], e[1][0]), L::mul(e[0][0], e[1][2]));
+        const V nz = L::sub(L::mul(e[0][0], e[1][1]), L::mul(e[0][1], e[1][0]));
+        const V pn = L::add(L::mul(nx, p[0][0]),
+                L::add(L::mul(ny, p[0][1]), L::mul(nz, p[0][2])));
+        const V r = L::add(L::mul(hx, L::abs(nx)),
+                L::add(L::mul(hy, L::abs(ny)), L::mul(hz, L::abs(nz))));
+        in = L::and_(in, Overlaps<L>(pn, pn, pn, r));
+    }
+
+    // cross products of the box axes with the triangle edges; the axis for
+    // box axis a and edge (ex, ey, ez) has zero component a, and components
+    // (-e[a2], e[a1]) along the other two box axes a1 and a2
+    for (int j = 0; j < 3; ++j) {
+        for (int a = 0; a < 3; ++a) {
+            const int a1 = (a + 1) % 3;
+            const int a2 = (a + 2) % 3;
+            const V u1 = L::sub(L::set1(0.0), e[j][a2]);
+            const V u2 = e[j][a1];
+            const V p0 = L::add(L::mul(u1, p[0][a1]), L::mul(u2, p[0][a2]));
+            const V p1 = L::add(L::mul(u1, p[1][a1]), L::mul(u2, p[1][a2]));
+            const V p2 = L::add(L::mul(u1, p[2][a1]), L::mul(u2, p[2][a2]));
+            const V r = L::add(
+                    L::mul(hv[a1], L::abs(u1)), L::mul(hv[a2], L::abs(u2)));
+            in = L::and_(in, Overlaps<L>(p0, p1, p2, r));
+        }
+    }
+
+    StoreHits<L>(in, hits + i);
+}
+
+template <typename L>
+void SpheresBoxIntersect(
+    const double* const s[4],
+    int i,
+    const Vector3& c,
+    const Vector3& h,
+    std::uint8_t* hits)
+{
+    using V = typename L::V;
+
+    // squared distance from each sphere center to the box
+    V dist_sqrd = L::set1(0.0);
+    for (int d = 0; d < 3; ++d) {
+        const V q = L::abs(L::sub(L::load(s[d] + i), L::set1(c[d])));
+        const V o = L::max(L::sub(q, L::set1(h[d])), L::set1(0.0));
+        dist_sqrd = L::add(dist_sqrd, L::mul(o, o));
+    }
+    const V r = L::load(s[3] + i);
+    StoreHits<L>(L::le(dist_sqrd, L::mul(r, r)), hits + i);
+}
+
+} // namespace
+
 static bool PointOnTriangle(
     const Vector3& p,
     const Vector3& a,
@@ -348,5 +612,98 @@ bool Intersects(const Triangle& tr1, const Triangle& tr2, double eps)
     return t2 >= t3 && t1 <= t4;
 }
 
+/// \brief Test a triangle against an axis-aligned box
+///
+/// This is the separating axis test of Akenine-Moller, "Fast 3D Triangle-Box
+/// Overlap Testing", Journal of Graphics Tools, 2001.
+bool Intersects(
+    const Triangle& tr,
+    const Vector3& box_center,
+    const Vector3& box_half_extents)
+{
+    std::uint8_t hit;
+    Intersects(
+            tr,
+            &box_center.x(), &box_center.y(), &box_center.z(),
+            1,
+            box_half_extents,
+            &hit);
+    return hit;
+}
+
+/// \brief Test a triangle against many axis-aligned boxes of the same size
+void Intersects(
+    const Triangle& tr,
+    const double* box_center_x,
+    const double* box_center_y,
+    const double* box_center_z,
+    int count,
+    const Vector3& box_half_extents,
+    std::uint8_t* hits)
+{
+    const TriangleBoxAxes axes(tr, box_half_extents);
+    int i = 0;
+    for (; i + WideLanes::width <= count; i += WideLanes::width) {
+        TriangleBoxesIntersect<WideLanes>(
+                axes, box_center_x + i, box_center_y + i, box_center_z + i,
+                hits + i);
+    }
+    for (; i < count; ++i) {
+        TriangleBoxesIntersect<ScalarLanes>(
+                axes, box_center_x + i, box_center_y + i, box_center_z + i,
+                hits + i);
+    }
+}
+
+/// \brief Test many triangles against an axis-aligned box
+///
+/// The i'th triangle has vertices (ax[i], ay[i], az[i]), (bx[i], by[i], bz[i]),
+/// and (cx[i], cy[i], cz[i]).
+void Intersects(
+    const double* ax, const double* ay, const double* az,
+    const double* bx, const double* by, const double* bz,
+    const double* cx, const double* cy, const double* cz,
+    int count,
+    const Vector3& box_center,
+    const Vector3& box_half_extents,
+    std::uint8_t* hits)
+{
+    const double* const v[9] = { ax, ay, az, bx, by, bz, cx, cy, cz };
+    int i = 0;
+    for (; i + WideLanes::width <= count; i += WideLanes::width) {
+        TrianglesBoxIntersect<WideLanes>(
+                v, i, box_center, box_half_extents, hits);
+    }
+    for (; i < count; ++i) {
+        TrianglesBoxIntersect<ScalarLanes>(
+                v, i, box_center, box_half_extents, hits);
+    }
+}
+
+/// \brief Test many spheres against an axis-aligned box
+void Intersects(
+    const double* sphere_center_x,
+    const double* sphere_center_y,
+    const double* sphere_center_z,
+    const double* sphere_radius,
+    int count,
+    const Vector3& box_center,
+    const Vector3& box_half_extents,
+    std::uint8_t* hits)
+{
+    const double* const s[4] = {
+        sphere_center_x, sphere_center_y, sphere_center_z, sphere_radius
+    };
+    int i = 0;
+    for (; i + WideLanes::width <= count; i += WideLanes::width) {
+        SpheresBoxIntersect<WideLanes>(
+                s, i, box_center, box_half_extents, hits);
+    }
+    for (; i < count; ++i) {
+        SpheresBoxIntersect<ScalarLanes>(
+                s, i, box_center, box_half_extents, hits);
+    }
+}
+
 } // namespace geometry
 } // namespace smpl
@@ -0,0 +1,228 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+/// \author Andrew Dornbush
+
+#include <smpl/geometry/kd_tree.h>
+
+// standard includes
+#include <algorithm>
+#include <numeric>
+
+namespace smpl {
+namespace geometry {
+
+// subtrees with at most this many points are scanned linearly
+static const std::size_t KDTreeLeafSize = 8;
+
+void KDTree::build(const double* points, std::size_t count, std::size_t dim)
+{
+    m_dim = dim;
+    m_index.resize(count);
+    std::iota(m_index.begin(), m_index.end(), 0);
+    m_split.assign(count, 0);
+
+    buildRange(points, 0, count);
+
+    // gather the points into tree order
+    m_points.resize(count * dim);
+    for (std::size_t i = 0; i < count; ++i) {
+        auto* p = points + m_index[i] * dim;
+        std::copy(p, p + dim, m_points.begin() + i * dim);
+    }
+}
+
+void KDTree::clear()
+{
+    m_dim = 0;
+    m_points.clear();
+    m_index.clear();
+    m_split.clear();
+}
+
+void KDTree::buildRange(const double* points, std::size_t lo, std::size_t hi)
+{
+    if (hi - lo <= KDTreeLeafSize || m_dim == 0) {
+        return;
+    }
+
+    // split along the dimension of greatest spread
+    std::size_t split = 0;
+    double best_spread = -1.0;
+    for (std::size_t d = 0; d < m_dim; ++d) {
+        auto minv = points[m_index[lo] * m_dim + d];
+        auto maxv = minv;
+        for (auto i = lo + 1; i < hi; ++i) {
+            auto v = points[m_index[i] * m_dim + d];
+            minv = std::min(minv, v);
+            maxv = std::max(maxv, v);
+        }
+        if (maxv - minv > best_spread) {
+            best_spread = maxv - minv;
+            split = d;
+        }
+    }
+
+    auto mid = lo + (hi - lo) / 2;
+    std::nth_element(
+            m_index.begin() + lo,
+            m_index.begin() + mid,
+            m_index.begin() + hi,
+            [&](std::size_t a, std::size_t b) {
+                return points[a * m_dim + split] < points[b * m_dim + split];
+            });
+    m_split[mid] = (std::uint16_t)split;
+
+    buildRange(points, lo, mid);
+    buildRange(points, mid + 1, hi);
+}
+
+double KDTree::squaredDistance(const double* query, std::size_t i) const
+{
+    auto* p = point(i);
+    double d2 = 0.0;
+    for (std::size_t d = 0; d < m_dim; ++d) {
+        auto diff = query[d] - p[d];
+        d2 += diff * diff;
+    }
+    return d2;
+}
+
+/// Find the k points nearest to a query point. The indices of the points are
+/// returned in order of increasing distance.
+void KDTree::nearest(
+    const double* query,
+    std::size_t k,
+    std::vector<std::size_t>& indices) const
+{
+    indices.clear();
+    if (k == 0 || m_index.empty()) {
+        return;
+    }
+
+    std::vector<Candidate> heap;
+    heap.reserve(std::min(k, m_index.size()) + 1);
+    nearestRange(query, k, 0, m_index.size(), heap);
+
+    std::sort_heap(heap.begin(), heap.end());
+    indices.reserve(heap.size());
+    for (auto& c : heap) {
+        indices.push_back(m_index[c.second]);
+    }
+}
+
+void KDTree::nearestRange(
+    const double* query,
+    std::size_t k,
+    std::size_t lo,
+    std::size_t hi,
+    std::vector<Candidate>& heap) const
+{
+    auto consider = [&](std::size_t i) {
+        auto d2 = squaredDistance(query, i);
+        if (heap.size() < k) {
+            heap.emplace_back(d2, i);
+            std::push_heap(heap.begin(), heap.end());
+        } else if (d2 < heap.front().first) {
+            std::pop_heap(heap.begin(), heap.end());
+            heap.back() = Candidate(d2, i);
+            std::push_heap(heap.begin(), heap.end());
+        }
+    };
+
+    if (hi - lo <= KDTreeLeafSize || m_dim == 0) {
+        for (auto i = lo; i < hi; ++i) {
+            consider(i);
+        }
+        return;
+    }
+
+    auto mid = lo + (hi - lo) / 2;
+    consider(mid);
+
+    auto diff = query[m_split[mid]] - point(mid)[m_split[mid]];
+    if (diff < 0.0) {
+        nearestRange(query, k, lo, mid, heap);
+        if (heap.size() < k || diff * diff < heap.front().first) {
+            nearestRange(query, k, mid + 1, hi, heap);
+        }
+    } else {
+        nearestRange(query, k, mid + 1, hi, heap);
+        if (heap.size() < k || diff * diff < heap.front().first) {
+            nearestRange(query, k, lo, mid, heap);
+        }
+    }
+}
+
+/// Find all points within a distance of a query point. The indices of the
+/// points are returned in no particular order.
+void KDTree::radius(
+    const double* query,
+    double radius,
+    std::vector<std::size_t>& indices) const
+{
+    indices.clear();
+    if (radius < 0.0 || m_index.empty()) {
+        return;
+    }
+    radiusRange(query, radius * radius, 0, m_index.size(), indices);
+}
+
+void KDTree::radiusRange(
+    const double* query,
+    double r2,
+    std::size_t lo,
+    std::size_t hi,
+    std::vector<std::size_t>& indices) const
+{
+    if (hi - lo <= KDTreeLeafSize || m_dim == 0) {
+        for (auto i = lo; i < hi; ++i) {
+            if (squaredDistance(query, i) <= r2) {
+                indices.push_back(m_index[i]);
+            }
+        }
+        return;
+    }
+
+    auto mid = lo + (hi - lo) / 2;
+    if (squaredDistance(query, mid) <= r2) {
+        indices.push_back(m_index[mid]);
+    }
+
+    auto diff = query[m_split[mid]] - point(mid)[m_split[mid]];
+    if (diff <= 0.0 || diff * diff <= r2) {
+        radiusRange(query, r2, lo, mid, indices);
+    }
+    if (diff >= 0.0 || diff * diff <= r2) {
+        radiusRange(query, r2, mid + 1, hi, indices);
+    }
+}
+
+} // namespace geometry
+} // namespace smpl
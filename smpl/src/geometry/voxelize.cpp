@@ -32,6 +32,8 @@
 // standard includes
 #include <cmath>
 #include <cstdlib>
+#include <limits>
+#include <thread>
 #include <algorithm>
 #include <utility>
 
@@ -40,6 +42,7 @@
 #include <smpl/geometry/intersect.h>
 #include <smpl/geometry/mesh_utils.h>
 #include <smpl/geometry/triangle.h>
+#include <smpl/worker_pool.h>
 
 namespace smpl {
 namespace geometry {
@@ -48,23 +51,53 @@ namespace geometry {
 // Static Function Declarations //
 //////////////////////////////////
 
-template <typename Discretizer>
-static void VoxelizeMesh(
-    const std::vector<Vector3>& vertices,
-    const std::vector<std::uint32_t>& indices,
+// Triangle accessor over a vertex vector and a flat index vector
+struct IndexedVectorMesh
+{
+    const std::vector<Vector3>& vertices;
+    const std::vector<std::uint32_t>& indices;
+
+    std::size_t triangleCount() const { return indices.size() / 3; }
+
+    void triangle(std::size_t t, Vector3& a, Vector3& b, Vector3& c) const
+    {
+        a = vertices[indices[3 * t + 0]];
+        b = vertices[indices[3 * t + 1]];
+        c = vertices[indices[3 * t + 2]];
+    }
+};
+
+// Triangle accessor over a MeshView, transforming vertices as they are read
+struct TransformedMeshView
+{
+    const MeshView& mesh;
+    const Affine3& pose;
+
+    std::size_t triangleCount() const { return mesh.triangle_count; }
+
+    void triangle(std::size_t t, Vector3& a, Vector3& b, Vector3& c) const
+    {
+        auto* tri = mesh.triangle(t);
+        a = pose * mesh.vertex(tri[0]);
+        b = pose * mesh.vertex(tri[1]);
+        c = pose * mesh.vertex(tri[2]);
+    }
+};
+
+template <typename Mesh, typename Discretizer>
+static void VoxelizeTriangles(
+    const Mesh& mesh,
     VoxelGrid<Discretizer>& vg,
     bool fill = false);
 
-template <typename Discretizer>
+template <typename Mesh, typename Discretizer>
 static void VoxelizeMeshAwesome(
-    const std::vector<Vector3>& vertices,
-    const std::vector<std::uint32_t>& indices,
+    const Mesh& mesh,
     VoxelGrid<Discretizer>& vg);
 
-template <typename Discretizer>
+template <typename Mesh, typename Discretizer>
 void VoxelizeMeshNaive(
-    const std::vector<Vector3>& vertices,
-    const std::vector<std::uint32_t>& triangles,
+    const Mesh& mesh,
     VoxelGrid<Discretizer>& vg);
 
 template <typename Discretizer>
@@ -72,11 +105,6 @@ void ExtractVoxels(
     const VoxelGrid<Discretizer>& vg,
     std::vector<Vector3>& voxels);
 
-static bool IsInDiscreteBoundingBox(
-    const MemoryCoord& mc,
-    const MemoryCoord& minmc,
-    const MemoryCoord& maxmc);
-
 /// \brief Fill the interior of a voxel grid via scanning
 template <typename Discretizer>
 static void ScanFill(VoxelGrid<Discretizer>& vg);
@@ -97,23 +125,24 @@ static bool CompareX(const Vector3& u, const Vector3& v);
 static bool CompareY(const Vector3& u, const Vector3& v);
 static bool CompareZ(const Vector3& u, const Vector3& v);
 
+static int VoxelizeThreadCount(size_t work_items);
+
 /////////////////////////////////
 // Static Function Definitions //
 /////////////////////////////////
 
-template <typename Discretizer>
-static void VoxelizeMesh(
-    const std::vector<Vector3>& vertices,
-    const std::vector<std::uint32_t>& indices,
+template <typename Mesh, typename Discretizer>
+static void VoxelizeTriangles(
+    const Mesh& mesh,
     VoxelGrid<Discretizer>& vg,
     bool fill)
 {
     const bool awesome = true;
     if (awesome) {
-        VoxelizeMeshAwesome(vertices, indices, vg);
+        VoxelizeMeshAwesome(mesh, vg);
     }
     else {
-        VoxelizeMeshNaive(vertices, indices, vg);
+        VoxelizeMeshNaive(mesh, vg);
     }
 
     if (fill) {
@@ -121,36 +150,87 @@ static void VoxelizeMesh(
     }
 }
 
-template <typename Discretizer>
+/// Large meshes are voxelized in parallel. The grid is split into slabs along
+/// x, each triangle is binned into the slabs its bounding box overlaps, and
+/// each slab is voxelized by one thread. Slabs write disjoint voxels and each
+/// voxel test depends only on the voxel and the triangle, so the output is the
+/// same as voxelizing the triangles serially.
+template <typename Mesh, typename Discretizer>
 void VoxelizeMeshAwesome(
-    const std::vector<Vector3>& vertices,
-    const std::vector<std::uint32_t>& indices,
+    const Mesh& mesh,
     VoxelGrid<Discretizer>& vg)
 {
-    for (size_t i = 0; i < indices.size(); i += 3) {
-        auto& a = vertices[indices[i + 0]];
-        auto& b = vertices[indices[i + 1]];
-        auto& c = vertices[indices[i + 2]];
-        VoxelizeTriangle(a, b, c, vg);
+    auto triangle_count = mesh.triangleCount();
+    auto thread_count = VoxelizeThreadCount(triangle_count);
+    Vector3 a, b, c;
+    if (thread_count <= 1) {
+        for (size_t t = 0; t < triangle_count; ++t) {
+            mesh.triangle(t, a, b, c);
+            VoxelizeTriangle(a, b, c, vg);
+        }
+        return;
+    }
+
+    // x range of the grid cells covered by each triangle
+    std::vector<std::pair<int, int>> tri_ranges(triangle_count);
+    auto min_gx = std::numeric_limits<int>::max();
+    auto max_gx = std::numeric_limits<int>::min();
+    for (size_t t = 0; t < triangle_count; ++t) {
+        mesh.triangle(t, a, b, c);
+        auto lo = std::min(a.x(), std::min(b.x(), c.x()));
+        auto hi = std::max(a.x(), std::max(b.x(), c.x()));
+        auto lo_gx = vg.worldToGrid(WorldCoord(lo, a.y(), a.z())).x;
+        auto hi_gx = vg.worldToGrid(WorldCoord(hi, a.y(), a.z())).x;
+        tri_ranges[t] = std::make_pair(lo_gx, hi_gx);
+        min_gx = std::min(min_gx, lo_gx);
+        max_gx = std::max(max_gx, hi_gx);
     }
+
+    // a few slabs per thread to balance uneven triangle densities
+    auto slab_count = std::min(4 * thread_count, max_gx - min_gx + 1);
+    auto slab_width = (max_gx - min_gx + slab_count) / slab_count;
+
+    std::vector<std::vector<std::uint32_t>> slab_triangles(slab_count);
+    for (size_t t = 0; t < triangle_count; ++t) {
+        auto first = (tri_ranges[t].first - min_gx) / slab_width;
+        auto last = (tri_ranges[t].second - min_gx) / slab_width;
+        for (auto s = first; s <= last; ++s) {
+            slab_triangles[s].push_back((std::uint32_t)t);
+        }
+    }
+
+    WorkerPool pool(thread_count);
+    pool.run(slab_count, [&](int tid, size_t s)
+    {
+        auto slab_min_gx = min_gx + (int)s * slab_width;
+        auto slab_max_gx = slab_min_gx + slab_width - 1;
+        Vector3 a, b, c;
+        for (auto t : slab_triangles[s]) {
+            mesh.triangle(t, a, b, c);
+            VoxelizeTriangle(a, b, c, vg, slab_min_gx, slab_max_gx);
+        }
+    });
 }
 
-template <typename Discretizer>
+/// Each triangle is tested against the voxels within its bounding box, in
+/// batches, with the vectorized triangle-box test.
+template <typename Mesh, typename Discretizer>
 void VoxelizeMeshNaive(
-    const std::vector<Vector3>& vertices,
-    const std::vector<std::uint32_t>& triangles,
+    const Mesh& mesh,
     VoxelGrid<Discretizer>& vg)
 {
-    // create a triangle mesh for the voxel grid surrounding the mesh
-    // TODO: use indexed mesh
-    std::vector<Vector3> voxel_mesh;
-    CreateGridMesh(vg, voxel_mesh);
+    const Vector3 half_extents = 0.5 * vg.res();
+
+    std::vector<MemoryIndex> cells;
+    std::vector<double> cx;
+    std::vector<double> cy;
+    std::vector<double> cz;
+    std::vector<std::uint8_t> hits;
 
-    for (std::size_t tidx = 0; tidx < triangles.size(); tidx += 3) {
+    Vector3 pt1, pt2, pt3;
+    for (std::size_t tidx = 0; tidx < mesh.triangleCount(); ++tidx) {
         // get the vertices of the triangle as Point
-        const Vector3& pt1 = vertices[triangles[tidx + 0]];
-        const Vector3& pt2 = vertices[triangles[tidx + 1]];
-        const Vector3& pt3 = vertices[triangles[tidx + 2]];
+        mesh.triangle(tidx, pt1, pt2, pt3);
 
         // pack those vertices into my Triangle struct
         Triangle triangle(pt1, pt2, pt3);
@@ -170,24 +250,39 @@ void VoxelizeMeshNaive(
         const MemoryCoord minmc = vg.worldToMemory(minwc);
         const MemoryCoord maxmc = vg.worldToMemory(maxwc);
 
-        // voxels in the voxel mesh are ordered by the memory index
-        for (std::size_t a = 0; a < voxel_mesh.size() / 3; ++a) {
-            int voxelNum = a / 12; // there are 12 mesh triangles per voxel
-
-            const MemoryIndex mi(voxelNum);
-            const MemoryCoord mc = vg.indexToMemory(mi);
-
-            // if not already filled, is in the bounding voxel grid of the
-            // triangle, and this voxel mesh triangle Intersects the current
-            // triangle, fill in the voxel
-
-            Triangle t(voxel_mesh[3 * a], voxel_mesh[3 * a + 1], voxel_mesh[3 * a + 2]);
+        // gather the unfilled voxels in the bounding voxel grid of the triangle
+        cells.clear();
+        cx.clear();
+        cy.clear();
+        cz.clear();
+        for (int x = std::max(minmc.x, 0); x <= std::min(maxmc.x, vg.sizeX() - 1); ++x) {
+        for (int y = std::max(minmc.y, 0); y <= std::min(maxmc.y, vg.sizeY() - 1); ++y) {
+        for (int z = std::max(minmc.z, 0); z <= std::min(maxmc.z, vg.sizeZ() - 1); ++z) {
+            const MemoryCoord mc(x, y, z);
+            const MemoryIndex mi = vg.memoryToIndex(mc);
+            if (vg[mi]) {
+                continue;
+            }
+            const WorldCoord wc = vg.memoryToWorld(mc);
+            cells.push_back(mi);
+            cx.push_back(wc.x);
+            cy.push_back(wc.y);
+            cz.push_back(wc.z);
+        }
+        }
+        }
 
-            if (!vg[mi] &&
-                IsInDiscreteBoundingBox(mc, minmc, maxmc) &&
-                Intersects(triangle, t))
-            {
-                vg[mi] = true;
+        hits.resize(cells.size());
+        Intersects(
+                triangle,
+                cx.data(), cy.data(), cz.data(),
+                (int)cells.size(),
+                half_extents,
+                hits.data());
+
+        for (std::size_t i = 0; i < cells.size(); ++i) {
+            if (hits[i]) {
+                vg[cells[i]] = true;
             }
         }
     }
@@ -248,23 +343,9 @@ bool ComputeAxisAlignedBoundingBox(
     return true;
 }
 
-bool IsInDiscreteBoundingBox(
-    const MemoryCoord& mc,
-    const MemoryCoord& minmc,
-    const MemoryCoord& maxmc)
-{
-    bool inside = true;
-    inside &= mc.x >= minmc.x && mc.x <= maxmc.x;
-    inside &= mc.y >= minmc.y && mc.y <= maxmc.y;
-    inside &= mc.z >= minmc.z && mc.z <= maxmc.z;
-    return inside;
-}
-
-
 template <typename Discretizer>
-void ScanFill(VoxelGrid<Discretizer>& vg)
+static void ScanFillX(VoxelGrid<Discretizer>& vg, int x)
 {
-    for (int x = 0; x < vg.sizeX(); x++) {
         for (int y = 0; y < vg.sizeY(); y++) {
             const int OUTSIDE = 0;
             const int ON_BOUNDARY_FROM_OUTSIDE = 1;
@@ -305,7 +386,27 @@ void ScanFill(VoxelGrid<Discretizer>& vg)
                 }
             }
         }
+}
+
+/// Each (x, y) column is scanned independently, so the columns are split by x
+/// across threads for large grids.
+template <typename Discretizer>
+void ScanFill(VoxelGrid<Discretizer>& vg)
+{
+    auto thread_count = VoxelizeThreadCount(
+            (size_t)vg.sizeX() * vg.sizeY() * vg.sizeZ() / 256);
+    if (thread_count <= 1) {
+        for (int x = 0; x < vg.sizeX(); x++) {
+            ScanFillX(vg, x);
+        }
+        return;
     }
+
+    WorkerPool pool(thread_count);
+    pool.run(vg.sizeX(), [&](int tid, size_t x)
+    {
+        ScanFillX(vg, (int)x);
+    });
 }
 
 void TransformVertices(
@@ -351,6 +452,18 @@ double Distance(
     }
 }
 
+/// Return the number of threads to spread a job of the given size over. Small
+/// jobs stay serial, since the threads would cost more than the work.
+int VoxelizeThreadCount(size_t work_items)
+{
+    const size_t min_items_per_thread = 1024;
+    auto hw_threads = (int)std::thread::hardware_concurrency();
+    if (hw_threads <= 1) {
+        return 1;
+    }
+    return (int)std::min((size_t)hw_threads, work_items / min_items_per_thread);
+}
+
 bool CompareX(const Vector3& u, const Vector3& v)
 {
     return u.x() < v.x();
@@ -684,7 +797,7 @@ void VoxelizeMesh(
     const Vector3 size = max - min;
     HalfResVoxelGrid vg(min, size, Vector3(res, res, res));
 
-    VoxelizeMesh(vertices, indices, vg, fill);
+    VoxelizeTriangles(IndexedVectorMesh{ vertices, indices }, vg, fill);
     ExtractVoxels(vg, voxels);
 }
 
@@ -729,7 +842,7 @@ void VoxelizeMesh(
 //    PivotVoxelGrid vg(min, size, Vector3(res, res, res), voxel_origin);
     PivotVoxelGrid vg(min, max, Vector3(res, res, res), voxel_origin, 0);
 
-    VoxelizeMesh(vertices, triangles, vg, fill);
+    VoxelizeTriangles(IndexedVectorMesh{ vertices, triangles }, vg, fill);
     ExtractVoxels(vg, voxels);
 }
 
@@ -751,6 +864,38 @@ void VoxelizeMesh(
     VoxelizeMesh(v_copy, indices, res, voxel_origin, voxels, fill);
 }
 
+/// \brief Voxelize a mesh, read in place from a view, at a given pose using a
+///     specified origin for the voxel grid
+///
+/// Vertices are transformed as they are read, so no copies of the vertex or
+/// index data are made. Output voxels are appended to the input voxel vector.
+void VoxelizeMesh(
+    const MeshView& mesh,
+    const Affine3& pose,
+    double res,
+    const Vector3& voxel_origin,
+    std::vector<Vector3>& voxels,
+    bool fill)
+{
+    if (mesh.vertex_count == 0) {
+        SMPL_ERROR("Failed to compute AABB of mesh vertices");
+        return;
+    }
+
+    Vector3 min = pose * mesh.vertex(0);
+    Vector3 max = min;
+    for (std::size_t i = 1; i < mesh.vertex_count; ++i) {
+        auto v = Vector3(pose * mesh.vertex(i));
+        min = min.cwiseMin(v);
+        max = max.cwiseMax(v);
+    }
+
+    PivotVoxelGrid vg(min, max, Vector3(res, res, res), voxel_origin, 0);
+
+    VoxelizeTriangles(TransformedMeshView{ mesh, pose }, vg, fill);
+    ExtractVoxels(vg, voxels);
+}
+
 /// \brief Voxelize a plane within a given bounding box
 void VoxelizePlane(
     double a, double b, double c, double d,
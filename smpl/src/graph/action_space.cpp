@@ -31,6 +31,9 @@
 
 #include <smpl/graph/action_space.h>
 
+// standard includes
+#include <algorithm>
+
 // project includes
 #include <smpl/graph/robot_planning_space.h>
 
@@ -50,4 +53,23 @@ bool ActionSpace::init(RobotPlanningSpace* space)
     return true;
 }
 
+bool ActionSpace::applyBuffered(
+    const RobotState& parent,
+    std::vector<Action>& actions,
+    size_t& count)
+{
+    std::vector<Action> applied;
+    if (!apply(parent, applied)) {
+        count = 0;
+        return false;
+    }
+
+    count = applied.size();
+    if (actions.size() < count) {
+        actions.resize(count);
+    }
+    std::move(applied.begin(), applied.end(), actions.begin());
+    return true;
+}
+
 } // namespace smpl
@@ -37,6 +37,7 @@
 
 // project includes
 #include <smpl/angles.h>
+#include <smpl/collision_checker.h>
 #include <smpl/console/nonstd.h>
 #include <smpl/debug/visualize.h>
 #include <smpl/debug/marker_utils.h>
@@ -77,6 +78,15 @@ std::ostream& operator<<(std::ostream& o, const AdaptiveWorkspaceState& s)
     return o;
 }
 
+static
+auto MakeWorkspacePose(const WorkspaceState& state) -> Affine3
+{
+    return Translation3(state[0], state[1], state[2]) *
+            AngleAxis(state[5], Vector3::UnitZ()) *
+            AngleAxis(state[4], Vector3::UnitY()) *
+            AngleAxis(state[3], Vector3::UnitX());
+}
+
 AdaptiveWorkspaceLattice::~AdaptiveWorkspaceLattice()
 {
     for (AdaptiveState* state : m_states) {
@@ -104,11 +114,22 @@ bool AdaptiveWorkspaceLattice::init(
 
     m_grid = grid;
 
-    m_dim_grid.assign(
+    m_models.robot = robot();
+    m_models.ik = m_ik_iface;
+    m_models.rm = m_rm_iface;
+    m_models.fk = m_fk_iface;
+    m_models.checker = collisionChecker();
+    m_plan_models = Models();
+    m_robot_clone.reset();
+    m_checker_clone.reset();
+    m_track_thread = std::thread::id();
+
+    m_dim_grid.resize(
             m_grid->numCellsX(),
             m_grid->numCellsY(),
             m_grid->numCellsZ(),
             AdaptiveGridCell());
+    m_tunnel_cells.clear();
 
     m_goal_state_id = reserveHashEntry(true);
     m_goal_state = getHashEntry(m_goal_state_id);
@@ -125,7 +146,7 @@ bool AdaptiveWorkspaceLattice::projectToPoint(
     int state_id,
     Vector3& pos)
 {
-    AdaptiveState* state = m_states[state_id];
+    AdaptiveState* state = getHashEntry(state_id);
     if (state_id == m_goal_state_id) {
         pos = goal().pose.translation();
     } else if (state->hid) {
@@ -147,7 +168,7 @@ bool AdaptiveWorkspaceLattice::projectToPoint(
 
 bool AdaptiveWorkspaceLattice::addHighDimRegion(int state_id)
 {
-    AdaptiveState* state = m_states[state_id];
+    AdaptiveState* state = getHashEntry(state_id);
 
     Eigen::Vector3i gp;
 
@@ -180,8 +201,10 @@ bool AdaptiveWorkspaceLattice::addHighDimRegion(int state_id)
         return false;
     }
 
-    ++m_dim_grid(gp.x(), gp.y(), gp.z()).grow_count;
-    const int radius = m_region_radius * m_dim_grid(gp.x(), gp.y(), gp.z()).grow_count;
+    auto center = m_dim_grid.get(gp.x(), gp.y(), gp.z());
+    ++center.grow_count;
+    m_dim_grid.set(gp.x(), gp.y(), gp.z(), center);
+    const int radius = m_region_radius * center.grow_count;
     SMPL_INFO_NAMED(G_LOG, "  radius: %d", radius);
 
     // TODO: mark cells as in high-dimensional region
@@ -191,12 +214,17 @@ bool AdaptiveWorkspaceLattice::addHighDimRegion(int state_id)
     for (int dz = -radius; dz <= radius; ++dz) {
         Eigen::Vector3i p = gp + Eigen::Vector3i(dx, dy, dz);
         if (m_grid->isInBounds(p.x(), p.y(), p.z())) {
-            m_dim_grid(p.x(), p.y(), p.z()).plan_hd = true;
+            auto cell = m_dim_grid.get(p.x(), p.y(), p.z());
+            if (!cell.plan_hd) {
+                cell.plan_hd = true;
+                m_dim_grid.set_lazy(p.x(), p.y(), p.z(), cell);
+            }
             ++marked;
         }
     }
     }
     }
+    m_dim_grid.prune();
 
     SMPL_INFO_NAMED(G_LOG, "Marked %d cells as high-dimensional", marked);
 
@@ -205,17 +233,19 @@ bool AdaptiveWorkspaceLattice::addHighDimRegion(int state_id)
 
 bool AdaptiveWorkspaceLattice::setTunnel(const std::vector<int>& states)
 {
-    // clear the tunnel grid
-    // TODO: retain the list of points in the tunnel and clear only those points
-    for (auto it = m_dim_grid.begin(); it != m_dim_grid.end(); ++it) {
-        it->trak_hd = false;
+    // clear the previous tunnel
+    for (auto& p : m_tunnel_cells) {
+        auto cell = m_dim_grid.get(p.x(), p.y(), p.z());
+        cell.trak_hd = false;
+        m_dim_grid.set_lazy(p.x(), p.y(), p.z(), cell);
     }
+    m_tunnel_cells.clear();
 
     std::vector<Eigen::Vector3i> tunnel;
     for (int state_id : states) {
         double px, py, pz;
 
-        AdaptiveState* state = m_states[state_id];
+        AdaptiveState* state = getHashEntry(state_id);
 
         if (state_id == m_goal_state_id) {
             px = goal().pose.translation()[0];
@@ -258,13 +288,19 @@ bool AdaptiveWorkspaceLattice::setTunnel(const std::vector<int>& states)
         for (int dz = -radius; dz <= radius; ++dz) {
             Eigen::Vector3i p = gp + Eigen::Vector3i(dx, dy, dz);
             if (m_grid->isInBounds(p.x(), p.y(), p.z())) {
-                m_dim_grid(p.x(), p.y(), p.z()).trak_hd = true;
+                auto cell = m_dim_grid.get(p.x(), p.y(), p.z());
+                if (!cell.trak_hd) {
+                    cell.trak_hd = true;
+                    m_dim_grid.set_lazy(p.x(), p.y(), p.z(), cell);
+                    m_tunnel_cells.push_back(p);
+                }
                 ++marked;
             }
         }
         }
         }
     }
+    m_dim_grid.prune();
     SMPL_INFO_NAMED(G_LOG, "Marked %d cells as tunnel cells", marked);
 
     return true;
@@ -287,15 +323,57 @@ bool AdaptiveWorkspaceLattice::setTrackMode(const std::vector<int>& tunnel)
     if (!setTunnel(tunnel)) {
         return false;
     }
-    m_plan_mode = false;
-    SV_SHOW_INFO_NAMED(TrackAdaptiveGridVisName, getAdaptiveGridVisualization(m_plan_mode));
+    m_track_thread = std::this_thread::get_id();
+    SV_SHOW_INFO_NAMED(TrackAdaptiveGridVisName, getAdaptiveGridVisualization(false));
     return true;
 }
 
 bool AdaptiveWorkspaceLattice::setPlanMode()
 {
-    m_plan_mode = true;
-    SV_SHOW_INFO_NAMED(PlanAdaptiveGridVisName, getAdaptiveGridVisualization(m_plan_mode));
+    m_track_thread = std::thread::id();
+    SV_SHOW_INFO_NAMED(PlanAdaptiveGridVisName, getAdaptiveGridVisualization(true));
+    return true;
+}
+
+bool AdaptiveWorkspaceLattice::enableConcurrentPlanning()
+{
+    if (m_plan_models.robot) {
+        return true;
+    }
+
+    if (!initialized()) {
+        return false;
+    }
+
+    auto* robot_cloner = robot()->getExtension<RobotModelCloneExtension>();
+    auto* checker_cloner =
+            collisionChecker()->getExtension<CollisionCheckerCloneExtension>();
+    if (!robot_cloner || !checker_cloner) {
+        SMPL_WARN_NAMED(G_LOG, "Concurrent planning requires cloneable robot model and collision checker");
+        return false;
+    }
+
+    auto robot_clone = robot_cloner->clone();
+    auto checker_clone = checker_cloner->clone();
+    if (!robot_clone || !checker_clone) {
+        SMPL_WARN_NAMED(G_LOG, "Failed to clone robot model or collision checker");
+        return false;
+    }
+
+    Models models;
+    models.robot = robot_clone.get();
+    models.ik = robot_clone->getExtension<InverseKinematicsInterface>();
+    models.rm = robot_clone->getExtension<RedundantManipulatorInterface>();
+    models.fk = robot_clone->getExtension<ForwardKinematicsInterface>();
+    models.checker = checker_clone.get();
+    if (!models.ik || !models.rm || !models.fk) {
+        SMPL_WARN_NAMED(G_LOG, "Robot model clone does not support the required kinematics interfaces");
+        return false;
+    }
+
+    m_robot_clone = std::move(robot_clone);
+    m_checker_clone = std::move(checker_clone);
+    m_plan_models = models;
     return true;
 }
 
@@ -431,12 +509,15 @@ bool AdaptiveWorkspaceLattice::setStart(const RobotState& state)
     WorkspaceCoord start_coord;
     stateRobotToCoord(state, start_coord);
 
-    m_start_state_id = getHiHashEntry(start_coord);
-    if (m_start_state_id < 0) {
-        m_start_state_id = createHiState(start_coord, state);
-    }
+    m_start_state_id = getOrCreateHiState(start_coord, state);
     m_start_state = getHashEntry(m_start_state_id);
 
+    // the environment may have changed since the last request
+    {
+        std::lock_guard<std::mutex> lock(m_states_mutex);
+        m_hi_action_checks.clear();
+    }
+
     return RobotPlanningSpace::setStart(state);
 }
 
@@ -469,18 +550,16 @@ void AdaptiveWorkspaceLattice::GetSuccs(
     std::vector<int>* succs,
     std::vector<int>* costs)
 {
-    assert(state_id >= 0 && state_id < (int)m_states.size());
-
     SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "Expand state %d", state_id);
 
     if (state_id == m_goal_state_id) {
         return;
     }
 
-    AdaptiveState* state = m_states[state_id];
+    AdaptiveState* state = getHashEntry(state_id);
     if (state->hid) {
         AdaptiveWorkspaceState* hi_state = (AdaptiveWorkspaceState*)state;
-        GetSuccs(*hi_state, succs, costs);
+        GetSuccs(state_id, *hi_state, succs, costs);
     } else {
         AdaptiveGridState* lo_state = (AdaptiveGridState*)state;
         GetSuccs(*lo_state, succs, costs);
@@ -617,6 +696,12 @@ bool AdaptiveWorkspaceLattice::setGoalPose(const GoalConstraint& goal)
     m_near_goal = false;
     m_t_start = clock::now();
 
+    // snap actions depend on the goal
+    {
+        std::lock_guard<std::mutex> lock(m_states_mutex);
+        m_hi_action_checks.clear();
+    }
+
     return RobotPlanningSpace::setGoal(goal);
 }
 
@@ -694,14 +779,17 @@ void AdaptiveWorkspaceLattice::GetSuccs(
                 WorkspaceCoord succ_coord;
                 RobotState final_rstate;
                 stateWorkspaceToCoord(succ_state, succ_coord);
-                if (!stateWorkspaceToRobot(succ_state, final_rstate)) {
+                RobotState seed(models().robot->jointVariableCount(), 0);
+                for (size_t fai = 0; fai < freeAngleCount(); ++fai) {
+                    seed[m_fangle_indices[fai]] = succ_state[6 + fai];
+                }
+                if (!models().rm->computeFastIK(
+                        MakeWorkspacePose(succ_state), seed, final_rstate))
+                {
                     continue;
                 }
 
-                int succ_id = getHiHashEntry(succ_coord);
-                if (succ_id < 0) {
-                    succ_id = createHiState(succ_coord, final_rstate);
-                }
+                int succ_id = getOrCreateHiState(succ_coord, final_rstate);
 
                 if (isGoal(succ_state)) {
                     succs->push_back(m_goal_state_id);
@@ -718,12 +806,9 @@ void AdaptiveWorkspaceLattice::GetSuccs(
             int succ_coord[3];
             posWorkspaceToCoord(succ_pos, succ_coord);
 
-            int succ_id = getLoHashEntry(tgx, tgy, tgz);
-            if (succ_id < 0) {
-                succ_id = createLoState(
+            int succ_id = getOrCreateLoState(
                     succ_coord[0], succ_coord[1], succ_coord[2],
                     succ_pos[0], succ_pos[1], succ_pos[2]);
-            }
 
             if (isLoGoal(succ_pos[0], succ_pos[1], succ_pos[2])) {
                 succs->push_back(m_goal_state_id);
@@ -737,6 +822,7 @@ void AdaptiveWorkspaceLattice::GetSuccs(
 }
 
 void AdaptiveWorkspaceLattice::GetSuccs(
+    int state_id,
     const AdaptiveWorkspaceState& state,
     std::vector<int>* succs,
     std::vector<int>* costs)
@@ -749,6 +835,15 @@ void AdaptiveWorkspaceLattice::GetSuccs(
     std::vector<Action> actions;
     getActions(state, actions);
 
+    // work on a copy of the cached checks so that actions are checked
+    // without holding the lock
+    std::vector<char> checks;
+    {
+        std::lock_guard<std::mutex> lock(m_states_mutex);
+        checks = m_hi_action_checks[state_id];
+    }
+    checks.resize(actions.size(), ACTION_UNCHECKED);
+
     SMPL_DEBUG_NAMED(G_SUCCESSORS_LOG, "  actions: %zu", actions.size());
     for (std::size_t i = 0; i < actions.size(); ++i) {
         const Action& action = actions[i];
@@ -756,8 +851,14 @@ void AdaptiveWorkspaceLattice::GetSuccs(
         SMPL_DEBUG_NAMED(G_SUCCESSORS_LOG, "    action %zu", i);
         SMPL_DEBUG_NAMED(G_SUCCESSORS_LOG, "      waypoints: %zu", action.size());
 
+        // the final robot state is only needed to create a new successor, so
+        // an action known to be valid is not checked again until then
         RobotState final_rstate;
-        if (!checkAction(state.state, action, &final_rstate)) {
+        if (checks[i] == ACTION_UNCHECKED) {
+            auto valid = checkAction(state.state, action, &final_rstate);
+            checks[i] = valid ? ACTION_VALID : ACTION_INVALID;
+        }
+        if (checks[i] == ACTION_INVALID) {
             continue;
         }
 
@@ -779,7 +880,10 @@ void AdaptiveWorkspaceLattice::GetSuccs(
             SMPL_DEBUG_NAMED(G_SUCCESSORS_LOG, "      -> high-dimensional");
             int succ_id = getHiHashEntry(succ_coord);
             if (succ_id < 0) {
-                succ_id = createHiState(succ_coord, final_rstate);
+                if (final_rstate.empty()) {
+                    checkAction(state.state, action, &final_rstate);
+                }
+                succ_id = getOrCreateHiState(succ_coord, final_rstate);
             }
 
             const bool is_goal_succ = isGoal(final_state);
@@ -790,15 +894,12 @@ void AdaptiveWorkspaceLattice::GetSuccs(
             }
             costs->push_back(120);
 
-            SMPL_DEBUG_STREAM_NAMED(G_SUCCESSORS_LOG, "         succ: { id: " << succs->back() << ", coord: " << succ_coord << ", state: " << final_rstate << ", cost: " << costs->back() << " }");
-        } else if (m_plan_mode) {
+            SMPL_DEBUG_STREAM_NAMED(G_SUCCESSORS_LOG, "         succ: { id: " << succs->back() << ", coord: " << succ_coord << ", state: " << getHiHashEntry(succ_id)->state << ", cost: " << costs->back() << " }");
+        } else if (isPlanMode()) {
             SMPL_DEBUG_NAMED(G_SUCCESSORS_LOG, "      -> low-dimensional");
-            int succ_id = getLoHashEntry(succ_coord[0], succ_coord[1], succ_coord[2]);
-            if (succ_id < 0) {
-                succ_id = createLoState(
-                        succ_coord[0], succ_coord[1], succ_coord[2],
-                        final_state[0], final_state[1], final_state[2]);
-            }
+            int succ_id = getOrCreateLoState(
+                    succ_coord[0], succ_coord[1], succ_coord[2],
+                    final_state[0], final_state[1], final_state[2]);
             if (isLoGoal(final_state[0], final_state[1], final_state[2])) {
                 succs->push_back(m_goal_state_id);
             } else {
@@ -810,8 +911,12 @@ void AdaptiveWorkspaceLattice::GetSuccs(
             SMPL_DEBUG_NAMED(G_SUCCESSORS_LOG, "      -> outside tunnel");
         }
     }
+
+    std::lock_guard<std::mutex> lock(m_states_mutex);
+    m_hi_action_checks[state_id] = std::move(checks);
 }
 
+// Must be called with m_states_mutex held, except during initialization
 int AdaptiveWorkspaceLattice::reserveHashEntry(bool hid)
 {
     AdaptiveState* entry;
@@ -835,17 +940,40 @@ int AdaptiveWorkspaceLattice::reserveHashEntry(bool hid)
     return state_id;
 }
 
+bool AdaptiveWorkspaceLattice::isPlanMode() const
+{
+    return std::this_thread::get_id() != m_track_thread;
+}
+
+auto AdaptiveWorkspaceLattice::models() const -> const Models&
+{
+    if (m_plan_models.robot &&
+        m_track_thread != std::thread::id() &&
+        std::this_thread::get_id() != m_track_thread)
+    {
+        return m_plan_models;
+    }
+    return m_models;
+}
+
 bool AdaptiveWorkspaceLattice::isHighDimensional(int gx, int gy, int gz) const
 {
-    if (m_plan_mode) {
-        return m_dim_grid(gx, gy, gz).plan_hd;
+    return isHighDimensional(gx, gy, gz, isPlanMode());
+}
+
+bool AdaptiveWorkspaceLattice::isHighDimensional(
+    int gx, int gy, int gz, bool plan_mode) const
+{
+    if (plan_mode) {
+        return m_dim_grid.get(gx, gy, gz).plan_hd;
     } else {
-        return m_dim_grid(gx, gy, gz).trak_hd;
+        return m_dim_grid.get(gx, gy, gz).trak_hd;
     }
 }
 
 AdaptiveState* AdaptiveWorkspaceLattice::getHashEntry(int state_id) const
 {
+    std::lock_guard<std::mutex> lock(m_states_mutex);
     assert(state_id >= 0 && state_id < m_states.size());
     return m_states[state_id];
 }
@@ -875,6 +1003,7 @@ int AdaptiveWorkspaceLattice::getHiHashEntry(
 {
     AdaptiveWorkspaceState state;
     state.coord = coord;
+    std::lock_guard<std::mutex> lock(m_states_mutex);
     auto sit = m_hi_to_id.find(&state);
     if (sit == m_hi_to_id.end()) {
         return -1;
@@ -891,6 +1020,7 @@ int AdaptiveWorkspaceLattice::getLoHashEntry(
     state.gx = x;
     state.gy = y;
     state.gz = z;
+    std::lock_guard<std::mutex> lock(m_states_mutex);
     auto sit = m_lo_to_id.find(&state);
     if (sit == m_lo_to_id.end()) {
         return -1;
@@ -898,30 +1028,51 @@ int AdaptiveWorkspaceLattice::getLoHashEntry(
     return sit->second;
 }
 
-int AdaptiveWorkspaceLattice::createHiState(
+int AdaptiveWorkspaceLattice::getOrCreateHiState(
     const WorkspaceCoord& coord,
     const RobotState& state)
 {
+    AdaptiveWorkspaceState key;
+    key.coord = coord;
+
+    std::lock_guard<std::mutex> lock(m_states_mutex);
+    auto sit = m_hi_to_id.find(&key);
+    if (sit != m_hi_to_id.end()) {
+        return sit->second;
+    }
+
     int state_id = reserveHashEntry(true);
-    AdaptiveWorkspaceState* hi_state = getHiHashEntry(state_id);
+    auto* hi_state = (AdaptiveWorkspaceState*)m_states[state_id];
     hi_state->coord = coord;
     hi_state->state = state;
     m_hi_to_id[hi_state] = state_id;
     return state_id;
 }
 
-int AdaptiveWorkspaceLattice::createLoState(
+int AdaptiveWorkspaceLattice::getOrCreateLoState(
     int x, int y, int z,
     double wx, double wy, double wz)
 {
+    AdaptiveGridState key;
+    key.gx = x;
+    key.gy = y;
+    key.gz = z;
+
+    std::lock_guard<std::mutex> lock(m_states_mutex);
+    auto sit = m_lo_to_id.find(&key);
+    if (sit != m_lo_to_id.end()) {
+        return sit->second;
+    }
+
     int state_id = reserveHashEntry(false);
-    AdaptiveGridState* lo_state = getLoHashEntry(state_id);
+    auto* lo_state = (AdaptiveGridState*)m_states[state_id];
     lo_state->gx = x;
     lo_state->gy = y;
     lo_state->gz = z;
     lo_state->x = wx;
     lo_state->y = wy;
     lo_state->z = wz;
+    m_lo_to_id[lo_state] = state_id;
     return state_id;
 }
 
@@ -963,9 +1114,18 @@ void AdaptiveWorkspaceLattice::getActions(
                 cont_state[0], cont_state[1], cont_state[2]);
         if (goal_dist < m_ik_amp_thresh) {
             std::vector<double> ik_sol;
-            if (m_ik_iface->computeIK(goal().pose, state.state, ik_sol)) {
-                WorkspaceState final_state;
-                stateRobotToWorkspace(ik_sol, final_state);
+            if (models().ik->computeIK(goal().pose, state.state, ik_sol)) {
+                auto pose = models().fk->computeFK(ik_sol);
+                WorkspaceState final_state(m_dof_count);
+                final_state[0] = pose.translation().x();
+                final_state[1] = pose.translation().y();
+                final_state[2] = pose.translation().z();
+                angles::get_euler_zyx(
+                        pose.rotation(),
+                        final_state[5], final_state[4], final_state[3]);
+                for (size_t fai = 0; fai < freeAngleCount(); ++fai) {
+                    final_state[6 + fai] = ik_sol[m_fangle_indices[fai]];
+                }
                 Action action(1);
                 action[0] = final_state;
                 actions.push_back(std::move(action));
@@ -979,6 +1139,8 @@ bool AdaptiveWorkspaceLattice::checkAction(
     const Action& action,
     RobotState* final_rstate)
 {
+    auto& models = this->models();
+
     std::vector<RobotState> wptraj;
     wptraj.reserve(action.size());
 
@@ -991,7 +1153,7 @@ bool AdaptiveWorkspaceLattice::checkAction(
         SMPL_DEBUG_STREAM_NAMED(G_SUCCESSORS_LOG, "        " << widx << ": " << istate);
 
         RobotState irstate;
-        if (!stateWorkspaceToRobot(istate, state, irstate)) {
+        if (!models.rm->computeFastIK(MakeWorkspacePose(istate), state, irstate)) {
             SMPL_DEBUG_NAMED(G_SUCCESSORS_LOG, "         -> failed to find ik solution");
             violation_mask |= 0x00000001;
             break;
@@ -999,7 +1161,7 @@ bool AdaptiveWorkspaceLattice::checkAction(
 
         wptraj.push_back(irstate);
 
-        if (!robot()->checkJointLimits(irstate)) {
+        if (!models.robot->checkJointLimits(irstate)) {
             SMPL_DEBUG_NAMED(G_SUCCESSORS_LOG, "        -> violates joint limits");
             violation_mask |= 0x00000002;
             break;
@@ -1013,7 +1175,7 @@ bool AdaptiveWorkspaceLattice::checkAction(
     // check for collisions between the waypoints
     assert(wptraj.size() == action.size());
 
-    if (!collisionChecker()->isStateToStateValid(state, wptraj[0])) {
+    if (!models.checker->isStateToStateValid(state, wptraj[0])) {
         SMPL_DEBUG_NAMED(G_SUCCESSORS_LOG, "        -> path to first waypoint in collision");
         violation_mask |= 0x00000004;
     }
@@ -1025,7 +1187,7 @@ bool AdaptiveWorkspaceLattice::checkAction(
     for (size_t widx = 1; widx < wptraj.size(); ++widx) {
         const RobotState& prev_istate = wptraj[widx - 1];
         const RobotState& curr_istate = wptraj[widx];
-        if (!collisionChecker()->isStateToStateValid(prev_istate, curr_istate)) {
+        if (!models.checker->isStateToStateValid(prev_istate, curr_istate)) {
             SMPL_DEBUG_NAMED(G_SUCCESSORS_LOG, "        -> path between waypoints in collision");
             violation_mask |= 0x00000008;
             break;
@@ -1070,7 +1232,7 @@ auto AdaptiveWorkspaceLattice::getStateVisualization(
     const RobotState& state,
     const std::string& ns) -> std::vector<visual::Marker>
 {
-    auto markers = collisionChecker()->getCollisionModelVisualization(state);
+    auto markers = models().checker->getCollisionModelVisualization(state);
     for (auto& marker : markers) {
         marker.ns = ns;
     }
@@ -1084,7 +1246,7 @@ auto AdaptiveWorkspaceLattice::getAdaptiveGridVisualization(bool plan_mode) cons
     for (int x = 0; x < m_grid->numCellsX(); ++x) {
     for (int y = 0; y < m_grid->numCellsY(); ++y) {
     for (int z = 0; z < m_grid->numCellsZ(); ++z) {
-        if (isHighDimensional(x, y, z)) {
+        if (isHighDimensional(x, y, z, plan_mode)) {
             Vector3 p;
             m_grid->gridToWorld(x, y, z, p.x(), p.y(), p.z());
             points.push_back(p);
@@ -1094,7 +1256,7 @@ auto AdaptiveWorkspaceLattice::getAdaptiveGridVisualization(bool plan_mode) cons
     }
 
     visual::Color color;
-    if (m_plan_mode) {
+    if (plan_mode) {
         color.r = color.a = 1.0f;
         color.g = color.b = 0.0f;
     } else {
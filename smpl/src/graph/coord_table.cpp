@@ -0,0 +1,145 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+/// \author Andrew Dornbush
+
+#include <smpl/graph/coord_table.h>
+
+// standard includes
+#include <assert.h>
+#include <algorithm>
+
+namespace smpl {
+
+static const std::size_t InitialSlotCount = 64;
+
+CoordTable::CoordTable(int width) :
+    m_width(width),
+    m_size(0),
+    m_coords(),
+    m_slots(InitialSlotCount, Slot{ 0, -1 }),
+    m_indexed(0)
+{
+}
+
+void CoordTable::setWidth(int width)
+{
+    assert(width >= 0);
+    m_width = width;
+    clear();
+}
+
+int CoordTable::find(const int* coord) const
+{
+    auto h = hash(coord);
+    auto mask = m_slots.size() - 1;
+    for (auto i = (std::size_t)h & mask; ; i = (i + 1) & mask) {
+        auto& slot = m_slots[i];
+        if (slot.id < 0) {
+            return -1;
+        }
+        if (slot.hash == h && equal(this->coord(slot.id), coord)) {
+            return slot.id;
+        }
+    }
+}
+
+int CoordTable::insert(const int* coord)
+{
+    assert(find(coord) < 0);
+
+    if (2 * (m_indexed + 1) > m_slots.size()) {
+        grow();
+    }
+
+    auto id = m_size++;
+    m_coords.insert(m_coords.end(), coord, coord + m_width);
+    place(hash(coord), id);
+    ++m_indexed;
+    return id;
+}
+
+int CoordTable::reserve()
+{
+    auto id = m_size++;
+    m_coords.resize(m_coords.size() + m_width, 0);
+    return id;
+}
+
+void CoordTable::clear()
+{
+    m_size = 0;
+    m_coords.clear();
+    std::fill(begin(m_slots), end(m_slots), Slot{ 0, -1 });
+    m_indexed = 0;
+}
+
+auto CoordTable::hash(const int* coord) const -> std::uint32_t
+{
+    // FNV-1a over the coordinate values, followed by a final avalanche so
+    // that the low bits used for slot selection depend on every value
+    std::uint32_t h = 2166136261u;
+    for (int i = 0; i < m_width; ++i) {
+        h ^= (std::uint32_t)coord[i];
+        h *= 16777619u;
+    }
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    return h;
+}
+
+bool CoordTable::equal(const int* a, const int* b) const
+{
+    return std::equal(a, a + m_width, b);
+}
+
+void CoordTable::place(std::uint32_t hash, int id)
+{
+    auto mask = m_slots.size() - 1;
+    auto i = (std::size_t)hash & mask;
+    while (m_slots[i].id >= 0) {
+        i = (i + 1) & mask;
+    }
+    m_slots[i] = Slot{ hash, id };
+}
+
+void CoordTable::grow()
+{
+    std::vector<Slot> slots(2 * m_slots.size(), Slot{ 0, -1 });
+    slots.swap(m_slots);
+    for (auto& slot : slots) {
+        if (slot.id >= 0) {
+            place(slot.hash, slot.id);
+        }
+    }
+}
+
+} // namespace smpl
@@ -1,5 +1,5 @@
 ////////////////////////////////////////////////////////////////////////////////
-// Copyright (c) 2010, Andrew Dornbush
+// Copyright (c) 2018, Andrew Dornbush
 // All rights reserved.
 //
 // Redistribution and use in source and binary forms, with or without
@@ -29,95 +29,57 @@
 
 /// \author Andrew Dornbush
 
-#ifndef smpl_manip_profiling_h
-#define smpl_manip_profiling_h
+#include <smpl/graph/cost_function.h>
 
 // standard includes
-#include <chrono>
-#include <functional>
+#include <algorithm>
 
 // project includes
-#include <smpl/time.h>
+#include <smpl/collision_checker.h>
 #include <smpl/console/console.h>
 
-#ifndef SBPL_MANIP_PROFILING
-#define SBPL_MANIP_PROFILING 0
-#endif
-
 namespace smpl {
 
-class RunUponDestruction
-{
-public:
-
-    RunUponDestruction(const std::function<void()>& fun) : fun_(fun) { }
-    ~RunUponDestruction() { fun_(); }
-
-private:
+static const char* LOG = "graph.cost_function";
 
-    std::function<void()> fun_;
-};
-
-class Stopwatch
+CostFunction::~CostFunction()
 {
-public:
-
-    Stopwatch(const std::string& name, int throttle) :
-        m_name(name),
-        m_throttle(throttle),
-        m_then(),
-        m_elapsed(0.0),
-        m_times(0)
-    { }
+}
 
-    // Start a stopwatch and log the call frequency at the throttled rate
-    void start()
-    {
-#if SBPL_MANIP_PROFILING
-        if (m_elapsed != 0.0 && (m_times % m_throttle) == 0) {
-            SMPL_INFO("%s: \t%0.3f Hz", m_name.c_str(), m_times / m_elapsed);
-        }
-        m_then = clock::now();
-#endif
-    }
+int CostFunction::getCostLowerBound(const RobotState& state, const Action& action)
+{
+    return getCost(state, action);
+}
 
-    // Stop a stopwatch
-    void stop()
-    {
-#if SBPL_MANIP_PROFILING
-        auto now = clock::now();
-        m_elapsed += std::chrono::duration<double>(now - m_then).count();
-        ++m_times;
-#endif
+bool ClearanceCostFunction::init(CollisionChecker* checker)
+{
+    m_cdist_iface = checker->getExtension<CollisionDistanceExtension>();
+    if (!m_cdist_iface) {
+        SMPL_WARN_NAMED(LOG, "Clearance cost function requires Collision Distance Extension");
+        return false;
     }
+    return true;
+}
 
-    // Tick a stopwatch and log the call frequency at the throttled rate
-    void tick()
+int ClearanceCostFunction::getCost(const RobotState& state, const Action& action)
+{
+    if (!m_cdist_iface ||
+        m_clearance <= 0.0 || m_weight <= 0.0 || action.empty())
     {
-#if SBPL_MANIP_PROFILING
-    if (m_elapsed != 0.0 && (m_times % m_throttle) == 0) {
-        SMPL_INFO("%s: \t%0.3f Hz", m_name.c_str(), m_times / m_elapsed);
-    }
-    ++m_times;
-#endif
+        return m_base_cost;
     }
 
-private:
+    auto d = m_cdist_iface->distanceToCollision(state, action.back());
+    auto penalty = std::max(0.0, m_clearance - d) / m_clearance;
+    penalty = std::min(penalty, 1.0);
+    return m_base_cost + (int)(m_weight * penalty * m_base_cost);
+}
 
-    const std::string m_name;
-    int m_throttle;
-    clock::time_point m_then;
-    double m_elapsed;
-    int m_times;
-};
+int ClearanceCostFunction::getCostLowerBound(
+    const RobotState& state,
+    const Action& action)
+{
+    return m_base_cost;
+}
 
 } // namespace smpl
-
-// Create an object to automatically stop a stopwatch upon exiting the current scope
-#if SBPL_MANIP_PROFILING
-#define PROFAUTOSTOP(watch) ::smpl::RunUponDestruction watch##_rod([&](){ watch.stop(); });
-#else
-#define PROFAUTOSTOP(watch)
-#endif
-
-#endif
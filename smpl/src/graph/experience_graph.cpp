@@ -235,6 +235,23 @@ void insert_incident_edge(
     }
 }
 
+static
+auto incident_edges(const ExperienceGraph* egraph, ExperienceGraph::node_id id)
+    -> std::pair<
+            ExperienceGraph::adjacent_edge_iterator,
+            ExperienceGraph::adjacent_edge_iterator>
+{
+    if (egraph->m_compact) {
+        auto first = egraph->m_adjacency.begin();
+        return std::make_pair(
+                first + egraph->m_adjacency_offsets[id],
+                first + egraph->m_adjacency_offsets[id + 1]);
+    } else {
+        auto& edges = egraph->m_nodes[id].edges;
+        return std::make_pair(edges.cbegin(), edges.cend());
+    }
+}
+
 /// Return a pair of iterators to the range of nodes in the graph.
 auto ExperienceGraph::nodes() const -> std::pair<node_iterator, node_iterator>
 {
@@ -255,24 +272,27 @@ auto ExperienceGraph::edges() const -> std::pair<edge_iterator, edge_iterator>
 auto ExperienceGraph::edges(node_id id) const
     -> std::pair<incident_edge_iterator, incident_edge_iterator>
 {
+    auto adj = incident_edges(this, id);
     return std::make_pair(
-            incident_edge_iterator(m_nodes[id].edges.begin()),
-            incident_edge_iterator(m_nodes[id].edges.end()));
+            incident_edge_iterator(adj.first),
+            incident_edge_iterator(adj.second));
 }
 
 /// Return a pair of iterators to the range of adjacent nodes for a node.
 auto ExperienceGraph::adjacent_nodes(node_id id) const
     -> std::pair<adjacency_iterator, adjacency_iterator>
 {
+    auto adj = incident_edges(this, id);
     return std::make_pair(
-            adjacency_iterator(m_nodes[id].edges.begin()),
-            adjacency_iterator(m_nodes[id].edges.end()));
+            adjacency_iterator(adj.first),
+            adjacency_iterator(adj.second));
 }
 
 /// Return the degree (number of incident edges) of a node.
 auto ExperienceGraph::degree(node_id id) const -> degree_size_type
 {
-    return m_nodes[id].edges.size();
+    auto adj = incident_edges(this, id);
+    return std::distance(adj.first, adj.second);
 }
 
 /// Return the id of an edge's source node.
@@ -294,17 +314,17 @@ bool ExperienceGraph::edge(node_id uid, node_id vid) const
         throw std::out_of_range("ExperienceGraph::edge called with invalid node ids");
     }
 
-    if (m_nodes[uid].edges.size() < m_nodes[vid].edges.size()) {
-        for (auto& adj : m_nodes[uid].edges) {
-            if (adj.second == vid) {
-                return true;
-            }
-        }
-    } else {
-        for (auto& adj : m_nodes[vid].edges) {
-            if (adj.second == uid) {
-                return true;
-            }
+    auto uadj = incident_edges(this, uid);
+    auto vadj = incident_edges(this, vid);
+    if (std::distance(uadj.first, uadj.second) >
+        std::distance(vadj.first, vadj.second))
+    {
+        std::swap(uadj, vadj);
+        std::swap(uid, vid);
+    }
+    for (auto it = uadj.first; it != uadj.second; ++it) {
+        if (it->second == vid) {
+            return true;
         }
     }
     return false;
@@ -314,6 +334,9 @@ bool ExperienceGraph::edge(node_id uid, node_id vid) const
 auto ExperienceGraph::insert_node(const RobotState& state) -> node_id
 {
     m_nodes.emplace_back(state);
+    if (m_compact) {
+        m_adjacency_offsets.push_back(m_adjacency.size());
+    }
     return m_nodes.size() - 1;
 }
 
@@ -326,6 +349,8 @@ void ExperienceGraph::erase_node(node_id id)
         throw std::out_of_range("ExperienceGraph::erase_node called with invalid node id");
     }
 
+    expand();
+
     auto& rem_node = m_nodes[id];
 
     // the number of edges to be removed and the smallest id, for updating
@@ -407,6 +432,7 @@ auto ExperienceGraph::insert_edge(node_id uid, node_id vid) -> edge_id
         throw std::out_of_range("ExperienceGraph::insert_edge called with invalid node ids");
     }
 
+    expand();
     m_edges.emplace_back(uid, vid);
     ExperienceGraph::edge_id eid = m_edges.size() - 1;
     insert_incident_edge(this, eid, uid, vid);
@@ -425,6 +451,7 @@ auto ExperienceGraph::insert_edge(
         throw std::out_of_range("ExperienceGraph::insert_edge called with invalid node ids");
     }
 
+    expand();
     m_edges.emplace_back(path, uid, vid);
     ExperienceGraph::edge_id eid = m_edges.size() - 1;
     insert_incident_edge(this, eid, uid, vid);
@@ -441,6 +468,8 @@ void ExperienceGraph::erase_edge(node_id uid, node_id vid)
         throw std::out_of_range("ExperienceGraph::erase_edge called with invalid node ids");
     }
 
+    expand();
+
     // search through the smaller of the two adjacency lists for the edge id
     // and call erase_edge on it when found
     if (m_nodes[uid].edges.size() < m_nodes[vid].edges.size()) {
@@ -477,6 +506,8 @@ void ExperienceGraph::erase_edge(edge_id id)
         throw std::out_of_range("ExperienceGraph::erase_edge called with invalid edge id");
     }
 
+    expand();
+
     auto& e = m_edges[id];
 
     // remove incident edge from source node and update edge ids
@@ -514,11 +545,132 @@ void ExperienceGraph::erase_edge(edge_id id)
     m_edges.erase(std::next(m_edges.begin(), id));
 }
 
+auto ExperienceGraph::mem_usage() const -> std::size_t
+{
+    auto usage = m_nodes.capacity() * sizeof(Node);
+    for (auto& node : m_nodes) {
+        usage += node.state.capacity() * sizeof(double);
+        usage += node.edges.capacity() * sizeof(Node::adjacency);
+    }
+    usage += m_edges.capacity() * sizeof(Edge);
+    for (auto& edge : m_edges) {
+        usage += edge.waypoints.capacity() * sizeof(RobotState);
+        for (auto& wp : edge.waypoints) {
+            usage += wp.capacity() * sizeof(double);
+        }
+    }
+    usage += m_shift.capacity() * sizeof(std::ptrdiff_t);
+    usage += m_adjacency_offsets.capacity() * sizeof(std::size_t);
+    usage += m_adjacency.capacity() * sizeof(Node::adjacency);
+    usage += m_waypoint_offsets.capacity() * sizeof(std::size_t);
+    usage += m_waypoint_pool.capacity() * sizeof(double);
+    return usage;
+}
+
 void ExperienceGraph::clear()
 {
     m_nodes.clear();
     m_edges.clear();
     m_shift.clear();
+
+    m_compact = false;
+    m_state_dim = 0;
+    m_adjacency_offsets.clear();
+    m_adjacency.clear();
+    m_waypoint_offsets.clear();
+    m_waypoint_pool.clear();
+}
+
+/// Freeze the graph into a compact layout for read-heavy use. Incident edge
+/// lists are packed into one array indexed by node and edge waypoints are
+/// pooled into one buffer of joint positions, so bulk traversals read memory
+/// sequentially. Nodes may still be inserted into a compacted graph; any other
+/// modification restores the mutable layout first, invalidating all incident
+/// edge and adjacent node iterators. All waypoints must have the same number
+/// of variables.
+void ExperienceGraph::compact()
+{
+    if (m_compact) {
+        return;
+    }
+
+    std::size_t state_dim = 0;
+    std::size_t waypoint_count = 0;
+    bool dim_set = false;
+    for (auto& edge : m_edges) {
+        for (auto& wp : edge.waypoints) {
+            if (!dim_set) {
+                state_dim = wp.size();
+                dim_set = true;
+            } else if (wp.size() != state_dim) {
+                throw std::invalid_argument("ExperienceGraph::compact called with waypoints of differing sizes");
+            }
+        }
+        waypoint_count += edge.waypoints.size();
+    }
+
+    std::size_t adjacency_count = 0;
+    for (auto& node : m_nodes) {
+        adjacency_count += node.edges.size();
+    }
+
+    m_adjacency_offsets.clear();
+    m_adjacency_offsets.reserve(m_nodes.size() + 1);
+    m_adjacency.clear();
+    m_adjacency.reserve(adjacency_count);
+    m_adjacency_offsets.push_back(0);
+    for (auto& node : m_nodes) {
+        m_adjacency.insert(m_adjacency.end(), node.edges.begin(), node.edges.end());
+        m_adjacency_offsets.push_back(m_adjacency.size());
+        Node::adjacent_edge_container().swap(node.edges);
+    }
+
+    m_state_dim = state_dim;
+    m_waypoint_offsets.clear();
+    m_waypoint_offsets.reserve(m_edges.size() + 1);
+    m_waypoint_pool.clear();
+    m_waypoint_pool.reserve(waypoint_count * state_dim);
+    m_waypoint_offsets.push_back(0);
+    for (auto& edge : m_edges) {
+        for (auto& wp : edge.waypoints) {
+            m_waypoint_pool.insert(m_waypoint_pool.end(), wp.begin(), wp.end());
+        }
+        m_waypoint_offsets.push_back(m_waypoint_offsets.back() + edge.waypoints.size());
+        std::vector<RobotState>().swap(edge.waypoints);
+    }
+
+    m_compact = true;
+}
+
+/// Restore the mutable layout of a compacted graph. All incident edge and
+/// adjacent node iterators are invalidated.
+void ExperienceGraph::expand()
+{
+    if (!m_compact) {
+        return;
+    }
+
+    for (node_id n = 0; n < m_nodes.size(); ++n) {
+        m_nodes[n].edges.assign(
+                m_adjacency.begin() + m_adjacency_offsets[n],
+                m_adjacency.begin() + m_adjacency_offsets[n + 1]);
+    }
+
+    for (edge_id e = 0; e < m_edges.size(); ++e) {
+        auto& waypoints = m_edges[e].waypoints;
+        waypoints.resize(waypoint_count(e));
+        for (std::size_t i = 0; i < waypoints.size(); ++i) {
+            auto wp = waypoint(e, i);
+            waypoints[i].assign(wp.first, wp.second);
+        }
+    }
+
+    m_compact = false;
+    m_state_dim = 0;
+    Node::adjacent_edge_container().swap(m_adjacency);
+    std::vector<std::size_t>().swap(m_adjacency_offsets);
+    std::vector<std::size_t>().swap(m_waypoint_offsets);
+    std::vector<double>().swap(m_waypoint_pool);
 }
 
 auto ExperienceGraph::state(node_id id) const -> const RobotState&
@@ -531,15 +683,47 @@ auto ExperienceGraph::state(node_id id) -> RobotState&
     return m_nodes[id].state;
 }
 
+/// Return the waypoints of an edge. The graph must not be compacted; use
+/// waypoint_count() and waypoint() to read waypoints in either layout.
 auto ExperienceGraph::waypoints(edge_id id) const
     -> const std::vector<RobotState>&
 {
+    if (m_compact) {
+        throw std::logic_error("ExperienceGraph::waypoints called on a compacted graph");
+    }
     return m_edges[id].waypoints;
 }
 
+/// Return the waypoints of an edge, restoring the mutable layout of a
+/// compacted graph.
 auto ExperienceGraph::waypoints(edge_id id) -> std::vector<RobotState>&
 {
+    expand();
     return m_edges[id].waypoints;
 }
 
+/// Return the number of waypoints along an edge.
+auto ExperienceGraph::waypoint_count(edge_id id) const -> std::size_t
+{
+    if (m_compact) {
+        return m_waypoint_offsets[id + 1] - m_waypoint_offsets[id];
+    } else {
+        return m_edges[id].waypoints.size();
+    }
+}
+
+/// Return the range of joint positions of the i'th waypoint along an edge.
+auto ExperienceGraph::waypoint(edge_id id, std::size_t i) const
+    -> std::pair<const double*, const double*>
+{
+    if (m_compact) {
+        auto* first = m_waypoint_pool.data() +
+                (m_waypoint_offsets[id] + i) * m_state_dim;
+        return std::make_pair(first, first + m_state_dim);
+    } else {
+        auto& wp = m_edges[id].waypoints[i];
+        return std::make_pair(wp.data(), wp.data() + wp.size());
+    }
+}
+
 } // namespace smpl
@@ -0,0 +1,442 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+/// \author Andrew Dornbush
+
+#include <smpl/graph/experience_graph_file.h>
+
+// standard includes
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// system includes
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// project includes
+#include <smpl/console/console.h>
+
+namespace smpl {
+
+static_assert(sizeof(ExperienceGraphFileHeader) % sizeof(double) == 0,
+        "Experience graph file sections must be 8-byte aligned");
+static_assert(sizeof(ExperienceGraphFile::Adjacency) == 2 * sizeof(std::uint64_t),
+        "Adjacency records must be tightly packed");
+
+ExperienceGraphFile::~ExperienceGraphFile()
+{
+    close();
+}
+
+bool ExperienceGraphFile::open(const std::string& path)
+{
+    if (IsSharedExperienceGraph(path)) {
+        return openShared(path.substr(std::strlen(EXPERIENCE_GRAPH_SHARED_PREFIX)));
+    }
+
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        SMPL_ERROR("Failed to open experience graph file '%s'", path.c_str());
+        return false;
+    }
+
+    return map(fd, path);
+}
+
+bool ExperienceGraphFile::openShared(const std::string& name)
+{
+    close();
+
+    int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        SMPL_ERROR("Failed to open shared experience graph '%s'", name.c_str());
+        return false;
+    }
+
+    return map(fd, name);
+}
+
+// Map and validate the experience graph open on fd, taking ownership of fd.
+bool ExperienceGraphFile::map(int fd, const std::string& what)
+{
+    auto* path = what.c_str();
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(ExperienceGraphFileHeader)) {
+        SMPL_ERROR("Experience graph file '%s' is truncated", path);
+        ::close(fd);
+        return false;
+    }
+
+    void* data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        SMPL_ERROR("Failed to map experience graph file '%s'", path);
+        return false;
+    }
+
+    m_data = data;
+    m_size = st.st_size;
+
+    auto& h = header();
+    if (std::memcmp(h.magic, EXPERIENCE_GRAPH_FILE_MAGIC, sizeof(h.magic)) != 0) {
+        SMPL_ERROR("'%s' is not an experience graph file", path);
+        close();
+        return false;
+    }
+    if (h.version != EXPERIENCE_GRAPH_FILE_VERSION) {
+        SMPL_ERROR("Experience graph file '%s' has version %u (expected %u)", path, h.version, EXPERIENCE_GRAPH_FILE_VERSION);
+        close();
+        return false;
+    }
+
+    // Walk the sections, checking each against the mapped size before
+    // reading anything that determines the size of the next one.
+    auto words = (m_size - sizeof(ExperienceGraphFileHeader)) / sizeof(std::uint64_t);
+    auto* base = reinterpret_cast<const std::uint64_t*>(
+            static_cast<const char*>(m_data) + sizeof(ExperienceGraphFileHeader));
+    std::size_t offset = 0;
+    auto take = [&](std::uint64_t count, std::uint64_t width) -> const std::uint64_t* {
+        if (width != 0 && count > (words - offset) / width) {
+            return nullptr;
+        }
+        auto* section = base + offset;
+        offset += count * width;
+        return section;
+    };
+
+    auto* states = h.node_count < words && h.edge_count < words ?
+            take(h.node_count, h.dof) : nullptr;
+    auto* adjacency_offsets = states ? take(h.node_count + 1, 1) : nullptr;
+    auto* adjacency = adjacency_offsets ?
+            take(adjacency_offsets[h.node_count], 2) : nullptr;
+    auto* edge_nodes = adjacency ? take(h.edge_count, 2) : nullptr;
+    auto* waypoint_offsets = edge_nodes ? take(h.edge_count + 1, 1) : nullptr;
+    auto* waypoints = waypoint_offsets &&
+            waypoint_offsets[h.edge_count] == h.waypoint_count ?
+            take(h.waypoint_count, h.dof) : nullptr;
+    if (!waypoints || offset != words) {
+        SMPL_ERROR("Experience graph file '%s' is truncated", path);
+        close();
+        return false;
+    }
+
+    auto bad_adjacency = adjacency_offsets[0] != 0;
+    for (std::uint64_t n = 0; n < h.node_count; ++n) {
+        bad_adjacency |= adjacency_offsets[n] > adjacency_offsets[n + 1];
+    }
+    for (std::uint64_t i = 0; i < adjacency_offsets[h.node_count]; ++i) {
+        bad_adjacency |= adjacency[2 * i] >= h.edge_count;
+        bad_adjacency |= adjacency[2 * i + 1] >= h.node_count;
+    }
+    if (bad_adjacency) {
+        SMPL_ERROR("Experience graph file '%s' has malformed adjacency", path);
+        close();
+        return false;
+    }
+    if (waypoint_offsets[0] != 0) {
+        SMPL_ERROR("Experience graph file '%s' has malformed edges", path);
+        close();
+        return false;
+    }
+    for (std::uint64_t e = 0; e < h.edge_count; ++e) {
+        if (edge_nodes[2 * e] >= h.node_count ||
+            edge_nodes[2 * e + 1] >= h.node_count ||
+            waypoint_offsets[e] > waypoint_offsets[e + 1])
+        {
+            SMPL_ERROR("Experience graph file '%s' has malformed edges", path);
+            close();
+            return false;
+        }
+    }
+
+    m_states = reinterpret_cast<const double*>(states);
+    m_adjacency_offsets = adjacency_offsets;
+    m_adjacency = reinterpret_cast<const Adjacency*>(adjacency);
+    m_edge_nodes = edge_nodes;
+    m_waypoint_offsets = waypoint_offsets;
+    m_waypoints = reinterpret_cast<const double*>(waypoints);
+    return true;
+}
+
+void ExperienceGraphFile::close()
+{
+    if (m_data) {
+        ::munmap(m_data, m_size);
+        m_data = nullptr;
+        m_size = 0;
+    }
+}
+
+bool IsExperienceGraphFile(const std::string& path)
+{
+    auto* f = std::fopen(path.c_str(), "rb");
+    if (!f) {
+        return false;
+    }
+    char magic[8];
+    auto ok = std::fread(magic, sizeof(magic), 1, f) == 1 &&
+            std::memcmp(magic, EXPERIENCE_GRAPH_FILE_MAGIC, sizeof(magic)) == 0;
+    std::fclose(f);
+    return ok;
+}
+
+bool IsSharedExperienceGraph(const std::string& path)
+{
+    return path.compare(0, std::strlen(EXPERIENCE_GRAPH_SHARED_PREFIX), EXPERIENCE_GRAPH_SHARED_PREFIX) == 0;
+}
+
+namespace {
+
+// The sections of an experience graph in the binary format, gathered from an
+// ExperienceGraph before they are written out.
+struct ExperienceGraphImage
+{
+    ExperienceGraphFileHeader header;
+    std::vector<double> states;
+    std::vector<std::uint64_t> adjacency_offsets;
+    std::vector<std::uint64_t> adjacency;
+    std::vector<std::uint64_t> edge_nodes;
+    std::vector<std::uint64_t> waypoint_offsets;
+    std::vector<double> waypoints;
+
+    auto size() const -> std::size_t
+    {
+        return sizeof(header) +
+                sizeof(double) * (states.size() + waypoints.size()) +
+                sizeof(std::uint64_t) * (adjacency_offsets.size() +
+                        adjacency.size() + edge_nodes.size() +
+                        waypoint_offsets.size());
+    }
+};
+
+} // namespace
+
+static bool MakeExperienceGraphImage(
+    const ExperienceGraph& egraph,
+    ExperienceGraphImage& image)
+{
+    auto& header = image.header;
+    std::memcpy(header.magic, EXPERIENCE_GRAPH_FILE_MAGIC, sizeof(header.magic));
+    header.version = EXPERIENCE_GRAPH_FILE_VERSION;
+    header.dof = egraph.num_nodes() != 0 ? egraph.state(0).size() : 0;
+    header.node_count = egraph.num_nodes();
+    header.edge_count = egraph.num_edges();
+    header.waypoint_count = 0;
+
+    auto& states = image.states;
+    auto& adjacency_offsets = image.adjacency_offsets;
+    auto& adjacency = image.adjacency;
+    states.reserve(header.node_count * header.dof);
+    adjacency_offsets.reserve(header.node_count + 1);
+    adjacency_offsets.push_back(0);
+    for (ExperienceGraph::node_id n = 0; n < egraph.num_nodes(); ++n) {
+        auto& state = egraph.state(n);
+        if (state.size() != header.dof) {
+            SMPL_ERROR("Experience graph node %zu has %zu variables (expected %u)", n, state.size(), header.dof);
+            return false;
+        }
+        states.insert(end(states), begin(state), end(state));
+        auto incident = egraph.edges(n);
+        auto adjacent = egraph.adjacent_nodes(n);
+        for (; incident.first != incident.second; ++incident.first, ++adjacent.first) {
+            adjacency.push_back(*incident.first);
+            adjacency.push_back(*adjacent.first);
+        }
+        adjacency_offsets.push_back(adjacency.size() / 2);
+    }
+
+    auto& edge_nodes = image.edge_nodes;
+    auto& waypoint_offsets = image.waypoint_offsets;
+    auto& waypoints = image.waypoints;
+    edge_nodes.reserve(2 * header.edge_count);
+    waypoint_offsets.reserve(header.edge_count + 1);
+    waypoint_offsets.push_back(0);
+    for (ExperienceGraph::edge_id e = 0; e < egraph.num_edges(); ++e) {
+        edge_nodes.push_back(egraph.source(e));
+        edge_nodes.push_back(egraph.target(e));
+        for (std::size_t i = 0; i < egraph.waypoint_count(e); ++i) {
+            auto wp = egraph.waypoint(e, i);
+            auto size = (std::size_t)(wp.second - wp.first);
+            if (size != header.dof) {
+                SMPL_ERROR("Waypoint on experience graph edge %zu has %zu variables (expected %u)", e, size, header.dof);
+                return false;
+            }
+            waypoints.insert(end(waypoints), wp.first, wp.second);
+            ++header.waypoint_count;
+        }
+        waypoint_offsets.push_back(header.waypoint_count);
+    }
+
+    return true;
+}
+
+template <typename T>
+static bool WriteSection(std::FILE* f, const std::vector<T>& section)
+{
+    return section.empty() ||
+            std::fwrite(section.data(), sizeof(T), section.size(), f) == section.size();
+}
+
+template <typename T>
+static char* CopySection(char* dst, const std::vector<T>& section)
+{
+    if (!section.empty()) {
+        std::memcpy(dst, section.data(), sizeof(T) * section.size());
+    }
+    return dst + sizeof(T) * section.size();
+}
+
+bool WriteExperienceGraphFile(
+    const std::string& path,
+    const ExperienceGraph& egraph)
+{
+    ExperienceGraphImage image;
+    if (!MakeExperienceGraphImage(egraph, image)) {
+        return false;
+    }
+
+    auto* f = std::fopen(path.c_str(), "wb");
+    if (!f) {
+        SMPL_ERROR("Failed to open '%s' for writing", path.c_str());
+        return false;
+    }
+
+    auto ok = std::fwrite(&image.header, sizeof(image.header), 1, f) == 1 &&
+            WriteSection(f, image.states) &&
+            WriteSection(f, image.adjacency_offsets) &&
+            WriteSection(f, image.adjacency) &&
+            WriteSection(f, image.edge_nodes) &&
+            WriteSection(f, image.waypoint_offsets) &&
+            WriteSection(f, image.waypoints);
+    ok = (std::fclose(f) == 0) && ok;
+    if (!ok) {
+        SMPL_ERROR("Failed to write experience graph file '%s'", path.c_str());
+    }
+    return ok;
+}
+
+bool PublishExperienceGraph(
+    const std::string& name,
+    const ExperienceGraph& egraph)
+{
+    ExperienceGraphImage image;
+    if (!MakeExperienceGraphImage(egraph, image)) {
+        return false;
+    }
+
+    // Resizing an object that other processes have mapped would fault their
+    // reads, so replace it with a fresh one. Attached processes keep the old
+    // object alive through their mappings.
+    ::shm_unlink(name.c_str());
+    int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        SMPL_ERROR("Failed to create shared experience graph '%s'", name.c_str());
+        return false;
+    }
+
+    auto size = image.size();
+    void* data = MAP_FAILED;
+    if (::ftruncate(fd, size) == 0) {
+        data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        SMPL_ERROR("Failed to map shared experience graph '%s'", name.c_str());
+        ::shm_unlink(name.c_str());
+        return false;
+    }
+
+    // Write the magic number last so that a process attaching while the
+    // sections are being copied rejects the object instead of reading a
+    // partial graph.
+    auto* dst = static_cast<char*>(data);
+    auto header = image.header;
+    std::memset(header.magic, 0, sizeof(header.magic));
+    std::memcpy(dst, &header, sizeof(header));
+    dst += sizeof(header);
+    dst = CopySection(dst, image.states);
+    dst = CopySection(dst, image.adjacency_offsets);
+    dst = CopySection(dst, image.adjacency);
+    dst = CopySection(dst, image.edge_nodes);
+    dst = CopySection(dst, image.waypoint_offsets);
+    dst = CopySection(dst, image.waypoints);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(data, EXPERIENCE_GRAPH_FILE_MAGIC, sizeof(header.magic));
+
+    ::munmap(data, size);
+    SMPL_INFO("Published experience graph '%s' (%zu nodes, %zu edges, %zu bytes)", name.c_str(), egraph.num_nodes(), egraph.num_edges(), size);
+    return true;
+}
+
+bool UnpublishExperienceGraph(const std::string& name)
+{
+    if (::shm_unlink(name.c_str()) != 0) {
+        SMPL_ERROR("Failed to remove shared experience graph '%s'", name.c_str());
+        return false;
+    }
+    return true;
+}
+
+void AppendExperienceGraphFile(
+    const ExperienceGraphFile& file,
+    ExperienceGraph& egraph)
+{
+    auto first = egraph.num_nodes();
+    auto dof = file.dof();
+
+    egraph.m_nodes.reserve(first + file.num_nodes());
+    egraph.m_edges.reserve(egraph.num_edges() + file.num_edges());
+
+    RobotState state(dof);
+    for (ExperienceGraph::node_id n = 0; n < file.num_nodes(); ++n) {
+        auto* s = file.state(n);
+        state.assign(s, s + dof);
+        egraph.insert_node(state);
+    }
+
+    std::vector<RobotState> waypoints;
+    for (ExperienceGraph::edge_id e = 0; e < file.num_edges(); ++e) {
+        waypoints.resize(file.num_waypoints(e));
+        auto* wp = file.waypoints(e);
+        for (auto& w : waypoints) {
+            w.assign(wp, wp + dof);
+            wp += dof;
+        }
+        egraph.insert_edge(first + file.source(e), first + file.target(e), waypoints);
+    }
+}
+
+} // namespace smpl
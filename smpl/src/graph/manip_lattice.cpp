@@ -33,6 +33,8 @@
 #include <smpl/graph/manip_lattice.h>
 
 // standard includes
+#include <algorithm>
+#include <cstring>
 #include <iomanip>
 #include <sstream>
 
@@ -42,30 +44,31 @@
 #include <smpl/angles.h>
 #include <smpl/console/console.h>
 #include <smpl/console/nonstd.h>
+#include <smpl/graph/cost_function.h>
 #include <smpl/heuristic/robot_heuristic.h>
 #include <smpl/debug/visualize.h>
 #include <smpl/debug/marker_utils.h>
 #include <smpl/spatial.h>
-#include "../profiling.h"
-
-auto std::hash<smpl::ManipLatticeState>::operator()(
-    const argument_type& s) const -> result_type
-{
-    size_t seed = 0;
-    boost::hash_combine(seed, boost::hash_range(s.coord.begin(), s.coord.end()));
-    return seed;
-}
+#include <smpl/telemetry.h>
 
 namespace smpl {
 
+// expansions are visualized at most this many times per second, so that the
+// forward kinematics and markers for the visualization are not computed for
+// every expansion while the channel is enabled
+static const double EXPANSION_VIS_RATE = 20.0;
+
 ManipLattice::~ManipLattice()
 {
+    // states are freed along with m_state_arena
     for (size_t i = 0; i < m_states.size(); i++) {
-        delete m_states[i];
-        m_states[i] = nullptr;
+        if (m_states[i] != nullptr) {
+            m_states[i]->~ManipLatticeState();
+            m_states[i] = nullptr;
+        }
     }
     m_states.clear();
-    m_state_to_id.clear();
+    m_coord_table.clear();
 }
 
 bool ManipLattice::init(
@@ -92,6 +95,7 @@ bool ManipLattice::init(
     }
 
     m_fk_iface = _robot->getExtension<ForwardKinematicsInterface>();
+    m_world_version_iface = checker->getExtension<CollisionWorldVersionExtension>();
 
     m_min_limits.resize(_robot->jointVariableCount());
     m_max_limits.resize(_robot->jointVariableCount());
@@ -111,9 +115,6 @@ bool ManipLattice::init(
             m_bounded[jidx] ? "true" : "false");
     }
 
-    m_goal_state_id = reserveHashEntry();
-    SMPL_DEBUG_NAMED(G_LOG, "  goal state has state ID %d", m_goal_state_id);
-
     std::vector<int> discretization(_robot->jointVariableCount());
     std::vector<double> deltas(_robot->jointVariableCount());
     for (size_t vidx = 0; vidx < _robot->jointVariableCount(); ++vidx) {
@@ -133,6 +134,40 @@ bool ManipLattice::init(
     SMPL_DEBUG_STREAM_NAMED(G_LOG, "  coord vals: " << discretization);
     SMPL_DEBUG_STREAM_NAMED(G_LOG, "  coord deltas: " << deltas);
 
+    // continuous joints take coordinates in [0, n), bounded joints in [0, n],
+    // and unbounded joints any value
+    std::vector<int> min_coords(_robot->jointVariableCount(), 0);
+    std::vector<int> max_coords(_robot->jointVariableCount());
+    for (size_t vidx = 0; vidx < _robot->jointVariableCount(); ++vidx) {
+        if (m_continuous[vidx]) {
+            max_coords[vidx] = discretization[vidx] - 1;
+        } else if (m_bounded[vidx]) {
+            max_coords[vidx] = discretization[vidx];
+        } else {
+            min_coords[vidx] = std::numeric_limits<int>::min();
+            max_coords[vidx] = std::numeric_limits<int>::max();
+        }
+    }
+    m_coord_table.setRanges(min_coords, max_coords);
+
+    m_goal_state_id = reserveHashEntry();
+    SMPL_DEBUG_NAMED(G_LOG, "  goal state has state ID %d", m_goal_state_id);
+
+    m_coord_offsets.assign(_robot->jointVariableCount(), 0.0);
+    m_coord_periods.assign(_robot->jointVariableCount(), 0.0);
+    m_coord_symmetric.assign(_robot->jointVariableCount(), 0.0);
+    m_coord_wraps.assign(_robot->jointVariableCount(), 0);
+    for (size_t vidx = 0; vidx < _robot->jointVariableCount(); ++vidx) {
+        if (m_continuous[vidx]) {
+            m_coord_periods[vidx] = 2.0 * M_PI;
+            m_coord_wraps[vidx] = discretization[vidx];
+        } else if (m_bounded[vidx]) {
+            m_coord_offsets[vidx] = m_min_limits[vidx];
+        } else {
+            m_coord_symmetric[vidx] = 1.0;
+        }
+    }
+
     m_coord_vals = std::move(discretization);
     m_coord_deltas = std::move(deltas);
 
@@ -213,34 +248,44 @@ void ManipLattice::GetSuccs(
     ManipLatticeState* parent_entry = m_states[state_id];
 
     assert(parent_entry);
-    assert(parent_entry->coord.size() >= robot()->jointVariableCount());
 
     // log expanded state details
-    SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "  coord: " << parent_entry->coord);
+    SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "  coord: " << getHashEntryCoord(state_id));
     SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "  angles: " << parent_entry->state);
 
     auto* vis_name = "expansion";
-    SV_SHOW_DEBUG_NAMED(vis_name, getStateVisualization(parent_entry->state, vis_name));
+    SV_SHOW_DEBUG_THROTTLE_NAMED(vis_name, EXPANSION_VIS_RATE, getStateVisualization(parent_entry->state, vis_name));
 
     int goal_succ_count = 0;
 
-    std::vector<Action> actions;
-    if (!m_actions->apply(parent_entry->state, actions)) {
+    auto& actions = m_action_buffer;
+    size_t action_count;
+    if (!m_actions->applyBuffered(parent_entry->state, actions, action_count)) {
         SMPL_WARN("Failed to get actions");
         return;
     }
 
-    SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "  actions: %zu", actions.size());
+    SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "  actions: %zu", action_count);
+
+    if (m_ordered_expansion && numHeuristics() > 0) {
+        getOrderedSuccs(state_id, parent_entry, action_count, succs, costs);
+        return;
+    }
 
     // check actions for validity
-    RobotCoord succ_coord(robot()->jointVariableCount(), 0);
-    for (size_t i = 0; i < actions.size(); ++i) {
+    auto& valid = m_valid_buffer;
+    auto* memo = getActionMemo(state_id, actions, action_count);
+    checkActions(parent_entry->state, actions, action_count, valid, memo);
+
+    auto& succ_coord = m_succ_coord;
+    succ_coord.resize(robot()->jointVariableCount());
+    for (size_t i = 0; i < action_count; ++i) {
         auto& action = actions[i];
 
         SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "    action %zu:", i);
         SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "      waypoints: %zu", action.size());
 
-        if (!checkAction(parent_entry->state, action)) {
+        if (!valid[i]) {
             continue;
         }
 
@@ -251,6 +296,9 @@ void ManipLattice::GetSuccs(
 
         // check if hash entry already exists, if not then create one
         int succ_state_id = getOrCreateState(succ_coord, action.back());
+        if (succ_state_id < 0) {
+            continue;
+        }
         ManipLatticeState* succ_entry = getHashEntry(succ_state_id);
 
         // check if this state meets the goal criteria
@@ -261,19 +309,19 @@ void ManipLattice::GetSuccs(
         }
 
         // put successor on successor list with the proper cost
-        if (is_goal_succ) {
+        if (is_goal_succ && !m_goal_set_states) {
             succs->push_back(m_goal_state_id);
         } else {
             succs->push_back(succ_state_id);
         }
-        costs->push_back(cost(parent_entry, succ_entry, is_goal_succ));
+        costs->push_back(actionCost(parent_entry->state, action));
 
         // log successor details
         SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "      succ: %zu", i);
         SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "        id: %5i", succ_state_id);
         SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "        coord: " << succ_coord);
         SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "        state: " << succ_entry->state);
-        SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "        cost: %5d", cost(parent_entry, succ_entry, is_goal_succ));
+        SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "        cost: %5d", costs->back());
     }
 
     if (goal_succ_count > 0) {
@@ -281,17 +329,12 @@ void ManipLattice::GetSuccs(
     }
 }
 
-Stopwatch GetLazySuccsStopwatch("GetLazySuccs", 10);
-
 void ManipLattice::GetLazySuccs(
     int state_id,
     std::vector<int>* succs,
     std::vector<int>* costs,
     std::vector<bool>* true_costs)
 {
-    GetLazySuccsStopwatch.start();
-    PROFAUTOSTOP(GetLazySuccsStopwatch);
-
     assert(state_id >= 0 && state_id < m_states.size());
 
     SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "expand state %d", state_id);
@@ -304,27 +347,28 @@ void ManipLattice::GetLazySuccs(
     ManipLatticeState* state_entry = m_states[state_id];
 
     assert(state_entry);
-    assert(state_entry->coord.size() >= robot()->jointVariableCount());
 
     // log expanded state details
-    SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "  coord: " << state_entry->coord);
+    SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "  coord: " << getHashEntryCoord(state_id));
     SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "  angles: " << state_entry->state);
 
     auto& source_angles = state_entry->state;
     auto* vis_name = "expansion";
-    SV_SHOW_DEBUG_NAMED(vis_name, getStateVisualization(source_angles, vis_name));
+    SV_SHOW_DEBUG_THROTTLE_NAMED(vis_name, EXPANSION_VIS_RATE, getStateVisualization(source_angles, vis_name));
 
-    std::vector<Action> actions;
-    if (!m_actions->apply(source_angles, actions)) {
+    auto& actions = m_action_buffer;
+    size_t action_count;
+    if (!m_actions->applyBuffered(source_angles, actions, action_count)) {
         SMPL_WARN("Failed to get successors");
         return;
     }
 
-    SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "  actions: %zu", actions.size());
+    SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "  actions: %zu", action_count);
 
     int goal_succ_count = 0;
-    RobotCoord succ_coord(robot()->jointVariableCount());
-    for (size_t i = 0; i < actions.size(); ++i) {
+    auto& succ_coord = m_succ_coord;
+    succ_coord.resize(robot()->jointVariableCount());
+    for (size_t i = 0; i < action_count; ++i) {
         auto& action = actions[i];
 
         SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "    action %zu:", i);
@@ -338,14 +382,17 @@ void ManipLattice::GetLazySuccs(
         }
 
         int succ_state_id = getOrCreateState(succ_coord, action.back());
+        if (succ_state_id < 0) {
+            continue;
+        }
         ManipLatticeState* succ_entry = getHashEntry(succ_state_id);
 
-        if (succ_is_goal_state) {
+        if (succ_is_goal_state && !m_goal_set_states) {
             succs->push_back(m_goal_state_id);
         } else {
             succs->push_back(succ_state_id);
         }
-        costs->push_back(cost(state_entry, succ_entry, succ_is_goal_state));
+        costs->push_back(actionCost(source_angles, action, true));
         true_costs->push_back(false);
 
         // log successor details
@@ -353,7 +400,7 @@ void ManipLattice::GetLazySuccs(
         SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "        id: %5i", succ_state_id);
         SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "        coord: " << succ_coord);
         SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "        state: " << succ_entry->state);
-        SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "        cost: %5d", cost(state_entry, succ_entry, succ_is_goal_state));
+        SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "        cost: %5d", costs->back());
     }
 
     if (goal_succ_count > 0) {
@@ -361,13 +408,8 @@ void ManipLattice::GetLazySuccs(
     }
 }
 
-Stopwatch GetTrueCostStopwatch("GetTrueCost", 10);
-
 int ManipLattice::GetTrueCost(int parentID, int childID)
 {
-    GetTrueCostStopwatch.start();
-    PROFAUTOSTOP(GetTrueCostStopwatch);
-
     SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "evaluating cost of transition %d -> %d", parentID, childID);
 
     assert(parentID >= 0 && parentID < (int)m_states.size());
@@ -375,27 +417,35 @@ int ManipLattice::GetTrueCost(int parentID, int childID)
 
     ManipLatticeState* parent_entry = m_states[parentID];
     ManipLatticeState* child_entry = m_states[childID];
-    assert(parent_entry && parent_entry->coord.size() >= robot()->jointVariableCount());
-    assert(child_entry && child_entry->coord.size() >= robot()->jointVariableCount());
+    assert(parent_entry);
+    assert(child_entry);
 
     auto& parent_angles = parent_entry->state;
     auto* vis_name = "expansion";
-    SV_SHOW_DEBUG_NAMED(vis_name, getStateVisualization(parent_angles, vis_name));
+    SV_SHOW_DEBUG_THROTTLE_NAMED(vis_name, EXPANSION_VIS_RATE, getStateVisualization(parent_angles, vis_name));
 
-    std::vector<Action> actions;
-    if (!m_actions->apply(parent_angles, actions)) {
+    auto& actions = m_action_buffer;
+    size_t action_count;
+    if (!m_actions->applyBuffered(parent_angles, actions, action_count)) {
         SMPL_WARN("Failed to get actions");
         return -1;
     }
 
     auto goal_edge = (childID == m_goal_state_id);
 
+    auto* memo = getActionMemo(parentID, actions, action_count);
+
     size_t num_actions = 0;
 
     // check actions for validity and find the valid action with the least cost
-    RobotCoord succ_coord(robot()->jointVariableCount());
+    auto& succ_coord = m_succ_coord;
+    succ_coord.resize(robot()->jointVariableCount());
+    RobotCoord child_coord;
+    if (!goal_edge) {
+        child_coord = getHashEntryCoord(childID);
+    }
     int best_cost = std::numeric_limits<int>::max();
-    for (size_t aidx = 0; aidx < actions.size(); ++aidx) {
+    for (size_t aidx = 0; aidx < action_count; ++aidx) {
         auto& action = actions[aidx];
 
         stateToCoord(action.back(), succ_coord);
@@ -408,7 +458,7 @@ int ManipLattice::GetTrueCost(int parentID, int childID)
             }
         } else {
             // skip actions which don't end up at the child state
-            if (succ_coord != child_entry->coord) {
+            if (succ_coord != child_coord) {
                 continue;
             }
         }
@@ -416,16 +466,25 @@ int ManipLattice::GetTrueCost(int parentID, int childID)
         SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "    action %zu:", num_actions++);
         SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "      waypoints %zu:", action.size());
 
-        if (!checkAction(parent_angles, action)) {
-            continue;
+        auto bit = std::uint64_t(1) << (aidx & 63);
+        if (memo && aidx < 64 && (memo->known & bit)) {
+            if (!(memo->valid & bit)) {
+                continue;
+            }
+        } else {
+            auto action_valid = checkAction(parent_angles, action);
+            if (memo && aidx < 64) {
+                memo->known |= bit;
+                if (action_valid) {
+                    memo->valid |= bit;
+                }
+            }
+            if (!action_valid) {
+                continue;
+            }
         }
 
-        // get the unique state
-        int succ_state_id = goal_edge ? getHashEntry(succ_coord) : childID;
-        ManipLatticeState* succ_entry = getHashEntry(succ_state_id);
-        assert(succ_entry);
-
-        auto edge_cost = cost(parent_entry, succ_entry, goal_edge);
+        auto edge_cost = actionCost(parent_angles, action);
         if (edge_cost < best_cost) {
             best_cost = edge_cost;
         }
@@ -450,16 +509,110 @@ bool ManipLattice::projectToPose(int state_id, Affine3& pose)
         return true;
     }
 
-    pose = computePlanningFrameFK(m_states[state_id]->state);
+    auto* entry = m_states[state_id];
+    updateProjection(entry);
+    pose = Translation3(entry->position[0], entry->position[1], entry->position[2]) *
+            Quaternion(
+                    entry->orientation[0],
+                    entry->orientation[1],
+                    entry->orientation[2],
+                    entry->orientation[3]).normalized();
     return true;
 }
 
+bool ManipLattice::projectToPoint(int state_id, Vector3& pos)
+{
+    if (state_id == getGoalStateID()) {
+        pos = goal().pose.translation();
+        return true;
+    }
+
+    auto* entry = m_states[state_id];
+    updateProjection(entry);
+    pos = Vector3(entry->position[0], entry->position[1], entry->position[2]);
+    return true;
+}
+
+/// Predecessors are found by applying the action space to the state itself and
+/// keeping each resulting state from which some action leads back to it, so
+/// only predecessors reachable by a reversible action are generated. The goal
+/// state has predecessors only for joint state goals.
 void ManipLattice::GetPreds(
     int state_id,
     std::vector<int>* preds,
     std::vector<int>* costs)
 {
-    SMPL_WARN("GetPreds unimplemented");
+    assert(state_id >= 0 && state_id < m_states.size() && "state id out of bounds");
+    assert(preds && costs && "predecessor buffer is null");
+    assert(m_actions && "action space is uninitialized");
+
+    SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "expanding state %d backward", state_id);
+
+    // the start state has no predecessors
+    if (state_id == m_start_state_id) {
+        return;
+    }
+
+    auto is_goal = state_id == m_goal_state_id;
+
+    const RobotState* state;
+    if (is_goal) {
+        if (goal().type != GoalType::JOINT_STATE_GOAL) {
+            SMPL_WARN_ONCE("GetPreds only supports joint state goals");
+            return;
+        }
+        state = &goal().angles;
+    } else {
+        state = &m_states[state_id]->state;
+    }
+
+    RobotCoord coord(robot()->jointVariableCount());
+    stateToCoord(*state, coord);
+
+    std::vector<Action> actions;
+    if (!m_actions->apply(*state, actions)) {
+        SMPL_WARN("Failed to get actions");
+        return;
+    }
+
+    RobotCoord pred_coord(robot()->jointVariableCount());
+    RobotCoord succ_coord(robot()->jointVariableCount());
+    std::vector<Action> pred_actions;
+    for (auto& action : actions) {
+        stateToCoord(action.back(), pred_coord);
+
+        int pred_state_id = getOrCreateState(pred_coord, action.back());
+        if (pred_state_id < 0 || pred_state_id == state_id) {
+            continue;
+        }
+        ManipLatticeState* pred_entry = getHashEntry(pred_state_id);
+
+        // goal states are absorbing and never the source of an edge
+        if (isGoal(pred_entry->state)) {
+            continue;
+        }
+
+        // find an action from the predecessor that leads back to this state
+        pred_actions.clear();
+        if (!m_actions->apply(pred_entry->state, pred_actions)) {
+            continue;
+        }
+        for (auto& pred_action : pred_actions) {
+            bool reaches;
+            if (is_goal) {
+                reaches = isGoal(pred_action.back());
+            } else {
+                stateToCoord(pred_action.back(), succ_coord);
+                reaches = succ_coord == coord;
+            }
+            if (reaches && checkAction(pred_entry->state, pred_action)) {
+                preds->push_back(pred_state_id);
+                costs->push_back(actionCost(pred_entry->state, pred_action));
+                SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "  pred: %5i", pred_state_id);
+                break;
+            }
+        }
+    }
 }
 
 // angles are counterclockwise from 0 to 360 in radians, 0 is the center of bin
@@ -471,14 +624,10 @@ void ManipLattice::coordToState(
     assert((int)state.size() == robot()->jointVariableCount() &&
             (int)coord.size() == robot()->jointVariableCount());
 
+    auto* offsets = m_coord_offsets.data();
+    auto* deltas = m_coord_deltas.data();
     for (size_t i = 0; i < coord.size(); ++i) {
-        if (m_continuous[i]) {
-            state[i] = coord[i] * m_coord_deltas[i];
-        } else if (!m_bounded[i]) {
-            state[i] = (double)coord[i] * m_coord_deltas[i];
-        } else {
-            state[i] = m_min_limits[i] + coord[i] * m_coord_deltas[i];
-        }
+        state[i] = offsets[i] + (double)coord[i] * deltas[i];
     }
 }
 
@@ -489,24 +638,22 @@ void ManipLattice::stateToCoord(
     assert((int)state.size() == robot()->jointVariableCount() &&
             (int)coord.size() == robot()->jointVariableCount());
 
+    // branch-free, so that the loop may be vectorized. continuous variables
+    // are wrapped into [0, 2 * pi] and their last coordinate wrapped to 0,
+    // unbounded variables are rounded half away from zero, and bounded
+    // variables are offset by their lower limit
+    auto* offsets = m_coord_offsets.data();
+    auto* periods = m_coord_periods.data();
+    auto* symmetric = m_coord_symmetric.data();
+    auto* wraps = m_coord_wraps.data();
+    auto* deltas = m_coord_deltas.data();
     for (size_t i = 0; i < state.size(); ++i) {
-        if (m_continuous[i]) {
-            auto pos_angle = normalize_angle_positive(state[i]);
-
-            coord[i] = (int)((pos_angle + m_coord_deltas[i] * 0.5) / m_coord_deltas[i]);
-
-            if (coord[i] == m_coord_vals[i]) {
-                coord[i] = 0;
-            }
-        } else if (!m_bounded[i]) {
-            if (state[i] >= 0.0) {
-                coord[i] = (int)(state[i] / m_coord_deltas[i] + 0.5);
-            } else {
-                coord[i] = (int)(state[i] / m_coord_deltas[i] - 0.5);
-            }
-        } else {
-            coord[i] = (int)(((state[i] - m_min_limits[i]) / m_coord_deltas[i]) + 0.5);
-        }
+        auto x = state[i] - offsets[i];
+        x -= periods[i] * std::floor(x * (0.5 / M_PI));
+        auto y = x / deltas[i];
+        auto half = 0.5 + symmetric[i] * (std::copysign(0.5, y) - 0.5);
+        auto c = (int)(y + half);
+        coord[i] = c - wraps[i] * (int)(c == wraps[i]);
     }
 }
 
@@ -519,60 +666,136 @@ ManipLatticeState* ManipLattice::getHashEntry(int state_id) const
     return m_states[state_id];
 }
 
+/// Return the discrete coordinate of the state with the given id.
+auto ManipLattice::getHashEntryCoord(int state_id) const -> RobotCoord
+{
+    assert(state_id >= 0 && state_id < m_coord_table.size());
+    RobotCoord coord(m_coord_table.width());
+    m_coord_table.get(state_id, coord.data());
+    return coord;
+}
+
 /// Return the state id of the state with the given coordinate or -1 if the
 /// state has not yet been allocated.
 int ManipLattice::getHashEntry(const RobotCoord& coord)
 {
-    ManipLatticeState state;
-    state.coord = coord;
-    auto sit = m_state_to_id.find(&state);
-    if (sit == m_state_to_id.end()) {
-        return -1;
-    }
-    return sit->second;
+    assert((int)coord.size() == m_coord_table.width());
+    return m_coord_table.find(coord.data());
 }
 
 int ManipLattice::createHashEntry(
     const RobotCoord& coord,
     const RobotState& state)
 {
-    int state_id = reserveHashEntry();
-    ManipLatticeState* entry = getHashEntry(state_id);
-
-    entry->coord = coord;
-    entry->state = state;
-
-    // map state -> state id
-    m_state_to_id[entry] = state_id;
+    assert((int)coord.size() == m_coord_table.width());
 
+    // map coord <-> state id
+    int state_id = m_coord_table.insert(coord.data());
+    addHashEntry(state_id, state);
     return state_id;
 }
 
+/// Return the id of the state at a coordinate, creating it if it does not
+/// exist, or -1 if the state does not exist and the memory limit has been
+/// reached.
 int ManipLattice::getOrCreateState(
     const RobotCoord& coord,
     const RobotState& state)
 {
     int state_id = getHashEntry(coord);
     if (state_id < 0) {
+        if (memoryLimitReached()) {
+            if (!m_memory_limit_reached) {
+                SMPL_WARN_NAMED(G_LOG, "Reached lattice memory limit of %zu bytes with %zu states", m_memory_limit, m_states.size());
+                m_memory_limit_reached = true;
+            }
+            return -1;
+        }
         state_id = createHashEntry(coord, state);
+    } else if (m_states[state_id] == nullptr) {
+        // recreate a retired state under its original id
+        m_states[state_id] = constructEntry(state);
+        --m_retired_count;
     }
     return state_id;
 }
 
+/// Create a state that is not indexed by its coordinate and hence will never
+/// be returned by getHashEntry(const RobotCoord&).
 int ManipLattice::reserveHashEntry()
 {
-    ManipLatticeState* entry = new ManipLatticeState;
-    int state_id = (int)m_states.size();
+    int state_id = m_coord_table.reserve();
+    addHashEntry(state_id, RobotState());
+    return state_id;
+}
+
+int ManipLattice::reserveHashEntry(
+    const RobotCoord& coord,
+    const RobotState& state)
+{
+    assert((int)coord.size() == m_coord_table.width());
+
+    int state_id = m_coord_table.reserve();
+    m_coord_table.set(state_id, coord.data());
+    addHashEntry(state_id, state);
+    return state_id;
+}
+
+void ManipLattice::addHashEntry(int state_id, const RobotState& state)
+{
+    assert(state_id == (int)m_states.size());
 
     // map state id -> state
-    m_states.push_back(entry);
+    m_states.push_back(constructEntry(state));
 
-    // map planner state -> graph state
-    int* pinds = new int[NUMOFINDICES_STATEID2IND];
-    std::fill(pinds, pinds + NUMOFINDICES_STATEID2IND, -1);
-    StateID2IndexMapping.push_back(pinds);
+    // map planner state -> graph state, reusing the mapping left behind by a
+    // cleared state, if any
+    if (state_id < (int)StateID2IndexMapping.size()) {
+        int* pinds = StateID2IndexMapping[state_id];
+        std::fill(pinds, pinds + NUMOFINDICES_STATEID2IND, -1);
+    } else {
+        int* pinds = new int[NUMOFINDICES_STATEID2IND];
+        std::fill(pinds, pinds + NUMOFINDICES_STATEID2IND, -1);
+        StateID2IndexMapping.push_back(pinds);
+    }
+}
 
-    return state_id;
+// Construct a state entry, reusing the storage of a retired state if any.
+auto ManipLattice::constructEntry(const RobotState& state) -> ManipLatticeState*
+{
+    ManipLatticeState* entry;
+    if (!m_free_entries.empty()) {
+        entry = new (m_free_entries.back()) ManipLatticeState();
+        m_free_entries.pop_back();
+    } else {
+        entry = m_state_arena.construct<ManipLatticeState>();
+    }
+    entry->state = state;
+    entry->projected = false;
+    return entry;
+}
+
+/// Release the entries of states that the search no longer needs. The ids and
+/// coordinates of retired states are kept, so that getOrCreateState recreates
+/// a retired state under its original id, and the entry storage is reused for
+/// new states. The start and goal states are never retired.
+void ManipLattice::retireStates(const int* state_ids, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        auto state_id = state_ids[i];
+        if (state_id == m_start_state_id || state_id == m_goal_state_id) {
+            continue;
+        }
+        auto* entry = getHashEntry(state_id);
+        if (entry == nullptr) {
+            continue;
+        }
+        entry->~ManipLatticeState();
+        m_free_entries.push_back(entry);
+        m_states[state_id] = nullptr;
+        ++m_retired_count;
+    }
+    SMPL_DEBUG_NAMED(G_LOG, "Retired states: %zu of %zu", m_retired_count, m_states.size());
 }
 
 /// NOTE: const although RobotModel::computeFK used underneath may
@@ -583,9 +806,31 @@ auto ManipLattice::computePlanningFrameFK(const RobotState& state) const
     assert(state.size() == robot()->jointVariableCount());
     assert(m_fk_iface);
 
+    TelemetryTimer timer(TelemetryEvent::ForwardKinematics);
     return m_fk_iface->computeFK(state);
 }
 
+/// Compute and store the planning frame pose of a state, if it has not been
+/// projected before. The heuristics project each state many times over the
+/// course of a search, but a state's continuous coordinate never changes, so
+/// forward kinematics are only computed once per state.
+void ManipLattice::updateProjection(ManipLatticeState* entry)
+{
+    if (entry->projected) {
+        return;
+    }
+    auto pose = computePlanningFrameFK(entry->state);
+    Quaternion q(pose.linear());
+    entry->position[0] = pose.translation().x();
+    entry->position[1] = pose.translation().y();
+    entry->position[2] = pose.translation().z();
+    entry->orientation[0] = (float)q.w();
+    entry->orientation[1] = (float)q.x();
+    entry->orientation[2] = (float)q.y();
+    entry->orientation[3] = (float)q.z();
+    entry->projected = true;
+}
+
 int ManipLattice::cost(
     ManipLatticeState* HashEntry1,
     ManipLatticeState* HashEntry2,
@@ -595,7 +840,29 @@ int ManipLattice::cost(
     return DefaultCostMultiplier;
 }
 
+int ManipLattice::actionCost(
+    const RobotState& state,
+    const Action& action,
+    bool lower_bound)
+{
+    if (!m_cost_fn) {
+        return cost(nullptr, nullptr, false);
+    }
+    if (lower_bound) {
+        return m_cost_fn->getCostLowerBound(state, action);
+    }
+    return m_cost_fn->getCost(state, action);
+}
+
 bool ManipLattice::checkAction(const RobotState& state, const Action& action)
+{
+    return checkAction(state, action, collisionChecker());
+}
+
+bool ManipLattice::checkAction(
+    const RobotState& state,
+    const Action& action,
+    CollisionChecker* checker)
 {
     std::uint32_t violation_mask = 0x00000000;
 
@@ -632,7 +899,7 @@ bool ManipLattice::checkAction(const RobotState& state, const Action& action)
     }
 
     // check for collisions along path from parent to first waypoint
-    if (!collisionChecker()->isStateToStateValid(state, action[0])) {
+    if (!checker->isStateToStateValid(state, action[0])) {
         SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "        -> path to first waypoint in collision");
         violation_mask |= 0x00000004;
     }
@@ -645,7 +912,7 @@ bool ManipLattice::checkAction(const RobotState& state, const Action& action)
     for (size_t j = 1; j < action.size(); ++j) {
         auto& prev_istate = action[j - 1];
         auto& curr_istate = action[j];
-        if (!collisionChecker()->isStateToStateValid(prev_istate, curr_istate))
+        if (!checker->isStateToStateValid(prev_istate, curr_istate))
         {
             SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "        -> path between waypoints %zu and %zu in collision", j - 1, j);
             violation_mask |= 0x00000008;
@@ -660,50 +927,302 @@ bool ManipLattice::checkAction(const RobotState& state, const Action& action)
     return true;
 }
 
-static
-bool WithinPositionTolerance(
-    const Affine3& A,
-    const Affine3& B,
-    const double tol[3])
+/// Check each action from a given state, storing valid[i] = whether actions[i]
+/// is valid. Actions are distributed over the action check pool when one has
+/// been configured.
+// Check the actions in the action buffer in order of increasing successor
+// f-value, in batches of one action per check thread, and append the valid
+// successors. With early exit, stop after the first batch that produces a
+// valid successor whose f-value matches the parent's.
+void ManipLattice::getOrderedSuccs(
+    int state_id,
+    ManipLatticeState* parent_entry,
+    size_t action_count,
+    std::vector<int>* succs,
+    std::vector<int>* costs)
 {
-    auto dx = std::fabs(A.translation()[0] - B.translation()[0]);
-    auto dy = std::fabs(A.translation()[1] - B.translation()[1]);
-    auto dz = std::fabs(A.translation()[2] - B.translation()[2]);
-    return dx <= tol[0] && dy <= tol[1] && dz <= tol[2];
+    auto& actions = m_action_buffer;
+    auto* h = heuristic(0);
+
+    auto& succ_coord = m_succ_coord;
+    succ_coord.resize(robot()->jointVariableCount());
+
+    auto& ordered = m_ordered_actions;
+    ordered.clear();
+    for (size_t i = 0; i < action_count; ++i) {
+        auto& action = actions[i];
+        stateToCoord(action.back(), succ_coord);
+        int succ_id = getOrCreateState(succ_coord, action.back());
+        if (succ_id < 0) {
+            continue;
+        }
+        ordered.emplace_back();
+        auto& entry = ordered.back();
+        entry.index = i;
+        entry.succ_id = succ_id;
+        entry.is_goal = isGoal(action.back());
+        entry.cost = actionCost(parent_entry->state, action, true);
+        entry.f = entry.cost;
+        if (!entry.is_goal) {
+            entry.f += h->GetGoalHeuristic(entry.succ_id);
+        }
+    }
+
+    // actions to states that could not be created are dropped
+    auto ordered_count = action_count;
+    action_count = ordered.size();
+
+    std::stable_sort(begin(ordered), end(ordered),
+            [](const OrderedAction& a, const OrderedAction& b)
+            {
+                return a.f < b.f;
+            });
+
+    auto parent_h = h->GetGoalHeuristic(state_id);
+    auto batch_size = (size_t)actionCheckThreadCount();
+
+    auto* memo = getActionMemo(state_id, actions, ordered_count);
+
+    auto& valid = m_valid_buffer;
+
+    int goal_succ_count = 0;
+    for (size_t first = 0, last = 0; first < action_count; first = last) {
+        // batches are filled with unmemoized actions only, so that a batch
+        // still holds one collision check per thread
+        auto& unknown = m_unknown_actions;
+        unknown.clear();
+        for (size_t i = first; i < action_count && unknown.size() < batch_size; ++i) {
+            auto index = ordered[i].index;
+            if (memo && index < 64 && (memo->known & (std::uint64_t(1) << index))) {
+                if (unknown.empty()) {
+                    // leading memoized actions extend the batch for free
+                    last = i + 1;
+                }
+                continue;
+            }
+            unknown.push_back(i);
+            last = i + 1;
+        }
+
+        valid.resize(last - first);
+        for (size_t i = first; i < last; ++i) {
+            auto index = ordered[i].index;
+            if (memo && index < 64) {
+                valid[i - first] = (memo->valid >> index) & 1;
+            }
+        }
+
+        if (m_check_pool) {
+            m_check_pool->run(unknown.size(), [&](int tid, size_t i)
+            {
+                auto* checker = tid == 0 ?
+                        collisionChecker() : m_check_clones[tid - 1].get();
+                auto& action = actions[ordered[unknown[i]].index];
+                valid[unknown[i] - first] = checkAction(parent_entry->state, action, checker);
+            });
+        } else {
+            for (auto i : unknown) {
+                auto& action = actions[ordered[i].index];
+                valid[i - first] = checkAction(parent_entry->state, action);
+            }
+        }
+
+        if (memo) {
+            for (auto i : unknown) {
+                auto index = ordered[i].index;
+                if (index < 64) {
+                    auto bit = std::uint64_t(1) << index;
+                    memo->known |= bit;
+                    if (valid[i - first]) {
+                        memo->valid |= bit;
+                    }
+                }
+            }
+        }
+
+        auto f_matched = false;
+        for (size_t i = first; i < last; ++i) {
+            if (!valid[i - first]) {
+                continue;
+            }
+
+            auto& entry = ordered[i];
+            if (entry.is_goal) {
+                ++goal_succ_count;
+            }
+            if (m_cost_fn) {
+                // replace the lower bound used for ordering
+                auto edge_cost = actionCost(
+                        parent_entry->state, actions[entry.index]);
+                entry.f += edge_cost - entry.cost;
+                entry.cost = edge_cost;
+            }
+            if (entry.is_goal && !m_goal_set_states) {
+                succs->push_back(m_goal_state_id);
+            } else {
+                succs->push_back(entry.succ_id);
+            }
+            costs->push_back(entry.cost);
+
+            SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "      succ: %zu", entry.index);
+            SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "        id: %5i", entry.succ_id);
+            SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "        cost: %5d", entry.cost);
+            SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "        f: %5d", entry.f);
+
+            if (entry.f <= parent_h) {
+                f_matched = true;
+            }
+        }
+
+        if (m_ordered_early_exit && f_matched) {
+            SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "  skipped %zu actions", action_count - last);
+            break;
+        }
+    }
+
+    if (goal_succ_count > 0) {
+        SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "Got %d goal successors!", goal_succ_count);
+    }
+}
+
+// Check the motions from a state to each of a set of states, concurrently on
+// the action check threads if there is more than one.
+void ManipLattice::checkMotions(
+    const RobotState& state,
+    const std::vector<const RobotState*>& targets,
+    std::vector<char>& valid)
+{
+    valid.resize(targets.size());
+
+    if (!m_check_pool) {
+        for (size_t i = 0; i < targets.size(); ++i) {
+            valid[i] = collisionChecker()->isStateToStateValid(state, *targets[i]);
+        }
+        return;
+    }
+
+    m_check_pool->run(targets.size(), [&](int tid, size_t i)
+    {
+        auto* checker = tid == 0 ?
+                collisionChecker() : m_check_clones[tid - 1].get();
+        valid[i] = checker->isStateToStateValid(state, *targets[i]);
+    });
+}
+
+void ManipLattice::checkActions(
+    const RobotState& state,
+    const std::vector<Action>& actions,
+    size_t count,
+    std::vector<char>& valid,
+    ActionMemo* memo)
+{
+    valid.resize(count);
+
+    // take memoized results and collect the actions left to check
+    auto& unknown = m_unknown_actions;
+    unknown.clear();
+    for (size_t i = 0; i < count; ++i) {
+        if (memo && i < 64 && (memo->known & (std::uint64_t(1) << i))) {
+            valid[i] = (memo->valid >> i) & 1;
+        } else {
+            unknown.push_back(i);
+        }
+    }
+
+    if (!m_check_pool) {
+        for (auto i : unknown) {
+            valid[i] = checkAction(state, actions[i]);
+        }
+    } else {
+        m_check_pool->run(unknown.size(), [&](int tid, size_t i)
+        {
+            auto* checker = tid == 0 ?
+                    collisionChecker() : m_check_clones[tid - 1].get();
+            valid[unknown[i]] = checkAction(state, actions[unknown[i]], checker);
+        });
+    }
+
+    if (memo) {
+        for (auto i : unknown) {
+            if (i < 64) {
+                auto bit = std::uint64_t(1) << i;
+                memo->known |= bit;
+                if (valid[i]) {
+                    memo->valid |= bit;
+                }
+            }
+        }
+    }
 }
 
 static
-bool WithinOrientationTolerance(
-    const Affine3& A,
-    const Affine3& B,
-    const double tol[3])
+auto ActionListFingerprint(const std::vector<Action>& actions, size_t count)
+    -> std::uint64_t
+{
+    // FNV-1a over 64-bit words
+    auto h = std::uint64_t(14695981039346656037ULL);
+    auto mix = [&](std::uint64_t word) {
+        h ^= word;
+        h *= std::uint64_t(1099511628211ULL);
+    };
+    mix(count);
+    for (size_t i = 0; i < count; ++i) {
+        mix(actions[i].size());
+        for (auto& waypoint : actions[i]) {
+            for (auto value : waypoint) {
+                std::uint64_t word;
+                std::memcpy(&word, &value, sizeof(word));
+                mix(word);
+            }
+        }
+    }
+    return h;
+}
+
+/// Return the validity memo for the actions of a state, reset if it was
+/// recorded for a different action list, or nullptr if memoization is
+/// disabled or unsupported by the collision checker. All memos are discarded
+/// when the collision world version changes.
+auto ManipLattice::getActionMemo(
+    int state_id,
+    const std::vector<Action>& actions,
+    size_t count)
+    -> ActionMemo*
 {
-    Quaternion qg(B.rotation());
-    Quaternion q(A.rotation());
-    if (q.dot(qg) < 0.0) {
-        qg = Quaternion(-qg.w(), -qg.x(), -qg.y(), -qg.z());
+    if (!m_action_memo_enabled || !m_world_version_iface) {
+        return nullptr;
+    }
+
+    auto version = m_world_version_iface->worldVersion();
+    if (version != m_action_memo_version) {
+        m_action_memos.clear();
+        m_action_memo_version = version;
     }
 
-    auto theta = normalize_angle(2.0 * acos(q.dot(qg)));
-    return theta < tol[0];
+    if (state_id >= (int)m_action_memos.size()) {
+        m_action_memos.resize(m_states.size(), ActionMemo{ 0, 0, 0 });
+    }
+
+    auto fingerprint = ActionListFingerprint(actions, count);
+    auto& memo = m_action_memos[state_id];
+    if (memo.fingerprint != fingerprint) {
+        memo.fingerprint = fingerprint;
+        memo.known = 0;
+        memo.valid = 0;
+    }
+    return &memo;
 }
 
 static
-auto WithinTolerance(
+bool WithinPositionTolerance(
     const Affine3& A,
     const Affine3& B,
-    const double xyz_tolerance[3],
-    const double rpy_tolerance[3])
-    -> std::pair<bool, bool>
+    const double tol[3])
 {
-    if (WithinPositionTolerance(A, B, xyz_tolerance)) {
-        if (WithinOrientationTolerance(A, B, rpy_tolerance)) {
-            return std::make_pair(true, true);
-        } else {
-            return std::make_pair(true, false);
-        }
-    }
-    return std::make_pair(false, false);
+    auto dx = std::fabs(A.translation()[0] - B.translation()[0]);
+    auto dy = std::fabs(A.translation()[1] - B.translation()[1]);
+    auto dz = std::fabs(A.translation()[2] - B.translation()[2]);
+    return dx <= tol[0] && dy <= tol[1] && dz <= tol[2];
 }
 
 bool ManipLattice::isGoal(const RobotState& state)
@@ -711,37 +1230,18 @@ bool ManipLattice::isGoal(const RobotState& state)
     switch (goal().type) {
     case GoalType::JOINT_STATE_GOAL:
     {
-        for (int i = 0; i < goal().angles.size(); i++) {
-            if (fabs(state[i] - goal().angles[i]) > goal().angle_tolerances[i]) {
-                return false;
-            }
-        }
-        return true;
+        return within_limits(
+                state.data(),
+                m_goal_min_angles.data(),
+                m_goal_max_angles.data(),
+                m_goal_min_angles.size());
     }
     case GoalType::XYZ_RPY_GOAL:
-    {
-        // get pose of planning link
-        auto pose = computePlanningFrameFK(state);
-
-        auto near = WithinTolerance(
-                pose,
-                goal().pose,
-                goal().xyz_tolerance,
-                goal().rpy_tolerance);
-        return near.first & near.second;
-    }
     case GoalType::MULTIPLE_POSE_GOAL:
     {
+        // get pose of planning link
         auto pose = computePlanningFrameFK(state);
-        for (auto& goal_pose : goal().poses) {
-            auto near = WithinTolerance(
-                    pose, goal_pose,
-                    goal().xyz_tolerance, goal().rpy_tolerance);
-            if (near.first & near.second) {
-                return true;
-            }
-        }
-        return false;
+        return m_goal_poses.contains(pose);
     }
     case GoalType::XYZ_GOAL:
     {
@@ -808,6 +1308,10 @@ bool ManipLattice::setStart(const RobotState& state)
     SMPL_DEBUG_STREAM_NAMED(G_LOG, "  coord: " << start_coord);
 
     m_start_state_id = getOrCreateState(start_coord, state);
+    if (m_start_state_id < 0) {
+        SMPL_ERROR_NAMED(G_LOG, "Failed to create start state");
+        return false;
+    }
 
     m_actions->updateStart(state);
 
@@ -866,15 +1370,155 @@ auto ManipLattice::getDiscreteCenter(const RobotState& state) const -> RobotStat
 void ManipLattice::clearStates()
 {
     for (auto& state : m_states) {
-        delete state;
+        if (state != nullptr) {
+            state->~ManipLatticeState();
+        }
     }
     m_states.clear();
-    m_state_to_id.clear();
-    m_states.shrink_to_fit();
-
+    m_coord_table.clear();
+    m_state_arena.reset();
+    m_free_entries.clear();
+    m_retired_count = 0;
+    m_memory_limit_reached = false;
+    m_action_memos.clear();
+
+    m_start_state_id = -1;
     m_goal_state_id = reserveHashEntry();
 }
 
+bool ManipLattice::setActionCheckThreadCount(int count)
+{
+    if (count <= 1) {
+        m_check_pool.reset();
+        m_check_clones.clear();
+        return true;
+    }
+
+    if (!collisionChecker()) {
+        SMPL_ERROR_NAMED(G_LOG, "Parallel action checking requires an initialized Manip Lattice");
+        return false;
+    }
+
+    auto* cloner = collisionChecker()->getExtension<CollisionCheckerCloneExtension>();
+    if (!cloner) {
+        SMPL_ERROR_NAMED(G_LOG, "Parallel action checking requires a Collision Checker Clone Extension");
+        return false;
+    }
+
+    std::vector<std::unique_ptr<CollisionChecker>> clones;
+    for (int i = 1; i < count; ++i) {
+        auto clone = cloner->clone();
+        if (!clone) {
+            SMPL_ERROR_NAMED(G_LOG, "Failed to clone collision checker");
+            return false;
+        }
+        clones.push_back(std::move(clone));
+    }
+
+    m_check_pool.reset(new WorkerPool(count));
+    m_check_clones = std::move(clones);
+    SMPL_DEBUG_NAMED(G_LOG, "Check actions using %d threads", count);
+    return true;
+}
+
+int ManipLattice::actionCheckThreadCount() const
+{
+    return m_check_pool ? m_check_pool->numThreads() : 1;
+}
+
+void ManipLattice::setOrderedExpansion(bool enable, bool early_exit)
+{
+    m_ordered_expansion = enable;
+    m_ordered_early_exit = enable && early_exit;
+}
+
+bool ManipLattice::orderedExpansion() const
+{
+    return m_ordered_expansion;
+}
+
+bool ManipLattice::orderedExpansionEarlyExit() const
+{
+    return m_ordered_early_exit;
+}
+
+void ManipLattice::setMemoryLimit(std::size_t bytes)
+{
+    m_memory_limit = bytes;
+    m_memory_limit_reached = false;
+}
+
+auto ManipLattice::memoryLimit() const -> std::size_t
+{
+    return m_memory_limit;
+}
+
+void ManipLattice::setActionValidityMemo(bool enable)
+{
+    m_action_memo_enabled = enable;
+    m_action_memos.clear();
+}
+
+bool ManipLattice::actionValidityMemo() const
+{
+    return m_action_memo_enabled;
+}
+
+void ManipLattice::setGoalSetStates(bool enable)
+{
+    m_goal_set_states = enable;
+}
+
+bool ManipLattice::goalSetStates() const
+{
+    return m_goal_set_states;
+}
+
+int ManipLattice::goalCount()
+{
+    if (goal().type == GoalType::MULTIPLE_POSE_GOAL) {
+        return (int)goal().poses.size();
+    }
+    return 1;
+}
+
+int ManipLattice::goalIndex(int state_id)
+{
+    assert(state_id >= 0 && state_id < m_states.size() && "state id out of bounds");
+
+    if (state_id == m_goal_state_id) {
+        return 0;
+    }
+
+    auto& state = m_states[state_id]->state;
+    switch (goal().type) {
+    case GoalType::XYZ_RPY_GOAL:
+    case GoalType::MULTIPLE_POSE_GOAL:
+        return m_goal_poses.find(computePlanningFrameFK(state));
+    default:
+        return isGoal(state) ? 0 : -1;
+    }
+}
+
+/// Return whether the states created since the last call to clearStates()
+/// hold at least the memory limit. The size of a state is estimated from its
+/// entry, its continuous and discrete coordinates, its index mapping, and its
+/// coordinate table slots, so the check takes constant time. Retired states
+/// are not counted.
+bool ManipLattice::memoryLimitReached() const
+{
+    if (m_memory_limit == 0) {
+        return false;
+    }
+    auto state_size =
+            sizeof(ManipLatticeState) + sizeof(ManipLatticeState*) +
+            sizeof(double) * robot()->jointVariableCount() +
+            sizeof(std::uint64_t) * m_coord_table.wordCount() +
+            sizeof(int) * NUMOFINDICES_STATEID2IND + sizeof(int*) +
+            2 * (sizeof(std::uint32_t) + sizeof(int));
+    return (m_states.size() - m_retired_count) * state_size >= m_memory_limit;
+}
+
 bool ManipLattice::extractPath(
     const std::vector<int>& idpath,
     std::vector<RobotState>& path)
@@ -971,7 +1615,7 @@ bool ManipLattice::extractPath(
                 ManipLatticeState* succ_entry = getHashEntry(succ_state_id);
                 assert(succ_entry);
 
-                auto edge_cost = cost(prev_entry, succ_entry, true);
+                auto edge_cost = actionCost(prev_state, action);
                 if (edge_cost < best_cost) {
                     best_cost = edge_cost;
                     best_goal_state = succ_entry;
@@ -1006,7 +1650,9 @@ bool ManipLattice::extractPath(
 Extension* ManipLattice::getExtension(size_t class_code)
 {
     if (class_code == GetClassCode<RobotPlanningSpace>() ||
-        class_code == GetClassCode<ExtractRobotStateExtension>())
+        class_code == GetClassCode<ExtractRobotStateExtension>() ||
+        class_code == GetClassCode<MemoryUsageExtension>() ||
+        class_code == GetClassCode<StateRetirementExtension>())
     {
         return this;
     }
@@ -1019,9 +1665,34 @@ Extension* ManipLattice::getExtension(size_t class_code)
         }
     }
 
+    if (class_code == GetClassCode<GoalSetExtension>()) {
+        if (m_goal_set_states) {
+            return this;
+        }
+    }
+
     return nullptr;
 }
 
+auto ManipLattice::memoryUsage() const -> std::size_t
+{
+    auto usage = m_coord_table.memoryUsage();
+    usage += MemoryUsage(m_states);
+    usage += MemoryUsage(m_free_entries);
+    usage += m_state_arena.capacity();
+    for (auto* state : m_states) {
+        if (state != nullptr) {
+            usage += MemoryUsage(state->state);
+        }
+    }
+    usage += MemoryUsage(m_action_buffer);
+    usage += MemoryUsage(m_valid_buffer);
+    usage += MemoryUsage(m_ordered_actions);
+    usage += MemoryUsage(m_action_memos);
+    usage += MemoryUsage(m_unknown_actions);
+    return usage;
+}
+
 /// \brief Return the ID of the goal state or -1 if no goal has been set.
 int ManipLattice::getGoalStateID() const
 {
@@ -1066,6 +1737,7 @@ bool ManipLattice::setGoalPose(const GoalConstraint& gc)
     SMPL_DEBUG_NAMED(G_LOG, "    rpy (radians): (%0.2f, %0.2f, %0.2f)", roll, pitch, yaw);
     SMPL_DEBUG_NAMED(G_LOG, "    tol (radians): %0.3f", gc.rpy_tolerance[0]);
 
+    m_goal_poses.assign(&gc.pose, 1, gc.xyz_tolerance, gc.rpy_tolerance);
 
     // set the (modified) goal
     return RobotPlanningSpace::setGoal(gc);
@@ -1074,6 +1746,10 @@ bool ManipLattice::setGoalPose(const GoalConstraint& gc)
 bool ManipLattice::setGoalPoses(const GoalConstraint& gc)
 {
     // TODO: a visualization would be nice
+    m_goal_poses.assign(
+            gc.poses.data(), gc.poses.size(),
+            gc.xyz_tolerance, gc.rpy_tolerance);
+    SMPL_DEBUG_NAMED(G_LOG, "A new goal has been set with %zu poses", gc.poses.size());
     return RobotPlanningSpace::setGoal(gc);
 }
 
@@ -1093,6 +1769,13 @@ bool ManipLattice::setGoalConfiguration(const GoalConstraint& goal)
     SMPL_INFO_STREAM_NAMED(G_LOG, "  config: " << goal.angles);
     SMPL_INFO_STREAM_NAMED(G_LOG, "  tolerance: " << goal.angle_tolerances);
 
+    m_goal_min_angles.resize(goal.angles.size());
+    m_goal_max_angles.resize(goal.angles.size());
+    for (size_t i = 0; i < goal.angles.size(); ++i) {
+        m_goal_min_angles[i] = goal.angles[i] - goal.angle_tolerances[i];
+        m_goal_max_angles[i] = goal.angles[i] + goal.angle_tolerances[i];
+    }
+
     // notify observers of updated goal
     return RobotPlanningSpace::setGoal(goal);
 }
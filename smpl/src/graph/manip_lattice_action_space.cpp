@@ -33,6 +33,8 @@
 #include <smpl/graph/manip_lattice_action_space.h>
 
 // standard includes
+#include <algorithm>
+#include <cmath>
 #include <limits>
 #include <numeric>
 
@@ -41,6 +43,8 @@
 #include <smpl/console/console.h>
 #include <smpl/graph/manip_lattice.h>
 #include <smpl/heuristic/robot_heuristic.h>
+#include <smpl/stl/memory.h>
+#include <smpl/telemetry.h>
 
 namespace smpl {
 
@@ -97,8 +101,19 @@ bool ManipLatticeActionSpace::init(ManipLattice* space)
 /// dv(i-k+1)1   dv(i-k+1)2  ... dv(i-k+1)m
 /// ...
 /// dvi1         dvi2        ... dvim
+///
+/// The file may instead be a binary motion primitive file, written by save(),
+/// or a shared memory motion primitive set named "shm:<name>", published with
+/// PublishMotionPrimitives(). These are validated against the lattice
+/// resolutions and used without parsing.
 bool ManipLatticeActionSpace::load(const std::string& action_filename)
 {
+    if (IsSharedMotionPrimitives(action_filename) ||
+        IsMotionPrimitiveFile(action_filename))
+    {
+        return loadBinary(action_filename);
+    }
+
     FILE* fCfg = fopen(action_filename.c_str(), "r");
     if (!fCfg) {
         SMPL_ERROR("Failed to open action set file. (file: '%s')", action_filename.c_str());
@@ -178,6 +193,84 @@ bool ManipLatticeActionSpace::load(const std::string& action_filename)
     return true;
 }
 
+bool ManipLatticeActionSpace::loadBinary(const std::string& path)
+{
+    auto file = make_unique<MotionPrimitiveFile>();
+    if (!file->open(path)) {
+        return false;
+    }
+
+    auto& res = static_cast<ManipLattice*>(planningSpace())->resolutions();
+    if (file->dof() != res.size()) {
+        SMPL_ERROR("Motion primitive file '%s' has %zu variables (expected %zu)", path.c_str(), file->dof(), res.size());
+        return false;
+    }
+    for (size_t j = 0; j < res.size(); ++j) {
+        if (std::fabs(file->resolutions()[j] - res[j]) > 1e-9) {
+            SMPL_ERROR("Motion primitive file '%s' was generated for resolution %f of variable %zu (expected %f)", path.c_str(), file->resolutions()[j], j, res[j]);
+            return false;
+        }
+    }
+
+    // the mapped deltas may stand in for the compiled table only if they are
+    // the only long and short distance primitives in the set
+    auto have_prims = std::any_of(
+            m_mprims.begin(), m_mprims.end(),
+            [](const MotionPrimitive& prim)
+            {
+                return prim.type == MotionPrimitive::LONG_DISTANCE ||
+                        prim.type == MotionPrimitive::SHORT_DISTANCE;
+            });
+
+    if (!have_prims) {
+        compilePrimitives();
+    }
+
+    auto dim = file->dof();
+    auto have_short_dist_mprims = false;
+    for (size_t i = 0; i < file->num_primitives(); ++i) {
+        auto& record = file->record(i);
+
+        MotionPrimitive prim;
+        prim.type = (MotionPrimitive::Type)record.type;
+        auto* delta = file->deltas(i);
+        for (size_t w = 0; w < record.waypoint_count; ++w) {
+            prim.action.emplace_back(delta, delta + dim);
+            delta += dim;
+        }
+        m_mprims.push_back(std::move(prim));
+
+        CompiledPrimitive entry;
+        entry.offset = record.first_waypoint * dim;
+        entry.waypoint_count = record.waypoint_count;
+        entry.dim = dim;
+        entry.cost = record.cost;
+        entry.max_displacement = record.max_displacement;
+        m_compiled_prims.push_back(entry);
+
+        have_short_dist_mprims |= record.type == MotionPrimitive::SHORT_DISTANCE;
+    }
+
+    if (have_short_dist_mprims) {
+        useAmp(MotionPrimitive::SHORT_DISTANCE, true);
+    }
+
+    if (have_prims) {
+        compilePrimitives();
+    } else {
+        m_prim_file = std::move(file);
+        m_prim_delta_data = m_prim_file->deltas();
+    }
+
+    return true;
+}
+
+bool ManipLatticeActionSpace::save(const std::string& path) const
+{
+    auto& res = static_cast<const ManipLattice*>(planningSpace())->resolutions();
+    return WriteMotionPrimitiveFile(path, m_mprims, res);
+}
+
 /// \brief Add a long or short distance motion primitive to the action set
 /// \param mprim The angle delta for each joint, in radians
 /// \param short_dist true = short distance; false = long distance
@@ -207,6 +300,8 @@ void ManipLatticeActionSpace::addMotionPrim(
         }
         m_mprims.push_back(m);
     }
+
+    compilePrimitives();
 }
 
 /// \brief Remove long and short motion primitives and disable adaptive motions.
@@ -234,6 +329,64 @@ void ManipLatticeActionSpace::clear()
     for (int i = 0; i < MotionPrimitive::NUMBER_OF_MPRIM_TYPES; ++i) {
         m_mprim_enabled[i] = (i == MotionPrimitive::Type::LONG_DISTANCE);
     }
+
+    compilePrimitives();
+}
+
+/// Rebuild the flat delta table from the current motion primitive set.
+void ManipLatticeActionSpace::compilePrimitives()
+{
+    m_prim_file.reset();
+    m_compiled_prims.assign(m_mprims.size(), CompiledPrimitive());
+    m_prim_deltas.clear();
+    for (size_t i = 0; i < m_mprims.size(); ++i) {
+        auto& prim = m_mprims[i];
+        if (prim.type != MotionPrimitive::LONG_DISTANCE &&
+            prim.type != MotionPrimitive::SHORT_DISTANCE)
+        {
+            continue;
+        }
+        if (prim.action.empty()) {
+            continue;
+        }
+
+        auto& entry = m_compiled_prims[i];
+        entry.offset = m_prim_deltas.size();
+        entry.dim = prim.action.front().size();
+        for (auto& waypoint : prim.action) {
+            if (waypoint.size() != entry.dim) {
+                // leave ragged primitives to applyMotionPrimitive
+                m_prim_deltas.resize(entry.offset);
+                entry = CompiledPrimitive();
+                break;
+            }
+            m_prim_deltas.insert(
+                    m_prim_deltas.end(), waypoint.begin(), waypoint.end());
+            ++entry.waypoint_count;
+        }
+        entry.cost = MotionPrimitiveCost(prim.action);
+        entry.max_displacement = MotionPrimitiveMaxDisplacement(prim.action);
+    }
+    m_prim_delta_data = m_prim_deltas.data();
+}
+
+double ManipLatticeActionSpace::primitiveCost(size_t i) const
+{
+    return m_compiled_prims[i].cost;
+}
+
+double ManipLatticeActionSpace::primitiveMaxDisplacement(size_t i) const
+{
+    return m_compiled_prims[i].max_displacement;
+}
+
+double ManipLatticeActionSpace::maxPrimitiveDisplacement() const
+{
+    auto max_disp = 0.0;
+    for (auto& entry : m_compiled_prims) {
+        max_disp = std::max(max_disp, entry.max_displacement);
+    }
+    return max_disp;
 }
 
 int ManipLatticeActionSpace::longDistCount() const
@@ -273,6 +426,11 @@ bool ManipLatticeActionSpace::useLongAndShortPrims() const
     return m_use_long_and_short_dist_mprims;
 }
 
+bool ManipLatticeActionSpace::useIkCache() const
+{
+    return m_use_ik_cache;
+}
+
 double ManipLatticeActionSpace::ampThresh(MotionPrimitive::Type type) const
 {
     return m_mprim_thresh[type];
@@ -293,6 +451,124 @@ void ManipLatticeActionSpace::useLongAndShortPrims(bool enable)
     m_use_long_and_short_dist_mprims = enable;
 }
 
+/// \brief Enable caching of adaptive motion IK results.
+///
+/// When enabled, IK results for snap motions are reused for every state that
+/// discretizes to the same lattice coordinate as a previously solved seed,
+/// until the goal changes.
+void ManipLatticeActionSpace::useIkCache(bool enable)
+{
+    m_use_ik_cache = enable;
+    clearIkCache();
+}
+
+void ManipLatticeActionSpace::clearIkCache()
+{
+    m_ik_cache.clear();
+    m_ik_cache_hits = 0;
+    m_ik_cache_misses = 0;
+}
+
+/// \brief Solve adaptive motions from multiple IK seeds.
+///
+/// The first seed is the parent state and the rest are sampled within the
+/// joint limits. Seeds are solved concurrently on \p thread_count threads,
+/// and only collision-free solutions are returned. A \p seed_count of 1
+/// restores the single, parent-seeded IK query.
+bool ManipLatticeActionSpace::setIkSampling(int seed_count, int thread_count)
+{
+    clearIkCache();
+
+    if (seed_count <= 1) {
+        m_ik_sampler.reset();
+        return true;
+    }
+
+    auto sampler = make_unique<IKSampler>();
+    if (!sampler->init(
+            planningSpace()->robot(),
+            planningSpace()->collisionChecker(),
+            thread_count))
+    {
+        SMPL_ERROR("Failed to initialize IK sampler");
+        return false;
+    }
+    sampler->setSeedCount(seed_count);
+    sampler->setReachabilityMap(m_reachability_map);
+
+    m_ik_sampler = std::move(sampler);
+    return true;
+}
+
+int ManipLatticeActionSpace::ikSamplingSeeds() const
+{
+    return m_ik_sampler ? m_ik_sampler->seedCount() : 1;
+}
+
+void ManipLatticeActionSpace::setReachabilityMap(const ReachabilityMap* map)
+{
+    clearIkCache();
+    m_reachability_map = map;
+    if (m_ik_sampler) {
+        m_ik_sampler->setReachabilityMap(map);
+    }
+}
+
+/// \brief Scale long distance motion primitives by the clearance of the state
+///     they are applied to.
+///
+/// Requires a Collision Checker with the Collision Distance Extension. Large
+/// steps are taken in free space and the unscaled primitives are used near
+/// obstacles.
+bool ManipLatticeActionSpace::useClearanceScaling(bool enable)
+{
+    if (!enable) {
+        m_use_clearance_scaling = false;
+        m_cdist_iface = nullptr;
+        return true;
+    }
+
+    auto* checker = planningSpace()->collisionChecker();
+    m_cdist_iface = checker ?
+            checker->getExtension<CollisionDistanceExtension>() : nullptr;
+    if (!m_cdist_iface) {
+        SMPL_ERROR("Clearance scaling requires Collision Distance Extension");
+        m_use_clearance_scaling = false;
+        return false;
+    }
+
+    m_use_clearance_scaling = true;
+    return true;
+}
+
+void ManipLatticeActionSpace::setClearanceScaling(
+    double min_clearance,
+    double max_clearance,
+    int max_scale)
+{
+    m_clearance_min = min_clearance;
+    m_clearance_max = std::max(min_clearance, max_clearance);
+    m_max_step_scale = std::max(1, max_scale);
+}
+
+int ManipLatticeActionSpace::clearanceScale(const RobotState& state)
+{
+    if (!m_use_clearance_scaling || m_max_step_scale <= 1) {
+        return 1;
+    }
+
+    auto clearance = m_cdist_iface->distanceToCollision(state);
+    if (clearance <= m_clearance_min) {
+        return 1;
+    }
+    if (clearance >= m_clearance_max) {
+        return m_max_step_scale;
+    }
+
+    auto alpha = (clearance - m_clearance_min) / (m_clearance_max - m_clearance_min);
+    return 1 + (int)(alpha * (m_max_step_scale - 1));
+}
+
 void ManipLatticeActionSpace::ampThresh(
     MotionPrimitive::Type type,
     double thresh)
@@ -334,6 +610,8 @@ bool ManipLatticeActionSpace::apply(
     double goal_dist, start_dist;
     std::tie(start_dist, goal_dist) = getStartGoalDistances(parent);
 
+    m_step_scale = clearanceScale(parent);
+
     for (auto& prim : m_mprims) {
         (void)getAction(parent, goal_dist, start_dist, prim, actions);
     }
@@ -345,6 +623,84 @@ bool ManipLatticeActionSpace::apply(
     return true;
 }
 
+/// Produce the same actions as apply(), in the same order, but write long and
+/// short distance primitives directly from the compiled delta table into the
+/// waypoints already allocated in \p actions.
+void ManipLatticeActionSpace::updateGoal(const GoalConstraint& goal)
+{
+    if (!m_ik_cache.empty()) {
+        SMPL_DEBUG_NAMED(G_LOG, "IK cache: %zu entries, %zu hits, %zu misses", m_ik_cache.size(), m_ik_cache_hits, m_ik_cache_misses);
+    }
+    clearIkCache();
+}
+
+bool ManipLatticeActionSpace::applyBuffered(
+    const RobotState& parent,
+    std::vector<Action>& actions,
+    size_t& count)
+{
+    // m_mprims is visible to derived classes; recompile if it was modified
+    // behind our back
+    if (m_compiled_prims.size() != m_mprims.size()) {
+        compilePrimitives();
+    }
+
+    double goal_dist, start_dist;
+    std::tie(start_dist, goal_dist) = getStartGoalDistances(parent);
+
+    m_step_scale = clearanceScale(parent);
+
+    count = 0;
+    auto next_action = [&]() -> Action& {
+        if (count == actions.size()) {
+            actions.emplace_back();
+        }
+        return actions[count++];
+    };
+
+    for (size_t pidx = 0; pidx < m_mprims.size(); ++pidx) {
+        auto& prim = m_mprims[pidx];
+        auto& entry = m_compiled_prims[pidx];
+        if (entry.waypoint_count == 0) {
+            m_amp_actions.clear();
+            (void)getAction(parent, goal_dist, start_dist, prim, m_amp_actions);
+            for (auto& amp_action : m_amp_actions) {
+                next_action() = std::move(amp_action);
+            }
+            continue;
+        }
+
+        if (!mprimActive(start_dist, goal_dist, prim.type)) {
+            continue;
+        }
+        if (entry.dim != parent.size()) {
+            continue;
+        }
+
+        auto scale = prim.type == MotionPrimitive::LONG_DISTANCE ?
+                (double)m_step_scale : 1.0;
+
+        auto& action = next_action();
+        action.resize(entry.waypoint_count);
+        auto* delta = m_prim_delta_data + entry.offset;
+        for (auto& waypoint : action) {
+            waypoint.resize(entry.dim);
+            auto* out = waypoint.data();
+            auto* in = parent.data();
+            for (size_t j = 0; j < entry.dim; ++j) {
+                out[j] = in[j] + scale * delta[j];
+            }
+            delta += entry.dim;
+        }
+    }
+
+    if (count == 0) {
+        SMPL_WARN_ONCE("No motion primitives specified");
+    }
+
+    return true;
+}
+
 bool ManipLatticeActionSpace::getAction(
     const RobotState& parent,
     double goal_dist,
@@ -417,6 +773,9 @@ bool ManipLatticeActionSpace::applyMotionPrimitive(
     const MotionPrimitive& mp,
     Action& action)
 {
+    auto scale = mp.type == MotionPrimitive::LONG_DISTANCE ?
+            (double)m_step_scale : 1.0;
+
     action = mp.action;
     for (size_t i = 0; i < action.size(); ++i) {
         if (action[i].size() != state.size()) {
@@ -424,7 +783,7 @@ bool ManipLatticeActionSpace::applyMotionPrimitive(
         }
 
         for (size_t j = 0; j < action[i].size(); ++j) {
-            action[i][j] = action[i][j] + state[j];
+            action[i][j] = scale * action[i][j] + state[j];
         }
     }
     return true;
@@ -441,28 +800,92 @@ bool ManipLatticeActionSpace::computeIkAction(
         return false;
     }
 
-    if (m_use_multiple_ik_solutions) {
-        //get actions for multiple ik solutions
-        std::vector<RobotState> solutions;
-        if (!m_ik_iface->computeIK(goal, state, solutions, option)) {
-            return false;
+    std::vector<RobotState> solutions;
+    if (!computeIkSolutions(state, goal, option, solutions)) {
+        return false;
+    }
+
+    for (auto& solution : solutions) {
+        Action action = { std::move(solution) };
+        actions.push_back(std::move(action));
+    }
+
+    return true;
+}
+
+auto ManipLatticeActionSpace::IkCacheKeyHash::operator()(
+    const argument_type& s) const -> result_type
+{
+    std::size_t seed = 0;
+    boost::hash_combine(seed, boost::hash_range(s.begin(), s.end()));
+    return seed;
+}
+
+bool ManipLatticeActionSpace::computeIkSolutions(
+    const RobotState& state,
+    const Affine3& goal,
+    ik_option::IkOption option,
+    std::vector<RobotState>& solutions)
+{
+    auto solve = [&]() -> bool
+    {
+        if (m_ik_sampler) {
+            if (m_use_multiple_ik_solutions) {
+                return m_ik_sampler->solve(
+                        goal, state, m_ik_sampler->seedCount(), solutions, option);
+            }
+
+            RobotState ik_sol;
+            if (!m_ik_sampler->solve(goal, state, ik_sol, option)) {
+                return false;
+            }
+            solutions.push_back(std::move(ik_sol));
+            return true;
         }
-        for (auto& solution : solutions) {
-            Action action = { std::move(solution) };
-            actions.push_back(std::move(action));
+
+        if (m_use_multiple_ik_solutions) {
+            //get actions for multiple ik solutions
+            return m_ik_iface->computeIK(goal, state, solutions, option);
         }
-    } else {
+
         //get single action for single ik solution
         RobotState ik_sol;
         if (!m_ik_iface->computeIK(goal, state, ik_sol)) {
             return false;
         }
+        solutions.push_back(std::move(ik_sol));
+        return true;
+    };
 
-        Action action = { std::move(ik_sol) };
-        actions.push_back(std::move(action));
+    auto& res = static_cast<ManipLattice*>(planningSpace())->resolutions();
+    if (!m_use_ik_cache || res.size() != state.size()) {
+        return solve();
     }
 
-    return true;
+    // seeds within the same lattice cell share their IK result; the goal is
+    // fixed between calls to updateGoal
+    m_ik_cache_key.resize(state.size() + 2);
+    for (size_t i = 0; i < state.size(); ++i) {
+        m_ik_cache_key[i] = (int)std::lround(state[i] / res[i]);
+    }
+    m_ik_cache_key[state.size()] = (int)option;
+    m_ik_cache_key[state.size() + 1] = m_use_multiple_ik_solutions ? 1 : 0;
+
+    auto it = m_ik_cache.find(m_ik_cache_key);
+    if (it != m_ik_cache.end()) {
+        ++m_ik_cache_hits;
+        TelemetryCount(TelemetryEvent::IkCacheHit);
+        solutions = it->second;
+        return !solutions.empty();
+    }
+
+    ++m_ik_cache_misses;
+    TelemetryCount(TelemetryEvent::IkCacheMiss);
+    if (!solve()) {
+        solutions.clear();
+    }
+    m_ik_cache[m_ik_cache_key] = solutions;
+    return !solutions.empty();
 }
 
 bool ManipLatticeActionSpace::mprimActive(
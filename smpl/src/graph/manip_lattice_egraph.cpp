@@ -29,6 +29,7 @@
 
 #include <smpl/graph/manip_lattice_egraph.h>
 
+#include <algorithm>
 #include <fstream>
 
 #include <boost/filesystem.hpp>
@@ -37,8 +38,12 @@
 #include <smpl/console/nonstd.h>
 #include <smpl/csv_parser.h>
 #include <smpl/debug/visualize.h>
+#include <smpl/graph/experience_graph_file.h>
 #include <smpl/graph/manip_lattice_action_space.h>
 #include <smpl/heap/intrusive_heap.h>
+#include <smpl/heuristic/egraph_heuristic.h>
+#include <smpl/heuristic/robot_heuristic.h>
+#include <smpl/worker_pool.h>
 
 namespace smpl {
 
@@ -226,83 +231,271 @@ bool ManipLatticeEgraph::extractPath(
     return true;
 }
 
+void ManipLatticeEgraph::clearStates()
+{
+    ManipLattice::clearStates();
+
+    // re-reserve hash entries for the experience graph states
+    m_state_to_node.clear();
+    auto nodes = m_egraph.nodes();
+    for (auto nit = nodes.first; nit != nodes.second; ++nit) {
+        auto& state = m_egraph.state(*nit);
+        RobotCoord coord(robot()->jointVariableCount());
+        stateToCoord(state, coord);
+
+        int entry_id = reserveHashEntry(coord, state);
+
+        m_egraph_state_ids[*nit] = entry_id;
+        m_state_to_node[entry_id] = *nit;
+    }
+}
+
 bool ManipLatticeEgraph::loadExperienceGraph(const std::string& path)
 {
     SMPL_INFO("Load Experience Graph at %s", path.c_str());
 
     boost::filesystem::path p(path);
+    if (IsSharedExperienceGraph(path) ||
+        (boost::filesystem::is_regular_file(p) && IsExperienceGraphFile(path)))
+    {
+        return loadExperienceGraphFile(path);
+    }
+
     if (!boost::filesystem::is_directory(p)) {
         SMPL_ERROR("'%s' is not a directory", path.c_str());
         return false;
     }
 
+    // merge demonstrations in a fixed order so that node ids do not depend on
+    // the directory listing or the number of threads
+    std::vector<std::string> filepaths;
     for (auto dit = boost::filesystem::directory_iterator(p);
         dit != boost::filesystem::directory_iterator(); ++dit)
     {
-        auto& filepath = dit->path().generic_string();
-        std::vector<RobotState> egraph_states;
-        if (!parseExperienceGraphFile(filepath, egraph_states)) {
-            continue;
+        filepaths.push_back(dit->path().generic_string());
+    }
+    std::sort(begin(filepaths), end(filepaths));
+
+    // Parsing and discretizing a demonstration only reads the lattice
+    // configuration, so every file is processed independently. Only the merge
+    // into the experience graph and the state table is serial.
+    struct Demonstration
+    {
+        std::vector<RobotState> states;
+        std::vector<RobotCoord> coords;
+    };
+
+    std::vector<Demonstration> demos(filepaths.size());
+    auto load_demo = [&](int, std::size_t i)
+    {
+        auto& demo = demos[i];
+        if (!parseExperienceGraphFile(filepaths[i], demo.states)) {
+            demo.states.clear();
+            return;
         }
 
-        if (egraph_states.empty()) {
+        demo.coords.resize(
+                demo.states.size(), RobotCoord(robot()->jointVariableCount()));
+        for (size_t j = 0; j < demo.states.size(); ++j) {
+            stateToCoord(demo.states[j], demo.coords[j]);
+        }
+    };
+
+    auto thread_count = std::min((std::size_t)m_egraph_load_threads, filepaths.size());
+    if (thread_count > 1) {
+        WorkerPool pool((int)thread_count);
+        pool.run(filepaths.size(), load_demo);
+    } else {
+        for (size_t i = 0; i < filepaths.size(); ++i) {
+            load_demo(0, i);
+        }
+    }
+
+    for (auto& demo : demos) {
+        if (demo.states.empty()) {
             continue;
         }
 
-        SMPL_INFO("Create hash entries for experience graph states");
+        addExperienceGraphPath(demo.states, demo.coords, 0.0);
+
+        // release the demonstration once it has been merged
+        demo = Demonstration();
+    }
+    SMPL_INFO("Created hash entries for experience graph states");
+
+    m_egraph.compact();
+    updateExperienceGraphIndex();
+
+    SMPL_INFO("Experience graph contains %zu nodes and %zu edges", m_egraph.num_nodes(), m_egraph.num_edges());
+    return true;
+}
+
+bool ManipLatticeEgraph::insertExperienceGraphPath(
+    const std::vector<RobotState>& path,
+    double merge_radius)
+{
+    if (path.empty()) {
+        return false;
+    }
 
-        auto& pp = egraph_states.front();  // previous robot state
-        RobotCoord pdp(robot()->jointVariableCount()); // previous robot coord
-        stateToCoord(egraph_states.front(), pdp);
+    auto first_node = m_egraph.num_nodes();
+    auto first_edge = m_egraph.num_edges();
 
-        auto pid = m_egraph.insert_node(pp);
-        m_coord_to_nodes[pdp].push_back(pid);
+    // merge against the nodes that existed before this path
+    updateExperienceGraphIndex();
+    addExperienceGraphPath(path, merge_radius);
 
-        int entry_id = reserveHashEntry();
-        auto* entry = getHashEntry(entry_id);
-        entry->coord = pdp;
-        entry->state = pp;
+    m_egraph.compact();
+    updateExperienceGraphIndex();
+
+    SMPL_INFO("Inserted %zu nodes and %zu edges into the experience graph", m_egraph.num_nodes() - first_node, m_egraph.num_edges() - first_edge);
+
+    for (size_t i = 0; i < numHeuristics(); ++i) {
+        auto* egh = heuristic(i)->getExtension<ExperienceGraphHeuristicExtension>();
+        if (egh) {
+            egh->experienceGraphExtended(first_node, first_edge);
+        }
+    }
+    return true;
+}
+
+// Insert the states of a path as experience graph nodes wherever the path
+// crosses into a new discrete state; the states in between become the
+// waypoints of the edge joining them. States within merge_radius of a node
+// in the experience graph index reuse that node.
+void ManipLatticeEgraph::addExperienceGraphPath(
+    const std::vector<RobotState>& path,
+    double merge_radius)
+{
+    std::vector<RobotCoord> coords(
+            path.size(), RobotCoord(robot()->jointVariableCount()));
+    for (size_t i = 0; i < path.size(); ++i) {
+        stateToCoord(path[i], coords[i]);
+    }
+    addExperienceGraphPath(path, coords, merge_radius);
+}
+
+// As above, with the discrete coordinates of the path states precomputed.
+void ManipLatticeEgraph::addExperienceGraphPath(
+    const std::vector<RobotState>& path,
+    const std::vector<RobotCoord>& coords,
+    double merge_radius)
+{
+    std::vector<std::size_t> nearest;
+    auto merge_node = [&](const RobotState& state, ExperienceGraph::node_id& n) -> bool {
+        if (merge_radius <= 0.0) {
+            return false;
+        }
+        m_egraph_index.nearest(state.data(), 1, nearest);
+        if (nearest.empty()) {
+            return false;
+        }
+        auto& nstate = m_egraph.state(nearest.front());
+        double d2 = 0.0;
+        for (size_t i = 0; i < state.size(); ++i) {
+            d2 += (state[i] - nstate[i]) * (state[i] - nstate[i]);
+        }
+        if (d2 > merge_radius * merge_radius) {
+            return false;
+        }
+        n = nearest.front();
+        return true;
+    };
+
+    auto add_node = [&](const RobotState& state, const RobotCoord& coord)
+        -> ExperienceGraph::node_id
+    {
+        ExperienceGraph::node_id n;
+        if (merge_node(state, n)) {
+            return n;
+        }
+
+        n = m_egraph.insert_node(state);
+        m_coord_to_nodes[coord].push_back(n);
+
+        int entry_id = reserveHashEntry(coord, state);
 
         // map state id <-> experience graph state
-        m_egraph_state_ids.resize(pid + 1, -1);
-        m_egraph_state_ids[pid] = entry_id;
-        m_state_to_node[entry_id] = pid;
-
-        std::vector<RobotState> edge_data;
-        for (size_t i = 1; i < egraph_states.size(); ++i) {
-            auto& p = egraph_states[i];
-            RobotCoord dp(robot()->jointVariableCount());
-            stateToCoord(p, dp);
-            if (dp != pdp) {
-                // found a new discrete state along the path
-
-                auto id = m_egraph.insert_node(p);
-                m_coord_to_nodes[dp].push_back(id);
-
-                int entry_id = reserveHashEntry();
-                auto* entry = getHashEntry(entry_id);
-                entry->coord = dp;
-                entry->state = p;
-
-                m_egraph_state_ids.resize(id + 1, -1);
-                m_egraph_state_ids[id] = entry_id;
-                m_state_to_node[entry_id] = id;
-                m_egraph.insert_edge(pid, id, edge_data);
+        m_egraph_state_ids.resize(n + 1, -1);
+        m_egraph_state_ids[n] = entry_id;
+        m_state_to_node[entry_id] = n;
+        return n;
+    };
 
-                pdp = dp;
-                pid = id;
-                edge_data.clear();
-            } else {
-                // gather intermediate robot states
-                edge_data.push_back(p);
+    auto* pdp = &coords.front(); // previous robot coord
+
+    auto pid = add_node(path.front(), *pdp);
+
+    std::vector<RobotState> edge_data;
+    for (size_t i = 1; i < path.size(); ++i) {
+        auto& p = path[i];
+        auto& dp = coords[i];
+        if (dp != *pdp) {
+            // found a new discrete state along the path
+            auto id = add_node(p, dp);
+            if (id != pid && !m_egraph.edge(pid, id)) {
+                m_egraph.insert_edge(pid, id, edge_data);
             }
+
+            pdp = &dp;
+            pid = id;
+            edge_data.clear();
+        } else {
+            // gather intermediate robot states
+            edge_data.push_back(p);
         }
     }
+}
+
+// Append the experience graph stored in a binary file written by
+// saveExperienceGraph(). The file already records which demonstration states
+// became nodes, so only hash entries for the nodes need to be created.
+bool ManipLatticeEgraph::loadExperienceGraphFile(const std::string& path)
+{
+    ExperienceGraphFile file;
+    if (!file.open(path)) {
+        return false;
+    }
+
+    if (file.num_nodes() != 0 && file.dof() != robot()->jointVariableCount()) {
+        SMPL_ERROR("Experience graph file '%s' has %zu variables (expected %zu)", path.c_str(), file.dof(), robot()->jointVariableCount());
+        return false;
+    }
+
+    auto first = m_egraph.num_nodes();
+    AppendExperienceGraphFile(file, m_egraph);
+
+    m_egraph_state_ids.resize(m_egraph.num_nodes(), -1);
+    RobotCoord coord(robot()->jointVariableCount());
+    for (auto n = first; n < m_egraph.num_nodes(); ++n) {
+        auto& state = m_egraph.state(n);
+        stateToCoord(state, coord);
+        m_coord_to_nodes[coord].push_back(n);
+
+        int entry_id = reserveHashEntry(coord, state);
+        m_egraph_state_ids[n] = entry_id;
+        m_state_to_node[entry_id] = n;
+    }
+
+    m_egraph.compact();
+    updateExperienceGraphIndex();
 
     SMPL_INFO("Experience graph contains %zu nodes and %zu edges", m_egraph.num_nodes(), m_egraph.num_edges());
     return true;
 }
 
+/// Write the loaded experience graph to a binary file that can be passed to
+/// loadExperienceGraph() in place of a directory of demonstrations.
+bool ManipLatticeEgraph::saveExperienceGraph(const std::string& path) const
+{
+    return WriteExperienceGraphFile(path, m_egraph);
+}
+
+void ManipLatticeEgraph::setExperienceGraphLoadThreadCount(int count)
+{
+    m_egraph_load_threads = std::max(1, count);
+}
+
 void ManipLatticeEgraph::getExperienceGraphNodes(
     int state_id,
     std::vector<ExperienceGraph::node_id>& nodes)
@@ -313,6 +506,53 @@ void ManipLatticeEgraph::getExperienceGraphNodes(
     }
 }
 
+void ManipLatticeEgraph::getNearestExperienceGraphNodes(
+    const RobotState& state,
+    int k,
+    std::vector<ExperienceGraph::node_id>& nodes)
+{
+    if (k <= 0 || state.size() != robot()->jointVariableCount()) {
+        return;
+    }
+    updateExperienceGraphIndex();
+    std::vector<std::size_t> indices;
+    m_egraph_index.nearest(state.data(), k, indices);
+    nodes.insert(nodes.end(), indices.begin(), indices.end());
+}
+
+void ManipLatticeEgraph::getExperienceGraphNodesInRadius(
+    const RobotState& state,
+    double radius,
+    std::vector<ExperienceGraph::node_id>& nodes)
+{
+    if (state.size() != robot()->jointVariableCount()) {
+        return;
+    }
+    updateExperienceGraphIndex();
+    std::vector<std::size_t> indices;
+    m_egraph_index.radius(state.data(), radius, indices);
+    nodes.insert(nodes.end(), indices.begin(), indices.end());
+}
+
+// Rebuild the joint-space index over experience graph node states if nodes
+// were inserted or erased since it was last built.
+void ManipLatticeEgraph::updateExperienceGraphIndex()
+{
+    if (m_egraph_index.size() == m_egraph.num_nodes()) {
+        return;
+    }
+
+    auto dof = robot()->jointVariableCount();
+    std::vector<double> points;
+    points.reserve(m_egraph.num_nodes() * dof);
+    auto nodes = m_egraph.nodes();
+    for (auto nit = nodes.first; nit != nodes.second; ++nit) {
+        auto& state = m_egraph.state(*nit);
+        points.insert(points.end(), state.begin(), state.end());
+    }
+    m_egraph_index.build(points.data(), m_egraph.num_nodes(), dof);
+}
+
 bool ManipLatticeEgraph::shortcut(
     int first_id,
     int second_id,
@@ -364,6 +604,72 @@ bool ManipLatticeEgraph::snap(
     return true;
 }
 
+/// Shortcuts are not checked, so every shortcut to an existing state is valid.
+int ManipLatticeEgraph::shortcutBatch(
+    int first_id,
+    const int* second_ids,
+    int n,
+    int* costs)
+{
+    if (getHashEntry(first_id) == NULL) {
+        SMPL_WARN("No state entry for state %d", first_id);
+        std::fill(costs, costs + n, -1);
+        return 0;
+    }
+
+    auto count = 0;
+    for (auto i = 0; i < n; ++i) {
+        if (getHashEntry(second_ids[i]) != NULL) {
+            costs[i] = 1000;
+            ++count;
+        } else {
+            costs[i] = -1;
+        }
+    }
+    SMPL_DEBUG_NAMED(G_LOG, "%d of %d shortcuts from %d", count, n, first_id);
+    return count;
+}
+
+/// The snap motions are collision checked together, on the action check
+/// threads if there are more than one (see setActionCheckThreadCount()).
+int ManipLatticeEgraph::snapBatch(
+    int first_id,
+    const int* second_ids,
+    int n,
+    int* costs)
+{
+    auto* first_entry = getHashEntry(first_id);
+    if (first_entry == NULL) {
+        SMPL_WARN("No state entry for state %d", first_id);
+        std::fill(costs, costs + n, -1);
+        return 0;
+    }
+
+    // collect the candidates with state entries, then check them together
+    m_snap_targets.clear();
+    for (auto i = 0; i < n; ++i) {
+        auto* second_entry = getHashEntry(second_ids[i]);
+        if (second_entry != NULL) {
+            m_snap_targets.push_back(&second_entry->state);
+        }
+    }
+
+    checkMotions(first_entry->state, m_snap_targets, m_snap_valid);
+
+    auto count = 0;
+    auto next = 0;
+    for (auto i = 0; i < n; ++i) {
+        if (getHashEntry(second_ids[i]) != NULL && m_snap_valid[next++]) {
+            costs[i] = 1000;
+            ++count;
+        } else {
+            costs[i] = -1;
+        }
+    }
+    SMPL_DEBUG_NAMED(G_LOG, "%d of %d snaps from %d", count, n, first_id);
+    return count;
+}
+
 const ExperienceGraph* ManipLatticeEgraph::getExperienceGraph() const
 {
     return &m_egraph;
@@ -392,6 +698,27 @@ Extension* ManipLatticeEgraph::getExtension(size_t class_code)
     }
 }
 
+auto ManipLatticeEgraph::memoryUsage() const -> std::size_t
+{
+    auto usage = ManipLattice::memoryUsage();
+    usage += m_egraph.mem_usage();
+    usage += MemoryUsage(m_egraph_state_ids);
+    usage += m_egraph_index.memoryUsage();
+
+    // approximate the hash tables by their buckets and one node per entry
+    usage += m_coord_to_nodes.bucket_count() * sizeof(void*);
+    usage += m_coord_to_nodes.size() *
+            (sizeof(CoordToExperienceGraphNodeMap::value_type) + sizeof(void*));
+    for (auto& entry : m_coord_to_nodes) {
+        usage += MemoryUsage(entry.first);
+        usage += MemoryUsage(entry.second);
+    }
+    usage += m_state_to_node.bucket_count() * sizeof(void*);
+    usage += m_state_to_node.size() *
+            (sizeof(decltype(m_state_to_node)::value_type) + sizeof(void*));
+    return usage;
+}
+
 bool ManipLatticeEgraph::findShortestExperienceGraphPath(
     ExperienceGraph::node_id start_node,
     ExperienceGraph::node_id goal_node,
@@ -479,14 +806,9 @@ bool ManipLatticeEgraph::parseExperienceGraphFile(
     const std::string& filepath,
     std::vector<RobotState>& egraph_states) const
 {
-    std::ifstream fin(filepath);
-    if (!fin.is_open()) {
-        return false;
-    }
-
     CSVParser parser;
     const bool with_header = true;
-    if (!parser.parseStream(fin, with_header)) {
+    if (!parser.parseNumericFile(filepath, with_header)) {
         SMPL_ERROR("Failed to parse experience graph file '%s'", filepath.c_str());
         return false;
     }
@@ -502,21 +824,10 @@ bool ManipLatticeEgraph::parseExperienceGraphFile(
         return false;
     }
 
-    egraph_states.reserve(parser.totalFieldCount());
+    egraph_states.reserve(parser.recordCount());
     for (size_t i = 0; i < parser.recordCount(); ++i) {
-        RobotState state(jvar_count);
-        for (size_t j = 0; j < parser.fieldCount(); ++j) {
-            try {
-                state[j] = std::stod(parser.fieldAt(i, j));
-            } catch (const std::invalid_argument& ex) {
-                SMPL_ERROR("Failed to parse egraph state variable (%s)", ex.what());
-                return false;
-            } catch (const std::out_of_range& ex) {
-                SMPL_ERROR("Failed to parse egraph state variable (%s)", ex.what());
-                return false;
-            }
-        }
-        egraph_states.push_back(std::move(state));
+        auto* record = parser.record(i);
+        egraph_states.emplace_back(record, record + jvar_count);
     }
 
     SMPL_INFO("Read %zu states from experience graph file", egraph_states.size());
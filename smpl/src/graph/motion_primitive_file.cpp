@@ -0,0 +1,384 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <smpl/graph/motion_primitive_file.h>
+
+// standard includes
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+// system includes
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// project includes
+#include <smpl/console/console.h>
+
+namespace smpl {
+
+static_assert(sizeof(MotionPrimitiveFileHeader) % sizeof(double) == 0,
+        "Motion primitive file sections must be 8-byte aligned");
+static_assert(sizeof(MotionPrimitiveRecord) == 4 * sizeof(std::uint64_t),
+        "Motion primitive records must be tightly packed");
+
+MotionPrimitiveFile::~MotionPrimitiveFile()
+{
+    close();
+}
+
+bool MotionPrimitiveFile::open(const std::string& path)
+{
+    if (IsSharedMotionPrimitives(path)) {
+        return openShared(path.substr(std::strlen(MOTION_PRIMITIVE_SHARED_PREFIX)));
+    }
+
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        SMPL_ERROR("Failed to open motion primitive file '%s'", path.c_str());
+        return false;
+    }
+
+    return map(fd, path);
+}
+
+bool MotionPrimitiveFile::openShared(const std::string& name)
+{
+    close();
+
+    int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        SMPL_ERROR("Failed to open shared motion primitives '%s'", name.c_str());
+        return false;
+    }
+
+    return map(fd, name);
+}
+
+// Map and validate the motion primitive file open on fd, taking ownership of
+// fd.
+bool MotionPrimitiveFile::map(int fd, const std::string& what)
+{
+    auto* path = what.c_str();
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(MotionPrimitiveFileHeader)) {
+        SMPL_ERROR("Motion primitive file '%s' is truncated", path);
+        ::close(fd);
+        return false;
+    }
+
+    void* data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        SMPL_ERROR("Failed to map motion primitive file '%s'", path);
+        return false;
+    }
+
+    m_data = data;
+    m_size = st.st_size;
+
+    auto& h = header();
+    if (std::memcmp(h.magic, MOTION_PRIMITIVE_FILE_MAGIC, sizeof(h.magic)) != 0) {
+        SMPL_ERROR("'%s' is not a motion primitive file", path);
+        close();
+        return false;
+    }
+    if (h.version != MOTION_PRIMITIVE_FILE_VERSION) {
+        SMPL_ERROR("Motion primitive file '%s' has version %u (expected %u)", path, h.version, MOTION_PRIMITIVE_FILE_VERSION);
+        close();
+        return false;
+    }
+
+    auto words = (m_size - sizeof(MotionPrimitiveFileHeader)) / sizeof(double);
+    auto record_words = sizeof(MotionPrimitiveRecord) / sizeof(double);
+    auto size_ok = h.dof <= words &&
+            h.primitive_count <= (words - h.dof) / record_words &&
+            (h.dof == 0 ||
+            h.waypoint_count <= (words - h.dof - h.primitive_count * record_words) / h.dof) &&
+            h.dof + h.primitive_count * record_words + h.waypoint_count * h.dof == words;
+    if (!size_ok) {
+        SMPL_ERROR("Motion primitive file '%s' is truncated", path);
+        close();
+        return false;
+    }
+
+    auto* base = static_cast<const char*>(m_data) + sizeof(MotionPrimitiveFileHeader);
+    auto* resolutions = reinterpret_cast<const double*>(base);
+    auto* records = reinterpret_cast<const MotionPrimitiveRecord*>(
+            base + h.dof * sizeof(double));
+    for (std::uint64_t i = 0; i < h.primitive_count; ++i) {
+        auto& r = records[i];
+        if ((r.type != MotionPrimitive::LONG_DISTANCE &&
+                r.type != MotionPrimitive::SHORT_DISTANCE) ||
+            r.first_waypoint > h.waypoint_count ||
+            r.waypoint_count > h.waypoint_count - r.first_waypoint)
+        {
+            SMPL_ERROR("Motion primitive file '%s' has malformed primitives", path);
+            close();
+            return false;
+        }
+    }
+
+    m_resolutions = resolutions;
+    m_records = records;
+    m_deltas = reinterpret_cast<const double*>(records + h.primitive_count);
+    return true;
+}
+
+void MotionPrimitiveFile::close()
+{
+    if (m_data) {
+        ::munmap(m_data, m_size);
+        m_data = nullptr;
+        m_size = 0;
+        m_resolutions = nullptr;
+        m_records = nullptr;
+        m_deltas = nullptr;
+    }
+}
+
+double MotionPrimitiveCost(const Action& deltas)
+{
+    auto cost = 0.0;
+    const RobotState* prev = nullptr;
+    for (auto& waypoint : deltas) {
+        auto sq = 0.0;
+        for (std::size_t j = 0; j < waypoint.size(); ++j) {
+            auto d = waypoint[j] - (prev ? (*prev)[j] : 0.0);
+            sq += d * d;
+        }
+        cost += std::sqrt(sq);
+        prev = &waypoint;
+    }
+    return cost;
+}
+
+double MotionPrimitiveMaxDisplacement(const Action& deltas)
+{
+    auto max_disp = 0.0;
+    for (auto& waypoint : deltas) {
+        for (auto d : waypoint) {
+            max_disp = std::max(max_disp, std::fabs(d));
+        }
+    }
+    return max_disp;
+}
+
+bool IsMotionPrimitiveFile(const std::string& path)
+{
+    auto* f = std::fopen(path.c_str(), "rb");
+    if (!f) {
+        return false;
+    }
+    char magic[8];
+    auto ok = std::fread(magic, sizeof(magic), 1, f) == 1 &&
+            std::memcmp(magic, MOTION_PRIMITIVE_FILE_MAGIC, sizeof(magic)) == 0;
+    std::fclose(f);
+    return ok;
+}
+
+bool IsSharedMotionPrimitives(const std::string& path)
+{
+    return path.compare(0, std::strlen(MOTION_PRIMITIVE_SHARED_PREFIX), MOTION_PRIMITIVE_SHARED_PREFIX) == 0;
+}
+
+namespace {
+
+// The sections of a motion primitive set in the binary format, gathered
+// before they are written out.
+struct MotionPrimitiveImage
+{
+    MotionPrimitiveFileHeader header;
+    std::vector<double> resolutions;
+    std::vector<MotionPrimitiveRecord> records;
+    std::vector<double> deltas;
+
+    auto size() const -> std::size_t
+    {
+        return sizeof(header) +
+                sizeof(MotionPrimitiveRecord) * records.size() +
+                sizeof(double) * (resolutions.size() + deltas.size());
+    }
+};
+
+} // namespace
+
+static bool MakeMotionPrimitiveImage(
+    const std::vector<MotionPrimitive>& prims,
+    const std::vector<double>& resolutions,
+    MotionPrimitiveImage& image)
+{
+    auto& header = image.header;
+    std::memcpy(header.magic, MOTION_PRIMITIVE_FILE_MAGIC, sizeof(header.magic));
+    header.version = MOTION_PRIMITIVE_FILE_VERSION;
+    header.dof = resolutions.size();
+    header.primitive_count = 0;
+    header.waypoint_count = 0;
+
+    image.resolutions = resolutions;
+    for (auto& prim : prims) {
+        if (prim.type != MotionPrimitive::LONG_DISTANCE &&
+            prim.type != MotionPrimitive::SHORT_DISTANCE)
+        {
+            continue;
+        }
+
+        MotionPrimitiveRecord record;
+        record.type = prim.type;
+        record.waypoint_count = prim.action.size();
+        record.first_waypoint = header.waypoint_count;
+        record.cost = MotionPrimitiveCost(prim.action);
+        record.max_displacement = MotionPrimitiveMaxDisplacement(prim.action);
+
+        for (auto& waypoint : prim.action) {
+            if (waypoint.size() != header.dof) {
+                SMPL_ERROR("Motion primitive %zu has a waypoint with %zu variables (expected %u)", image.records.size(), waypoint.size(), header.dof);
+                return false;
+            }
+            image.deltas.insert(end(image.deltas), begin(waypoint), end(waypoint));
+            ++header.waypoint_count;
+        }
+
+        image.records.push_back(record);
+        ++header.primitive_count;
+    }
+
+    return true;
+}
+
+template <typename T>
+static bool WriteSection(std::FILE* f, const std::vector<T>& section)
+{
+    return section.empty() ||
+            std::fwrite(section.data(), sizeof(T), section.size(), f) == section.size();
+}
+
+template <typename T>
+static char* CopySection(char* dst, const std::vector<T>& section)
+{
+    if (!section.empty()) {
+        std::memcpy(dst, section.data(), sizeof(T) * section.size());
+    }
+    return dst + sizeof(T) * section.size();
+}
+
+bool WriteMotionPrimitiveFile(
+    const std::string& path,
+    const std::vector<MotionPrimitive>& prims,
+    const std::vector<double>& resolutions)
+{
+    MotionPrimitiveImage image;
+    if (!MakeMotionPrimitiveImage(prims, resolutions, image)) {
+        return false;
+    }
+
+    auto* f = std::fopen(path.c_str(), "wb");
+    if (!f) {
+        SMPL_ERROR("Failed to open '%s' for writing", path.c_str());
+        return false;
+    }
+
+    auto ok = std::fwrite(&image.header, sizeof(image.header), 1, f) == 1 &&
+            WriteSection(f, image.resolutions) &&
+            WriteSection(f, image.records) &&
+            WriteSection(f, image.deltas);
+    ok = (std::fclose(f) == 0) && ok;
+    if (!ok) {
+        SMPL_ERROR("Failed to write motion primitive file '%s'", path.c_str());
+    }
+    return ok;
+}
+
+bool PublishMotionPrimitives(
+    const std::string& name,
+    const std::vector<MotionPrimitive>& prims,
+    const std::vector<double>& resolutions)
+{
+    MotionPrimitiveImage image;
+    if (!MakeMotionPrimitiveImage(prims, resolutions, image)) {
+        return false;
+    }
+
+    // Replace, rather than resize, any previous object so that attached
+    // processes keep a consistent mapping of the old primitives.
+    ::shm_unlink(name.c_str());
+    int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        SMPL_ERROR("Failed to create shared motion primitives '%s'", name.c_str());
+        return false;
+    }
+
+    auto size = image.size();
+    void* data = MAP_FAILED;
+    if (::ftruncate(fd, size) == 0) {
+        data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        SMPL_ERROR("Failed to map shared motion primitives '%s'", name.c_str());
+        ::shm_unlink(name.c_str());
+        return false;
+    }
+
+    // Write the magic number last so that a process attaching mid-copy
+    // rejects the object.
+    auto* dst = static_cast<char*>(data);
+    auto header = image.header;
+    std::memset(header.magic, 0, sizeof(header.magic));
+    std::memcpy(dst, &header, sizeof(header));
+    dst += sizeof(header);
+    dst = CopySection(dst, image.resolutions);
+    dst = CopySection(dst, image.records);
+    dst = CopySection(dst, image.deltas);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(data, MOTION_PRIMITIVE_FILE_MAGIC, sizeof(header.magic));
+
+    ::munmap(data, size);
+    SMPL_INFO("Published motion primitives '%s' (%zu primitives, %zu bytes)", name.c_str(), image.records.size(), size);
+    return true;
+}
+
+bool UnpublishMotionPrimitives(const std::string& name)
+{
+    if (::shm_unlink(name.c_str()) != 0) {
+        SMPL_ERROR("Failed to remove shared motion primitives '%s'", name.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace smpl
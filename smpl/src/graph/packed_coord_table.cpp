@@ -0,0 +1,303 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+/// \author Andrew Dornbush
+
+#include <smpl/graph/packed_coord_table.h>
+
+// standard includes
+#include <assert.h>
+#include <algorithm>
+#include <limits>
+
+namespace smpl {
+
+static const std::size_t InitialSlotCount = 64;
+
+// rows of up to this many words are packed on the stack for lookups
+static const int MaxStackWords = 8;
+
+PackedCoordTable::PackedCoordTable() :
+    m_columns(),
+    m_word_count(0),
+    m_size(0),
+    m_min(),
+    m_max(),
+    m_words(),
+    m_slots(InitialSlotCount, Slot{ 0, -1 }),
+    m_indexed(0)
+{
+}
+
+void PackedCoordTable::setWidth(int width)
+{
+    assert(width >= 0);
+    m_min.assign(width, std::numeric_limits<int>::min());
+    m_max.assign(width, std::numeric_limits<int>::max());
+    clear();
+}
+
+void PackedCoordTable::setRanges(
+    const std::vector<int>& min,
+    const std::vector<int>& max)
+{
+    assert(min.size() == max.size());
+    m_min = min;
+    m_max = max;
+    clear();
+}
+
+int PackedCoordTable::find(const int* coord) const
+{
+    // a value outside the range of its column would have widened the column
+    // when the coordinate was inserted
+    if (!fits(coord)) {
+        return -1;
+    }
+
+    std::uint64_t stack_key[MaxStackWords];
+    std::vector<std::uint64_t> heap_key;
+    auto* key = stack_key;
+    if (m_word_count > MaxStackWords) {
+        heap_key.resize(m_word_count);
+        key = heap_key.data();
+    }
+    pack(coord, key);
+
+    auto h = hash(key);
+    auto mask = m_slots.size() - 1;
+    for (auto i = (std::size_t)h & mask; ; i = (i + 1) & mask) {
+        auto& slot = m_slots[i];
+        if (slot.id < 0) {
+            return -1;
+        }
+        if (slot.hash == h && equal(row(slot.id), key)) {
+            return slot.id;
+        }
+    }
+}
+
+int PackedCoordTable::insert(const int* coord)
+{
+    assert(find(coord) < 0);
+
+    if (!fits(coord)) {
+        widen(coord);
+    }
+
+    if (2 * (m_indexed + 1) > m_slots.size()) {
+        grow();
+    }
+
+    auto id = m_size++;
+    m_words.resize(m_words.size() + m_word_count, 0);
+    pack(coord, row(id));
+    place(hash(row(id)), id);
+    ++m_indexed;
+    return id;
+}
+
+int PackedCoordTable::reserve()
+{
+    auto id = m_size++;
+    m_words.resize(m_words.size() + m_word_count, 0);
+    std::vector<int> zero(width(), 0);
+    set(id, zero.data());
+    return id;
+}
+
+void PackedCoordTable::get(int id, int* coord) const
+{
+    assert(id >= 0 && id < m_size);
+    unpack(row(id), coord);
+}
+
+void PackedCoordTable::set(int id, const int* coord)
+{
+    assert(id >= 0 && id < m_size);
+    if (!fits(coord)) {
+        widen(coord);
+    }
+    pack(coord, row(id));
+}
+
+void PackedCoordTable::clear()
+{
+    m_columns.resize(m_min.size());
+    for (size_t i = 0; i < m_columns.size(); ++i) {
+        auto& column = m_columns[i];
+        column.min = m_min[i];
+        auto span = (std::uint64_t)((std::int64_t)m_max[i] - (std::int64_t)m_min[i]);
+        if (m_max[i] < m_min[i]) {
+            column.min = std::numeric_limits<int>::min();
+            span = std::numeric_limits<std::uint32_t>::max();
+        }
+        column.bits = 1;
+        while (column.bits < 32 && (span >> column.bits) != 0) {
+            ++column.bits;
+        }
+    }
+    layout();
+
+    m_size = 0;
+    m_words.clear();
+    std::fill(begin(m_slots), end(m_slots), Slot{ 0, -1 });
+    m_indexed = 0;
+}
+
+// Assign each column the word and offset it is stored at, packing columns in
+// order and starting a new word for a column that does not fit in the rest of
+// the current one.
+void PackedCoordTable::layout()
+{
+    auto word = 0;
+    auto shift = 0;
+    for (auto& column : m_columns) {
+        if (shift + column.bits > 64) {
+            ++word;
+            shift = 0;
+        }
+        column.word = word;
+        column.shift = shift;
+        shift += column.bits;
+    }
+    m_word_count = m_columns.empty() ? 0 : word + 1;
+}
+
+bool PackedCoordTable::fits(const int* coord) const
+{
+    for (size_t i = 0; i < m_columns.size(); ++i) {
+        auto& column = m_columns[i];
+        auto v = (std::int64_t)coord[i] - column.min;
+        if (v < 0 || (std::uint64_t)v >> column.bits != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void PackedCoordTable::pack(const int* coord, std::uint64_t* row) const
+{
+    std::fill(row, row + m_word_count, 0);
+    for (size_t i = 0; i < m_columns.size(); ++i) {
+        auto& column = m_columns[i];
+        auto v = (std::uint64_t)((std::int64_t)coord[i] - column.min);
+        row[column.word] |= v << column.shift;
+    }
+}
+
+void PackedCoordTable::unpack(const std::uint64_t* row, int* coord) const
+{
+    for (size_t i = 0; i < m_columns.size(); ++i) {
+        auto& column = m_columns[i];
+        auto mask = (std::uint64_t(1) << column.bits) - 1;
+        auto v = (row[column.word] >> column.shift) & mask;
+        coord[i] = (int)((std::int64_t)v + column.min);
+    }
+}
+
+// Widen the columns whose range does not cover a value of a coordinate to
+// 32 bits, repack every row, and rebuild the index.
+void PackedCoordTable::widen(const int* coord)
+{
+    std::vector<int> coords((std::size_t)m_size * width());
+    for (int id = 0; id < m_size; ++id) {
+        unpack(row(id), &coords[(std::size_t)id * width()]);
+    }
+
+    for (size_t i = 0; i < m_columns.size(); ++i) {
+        auto& column = m_columns[i];
+        auto v = (std::int64_t)coord[i] - column.min;
+        if (v < 0 || (std::uint64_t)v >> column.bits != 0) {
+            column.min = std::numeric_limits<int>::min();
+            column.bits = 32;
+        }
+    }
+    layout();
+
+    m_words.assign((std::size_t)m_size * m_word_count, 0);
+    for (int id = 0; id < m_size; ++id) {
+        pack(&coords[(std::size_t)id * width()], row(id));
+    }
+
+    std::vector<Slot> slots(m_slots.size(), Slot{ 0, -1 });
+    slots.swap(m_slots);
+    for (auto& slot : slots) {
+        if (slot.id >= 0) {
+            place(hash(row(slot.id)), slot.id);
+        }
+    }
+}
+
+auto PackedCoordTable::hash(const std::uint64_t* row) const -> std::uint32_t
+{
+    // FNV-1a over the packed words, followed by the 64-bit finalizer of
+    // MurmurHash3 so that the low bits used for slot selection depend on
+    // every word
+    std::uint64_t h = 14695981039346656037ull;
+    for (int i = 0; i < m_word_count; ++i) {
+        h ^= row[i];
+        h *= 1099511628211ull;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return (std::uint32_t)h;
+}
+
+bool PackedCoordTable::equal(const std::uint64_t* a, const std::uint64_t* b) const
+{
+    return std::equal(a, a + m_word_count, b);
+}
+
+void PackedCoordTable::place(std::uint32_t hash, int id)
+{
+    auto mask = m_slots.size() - 1;
+    auto i = (std::size_t)hash & mask;
+    while (m_slots[i].id >= 0) {
+        i = (i + 1) & mask;
+    }
+    m_slots[i] = Slot{ hash, id };
+}
+
+void PackedCoordTable::grow()
+{
+    std::vector<Slot> slots(2 * m_slots.size(), Slot{ 0, -1 });
+    slots.swap(m_slots);
+    for (auto& slot : slots) {
+        if (slot.id >= 0) {
+            place(slot.hash, slot.id);
+        }
+    }
+}
+
+} // namespace smpl
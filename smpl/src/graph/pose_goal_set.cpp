@@ -0,0 +1,148 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+
+#include <smpl/graph/pose_goal_set.h>
+
+// standard includes
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace smpl {
+
+/// Replace the set of goal poses and the tolerances they are tested with.
+void PoseGoalSet::assign(
+    const Affine3* poses,
+    std::size_t count,
+    const double xyz_tolerance[3],
+    const double rpy_tolerance[3])
+{
+    std::vector<std::size_t> order(count);
+    std::iota(begin(order), end(order), 0);
+    std::sort(begin(order), end(order), [&](std::size_t a, std::size_t b) {
+        return poses[a].translation().x() < poses[b].translation().x();
+    });
+
+    clear();
+    for (auto i : order) {
+        auto& pose = poses[i];
+        Quaternion q(pose.rotation());
+        m_x.push_back(pose.translation().x());
+        m_y.push_back(pose.translation().y());
+        m_z.push_back(pose.translation().z());
+        m_qw.push_back(q.w());
+        m_qx.push_back(q.x());
+        m_qy.push_back(q.y());
+        m_qz.push_back(q.z());
+        m_index.push_back((int)i);
+    }
+
+    std::copy(xyz_tolerance, xyz_tolerance + 3, m_xyz_tolerance);
+
+    // the angle between two orientations, 2 * acos(|q . qg|), lies in
+    // [0, pi] and is less than the tolerance exactly when |q . qg| exceeds
+    // cos(tolerance / 2)
+    auto tol = rpy_tolerance[0];
+    if (tol <= 0.0) {
+        m_min_abs_dot = 1.0;
+    } else if (tol > M_PI) {
+        m_min_abs_dot = -1.0;
+    } else {
+        m_min_abs_dot = std::cos(0.5 * tol);
+    }
+}
+
+void PoseGoalSet::clear()
+{
+    m_x.clear();
+    m_y.clear();
+    m_z.clear();
+    m_qw.clear();
+    m_qx.clear();
+    m_qy.clear();
+    m_qz.clear();
+    m_index.clear();
+}
+
+int PoseGoalSet::find(const Affine3& pose) const
+{
+    const double px = pose.translation().x();
+    const double py = pose.translation().y();
+    const double pz = pose.translation().z();
+    const double tx = m_xyz_tolerance[0];
+    const double ty = m_xyz_tolerance[1];
+    const double tz = m_xyz_tolerance[2];
+
+    // goals in the slab of x within tolerance, widened slightly so that
+    // rounding does not exclude a goal accepted by the exact test below
+    const double margin = 1e-9 * (1.0 + std::fabs(px) + tx);
+    auto first = std::lower_bound(begin(m_x), end(m_x), px - tx - margin) - begin(m_x);
+    auto last = std::upper_bound(begin(m_x), end(m_x), px + tx + margin) - begin(m_x);
+    if (first >= last) {
+        return -1;
+    }
+
+    Quaternion q(pose.rotation());
+
+    const std::ptrdiff_t BatchSize = 8;
+    for (auto b = first; b < last; b += BatchSize) {
+        auto n = std::min(BatchSize, last - b);
+
+        // position test for a batch of goals, without branches
+        bool near[BatchSize];
+        auto any = false;
+        for (std::ptrdiff_t i = 0; i < n; ++i) {
+            near[i] =
+                    (std::fabs(m_x[b + i] - px) <= tx) &
+                    (std::fabs(m_y[b + i] - py) <= ty) &
+                    (std::fabs(m_z[b + i] - pz) <= tz);
+            any |= near[i];
+        }
+        if (!any) {
+            continue;
+        }
+
+        for (std::ptrdiff_t i = 0; i < n; ++i) {
+            if (!near[i]) {
+                continue;
+            }
+            auto dot =
+                    q.w() * m_qw[b + i] + q.x() * m_qx[b + i] +
+                    q.y() * m_qy[b + i] + q.z() * m_qz[b + i];
+            if (std::fabs(dot) > m_min_abs_dot) {
+                return m_index[b + i];
+            }
+        }
+    }
+
+    return -1;
+}
+
+} // namespace smpl
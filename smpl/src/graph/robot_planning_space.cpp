@@ -80,6 +80,10 @@ bool RobotPlanningSpace::hasHeuristic(const RobotHeuristic* h)
     return hit != m_heuristics.end();
 }
 
+void RobotPlanningSpace::clearStates()
+{
+}
+
 bool RobotPlanningSpace::setStart(const RobotState& start)
 {
     m_start = start;
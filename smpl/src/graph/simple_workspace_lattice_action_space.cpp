@@ -77,13 +77,14 @@ bool InitSimpleWorkspaceLatticeActions(
 }
 
 void SimpleWorkspaceLatticeActionSpace::apply(
-    const WorkspaceLatticeState& state,
+    const WorkspaceCoord& coord,
+    const RobotState& state,
     std::vector<WorkspaceAction>& actions)
 {
     actions.reserve(actions.size() + m_prims.size());
 
     WorkspaceState cont_state;
-    space->stateCoordToWorkspace(state.coord, cont_state);
+    space->stateCoordToWorkspace(coord, cont_state);
 
     SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "  create actions for workspace state: " << cont_state);
 
@@ -112,7 +113,7 @@ void SimpleWorkspaceLatticeActionSpace::apply(
                 cont_state[FK_PX], cont_state[FK_PY], cont_state[FK_PZ]);
         if (goal_dist < m_ik_amp_thresh) {
             RobotState ik_sol;
-            if (space->m_ik_iface->computeIK(space->goal().pose, state.state, ik_sol)) {
+            if (space->computeGoalIK(space->goal().pose, state, ik_sol)) {
                 WorkspaceState final_state;
                 space->stateRobotToWorkspace(ik_sol, final_state);
                 WorkspaceAction action(1);
@@ -32,6 +32,9 @@
 
 #include <smpl/graph/workspace_lattice.h>
 
+// standard includes
+#include <algorithm>
+
 // system includes
 #include <boost/functional/hash.hpp>
 
@@ -42,24 +45,12 @@
 #include <smpl/debug/visualize.h>
 #include <smpl/debug/marker_utils.h>
 #include <smpl/heuristic/robot_heuristic.h>
+#include <smpl/stl/memory.h>
+#include <smpl/telemetry.h>
 #include <smpl/graph/workspace_lattice_action_space.h>
 
-auto std::hash<smpl::WorkspaceLatticeState>::operator()(
-    const argument_type& s) const -> result_type
-{
-    size_t seed = 0;
-    boost::hash_combine(seed, boost::hash_range(s.coord.begin(), s.coord.end()));
-    return seed;
-}
-
 namespace smpl {
 
-std::ostream& operator<<(std::ostream& o, const WorkspaceLatticeState& s)
-{
-    o << "{ coord: " << s.coord << ", state: " << s.state << " }";
-    return o;
-}
-
 template <
     class InputIt,
     class Equal = std::equal_to<typename std::iterator_traits<InputIt>::value_type>>
@@ -73,8 +64,9 @@ bool all_equal(InputIt first, InputIt last, typename std::iterator_traits<InputI
 
 WorkspaceLattice::~WorkspaceLattice()
 {
+    // states are freed along with m_state_arena
     for (size_t i = 0; i < m_states.size(); i++) {
-        delete m_states[i];
+        m_states[i]->~WorkspaceLatticeState();
         m_states[i] = nullptr;
     }
     m_states.clear();
@@ -92,6 +84,81 @@ const std::string& WorkspaceLattice::visualizationFrameId() const
     return m_viz_frame_id;
 }
 
+void WorkspaceLattice::useIkCache(bool enable)
+{
+    m_use_ik_cache = enable;
+    clearIkCache();
+}
+
+void WorkspaceLattice::clearIkCache()
+{
+    if (!m_ik_cache.empty()) {
+        SMPL_DEBUG_NAMED(G_LOG, "IK cache: %zu entries, %zu hits, %zu misses", m_ik_cache.size(), m_ik_cache_hits, m_ik_cache_misses);
+    }
+    m_ik_cache.clear();
+    m_ik_cache_hits = 0;
+    m_ik_cache_misses = 0;
+}
+
+bool WorkspaceLattice::setIkSampling(int seed_count, int thread_count)
+{
+    if (seed_count <= 1) {
+        m_ik_sampler.reset();
+        return true;
+    }
+
+    if (!initialized()) {
+        SMPL_ERROR_NAMED(G_LOG, "IK sampling requires an initialized Workspace Lattice");
+        return false;
+    }
+
+    auto sampler = make_unique<IKSampler>();
+    if (!sampler->init(robot(), collisionChecker(), thread_count)) {
+        SMPL_ERROR_NAMED(G_LOG, "Failed to initialize IK sampler");
+        return false;
+    }
+    sampler->setSeedCount(seed_count);
+    sampler->setReachabilityMap(m_reachability_map);
+
+    m_ik_sampler = std::move(sampler);
+    return true;
+}
+
+int WorkspaceLattice::ikSamplingSeeds() const
+{
+    return m_ik_sampler ? m_ik_sampler->seedCount() : 1;
+}
+
+void WorkspaceLattice::setReachabilityMap(const ReachabilityMap* map)
+{
+    if (map != nullptr && map->dof() != robot()->jointVariableCount()) {
+        SMPL_WARN_NAMED(G_LOG, "Reachability map has %zu variables (expected %zu)", map->dof(), robot()->jointVariableCount());
+        map = nullptr;
+    }
+    m_reachability_map = map;
+    if (m_ik_sampler) {
+        m_ik_sampler->setReachabilityMap(map);
+    }
+}
+
+bool WorkspaceLattice::computeGoalIK(
+    const Affine3& pose,
+    const RobotState& seed,
+    RobotState& solution)
+{
+    if (m_ik_sampler) {
+        return m_ik_sampler->solve(pose, seed, solution);
+    }
+    if (m_ik_iface->computeIK(pose, seed, solution)) {
+        return true;
+    }
+
+    RobotState map_seed;
+    return m_reachability_map != nullptr &&
+            m_reachability_map->seed(pose, map_seed) &&
+            m_ik_iface->computeIK(pose, map_seed, solution);
+}
+
 bool WorkspaceLattice::init(
     RobotModel* _robot,
     CollisionChecker* checker,
@@ -102,10 +169,12 @@ bool WorkspaceLattice::init(
         return false;
     }
 
-    // this should serve as a reasonable dummy state since no valid state should
-    // have an empty coordinate vector
-    WorkspaceCoord fake_coord;
-    m_goal_state_id = createState(fake_coord);
+    m_coord_table.setWidth(m_dof_count);
+    m_parent_coord.resize(m_dof_count);
+    m_succ_coord.resize(m_dof_count);
+
+    // the goal state is reserved so that it is never found by coordinate
+    m_goal_state_id = reserveHashEntry();
     m_goal_entry = getState(m_goal_state_id);
     SMPL_DEBUG_NAMED(G_LOG, "  goal state has id %d", m_goal_state_id);
 
@@ -122,10 +191,8 @@ bool WorkspaceLattice::projectToPose(int state_id, Affine3& pose)
         return true;
     }
 
-    WorkspaceLatticeState* state = getState(state_id);
-
     double p[6];
-    poseCoordToWorkspace(&state->coord[0], &p[0]);
+    poseCoordToWorkspace(getStateCoord(state_id), &p[0]);
 
     pose = Translation3(p[FK_PX], p[FK_PY], p[FK_PZ]) *
             AngleAxis(p[FK_QZ], Vector3::UnitZ()) *
@@ -154,6 +221,9 @@ bool WorkspaceLattice::setStart(const RobotState& state)
         return false;
     }
 
+    // cached solutions were seeded from the previous start
+    clearIkCache();
+
     if (!collisionChecker()->isStateValid(state, true)) {
         auto* vis_name = "invalid_start";
         SV_SHOW_WARN_NAMED(vis_name, collisionChecker()->getCollisionModelVisualization(state));
@@ -196,8 +266,10 @@ int WorkspaceLattice::getStartStateID() const
 {
     if (m_start_state_id >= 0 && m_goal_state_id >= 0) {
         WorkspaceLatticeState* start_state = getState(m_start_state_id);
+        WorkspaceCoord start_coord;
+        getStateCoord(m_start_state_id, start_coord);
         WorkspaceState cont_state;
-        stateCoordToWorkspace(start_state->coord, cont_state);
+        stateCoordToWorkspace(start_coord, cont_state);
         if (isGoal(cont_state, start_state->state)) {
             return m_goal_state_id;
         }
@@ -260,8 +332,10 @@ bool WorkspaceLattice::extractPath(
         if (curr_id == getGoalStateID()) {
             // TODO: variant of get succs that returns unique state ids
             auto* prev_entry = getState(prev_id);
+            WorkspaceCoord prev_coord;
+            getStateCoord(prev_id, prev_coord);
             std::vector<WorkspaceAction> actions;
-            m_actions->apply(*prev_entry, actions);
+            m_actions->apply(prev_coord, prev_entry->state, actions);
 
             WorkspaceLatticeState* best_goal_entry = NULL;
             auto best_cost = std::numeric_limits<int>::max();
@@ -348,16 +422,18 @@ void WorkspaceLattice::GetSuccs(
     auto* parent_entry = getState(state_id);
 
     assert(parent_entry);
-    assert(parent_entry->coord.size() == m_dof_count);
 
-    SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "  workspace coord: " << parent_entry->coord);
+    auto& parent_coord = m_parent_coord;
+    getStateCoord(state_id, parent_coord);
+
+    SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "  workspace coord: " << parent_coord);
     SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "      robot state: " << parent_entry->state);
 
     auto* vis_name = "expansion";
     SV_SHOW_DEBUG_NAMED(vis_name, getStateVisualization(parent_entry->state, vis_name));
 
     std::vector<WorkspaceAction> actions;
-    m_actions->apply(*parent_entry, actions);
+    m_actions->apply(parent_coord, parent_entry->state, actions);
 
     SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "  actions: %zu", actions.size());
 
@@ -374,7 +450,7 @@ void WorkspaceLattice::GetSuccs(
         }
 
         auto& final_state = action.back();
-        WorkspaceCoord succ_coord;
+        auto& succ_coord = m_succ_coord;
         stateWorkspaceToCoord(final_state, succ_coord);
 
         // check if hash entry already exists, if not then create one
@@ -396,7 +472,7 @@ void WorkspaceLattice::GetSuccs(
         costs->push_back(edge_cost);
 
         SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "      succ: %d", succ_id);
-        SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "        coord: " << succ_state->coord);
+        SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "        coord: " << succ_coord);
         SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "        state: " << succ_state->state);
         SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "        cost: %5d", edge_cost);
     }
@@ -417,9 +493,11 @@ void WorkspaceLattice::PrintState(int state_id, bool verbose, FILE* fout)
     }
 
     WorkspaceLatticeState* state = getState(state_id);
+    WorkspaceCoord coord;
+    getStateCoord(state_id, coord);
 
     std::stringstream ss;
-    ss << *state;
+    ss << "{ coord: " << coord << ", state: " << state->state << " }";
 
     if (fout == stdout) {
         SMPL_DEBUG_NAMED(G_LOG, "%s", ss.str().c_str());
@@ -451,32 +529,37 @@ void WorkspaceLattice::GetLazySuccs(
     WorkspaceLatticeState* state_entry = getState(state_id);
 
     assert(state_entry);
-    assert(state_entry->coord.size() == m_dof_count);
 
-    SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "  coord: " << state_entry->coord);
+    auto& parent_coord = m_parent_coord;
+    getStateCoord(state_id, parent_coord);
+
+    SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "  coord: " << parent_coord);
     SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "  state: " << state_entry->state);
 
     auto* vis_name = "expansion";
     SV_SHOW_DEBUG_NAMED(vis_name, getStateVisualization(state_entry->state, vis_name));
 
     std::vector<WorkspaceAction> actions;
-    m_actions->apply(*state_entry, actions);
+    m_actions->apply(parent_coord, state_entry->state, actions);
 
     SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "  actions: %zu", actions.size());
 
+    auto& final_rstates = m_lazy_final_rstates;
+    checkLazyActions(state_entry->state, actions, final_rstates);
+
     for (size_t i = 0; i < actions.size(); ++i) {
         auto& action = actions[i];
 
         SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "    action %zu", i);
         SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "      waypoints: %zu", action.size());
 
-        RobotState final_rstate;
-        if (!checkLazyAction(state_entry->state, action, &final_rstate)) {
+        auto& final_rstate = final_rstates[i];
+        if (final_rstate.empty()) {
             continue;
         }
 
         auto& final_state = action.back();
-        WorkspaceCoord succ_coord;
+        auto& succ_coord = m_succ_coord;
         stateWorkspaceToCoord(final_state, succ_coord);
 
         // check if hash entry already exists, if not then create one
@@ -500,7 +583,7 @@ void WorkspaceLattice::GetLazySuccs(
         true_costs->push_back(false);
 
         SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "      succ: %d", succ_id);
-        SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "        coord: " << succ_state->coord);
+        SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "        coord: " << succ_coord);
         SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "        state: " << succ_state->state);
         SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "        cost: %5d", edge_cost);
     }
@@ -515,39 +598,49 @@ int WorkspaceLattice::GetTrueCost(int parent_id, int child_id)
 
     WorkspaceLatticeState* parent_entry = getState(parent_id);
     WorkspaceLatticeState* child_entry = getState(child_id);
-    assert(parent_entry && parent_entry->coord.size() == m_dof_count);
-    assert(child_entry && child_entry->coord.size() == m_dof_count);
+    assert(parent_entry);
+    assert(child_entry);
+
+    auto& parent_coord = m_parent_coord;
+    getStateCoord(parent_id, parent_coord);
 
     std::vector<WorkspaceAction> actions;
-    m_actions->apply(*parent_entry, actions);
+    m_actions->apply(parent_coord, parent_entry->state, actions);
 
     auto goal_edge = (child_id == m_goal_state_id);
 
-    WorkspaceCoord succ_coord;
+    auto& succ_coord = m_succ_coord;
     auto best_cost = std::numeric_limits<int>::max();
     for (size_t aidx = 0; aidx < actions.size(); ++aidx) {
         auto& action = actions[aidx];
 
+        // skip actions which don't end up at the child state before doing any
+        // ik or collision checking
+        stateWorkspaceToCoord(action.back(), succ_coord);
+        if (!goal_edge && !stateHasCoord(child_id, succ_coord)) {
+            continue;
+        }
+
         RobotState final_rstate;
         if (!checkAction(parent_entry->state, action, &final_rstate)) {
             continue;
         }
 
-        stateWorkspaceToCoord(action.back(), succ_coord);
+        if (goal_edge && !isGoal(action.back(), final_rstate)) {
+            continue;
+        }
 
+        auto* succ_entry = child_entry;
         if (goal_edge) {
-            if (!isGoal(action.back(), final_rstate)) {
-                continue;
-            }
-        } else {
-            if (succ_coord != child_entry->coord) {
-                continue;
-            }
+            succ_entry = getState(createState(succ_coord));
         }
 
-        auto edge_cost = /* TODO: compute cost */ 30;
+        auto edge_cost = computeCost(*parent_entry, *succ_entry);
         if (edge_cost < best_cost) {
             best_cost = edge_cost;
+            // the lazily-computed state for the child is replaced with the
+            // one from the validated action
+            succ_entry->state = final_rstate;
         }
     }
 
@@ -574,7 +667,7 @@ bool WorkspaceLattice::setGoalPose(const GoalConstraint& goal)
     // the search we plan even if there is no solution
     RobotState seed(robot()->jointVariableCount(), 0);
     RobotState ik_solution;
-    if (!m_ik_iface->computeIK(goal.pose, seed, ik_solution)) {
+    if (!computeGoalIK(goal.pose, seed, ik_solution)) {
         SMPL_WARN("No valid IK solution for the goal pose.");
     }
 
@@ -606,16 +699,45 @@ bool WorkspaceLattice::setUserGoal(const GoalConstraint& goal)
     return RobotPlanningSpace::setGoal(goal);
 }
 
+void WorkspaceLattice::clearStates()
+{
+    for (auto* state : m_states) {
+        state->~WorkspaceLatticeState();
+    }
+    m_states.clear();
+    m_coord_table.clear();
+    m_state_arena.reset();
+
+    m_start_entry = NULL;
+    m_start_state_id = -1;
+
+    m_goal_state_id = reserveHashEntry();
+    m_goal_entry = getState(m_goal_state_id);
+
+    clearIkCache();
+}
+
+/// Create a state that is not indexed by its coordinate and hence will never
+/// be returned by createState(const WorkspaceCoord&).
 int WorkspaceLattice::reserveHashEntry()
 {
-    auto* state = new WorkspaceLatticeState;
-    int state_id = (int)this->m_states.size();
-    m_states.push_back(state);
+    int state_id = m_coord_table.reserve();
+    addHashEntry(state_id);
+    return state_id;
+}
 
-    int* pinds = new int[NUMOFINDICES_STATEID2IND];
-    std::fill(pinds, pinds + NUMOFINDICES_STATEID2IND, -1);
-    StateID2IndexMapping.push_back(pinds);
+/// Create a state that is not indexed by its coordinate, but is assigned the
+/// given coordinate and robot state.
+int WorkspaceLattice::reserveHashEntry(
+    const WorkspaceCoord& coord,
+    const RobotState& state)
+{
+    assert((int)coord.size() == m_coord_table.width());
 
+    int state_id = m_coord_table.reserve();
+    std::copy(begin(coord), end(coord), m_coord_table.coord(state_id));
+    addHashEntry(state_id);
+    getState(state_id)->state = state;
     return state_id;
 }
 
@@ -625,27 +747,37 @@ int WorkspaceLattice::reserveHashEntry()
 /// entry is returned; otherwise, a new entry is created and its id returned.
 int WorkspaceLattice::createState(const WorkspaceCoord& coord)
 {
-    WorkspaceLatticeState state;
-    state.coord = coord;
-    auto sit = m_state_to_id.find(&state);
-    if (sit != m_state_to_id.end()) {
-        return sit->second;
-    }
+    assert((int)coord.size() == m_coord_table.width());
 
-    int new_id = (int)m_states.size();
+    int state_id = m_coord_table.find(coord.data());
+    if (state_id >= 0) {
+        return state_id;
+    }
 
-    // create a new entry
-    auto* state_entry = new WorkspaceLatticeState(state);
+    // map coord <-> state id
+    state_id = m_coord_table.insert(coord.data());
+    addHashEntry(state_id);
+    return state_id;
+}
 
-    // map id <-> state
-    m_states.push_back(state_entry);
-    m_state_to_id[state_entry] = new_id;
+void WorkspaceLattice::addHashEntry(int state_id)
+{
+    assert(state_id == (int)m_states.size());
 
-    int* indices = new int[NUMOFINDICES_STATEID2IND];
-    std::fill(indices, indices + NUMOFINDICES_STATEID2IND, -1);
-    StateID2IndexMapping.push_back(indices);
+    // map state id -> state
+    auto* entry = m_state_arena.construct<WorkspaceLatticeState>();
+    m_states.push_back(entry);
 
-    return new_id;
+    // map planner state -> graph state, reusing the mapping left behind by a
+    // cleared state, if any
+    if (state_id < (int)StateID2IndexMapping.size()) {
+        int* pinds = StateID2IndexMapping[state_id];
+        std::fill(pinds, pinds + NUMOFINDICES_STATEID2IND, -1);
+    } else {
+        int* pinds = new int[NUMOFINDICES_STATEID2IND];
+        std::fill(pinds, pinds + NUMOFINDICES_STATEID2IND, -1);
+        StateID2IndexMapping.push_back(pinds);
+    }
 }
 
 /// Retrieve a state by its id.
@@ -659,6 +791,30 @@ WorkspaceLatticeState* WorkspaceLattice::getState(int state_id) const
     return m_states[state_id];
 }
 
+/// Return the discrete coordinate of a state, dofCount() integers stored
+/// inline in the coordinate table. The pointer is invalidated when a state is
+/// created.
+auto WorkspaceLattice::getStateCoord(int state_id) const -> const int*
+{
+    assert(state_id >= 0 && state_id < m_coord_table.size());
+    return m_coord_table.coord(state_id);
+}
+
+/// Copy the discrete coordinate of a state.
+void WorkspaceLattice::getStateCoord(int state_id, WorkspaceCoord& coord) const
+{
+    auto* c = getStateCoord(state_id);
+    coord.assign(c, c + m_coord_table.width());
+}
+
+bool WorkspaceLattice::stateHasCoord(
+    int state_id,
+    const WorkspaceCoord& coord) const
+{
+    assert((int)coord.size() == m_coord_table.width());
+    return std::equal(begin(coord), end(coord), getStateCoord(state_id));
+}
+
 bool WorkspaceLattice::isGoal(
     const WorkspaceState& state,
     const RobotState& robot_state) const
@@ -730,6 +886,41 @@ auto WorkspaceLattice::getStateVisualization(
     return markers;
 }
 
+auto WorkspaceLattice::IkCacheKeyHash::operator()(
+    const argument_type& s) const -> result_type
+{
+    return boost::hash_range(s.begin(), s.end());
+}
+
+/// Solve for the robot state at a waypoint, consulting the IK cache first if
+/// it is enabled. Returns false if no solution exists.
+bool WorkspaceLattice::solveWaypoint(
+    const WorkspaceState& waypoint,
+    const RobotState& seed,
+    RobotState& ostate)
+{
+    if (!m_use_ik_cache) {
+        return stateWorkspaceToRobot(waypoint, seed, ostate);
+    }
+
+    stateWorkspaceToCoord(waypoint, m_ik_cache_key);
+    auto it = m_ik_cache.find(m_ik_cache_key);
+    if (it != m_ik_cache.end()) {
+        ++m_ik_cache_hits;
+        TelemetryCount(TelemetryEvent::IkCacheHit);
+        ostate = it->second;
+        return !ostate.empty();
+    }
+
+    ++m_ik_cache_misses;
+    TelemetryCount(TelemetryEvent::IkCacheMiss);
+    if (!stateWorkspaceToRobot(waypoint, seed, ostate)) {
+        ostate.clear();
+    }
+    m_ik_cache[m_ik_cache_key] = ostate;
+    return !ostate.empty();
+}
+
 bool WorkspaceLattice::checkAction(
     const RobotState& state,
     const WorkspaceAction& action,
@@ -751,7 +942,7 @@ bool WorkspaceLattice::checkAction(
         }
 
         RobotState irstate;
-        if (!stateWorkspaceToRobot(waypoint, seed, irstate)) {
+        if (!solveWaypoint(waypoint, seed, irstate)) {
             SMPL_DEBUG_NAMED(G_SUCCESSORS_LOG, "         -> failed to find ik solution");
             return false;
         }
@@ -795,41 +986,92 @@ int WorkspaceLattice::computeCost(
     return 30;
 }
 
-bool WorkspaceLattice::checkLazyAction(
+/// Compute the robot state at the end of each action without validating the
+/// intermediate waypoints or checking for collisions. Only the final waypoint
+/// is solved for, since its robot state is required to store the successor and
+/// to test it against joint-space goals. The remaining checks are deferred to
+/// checkAction, called from GetTrueCost. The final waypoints of all actions
+/// are solved as one batch; the robot state of an invalid action is left
+/// empty.
+void WorkspaceLattice::checkLazyActions(
     const RobotState& state,
-    const WorkspaceAction& action,
-    RobotState* final_rstate)
+    const std::vector<WorkspaceAction>& actions,
+    std::vector<RobotState>& final_rstates)
 {
-    std::vector<RobotState> wptraj;
-    wptraj.reserve(action.size());
+    auto& final_states = m_lazy_final_states;
+    auto& seeds = m_lazy_seeds;
+    final_states.resize(actions.size());
+    seeds.resize(actions.size());
+    final_rstates.resize(actions.size());
 
-    // check waypoints for ik solutions and joint limits
-    for (size_t widx = 0; widx < action.size(); ++widx) {
-        auto& istate = action[widx];
+    for (size_t i = 0; i < actions.size(); ++i) {
+        assert(!actions[i].empty());
+        final_states[i] = actions[i].back();
 
-        SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "        " << widx << ": " << istate);
+        SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "        " << i << ": " << final_states[i]);
 
-        RobotState irstate;
-        if (!stateWorkspaceToRobot(istate, state, irstate)) {
-            SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "         -> failed to find ik solution");
-            return false;
+        // seed with the same free angles used by checkAction so that lazy and
+        // true evaluation agree on the final robot state
+        seeds[i] = state;
+        for (int j = 0; j < this->freeAngleCount(); ++j) {
+            seeds[i][this->m_fangle_indices[j]] = final_states[i][6 + j];
         }
+    }
 
-        wptraj.push_back(irstate);
+    if (!m_use_ik_cache) {
+        stateWorkspaceToRobotBatch(
+                final_states.data(),
+                seeds.data(),
+                (int)actions.size(),
+                final_rstates.data());
+    } else {
+        // take cached solutions and move the remaining waypoints to the front
+        // so that only the misses are solved, still as one batch
+        auto& misses = m_lazy_ik_misses;
+        misses.clear();
+        for (size_t i = 0; i < actions.size(); ++i) {
+            stateWorkspaceToCoord(final_states[i], m_ik_cache_key);
+            auto it = m_ik_cache.find(m_ik_cache_key);
+            if (it != m_ik_cache.end()) {
+                ++m_ik_cache_hits;
+                TelemetryCount(TelemetryEvent::IkCacheHit);
+                final_rstates[i] = it->second;
+            } else {
+                ++m_ik_cache_misses;
+                TelemetryCount(TelemetryEvent::IkCacheMiss);
+                std::swap(final_states[misses.size()], final_states[i]);
+                std::swap(seeds[misses.size()], seeds[i]);
+                misses.push_back(i);
+            }
+        }
 
-        if (!robot()->checkJointLimits(irstate)) {
-            SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "        -> violates joint limits");
-            return false;
+        auto& miss_rstates = m_lazy_ik_miss_rstates;
+        miss_rstates.resize(misses.size());
+        stateWorkspaceToRobotBatch(
+                final_states.data(),
+                seeds.data(),
+                (int)misses.size(),
+                miss_rstates.data());
+
+        for (size_t k = 0; k < misses.size(); ++k) {
+            stateWorkspaceToCoord(final_states[k], m_ik_cache_key);
+            m_ik_cache[m_ik_cache_key] = miss_rstates[k];
+            final_rstates[misses[k]] = std::move(miss_rstates[k]);
         }
     }
 
-    // check for collisions between the waypoints
-    assert(wptraj.size() == action.size());
+    for (size_t i = 0; i < actions.size(); ++i) {
+        auto& frstate = final_rstates[i];
+        if (frstate.empty()) {
+            SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "         -> action %zu failed to find ik solution", i);
+            continue;
+        }
 
-    if (final_rstate) {
-        *final_rstate = wptraj.back();
+        if (!robot()->checkJointLimits(frstate)) {
+            SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "        -> action %zu violates joint limits", i);
+            frstate.clear();
+        }
     }
-    return true;
 }
 
 } // namespace smpl
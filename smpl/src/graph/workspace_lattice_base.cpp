@@ -234,6 +234,25 @@ bool WorkspaceLatticeBase::stateWorkspaceToRobot(
     return m_rm_iface->computeFastIK(pose, seed, ostate);
 }
 
+int WorkspaceLatticeBase::stateWorkspaceToRobotBatch(
+    const WorkspaceState* states,
+    const RobotState* seeds,
+    int n,
+    RobotState* ostates) const
+{
+    std::vector<Affine3, Eigen::aligned_allocator<Affine3>> poses(n);
+    for (int i = 0; i < n; ++i) {
+        auto& state = states[i];
+        poses[i] =
+                Translation3(state[0], state[1], state[2]) *
+                AngleAxis(state[5], Vector3::UnitZ()) *
+                AngleAxis(state[4], Vector3::UnitY()) *
+                AngleAxis(state[3], Vector3::UnitX());
+    }
+
+    return m_rm_iface->computeFastIKBatch(poses.data(), seeds, n, ostates);
+}
+
 void WorkspaceLatticeBase::posWorkspaceToCoord(const double* wp, int* gp) const
 {
     if (wp[0] >= 0.0) {
@@ -1,6 +1,7 @@
 #include <smpl/graph/workspace_lattice_egraph.h>
 
 // standard includes
+#include <algorithm>
 #include <fstream>
 
 // system includes
@@ -12,8 +13,11 @@
 #include <smpl/console/console.h>
 #include <smpl/console/nonstd.h>
 #include <smpl/debug/visualize.h>
+#include <smpl/graph/experience_graph_file.h>
 #include <smpl/graph/workspace_lattice_action_space.h>
 #include <smpl/heap/intrusive_heap.h>
+#include <smpl/heuristic/egraph_heuristic.h>
+#include <smpl/heuristic/robot_heuristic.h>
 
 namespace smpl {
 
@@ -22,17 +26,11 @@ bool ParseExperienceGraphFile(
     RobotModel* robot_model,
     std::vector<RobotState>& egraph_states)
 {
-    std::ifstream fin(filepath);
-    if (!fin.is_open()) {
-        SMPL_WARN("Failed to open file '%s' for writing", filepath.c_str());
-        return false;
-    }
-
     SMPL_DEBUG_NAMED(G_LOG, "Parse experience graph at '%s'", filepath.c_str());
 
     CSVParser parser;
     auto with_header = true;
-    if (!parser.parseStream(fin, with_header)) {
+    if (!parser.parseNumericFile(filepath, with_header)) {
         SMPL_WARN("Failed to parse experience graph file '%s'", filepath.c_str());
         return false;
     }
@@ -51,21 +49,11 @@ bool ParseExperienceGraphFile(
         SMPL_WARN("Parsed experience graph contains superflous many joint variables (%zu > %zu)", parser.fieldCount(), jvar_count);
     }
 
-    egraph_states.reserve(parser.totalFieldCount());
+    // superfluous trailing variables are ignored
+    egraph_states.reserve(parser.recordCount());
     for (size_t i = 0; i < parser.recordCount(); ++i) {
-        RobotState state(jvar_count);
-        for (size_t j = 0; j < parser.fieldCount(); ++j) {
-            try {
-                state[j] = std::stod(parser.fieldAt(i, j));
-            } catch (const std::invalid_argument& ex) {
-                SMPL_ERROR("Failed to parse egraph state variable (%s)", ex.what());
-                return false;
-            } catch (const std::out_of_range& ex) {
-                SMPL_ERROR("Failed to parse egraph state variable (%s)", ex.what());
-                return false;
-            }
-        }
-        egraph_states.push_back(std::move(state));
+        auto* record = parser.record(i);
+        egraph_states.emplace_back(record, record + jvar_count);
     }
 
     SMPL_DEBUG_NAMED(G_LOG, "Read %zu states from experience graph file", egraph_states.size());
@@ -144,11 +132,12 @@ void WorkspaceLatticeEGraph::getEGraphStateSuccs(
 
 void WorkspaceLatticeEGraph::getOrigStateBridgeSuccs(
     WorkspaceLatticeState* state,
+    const WorkspaceCoord& coord,
     std::vector<int>* succs,
     std::vector<int>* costs)
 {
     // E_bridge from V_orig
-    auto it = m_coord_to_egraph_nodes.find(state->coord);
+    auto it = m_coord_to_egraph_nodes.find(coord);
     if (it != end(m_coord_to_egraph_nodes)) {
         SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "  bridge to %zu e-graph nodes", it->second.size());
         for (auto node : it->second) {
@@ -164,11 +153,12 @@ void WorkspaceLatticeEGraph::getOrigStateBridgeSuccs(
 
 void WorkspaceLatticeEGraph::getOrigStateOrigSuccs(
     WorkspaceLatticeState* state,
+    const WorkspaceCoord& coord,
     std::vector<int>* succs,
     std::vector<int>* costs)
 {
     std::vector<smpl::WorkspaceAction> actions;
-    m_actions->apply(*state, actions);
+    m_actions->apply(coord, state->state, actions);
 
     SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "  actions: %zu", actions.size());
 
@@ -185,7 +175,7 @@ void WorkspaceLatticeEGraph::getOrigStateOrigSuccs(
         }
 
         auto& final_workspace_state = action.back();
-        smpl::WorkspaceCoord succ_coord;
+        auto& succ_coord = m_succ_coord;
         stateWorkspaceToCoord(final_workspace_state, succ_coord);
 
         // check if hash entry already exists, if not then create one
@@ -200,7 +190,7 @@ void WorkspaceLatticeEGraph::getOrigStateOrigSuccs(
         costs->push_back(edge_cost);
 
         SMPL_DEBUG_NAMED(G_SUCCESSORS_LOG,        "      succ: %d", succ_id);
-        SMPL_DEBUG_STREAM_NAMED(G_SUCCESSORS_LOG, "        coord: " << succ_state->coord);
+        SMPL_DEBUG_STREAM_NAMED(G_SUCCESSORS_LOG, "        coord: " << succ_coord);
         SMPL_DEBUG_STREAM_NAMED(G_SUCCESSORS_LOG, "        state: " << succ_state->state);
         SMPL_DEBUG_NAMED(G_SUCCESSORS_LOG,        "        cost: %5d", edge_cost);
     }
@@ -208,11 +198,12 @@ void WorkspaceLatticeEGraph::getOrigStateOrigSuccs(
 
 void WorkspaceLatticeEGraph::getOrigStateSuccs(
     smpl::WorkspaceLatticeState* state,
+    const WorkspaceCoord& coord,
     std::vector<int>* succs,
     std::vector<int>* costs)
 {
-    getOrigStateBridgeSuccs(state, succs, costs);
-    getOrigStateOrigSuccs(state, succs, costs);
+    getOrigStateBridgeSuccs(state, coord, succs, costs);
+    getOrigStateOrigSuccs(state, coord, succs, costs);
 }
 
 void WorkspaceLatticeEGraph::getUniqueSuccs(
@@ -224,7 +215,10 @@ void WorkspaceLatticeEGraph::getUniqueSuccs(
 
     auto* parent_entry = getState(state_id);
 
-    SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "  workspace coord: " << parent_entry->coord);
+    auto& parent_coord = m_parent_coord;
+    getStateCoord(state_id, parent_coord);
+
+    SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "  workspace coord: " << parent_coord);
     SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "      robot state: " << parent_entry->state);
 
     auto* vis_name = "expansion";
@@ -245,44 +239,44 @@ void WorkspaceLatticeEGraph::getUniqueSuccs(
     if (is_egraph_node) { // expanding an egraph node
         return getEGraphStateSuccs(parent_entry, egraph_node, succs, costs);
     } else {
-        return getOrigStateSuccs(parent_entry, succs, costs);
+        return getOrigStateSuccs(parent_entry, parent_coord, succs, costs);
     }
 }
 
 void WorkspaceLatticeEGraph::clearExperienceGraph()
 {
-    // delete all reserved states corresponding to e-graph states
+    // destroy all reserved states corresponding to e-graph states. their
+    // memory is owned by the lattice's state arena and is reclaimed when the
+    // lattice is destroyed
     for (auto state_id : m_egraph_node_to_state) {
         auto& state = WorkspaceLattice::m_states[state_id];
-        delete state;
+        state->~WorkspaceLatticeState();
         state = NULL;
     }
 
-    // remove all e-graph states from the state table
-
+    // remove all e-graph states from the state table, shifting the remaining
+    // states down and rebuilding the coordinate index for their new ids.
+    // states created by coordinate are found under their own id; reserved
+    // states are not and remain unindexed
+    CoordTable coords(m_coord_table.width());
     auto first = (decltype(m_states)::size_type)0;
-    auto last = m_states.size();
-
-    // find the index of the first non-null state
-    while (first != last) {
-        if (m_states[first] == NULL) break;
-        ++first;
-    }
-
-    // shift all non-null states
-    if (first != last) {
-        for (auto i = first; ++i != last;) {
-            if (m_states[i] != NULL) {
-                // remap state to id
-                m_state_to_id[m_states[i]] = first;
-                // shift the state
-                m_states[first] = m_states[i];
-                ++first;
-            }
+    for (size_t i = 0; i < m_states.size(); ++i) {
+        if (m_states[i] == NULL) {
+            continue;
+        }
+
+        auto* coord = m_coord_table.coord((int)i);
+        if (m_coord_table.find(coord) == (int)i) {
+            coords.insert(coord);
+        } else {
+            auto id = coords.reserve();
+            std::copy(coord, coord + coords.width(), coords.coord(id));
         }
+        m_states[first++] = m_states[i];
     }
 
     m_states.resize(first);
+    m_coord_table = std::move(coords);
 
     m_egraph.clear();
     m_coord_to_egraph_nodes.clear();
@@ -290,89 +284,133 @@ void WorkspaceLatticeEGraph::clearExperienceGraph()
     m_state_to_egraph_node.clear();
 }
 
-void WorkspaceLatticeEGraph::insertExperienceGraphPath(
-    const std::vector<smpl::RobotState>& path)
+void WorkspaceLatticeEGraph::clearStates()
 {
-    if (path.empty()) {
-        SMPL_WARN("No experience graph states contained in file");
-        return;
-    }
+    WorkspaceLattice::clearStates();
 
-    SMPL_DEBUG_NAMED(G_LOG, "Create hash entries for experience graph states");
+    // re-reserve graph states for the experience graph states
+    m_state_to_egraph_node.clear();
+    auto nodes = m_egraph.nodes();
+    for (auto nit = nodes.first; nit != nodes.second; ++nit) {
+        auto& egraph_state = m_egraph.state(*nit);
 
-    // Create an experience graph state for the first state
+        WorkspaceState tmp;
+        stateRobotToWorkspace(egraph_state, tmp);
+        WorkspaceCoord disc_egraph_state(dofCount());
+        stateWorkspaceToCoord(tmp, disc_egraph_state);
 
-    auto& first_egraph_state = path.front();
+        auto state_id = reserveHashEntry(disc_egraph_state, egraph_state);
 
-    auto prev_node_id = m_egraph.insert_node(first_egraph_state);
+        m_egraph_node_to_state[*nit] = state_id;
+        m_state_to_egraph_node[state_id] = *nit;
+    }
+}
 
-    {
-        // map discrete egraph state -> egraph node
-        WorkspaceState tmp;
-        stateRobotToWorkspace(first_egraph_state, tmp);
+bool WorkspaceLatticeEGraph::insertExperienceGraphPath(
+    const std::vector<RobotState>& path,
+    double merge_radius)
+{
+    if (path.empty()) {
+        return false;
+    }
 
-        WorkspaceCoord disc_egraph_state(dofCount());
-        stateWorkspaceToCoord(tmp, disc_egraph_state);
-        m_coord_to_egraph_nodes[disc_egraph_state].push_back(prev_node_id);
+    auto first_node = m_egraph.num_nodes();
+    auto first_edge = m_egraph.num_edges();
 
-        // reserve a graph state for this state
-        auto state_id = reserveHashEntry();
-        auto* state = getState(state_id);
-        state->coord = disc_egraph_state;
-        state->state = first_egraph_state;
+    // merge against the nodes that existed before this path
+    updateExperienceGraphIndex();
+    addExperienceGraphPath(path, merge_radius);
 
-        // map egraph node -> graph state
-        m_egraph_node_to_state.resize(prev_node_id + 1, -1);
-        m_egraph_node_to_state[prev_node_id] = state_id;
+    m_egraph.compact();
+    updateExperienceGraphIndex();
 
-        // map graph state -> egraph node
-        m_state_to_egraph_node[state_id] = prev_node_id;
+    SMPL_DEBUG_NAMED(G_LOG, "Inserted %zu nodes and %zu edges into the experience graph", m_egraph.num_nodes() - first_node, m_egraph.num_edges() - first_edge);
 
-        SMPL_DEBUG_STREAM_NAMED(G_LOG, "  egraph state = " << first_egraph_state);
-        SMPL_DEBUG_STREAM_NAMED(G_LOG, "  egraph node = " << prev_node_id);
-        SMPL_DEBUG_STREAM_NAMED(G_LOG, "  disc state = " << disc_egraph_state);
-        SMPL_DEBUG_STREAM_NAMED(G_LOG, "  state id = " << state_id);
+    for (size_t i = 0; i < numHeuristics(); ++i) {
+        auto* egh = heuristic(i)->getExtension<ExperienceGraphHeuristicExtension>();
+        if (egh) {
+            egh->experienceGraphExtended(first_node, first_edge);
+        }
     }
+    return true;
+}
+
+void WorkspaceLatticeEGraph::addExperienceGraphPath(
+    const std::vector<smpl::RobotState>& path,
+    double merge_radius)
+{
+    if (path.empty()) {
+        SMPL_WARN("No experience graph states contained in file");
+        return;
+    }
+
+    SMPL_DEBUG_NAMED(G_LOG, "Create hash entries for experience graph states");
+
+    std::vector<std::size_t> nearest;
+    auto merge_node = [&](const RobotState& state, ExperienceGraph::node_id& n) -> bool {
+        if (merge_radius <= 0.0) {
+            return false;
+        }
+        m_egraph_index.nearest(state.data(), 1, nearest);
+        if (nearest.empty()) {
+            return false;
+        }
+        auto& nstate = m_egraph.state(nearest.front());
+        double d2 = 0.0;
+        for (size_t i = 0; i < state.size(); ++i) {
+            d2 += (state[i] - nstate[i]) * (state[i] - nstate[i]);
+        }
+        if (d2 > merge_radius * merge_radius) {
+            return false;
+        }
+        n = nearest.front();
+        return true;
+    };
 
     // Walk through the demonstration and create a unique e-graph state
     // for each state. Intermediately encountered
     // states that span between two discrete states become the edges in
     // the e-graph.
-    for (size_t i = 1; i < path.size(); ++i) {
+    ExperienceGraph::node_id prev_node_id = 0;
+    for (size_t i = 0; i < path.size(); ++i) {
         auto& egraph_state = path[i];
 
-        auto node_id = m_egraph.insert_node(egraph_state);
+        ExperienceGraph::node_id node_id;
+        if (!merge_node(egraph_state, node_id)) {
+            node_id = m_egraph.insert_node(egraph_state);
 
-        WorkspaceState tmp;
-        stateRobotToWorkspace(egraph_state, tmp);
+            WorkspaceState tmp;
+            stateRobotToWorkspace(egraph_state, tmp);
 
-        // map discrete egraph state -> egraph node
-        WorkspaceCoord disc_egraph_state(dofCount());
-        stateWorkspaceToCoord(tmp, disc_egraph_state);
-        m_coord_to_egraph_nodes[disc_egraph_state].push_back(prev_node_id);
+            // map discrete egraph state -> egraph node
+            WorkspaceCoord disc_egraph_state(dofCount());
+            stateWorkspaceToCoord(tmp, disc_egraph_state);
+            m_coord_to_egraph_nodes[disc_egraph_state].push_back(node_id);
 
-        // reserve a graph state for this state
-        auto state_id = reserveHashEntry();
-        auto* state = getState(state_id);
-        state->coord = disc_egraph_state;
-        state->state = egraph_state;
+            // reserve a graph state for this state
+            auto state_id = reserveHashEntry(disc_egraph_state, egraph_state);
 
-        // map egraph node -> graph state
-        m_egraph_node_to_state.resize(node_id + 1, -1);
-        m_egraph_node_to_state[node_id] = state_id;
+            // map egraph node -> graph state
+            m_egraph_node_to_state.resize(node_id + 1, -1);
+            m_egraph_node_to_state[node_id] = state_id;
 
-        // map graph state -> egraph node
-        m_state_to_egraph_node[state_id] = node_id;
+            // map graph state -> egraph node
+            m_state_to_egraph_node[state_id] = node_id;
+
+            SMPL_DEBUG_STREAM_NAMED(G_LOG, "  egraph state = " << egraph_state);
+            SMPL_DEBUG_STREAM_NAMED(G_LOG, "  egraph node = " << node_id);
+            SMPL_DEBUG_STREAM_NAMED(G_LOG, "  disc state = " << disc_egraph_state);
+            SMPL_DEBUG_STREAM_NAMED(G_LOG, "  state id = " << state_id);
+        }
 
         // add edge from previous node
-        m_egraph.insert_edge(prev_node_id, node_id, { });
+        if (i > 0 && node_id != prev_node_id &&
+            !m_egraph.edge(prev_node_id, node_id))
+        {
+            m_egraph.insert_edge(prev_node_id, node_id, { });
+        }
 
         prev_node_id = node_id;
-
-        SMPL_DEBUG_STREAM_NAMED(G_LOG, "  egraph state = " << egraph_state);
-        SMPL_DEBUG_STREAM_NAMED(G_LOG, "  egraph node = " << prev_node_id);
-        SMPL_DEBUG_STREAM_NAMED(G_LOG, "  disc state = " << disc_egraph_state);
-        SMPL_DEBUG_STREAM_NAMED(G_LOG, "  state id = " << state_id);
     }
 }
 
@@ -389,6 +427,12 @@ void WorkspaceLatticeEGraph::insertExperienceGraphPath(
 bool WorkspaceLatticeEGraph::loadExperienceGraph(const std::string& path)
 {
     boost::filesystem::path p(path);
+    if (IsSharedExperienceGraph(path) ||
+        (boost::filesystem::is_regular_file(p) && IsExperienceGraphFile(path)))
+    {
+        return loadExperienceGraphFile(path);
+    }
+
     if (!boost::filesystem::is_directory(p)) {
         SMPL_ERROR("'%s' is not a directory", path.c_str());
         return false;
@@ -403,13 +447,62 @@ bool WorkspaceLatticeEGraph::loadExperienceGraph(const std::string& path)
             continue;
         }
 
-        insertExperienceGraphPath(egraph_path);
+        addExperienceGraphPath(egraph_path, 0.0);
+    }
+
+    m_egraph.compact();
+    updateExperienceGraphIndex();
+
+    SMPL_DEBUG_NAMED(G_LOG, "Experience graph contains %zu nodes and %zu edges", m_egraph.num_nodes(), m_egraph.num_edges());
+    return true;
+}
+
+// Append the experience graph stored in a binary file written by
+// saveExperienceGraph() and reserve a graph state for each of its nodes.
+bool WorkspaceLatticeEGraph::loadExperienceGraphFile(const std::string& path)
+{
+    ExperienceGraphFile file;
+    if (!file.open(path)) {
+        return false;
+    }
+
+    if (file.num_nodes() != 0 && file.dof() != robot()->jointVariableCount()) {
+        SMPL_ERROR("Experience graph file '%s' has %zu variables (expected %zu)", path.c_str(), file.dof(), robot()->jointVariableCount());
+        return false;
+    }
+
+    auto first = m_egraph.num_nodes();
+    AppendExperienceGraphFile(file, m_egraph);
+
+    m_egraph_node_to_state.resize(m_egraph.num_nodes(), -1);
+    WorkspaceState tmp;
+    WorkspaceCoord disc_egraph_state(dofCount());
+    for (auto n = first; n < m_egraph.num_nodes(); ++n) {
+        auto& egraph_state = m_egraph.state(n);
+        stateRobotToWorkspace(egraph_state, tmp);
+        stateWorkspaceToCoord(tmp, disc_egraph_state);
+        m_coord_to_egraph_nodes[disc_egraph_state].push_back(n);
+
+        auto state_id = reserveHashEntry(disc_egraph_state, egraph_state);
+
+        m_egraph_node_to_state[n] = state_id;
+        m_state_to_egraph_node[state_id] = n;
     }
 
+    m_egraph.compact();
+    updateExperienceGraphIndex();
+
     SMPL_DEBUG_NAMED(G_LOG, "Experience graph contains %zu nodes and %zu edges", m_egraph.num_nodes(), m_egraph.num_edges());
     return true;
 }
 
+/// Write the loaded experience graph to a binary file that can be passed to
+/// loadExperienceGraph() in place of a directory of demonstrations.
+bool WorkspaceLatticeEGraph::saveExperienceGraph(const std::string& path) const
+{
+    return WriteExperienceGraphFile(path, m_egraph);
+}
+
 void WorkspaceLatticeEGraph::getExperienceGraphNodes(
     int state_id,
     std::vector<ExperienceGraph::node_id>& nodes)
@@ -420,12 +513,62 @@ void WorkspaceLatticeEGraph::getExperienceGraphNodes(
     }
 }
 
+void WorkspaceLatticeEGraph::getNearestExperienceGraphNodes(
+    const RobotState& state,
+    int k,
+    std::vector<ExperienceGraph::node_id>& nodes)
+{
+    if (k <= 0 || state.size() != robot()->jointVariableCount()) {
+        return;
+    }
+    updateExperienceGraphIndex();
+    std::vector<std::size_t> indices;
+    m_egraph_index.nearest(state.data(), k, indices);
+    nodes.insert(nodes.end(), indices.begin(), indices.end());
+}
+
+void WorkspaceLatticeEGraph::getExperienceGraphNodesInRadius(
+    const RobotState& state,
+    double radius,
+    std::vector<ExperienceGraph::node_id>& nodes)
+{
+    if (state.size() != robot()->jointVariableCount()) {
+        return;
+    }
+    updateExperienceGraphIndex();
+    std::vector<std::size_t> indices;
+    m_egraph_index.radius(state.data(), radius, indices);
+    nodes.insert(nodes.end(), indices.begin(), indices.end());
+}
+
+// Rebuild the joint-space index over experience graph node states if nodes
+// were inserted or erased since it was last built.
+void WorkspaceLatticeEGraph::updateExperienceGraphIndex()
+{
+    if (m_egraph_index.size() == m_egraph.num_nodes()) {
+        return;
+    }
+
+    auto dof = robot()->jointVariableCount();
+    std::vector<double> points;
+    points.reserve(m_egraph.num_nodes() * dof);
+    auto nodes = m_egraph.nodes();
+    for (auto nit = nodes.first; nit != nodes.second; ++nit) {
+        auto& state = m_egraph.state(*nit);
+        points.insert(points.end(), state.begin(), state.end());
+    }
+    m_egraph_index.build(points.data(), m_egraph.num_nodes(), dof);
+}
+
 bool WorkspaceLatticeEGraph::shortcut(int src_id, int dst_id, int& cost)
 {
     auto* src_state = getState(src_id);
     auto* dst_state = getState(dst_id);
 
-    SMPL_INFO_STREAM("Shortcut " << src_state->coord << " -> " << dst_state->coord);
+    WorkspaceCoord src_coord, dst_coord;
+    getStateCoord(src_id, src_coord);
+    getStateCoord(dst_id, dst_coord);
+    SMPL_INFO_STREAM("Shortcut " << src_coord << " -> " << dst_coord);
     auto* vis_name = "shortcut";
     SV_SHOW_INFO_NAMED(vis_name, getStateVisualization(src_state->state, "shortcut_from"));
     SV_SHOW_INFO_NAMED(vis_name, getStateVisualization(dst_state->state, "shortcut_to"));
@@ -444,7 +587,10 @@ bool WorkspaceLatticeEGraph::snap(int src_id, int dst_id, int& cost)
         return false;
     }
 
-    SMPL_DEBUG_STREAM("Snap " << src_state->coord << " -> " << dst_state->coord);
+    WorkspaceCoord src_coord, dst_coord;
+    getStateCoord(src_id, src_coord);
+    getStateCoord(dst_id, dst_coord);
+    SMPL_DEBUG_STREAM("Snap " << src_coord << " -> " << dst_coord);
     auto* vis_name = "snap";
     SV_SHOW_INFO_NAMED(vis_name, getStateVisualization(src_state->state, "snap_from"));
     SV_SHOW_INFO_NAMED(vis_name, getStateVisualization(dst_state->state, "snap_to"));
@@ -639,8 +785,9 @@ void WorkspaceLatticeEGraph::GetSuccs(
     auto curr_count = succs->size();
     for (auto i = prev_count; i != curr_count; ++i) {
         auto* state = getState((*succs)[i]);
+        getStateCoord((*succs)[i], m_succ_coord);
         WorkspaceState workspace_state;
-        stateCoordToWorkspace(state->coord, workspace_state);
+        stateCoordToWorkspace(m_succ_coord, workspace_state);
         if (isGoal(workspace_state, state->state)) {
             (*succs)[i] = getGoalStateID();
         }
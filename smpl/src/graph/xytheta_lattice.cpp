@@ -0,0 +1,750 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+
+#include <smpl/graph/xytheta_lattice.h>
+
+// standard includes
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+// project includes
+#include <smpl/angles.h>
+#include <smpl/console/console.h>
+#include <smpl/console/nonstd.h>
+#include <smpl/unicycle/dubins.h>
+
+namespace smpl {
+
+// primitives whose Dubins curve is this much longer than the straight line
+// between their endpoints loop around and are discarded
+static const double MAX_CURVE_TO_CHORD_RATIO = 1.5;
+
+// cost of one meter of motion
+static const double COST_PER_METER = 1000.0;
+
+XYThetaLattice::~XYThetaLattice()
+{
+    for (auto* pinds : StateID2IndexMapping) {
+        delete[] pinds;
+    }
+    StateID2IndexMapping.clear();
+}
+
+bool XYThetaLattice::init(
+    RobotModel* robot,
+    CollisionChecker* checker,
+    const OccupancyGrid* grid,
+    const Params& params)
+{
+    if (!grid) {
+        SMPL_ERROR_NAMED(G_LOG, "Occupancy grid is null");
+        return false;
+    }
+
+    if (robot->jointVariableCount() != 3) {
+        SMPL_ERROR_NAMED(G_LOG, "XYTheta Lattice requires a robot model with 3 variables (found %d)", robot->jointVariableCount());
+        return false;
+    }
+
+    if (params.num_headings < 4 || params.num_headings % 4 != 0) {
+        SMPL_ERROR_NAMED(G_LOG, "Number of headings must be a positive multiple of 4");
+        return false;
+    }
+
+    if (params.turning_radius <= 0.0 || params.long_primitive_cells < 1 ||
+        params.max_heading_change < 0 ||
+        params.max_heading_change >= params.num_headings / 4)
+    {
+        SMPL_ERROR_NAMED(G_LOG, "Invalid XYTheta Lattice primitive parameters");
+        return false;
+    }
+
+    if (!RobotPlanningSpace::init(robot, checker)) {
+        SMPL_ERROR_NAMED(G_LOG, "Failed to initialize Robot Planning Space");
+        return false;
+    }
+
+    m_grid = grid;
+    m_params = params;
+
+    int gx, gy;
+    m_grid->worldToGrid(m_grid->originX(), m_grid->originY(), m_params.height, gx, gy, m_grid_z);
+    if (!m_grid->isInBounds(0, 0, m_grid_z)) {
+        SMPL_ERROR_NAMED(G_LOG, "Height %f is outside the occupancy grid", m_params.height);
+        return false;
+    }
+
+    m_coord_table.setWidth(3);
+    clearStates();
+
+    if (!m_slice.init(m_grid, m_grid_z)) {
+        return false;
+    }
+
+    m_footprint_cells.resize(m_params.num_headings);
+    m_footprint_swept.resize(m_params.num_headings);
+    for (int h = 0; h < m_params.num_headings; ++h) {
+        m_footprint_cells[h].clear();
+        addSweptCells(Pose2D(0.0, 0.0, headingAngle(h)), m_footprint_cells[h]);
+        std::sort(begin(m_footprint_cells[h]), end(m_footprint_cells[h]));
+        m_footprint_swept[h] = SweptFootprint(m_footprint_cells[h]);
+    }
+
+    makePrimitives();
+    return true;
+}
+
+double XYThetaLattice::headingAngle(int heading) const
+{
+    return 2.0 * M_PI * (double)heading / (double)m_params.num_headings;
+}
+
+int XYThetaLattice::angleToHeading(double theta) const
+{
+    auto step = 2.0 * M_PI / (double)m_params.num_headings;
+    auto h = (int)std::round(normalize_angle_positive(theta) / step);
+    return h % m_params.num_headings;
+}
+
+bool XYThetaLattice::cellsFree(
+    int x,
+    int y,
+    const std::vector<std::pair<int, int>>& cells) const
+{
+    for (auto& cell : cells) {
+        auto cx = x + cell.first;
+        auto cy = y + cell.second;
+        if (!m_grid->isInBounds(cx, cy, m_grid_z) ||
+            m_grid->getDistance(cx, cy, m_grid_z) <= 0.0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void XYThetaLattice::updateOccupancySlice()
+{
+    m_slice.update();
+}
+
+void XYThetaLattice::clearStates()
+{
+    m_coord_table.clear();
+    m_states.clear();
+    m_start_state_id = -1;
+
+    // the goal state is reserved, without a coordinate, so that it is never
+    // found by coordinate lookup
+    m_goal_state_id = m_coord_table.reserve();
+    m_states.emplace_back();
+}
+
+auto XYThetaLattice::extractState(int state_id) -> const RobotState&
+{
+    return m_states[state_id];
+}
+
+bool XYThetaLattice::projectToPose(int state_id, Affine3& pose)
+{
+    if (state_id == m_goal_state_id) {
+        pose = goal().pose;
+        return true;
+    }
+
+    auto& state = m_states[state_id];
+    pose = Translation3(state[0], state[1], m_params.height) *
+            AngleAxis(state[2], Vector3::UnitZ());
+    return true;
+}
+
+bool XYThetaLattice::setStart(const RobotState& state)
+{
+    if (state.size() < 3) {
+        SMPL_ERROR_NAMED(G_LOG, "start state does not contain enough variables");
+        return false;
+    }
+
+    updateOccupancySlice();
+
+    int coord[3];
+    stateToCoord(state, coord);
+    if (!sweptFree(coord[0], coord[1], m_footprint_swept[coord[2]])) {
+        SMPL_WARN(" -> in collision");
+        return false;
+    }
+
+    m_start_state_id = getOrCreateState(coord);
+    return RobotPlanningSpace::setStart(state);
+}
+
+bool XYThetaLattice::setGoal(const GoalConstraint& goal)
+{
+    switch (goal.type) {
+    case GoalType::JOINT_STATE_GOAL:
+    {
+        if (goal.angles.size() < 3 || goal.angle_tolerances.size() < 3) {
+            SMPL_ERROR_NAMED(G_LOG, "Goal state and tolerances must contain (x, y, theta)");
+            return false;
+        }
+
+        // fill in the goal pose for heuristics that work in the workspace
+        auto pose_goal = goal;
+        pose_goal.pose = Translation3(goal.angles[0], goal.angles[1], m_params.height) *
+                AngleAxis(goal.angles[2], Vector3::UnitZ());
+        return RobotPlanningSpace::setGoal(pose_goal);
+    }
+    case GoalType::XYZ_GOAL:
+    case GoalType::XYZ_RPY_GOAL:
+        break;
+    default:
+        SMPL_ERROR_NAMED(G_LOG, "XYTheta Lattice supports only joint state and pose goals");
+        return false;
+    }
+
+    return RobotPlanningSpace::setGoal(goal);
+}
+
+int XYThetaLattice::getStartStateID() const
+{
+    return m_start_state_id;
+}
+
+int XYThetaLattice::getGoalStateID() const
+{
+    return m_goal_state_id;
+}
+
+bool XYThetaLattice::extractPath(
+    const std::vector<int>& ids,
+    std::vector<RobotState>& path)
+{
+    if (ids.empty()) {
+        return true;
+    }
+
+    if (ids[0] == m_goal_state_id) {
+        if (ids.size() != 1 || m_start_state_id < 0) {
+            SMPL_ERROR_NAMED(G_LOG, "Cannot extract a non-trivial path starting from the goal state");
+            return false;
+        }
+        path.assign(1, m_states[m_start_state_id]);
+        return true;
+    }
+
+    std::vector<RobotState> opath;
+    opath.push_back(m_states[ids[0]]);
+
+    for (size_t i = 1; i < ids.size(); ++i) {
+        auto prev_id = ids[i - 1];
+        auto curr_id = ids[i];
+        if (prev_id == m_goal_state_id) {
+            SMPL_ERROR_NAMED(G_LOG, "Cannot determine goal state predecessor state during path extraction");
+            return false;
+        }
+
+        auto* prev = m_coord_table.coord(prev_id);
+        auto* curr = curr_id == m_goal_state_id ? nullptr : m_coord_table.coord(curr_id);
+
+        // find the cheapest valid primitive between the two states
+        const XYThetaPrimitive* best = nullptr;
+        for (auto& prim : m_prims[prev[2]]) {
+            if (best && prim.cost >= best->cost) {
+                continue;
+            }
+            if (curr) {
+                if (prev[0] + prim.dx != curr[0] ||
+                    prev[1] + prim.dy != curr[1] ||
+                    prim.end_heading != curr[2])
+                {
+                    continue;
+                }
+            } else if (!isGoal(stateAt(prev[0], prev[1], prim.poses.back()))) {
+                continue;
+            }
+            if (sweptFree(prev[0], prev[1], prim.swept)) {
+                best = &prim;
+            }
+        }
+
+        if (!best) {
+            SMPL_ERROR_STREAM_NAMED(G_LOG, "Failed to find a valid primitive from state " << m_states[prev_id] << " during path extraction");
+            return false;
+        }
+
+        for (auto& pose : best->poses) {
+            opath.push_back(stateAt(prev[0], prev[1], pose));
+        }
+    }
+
+    path = std::move(opath);
+    return true;
+}
+
+Extension* XYThetaLattice::getExtension(size_t class_code)
+{
+    if (class_code == GetClassCode<RobotPlanningSpace>() ||
+        class_code == GetClassCode<ExtractRobotStateExtension>() ||
+        class_code == GetClassCode<PointProjectionExtension>() ||
+        class_code == GetClassCode<PoseProjectionExtension>())
+    {
+        return this;
+    }
+    return nullptr;
+}
+
+void XYThetaLattice::GetSuccs(
+    int state_id,
+    std::vector<int>* succs,
+    std::vector<int>* costs)
+{
+    assert(state_id >= 0 && state_id < (int)m_states.size());
+
+    if (state_id == m_goal_state_id) {
+        return;
+    }
+
+    // copy the coordinate; creating successors may grow the table
+    int coord[3];
+    std::copy(m_coord_table.coord(state_id), m_coord_table.coord(state_id) + 3, coord);
+
+    for (auto& prim : m_prims[coord[2]]) {
+        if (!sweptFree(coord[0], coord[1], prim.swept)) {
+            continue;
+        }
+
+        int succ_coord[3] = { coord[0] + prim.dx, coord[1] + prim.dy, prim.end_heading };
+        auto succ_id = isGoal(coordToState(succ_coord)) ?
+                m_goal_state_id : getOrCreateState(succ_coord);
+        succs->push_back(succ_id);
+        costs->push_back(prim.cost);
+    }
+}
+
+/// Predecessors are found through the primitives that end at the state's
+/// heading. The goal state has no predecessors, since it stands for every
+/// state that satisfies the goal.
+void XYThetaLattice::GetPreds(
+    int state_id,
+    std::vector<int>* preds,
+    std::vector<int>* costs)
+{
+    assert(state_id >= 0 && state_id < (int)m_states.size());
+
+    if (state_id == m_goal_state_id) {
+        SMPL_WARN_ONCE("XYTheta Lattice does not generate predecessors of the goal state");
+        return;
+    }
+
+    int coord[3];
+    std::copy(m_coord_table.coord(state_id), m_coord_table.coord(state_id) + 3, coord);
+
+    for (auto& entry : m_prims_to[coord[2]]) {
+        auto& prim = m_prims[entry.first][entry.second];
+        int pred_coord[3] = { coord[0] - prim.dx, coord[1] - prim.dy, prim.start_heading };
+        if (!sweptFree(pred_coord[0], pred_coord[1], prim.swept)) {
+            continue;
+        }
+        preds->push_back(getOrCreateState(pred_coord));
+        costs->push_back(prim.cost);
+    }
+}
+
+void XYThetaLattice::PrintState(int state_id, bool verbose, FILE* fout)
+{
+    assert(state_id >= 0 && state_id < (int)m_states.size());
+
+    if (!fout) {
+        fout = stdout;
+    }
+
+    std::stringstream ss;
+    if (state_id == m_goal_state_id) {
+        ss << "<goal state>";
+    } else {
+        auto* coord = m_coord_table.coord(state_id);
+        ss << "{ coord: (" << coord[0] << ", " << coord[1] << ", " << coord[2] <<
+                "), state: " << m_states[state_id] << " }";
+    }
+
+    if (fout == stdout) {
+        SMPL_DEBUG_NAMED(G_LOG, "%s", ss.str().c_str());
+    } else if (fout == stderr) {
+        SMPL_WARN("%s", ss.str().c_str());
+    } else {
+        fprintf(fout, "%s\n", ss.str().c_str());
+    }
+}
+
+// Generate, for each start heading, primitives that change the heading by up
+// to max_heading_change. For each heading change, the ideal end pose of a
+// minimum-radius turn followed by a straight segment is rounded to the
+// nearest cell, and the shortest Dubins curve to it is kept if it does not
+// loop; of the curves of increasing length, the shortest and longest that
+// are kept become primitives. Backward primitives are the forward ones driven
+// in reverse.
+void XYThetaLattice::makePrimitives()
+{
+    auto H = m_params.num_headings;
+    auto res = m_grid->resolution();
+    auto r = m_params.turning_radius;
+    auto step = 2.0 * M_PI / (double)H;
+
+    m_prims.assign(H, std::vector<XYThetaPrimitive>());
+
+    for (int h = 0; h < H; ++h) {
+        auto theta = headingAngle(h);
+        auto c = std::cos(theta);
+        auto s = std::sin(theta);
+
+        for (int dh = -m_params.max_heading_change; dh <= m_params.max_heading_change; ++dh) {
+            auto phi = (double)dh * step;
+            std::vector<XYThetaPrimitive> kept;
+            for (int len = 1; len <= m_params.long_primitive_cells; ++len) {
+                // ideal end position in the start heading frame
+                auto ex = r * std::sin(std::fabs(phi));
+                auto ey = (dh < 0 ? -1.0 : 1.0) * r * (1.0 - std::cos(phi));
+                auto extra = std::max(0.0, (double)len * res - std::hypot(ex, ey));
+                ex += extra * std::cos(phi);
+                ey += extra * std::sin(phi);
+
+                auto dx = (int)std::round((c * ex - s * ey) / res);
+                auto dy = (int)std::round((s * ex + c * ey) / res);
+                if (dx == 0 && dy == 0) {
+                    continue;
+                }
+
+                auto end_pose = Pose2D((double)dx * res, (double)dy * res, theta + phi);
+                XYThetaPrimitive prim;
+                if (!makePrimitive(h, end_pose, prim)) {
+                    continue;
+                }
+
+                auto dup = std::any_of(begin(kept), end(kept),
+                        [&](const XYThetaPrimitive& p) {
+                            return p.dx == prim.dx && p.dy == prim.dy;
+                        });
+                if (!dup) {
+                    kept.push_back(std::move(prim));
+                }
+            }
+
+            if (!kept.empty()) {
+                m_prims[h].push_back(std::move(kept.front()));
+            }
+            if (kept.size() > 1) {
+                m_prims[h].push_back(std::move(kept.back()));
+            }
+        }
+    }
+
+    if (m_params.backward_cost_mult > 0.0) {
+        std::vector<std::vector<XYThetaPrimitive>> backward(H);
+        for (int h = 0; h < H; ++h) {
+            for (auto& fwd : m_prims[h]) {
+                XYThetaPrimitive prim;
+                prim.start_heading = fwd.end_heading;
+                prim.end_heading = fwd.start_heading;
+                prim.dx = -fwd.dx;
+                prim.dy = -fwd.dy;
+                prim.cost = std::max(1, (int)std::ceil((double)fwd.cost * m_params.backward_cost_mult));
+
+                // poses of the forward primitive, relative to its end, in
+                // reverse order, ending at its start
+                auto ox = (double)fwd.dx * res;
+                auto oy = (double)fwd.dy * res;
+                for (int i = (int)fwd.poses.size() - 2; i >= 0; --i) {
+                    auto& p = fwd.poses[i];
+                    prim.poses.push_back(Pose2D(p.x - ox, p.y - oy, p.theta));
+                }
+                prim.poses.push_back(Pose2D(-ox, -oy, headingAngle(fwd.start_heading)));
+
+                for (auto& cell : fwd.cells) {
+                    prim.cells.emplace_back(cell.first - fwd.dx, cell.second - fwd.dy);
+                }
+                backward[prim.start_heading].push_back(std::move(prim));
+            }
+        }
+        for (int h = 0; h < H; ++h) {
+            for (auto& prim : backward[h]) {
+                m_prims[h].push_back(std::move(prim));
+            }
+        }
+    }
+
+    if (m_params.turn_in_place_cost > 0) {
+        for (int h = 0; h < H; ++h) {
+            for (int dh = -1; dh <= 1; dh += 2) {
+                XYThetaPrimitive prim;
+                prim.start_heading = h;
+                prim.end_heading = (h + dh + H) % H;
+                prim.dx = 0;
+                prim.dy = 0;
+                prim.cost = m_params.turn_in_place_cost;
+
+                // sample the rotation finely enough that no footprint vertex
+                // moves more than half a cell between samples
+                auto reach = 0.0;
+                for (auto& v : m_params.footprint) {
+                    reach = std::max(reach, v.norm());
+                }
+                auto samples = std::max(1, (int)std::ceil(reach * step / (0.5 * res)));
+                auto theta = headingAngle(h);
+                addSweptCells(Pose2D(0.0, 0.0, theta), prim.cells);
+                for (int i = 1; i <= samples; ++i) {
+                    auto pose = Pose2D(0.0, 0.0, theta + (double)dh * step * (double)i / (double)samples);
+                    addSweptCells(pose, prim.cells);
+                    if (i == samples) {
+                        pose.theta = headingAngle(prim.end_heading);
+                        prim.poses.push_back(pose);
+                    }
+                }
+                std::sort(begin(prim.cells), end(prim.cells));
+                prim.cells.erase(std::unique(begin(prim.cells), end(prim.cells)), end(prim.cells));
+                m_prims[h].push_back(std::move(prim));
+            }
+        }
+    }
+
+    makeBodyVelocityPrimitives();
+
+    m_prims_to.assign(H, std::vector<std::pair<int, int>>());
+    auto count = 0;
+    for (int h = 0; h < H; ++h) {
+        for (int i = 0; i < (int)m_prims[h].size(); ++i) {
+            auto& prim = m_prims[h][i];
+            prim.swept = SweptFootprint(prim.cells);
+            m_prims_to[prim.end_heading].emplace_back(h, i);
+            ++count;
+        }
+    }
+
+    SMPL_INFO_NAMED(G_LOG, "Generated %d primitives over %d headings", count, H);
+}
+
+// Generate, for each start heading, the primitives that drive each body
+// velocity for the configured duration. The end pose is rounded to the
+// nearest lattice pose, and the difference is blended into the intermediate
+// poses in proportion to their time along the motion. Motions that end in
+// their own start state are dropped.
+void XYThetaLattice::makeBodyVelocityPrimitives()
+{
+    auto H = m_params.num_headings;
+    auto res = m_grid->resolution();
+    auto T = m_params.body_velocity_duration;
+
+    // distance of the farthest footprint vertex from the origin, to charge
+    // for rotation
+    auto reach = 0.0;
+    for (auto& v : m_params.footprint) {
+        reach = std::max(reach, v.norm());
+    }
+
+    for (auto& v : m_params.body_velocities) {
+        // sample often enough that no footprint vertex moves more than half
+        // a cell between samples
+        auto speed = std::hypot(v.x(), v.y()) + std::fabs(v.z()) * reach;
+        auto samples = std::max(1, (int)std::ceil(speed * T / (0.5 * res)));
+
+        for (int h = 0; h < H; ++h) {
+            auto start = Pose2D(0.0, 0.0, headingAngle(h));
+            auto poses = IntegrateBodyVelocity(start, v.x(), v.y(), v.z(), T, samples);
+
+            auto& last = poses.back();
+            XYThetaPrimitive prim;
+            prim.start_heading = h;
+            prim.end_heading = angleToHeading(last.theta);
+            prim.dx = (int)std::round(last.x / res);
+            prim.dy = (int)std::round(last.y / res);
+            if (prim.dx == 0 && prim.dy == 0 && prim.end_heading == h) {
+                continue;
+            }
+
+            auto ex = (double)prim.dx * res - last.x;
+            auto ey = (double)prim.dy * res - last.y;
+            auto eth = shortest_angle_diff(headingAngle(prim.end_heading), last.theta);
+
+            auto length = 0.0;
+            auto turned = 0.0;
+            auto prev = start;
+            addSweptCells(start, prim.cells);
+            for (int i = 0; i < samples; ++i) {
+                auto a = (double)(i + 1) / (double)samples;
+                auto pose = Pose2D(
+                        poses[i].x + a * ex,
+                        poses[i].y + a * ey,
+                        normalize_angle_positive(poses[i].theta + a * eth));
+                if (i == samples - 1) {
+                    pose.theta = headingAngle(prim.end_heading);
+                }
+                length += std::hypot(pose.x - prev.x, pose.y - prev.y);
+                turned += std::fabs(shortest_angle_diff(pose.theta, prev.theta));
+                prim.poses.push_back(pose);
+                addSweptCells(pose, prim.cells);
+                prev = pose;
+            }
+            std::sort(begin(prim.cells), end(prim.cells));
+            prim.cells.erase(std::unique(begin(prim.cells), end(prim.cells)), end(prim.cells));
+
+            prim.cost = std::max(1, (int)std::ceil(COST_PER_METER * (length + reach * turned)));
+            m_prims[h].push_back(std::move(prim));
+        }
+    }
+}
+
+bool XYThetaLattice::makePrimitive(
+    int heading,
+    const Pose2D& end_pose,
+    XYThetaPrimitive& prim) const
+{
+    auto res = m_grid->resolution();
+    auto start = Pose2D(0.0, 0.0, headingAngle(heading));
+
+    DubinsMotion motions[6];
+    auto count = MakeDubinsPaths(start, end_pose, m_params.turning_radius, motions);
+    auto best = -1;
+    for (int i = 0; i < count; ++i) {
+        if (best < 0 || motions[i].length() < motions[best].length()) {
+            best = i;
+        }
+    }
+
+    auto chord = std::hypot(end_pose.x, end_pose.y);
+    if (best < 0 || motions[best].length() > MAX_CURVE_TO_CHORD_RATIO * chord) {
+        return false;
+    }
+
+    auto& motion = motions[best];
+    auto length = motion.length();
+
+    prim.start_heading = heading;
+    prim.end_heading = angleToHeading(end_pose.theta);
+    prim.dx = (int)std::round(end_pose.x / res);
+    prim.dy = (int)std::round(end_pose.y / res);
+    prim.cost = std::max(1, (int)std::ceil(COST_PER_METER * length));
+
+    // sample every half cell, so that consecutive footprints overlap
+    auto samples = std::max(1, (int)std::ceil(length / (0.5 * res)));
+    prim.poses.clear();
+    prim.cells.clear();
+    addSweptCells(start, prim.cells);
+    for (int i = 1; i <= samples; ++i) {
+        auto pose = i == samples ? end_pose : motion((double)i / (double)samples);
+        pose.theta = i == samples ?
+                headingAngle(prim.end_heading) : normalize_angle_positive(pose.theta);
+        prim.poses.push_back(pose);
+        addSweptCells(pose, prim.cells);
+    }
+    std::sort(begin(prim.cells), end(prim.cells));
+    prim.cells.erase(std::unique(begin(prim.cells), end(prim.cells)), end(prim.cells));
+    return true;
+}
+
+void XYThetaLattice::addSweptCells(
+    const Pose2D& pose,
+    std::vector<std::pair<int, int>>& cells) const
+{
+    RasterizeFootprint(m_params.footprint, pose, m_grid->resolution(), cells);
+}
+
+auto XYThetaLattice::coordToState(const int* coord) const -> RobotState
+{
+    double x, y, z;
+    m_grid->gridToWorld(coord[0], coord[1], m_grid_z, x, y, z);
+    return RobotState{ x, y, headingAngle(coord[2]) };
+}
+
+void XYThetaLattice::stateToCoord(const RobotState& state, int* coord) const
+{
+    int z;
+    m_grid->worldToGrid(state[0], state[1], m_params.height, coord[0], coord[1], z);
+    coord[2] = angleToHeading(state[2]);
+}
+
+int XYThetaLattice::getOrCreateState(const int* coord)
+{
+    auto state_id = m_coord_table.find(coord);
+    if (state_id >= 0) {
+        return state_id;
+    }
+
+    state_id = m_coord_table.insert(coord);
+    m_states.push_back(coordToState(coord));
+
+    // map planner state -> graph state, reusing the mapping left behind by a
+    // cleared state, if any
+    if (state_id < (int)StateID2IndexMapping.size()) {
+        int* pinds = StateID2IndexMapping[state_id];
+        std::fill(pinds, pinds + NUMOFINDICES_STATEID2IND, -1);
+    } else {
+        int* pinds = new int[NUMOFINDICES_STATEID2IND];
+        std::fill(pinds, pinds + NUMOFINDICES_STATEID2IND, -1);
+        StateID2IndexMapping.push_back(pinds);
+    }
+    return state_id;
+}
+
+bool XYThetaLattice::isGoal(const RobotState& state) const
+{
+    switch (goal().type) {
+    case GoalType::JOINT_STATE_GOAL:
+        return std::fabs(state[0] - goal().angles[0]) <= goal().angle_tolerances[0] &&
+                std::fabs(state[1] - goal().angles[1]) <= goal().angle_tolerances[1] &&
+                shortest_angle_dist(state[2], goal().angles[2]) <= goal().angle_tolerances[2];
+    case GoalType::XYZ_GOAL:
+    case GoalType::XYZ_RPY_GOAL:
+    {
+        auto& p = goal().pose.translation();
+        if (std::fabs(state[0] - p.x()) > goal().xyz_tolerance[0] ||
+            std::fabs(state[1] - p.y()) > goal().xyz_tolerance[1])
+        {
+            return false;
+        }
+        if (goal().type == GoalType::XYZ_GOAL) {
+            return true;
+        }
+        auto yaw = get_nearest_planar_rotation(Quaternion(goal().pose.rotation()));
+        return shortest_angle_dist(state[2], yaw) <= goal().rpy_tolerance[2];
+    }
+    default:
+        return false;
+    }
+}
+
+auto XYThetaLattice::stateAt(int x, int y, const Pose2D& offset) const
+    -> RobotState
+{
+    double wx, wy, wz;
+    m_grid->gridToWorld(x, y, m_grid_z, wx, wy, wz);
+    return RobotState{ wx + offset.x, wy + offset.y, normalize_angle_positive(offset.theta) };
+}
+
+} // namespace smpl
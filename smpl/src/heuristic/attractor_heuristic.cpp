@@ -31,10 +31,27 @@
 
 #include <smpl/heuristic/attractor_heuristic.h>
 
+// standard includes
+#include <algorithm>
+#include <cmath>
+
+// project includes
+#include <smpl/console/console.h>
 #include <smpl/occupancy_grid.h>
+#include <smpl/worker_pool.h>
 
 namespace smpl {
 
+static const char* LOG = "heuristic.attractor";
+
+// attraction per unit of distance to the attractor
+static const double AttractionScale = 1000.0;
+
+AttractorHeuristic::~AttractorHeuristic()
+{
+    // empty to allow forward declaration of WorkerPool
+}
+
 bool AttractorHeuristic::init(
     RobotPlanningSpace* space,
     const OccupancyGrid* grid)
@@ -49,9 +66,31 @@ bool AttractorHeuristic::init(
 
     m_grid = grid;
     m_ers = space->getExtension<ExtractRobotStateExtension>();
+    m_pp = space->getExtension<PointProjectionExtension>();
+    m_fk_iface = space->robot()->getExtension<ForwardKinematicsInterface>();
     return true;
 }
 
+/// Enable the precomputed workspace attractor field. Requires the planning
+/// space to project states to points and the robot model to provide forward
+/// kinematics. Takes effect on the next goal update.
+void AttractorHeuristic::setUseField(bool use)
+{
+    m_use_field = use;
+    if (!use) {
+        m_field = std::vector<int>();
+    }
+}
+
+/// Set the number of threads used to compute the attractor field.
+void AttractorHeuristic::setThreadCount(int count)
+{
+    m_thread_count = std::max(1, count);
+    if (m_pool && m_pool->numThreads() != m_thread_count) {
+        m_pool.reset();
+    }
+}
+
 double AttractorHeuristic::getMetricGoalDistance(double x, double y, double z)
 {
     return 0.0;
@@ -64,17 +103,41 @@ double AttractorHeuristic::getMetricStartDistance(double x, double y, double z)
 
 Extension* AttractorHeuristic::getExtension(size_t class_code)
 {
-    if (class_code == GetClassCode<RobotHeuristic>()) {
+    if (class_code == GetClassCode<RobotHeuristic>() ||
+        class_code == GetClassCode<MemoryUsageExtension>())
+    {
         return this;
     }
     return nullptr;
 }
 
+auto AttractorHeuristic::memoryUsage() const -> std::size_t
+{
+    return m_field.capacity() * sizeof(int);
+}
+
+void AttractorHeuristic::updateGoal(const GoalConstraint& goal)
+{
+    m_field.clear();
+    if (m_use_field) {
+        computeField();
+    }
+}
+
 int AttractorHeuristic::GetGoalHeuristic(int state_id)
 {
     if (state_id == planningSpace()->getGoalStateID()) {
         return 0;
     }
+
+    if (!m_field.empty()) {
+        Vector3 p;
+        if (!m_pp->projectToPoint(state_id, p)) {
+            return 0;
+        }
+        return fieldAttraction(p);
+    }
+
     if (!m_ers) {
         return 0;
     }
@@ -92,7 +155,7 @@ int AttractorHeuristic::GetGoalHeuristic(int state_id)
         double dj = (state[i] - m_attractor[i]);
         dsum += dj * dj;
     }
-    dsum = 1000.0 * std::sqrt(dsum);
+    dsum = AttractionScale * std::sqrt(dsum);
     return (int)dsum;
 }
 
@@ -106,4 +169,56 @@ int AttractorHeuristic::GetFromToHeuristic(int from_id, int to_id)
     return 0;
 }
 
+void AttractorHeuristic::computeField()
+{
+    if (!m_pp || !m_fk_iface) {
+        SMPL_WARN_NAMED(LOG, "Attractor field requires point projection and forward kinematics");
+        return;
+    }
+    if (m_attractor.size() != planningSpace()->robot()->jointVariableCount()) {
+        SMPL_WARN_NAMED(LOG, "Attractor has %zu variables, expected %zu", m_attractor.size(), planningSpace()->robot()->jointVariableCount());
+        return;
+    }
+
+    m_attractor_pos = m_fk_iface->computeFK(m_attractor).translation();
+
+    const int xc = m_grid->numCellsX();
+    const int yc = m_grid->numCellsY();
+    const int zc = m_grid->numCellsZ();
+    m_field.resize((size_t)xc * yc * zc);
+
+    if (!m_pool) {
+        m_pool.reset(new WorkerPool(m_thread_count));
+    }
+
+    // each work item fills one z slab of the field
+    m_pool->run(zc, [&](int tid, std::size_t z)
+    {
+        auto* slab = &m_field[z * xc * yc];
+        for (int y = 0; y < yc; ++y) {
+        for (int x = 0; x < xc; ++x) {
+            Vector3 p;
+            m_grid->gridToWorld(x, y, (int)z, p.x(), p.y(), p.z());
+            slab[y * xc + x] =
+                    (int)(AttractionScale * (p - m_attractor_pos).norm());
+        }
+        }
+    });
+
+    SMPL_DEBUG_NAMED(LOG, "Computed attractor field over %d x %d x %d cells", xc, yc, zc);
+}
+
+int AttractorHeuristic::fieldAttraction(const Vector3& p) const
+{
+    int gx, gy, gz;
+    m_grid->worldToGrid(p.x(), p.y(), p.z(), gx, gy, gz);
+    if (!m_grid->isInBounds(gx, gy, gz)) {
+        // points outside the grid fall back to the exact attraction
+        return (int)(AttractionScale * (p - m_attractor_pos).norm());
+    }
+    const int xc = m_grid->numCellsX();
+    const int yc = m_grid->numCellsY();
+    return m_field[((size_t)gz * yc + gy) * xc + gx];
+}
+
 } // namespace smpl
@@ -31,18 +31,80 @@
 
 #include <smpl/heuristic/bfs_heuristic.h>
 
+// standard includes
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <tuple>
+
 // project includes
 #include <smpl/bfs3d/bfs3d.h>
+#include <smpl/collision_checker.h>
 #include <smpl/console/console.h>
 #include <smpl/debug/marker_utils.h>
 #include <smpl/debug/colors.h>
 #include <smpl/grid/grid.h>
 #include <smpl/heap/intrusive_heap.h>
+#include <smpl/telemetry.h>
 
 namespace smpl {
 
 static const char* LOG = "heuristic.bfs";
 
+static
+bool operator==(const BfsSearchRegistry::Key& a, const BfsSearchRegistry::Key& b)
+{
+    return a.grid == b.grid &&
+            a.world_version == b.world_version &&
+            a.inflation_radius == b.inflation_radius &&
+            a.goal == b.goal;
+}
+
+auto BfsSearchRegistry::acquire(const Key& key, const SearchFactory& make)
+    -> std::shared_ptr<const BFS_3D16>
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // drop the searches no heuristic holds any more while looking for the key
+    std::shared_ptr<const BFS_3D16> search;
+    for (auto it = begin(m_searches); it != end(m_searches); ) {
+        auto held = it->second.lock();
+        if (!held) {
+            it = m_searches.erase(it);
+            continue;
+        }
+        if (!search && it->first == key) {
+            search = std::move(held);
+        }
+        ++it;
+    }
+
+    if (search) {
+        SMPL_DEBUG_NAMED(LOG, "Share BFS for %zu goal cells", key.goal.size() / 3);
+        return search;
+    }
+
+    // run the search with the registry locked, so that concurrent requests
+    // for the same key wait for it rather than searching again
+    search = make();
+    if (search) {
+        m_searches.emplace_back(key, search);
+    }
+    return search;
+}
+
+int BfsSearchRegistry::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int count = 0;
+    for (auto& entry : m_searches) {
+        if (!entry.second.expired()) {
+            ++count;
+        }
+    }
+    return count;
+}
+
 BfsHeuristic::~BfsHeuristic()
 {
     // empty to allow forward declaration of BFS_3D
@@ -74,11 +136,46 @@ void BfsHeuristic::setInflationRadius(double radius)
     m_inflation_radius = radius;
 }
 
+void BfsHeuristic::setLazy(bool lazy)
+{
+    m_lazy = lazy;
+    if (m_bfs) {
+        m_bfs->setLazy(lazy);
+    }
+}
+
+void BfsHeuristic::setGoalCacheSize(int size)
+{
+    m_goal_cache_size = std::max(0, size);
+    while (m_goal_cache.size() > (size_t)m_goal_cache_size) {
+        m_goal_cache.pop_back();
+    }
+}
+
+void BfsHeuristic::setGoalCacheCompression(bool compress)
+{
+    m_compress_goal_cache = compress;
+}
+
+void BfsHeuristic::setSearchRegistry(BfsSearchRegistry* registry)
+{
+    m_registry = registry;
+}
+
 void BfsHeuristic::setCostPerCell(int cost_per_cell)
 {
     m_cost_per_cell = cost_per_cell;
 }
 
+/// Set the number of threads used to propagate distances from the goal.
+void BfsHeuristic::setThreadCount(int count)
+{
+    m_thread_count = count;
+    if (m_bfs) {
+        m_bfs->setThreadCount(count);
+    }
+}
+
 void BfsHeuristic::updateGoal(const GoalConstraint& goal)
 {
     switch (goal.type) {
@@ -104,20 +201,25 @@ void BfsHeuristic::updateGoal(const GoalConstraint& goal)
             break;
         }
 
-        m_goal_cells.emplace_back(gx, gy, gz);
+        m_goal_cells.clear();
+        if (goal.type == GoalType::JOINT_STATE_GOAL) {
+            m_goal_cells.emplace_back(gx, gy, gz);
+        } else {
+            addGoalRegion(goal.pose.translation(), goal.xyz_tolerance);
+        }
 
-        m_bfs->run(gx, gy, gz);
+        runGoalSearch();
         break;
     }
     case GoalType::MULTIPLE_POSE_GOAL:
     {
-        std::vector<int> cell_coords;
+        m_goal_cells.clear();
         for (auto& goal_pose : goal.poses) {
             int gx, gy, gz;
             grid()->worldToGrid(
-                    goal.pose.translation()[0],
-                    goal.pose.translation()[1],
-                    goal.pose.translation()[2],
+                    goal_pose.translation()[0],
+                    goal_pose.translation()[1],
+                    goal_pose.translation()[2],
                     gx, gy, gz);
 
             SMPL_DEBUG_NAMED(LOG, "Setting the BFS heuristic goal (%d, %d, %d)", gx, gy, gz);
@@ -127,13 +229,9 @@ void BfsHeuristic::updateGoal(const GoalConstraint& goal)
                 continue;
             }
 
-            cell_coords.push_back(gx);
-            cell_coords.push_back(gy);
-            cell_coords.push_back(gz);
-
-            m_goal_cells.emplace_back(gx, gy, gz);
+            addGoalRegion(goal_pose.translation(), goal.xyz_tolerance);
         }
-        m_bfs->run(begin(cell_coords), end(cell_coords));
+        runGoalSearch();
         break;
     }
     case GoalType::USER_GOAL_CONSTRAINT_FN:
@@ -143,6 +241,83 @@ void BfsHeuristic::updateGoal(const GoalConstraint& goal)
     }
 }
 
+/// Add the cell containing a goal position to the goal cells, along with the
+/// free cells whose centers lie within the position tolerance of the goal.
+void BfsHeuristic::addGoalRegion(const Vector3& pos, const double tolerance[3])
+{
+    int gx, gy, gz;
+    grid()->worldToGrid(pos.x(), pos.y(), pos.z(), gx, gy, gz);
+    m_goal_cells.emplace_back(gx, gy, gz);
+
+    // treat invalid tolerances as none
+    double tol[3];
+    for (int i = 0; i < 3; ++i) {
+        tol[i] = tolerance[i] > 0.0 ? tolerance[i] : 0.0;
+    }
+
+    int min[3], max[3];
+    grid()->worldToGrid(
+            pos.x() - tol[0], pos.y() - tol[1], pos.z() - tol[2],
+            min[0], min[1], min[2]);
+    grid()->worldToGrid(
+            pos.x() + tol[0], pos.y() + tol[1], pos.z() + tol[2],
+            max[0], max[1], max[2]);
+    const int cells[3] = {
+        grid()->numCellsX(), grid()->numCellsY(), grid()->numCellsZ()
+    };
+    for (int i = 0; i < 3; ++i) {
+        min[i] = std::max(min[i], 0);
+        max[i] = std::min(max[i], cells[i] - 1);
+    }
+
+    for (int x = min[0]; x <= max[0]; ++x) {
+    for (int y = min[1]; y <= max[1]; ++y) {
+    for (int z = min[2]; z <= max[2]; ++z) {
+        if (x == gx && y == gy && z == gz) {
+            continue;
+        }
+        if (m_bfs->isWall(x, y, z)) {
+            continue;
+        }
+        double wx, wy, wz;
+        grid()->gridToWorld(x, y, z, wx, wy, wz);
+        if (std::fabs(wx - pos.x()) <= tol[0] &&
+            std::fabs(wy - pos.y()) <= tol[1] &&
+            std::fabs(wz - pos.z()) <= tol[2])
+        {
+            m_goal_cells.emplace_back(x, y, z);
+        }
+    }
+    }
+    }
+}
+
+/// Run the search from the goal cells, once each.
+void BfsHeuristic::runGoalSearch()
+{
+    auto less = [](const CellCoord& a, const CellCoord& b) {
+        return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z);
+    };
+    auto equal = [](const CellCoord& a, const CellCoord& b) {
+        return a.x == b.x && a.y == b.y && a.z == b.z;
+    };
+    std::sort(begin(m_goal_cells), end(m_goal_cells), less);
+    m_goal_cells.erase(
+            std::unique(begin(m_goal_cells), end(m_goal_cells), equal),
+            end(m_goal_cells));
+
+    SMPL_DEBUG_NAMED(LOG, "Seed the BFS with %zu goal cells", m_goal_cells.size());
+
+    std::vector<int> cell_coords;
+    cell_coords.reserve(3 * m_goal_cells.size());
+    for (auto& cell : m_goal_cells) {
+        cell_coords.push_back(cell.x);
+        cell_coords.push_back(cell.y);
+        cell_coords.push_back(cell.z);
+    }
+    runSearch(cell_coords);
+}
+
 double BfsHeuristic::getMetricStartDistance(double x, double y, double z)
 {
     int start_id = planningSpace()->getStartStateID();
@@ -173,21 +348,46 @@ double BfsHeuristic::getMetricGoalDistance(double x, double y, double z)
 {
     int gx, gy, gz;
     grid()->worldToGrid(x, y, z, gx, gy, gz);
-    if (!m_bfs->inBounds(gx, gy, gz)) {
+    if (!bfs().inBounds(gx, gy, gz)) {
         return (double)BFS_3D::WALL * grid()->resolution();
     } else {
-        return (double)m_bfs->getDistance(gx, gy, gz) * grid()->resolution();
+        return (double)bfs().getDistance(gx, gy, gz) * grid()->resolution();
     }
 }
 
 Extension* BfsHeuristic::getExtension(size_t class_code)
 {
-    if (class_code == GetClassCode<RobotHeuristic>()) {
+    if (class_code == GetClassCode<RobotHeuristic>() ||
+        class_code == GetClassCode<MemoryUsageExtension>() ||
+        class_code == GetClassCode<CancellationExtension>())
+    {
         return this;
     }
     return nullptr;
 }
 
+void BfsHeuristic::setCancellationToken(const CancellationToken* token)
+{
+    m_cancel = token;
+    if (m_bfs) {
+        m_bfs->setCancellationToken(token);
+    }
+}
+
+auto BfsHeuristic::memoryUsage() const -> std::size_t
+{
+    auto usage = m_bfs ? m_bfs->memoryUsage() : 0;
+    usage += MemoryUsage(m_goal_cells);
+    usage += MemoryUsage(m_search_goal);
+    for (auto& search : m_goal_cache) {
+        usage += sizeof(search);
+        usage += MemoryUsage(search.goal);
+        usage += MemoryUsage(search.distances);
+        usage += MemoryUsage(search.runs);
+    }
+    return usage;
+}
+
 int BfsHeuristic::GetGoalHeuristic(int state_id)
 {
     if (m_pp == NULL) {
@@ -202,7 +402,7 @@ int BfsHeuristic::GetGoalHeuristic(int state_id)
     Eigen::Vector3i dp;
     grid()->worldToGrid(p.x(), p.y(), p.z(), dp.x(), dp.y(), dp.z());
 
-    return getBfsCostToGoal(*m_bfs, dp.x(), dp.y(), dp.z());
+    return getBfsCostToGoal(bfs(), dp.x(), dp.y(), dp.z());
 }
 
 int BfsHeuristic::GetStartHeuristic(int state_id)
@@ -231,7 +431,7 @@ auto BfsHeuristic::getWallsVisualization() const -> visual::Marker
     for (int x = 0; x < dimX; x++) {
     for (int y = 0; y < dimY; y++) {
     for (int z = 0; z < dimZ; z++) {
-        if (m_bfs->isWall(x, y, z)) {
+        if (bfs().isWall(x, y, z)) {
             Vector3 p;
             grid()->gridToWorld(x, y, z, p.x(), p.y(), p.z());
             centers.push_back(p);
@@ -260,7 +460,7 @@ auto BfsHeuristic::getValuesVisualization() -> visual::Marker
 {
     bool all_invalid = true;
     for (auto& cell : m_goal_cells) {
-        if (!m_bfs->isWall(cell.x, cell.y, cell.z)) {
+        if (!bfs().isWall(cell.x, cell.y, cell.z)) {
             all_invalid = false;
             break;
         }
@@ -302,7 +502,7 @@ auto BfsHeuristic::getValuesVisualization() -> visual::Marker
     std::queue<CostCell> cells;
     Grid3<bool> visited(grid()->numCellsX(), grid()->numCellsY(), grid()->numCellsZ(), false);
     for (auto& cell : m_goal_cells) {
-        if (!m_bfs->isWall(cell.x, cell.y, cell.z)) {
+        if (!bfs().isWall(cell.x, cell.y, cell.z)) {
             visited(cell.x, cell.y, cell.z) = true;
             cells.push({ cell.x, cell.y, cell.z, 0 });
         }
@@ -344,7 +544,7 @@ auto BfsHeuristic::getValuesVisualization() -> visual::Marker
 
 //        visited(c.x, c.y, c.z) = true;
 
-        const int d = m_cost_per_cell * m_bfs->getDistance(c.x, c.y, c.z);
+        const int d = m_cost_per_cell * bfs().getDistance(c.x, c.y, c.z);
 
         for (int dx = -1; dx <= 1; ++dx) {
         for (int dy = -1; dy <= 1; ++dy) {
@@ -358,7 +558,7 @@ auto BfsHeuristic::getValuesVisualization() -> visual::Marker
             int sz = c.z + dz;
 
             // check if neighbor is valid
-            if (!m_bfs->inBounds(sx, sy, sz) || m_bfs->isWall(sx, sy, sz)) {
+            if (!bfs().inBounds(sx, sy, sz) || bfs().isWall(sx, sy, sz)) {
                 continue;
             }
 
@@ -369,7 +569,7 @@ auto BfsHeuristic::getValuesVisualization() -> visual::Marker
 
             visited(sx, sy, sz) = true;
 
-            int dd = m_cost_per_cell * m_bfs->getDistance(sx, sy, sz);
+            int dd = m_cost_per_cell * bfs().getDistance(sx, sy, sz);
             cells.push({sx, sy, sz, dd});
         }
         }
@@ -384,13 +584,57 @@ auto BfsHeuristic::getValuesVisualization() -> visual::Marker
             "bfs_values");
 }
 
-void BfsHeuristic::syncGridAndBfs()
+void BfsHeuristic::updateWalls()
+{
+    const int xc = grid()->numCellsX();
+    const int yc = grid()->numCellsY();
+    const int zc = grid()->numCellsZ();
+    std::vector<int> added;
+    std::vector<int> removed;
+    for (int x = 0; x < xc; ++x) {
+    for (int y = 0; y < yc; ++y) {
+    for (int z = 0; z < zc; ++z) {
+        const bool wall = grid()->getDistance(x, y, z) <= m_inflation_radius;
+        if (wall != m_bfs->isWall(x, y, z)) {
+            auto& changed = wall ? added : removed;
+            changed.push_back(x);
+            changed.push_back(y);
+            changed.push_back(z);
+        }
+    }
+    }
+    }
+
+    SMPL_DEBUG_NAMED(LOG, "Update BFS walls (%zu added, %zu removed)", added.size() / 3, removed.size() / 3);
+
+    if (added.empty() && removed.empty()) {
+        return;
+    }
+
+    m_bfs->updateWalls(added, removed);
+
+    // the cached searches were for the old walls; the repaired search is
+    // cached on the next goal change
+    m_goal_cache.clear();
+    m_search_cached = false;
+
+    // so was a shared search, and m_bfs holds no search for its goal
+    if (m_shared && !acquireSharedSearch(m_search_goal)) {
+        m_bfs->run(begin(m_search_goal), end(m_search_goal));
+        m_search_cached = false;
+    }
+}
+
+/// Create a BFS with walls at the cells of the occupancy grid within the
+/// inflation radius of an obstacle.
+auto BfsHeuristic::makeBfs() const -> std::unique_ptr<BFS_3D16>
 {
     const int xc = grid()->numCellsX();
     const int yc = grid()->numCellsY();
     const int zc = grid()->numCellsZ();
 //    SMPL_DEBUG_NAMED(LOG, "Initializing BFS of size %d x %d x %d = %d", xc, yc, zc, xc * yc * zc);
-    m_bfs.reset(new BFS_3D(xc, yc, zc));
+    std::unique_ptr<BFS_3D16> bfs(new BFS_3D16(xc, yc, zc));
+    bfs->setThreadCount(m_thread_count);
     const int cell_count = xc * yc * zc;
     int wall_count = 0;
     for (int x = 0; x < xc; ++x) {
@@ -398,7 +642,7 @@ void BfsHeuristic::syncGridAndBfs()
     for (int z = 0; z < zc; ++z) {
         const double radius = m_inflation_radius;
         if (grid()->getDistance(x, y, z) <= radius) {
-            m_bfs->setWall(x, y, z);
+            bfs->setWall(x, y, z);
             ++wall_count;
         }
     }
@@ -406,9 +650,201 @@ void BfsHeuristic::syncGridAndBfs()
     }
 
     SMPL_DEBUG_NAMED(LOG, "%d/%d (%0.3f%%) walls in the bfs heuristic", wall_count, cell_count, 100.0 * (double)wall_count / cell_count);
+    return bfs;
+}
+
+void BfsHeuristic::syncGridAndBfs()
+{
+    m_bfs = makeBfs();
+    m_bfs->setCancellationToken(m_cancel);
+    m_bfs->setLazy(m_lazy);
+    m_shared.reset();
+    m_goal_cache.clear();
+    m_search_goal.clear();
+    m_search_cached = true;
+}
+
+/// Hold the search for a set of goal cells from the registry, running it if
+/// no other heuristic holds it. Return false if the search can not be shared.
+bool BfsHeuristic::acquireSharedSearch(const std::vector<int>& goal)
+{
+    m_shared.reset();
+
+    if (m_registry == NULL || m_lazy) {
+        return false;
+    }
+
+    auto* checker = planningSpace()->collisionChecker();
+    auto* wver = checker != NULL ?
+            checker->getExtension<CollisionWorldVersionExtension>() : NULL;
+    if (wver == NULL) {
+        SMPL_WARN_ONCE("BFS searches are only shared with a collision checker that provides CollisionWorldVersionExtension");
+        return false;
+    }
+
+    BfsSearchRegistry::Key key;
+    key.grid = grid();
+    key.world_version = wver->worldVersion();
+    key.inflation_radius = m_inflation_radius;
+    key.goal = goal;
+    m_shared = m_registry->acquire(key, [&]()
+    {
+        std::shared_ptr<BFS_3D16> search(makeBfs());
+        search->run(begin(goal), end(goal));
+        return search;
+    });
+
+    m_search_goal = goal;
+    m_search_cached = true;
+    return true;
+}
+
+/// Run-length encode a distance grid as (value, count) pairs of 16-bit words.
+/// Walls and undiscovered cells are mapped to the two largest values. Return
+/// false if a distance is too large to fit.
+static bool CompressDistances(
+    const std::vector<int>& distances,
+    std::vector<std::uint16_t>& runs)
+{
+    const std::uint16_t wall_value = 0xFFFF;
+    const std::uint16_t undiscovered_value = 0xFFFE;
+    const std::uint16_t max_count = 0xFFFF;
+
+    runs.clear();
+    for (size_t i = 0; i < distances.size(); ) {
+        std::uint16_t value;
+        if (distances[i] == BFS_3D::WALL) {
+            value = wall_value;
+        } else if (distances[i] == BFS_3D::UNDISCOVERED) {
+            value = undiscovered_value;
+        } else if (distances[i] < undiscovered_value) {
+            value = (std::uint16_t)distances[i];
+        } else {
+            runs.clear();
+            return false;
+        }
+
+        size_t count = 1;
+        while (i + count < distances.size() &&
+                distances[i + count] == distances[i] &&
+                count < max_count)
+        {
+            ++count;
+        }
+
+        runs.push_back(value);
+        runs.push_back((std::uint16_t)count);
+        i += count;
+    }
+
+    runs.shrink_to_fit();
+    return true;
+}
+
+static void DecompressDistances(
+    const std::vector<std::uint16_t>& runs,
+    std::vector<int>& distances)
+{
+    distances.clear();
+    for (size_t i = 0; i + 1 < runs.size(); i += 2) {
+        int value;
+        if (runs[i] == 0xFFFF) {
+            value = BFS_3D::WALL;
+        } else if (runs[i] == 0xFFFE) {
+            value = BFS_3D::UNDISCOVERED;
+        } else {
+            value = runs[i];
+        }
+        distances.insert(distances.end(), runs[i + 1], value);
+    }
+}
+
+/// Store the search in m_bfs in the goal cache, if it is not there already,
+/// evicting the least recently used searches beyond the cache size.
+void BfsHeuristic::cacheSearch()
+{
+    // copying a lazy search would complete it
+    if (m_goal_cache_size <= 0 || m_search_cached || m_bfs->lazy()) {
+        return;
+    }
+
+    CachedSearch search;
+    search.goal = m_search_goal;
+    m_bfs->copyDistances(search.distances);
+    if (m_compress_goal_cache &&
+        CompressDistances(search.distances, search.runs))
+    {
+        std::vector<int>().swap(search.distances);
+    }
+
+    m_goal_cache.push_front(std::move(search));
+    while (m_goal_cache.size() > (size_t)m_goal_cache_size) {
+        m_goal_cache.pop_back();
+    }
+    m_search_cached = true;
+}
+
+/// Restore the cached search for a set of goal cells into m_bfs.
+bool BfsHeuristic::restoreSearch(const std::vector<int>& goal)
+{
+    for (auto it = begin(m_goal_cache); it != end(m_goal_cache); ++it) {
+        if (it->goal != goal) {
+            continue;
+        }
+
+        bool restored;
+        if (!it->runs.empty()) {
+            std::vector<int> distances;
+            DecompressDistances(it->runs, distances);
+            restored = m_bfs->restoreDistances(distances);
+        } else {
+            restored = m_bfs->restoreDistances(it->distances);
+        }
+
+        if (!restored) {
+            m_goal_cache.erase(it);
+            return false;
+        }
+
+        m_goal_cache.splice(begin(m_goal_cache), m_goal_cache, it);
+        m_search_goal = goal;
+        m_search_cached = true;
+        return true;
+    }
+
+    return false;
+}
+
+void BfsHeuristic::runSearch(const std::vector<int>& goal)
+{
+    if (m_goal_cache_size > 0 && !goal.empty() && goal == m_search_goal) {
+        SMPL_DEBUG_NAMED(LOG, "Reuse BFS for the current goal");
+        TelemetryCount(TelemetryEvent::HeuristicCacheHit);
+        return;
+    }
+
+    // keep the finished search for the previous goal around
+    cacheSearch();
+
+    if (acquireSharedSearch(goal)) {
+        return;
+    }
+
+    if (restoreSearch(goal)) {
+        SMPL_DEBUG_NAMED(LOG, "Restored BFS for %zu goal cells from the cache", goal.size() / 3);
+        TelemetryCount(TelemetryEvent::HeuristicCacheHit);
+        return;
+    }
+
+    if (m_goal_cache_size > 0) {
+        TelemetryCount(TelemetryEvent::HeuristicCacheMiss);
+    }
+    m_bfs->run(begin(goal), end(goal));
+    m_search_goal = goal;
+    m_search_cached = false;
 }
 
-int BfsHeuristic::getBfsCostToGoal(const BFS_3D& bfs, int x, int y, int z) const
+int BfsHeuristic::getBfsCostToGoal(const BFS_3D16& bfs, int x, int y, int z) const
 {
     if (!bfs.inBounds(x, y, z)) {
         return Infinity;
@@ -0,0 +1,322 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+
+#include <smpl/heuristic/dubins_heuristic.h>
+
+// standard includes
+#include <cmath>
+
+// project includes
+#include <smpl/angles.h>
+#include <smpl/console/console.h>
+#include <smpl/unicycle/dubins.h>
+
+namespace smpl {
+
+static const char* LOG = "heuristic.dubins";
+
+bool DubinsHeuristic::init(RobotPlanningSpace* space)
+{
+    if (!RobotHeuristic::init(space)) {
+        return false;
+    }
+
+    m_pose_ext = space->getExtension<PoseProjectionExtension>();
+    if (m_pose_ext == NULL) {
+        SMPL_WARN_NAMED(LOG, "DubinsHeuristic requires PoseProjectionExtension");
+        return false;
+    }
+
+    return true;
+}
+
+void DubinsHeuristic::setTurningRadius(double radius)
+{
+    if (radius <= 0.0) {
+        SMPL_WARN_NAMED(LOG, "Turning radius must be positive");
+        return;
+    }
+    if (radius != m_radius) {
+        m_radius = radius;
+        // table values scale linearly with the radius, but the poses they
+        // were sampled at do not, so the table must be rebuilt
+        if (hasLookupTable()) {
+            setLookupTable(m_table_extent, m_table_res, m_table_headings);
+        }
+    }
+}
+
+bool DubinsHeuristic::setLookupTable(
+    double half_extent,
+    double res,
+    int num_headings)
+{
+    if (half_extent <= 0.0 || res <= 0.0 || num_headings <= 0) {
+        SMPL_WARN_NAMED(LOG, "Invalid lookup table dimensions (extent = %f, res = %f, headings = %d)", half_extent, res, num_headings);
+        return false;
+    }
+
+    auto width = (int)std::round(2.0 * half_extent / res) + 1;
+    auto row_size = (size_t)width * (size_t)num_headings;
+
+    m_table_extent = half_extent;
+    m_table_res = res;
+    m_table_width = width;
+    m_table_headings = num_headings;
+    m_table.resize((size_t)width * row_size);
+
+    SMPL_INFO_NAMED(LOG, "Build %d x %d x %d Dubins lookup table (%zu bytes)", width, width, num_headings, m_table.size() * sizeof(float));
+
+    // evaluate one row of constant x at a time, from start poses sampled in
+    // the goal frame to the origin
+    std::vector<double> sx(row_size);
+    std::vector<double> sy(row_size);
+    std::vector<double> sth(row_size);
+    std::vector<double> zeros(row_size, 0.0);
+    std::vector<double> dist(row_size);
+    for (int ix = 0; ix < width; ++ix) {
+        auto x = -half_extent + ix * res;
+        for (int iy = 0; iy < width; ++iy) {
+            auto y = -half_extent + iy * res;
+            for (int ih = 0; ih < num_headings; ++ih) {
+                auto i = (size_t)iy * num_headings + ih;
+                sx[i] = x;
+                sy[i] = y;
+                sth[i] = 2.0 * M_PI * ih / num_headings;
+            }
+        }
+
+        ComputeDubinsDistances(
+                sx.data(), sy.data(), sth.data(),
+                zeros.data(), zeros.data(), zeros.data(),
+                m_radius, row_size, dist.data());
+
+        auto* row = &m_table[(size_t)ix * row_size];
+        for (size_t i = 0; i < row_size; ++i) {
+            row[i] = (float)dist[i];
+        }
+    }
+
+    return true;
+}
+
+void DubinsHeuristic::clearLookupTable()
+{
+    m_table.clear();
+    m_table.shrink_to_fit();
+    m_table_width = 0;
+    m_table_headings = 0;
+}
+
+double DubinsHeuristic::dubinsDistance(const Pose2D& from, const Pose2D& to) const
+{
+    double dist;
+    if (lookupDistance(from, to, dist)) {
+        return dist;
+    }
+    return ComputeDubinsDistance(from, to, m_radius);
+}
+
+void DubinsHeuristic::getGoalHeuristics(
+    const int* state_ids,
+    size_t count,
+    int* values)
+{
+    auto goal_id = planningSpace()->getGoalStateID();
+    auto goal = goalPose2D();
+
+    // resolve the states that hit the lookup table (or need no distance at
+    // all) immediately and gather the rest for one batched evaluation
+    m_batch_sx.clear();
+    m_batch_sy.clear();
+    m_batch_sth.clear();
+    m_batch_index.clear();
+    for (size_t i = 0; i < count; ++i) {
+        if (state_ids[i] == goal_id) {
+            values[i] = 0;
+            continue;
+        }
+
+        Pose2D p;
+        if (!projectToPose2D(state_ids[i], p)) {
+            values[i] = 0;
+            continue;
+        }
+
+        double dist;
+        if (lookupDistance(p, goal, dist)) {
+            values[i] = toHeuristic(dist);
+            continue;
+        }
+
+        m_batch_sx.push_back(p.x);
+        m_batch_sy.push_back(p.y);
+        m_batch_sth.push_back(p.theta);
+        m_batch_index.push_back(i);
+    }
+
+    auto n = m_batch_index.size();
+    if (n == 0) {
+        return;
+    }
+
+    m_batch_gx.assign(n, goal.x);
+    m_batch_gy.assign(n, goal.y);
+    m_batch_gth.assign(n, goal.theta);
+    m_batch_dist.resize(n);
+
+    ComputeDubinsDistances(
+            m_batch_sx.data(), m_batch_sy.data(), m_batch_sth.data(),
+            m_batch_gx.data(), m_batch_gy.data(), m_batch_gth.data(),
+            m_radius, n, m_batch_dist.data());
+
+    for (size_t i = 0; i < n; ++i) {
+        values[m_batch_index[i]] = toHeuristic(m_batch_dist[i]);
+    }
+}
+
+double DubinsHeuristic::getMetricGoalDistance(double x, double y, double z)
+{
+    auto& goal_pose = planningSpace()->goal().pose;
+    const double dx = goal_pose.translation()[0] - x;
+    const double dy = goal_pose.translation()[1] - y;
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+double DubinsHeuristic::getMetricStartDistance(double x, double y, double z)
+{
+    return 0.0;
+}
+
+Extension* DubinsHeuristic::getExtension(size_t class_code)
+{
+    if (class_code == GetClassCode<RobotHeuristic>()) {
+        return this;
+    }
+    return nullptr;
+}
+
+int DubinsHeuristic::GetGoalHeuristic(int state_id)
+{
+    if (state_id == planningSpace()->getGoalStateID()) {
+        return 0;
+    }
+
+    Pose2D p;
+    if (!projectToPose2D(state_id, p)) {
+        return 0;
+    }
+
+    auto h = toHeuristic(dubinsDistance(p, goalPose2D()));
+    SMPL_DEBUG_NAMED(LOG, "h(%0.3f, %0.3f, %0.3f) = %d", p.x, p.y, p.theta, h);
+    return h;
+}
+
+int DubinsHeuristic::GetStartHeuristic(int state_id)
+{
+    return 0;
+}
+
+int DubinsHeuristic::GetFromToHeuristic(int from_id, int to_id)
+{
+    if (from_id == to_id) {
+        return 0;
+    }
+
+    Pose2D from, to;
+    if (!projectToPose2D(from_id, from) || !projectToPose2D(to_id, to)) {
+        return 0;
+    }
+    return toHeuristic(dubinsDistance(from, to));
+}
+
+bool DubinsHeuristic::projectToPose2D(int state_id, Pose2D& pose) const
+{
+    if (state_id == planningSpace()->getGoalStateID()) {
+        pose = goalPose2D();
+        return true;
+    }
+
+    Affine3 p;
+    if (!m_pose_ext->projectToPose(state_id, p)) {
+        return false;
+    }
+
+    double Y, P, R;
+    angles::get_euler_zyx(p.rotation(), Y, P, R);
+    pose = Pose2D(p.translation().x(), p.translation().y(), Y);
+    return true;
+}
+
+auto DubinsHeuristic::goalPose2D() const -> Pose2D
+{
+    auto& goal_pose = planningSpace()->goal().pose;
+    double Y, P, R;
+    angles::get_euler_zyx(goal_pose.rotation(), Y, P, R);
+    return Pose2D(goal_pose.translation().x(), goal_pose.translation().y(), Y);
+}
+
+bool DubinsHeuristic::lookupDistance(
+    const Pose2D& from,
+    const Pose2D& to,
+    double& dist) const
+{
+    if (m_table.empty()) {
+        return false;
+    }
+
+    // express the start pose in the frame of the goal pose
+    auto c = std::cos(to.theta);
+    auto s = std::sin(to.theta);
+    auto dx = from.x - to.x;
+    auto dy = from.y - to.y;
+    auto rx = c * dx + s * dy;
+    auto ry = -s * dx + c * dy;
+    auto rth = angles::normalize_angle_positive(from.theta - to.theta);
+
+    auto ix = (int)std::lround((rx + m_table_extent) / m_table_res);
+    auto iy = (int)std::lround((ry + m_table_extent) / m_table_res);
+    if (ix < 0 || ix >= m_table_width || iy < 0 || iy >= m_table_width) {
+        return false;
+    }
+    auto ih = (int)std::lround(rth * m_table_headings / (2.0 * M_PI));
+    ih %= m_table_headings;
+
+    auto row_size = (size_t)m_table_width * (size_t)m_table_headings;
+    dist = (double)m_table[(size_t)ix * row_size + (size_t)iy * m_table_headings + ih];
+    return true;
+}
+
+int DubinsHeuristic::toHeuristic(double dist) const
+{
+    return (int)(FIXED_POINT_RATIO * dist);
+}
+
+} // namespace smpl
@@ -126,12 +126,39 @@ void DijkstraEgraphHeuristic3D::setInflationRadius(double radius)
     m_inflation_radius = radius;
 }
 
+void DijkstraEgraphHeuristic3D::setSnapRadius(double radius)
+{
+    m_snap_radius = radius;
+}
+
+void DijkstraEgraphHeuristic3D::setThreadCount(int count)
+{
+    if (count <= 1) {
+        m_pool.reset();
+    } else {
+        m_pool.reset(new WorkerPool(count));
+    }
+}
+
 void DijkstraEgraphHeuristic3D::getEquivalentStates(
     int state_id,
     std::vector<int>& ids)
 {
     Vector3 p;
     m_pp->projectToPoint(state_id, p);
+
+    if (m_snap_radius > 0.0) {
+        std::vector<std::size_t> nodes;
+        m_node_index.radius(p.data(), m_snap_radius, nodes);
+        for (auto n : nodes) {
+            int id = m_eg->getStateID(n);
+            if (id != state_id) {
+                ids.push_back(id);
+            }
+        }
+        return;
+    }
+
     Eigen::Vector3i dp;
     grid()->worldToGrid(p.x(), p.y(), p.z(), dp.x(), dp.y(), dp.z());
     if (!grid()->isInBounds(dp.x(), dp.y(), dp.z())) {
@@ -152,6 +179,20 @@ void DijkstraEgraphHeuristic3D::getEquivalentStates(
     }
 }
 
+// The projection and the lazily-expanded distance grid both depend on the
+// experience graph, so rebuild them against the current goal.
+void DijkstraEgraphHeuristic3D::experienceGraphExtended(
+    ExperienceGraph::node_id first_node,
+    ExperienceGraph::edge_id first_edge)
+{
+    if (m_projected_nodes.empty()) {
+        // no goal set yet
+        return;
+    }
+
+    updateGoal(planningSpace()->goal());
+}
+
 void DijkstraEgraphHeuristic3D::getShortcutSuccs(
     int state_id,
     std::vector<int>& shortcut_ids)
@@ -309,25 +350,58 @@ double DijkstraEgraphHeuristic3D::getMetricGoalDistance(double x, double y, doub
 
 Extension* DijkstraEgraphHeuristic3D::getExtension(size_t class_code)
 {
-    if (class_code == GetClassCode<ExperienceGraphHeuristicExtension>()) {
+    if (class_code == GetClassCode<ExperienceGraphHeuristicExtension>() ||
+        class_code == GetClassCode<MemoryUsageExtension>())
+    {
         return this;
     }
     return nullptr;
 }
 
+auto DijkstraEgraphHeuristic3D::memoryUsage() const -> std::size_t
+{
+    auto usage = m_dist_grid.size() * sizeof(Cell);
+    // the open list stores a pointer to each open cell
+    usage += m_open.size() * sizeof(Cell*);
+    usage += MemoryUsage(m_projected_nodes);
+    usage += MemoryUsage(m_projected_points);
+    usage += MemoryUsage(m_component_ids);
+    usage += MemoryUsage(m_component_nodes);
+    usage += MemoryUsage(m_shortcut_nodes);
+    // approximate the hash table by its buckets and one node per entry
+    usage += m_heur_nodes.bucket_count() * sizeof(void*);
+    usage += m_heur_nodes.size() *
+            (sizeof(decltype(m_heur_nodes)::value_type) + sizeof(void*));
+    for (auto& entry : m_heur_nodes) {
+        usage += MemoryUsage(entry.second.up_nodes);
+        usage += MemoryUsage(entry.second.edges);
+    }
+    return usage;
+}
+
 void DijkstraEgraphHeuristic3D::updateGoal(const GoalConstraint& goal)
 {
     SMPL_INFO_NAMED(LOG, "Update EGraphBfsHeuristic goal");
 
-    // reset all distances
-    for (size_t x = 1; x < m_dist_grid.xsize() - 1; ++x) {
-    for (size_t y = 1; y < m_dist_grid.ysize() - 1; ++y) {
-    for (size_t z = 1; z < m_dist_grid.zsize() - 1; ++z) {
-        auto& c = m_dist_grid(x, y, z);
-        if (c.dist != Wall) {
-            c.dist = Unknown;
+    // reset all distances, one x-slab per work item
+    auto reset_slab = [&](int tid, std::size_t i) {
+        const size_t x = i + 1;
+        for (size_t y = 1; y < m_dist_grid.ysize() - 1; ++y) {
+        for (size_t z = 1; z < m_dist_grid.zsize() - 1; ++z) {
+            auto& c = m_dist_grid(x, y, z);
+            if (c.dist != Wall) {
+                c.dist = Unknown;
+            }
+        } }
+    };
+    const size_t slab_count = m_dist_grid.xsize() - 2;
+    if (m_pool) {
+        m_pool->run(slab_count, reset_slab);
+    } else {
+        for (size_t i = 0; i < slab_count; ++i) {
+            reset_slab(0, i);
         }
-    } } }
+    }
 
     projectExperienceGraph();
 
@@ -338,33 +412,7 @@ void DijkstraEgraphHeuristic3D::updateGoal(const GoalConstraint& goal)
 
     // precompute shortcuts
     assert(m_component_ids.size() == m_eg->getExperienceGraph()->num_nodes());
-    auto* eg = m_eg->getExperienceGraph();
-    auto nodes = eg->nodes();
-    for (auto nit = nodes.first; nit != nodes.second; ++nit) {
-        auto comp_id = m_component_ids[*nit];
-        if (m_shortcut_nodes[comp_id].empty()) {
-            m_shortcut_nodes[comp_id].push_back(*nit);
-            continue;
-        }
-
-        // get the distance of this node to the goal
-        Vector3 p;
-        m_pp->projectToPoint(m_eg->getStateID(*nit), p);
-
-        auto dist = (gp - p).squaredNorm();
-
-        Vector3 lp;
-        m_pp->projectToPoint(m_eg->getStateID(m_shortcut_nodes[comp_id].front()), lp);
-
-        auto curr_dist = (gp - lp).squaredNorm();
-
-        if (dist < curr_dist) {
-            m_shortcut_nodes[comp_id].clear();
-            m_shortcut_nodes[comp_id].push_back(*nit);
-        } else if (dist == curr_dist) {
-            m_shortcut_nodes[comp_id].push_back(*nit);
-        }
-    }
+    computeShortcutNodes(gp);
 
     if (!grid()->isInBounds(dgp.x(), dgp.y(), dgp.z())) {
         SMPL_WARN("Cell (%d, %d, %d) is outside heuristic bounds", dgp.x(), dgp.y(), dgp.z());
@@ -381,6 +429,36 @@ void DijkstraEgraphHeuristic3D::updateGoal(const GoalConstraint& goal)
     SMPL_INFO_NAMED(LOG, "Updated EGraphBfsHeuristic goal");
 }
 
+// Select the nodes of each component whose projections are nearest the goal.
+// Components are independent, so they are distributed among the threads.
+void DijkstraEgraphHeuristic3D::computeShortcutNodes(const Vector3& gp)
+{
+    auto select_shortcuts = [&](int tid, std::size_t comp_id) {
+        auto& shortcuts = m_shortcut_nodes[comp_id];
+        shortcuts.clear();
+        auto best_dist = std::numeric_limits<double>::infinity();
+        for (auto n : m_component_nodes[comp_id]) {
+            // get the distance of this node to the goal
+            auto dist = (gp - m_projected_points[n]).squaredNorm();
+            if (dist < best_dist) {
+                shortcuts.clear();
+                shortcuts.push_back(n);
+                best_dist = dist;
+            } else if (dist == best_dist) {
+                shortcuts.push_back(n);
+            }
+        }
+    };
+
+    if (m_pool) {
+        m_pool->run(m_component_nodes.size(), select_shortcuts);
+    } else {
+        for (size_t i = 0; i < m_component_nodes.size(); ++i) {
+            select_shortcuts(0, i);
+        }
+    }
+}
+
 int DijkstraEgraphHeuristic3D::GetGoalHeuristic(int state_id)
 {
     // project and discretize state
@@ -438,15 +516,16 @@ void DijkstraEgraphHeuristic3D::projectExperienceGraph()
     std::vector<Vector3> viz_points;
 
     m_projected_nodes.resize(eg->num_nodes());
+    m_projected_points.resize(eg->num_nodes());
 
-    int proj_node_count = 0;
-    int proj_edge_count = 0;
+    // project every state once; edges below reuse the discretized cells
+    // rather than projecting the adjacent states again
     auto nodes = eg->nodes();
     for (auto nit = nodes.first; nit != nodes.second; ++nit) {
         // project experience graph state to point and discretize
         int first_id = m_eg->getStateID(*nit);
         SMPL_DEBUG_STREAM_NAMED(LOG, "Project experience graph state " << first_id << " " << eg->state(*nit) << " into 3D");
-        Vector3 p;
+        auto& p = m_projected_points[*nit];
         m_pp->projectToPoint(first_id, p);
         SMPL_DEBUG_NAMED(LOG, "Discretize point (%0.3f, %0.3f, %0.3f)", p.x(), p.y(), p.z());
         Eigen::Vector3i dp;
@@ -459,6 +538,12 @@ void DijkstraEgraphHeuristic3D::projectExperienceGraph()
         dp += Eigen::Vector3i::Ones();
 
         m_projected_nodes[*nit] = dp;
+    }
+
+    int proj_node_count = 0;
+    int proj_edge_count = 0;
+    for (auto nit = nodes.first; nit != nodes.second; ++nit) {
+        auto& dp = m_projected_nodes[*nit];
 
         // insert node into down-projected experience graph
         HeuristicNode empty;
@@ -477,13 +562,9 @@ void DijkstraEgraphHeuristic3D::projectExperienceGraph()
 
         auto adj = eg->adjacent_nodes(*nit);
         for (auto ait = adj.first; ait != adj.second; ++ait) {
-            // project adjacent experience graph state and discretize
             auto second_id = m_eg->getStateID(*ait);
             SMPL_DEBUG_NAMED(LOG, "  Project experience graph edge to state %d", second_id);
-            Vector3 q;
-            m_pp->projectToPoint(second_id, q);
-            Eigen::Vector3i dq;
-            grid()->worldToGrid(q.x(), q.y(), q.z(), dq.x(), dq.y(), dq.z());
+            Eigen::Vector3i dq = m_projected_nodes[*ait] - Eigen::Vector3i::Ones();
             if (!grid()->isInBounds(dq.x(), dq.y(), dq.z())) {
                 continue;
             }
@@ -504,6 +585,12 @@ void DijkstraEgraphHeuristic3D::projectExperienceGraph()
 
     SMPL_INFO("Projected experience graph contains %d nodes and %d edges", proj_node_count, proj_edge_count);
 
+    static_assert(sizeof(Vector3) == 3 * sizeof(double), "Vector3 must be packed");
+    m_node_index.build(
+            m_projected_points.empty() ? nullptr : m_projected_points[0].data(),
+            m_projected_points.size(),
+            3);
+
     auto comp_count = 0;
     m_component_ids.assign(eg->num_nodes(), -1);
     for (auto nit = nodes.first; nit != nodes.second; ++nit) {
@@ -530,6 +617,11 @@ void DijkstraEgraphHeuristic3D::projectExperienceGraph()
         ++comp_count;
     }
 
+    m_component_nodes.assign(comp_count, std::vector<ExperienceGraph::node_id>());
+    for (auto nit = nodes.first; nit != nodes.second; ++nit) {
+        m_component_nodes[m_component_ids[*nit]].push_back(*nit);
+    }
+
     // pre-allocate shortcuts array here, fill in updateGoal()
     m_shortcut_nodes.assign(comp_count, std::vector<ExperienceGraph::node_id>());
     SMPL_INFO("Experience graph contains %d components", comp_count);
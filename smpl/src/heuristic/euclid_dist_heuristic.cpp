@@ -32,6 +32,7 @@
 #include <smpl/heuristic/euclid_dist_heuristic.h>
 
 // standard includes
+#include <cassert>
 #include <cmath>
 
 // project includes
@@ -112,7 +113,9 @@ double EuclidDistHeuristic::getMetricStartDistance(double x, double y, double z)
 
 Extension* EuclidDistHeuristic::getExtension(size_t class_code)
 {
-    if (class_code == GetClassCode<RobotHeuristic>()) {
+    if (class_code == GetClassCode<RobotHeuristic>() ||
+        class_code == GetClassCode<GoalSetHeuristicExtension>())
+    {
         return this;
     }
     return nullptr;
@@ -124,40 +127,17 @@ int EuclidDistHeuristic::GetGoalHeuristic(int state_id)
         return 0;
     }
 
-    if (m_pose_ext) {
-        Affine3 p;
-        if (!m_pose_ext->projectToPose(state_id, p)) {
-            return 0;
-        }
-
-        auto& goal_pose = planningSpace()->goal().pose;
-
-        const double dist = computeDistance(p, goal_pose);
-
-        const int h = FIXED_POINT_RATIO * dist;
-
-        double Y, P, R;
-        angles::get_euler_zyx(p.rotation(), Y, P, R);
-        SMPL_DEBUG_NAMED(LOG, "h(%0.3f, %0.3f, %0.3f, %0.3f, %0.3f, %0.3f) = %d", p.translation()[0], p.translation()[1], p.translation()[2], Y, P, R, h);
-
-        return h;
-    } else if (m_point_ext) {
-        Vector3 p;
-        if (!m_point_ext->projectToPoint(state_id, p)) {
-            return 0;
-        }
-
-        auto& goal_pose = planningSpace()->goal().pose;
-        Vector3 gp(goal_pose.translation());
-
-        double dist = computeDistance(p, gp);
+    return computeHeuristic(state_id, planningSpace()->goal().pose);
+}
 
-        const int h = FIXED_POINT_RATIO * dist;
-        SMPL_DEBUG_NAMED(LOG, "h(%d) = %d", state_id, h);
-        return h;
-    } else {
-        return 0;
+int EuclidDistHeuristic::GetGoalHeuristic(int state_id, int goal_index)
+{
+    auto& goal = planningSpace()->goal();
+    if (goal.type == GoalType::MULTIPLE_POSE_GOAL) {
+        assert(goal_index >= 0 && goal_index < goal.poses.size());
+        return computeHeuristic(state_id, goal.poses[goal_index]);
     }
+    return GetGoalHeuristic(state_id);
 }
 
 int EuclidDistHeuristic::GetStartHeuristic(int state_id)
@@ -243,6 +223,43 @@ Affine3 EuclidDistHeuristic::createPose(
             AngleAxis(R, Vector3::UnitX()));
 }
 
+// Return the heuristic distance from a state to a goal pose, or 0 if the state
+// can not be projected to a pose or point.
+int EuclidDistHeuristic::computeHeuristic(int state_id, const Affine3& goal_pose)
+{
+    if (m_pose_ext) {
+        Affine3 p;
+        if (!m_pose_ext->projectToPose(state_id, p)) {
+            return 0;
+        }
+
+        const double dist = computeDistance(p, goal_pose);
+
+        const int h = FIXED_POINT_RATIO * dist;
+
+        double Y, P, R;
+        angles::get_euler_zyx(p.rotation(), Y, P, R);
+        SMPL_DEBUG_NAMED(LOG, "h(%0.3f, %0.3f, %0.3f, %0.3f, %0.3f, %0.3f) = %d", p.translation()[0], p.translation()[1], p.translation()[2], Y, P, R, h);
+
+        return h;
+    } else if (m_point_ext) {
+        Vector3 p;
+        if (!m_point_ext->projectToPoint(state_id, p)) {
+            return 0;
+        }
+
+        Vector3 gp(goal_pose.translation());
+
+        double dist = computeDistance(p, gp);
+
+        const int h = FIXED_POINT_RATIO * dist;
+        SMPL_DEBUG_NAMED(LOG, "h(%d) = %d", state_id, h);
+        return h;
+    } else {
+        return 0;
+    }
+}
+
 double EuclidDistHeuristic::computeDistance(
     const Affine3& a,
     const Affine3& b) const
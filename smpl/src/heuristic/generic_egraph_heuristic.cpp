@@ -131,11 +131,113 @@ void GenericEgraphHeuristic::updateGoal(const GoalConstraint& goal)
         return;
     }
 
+    computeComponents(eg);
+
+    m_node_h.resize(eg->num_nodes());
+    auto nodes = eg->nodes();
+    for (auto nit = nodes.first; nit != nodes.second; ++nit) {
+        m_node_h[*nit] = m_orig_h->GetGoalHeuristic(m_eg->getStateID(*nit));
+    }
+
+    computeShortcutNodes(eg);
+
+    ////////////////////////////////////////////////////////////
+    // Compute Heuristic Distances for Experience Graph Nodes //
+    ////////////////////////////////////////////////////////////
+
+    m_h_nodes.assign(eg->num_nodes() + 1, HeuristicNode(Unknown));
+    m_open.clear();
+    m_h_nodes[0].dist = 0;
+    m_open.push(&m_h_nodes[0]);
+    propagateDistances(eg);
+}
+
+// Extend the precomputation for the current goal to cover appended nodes and
+// edges. Adding nodes and edges can only shorten heuristic distances, so the
+// new nodes are seeded with their best distance through the existing nodes
+// and any improvements are propagated from them, rather than rerunning the
+// search over the whole graph.
+void GenericEgraphHeuristic::experienceGraphExtended(
+    ExperienceGraph::node_id first_node,
+    ExperienceGraph::edge_id first_edge)
+{
+    if (!m_eg) {
+        return;
+    }
+
+    ExperienceGraph* eg = m_eg->getExperienceGraph();
+    if (!eg || m_h_nodes.size() != first_node + 1) {
+        // no precomputation over the previous graph to extend
+        return;
+    }
+
+    computeComponents(eg);
+
+    m_node_h.resize(eg->num_nodes());
+    for (auto n = first_node; n < eg->num_nodes(); ++n) {
+        m_node_h[n] = m_orig_h->GetGoalHeuristic(m_eg->getStateID(n));
+    }
+
+    computeShortcutNodes(eg);
+
+    m_open.clear();
+    m_h_nodes.resize(eg->num_nodes() + 1, HeuristicNode(Unknown));
+
+    auto relax = [&](HeuristicNode* n, int new_cost) {
+        if (new_cost < n->dist) {
+            n->dist = new_cost;
+            if (m_open.contains(n)) {
+                m_open.decrease(n);
+            } else {
+                m_open.push(n);
+            }
+        }
+    };
+
+    std::vector<bool> adjacent(eg->num_nodes(), false);
+    for (auto n = first_node; n < eg->num_nodes(); ++n) {
+        HeuristicNode* hn = &m_h_nodes[n + 1];
+        const int n_state_id = m_eg->getStateID(n);
+        auto adj = eg->adjacent_nodes(n);
+        for (auto ait = adj.first; ait != adj.second; ++ait) {
+            adjacent[*ait] = true;
+        }
+        relax(hn, (int)(m_eg_eps * m_node_h[n]));
+        for (ExperienceGraph::node_id sid = 0; sid < first_node; ++sid) {
+            const HeuristicNode& s = m_h_nodes[sid + 1];
+            if (adjacent[sid]) {
+                relax(hn, s.dist + 10);
+            } else {
+                const int s_state_id = m_eg->getStateID(sid);
+                int h = m_orig_h->GetFromToHeuristic(s_state_id, n_state_id);
+                relax(hn, s.dist + (int)(m_eg_eps * h));
+            }
+        }
+        for (auto ait = adj.first; ait != adj.second; ++ait) {
+            adjacent[*ait] = false;
+        }
+    }
+
+    // new edges between existing nodes
+    for (auto e = first_edge; e < eg->num_edges(); ++e) {
+        auto u = eg->source(e);
+        auto v = eg->target(e);
+        if (u < first_node && v < first_node) {
+            relax(&m_h_nodes[v + 1], m_h_nodes[u + 1].dist + 10);
+            relax(&m_h_nodes[u + 1], m_h_nodes[v + 1].dist + 10);
+        }
+    }
+
+    propagateDistances(eg);
+}
+
+void GenericEgraphHeuristic::computeComponents(const ExperienceGraph* eg)
+{
     //////////////////////////////////////////////////////////
     // Compute Connected Components of the Experience Graph //
     //////////////////////////////////////////////////////////
 
-    int comp_count = 0;
+    m_component_count = 0;
     m_component_ids.assign(eg->num_nodes(), -1);
     auto nodes = eg->nodes();
     for (auto nit = nodes.first; nit != nodes.second; ++nit) {
@@ -149,7 +251,7 @@ void GenericEgraphHeuristic::updateGoal(const GoalConstraint& goal)
             ExperienceGraph::node_id n = frontier.back();
             frontier.pop_back();
 
-            m_component_ids[n] = comp_count;
+            m_component_ids[n] = m_component_count;
 
             auto adj = eg->adjacent_nodes(n);
             for (auto ait = adj.first; ait != adj.second; ++ait) {
@@ -159,23 +261,26 @@ void GenericEgraphHeuristic::updateGoal(const GoalConstraint& goal)
             }
         }
 
-        ++comp_count;
+        ++m_component_count;
     }
 
-    SMPL_INFO_NAMED(LOG, "Experience graph contains %d connected components", comp_count);
+    SMPL_INFO_NAMED(LOG, "Experience graph contains %d connected components", m_component_count);
+}
 
+void GenericEgraphHeuristic::computeShortcutNodes(const ExperienceGraph* eg)
+{
     ////////////////////////////
     // Compute Shortcut Nodes //
     ////////////////////////////
 
-    m_shortcut_nodes.assign(comp_count, std::vector<ExperienceGraph::node_id>());
-    std::vector<int> shortcut_heuristics(comp_count);
+    m_shortcut_nodes.assign(m_component_count, std::vector<ExperienceGraph::node_id>());
+    std::vector<int> shortcut_heuristics(m_component_count);
+    auto nodes = eg->nodes();
     for (auto nit = nodes.first; nit != nodes.second; ++nit) {
         const ExperienceGraph::node_id n = *nit;
         const int comp_id = m_component_ids[n];
-        const int state_id = m_eg->getStateID(n);
 
-        int h = m_orig_h->GetGoalHeuristic(state_id);
+        int h = m_node_h[n];
 
         if (m_shortcut_nodes[comp_id].empty()) {
             m_shortcut_nodes[comp_id].push_back(n);
@@ -191,15 +296,16 @@ void GenericEgraphHeuristic::updateGoal(const GoalConstraint& goal)
             }
         }
     }
+}
 
-    ////////////////////////////////////////////////////////////
-    // Compute Heuristic Distances for Experience Graph Nodes //
-    ////////////////////////////////////////////////////////////
+void GenericEgraphHeuristic::propagateDistances(const ExperienceGraph* eg)
+{
+    auto nodes = eg->nodes();
+
+    // nodes adjacent to the expanded node, marked from its incident edges
+    // rather than testing each candidate with ExperienceGraph::edge()
+    std::vector<bool> adjacent(eg->num_nodes(), false);
 
-    m_h_nodes.assign(eg->num_nodes() + 1, HeuristicNode(Unknown));
-    m_open.clear();
-    m_h_nodes[0].dist = 0;
-    m_open.push(&m_h_nodes[0]);
     while (!m_open.empty()) {
         HeuristicNode* s = m_open.min();
         m_open.pop();
@@ -211,9 +317,7 @@ void GenericEgraphHeuristic::updateGoal(const GoalConstraint& goal)
             for (auto nit = nodes.first; nit != nodes.second; ++nit) {
                 const ExperienceGraph::node_id nid = *nit;
                 HeuristicNode* n = &m_h_nodes[nid + 1];
-                const int state_id = m_eg->getStateID(nid);
-                const int h = m_orig_h->GetGoalHeuristic(state_id);
-                n->dist = (int)(m_eg_eps * h);
+                n->dist = (int)(m_eg_eps * m_node_h[nid]);
                 m_open.push(n);
             }
         } else {
@@ -222,10 +326,14 @@ void GenericEgraphHeuristic::updateGoal(const GoalConstraint& goal)
             // states
             const ExperienceGraph::node_id sid = nidx - 1;
             const int s_state_id = m_eg->getStateID(sid);
+            auto adj = eg->adjacent_nodes(sid);
+            for (auto ait = adj.first; ait != adj.second; ++ait) {
+                adjacent[*ait] = true;
+            }
             for (auto nit = nodes.first; nit != nodes.second; ++nit) {
                 const ExperienceGraph::node_id nid = *nit;
                 HeuristicNode* n = &m_h_nodes[nid + 1];
-                if (eg->edge(sid, nid)) {
+                if (adjacent[nid]) {
                     const int edge_cost = 10;
                     const int new_cost = s->dist + edge_cost;
                     if (new_cost < n->dist) {
@@ -250,6 +358,9 @@ void GenericEgraphHeuristic::updateGoal(const GoalConstraint& goal)
                     }
                 }
             }
+            for (auto ait = adj.first; ait != adj.second; ++ait) {
+                adjacent[*ait] = false;
+            }
         }
     }
 }
@@ -122,6 +122,9 @@ int JointDistHeuristic::GetFromToHeuristic(int from_id, int to_id)
     }
 }
 
+// The distance is computed directly rather than looked up from per-joint tables
+// of discretized deltas. Indexing such a table still requires converting each
+// delta to a cell count, which costs more than the multiply-add it replaces.
 double JointDistHeuristic::computeJointDistance(
     const RobotState& s,
     const RobotState& t) const
@@ -31,6 +31,10 @@
 
 #include <smpl/heuristic/multi_frame_bfs_heuristic.h>
 
+// standard includes
+#include <algorithm>
+#include <thread>
+
 // project includes
 #include <smpl/bfs3d/bfs3d.h>
 #include <smpl/console/console.h>
@@ -96,14 +100,66 @@ void MultiFrameBfsHeuristic::setCostPerCell(int cost)
     m_cost_per_cell = cost;
 }
 
+/// Set the number of threads used by each of the planning link and end
+/// effector searches to propagate distances from the goal.
+void MultiFrameBfsHeuristic::setThreadCount(int count)
+{
+    m_thread_count = count;
+    if (m_bfs) {
+        m_bfs->setThreadCount(count);
+        m_ee_bfs->setThreadCount(count);
+    }
+}
+
+/// Set the number of grid cells, along each axis, covered by one cell of the
+/// end effector search. A cell of the coarser search is free if any of the
+/// grid cells it covers is free, which keeps its scaled distances from
+/// overestimating those of a full resolution search. Resets both searches if
+/// the heuristic has already been initialized.
+void MultiFrameBfsHeuristic::setEeCellScale(int scale)
+{
+    scale = std::max(1, scale);
+    if (scale == m_ee_cell_scale) {
+        return;
+    }
+    m_ee_cell_scale = scale;
+    if (m_bfs) {
+        syncGridAndBfs();
+    }
+}
+
 Extension* MultiFrameBfsHeuristic::getExtension(size_t class_code)
 {
-    if (class_code == GetClassCode<RobotHeuristic>()) {
+    if (class_code == GetClassCode<RobotHeuristic>() ||
+        class_code == GetClassCode<MemoryUsageExtension>() ||
+        class_code == GetClassCode<CancellationExtension>())
+    {
         return this;
     }
     return nullptr;
 }
 
+void MultiFrameBfsHeuristic::setCancellationToken(const CancellationToken* token)
+{
+    m_cancel = token;
+    if (m_bfs) {
+        m_bfs->setCancellationToken(token);
+        m_ee_bfs->setCancellationToken(token);
+    }
+}
+
+auto MultiFrameBfsHeuristic::memoryUsage() const -> std::size_t
+{
+    auto usage = std::size_t(0);
+    if (m_bfs) {
+        usage += m_bfs->memoryUsage();
+    }
+    if (m_ee_bfs) {
+        usage += m_ee_bfs->memoryUsage();
+    }
+    return usage;
+}
+
 void MultiFrameBfsHeuristic::updateGoal(const GoalConstraint& goal)
 {
     SMPL_DEBUG_NAMED(LOG, "Update goal");
@@ -129,14 +185,19 @@ void MultiFrameBfsHeuristic::updateGoal(const GoalConstraint& goal)
     SMPL_DEBUG_NAMED(LOG, "Setting the Two-Point BFS heuristic goals (%d, %d, %d), (%d, %d, %d)", ogx, ogy, ogz, plgx, plgy, plgz);
 
     if (!m_bfs->inBounds(ogx, ogy, ogz) ||
-        !m_ee_bfs->inBounds(plgx, plgy, plgz))
+        !m_bfs->inBounds(plgx, plgy, plgz))
     {
         SMPL_ERROR_NAMED(LOG, "Heuristic goal is out of BFS bounds");
         return;
     }
 
+    // each search propagates in its own background thread, so both are
+    // in flight once the second is started
     m_bfs->run(ogx, ogy, ogz);
-    m_ee_bfs->run(plgx, plgy, plgz);
+    m_ee_bfs->run(
+            plgx / m_ee_cell_scale,
+            plgy / m_ee_cell_scale,
+            plgz / m_ee_cell_scale);
 }
 
 double MultiFrameBfsHeuristic::getMetricStartDistance(double x, double y, double z)
@@ -261,7 +322,12 @@ auto MultiFrameBfsHeuristic::getValuesVisualization() const -> visual::Marker
         }
 
         int d = edge_cost * m_bfs->getDistance(x, y, z);
-        int eed = factor_ee ? edge_cost * m_ee_bfs->getDistance(x, y, z) : 0;
+        int eed = factor_ee ?
+                edge_cost * m_ee_bfs->getDistance(
+                        x / m_ee_cell_scale,
+                        y / m_ee_cell_scale,
+                        z / m_ee_cell_scale) :
+                0;
         double cost_pct = (double)combine_costs(d, eed) / (double)(max_cost);
 
         if (cost_pct > 1.0) {
@@ -327,39 +393,159 @@ int MultiFrameBfsHeuristic::getGoalHeuristic(int state_id, bool use_ee) const
                 pose.translation()[1],
                 pose.translation()[2],
                 eex[0], eex[1], eex[2]);
-        h_planning_link = getBfsCostToGoal(*m_ee_bfs, eex[0], eex[1], eex[2]);
+        if (m_bfs->inBounds(eex[0], eex[1], eex[2])) {
+            const int s = m_ee_cell_scale;
+            h_planning_link = getBfsCostToGoal(
+                    *m_ee_bfs, eex[0] / s, eex[1] / s, eex[2] / s, s);
+        } else {
+            h_planning_link = Infinity;
+        }
     }
 
     return combine_costs(h_planning_frame, h_planning_link);
 }
 
+void MultiFrameBfsHeuristic::updateWalls()
+{
+    std::vector<bool> walls;
+    std::vector<bool> ee_walls;
+    getWalls(walls, ee_walls);
+
+    auto diff_walls = [](
+        const BFS_3D16& bfs,
+        int xc, int yc, int zc,
+        const std::vector<bool>& walls,
+        std::vector<int>& added,
+        std::vector<int>& removed)
+    {
+        auto i = 0;
+        for (int z = 0; z < zc; ++z) {
+        for (int y = 0; y < yc; ++y) {
+        for (int x = 0; x < xc; ++x) {
+            const bool wall = walls[i++];
+            if (wall != bfs.isWall(x, y, z)) {
+                auto& changed = wall ? added : removed;
+                changed.push_back(x);
+                changed.push_back(y);
+                changed.push_back(z);
+            }
+        }
+        }
+        }
+    };
+
+    const int xc = grid()->numCellsX();
+    const int yc = grid()->numCellsY();
+    const int zc = grid()->numCellsZ();
+    const int s = m_ee_cell_scale;
+
+    std::vector<int> added, removed;
+    diff_walls(*m_bfs, xc, yc, zc, walls, added, removed);
+    std::vector<int> ee_added, ee_removed;
+    diff_walls(
+            *m_ee_bfs,
+            (xc + s - 1) / s, (yc + s - 1) / s, (zc + s - 1) / s,
+            ee_walls, ee_added, ee_removed);
+
+    SMPL_DEBUG_NAMED(LOG, "Update BFS walls (%zu added, %zu removed)", added.size() / 3, removed.size() / 3);
+
+    // the repairs run in the calling thread, so repair the end effector
+    // search alongside
+    std::thread ee_repair([&]()
+    {
+        m_ee_bfs->updateWalls(ee_added, ee_removed);
+    });
+    m_bfs->updateWalls(added, removed);
+    ee_repair.join();
+}
+
 void MultiFrameBfsHeuristic::syncGridAndBfs()
 {
     const int xc = grid()->numCellsX();
     const int yc = grid()->numCellsY();
     const int zc = grid()->numCellsZ();
-    m_bfs.reset(new BFS_3D(xc, yc, zc));
-    m_ee_bfs.reset(new BFS_3D(xc, yc, zc));
+    const int s = m_ee_cell_scale;
+    const int exc = (xc + s - 1) / s;
+    const int eyc = (yc + s - 1) / s;
+    const int ezc = (zc + s - 1) / s;
+    m_bfs.reset(new BFS_3D16(xc, yc, zc));
+    m_ee_bfs.reset(new BFS_3D16(exc, eyc, ezc));
+    m_bfs->setThreadCount(m_thread_count);
+    m_bfs->setCancellationToken(m_cancel);
+    m_ee_bfs->setThreadCount(m_thread_count);
+    m_ee_bfs->setCancellationToken(m_cancel);
+
+    std::vector<bool> walls;
+    std::vector<bool> ee_walls;
+    getWalls(walls, ee_walls);
+
     const int cell_count = xc * yc * zc;
     int wall_count = 0;
+    auto i = 0;
     for (int z = 0; z < zc; ++z) {
     for (int y = 0; y < yc; ++y) {
     for (int x = 0; x < xc; ++x) {
-        const double radius = m_inflation_radius;
-        if (grid()->getDistance(x, y, z) <= radius) {
+        if (walls[i++]) {
             m_bfs->setWall(x, y, z);
-            m_ee_bfs->setWall(x, y, z);
             ++wall_count;
         }
     }
     }
     }
 
+    i = 0;
+    for (int z = 0; z < ezc; ++z) {
+    for (int y = 0; y < eyc; ++y) {
+    for (int x = 0; x < exc; ++x) {
+        if (ee_walls[i++]) {
+            m_ee_bfs->setWall(x, y, z);
+        }
+    }
+    }
+    }
+
     SMPL_DEBUG_NAMED(LOG, "%d/%d (%0.3f%%) walls in the bfs heuristic", wall_count, cell_count, 100.0 * (double)wall_count / cell_count);
 }
 
+// Compute the walls of the planning frame and end effector searches, indexed
+// x-fastest, in a single pass over the occupancy grid. A cell of the end
+// effector search is a wall only if all of the grid cells it covers are.
+void MultiFrameBfsHeuristic::getWalls(
+    std::vector<bool>& walls,
+    std::vector<bool>& ee_walls) const
+{
+    const int xc = grid()->numCellsX();
+    const int yc = grid()->numCellsY();
+    const int zc = grid()->numCellsZ();
+    const int s = m_ee_cell_scale;
+    const int exc = (xc + s - 1) / s;
+    const int eyc = (yc + s - 1) / s;
+    const int ezc = (zc + s - 1) / s;
+
+    walls.assign((size_t)xc * yc * zc, false);
+    ee_walls.assign((size_t)exc * eyc * ezc, true);
+
+    auto i = 0;
+    for (int z = 0; z < zc; ++z) {
+    for (int y = 0; y < yc; ++y) {
+    for (int x = 0; x < xc; ++x) {
+        if (grid()->getDistance(x, y, z) <= m_inflation_radius) {
+            walls[i] = true;
+        } else {
+            ee_walls[(x / s) + exc * ((y / s) + eyc * (z / s))] = false;
+        }
+        ++i;
+    }
+    }
+    }
+}
+
+// A search whose cells each cover cell_scale grid cells along each axis
+// reaches the goal in at most ceil(d / cell_scale) cells for any free path of
+// d grid cells, so cell_scale * distance - (cell_scale - 1) bounds d from
+// below.
 int MultiFrameBfsHeuristic::getBfsCostToGoal(
-    const BFS_3D& bfs, int x, int y, int z) const
+    const BFS_3D16& bfs, int x, int y, int z, int cell_scale) const
 {
     if (!bfs.inBounds(x, y, z)) {
         return Infinity;
@@ -368,7 +554,8 @@ int MultiFrameBfsHeuristic::getBfsCostToGoal(
         return Infinity;
     }
     else {
-        return m_cost_per_cell * bfs.getDistance(x, y, z);
+        const int d = bfs.getDistance(x, y, z);
+        return m_cost_per_cell * std::max(0, cell_scale * d - (cell_scale - 1));
     }
 }
 
@@ -0,0 +1,152 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+/// \author Andrew Dornbush
+
+#include <smpl/heuristic/pose_bfs_heuristic.h>
+
+// standard includes
+#include <algorithm>
+#include <cmath>
+
+// project includes
+#include <smpl/angles.h>
+#include <smpl/console/console.h>
+#include <smpl/memory_usage.h>
+#include <smpl/graph/workspace_lattice.h>
+
+namespace smpl {
+
+static const char* LOG = "heuristic.pose_bfs";
+
+bool PoseBfsHeuristic::init(RobotPlanningSpace* space, const OccupancyGrid* grid)
+{
+    auto* lattice = space->getExtension<WorkspaceLattice>();
+    if (lattice == nullptr) {
+        SMPL_WARN_NAMED(LOG, "PoseBfsHeuristic requires a Workspace Lattice");
+        return false;
+    }
+
+    if (!BfsHeuristic::init(space, grid)) {
+        return false;
+    }
+
+    m_lattice = lattice;
+    return true;
+}
+
+auto PoseBfsHeuristic::memoryUsage() const -> std::size_t
+{
+    return BfsHeuristic::memoryUsage() + MemoryUsage(m_rot_costs);
+}
+
+void PoseBfsHeuristic::updateGoal(const GoalConstraint& goal)
+{
+    BfsHeuristic::updateGoal(goal);
+    updateRotationCosts(goal);
+}
+
+int PoseBfsHeuristic::GetGoalHeuristic(int state_id)
+{
+    auto h = BfsHeuristic::GetGoalHeuristic(state_id);
+    if (m_rot_costs.empty() ||
+        h >= Infinity ||
+        state_id == planningSpace()->getGoalStateID())
+    {
+        return h;
+    }
+
+    auto& counts = m_lattice->m_val_count;
+    auto* coord = m_lattice->getStateCoord(state_id);
+    auto bin = (coord[3] * counts[4] + coord[4]) * counts[5] + coord[5];
+    return h + m_rot_costs[bin];
+}
+
+// Tabulate the rotation steps from the center of each orientation bin to the
+// nearest goal orientation. One step rotates the planning link by at most the
+// coarsest rotation resolution, so the geodesic angle outside the goal
+// tolerance, divided by that resolution, bounds the number of steps below.
+void PoseBfsHeuristic::updateRotationCosts(const GoalConstraint& goal)
+{
+    m_rot_costs.clear();
+
+    std::vector<Quaternion> goal_rotations;
+    switch (goal.type) {
+    case GoalType::XYZ_RPY_GOAL:
+        goal_rotations.push_back(Quaternion(goal.pose.rotation()));
+        break;
+    case GoalType::MULTIPLE_POSE_GOAL:
+        for (auto& pose : goal.poses) {
+            goal_rotations.push_back(Quaternion(pose.rotation()));
+        }
+        break;
+    default:
+        break;
+    }
+    if (goal_rotations.empty()) {
+        return;
+    }
+
+    auto& res = m_lattice->resolution();
+    auto& counts = m_lattice->m_val_count;
+    auto max_res = std::max(res[3], std::max(res[4], res[5]));
+    // the angle of a rotation composed of the three tolerated rotations is at
+    // most their sum
+    auto tolerance = goal.rpy_tolerance[0] + goal.rpy_tolerance[1] + goal.rpy_tolerance[2];
+
+    m_rot_costs.resize(counts[3] * counts[4] * counts[5]);
+    auto bin = 0;
+    for (int r = 0; r < counts[3]; ++r) {
+    for (int p = 0; p < counts[4]; ++p) {
+    for (int y = 0; y < counts[5]; ++y) {
+        int coord[3] = { r, p, y };
+        double rpy[3];
+        m_lattice->rotCoordToWorkspace(coord, rpy);
+
+        Quaternion q;
+        angles::from_euler_zyx(rpy[2], rpy[1], rpy[0], q);
+
+        auto angle = M_PI;
+        for (auto& goal_rotation : goal_rotations) {
+            auto dot = std::min(1.0, std::fabs(q.dot(goal_rotation)));
+            angle = std::min(angle, 2.0 * std::acos(dot));
+        }
+
+        // small slack so bins that differ only by rounding from a whole
+        // number of steps are not charged an extra step
+        auto steps = std::ceil(std::max(0.0, angle - tolerance) / max_res - 1e-6);
+        m_rot_costs[bin++] = costPerCell() * (int)steps;
+    }
+    }
+    }
+
+    SMPL_DEBUG_NAMED(LOG, "Tabulated rotation costs of %zu orientation bins", m_rot_costs.size());
+}
+
+} // namespace smpl
@@ -31,116 +31,211 @@
 
 #include <smpl/heuristic/soft_bfs_heuristic.h>
 
+// standard includes
+#include <algorithm>
+#include <cmath>
+
+// project includes
 #include <smpl/console/console.h>
 
 namespace smpl {
 
-SoftBfsHeuristic::SoftBfsHeuristic(
-    EnvironmentROBARM3D* env,
-    const OccupancyGridConstPtr& grid,
-    const PlanningParams* params)
-:
-    RobotHeuristic(env, grid, params)
+static const char* LOG = "heuristic.soft_bfs";
+
+// cell costs are stored in tenths of the cost of a cell without clearance
+// cost, so that fractional clearance costs are not lost
+static const int CellCostScale = 10;
+
+SoftBfsHeuristic::~SoftBfsHeuristic()
 {
-    syncGridAndBfs();
+    // empty to allow forward declaration of SoftBFS_3D
 }
 
-bool SoftBfsHeuristic::setGoal(int x, int y, int z)
+bool SoftBfsHeuristic::init(RobotPlanningSpace* space, const OccupancyGrid* grid)
 {
-    int gx, gy, gz;
-    m_grid->worldToGrid(x, y, z, gx, gy, gz);
+    if (!RobotHeuristic::init(space)) {
+        return false;
+    }
 
-    if (!m_bfs->escapeCell(x, y, z)) {
-        SMPL_ERROR("BFS goal is out of bounds or couldn't be freed");
+    if (grid == NULL) {
         return false;
     }
 
-    m_bfs->run_components(x, y, z);
-    SMPL_INFO(" -> Running");
-    while (m_bfs->isRunning());
-    SMPL_INFO(" -> Finished: %d walls, %d undiscovered, %d discovered", m_bfs->countWalls(), m_bfs->countUndiscovered(), m_bfs->countDiscovered());
+    m_grid = grid;
+    m_pp = space->getExtension<PointProjectionExtension>();
 
+    const int xc = grid->numCellsX();
+    const int yc = grid->numCellsY();
+    const int zc = grid->numCellsZ();
+    m_bfs.reset(new SoftBFS_3D(xc, yc, zc));
+    m_bfs->setThreadCount(m_thread_count);
+    int wall_count = 0;
+    for (int x = 0; x < xc; ++x) {
+    for (int y = 0; y < yc; ++y) {
+    for (int z = 0; z < zc; ++z) {
+        const int cost = cellCost(x, y, z);
+        m_bfs->setCellCost(x, y, z, cost);
+        if (cost == SoftBFS_3D::WALL) {
+            ++wall_count;
+        }
+    }
+    }
+    }
+
+    SMPL_DEBUG_NAMED(LOG, "%d/%d walls in the soft bfs heuristic", wall_count, xc * yc * zc);
     return true;
 }
 
-bool SoftBfsHeuristic::setGoal(double x, double y, double z)
+void SoftBfsHeuristic::updateCosts()
 {
-    int gx, gy, gz;
-    m_grid->worldToGrid(x, y, z, gx, gy, gz);
-    return setGoal(gx, gy, gz);
+    const int xc = grid()->numCellsX();
+    const int yc = grid()->numCellsY();
+    const int zc = grid()->numCellsZ();
+    std::vector<int> cells;
+    std::vector<int> costs;
+    for (int x = 0; x < xc; ++x) {
+    for (int y = 0; y < yc; ++y) {
+    for (int z = 0; z < zc; ++z) {
+        const int cost = cellCost(x, y, z);
+        if (cost != m_bfs->getCellCost(x, y, z)) {
+            cells.push_back(x);
+            cells.push_back(y);
+            cells.push_back(z);
+            costs.push_back(cost);
+        }
+    }
+    }
+    }
+
+    SMPL_DEBUG_NAMED(LOG, "Update soft BFS costs of %zu cells", costs.size());
+
+    if (!costs.empty()) {
+        m_bfs->updateCellCosts(cells, costs);
+    }
 }
 
-int SoftBfsHeuristic::GetGoalHeuristic(int state_id)
+void SoftBfsHeuristic::updateGoal(const GoalConstraint& goal)
 {
-    const ManipLatticeState* state = m_robarm_env->getHashEntry(state_id);
-    if (state) {
-        const int x = state->xyz[0];
-        const int y = state->xyz[1];
-        const int z = state->xyz[2];
-        if (m_bfs_>isWall(x, y, z)) {
-            const int h = 100 * m_bfs->getNearestFreeNodeDist(x, y, z);
-            return INT_MAX;
+    std::vector<Vector3> positions;
+    switch (goal.type) {
+    case GoalType::XYZ_GOAL:
+    case GoalType::XYZ_RPY_GOAL:
+    case GoalType::JOINT_STATE_GOAL:
+        positions.push_back(goal.pose.translation());
+        break;
+    case GoalType::MULTIPLE_POSE_GOAL:
+        for (auto& pose : goal.poses) {
+            positions.push_back(pose.translation());
         }
-        else {
-            int cell_dist = m_bfs->getDistance(x, y, z);
-            if (cell_dist < 0) {
-                SMPL_WARN_THROTTLE(1, "queried distance for isolated cell");
-                m_bfs->setWall(x, y, z);
-                while ((cell_dist = m_bfs->getNearestFreeNodeDist(x, y, z)) < 0);
-                return 100 * cell_dist;
-            }
-            else {
-                return 100 * m_bfs->getDistance(x, y, z);
-            }
+        break;
+    case GoalType::USER_GOAL_CONSTRAINT_FN:
+    default:
+        SMPL_ERROR_NAMED(LOG, "Unsupported goal type in Soft BFS Heuristic");
+        return;
+    }
+
+    std::vector<int> goal_cells;
+    for (auto& pos : positions) {
+        int gx, gy, gz;
+        grid()->worldToGrid(pos.x(), pos.y(), pos.z(), gx, gy, gz);
+        if (!m_bfs->inBounds(gx, gy, gz)) {
+            SMPL_ERROR_NAMED(LOG, "Heuristic goal is out of BFS bounds");
+            continue;
         }
+        goal_cells.push_back(gx);
+        goal_cells.push_back(gy);
+        goal_cells.push_back(gz);
     }
-    else {
-        return 0;
+
+    SMPL_DEBUG_NAMED(LOG, "Run the soft BFS from %zu goal cells", goal_cells.size() / 3);
+    m_bfs->run(begin(goal_cells), end(goal_cells));
+}
+
+double SoftBfsHeuristic::getMetricStartDistance(double x, double y, double z)
+{
+    return 0.0;
+}
+
+double SoftBfsHeuristic::getMetricGoalDistance(double x, double y, double z)
+{
+    int gx, gy, gz;
+    grid()->worldToGrid(x, y, z, gx, gy, gz);
+    const int d = m_bfs->getDistance(gx, gy, gz);
+    if (d == SoftBFS_3D::WALL || d == SoftBFS_3D::UNDISCOVERED) {
+        return (double)SoftBFS_3D::WALL * grid()->resolution();
     }
+    return (double)d / (double)CellCostScale * grid()->resolution();
 }
 
-int SoftBfsHeuristic::GetStartHeuristic(int state_id)
+Extension* SoftBfsHeuristic::getExtension(size_t class_code)
 {
-    return 0;
+    if (class_code == GetClassCode<RobotHeuristic>() ||
+        class_code == GetClassCode<MemoryUsageExtension>())
+    {
+        return this;
+    }
+    return nullptr;
 }
 
-int SoftBfsHeuristic::GetFromToHeuristic(int from_id, int to_id)
+auto SoftBfsHeuristic::memoryUsage() const -> std::size_t
 {
-    return 0;
+    return m_bfs ? m_bfs->memoryUsage() : 0;
 }
 
-visualization_msgs::MarkerArray SoftBfsHeuristic::getWallsVisualization() const
+int SoftBfsHeuristic::GetGoalHeuristic(int state_id)
 {
+    if (m_pp == NULL) {
+        return 0;
+    }
+
+    Vector3 p;
+    if (!m_pp->projectToPoint(state_id, p)) {
+        return 0;
+    }
 
+    int gx, gy, gz;
+    grid()->worldToGrid(p.x(), p.y(), p.z(), gx, gy, gz);
+    return getCostToGoal(gx, gy, gz);
 }
 
-visualization_msgs::MarkerArray SoftBfsHeuristic::getValuesVisualization() const
+int SoftBfsHeuristic::GetStartHeuristic(int state_id)
 {
+    SMPL_WARN_ONCE("SoftBfsHeuristic::GetStartHeuristic unimplemented");
+    return 0;
+}
 
+int SoftBfsHeuristic::GetFromToHeuristic(int from_id, int to_id)
+{
+    if (to_id == planningSpace()->getGoalStateID()) {
+        return GetGoalHeuristic(from_id);
+    } else {
+        SMPL_WARN_ONCE("SoftBfsHeuristic::GetFromToHeuristic unimplemented for arbitrary state pair");
+        return 0;
+    }
 }
 
-void SoftBfsHeuristic::syncGridAndBfs()
+// Return the cost of entering a cell, in CellCostScale units, or WALL
+int SoftBfsHeuristic::cellCost(int x, int y, int z) const
 {
-    const int xc = m_grid->numCellsX();
-    const int yc = m_grid->numCellsY();
-    const int zc = m_grid->numCellsZ();
-    m_bfs.reset(new BFS_3D(xc, yc, zc));
-    const int cell_count = xc * yc * zc;
-    int wall_count = 0;
-    for (int z = 0; z < zc; ++z) {
-        for (int y = 0; y < yc; ++y) {
-            for (int x = 0; x < xc; ++x) {
-                if (m_grid->getDistance(x, y, z) <=
-                        m_params->planning_link_sphere_radius_)
-                {
-                    m_bfs->setWall(x, y, z);
-                    ++wall_count;
-                }
-            }
-        }
+    const double d = grid()->getDistance(x, y, z);
+    if (d <= m_inflation_radius) {
+        return SoftBFS_3D::WALL;
+    }
+    if (d >= m_clearance || m_clearance <= m_inflation_radius) {
+        return CellCostScale;
     }
+    const double closeness = (m_clearance - d) / (m_clearance - m_inflation_radius);
+    const double extra = std::round(CellCostScale * m_clearance_weight * closeness);
+    return CellCostScale + (int)std::min(extra, (double)SoftBFS_3D::MaxCellCost);
+}
 
-    SMPL_INFO("%d/%d (%0.3f%%) walls in the bfs heuristic", wall_count, cell_count, 100.0 * (double)wall_count / cell_count);
+int SoftBfsHeuristic::getCostToGoal(int x, int y, int z) const
+{
+    const int d = m_bfs->getDistance(x, y, z);
+    if (d == SoftBFS_3D::WALL || d == SoftBFS_3D::UNDISCOVERED) {
+        return Infinity;
+    }
+    return (int)((long long)m_cost_per_cell * d / CellCostScale);
 }
 
 } // namespace smpl
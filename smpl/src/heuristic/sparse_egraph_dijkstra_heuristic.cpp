@@ -130,6 +130,15 @@ void SparseEGraphDijkstra3DHeuristic::setInflationRadius(double radius)
     m_inflation_radius = radius;
 }
 
+void SparseEGraphDijkstra3DHeuristic::setThreadCount(int count)
+{
+    if (count <= 1) {
+        m_pool.reset();
+    } else {
+        m_pool.reset(new WorkerPool(count));
+    }
+}
+
 void SparseEGraphDijkstra3DHeuristic::getEquivalentStates(
     int state_id,
     std::vector<int>& ids)
@@ -174,6 +183,21 @@ void SparseEGraphDijkstra3DHeuristic::getShortcutSuccs(
     }
 }
 
+// The lazily-expanded distance grid seeds its search from the experience graph
+// projection, so cells already closed may now have shorter distances through
+// the new nodes. Re-project and restart the search from the current goal.
+void SparseEGraphDijkstra3DHeuristic::experienceGraphExtended(
+    ExperienceGraph::node_id first_node,
+    ExperienceGraph::edge_id first_edge)
+{
+    if (m_projected_nodes.empty()) {
+        // no goal set yet
+        return;
+    }
+
+    updateGoal(planningSpace()->goal());
+}
+
 auto SparseEGraphDijkstra3DHeuristic::getWallsVisualization() -> visual::Marker
 {
     std::vector<Vector3> centers;
@@ -343,33 +367,7 @@ void SparseEGraphDijkstra3DHeuristic::updateGoal(const GoalConstraint& goal)
 
     // precompute shortcuts
     assert(m_component_ids.size() == m_eg->getExperienceGraph()->num_nodes());
-    ExperienceGraph* eg = m_eg->getExperienceGraph();
-    auto nodes = eg->nodes();
-    for (auto nit = nodes.first; nit != nodes.second; ++nit) {
-        int comp_id = m_component_ids[*nit];
-        if (m_shortcut_nodes[comp_id].empty()) {
-            m_shortcut_nodes[comp_id].push_back(*nit);
-            continue;
-        }
-
-        // get the distance of this node to the goal
-        Vector3 p;
-        m_pp->projectToPoint(m_eg->getStateID(*nit), p);
-
-        const double dist = (gp - p).squaredNorm();
-
-        Vector3 lp;
-        m_pp->projectToPoint(m_eg->getStateID(m_shortcut_nodes[comp_id].front()), lp);
-
-        const double curr_dist = (gp - lp).squaredNorm();
-
-        if (dist < curr_dist) {
-            m_shortcut_nodes[comp_id].clear();
-            m_shortcut_nodes[comp_id].push_back(*nit);
-        } else if (dist == curr_dist) {
-            m_shortcut_nodes[comp_id].push_back(*nit);
-        }
-    }
+    computeShortcutNodes(gp);
 
     if (!grid()->isInBounds(dgp.x(), dgp.y(), dgp.z())) {
         SMPL_WARN("Cell (%d, %d, %d) is outside heuristic bounds", dgp.x(), dgp.y(), dgp.z());
@@ -387,6 +385,36 @@ void SparseEGraphDijkstra3DHeuristic::updateGoal(const GoalConstraint& goal)
     SMPL_INFO_NAMED(LOG, "Updated EGraphBfsHeuristic goal");
 }
 
+// Select the nodes of each component whose projections are nearest the goal.
+// Components are independent, so they are distributed among the threads.
+void SparseEGraphDijkstra3DHeuristic::computeShortcutNodes(const Vector3& gp)
+{
+    auto select_shortcuts = [&](int tid, std::size_t comp_id) {
+        auto& shortcuts = m_shortcut_nodes[comp_id];
+        shortcuts.clear();
+        double best_dist = std::numeric_limits<double>::infinity();
+        for (ExperienceGraph::node_id n : m_component_nodes[comp_id]) {
+            // get the distance of this node to the goal
+            const double dist = (gp - m_projected_points[n]).squaredNorm();
+            if (dist < best_dist) {
+                shortcuts.clear();
+                shortcuts.push_back(n);
+                best_dist = dist;
+            } else if (dist == best_dist) {
+                shortcuts.push_back(n);
+            }
+        }
+    };
+
+    if (m_pool) {
+        m_pool->run(m_component_nodes.size(), select_shortcuts);
+    } else {
+        for (size_t i = 0; i < m_component_nodes.size(); ++i) {
+            select_shortcuts(0, i);
+        }
+    }
+}
+
 int SparseEGraphDijkstra3DHeuristic::GetGoalHeuristic(int state_id)
 {
     // project and discretize state
@@ -444,15 +472,16 @@ void SparseEGraphDijkstra3DHeuristic::projectExperienceGraph()
     std::vector<Vector3> viz_points;
 
     m_projected_nodes.resize(eg->num_nodes());
+    m_projected_points.resize(eg->num_nodes());
 
-    size_t proj_node_count = 0;
-    size_t proj_edge_count = 0;
+    // project every state once; edges below reuse the discretized cells
+    // rather than projecting the adjacent states again
     auto nodes = eg->nodes();
     for (auto nit = nodes.first; nit != nodes.second; ++nit) {
         // project experience graph state to point and discretize
         int first_id = m_eg->getStateID(*nit);
         SMPL_DEBUG_STREAM_NAMED(LOG, "Project experience graph state " << first_id << " " << eg->state(*nit) << " into 3D");
-        Vector3 p;
+        Vector3& p = m_projected_points[*nit];
         m_pp->projectToPoint(first_id, p);
         SMPL_DEBUG_NAMED(LOG, "Discretize point (%0.3f, %0.3f, %0.3f)", p.x(), p.y(), p.z());
         Eigen::Vector3i dp;
@@ -465,6 +494,12 @@ void SparseEGraphDijkstra3DHeuristic::projectExperienceGraph()
         dp += Eigen::Vector3i::Ones();
 
         m_projected_nodes[*nit] = dp;
+    }
+
+    size_t proj_node_count = 0;
+    size_t proj_edge_count = 0;
+    for (auto nit = nodes.first; nit != nodes.second; ++nit) {
+        const Eigen::Vector3i& dp = m_projected_nodes[*nit];
 
         // insert node into down-projected experience graph
         HeuristicNode empty;
@@ -483,13 +518,9 @@ void SparseEGraphDijkstra3DHeuristic::projectExperienceGraph()
 
         auto adj = eg->adjacent_nodes(*nit);
         for (auto ait = adj.first; ait != adj.second; ++ait) {
-            // project adjacent experience graph state and discretize
             int second_id = m_eg->getStateID(*ait);
             SMPL_DEBUG_NAMED(LOG, "  Project experience graph edge to state %d", second_id);
-            Vector3 q;
-            m_pp->projectToPoint(second_id, q);
-            Eigen::Vector3i dq;
-            grid()->worldToGrid(q.x(), q.y(), q.z(), dq.x(), dq.y(), dq.z());
+            Eigen::Vector3i dq = m_projected_nodes[*ait] - Eigen::Vector3i::Ones();
             if (!grid()->isInBounds(dq.x(), dq.y(), dq.z())) {
                 continue;
             }
@@ -536,6 +567,11 @@ void SparseEGraphDijkstra3DHeuristic::projectExperienceGraph()
         ++comp_count;
     }
 
+    m_component_nodes.assign(comp_count, std::vector<ExperienceGraph::node_id>());
+    for (auto nit = nodes.first; nit != nodes.second; ++nit) {
+        m_component_nodes[m_component_ids[*nit]].push_back(*nit);
+    }
+
     // pre-allocate shortcuts array here, fill in updateGoal()
     m_shortcut_nodes.assign(comp_count, std::vector<ExperienceGraph::node_id>());
     SMPL_INFO("Experience graph contains %d components", comp_count);
@@ -0,0 +1,322 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+
+#include <smpl/ik_sampler.h>
+
+// standard includes
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <random>
+
+// project includes
+#include <smpl/angles.h>
+#include <smpl/collision_checker.h>
+#include <smpl/console/console.h>
+#include <smpl/reachability_map.h>
+#include <smpl/worker_pool.h>
+
+namespace smpl {
+
+static const char* LOG = "ik_sampler";
+
+// solutions closer than this in every joint variable are considered the same
+static const double kDuplicateTolerance = 1e-3;
+
+IKSampler::IKSampler() = default;
+
+IKSampler::~IKSampler() = default;
+
+bool IKSampler::init(
+    RobotModel* robot,
+    CollisionChecker* checker,
+    int thread_count)
+{
+    if (!robot) {
+        SMPL_ERROR_NAMED(LOG, "IK Sampler requires a Robot Model");
+        return false;
+    }
+
+    Solver solver;
+    solver.robot = robot;
+    solver.ik = robot->getExtension<InverseKinematicsInterface>();
+    solver.checker = checker;
+    if (!solver.ik) {
+        SMPL_ERROR_NAMED(LOG, "IK Sampler requires an Inverse Kinematics Interface");
+        return false;
+    }
+
+    std::vector<Solver> solvers = { solver };
+    std::vector<std::unique_ptr<RobotModel>> robot_clones;
+    std::vector<std::unique_ptr<CollisionChecker>> checker_clones;
+    if (thread_count > 1) {
+        auto* robot_cloner = robot->getExtension<RobotModelCloneExtension>();
+        if (!robot_cloner) {
+            SMPL_ERROR_NAMED(LOG, "Parallel IK sampling requires a Robot Model Clone Extension");
+            return false;
+        }
+
+        CollisionCheckerCloneExtension* checker_cloner = nullptr;
+        if (checker) {
+            checker_cloner = checker->getExtension<CollisionCheckerCloneExtension>();
+            if (!checker_cloner) {
+                SMPL_ERROR_NAMED(LOG, "Parallel IK sampling requires a Collision Checker Clone Extension");
+                return false;
+            }
+        }
+
+        for (int i = 1; i < thread_count; ++i) {
+            auto robot_clone = robot_cloner->clone();
+            if (!robot_clone) {
+                SMPL_ERROR_NAMED(LOG, "Failed to clone robot model");
+                return false;
+            }
+
+            Solver clone_solver;
+            clone_solver.robot = robot_clone.get();
+            clone_solver.ik = robot_clone->getExtension<InverseKinematicsInterface>();
+            if (!clone_solver.ik) {
+                SMPL_ERROR_NAMED(LOG, "Robot model clone does not support Inverse Kinematics Interface");
+                return false;
+            }
+            robot_clones.push_back(std::move(robot_clone));
+
+            if (checker_cloner) {
+                auto checker_clone = checker_cloner->clone();
+                if (!checker_clone) {
+                    SMPL_ERROR_NAMED(LOG, "Failed to clone collision checker");
+                    return false;
+                }
+                clone_solver.checker = checker_clone.get();
+                checker_clones.push_back(std::move(checker_clone));
+            }
+
+            solvers.push_back(clone_solver);
+        }
+    }
+
+    m_robot = robot;
+    m_solvers = std::move(solvers);
+    m_robot_clones = std::move(robot_clones);
+    m_checker_clones = std::move(checker_clones);
+    if (thread_count > 1) {
+        m_pool.reset(new WorkerPool(thread_count));
+    } else {
+        m_pool.reset();
+    }
+    return true;
+}
+
+int IKSampler::threadCount() const
+{
+    return m_pool ? m_pool->numThreads() : 1;
+}
+
+void IKSampler::setSeedCount(int count)
+{
+    m_seed_count = std::max(1, count);
+}
+
+bool IKSampler::solve(
+    const Affine3& pose,
+    const RobotState& seed,
+    RobotState& solution,
+    ik_option::IkOption option)
+{
+    if (m_solvers.empty()) {
+        SMPL_ERROR_NAMED(LOG, "IK Sampler is not initialized");
+        return false;
+    }
+
+    sampleSeeds(pose, seed);
+
+    // seeds past the lowest-numbered success so far can not change the
+    // result, so they are skipped
+    std::atomic<std::size_t> first(m_seeds.size());
+    auto job = [&](int tid, std::size_t i)
+    {
+        if (i > first.load(std::memory_order_relaxed)) {
+            return;
+        }
+        if (!solveSeed(m_solvers[tid], pose, option, i)) {
+            return;
+        }
+        auto curr = first.load();
+        while (i < curr && !first.compare_exchange_weak(curr, i)) { }
+    };
+
+    if (m_pool) {
+        m_pool->run(m_seeds.size(), job);
+    } else {
+        for (std::size_t i = 0; i < m_seeds.size(); ++i) {
+            job(0, i);
+        }
+    }
+
+    auto found = first.load();
+    if (found == m_seeds.size()) {
+        SMPL_DEBUG_NAMED(LOG, "No valid IK solution from %zu seeds", m_seeds.size());
+        return false;
+    }
+
+    SMPL_DEBUG_NAMED(LOG, "Found valid IK solution from seed %zu", found);
+    solution = std::move(m_solutions[found]);
+    return true;
+}
+
+bool IKSampler::solve(
+    const Affine3& pose,
+    const RobotState& seed,
+    int k,
+    std::vector<RobotState>& solutions,
+    ik_option::IkOption option)
+{
+    if (m_solvers.empty()) {
+        SMPL_ERROR_NAMED(LOG, "IK Sampler is not initialized");
+        return false;
+    }
+
+    sampleSeeds(pose, seed);
+
+    auto job = [&](int tid, std::size_t i)
+    {
+        solveSeed(m_solvers[tid], pose, option, i);
+    };
+
+    if (m_pool) {
+        m_pool->run(m_seeds.size(), job);
+    } else {
+        for (std::size_t i = 0; i < m_seeds.size(); ++i) {
+            job(0, i);
+        }
+    }
+
+    std::vector<std::pair<double, std::size_t>> ranked;
+    for (std::size_t i = 0; i < m_seeds.size(); ++i) {
+        if (m_valid[i]) {
+            ranked.emplace_back(distance(m_solutions[i], seed), i);
+        }
+    }
+    std::sort(begin(ranked), end(ranked));
+
+    solutions.clear();
+    for (auto& entry : ranked) {
+        if ((int)solutions.size() >= k) {
+            break;
+        }
+
+        auto& candidate = m_solutions[entry.second];
+        auto duplicate = std::any_of(
+                begin(solutions), end(solutions),
+                [&](const RobotState& s)
+                {
+                    for (std::size_t j = 0; j < s.size(); ++j) {
+                        if (std::fabs(s[j] - candidate[j]) > kDuplicateTolerance) {
+                            return false;
+                        }
+                    }
+                    return true;
+                });
+        if (!duplicate) {
+            solutions.push_back(std::move(candidate));
+        }
+    }
+
+    SMPL_DEBUG_NAMED(LOG, "Found %zu distinct IK solutions from %zu seeds", solutions.size(), m_seeds.size());
+    return !solutions.empty();
+}
+
+void IKSampler::sampleSeeds(const Affine3& pose, const RobotState& seed)
+{
+    auto count = (std::size_t)m_seed_count;
+    m_seeds.resize(count);
+    m_solutions.assign(count, RobotState());
+    m_valid.assign(count, 0);
+
+    m_seeds[0] = seed;
+
+    std::size_t first_random = 1;
+    if (count > 1 &&
+        m_reachability_map != nullptr &&
+        m_reachability_map->dof() == seed.size() &&
+        m_reachability_map->seed(pose, m_seeds[1]))
+    {
+        first_random = 2;
+    }
+
+    // restart the sequence for every query so results are reproducible
+    std::mt19937 rng(m_random_seed);
+    for (std::size_t i = first_random; i < count; ++i) {
+        auto& s = m_seeds[i];
+        s.resize(seed.size());
+        for (std::size_t j = 0; j < seed.size(); ++j) {
+            auto lo = -M_PI;
+            auto hi = M_PI;
+            if (!m_robot->isContinuous(j) && m_robot->hasPosLimit(j)) {
+                lo = m_robot->minPosLimit(j);
+                hi = m_robot->maxPosLimit(j);
+            }
+            s[j] = std::uniform_real_distribution<double>(lo, hi)(rng);
+        }
+    }
+}
+
+bool IKSampler::solveSeed(
+    const Solver& solver,
+    const Affine3& pose,
+    ik_option::IkOption option,
+    std::size_t i)
+{
+    auto& solution = m_solutions[i];
+    if (!solver.ik->computeIK(pose, m_seeds[i], solution, option)) {
+        return false;
+    }
+    if (!solver.robot->checkJointLimits(solution)) {
+        return false;
+    }
+    if (solver.checker && !solver.checker->isStateValid(solution)) {
+        return false;
+    }
+    m_valid[i] = 1;
+    return true;
+}
+
+double IKSampler::distance(const RobotState& a, const RobotState& b) const
+{
+    auto dist = 0.0;
+    for (std::size_t j = 0; j < a.size(); ++j) {
+        auto d = m_robot->isContinuous(j) ?
+                shortest_angle_dist(a[j], b[j]) : a[j] - b[j];
+        dist += d * d;
+    }
+    return std::sqrt(dist);
+}
+
+} // namespace smpl
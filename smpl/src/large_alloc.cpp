@@ -0,0 +1,205 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+/// \author Andrew Dornbush
+
+#include <smpl/large_alloc.h>
+
+// standard includes
+#include <stdint.h>
+#include <atomic>
+#include <new>
+
+// system includes
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <smpl/console/console.h>
+
+namespace smpl {
+
+static const char* LOG = "large_alloc";
+
+// large allocations are mapped in multiples of, and aligned to, the size of a
+// huge page, so that they may be backed entirely by huge pages
+static const std::size_t HugePageSize = std::size_t(2) << 20;
+
+static std::atomic<int> g_huge_pages((int)HugePageMode::None);
+static std::atomic<int> g_numa_node(LargeAllocOptions::NoNode);
+
+void SetLargeAllocOptions(const LargeAllocOptions& options)
+{
+    g_huge_pages = (int)options.huge_pages;
+    g_numa_node = options.numa_node;
+}
+
+auto GetLargeAllocOptions() -> LargeAllocOptions
+{
+    LargeAllocOptions options;
+    options.huge_pages = (HugePageMode)g_huge_pages.load();
+    options.numa_node = g_numa_node.load();
+    return options;
+}
+
+int CurrentNumaNode()
+{
+#if defined(__linux__) && defined(SYS_getcpu)
+    unsigned int cpu, node;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+        return (int)node;
+    }
+#endif
+    return -1;
+}
+
+static auto MappedSize(std::size_t size) -> std::size_t
+{
+    return (size + HugePageSize - 1) & ~(HugePageSize - 1);
+}
+
+#if defined(__linux__)
+
+static void BindToNode(void* p, std::size_t size, int node)
+{
+#if defined(SYS_mbind)
+    // values from <numaif.h>, to avoid a dependency on libnuma
+    const int MPOL_BIND_ = 2;
+
+    const std::size_t bits = 8 * sizeof(unsigned long);
+    unsigned long mask[4] = { 0 };
+    if (node < 0 || node >= (int)(4 * bits)) {
+        SMPL_WARN_ONCE_NAMED(LOG, "Cannot bind memory to NUMA node %d", node);
+        return;
+    }
+    mask[node / bits] = 1ul << (node % bits);
+    if (syscall(SYS_mbind, p, size, MPOL_BIND_, mask, 4 * bits + 1, 0) != 0) {
+        SMPL_WARN_ONCE_NAMED(LOG, "Failed to bind memory to NUMA node %d", node);
+    }
+#endif
+}
+
+static void* MapLarge(std::size_t size, HugePageMode huge_pages)
+{
+#if defined(MAP_HUGETLB)
+    if (huge_pages == HugePageMode::Explicit) {
+        void* p = mmap(
+                nullptr, size,
+                PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                -1, 0);
+        if (p != MAP_FAILED) {
+            return p;
+        }
+        SMPL_WARN_ONCE_NAMED(LOG, "No explicit huge pages available, falling back to transparent huge pages");
+    }
+#endif
+
+    // over-allocate by a huge page and trim the ends to align the mapping to a
+    // huge page boundary
+    const std::size_t padded = size + HugePageSize;
+    void* p = mmap(
+            nullptr, padded,
+            PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS,
+            -1, 0);
+    if (p == MAP_FAILED) {
+        return nullptr;
+    }
+
+    const uintptr_t begin = (uintptr_t)p;
+    const uintptr_t aligned = (begin + HugePageSize - 1) & ~(uintptr_t)(HugePageSize - 1);
+    if (aligned != begin) {
+        munmap(p, aligned - begin);
+    }
+    const uintptr_t end = begin + padded;
+    if (end != aligned + size) {
+        munmap((void*)(aligned + size), end - (aligned + size));
+    }
+
+#if defined(MADV_HUGEPAGE)
+    if (huge_pages != HugePageMode::None) {
+        (void)madvise((void*)aligned, size, MADV_HUGEPAGE);
+    }
+#endif
+
+    return (void*)aligned;
+}
+
+#endif
+
+void* AllocateLarge(std::size_t size)
+{
+    return AllocateLarge(size, GetLargeAllocOptions());
+}
+
+void* AllocateLarge(std::size_t size, const LargeAllocOptions& options)
+{
+#if defined(__linux__)
+    if (size < LargeAllocThreshold) {
+        return ::operator new(size);
+    }
+
+    const std::size_t mapped = MappedSize(size);
+    void* p = MapLarge(mapped, options.huge_pages);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+
+    if (options.numa_node != LargeAllocOptions::NoNode) {
+        const int node = options.numa_node == LargeAllocOptions::LocalNode ?
+                CurrentNumaNode() : options.numa_node;
+        if (node >= 0) {
+            BindToNode(p, mapped, node);
+        }
+    }
+    return p;
+#else
+    return ::operator new(size);
+#endif
+}
+
+void DeallocateLarge(void* p, std::size_t size)
+{
+    if (!p) {
+        return;
+    }
+#if defined(__linux__)
+    if (size >= LargeAllocThreshold) {
+        munmap(p, MappedSize(size));
+        return;
+    }
+#endif
+    ::operator delete(p);
+}
+
+} // namespace smpl
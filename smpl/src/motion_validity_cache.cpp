@@ -0,0 +1,304 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+/// \author Andrew Dornbush
+
+#include <smpl/motion_validity_cache.h>
+
+// standard includes
+#include <cmath>
+
+// system includes
+#include <boost/functional/hash.hpp>
+
+namespace smpl {
+
+MotionValidityCache::MotionValidityCache(double resolution) :
+    m_resolution(resolution),
+    m_version(0),
+    m_shards(new Shard[ShardCount]),
+    m_world_version(0),
+    m_epoch(0),
+    m_growth(0.0),
+    m_hits(0),
+    m_misses(0)
+{
+}
+
+void MotionValidityCache::invalidate()
+{
+    ++m_version;
+}
+
+void MotionValidityCache::clear()
+{
+    for (int i = 0; i < ShardCount; ++i) {
+        std::lock_guard<std::mutex> lock(m_shards[i].mutex);
+        m_shards[i].entries.clear();
+    }
+    ++m_version;
+    m_hits = 0;
+    m_misses = 0;
+}
+
+void MotionValidityCache::removeStale()
+{
+    for (int i = 0; i < ShardCount; ++i) {
+        auto& s = m_shards[i];
+        std::lock_guard<std::mutex> lock(s.mutex);
+        for (auto it = s.entries.begin(); it != s.entries.end(); ) {
+            if (fresh(it->second)) {
+                ++it;
+            } else {
+                it = s.entries.erase(it);
+            }
+        }
+    }
+}
+
+void MotionValidityCache::setWorld(
+    std::uint64_t version,
+    std::uint64_t epoch,
+    double growth)
+{
+    m_world_version = version;
+    m_epoch = epoch;
+    m_growth = growth;
+}
+
+bool MotionValidityCache::lookup(
+    const RobotState& start,
+    const RobotState& finish,
+    bool& valid) const
+{
+    Key key;
+    makeKey(start, finish, key);
+    auto& s = shard(key);
+
+    std::lock_guard<std::mutex> lock(s.mutex);
+    auto it = s.entries.find(key);
+    if (it == s.entries.end() || !fresh(it->second)) {
+        ++m_misses;
+        return false;
+    }
+    ++m_hits;
+    valid = it->second.valid;
+    return true;
+}
+
+void MotionValidityCache::insert(
+    const RobotState& start,
+    const RobotState& finish,
+    bool valid,
+    double clearance)
+{
+    Key key;
+    makeKey(start, finish, key);
+    auto& s = shard(key);
+    Entry entry;
+    entry.version = m_version;
+    entry.world_version = m_world_version;
+    entry.epoch = m_epoch;
+    entry.growth = m_growth;
+    entry.clearance = valid ? clearance : 0.0;
+    entry.valid = valid;
+
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.entries[std::move(key)] = entry;
+}
+
+auto MotionValidityCache::size() const -> std::size_t
+{
+    std::size_t count = 0;
+    for (int i = 0; i < ShardCount; ++i) {
+        std::lock_guard<std::mutex> lock(m_shards[i].mutex);
+        count += m_shards[i].entries.size();
+    }
+    return count;
+}
+
+// An entry is fresh if it was recorded in the current world, or if it
+// certifies a valid motion whose clearance exceeds the growth of the world
+// since.
+bool MotionValidityCache::fresh(const Entry& entry) const
+{
+    if (entry.version != m_version) {
+        return false;
+    }
+    if (entry.world_version == m_world_version) {
+        return true;
+    }
+    return entry.valid &&
+            entry.epoch == m_epoch &&
+            entry.clearance > m_growth - entry.growth;
+}
+
+auto MotionValidityCache::KeyHash::operator()(const Key& key) const
+    -> std::size_t
+{
+    return boost::hash_range(key.begin(), key.end());
+}
+
+void MotionValidityCache::makeKey(
+    const RobotState& start,
+    const RobotState& finish,
+    Key& key) const
+{
+    key.resize(start.size() + finish.size());
+    auto kit = key.begin();
+    for (double v : start) {
+        *kit++ = (std::int64_t)std::llround(v / m_resolution);
+    }
+    for (double v : finish) {
+        *kit++ = (std::int64_t)std::llround(v / m_resolution);
+    }
+}
+
+auto MotionValidityCache::shard(const Key& key) const -> Shard&
+{
+    return m_shards[KeyHash()(key) % ShardCount];
+}
+
+CachedCollisionChecker::CachedCollisionChecker(
+    CollisionChecker* checker,
+    MotionValidityCache* cache)
+:
+    m_checker(checker),
+    m_cache(cache),
+    m_wver_iface(checker->getExtension<CollisionWorldVersionExtension>()),
+    m_clearance_iface(checker->getExtension<CollisionClearanceExtension>()),
+    m_certify(false)
+{
+}
+
+void CachedCollisionChecker::syncWorld()
+{
+    if (m_wver_iface == NULL) {
+        return;
+    }
+    if (m_clearance_iface != NULL) {
+        m_cache->setWorld(
+                m_wver_iface->worldVersion(),
+                m_clearance_iface->growthEpoch(),
+                m_clearance_iface->worldGrowth());
+    } else {
+        m_cache->setWorld(m_wver_iface->worldVersion(), 0, 0.0);
+    }
+}
+
+bool CachedCollisionChecker::isStateValid(const RobotState& state, bool verbose)
+{
+    return m_checker->isStateValid(state, verbose);
+}
+
+bool CachedCollisionChecker::isStateValid(RobotStateView state, bool verbose)
+{
+    return m_checker->isStateValid(state, verbose);
+}
+
+bool CachedCollisionChecker::isStateToStateValid(
+    const RobotState& start,
+    const RobotState& finish,
+    bool verbose)
+{
+    syncWorld();
+
+    bool valid;
+    if (!verbose && m_cache->lookup(start, finish, valid)) {
+        return valid;
+    }
+
+    valid = m_checker->isStateToStateValid(start, finish, verbose);
+    auto clearance = 0.0;
+    if (valid && m_certify && m_clearance_iface != NULL) {
+        clearance = m_clearance_iface->motionClearance(start, finish);
+    }
+    m_cache->insert(start, finish, valid, clearance);
+    return valid;
+}
+
+bool CachedCollisionChecker::interpolatePath(
+    const RobotState& start,
+    const RobotState& finish,
+    std::vector<RobotState>& path)
+{
+    return m_checker->interpolatePath(start, finish, path);
+}
+
+bool CachedCollisionChecker::areStatesValid(
+    const RobotState* states,
+    size_t n,
+    bool* out)
+{
+    return m_checker->areStatesValid(states, n, out);
+}
+
+auto CachedCollisionChecker::getCollisionModelVisualization(
+    const RobotState& state)
+    -> std::vector<visual::Marker>
+{
+    return m_checker->getCollisionModelVisualization(state);
+}
+
+auto CachedCollisionChecker::clone() -> std::unique_ptr<CollisionChecker>
+{
+    auto* cloner = m_checker->getExtension<CollisionCheckerCloneExtension>();
+    if (!cloner) {
+        return nullptr;
+    }
+
+    auto checker = cloner->clone();
+    if (!checker) {
+        return nullptr;
+    }
+
+    std::unique_ptr<CachedCollisionChecker> cached(
+            new CachedCollisionChecker(checker.get(), m_cache));
+    cached->m_certify = m_certify;
+    cached->m_owned_checker = std::move(checker);
+    return std::move(cached);
+}
+
+auto CachedCollisionChecker::getExtension(size_t class_code) -> Extension*
+{
+    if (class_code == GetClassCode<CollisionChecker>() ||
+        class_code == GetClassCode<CachedCollisionChecker>())
+    {
+        return this;
+    }
+    if (class_code == GetClassCode<CollisionCheckerCloneExtension>()) {
+        if (m_checker->getExtension<CollisionCheckerCloneExtension>()) {
+            return this;
+        }
+        return nullptr;
+    }
+    return m_checker->getExtension(class_code);
+}
+
+} // namespace smpl
@@ -33,7 +33,11 @@
 #include <smpl/occupancy_grid.h>
 
 // standard includes
+#include <assert.h>
+#include <cmath>
+#include <limits>
 #include <memory>
+#include <mutex>
 
 // project includes
 #include <smpl/debug/marker_utils.h>
@@ -42,6 +46,129 @@
 
 namespace smpl {
 
+namespace {
+
+// An update as forwarded to a distance map, after reference counting, kept so
+// that it can be replayed onto the other map of a double-buffered grid
+struct MapUpdate
+{
+    enum Type { Add, Remove, Update, Reset };
+    Type type;
+    std::vector<Vector3> points;
+    std::vector<Vector3> new_points;
+};
+
+void ApplyMapUpdates(DistanceMapInterface& map, std::vector<MapUpdate>& updates)
+{
+    for (auto& update : updates) {
+        switch (update.type) {
+        case MapUpdate::Add:
+            map.addPointsToMap(update.points);
+            break;
+        case MapUpdate::Remove:
+            map.removePointsFromMap(update.points);
+            break;
+        case MapUpdate::Update:
+            map.updatePointsInMap(update.points, update.new_points);
+            break;
+        case MapUpdate::Reset:
+            map.reset();
+            break;
+        }
+    }
+    updates.clear();
+}
+
+// Visit the cells crossed by the segment from a to b, given in continuous cell
+// coordinates, that lie within a grid of the given size.
+template <typename CellFunction>
+void TraceSegment(
+    const Vector3& a,
+    const Vector3& b,
+    const int size[3],
+    CellFunction f)
+{
+    // clip the segment to the grid bounds
+    const Vector3 d = b - a;
+    double t0 = 0.0;
+    double t1 = 1.0;
+    for (int i = 0; i < 3; ++i) {
+        if (d[i] == 0.0) {
+            if (a[i] < 0.0 || a[i] >= size[i]) {
+                return;
+            }
+            continue;
+        }
+        double ta = -a[i] / d[i];
+        double tb = (size[i] - a[i]) / d[i];
+        if (ta > tb) {
+            std::swap(ta, tb);
+        }
+        t0 = std::max(t0, ta);
+        t1 = std::min(t1, tb);
+        if (t0 > t1) {
+            return;
+        }
+    }
+
+    const Vector3 p = a + t0 * d;
+    const Vector3 q = a + t1 * d;
+
+    int c[3];
+    int step[3];
+    double t_max[3];
+    double t_delta[3];
+    int steps = 0;
+    for (int i = 0; i < 3; ++i) {
+        c[i] = std::min(std::max((int)std::floor(p[i]), 0), size[i] - 1);
+        const int last = std::min(std::max((int)std::floor(q[i]), 0), size[i] - 1);
+        steps += std::abs(last - c[i]);
+        if (d[i] > 0.0) {
+            step[i] = 1;
+            t_max[i] = (c[i] + 1 - a[i]) / d[i];
+            t_delta[i] = 1.0 / d[i];
+        } else if (d[i] < 0.0) {
+            step[i] = -1;
+            t_max[i] = (c[i] - a[i]) / d[i];
+            t_delta[i] = -1.0 / d[i];
+        } else {
+            step[i] = 0;
+            t_max[i] = std::numeric_limits<double>::infinity();
+            t_delta[i] = std::numeric_limits<double>::infinity();
+        }
+    }
+
+    f(c[0], c[1], c[2]);
+    for (int n = 0; n < steps; ++n) {
+        int i = 0;
+        if (t_max[1] < t_max[i]) i = 1;
+        if (t_max[2] < t_max[i]) i = 2;
+        c[i] += step[i];
+        if (c[i] < 0 || c[i] >= size[i]) {
+            return;
+        }
+        t_max[i] += t_delta[i];
+        f(c[0], c[1], c[2]);
+    }
+}
+
+} // namespace
+
+struct OccupancyGrid::ShadowBuffer
+{
+    // guards everything below and the reference counts
+    std::mutex mutex;
+
+    // the distance map receiving staged updates
+    std::shared_ptr<DistanceMapInterface> map;
+
+    // immediate updates applied to the current map but not yet to the shadow
+    std::vector<MapUpdate> shadow_lag;
+
+    // staged updates applied to the shadow map but not yet to the current map
+    std::vector<MapUpdate> staged;
+};
+
 /// \class OccupancyGrid
 ///
 /// OccupancyGrid is a lightweight wrapper around DistanceMapInterface, with
@@ -73,6 +200,7 @@ OccupancyGrid::OccupancyGrid()
     m_ref_counted = false;
     m_x_stride = 0;
     m_y_stride = 0;
+    m_has_view = false;
 }
 
 /// Construct an Occupancy Grid.
@@ -107,9 +235,10 @@ OccupancyGrid::OccupancyGrid(
     m_y_stride(m_grid->numCellsZ()),
     m_counts()
 {
+    updateView();
     // distance field guaranteed to be empty -> faster initialization
     if (m_ref_counted) {
-        m_counts.assign(getCellCount(), 0);
+        m_counts.resize(numCellsX(), numCellsY(), numCellsZ(), 0);
     }
 }
 
@@ -128,21 +257,29 @@ OccupancyGrid::OccupancyGrid(
     m_y_stride(m_grid->numCellsZ()),
     m_counts()
 {
+    updateView();
     initRefCounts();
 }
 
-/// Copy constructor. Constructs the Occupancy Grid with a deep copy of the
-/// contents of \p o.
+/// Copy constructor. Constructs the Occupancy Grid with a copy of the contents
+/// of \p o. Reference counts, and the cells of distance maps that support it
+/// (e.g. smpl::SparseDistanceMap), are shared with \p o until modified.
 OccupancyGrid::OccupancyGrid(const OccupancyGrid& o) :
     m_grid(o.m_grid->clone()),
     reference_frame_(o.reference_frame_),
     m_ref_counted(o.m_ref_counted),
     m_x_stride(o.m_x_stride),
     m_y_stride(o.m_y_stride),
-    m_counts(o.m_counts)
+    m_counts(o.m_counts),
+    m_sensed(o.m_sensed)
 {
+    updateView();
 }
 
+OccupancyGrid::OccupancyGrid(OccupancyGrid&& o) = default;
+
+OccupancyGrid::~OccupancyGrid() = default;
+
 OccupancyGrid& OccupancyGrid::operator=(const OccupancyGrid& rhs)
 {
     if (this != &rhs) {
@@ -152,20 +289,127 @@ OccupancyGrid& OccupancyGrid::operator=(const OccupancyGrid& rhs)
         m_x_stride = rhs.m_x_stride;
         m_y_stride = rhs.m_y_stride;
         m_counts = rhs.m_counts;
+        m_shadow.reset();
+        m_sensed = rhs.m_sensed;
+        updateView();
     }
     return *this;
 }
 
+OccupancyGrid& OccupancyGrid::operator=(OccupancyGrid&& rhs) = default;
+
 /// Reset the grid, removing all obstacles setting distances to their
 /// uninitialized values.
 void OccupancyGrid::reset()
 {
+    if (m_shadow) {
+        std::lock_guard<std::mutex> lock(m_shadow->mutex);
+        m_grid->reset();
+        if (m_ref_counted) {
+            m_counts.reset(0);
+        }
+        m_shadow->shadow_lag.push_back(MapUpdate{ MapUpdate::Reset, { }, { } });
+        m_sensed.clear();
+        return;
+    }
+
     m_grid->reset();
     if (m_ref_counted) {
-        m_counts.assign(getCellCount(), 0);
+        m_counts.reset(0);
+    }
+    m_sensed.clear();
+}
+
+/// Enable or disable double buffering. Enabling double buffering allocates a
+/// copy of the distance map. Updates that are staged when double buffering is
+/// disabled are applied to the current map.
+void OccupancyGrid::setDoubleBuffered(bool enabled)
+{
+    if (enabled) {
+        if (!m_shadow) {
+            m_shadow.reset(new ShadowBuffer);
+            m_shadow->map.reset(m_grid->clone());
+        }
+    } else if (m_shadow) {
+        ApplyMapUpdates(*m_grid, m_shadow->staged);
+        m_shadow.reset();
     }
 }
 
+/// Stage a set of obstacle cells to be added, to be published by the next
+/// successful call to swapBuffers. May be called concurrently with lookups.
+void OccupancyGrid::stageAddPoints(const std::vector<Vector3>& points)
+{
+    assert(m_shadow);
+    std::lock_guard<std::mutex> lock(m_shadow->mutex);
+    ApplyMapUpdates(*m_shadow->map, m_shadow->shadow_lag);
+    MapUpdate update{ MapUpdate::Add, filterAddedPoints(points), { } };
+    m_shadow->map->addPointsToMap(update.points);
+    m_shadow->staged.push_back(std::move(update));
+}
+
+/// Stage a set of obstacle cells to be removed, to be published by the next
+/// successful call to swapBuffers. May be called concurrently with lookups.
+void OccupancyGrid::stageRemovePoints(const std::vector<Vector3>& points)
+{
+    assert(m_shadow);
+    std::lock_guard<std::mutex> lock(m_shadow->mutex);
+    ApplyMapUpdates(*m_shadow->map, m_shadow->shadow_lag);
+    MapUpdate update{ MapUpdate::Remove, filterRemovedPoints(points), { } };
+    m_shadow->map->removePointsFromMap(update.points);
+    m_shadow->staged.push_back(std::move(update));
+}
+
+/// Stage the replacement of one set of obstacle cells with another, as by
+/// updatePointsInField(), to be published by the next successful call to
+/// swapBuffers. May be called concurrently with lookups.
+void OccupancyGrid::stageUpdatePoints(
+    const std::vector<Vector3>& old_points,
+    const std::vector<Vector3>& new_points)
+{
+    assert(m_shadow);
+    std::lock_guard<std::mutex> lock(m_shadow->mutex);
+    ApplyMapUpdates(*m_shadow->map, m_shadow->shadow_lag);
+    MapUpdate update{
+            MapUpdate::Update,
+            filterRemovedPoints(old_points),
+            filterAddedPoints(new_points) };
+    m_shadow->map->updatePointsInMap(update.points, update.new_points);
+    m_shadow->staged.push_back(std::move(update));
+}
+
+/// Publish all staged updates by exchanging the current and shadow distance
+/// maps. The exchange is skipped, rather than waiting, while a staged update
+/// is in progress, so the caller is never held up by a long update.
+///
+/// \return true if staged updates were published; false otherwise
+bool OccupancyGrid::swapBuffers()
+{
+    if (!m_shadow) {
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(m_shadow->mutex, std::try_to_lock);
+    if (!lock.owns_lock() || m_shadow->staged.empty()) {
+        return false;
+    }
+
+    ApplyMapUpdates(*m_shadow->map, m_shadow->shadow_lag);
+    std::swap(m_grid, m_shadow->map);
+    updateView();
+
+    // the previous map is now the shadow and is behind by the staged updates,
+    // which are replayed onto it before the next staged update
+    m_shadow->shadow_lag = std::move(m_shadow->staged);
+    m_shadow->staged.clear();
+    return true;
+}
+
+void OccupancyGrid::updateView()
+{
+    m_has_view = m_grid && m_grid->getView(m_view);
+}
+
 /// Count the number of obstacles in the occupancy grid.
 size_t OccupancyGrid::getOccupiedVoxelCount() const
 {
@@ -361,26 +605,17 @@ auto OccupancyGrid::getOccupiedVoxelsVisualization() const -> visual::Marker
 void OccupancyGrid::addPointsToField(
     const std::vector<Vector3>& points)
 {
-    if (m_ref_counted) {
-        std::vector<Vector3> pts;
-        pts.reserve(points.size());
-        int gx, gy, gz;
-        for (const Vector3& v : points) {
-            worldToGrid(v.x(), v.y(), v.z(), gx, gy, gz);
-
-            if (isInBounds(gx, gy, gz)) {
-                const int idx = coordToIndex(gx, gy, gz);
-
-                if (m_counts[idx] == 0) {
-                    pts.emplace_back(v.x(), v.y(), v.z());
-                }
-
-                ++m_counts[idx];
-            }
-        }
-        m_grid->addPointsToMap(pts);
+    if (m_shadow) {
+        std::lock_guard<std::mutex> lock(m_shadow->mutex);
+        MapUpdate update{ MapUpdate::Add, filterAddedPoints(points), { } };
+        m_grid->addPointsToMap(update.points);
+        m_shadow->shadow_lag.push_back(std::move(update));
+        return;
     }
-    else {
+
+    if (m_ref_counted) {
+        m_grid->addPointsToMap(filterAddedPoints(points));
+    } else {
         m_grid->addPointsToMap(points);
     }
 }
@@ -389,27 +624,17 @@ void OccupancyGrid::addPointsToField(
 void OccupancyGrid::removePointsFromField(
     const std::vector<Vector3>& points)
 {
-    if (m_ref_counted) {
-        std::vector<Vector3> pts;
-        pts.reserve(points.size());
-        int gx, gy, gz;
-        for (const Vector3& v : points) {
-            worldToGrid(v.x(), v.y(), v.z(), gx, gy, gz);
-
-            if (isInBounds(gx, gy, gz)) {
-                int idx = coordToIndex(gx, gy, gz);
-
-                if (m_counts[idx] > 0) {
-                    --m_counts[idx];
-                    if (m_counts[idx] == 0) {
-                        pts.emplace_back(v.x(), v.y(), v.z());
-                    }
-                }
-            }
-        }
-        m_grid->removePointsFromMap(pts);
+    if (m_shadow) {
+        std::lock_guard<std::mutex> lock(m_shadow->mutex);
+        MapUpdate update{ MapUpdate::Remove, filterRemovedPoints(points), { } };
+        m_grid->removePointsFromMap(update.points);
+        m_shadow->shadow_lag.push_back(std::move(update));
+        return;
     }
-    else {
+
+    if (m_ref_counted) {
+        m_grid->removePointsFromMap(filterRemovedPoints(points));
+    } else {
         m_grid->removePointsFromMap(points);
     }
 }
@@ -417,30 +642,298 @@ void OccupancyGrid::removePointsFromField(
 /// Update the occupancy grid, removing obstacles that exist in the old obstacle
 /// set, but not in the new obstacle set, and adding obstacles that exist in the
 /// new obstacle set, but not in the old obstacle set.
+///
+/// With reference counting, the old points are released before the new points
+/// are acquired, so cells present in both sets are left untouched.
 void OccupancyGrid::updatePointsInField(
     const std::vector<Vector3>& old_points,
     const std::vector<Vector3>& new_points)
 {
-    // TODO: ref counting
-    m_grid->updatePointsInMap(old_points, new_points);
+    if (m_shadow) {
+        std::lock_guard<std::mutex> lock(m_shadow->mutex);
+        MapUpdate update{
+                MapUpdate::Update,
+                filterRemovedPoints(old_points),
+                filterAddedPoints(new_points) };
+        m_grid->updatePointsInMap(update.points, update.new_points);
+        m_shadow->shadow_lag.push_back(std::move(update));
+        return;
+    }
+
+    if (m_ref_counted) {
+        auto removed = filterRemovedPoints(old_points);
+        auto added = filterAddedPoints(new_points);
+        m_grid->updatePointsInMap(removed, added);
+    } else {
+        m_grid->updatePointsInMap(old_points, new_points);
+    }
+}
+
+/// Insert the points observed in a depth image.
+///
+/// \param depth Row-major depth values, in meters, along the optical axis.
+///     Values that are not positive and finite are ignored.
+/// \param intrinsics The pinhole parameters of the camera
+/// \param sensor_pose The pose of the camera's optical frame, which has z
+///     forward, x right, and y down, in the grid frame
+/// \param max_range Points farther than this from the sensor are not inserted,
+///     but the cells on the way to them are still cleared. A non-positive range
+///     is unlimited.
+void OccupancyGrid::insertDepthImage(
+    const float* depth,
+    int width,
+    int height,
+    const CameraIntrinsics& intrinsics,
+    const Affine3& sensor_pose,
+    double max_range)
+{
+    const double inv_fx = 1.0 / intrinsics.fx;
+    const double inv_fy = 1.0 / intrinsics.fy;
+    insertSensorRays(sensor_pose, width * height, max_range,
+            [&](int i, Vector3& p)
+            {
+                const double z = depth[i];
+                if (!(z > 0.0) || !std::isfinite(z)) {
+                    return false;
+                }
+                const int u = i % width;
+                const int v = i / width;
+                p.x() = (u - intrinsics.cx) * z * inv_fx;
+                p.y() = (v - intrinsics.cy) * z * inv_fy;
+                p.z() = z;
+                return true;
+            });
+}
+
+/// Insert the points of an organized point cloud.
+///
+/// \param points Row-major point coordinates, in the sensor frame, with the
+///     x, y, and z coordinates of each point stored consecutively. Points with
+///     non-finite coordinates are ignored.
+/// \param point_stride The number of floats between consecutive points
+/// \param sensor_pose The pose of the sensor frame in the grid frame
+/// \param max_range Points farther than this from the sensor are not inserted,
+///     but the cells on the way to them are still cleared. A non-positive range
+///     is unlimited.
+void OccupancyGrid::insertPointCloud(
+    const float* points,
+    int width,
+    int height,
+    int point_stride,
+    const Affine3& sensor_pose,
+    double max_range)
+{
+    insertSensorRays(sensor_pose, width * height, max_range,
+            [&](int i, Vector3& p)
+            {
+                const float* xyz = points + (size_t)i * point_stride;
+                if (!std::isfinite(xyz[0]) ||
+                    !std::isfinite(xyz[1]) ||
+                    !std::isfinite(xyz[2]))
+                {
+                    return false;
+                }
+                p = Vector3(xyz[0], xyz[1], xyz[2]);
+                return true;
+            });
+}
+
+/// Remove all cells inserted by sensor updates.
+void OccupancyGrid::clearSensorCells()
+{
+    std::vector<Vector3> points;
+    for (size_t idx = 0; idx < m_sensed.size(); ++idx) {
+        if (m_sensed[idx]) {
+            const int x = (int)idx / m_x_stride;
+            const int y = ((int)idx % m_x_stride) / m_y_stride;
+            const int z = (int)idx % m_y_stride;
+            Vector3 p;
+            gridToWorld(x, y, z, p.x(), p.y(), p.z());
+            points.push_back(p);
+        }
+    }
+    m_sensed.clear();
+    removePointsFromField(points);
+}
+
+/// Trace a ray from the sensor to each of a set of points, given in the sensor
+/// frame by get_point(i, p), which returns false for invalid points. Hit and
+/// passed cells are deduplicated in bitsets as they are traced, and the point
+/// lists are built only for the cells whose sensed state changes.
+template <typename PointFunction>
+void OccupancyGrid::insertSensorRays(
+    const Affine3& sensor_pose,
+    int count,
+    double max_range,
+    PointFunction get_point)
+{
+    const int cell_count = getCellCount();
+    if (m_sensed.size() != (size_t)cell_count) {
+        m_sensed.assign(cell_count, false);
+    }
+    if (m_sensor_hit.size() != (size_t)cell_count) {
+        m_sensor_hit.assign(cell_count, false);
+        m_sensor_passed.assign(cell_count, false);
+    }
+
+    const int size[3] = { numCellsX(), numCellsY(), numCellsZ() };
+
+    // transform from the sensor frame to continuous cell coordinates, in which
+    // cell (x, y, z) spans [x, x + 1) x [y, y + 1) x [z, z + 1)
+    const double inv_res = 1.0 / resolution();
+    const Vector3 cell_offset(
+            0.5 - originX() * inv_res,
+            0.5 - originY() * inv_res,
+            0.5 - originZ() * inv_res);
+    const Affine3 T_cell_sensor =
+            Translation3(cell_offset) * Scaling(inv_res) * sensor_pose;
+    const Vector3 start = T_cell_sensor.translation();
+
+    const bool limited = max_range > 0.0;
+    const double max_range_sqrd = max_range * max_range;
+
+    Vector3 p;
+    for (int i = 0; i < count; ++i) {
+        if (!get_point(i, p)) {
+            continue;
+        }
+
+        bool hit = true;
+        const double range_sqrd = p.squaredNorm();
+        if (limited && range_sqrd > max_range_sqrd) {
+            p *= max_range / std::sqrt(range_sqrd);
+            hit = false;
+        }
+
+        const Vector3 end = T_cell_sensor * p;
+
+        TraceSegment(start, end, size, [&](int x, int y, int z)
+        {
+            const int idx = coordToIndex(x, y, z);
+            if (m_sensed[idx] && !m_sensor_passed[idx]) {
+                m_sensor_passed[idx] = true;
+                m_sensor_passed_cells.push_back(idx);
+            }
+        });
+
+        if (!hit) {
+            continue;
+        }
+
+        const int x = (int)std::floor(end.x());
+        const int y = (int)std::floor(end.y());
+        const int z = (int)std::floor(end.z());
+        if (!isInBounds(x, y, z)) {
+            continue;
+        }
+        const int idx = coordToIndex(x, y, z);
+        if (!m_sensor_hit[idx]) {
+            m_sensor_hit[idx] = true;
+            m_sensor_hit_cells.push_back(idx);
+        }
+    }
+
+    auto cell_center = [&](int idx)
+    {
+        const int x = idx / m_x_stride;
+        const int y = (idx % m_x_stride) / m_y_stride;
+        const int z = idx % m_y_stride;
+        Vector3 c;
+        gridToWorld(x, y, z, c.x(), c.y(), c.z());
+        return c;
+    };
+
+    std::vector<Vector3> old_points;
+    for (const int idx : m_sensor_passed_cells) {
+        if (!m_sensor_hit[idx]) {
+            m_sensed[idx] = false;
+            old_points.push_back(cell_center(idx));
+        }
+        m_sensor_passed[idx] = false;
+    }
+    m_sensor_passed_cells.clear();
+
+    std::vector<Vector3> new_points;
+    for (const int idx : m_sensor_hit_cells) {
+        if (!m_sensed[idx]) {
+            m_sensed[idx] = true;
+            new_points.push_back(cell_center(idx));
+        }
+        m_sensor_hit[idx] = false;
+    }
+    m_sensor_hit_cells.clear();
+
+    if (!old_points.empty() || !new_points.empty()) {
+        updatePointsInField(old_points, new_points);
+    }
+}
+
+/// Return the points whose cells become occupied by adding points, updating
+/// the reference counts of their cells. Without reference counting, return
+/// all points.
+auto OccupancyGrid::filterAddedPoints(const std::vector<Vector3>& points)
+    -> std::vector<Vector3>
+{
+    if (!m_ref_counted) {
+        return points;
+    }
+
+    std::vector<Vector3> pts;
+    pts.reserve(points.size());
+    int gx, gy, gz;
+    for (const Vector3& v : points) {
+        worldToGrid(v.x(), v.y(), v.z(), gx, gy, gz);
+        if (isInBounds(gx, gy, gz)) {
+            int& count = m_counts(gx, gy, gz);
+            if (count == 0) {
+                pts.emplace_back(v.x(), v.y(), v.z());
+            }
+            ++count;
+        }
+    }
+    return pts;
+}
+
+/// Return the points whose cells become free by removing points, updating the
+/// reference counts of their cells. Without reference counting, return all
+/// points.
+auto OccupancyGrid::filterRemovedPoints(const std::vector<Vector3>& points)
+    -> std::vector<Vector3>
+{
+    if (!m_ref_counted) {
+        return points;
+    }
+
+    std::vector<Vector3> pts;
+    pts.reserve(points.size());
+    int gx, gy, gz;
+    for (const Vector3& v : points) {
+        worldToGrid(v.x(), v.y(), v.z(), gx, gy, gz);
+        if (isInBounds(gx, gy, gz)) {
+            if (m_counts.get(gx, gy, gz) > 0) {
+                int& count = m_counts(gx, gy, gz);
+                --count;
+                if (count == 0) {
+                    pts.emplace_back(v.x(), v.y(), v.z());
+                }
+            }
+        }
+    }
+    return pts;
 }
 
 void OccupancyGrid::initRefCounts()
 {
     if (!m_ref_counted) {
-        m_counts.clear();
+        m_counts.resize(0, 0, 0, 0);
         return;
     }
 
-    int gidx = 0;
-    m_counts.resize(getCellCount());
+    m_counts.resize(numCellsX(), numCellsY(), numCellsZ(), 0);
     iterateCells([&](int x, int y, int z)
     {
         if (m_grid->getCellDistance(x, y, z) <= 0.0) {
-            m_counts[gidx++] = 1;
-        }
-        else {
-            m_counts[gidx++] = 0;
+            m_counts(x, y, z) = 1;
         }
     });
 }
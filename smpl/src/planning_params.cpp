@@ -34,6 +34,7 @@
 
 // standard includes
 #include <sstream>
+#include <utility>
 
 // system includes
 #include <smpl/console/console.h>
@@ -56,6 +57,104 @@ std::string to_string(ShortcutType type)
     }
 }
 
+namespace {
+
+using CPP = CompiledPlanningParams;
+
+// Reference to the field of CompiledPlanningParams that stores a parameter
+using CompiledField = boost::variant<
+        bool CPP::*,
+        int CPP::*,
+        double CPP::*,
+        std::string CPP::*,
+        boost::optional<bool> CPP::*,
+        boost::optional<int> CPP::*,
+        boost::optional<double> CPP::*,
+        boost::optional<std::string> CPP::*>;
+
+// Map from parameter name to the field that stores it. This is the schema
+// for CompiledPlanningParams; parameters not listed here are only available
+// through PlanningParams::param and PlanningParams::getParam.
+auto CompiledFields() -> const std::unordered_map<std::string, CompiledField>&
+{
+#define SMPL_COMPILED_FIELD(name) { #name, CompiledField(&CPP::name) }
+    static const std::unordered_map<std::string, CompiledField> fields =
+    {
+        SMPL_COMPILED_FIELD(discretization),
+        SMPL_COMPILED_FIELD(mprim_filename),
+        SMPL_COMPILED_FIELD(use_multiple_ik_solutions),
+        SMPL_COMPILED_FIELD(use_ik_cache),
+        SMPL_COMPILED_FIELD(ik_sampling_seeds),
+        SMPL_COMPILED_FIELD(ik_sampling_threads),
+        SMPL_COMPILED_FIELD(use_clearance_scaling),
+        SMPL_COMPILED_FIELD(clearance_scaling_min),
+        SMPL_COMPILED_FIELD(clearance_scaling_max),
+        SMPL_COMPILED_FIELD(clearance_scaling_max_scale),
+        SMPL_COMPILED_FIELD(use_xyz_snap_mprim),
+        SMPL_COMPILED_FIELD(use_rpy_snap_mprim),
+        SMPL_COMPILED_FIELD(use_xyzrpy_snap_mprim),
+        SMPL_COMPILED_FIELD(use_short_dist_mprims),
+        SMPL_COMPILED_FIELD(xyz_snap_dist_thresh),
+        SMPL_COMPILED_FIELD(rpy_snap_dist_thresh),
+        SMPL_COMPILED_FIELD(xyzrpy_snap_dist_thresh),
+        SMPL_COMPILED_FIELD(short_dist_mprims_thresh),
+        SMPL_COMPILED_FIELD(action_check_threads),
+        SMPL_COMPILED_FIELD(ordered_expansion),
+        SMPL_COMPILED_FIELD(ordered_expansion_early_exit),
+        SMPL_COMPILED_FIELD(space_memory_limit),
+        SMPL_COMPILED_FIELD(egraph_path),
+        SMPL_COMPILED_FIELD(egraph_load_threads),
+
+        SMPL_COMPILED_FIELD(bfs_inflation_radius),
+        SMPL_COMPILED_FIELD(bfs_threads),
+        SMPL_COMPILED_FIELD(soft_bfs_clearance),
+        SMPL_COMPILED_FIELD(soft_bfs_clearance_weight),
+        SMPL_COMPILED_FIELD(mfbfs_ee_cell_scale),
+        SMPL_COMPILED_FIELD(offset_x),
+        SMPL_COMPILED_FIELD(offset_y),
+        SMPL_COMPILED_FIELD(offset_z),
+        SMPL_COMPILED_FIELD(x_coeff),
+        SMPL_COMPILED_FIELD(y_coeff),
+        SMPL_COMPILED_FIELD(z_coeff),
+        SMPL_COMPILED_FIELD(rot_coeff),
+        SMPL_COMPILED_FIELD(turning_radius),
+        SMPL_COMPILED_FIELD(dubins_table_extent),
+        SMPL_COMPILED_FIELD(dubins_table_res),
+        SMPL_COMPILED_FIELD(dubins_table_headings),
+        SMPL_COMPILED_FIELD(egraph_epsilon),
+
+        SMPL_COMPILED_FIELD(open_list),
+        SMPL_COMPILED_FIELD(epsilon),
+        SMPL_COMPILED_FIELD(epsilon_mha),
+        SMPL_COMPILED_FIELD(epsilon_plan),
+        SMPL_COMPILED_FIELD(epsilon_track),
+        SMPL_COMPILED_FIELD(pipeline_plan_track),
+        SMPL_COMPILED_FIELD(independence_epsilon),
+        SMPL_COMPILED_FIELD(search_mode),
+        SMPL_COMPILED_FIELD(thread_count),
+        SMPL_COMPILED_FIELD(concurrent_successors),
+        SMPL_COMPILED_FIELD(allow_partial_solutions),
+        SMPL_COMPILED_FIELD(backward_search),
+        SMPL_COMPILED_FIELD(target_epsilon),
+        SMPL_COMPILED_FIELD(delta_epsilon),
+        SMPL_COMPILED_FIELD(improve_solution),
+        SMPL_COMPILED_FIELD(bound_expansions),
+        SMPL_COMPILED_FIELD(repair_time),
+        SMPL_COMPILED_FIELD(search_memory_limit),
+        SMPL_COMPILED_FIELD(goal_set_search),
+        SMPL_COMPILED_FIELD(goal_set_count),
+        SMPL_COMPILED_FIELD(egraph_successor_period),
+        SMPL_COMPILED_FIELD(adaptive_egraph),
+        SMPL_COMPILED_FIELD(min_egraph_epsilon),
+        SMPL_COMPILED_FIELD(max_egraph_epsilon),
+        SMPL_COMPILED_FIELD(egraph_adaptation_window),
+    };
+#undef SMPL_COMPILED_FIELD
+    return fields;
+}
+
+} // namespace
+
 PlanningParams::PlanningParams() :
     cost_per_cell(DefaultCostPerCell),
 
@@ -77,22 +176,30 @@ std::string construct_warn_string(const std::string& name, T def)
 
 void PlanningParams::addParam(const std::string& name, bool val)
 {
-    params[name] = val;
+    Parameter p(val);
+    compileParam(name, p);
+    params[name] = std::move(p);
 }
 
 void PlanningParams::addParam(const std::string& name, int val)
 {
-    params[name] = val;
+    Parameter p(val);
+    compileParam(name, p);
+    params[name] = std::move(p);
 }
 
 void PlanningParams::addParam(const std::string& name, double val)
 {
-    params[name] = val;
+    Parameter p(val);
+    compileParam(name, p);
+    params[name] = std::move(p);
 }
 
 void PlanningParams::addParam(const std::string& name, const std::string& val)
 {
-    params[name] = val;
+    Parameter p(val);
+    compileParam(name, p);
+    params[name] = std::move(p);
 }
 
 void PlanningParams::param(const std::string& name, bool& val, bool def) const
@@ -251,4 +358,42 @@ void PlanningParams::convertToString(const Parameter& p, std::string& val) const
     val = boost::apply_visitor(string_converter(), p);
 }
 
+// Convert a parameter into its field in the compiled parameters, if it has
+// one. Conversion errors are reported here, when the parameter is added,
+// rather than when a pipeline is constructed.
+void PlanningParams::compileParam(const std::string& name, const Parameter& p)
+{
+    auto it = CompiledFields().find(name);
+    if (it == end(CompiledFields())) {
+        return;
+    }
+
+    struct field_compiler : public boost::static_visitor<void> {
+        PlanningParams* pp;
+        const Parameter* p;
+
+        void operator()(bool CPP::* f) const { pp->convertToBool(*p, pp->m_compiled.*f); }
+        void operator()(int CPP::* f) const { pp->convertToInt(*p, pp->m_compiled.*f); }
+        void operator()(double CPP::* f) const { pp->convertToDouble(*p, pp->m_compiled.*f); }
+        void operator()(std::string CPP::* f) const { pp->convertToString(*p, pp->m_compiled.*f); }
+
+        void operator()(boost::optional<bool> CPP::* f) const { bool val; pp->convertToBool(*p, val); pp->m_compiled.*f = val; }
+        void operator()(boost::optional<int> CPP::* f) const { int val; pp->convertToInt(*p, val); pp->m_compiled.*f = val; }
+        void operator()(boost::optional<double> CPP::* f) const { double val; pp->convertToDouble(*p, val); pp->m_compiled.*f = val; }
+        void operator()(boost::optional<std::string> CPP::* f) const { std::string val; pp->convertToString(*p, val); pp->m_compiled.*f = val; }
+    };
+
+    field_compiler compiler;
+    compiler.pp = this;
+    compiler.p = &p;
+    try {
+        boost::apply_visitor(compiler, it->second);
+    } catch (const std::logic_error& ex) {
+        // std::stoi and std::stod throw std::invalid_argument and
+        // std::out_of_range for malformed values
+        throw ParameterException(
+                "Parameter '" + name + "' has malformed value (" + ex.what() + ")");
+    }
+}
+
 } // namespace smpl
@@ -33,8 +33,15 @@
 #include <smpl/post_processing.h>
 
 // standard includes
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <memory>
 #include <numeric>
+#include <random>
+#include <utility>
 
 // project includes
 #include <smpl/angles.h>
@@ -42,7 +49,9 @@
 #include <smpl/console/console.h>
 #include <smpl/console/nonstd.h>
 #include <smpl/geometry/shortcut.h>
+#include <smpl/motion_validity_cache.h>
 #include <smpl/spatial.h>
+#include <smpl/worker_pool.h>
 
 namespace smpl {
 
@@ -96,9 +105,14 @@ class JointPositionShortcutPathGenerator
 {
 public:
 
-    JointPositionShortcutPathGenerator(RobotModel* rm, CollisionChecker* cc) :
+    JointPositionShortcutPathGenerator(
+        RobotModel* rm,
+        CollisionChecker* cc,
+        const CancellationToken* token)
+    :
         m_robot(rm),
-        m_cc(cc)
+        m_cc(cc),
+        m_cancel(token)
     { }
 
     template <typename OutputIt>
@@ -106,6 +120,10 @@ public:
         const RobotState& start, const RobotState& finish,
         OutputIt ofirst, double& cost) const
     {
+        if (Expired(m_cancel)) {
+            return false;
+        }
+
         const size_t var_count = m_robot->getPlanningJoints().size();
         if (m_cc->isStateToStateValid(start, finish)) {
             *ofirst++ = start;
@@ -122,6 +140,7 @@ private:
 
     RobotModel* m_robot;
     CollisionChecker* m_cc;
+    const CancellationToken* m_cancel;
 };
 
 class JointPositionVelocityShortcutPathGenerator
@@ -130,10 +149,12 @@ public:
 
     JointPositionVelocityShortcutPathGenerator(
         RobotModel* rm,
-        CollisionChecker* cc)
+        CollisionChecker* cc,
+        const CancellationToken* token)
     :
         m_robot(rm),
-        m_cc(cc)
+        m_cc(cc),
+        m_cancel(token)
     { }
 
     template <typename OutputIt>
@@ -141,6 +162,10 @@ public:
         const RobotState& start, const RobotState& finish,
         OutputIt ofirst, double& cost) const
     {
+        if (Expired(m_cancel)) {
+            return false;
+        }
+
         const size_t var_count = m_robot->getPlanningJoints().size();
         const RobotState pstart(start.begin(), start.begin() + var_count);
         const RobotState pend(finish.begin(), finish.begin() + var_count);
@@ -159,15 +184,21 @@ private:
 
     RobotModel* m_robot;
     CollisionChecker* m_cc;
+    const CancellationToken* m_cancel;
 };
 
 class EuclidShortcutPathGenerator
 {
 public:
 
-    EuclidShortcutPathGenerator(RobotModel* rm, CollisionChecker* cc) :
+    EuclidShortcutPathGenerator(
+        RobotModel* rm,
+        CollisionChecker* cc,
+        const CancellationToken* token)
+    :
         m_rm(rm),
         m_cc(cc),
+        m_cancel(token),
         m_fk_iface(nullptr),
         m_ik_iface(nullptr)
     {
@@ -180,7 +211,7 @@ public:
         const RobotState& start, const RobotState& end,
         OutputIt ofirst, double& cost) const
     {
-        if (!m_fk_iface || !m_ik_iface) {
+        if (!m_fk_iface || !m_ik_iface || Expired(m_cancel)) {
             return false;
         }
 
@@ -231,7 +262,7 @@ public:
             }
 
             // check the path segment for collisions
-            if (!m_cc->isStateToStateValid(prev_wp, wp)) {
+            if (Expired(m_cancel) || !m_cc->isStateToStateValid(prev_wp, wp)) {
                 return false;
             }
 
@@ -251,6 +282,7 @@ private:
 
     RobotModel* m_rm;
     CollisionChecker* m_cc;
+    const CancellationToken* m_cancel;
 
     ForwardKinematicsInterface* m_fk_iface;
     InverseKinematicsInterface* m_ik_iface;
@@ -261,7 +293,8 @@ void ShortcutPath(
     CollisionChecker* cc,
     const std::vector<RobotState>& pin,
     std::vector<RobotState>& pout,
-    ShortcutType type)
+    ShortcutType type,
+    const CancellationToken* token)
 {
     if (pin.size() < 2) {
         pout = pin;
@@ -277,7 +310,7 @@ void ShortcutPath(
         ComputePositionPathCosts(rm, pin, costs);
         JointPositionShortcutPathGenerator generators[] =
         {
-            JointPositionShortcutPathGenerator(rm, cc)
+            JointPositionShortcutPathGenerator(rm, cc, token)
         };
         shortcut::ShortcutPath(
                 pin.begin(), pin.end(),
@@ -292,7 +325,7 @@ void ShortcutPath(
 
         EuclidShortcutPathGenerator generators[] =
         {
-            EuclidShortcutPathGenerator(rm, cc)
+            EuclidShortcutPathGenerator(rm, cc, token)
         };
 
         shortcut::ShortcutPath(
@@ -312,7 +345,7 @@ void ShortcutPath(
 
         JointPositionVelocityShortcutPathGenerator generators[] =
         {
-            JointPositionVelocityShortcutPathGenerator(rm, cc)
+            JointPositionVelocityShortcutPathGenerator(rm, cc, token)
         };
 
         std::vector<RobotState> opvpath;
@@ -355,39 +388,787 @@ void ShortcutPath(
     SMPL_INFO("Shortcutted path: waypount_count: %zu, cost: %0.3f", pout.size(), next_cost);
 }
 
-bool CreatePositionVelocityPath(
+// Shared state for the randomized shortcutting rounds: a collision checker
+// per thread and the pool that drives them
+struct RandomShortcutter
+{
+    RobotModel* rm;
+    std::vector<std::unique_ptr<CollisionChecker>> clones;
+    std::vector<CollisionChecker*> checkers;
+    std::unique_ptr<WorkerPool> pool;
+    std::default_random_engine rng;
+
+    struct Candidate
+    {
+        size_t first;
+        size_t last;
+        int joint; // -1 for a shortcut of every joint
+        double savings;
+        bool valid;
+        std::vector<RobotState> segment; // replaced waypoints, if partial
+    };
+
+    std::vector<Candidate> candidates;
+
+    RandomShortcutter(RobotModel* rm, CollisionChecker* cc, int thread_count);
+
+    void run(const std::function<void(int, size_t)>& job, size_t count);
+    bool shortcutRound(std::vector<RobotState>& path, int batch_size);
+    bool partialShortcutRound(std::vector<RobotState>& path, int batch_size);
+    bool applyCandidates(std::vector<RobotState>& path);
+};
+
+RandomShortcutter::RandomShortcutter(
     RobotModel* rm,
-    const std::vector<RobotState>& path,
-    std::vector<RobotState>& opath)
+    CollisionChecker* cc,
+    int thread_count)
+:
+    rm(rm),
+    checkers(1, cc)
 {
-    const size_t var_count = rm->getPlanningJoints().size();
+    if (thread_count > 1) {
+        auto* cloner = cc->getExtension<CollisionCheckerCloneExtension>();
+        if (!cloner) {
+            SMPL_WARN("Parallel shortcutting requires a Collision Checker Clone Extension. Check shortcuts serially");
+        } else {
+            for (int i = 1; i < thread_count; ++i) {
+                auto clone = cloner->clone();
+                if (!clone) {
+                    SMPL_WARN("Failed to clone collision checker");
+                    break;
+                }
+                checkers.push_back(clone.get());
+                clones.push_back(std::move(clone));
+            }
+        }
+    }
+
+    if (checkers.size() > 1) {
+        pool.reset(new WorkerPool((int)checkers.size()));
+    }
+}
 
-    // position + zero velocity for the first point
-    std::vector<RobotState> pv_path(path.size());
-    if (!pv_path.empty()) {
-        pv_path[0].resize(2 * var_count);
-        // p_0 = p_in_0, v_0 = { 0, ..., 0 }
-        std::copy(path[0].begin(), path[0].begin() + var_count, pv_path[0].begin());
-        std::generate(pv_path[0].begin() + var_count, pv_path[0].end(), []() { return 0.0; });
+void RandomShortcutter::run(
+    const std::function<void(int, size_t)>& job,
+    size_t count)
+{
+    if (pool) {
+        pool->run(count, job);
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            job(0, i);
+        }
     }
+}
 
-    // position + velocities for the remaining points
+// Replace the waypoints between sampled pairs with a straight joint-space
+// motion.
+bool RandomShortcutter::shortcutRound(
+    std::vector<RobotState>& path,
+    int batch_size)
+{
+    std::vector<double> lengths(path.size()); // path length up to waypoint i
+    lengths[0] = 0.0;
     for (size_t i = 1; i < path.size(); ++i) {
-        const RobotState& from = path[i - 1];
-        const RobotState& to = path[i];
-        pv_path[i].resize(2 * var_count);
-        std::copy(to.begin(), to.begin() + var_count, pv_path[i].begin());
-        for (size_t vidx = 0; vidx < var_count; ++vidx) {
-            if (!rm->hasPosLimit(vidx)) {
-                pv_path[i][var_count + vidx] = std::copysign(1.0, angles::shortest_angle_diff(to[vidx], from[vidx]));
+        lengths[i] = lengths[i - 1] + distance(*rm, path[i - 1], path[i]);
+    }
+
+    // sample candidate shortcuts that skip at least one waypoint and do not
+    // lengthen the path
+    candidates.clear();
+    std::uniform_int_distribution<size_t> first_dist(0, path.size() - 3);
+    for (int k = 0; k < batch_size; ++k) {
+        auto first = first_dist(rng);
+        std::uniform_int_distribution<size_t> last_dist(first + 2, path.size() - 1);
+        auto last = last_dist(rng);
+        auto savings = lengths[last] - lengths[first] -
+                distance(*rm, path[first], path[last]);
+        // like ShortcutPath, accept shortcuts of equal cost, which still
+        // remove waypoints
+        if (savings > -1e-9) {
+            Candidate c;
+            c.first = first;
+            c.last = last;
+            c.joint = -1;
+            c.savings = savings;
+            c.valid = false;
+            candidates.push_back(std::move(c));
+        }
+    }
+
+    run([&](int tid, size_t i) {
+            auto& c = candidates[i];
+            c.valid = checkers[tid]->isStateToStateValid(path[c.first], path[c.last]);
+        },
+        candidates.size());
+
+    return applyCandidates(path);
+}
+
+// Move the waypoints between sampled pairs onto the straight line between the
+// pair along a single joint, keeping the other joints as they are. This
+// straightens motions that a full shortcut cannot because other joints must
+// still move around an obstacle.
+bool RandomShortcutter::partialShortcutRound(
+    std::vector<RobotState>& path,
+    int batch_size)
+{
+    const auto var_count = (int)rm->getPlanningJoints().size();
+
+    candidates.clear();
+    std::uniform_int_distribution<size_t> first_dist(0, path.size() - 3);
+    std::uniform_int_distribution<int> joint_dist(0, var_count - 1);
+    for (int k = 0; k < batch_size; ++k) {
+        Candidate c;
+        c.first = first_dist(rng);
+        std::uniform_int_distribution<size_t> last_dist(c.first + 2, path.size() - 1);
+        c.last = last_dist(rng);
+        c.joint = joint_dist(rng);
+        c.savings = 0.0;
+        c.valid = false;
+        candidates.push_back(std::move(c));
+    }
+
+    run([&](int tid, size_t i) {
+            auto& c = candidates[i];
+            auto from = path[c.first][c.joint];
+            auto to = path[c.last][c.joint];
+            auto diff = rm->hasPosLimit(c.joint) ?
+                    to - from : angles::shortest_angle_diff(to, from);
+
+            // build the replacement waypoints and measure the savings
+            c.segment.assign(
+                    path.begin() + c.first + 1, path.begin() + c.last);
+            auto count = (double)(c.last - c.first);
+            for (size_t k = 0; k < c.segment.size(); ++k) {
+                auto alpha = (double)(k + 1) / count;
+                c.segment[k][c.joint] = from + alpha * diff;
+            }
+
+            auto old_cost = 0.0;
+            auto new_cost = 0.0;
+            for (size_t k = c.first; k < c.last; ++k) {
+                old_cost += distance(*rm, path[k], path[k + 1]);
+                auto& a = k == c.first ? path[k] : c.segment[k - c.first - 1];
+                auto& b = k + 1 == c.last ? path[k + 1] : c.segment[k - c.first];
+                new_cost += distance(*rm, a, b);
+            }
+            c.savings = old_cost - new_cost;
+            if (c.savings <= 1e-6) {
+                return;
+            }
+
+            auto* checker = checkers[tid];
+            for (size_t k = c.first; k < c.last; ++k) {
+                auto& a = k == c.first ? path[k] : c.segment[k - c.first - 1];
+                auto& b = k + 1 == c.last ? path[k + 1] : c.segment[k - c.first];
+                if (!checker->isStateToStateValid(a, b)) {
+                    return;
+                }
+            }
+            c.valid = true;
+        },
+        candidates.size());
+
+    return applyCandidates(path);
+}
+
+// Greedily apply the valid candidates with the largest savings, then the most
+// replaced waypoints, that do not overlap an applied candidate.
+bool RandomShortcutter::applyCandidates(std::vector<RobotState>& path)
+{
+    std::sort(begin(candidates), end(candidates),
+            [](const Candidate& a, const Candidate& b) {
+                if (a.savings != b.savings) {
+                    return a.savings > b.savings;
+                }
+                return a.last - a.first > b.last - b.first;
+            });
+
+    std::vector<Candidate*> accepted;
+    for (auto& c : candidates) {
+        if (!c.valid) {
+            continue;
+        }
+        auto overlaps = false;
+        for (auto* a : accepted) {
+            if (c.first < a->last && a->first < c.last) {
+                overlaps = true;
+                break;
+            }
+        }
+        if (!overlaps) {
+            accepted.push_back(&c);
+        }
+    }
+
+    if (accepted.empty()) {
+        return false;
+    }
+
+    std::sort(begin(accepted), end(accepted),
+            [](const Candidate* a, const Candidate* b) {
+                return a->first < b->first;
+            });
+
+    std::vector<RobotState> next_path;
+    auto ait = begin(accepted);
+    for (size_t i = 0; i < path.size(); ) {
+        next_path.push_back(std::move(path[i]));
+        if (ait != end(accepted) && (*ait)->first == i) {
+            auto& c = **ait;
+            if (c.joint >= 0) {
+                for (auto& wp : c.segment) {
+                    next_path.push_back(std::move(wp));
+                }
+            }
+            i = c.last;
+            ++ait;
+        } else {
+            ++i;
+        }
+    }
+    path = std::move(next_path);
+    return true;
+}
+
+static
+double PathCost(RobotModel* rm, const std::vector<RobotState>& path)
+{
+    auto cost = 0.0;
+    for (size_t i = 1; i < path.size(); ++i) {
+        cost += distance(*rm, path[i - 1], path[i]);
+    }
+    return cost;
+}
+
+void ParallelShortcutPath(
+    RobotModel* rm,
+    CollisionChecker* cc,
+    const std::vector<RobotState>& pin,
+    std::vector<RobotState>& pout,
+    int thread_count,
+    double allowed_time,
+    int batch_size,
+    int max_stalled_rounds,
+    const CancellationToken* token)
+{
+    if (pin.size() < 3) {
+        pout = pin;
+        return;
+    }
+
+    auto then = clock::now();
+    auto deadline = then + std::chrono::duration_cast<clock::duration>(
+            std::chrono::duration<double>(allowed_time));
+
+    RandomShortcutter shortcutter(rm, cc, thread_count);
+    if (batch_size <= 0) {
+        batch_size = 4 * (int)shortcutter.checkers.size();
+    }
+
+    std::vector<RobotState> path = pin;
+    auto rounds = 0;
+    auto stalled_rounds = 0;
+    while (path.size() > 2 && stalled_rounds < max_stalled_rounds) {
+        if (allowed_time > 0.0 && clock::now() >= deadline) {
+            break;
+        }
+        if (Expired(token)) {
+            break;
+        }
+        ++rounds;
+        if (shortcutter.shortcutRound(path, batch_size)) {
+            stalled_rounds = 0;
+        } else {
+            ++stalled_rounds;
+        }
+    }
+
+    auto now = clock::now();
+    SMPL_INFO("Parallel path shortcutting took %0.3f seconds (%d rounds, %zu threads)", std::chrono::duration<double>(now - then).count(), rounds, shortcutter.checkers.size());
+    SMPL_INFO("Original path: waypoint count: %zu, cost: %0.3f", pin.size(), PathCost(rm, pin));
+    SMPL_INFO("Shortcutted path: waypoint count: %zu, cost: %0.3f", path.size(), PathCost(rm, path));
+
+    pout = std::move(path);
+}
+
+void AnytimeSmoothPath(
+    RobotModel* rm,
+    CollisionChecker* cc,
+    const std::vector<RobotState>& pin,
+    std::vector<RobotState>& pout,
+    double allowed_time,
+    int thread_count,
+    int max_stalled_rounds,
+    const CancellationToken* token)
+{
+    if (pin.size() < 3 || allowed_time <= 0.0) {
+        pout = pin;
+        return;
+    }
+
+    auto then = clock::now();
+    auto deadline = then + std::chrono::duration_cast<clock::duration>(
+            std::chrono::duration<double>(allowed_time));
+
+    RandomShortcutter shortcutter(rm, cc, thread_count);
+    auto batch_size = 4 * (int)shortcutter.checkers.size();
+
+    // every round keeps the path valid, so the current path is always the
+    // best one found
+    std::vector<RobotState> path = pin;
+    auto rounds = 0;
+    auto stalled_rounds = 0;
+    while (path.size() > 2 &&
+        stalled_rounds < max_stalled_rounds &&
+        clock::now() < deadline &&
+        !Expired(token))
+    {
+        // alternate full shortcuts, which remove waypoints, with partial
+        // shortcuts of a single joint
+        ++rounds;
+        auto improved = (rounds % 2 == 1) ?
+                shortcutter.shortcutRound(path, batch_size) :
+                shortcutter.partialShortcutRound(path, batch_size);
+        if (improved) {
+            stalled_rounds = 0;
+        } else {
+            ++stalled_rounds;
+        }
+    }
+
+    auto now = clock::now();
+    SMPL_INFO("Anytime path smoothing took %0.3f of %0.3f seconds (%d rounds, %zu threads)", std::chrono::duration<double>(now - then).count(), allowed_time, rounds, shortcutter.checkers.size());
+    SMPL_INFO("Original path: waypoint count: %zu, cost: %0.3f", pin.size(), PathCost(rm, pin));
+    SMPL_INFO("Smoothed path: waypoint count: %zu, cost: %0.3f", path.size(), PathCost(rm, path));
+
+    pout = std::move(path);
+}
+
+// Solve A x = b in place, where A is the n x n tridiagonal matrix with 2 on the
+// diagonal and -1 off the diagonal, by the Thomas algorithm. c is scratch
+// space for n coefficients.
+static
+void SolveSmoothnessMetric(double* b, double* c, size_t n)
+{
+    c[0] = -0.5;
+    b[0] = 0.5 * b[0];
+    for (size_t i = 1; i < n; ++i) {
+        const double m = 2.0 + c[i - 1];
+        c[i] = -1.0 / m;
+        b[i] = (b[i] + b[i - 1]) / m;
+    }
+    for (size_t i = n - 1; i > 0; --i) {
+        b[i - 1] -= c[i - 1] * b[i];
+    }
+}
+
+static
+bool IsPathValid(CollisionChecker* cc, const std::vector<RobotState>& path)
+{
+    for (size_t i = 1; i < path.size(); ++i) {
+        if (!cc->isStateToStateValid(path[i - 1], path[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool OptimizePath(
+    RobotModel* rm,
+    CollisionChecker* cc,
+    const std::vector<RobotState>& pin,
+    std::vector<RobotState>& pout,
+    int iterations,
+    double clearance,
+    double obstacle_weight,
+    double step_size,
+    const CancellationToken* token)
+{
+    pout = pin;
+    if (pin.size() < 3 || iterations <= 0) {
+        return false;
+    }
+
+    auto* cdist = cc->getExtension<CollisionDistanceExtension>();
+    if (cdist == nullptr) {
+        SMPL_WARN_ONCE("Path optimization requires a collision checker with CollisionDistanceExtension");
+        return false;
+    }
+
+    auto then = clock::now();
+
+    const size_t var_count = rm->jointVariableCount();
+    const size_t n = pin.size() - 2; // interior waypoints
+
+    // iterates[k] is the path after k iterations
+    std::vector<std::vector<RobotState>> iterates;
+    iterates.push_back(pin);
+
+    // the costs are integrated over the path in normalized time, with a time
+    // step of dt between waypoints, which scales the obstacle gradient by
+    // dt^2 relative to the smoothness gradient, so that the weights do not
+    // depend on the waypoint count
+    const double dt = 1.0 / (double)(pin.size() - 1);
+    const double obs_scale = obstacle_weight * dt * dt;
+
+    std::vector<double> grad(n * var_count);
+    std::vector<double> obs_grad;
+    std::vector<double> b(n), c(n);
+    auto evaluations = 0;
+    for (int k = 0; k < iterations && !Expired(token); ++k) {
+        auto& path = iterates.back();
+
+        // gradient of the smoothness and obstacle costs at each interior
+        // waypoint
+        auto supported = true;
+        for (size_t i = 0; i < n && supported; ++i) {
+            auto& prev = path[i];
+            auto& curr = path[i + 1];
+            auto& next = path[i + 2];
+
+            double cost;
+            ++evaluations;
+            supported = cdist->collisionCostGradient(
+                    curr, clearance, cost, obs_grad);
+
+            for (size_t v = 0; v < var_count && supported; ++v) {
+                double ds;
+                if (rm->isContinuous(v)) {
+                    ds = angles::shortest_angle_diff(curr[v], prev[v]) -
+                            angles::shortest_angle_diff(next[v], curr[v]);
+                } else {
+                    ds = 2.0 * curr[v] - prev[v] - next[v];
+                }
+                grad[v * n + i] = ds + obs_scale * obs_grad[v];
             }
-            else {
-                pv_path[i][var_count + vidx] = std::copysign(1.0, to[vidx] - from[vidx]);
+        }
+        if (!supported) {
+            SMPL_WARN_ONCE("Collision checker does not support collision cost gradients");
+            pout = pin;
+            return false;
+        }
+
+        // covariant step, under the metric of the smoothness cost, so that
+        // updates spread smoothly along the path
+        auto next_path = path;
+        for (size_t v = 0; v < var_count; ++v) {
+            std::copy(grad.begin() + v * n, grad.begin() + (v + 1) * n, b.begin());
+            SolveSmoothnessMetric(b.data(), c.data(), n);
+            for (size_t i = 0; i < n; ++i) {
+                auto& q = next_path[i + 1][v];
+                q -= step_size * b[i];
+                if (rm->hasPosLimit(v)) {
+                    q = std::max(rm->minPosLimit(v), std::min(q, rm->maxPosLimit(v)));
+                }
             }
         }
+        iterates.push_back(std::move(next_path));
+    }
+
+    // check the latest iterate first, then back off toward the input path
+    // until a valid one is found
+    auto valid = iterates.size() - 1;
+    auto checks = 0;
+    while (valid > 0) {
+        ++checks;
+        if (IsPathValid(cc, iterates[valid])) {
+            break;
+        }
+        valid /= 2;
+    }
+
+    auto now = clock::now();
+    SMPL_INFO("Path optimization took %0.3f seconds (%zu iterations, %d gradient evaluations, %d path checks)", std::chrono::duration<double>(now - then).count(), iterates.size() - 1, evaluations, checks);
+    SMPL_INFO("Original path: waypoint count: %zu, cost: %0.3f", pin.size(), PathCost(rm, pin));
+
+    if (valid == 0) {
+        SMPL_WARN("No optimized path was valid");
+        return false;
+    }
+
+    SMPL_INFO("Optimized path: waypoint count: %zu, cost: %0.3f (iteration %zu)", iterates[valid].size(), PathCost(rm, iterates[valid]), valid);
+    pout = std::move(iterates[valid]);
+    return true;
+}
+
+bool RepairState(
+    RobotModel* rm,
+    CollisionChecker* cc,
+    const RobotState& state,
+    RobotState& repaired,
+    int iterations,
+    double clearance,
+    double max_step)
+{
+    repaired = state;
+    if (cc->isStateValid(state)) {
+        return true;
+    }
+
+    auto* cdist = cc->getExtension<CollisionDistanceExtension>();
+    if (cdist == nullptr) {
+        SMPL_WARN_ONCE("State repair requires a collision checker with CollisionDistanceExtension");
+        return false;
+    }
+
+    auto q = state;
+    double cost;
+    std::vector<double> grad;
+    if (!cdist->collisionCostGradient(q, clearance, cost, grad)) {
+        SMPL_WARN_ONCE("Collision checker does not support collision cost gradients");
+        return false;
+    }
+
+    auto step = max_step;
+    for (int k = 0; k < iterations; ++k) {
+        auto grad_norm = 0.0;
+        for (auto g : grad) {
+            grad_norm = std::max(grad_norm, std::fabs(g));
+        }
+        if (grad_norm == 0.0) {
+            break;
+        }
+
+        // step against the gradient, moving the variable with the largest
+        // gradient component by the step size
+        auto next = q;
+        for (size_t v = 0; v < next.size(); ++v) {
+            next[v] -= step * grad[v] / grad_norm;
+            if (rm->hasPosLimit(v)) {
+                next[v] = std::max(rm->minPosLimit(v), std::min(next[v], rm->maxPosLimit(v)));
+            }
+        }
+
+        double next_cost;
+        std::vector<double> next_grad;
+        if (!cdist->collisionCostGradient(next, clearance, next_cost, next_grad)) {
+            return false;
+        }
+        if (next_cost >= cost) {
+            step *= 0.5;
+            continue;
+        }
+
+        q = std::move(next);
+        cost = next_cost;
+        grad = std::move(next_grad);
+        step = max_step;
+
+        if (cc->isStateValid(q)) {
+            SMPL_INFO("Repaired state in collision after %d iterations", k + 1);
+            repaired = std::move(q);
+            return true;
+        }
+    }
+
+    SMPL_WARN("Failed to repair state in collision within %d iterations", iterations);
+    return false;
+}
+
+bool ComputeTrapezoidalTimeParameterization(
+    RobotModel* rm,
+    const std::vector<RobotState>& path,
+    std::vector<double>& times,
+    std::vector<RobotState>& velocities,
+    double junction_deviation)
+{
+    const auto var_count = rm->getPlanningJoints().size();
+    for (auto& wp : path) {
+        if (wp.size() != var_count) {
+            SMPL_ERROR("Failed to time-parameterize path. Waypoint has %zu variables (expected %zu)", wp.size(), var_count);
+            return false;
+        }
+    }
+
+    times.assign(path.size(), 0.0);
+    velocities.assign(path.size(), RobotState(var_count, 0.0));
+    if (path.size() < 2) {
+        return true;
+    }
+
+    const auto inf = std::numeric_limits<double>::infinity();
+    const auto seg_count = path.size() - 1;
+
+    // unit direction, length, and the speed and acceleration limits along
+    // each segment
+    std::vector<RobotState> dirs(seg_count, RobotState(var_count, 0.0));
+    std::vector<double> lengths(seg_count, 0.0);
+    std::vector<double> max_vels(seg_count, inf);
+    std::vector<double> max_accs(seg_count, inf);
+    for (size_t k = 0; k < seg_count; ++k) {
+        auto& dir = dirs[k];
+        for (size_t j = 0; j < var_count; ++j) {
+            if (rm->isContinuous(j)) {
+                dir[j] = angles::shortest_angle_diff(path[k + 1][j], path[k][j]);
+            } else {
+                dir[j] = path[k + 1][j] - path[k][j];
+            }
+            lengths[k] += dir[j] * dir[j];
+        }
+        lengths[k] = std::sqrt(lengths[k]);
+        if (lengths[k] == 0.0) {
+            continue;
+        }
+        for (size_t j = 0; j < var_count; ++j) {
+            dir[j] /= lengths[k];
+            auto u = std::fabs(dir[j]);
+            if (u == 0.0) {
+                continue;
+            }
+            if (rm->velLimit(j) > 0.0) {
+                max_vels[k] = std::min(max_vels[k], rm->velLimit(j) / u);
+            }
+            if (rm->accLimit(j) > 0.0) {
+                max_accs[k] = std::min(max_accs[k], rm->accLimit(j) / u);
+            }
+        }
+    }
+
+    // bound the speed at each waypoint by the segments on either side and the
+    // corner it rounds (as in junction deviation cornering of cnc motion
+    // planners)
+    std::vector<double> speeds(path.size(), 0.0);
+    size_t prev = seg_count; // previous segment with nonzero length
+    for (size_t k = 0; k < seg_count; ++k) {
+        if (lengths[k] == 0.0) {
+            continue;
+        }
+        if (prev != seg_count) {
+            auto cos_theta = 0.0;
+            for (size_t j = 0; j < var_count; ++j) {
+                cos_theta -= dirs[prev][j] * dirs[k][j];
+            }
+            auto v = std::min(max_vels[prev], max_vels[k]);
+            if (cos_theta > 0.999999) {
+                // reversal
+                v = 0.0;
+            } else if (cos_theta > -0.999999) {
+                auto sin_half = std::sqrt(0.5 * (1.0 - cos_theta));
+                auto a = std::min(max_accs[prev], max_accs[k]);
+                v = std::min(v, std::sqrt(a * junction_deviation * sin_half / (1.0 - sin_half)));
+            }
+            // a waypoint repeated between the two segments passes at the
+            // same speed
+            for (size_t i = prev + 1; i <= k; ++i) {
+                speeds[i] = v;
+            }
+        }
+        prev = k;
+    }
+
+    // limit the speeds to those reachable under the acceleration limits,
+    // ending and starting at rest
+    for (size_t k = seg_count; k-- > 0; ) {
+        speeds[k] = std::min(speeds[k], std::sqrt(speeds[k + 1] * speeds[k + 1] + 2.0 * max_accs[k] * lengths[k]));
+    }
+    for (size_t k = 0; k < seg_count; ++k) {
+        speeds[k + 1] = std::min(speeds[k + 1], std::sqrt(speeds[k] * speeds[k] + 2.0 * max_accs[k] * lengths[k]));
+    }
+
+    // time each segment with a trapezoidal speed profile
+    for (size_t k = 0; k < seg_count; ++k) {
+        auto dt = 0.0;
+        const auto L = lengths[k];
+        const auto A = max_accs[k];
+        const auto v0 = speeds[k];
+        const auto v1 = speeds[k + 1];
+        if (L > 0.0 && (max_vels[k] < inf || A < inf)) {
+            auto peak = max_vels[k];
+            if (A < inf) {
+                peak = std::min(peak, std::sqrt(A * L + 0.5 * (v0 * v0 + v1 * v1)));
+            }
+            if (peak > 0.0) {
+                auto accel_dist = (A < inf) ? (peak * peak - v0 * v0) / (2.0 * A) : 0.0;
+                auto decel_dist = (A < inf) ? (peak * peak - v1 * v1) / (2.0 * A) : 0.0;
+                auto cruise_dist = std::max(0.0, L - accel_dist - decel_dist);
+                if (A < inf) {
+                    dt += (peak - v0) / A + (peak - v1) / A;
+                }
+                dt += cruise_dist / peak;
+            }
+        }
+        times[k + 1] = times[k] + dt;
+        for (size_t j = 0; j < var_count; ++j) {
+            velocities[k][j] = dirs[k][j] * speeds[k];
+        }
+    }
+
+    return true;
+}
+
+// Store the position of a waypoint, followed by the sign of the velocity
+// arriving at it from the previous waypoint, or zero velocity for the first
+// waypoint, in out[0, 2 * var_count)
+static
+void MakePositionVelocityPoint(
+    RobotModel* rm,
+    const double* from,
+    const double* to,
+    size_t var_count,
+    double* out)
+{
+    std::copy(to, to + var_count, out);
+    if (from == nullptr) {
+        std::fill(out + var_count, out + 2 * var_count, 0.0);
+        return;
+    }
+    for (size_t vidx = 0; vidx < var_count; ++vidx) {
+        if (!rm->hasPosLimit(vidx)) {
+            out[var_count + vidx] = std::copysign(1.0, angles::shortest_angle_diff(to[vidx], from[vidx]));
+        }
+        else {
+            out[var_count + vidx] = std::copysign(1.0, to[vidx] - from[vidx]);
+        }
+    }
+}
+
+bool CreatePositionVelocityPath(
+    RobotModel* rm,
+    const std::vector<RobotState>& path,
+    std::vector<RobotState>& opath)
+{
+    if (&path == &opath) {
+        auto ipath = path;
+        return CreatePositionVelocityPath(rm, ipath, opath);
+    }
+
+    const size_t var_count = rm->getPlanningJoints().size();
+
+    // reuse the storage of the waypoints already in the output path
+    opath.resize(path.size());
+    for (size_t i = 0; i < path.size(); ++i) {
+        opath[i].resize(2 * var_count);
+        MakePositionVelocityPoint(
+                rm,
+                i == 0 ? nullptr : path[i - 1].data(),
+                path[i].data(),
+                var_count,
+                opath[i].data());
+    }
+
+    return true;
+}
+
+bool CreatePositionVelocityPath(
+    RobotModel* rm,
+    const double* path,
+    size_t count,
+    std::vector<double>& opath)
+{
+    const size_t var_count = rm->getPlanningJoints().size();
+
+    opath.resize(count * 2 * var_count);
+    for (size_t i = 0; i < count; ++i) {
+        MakePositionVelocityPoint(
+                rm,
+                i == 0 ? nullptr : path + (i - 1) * var_count,
+                path + i * var_count,
+                var_count,
+                &opath[i * 2 * var_count]);
     }
 
-    opath = std::move(pv_path);
     return true;
 }
 
@@ -445,6 +1226,32 @@ bool InterpolatePath(CollisionChecker& cc, std::vector<RobotState>& path)
         return true;
     }
 
+    std::vector<double> opath;
+    if (!InterpolatePath(cc, path, opath)) {
+        return false;
+    }
+
+    // reuse the storage of the original waypoints
+    auto num_joints = path.front().size();
+    auto count = opath.size() / num_joints;
+    SMPL_INFO("Original path length: %zu   Interpolated path length: %zu", path.size(), count);
+    path.resize(count);
+    for (auto i = size_t(0); i < count; ++i) {
+        path[i].assign(&opath[i * num_joints], &opath[(i + 1) * num_joints]);
+    }
+    return true;
+}
+
+bool InterpolatePath(
+    CollisionChecker& cc,
+    const std::vector<RobotState>& path,
+    std::vector<double>& opath)
+{
+    opath.clear();
+    if (path.empty()) {
+        return true;
+    }
+
     auto num_joints = path.front().size();
     for (auto& pt : path) {
         if (pt.size() != num_joints) {
@@ -453,10 +1260,32 @@ bool InterpolatePath(CollisionChecker& cc, std::vector<RobotState>& path)
         }
     }
 
-    std::vector<RobotState> opath;
+    // motions already validated, e.g. the lattice edges checked during the
+    // search, need not have their interpolated states checked again
+    auto* cached = cc.getExtension<CachedCollisionChecker>();
+    if (cached) {
+        cached->syncWorld();
+    }
+
+    // at least every original waypoint is kept
+    opath.reserve(path.size() * num_joints);
+
+    // append waypoints, growing the buffer geometrically so that long paths
+    // are copied a logarithmic number of times
+    auto append = [&](const double* first, const double* last) {
+        auto size = opath.size() + (last - first);
+        if (size > opath.capacity()) {
+            opath.reserve(std::max(size, 2 * opath.capacity()));
+        }
+        opath.insert(end(opath), first, last);
+    };
 
     // tack on the first point of the trajectory
-    opath.push_back(path.front());
+    append(path.front().data(), path.front().data() + num_joints);
+
+    // interpolated segments, whose waypoints keep their storage from one
+    // segment to the next
+    std::vector<RobotState> ipath;
 
     // iterate over path segments
     for (auto i = size_t(0); i < path.size() - 1; ++i) {
@@ -465,7 +1294,6 @@ bool InterpolatePath(CollisionChecker& cc, std::vector<RobotState>& path)
 
         SMPL_DEBUG_STREAM("Interpolating between " << curr << " and " << next);
 
-        std::vector<RobotState> ipath;
         if (!cc.interpolatePath(curr, next, ipath)) {
             SMPL_ERROR("Failed to interpolate between waypoint %zu and %zu because it's infeasible given the limits.", i, i + 1);
             return false;
@@ -473,31 +1301,29 @@ bool InterpolatePath(CollisionChecker& cc, std::vector<RobotState>& path)
 
         // check the interpolated path for collisions, as the interpolator may
         // take a slightly different
-        auto collision = false;
-        for (auto& point : ipath) {
-            if (!cc.isStateValid(point, false)) {
-                collision = true;
-                break;
-            }
+        auto known_valid = false;
+        if (cached && !cached->cache()->lookup(curr, next, known_valid)) {
+            known_valid = false;
         }
-
-        if (collision) {
+        if (!known_valid && !cc.areStatesValid(ipath.data(), ipath.size())) {
             SMPL_ERROR("Interpolated path collides. Resorting to original waypoints");
-            opath.push_back(next);
+            append(next.data(), next.data() + num_joints);
             continue;
         }
 
-        if (!ipath.empty()) {
-            // concatenate current path and the intermediate path (we already
-            // have the first waypoint in the path from last iteration)
-            opath.insert(end(opath), std::next(begin(ipath)), end(ipath));
+        // concatenate current path and the intermediate path (we already
+        // have the first waypoint in the path from last iteration)
+        for (auto j = size_t(1); j < ipath.size(); ++j) {
+            if (ipath[j].size() != num_joints) {
+                SMPL_ERROR("Failed to interpolate trajectory. Interpolated waypoint is malformed");
+                return false;
+            }
+            append(ipath[j].data(), ipath[j].data() + num_joints);
         }
 
-        SMPL_DEBUG("[%zu] path length: %zu", i, opath.size());
+        SMPL_DEBUG("[%zu] path length: %zu", i, opath.size() / num_joints);
     }
 
-    SMPL_INFO("Original path length: %zu   Interpolated path length: %zu", path.size(), opath.size());
-    path = std::move(opath);
     return true;
 }
 
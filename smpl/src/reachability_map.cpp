@@ -0,0 +1,426 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+/// \author Andrew Dornbush
+
+#include <smpl/reachability_map.h>
+
+// standard includes
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+
+// system includes
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// project includes
+#include <smpl/angles.h>
+#include <smpl/collision_checker.h>
+#include <smpl/console/console.h>
+#include <smpl/robot_model.h>
+
+namespace smpl {
+
+static const char* LOG = "reachability_map";
+
+static_assert(sizeof(ReachabilityMapFileHeader) % sizeof(double) == 0,
+        "Reachability map file sections must be 8-byte aligned");
+
+// Bound on the size of each dimension of a map, which keeps every cell index
+// of a valid header within 64 bits.
+static const std::uint32_t kMaxDimension = 1 << 12;
+
+static int Bin(double value, double lo, double hi, int count)
+{
+    auto bin = (int)std::floor((value - lo) / (hi - lo) * count);
+    return std::max(0, std::min(count - 1, bin));
+}
+
+ReachabilityMap::~ReachabilityMap()
+{
+    clear();
+}
+
+bool ReachabilityMap::build(
+    RobotModel* robot,
+    CollisionChecker* checker,
+    const Vector3& min,
+    const Vector3& max,
+    double resolution,
+    int orientation_bins,
+    int sample_count,
+    std::uint32_t random_seed)
+{
+    auto* fk = robot ? robot->getExtension<ForwardKinematicsInterface>() : nullptr;
+    if (!fk) {
+        SMPL_ERROR_NAMED(LOG, "Reachability map requires a Forward Kinematics Interface");
+        return false;
+    }
+    if (resolution <= 0.0 || orientation_bins <= 0 || (std::uint32_t)orientation_bins > kMaxDimension) {
+        SMPL_ERROR_NAMED(LOG, "Invalid reachability map resolution");
+        return false;
+    }
+
+    ReachabilityMapFileHeader header = { };
+    std::memcpy(header.magic, REACHABILITY_MAP_FILE_MAGIC, sizeof(header.magic));
+    header.version = REACHABILITY_MAP_FILE_VERSION;
+    header.dof = robot->jointVariableCount();
+    for (int i = 0; i < 3; ++i) {
+        auto cells = std::ceil((max[i] - min[i]) / resolution);
+        if (!(cells >= 1.0 && cells <= kMaxDimension)) {
+            SMPL_ERROR_NAMED(LOG, "Invalid reachability map bounds");
+            return false;
+        }
+        header.size[i] = (std::uint32_t)cells;
+        header.origin[i] = min[i];
+    }
+    header.orientation_bins = orientation_bins;
+    header.seed_count = 0;
+    header.resolution = resolution;
+
+    clear();
+    m_header = header;
+
+    m_voxel_counts_data.assign(voxelCount(), 0);
+    m_cells_data.assign(voxelCount() * orientationCount(), -1);
+    m_seeds_data.clear();
+
+    std::mt19937 rng(random_seed);
+    RobotState state(header.dof);
+    for (int n = 0; n < sample_count; ++n) {
+        for (std::size_t j = 0; j < state.size(); ++j) {
+            auto lo = -M_PI;
+            auto hi = M_PI;
+            if (!robot->isContinuous(j) && robot->hasPosLimit(j)) {
+                lo = robot->minPosLimit(j);
+                hi = robot->maxPosLimit(j);
+            }
+            state[j] = std::uniform_real_distribution<double>(lo, hi)(rng);
+        }
+
+        if (checker && !checker->isStateValid(state)) {
+            continue;
+        }
+
+        auto pose = fk->computeFK(state);
+        int v[3];
+        if (!voxelCoord(pose.translation(), v)) {
+            continue;
+        }
+        int o[3];
+        orientationCoord(pose, o);
+
+        auto voxel = ((std::size_t)v[0] * header.size[1] + v[1]) * header.size[2] + v[2];
+        auto cell = voxel * orientationCount() +
+                ((std::size_t)o[0] * orientation_bins + o[1]) * orientation_bins + o[2];
+        if (m_cells_data[cell] >= 0) {
+            continue;
+        }
+
+        m_cells_data[cell] = (std::int32_t)m_header.seed_count++;
+        m_seeds_data.insert(end(m_seeds_data), begin(state), end(state));
+        ++m_voxel_counts_data[voxel];
+    }
+
+    m_voxel_counts = m_voxel_counts_data.data();
+    m_cells = m_cells_data.data();
+    m_seeds = m_seeds_data.data();
+
+    SMPL_INFO_NAMED(LOG, "Built reachability map with %zu seeds from %d samples", seedCount(), sample_count);
+    return true;
+}
+
+template <typename T>
+static bool WriteSection(std::FILE* f, const T* section, std::size_t count)
+{
+    return count == 0 || std::fwrite(section, sizeof(T), count, f) == count;
+}
+
+bool ReachabilityMap::save(const std::string& path) const
+{
+    if (empty()) {
+        SMPL_ERROR_NAMED(LOG, "Cannot save an empty reachability map");
+        return false;
+    }
+
+    auto* f = std::fopen(path.c_str(), "wb");
+    if (!f) {
+        SMPL_ERROR_NAMED(LOG, "Failed to open '%s' for writing", path.c_str());
+        return false;
+    }
+
+    auto ok = std::fwrite(&m_header, sizeof(m_header), 1, f) == 1 &&
+            WriteSection(f, m_voxel_counts, voxelCount()) &&
+            WriteSection(f, m_cells, voxelCount() * orientationCount()) &&
+            WriteSection(f, m_seeds, seedCount() * dof());
+    ok = std::fclose(f) == 0 && ok;
+    if (!ok) {
+        SMPL_ERROR_NAMED(LOG, "Failed to write reachability map '%s'", path.c_str());
+    }
+    return ok;
+}
+
+bool ReachabilityMap::load(const std::string& path)
+{
+    clear();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        SMPL_ERROR_NAMED(LOG, "Failed to open reachability map '%s'", path.c_str());
+        return false;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(ReachabilityMapFileHeader)) {
+        SMPL_ERROR_NAMED(LOG, "Reachability map '%s' is truncated", path.c_str());
+        ::close(fd);
+        return false;
+    }
+
+    void* data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        SMPL_ERROR_NAMED(LOG, "Failed to map reachability map '%s'", path.c_str());
+        return false;
+    }
+
+    m_data = data;
+    m_size = st.st_size;
+
+    auto& h = *static_cast<const ReachabilityMapFileHeader*>(m_data);
+    if (std::memcmp(h.magic, REACHABILITY_MAP_FILE_MAGIC, sizeof(h.magic)) != 0) {
+        SMPL_ERROR_NAMED(LOG, "'%s' is not a reachability map", path.c_str());
+        clear();
+        return false;
+    }
+    if (h.version != REACHABILITY_MAP_FILE_VERSION) {
+        SMPL_ERROR_NAMED(LOG, "Reachability map '%s' has version %u (expected %u)", path.c_str(), h.version, REACHABILITY_MAP_FILE_VERSION);
+        clear();
+        return false;
+    }
+
+    auto bad_header = !(h.resolution > 0.0) || h.orientation_bins == 0 ||
+            h.orientation_bins > kMaxDimension;
+    for (int i = 0; i < 3; ++i) {
+        bad_header |= h.size[i] == 0 || h.size[i] > kMaxDimension;
+    }
+    if (bad_header) {
+        SMPL_ERROR_NAMED(LOG, "Reachability map '%s' has a malformed header", path.c_str());
+        clear();
+        return false;
+    }
+
+    m_header = h;
+
+    // every section holds 4-byte values and the seeds fill the rest of the
+    // file
+    auto bytes = m_size - sizeof(ReachabilityMapFileHeader);
+    auto values = bytes / sizeof(float);
+    auto fixed = voxelCount() + voxelCount() * orientationCount();
+    if (bytes % sizeof(float) != 0 || fixed > values ||
+        h.seed_count > (std::uint64_t)std::numeric_limits<std::int32_t>::max() ||
+        values - fixed != h.seed_count * dof())
+    {
+        SMPL_ERROR_NAMED(LOG, "Reachability map '%s' is truncated", path.c_str());
+        clear();
+        return false;
+    }
+
+    auto* base = static_cast<const char*>(m_data) + sizeof(ReachabilityMapFileHeader);
+    m_voxel_counts = reinterpret_cast<const std::uint32_t*>(base);
+    m_cells = reinterpret_cast<const std::int32_t*>(m_voxel_counts + voxelCount());
+    m_seeds = reinterpret_cast<const float*>(m_cells + voxelCount() * orientationCount());
+
+    SMPL_INFO_NAMED(LOG, "Loaded reachability map '%s' with %zu seeds", path.c_str(), seedCount());
+    return true;
+}
+
+void ReachabilityMap::clear()
+{
+    if (m_data) {
+        ::munmap(m_data, m_size);
+        m_data = nullptr;
+        m_size = 0;
+    }
+    m_voxel_counts_data = std::vector<std::uint32_t>();
+    m_cells_data = std::vector<std::int32_t>();
+    m_seeds_data = std::vector<float>();
+    m_voxel_counts = nullptr;
+    m_cells = nullptr;
+    m_seeds = nullptr;
+    m_header = ReachabilityMapFileHeader();
+}
+
+bool ReachabilityMap::reachable(const Affine3& pose) const
+{
+    return findSeed(pose) >= 0;
+}
+
+bool ReachabilityMap::reachable(const Vector3& position) const
+{
+    int v[3];
+    if (empty() || !voxelCoord(position, v)) {
+        return false;
+    }
+
+    for (int x = std::max(0, v[0] - 1); x <= std::min<int>(m_header.size[0] - 1, v[0] + 1); ++x) {
+    for (int y = std::max(0, v[1] - 1); y <= std::min<int>(m_header.size[1] - 1, v[1] + 1); ++y) {
+    for (int z = std::max(0, v[2] - 1); z <= std::min<int>(m_header.size[2] - 1, v[2] + 1); ++z) {
+        auto voxel = ((std::size_t)x * m_header.size[1] + y) * m_header.size[2] + z;
+        if (m_voxel_counts[voxel] != 0) {
+            return true;
+        }
+    }
+    }
+    }
+    return false;
+}
+
+double ReachabilityMap::capability(const Vector3& position) const
+{
+    int v[3];
+    if (empty() || !voxelCoord(position, v)) {
+        return 0.0;
+    }
+    auto voxel = ((std::size_t)v[0] * m_header.size[1] + v[1]) * m_header.size[2] + v[2];
+    return (double)m_voxel_counts[voxel] / (double)orientationCount();
+}
+
+bool ReachabilityMap::seed(const Affine3& pose, RobotState& seed) const
+{
+    auto index = findSeed(pose);
+    if (index < 0) {
+        return false;
+    }
+
+    auto* s = m_seeds + (std::size_t)index * dof();
+    seed.assign(s, s + dof());
+    return true;
+}
+
+auto ReachabilityMap::memoryUsage() const -> std::size_t
+{
+    return sizeof(*this) + m_size +
+            m_voxel_counts_data.capacity() * sizeof(std::uint32_t) +
+            m_cells_data.capacity() * sizeof(std::int32_t) +
+            m_seeds_data.capacity() * sizeof(float);
+}
+
+// Return the voxel containing position, or false if it lies outside the map.
+bool ReachabilityMap::voxelCoord(const Vector3& position, int* coord) const
+{
+    for (int i = 0; i < 3; ++i) {
+        auto c = std::floor((position[i] - m_header.origin[i]) / m_header.resolution);
+        if (!(c >= 0.0 && c < m_header.size[i])) {
+            return false;
+        }
+        coord[i] = (int)c;
+    }
+    return true;
+}
+
+// Bin the roll, pitch, and yaw of pose. Roll and yaw bins wrap around at
+// +/-pi; pitch bins span [-pi/2, pi/2] and do not wrap.
+void ReachabilityMap::orientationCoord(const Affine3& pose, int* coord) const
+{
+    double yaw, pitch, roll;
+    get_euler_zyx(pose.rotation(), yaw, pitch, roll);
+    int n = m_header.orientation_bins;
+    coord[0] = Bin(roll, -M_PI, M_PI, n);
+    coord[1] = Bin(pitch, -0.5 * M_PI, 0.5 * M_PI, n);
+    coord[2] = Bin(yaw, -M_PI, M_PI, n);
+}
+
+auto ReachabilityMap::voxelCount() const -> std::size_t
+{
+    return (std::size_t)m_header.size[0] * m_header.size[1] * m_header.size[2];
+}
+
+auto ReachabilityMap::orientationCount() const -> std::size_t
+{
+    auto n = (std::size_t)m_header.orientation_bins;
+    return n * n * n;
+}
+
+// Return the index of the seed of the reached cell nearest, by the sum of its
+// coordinate offsets, to the cell of pose, searching the cells within one bin
+// of it in every dimension, or -1 if none was reached.
+int ReachabilityMap::findSeed(const Affine3& pose) const
+{
+    int v[3];
+    if (empty() || !voxelCoord(pose.translation(), v)) {
+        return -1;
+    }
+    int o[3];
+    orientationCoord(pose, o);
+
+    int n = m_header.orientation_bins;
+    auto wrap = [n](int i) { return (i + n) % n; };
+
+    auto best = -1;
+    auto best_offset = std::numeric_limits<int>::max();
+    for (int x = std::max(0, v[0] - 1); x <= std::min<int>(m_header.size[0] - 1, v[0] + 1); ++x) {
+    for (int y = std::max(0, v[1] - 1); y <= std::min<int>(m_header.size[1] - 1, v[1] + 1); ++y) {
+    for (int z = std::max(0, v[2] - 1); z <= std::min<int>(m_header.size[2] - 1, v[2] + 1); ++z) {
+        auto voxel = ((std::size_t)x * m_header.size[1] + y) * m_header.size[2] + z;
+        if (m_voxel_counts[voxel] == 0) {
+            continue;
+        }
+        auto voxel_offset = std::abs(x - v[0]) + std::abs(y - v[1]) + std::abs(z - v[2]);
+        for (int dr = -1; dr <= 1; ++dr) {
+        for (int dp = -1; dp <= 1; ++dp) {
+        for (int dy = -1; dy <= 1; ++dy) {
+            auto offset = voxel_offset + std::abs(dr) + std::abs(dp) + std::abs(dy);
+            auto p = o[1] + dp;
+            if (offset >= best_offset || p < 0 || p >= n) {
+                continue;
+            }
+            auto cell = voxel * orientationCount() +
+                    ((std::size_t)wrap(o[0] + dr) * n + p) * n + wrap(o[2] + dy);
+            auto index = m_cells[cell];
+            if (index >= 0 && (std::uint64_t)index < m_header.seed_count) {
+                best = index;
+                best_offset = offset;
+            }
+        }
+        }
+        }
+    }
+    }
+    }
+    return best;
+}
+
+} // namespace smpl
@@ -33,6 +33,7 @@
 #include <smpl/robot_model.h>
 
 #include <assert.h>
+#include <algorithm>
 #include <sstream>
 
 namespace smpl {
@@ -66,6 +67,11 @@ RobotModel::~RobotModel()
 {
 }
 
+bool RobotModel::checkJointLimits(RobotStateView state, bool verbose)
+{
+    return checkJointLimits(RobotState(state.begin(), state.end()), verbose);
+}
+
 void RobotModel::setPlanningJoints(const std::vector<std::string>& joints)
 {
     planning_joints_ = joints;
@@ -80,8 +86,61 @@ ForwardKinematicsInterface::~ForwardKinematicsInterface()
 {
 }
 
+Affine3 ForwardKinematicsInterface::computeFK(RobotStateView state)
+{
+    return computeFK(RobotState(state.begin(), state.end()));
+}
+
+void ForwardKinematicsInterface::computeFKBatch(
+    const double* states,
+    int n,
+    Affine3* poses)
+{
+    auto dim = jointVariableCount();
+    RobotState state(dim);
+    for (int i = 0; i < n; ++i) {
+        std::copy(states + i * dim, states + (i + 1) * dim, state.begin());
+        poses[i] = computeFK(state);
+    }
+}
+
 InverseKinematicsInterface::~InverseKinematicsInterface()
 {
 }
 
+int InverseKinematicsInterface::computeIKBatch(
+    const Affine3* poses,
+    const RobotState* seeds,
+    int n,
+    RobotState* solutions,
+    ik_option::IkOption option)
+{
+    auto found = 0;
+    for (int i = 0; i < n; ++i) {
+        if (computeIK(poses[i], seeds[i], solutions[i], option)) {
+            ++found;
+        } else {
+            solutions[i].clear();
+        }
+    }
+    return found;
+}
+
+int RedundantManipulatorInterface::computeFastIKBatch(
+    const Affine3* poses,
+    const RobotState* seeds,
+    int n,
+    RobotState* solutions)
+{
+    auto found = 0;
+    for (int i = 0; i < n; ++i) {
+        if (computeFastIK(poses[i], seeds[i], solutions[i])) {
+            ++found;
+        } else {
+            solutions[i].clear();
+        }
+    }
+    return found;
+}
+
 } // namespace smpl
@@ -33,6 +33,7 @@
 
 // standard includes
 #include <chrono>
+#include <future>
 
 // project includes
 #include <smpl/time.h>
@@ -188,36 +189,66 @@ int AdaptivePlanner::replan(
 
     double time_remaining = allowed_time;
 
+    auto select_random_path_state = [this](const std::vector<int>& path)
+    {
+        std::uniform_int_distribution<int> dist(0, path.size() - 1);
+        int ridx = dist(m_rng);
+        return path[ridx];
+    };
+
+    const bool pipelining =
+            m_pipelining && m_adaptive_graph->enableConcurrentPlanning();
+    if (m_pipelining && !pipelining) {
+        SMPL_WARN("Adaptive graph does not support concurrent planning. Plan and track sequentially");
+    }
+
     std::vector<int> plan_path;
     std::vector<int> track_path;
+    int plan_cost = -1;
+    // whether plan_path was found by a speculative plan phase that ran
+    // during the previous track phase
+    bool have_plan = false;
     bool done =  false;
     int iter_count = 0;
     int res;
     while (!done) {
+        if (Expired(m_cancel)) {
+            SMPL_WARN("Planning cancelled");
+            return !TIMED_OUT;
+        }
+
         ++iter_count;
 
-        plan_path.clear();
-        int plan_cost = -1;
-        auto plan_start = clock::now();
         m_adaptive_graph->setPlanMode();
-        m_planner.force_planning_from_scratch();
-        SMPL_INFO("Time remaining: %0.3fs. Plan low-dimensional path", time_remaining);
-        ARAStar::TimeParameters time_params = m_time_params.planning;
-        time_params.max_allowed_time_init = to_duration(time_remaining);
-        time_params.max_allowed_time = std::min(time_params.max_allowed_time, to_duration(time_remaining));
-        res = m_planner.replan(time_params, &plan_path, &plan_cost);
-        auto plan_finish = clock::now();
-
-        SMPL_INFO("Planner terminated");
-        SMPL_INFO_STREAM("  Path: " << plan_path);
-        SMPL_INFO("  Cost: %d", plan_cost);
-        SMPL_INFO("  Time: %0.3f", m_planner.get_final_eps_planning_time());
-        SMPL_INFO("  Expansions: %d", m_planner.get_n_expands());
-        SMPL_INFO("  Suboptimality Bound: %0.3f", m_planner.get_solution_eps());
-
-        if (!res) {
-            SMPL_WARN("Failed to find least-cost path in G^ad");
-            return !FAILED_TO_FIND_PATH;
+        if (have_plan) {
+            have_plan = false;
+            SMPL_INFO("Use path planned during the previous track phase");
+        } else {
+            plan_path.clear();
+            plan_cost = -1;
+            auto plan_start = clock::now();
+            m_planner.force_planning_from_scratch();
+            SMPL_INFO("Time remaining: %0.3fs. Plan low-dimensional path", time_remaining);
+            ARAStar::TimeParameters time_params = m_time_params.planning;
+            time_params.max_allowed_time_init = to_duration(time_remaining);
+            time_params.max_allowed_time = std::min(time_params.max_allowed_time, to_duration(time_remaining));
+            res = m_planner.replan(time_params, &plan_path, &plan_cost);
+            auto plan_finish = clock::now();
+
+            SMPL_INFO("Planner terminated");
+            SMPL_INFO_STREAM("  Path: " << plan_path);
+            SMPL_INFO("  Cost: %d", plan_cost);
+            SMPL_INFO("  Time: %0.3f", m_planner.get_final_eps_planning_time());
+            SMPL_INFO("  Expansions: %d", m_planner.get_n_expands());
+            SMPL_INFO("  Suboptimality Bound: %0.3f", m_planner.get_solution_eps());
+
+            if (!res) {
+                SMPL_WARN("Failed to find least-cost path in G^ad");
+                return !FAILED_TO_FIND_PATH;
+            }
+
+            time_remaining -= to_seconds(plan_finish - plan_start);
+            time_remaining = std::max(0.0, time_remaining);
         }
 
         if (m_adaptive_graph->isExecutable(plan_path)) {
@@ -227,9 +258,6 @@ int AdaptivePlanner::replan(
             return !SUCCESS;
         }
 
-        time_remaining -= to_seconds(plan_finish - plan_start);
-        time_remaining = std::max(0.0, time_remaining);
-
         if (time_remaining == 0.0) {
             SMPL_WARN("No time to track!");
             return !TIMED_OUT;
@@ -239,13 +267,25 @@ int AdaptivePlanner::replan(
         int track_cost = -1;
         auto track_start = clock::now();
         m_adaptive_graph->setTrackMode(plan_path);
+
+        // start the next plan phase, assuming the tracked path will be
+        // rejected
+        std::future<int> speculation;
+        std::vector<int> spec_path;
+        int spec_cost = -1;
+        if (pipelining) {
+            int spec_state_id = select_random_path_state(plan_path);
+            SMPL_INFO("Add/Grow sphere at (random) state %d for speculative plan", spec_state_id);
+            m_adaptive_graph->addHighDimRegion(spec_state_id);
+            speculation = startSpeculativePlan(time_remaining, &spec_path, &spec_cost);
+        }
+
         m_tracker.force_planning_from_scratch();
         SMPL_INFO("Time remaining: %0.3fs. Track low-dimensional path", time_remaining);
-        time_params = m_time_params.tracking;
+        ARAStar::TimeParameters time_params = m_time_params.tracking;
         time_params.max_allowed_time_init = to_duration(time_remaining);
         time_params.max_allowed_time = std::min(time_params.max_allowed_time, to_duration(time_remaining));
         res = m_tracker.replan(time_params, &track_path, &track_cost);
-        auto track_finish = clock::now();
 
         SMPL_INFO("Tracker terminated");
         SMPL_INFO_STREAM("  Path: " << track_path);
@@ -254,54 +294,68 @@ int AdaptivePlanner::replan(
         SMPL_INFO("  Expansions: %d", m_tracker.get_n_expands());
         SMPL_INFO("  Suboptimality Bound: %0.3f", m_tracker.get_solution_eps());
 
-        time_remaining -= to_seconds(plan_finish - plan_start);
+        // tracker found a (partial) solution
+        const bool finished =
+                res && !track_path.empty() && track_path.back() == m_goal_state_id;
+        const bool accepted = finished && track_cost <= m_eps_track * plan_cost;
+        const bool partial = res && !finished;
+
+        int spec_res = 0;
+        if (pipelining) {
+            // the speculative plan is only useful if the tracked path was
+            // rejected or not found
+            if (accepted || partial || Expired(m_cancel)) {
+                m_speculation_cancel.cancel();
+            }
+            spec_res = speculation.get();
+            m_planner.setCancellationToken(m_cancel);
+        }
+
+        auto track_finish = clock::now();
+        time_remaining -= to_seconds(track_finish - track_start);
         time_remaining = std::max(0.0, time_remaining);
 
-        auto select_random_path_state = [this](const std::vector<int>& path)
-        {
-            std::uniform_int_distribution<int> dist(0, path.size() - 1);
-            int ridx = dist(m_rng);
-            return path[ridx];
-        };
-
-        if (res) { // tracker found a (partial) solution
-            bool finished =
-                    !track_path.empty() && track_path.back() == m_goal_state_id;
-
-            if (finished) {
-                if (track_cost <= m_eps_track * plan_cost) {
-                    SMPL_INFO("Solution accepted (%d <= %0.3f * %d)", track_cost, m_eps_track, plan_cost);
-                    // solution quality is acceptable
-                    done = true;
-                    *solution = track_path;
-                    *cost = track_cost;
-                    return !SUCCESS;
-                } else {
-                    SMPL_INFO("Solution rejected (%d > %0.3f * %d)", track_cost, m_eps_track, plan_cost);
-                    if (time_remaining == 0.0) {
-                        SMPL_WARN("Ran out of time after tracking phase");
-                        return !TIMED_OUT;
-                    }
-                    // tracker solution quality is poor: identify the largest
-                    // cost discrepancy between the adaptive path and the
-                    // returned path and introduce a sphere there
-                    int worst_state_id = select_random_path_state(plan_path);
-                    m_adaptive_graph->addHighDimRegion(worst_state_id);
-                }
-            } else {
-                if (time_remaining == 0.0) {
-                    SMPL_WARN("Ran out of time after tracking phase");
+        if (finished) {
+            if (accepted) {
+                SMPL_INFO("Solution accepted (%d <= %0.3f * %d)", track_cost, m_eps_track, plan_cost);
+                // solution quality is acceptable
+                done = true;
+                *solution = track_path;
+                *cost = track_cost;
+                return !SUCCESS;
+            }
+            SMPL_INFO("Solution rejected (%d > %0.3f * %d)", track_cost, m_eps_track, plan_cost);
+        }
+
+        if (time_remaining == 0.0) {
+            SMPL_WARN("Ran out of time after tracking phase");
+            return !TIMED_OUT;
+        }
+
+        if (partial) {
+            // the speculative plan, if any, grew the wrong region
+            SMPL_INFO("Add/Grow sphere at (terminal) state %d", track_path.back());
+            m_adaptive_graph->addHighDimRegion(track_path.back());
+        } else if (pipelining) {
+            SMPL_INFO("Speculative planner terminated");
+            SMPL_INFO_STREAM("  Path: " << spec_path);
+            SMPL_INFO("  Cost: %d", spec_cost);
+            if (!spec_res) {
+                if (Expired(m_cancel)) {
+                    SMPL_WARN("Planning cancelled");
                     return !TIMED_OUT;
                 }
-                SMPL_INFO("Add/Grow sphere at (terminal) state %d", track_path.back());
-                m_adaptive_graph->addHighDimRegion(track_path.back());
+                SMPL_WARN("Failed to find least-cost path in G^ad");
+                return !FAILED_TO_FIND_PATH;
             }
+            plan_path = std::move(spec_path);
+            plan_cost = spec_cost;
+            have_plan = true;
         } else {
-            if (time_remaining == 0.0) {
-                SMPL_WARN("Ran out of time after tracking phase");
-                return !TIMED_OUT;
-            }
-            // tracker failed to find a solution
+            // tracker solution quality is poor or the tracker failed to find
+            // a solution: identify the largest cost discrepancy between the
+            // adaptive path and the returned path and introduce a sphere
+            // there
             int best_state_id = select_random_path_state(plan_path);
             SMPL_INFO("Add/Grow sphere at (random) state %d", best_state_id);
             m_adaptive_graph->addHighDimRegion(best_state_id);
@@ -312,6 +366,47 @@ int AdaptivePlanner::replan(
     return !TIMED_OUT;
 }
 
+// Run the plan phase on another thread, polling a separate cancellation token
+// so that it may be abandoned without cancelling the track phase. The planner
+// polls the speculative token until the returned future is consumed.
+auto AdaptivePlanner::startSpeculativePlan(
+    double time_remaining,
+    std::vector<int>* path,
+    int* cost)
+    -> std::future<int>
+{
+    m_speculation_cancel.reset();
+    if (m_cancel != nullptr && m_cancel->hasDeadline()) {
+        m_speculation_cancel.setDeadline(m_cancel->deadline());
+    }
+    m_planner.setCancellationToken(&m_speculation_cancel);
+
+    ARAStar::TimeParameters time_params = m_time_params.planning;
+    time_params.max_allowed_time_init = to_duration(time_remaining);
+    time_params.max_allowed_time = std::min(time_params.max_allowed_time, to_duration(time_remaining));
+
+    m_planner.force_planning_from_scratch();
+    return std::async(std::launch::async, [this, time_params, path, cost]()
+    {
+        return m_planner.replan(time_params, path, cost);
+    });
+}
+
+Extension* AdaptivePlanner::getExtension(size_t class_code)
+{
+    if (class_code == GetClassCode<CancellationExtension>()) {
+        return this;
+    }
+    return nullptr;
+}
+
+void AdaptivePlanner::setCancellationToken(const CancellationToken* token)
+{
+    m_cancel = token;
+    m_planner.setCancellationToken(token);
+    m_tracker.setCancellationToken(token);
+}
+
 int AdaptivePlanner::set_goal(int goal_state_id)
 {
     m_goal_state_id = goal_state_id;
@@ -0,0 +1,541 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+/// \author Andrew Dornbush
+
+#include <smpl/search/anastar.h>
+
+#include <algorithm>
+#include <limits>
+
+// project includes
+#include <smpl/console/console.h>
+#include <smpl/telemetry.h>
+
+namespace smpl {
+
+static const char* SLOG = "search";
+static const char* SELOG = "search.expansions";
+
+ANAStar::ANAStar(DiscreteSpaceInformation* space, Heuristic* heur) :
+    SBPLPlanner(),
+    m_space(space),
+    m_heur(heur),
+    m_states(),
+    m_state_arena(),
+    m_start_state_id(-1),
+    m_goal_state_id(-1),
+    m_open(),
+    m_succs(),
+    m_costs(),
+    m_call_number(0),
+    m_last_start_state_id(-1),
+    m_last_goal_state_id(-1),
+    m_improve(true),
+    m_bounded(true),
+    m_allowed_time(clock::duration::zero()),
+    m_solution_cost(INFINITECOST),
+    m_solution_eps(std::numeric_limits<double>::infinity()),
+    m_solution(),
+    m_expand_count_init(0),
+    m_search_time_init(clock::duration::zero()),
+    m_expand_count(0),
+    m_search_time(clock::duration::zero())
+{
+    environment_ = space;
+}
+
+ANAStar::~ANAStar()
+{
+    // search states are trivially destructible and are freed along with
+    // m_state_arena
+}
+
+enum ReplanResultCode
+{
+    SUCCESS = 0,
+    PARTIAL_SUCCESS,
+    START_NOT_SET,
+    GOAL_NOT_SET,
+    TIMED_OUT,
+    EXHAUSTED_OPEN_LIST,
+    OUT_OF_MEMORY
+};
+
+int ANAStar::replan(double allowed_time, std::vector<int>* solution)
+{
+    int cost;
+    return replan(allowed_time, solution, &cost);
+}
+
+int ANAStar::replan(
+    double allowed_time,
+    std::vector<int>* solution,
+    int* cost)
+{
+    SMPL_DEBUG_NAMED(SLOG, "Find path to goal");
+
+    if (m_start_state_id < 0) {
+        SMPL_ERROR_NAMED(SLOG, "Start state not set");
+        return !START_NOT_SET;
+    }
+    if (m_goal_state_id < 0) {
+        SMPL_ERROR_NAMED(SLOG, "Goal state not set");
+        return !GOAL_NOT_SET;
+    }
+
+    m_allowed_time = to_duration(allowed_time);
+
+    SearchState* start_state = getSearchState(m_start_state_id);
+    SearchState* goal_state = getSearchState(m_goal_state_id);
+    if (start_state == NULL || goal_state == NULL) {
+        SMPL_ERROR_NAMED(SLOG, "Failed to create start and goal search states within the memory limit");
+        return !OUT_OF_MEMORY;
+    }
+
+    if (m_start_state_id != m_last_start_state_id ||
+        m_goal_state_id != m_last_goal_state_id)
+    {
+        SMPL_DEBUG_NAMED(SLOG, "Reinitialize search");
+        m_open.clear();
+        ++m_call_number; // trigger state reinitializations
+
+        m_solution_cost = INFINITECOST;
+        m_solution_eps = std::numeric_limits<double>::infinity();
+        m_solution.clear();
+
+        reinitSearchState(start_state);
+        reinitSearchState(goal_state);
+
+        start_state->g = 0;
+        start_state->key = computeKey(start_state);
+        m_open.push(start_state);
+
+        m_expand_count_init = 0;
+        m_search_time_init = clock::duration::zero();
+        m_expand_count = 0;
+        m_search_time = clock::duration::zero();
+
+        m_last_start_state_id = m_start_state_id;
+        m_last_goal_state_id = m_goal_state_id;
+    }
+
+    auto start_time = clock::now();
+    int num_expansions = 0;
+    clock::duration elapsed_time = clock::duration::zero();
+
+    int err;
+    while (true) {
+        auto had_solution = m_solution_cost != INFINITECOST;
+        err = improvePath(start_time, goal_state, num_expansions, elapsed_time);
+        if (!had_solution) {
+            m_expand_count_init = m_expand_count + num_expansions;
+            m_search_time_init = m_search_time + elapsed_time;
+        }
+        if (err) {
+            break;
+        }
+
+        SMPL_DEBUG_NAMED(SLOG, "Improved solution to cost %u", m_solution_cost);
+
+        // reorder OPEN by the potentials under the new solution cost
+        pruneOpen();
+
+        if (!m_improve) {
+            break;
+        }
+    }
+
+    m_search_time += elapsed_time;
+    m_expand_count += num_expansions;
+
+    if (m_solution_cost == INFINITECOST) {
+        return !err;
+    }
+
+    // no cheaper solution remains
+    if (err == EXHAUSTED_OPEN_LIST) {
+        m_solution_eps = 1.0;
+    }
+
+    SMPL_DEBUG_NAMED(SLOG, "Return solution with cost %u and bound %0.3f", m_solution_cost, m_solution_eps);
+    solution->insert(end(*solution), begin(m_solution), end(m_solution));
+    *cost = m_solution_cost;
+    return !SUCCESS;
+}
+
+int ANAStar::replan(std::vector<int>* solution, ReplanParams params)
+{
+    int cost;
+    return replan(solution, params, &cost);
+}
+
+/// The epsilon parameters are ignored. A request for the first solution,
+/// found without a time limit, applies to this call alone.
+int ANAStar::replan(
+    std::vector<int>* solution,
+    ReplanParams params,
+    int* cost)
+{
+    auto improve = m_improve;
+    auto bounded = m_bounded;
+    if (params.return_first_solution) {
+        m_improve = false;
+        m_bounded = false;
+    }
+    auto res = replan(params.max_time, solution, cost);
+    m_improve = improve;
+    m_bounded = bounded;
+    return res;
+}
+
+/// Force the planner to forget previous search efforts, begin from scratch,
+/// and free all memory allocated by the planner during previous searches.
+int ANAStar::force_planning_from_scratch_and_free_memory()
+{
+    force_planning_from_scratch();
+    m_open.clear();
+    m_states.clear();
+    m_states.shrink_to_fit();
+    m_state_arena.release();
+    return 0;
+}
+
+/// Return the suboptimality bound of the current solution.
+double ANAStar::get_solution_eps() const
+{
+    return m_solution_eps;
+}
+
+/// Return the number of expansions made in progress to the final solution.
+int ANAStar::get_n_expands() const
+{
+    return m_expand_count;
+}
+
+/// Return the suboptimality bound of the first solution, which is found by a
+/// greedy search and so has none.
+double ANAStar::get_initial_eps()
+{
+    return std::numeric_limits<double>::infinity();
+}
+
+/// Return the time consumed by the search in progress to the initial solution.
+double ANAStar::get_initial_eps_planning_time()
+{
+    return to_seconds(m_search_time_init);
+}
+
+/// Return the time consumed by the search in progress to the final solution.
+double ANAStar::get_final_eps_planning_time()
+{
+    return to_seconds(m_search_time);
+}
+
+/// Return the number of expansions made in progress to the initial solution.
+int ANAStar::get_n_expands_init_solution()
+{
+    return m_expand_count_init;
+}
+
+/// Return the final suboptimality bound.
+double ANAStar::get_final_epsilon()
+{
+    return m_solution_eps;
+}
+
+/// Return statistics for the search.
+void ANAStar::get_search_stats(std::vector<PlannerStats>* s)
+{
+    PlannerStats stats;
+    stats.eps = m_solution_eps;
+    stats.cost = m_solution_cost;
+    stats.expands = m_expand_count;
+    stats.time = to_seconds(m_search_time);
+    s->push_back(stats);
+}
+
+Extension* ANAStar::getExtension(size_t class_code)
+{
+    if (class_code == GetClassCode<MemoryUsageExtension>() ||
+        class_code == GetClassCode<CancellationExtension>())
+    {
+        return this;
+    }
+    return nullptr;
+}
+
+/// Return the memory held by the search states and lists. The OPEN list is
+/// counted by the number of states it holds.
+auto ANAStar::memoryUsage() const -> std::size_t
+{
+    auto usage = m_state_arena.capacity();
+    usage += MemoryUsage(m_states);
+    usage += m_open.size() * (sizeof(SearchState*) + sizeof(double));
+    usage += MemoryUsage(m_succs);
+    usage += MemoryUsage(m_costs);
+    usage += MemoryUsage(m_solution);
+    return usage;
+}
+
+/// Set the goal state.
+int ANAStar::set_goal(int goal_state_id)
+{
+    m_goal_state_id = goal_state_id;
+    return 1;
+}
+
+/// Set the start state.
+int ANAStar::set_start(int start_state_id)
+{
+    m_start_state_id = start_state_id;
+    return 1;
+}
+
+/// Force the search to forget previous search efforts and start from scratch.
+int ANAStar::force_planning_from_scratch()
+{
+    m_last_start_state_id = -1;
+    m_last_goal_state_id = -1;
+    return 0;
+}
+
+/// Set whether the search for the first solution is bounded by the allowed
+/// time.
+int ANAStar::set_search_mode(bool first_solution_unbounded)
+{
+    m_bounded = !first_solution_unbounded;
+    return 0;
+}
+
+/// Notify the search of changes to edge costs in the graph.
+void ANAStar::costs_changed(const StateChangeQuery& changes)
+{
+    force_planning_from_scratch();
+}
+
+// Test whether the search has run out of time.
+bool ANAStar::timedOut(const clock::duration& elapsed_time) const
+{
+    if (Expired(m_cancel)) {
+        return true;
+    }
+
+    if (!m_bounded && m_solution_cost == INFINITECOST) {
+        return false;
+    }
+
+    return elapsed_time >= m_allowed_time;
+}
+
+// Expand states in order of potential until a solution cheaper than the
+// current one is found, time runs out, or OPEN is exhausted.
+int ANAStar::improvePath(
+    const clock::time_point& start_time,
+    SearchState* goal_state,
+    int& elapsed_expansions,
+    clock::duration& elapsed_time)
+{
+    while (!m_open.empty()) {
+        SearchState* min_state = m_open.min();
+
+        elapsed_time = clock::now() - start_time;
+        if (timedOut(elapsed_time)) {
+            SMPL_DEBUG_NAMED(SLOG, "Ran out of time");
+            return TIMED_OUT;
+        }
+
+        m_open.pop();
+
+        // the state with the greatest potential bounds the suboptimality of
+        // the current solution
+        if (m_solution_cost != INFINITECOST) {
+            m_solution_eps = std::min(m_solution_eps, -min_state->key);
+        }
+
+        if (min_state == goal_state) {
+            SMPL_DEBUG_NAMED(SLOG, "Found path to goal");
+            m_solution_cost = goal_state->g;
+            m_solution.clear();
+            extractPath(goal_state, m_solution);
+            return SUCCESS;
+        }
+
+        SMPL_DEBUG_NAMED(SELOG, "Expand state %d", min_state->state_id);
+
+        if (!expand(min_state)) {
+            SMPL_WARN_NAMED(SLOG, "Reached search memory limit of %zu bytes", memoryLimit());
+            m_open.push(min_state);
+            return OUT_OF_MEMORY;
+        }
+
+        ++elapsed_expansions;
+    }
+
+    return EXHAUSTED_OPEN_LIST;
+}
+
+// Expand a state, placing the successors whose cost-to-come it improves into
+// OPEN unless they can not lead to a solution cheaper than the current one.
+// Return false, leaving the successors unchanged, if search states for the
+// successors could not be created within the memory limit.
+bool ANAStar::expand(SearchState* s)
+{
+    m_succs.clear();
+    m_costs.clear();
+    {
+        TelemetryTimer timer(TelemetryEvent::Expansion);
+        m_space->GetSuccs(s->state_id, &m_succs, &m_costs);
+    }
+    TelemetryCount(TelemetryEvent::SuccessorGenerated, m_succs.size());
+
+    SMPL_DEBUG_NAMED(SELOG, "  %zu successors", m_succs.size());
+
+    for (int succ_state_id : m_succs) {
+        if (getSearchState(succ_state_id) == NULL) {
+            return false;
+        }
+    }
+
+    for (size_t sidx = 0; sidx < m_succs.size(); ++sidx) {
+        SearchState* succ_state = getSearchState(m_succs[sidx]);
+        reinitSearchState(succ_state);
+
+        unsigned int new_cost = s->g + m_costs[sidx];
+        if (new_cost >= succ_state->g) {
+            continue;
+        }
+
+        succ_state->g = new_cost;
+        succ_state->bp = s;
+        if (new_cost + succ_state->h >= m_solution_cost) {
+            continue;
+        }
+
+        // a cheaper path raises the potential, so the key only decreases
+        succ_state->key = computeKey(succ_state);
+        if (m_open.contains(succ_state)) {
+            m_open.decrease(succ_state);
+        } else {
+            m_open.push(succ_state);
+        }
+    }
+
+    return true;
+}
+
+// Remove the states from OPEN that can not lead to a solution cheaper than the
+// current one, and reorder the rest by their potentials.
+void ANAStar::pruneOpen()
+{
+    std::vector<SearchState*> pruned;
+    for (auto it = m_open.begin(); it != m_open.end(); ++it) {
+        auto* s = *it;
+        if (s->g + s->h >= m_solution_cost) {
+            pruned.push_back(s);
+        } else {
+            s->key = computeKey(s);
+        }
+    }
+    for (auto* s : pruned) {
+        m_open.erase(s);
+    }
+    m_open.make();
+    SMPL_DEBUG_NAMED(SLOG, "Pruned %zu states from OPEN, %zu remain", pruned.size(), m_open.size());
+}
+
+// Return the key of a state in OPEN. Before the first solution, states are
+// ordered by their heuristics; afterwards, by decreasing potential.
+double ANAStar::computeKey(const SearchState* s) const
+{
+    if (m_solution_cost == INFINITECOST) {
+        return (double)s->h;
+    }
+    if (s->h == 0) {
+        return -std::numeric_limits<double>::infinity();
+    }
+    return -((double)m_solution_cost - (double)s->g) / (double)s->h;
+}
+
+// Get the search state corresponding to a graph state, creating a new state if
+// one has not been created yet. Return null if the state could not be created
+// within the memory limit.
+ANAStar::SearchState* ANAStar::getSearchState(int state_id)
+{
+    if (m_states.size() <= state_id) {
+        m_states.resize(state_id + 1, nullptr);
+    }
+
+    auto& state = m_states[state_id];
+    if (state == NULL) {
+        state = createState(state_id);
+    }
+
+    return state;
+}
+
+// Create a new search state for a graph state.
+ANAStar::SearchState* ANAStar::createState(int state_id)
+{
+    SearchState* ss = m_state_arena.tryConstruct<SearchState>();
+    if (ss == NULL) {
+        return NULL;
+    }
+    ss->state_id = state_id;
+    ss->call_number = 0;
+    return ss;
+}
+
+// Lazily (re)initialize a search state.
+void ANAStar::reinitSearchState(SearchState* state)
+{
+    if (state->call_number != m_call_number) {
+        SMPL_DEBUG_NAMED(SELOG, "Reinitialize state %d", state->state_id);
+        state->g = INFINITECOST;
+        {
+            TelemetryTimer timer(TelemetryEvent::HeuristicEvaluation);
+            state->h = m_heur->GetGoalHeuristic(state->state_id);
+        }
+        state->key = std::numeric_limits<double>::infinity();
+        state->call_number = m_call_number;
+        state->bp = nullptr;
+    }
+}
+
+// Extract the path from the start state up to a new state.
+void ANAStar::extractPath(SearchState* to_state, std::vector<int>& solution) const
+{
+    for (SearchState* s = to_state; s; s = s->bp) {
+        solution.push_back(s->state_id);
+    }
+    std::reverse(solution.begin(), solution.end());
+}
+
+} // namespace smpl
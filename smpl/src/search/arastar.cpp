@@ -32,6 +32,9 @@
 #include <smpl/search/arastar.h>
 
 #include <algorithm>
+#include <cstdint>
+#include <new>
+#include <thread>
 
 // system includes
 #include <sbpl/utils/key.h>
@@ -39,13 +42,17 @@
 // project includes
 #include <smpl/time.h>
 #include <smpl/console/console.h>
+#include <smpl/telemetry.h>
+#include <smpl/graph/robot_planning_space.h>
+#include <smpl/heuristic/robot_heuristic.h>
 
 namespace smpl {
 
 static const char* SLOG = "search";
 static const char* SELOG = "search.expansions";
 
-ARAStar::ARAStar(
+template <class OpenPolicy>
+BasicARAStar<OpenPolicy>::BasicARAStar(
     DiscreteSpaceInformation* space,
     Heuristic* heur)
 :
@@ -57,7 +64,9 @@ ARAStar::ARAStar(
     m_final_eps(1.0),
     m_delta_eps(1.0),
     m_allow_partial_solutions(false),
-    m_states(),
+    m_backward_search(false),
+    m_state_pages(),
+    m_state_arena(),
     m_start_state_id(-1),
     m_goal_state_id(-1),
     m_open(),
@@ -65,6 +74,7 @@ ARAStar::ARAStar(
     m_curr_eps(1.0),
     m_iteration(1),
     m_call_number(0),
+    m_h_epoch(0),
     m_last_start_state_id(-1),
     m_last_goal_state_id(-1),
     m_last_eps(1.0),
@@ -85,13 +95,11 @@ ARAStar::ARAStar(
     m_time_params.max_allowed_time = clock::duration::zero();
 }
 
-ARAStar::~ARAStar()
+template <class OpenPolicy>
+BasicARAStar<OpenPolicy>::~BasicARAStar()
 {
-    for (SearchState* s : m_states) {
-        if (s != NULL) {
-            delete s;
-        }
-    }
+    // search states are trivially destructible and are freed along with
+    // m_state_arena
 }
 
 enum ReplanResultCode
@@ -101,16 +109,20 @@ enum ReplanResultCode
     START_NOT_SET,
     GOAL_NOT_SET,
     TIMED_OUT,
-    EXHAUSTED_OPEN_LIST
+    EXHAUSTED_OPEN_LIST,
+    OUT_OF_MEMORY
 };
 
-int ARAStar::replan(
+template <class OpenPolicy>
+int BasicARAStar<OpenPolicy>::replan(
     const TimeParameters& params,
     std::vector<int>* solution,
     int* cost)
 {
     SMPL_DEBUG_NAMED(SLOG, "Find path to goal");
 
+    m_replan_error = SUCCESS;
+
     if (m_start_state_id < 0) {
         SMPL_ERROR_NAMED(SLOG, "Start state not set");
         return !START_NOT_SET;
@@ -119,24 +131,56 @@ int ARAStar::replan(
         SMPL_ERROR_NAMED(SLOG, "Goal state not set");
         return !GOAL_NOT_SET;
     }
+    m_goal_solutions.clear();
+    if (m_goal_set_search && !initGoalSet()) {
+        return !GOAL_NOT_SET;
+    }
 
     m_time_params = params;
 
+    if (m_trace != nullptr) {
+        m_trace->recordSearch(m_start_state_id, m_goal_state_id, m_initial_eps);
+    }
+
     SearchState* start_state = getSearchState(m_start_state_id);
     SearchState* goal_state = getSearchState(m_goal_state_id);
+    if (start_state == NULL || goal_state == NULL) {
+        SMPL_ERROR_NAMED(SLOG, "Failed to create start and goal search states within the memory limit");
+        return !OUT_OF_MEMORY;
+    }
 
-    if (m_start_state_id != m_last_start_state_id) {
+    // the search tree is rooted at the start and grows toward the goal, or,
+    // when searching backward, is rooted at the goal and grows toward the start
+    SearchState* root_state = m_backward_search ? goal_state : start_state;
+    SearchState* target_state = m_backward_search ? start_state : goal_state;
+    int& last_root_state_id = m_backward_search ? m_last_goal_state_id : m_last_start_state_id;
+    int& last_target_state_id = m_backward_search ? m_last_start_state_id : m_last_goal_state_id;
+
+    // a new goal changes which states satisfy each goal of a goal set, so the
+    // search starts over rather than updating its heuristics
+    // likewise when states have been retired, since states that could not
+    // improve the path to the previous target may lie on the path to this one
+    if (root_state->state_id != last_root_state_id ||
+        ((m_goal_set_search || m_states_retired) &&
+            target_state->state_id != last_target_state_id))
+    {
         SMPL_DEBUG_NAMED(SLOG, "Reinitialize search");
         m_open.clear();
         m_incons.clear();
         ++m_call_number; // trigger state reinitializations
+        m_states_retired = false;
+
+        if (m_goal_set_search) {
+            resetGoalSet();
+        }
 
-        reinitSearchState(start_state);
-        reinitSearchState(goal_state);
+        reinitSearchState(root_state);
+        reinitSearchState(target_state);
 
-        start_state->g = 0;
-        start_state->f = computeKey(start_state);
-        m_open.push(start_state);
+        root_state->g = 0;
+        root_state->f = computeKey(root_state);
+        m_open.push(root_state);
+        updateGoalSet(root_state);
 
         m_iteration = 1; // 0 reserved for "not closed on any iteration"
 
@@ -150,25 +194,45 @@ int ARAStar::replan(
 
         m_satisfied_eps = std::numeric_limits<double>::infinity();
 
-        m_last_start_state_id = m_start_state_id;
-    }
-
-    if (m_goal_state_id != m_last_goal_state_id) {
+        last_root_state_id = root_state->state_id;
+        last_target_state_id = target_state->state_id;
+    } else if (target_state->state_id != last_target_state_id) {
         SMPL_DEBUG_NAMED(SLOG, "Refresh heuristics, keys, and reorder open list");
+        reinitSearchState(target_state);
         recomputeHeuristics();
+        refreshHeuristic(target_state);
+
+        // begin a new search iteration so that states closed while searching
+        // for the previous target may be reopened under the new heuristic
+        ++m_iteration;
+        for (SearchState* s : m_incons) {
+            s->incons = false;
+            refreshHeuristic(s);
+            m_open.append(s);
+        }
+        m_incons.clear();
         reorderOpen();
+        if (target_state->g != INFINITECOST && !m_open.contains(target_state)) {
+            target_state->f = computeKey(target_state);
+        }
 
-        m_last_goal_state_id = m_goal_state_id;
+        // solutions found for the previous target say nothing about this one
+        m_satisfied_eps = std::numeric_limits<double>::infinity();
+
+        last_target_state_id = target_state->state_id;
     }
 
     auto start_time = clock::now();
     int num_expansions = 0;
     clock::duration elapsed_time = clock::duration::zero();
 
-    int err;
+    int err = SUCCESS;
     while (m_satisfied_eps > m_final_eps) {
         if (m_curr_eps == m_satisfied_eps) {
-            if (!m_time_params.improve) {
+            if (!m_time_params.improve ||
+                (m_goal_set_search &&
+                    m_goal_set_termination == GoalSetTermination::FirstGoal))
+            {
                 break;
             }
             // begin a new search iteration
@@ -177,13 +241,13 @@ int ARAStar::replan(
             m_curr_eps = std::max(m_curr_eps, m_final_eps);
             for (SearchState* s : m_incons) {
                 s->incons = false;
-                m_open.push(s);
+                m_open.append(s);
             }
             reorderOpen();
             m_incons.clear();
             SMPL_DEBUG_NAMED(SLOG, "Begin new search iteration %d with epsilon = %0.3f", m_iteration, m_curr_eps);
         }
-        err = improvePath(start_time, goal_state, num_expansions, elapsed_time);
+        err = improvePath(start_time, target_state, num_expansions, elapsed_time);
         if (m_curr_eps == m_initial_eps) {
             m_expand_count_init += num_expansions;
             m_search_time_init += elapsed_time;
@@ -193,13 +257,19 @@ int ARAStar::replan(
         }
         SMPL_DEBUG_NAMED(SLOG, "Improved solution");
         m_satisfied_eps = m_curr_eps;
+
+        if (m_retire_states && !m_goal_set_search) {
+            retireStates(target_state);
+        }
     }
 
     m_search_time += elapsed_time;
     m_expand_count += num_expansions;
+    m_replan_error = err;
 
     if (m_satisfied_eps == std::numeric_limits<double>::infinity()) {
-        if (m_allow_partial_solutions && !m_open.empty()) {
+        // a partial path from the goal is of no use to the caller
+        if (m_allow_partial_solutions && !m_backward_search && !m_open.empty()) {
             SearchState* next_state = m_open.min();
             extractPath(next_state, *solution, *cost);
             return !SUCCESS;
@@ -207,11 +277,16 @@ int ARAStar::replan(
         return !err;
     }
 
-    extractPath(goal_state, *solution, *cost);
+    if (m_goal_set_search) {
+        extractGoalSolutions(*solution, *cost);
+    } else {
+        extractPath(target_state, *solution, *cost);
+    }
     return !SUCCESS;
 }
 
-int ARAStar::replan(
+template <class OpenPolicy>
+int BasicARAStar<OpenPolicy>::replan(
     double allowed_time,
     std::vector<int>* solution)
 {
@@ -239,7 +314,8 @@ int ARAStar::replan(
 //       case epsilon raised
 //           reevaluate heuristics and reorder the open list
 // case scenario_changed
-int ARAStar::replan(
+template <class OpenPolicy>
+int BasicARAStar<OpenPolicy>::replan(
     double allowed_time,
     std::vector<int>* solution,
     int* cost)
@@ -260,7 +336,8 @@ int ARAStar::replan(
     return replan(tparams, solution, cost);
 }
 
-int ARAStar::replan(
+template <class OpenPolicy>
+int BasicARAStar<OpenPolicy>::replan(
     std::vector<int>* solution,
     ReplanParams params)
 {
@@ -268,7 +345,8 @@ int ARAStar::replan(
     return replan(solution, params, &cost);
 }
 
-int ARAStar::replan(
+template <class OpenPolicy>
+int BasicARAStar<OpenPolicy>::replan(
     std::vector<int>* solution,
     ReplanParams params,
     int* cost)
@@ -283,66 +361,113 @@ int ARAStar::replan(
     return replan(tparams, solution, cost);
 }
 
+/// Expand at most \p max_expansions states toward the solution, within the
+/// current time parameters otherwise, and return control to the caller. The
+/// search resumes from where it left off on the next call, while the start and
+/// goal are unchanged.
+///
+/// While the search is unfinished, StepStatus::Searching is returned, and the
+/// best solution found so far, if any, or a partial solution, if allowed, is
+/// stored in \p solution and \p cost.
+/// The search is finished once it has found a solution within the target
+/// suboptimality bound, or, if it does not improve solutions, its first one.
+/// The solution is then stored and StepStatus::Solved is returned. If no
+/// solution was found when the search runs out of states, memory, or is
+/// cancelled, StepStatus::Failed is returned.
+template <class OpenPolicy>
+auto BasicARAStar<OpenPolicy>::step(
+    int max_expansions,
+    std::vector<int>* solution,
+    int* cost)
+    -> StepStatus
+{
+    TimeParameters params = m_time_params;
+    params.bounded = true;
+    params.type = TimeParameters::EXPANSIONS;
+    params.max_expansions_init = max_expansions;
+    params.max_expansions = max_expansions;
+
+    // keep the time parameters of replan() for subsequent blocking calls
+    auto time_params = m_time_params;
+    replan(params, solution, cost);
+    m_time_params = time_params;
+
+    if (m_replan_error == TIMED_OUT && !Expired(m_cancel)) {
+        return StepStatus::Searching;
+    }
+    if (m_satisfied_eps == std::numeric_limits<double>::infinity()) {
+        return StepStatus::Failed;
+    }
+    return StepStatus::Solved;
+}
+
 /// Force the planner to forget previous search efforts, begin from scratch,
 /// and free all memory allocated by the planner during previous searches.
-int ARAStar::force_planning_from_scratch_and_free_memory()
+template <class OpenPolicy>
+int BasicARAStar<OpenPolicy>::force_planning_from_scratch_and_free_memory()
 {
     force_planning_from_scratch();
     m_open.clear();
-    for (SearchState* s : m_states) {
-        if (s != NULL) {
-            delete s;
-        }
-    }
-    m_states.clear();
-    m_states.shrink_to_fit();
+    m_state_pages.clear();
+    m_state_pages.shrink_to_fit();
+    m_free_pages.clear();
+    m_free_pages.shrink_to_fit();
+    m_state_arena.release();
     return 0;
 }
 
 /// Return the suboptimality bound of the current solution for the current search.
-double ARAStar::get_solution_eps() const
+template <class OpenPolicy>
+double BasicARAStar<OpenPolicy>::get_solution_eps() const
 {
     return m_satisfied_eps;
 }
 
 /// Return the number of expansions made in progress to the final solution.
-int ARAStar::get_n_expands() const
+template <class OpenPolicy>
+int BasicARAStar<OpenPolicy>::get_n_expands() const
 {
     return m_expand_count;
 }
 
 /// Return the initial suboptimality bound
-double ARAStar::get_initial_eps()
+template <class OpenPolicy>
+double BasicARAStar<OpenPolicy>::get_initial_eps()
 {
     return m_initial_eps;
 }
 
 /// Return the time consumed by the search in progress to the initial solution.
-double ARAStar::get_initial_eps_planning_time()
+template <class OpenPolicy>
+double BasicARAStar<OpenPolicy>::get_initial_eps_planning_time()
 {
     return to_seconds(m_search_time_init);
 }
 
 /// Return the time consumed by the search in progress to the final solution.
-double ARAStar::get_final_eps_planning_time()
+template <class OpenPolicy>
+double BasicARAStar<OpenPolicy>::get_final_eps_planning_time()
 {
     return to_seconds(m_search_time);
 }
 
 /// Return the number of expansions made in progress to the initial solution.
-int ARAStar::get_n_expands_init_solution()
+template <class OpenPolicy>
+int BasicARAStar<OpenPolicy>::get_n_expands_init_solution()
 {
     return m_expand_count_init;
 }
 
 /// Return the final suboptimality bound.
-double ARAStar::get_final_epsilon()
+template <class OpenPolicy>
+double BasicARAStar<OpenPolicy>::get_final_epsilon()
 {
     return m_final_eps;
 }
 
 /// Return statistics for each completed search iteration.
-void ARAStar::get_search_stats(std::vector<PlannerStats>* s)
+template <class OpenPolicy>
+void BasicARAStar<OpenPolicy>::get_search_stats(std::vector<PlannerStats>* s)
 {
     PlannerStats stats;
     stats.eps = m_curr_eps;
@@ -352,28 +477,61 @@ void ARAStar::get_search_stats(std::vector<PlannerStats>* s)
     s->push_back(stats);
 }
 
+template <class OpenPolicy>
+Extension* BasicARAStar<OpenPolicy>::getExtension(size_t class_code)
+{
+    if (class_code == GetClassCode<MemoryUsageExtension>() ||
+        class_code == GetClassCode<CancellationExtension>())
+    {
+        return this;
+    }
+    return nullptr;
+}
+
+/// Return the memory held by the search states and lists. The OPEN list is
+/// counted by the number of states it holds.
+template <class OpenPolicy>
+auto BasicARAStar<OpenPolicy>::memoryUsage() const -> std::size_t
+{
+    auto usage = m_state_arena.capacity();
+    usage += MemoryUsage(m_state_pages);
+    usage += m_open.size() * sizeof(SearchState*);
+    usage += MemoryUsage(m_incons);
+    usage += MemoryUsage(m_free_pages);
+    usage += MemoryUsage(m_retire_marks);
+    usage += MemoryUsage(m_retired_ids);
+    usage += MemoryUsage(m_succs);
+    usage += MemoryUsage(m_costs);
+    usage += MemoryUsage(m_goal_states);
+    return usage;
+}
+
 /// Set the desired suboptimality bound for the initial solution.
-void ARAStar::set_initialsolution_eps(double eps)
+template <class OpenPolicy>
+void BasicARAStar<OpenPolicy>::set_initialsolution_eps(double eps)
 {
     m_initial_eps = eps;
 }
 
 /// Set the goal state.
-int ARAStar::set_goal(int goal_state_id)
+template <class OpenPolicy>
+int BasicARAStar<OpenPolicy>::set_goal(int goal_state_id)
 {
     m_goal_state_id = goal_state_id;
     return 1;
 }
 
 /// Set the start state.
-int ARAStar::set_start(int start_state_id)
+template <class OpenPolicy>
+int BasicARAStar<OpenPolicy>::set_start(int start_state_id)
 {
     m_start_state_id = start_state_id;
     return 1;
 }
 
 /// Force the search to forget previous search efforts and start from scratch.
-int ARAStar::force_planning_from_scratch()
+template <class OpenPolicy>
+int BasicARAStar<OpenPolicy>::force_planning_from_scratch()
 {
     m_last_start_state_id = -1;
     m_last_goal_state_id = -1;
@@ -382,31 +540,67 @@ int ARAStar::force_planning_from_scratch()
 
 /// Set whether the number of expansions is bounded by time or total expansions
 /// per call to replan().
-int ARAStar::set_search_mode(bool first_solution_unbounded)
+template <class OpenPolicy>
+int BasicARAStar<OpenPolicy>::set_search_mode(bool first_solution_unbounded)
 {
     m_time_params.bounded = !first_solution_unbounded;
     return 0;
 }
 
 /// Notify the search of changes to edge costs in the graph.
-void ARAStar::costs_changed(const StateChangeQuery& changes)
+template <class OpenPolicy>
+void BasicARAStar<OpenPolicy>::costs_changed(const StateChangeQuery& changes)
 {
     force_planning_from_scratch();
 }
 
-// Recompute heuristics for all states.
-void ARAStar::recomputeHeuristics()
+// Compute the heuristic for a state: the estimated cost to the goal, or, when
+// searching backward, from the start.
+template <class OpenPolicy>
+unsigned int BasicARAStar<OpenPolicy>::computeHeuristic(int state_id)
 {
-    for (SearchState* s : m_states) {
-        if (s != NULL) {
-            s->h = m_heur->GetGoalHeuristic(s->state_id);
+    TelemetryTimer timer(TelemetryEvent::HeuristicEvaluation);
+    if (m_backward_search) {
+        return m_heur->GetStartHeuristic(state_id);
+    } else if (m_goal_set_search && m_goal_set_heur != NULL) {
+        auto h = std::numeric_limits<unsigned int>::max();
+        for (int i = 0; i < m_goal_count; ++i) {
+            h = std::min(h, (unsigned int)m_goal_set_heur->GetGoalHeuristic(state_id, i));
+        }
+        return h;
+    } else {
+        return m_heur->GetGoalHeuristic(state_id);
+    }
+}
+
+// Invalidate the heuristics of all states and recompute them for the states
+// in OPEN. The heuristics of other states are recomputed when they are next
+// reached, by reinitSearchState, or refreshed explicitly.
+template <class OpenPolicy>
+void BasicARAStar<OpenPolicy>::recomputeHeuristics()
+{
+    ++m_h_epoch;
+    for (auto it = m_open.begin(); it != m_open.end(); ++it) {
+        refreshHeuristic(*it);
+    }
+}
+
+template <class OpenPolicy>
+void BasicARAStar<OpenPolicy>::refreshHeuristic(SearchState* s)
+{
+    if (s->h_epoch != (unsigned short)m_h_epoch) {
+        s->h = computeHeuristic(s->state_id);
+        s->h_epoch = (unsigned short)m_h_epoch;
+        if (m_trace != nullptr) {
+            m_trace->recordHeuristic(s->state_id, 0, s->h);
         }
     }
 }
 
 // Convert TimeParameters to ReplanParams. Uses the current epsilon values
 // to fill in the epsilon fields.
-void ARAStar::convertTimeParamsToReplanParams(
+template <class OpenPolicy>
+void BasicARAStar<OpenPolicy>::convertTimeParamsToReplanParams(
     const TimeParameters& t,
     ReplanParams& r) const
 {
@@ -425,7 +619,8 @@ void ARAStar::convertTimeParamsToReplanParams(
 
 // Convert ReplanParams to TimeParameters. Sets the current initial, final, and
 // delta eps from ReplanParams.
-void ARAStar::convertReplanParamsToTimeParams(
+template <class OpenPolicy>
+void BasicARAStar<OpenPolicy>::convertReplanParamsToTimeParams(
     const ReplanParams& r,
     TimeParameters& t)
 {
@@ -447,10 +642,15 @@ void ARAStar::convertReplanParamsToTimeParams(
 }
 
 // Test whether the search has run out of time.
-bool ARAStar::timedOut(
+template <class OpenPolicy>
+bool BasicARAStar<OpenPolicy>::timedOut(
     int elapsed_expansions,
     const clock::duration& elapsed_time) const
 {
+    if (Expired(m_cancel)) {
+        return true;
+    }
+
     if (!m_time_params.bounded) {
         return false;
     }
@@ -480,9 +680,10 @@ bool ARAStar::timedOut(
 
 // Expand states to improve the current solution until a solution within the
 // current suboptimality bound is found, time runs out, or no solution exists.
-int ARAStar::improvePath(
+template <class OpenPolicy>
+int BasicARAStar<OpenPolicy>::improvePath(
     const clock::time_point& start_time,
-    SearchState* goal_state,
+    SearchState* target_state,
     int& elapsed_expansions,
     clock::duration& elapsed_time)
 {
@@ -492,8 +693,8 @@ int ARAStar::improvePath(
         auto now = clock::now();
         elapsed_time = now - start_time;
 
-        // path to goal found
-        if (min_state->f >= goal_state->f || min_state == goal_state) {
+        // path to goal (or, searching backward, from start) found
+        if (targetReached(min_state, target_state)) {
             SMPL_DEBUG_NAMED(SLOG, "Found path to goal");
             return SUCCESS;
         }
@@ -510,27 +711,70 @@ int ARAStar::improvePath(
         assert(min_state->iteration_closed != m_iteration);
         assert(min_state->g != INFINITECOST);
 
+        auto iteration_closed = min_state->iteration_closed;
         min_state->iteration_closed = m_iteration;
         min_state->eg = min_state->g;
 
-        expand(min_state);
+        if (!expand(min_state)) {
+            SMPL_WARN_NAMED(SLOG, "Reached search memory limit of %zu bytes", memoryLimit());
+            min_state->iteration_closed = iteration_closed;
+            m_open.push(min_state);
+            return OUT_OF_MEMORY;
+        }
 
         ++elapsed_expansions;
     }
 
+    // every reachable goal has been found
+    if (m_goal_set_search && m_goals_reached > 0) {
+        return SUCCESS;
+    }
+
     return EXHAUSTED_OPEN_LIST;
 }
 
 // Expand a state, updating its successors and placing them into OPEN, CLOSED,
-// and INCONS list appropriately.
-void ARAStar::expand(SearchState* s)
+// and INCONS list appropriately. Return false, leaving the successors
+// unchanged, if search states for the successors could not be created within
+// the memory limit.
+template <class OpenPolicy>
+bool BasicARAStar<OpenPolicy>::expand(SearchState* s)
 {
     m_succs.clear();
     m_costs.clear();
-    m_space->GetSuccs(s->state_id, &m_succs, &m_costs);
+    {
+        TelemetryTimer timer(TelemetryEvent::Expansion);
+        if (m_trace != nullptr) {
+            auto then = clock::now();
+            if (m_backward_search) {
+                m_space->GetPreds(s->state_id, &m_succs, &m_costs);
+            } else {
+                m_space->GetSuccs(s->state_id, &m_succs, &m_costs);
+            }
+            auto graph_time = to_seconds(clock::now() - then);
+            m_trace->recordExpansion(
+                    s->state_id, s->g, s->h, graph_time, m_succs, m_costs);
+        } else if (m_backward_search) {
+            m_space->GetPreds(s->state_id, &m_succs, &m_costs);
+        } else {
+            m_space->GetSuccs(s->state_id, &m_succs, &m_costs);
+        }
+    }
+    TelemetryCount(TelemetryEvent::SuccessorGenerated, m_succs.size());
 
     SMPL_DEBUG_NAMED(SELOG, "  %zu successors", m_succs.size());
 
+    // look up the search states of all successors before updating any, and
+    // prefetch them, so that their cache misses overlap rather than stall
+    // each update in turn
+    for (int succ_state_id : m_succs) {
+        auto* succ_state = getSearchState(succ_state_id);
+        if (succ_state == NULL) {
+            return false;
+        }
+        __builtin_prefetch(succ_state, 1);
+    }
+
     for (size_t sidx = 0; sidx < m_succs.size(); ++sidx) {
         int succ_state_id = m_succs[sidx];
         int cost = m_costs[sidx];
@@ -543,6 +787,7 @@ void ARAStar::expand(SearchState* s)
         if (new_cost < succ_state->g) {
             succ_state->g = new_cost;
             succ_state->bp = s;
+            updateGoalSet(succ_state);
             if (succ_state->iteration_closed != m_iteration) {
                 succ_state->f = computeKey(succ_state);
                 if (m_open.contains(succ_state)) {
@@ -551,72 +796,396 @@ void ARAStar::expand(SearchState* s)
                     m_open.push(succ_state);
                 }
             } else if (!succ_state->incons) {
+                succ_state->incons = true;
                 m_incons.push_back(succ_state);
             }
         }
     }
+
+    return true;
 }
 
-// Recompute the f-values of all states in OPEN and reorder OPEN.
-void ARAStar::reorderOpen()
+// Look up the goal set of the graph and the per-goal heuristic for a goal-set
+// search.
+template <class OpenPolicy>
+bool BasicARAStar<OpenPolicy>::initGoalSet()
 {
-    for (auto it = m_open.begin(); it != m_open.end(); ++it) {
-        (*it)->f = computeKey(*it);
+    if (m_backward_search) {
+        SMPL_ERROR_NAMED(SLOG, "Goal-set search does not support backward search");
+        return false;
     }
+
+    auto* space = dynamic_cast<Extension*>(m_space);
+    m_goal_set = space != NULL ? space->getExtension<GoalSetExtension>() : NULL;
+    if (m_goal_set == NULL) {
+        SMPL_ERROR_NAMED(SLOG, "Goal-set search requires a Goal Set Extension");
+        return false;
+    }
+    if (m_goal_set->goalCount() <= 0) {
+        SMPL_ERROR_NAMED(SLOG, "Goal set is empty");
+        return false;
+    }
+
+    auto* heur = dynamic_cast<Extension*>(m_heur);
+    m_goal_set_heur = heur != NULL ? heur->getExtension<GoalSetHeuristicExtension>() : NULL;
+    return true;
+}
+
+// Forget the goals reached by a previous goal-set search.
+template <class OpenPolicy>
+void BasicARAStar<OpenPolicy>::resetGoalSet()
+{
+    m_goal_count = m_goal_set->goalCount();
+    m_goal_states.assign(m_goal_count, nullptr);
+    m_goals_reached = 0;
+    m_goal_bound = INFINITECOST;
+}
+
+// Record a new path to a state that satisfies a goal of the goal set, and
+// update the f-value at which the goal-set search is done: once any goal is
+// reached, when stopping at the first goal, or once OPEN's min f reaches the
+// cost of the k-th cheapest goal, when looking for the best k goals.
+template <class OpenPolicy>
+void BasicARAStar<OpenPolicy>::updateGoalSet(SearchState* s)
+{
+    if (s->goal < 0 || s->goal >= m_goal_count) {
+        return;
+    }
+
+    auto& best = m_goal_states[s->goal];
+    if (best == NULL) {
+        ++m_goals_reached;
+    } else if (best != s && best->g <= s->g) {
+        return;
+    }
+    best = s;
+
+    if (m_goal_set_termination == GoalSetTermination::FirstGoal) {
+        m_goal_bound = 0;
+        return;
+    }
+
+    auto k = std::min(m_goal_set_count, m_goal_count);
+    if (m_goals_reached < k) {
+        return;
+    }
+
+    std::vector<unsigned int> goal_costs;
+    goal_costs.reserve(m_goals_reached);
+    for (auto* state : m_goal_states) {
+        if (state != NULL) {
+            goal_costs.push_back(state->g);
+        }
+    }
+    std::nth_element(
+            begin(goal_costs), begin(goal_costs) + (k - 1), end(goal_costs));
+    m_goal_bound = goal_costs[k - 1];
+}
+
+// Return whether the search has found a solution within the current bound.
+template <class OpenPolicy>
+bool BasicARAStar<OpenPolicy>::targetReached(
+    SearchState* min_state,
+    SearchState* target_state) const
+{
+    if (m_goal_set_search) {
+        return min_state->f >= m_goal_bound;
+    }
+    return min_state->f >= target_state->f || min_state == target_state;
+}
+
+// Extract the paths to the cheapest goals reached by a goal-set search, and
+// return the path to the cheapest as the solution.
+template <class OpenPolicy>
+void BasicARAStar<OpenPolicy>::extractGoalSolutions(
+    std::vector<int>& solution,
+    int& cost)
+{
+    std::vector<SearchState*> reached;
+    for (auto* state : m_goal_states) {
+        if (state != NULL) {
+            reached.push_back(state);
+        }
+    }
+    std::stable_sort(begin(reached), end(reached),
+            [](const SearchState* a, const SearchState* b)
+            {
+                return a->g < b->g;
+            });
+
+    auto count = m_goal_set_termination == GoalSetTermination::FirstGoal ?
+            1 : std::min((size_t)m_goal_set_count, reached.size());
+    for (size_t i = 0; i < count; ++i) {
+        GoalSolution goal_solution;
+        goal_solution.goal = reached[i]->goal;
+        extractPath(reached[i], goal_solution.path, goal_solution.cost);
+        m_goal_solutions.push_back(std::move(goal_solution));
+    }
+
+    solution.insert(
+            end(solution),
+            begin(m_goal_solutions.front().path),
+            end(m_goal_solutions.front().path));
+    cost = m_goal_solutions.front().cost;
+}
+
+// Recompute the f-values of all states in OPEN from their cached g- and
+// h-values and rebuild OPEN in bulk. The keys of very large OPEN lists are
+// computed in parallel.
+template <class OpenPolicy>
+void BasicARAStar<OpenPolicy>::reorderOpen()
+{
+    const std::size_t ParallelRekeyMinCount = 1 << 16;
+    const std::size_t MaxRekeyThreads = 8;
+
+    auto count = (std::size_t)m_open.size();
+    auto first = m_open.begin();
+    auto rekey = [&](std::size_t begin, std::size_t end)
+    {
+        for (auto i = begin; i < end; ++i) {
+            SearchState* s = *(first + i);
+            s->f = computeKey(s);
+        }
+    };
+
+    auto thread_count = std::min<std::size_t>(
+            std::thread::hardware_concurrency(), MaxRekeyThreads);
+    if (count >= ParallelRekeyMinCount && thread_count > 1) {
+        auto chunk = (count + thread_count - 1) / thread_count;
+        std::vector<std::thread> workers;
+        for (std::size_t t = 1; t < thread_count; ++t) {
+            workers.emplace_back(
+                    rekey,
+                    std::min(count, t * chunk),
+                    std::min(count, (t + 1) * chunk));
+        }
+        rekey(0, std::min(count, chunk));
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    } else {
+        rekey(0, count);
+    }
+
     m_open.make();
 }
 
-int ARAStar::computeKey(SearchState* s) const
+template <class OpenPolicy>
+int BasicARAStar<OpenPolicy>::computeKey(SearchState* s) const
 {
     return s->g + (unsigned int)(m_curr_eps * s->h);
 }
 
+// Discard the search states that cannot improve the path to the target: those
+// whose g-value plus heuristic exceeds the cost of the path, and states left
+// over from previous searches, unless they are ancestors of a kept state so
+// that back pointers remain valid. Pages left empty are kept for reuse by
+// createPage.
+template <class OpenPolicy>
+void BasicARAStar<OpenPolicy>::retireStates(SearchState* target_state)
+{
+    auto bound = target_state->g;
+    if (bound == INFINITECOST) {
+        return;
+    }
+
+    auto capacity = m_state_pages.size() * StatePageSize;
+    m_retire_marks.assign(capacity, 0);
+
+    // mark states outside the bound
+    for (auto* states : m_state_pages) {
+        if (states == NULL) {
+            continue;
+        }
+        for (int i = 0; i < StatePageSize; ++i) {
+            auto* s = &states[i];
+            if (s->state_id < 0 ||
+                s->state_id == m_start_state_id ||
+                s->state_id == m_goal_state_id)
+            {
+                continue;
+            }
+            if (s->call_number != m_call_number) {
+                m_retire_marks[s->state_id] = 1;
+            } else if (s->g != INFINITECOST &&
+                s->h_epoch == (unsigned short)m_h_epoch &&
+                (std::uint64_t)s->g + s->h > bound)
+            {
+                m_retire_marks[s->state_id] = 1;
+            }
+        }
+    }
+
+    // keep the ancestors of kept states
+    for (auto* states : m_state_pages) {
+        if (states == NULL) {
+            continue;
+        }
+        for (int i = 0; i < StatePageSize; ++i) {
+            auto* s = &states[i];
+            if (s->state_id < 0 ||
+                m_retire_marks[s->state_id] ||
+                s->call_number != m_call_number)
+            {
+                continue;
+            }
+            for (auto* p = s->bp; p != NULL && m_retire_marks[p->state_id]; p = p->bp) {
+                m_retire_marks[p->state_id] = 0;
+            }
+        }
+    }
+
+    // remove retired states from OPEN and INCONS
+    std::vector<SearchState*> open;
+    open.reserve(m_open.size());
+    for (auto* s : m_open) {
+        if (!m_retire_marks[s->state_id]) {
+            open.push_back(s);
+        }
+    }
+    if (open.size() != m_open.size()) {
+        m_open.clear();
+        for (auto* s : open) {
+            m_open.append(s);
+        }
+        m_open.make();
+    }
+
+    auto incons_end = std::remove_if(
+            begin(m_incons), end(m_incons),
+            [&](SearchState* s) { return m_retire_marks[s->state_id] != 0; });
+    for (auto it = incons_end; it != end(m_incons); ++it) {
+        (*it)->incons = false;
+    }
+    m_incons.erase(incons_end, end(m_incons));
+
+    // free the slots of retired states, and pages left empty
+    m_retired_ids.clear();
+    for (size_t page = 0; page < m_state_pages.size(); ++page) {
+        auto* states = m_state_pages[page];
+        if (states == NULL) {
+            continue;
+        }
+        auto used = 0;
+        for (int i = 0; i < StatePageSize; ++i) {
+            auto* s = &states[i];
+            if (s->state_id < 0) {
+                continue;
+            }
+            if (m_retire_marks[s->state_id]) {
+                m_retired_ids.push_back(s->state_id);
+                s->state_id = -1;
+            } else {
+                ++used;
+            }
+        }
+        if (used == 0) {
+            m_free_pages.push_back(states);
+            m_state_pages[page] = NULL;
+        }
+    }
+
+    if (m_retired_ids.empty()) {
+        return;
+    }
+
+    m_states_retired = true;
+
+    auto* space = dynamic_cast<Extension*>(m_space);
+    auto* retirement = space != NULL ?
+            space->getExtension<StateRetirementExtension>() : NULL;
+    if (retirement != NULL) {
+        retirement->retireStates(m_retired_ids.data(), m_retired_ids.size());
+    }
+
+    SMPL_DEBUG_NAMED(SLOG, "Retired %zu states outside the bound %u", m_retired_ids.size(), bound);
+}
+
 // Get the search state corresponding to a graph state, creating a new state if
-// one has not been created yet.
-ARAStar::SearchState* ARAStar::getSearchState(int state_id)
+// one has not been created yet. Return null if the state could not be created
+// within the memory limit.
+template <class OpenPolicy>
+typename BasicARAStar<OpenPolicy>::SearchState*
+BasicARAStar<OpenPolicy>::getSearchState(int state_id)
 {
-    if (m_states.size() <= state_id) {
-        m_states.resize(state_id + 1, nullptr);
+    auto page = state_id >> StatePageBits;
+    if (m_state_pages.size() <= page) {
+        m_state_pages.resize(page + 1, nullptr);
     }
 
-    auto& state = m_states[state_id];
-    if (state == NULL) {
-        state = createState(state_id);
+    auto* states = m_state_pages[page];
+    if (states == NULL) {
+        states = createPage(page);
+        if (states == NULL) {
+            return NULL;
+        }
     }
 
+    auto* state = &states[state_id & (StatePageSize - 1)];
+    if (state->state_id < 0) {
+        state->state_id = state_id;
+        state->call_number = 0;
+    }
     return state;
 }
 
-// Create a new search state for a graph state.
-ARAStar::SearchState* ARAStar::createState(int state_id)
+// Create the page of search states for a range of graph states, with every
+// slot marked unused.
+template <class OpenPolicy>
+typename BasicARAStar<OpenPolicy>::SearchState*
+BasicARAStar<OpenPolicy>::createPage(int page)
 {
-    assert(state_id < m_states.size());
+    assert(page < m_state_pages.size());
 
-    SearchState* ss = new SearchState;
-    ss->state_id = state_id;
-    ss->call_number = 0;
+    SearchState* states;
+    if (!m_free_pages.empty()) {
+        states = m_free_pages.back();
+        m_free_pages.pop_back();
+    } else {
+        states = (SearchState*)m_state_arena.tryAllocate(
+                StatePageSize * sizeof(SearchState), alignof(SearchState));
+        if (states == NULL) {
+            return NULL;
+        }
+    }
+    for (int i = 0; i < StatePageSize; ++i) {
+        auto* s = new (&states[i]) SearchState;
+        s->state_id = -1;
+    }
 
-    return ss;
+    m_state_pages[page] = states;
+    return states;
 }
 
 // Lazily (re)initialize a search state.
-void ARAStar::reinitSearchState(SearchState* state)
+template <class OpenPolicy>
+void BasicARAStar<OpenPolicy>::reinitSearchState(SearchState* state)
 {
     if (state->call_number != m_call_number) {
         SMPL_DEBUG_NAMED(SELOG, "Reinitialize state %d", state->state_id);
         state->g = INFINITECOST;
-        state->h = m_heur->GetGoalHeuristic(state->state_id);
+        state->h = computeHeuristic(state->state_id);
+        state->h_epoch = (unsigned short)m_h_epoch;
+        if (m_trace != nullptr) {
+            m_trace->recordHeuristic(state->state_id, 0, state->h);
+        }
         state->f = INFINITECOST;
         state->eg = INFINITECOST;
         state->iteration_closed = 0;
         state->call_number = m_call_number;
         state->bp = nullptr;
+        state->goal = m_goal_set_search ? m_goal_set->goalIndex(state->state_id) : -1;
         state->incons = false;
+    } else {
+        refreshHeuristic(state);
     }
 }
 
-// Extract the path from the start state up to a new state.
-void ARAStar::extractPath(
+// Extract the path from the root of the search tree up to a new state. When
+// searching backward, the tree's back pointers already lead from the start to
+// the goal.
+template <class OpenPolicy>
+void BasicARAStar<OpenPolicy>::extractPath(
     SearchState* to_state,
     std::vector<int>& solution,
     int& cost) const
@@ -624,8 +1193,13 @@ void ARAStar::extractPath(
     for (SearchState* s = to_state; s; s = s->bp) {
         solution.push_back(s->state_id);
     }
-    std::reverse(solution.begin(), solution.end());
+    if (!m_backward_search) {
+        std::reverse(solution.begin(), solution.end());
+    }
     cost = to_state->g;
 }
 
+template class BasicARAStar<DaryHeapOpenList>;
+template class BasicARAStar<BucketHeapOpenList>;
+
 } // namespace smpl
@@ -132,7 +132,7 @@ int AWAStar::replan(
             while (!m_open.empty()) {
                 auto now = smpl::clock::now();
                 auto elapsed = now - start_time;
-                if (elapsed > allowed_time) {
+                if (elapsed > allowed_time || Expired(m_cancel)) {
                     // ugh!
                     if (best_sol != INFINITECOST) {
                         extractPath(goal_state, *solution, *cost);
@@ -362,6 +362,14 @@ int AWAStar::set_search_mode(bool first_solution_unbounded)
 }
 
 /// Notify the search of changes to edge costs in the graph.
+Extension* AWAStar::getExtension(size_t class_code)
+{
+    if (class_code == GetClassCode<CancellationExtension>()) {
+        return this;
+    }
+    return nullptr;
+}
+
 void AWAStar::costs_changed(const StateChangeQuery& changes)
 {
     force_planning_from_scratch();
@@ -0,0 +1,508 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+
+#include <smpl/search/bidirectional_wastar.h>
+
+// standard includes
+#include <assert.h>
+#include <limits>
+#include <thread>
+
+// project includes
+#include <smpl/console/console.h>
+
+namespace smpl {
+
+static const char* SLOG = "search";
+static const char* SELOG = "search.expansions";
+
+BidirectionalWAStar::BidirectionalWAStar(
+    DiscreteSpaceInformation* space,
+    Heuristic* heuristic)
+:
+    SBPLPlanner(),
+    m_space(space),
+    m_heur(heuristic)
+{
+    environment_ = space;
+    m_expanding_f[FORWARD] = INFINITECOST;
+    m_expanding_f[BACKWARD] = INFINITECOST;
+}
+
+BidirectionalWAStar::~BidirectionalWAStar()
+{
+    clearStates();
+}
+
+int BidirectionalWAStar::replan(
+    double allowed_time_secs,
+    std::vector<int>* solution)
+{
+    int cost;
+    return replan(allowed_time_secs, solution, &cost);
+}
+
+int BidirectionalWAStar::replan(
+    double allowed_time_secs,
+    std::vector<int>* solution,
+    int* cost)
+{
+    SMPL_DEBUG_NAMED(SLOG, "Find path to goal");
+
+    if (m_start_state_id < 0) {
+        SMPL_ERROR_NAMED(SLOG, "Start state not set");
+        return 0;
+    }
+    if (m_goal_state_id < 0) {
+        SMPL_ERROR_NAMED(SLOG, "Goal state not set");
+        return 0;
+    }
+
+    auto start_time = clock::now();
+    m_deadline = m_bounded
+            ? start_time + to_duration(allowed_time_secs)
+            : clock::time_point::max();
+
+    clearStates();
+    m_expanding_f[FORWARD] = INFINITECOST;
+    m_expanding_f[BACKWARD] = INFINITECOST;
+    m_best_cost = INFINITECOST;
+    m_meet_state = nullptr;
+    m_terminate = false;
+    m_found = false;
+    m_expand_count[FORWARD] = 0;
+    m_expand_count[BACKWARD] = 0;
+
+    auto* start_state = getSearchState(m_start_state_id);
+    reachState(FORWARD, start_state);
+    start_state->dir[FORWARD].g = 0;
+    start_state->dir[FORWARD].f = start_state->dir[FORWARD].h;
+    m_open[FORWARD].push(&start_state->dir[FORWARD]);
+
+    auto* goal_state = getSearchState(m_goal_state_id);
+    reachState(BACKWARD, goal_state);
+    goal_state->dir[BACKWARD].g = 0;
+    goal_state->dir[BACKWARD].f = goal_state->dir[BACKWARD].h;
+    m_open[BACKWARD].push(&goal_state->dir[BACKWARD]);
+
+    if (start_state == goal_state) {
+        m_best_cost = 0;
+        m_meet_state = start_state;
+    }
+
+    if (m_thread_count > 1) {
+        std::thread worker([this]() { this->work(BACKWARD); });
+        work(FORWARD);
+        worker.join();
+    } else {
+        search();
+    }
+
+    m_search_time = clock::now() - start_time;
+
+    SMPL_DEBUG_NAMED(SLOG, "Search finished after %d forward and %d backward expansions", m_expand_count[FORWARD], m_expand_count[BACKWARD]);
+
+    if (!m_found) {
+        return 0;
+    }
+
+    extractPath(*solution, *cost);
+    return 1;
+}
+
+int BidirectionalWAStar::replan(std::vector<int>* solution, ReplanParams params)
+{
+    int cost;
+    return replan(solution, params, &cost);
+}
+
+int BidirectionalWAStar::replan(
+    std::vector<int>* solution,
+    ReplanParams params,
+    int* cost)
+{
+    set_initialsolution_eps(params.initial_eps);
+    m_bounded = !params.return_first_solution;
+    return replan(params.max_time, solution, cost);
+}
+
+int BidirectionalWAStar::set_goal(int state_id)
+{
+    m_goal_state_id = state_id;
+    return 1;
+}
+
+int BidirectionalWAStar::set_start(int state_id)
+{
+    m_start_state_id = state_id;
+    return 1;
+}
+
+/// Each call to replan() already plans from scratch.
+int BidirectionalWAStar::force_planning_from_scratch()
+{
+    return 0;
+}
+
+int BidirectionalWAStar::force_planning_from_scratch_and_free_memory()
+{
+    clearStates();
+    m_states.shrink_to_fit();
+    return 0;
+}
+
+int BidirectionalWAStar::set_search_mode(bool first_solution_unbounded)
+{
+    m_bounded = !first_solution_unbounded;
+    return 0;
+}
+
+void BidirectionalWAStar::costs_changed(const StateChangeQuery& changes)
+{
+}
+
+double BidirectionalWAStar::get_solution_eps() const
+{
+    return m_found ? m_eps : std::numeric_limits<double>::infinity();
+}
+
+int BidirectionalWAStar::get_n_expands() const
+{
+    return m_expand_count[FORWARD] + m_expand_count[BACKWARD];
+}
+
+double BidirectionalWAStar::get_initial_eps()
+{
+    return m_eps;
+}
+
+double BidirectionalWAStar::get_initial_eps_planning_time()
+{
+    return to_seconds(m_search_time);
+}
+
+double BidirectionalWAStar::get_final_eps_planning_time()
+{
+    return to_seconds(m_search_time);
+}
+
+int BidirectionalWAStar::get_n_expands_init_solution()
+{
+    return get_n_expands();
+}
+
+double BidirectionalWAStar::get_final_epsilon()
+{
+    return m_eps;
+}
+
+void BidirectionalWAStar::get_search_stats(std::vector<PlannerStats>* s)
+{
+    PlannerStats stats;
+    stats.eps = get_solution_eps();
+    stats.expands = get_n_expands();
+    stats.time = to_seconds(m_search_time);
+    s->push_back(stats);
+}
+
+void BidirectionalWAStar::set_initialsolution_eps(double eps)
+{
+    m_eps = std::max(eps, 1.0);
+}
+
+Extension* BidirectionalWAStar::getExtension(size_t class_code)
+{
+    if (class_code == GetClassCode<CancellationExtension>()) {
+        return this;
+    }
+    return nullptr;
+}
+
+// Search on the calling thread, alternating between the directions by
+// expanding from the one with the smaller OPEN list.
+bool BidirectionalWAStar::search()
+{
+    std::vector<int> ids;
+    std::vector<int> costs;
+    while (!updateTermination()) {
+        Direction d;
+        if (m_open[FORWARD].empty()) {
+            d = BACKWARD;
+        } else if (m_open[BACKWARD].empty()) {
+            d = FORWARD;
+        } else {
+            d = m_open[FORWARD].size() <= m_open[BACKWARD].size()
+                    ? FORWARD : BACKWARD;
+        }
+
+        auto* s = popState(d);
+        generateNeighbors(d, s, ids, costs);
+        updateNeighbors(d, s, ids, costs);
+        m_expanding_f[d] = INFINITECOST;
+    }
+    return m_found;
+}
+
+// Search in one direction on the calling thread, concurrently with the search
+// in the other direction, until the search terminates or this direction runs
+// out of states to expand.
+void BidirectionalWAStar::work(Direction d)
+{
+    std::vector<int> ids;
+    std::vector<int> costs;
+
+    std::unique_lock<std::mutex> lock(m_lock);
+    while (!updateTermination()) {
+        if (m_open[d].empty()) {
+            SMPL_DEBUG_NAMED(SLOG, "%s search exhausted", d == FORWARD ? "Forward" : "Backward");
+            break;
+        }
+
+        auto* s = popState(d);
+
+        lock.unlock();
+
+        if (m_concurrent_succs) {
+            generateNeighbors(d, s, ids, costs);
+        } else {
+            std::unique_lock<std::mutex> space_lock(m_space_lock);
+            generateNeighbors(d, s, ids, costs);
+        }
+
+        lock.lock();
+
+        if (!m_terminate) {
+            if (m_concurrent_succs) {
+                updateNeighbors(d, s, ids, costs);
+            } else {
+                // state lookups and heuristic queries access the graph too
+                std::unique_lock<std::mutex> space_lock(m_space_lock);
+                updateNeighbors(d, s, ids, costs);
+            }
+        }
+
+        m_expanding_f[d] = INFINITECOST;
+    }
+}
+
+// Decide whether the search should stop: when it runs out of time, when the
+// best path found is within the bound given by the directions that may still
+// expand states, or when neither direction may.
+bool BidirectionalWAStar::updateTermination()
+{
+    if (m_terminate) {
+        return true;
+    }
+
+    if (timedOut()) {
+        SMPL_DEBUG_NAMED(SLOG, "Ran out of time");
+        m_terminate = true;
+        return true;
+    }
+
+    auto active = false;
+    auto bound = 0u;
+    for (auto d : { FORWARD, BACKWARD }) {
+        if (!m_open[d].empty() || m_expanding_f[d] != INFINITECOST) {
+            active = true;
+            bound = std::max(bound, minFBound(d));
+        }
+    }
+
+    if (!active || m_best_cost <= bound) {
+        m_found = m_best_cost != INFINITECOST;
+        m_terminate = true;
+        return true;
+    }
+
+    return false;
+}
+
+// Return a lower bound on the f-values of the states that may still be
+// expanded in one direction: the minimum f-value in its OPEN list and that of
+// the state it is currently expanding.
+auto BidirectionalWAStar::minFBound(Direction d) const -> unsigned int
+{
+    auto bound = m_open[d].empty() ? (unsigned int)INFINITECOST : m_open[d].min()->f;
+    return std::min(bound, m_expanding_f[d]);
+}
+
+bool BidirectionalWAStar::timedOut() const
+{
+    return clock::now() >= m_deadline || Expired(m_cancel);
+}
+
+auto BidirectionalWAStar::popState(Direction d) -> SearchState*
+{
+    auto* ds = m_open[d].min();
+    m_open[d].pop();
+    ds->closed = true;
+    m_expanding_f[d] = ds->f;
+    ++m_expand_count[d];
+    SMPL_DEBUG_NAMED(SELOG, "Expand state %d %s", ds->state->state_id, d == FORWARD ? "forward" : "backward");
+    return ds->state;
+}
+
+void BidirectionalWAStar::generateNeighbors(
+    Direction d,
+    SearchState* s,
+    std::vector<int>& ids,
+    std::vector<int>& costs)
+{
+    ids.clear();
+    costs.clear();
+    if (d == FORWARD) {
+        m_space->GetSuccs(s->state_id, &ids, &costs);
+    } else {
+        m_space->GetPreds(s->state_id, &ids, &costs);
+    }
+    assert(ids.size() == costs.size());
+}
+
+// Relax the edges between an expanded state and its successors (forward) or
+// predecessors (backward), recording a new best path whenever an improved
+// state has also been reached by the other direction. States already closed
+// in this direction are not reopened.
+void BidirectionalWAStar::updateNeighbors(
+    Direction d,
+    SearchState* s,
+    const std::vector<int>& ids,
+    const std::vector<int>& costs)
+{
+    auto other = d == FORWARD ? BACKWARD : FORWARD;
+    auto& sd = s->dir[d];
+    for (size_t i = 0; i < ids.size(); ++i) {
+        if (costs[i] >= INFINITECOST) {
+            continue;
+        }
+
+        auto* t = getSearchState(ids[i]);
+        reachState(d, t);
+        auto& td = t->dir[d];
+        if (td.closed) {
+            continue;
+        }
+
+        auto new_g = sd.g + (unsigned int)costs[i];
+        if (new_g >= td.g) {
+            continue;
+        }
+
+        td.g = new_g;
+        td.bp = &sd;
+        td.f = (unsigned int)std::min(
+                (double)td.g + m_eps * td.h, (double)INFINITECOST);
+        if (m_open[d].contains(&td)) {
+            m_open[d].decrease(&td);
+        } else {
+            m_open[d].push(&td);
+        }
+
+        auto& to = t->dir[other];
+        if (to.g != INFINITECOST && td.g + to.g < m_best_cost) {
+            m_best_cost = td.g + to.g;
+            m_meet_state = t;
+            SMPL_DEBUG_NAMED(SLOG, "Searches met at state %d with cost %u", t->state_id, m_best_cost);
+        }
+    }
+}
+
+auto BidirectionalWAStar::getSearchState(int state_id) -> SearchState*
+{
+    if (m_states.size() <= state_id) {
+        m_states.resize(state_id + 1, nullptr);
+    }
+
+    auto& state = m_states[state_id];
+    if (state == nullptr) {
+        state = new SearchState;
+        state->state_id = state_id;
+        for (auto& ds : state->dir) {
+            ds.state = state;
+            ds.g = INFINITECOST;
+            ds.h = INFINITECOST;
+            ds.f = INFINITECOST;
+            ds.bp = nullptr;
+            ds.reached = false;
+            ds.closed = false;
+        }
+    }
+
+    return state;
+}
+
+// Compute the heuristic of a state the first time it is reached in a
+// direction.
+void BidirectionalWAStar::reachState(Direction d, SearchState* s)
+{
+    auto& ds = s->dir[d];
+    if (ds.reached) {
+        return;
+    }
+    if (d == FORWARD) {
+        ds.h = m_heur->GetGoalHeuristic(s->state_id);
+    } else {
+        ds.h = m_heur->GetStartHeuristic(s->state_id);
+    }
+    ds.reached = true;
+}
+
+void BidirectionalWAStar::clearStates()
+{
+    m_open[FORWARD].clear();
+    m_open[BACKWARD].clear();
+    for (SearchState* s : m_states) {
+        delete s;
+    }
+    m_states.clear();
+    m_meet_state = nullptr;
+}
+
+// Join the path from the start to the meeting state, following the forward
+// back pointers, with the path from the meeting state to the goal, following
+// the backward back pointers.
+void BidirectionalWAStar::extractPath(
+    std::vector<int>& solution,
+    int& cost) const
+{
+    assert(m_meet_state != nullptr);
+    solution.clear();
+    for (auto* s = &m_meet_state->dir[FORWARD]; s != nullptr; s = s->bp) {
+        solution.push_back(s->state->state_id);
+    }
+    std::reverse(solution.begin(), solution.end());
+    for (auto* s = m_meet_state->dir[BACKWARD].bp; s != nullptr; s = s->bp) {
+        solution.push_back(s->state->state_id);
+    }
+    // the meeting state may have been improved since the searches met there
+    cost = m_meet_state->dir[FORWARD].g + m_meet_state->dir[BACKWARD].g;
+}
+
+} // namespace smpl
@@ -1,6 +1,7 @@
 #include <smpl/search/experience_graph_planner.h>
 
 // standard includes
+#include <algorithm>
 #include <chrono>
 
 // system includes
@@ -67,6 +68,10 @@ int ExperienceGraphPlanner::replan(
 {
     ++m_call_number;
     m_expand_count = 0;
+    m_search_time = 0.0;
+    m_solution_cost = 0;
+    m_egraph_attempts = 0;
+    m_egraph_successes = 0;
 
     SMPL_INFO_NAMED(LOG, "Find path to goal");
 
@@ -100,6 +105,10 @@ int ExperienceGraphPlanner::replan(
             SMPL_INFO_NAMED(LOG, "Ran out of time");
             break;
         }
+        if (Expired(m_cancel)) {
+            SMPL_INFO_NAMED(LOG, "Search cancelled");
+            break;
+        }
 
         SearchState* min_state = m_open.min();
         m_open.pop();
@@ -152,14 +161,24 @@ int ExperienceGraphPlanner::replan(
             }
         }
 
-        if (m_ege) {
+        if (m_ege && m_egh && m_expand_count % m_egraph_succ_period == 0) {
+            // collect the snap and shortcut candidates of this expansion and
+            // check each kind together
             std::vector<int> snap_succs;
             m_egh->getEquivalentStates(min_state->state_id, snap_succs);
 
+            std::vector<int> snap_costs(snap_succs.size());
+            m_egraph_attempts += (int)snap_succs.size();
+            m_egraph_successes += m_ege->snapBatch(
+                    min_state->state_id,
+                    snap_succs.data(),
+                    (int)snap_succs.size(),
+                    snap_costs.data());
+
             for (size_t sidx = 0; sidx < snap_succs.size(); ++sidx) {
                 int snap_id = snap_succs[sidx];
-                int cost;
-                if (!m_ege->snap(min_state->state_id, snap_id, cost)) {
+                int cost = snap_costs[sidx];
+                if (cost < 0) {
                     continue;
                 }
 
@@ -186,10 +205,18 @@ int ExperienceGraphPlanner::replan(
             std::vector<int> shortcut_succs;
             m_egh->getShortcutSuccs(min_state->state_id, shortcut_succs);
 
+            std::vector<int> shortcut_costs(shortcut_succs.size());
+            m_egraph_attempts += (int)shortcut_succs.size();
+            m_egraph_successes += m_ege->shortcutBatch(
+                    min_state->state_id,
+                    shortcut_succs.data(),
+                    (int)shortcut_succs.size(),
+                    shortcut_costs.data());
+
             for (size_t sidx = 0; sidx < shortcut_succs.size(); ++sidx) {
                 int scut_id = shortcut_succs[sidx];
-                int cost;
-                if (!m_ege->shortcut(min_state->state_id, scut_id, cost)) {
+                int cost = shortcut_costs[sidx];
+                if (cost < 0) {
                     continue;
                 }
 
@@ -215,12 +242,24 @@ int ExperienceGraphPlanner::replan(
         }
     }
 
-    if (!path_found) {
-        return false;
+    m_search_time = std::chrono::duration<double>(clock::now() - start_time).count();
+
+    if (path_found) {
+        extractPath(*solution, *cost);
+        m_solution_cost = *cost;
     }
 
-    extractPath(*solution, *cost);
-    return true;
+    if (m_adaptive) {
+        RequestStats stats;
+        stats.solved = path_found;
+        stats.time_fraction = allowed_time > 0.0 ? m_search_time / allowed_time : 1.0;
+        stats.egraph_attempts = m_egraph_attempts;
+        stats.egraph_successes = m_egraph_successes;
+        m_recent.push_back(stats);
+        adapt();
+    }
+
+    return path_found;
 }
 
 int ExperienceGraphPlanner::replan(
@@ -281,6 +320,12 @@ double ExperienceGraphPlanner::get_final_epsilon()
 
 void ExperienceGraphPlanner::get_search_stats(std::vector<PlannerStats>* s)
 {
+    PlannerStats stats;
+    stats.eps = m_eps;
+    stats.cost = m_solution_cost;
+    stats.expands = m_expand_count;
+    stats.time = m_search_time;
+    s->push_back(stats);
 }
 
 void ExperienceGraphPlanner::set_initialsolution_eps(double initialsolution_eps)
@@ -316,6 +361,97 @@ void ExperienceGraphPlanner::costs_changed(const StateChangeQuery& state_change)
 
 }
 
+void ExperienceGraphPlanner::setAdaptive(bool adaptive)
+{
+    if (adaptive && !m_egh) {
+        SMPL_WARN("Adaptive experience graph use requires an ExperienceGraphHeuristicExtension");
+        return;
+    }
+    m_adaptive = adaptive;
+    m_recent.clear();
+}
+
+void ExperienceGraphPlanner::setWeightEGraphBounds(
+    double min_weight,
+    double max_weight)
+{
+    m_min_eg_weight = std::max(1.0, min_weight);
+    m_max_eg_weight = std::max(m_min_eg_weight, max_weight);
+}
+
+void ExperienceGraphPlanner::setAdaptationWindow(int requests)
+{
+    m_adapt_window = std::max(1, requests);
+}
+
+void ExperienceGraphPlanner::setEGraphSuccessorPeriod(int period)
+{
+    m_egraph_succ_period = std::max(1, period);
+}
+
+// Adjust the experience graph weight and the snap/shortcut period once a full
+// window of requests has been recorded, then start a new window so that each
+// outcome drives exactly one adjustment.
+void ExperienceGraphPlanner::adapt()
+{
+    if ((int)m_recent.size() < m_adapt_window) {
+        return;
+    }
+
+    const double weight_step = 1.25;
+    const double slow_time_fraction = 0.5;
+    const double fast_time_fraction = 0.1;
+    const double low_yield = 0.05;
+    const double high_yield = 0.25;
+    const int max_period = 16;
+
+    auto solved = 0;
+    auto time_fraction = 0.0;
+    auto attempts = 0;
+    auto successes = 0;
+    for (auto& r : m_recent) {
+        solved += r.solved ? 1 : 0;
+        time_fraction += r.time_fraction;
+        attempts += r.egraph_attempts;
+        successes += r.egraph_successes;
+    }
+    auto requests = (int)m_recent.size();
+    time_fraction /= (double)requests;
+    m_recent.clear();
+
+    auto weight = m_egh->weightEGraph();
+    auto new_weight = weight;
+    if (solved < requests || time_fraction > slow_time_fraction) {
+        new_weight = std::min(m_max_eg_weight, weight * weight_step);
+    } else if (time_fraction < fast_time_fraction) {
+        new_weight = std::max(m_min_eg_weight, weight / weight_step);
+    }
+    if (new_weight != weight) {
+        m_egh->setWeightEGraph(new_weight);
+    }
+
+    auto period = m_egraph_succ_period;
+    if (attempts > 0) {
+        auto yield = (double)successes / (double)attempts;
+        if (yield < low_yield) {
+            period = std::min(max_period, 2 * period);
+        } else if (yield > high_yield) {
+            period = std::max(1, period / 2);
+        }
+    }
+    m_egraph_succ_period = period;
+
+    SMPL_INFO_NAMED(LOG, "Adapted experience graph use: solved %d/%d, time fraction %0.3f, weight %0.3f -> %0.3f, snap/shortcut period %d", solved, requests, time_fraction, weight, new_weight, period);
+}
+
+Extension* ExperienceGraphPlanner::getExtension(size_t class_code)
+{
+    if (class_code == GetClassCode<CancellationExtension>()) {
+        return this;
+    }
+    return nullptr;
+}
+
 auto ExperienceGraphPlanner::getSearchState(int state_id) -> SearchState*
 {
     if (m_graph_to_search_map.size() <= state_id) {
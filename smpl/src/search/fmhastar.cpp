@@ -33,30 +33,38 @@
 
 namespace smpl {
 
-FMHAstar::FMHAstar(
+template <typename EdgePolicy>
+BasicFMHAstar<EdgePolicy>::BasicFMHAstar(
     DiscreteSpaceInformation* environment,
     Heuristic* hanchor,
     Heuristic** heurs,
     int hcount)
 :
-    MHAStarBase(environment, hanchor, heurs, hcount)
+    MHAStarBase<BasicFMHAstar<EdgePolicy>, EdgePolicy>(
+            environment, hanchor, heurs, hcount)
 {
 }
 
-int FMHAstar::priority(MHASearchState* state)
+template <typename EdgePolicy>
+int BasicFMHAstar<EdgePolicy>::priority(MHASearchState* state)
 {
     return state->g + state->od[0].h;
 }
 
-bool FMHAstar::terminated() const
+template <typename EdgePolicy>
+bool BasicFMHAstar<EdgePolicy>::terminated() const
 {
-    return m_goal_state->g <= m_eps * get_minf(m_open[0]);
+    return this->m_goal_state->g <= this->m_eps * this->get_minf(this->m_open[0]);
 }
 
-bool FMHAstar::satisfies_p_criterion(
+template <typename EdgePolicy>
+bool BasicFMHAstar<EdgePolicy>::satisfies_p_criterion(
         MHASearchState* state) const
 {
-    return state->od[0].f <= m_eps * m_open[0].min()->f;
+    return state->od[0].f <= this->m_eps * this->m_open[0].min()->f;
 }
 
+template class BasicFMHAstar<EagerEdgeEvaluation>;
+template class BasicFMHAstar<LazyEdgeEvaluation>;
+
 } // namespace smpl
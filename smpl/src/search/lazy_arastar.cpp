@@ -1,6 +1,9 @@
 #include <smpl/search/lazy_arastar.h>
 
+#include <algorithm>
+
 #include <smpl/console/console.h>
+#include <smpl/telemetry.h>
 
 namespace smpl {
 
@@ -23,6 +26,7 @@ static auto GetState(LazyARAStar& search, int state_id) -> State*
 
     State* new_state = new State;
     new_state->cands.clear();
+    new_state->lazy_succs.clear();
     new_state->graph_state = state_id;
     new_state->h = g_infinite;
     new_state->g = g_infinite;
@@ -40,11 +44,13 @@ static auto GetState(LazyARAStar& search, int state_id) -> State*
 static void ReinitState(LazyARAStar& search, State* state) {
     if (state->call_number != search.call_number_) {
         state->cands.clear();
+        state->lazy_succs.clear();
 
         if (state == search.goal_state_) {
             state->h = 0;
         } else {
             int32_t goal = search.goal_state_->graph_state;
+            TelemetryTimer timer(TelemetryEvent::HeuristicEvaluation);
             state->h = search.heuristic_->GetGoalHeuristic(state->graph_state);
         }
 
@@ -78,11 +84,15 @@ static void ExpandState(LazyARAStar& search, State* state) {
     search.succs_.clear();
     search.costs_.clear();
     search.true_costs_.clear();
-    search.succ_fun_->GetLazySuccs(
-            state->graph_state,
-            search.succs_,
-            search.costs_,
-            search.true_costs_);
+    {
+        TelemetryTimer timer(TelemetryEvent::Expansion);
+        search.succ_fun_->GetLazySuccs(
+                state->graph_state,
+                search.succs_,
+                search.costs_,
+                search.true_costs_);
+    }
+    TelemetryCount(TelemetryEvent::SuccessorGenerated, search.succs_.size());
 
     assert(search.succs_.size() == search.costs_.size());
     assert(search.succs_.size() == search.true_costs_.size());
@@ -111,6 +121,10 @@ static void ExpandState(LazyARAStar& search, State* state) {
         auto& cands = succ_state->cands;
         cands.push_back(cand);
 
+        if (!true_cost) {
+            state->lazy_succs.push_back(succ_state);
+        }
+
         auto better_cand = [&](const CandidatePred& a, const CandidatePred& b) {
             return a.g < b.g;
         };
@@ -132,6 +146,83 @@ static void ExpandState(LazyARAStar& search, State* state) {
     }
 }
 
+static int ComputeFVal(
+    const LazyARAStar& search,
+    const State& s);
+
+// Replace the unevaluated candidate of s from pred with its true cost, or
+// remove it if the transition is invalid, and update the best candidate of
+// s. Return false if s has no remaining candidates.
+static bool ApplyTrueCost(State* s, const State* pred, int32_t cost)
+{
+    auto& cands = s->cands;
+    auto cand_it = std::find_if(begin(cands), end(cands),
+            [&](const CandidatePred& c) {
+                return c.pred == pred && !c.true_cost;
+            });
+    assert(cand_it != end(cands));
+
+    // remove invalid or now-dominated candidate preds
+    if (cost < 0) {
+        cands.erase(cand_it);
+    } else {
+        cand_it->true_cost = true;
+        cand_it->g = cand_it->pred->g + cost;
+        if (IsPredDominated(*cand_it, s)) {
+            cands.erase(cand_it);
+        }
+    }
+
+    if (cands.empty()) {
+        s->bp = nullptr;
+        s->g = g_infinite;
+        s->true_cost = false;
+        return false;
+    }
+
+    auto better_cand = [&](const CandidatePred& a, const CandidatePred& b) {
+        return a.g < b.g;
+    };
+    auto best_it = std::min_element(begin(cands), end(cands), better_cand);
+    s->bp = best_it->pred;
+    s->g = best_it->g;
+    s->true_cost = best_it->true_cost;
+    return true;
+}
+
+// Gather the states whose best candidate is an unevaluated transition from
+// pred, other than s, that are most promising to be expanded next.
+static void GatherBatch(LazyARAStar& search, State* s, State* pred)
+{
+    search.batch_.clear();
+    search.batch_.push_back(s);
+    if (search.batch_size_ <= 1) {
+        return;
+    }
+
+    for (auto* t : pred->lazy_succs) {
+        if (t != s &&
+            t->call_number == search.call_number_ &&
+            !t->closed &&
+            !t->true_cost &&
+            t->bp == pred &&
+            search.open_.contains(t))
+        {
+            search.batch_.push_back(t);
+        }
+    }
+
+    auto count = std::min(search.batch_.size(), (size_t)search.batch_size_);
+    std::partial_sort(
+            begin(search.batch_) + 1,
+            begin(search.batch_) + count,
+            end(search.batch_),
+            [&](const State* a, const State* b) {
+                return ComputeFVal(search, *a) < ComputeFVal(search, *b);
+            });
+    search.batch_.resize(count);
+}
+
 static void EvaluateState(LazyARAStar& search, State* s) {
     assert(!s->true_cost);
     assert(!s->closed);
@@ -147,34 +238,40 @@ static void EvaluateState(LazyARAStar& search, State* s) {
 
     assert(!best_it->true_cost);
 
-    SMPL_DEBUG_NAMED(LOG, "Evaluate transitions %d -> %d", s->bp->graph_state, s->graph_state);
+    // evaluate the transition along with other pending transitions from the
+    // same predecessor
+    auto* pred = const_cast<State*>(best_it->pred);
+    GatherBatch(search, s, pred);
 
-    int32_t cost = search.succ_fun_->GetSuccTrueCost(
-            s->bp->graph_state, s->graph_state);
-
-    // remove invalid or now-dominated candidate preds
-    if (cost < 0) {
-        cands.erase(best_it);
-    } else {
-        best_it->true_cost = true;
-        best_it->g = best_it->pred->g + cost;
-        if (IsPredDominated(*best_it, s)) {
-            cands.erase(best_it);
-        }
+    search.batch_ids_.clear();
+    for (auto* t : search.batch_) {
+        SMPL_DEBUG_NAMED(LOG, "Evaluate transitions %d -> %d", pred->graph_state, t->graph_state);
+        search.batch_ids_.push_back(t->graph_state);
     }
+    search.batch_costs_.resize(search.batch_ids_.size());
 
-    best_it = std::min_element(begin(cands), end(cands), better_cand);
-    s->bp = best_it->pred;
-    s->g = best_it->g;
-    s->true_cost = best_it->true_cost;
+    search.succ_fun_->GetSuccTrueCosts(
+            pred->graph_state,
+            search.batch_ids_.data(),
+            (int)search.batch_ids_.size(),
+            search.batch_costs_.data());
 
     // OPTIMIZATION if this element is the best, remove all elements except this
     // one from the lazy list. Also, we can probably also remove this element
     // and maintain the s's (bp,g,true) as the current best candidate
 
-    if (best_it != end(cands)) {
+    if (ApplyTrueCost(s, pred, search.batch_costs_[0])) {
         search.open_.push(s);
     }
+
+    for (size_t i = 1; i < search.batch_.size(); ++i) {
+        auto* t = search.batch_[i];
+        if (ApplyTrueCost(t, pred, search.batch_costs_[i])) {
+            search.open_.update(t);
+        } else {
+            search.open_.erase(t);
+        }
+    }
 }
 
 static void ReconstructPath(
@@ -276,11 +373,9 @@ int Replan(
     return 1;
 }
 
-bool LazyARAStar::StateCompare::operator()(
-    const State& s1,
-    const State& s2) const
+int LazyARAStar::StateKey::operator()(const State& s) const
 {
-    return ComputeFVal(*search_, s1) < ComputeFVal(*search_, s2);
+    return ComputeFVal(*search_, s);
 }
 
 } // namespace smpl
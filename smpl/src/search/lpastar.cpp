@@ -0,0 +1,471 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+
+#include <smpl/search/lpastar.h>
+
+// standard includes
+#include <assert.h>
+#include <algorithm>
+#include <limits>
+
+// project includes
+#include <smpl/console/console.h>
+
+namespace smpl {
+
+static const char* SLOG = "search";
+static const char* SELOG = "search.expansions";
+
+LPAStar::LPAStar(DiscreteSpaceInformation* space, Heuristic* heuristic) :
+    SBPLPlanner(),
+    m_space(space),
+    m_heur(heuristic)
+{
+    environment_ = space;
+}
+
+LPAStar::~LPAStar()
+{
+    clearTree();
+}
+
+/// Generate the successors of each of a set of states again, replacing the
+/// edges previously discovered from them. The cost-to-come of every state at
+/// the end of a replaced edge is recomputed and inconsistent states are
+/// returned to OPEN, to be repaired by the next call to replan().
+///
+/// When a state becomes invalid, its predecessors, whose edges into it are no
+/// longer generated, are the states to update.
+void LPAStar::updateEdges(const std::vector<int>& state_ids)
+{
+    if (m_start_state == nullptr) {
+        return; // no search tree to repair
+    }
+
+    std::vector<SearchState*> affected;
+    for (int state_id : state_ids) {
+        if (state_id < 0 || state_id >= (int)m_states.size()) {
+            continue;
+        }
+        auto* s = m_states[state_id];
+        if (s == nullptr || !s->expanded) {
+            continue;
+        }
+
+        for (auto& e : s->succs) {
+            auto& preds = e.state->preds;
+            preds.erase(
+                    std::remove_if(begin(preds), end(preds),
+                            [&](const Edge& p) { return p.state == s; }),
+                    end(preds));
+            affected.push_back(e.state);
+        }
+        s->succs.clear();
+        s->expanded = false;
+
+        generateSuccessors(s);
+        for (auto& e : s->succs) {
+            affected.push_back(e.state);
+        }
+    }
+
+    std::sort(begin(affected), end(affected));
+    affected.erase(std::unique(begin(affected), end(affected)), end(affected));
+
+    for (auto* s : affected) {
+        updateRhs(s);
+        updateOpen(s);
+    }
+
+    SMPL_DEBUG_NAMED(SLOG, "Updated edges of %zu states, affecting %zu states", state_ids.size(), affected.size());
+}
+
+int LPAStar::replan(double allowed_time_secs, std::vector<int>* solution)
+{
+    int cost;
+    return replan(allowed_time_secs, solution, &cost);
+}
+
+int LPAStar::replan(
+    double allowed_time_secs,
+    std::vector<int>* solution,
+    int* cost)
+{
+    SMPL_DEBUG_NAMED(SLOG, "Find path to goal");
+
+    if (m_start_state_id < 0) {
+        SMPL_ERROR_NAMED(SLOG, "Start state not set");
+        return 0;
+    }
+    if (m_goal_state_id < 0) {
+        SMPL_ERROR_NAMED(SLOG, "Goal state not set");
+        return 0;
+    }
+
+    auto start_time = clock::now();
+    auto deadline = m_bounded
+            ? start_time + to_duration(allowed_time_secs)
+            : clock::time_point::max();
+
+    m_expand_count = 0;
+
+    if (m_start_state == nullptr ||
+        m_start_state->state_id != m_start_state_id ||
+        m_goal_state->state_id != m_goal_state_id ||
+        m_tree_eps != m_eps)
+    {
+        SMPL_DEBUG_NAMED(SLOG, "Reinitialize search tree");
+        clearTree();
+        m_tree_eps = m_eps;
+        m_start_state = getSearchState(m_start_state_id);
+        m_goal_state = getSearchState(m_goal_state_id);
+        m_start_state->rhs = 0;
+        updateOpen(m_start_state);
+    }
+
+    m_found = computeShortestPath(deadline);
+    m_search_time = clock::now() - start_time;
+
+    SMPL_DEBUG_NAMED(SLOG, "Search finished after %d expansions", m_expand_count);
+
+    if (!m_found) {
+        return 0;
+    }
+
+    std::vector<int> path;
+    int path_cost;
+    if (!extractPath(path, path_cost)) {
+        SMPL_ERROR_NAMED(SLOG, "Failed to extract path from the search tree");
+        return 0;
+    }
+
+    *solution = std::move(path);
+    *cost = path_cost;
+    return 1;
+}
+
+int LPAStar::replan(std::vector<int>* solution, ReplanParams params)
+{
+    int cost;
+    return replan(solution, params, &cost);
+}
+
+int LPAStar::replan(std::vector<int>* solution, ReplanParams params, int* cost)
+{
+    m_eps = params.initial_eps;
+    m_bounded = !params.return_first_solution;
+    return replan(params.max_time, solution, cost);
+}
+
+int LPAStar::set_goal(int state_id)
+{
+    m_goal_state_id = state_id;
+    return 1;
+}
+
+int LPAStar::set_start(int state_id)
+{
+    m_start_state_id = state_id;
+    return 1;
+}
+
+/// Discard the search tree at the next call to replan().
+int LPAStar::force_planning_from_scratch()
+{
+    m_start_state = nullptr;
+    m_goal_state = nullptr;
+    return 0;
+}
+
+int LPAStar::force_planning_from_scratch_and_free_memory()
+{
+    clearTree();
+    m_states.shrink_to_fit();
+    return 0;
+}
+
+int LPAStar::set_search_mode(bool first_solution_unbounded)
+{
+    m_bounded = !first_solution_unbounded;
+    return 0;
+}
+
+void LPAStar::costs_changed(const StateChangeQuery& changes)
+{
+    auto* preds = changes.getPredecessors();
+    if (preds != NULL) {
+        updateEdges(*preds);
+    }
+}
+
+double LPAStar::get_solution_eps() const
+{
+    return m_found ? m_tree_eps : std::numeric_limits<double>::infinity();
+}
+
+int LPAStar::get_n_expands() const
+{
+    return m_expand_count;
+}
+
+double LPAStar::get_initial_eps()
+{
+    return m_eps;
+}
+
+double LPAStar::get_initial_eps_planning_time()
+{
+    return to_seconds(m_search_time);
+}
+
+double LPAStar::get_final_eps_planning_time()
+{
+    return to_seconds(m_search_time);
+}
+
+int LPAStar::get_n_expands_init_solution()
+{
+    return m_expand_count;
+}
+
+double LPAStar::get_final_epsilon()
+{
+    return m_eps;
+}
+
+void LPAStar::get_search_stats(std::vector<PlannerStats>* s)
+{
+    PlannerStats stats;
+    stats.eps = get_solution_eps();
+    stats.expands = m_expand_count;
+    stats.time = to_seconds(m_search_time);
+    s->push_back(stats);
+}
+
+void LPAStar::set_initialsolution_eps(double eps)
+{
+    m_eps = std::max(eps, 1.0);
+}
+
+Extension* LPAStar::getExtension(size_t class_code)
+{
+    if (class_code == GetClassCode<CancellationExtension>()) {
+        return this;
+    }
+    return nullptr;
+}
+
+// Expand inconsistent states until the goal is consistent and no state in OPEN
+// may lower its cost-to-come. With an inconsistent or inflated heuristic, the
+// states on the path to the goal may still be inconsistent at that point, so
+// expansions continue until the path is consistent as well. Return true if a
+// path to the goal exists.
+bool LPAStar::computeShortestPath(const clock::time_point& deadline)
+{
+    while (!m_open.empty() &&
+        (m_open.min_key() < computeKey(m_goal_state) ||
+            m_goal_state->rhs != m_goal_state->g ||
+            !isPathConsistent()))
+    {
+        if (clock::now() >= deadline || Expired(m_cancel)) {
+            SMPL_DEBUG_NAMED(SLOG, "Ran out of time");
+            return false;
+        }
+
+        auto* s = m_open.min();
+        m_open.pop();
+        ++m_expand_count;
+
+        if (s->g > s->rhs) {
+            SMPL_DEBUG_NAMED(SELOG, "Expand overconsistent state %d", s->state_id);
+            s->g = s->rhs;
+            generateSuccessors(s);
+            for (auto& e : s->succs) {
+                auto* t = e.state;
+                if (t != m_start_state && s->g + e.cost < t->rhs) {
+                    t->rhs = s->g + e.cost;
+                    t->bp = s;
+                    updateOpen(t);
+                }
+            }
+        } else {
+            SMPL_DEBUG_NAMED(SELOG, "Expand underconsistent state %d", s->state_id);
+            s->g = INFINITECOST;
+            updateRhs(s);
+            updateOpen(s);
+            for (auto& e : s->succs) {
+                if (e.state->bp == s) {
+                    updateRhs(e.state);
+                    updateOpen(e.state);
+                }
+            }
+        }
+    }
+
+    return m_goal_state->g != INFINITECOST && isPathConsistent();
+}
+
+// Test whether the back pointers from the goal lead to the start through
+// consistent states only.
+bool LPAStar::isPathConsistent() const
+{
+    size_t length = 0;
+    for (auto* s = m_goal_state; s != m_start_state; s = s->bp) {
+        if (s == nullptr || s->g != s->rhs || ++length > m_states.size()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void LPAStar::generateSuccessors(SearchState* s)
+{
+    if (s->expanded) {
+        return;
+    }
+
+    m_succs.clear();
+    m_costs.clear();
+    m_space->GetSuccs(s->state_id, &m_succs, &m_costs);
+    assert(m_succs.size() == m_costs.size());
+
+    s->expanded = true;
+    s->succs.reserve(m_succs.size());
+    for (size_t sidx = 0; sidx < m_succs.size(); ++sidx) {
+        if (m_costs[sidx] >= INFINITECOST) {
+            continue;
+        }
+        auto* t = getSearchState(m_succs[sidx]);
+        s->succs.push_back(Edge{ t, (unsigned int)m_costs[sidx] });
+        t->preds.push_back(Edge{ s, (unsigned int)m_costs[sidx] });
+    }
+}
+
+// Recompute the one-step lookahead cost-to-come of a state from the edges into
+// it discovered so far.
+void LPAStar::updateRhs(SearchState* s)
+{
+    if (s == m_start_state) {
+        return;
+    }
+
+    s->rhs = INFINITECOST;
+    s->bp = nullptr;
+    for (auto& e : s->preds) {
+        if (e.state->g == INFINITECOST) {
+            continue;
+        }
+        auto rhs = e.state->g + e.cost;
+        if (rhs < s->rhs) {
+            s->rhs = rhs;
+            s->bp = e.state;
+        }
+    }
+}
+
+// Insert an inconsistent state into OPEN, or update its position, and remove a
+// consistent state from OPEN.
+void LPAStar::updateOpen(SearchState* s)
+{
+    if (s->g != s->rhs) {
+        s->key = computeKey(s);
+        if (m_open.contains(s)) {
+            m_open.update(s);
+        } else {
+            m_open.push(s);
+        }
+    } else if (m_open.contains(s)) {
+        m_open.erase(s);
+    }
+}
+
+auto LPAStar::computeKey(const SearchState* s) const
+    -> std::pair<unsigned int, unsigned int>
+{
+    auto k2 = std::min(s->g, s->rhs);
+    if (k2 >= INFINITECOST) {
+        return std::make_pair((unsigned int)INFINITECOST, (unsigned int)INFINITECOST);
+    }
+    auto k1 = std::min((double)k2 + m_tree_eps * s->h, (double)INFINITECOST);
+    return std::make_pair((unsigned int)k1, k2);
+}
+
+auto LPAStar::getSearchState(int state_id) -> SearchState*
+{
+    if (m_states.size() <= state_id) {
+        m_states.resize(state_id + 1, nullptr);
+    }
+
+    auto& state = m_states[state_id];
+    if (state == nullptr) {
+        state = new SearchState;
+        state->state_id = state_id;
+        state->g = INFINITECOST;
+        state->rhs = INFINITECOST;
+        state->h = m_heur->GetGoalHeuristic(state_id);
+        state->key = std::make_pair((unsigned int)INFINITECOST, (unsigned int)INFINITECOST);
+        state->bp = nullptr;
+        state->expanded = false;
+    }
+
+    return state;
+}
+
+void LPAStar::clearTree()
+{
+    m_open.clear();
+    for (SearchState* s : m_states) {
+        delete s;
+    }
+    m_states.clear();
+    m_start_state = nullptr;
+    m_goal_state = nullptr;
+    m_found = false;
+}
+
+// Follow the back pointers from the goal to the start.
+bool LPAStar::extractPath(std::vector<int>& solution, int& cost) const
+{
+    solution.clear();
+    for (auto* s = m_goal_state; s != nullptr; s = s->bp) {
+        solution.push_back(s->state_id);
+        if (solution.size() > m_states.size()) {
+            return false; // back pointers form a cycle
+        }
+    }
+    if (solution.back() != m_start_state->state_id) {
+        return false;
+    }
+    std::reverse(solution.begin(), solution.end());
+    cost = m_goal_state->g;
+    return true;
+}
+
+} // namespace smpl
@@ -70,7 +70,10 @@ MetaMHAstarDTS::MetaMHAstarDTS(
     m_rng(),
     m_uniform(0.0, 1.0),
     m_search_states(),
-    m_open(nullptr)
+    m_state_arena(),
+    m_open(nullptr),
+    m_batch_size(1),
+    m_concurrent_succs(false)
 {
     SMPL_INFO("Construct Focal MHA* Search with %d heuristics", hcount);
     environment_ = environment;
@@ -208,6 +211,10 @@ int MetaMHAstarDTS::replan(
     auto end_time = smpl::clock::now();
     m_elapsed += to_seconds(end_time - start_time);
 
+    if (m_batch_size > 1 && m_hcount > 1) {
+        return batched_search(solution, solcost);
+    }
+
     const int anchor_freq = m_hcount;
     int iter_count = 0;
 
@@ -368,6 +375,31 @@ double MetaMHAstarDTS::get_max_time() const
     return m_params.max_time;
 }
 
+void MetaMHAstarDTS::set_batch_size(int count)
+{
+    m_batch_size = std::max(count, 1);
+    if (m_batch_size > 1) {
+        m_pool.reset(new WorkerPool(m_batch_size));
+    } else {
+        m_pool.reset();
+    }
+}
+
+void MetaMHAstarDTS::set_concurrent_successors(bool allow)
+{
+    m_concurrent_succs = allow;
+}
+
+int MetaMHAstarDTS::get_batch_size() const
+{
+    return m_batch_size;
+}
+
+bool MetaMHAstarDTS::get_concurrent_successors() const
+{
+    return m_concurrent_succs;
+}
+
 bool MetaMHAstarDTS::check_params(const ReplanParams& params)
 {
     if (params.initial_eps < 1.0) {
@@ -420,7 +452,8 @@ MHASearchState* MetaMHAstarDTS::get_state(int state_id)
         const size_t state_size =
                 sizeof(MHASearchState) +
                 sizeof(MHASearchState::HeapData) * (m_hcount);
-        MHASearchState* s = (MHASearchState*)malloc(state_size);
+        MHASearchState* s = (MHASearchState*)m_state_arena.allocate(
+                state_size, alignof(MHASearchState));
 
         // force construction to correctly initialize heap position to null
         new (s) MHASearchState;
@@ -446,17 +479,15 @@ void MetaMHAstarDTS::clear()
 {
     clear_open_lists();
 
-    // free states
-    for (size_t i = 0; i < m_search_states.size(); ++i) {
-        // unmap graph to search state
-        MHASearchState* search_state = m_search_states[i];
+    // unmap graph to search states
+    std::fill(
+            m_graph_to_search_state.begin(),
+            m_graph_to_search_state.end(),
+            -1);
 
-        // free search state
-        free(m_search_states[i]);
-    }
-
-    // empty state table
+    // empty state table and free states
     m_search_states.clear();
+    m_state_arena.reset();
 
     m_start_state = nullptr;
     m_goal_state = nullptr;
@@ -542,12 +573,38 @@ int MetaMHAstarDTS::choose_search()
     return std::distance(r.begin(), std::max_element(r.begin(), r.end())) + 1;
 }
 
+// Choose the count searches whose samples from their posteriors are largest,
+// drawing one sample per search.
+void MetaMHAstarDTS::choose_searches(int count, std::vector<int>& hidxs)
+{
+    std::vector<double> r(m_hcount);
+    for (int hidx = 0; hidx < m_hcount; ++hidx) {
+        boost::math::beta_distribution<double> dist(m_alphas[hidx], m_betas[hidx]);
+        r[hidx] = quantile(dist, m_uniform(m_rng));
+    }
+    SMPL_INFO_STREAM("Choose Searches from: " << r);
+
+    hidxs.resize(m_hcount);
+    for (int hidx = 0; hidx < m_hcount; ++hidx) {
+        hidxs[hidx] = hidx;
+    }
+    count = std::min(count, m_hcount);
+    std::partial_sort(
+            hidxs.begin(), hidxs.begin() + count, hidxs.end(),
+            [&](int a, int b) { return r[a] > r[b]; });
+    hidxs.resize(count);
+    for (int& hidx : hidxs) {
+        ++hidx;
+    }
+}
+
 void MetaMHAstarDTS::update_meta_method(int hidx)
 {
     SMPL_INFO("Update Meta Method:");
     SMPL_INFO_STREAM("  pre-alphas: " << m_alphas);
     SMPL_INFO_STREAM("  pre-betas: " << m_betas);
-    int new_best_hval = m_open[hidx].min()->h;
+    int new_best_hval = m_open[hidx].empty()
+            ? INFINITECOST : m_open[hidx].min()->h;
     if (new_best_hval < m_best_hvals[hidx - 1]) {
         SMPL_INFO("Update[%d] Good! :D", hidx);
         m_best_hvals[hidx - 1] = new_best_hval;
@@ -574,20 +631,33 @@ void MetaMHAstarDTS::expand(MHASearchState* state, int hidx)
 
     assert(!closed_in_add_search(state) || !closed_in_anc_search(state));
 
+    close_state(state);
+
+    std::vector<int> succ_ids;
+    std::vector<int> costs;
+    environment_->GetSuccs(state->state_id, &succ_ids, &costs);
+    assert(succ_ids.size() == costs.size());
+
+    update_successors(state, succ_ids, costs);
+}
+
+// Count the expansion of a state and remove it from OPEN and all P-SETs.
+void MetaMHAstarDTS::close_state(MHASearchState* state)
+{
     ++m_num_expansions;
 
-    // remove s from OPEN and all P-SETs
     for (int hidx = 0; hidx < num_heuristics(); ++hidx) {
         if (m_open[hidx].contains(&state->od[hidx])) {
             m_open[hidx].erase(&state->od[hidx]);
         }
     }
+}
 
-    std::vector<int> succ_ids;
-    std::vector<int> costs;
-    environment_->GetSuccs(state->state_id, &succ_ids, &costs);
-    assert(succ_ids.size() == costs.size());
-
+void MetaMHAstarDTS::update_successors(
+    MHASearchState* state,
+    const std::vector<int>& succ_ids,
+    const std::vector<int>& costs)
+{
     for (size_t sidx = 0; sidx < succ_ids.size(); ++sidx)  {
         const int cost = costs[sidx];
         MHASearchState* succ_state = get_state(succ_ids[sidx]);
@@ -616,6 +686,97 @@ void MetaMHAstarDTS::expand(MHASearchState* state, int hidx)
     }
 }
 
+// Search in rounds. Each round selects a state from each of the searches with
+// the largest samples and, when due, from the anchor search, closing each
+// state as it is selected so that no state is selected twice. The successors
+// of the selected states are generated concurrently, then processed and the
+// searches rewarded in the order the states were selected.
+int MetaMHAstarDTS::batched_search(std::vector<int>* solution, int* solcost)
+{
+    const int anchor_freq = m_hcount;
+    int iter_count = 0;
+
+    std::vector<int> hidxs;
+
+    while (!m_open[0].empty() && !time_limit_reached()) {
+        auto start_time = smpl::clock::now();
+
+        // check termination criteria
+        if (m_goal_state->g <= m_eps * get_minf(m_open[0])) {
+            m_eps_satisfied = m_eps;
+            extract_path(solution, solcost);
+            return 1;
+        }
+
+        m_batch.clear();
+
+        choose_searches(m_batch_size, hidxs);
+        for (int hidx : hidxs) {
+            ++iter_count;
+            if (m_open[hidx].empty()) {
+                continue;
+            }
+            MHASearchState* s = select_state(hidx);
+            if (s == nullptr) {
+                continue;
+            }
+            SMPL_INFO("Expanding state %d in search %d", s->state_id, hidx);
+            close_state(s);
+            s->closed_in_add = true;
+            m_batch.push_back(BatchExpansion{ s, hidx });
+        }
+
+        // expand from the anchor queue
+        for (; iter_count >= anchor_freq; iter_count -= anchor_freq) {
+            if (m_open[0].empty()) {
+                break;
+            }
+            if (m_goal_state->g <= m_eps * get_minf(m_open[0])) {
+                m_eps_satisfied = m_eps;
+                extract_path(solution, solcost);
+                return 1;
+            }
+            MHASearchState* s = state_from_open_state(m_open[0].min());
+            SMPL_INFO("Expanding state %d in search 0", s->state_id);
+            close_state(s);
+            s->closed_in_anc = true;
+            m_batch.push_back(BatchExpansion{ s, 0 });
+        }
+
+        m_pool->run(m_batch.size(), [&](int tid, std::size_t i) {
+            auto& e = m_batch[i];
+            if (m_concurrent_succs) {
+                environment_->GetSuccs(e.state->state_id, &e.succ_ids, &e.costs);
+            } else {
+                std::unique_lock<std::mutex> space_lock(m_space_lock);
+                environment_->GetSuccs(e.state->state_id, &e.succ_ids, &e.costs);
+            }
+            assert(e.succ_ids.size() == e.costs.size());
+        });
+
+        for (auto& e : m_batch) {
+            update_successors(e.state, e.succ_ids, e.costs);
+        }
+        for (auto& e : m_batch) {
+            if (e.hidx != 0) {
+                update_meta_method(e.hidx);
+            }
+        }
+
+        auto end_time = smpl::clock::now();
+        m_elapsed += to_seconds(end_time - start_time);
+    }
+
+    if (m_open[0].empty()) {
+        SMPL_INFO("Anchor search exhausted");
+    }
+    if (time_limit_reached()) {
+        SMPL_INFO("Time limit reached");
+    }
+
+    return 0;
+}
+
 MHASearchState* MetaMHAstarDTS::state_from_open_state(
     MHASearchState::HeapData* open_state)
 {
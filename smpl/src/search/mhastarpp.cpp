@@ -35,43 +35,53 @@
 
 namespace smpl {
 
-MHAStarPP::MHAStarPP(
+template <typename EdgePolicy>
+BasicMHAStarPP<EdgePolicy>::BasicMHAStarPP(
     DiscreteSpaceInformation* environment,
     Heuristic* hanchor,
     Heuristic** heurs,
     int hcount)
 :
-    MHAStarBase(environment, hanchor, heurs, hcount),
+    MHAStarBase<BasicMHAStarPP<EdgePolicy>, EdgePolicy>(
+            environment, hanchor, heurs, hcount),
     m_max_fval_closed_anc(0)
 {
 }
 
-void MHAStarPP::reinitSearch()
+template <typename EdgePolicy>
+void BasicMHAStarPP<EdgePolicy>::reinitSearch()
 {
-    m_max_fval_closed_anc = m_start_state->od[0].f; //0;
+    m_max_fval_closed_anc = this->m_start_state->od[0].f; //0;
 }
 
-void MHAStarPP::on_closed_anchor(MHASearchState* s)
+template <typename EdgePolicy>
+void BasicMHAStarPP<EdgePolicy>::on_closed_anchor(MHASearchState* s)
 {
     if (s->od[0].f > m_max_fval_closed_anc) {
         m_max_fval_closed_anc = s->od[0].f;
     }
 }
 
-int MHAStarPP::priority(MHASearchState* state)
+template <typename EdgePolicy>
+int BasicMHAStarPP<EdgePolicy>::priority(MHASearchState* state)
 {
-    return state->g + (int)(m_eps * state->od[0].h);
+    return state->g + (int)(this->m_eps * state->od[0].h);
 }
 
-bool MHAStarPP::terminated() const
+template <typename EdgePolicy>
+bool BasicMHAStarPP<EdgePolicy>::terminated() const
 {
-    return m_goal_state->g <= m_max_fval_closed_anc;
+    return this->m_goal_state->g <= m_max_fval_closed_anc;
 }
 
-bool MHAStarPP::satisfies_p_criterion(MHASearchState* state) const
+template <typename EdgePolicy>
+bool BasicMHAStarPP<EdgePolicy>::satisfies_p_criterion(MHASearchState* state) const
 {
     return state->g + state->od[0].h <=
-            std::max(m_max_fval_closed_anc, m_open[0].min()->f);
+            std::max(m_max_fval_closed_anc, this->m_open[0].min()->f);
 }
 
+template class BasicMHAStarPP<EagerEdgeEvaluation>;
+template class BasicMHAStarPP<LazyEdgeEvaluation>;
+
 } // namespace smpl
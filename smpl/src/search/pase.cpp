@@ -0,0 +1,489 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+
+#include <smpl/search/pase.h>
+
+// standard includes
+#include <assert.h>
+#include <algorithm>
+#include <thread>
+
+// project includes
+#include <smpl/console/console.h>
+
+namespace smpl {
+
+static const char* SLOG = "search";
+static const char* SELOG = "search.expansions";
+
+PASE::PASE(DiscreteSpaceInformation* space, Heuristic* heuristic) :
+    SBPLPlanner(),
+    m_space(space),
+    m_heur(heuristic)
+{
+    environment_ = space;
+}
+
+PASE::~PASE()
+{
+    for (SearchState* s : m_states) {
+        delete s;
+    }
+}
+
+int PASE::replan(double allowed_time_secs, std::vector<int>* solution)
+{
+    int cost;
+    return replan(allowed_time_secs, solution, &cost);
+}
+
+int PASE::replan(
+    double allowed_time_secs,
+    std::vector<int>* solution,
+    int* cost)
+{
+    SMPL_DEBUG_NAMED(SLOG, "Find path to goal");
+
+    if (m_start_state_id < 0) {
+        SMPL_ERROR_NAMED(SLOG, "Start state not set");
+        return 0;
+    }
+    if (m_goal_state_id < 0) {
+        SMPL_ERROR_NAMED(SLOG, "Goal state not set");
+        return 0;
+    }
+
+    auto start_time = clock::now();
+    auto deadline = start_time + to_duration(allowed_time_secs);
+
+    m_expand_count_init = 0;
+    m_search_time_init = clock::duration::zero();
+    m_expand_count = 0;
+    m_search_time = clock::duration::zero();
+    m_satisfied_eps = std::numeric_limits<double>::infinity();
+
+    std::vector<int> best_path;
+    int best_cost = INFINITECOST;
+
+    auto eps = m_initial_eps;
+    while (true) {
+        // the first search is only bounded by time in bounded mode
+        auto first = m_satisfied_eps == std::numeric_limits<double>::infinity();
+        auto bounded = m_bounded || !first;
+
+        auto found = search(eps, bounded ? deadline : clock::time_point::max());
+
+        if (first) {
+            m_expand_count_init = m_expand_count;
+            m_search_time_init = clock::now() - start_time;
+        }
+
+        if (!found) {
+            break;
+        }
+
+        SMPL_DEBUG_NAMED(SLOG, "Found solution with epsilon = %0.3f", eps);
+        best_path.clear();
+        extractPath(m_goal_state, best_path, best_cost);
+        m_satisfied_eps = eps;
+
+        if (!m_improve || eps <= m_final_eps) {
+            break;
+        }
+
+        eps = std::max(eps - m_delta_eps, m_final_eps);
+    }
+
+    m_search_time = clock::now() - start_time;
+
+    if (m_satisfied_eps == std::numeric_limits<double>::infinity()) {
+        return 0;
+    }
+
+    *solution = std::move(best_path);
+    *cost = best_cost;
+    return 1;
+}
+
+int PASE::replan(std::vector<int>* solution, ReplanParams params)
+{
+    int cost;
+    return replan(solution, params, &cost);
+}
+
+int PASE::replan(std::vector<int>* solution, ReplanParams params, int* cost)
+{
+    m_initial_eps = params.initial_eps;
+    m_final_eps = params.final_eps;
+    m_delta_eps = params.dec_eps;
+    m_bounded = !params.return_first_solution;
+    m_improve = !params.return_first_solution;
+    return replan(params.max_time, solution, cost);
+}
+
+int PASE::set_goal(int state_id)
+{
+    m_goal_state_id = state_id;
+    return 1;
+}
+
+int PASE::set_start(int state_id)
+{
+    m_start_state_id = state_id;
+    return 1;
+}
+
+/// Every call to replan() searches from scratch, so there is no search effort
+/// to discard.
+int PASE::force_planning_from_scratch()
+{
+    return 0;
+}
+
+int PASE::force_planning_from_scratch_and_free_memory()
+{
+    for (SearchState* s : m_states) {
+        delete s;
+    }
+    m_states.clear();
+    m_states.shrink_to_fit();
+    m_open.clear();
+    m_being_expanded.clear();
+    m_goal_state = nullptr;
+    return 0;
+}
+
+int PASE::set_search_mode(bool first_solution_unbounded)
+{
+    m_bounded = !first_solution_unbounded;
+    return 0;
+}
+
+void PASE::costs_changed(const StateChangeQuery& changes)
+{
+}
+
+double PASE::get_solution_eps() const
+{
+    return m_satisfied_eps;
+}
+
+int PASE::get_n_expands() const
+{
+    return m_expand_count;
+}
+
+double PASE::get_initial_eps()
+{
+    return m_initial_eps;
+}
+
+double PASE::get_initial_eps_planning_time()
+{
+    return to_seconds(m_search_time_init);
+}
+
+double PASE::get_final_eps_planning_time()
+{
+    return to_seconds(m_search_time);
+}
+
+int PASE::get_n_expands_init_solution()
+{
+    return m_expand_count_init;
+}
+
+double PASE::get_final_epsilon()
+{
+    return m_final_eps;
+}
+
+void PASE::get_search_stats(std::vector<PlannerStats>* s)
+{
+    PlannerStats stats;
+    stats.eps = m_satisfied_eps;
+    stats.expands = m_expand_count;
+    stats.time = to_seconds(m_search_time);
+    s->push_back(stats);
+}
+
+void PASE::set_initialsolution_eps(double eps)
+{
+    m_initial_eps = eps;
+}
+
+// Run a single weighted A* search with the given epsilon, from scratch, using
+// all worker threads. Return true if a path to the goal was found.
+Extension* PASE::getExtension(size_t class_code)
+{
+    if (class_code == GetClassCode<CancellationExtension>()) {
+        return this;
+    }
+    return nullptr;
+}
+
+bool PASE::search(double eps, const clock::time_point& deadline)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_open.clear();
+        m_being_expanded.clear();
+        ++m_call_number; // trigger state reinitializations
+
+        m_curr_eps = eps;
+        m_deadline = deadline;
+        m_terminate = false;
+        m_found_goal = false;
+
+        auto* start_state = getSearchState(m_start_state_id);
+        m_goal_state = getSearchState(m_goal_state_id);
+        reinitSearchState(start_state);
+        reinitSearchState(m_goal_state);
+
+        start_state->g = 0;
+        start_state->f = computeKey(start_state);
+        insertOpen(start_state);
+    }
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < m_thread_count; ++i) {
+        workers.emplace_back([this]() { this->work(); });
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    return m_found_goal;
+}
+
+// Repeatedly select an independent state from OPEN and expand it until the
+// goal is selected, the search runs out of time, or OPEN is exhausted.
+void PASE::work()
+{
+    std::vector<int> succs;
+    std::vector<int> costs;
+
+    std::unique_lock<std::mutex> lock(m_lock);
+    while (!m_terminate) {
+        if (m_open.empty() && m_being_expanded.empty()) {
+            SMPL_DEBUG_NAMED(SLOG, "Exhausted open list");
+            m_terminate = true;
+            break;
+        }
+
+        if (clock::now() >= m_deadline || Expired(m_cancel)) {
+            SMPL_DEBUG_NAMED(SLOG, "Ran out of time");
+            m_terminate = true;
+            break;
+        }
+
+        auto* s = selectState();
+        if (s == nullptr) {
+            // wait for an expansion to finish and free up more states
+            if (m_deadline == clock::time_point::max()) {
+                m_cond.wait(lock);
+            } else {
+                m_cond.wait_until(lock, m_deadline);
+            }
+            continue;
+        }
+
+        if (s == m_goal_state) {
+            SMPL_DEBUG_NAMED(SLOG, "Found path to goal");
+            m_found_goal = true;
+            m_terminate = true;
+            break;
+        }
+
+        SMPL_DEBUG_NAMED(SELOG, "Expand state %d", s->state_id);
+
+        eraseOpen(s);
+        s->closed = true;
+        s->eg = s->g;
+        m_being_expanded.push_back(s);
+        ++m_expand_count;
+
+        lock.unlock();
+
+        succs.clear();
+        costs.clear();
+        if (m_concurrent_succs) {
+            m_space->GetSuccs(s->state_id, &succs, &costs);
+        } else {
+            std::unique_lock<std::mutex> space_lock(m_space_lock);
+            m_space->GetSuccs(s->state_id, &succs, &costs);
+        }
+
+        lock.lock();
+
+        updateSuccessors(s, succs, costs);
+
+        auto it = std::find(
+                m_being_expanded.begin(), m_being_expanded.end(), s);
+        assert(it != m_being_expanded.end());
+        *it = m_being_expanded.back();
+        m_being_expanded.pop_back();
+
+        m_cond.notify_all();
+    }
+
+    // wake waiting workers so they observe termination
+    m_cond.notify_all();
+}
+
+// Return the state with the smallest f-value in OPEN that may be expanded
+// concurrently with the states currently being expanded, or nullptr if no such
+// state exists.
+auto PASE::selectState() -> SearchState*
+{
+    for (auto it = m_open.begin(); it != m_open.end(); ++it) {
+        if (isIndependent(*it, it)) {
+            return *it;
+        }
+    }
+    return nullptr;
+}
+
+// Test whether the cost-to-come of a state in OPEN, at position pos, may be
+// lowered by any state ahead of it in OPEN or any state being expanded.
+bool PASE::isIndependent(SearchState* s, OpenList::iterator pos)
+{
+    auto h = [&](SearchState* from) -> double {
+        if (s == m_goal_state) {
+            return (double)from->h;
+        }
+        return (double)m_heur->GetFromToHeuristic(from->state_id, s->state_id);
+    };
+
+    for (SearchState* b : m_being_expanded) {
+        if ((double)s->g > (double)b->eg + m_indep_eps * h(b)) {
+            return false;
+        }
+    }
+
+    for (auto it = m_open.begin(); it != pos; ++it) {
+        SearchState* o = *it;
+        if ((double)s->g > (double)o->g + m_indep_eps * h(o)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Update the cost-to-come of the successors of an expanded state. Improved
+// states that have already been expanded are not reopened.
+void PASE::updateSuccessors(
+    SearchState* s,
+    const std::vector<int>& succs,
+    const std::vector<int>& costs)
+{
+    SMPL_DEBUG_NAMED(SELOG, "  %zu successors", succs.size());
+
+    for (size_t sidx = 0; sidx < succs.size(); ++sidx) {
+        SearchState* succ_state = getSearchState(succs[sidx]);
+        reinitSearchState(succ_state);
+
+        unsigned int new_cost = s->eg + costs[sidx];
+        if (new_cost < succ_state->g) {
+            succ_state->g = new_cost;
+            succ_state->bp = s;
+            if (!succ_state->closed) {
+                if (succ_state->open) {
+                    eraseOpen(succ_state);
+                }
+                succ_state->f = computeKey(succ_state);
+                insertOpen(succ_state);
+            }
+        }
+    }
+}
+
+void PASE::insertOpen(SearchState* s)
+{
+    m_open.insert(s);
+    s->open = true;
+}
+
+void PASE::eraseOpen(SearchState* s)
+{
+    m_open.erase(s);
+    s->open = false;
+}
+
+unsigned int PASE::computeKey(SearchState* s) const
+{
+    return s->g + (unsigned int)(m_curr_eps * s->h);
+}
+
+auto PASE::getSearchState(int state_id) -> SearchState*
+{
+    if (m_states.size() <= state_id) {
+        m_states.resize(state_id + 1, nullptr);
+    }
+
+    auto& state = m_states[state_id];
+    if (state == nullptr) {
+        state = new SearchState;
+        state->state_id = state_id;
+        state->call_number = 0;
+    }
+
+    return state;
+}
+
+void PASE::reinitSearchState(SearchState* state)
+{
+    if (state->call_number != m_call_number) {
+        state->g = INFINITECOST;
+        state->h = m_heur->GetGoalHeuristic(state->state_id);
+        state->f = INFINITECOST;
+        state->eg = INFINITECOST;
+        state->call_number = m_call_number;
+        state->open = false;
+        state->closed = false;
+        state->bp = nullptr;
+    }
+}
+
+void PASE::extractPath(
+    SearchState* to_state,
+    std::vector<int>& solution,
+    int& cost) const
+{
+    for (SearchState* s = to_state; s; s = s->bp) {
+        solution.push_back(s->state_id);
+    }
+    std::reverse(solution.begin(), solution.end());
+    cost = to_state->g;
+}
+
+} // namespace smpl
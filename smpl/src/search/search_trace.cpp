@@ -0,0 +1,277 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+#include <smpl/search/search_trace.h>
+
+// standard includes
+#include <cstring>
+
+// project includes
+#include <smpl/console/console.h>
+
+namespace smpl {
+
+static const char* LOG = "search.trace";
+
+static const char SearchTraceMagic[8] = { 'S', 'M', 'P', 'L', 'S', 'T', 'R', '1' };
+
+// flush the write buffer once it grows past this size
+static const std::size_t FlushThreshold = 1 << 16;
+
+SearchTraceRecorder::~SearchTraceRecorder()
+{
+    close();
+}
+
+bool SearchTraceRecorder::open(const std::string& path)
+{
+    close();
+    m_file = std::fopen(path.c_str(), "wb");
+    if (m_file == nullptr) {
+        SMPL_ERROR_NAMED(LOG, "Failed to open search trace '%s' for writing", path.c_str());
+        return false;
+    }
+    m_buffer.insert(m_buffer.end(), SearchTraceMagic, SearchTraceMagic + sizeof(SearchTraceMagic));
+    return true;
+}
+
+void SearchTraceRecorder::close()
+{
+    if (m_file != nullptr) {
+        flush();
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+    m_buffer.clear();
+}
+
+void SearchTraceRecorder::recordSearch(int start_id, int goal_id, double eps)
+{
+    if (!isOpen()) {
+        return;
+    }
+    write('S');
+    write((std::int32_t)start_id);
+    write((std::int32_t)goal_id);
+    write(eps);
+}
+
+void SearchTraceRecorder::recordHeuristic(int state_id, int hidx, int h)
+{
+    if (!isOpen()) {
+        return;
+    }
+    write('H');
+    write((std::int32_t)state_id);
+    write((std::uint8_t)hidx);
+    write((std::int32_t)h);
+}
+
+void SearchTraceRecorder::recordExpansion(
+    int state_id,
+    unsigned int g,
+    unsigned int h,
+    double graph_time,
+    const std::vector<int>& succs,
+    const std::vector<int>& costs)
+{
+    if (!isOpen()) {
+        return;
+    }
+    write('E');
+    write((std::int32_t)state_id);
+    write((std::uint32_t)g);
+    write((std::uint32_t)h);
+    write((float)graph_time);
+    write((std::uint32_t)succs.size());
+    for (int succ : succs) {
+        write((std::int32_t)succ);
+    }
+    for (int cost : costs) {
+        write((std::int32_t)cost);
+    }
+    if (m_buffer.size() > FlushThreshold) {
+        flush();
+    }
+}
+
+template <class T>
+void SearchTraceRecorder::write(const T& value)
+{
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    m_buffer.insert(m_buffer.end(), bytes, bytes + sizeof(T));
+}
+
+void SearchTraceRecorder::flush()
+{
+    if (!m_buffer.empty()) {
+        std::fwrite(m_buffer.data(), 1, m_buffer.size(), m_file);
+        m_buffer.clear();
+    }
+}
+
+double SearchTrace::graphTime() const
+{
+    double time = 0.0;
+    for (auto& e : expansions) {
+        time += e.graph_time;
+    }
+    return time;
+}
+
+template <class T>
+static bool Read(std::FILE* f, T& value)
+{
+    return std::fread(&value, sizeof(T), 1, f) == 1;
+}
+
+bool ReadSearchTrace(const std::string& path, SearchTrace& trace)
+{
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (f == nullptr) {
+        SMPL_ERROR_NAMED(LOG, "Failed to open search trace '%s'", path.c_str());
+        return false;
+    }
+
+    char magic[sizeof(SearchTraceMagic)];
+    if (std::fread(magic, sizeof(magic), 1, f) != 1 ||
+        std::memcmp(magic, SearchTraceMagic, sizeof(magic)) != 0)
+    {
+        SMPL_ERROR_NAMED(LOG, "'%s' is not a search trace", path.c_str());
+        std::fclose(f);
+        return false;
+    }
+
+    bool ok = true;
+    char tag;
+    while (ok && Read(f, tag)) {
+        switch (tag) {
+        case 'S': {
+            std::int32_t start_id, goal_id;
+            ok = Read(f, start_id) && Read(f, goal_id) && Read(f, trace.eps);
+            trace.start_id = start_id;
+            trace.goal_id = goal_id;
+            break;
+        }
+        case 'H': {
+            std::int32_t state_id, h;
+            std::uint8_t hidx;
+            ok = Read(f, state_id) && Read(f, hidx) && Read(f, h);
+            if (ok) {
+                if (hidx >= trace.heuristics.size()) {
+                    trace.heuristics.resize(hidx + 1);
+                }
+                trace.heuristics[hidx][state_id] = h;
+            }
+            break;
+        }
+        case 'E': {
+            std::int32_t state_id;
+            std::uint32_t g, h, count;
+            float graph_time;
+            ok = Read(f, state_id) && Read(f, g) && Read(f, h) &&
+                    Read(f, graph_time) && Read(f, count);
+            if (!ok) break;
+
+            SearchTrace::Expansion e;
+            e.state_id = state_id;
+            e.g = g;
+            e.h = h;
+            e.graph_time = graph_time;
+            e.first_succ = (std::uint32_t)trace.succs.size();
+            e.succ_count = count;
+
+            trace.succs.resize(trace.succs.size() + count);
+            trace.costs.resize(trace.costs.size() + count);
+            if (count > 0) {
+                ok = std::fread(&trace.succs[e.first_succ], sizeof(int), count, f) == count &&
+                        std::fread(&trace.costs[e.first_succ], sizeof(int), count, f) == count;
+            }
+
+            trace.expansion_of.insert(std::make_pair(state_id, trace.expansions.size()));
+            trace.expansions.push_back(e);
+            break;
+        }
+        default:
+            ok = false;
+            break;
+        }
+    }
+
+    std::fclose(f);
+    if (!ok) {
+        SMPL_ERROR_NAMED(LOG, "Search trace '%s' is malformed", path.c_str());
+    }
+    return ok;
+}
+
+void SearchTraceSpace::GetSuccs(
+    int state_id,
+    std::vector<int>* succs,
+    std::vector<int>* costs)
+{
+    auto it = m_trace->expansion_of.find(state_id);
+    if (it == m_trace->expansion_of.end()) {
+        ++m_missing;
+        return;
+    }
+
+    auto& e = m_trace->expansions[it->second];
+    succs->insert(
+            succs->end(),
+            m_trace->succs.begin() + e.first_succ,
+            m_trace->succs.begin() + e.first_succ + e.succ_count);
+    costs->insert(
+            costs->end(),
+            m_trace->costs.begin() + e.first_succ,
+            m_trace->costs.begin() + e.first_succ + e.succ_count);
+}
+
+void SearchTraceSpace::GetPreds(
+    int state_id,
+    std::vector<int>* preds,
+    std::vector<int>* costs)
+{
+    SMPL_WARN_ONCE_NAMED(LOG, "SearchTraceSpace does not support GetPreds");
+}
+
+int SearchTraceHeuristic::GetGoalHeuristic(int state_id)
+{
+    if (m_hidx < (int)m_trace->heuristics.size()) {
+        auto& values = m_trace->heuristics[m_hidx];
+        auto it = values.find(state_id);
+        if (it != values.end()) {
+            return it->second;
+        }
+    }
+    ++m_missing;
+    return 0;
+}
+
+} // namespace smpl
@@ -35,6 +35,7 @@
 #include <stdlib.h>
 #include <time.h>
 #include <algorithm>
+#include <thread>
 
 #include <sbpl/discrete_space_information/environment.h>
 #include <sbpl/utils/key.h>
@@ -182,6 +183,10 @@ int SMHAStar::replan(std::vector<int>* solution, ReplanParams params, int* solco
     double end_time = GetTime();
     m_elapsed += (end_time - start_time);
 
+    if (m_thread_count > 1 && m_heur_count > 1) {
+        return parallel_search(solution, solcost);
+    }
+
     while (!m_open[0].empty() && !time_limit_reached()) {
         start_time = GetTime();
 
@@ -360,6 +365,26 @@ double SMHAStar::get_max_time() const
     return m_params.max_time;
 }
 
+void SMHAStar::set_thread_count(int count)
+{
+    m_thread_count = std::max(count, 1);
+}
+
+void SMHAStar::set_concurrent_successors(bool allow)
+{
+    m_concurrent_succs = allow;
+}
+
+int SMHAStar::get_thread_count() const
+{
+    return m_thread_count;
+}
+
+bool SMHAStar::get_concurrent_successors() const
+{
+    return m_concurrent_succs;
+}
+
 bool SMHAStar::check_params(const ReplanParams& params)
 {
     if (params.initial_eps < 1.0) {
@@ -415,7 +440,8 @@ SMHAState* SMHAStar::get_state(int state_id)
         size_t state_size =
                 sizeof(SMHAState) +
                 sizeof(SMHAState::HeapData) * (m_heur_count);
-        SMHAState* s = (SMHAState*)malloc(state_size);
+        SMHAState* s = (SMHAState*)m_state_arena.allocate(
+                state_size, alignof(SMHAState));
 
         new (s) SMHAState;
         for (int i = 0; i < m_heur_count; ++i) {
@@ -440,19 +466,16 @@ void SMHAStar::clear()
 {
     clear_open_lists();
 
-    // free states
+    // unmap graph to search states
     for (size_t i = 0; i < m_search_states.size(); ++i) {
-        // unmap graph to search state
         int state_id = m_search_states[i]->state_id;
         int* idxs = environment_->StateID2IndexMapping[state_id];
         idxs[MHAMDP_STATEID2IND] = -1;
-
-        // free search state
-        free(m_search_states[i]);
     }
 
-    // empty state table
+    // empty state table and free states
     m_search_states.clear();
+    m_state_arena.reset();
 
     m_start_state = NULL;
     m_goal_state = NULL;
@@ -464,6 +487,7 @@ void SMHAStar::init_state(SMHAState* state, size_t mha_state_idx, int state_id)
     state->state_id = state_id;
     state->closed_in_anc = false;
     state->closed_in_add = false;
+    state->expanding = false;
     for (int i = 0; i < num_heuristics(); ++i) {
         state->od[i].me = state;
         state->od[i].h = compute_heuristic(state->state_id, i);
@@ -479,6 +503,7 @@ void SMHAStar::reinit_state(SMHAState* state)
 
         state->closed_in_anc = false;
         state->closed_in_add = false;
+        state->expanding = false;
 
         for (int i = 0; i < num_heuristics(); ++i) {
             state->od[i].h = compute_heuristic(state->state_id, i);
@@ -508,6 +533,22 @@ void SMHAStar::expand(SMHAState* state, int hidx)
 {
     SMPL_DEBUG_NAMED(LOG, "Expanding state %d in search %d", state->state_id, hidx);
 
+    close_state(state, hidx);
+
+    std::vector<int> succ_ids;
+    std::vector<int> costs;
+    environment_->GetSuccs(state->state_id, &succ_ids, &costs);
+    assert(succ_ids.size() == costs.size());
+
+    update_successors(state, succ_ids, costs);
+
+    assert(closed_in_any_search(state));
+}
+
+// Close a state in the search it is selected from and remove it from all open
+// lists.
+void SMHAStar::close_state(SMHAState* state, int hidx)
+{
     assert(!closed_in_add_search(state) || !closed_in_anc_search(state));
 
     if (hidx == 0) {
@@ -523,14 +564,14 @@ void SMHAStar::expand(SMHAState* state, int hidx)
             m_open[i].erase(&state->od[i]);
         }
     }
+}
 
-    std::vector<int> succ_ids;
-    std::vector<int> costs;
-    environment_->GetSuccs(state->state_id, &succ_ids, &costs);
-    assert(succ_ids.size() == costs.size());
-
+void SMHAStar::update_successors(
+    SMHAState* state,
+    const std::vector<int>& succ_ids,
+    const std::vector<int>& costs)
+{
     for (size_t sidx = 0; sidx < succ_ids.size(); ++sidx)  {
-        int cost = costs[sidx];
         SMHAState* succ_state = get_state(succ_ids[sidx]);
         reinit_state(succ_state);
 
@@ -540,6 +581,13 @@ void SMHAStar::expand(SMHAState* state, int hidx)
         if (new_g < succ_state->g) {
             succ_state->g = new_g;
             succ_state->bp = state;
+
+            // a state being expanded relaxes its successors with its g-value
+            // at the end of its expansion, so it need not be reopened
+            if (succ_state->expanding) {
+                continue;
+            }
+
             if (!closed_in_anc_search(succ_state)) {
                 int fanchor = compute_key(succ_state, 0);
                 succ_state->od[0].f = fanchor;
@@ -561,8 +609,166 @@ void SMHAStar::expand(SMHAState* state, int hidx)
             }
         }
     }
+}
+
+int SMHAStar::parallel_search(std::vector<int>* solution, int* solcost)
+{
+    int thread_count = std::min(m_thread_count, m_heur_count);
+    SMPL_DEBUG_NAMED(LOG, "Search with %d threads", thread_count);
+
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_being_expanded.clear();
+        m_search_start = GetTime() - m_elapsed;
+        m_terminate = false;
+        m_found_goal = false;
+    }
 
-    assert(closed_in_any_search(state));
+    std::vector<std::thread> workers;
+    for (int i = 1; i < thread_count; ++i) {
+        workers.emplace_back([this, i, thread_count]() {
+            this->work(i, thread_count);
+        });
+    }
+    work(0, thread_count);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    m_elapsed = GetTime() - m_search_start;
+
+    if (m_found_goal) {
+        m_eps_satisfied = m_eps * m_eps_mha;
+        extract_path(solution, solcost);
+        return 1;
+    }
+
+    if (m_open[0].empty()) {
+        SMPL_DEBUG_NAMED(LOG, "Anchor search exhausted");
+    }
+    if (time_limit_reached()) {
+        SMPL_DEBUG_NAMED(LOG, "Time limit reached");
+    }
+    return 0;
+}
+
+// Serve the inadmissible searches assigned to a worker thread, round robin,
+// falling back to the anchor search as the sequential search does, until a
+// solution within the suboptimality bound is found, the search runs out of
+// time, or the anchor search is exhausted.
+void SMHAStar::work(int tid, int thread_count)
+{
+    std::vector<int> succ_ids;
+    std::vector<int> costs;
+
+    int next = tid + 1;
+
+    std::unique_lock<std::mutex> lock(m_lock);
+    while (!m_terminate) {
+        m_elapsed = GetTime() - m_search_start;
+
+        if (m_open[0].empty() && m_being_expanded.empty()) {
+            m_terminate = true;
+            break;
+        }
+
+        if (time_limit_reached()) {
+            m_terminate = true;
+            break;
+        }
+
+        int hidx = next;
+        next += thread_count;
+        if (next >= num_heuristics()) {
+            next = tid + 1;
+        }
+
+        int anchor_bound = get_minf_bound(0);
+
+        SMHAState* s = NULL;
+        int sidx = 0;
+        if (!m_open[hidx].empty() &&
+            get_minf(m_open[hidx]) <= m_eps_mha * anchor_bound)
+        {
+            if (m_goal_state->g <= get_minf_bound(hidx)) {
+                m_found_goal = true;
+                m_terminate = true;
+                break;
+            }
+            s = state_from_open_state(m_open[hidx].min());
+            sidx = hidx;
+        } else {
+            if (m_goal_state->g <= anchor_bound) {
+                m_found_goal = true;
+                m_terminate = true;
+                break;
+            }
+            if (m_open[0].empty()) {
+                // wait for an expansion to finish and refill the anchor
+                if (m_params.max_time > 0.0 && !m_params.return_first_solution) {
+                    m_cond.wait_for(lock, to_duration(m_params.max_time - m_elapsed));
+                } else {
+                    m_cond.wait(lock);
+                }
+                continue;
+            }
+            s = state_from_open_state(m_open[0].min());
+            sidx = 0;
+        }
+
+        SMPL_DEBUG_NAMED(LOG, "Expanding state %d in search %d", s->state_id, sidx);
+
+        close_state(s, sidx);
+        s->expanding = true;
+        m_being_expanded.push_back(s);
+
+        lock.unlock();
+
+        succ_ids.clear();
+        costs.clear();
+        if (m_concurrent_succs) {
+            environment_->GetSuccs(s->state_id, &succ_ids, &costs);
+        } else {
+            std::unique_lock<std::mutex> space_lock(m_space_lock);
+            environment_->GetSuccs(s->state_id, &succ_ids, &costs);
+        }
+        assert(succ_ids.size() == costs.size());
+
+        lock.lock();
+
+        if (!m_terminate) {
+            if (m_concurrent_succs) {
+                update_successors(s, succ_ids, costs);
+            } else {
+                // state lookups and heuristic queries access the graph too
+                std::unique_lock<std::mutex> space_lock(m_space_lock);
+                update_successors(s, succ_ids, costs);
+            }
+        }
+
+        s->expanding = false;
+        auto it = std::find(begin(m_being_expanded), end(m_being_expanded), s);
+        assert(it != end(m_being_expanded));
+        *it = m_being_expanded.back();
+        m_being_expanded.pop_back();
+
+        m_cond.notify_all();
+    }
+
+    // wake waiting workers so they observe termination
+    m_cond.notify_all();
+}
+
+// Return a lower bound on the keys, in a search, of the states that may still
+// be expanded: the minimum key in its open list and the keys of the states
+// currently being expanded.
+int SMHAStar::get_minf_bound(int hidx)
+{
+    int bound = m_open[hidx].empty() ? INFINITECOST : get_minf(m_open[hidx]);
+    for (SMHAState* s : m_being_expanded) {
+        bound = std::min(bound, compute_key(s, hidx));
+    }
+    return bound;
 }
 
 SMHAState* SMHAStar::state_from_open_state(SMHAState::HeapData* open_state)
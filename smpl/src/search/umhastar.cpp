@@ -33,43 +33,53 @@
 
 namespace smpl {
 
-UMHAStar::UMHAStar(
+template <typename EdgePolicy>
+BasicUMHAStar<EdgePolicy>::BasicUMHAStar(
     DiscreteSpaceInformation* environment,
     Heuristic* hanchor,
     Heuristic** heurs,
     int hcount)
 :
-    MHAStarBase(environment, hanchor, heurs, hcount),
+    MHAStarBase<BasicUMHAStar<EdgePolicy>, EdgePolicy>(
+            environment, hanchor, heurs, hcount),
     m_max_fval_closed_anc(0)
 {
 }
 
-void UMHAStar::reinitSearch()
+template <typename EdgePolicy>
+void BasicUMHAStar<EdgePolicy>::reinitSearch()
 {
-    m_max_fval_closed_anc = m_start_state->od[0].f; //0;
+    m_max_fval_closed_anc = this->m_start_state->od[0].f; //0;
 }
 
-void UMHAStar::on_closed_anchor(MHASearchState* s)
+template <typename EdgePolicy>
+void BasicUMHAStar<EdgePolicy>::on_closed_anchor(MHASearchState* s)
 {
     if (s->od[0].f > m_max_fval_closed_anc) {
         m_max_fval_closed_anc = s->od[0].f;
     }
 }
 
-int UMHAStar::priority(MHASearchState* state)
+template <typename EdgePolicy>
+int BasicUMHAStar<EdgePolicy>::priority(MHASearchState* state)
 {
-    return state->g + m_eps * state->od[0].h;
+    return state->g + this->m_eps * state->od[0].h;
 }
 
-bool UMHAStar::terminated() const
+template <typename EdgePolicy>
+bool BasicUMHAStar<EdgePolicy>::terminated() const
 {
-    return m_goal_state->g <= m_eps * get_minf(m_open[0]);
+    return this->m_goal_state->g <= this->m_eps * this->get_minf(this->m_open[0]);
 }
 
-bool UMHAStar::satisfies_p_criterion(
+template <typename EdgePolicy>
+bool BasicUMHAStar<EdgePolicy>::satisfies_p_criterion(
         MHASearchState* state) const
 {
     return true;
 }
 
+template class BasicUMHAStar<EagerEdgeEvaluation>;
+template class BasicUMHAStar<LazyEdgeEvaluation>;
+
 } // namespace smpl
@@ -0,0 +1,240 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+
+#include <smpl/steer/swept_footprint.h>
+
+// standard includes
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// project includes
+#include <smpl/occupancy_grid.h>
+#include <smpl/console/console.h>
+
+namespace smpl {
+
+static double PointSegmentDistance(
+    const Vector2& p,
+    const Vector2& a,
+    const Vector2& b)
+{
+    Vector2 ab = b - a;
+    auto len2 = ab.squaredNorm();
+    auto t = len2 > 0.0 ? std::max(0.0, std::min(1.0, (p - a).dot(ab) / len2)) : 0.0;
+    return (a + t * ab - p).norm();
+}
+
+static bool PointInPolygon(const Vector2& p, const std::vector<Vector2>& poly)
+{
+    auto inside = false;
+    for (size_t i = 0, j = poly.size() - 1; i < poly.size(); j = i++) {
+        if ((poly[i].y() > p.y()) != (poly[j].y() > p.y()) &&
+            p.x() < (poly[j].x() - poly[i].x()) * (p.y() - poly[i].y()) /
+                    (poly[j].y() - poly[i].y()) + poly[i].x())
+        {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+void RasterizeFootprint(
+    const std::vector<Vector2>& footprint,
+    const Pose2D& pose,
+    double res,
+    std::vector<std::pair<int, int>>& cells)
+{
+    if (footprint.empty()) {
+        cells.emplace_back((int)std::round(pose.x / res), (int)std::round(pose.y / res));
+        return;
+    }
+
+    auto c = std::cos(pose.theta);
+    auto s = std::sin(pose.theta);
+    std::vector<Vector2> poly;
+    poly.reserve(footprint.size());
+    auto min_x = std::numeric_limits<double>::infinity();
+    auto min_y = std::numeric_limits<double>::infinity();
+    auto max_x = -std::numeric_limits<double>::infinity();
+    auto max_y = -std::numeric_limits<double>::infinity();
+    for (auto& v : footprint) {
+        Vector2 w(pose.x + c * v.x() - s * v.y(), pose.y + s * v.x() + c * v.y());
+        min_x = std::min(min_x, w.x());
+        min_y = std::min(min_y, w.y());
+        max_x = std::max(max_x, w.x());
+        max_y = std::max(max_y, w.y());
+        poly.push_back(w);
+    }
+
+    auto margin = 0.5 * std::sqrt(2.0) * res;
+    for (int x = (int)std::floor(min_x / res); x <= (int)std::ceil(max_x / res); ++x) {
+    for (int y = (int)std::floor(min_y / res); y <= (int)std::ceil(max_y / res); ++y) {
+        Vector2 p((double)x * res, (double)y * res);
+        auto covered = PointInPolygon(p, poly);
+        for (size_t i = 0; !covered && i < poly.size(); ++i) {
+            auto& a = poly[i];
+            auto& b = poly[(i + 1) % poly.size()];
+            covered = PointSegmentDistance(p, a, b) <= margin;
+        }
+        if (covered) {
+            cells.emplace_back(x, y);
+        }
+    }
+    }
+}
+
+auto IntegrateBodyVelocity(
+    const Pose2D& start,
+    double vx,
+    double vy,
+    double vtheta,
+    double duration,
+    int count)
+    -> std::vector<Pose2D>
+{
+    std::vector<Pose2D> poses;
+    poses.reserve(std::max(count, 0));
+
+    auto c0 = std::cos(start.theta);
+    auto s0 = std::sin(start.theta);
+    for (int i = 1; i <= count; ++i) {
+        auto t = duration * (double)i / (double)count;
+        auto theta = start.theta + vtheta * t;
+
+        // integrals of cos(theta) and sin(theta) over [0, t]
+        double ic, is;
+        if (std::fabs(vtheta) < 1e-9) {
+            ic = c0 * t;
+            is = s0 * t;
+        } else {
+            ic = (std::sin(theta) - s0) / vtheta;
+            is = (c0 - std::cos(theta)) / vtheta;
+        }
+
+        poses.push_back(Pose2D(
+                start.x + vx * ic - vy * is,
+                start.y + vx * is + vy * ic,
+                theta));
+    }
+    return poses;
+}
+
+SweptFootprint::SweptFootprint(std::vector<std::pair<int, int>> cells) :
+    m_cells(std::move(cells))
+{
+    std::sort(begin(m_cells), end(m_cells));
+    m_cells.erase(std::unique(begin(m_cells), end(m_cells)), end(m_cells));
+    if (m_cells.empty()) {
+        return;
+    }
+
+    m_min_x = m_max_x = m_cells.front().first;
+    m_min_y = m_max_y = m_cells.front().second;
+    for (auto& cell : m_cells) {
+        m_min_x = std::min(m_min_x, cell.first);
+        m_max_x = std::max(m_max_x, cell.first);
+        m_min_y = std::min(m_min_y, cell.second);
+        m_max_y = std::max(m_max_y, cell.second);
+    }
+
+    m_row_words = (m_max_x - m_min_x) / 64 + 1;
+    m_masks.assign((size_t)(m_max_y - m_min_y + 1) * m_row_words, 0);
+    for (auto& cell : m_cells) {
+        auto col = cell.first - m_min_x;
+        auto row = cell.second - m_min_y;
+        m_masks[(size_t)row * m_row_words + (col >> 6)] |= (uint64_t)1 << (col & 63);
+    }
+}
+
+bool OccupancySlice::init(const OccupancyGrid* grid, int z)
+{
+    if (!grid || z < 0 || z >= grid->numCellsZ()) {
+        SMPL_ERROR("Occupancy slice %d is outside the grid", z);
+        return false;
+    }
+
+    m_grid = grid;
+    m_z = z;
+    m_width = grid->numCellsX();
+    m_height = grid->numCellsY();
+    m_row_words = (m_width + 63) / 64 + 1;
+    update();
+    return true;
+}
+
+void OccupancySlice::update()
+{
+    m_bits.assign((size_t)m_height * m_row_words, 0);
+    for (int y = 0; y < m_height; ++y) {
+        auto* row = &m_bits[(size_t)y * m_row_words];
+        for (int x = 0; x < m_width; ++x) {
+            if (m_grid->getDistance(x, y, m_z) <= 0.0) {
+                row[x >> 6] |= (uint64_t)1 << (x & 63);
+            }
+        }
+    }
+}
+
+bool OccupancySlice::isFree(int x, int y, const SweptFootprint& swept) const
+{
+    if (swept.empty()) {
+        return true;
+    }
+
+    auto x0 = x + swept.minX();
+    auto y0 = y + swept.minY();
+    if (x0 < 0 || y0 < 0 ||
+        x + swept.maxX() >= m_width || y + swept.maxY() >= m_height)
+    {
+        return false;
+    }
+
+    auto rows = swept.maxY() - swept.minY() + 1;
+    for (int r = 0; r < rows; ++r) {
+        auto* mask = swept.rowMask(r);
+        auto* bits = &m_bits[(size_t)(y0 + r) * m_row_words];
+        for (int j = 0; j < swept.rowWords(); ++j) {
+            // the 64 slice cells starting at the column of this mask word;
+            // the high word is shifted in two steps so that a shift of 0
+            // does not shift by 64
+            auto col = x0 + 64 * j;
+            auto w = col >> 6;
+            auto s = col & 63;
+            auto window = (bits[w] >> s) | ((bits[w + 1] << 1) << (63 - s));
+            if (window & mask[j]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace smpl
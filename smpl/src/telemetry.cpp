@@ -0,0 +1,162 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+#include <smpl/telemetry.h>
+
+// standard includes
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace smpl {
+
+namespace detail {
+
+thread_local TelemetryBlock* g_telemetry_block = nullptr;
+
+TelemetryBlock::TelemetryBlock()
+{
+    for (int e = 0; e < TelemetryEventCount; ++e) {
+        counts[e].store(0, std::memory_order_relaxed);
+        ticks[e].store(0, std::memory_order_relaxed);
+        for (int b = 0; b < TelemetryBucketCount; ++b) {
+            histogram[e][b].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+} // namespace detail
+
+namespace {
+
+// The blocks of all threads that have recorded an event. Blocks outlive their
+// threads so that the totals never decrease.
+struct TelemetryRegistry
+{
+    std::mutex mutex;
+    std::vector<std::unique_ptr<detail::TelemetryBlock>> blocks;
+
+    // reference point for measuring the tick period
+    std::uint64_t start_ticks;
+    std::chrono::steady_clock::time_point start_time;
+
+    TelemetryRegistry() :
+        start_ticks(TelemetryTicks()),
+        start_time(std::chrono::steady_clock::now())
+    { }
+};
+
+auto GetRegistry() -> TelemetryRegistry&
+{
+    static TelemetryRegistry registry;
+    return registry;
+}
+
+auto MeasureSecondsPerTick(const TelemetryRegistry& registry) -> double
+{
+#if defined(__x86_64__) || defined(__i386__)
+    const auto now_ticks = TelemetryTicks();
+    const auto now_time = std::chrono::steady_clock::now();
+    if (now_ticks <= registry.start_ticks) {
+        return 0.0;
+    }
+    const double elapsed =
+            std::chrono::duration<double>(now_time - registry.start_time).count();
+    return elapsed / (double)(now_ticks - registry.start_ticks);
+#else
+    return 1e-9;
+#endif
+}
+
+} // namespace
+
+auto to_cstring(TelemetryEvent event) -> const char*
+{
+    switch (event) {
+    case TelemetryEvent::Expansion:             return "expansion";
+    case TelemetryEvent::SuccessorGenerated:    return "successor";
+    case TelemetryEvent::StateCheck:            return "state check";
+    case TelemetryEvent::MotionCheck:           return "motion check";
+    case TelemetryEvent::ForwardKinematics:     return "forward kinematics";
+    case TelemetryEvent::HeuristicEvaluation:   return "heuristic evaluation";
+    case TelemetryEvent::IkCacheHit:            return "ik cache hit";
+    case TelemetryEvent::IkCacheMiss:           return "ik cache miss";
+    case TelemetryEvent::HeuristicCacheHit:     return "heuristic cache hit";
+    case TelemetryEvent::HeuristicCacheMiss:    return "heuristic cache miss";
+    case TelemetryEvent::ResultCacheHit:        return "result cache hit";
+    case TelemetryEvent::ResultCacheMiss:       return "result cache miss";
+    default:                                    return "<unknown>";
+    }
+}
+
+auto detail::RegisterTelemetryThread() -> TelemetryBlock*
+{
+    auto& registry = GetRegistry();
+    std::unique_ptr<TelemetryBlock> block(new TelemetryBlock);
+    g_telemetry_block = block.get();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.blocks.push_back(std::move(block));
+    return g_telemetry_block;
+}
+
+auto GetTelemetry() -> TelemetrySnapshot
+{
+    auto& registry = GetRegistry();
+    TelemetrySnapshot snapshot;
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (auto& block : registry.blocks) {
+        for (int e = 0; e < TelemetryEventCount; ++e) {
+            snapshot.counts[e] += block->counts[e].load(std::memory_order_relaxed);
+            snapshot.ticks[e] += block->ticks[e].load(std::memory_order_relaxed);
+            for (int b = 0; b < TelemetryBucketCount; ++b) {
+                snapshot.histogram[e][b] +=
+                        block->histogram[e][b].load(std::memory_order_relaxed);
+            }
+        }
+    }
+    snapshot.seconds_per_tick = MeasureSecondsPerTick(registry);
+    return snapshot;
+}
+
+auto operator-(const TelemetrySnapshot& a, const TelemetrySnapshot& b)
+    -> TelemetrySnapshot
+{
+    TelemetrySnapshot d;
+    for (int e = 0; e < TelemetryEventCount; ++e) {
+        d.counts[e] = a.counts[e] - b.counts[e];
+        d.ticks[e] = a.ticks[e] - b.ticks[e];
+        for (int i = 0; i < TelemetryBucketCount; ++i) {
+            d.histogram[e][i] = a.histogram[e][i] - b.histogram[e][i];
+        }
+    }
+    d.seconds_per_tick = a.seconds_per_tick;
+    return d;
+}
+
+} // namespace smpl
@@ -0,0 +1,187 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+
+#include <smpl/tracing.h>
+
+// standard includes
+#include <fstream>
+#include <mutex>
+#include <unistd.h>
+
+namespace smpl {
+
+namespace detail {
+
+std::atomic<bool> g_tracing_enabled(false);
+
+} // namespace detail
+
+namespace {
+
+// Ring buffer of completed spans. Spans are recorded around coarse stages of
+// a request, so a lock is cheap relative to the work they measure.
+struct TraceBuffer
+{
+    std::mutex mutex;
+    std::vector<TraceEvent> events;
+    std::size_t capacity = 1 << 16;
+    std::size_t next = 0; // slot of the next span once the buffer is full
+};
+
+auto GetTraceBuffer() -> TraceBuffer&
+{
+    static TraceBuffer buffer;
+    return buffer;
+}
+
+// Small, stable ids for the threads that record spans, in order of their
+// first span
+auto TraceThreadID() -> std::uint32_t
+{
+    static std::atomic<std::uint32_t> next_id(0);
+    thread_local std::uint32_t id = next_id.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+void WriteJSONString(std::ostream& o, const char* s)
+{
+    o << '"';
+    for (; *s != '\0'; ++s) {
+        switch (*s) {
+        case '"':   o << "\\\""; break;
+        case '\\':  o << "\\\\"; break;
+        case '\n':  o << "\\n"; break;
+        default:    o << *s; break;
+        }
+    }
+    o << '"';
+}
+
+} // namespace
+
+void detail::RecordSpan(
+    const char* name,
+    std::uint64_t begin_ns,
+    std::uint64_t end_ns)
+{
+    TraceEvent event;
+    event.name = name;
+    event.thread = TraceThreadID();
+    event.begin_ns = begin_ns;
+    event.end_ns = end_ns;
+
+    auto& buffer = GetTraceBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    if (buffer.capacity == 0) {
+        return;
+    }
+    if (buffer.events.size() < buffer.capacity) {
+        buffer.events.push_back(event);
+    } else {
+        buffer.events[buffer.next] = event;
+        buffer.next = (buffer.next + 1) % buffer.capacity;
+    }
+}
+
+void SetTracingEnabled(bool enabled)
+{
+    detail::g_tracing_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void SetTraceCapacity(std::size_t capacity)
+{
+    auto& buffer = GetTraceBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.events.clear();
+    buffer.events.shrink_to_fit();
+    buffer.capacity = capacity;
+    buffer.next = 0;
+}
+
+void ClearTrace()
+{
+    auto& buffer = GetTraceBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.events.clear();
+    buffer.next = 0;
+}
+
+auto GetTraceEvents() -> std::vector<TraceEvent>
+{
+    auto& buffer = GetTraceBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    std::vector<TraceEvent> events;
+    events.reserve(buffer.events.size());
+    events.insert(end(events), begin(buffer.events) + buffer.next, end(buffer.events));
+    events.insert(end(events), begin(buffer.events), begin(buffer.events) + buffer.next);
+    return events;
+}
+
+void WriteChromeTrace(std::ostream& o)
+{
+    auto events = GetTraceEvents();
+    auto pid = (long)getpid();
+
+    // complete ("X") events, with timestamps and durations in microseconds
+    o << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    auto first = true;
+    for (auto& event : events) {
+        if (!first) {
+            o << ',';
+        }
+        first = false;
+        o << "\n{\"name\":";
+        WriteJSONString(o, event.name);
+        o << ",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << event.thread;
+        o << ",\"ts\":" << event.begin_ns / 1000 << '.';
+        o << (char)('0' + event.begin_ns / 100 % 10);
+        o << (char)('0' + event.begin_ns / 10 % 10);
+        o << (char)('0' + event.begin_ns % 10);
+        auto dur = event.end_ns - event.begin_ns;
+        o << ",\"dur\":" << dur / 1000 << '.';
+        o << (char)('0' + dur / 100 % 10);
+        o << (char)('0' + dur / 10 % 10);
+        o << (char)('0' + dur % 10);
+        o << '}';
+    }
+    o << "\n]}\n";
+}
+
+bool WriteChromeTrace(const std::string& path)
+{
+    std::ofstream ofs(path);
+    if (!ofs.is_open()) {
+        return false;
+    }
+    WriteChromeTrace(ofs);
+    return ofs.good();
+}
+
+} // namespace smpl
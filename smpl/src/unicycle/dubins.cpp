@@ -833,4 +833,126 @@ int MakeDubinsPaths(
     return count;
 }
 
+// Wrap an angle into [0, 2pi) without branching
+static inline
+auto mod2pi(double a) -> double
+{
+    return a - 2.0 * M_PI * floor(a * (0.5 / M_PI));
+}
+
+// Return the length of the shortest Dubins path, in units of the turning
+// radius, from the origin with heading alpha to the point (d, 0) with heading
+// beta (the normalized form from Shkel and Lumelsky). Each of the six words
+// is computed unconditionally; words that do not exist are replaced with
+// infinity via selects.
+static inline
+auto NormalizedDubinsDistance(double d, double alpha, double beta) -> double
+{
+    const double inf = std::numeric_limits<double>::infinity();
+
+    const double sa = sin(alpha);
+    const double ca = cos(alpha);
+    const double sb = sin(beta);
+    const double cb = cos(beta);
+    const double cab = cos(alpha - beta);
+    const double dd = d * d;
+
+    // LSL
+    const double p2_lsl = 2.0 + dd - 2.0 * cab + 2.0 * d * (sa - sb);
+    const double tmp_lsl = atan2(cb - ca, d + sa - sb);
+    const double len_lsl =
+            mod2pi(tmp_lsl - alpha) +
+            sqrt(fmax(p2_lsl, 0.0)) +
+            mod2pi(beta - tmp_lsl);
+
+    // RSR
+    const double p2_rsr = 2.0 + dd - 2.0 * cab + 2.0 * d * (sb - sa);
+    const double tmp_rsr = atan2(ca - cb, d - sa + sb);
+    const double len_rsr =
+            mod2pi(alpha - tmp_rsr) +
+            sqrt(fmax(p2_rsr, 0.0)) +
+            mod2pi(tmp_rsr - beta);
+
+    // LSR
+    const double p2_lsr = -2.0 + dd + 2.0 * cab + 2.0 * d * (sa + sb);
+    const double p_lsr = sqrt(fmax(p2_lsr, 0.0));
+    const double tmp_lsr = atan2(-ca - cb, d + sa + sb) - atan2(-2.0, p_lsr);
+    const double len_lsr =
+            mod2pi(tmp_lsr - alpha) + p_lsr + mod2pi(tmp_lsr - beta);
+
+    // RSL
+    const double p2_rsl = -2.0 + dd + 2.0 * cab - 2.0 * d * (sa + sb);
+    const double p_rsl = sqrt(fmax(p2_rsl, 0.0));
+    const double tmp_rsl = atan2(ca + cb, d - sa - sb) - atan2(2.0, p_rsl);
+    const double len_rsl =
+            mod2pi(alpha - tmp_rsl) + p_rsl + mod2pi(beta - tmp_rsl);
+
+    // RLR
+    const double c_rlr = (6.0 - dd + 2.0 * cab + 2.0 * d * (sa - sb)) / 8.0;
+    const double p_rlr =
+            mod2pi(2.0 * M_PI - acos(fmin(fmax(c_rlr, -1.0), 1.0)));
+    const double t_rlr =
+            mod2pi(alpha - atan2(ca - cb, d - sa + sb) + 0.5 * p_rlr);
+    const double len_rlr =
+            t_rlr + p_rlr + mod2pi(alpha - beta - t_rlr + p_rlr);
+
+    // LRL
+    const double c_lrl = (6.0 - dd + 2.0 * cab + 2.0 * d * (sb - sa)) / 8.0;
+    const double p_lrl =
+            mod2pi(2.0 * M_PI - acos(fmin(fmax(c_lrl, -1.0), 1.0)));
+    const double t_lrl =
+            mod2pi(-alpha - atan2(ca - cb, d + sa - sb) + 0.5 * p_lrl);
+    const double len_lrl =
+            t_lrl + p_lrl + mod2pi(beta - alpha - t_lrl + p_lrl);
+
+    double best = p2_lsl >= 0.0 ? len_lsl : inf;
+    best = fmin(best, p2_rsr >= 0.0 ? len_rsr : inf);
+    best = fmin(best, p2_lsr >= 0.0 ? len_lsr : inf);
+    best = fmin(best, p2_rsl >= 0.0 ? len_rsl : inf);
+    best = fmin(best, fabs(c_rlr) <= 1.0 ? len_rlr : inf);
+    best = fmin(best, fabs(c_lrl) <= 1.0 ? len_lrl : inf);
+    return best;
+}
+
+static inline
+auto DubinsDistance(
+    double sx, double sy, double sth,
+    double gx, double gy, double gth,
+    double radius) -> double
+{
+    const double dx = gx - sx;
+    const double dy = gy - sy;
+    const double d = sqrt(dx * dx + dy * dy) / radius;
+    const double theta = mod2pi(atan2(dy, dx));
+    const double alpha = mod2pi(sth - theta);
+    const double beta = mod2pi(gth - theta);
+    return radius * NormalizedDubinsDistance(d, alpha, beta);
+}
+
+auto ComputeDubinsDistance(
+    const Pose2D& start,
+    const Pose2D& goal,
+    double radius) -> double
+{
+    return DubinsDistance(
+            start.x, start.y, start.theta,
+            goal.x, goal.y, goal.theta,
+            radius);
+}
+
+void ComputeDubinsDistances(
+    const double* start_x, const double* start_y, const double* start_theta,
+    const double* goal_x, const double* goal_y, const double* goal_theta,
+    double radius,
+    size_t count,
+    double* distances)
+{
+    for (size_t i = 0; i < count; ++i) {
+        distances[i] = DubinsDistance(
+                start_x[i], start_y[i], start_theta[i],
+                goal_x[i], goal_y[i], goal_theta[i],
+                radius);
+    }
+}
+
 } // namespace smpl
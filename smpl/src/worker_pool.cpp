@@ -0,0 +1,124 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+
+#include <smpl/worker_pool.h>
+
+namespace smpl {
+
+WorkerPool::WorkerPool(int num_threads) : m_next(0)
+{
+    for (int i = 1; i < num_threads; ++i) {
+        m_threads.emplace_back([this, i]() { this->work(i); });
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_shutdown = true;
+    }
+    m_job_ready.notify_all();
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::run(std::size_t count, const Job& job)
+{
+    if (count == 0) {
+        return;
+    }
+
+    // not worth waking anyone up
+    if (m_threads.empty() || count == 1) {
+        for (std::size_t i = 0; i < count; ++i) {
+            job(0, i);
+        }
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_job = &job;
+        m_count = count;
+        m_next = 0;
+        m_active = (int)m_threads.size();
+        ++m_generation;
+    }
+    m_job_ready.notify_all();
+
+    runItems(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_job_done.wait(lock, [this]() { return m_active == 0; });
+    m_job = nullptr;
+}
+
+void WorkerPool::work(int tid)
+{
+    unsigned long last_generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_job_ready.wait(lock, [&]() {
+                return m_shutdown || m_generation != last_generation;
+            });
+            if (m_shutdown) {
+                return;
+            }
+            last_generation = m_generation;
+        }
+
+        runItems(tid);
+
+        bool last;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            last = (--m_active == 0);
+        }
+        if (last) {
+            m_job_done.notify_one();
+        }
+    }
+}
+
+void WorkerPool::runItems(int tid)
+{
+    while (true) {
+        auto i = m_next.fetch_add(1, std::memory_order_relaxed);
+        if (i >= m_count) {
+            return;
+        }
+        (*m_job)(tid, i);
+    }
+}
+
+} // namespace smpl
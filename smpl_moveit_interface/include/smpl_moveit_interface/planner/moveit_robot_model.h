@@ -106,6 +106,11 @@ public:
     ///@{
     auto computeFK(const smpl::RobotState& state)
         -> Eigen::Affine3d override;
+
+    void computeFKBatch(
+        const double* states,
+        int n,
+        Eigen::Affine3d* poses) override;
     ///@}
 
     /// \name InverseKinematicsInterface Interface
@@ -172,6 +177,10 @@ private:
     std::vector<double> m_var_max_limits;
     std::vector<bool> m_var_continuous;
     std::vector<bool> m_var_bounded;
+
+    // limits checked by checkJointLimits, infinite for unbounded variables
+    std::vector<double> m_var_check_min_limits;
+    std::vector<double> m_var_check_max_limits;
     std::vector<double> m_var_vel_limits;
     std::vector<double> m_var_acc_limits;
 
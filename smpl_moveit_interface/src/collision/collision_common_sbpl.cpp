@@ -70,6 +70,19 @@ bool CollisionStateUpdater::init(
 
     m_rcm_vars.assign(robot.getVariableCount(), 0.0);
 
+    m_root_var_indices.clear();
+    m_root_identity_vars.clear();
+    auto* root_joint = robot.getRootJoint();
+    if (root_joint != nullptr && root_joint->getVariableCount() > 0) {
+        m_root_identity_vars.resize(root_joint->getVariableCount());
+        root_joint->computeVariablePositions(
+                Eigen::Affine3d::Identity(), m_root_identity_vars.data());
+        for (auto i = 0; i < root_joint->getVariableCount(); ++i) {
+            auto vidx = root_joint->getFirstVariableIndex() + i;
+            m_root_var_indices.push_back(m_rcm_var_indices[vidx]);
+        }
+    }
+
     m_inorder = true;
     for (auto i = 1; i < m_rcm_var_indices.size(); ++i) {
         if (m_rcm_var_indices[i] != m_rcm_var_indices[i - 1] + 1) {
@@ -84,14 +97,20 @@ bool CollisionStateUpdater::init(
     return true;
 }
 
-void CollisionStateUpdater::update(const moveit::core::RobotState& state)
+void CollisionStateUpdater::update(
+    const moveit::core::RobotState& state,
+    bool identity_root)
 {
-    m_rcs->setJointVarPositions(getVariablesFor(state).data());
+    // RobotCollisionState only dirties the subtrees of joints whose variables
+    // differ from its current values, so repeated checks of states that differ
+    // only in a few variables recompute only the affected links
+    m_rcs->setJointVarPositions(getVariablesFor(state, identity_root).data());
     updateAttachedBodies(state);
 }
 
 auto CollisionStateUpdater::getVariablesFor(
-    const moveit::core::RobotState& state)
+    const moveit::core::RobotState& state,
+    bool identity_root)
     -> const std::vector<double>&
 {
     if (m_inorder) {
@@ -105,6 +124,11 @@ auto CollisionStateUpdater::getVariablesFor(
             m_rcm_vars[rcmvidx] = state.getVariablePosition(vidx);
         }
     }
+    if (identity_root) {
+        for (size_t i = 0; i < m_root_var_indices.size(); ++i) {
+            m_rcm_vars[m_root_var_indices[i]] = m_root_identity_vars[i];
+        }
+    }
     return m_rcm_vars;
 }
 
@@ -141,7 +165,7 @@ bool CollisionStateUpdater::getRobotCollisionModelJointIndices(
 bool CollisionStateUpdater::updateAttachedBodies(
     const moveit::core::RobotState& state)
 {
-    std::vector<const moveit::core::AttachedBody*> attached_bodies;
+    auto& attached_bodies = m_attached_bodies;
     state.getAttachedBodies(attached_bodies);
 
     bool updated = false;
@@ -257,6 +281,11 @@ void LoadCollisionGridConfig(
     config.origin_z = cm_config["origin_z"];
     config.res_m = cm_config["res_m"];
     config.max_distance_m = cm_config["max_distance_m"];
+    if (cm_config.hasMember("sparse")) {
+        config.sparse = cm_config["sparse"];
+    } else {
+        config.sparse = false;
+    }
 }
 
 /// \brief Load the Joint <-> Collision Group Map from the param server
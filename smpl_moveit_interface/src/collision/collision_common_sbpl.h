@@ -70,6 +70,10 @@ struct CollisionGridConfig
     double origin_z;
     double res_m;
     double max_distance_m;
+
+    /// Store distances in a smpl::SparseDistanceMap, whose copies share
+    /// unmodified cells with the original.
+    bool sparse = false;
 };
 
 void LoadCollisionGridConfig(
@@ -102,9 +106,18 @@ public:
         const moveit::core::RobotModel& robot,
         const smpl::collision::RobotCollisionModelConstPtr& rcm);
 
-    void update(const moveit::core::RobotState& state);
-
-    auto getVariablesFor(const moveit::core::RobotState& state)
+    /// Update the collision state to reflect the joint variables and attached
+    /// bodies of \p state. If \p identity_root is true, the root joint of
+    /// \p state is treated as the identity transform, without requiring a
+    /// modified copy of \p state. Only links affected by variables that
+    /// changed since the previous update are marked for recomputation.
+    void update(
+        const moveit::core::RobotState& state,
+        bool identity_root = false);
+
+    auto getVariablesFor(
+        const moveit::core::RobotState& state,
+        bool identity_root = false)
         -> const std::vector<double>&;
 
     auto collisionState() -> smpl::collision::RobotCollisionState*
@@ -142,6 +155,14 @@ private:
     // robot collision state joint variables for batch updating
     std::vector<double> m_rcm_vars;
 
+    // RobotCollisionModel indices of the root joint variables and their
+    // values when the root joint is the identity transform
+    std::vector<int> m_root_var_indices;
+    std::vector<double> m_root_identity_vars;
+
+    // scratch storage for the attached bodies of the state being updated
+    std::vector<const moveit::core::AttachedBody*> m_attached_bodies;
+
     // the final RobotCollisionState
     smpl::collision::RobotCollisionStatePtr m_rcs;
 
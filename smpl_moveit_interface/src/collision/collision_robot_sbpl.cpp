@@ -398,11 +398,7 @@ void CollisionRobotSBPL::checkSelfCollisionMutable(
 
     auto gidx = m_rcm->groupIndex(collision_group_name);
 
-    auto state_copy = state;
-    state_copy.setJointPositions(
-            state_copy.getRobotModel()->getRootJoint(),
-            Eigen::Affine3d::Identity());
-    m_updater.update(state_copy);
+    m_updater.update(state, true);
 
     double dist;
     auto valid = m_scm->checkCollision(
@@ -480,18 +476,8 @@ void CollisionRobotSBPL::checkSelfCollisionMutable(
 
     auto gidx = m_rcm->groupIndex(collision_group_name);
 
-    auto state1_copy = state1;
-    auto state2_copy = state2;
-    state1_copy.setJointPositions(
-            state1_copy.getRobotModel()->getRootJoint(),
-            Eigen::Affine3d::Identity());
-    state2_copy.setJointPositions(
-            state1_copy.getRobotModel()->getRootJoint(),
-            Eigen::Affine3d::Identity());
-//    m_updater.update(state_copy);
-
-    auto startvars = m_updater.getVariablesFor(state1_copy);
-    auto goalvars = m_updater.getVariablesFor(state2_copy);
+    auto startvars = m_updater.getVariablesFor(state1, true);
+    auto goalvars = m_updater.getVariablesFor(state2, true);
 
     double dist;
     auto valid = m_scm->checkMotionCollision(
@@ -38,6 +38,7 @@
 #include <ros/ros.h>
 #include <geometric_shapes/shape_operations.h>
 #include <smpl/debug/visualize.h>
+#include <smpl/distance_map/sparse_distance_map.h>
 
 // module includes
 #include "collision_common_sbpl.h"
@@ -115,9 +116,25 @@ auto MakeGrid(const CollisionGridConfig& config) -> smpl::OccupancyGridPtr
     ROS_DEBUG_NAMED(LOG, "    origin: (%0.3f, %0.3f, %0.3f)", config.origin_x, config.origin_y, config.origin_z);
     ROS_DEBUG_NAMED(LOG, "    resolution: %0.3f", config.res_m);
     ROS_DEBUG_NAMED(LOG, "    max_distance: %0.3f", config.max_distance_m);
+    ROS_DEBUG_NAMED(LOG, "    sparse: %s", config.sparse ? "true" : "false");
 
     auto ref_counted = true;
 
+    if (config.sparse) {
+        auto dfield = std::make_shared<smpl::SparseDistanceMap>(
+                config.origin_x,
+                config.origin_y,
+                config.origin_z,
+                config.size_x,
+                config.size_y,
+                config.size_z,
+                config.res_m,
+                config.max_distance_m);
+        auto dmap = std::make_shared<smpl::OccupancyGrid>(dfield, ref_counted);
+        dmap->setReferenceFrame(config.frame_id);
+        return dmap;
+    }
+
     auto dmap = std::make_shared<smpl::OccupancyGrid>(
             config.size_x,
             config.size_y,
@@ -35,6 +35,8 @@
 
 // standard includes
 #include <assert.h>
+#include <algorithm>
+#include <atomic>
 #include <limits>
 
 // system includes
@@ -44,16 +46,44 @@
 #include <smpl/debug/marker_conversions.h>
 #include <smpl/debug/marker_utils.h>
 #include <smpl/console/nonstd.h>
+#include <smpl/stl/memory.h>
+#include <sbpl_collision_checking/world_collision_detector.h>
 
 #include <smpl_moveit_interface/planner/moveit_robot_model.h>
 
+#include "../collision/collision_common_sbpl.h"
+#include "../collision/collision_robot_sbpl.h"
+#include "../collision/collision_world_sbpl.h"
+
 namespace sbpl_interface {
 
+struct MoveItCollisionChecker::SBPLCollisionPath
+{
+    smpl::collision::RobotCollisionModelConstPtr rcm;
+
+    // collision state of the robot in the planning frame, for world collisions
+    collision_detection::CollisionStateUpdater world_state;
+
+    // collision state of the robot in its model frame, for self collisions
+    collision_detection::CollisionStateUpdater self_state;
+
+    smpl::OccupancyGridPtr self_grid;
+    smpl::collision::SelfCollisionModelPtr scm;
+
+    const collision_detection::CollisionWorldSBPL* world = nullptr;
+
+    // collision model variable index of each planning variable
+    std::vector<int> var_indices;
+
+    int gidx = -1;
+};
+
 MoveItCollisionChecker::MoveItCollisionChecker() :
     Base(),
     m_robot_model(nullptr),
     m_scene(),
-    m_ref_state()
+    m_ref_state(),
+    m_enabled_sbpl_path(true)
 {
     ros::NodeHandle nh;
 }
@@ -95,6 +125,7 @@ bool MoveItCollisionChecker::init(
 
     m_robot_model = robot_model;
 
+    m_var_incs.clear();
     m_var_incs.reserve(m_robot_model->getPlanningJoints().size());
     for (auto& joint_name : m_robot_model->getPlanningJoints()) {
         m_var_incs.push_back(smpl::angles::to_radians(2.0));
@@ -112,13 +143,51 @@ bool MoveItCollisionChecker::init(
     ph.param("enable_ccd", m_enabled_ccd, false);
     ROS_INFO("enable_ccd: %s", m_enabled_ccd ? "true" : "false");
 
+    ph.param("enable_sbpl_collision_path", m_enabled_sbpl_path, true);
+    ROS_INFO("enable_sbpl_collision_path: %s", m_enabled_sbpl_path ? "true" : "false");
+
+    // batch workers check states on their parent's threads
+    if (!m_batch_worker) {
+        int batch_threads;
+        ph.param("collision_batch_threads", batch_threads, 1);
+        ROS_INFO("collision_batch_threads: %d", batch_threads);
+        setBatchThreadCount(batch_threads);
+    }
+
+    if (!m_enabled_sbpl_path || !initSBPLCollisionPath(ref_state)) {
+        m_sbpl_path.reset();
+    }
+
+    m_sbpl_world = dynamic_cast<const collision_detection::CollisionWorldSBPL*>(
+            m_scene->getCollisionWorld().get()) != nullptr;
+
+    // batch workers are brought up to date on the next parallel batch, rather
+    // than recreated, to keep their collision models
+    m_batch_workers_stale = true;
+
     return true;
 }
 
+void MoveItCollisionChecker::setBatchThreadCount(int num_threads)
+{
+    num_threads = std::max(num_threads, 1);
+    if (num_threads == m_batch_thread_count) {
+        return;
+    }
+    m_batch_thread_count = num_threads;
+    m_batch_workers.clear();
+    if (num_threads > 1) {
+        m_batch_pool.reset(new smpl::WorkerPool(num_threads));
+    } else {
+        m_batch_pool.reset();
+    }
+}
+
 void MoveItCollisionChecker::setPathConstraints(
     const moveit_msgs::Constraints& constraints)
 {
     m_path_constraints = constraints;
+    m_batch_workers_stale = true;
     m_has_path_constraints =
             (!constraints.position_constraints.empty()) |
             (!constraints.orientation_constraints.empty()) |
@@ -133,22 +202,43 @@ bool MoveItCollisionChecker::initialized() const
 
 auto MoveItCollisionChecker::getExtension(size_t class_code) -> smpl::Extension*
 {
-    if (class_code == smpl::GetClassCode<smpl::CollisionChecker>()) {
+    if (class_code == smpl::GetClassCode<smpl::CollisionChecker>() ||
+        class_code == smpl::GetClassCode<smpl::CollisionCheckerCloneExtension>())
+    {
         return this;
     }
     return nullptr;
 }
 
+/// Create a checker for the same robot model, reference state, scene, and path
+/// constraints, with its own copy of the reference state and collision states.
+auto MoveItCollisionChecker::clone() -> std::unique_ptr<smpl::CollisionChecker>
+{
+    auto checker = smpl::make_unique<MoveItCollisionChecker>();
+    checker->m_batch_worker = true;
+    if (initialized()) {
+        checker->m_enabled_sbpl_path = m_enabled_sbpl_path;
+        if (!checker->init(m_robot_model, *m_ref_state, m_scene)) {
+            return nullptr;
+        }
+        checker->setPathConstraints(m_path_constraints);
+    }
+    return std::move(checker);
+}
+
 bool MoveItCollisionChecker::isStateValid(
     const smpl::RobotState& state,
     bool verbose)
 {
     assert(initialized() && "MoveItCollisionChecker must be initialized before use");
 
-    setRobotStateFromState(*m_ref_state, state);
+    auto must_update = mustUpdateState();
 
-    auto has_feasibility_predicate = (bool)m_scene->getStateFeasibilityPredicate();
-    auto must_update = has_feasibility_predicate | m_has_path_constraints;
+    if (!must_update && m_sbpl_path) {
+        return checkStateSBPL(state, verbose);
+    }
+
+    setRobotStateFromState(*m_ref_state, state);
 
     if (must_update) {
         // Obnoxiously, we need to manually flush transform updates here. While
@@ -169,6 +259,207 @@ bool MoveItCollisionChecker::isStateValid(
     }
 }
 
+bool MoveItCollisionChecker::areStatesValid(
+    const smpl::RobotState* states,
+    size_t n,
+    bool* out)
+{
+    // the MoveIt interface of the sbpl collision detector, feasibility
+    // predicates, and constraint evaluation are not safe to call from
+    // multiple threads
+    auto parallel_safe =
+            !mustUpdateState() && (m_sbpl_path || !m_sbpl_world);
+    if (m_batch_pool && parallel_safe && n >= (size_t)m_batch_thread_count) {
+        return areStatesValidParallel(states, n, out);
+    }
+
+    return Base::areStatesValid(states, n, out);
+}
+
+bool MoveItCollisionChecker::areStatesValidParallel(
+    const smpl::RobotState* states,
+    size_t n,
+    bool* out)
+{
+    if (m_batch_workers_stale) {
+        for (auto& worker : m_batch_workers) {
+            worker->m_enabled_sbpl_path = m_enabled_sbpl_path;
+            if (!worker->init(m_robot_model, *m_ref_state, m_scene)) {
+                ROS_WARN("Failed to update batch collision checker");
+                m_batch_workers.clear();
+                return Base::areStatesValid(states, n, out);
+            }
+            worker->setPathConstraints(m_path_constraints);
+        }
+        m_batch_workers_stale = false;
+    }
+
+    while (m_batch_workers.size() < (size_t)m_batch_thread_count - 1) {
+        auto checker = clone();
+        if (!checker) {
+            ROS_WARN("Failed to clone batch collision checker");
+            m_batch_workers.clear();
+            return Base::areStatesValid(states, n, out);
+        }
+        m_batch_workers.emplace_back(
+                static_cast<MoveItCollisionChecker*>(checker.release()));
+    }
+
+    std::atomic<bool> all_valid(true);
+    m_batch_pool->run(n, [&](int tid, size_t i)
+    {
+        // without an output array, the answer is known at the first invalid
+        // state, and the remaining items are skipped
+        if (out == nullptr && !all_valid.load(std::memory_order_relaxed)) {
+            return;
+        }
+        auto* checker = tid == 0 ? this : m_batch_workers[tid - 1].get();
+        auto valid = checker->isStateValid(states[i], false);
+        if (out != nullptr) {
+            out[i] = valid;
+        }
+        if (!valid) {
+            all_valid.store(false, std::memory_order_relaxed);
+        }
+    });
+
+    return all_valid.load();
+}
+
+bool MoveItCollisionChecker::mustUpdateState() const
+{
+    auto has_feasibility_predicate = (bool)m_scene->getStateFeasibilityPredicate();
+    return has_feasibility_predicate | m_has_path_constraints;
+}
+
+/// Prepare to check states directly against the sbpl collision detector. The
+/// collision states are initialized from the reference state, after which only
+/// the planning variables are updated, so only the transforms of links that
+/// depend on them are recomputed. The self collision model is kept across
+/// calls as long as the scene's robot collision model is unchanged.
+bool MoveItCollisionChecker::initSBPLCollisionPath(
+    const moveit::core::RobotState& ref_state)
+{
+    using collision_detection::CollisionRobotSBPL;
+    using collision_detection::CollisionWorldSBPL;
+
+    auto* cworld = dynamic_cast<const CollisionWorldSBPL*>(
+            m_scene->getCollisionWorld().get());
+    auto* crobot = dynamic_cast<const CollisionRobotSBPL*>(
+            m_scene->getCollisionRobotUnpadded().get());
+    auto* crobot_padded = dynamic_cast<const CollisionRobotSBPL*>(
+            m_scene->getCollisionRobot().get());
+    if (!cworld || !crobot || !crobot_padded ||
+        crobot->robotCollisionModel() != crobot_padded->robotCollisionModel())
+    {
+        ROS_DEBUG("Scene is not using the sbpl collision detector");
+        return false;
+    }
+
+    auto& rcm = crobot->robotCollisionModel();
+
+    auto jgcgit = crobot->m_jcgm_map.find(m_robot_model->planningGroupName());
+    auto& collision_group_name = jgcgit == end(crobot->m_jcgm_map) ?
+            m_robot_model->planningGroupName() : jgcgit->second;
+    if (!rcm->hasGroup(collision_group_name)) {
+        ROS_WARN("No group '%s' found in the Robot Collision Model", collision_group_name.c_str());
+        return false;
+    }
+
+    std::vector<int> var_indices;
+    var_indices.reserve(m_robot_model->planningVariableNames().size());
+    for (auto& var_name : m_robot_model->planningVariableNames()) {
+        if (!rcm->hasJointVar(var_name)) {
+            ROS_WARN("Planning variable '%s' not found in the Robot Collision Model", var_name.c_str());
+            return false;
+        }
+        var_indices.push_back(rcm->jointVarIndex(var_name));
+    }
+
+    if (!m_sbpl_path || m_sbpl_path->rcm != rcm) {
+        auto path = smpl::make_unique<SBPLCollisionPath>();
+        path->rcm = rcm;
+        if (!path->world_state.init(*m_scene->getRobotModel(), rcm) ||
+            !path->self_state.init(*m_scene->getRobotModel(), rcm))
+        {
+            ROS_WARN("Failed to initialize sbpl collision states");
+            return false;
+        }
+
+        path->self_grid = crobot->createGridFor(crobot->m_scm_config);
+        path->self_grid->setReferenceFrame(rcm->modelFrame());
+        path->scm = std::make_shared<smpl::collision::SelfCollisionModel>(
+                path->self_grid.get(),
+                rcm.get(),
+                path->self_state.attachedBodiesCollisionModel());
+        m_sbpl_path = std::move(path);
+    }
+
+    m_sbpl_path->world = cworld;
+    m_sbpl_path->var_indices = std::move(var_indices);
+    m_sbpl_path->gidx = rcm->groupIndex(collision_group_name);
+
+    m_sbpl_path->world_state.update(ref_state);
+
+    // self collisions are checked in the frame of the robot model
+    moveit::core::RobotState model_state(ref_state);
+    model_state.setJointPositions(
+            model_state.getRobotModel()->getRootJoint(),
+            Eigen::Affine3d::Identity());
+    m_sbpl_path->self_state.update(model_state);
+
+    ROS_DEBUG("Use the sbpl collision detector directly");
+    return true;
+}
+
+bool MoveItCollisionChecker::checkStateSBPL(
+    const smpl::RobotState& state,
+    bool verbose)
+{
+    auto& path = *m_sbpl_path;
+
+    assert(state.size() == path.var_indices.size());
+    auto* world_rcs = path.world_state.collisionState();
+    auto* self_rcs = path.self_state.collisionState();
+    for (size_t vidx = 0; vidx < state.size(); ++vidx) {
+        world_rcs->setJointVarPosition(path.var_indices[vidx], state[vidx]);
+        self_rcs->setJointVarPosition(path.var_indices[vidx], state[vidx]);
+    }
+
+    auto* wcm = path.world->m_wcm ?
+            path.world->m_wcm.get() : path.world->m_parent_wcm.get();
+
+    double dist;
+    if (wcm) {
+        smpl::collision::WorldCollisionDetector wcd(path.rcm.get(), wcm);
+        if (!wcd.checkCollision(
+                *world_rcs,
+                *path.world_state.attachedBodiesCollisionState(),
+                path.gidx,
+                dist))
+        {
+            ROS_INFO_COND(verbose, "world collision (dist: %f)", dist);
+            return false;
+        }
+    }
+
+    collision_detection::AllowedCollisionMatrixAndTouchLinksInterface aci(
+            m_scene->getAllowedCollisionMatrix(),
+            path.self_state.touchLinkSet());
+    if (!path.scm->checkCollision(
+            *self_rcs,
+            *path.self_state.attachedBodiesCollisionState(),
+            aci,
+            path.gidx,
+            dist))
+    {
+        ROS_INFO_COND(verbose, "self collision (dist: %f)", dist);
+        return false;
+    }
+
+    return true;
+}
+
 bool MoveItCollisionChecker::isStateToStateValid(
     const smpl::RobotState& start,
     const smpl::RobotState& finish,
@@ -231,14 +522,37 @@ auto MoveItCollisionChecker::checkInterpolatedPathCollision(
         return false;
     }
 
-    for (int widx = 0; widx < waypoint_count; ++widx) {
-        auto& p = m_waypoint_path[widx];
-        if (!isStateValid(p, false)) {
-            return false;
+    if (waypoint_count == 0) {
+        return true;
+    }
+
+    // order the waypoints as the endpoints, then the midpoints of successively
+    // finer intervals between them, so that a collision anywhere along the
+    // path is found after a few checks
+    if (m_bisection_path.size() < (size_t)waypoint_count) {
+        m_bisection_path.resize(waypoint_count);
+    }
+    auto bcount = 0;
+    m_bisection_path[bcount++] = m_waypoint_path[0];
+    if (waypoint_count > 1) {
+        m_bisection_path[bcount++] = m_waypoint_path[waypoint_count - 1];
+    }
+    m_intervals.clear();
+    m_intervals.emplace_back(0, waypoint_count - 1);
+    for (size_t i = 0; i < m_intervals.size(); ++i) {
+        auto lo = m_intervals[i].first;
+        auto hi = m_intervals[i].second;
+        if (hi - lo < 2) {
+            continue;
         }
+        auto mid = lo + (hi - lo) / 2;
+        m_bisection_path[bcount++] = m_waypoint_path[mid];
+        m_intervals.emplace_back(lo, mid);
+        m_intervals.emplace_back(mid, hi);
     }
+    assert(bcount == waypoint_count);
 
-    return true;
+    return areStatesValid(m_bisection_path.data(), bcount);
 }
 
 void MoveItCollisionChecker::setRobotStateFromState(
@@ -34,17 +34,26 @@
 #ifndef sbpl_interface_moveit_collision_checker_h
 #define sbpl_interface_moveit_collision_checker_h
 
+// standard includes
+#include <memory>
+#include <utility>
+#include <vector>
+
+// system includes
 #include <moveit/planning_scene/planning_scene.h>
 #include <moveit/robot_model/robot_model.h>
 #include <moveit/robot_state/robot_state.h>
 #include <ros/ros.h>
 #include <smpl/collision_checker.h>
+#include <smpl/worker_pool.h>
 
 namespace sbpl_interface {
 
 class MoveItRobotModel;
 
-class MoveItCollisionChecker : public smpl::CollisionChecker
+class MoveItCollisionChecker :
+    public smpl::CollisionChecker,
+    public smpl::CollisionCheckerCloneExtension
 {
 public:
 
@@ -62,6 +71,16 @@ public:
 
     bool initialized() const;
 
+    /// \brief Set the number of threads used to check batches of states
+    ///
+    /// With more than one thread, areStatesValid divides batches among the
+    /// threads, each checking with its own clone of this checker, whenever
+    /// the states are checked without a feasibility predicate or path
+    /// constraints and with a collision detector that may be queried
+    /// concurrently.
+    void setBatchThreadCount(int num_threads);
+    int batchThreadCount() const { return m_batch_thread_count; }
+
     /// \name Required Functions from Extension
     ///@{
     auto getExtension(size_t class_code) -> smpl::Extension* override;
@@ -84,8 +103,18 @@ public:
         std::vector<smpl::RobotState>& opath) override;
     ///@}
 
+    /// \name Required Functions from CollisionCheckerCloneExtension
+    ///@{
+    auto clone() -> std::unique_ptr<smpl::CollisionChecker> override;
+    ///@}
+
     /// \name Reimplemented Functions from CollisionChecker
     ///@{
+    bool areStatesValid(
+        const smpl::RobotState* states,
+        size_t n,
+        bool* out = nullptr) override;
+
     auto getCollisionModelVisualization(const smpl::RobotState& angles)
         -> std::vector<smpl::visual::Marker> override;
     ///@}
@@ -105,9 +134,40 @@ private:
 
     bool m_enabled_ccd;
 
+    // Checks states directly against the sbpl collision detector, bypassing
+    // MoveIt's RobotState and collision interfaces, when the scene uses
+    // CollisionWorldSBPL and CollisionRobotSBPL
+    struct SBPLCollisionPath;
+    std::unique_ptr<SBPLCollisionPath> m_sbpl_path;
+    bool m_enabled_sbpl_path;
+
+    // whether the scene uses CollisionWorldSBPL, whose MoveIt interface may
+    // not be queried concurrently
+    bool m_sbpl_world = false;
+
+    int m_batch_thread_count = 1;
+    std::unique_ptr<smpl::WorkerPool> m_batch_pool;
+    std::vector<std::unique_ptr<MoveItCollisionChecker>> m_batch_workers;
+    bool m_batch_workers_stale = false;
+    bool m_batch_worker = false;
+
+    // waypoints of an interpolated path in bisection order
+    std::vector<smpl::RobotState> m_bisection_path;
+    std::vector<std::pair<int, int>> m_intervals;
+
     moveit_msgs::Constraints m_path_constraints;
     bool m_has_path_constraints = false;
 
+    bool initSBPLCollisionPath(const moveit::core::RobotState& ref_state);
+    bool checkStateSBPL(const smpl::RobotState& state, bool verbose);
+
+    bool mustUpdateState() const;
+
+    bool areStatesValidParallel(
+        const smpl::RobotState* states,
+        size_t n,
+        bool* out);
+
     auto checkContinuousCollision(
         const smpl::RobotState& start,
         const smpl::RobotState& finish)
@@ -394,6 +394,14 @@ bool MoveItRobotModel::init(
     m_var_max_limits = std::move(var_max_limits);
     m_var_continuous = std::move(var_continuous);
     m_var_bounded = std::move(var_bounded);
+
+    m_var_check_min_limits.resize(m_active_var_count);
+    m_var_check_max_limits.resize(m_active_var_count);
+    for (int vidx = 0; vidx < m_active_var_count; ++vidx) {
+        auto inf = std::numeric_limits<double>::infinity();
+        m_var_check_min_limits[vidx] = m_var_bounded[vidx] ? m_var_min_limits[vidx] : -inf;
+        m_var_check_max_limits[vidx] = m_var_bounded[vidx] ? m_var_max_limits[vidx] : inf;
+    }
     m_var_vel_limits = std::move(var_vel_limits);
     m_var_acc_limits = std::move(var_acc_limits);
 
@@ -600,6 +608,34 @@ auto MoveItRobotModel::computeFK(const smpl::RobotState& state)
     return computeFK(state, m_tip_link->getName());
 }
 
+void MoveItRobotModel::computeFKBatch(
+    const double* states,
+    int n,
+    Eigen::Affine3d* poses)
+{
+    assert(initialized());
+    assert(m_tip_link);
+
+    // look up the planning frame transform once for the whole batch
+    Eigen::Affine3d T_planning_model(Eigen::Affine3d::Identity());
+    if (!transformToPlanningFrame(T_planning_model)) {
+        for (int i = 0; i < n; ++i) {
+            poses[i] = Eigen::Affine3d::Identity(); // errors printed within
+        }
+        return;
+    }
+
+    for (int i = 0; i < n; ++i) {
+        auto* state = states + i * m_active_var_count;
+        for (int vind = 0; vind < m_active_var_count; ++vind) {
+            m_robot_state->setVariablePosition(
+                    m_active_var_indices[vind], state[vind]);
+        }
+        m_robot_state->updateLinkTransforms();
+        poses[i] = T_planning_model * m_robot_state->getGlobalLinkTransform(m_tip_link);
+    }
+}
+
 bool MoveItRobotModel::computeIK(
     const Eigen::Affine3d& pose,
     const smpl::RobotState& start,
@@ -716,6 +752,16 @@ bool MoveItRobotModel::checkJointLimits(
 
     assert(state.size() == m_active_var_count);
 
+    if (smpl::within_limits(
+            state.data(),
+            m_var_check_min_limits.data(),
+            m_var_check_max_limits.data(),
+            m_active_var_count))
+    {
+        return true;
+    }
+
+    // find the offending variable
     for (int vidx = 0; vidx < activeVariableCount(); ++vidx) {
         if (m_var_bounded[vidx]) {
             if ((state[vidx] < m_var_min_limits[vidx]) |
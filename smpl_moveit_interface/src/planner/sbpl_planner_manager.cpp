@@ -550,40 +550,29 @@ bool LoadPlannerConfigurationMapping(
     return true;
 }
 
-// retrive an already-initialized model for a given group
-auto GetModelForGroup(
+// build a robot model for a group, for exclusive use by one planning context
+auto CreateModelForGroup(
     SBPLPlannerManager* manager,
     const std::string& group_name)
-    -> MoveItRobotModel*
+    -> std::unique_ptr<MoveItRobotModel>
 {
-    auto it = manager->m_sbpl_models.find(group_name);
-    if (it != end(manager->m_sbpl_models)) {
-        ROS_DEBUG_NAMED(PP_LOGGER, "Use existing SBPL Robot Model for group '%s'", group_name.c_str());
-        return it->second.get();
-    }
-
     auto model = smpl::make_unique<MoveItRobotModel>();
     if (!model->init(manager->m_robot_model, group_name)) {
         ROS_WARN_NAMED(PP_LOGGER, "Failed to initialize SBPL Robot Model");
-        return NULL;
+        return nullptr;
     }
 
     ROS_INFO_NAMED(PP_LOGGER, "Created SBPL Robot Model for group '%s'", group_name.c_str());
-    auto ent = manager->m_sbpl_models.insert(std::make_pair(group_name, std::move(model)));
-    return ent.first->second.get();
+    return model;
 }
 
-auto GetPlanningContextForPlanner(
+auto CreatePlanningContext(
     SBPLPlannerManager* manager,
     MoveItRobotModel* model,
     const std::string& planner_id)
     -> SBPLPlanningContextPtr
 {
     SBPLPlanningContextPtr null_context;
-    auto it = manager->m_contexts.find(planner_id);
-    if (it != end(manager->m_contexts)) {
-        return it->second;
-    }
 
     auto context = SBPLPlanningContextPtr(new SBPLPlanningContext(
             model, "sbpl_planning_context", model->planningGroupName()));
@@ -610,10 +599,44 @@ auto GetPlanningContextForPlanner(
         return null_context;
     }
 
-    manager->m_contexts.insert(std::make_pair(planner_id, context));
     return context;
 }
 
+// Retrieve an idle, initialized context for a group + planner_id from the
+// pool, or create and pool a new one if all of them are in use. A pooled
+// context is idle when the pool holds the only reference to it.
+auto AcquirePlanningContext(
+    SBPLPlannerManager* manager,
+    const std::string& group_name,
+    const std::string& planner_id)
+    -> SBPLPlanningContextPtr
+{
+    std::lock_guard<std::mutex> lock(manager->m_context_pool_mutex);
+
+    auto& contexts = manager->m_context_pool[std::make_pair(group_name, planner_id)];
+    for (auto& pc : contexts) {
+        if (pc.context.use_count() == 1) {
+            ROS_DEBUG_NAMED(PP_LOGGER, "Use pooled SBPL Planning Context for group '%s' and planner '%s'", group_name.c_str(), planner_id.c_str());
+            return pc.context;
+        }
+    }
+
+    SBPLPlannerManager::PooledContext pc;
+    pc.model = CreateModelForGroup(manager, group_name);
+    if (!pc.model) {
+        return SBPLPlanningContextPtr();
+    }
+
+    pc.context = CreatePlanningContext(manager, pc.model.get(), planner_id);
+    if (!pc.context) {
+        return SBPLPlanningContextPtr();
+    }
+
+    ROS_INFO_NAMED(PP_LOGGER, "Pool SBPL Planning Context %zu for group '%s' and planner '%s'", contexts.size(), group_name.c_str(), planner_id.c_str());
+    contexts.push_back(std::move(pc));
+    return contexts.back().context;
+}
+
 auto SelectPlanningLink(
     const SBPLPlannerManager* manager,
     const MotionPlanRequest& req)
@@ -655,16 +678,17 @@ auto SelectPlanningLink(
 SBPLPlannerManager::SBPLPlannerManager() :
     Base(),
     m_robot_model(),
-    m_viz()
+    m_viz(),
+    m_async_viz(&m_viz)
 {
     ROS_DEBUG_NAMED(PP_LOGGER, "Constructed SBPL Planner Manager");
-    smpl::viz::set_visualizer(&m_viz);
+    smpl::viz::set_visualizer(&m_async_viz);
 }
 
 SBPLPlannerManager::~SBPLPlannerManager()
 {
     ROS_DEBUG_NAMED(PP_LOGGER, "Destructed SBPL Planner Manager");
-    if (smpl::viz::visualizer() == &m_viz) {
+    if (smpl::viz::visualizer() == &m_async_viz) {
         smpl::viz::unset_visualizer();
     }
 }
@@ -730,16 +754,24 @@ auto SBPLPlannerManager::getPlanningContext(
         return null_context;
     }
 
+    auto* mutable_me = const_cast<SBPLPlannerManager*>(this);
+
+    /////////////////////////////////////////////
+    // Initialize/Update SBPL Planning Context //
+    /////////////////////////////////////////////
+
+    auto sbpl_context = AcquirePlanningContext(
+            mutable_me, req.group_name, req.planner_id);
+    if (!sbpl_context) {
+        ROS_WARN_NAMED(PP_LOGGER, "No SBPL Planning Context available for group '%s'", req.group_name.c_str());
+        return null_context;
+    }
+
     ////////////////////////////////////////
     // Initialize/Update SBPL Robot Model //
     ////////////////////////////////////////
 
-    auto* mutable_me = const_cast<SBPLPlannerManager*>(this);
-    auto* sbpl_model = GetModelForGroup(mutable_me, req.group_name);
-    if (!sbpl_model) {
-        ROS_WARN_NAMED(PP_LOGGER, "No SBPL Robot Model available for group '%s'", req.group_name.c_str());
-        return null_context;
-    }
+    auto* sbpl_model = sbpl_context->m_robot_model;
 
     auto planning_link = SelectPlanningLink(this, req);
     if (planning_link.empty()) {
@@ -761,17 +793,10 @@ auto SBPLPlannerManager::getPlanningContext(
         return null_context;
     }
 
-    /////////////////////////////////////////////
-    // Initialize/Update SBPL Planning Context //
-    /////////////////////////////////////////////
-
 #if 0
     LogPlanningScene(*planning_scene);
 #endif
 
-    auto sbpl_context = GetPlanningContextForPlanner(
-            mutable_me, sbpl_model, req.planner_id);
-
     sbpl_context->setPlanningScene(planning_scene);
     sbpl_context->setMotionPlanRequest(req);
 
@@ -855,6 +880,12 @@ void SBPLPlannerManager::setPlannerConfigurations(
 {
     Base::setPlannerConfigurations(pcs);
 
+    // pooled contexts were initialized with the previous configurations
+    {
+        std::lock_guard<std::mutex> lock(m_context_pool_mutex);
+        m_context_pool.clear();
+    }
+
     ROS_DEBUG_NAMED(PP_LOGGER, "Planner Configurations");
     for (auto& entry : pcs) {
         ROS_DEBUG_NAMED(PP_LOGGER, "  %s: { name: %s, group: %s }", entry.first.c_str(), entry.second.name.c_str(), entry.second.group.c_str());
@@ -1,10 +1,19 @@
 #ifndef sbpl_interface_sbpl_planner_manager_h
 #define sbpl_interface_sbpl_planner_manager_h
 
+// standard includes
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
 // system includes
 #include <XmlRpcValue.h>
 #include <moveit/macros/class_forward.h>
 #include <moveit/planning_interface/planning_interface.h>
+#include <smpl/debug/async_visualizer.h>
 #include <smpl/debug/visualizer_ros.h>
 
 // project includes
@@ -61,15 +70,25 @@ public:
 
     moveit::core::RobotModelConstPtr m_robot_model;
 
-    // per-group sbpl robot model
-    // TODO: make unique per context instance
-    std::map<std::string, std::unique_ptr<MoveItRobotModel>> m_sbpl_models;
+    // A preinitialized planning context and the robot model it plans for
+    struct PooledContext
+    {
+        std::unique_ptr<MoveItRobotModel> model;
+        SBPLPlanningContextPtr context;
+    };
 
-    // per-configuration context
-    std::map<std::string, SBPLPlanningContextPtr> m_contexts;
+    // Pool of contexts per (group, planner id). A context stays in use until
+    // every reference handed out by getPlanningContext() is released. The
+    // pool is cleared when the planner configurations change, so contexts
+    // must not outlive a call to setPlannerConfigurations().
+    std::map<std::pair<std::string, std::string>, std::vector<PooledContext>> m_context_pool;
+    std::mutex m_context_pool_mutex;
 
     smpl::VisualizerROS m_viz;
 
+    // publishes markers to m_viz off of the planning threads
+    smpl::visual::AsyncVisualizer m_async_viz;
+
     PlannerConfigurationMap map;
 };
 
@@ -2,6 +2,7 @@
 
 // standard includes
 #include <chrono>
+#include <thread>
 
 // system includes
 #include <moveit/collision_detection/world.h>
@@ -133,13 +134,13 @@ void CopyDistanceField(
     const smpl::DistanceMapInterface& dfin,
     smpl::DistanceMapInterface& dfout);
 
+// Return whether the scene or workspace differ from those of the previous
+// request, which invalidates the grid and everything derived from it
 static
-auto UpdateOrCreateGrid(
-    SBPLPlanningContext* context,
-    std::unique_ptr<smpl::OccupancyGrid> grid,
+bool SceneOrWorkspaceChanged(
+    const SBPLPlanningContext* context,
     const planning_scene::PlanningSceneConstPtr& scene,
     const moveit_msgs::WorkspaceParameters& workspace)
-    -> std::unique_ptr<smpl::OccupancyGrid>
 {
     // TODO: transforms may have changed that reposition the workspace within
     // the planning frame
@@ -152,7 +153,18 @@ auto UpdateOrCreateGrid(
             workspace.max_corner.y != context->m_prev_workspace.max_corner.y ||
             workspace.max_corner.z != context->m_prev_workspace.max_corner.z;
 
-    if (scene != context->m_prev_scene || workspace_diff) {
+    return scene != context->m_prev_scene || workspace_diff;
+}
+
+static
+auto UpdateOrCreateGrid(
+    SBPLPlanningContext* context,
+    std::unique_ptr<smpl::OccupancyGrid> grid,
+    const planning_scene::PlanningSceneConstPtr& scene,
+    const moveit_msgs::WorkspaceParameters& workspace)
+    -> std::unique_ptr<smpl::OccupancyGrid>
+{
+    if (SceneOrWorkspaceChanged(context, scene, workspace)) {
         ROS_DEBUG_NAMED(PP_LOGGER, "   -> Scene or workspace changed (scene: %p -> %p)", context->m_prev_scene.get(), scene.get());
         {
             auto g = std::move(grid); // for lack of a swap or destroy
@@ -293,7 +305,12 @@ bool InitPlanningParams(
     //////////////////////////////////////////////
 
     for (auto& entry : config) {
-        pp->addParam(entry.first, entry.second);
+        try {
+            pp->addParam(entry.first, entry.second);
+        } catch (const smpl::ParameterException& ex) {
+            ROS_ERROR_NAMED(PP_LOGGER, "%s", ex.what());
+            return false;
+        }
     }
 
     return true;
@@ -539,18 +556,24 @@ auto CreateHeuristicGrid(
     std::vector<std::unique_ptr<smpl::collision::CollisionObject>> collision_objects;
     smpl::collision::WorldCollisionModel cmodel(grid.get());
 
-    // insert world objects into the collision model
+    // insert world objects into the collision model, voxelizing them in
+    // parallel with a single update of the distance field
     auto& world = cworld->getWorld();
     if (world) {
-        int insert_count = 0;
+        std::vector<const smpl::collision::CollisionObject*> objects;
         for (auto oit = world->begin(); oit != world->end(); ++oit) {
-
             collision_objects.push_back(std::unique_ptr<smpl::collision::CollisionObject>());
             ConvertObjectToCollisionObjectShallow(oit->second, shapes, collision_objects.back());
-            auto& collision_object = collision_objects.back();
+            objects.push_back(collision_objects.back().get());
+        }
+
+        cmodel.setVoxelizeThreadCount(std::thread::hardware_concurrency());
+        cmodel.insertObjects(objects.data(), objects.size());
 
-            if (!cmodel.insertObject(collision_object.get())) {
-                ROS_WARN_NAMED(PP_LOGGER, "Failed to insert object '%s' into heuristic grid", oit->first.c_str());
+        int insert_count = 0;
+        for (auto* object : objects) {
+            if (!cmodel.hasObject(object)) {
+                ROS_WARN_NAMED(PP_LOGGER, "Failed to insert object '%s' into heuristic grid", object->id.c_str());
             } else {
                 ++insert_count;
             }
@@ -603,10 +626,19 @@ bool UpdatePlanner(
 {
     ROS_DEBUG_NAMED(PP_LOGGER, "Update planner");
 
+    // the planner interface, and the heuristics it derives from the grid, can
+    // be kept when planning in the same scene and workspace as the previous
+    // request
+    auto reuse_planner = context->m_planner &&
+            !SceneOrWorkspaceChanged(context, scene, workspace);
+
     // Update the collision checker interface to use the complete start state
-    // as the reference state
+    // as the reference state. The checker is reinitialized in place, since the
+    // planner interface refers to it.
     ROS_DEBUG_NAMED(PP_LOGGER, " -> Initialize collision checker interface");
-    context->m_collision_checker = smpl::make_unique<MoveItCollisionChecker>();
+    if (!context->m_collision_checker) {
+        context->m_collision_checker = smpl::make_unique<MoveItCollisionChecker>();
+    }
     if (!context->m_collision_checker->init(context->m_robot_model, start_state, scene)) {
         ROS_WARN_NAMED(PP_LOGGER, "Failed to initialize collision checker interface");
         return false;
@@ -622,16 +654,22 @@ bool UpdatePlanner(
         context->m_grid = UpdateOrCreateGrid(context, std::move(context->m_grid), scene, workspace);
         if (!context->m_grid) {
             ROS_WARN_NAMED(PP_LOGGER, "Failed to update or create grid");
+            context->m_planner.reset(); // refers to the discarded grid
             return false;
         }
     }
 
-    ROS_DEBUG_NAMED(PP_LOGGER, " -> Initialize planner interface");
-    context->m_planner = smpl::make_unique<smpl::PlannerInterface>(
-            context->m_robot_model, context->m_collision_checker.get(), context->m_grid.get());
-    if (!context->m_planner->init(context->m_pp)) {
-        ROS_WARN_NAMED(PP_LOGGER, "Failed to initialize planner interface");
-        return false;
+    if (reuse_planner) {
+        ROS_DEBUG_NAMED(PP_LOGGER, " -> Reuse planner interface");
+    } else {
+        ROS_DEBUG_NAMED(PP_LOGGER, " -> Initialize planner interface");
+        context->m_planner = smpl::make_unique<smpl::PlannerInterface>(
+                context->m_robot_model, context->m_collision_checker.get(), context->m_grid.get());
+        if (!context->m_planner->init(context->m_pp)) {
+            ROS_WARN_NAMED(PP_LOGGER, "Failed to initialize planner interface");
+            context->m_planner.reset();
+            return false;
+        }
     }
 
     context->m_prev_scene = scene;
@@ -770,6 +808,9 @@ bool SBPLPlanningContext::solve(
 bool SBPLPlanningContext::terminate()
 {
     ROS_INFO_NAMED(PP_LOGGER, "SBPLPlanningContext::terminate()");
+    if (m_planner) {
+        m_planner->cancel();
+    }
     return true;
 }
 
@@ -0,0 +1,85 @@
+#ifndef SMPL_OMPL_INTERFACE_COLLISION_CHECKING_H
+#define SMPL_OMPL_INTERFACE_COLLISION_CHECKING_H
+
+// standard includes
+#include <utility>
+
+// system includes
+#include <ompl/base/MotionValidator.h>
+#include <ompl/base/SpaceInformation.h>
+#include <ompl/base/StateValidityChecker.h>
+
+namespace smpl {
+
+class CollisionChecker;
+
+/// \brief An OMPL state validity checker backed by an SMPL collision checker
+///
+/// Lets OMPL planners validate states with the same collision checker used by
+/// SMPL searches. If the collision checker provides CollisionDistanceExtension,
+/// clearance() reports the distance to the nearest obstacle.
+class StateValidityChecker : public ompl::base::StateValidityChecker
+{
+public:
+
+    StateValidityChecker(
+        const ompl::base::SpaceInformationPtr& si,
+        CollisionChecker* checker);
+
+    bool isValid(const ompl::base::State* state) const override;
+
+    double clearance(const ompl::base::State* state) const override;
+
+    /// \brief Return whether a set of states are all valid, checking them as
+    ///     one batch with CollisionChecker::areStatesValid
+    /// \param[out] out If non-null, out[i] is set to whether states[i] is valid
+    bool areStatesValid(
+        const ompl::base::State* const* states,
+        std::size_t n,
+        bool* out = nullptr) const;
+
+    auto collisionChecker() const -> CollisionChecker* { return m_checker; }
+
+private:
+
+    CollisionChecker* m_checker;
+};
+
+/// \brief An OMPL motion validator backed by an SMPL collision checker
+///
+/// checkMotion(s1, s2) defers to CollisionChecker::isStateToStateValid, so it
+/// uses whatever motion checking strategy the collision checker is configured
+/// with (e.g. conservative advancement in CollisionSpace). The variant that
+/// reports the last valid state interpolates the motion with
+/// CollisionChecker::interpolatePath and checks the waypoints as one batch.
+class MotionValidator : public ompl::base::MotionValidator
+{
+public:
+
+    MotionValidator(
+        const ompl::base::SpaceInformationPtr& si,
+        CollisionChecker* checker);
+
+    bool checkMotion(
+        const ompl::base::State* s1,
+        const ompl::base::State* s2) const override;
+
+    bool checkMotion(
+        const ompl::base::State* s1,
+        const ompl::base::State* s2,
+        std::pair<ompl::base::State*, double>& last_valid) const override;
+
+private:
+
+    CollisionChecker* m_checker;
+};
+
+/// Set the state validity checker and motion validator of a space information
+/// to ones backed by an SMPL collision checker.
+void SetCollisionChecker(
+    const ompl::base::SpaceInformationPtr& si,
+    CollisionChecker* checker);
+
+} // namespace smpl
+
+#endif
@@ -0,0 +1,141 @@
+#include <smpl_ompl_interface/collision_checking.h>
+
+// standard includes
+#include <memory>
+#include <vector>
+
+// project includes
+#include <smpl/collision_checker.h>
+#include <smpl/console/console.h>
+#include <smpl_ompl_interface/ompl_interface.h>
+
+namespace smpl {
+
+StateValidityChecker::StateValidityChecker(
+    const ompl::base::SpaceInformationPtr& si,
+    CollisionChecker* checker)
+:
+    ompl::base::StateValidityChecker(si),
+    m_checker(checker)
+{
+    if (m_checker->getExtension<CollisionDistanceExtension>() != NULL) {
+        specs_.clearanceComputationType =
+                ompl::base::StateValidityCheckerSpecs::EXACT;
+    }
+}
+
+bool StateValidityChecker::isValid(const ompl::base::State* state) const
+{
+    auto s = MakeStateSMPL(si_->getStateSpace().get(), state);
+    return m_checker->isStateValid(s);
+}
+
+double StateValidityChecker::clearance(const ompl::base::State* state) const
+{
+    auto* cdist = m_checker->getExtension<CollisionDistanceExtension>();
+    if (cdist == NULL) {
+        return ompl::base::StateValidityChecker::clearance(state);
+    }
+    auto s = MakeStateSMPL(si_->getStateSpace().get(), state);
+    return cdist->distanceToCollision(s);
+}
+
+bool StateValidityChecker::areStatesValid(
+    const ompl::base::State* const* states,
+    std::size_t n,
+    bool* out) const
+{
+    std::vector<RobotState> batch(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        batch[i] = MakeStateSMPL(si_->getStateSpace().get(), states[i]);
+    }
+    return m_checker->areStatesValid(batch.data(), batch.size(), out);
+}
+
+MotionValidator::MotionValidator(
+    const ompl::base::SpaceInformationPtr& si,
+    CollisionChecker* checker)
+:
+    ompl::base::MotionValidator(si),
+    m_checker(checker)
+{
+}
+
+bool MotionValidator::checkMotion(
+    const ompl::base::State* s1,
+    const ompl::base::State* s2) const
+{
+    auto* space = si_->getStateSpace().get();
+    auto valid = m_checker->isStateToStateValid(
+            MakeStateSMPL(space, s1), MakeStateSMPL(space, s2));
+    if (valid) {
+        ++valid_;
+    } else {
+        ++invalid_;
+    }
+    return valid;
+}
+
+bool MotionValidator::checkMotion(
+    const ompl::base::State* s1,
+    const ompl::base::State* s2,
+    std::pair<ompl::base::State*, double>& last_valid) const
+{
+    auto* space = si_->getStateSpace().get();
+
+    std::vector<RobotState> path;
+    if (!m_checker->interpolatePath(
+            MakeStateSMPL(space, s1), MakeStateSMPL(space, s2), path) ||
+        path.empty())
+    {
+        SMPL_WARN("Failed to interpolate motion");
+        last_valid.second = 0.0;
+        if (last_valid.first != NULL) {
+            space->copyState(last_valid.first, s1);
+        }
+        ++invalid_;
+        return false;
+    }
+
+    std::unique_ptr<bool[]> waypoint_valid(new bool[path.size()]);
+    if (m_checker->areStatesValid(path.data(), path.size(), waypoint_valid.get())) {
+        ++valid_;
+        return true;
+    }
+
+    // the waypoints are checked in order of increasing distance from s1, so
+    // the motion is valid up to the waypoint preceding the first invalid one
+    std::size_t first_invalid = 0;
+    while (waypoint_valid[first_invalid]) {
+        ++first_invalid;
+    }
+
+    if (first_invalid == 0) {
+        last_valid.second = 0.0;
+        if (last_valid.first != NULL) {
+            space->copyState(last_valid.first, s1);
+        }
+    } else {
+        last_valid.second = path.size() > 1
+                ? (double)(first_invalid - 1) / (double)(path.size() - 1)
+                : 0.0;
+        if (last_valid.first != NULL) {
+            space->copyFromReals(last_valid.first, path[first_invalid - 1]);
+        }
+    }
+
+    ++invalid_;
+    return false;
+}
+
+void SetCollisionChecker(
+    const ompl::base::SpaceInformationPtr& si,
+    CollisionChecker* checker)
+{
+    si->setStateValidityChecker(ompl::base::StateValidityCheckerPtr(
+            new StateValidityChecker(si, checker)));
+    si->setMotionValidator(ompl::base::MotionValidatorPtr(
+            new MotionValidator(si, checker)));
+}
+
+} // namespace smpl
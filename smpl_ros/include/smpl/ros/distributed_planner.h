@@ -0,0 +1,173 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_ROS_DISTRIBUTED_PLANNER_H
+#define SMPL_ROS_DISTRIBUTED_PLANNER_H
+
+// standard includes
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+// system includes
+#include <moveit_msgs/MotionPlanRequest.h>
+#include <moveit_msgs/MotionPlanResponse.h>
+#include <moveit_msgs/PlanningScene.h>
+
+// project includes
+#include <smpl/distance_map/distance_map_interface.h>
+#include <smpl/occupancy_grid.h>
+#include <smpl/ros/planner_interface.h>
+
+namespace smpl {
+
+/// \brief Write a snapshot of a distance map, in the serialized distance map
+///     format, to a file.
+///
+/// Supports the dense distance maps and SparseDistanceMap.
+bool SaveDistanceMapSnapshot(
+    const DistanceMapInterface& dmap,
+    const std::string& path);
+
+/// \brief Restore a distance map from a snapshot written by
+///     SaveDistanceMapSnapshot() for a distance map of the same type and
+///     geometry.
+bool LoadDistanceMapSnapshot(DistanceMapInterface& dmap, const std::string& path);
+
+/// \brief Serves planning jobs from DistributedPlanner clients with a planner
+///     interface.
+///
+/// Each job carries a planning scene, a request, whose planner id selects the
+/// pipeline run on this host, and optionally a snapshot of the world's
+/// distance map, which replaces the distance field of the occupancy grid
+/// before the request is solved. Jobs are served one at a time; a client that
+/// sends a cancel message or disconnects cancels its job.
+///
+/// A loaded snapshot does not advance the collision checker's world version,
+/// so hosts that receive snapshots should run with the result cache disabled.
+class PlannerHostServer
+{
+public:
+
+    /// \p planner and \p grid must outlive the server. \p grid may be null if
+    /// jobs will not carry snapshots.
+    PlannerHostServer(PlannerInterface* planner, OccupancyGrid* grid);
+    ~PlannerHostServer();
+
+    PlannerHostServer(const PlannerHostServer&) = delete;
+    PlannerHostServer& operator=(const PlannerHostServer&) = delete;
+
+    /// \brief Start serving on a port of all interfaces.
+    bool start(int port);
+
+    /// \brief Stop serving, cancelling any job in progress, and wait for the
+    ///     server thread to exit.
+    void stop();
+
+    /// \brief Return the port being served, or 0 if not serving.
+    int port() const { return m_port; }
+
+private:
+
+    PlannerInterface* m_planner;
+    OccupancyGrid* m_grid;
+
+    int m_listen_fd;
+    int m_port;
+    std::atomic<bool> m_running;
+    std::thread m_server;
+
+    void serve();
+    void serveJob(int fd);
+};
+
+struct PlannerHost
+{
+    std::string address;
+    int port = 0;
+
+    /// The planner id the host plans with. If empty, the host plans with the
+    /// planner id of the request.
+    std::string planner_id;
+};
+
+/// \brief Solves a request on several planner hosts at once and takes the
+///     first solution found.
+///
+/// This is the portfolio planner spread across processes or machines: every
+/// host receives the same scene, request, and world snapshot, but plans with
+/// its own planner id. Once a host returns a solution, the jobs of the
+/// remaining hosts are cancelled. Hosts that cannot be reached are skipped.
+class DistributedPlanner
+{
+public:
+
+    DistributedPlanner();
+
+    void addHost(const PlannerHost& host);
+    auto hosts() const -> const std::vector<PlannerHost>& { return m_hosts; }
+
+    /// \brief Set how long to wait, beyond the allowed planning time of the
+    ///     request, for hosts to respond. Default 5 seconds.
+    void setResponseGracePeriod(double seconds) { m_grace_period = seconds; }
+
+    /// \brief Solve a request on every host.
+    ///
+    /// If \p world is not null, a snapshot of it is sent with the request
+    /// and planned in by each host. If no host finds a solution, \p res is
+    /// the last response received, if any.
+    ///
+    /// \param winner If not null, set to the index of the host whose solution
+    ///     was taken, or -1 if none
+    /// \return true if a host found a solution; false otherwise
+    bool solve(
+        const moveit_msgs::PlanningScene& planning_scene,
+        const moveit_msgs::MotionPlanRequest& req,
+        const DistanceMapInterface* world,
+        moveit_msgs::MotionPlanResponse& res,
+        int* winner = nullptr);
+
+    /// \brief Stop the request being solved, cancelling every host's job.
+    ///
+    /// May be called from any thread while solve() runs.
+    void cancel() { m_cancelled = true; }
+
+private:
+
+    std::vector<PlannerHost> m_hosts;
+    double m_grace_period;
+    std::atomic<bool> m_cancelled;
+};
+
+} // namespace smpl
+
+#endif
@@ -76,6 +76,18 @@ auto MakeBFSHeuristic(
     const OccupancyGrid* grid)
     -> std::unique_ptr<RobotHeuristic>;
 
+auto MakePoseBFSHeuristic(
+    RobotPlanningSpace* space,
+    const PlanningParams& params,
+    const OccupancyGrid* grid)
+    -> std::unique_ptr<RobotHeuristic>;
+
+auto MakeSoftBFSHeuristic(
+    RobotPlanningSpace* space,
+    const PlanningParams& params,
+    const OccupancyGrid* grid)
+    -> std::unique_ptr<RobotHeuristic>;
+
 auto MakeEuclidDistHeuristic(
     RobotPlanningSpace* space,
     const PlanningParams& params)
@@ -86,6 +98,11 @@ auto MakeJointDistHeuristic(
     const PlanningParams& params)
     -> std::unique_ptr<RobotHeuristic>;
 
+auto MakeDubinsHeuristic(
+    RobotPlanningSpace* space,
+    const PlanningParams& params)
+    -> std::unique_ptr<RobotHeuristic>;
+
 auto MakeDijkstraEgraphHeuristic3D(
     RobotPlanningSpace* space,
     const PlanningParams& params,
@@ -113,6 +130,12 @@ auto MakeAWAStar(
     const PlanningParams& params)
     -> std::unique_ptr<SBPLPlanner>;
 
+auto MakeANAStar(
+    RobotPlanningSpace* space,
+    RobotHeuristic* heuristic,
+    const PlanningParams& params)
+    -> std::unique_ptr<SBPLPlanner>;
+
 auto MakeMHAStar(
     RobotPlanningSpace* space,
     RobotHeuristic* heuristic,
@@ -137,6 +160,24 @@ auto MakePADAStar(
     const PlanningParams& params)
     -> std::unique_ptr<SBPLPlanner>;
 
+auto MakePASE(
+    RobotPlanningSpace* space,
+    RobotHeuristic* heuristic,
+    const PlanningParams& params)
+    -> std::unique_ptr<SBPLPlanner>;
+
+auto MakeLPAStar(
+    RobotPlanningSpace* space,
+    RobotHeuristic* heuristic,
+    const PlanningParams& params)
+    -> std::unique_ptr<SBPLPlanner>;
+
+auto MakeBidirectionalWAStar(
+    RobotPlanningSpace* space,
+    RobotHeuristic* heuristic,
+    const PlanningParams& params)
+    -> std::unique_ptr<SBPLPlanner>;
+
 } // namespace smpl
 
 #endif
@@ -0,0 +1,148 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_ROS_METRICS_EXPORTER_H
+#define SMPL_ROS_METRICS_EXPORTER_H
+
+// standard includes
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace smpl {
+
+/// The planner components whose memory usage is reported with each request
+enum class MemoryComponent
+{
+    PlanningSpace = 0,
+    Heuristic,
+    Search,
+    CollisionChecker,
+    DistanceMap,
+    Count
+};
+
+auto to_cstring(MemoryComponent component) -> const char*;
+
+static const int MemoryComponentCount = (int)MemoryComponent::Count;
+
+/// \brief Serves cumulative planner metrics over HTTP, in the Prometheus text
+///     exposition format.
+///
+/// The hot-path event counts and times, including cache hits and misses, are
+/// read from the telemetry registry when the endpoint is scraped. Planner
+/// interfaces report the latency and outcome of each request, and the memory
+/// held by their components, by planner id. Reports are relaxed atomic
+/// updates and scrapes only read, so serving the endpoint never waits on
+/// planning.
+///
+/// Up to MaxPlannerCount distinct planner ids are tracked; requests for
+/// further planner ids are not reported.
+class MetricsExporter
+{
+public:
+
+    static const int MaxPlannerCount = 32;
+
+    MetricsExporter();
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    /// \brief Start serving on a port of all interfaces.
+    bool start(int port);
+
+    /// \brief Stop serving and wait for the server thread to exit.
+    void stop();
+
+    /// \brief Return the port being served, or 0 if not serving.
+    int port() const { return m_port; }
+
+    void recordRequest(const std::string& planner_id, double seconds, bool solved);
+
+    void recordMemoryUsage(
+        const std::string& planner_id,
+        MemoryComponent component,
+        std::size_t bytes);
+
+    /// \brief Return the current value of every series.
+    auto render() const -> std::string;
+
+private:
+
+    // upper bounds, in seconds, of the request latency buckets, followed by
+    // an unbounded bucket
+    static const int LatencyBoundCount = 13;
+    static const double LatencyBounds[LatencyBoundCount];
+
+    struct PlannerSeries
+    {
+        std::string planner_id;
+        std::atomic<std::uint64_t> solved;
+        std::atomic<std::uint64_t> failed;
+
+        // counts per latency bucket, not cumulative, with the last bucket
+        // counting the requests beyond the last bound
+        std::atomic<std::uint64_t> latency_buckets[LatencyBoundCount + 1];
+        std::atomic<std::uint64_t> latency_ns;
+
+        // bytes held by each component after the latest request
+        std::atomic<std::uint64_t> memory[MemoryComponentCount];
+
+        PlannerSeries();
+    };
+
+    PlannerSeries m_planners[MaxPlannerCount];
+
+    // series [0, m_planner_count) are published and their ids immutable.
+    // writers publish new series under the mutex; the server thread never
+    // takes it
+    std::atomic<int> m_planner_count;
+    std::mutex m_register_mutex;
+
+    int m_listen_fd;
+    int m_port;
+    std::atomic<bool> m_running;
+    std::thread m_server;
+
+    auto plannerSeries(const std::string& planner_id) -> PlannerSeries*;
+
+    void serve();
+    void respond(int fd) const;
+};
+
+} // namespace smpl
+
+#endif
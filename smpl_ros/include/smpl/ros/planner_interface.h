@@ -34,8 +34,14 @@
 #define SMPL_PLANNER_INTERFACE_H
 
 // standard includes
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -51,14 +57,21 @@
 #include <visualization_msgs/MarkerArray.h>
 
 // project includes
+#include <smpl/cancellation.h>
 #include <smpl/collision_checker.h>
 #include <smpl/forward.h>
+#include <smpl/motion_validity_cache.h>
 #include <smpl/occupancy_grid.h>
 #include <smpl/planning_params.h>
+#include <smpl/reachability_map.h>
 #include <smpl/robot_model.h>
+#include <smpl/telemetry.h>
+#include <smpl/worker_pool.h>
 #include <smpl/debug/marker.h>
 #include <smpl/graph/robot_planning_space.h>
+#include <smpl/heuristic/bfs_heuristic.h>
 #include <smpl/heuristic/robot_heuristic.h>
+#include <smpl/ros/metrics_exporter.h>
 
 class SBPLPlanner;
 
@@ -78,6 +91,9 @@ using PlannerFactory = std::function<
 
 using GoalConstraints = std::vector<moveit_msgs::Constraints>;
 
+/// Receives the smoothed first waypoints of a path, ahead of the rest.
+using PathPrefixCallback = std::function<void(const std::vector<RobotState>&)>;
+
 class PlannerInterface
 {
 public:
@@ -96,11 +112,67 @@ public:
         const moveit_msgs::MotionPlanRequest& req,
         moveit_msgs::MotionPlanResponse& res);
 
+    /// \brief Solve a batch of independent requests concurrently.
+    ///
+    /// The requests are dispatched to batch_threads workers, in order of
+    /// their index as workers become free. The first worker is this
+    /// interface; each other worker is an interface of its own, planning with
+    /// clones of the robot model and collision checker over the shared
+    /// occupancy grid, and keeps its pipelines between batches. Without a
+    /// robot model that provides RobotModelCloneExtension, or a collision
+    /// checker that provides CollisionCheckerCloneExtension, the requests are
+    /// solved one after another by this interface.
+    ///
+    /// The response to the i'th request is stored in \p res[i] and, if
+    /// \p stats is not null, the statistics of its planner, as returned by
+    /// getPlannerStats(), in (*stats)[i]. The telemetry statistics count the
+    /// events of every worker. The path prefix callback is not invoked.
+    ///
+    /// \return true if every request was solved; false otherwise
+    bool solveBatch(
+        const moveit_msgs::PlanningScene& planning_scene,
+        const std::vector<moveit_msgs::MotionPlanRequest>& reqs,
+        std::vector<moveit_msgs::MotionPlanResponse>& res,
+        std::vector<std::map<std::string, double>>* stats = nullptr);
+
     static
     bool SupportsGoalConstraints(
         const GoalConstraints& constraints,
         std::string& why);
 
+    /// \brief Set a callback to receive the beginning of each path early.
+    ///
+    /// When the stream_waypoint_count parameter is positive and a path has
+    /// more waypoints than that, solve() post-processes the path up to that
+    /// waypoint first and passes the result to the callback, before
+    /// post-processing the remainder. The trajectory returned by solve()
+    /// begins with exactly the waypoints passed to the callback. The callback
+    /// runs on the thread calling solve() and should return quickly.
+    void setPathPrefixCallback(PathPrefixCallback callback);
+
+    /// \brief Add a planning context for a member of the planner portfolio.
+    ///
+    /// With the portfolio parameter set to a space-separated list of planner
+    /// ids, requests with the planner id "portfolio" run a pipeline for each
+    /// listed planner id concurrently and return the first valid solution
+    /// found. The first member plans with the robot model and collision
+    /// checker given to the constructor; each following member plans with the
+    /// robot model of the next added context, and with its collision checker
+    /// or, if that is null, a clone of the interface's collision checker.
+    /// Members without a context are dropped. Contexts must be added before
+    /// init() and must outlive the interface.
+    void addPortfolioContext(RobotModel* robot, CollisionChecker* checker = nullptr);
+
+    /// \brief Stop the request being solved.
+    ///
+    /// May be called from any thread while solve() or solveBatch() runs.
+    /// The remaining requests of a batch are not started. The heuristic
+    /// searches, the search, and post-processing of the request wind down
+    /// soon after, and solve() returns with the best path found so far, if
+    /// any. Heuristic initialization and the search of each request also stop
+    /// this way once its allowed planning time has passed.
+    void cancel();
+
     bool canServiceRequest(
         const moveit_msgs::MotionPlanRequest& req,
         moveit_msgs::MotionPlanResponse& res) const;
@@ -146,6 +218,15 @@ protected:
     CollisionChecker* m_checker;
     OccupancyGrid* m_grid;
 
+    // with motion_validity_cache set, m_checker is replaced by a checker that
+    // shares motion validity results between the search and post-processing
+    // of a request. with motion_validity_certificates also set, valid motions
+    // are kept across requests while the world grows by less than their
+    // clearance
+    CollisionChecker* m_user_checker;
+    std::unique_ptr<MotionValidityCache> m_motion_cache;
+    std::unique_ptr<CachedCollisionChecker> m_cached_checker;
+
     ForwardKinematicsInterface* m_fk_iface;
 
     PlanningParams m_params;
@@ -165,12 +246,191 @@ protected:
 
     int m_sol_cost;
 
+    // telemetry totals at the start of the last search
+    TelemetrySnapshot m_telemetry_start;
+
     std::string m_planner_id;
 
+    // planner components of previously used planner ids, kept around so that
+    // switching back to them reuses their allocated state tables and search
+    // memory rather than rebuilding them
+    struct Pipeline
+    {
+        std::unique_ptr<RobotPlanningSpace> space;
+        std::map<std::string, std::unique_ptr<RobotHeuristic>> heuristics;
+        std::unique_ptr<SBPLPlanner> planner;
+    };
+
+    bool m_reuse_pipelines;
+    std::map<std::string, Pipeline> m_pipelines;
+
+    // with parallel_setup set, the goal updates of the BFS heuristics, which
+    // read only the goal and the occupancy grid, run on their own threads
+    // while the search is reset and the goal and start states of the graph
+    // are set and validated
+    bool m_parallel_setup;
+    std::vector<std::future<void>> m_heuristic_updates;
+
+    // with share_bfs set, the BFS heuristics of every pipeline, including
+    // the portfolio members, share one search per goal and world version
+    bool m_share_bfs;
+    BfsSearchRegistry m_bfs_registry;
+
+    // members of the planner portfolio. each member owns its pipeline and the
+    // clone of the collision checker its planning space was built with, so
+    // that members may plan concurrently. the pipeline of the member that
+    // solved the last portfolio request (or of the first member, if none did)
+    // is moved into m_pspace, m_heuristics, and m_planner until the next
+    // request, so that statistics and visualizations report on it
+    struct PortfolioContext
+    {
+        RobotModel* robot;
+        CollisionChecker* checker;
+    };
+
+    struct PortfolioMember
+    {
+        std::string planner_id;
+        RobotModel* robot;
+        CollisionChecker* checker;
+        std::unique_ptr<CollisionChecker> checker_clone;
+        Pipeline pipeline;
+    };
+
+    std::vector<std::string> m_portfolio_ids;
+    std::vector<PortfolioContext> m_portfolio_contexts;
+    std::vector<std::unique_ptr<PortfolioMember>> m_portfolio;
+    int m_portfolio_active;
+
+    // successful paths are appended to the experience graph of the planning
+    // space that produced them, at the start of the next request, so that
+    // the insertion is kept out of the response time of the current one
+    // joint-space shortcutting with a thread count above one or a positive
+    // time budget uses the randomized, parallel shortcutter
+    int m_shortcut_threads;
+    double m_shortcut_time;
+
+    // smooth with AnytimeSmoothPath, within the part of the request's allowed
+    // planning time that the search left over
+    bool m_anytime_smoothing;
+
+    // iterations of gradient-based path optimization (OptimizePath) after
+    // shortcutting, disabled when zero, and the clearance from obstacles it
+    // optimizes for
+    int m_optimize_iterations;
+    double m_optimize_clearance;
+
+    // with start_repair_iterations positive, a start state in collision is
+    // pushed out of collision along the gradient of the obstacle cost, the
+    // search plans from the repaired state, and the start of the request is
+    // prepended to the final path
+    int m_start_repair_iterations;
+    double m_start_repair_clearance;
+    double m_start_repair_step;
+    RobotState m_unrepaired_start;
+
+    // map of the poses reachable by the planning link, loaded from the file
+    // named by reachability_map. Pose and position goals outside of it are
+    // rejected before planning, and goal IK is seeded from it
+    ReachabilityMap m_reachability_map;
+
+    // time the trajectory under the acceleration limits of the robot model,
+    // rather than at constant maximum velocity
+    bool m_trapezoidal_timing;
+    double m_junction_deviation;
+
+    PathPrefixCallback m_prefix_callback;
+    int m_stream_waypoint_count;
+
+    bool m_egraph_record;
+    double m_egraph_merge_radius;
+    std::vector<std::vector<RobotState>> m_pending_experiences;
+
+    // with warm_start set, the final path of the last request is kept with
+    // its goal. a request for the same goal, from a start within
+    // warm_start_radius of one of its waypoints (in every joint), reuses the
+    // remainder of the path if it is still valid, instead of searching
+    bool m_warm_start;
+    double m_warm_start_radius;
+    GoalConstraint m_warm_goal;
+    std::vector<RobotState> m_warm_path;
+
+    // with result_cache_size positive, the results of the most recent
+    // successful requests are kept, most recently used first, keyed on the
+    // serialized request and the version of the collision world they were
+    // planned in. a repeated request in an unchanged world returns the stored
+    // trajectory once its path is checked again. requires a collision checker
+    // that provides CollisionWorldVersionExtension
+    struct CachedResult
+    {
+        std::size_t hash;
+        std::string key;
+        std::uint64_t world_version;
+        std::vector<RobotState> path;
+        moveit_msgs::RobotTrajectory trajectory;
+    };
+
+    int m_result_cache_size;
+    std::list<CachedResult> m_result_cache;
+
+    // with resume_searches set, the search of a request that ended without a
+    // path is kept along with the states of its planning space. a retry of
+    // the same request, apart from its allowed planning time, in an unchanged
+    // world continues that search rather than starting over. requires a
+    // collision checker that provides CollisionWorldVersionExtension
+    struct SearchCheckpoint
+    {
+        bool valid = false;
+        std::string key;
+        std::uint64_t world_version = 0;
+    };
+
+    bool m_resume_searches;
+    bool m_resuming;
+    SearchCheckpoint m_checkpoint;
+
+    // workers of solveBatch() other than this interface, each owning the
+    // clones it plans with. rebuilt with the new parameters on the first
+    // batch after init()
+    struct BatchWorker
+    {
+        std::unique_ptr<RobotModel> robot;
+        std::unique_ptr<CollisionChecker> checker;
+        std::unique_ptr<PlannerInterface> planner;
+    };
+
+    int m_batch_threads;
+    std::unique_ptr<WorkerPool> m_batch_pool;
+    std::mutex m_batch_mutex;
+    std::vector<std::unique_ptr<BatchWorker>> m_batch_workers;
+    std::atomic<bool> m_batch_cancelled;
+
+    // expires when the request being solved is cancelled or, until its search
+    // finishes, runs out of allowed planning time. polled by the searches and
+    // heuristics of every pipeline, and by post-processing
+    CancellationToken m_cancel;
+
+    // when non-empty, scoped spans around the stages of each request are
+    // recorded and exported here, in Chrome trace format, after each request
+    std::string m_trace_output;
+
+    // when non-null, the latency, outcome, and component memory usage of
+    // each request are reported here. shared with the batch workers
+    std::shared_ptr<MetricsExporter> m_metrics;
+
+    bool solveRequest(
+        const moveit_msgs::PlanningScene& planning_scene,
+        const moveit_msgs::MotionPlanRequest& req,
+        moveit_msgs::MotionPlanResponse& res);
+
     // Set start configuration
-    bool setGoal(const GoalConstraints& v_goal_constraints);
+    bool makeGoal(const GoalConstraints& v_goal_constraints, GoalConstraint& goal);
+    bool setGoal(const GoalConstraint& goal);
     bool setStart(const moveit_msgs::RobotState& state);
 
+    void startHeuristicUpdates(const GoalConstraint& goal);
+    void finishHeuristicUpdates();
+
     // Retrieve plan from sbpl
     bool plan(double allowed_time, std::vector<RobotState>& path);
 
@@ -180,9 +440,41 @@ protected:
         std::string& heuristic_name,
         std::string& search_name) const;
 
+    bool buildPipeline(
+        const std::string& planner_id,
+        RobotModel* robot,
+        CollisionChecker* checker,
+        Pipeline& pipeline);
+
     bool reinitPlanner(const std::string& planner_id);
 
-    void postProcessPath(std::vector<RobotState>& path) const;
+    void applyCancellationToken();
+
+    bool initPortfolio();
+    void restorePortfolioMember();
+    bool planPortfolio(double allowed_time, std::vector<RobotState>& path);
+
+    bool warmStartPath(std::vector<RobotState>& path) const;
+
+    bool lookupCachedResult(
+        const std::string& key,
+        std::uint64_t world_version,
+        moveit_msgs::RobotTrajectory& trajectory);
+
+    void storeCachedResult(
+        const std::string& key,
+        std::uint64_t world_version,
+        const std::vector<RobotState>& path,
+        const moveit_msgs::RobotTrajectory& trajectory);
+
+    void postProcessPath(std::vector<RobotState>& path, double allowed_time) const;
+    void prependUnrepairedStart(std::vector<RobotState>& path) const;
+
+    void insertPendingExperiences();
+
+    auto memoryUsage(MemoryComponent component) const -> std::size_t;
+
+    bool initBatchWorkers();
 };
 
 } // namespace smpl
@@ -0,0 +1,185 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+/// \author Andrew Dornbush
+
+#ifndef SMPL_ROS_REQUEST_SCHEDULER_H
+#define SMPL_ROS_REQUEST_SCHEDULER_H
+
+// standard includes
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// system includes
+#include <moveit_msgs/MotionPlanRequest.h>
+#include <moveit_msgs/MotionPlanResponse.h>
+#include <moveit_msgs/PlanningScene.h>
+
+// project includes
+#include <smpl/time.h>
+
+namespace smpl {
+
+class PlannerInterface;
+
+enum class RequestPriority
+{
+    Urgent = 0,     ///< reactive replans
+    Normal,
+    Background,     ///< offline queries and precomputation
+    Count
+};
+
+auto to_cstring(RequestPriority priority) -> const char*;
+
+/// \brief Queues planning requests and solves them on a fixed set of planner
+///     interfaces, in order of priority.
+///
+/// Each planner interface is served by a thread of its own and solves one
+/// request at a time. Queued requests are started in order of their
+/// priority class, and in order of submission within a class, so a request
+/// never waits behind one of a lower class.
+///
+/// With a memory budget, every request reserves the number of bytes it was
+/// submitted with while it runs, and is started only once its reservation
+/// fits within the budget. Requests reserving more than the whole budget are
+/// rejected.
+///
+/// A request that can not be started when it is submitted preempts a running
+/// request of a lower class, by cancelling the planner interface solving it.
+/// The preempted request returns to the front of its class and is solved
+/// again from scratch, unless it was solved before it wound down.
+class RequestScheduler
+{
+public:
+
+    /// Latency metrics of the requests of one priority class. Wait times run
+    /// from submission to the start of the final attempt at a request;
+    /// latencies from submission to completion.
+    struct ClassStats
+    {
+        std::size_t submitted = 0;
+        std::size_t completed = 0;
+        std::size_t rejected = 0;
+        std::size_t preempted = 0;
+        double total_wait = 0.0;
+        double max_wait = 0.0;
+        double total_latency = 0.0;
+        double max_latency = 0.0;
+
+        double meanWait() const { return completed ? total_wait / completed : 0.0; }
+        double meanLatency() const { return completed ? total_latency / completed : 0.0; }
+    };
+
+    /// \param planners The planner interfaces to solve requests with. Each
+    ///     must be initialized, must not be used elsewhere while the
+    ///     scheduler exists, and must outlive it.
+    /// \param memory_budget Bytes that the reservations of running requests
+    ///     may add up to, or 0 to admit requests regardless of memory
+    RequestScheduler(
+        const std::vector<PlannerInterface*>& planners,
+        std::size_t memory_budget = 0);
+
+    /// Cancel the running requests, reject the queued ones, and join the
+    /// threads of the planner interfaces.
+    ~RequestScheduler();
+
+    RequestScheduler(const RequestScheduler&) = delete;
+    RequestScheduler& operator=(const RequestScheduler&) = delete;
+
+    /// \brief Queue a request.
+    ///
+    /// \param memory Bytes reserved from the memory budget while the request
+    ///     runs
+    /// \return The response to the request. Rejected requests are answered
+    ///     with the FAILURE error code.
+    auto submit(
+        const moveit_msgs::PlanningScene& planning_scene,
+        const moveit_msgs::MotionPlanRequest& req,
+        RequestPriority priority,
+        std::size_t memory = 0)
+        -> std::future<moveit_msgs::MotionPlanResponse>;
+
+    auto stats(RequestPriority priority) const -> ClassStats;
+
+    std::size_t queuedCount() const;
+
+private:
+
+    struct Request
+    {
+        moveit_msgs::PlanningScene planning_scene;
+        moveit_msgs::MotionPlanRequest req;
+        RequestPriority priority;
+        std::size_t memory;
+        clock::time_point submitted;
+        std::promise<moveit_msgs::MotionPlanResponse> response;
+    };
+
+    struct Executor
+    {
+        PlannerInterface* planner;
+        std::unique_ptr<Request> running;
+        clock::time_point started;
+        bool preempting;
+        std::thread thread;
+    };
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+
+    std::vector<std::unique_ptr<Executor>> m_executors;
+    std::deque<std::unique_ptr<Request>> m_queues[(int)RequestPriority::Count];
+    ClassStats m_stats[(int)RequestPriority::Count];
+
+    std::size_t m_memory_budget;
+    std::size_t m_memory_reserved;
+
+    bool m_shutdown;
+
+    void run(Executor* executor);
+
+    auto popAdmissible() -> std::unique_ptr<Request>;
+    bool admissible(const Request& request) const;
+
+    void preemptFor(const Request& request);
+
+    void reject(std::unique_ptr<Request> request);
+};
+
+} // namespace smpl
+
+#endif
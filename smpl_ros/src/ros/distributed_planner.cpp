@@ -0,0 +1,653 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+/// \author Andrew Dornbush
+
+#include <smpl/ros/distributed_planner.h>
+
+// standard includes
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+// system includes
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <moveit_msgs/MoveItErrorCodes.h>
+#include <ros/serialization.h>
+#include <smpl/console/console.h>
+#include <smpl/distance_map/chessboard_distance_map.h>
+#include <smpl/distance_map/edge_euclid_distance_map.h>
+#include <smpl/distance_map/euclid_distance_map.h>
+#include <smpl/distance_map/sparse_distance_map.h>
+
+namespace smpl {
+
+static const char* LOG = "distributed";
+
+// Every message is framed by a header of the protocol magic, the message
+// type, and the length of the payload. Hosts and clients are assumed to share
+// a byte order.
+static const std::uint32_t ProtocolMagic = 0x534d504a; // "SMPJ"
+
+enum MessageType : std::uint32_t
+{
+    // client -> host: the serialized planning scene and request, followed by
+    // the world snapshot, which may be empty
+    JobMessage = 1,
+
+    // client -> host: cancel the job
+    CancelMessage,
+
+    // host -> client: the serialized response
+    ResultMessage,
+};
+
+struct MessageHeader
+{
+    std::uint32_t magic;
+    std::uint32_t type;
+    std::uint64_t length;
+};
+
+// generous bound on payloads, to reject garbage before allocating for it
+static const std::uint64_t MaxPayloadLength = std::uint64_t(1) << 34;
+
+static
+bool SendAll(int fd, const void* data, std::size_t size)
+{
+    auto* p = (const char*)data;
+    while (size > 0) {
+        auto n = send(fd, p, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+static
+bool RecvAll(int fd, void* data, std::size_t size)
+{
+    auto* p = (char*)data;
+    while (size > 0) {
+        auto n = recv(fd, p, size, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+static
+bool SendMessage(int fd, MessageType type, const std::string& payload)
+{
+    MessageHeader header;
+    header.magic = ProtocolMagic;
+    header.type = type;
+    header.length = payload.size();
+    return SendAll(fd, &header, sizeof(header)) &&
+            SendAll(fd, payload.data(), payload.size());
+}
+
+static
+bool RecvMessage(int fd, MessageType& type, std::string& payload)
+{
+    MessageHeader header;
+    if (!RecvAll(fd, &header, sizeof(header))) {
+        return false;
+    }
+    if (header.magic != ProtocolMagic || header.length > MaxPayloadLength) {
+        SMPL_ERROR_NAMED(LOG, "Received a malformed message");
+        return false;
+    }
+    type = (MessageType)header.type;
+    payload.resize(header.length);
+    return RecvAll(fd, &payload[0], payload.size());
+}
+
+// Append a length-prefixed serialized message to a payload
+template <class Message>
+void AppendMessage(std::string& payload, const Message& msg)
+{
+    auto length = (std::uint32_t)ros::serialization::serializationLength(msg);
+    auto offset = payload.size();
+    payload.resize(offset + sizeof(length) + length);
+    std::memcpy(&payload[offset], &length, sizeof(length));
+    ros::serialization::OStream stream(
+            (std::uint8_t*)&payload[offset + sizeof(length)], length);
+    ros::serialization::serialize(stream, msg);
+}
+
+// Read a length-prefixed serialized message from a payload, starting at
+// offset, and advance offset past it
+template <class Message>
+bool ReadMessage(const std::string& payload, std::size_t& offset, Message& msg)
+{
+    std::uint32_t length;
+    if (payload.size() - offset < sizeof(length)) {
+        return false;
+    }
+    std::memcpy(&length, &payload[offset], sizeof(length));
+    offset += sizeof(length);
+    if (payload.size() - offset < length) {
+        return false;
+    }
+
+    try {
+        ros::serialization::IStream stream(
+                (std::uint8_t*)&payload[offset], length);
+        ros::serialization::deserialize(stream, msg);
+    } catch (const ros::serialization::StreamOverrunException& ex) {
+        return false;
+    }
+    offset += length;
+    return true;
+}
+
+// Create an empty temporary file for a snapshot and return its path
+static
+bool MakeSnapshotPath(std::string& path)
+{
+    char name[] = "/tmp/smpl_snapshot_XXXXXX";
+    auto fd = mkstemp(name);
+    if (fd < 0) {
+        SMPL_ERROR_NAMED(LOG, "Failed to create snapshot file: %s", std::strerror(errno));
+        return false;
+    }
+    close(fd);
+    path = name;
+    return true;
+}
+
+static
+bool ReadFile(const std::string& path, std::string& data)
+{
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs.is_open()) {
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    return !ifs.bad();
+}
+
+static
+bool WriteFile(const std::string& path, const std::string& data)
+{
+    std::ofstream ofs(path, std::ios::binary);
+    if (!ofs.is_open()) {
+        return false;
+    }
+    ofs.write(data.data(), data.size());
+    return ofs.good();
+}
+
+bool SaveDistanceMapSnapshot(
+    const DistanceMapInterface& dmap,
+    const std::string& path)
+{
+    if (auto* m = dynamic_cast<const EuclidDistanceMap*>(&dmap)) {
+        return m->save(path);
+    }
+    if (auto* m = dynamic_cast<const EdgeEuclidDistanceMap*>(&dmap)) {
+        return m->save(path);
+    }
+    if (auto* m = dynamic_cast<const ChessboardDistanceMap*>(&dmap)) {
+        return m->save(path);
+    }
+    if (auto* m = dynamic_cast<const SparseDistanceMap*>(&dmap)) {
+        return m->save(path);
+    }
+    SMPL_ERROR_NAMED(LOG, "Distance map does not support snapshots");
+    return false;
+}
+
+bool LoadDistanceMapSnapshot(DistanceMapInterface& dmap, const std::string& path)
+{
+    if (auto* m = dynamic_cast<EuclidDistanceMap*>(&dmap)) {
+        return m->load(path);
+    }
+    if (auto* m = dynamic_cast<EdgeEuclidDistanceMap*>(&dmap)) {
+        return m->load(path);
+    }
+    if (auto* m = dynamic_cast<ChessboardDistanceMap*>(&dmap)) {
+        return m->load(path);
+    }
+    if (auto* m = dynamic_cast<SparseDistanceMap*>(&dmap)) {
+        return m->load(path);
+    }
+    SMPL_ERROR_NAMED(LOG, "Distance map does not support snapshots");
+    return false;
+}
+
+PlannerHostServer::PlannerHostServer(
+    PlannerInterface* planner,
+    OccupancyGrid* grid)
+:
+    m_planner(planner),
+    m_grid(grid),
+    m_listen_fd(-1),
+    m_port(0),
+    m_running(false)
+{
+}
+
+PlannerHostServer::~PlannerHostServer()
+{
+    stop();
+}
+
+bool PlannerHostServer::start(int port)
+{
+    stop();
+
+    auto fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        SMPL_ERROR_NAMED(LOG, "Failed to create planner host socket: %s", std::strerror(errno));
+        return false;
+    }
+
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((std::uint16_t)port);
+    if (bind(fd, (const sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, 8) < 0) {
+        SMPL_ERROR_NAMED(LOG, "Failed to serve planning jobs on port %d: %s", port, std::strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    m_listen_fd = fd;
+    m_port = port;
+    m_running = true;
+    m_server = std::thread([this]() { serve(); });
+    SMPL_INFO_NAMED(LOG, "Serve planning jobs on port %d", port);
+    return true;
+}
+
+void PlannerHostServer::stop()
+{
+    if (!m_server.joinable()) {
+        return;
+    }
+    m_running = false;
+    m_server.join();
+    close(m_listen_fd);
+    m_listen_fd = -1;
+    m_port = 0;
+}
+
+// Accept and serve jobs one at a time until stopped. Clients connecting while
+// a job is served wait in the listen backlog.
+void PlannerHostServer::serve()
+{
+    while (m_running) {
+        pollfd pfd;
+        pfd.fd = m_listen_fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, 100) <= 0) {
+            continue;
+        }
+
+        auto fd = accept(m_listen_fd, NULL, NULL);
+        if (fd < 0) {
+            continue;
+        }
+
+        // a stalled client may fail its own job, but never holds up later
+        // jobs for long
+        timeval timeout;
+        timeout.tv_sec = 10;
+        timeout.tv_usec = 0;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        serveJob(fd);
+        close(fd);
+    }
+}
+
+void PlannerHostServer::serveJob(int fd)
+{
+    MessageType type;
+    std::string payload;
+    if (!RecvMessage(fd, type, payload) || type != JobMessage) {
+        SMPL_WARN_NAMED(LOG, "Failed to receive planning job");
+        return;
+    }
+
+    moveit_msgs::PlanningScene scene;
+    moveit_msgs::MotionPlanRequest req;
+    auto offset = std::size_t(0);
+    if (!ReadMessage(payload, offset, scene) ||
+        !ReadMessage(payload, offset, req))
+    {
+        SMPL_WARN_NAMED(LOG, "Received a malformed planning job");
+        return;
+    }
+
+    moveit_msgs::MotionPlanResponse res;
+
+    if (offset < payload.size()) {
+        std::string path;
+        auto loaded = m_grid != nullptr && MakeSnapshotPath(path);
+        if (loaded) {
+            loaded = WriteFile(path, payload.substr(offset)) &&
+                    LoadDistanceMapSnapshot(*m_grid->getDistanceField(), path);
+            unlink(path.c_str());
+        }
+        if (!loaded) {
+            SMPL_ERROR_NAMED(LOG, "Failed to load world snapshot for planning job");
+            res.error_code.val = moveit_msgs::MoveItErrorCodes::FAILURE;
+            std::string result;
+            AppendMessage(result, res);
+            SendMessage(fd, ResultMessage, result);
+            return;
+        }
+    }
+
+    SMPL_INFO_NAMED(LOG, "Serve planning job with planner '%s'", req.planner_id.c_str());
+
+    std::atomic<bool> done(false);
+    std::thread solver([&]()
+    {
+        m_planner->solve(scene, req, res);
+        done = true;
+    });
+
+    // watch the connection for a cancel message, or the client hanging up,
+    // while the job is solved
+    auto cancelled = false;
+    while (!done) {
+        if (!m_running && !cancelled) {
+            m_planner->cancel();
+            cancelled = true;
+        }
+        if (cancelled) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+
+        pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, 100) <= 0) {
+            continue;
+        }
+
+        std::string message;
+        if (!RecvMessage(fd, type, message) || type == CancelMessage) {
+            SMPL_INFO_NAMED(LOG, "Cancel planning job");
+            m_planner->cancel();
+            cancelled = true;
+        }
+    }
+    solver.join();
+
+    if (cancelled) {
+        return;
+    }
+
+    std::string result;
+    AppendMessage(result, res);
+    if (!SendMessage(fd, ResultMessage, result)) {
+        SMPL_WARN_NAMED(LOG, "Failed to send planning result");
+    }
+}
+
+// Connect to a host, waiting at most timeout_ms, and return the connected
+// socket, or -1 on failure
+static
+int ConnectToHost(const PlannerHost& host, int timeout_ms)
+{
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    addrinfo* addrs = NULL;
+    auto port = std::to_string(host.port);
+    auto err = getaddrinfo(host.address.c_str(), port.c_str(), &hints, &addrs);
+    if (err != 0) {
+        SMPL_WARN_NAMED(LOG, "Failed to resolve planner host '%s': %s", host.address.c_str(), gai_strerror(err));
+        return -1;
+    }
+
+    auto fd = -1;
+    for (auto* a = addrs; a != NULL && fd < 0; a = a->ai_next) {
+        fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+
+        // connect without blocking, to bound the wait for unreachable hosts
+        auto flags = fcntl(fd, F_GETFL, 0);
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+        auto connected = connect(fd, a->ai_addr, a->ai_addrlen) == 0;
+        if (!connected && errno == EINPROGRESS) {
+            pollfd pfd;
+            pfd.fd = fd;
+            pfd.events = POLLOUT;
+            pfd.revents = 0;
+            if (poll(&pfd, 1, timeout_ms) > 0) {
+                int error = 0;
+                socklen_t len = sizeof(error);
+                getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len);
+                connected = error == 0;
+            }
+        }
+        fcntl(fd, F_SETFL, flags);
+
+        if (!connected) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(addrs);
+
+    if (fd < 0) {
+        SMPL_WARN_NAMED(LOG, "Failed to connect to planner host %s:%d", host.address.c_str(), host.port);
+    }
+    return fd;
+}
+
+DistributedPlanner::DistributedPlanner() :
+    m_hosts(),
+    m_grace_period(5.0),
+    m_cancelled(false)
+{
+}
+
+void DistributedPlanner::addHost(const PlannerHost& host)
+{
+    m_hosts.push_back(host);
+}
+
+bool DistributedPlanner::solve(
+    const moveit_msgs::PlanningScene& planning_scene,
+    const moveit_msgs::MotionPlanRequest& req,
+    const DistanceMapInterface* world,
+    moveit_msgs::MotionPlanResponse& res,
+    int* winner)
+{
+    m_cancelled = false;
+    if (winner != nullptr) {
+        *winner = -1;
+    }
+
+    res.error_code.val = moveit_msgs::MoveItErrorCodes::PLANNING_FAILED;
+
+    // the snapshot is taken once and shared by every host's job
+    std::string snapshot;
+    if (world != nullptr) {
+        std::string path;
+        if (!MakeSnapshotPath(path)) {
+            return false;
+        }
+        auto saved = SaveDistanceMapSnapshot(*world, path) && ReadFile(path, snapshot);
+        unlink(path.c_str());
+        if (!saved) {
+            SMPL_ERROR_NAMED(LOG, "Failed to take world snapshot");
+            return false;
+        }
+    }
+
+    // connect to and send the job to every host
+    std::vector<pollfd> pfds;
+    std::vector<int> host_indices;
+    for (size_t i = 0; i < m_hosts.size(); ++i) {
+        auto& host = m_hosts[i];
+        auto fd = ConnectToHost(host, 1000);
+        if (fd < 0) {
+            continue;
+        }
+
+        auto job_req = req;
+        if (!host.planner_id.empty()) {
+            job_req.planner_id = host.planner_id;
+        }
+
+        std::string payload;
+        AppendMessage(payload, planning_scene);
+        AppendMessage(payload, job_req);
+        payload += snapshot;
+        if (!SendMessage(fd, JobMessage, payload)) {
+            SMPL_WARN_NAMED(LOG, "Failed to send job to planner host %s:%d", host.address.c_str(), host.port);
+            close(fd);
+            continue;
+        }
+
+        pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        pfds.push_back(pfd);
+        host_indices.push_back((int)i);
+    }
+
+    if (pfds.empty()) {
+        SMPL_ERROR_NAMED(LOG, "No planner hosts available");
+        return false;
+    }
+
+    SMPL_INFO_NAMED(LOG, "Sent planning job to %zu of %zu hosts", pfds.size(), m_hosts.size());
+
+    // wait for the first solution. hosts that fail, or hang up, are dropped
+    auto deadline = std::chrono::steady_clock::now() +
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double>(
+                            req.allowed_planning_time + m_grace_period));
+    auto solved = false;
+    auto remaining = pfds.size();
+    while (!solved && remaining > 0 && !m_cancelled &&
+        std::chrono::steady_clock::now() < deadline)
+    {
+        if (poll(pfds.data(), pfds.size(), 100) <= 0) {
+            continue;
+        }
+
+        for (size_t i = 0; i < pfds.size() && !solved; ++i) {
+            auto& pfd = pfds[i];
+            if (pfd.fd < 0 || pfd.revents == 0) {
+                continue;
+            }
+
+            auto& host = m_hosts[host_indices[i]];
+
+            MessageType type;
+            std::string payload;
+            moveit_msgs::MotionPlanResponse host_res;
+            auto offset = std::size_t(0);
+            if (RecvMessage(pfd.fd, type, payload) &&
+                type == ResultMessage &&
+                ReadMessage(payload, offset, host_res))
+            {
+                res = host_res;
+                if (host_res.error_code.val == moveit_msgs::MoveItErrorCodes::SUCCESS) {
+                    SMPL_INFO_NAMED(LOG, "Take solution from planner host %s:%d (%s)", host.address.c_str(), host.port, host.planner_id.c_str());
+                    solved = true;
+                    if (winner != nullptr) {
+                        *winner = host_indices[i];
+                    }
+                } else {
+                    SMPL_INFO_NAMED(LOG, "Planner host %s:%d (%s) failed with error code %d", host.address.c_str(), host.port, host.planner_id.c_str(), host_res.error_code.val);
+                }
+            } else {
+                SMPL_WARN_NAMED(LOG, "Lost planner host %s:%d", host.address.c_str(), host.port);
+            }
+
+            close(pfd.fd);
+            pfd.fd = -1; // ignored by poll from now on
+            --remaining;
+        }
+    }
+
+    // cancel the stragglers
+    for (auto& pfd : pfds) {
+        if (pfd.fd >= 0) {
+            SendMessage(pfd.fd, CancelMessage, std::string());
+            close(pfd.fd);
+        }
+    }
+
+    if (!solved && remaining > 0 && !m_cancelled) {
+        SMPL_WARN_NAMED(LOG, "Timed out waiting for planner hosts");
+        res.error_code.val = moveit_msgs::MoveItErrorCodes::TIMED_OUT;
+    }
+
+    return solved;
+}
+
+} // namespace smpl
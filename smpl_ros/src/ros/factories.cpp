@@ -12,17 +12,24 @@
 #include <smpl/graph/workspace_lattice_action_space.h>
 #include <smpl/graph/workspace_lattice_egraph.h>
 #include <smpl/heuristic/bfs_heuristic.h>
+#include <smpl/heuristic/dubins_heuristic.h>
 #include <smpl/heuristic/egraph_bfs_heuristic.h>
 #include <smpl/heuristic/euclid_dist_heuristic.h>
 #include <smpl/heuristic/generic_egraph_heuristic.h>
 #include <smpl/heuristic/joint_dist_heuristic.h>
 #include <smpl/heuristic/multi_frame_bfs_heuristic.h>
+#include <smpl/heuristic/pose_bfs_heuristic.h>
+#include <smpl/heuristic/soft_bfs_heuristic.h>
 #include <smpl/planning_params.h>
 #include <smpl/robot_model.h>
 #include <smpl/search/adaptive_planner.h>
+#include <smpl/search/anastar.h>
 #include <smpl/search/arastar.h>
 #include <smpl/search/awastar.h>
+#include <smpl/search/bidirectional_wastar.h>
 #include <smpl/search/experience_graph_planner.h>
+#include <smpl/search/lpastar.h>
+#include <smpl/search/pase.h>
 #include <smpl/stl/memory.h>
 
 namespace smpl {
@@ -33,6 +40,7 @@ struct ManipLatticeActionSpaceParams
 {
     std::string mprim_filename;
     bool use_multiple_ik_solutions = false;
+    bool use_ik_cache = false;
     bool use_xyz_snap_mprim;
     bool use_rpy_snap_mprim;
     bool use_xyzrpy_snap_mprim;
@@ -50,22 +58,25 @@ bool GetManipLatticeActionSpaceParams(
     ManipLatticeActionSpaceParams& params,
     const PlanningParams& pp)
 {
-    if (!pp.getParam("mprim_filename", params.mprim_filename)) {
+    auto& cp = pp.compiled();
+    if (!cp.mprim_filename) {
         SMPL_ERROR_NAMED(PI_LOGGER, "Parameter 'mprim_filename' not found in planning params");
         return false;
     }
+    params.mprim_filename = *cp.mprim_filename;
 
-    pp.param("use_multiple_ik_solutions", params.use_multiple_ik_solutions, false);
+    params.use_multiple_ik_solutions = cp.use_multiple_ik_solutions;
+    params.use_ik_cache = cp.use_ik_cache;
 
-    pp.param("use_xyz_snap_mprim", params.use_xyz_snap_mprim, false);
-    pp.param("use_rpy_snap_mprim", params.use_rpy_snap_mprim, false);
-    pp.param("use_xyzrpy_snap_mprim", params.use_xyzrpy_snap_mprim, false);
-    pp.param("use_short_dist_mprims", params.use_short_dist_mprims, false);
+    params.use_xyz_snap_mprim = cp.use_xyz_snap_mprim;
+    params.use_rpy_snap_mprim = cp.use_rpy_snap_mprim;
+    params.use_xyzrpy_snap_mprim = cp.use_xyzrpy_snap_mprim;
+    params.use_short_dist_mprims = cp.use_short_dist_mprims;
 
-    pp.param("xyz_snap_dist_thresh", params.xyz_snap_thresh, 0.0);
-    pp.param("rpy_snap_dist_thresh", params.rpy_snap_thresh, 0.0);
-    pp.param("xyzrpy_snap_dist_thresh", params.xyzrpy_snap_thresh, 0.0);
-    pp.param("short_dist_mprims_thresh", params.short_dist_mprims_thresh, 0.0);
+    params.xyz_snap_thresh = cp.xyz_snap_dist_thresh;
+    params.rpy_snap_thresh = cp.rpy_snap_dist_thresh;
+    params.xyzrpy_snap_thresh = cp.xyzrpy_snap_dist_thresh;
+    params.short_dist_mprims_thresh = cp.short_dist_mprims_thresh;
     return true;
 }
 
@@ -117,13 +128,13 @@ auto MakeManipLattice(
 
     auto resolutions = std::vector<double>(robot->jointVariableCount());
 
-    std::string disc_string;
-    if (!params.getParam("discretization", disc_string)) {
+    auto& disc_string = params.compiled().discretization;
+    if (!disc_string) {
         SMPL_ERROR_NAMED(PI_LOGGER, "Parameter 'discretization' not found in planning params");
         return nullptr;
     }
 
-    auto disc = ParseMapFromString<double>(disc_string);
+    auto disc = ParseMapFromString<double>(*disc_string);
     SMPL_DEBUG_NAMED(PI_LOGGER, "Parsed discretization for %zu joints", disc.size());
 
     for (size_t vidx = 0; vidx < robot->jointVariableCount(); ++vidx) {
@@ -181,8 +192,34 @@ auto MakeManipLattice(
         space->setVisualizationFrameId(grid->getReferenceFrame());
     }
 
+    auto& cp = params.compiled();
+    if (!space->setActionCheckThreadCount(cp.action_check_threads)) {
+        SMPL_WARN_NAMED(PI_LOGGER, "Failed to enable parallel action checking. Checking actions serially");
+    }
+
+    space->setOrderedExpansion(
+            cp.ordered_expansion, cp.ordered_expansion_early_exit);
+
+    space->setMemoryLimit((std::size_t)(cp.space_memory_limit * 1024.0 * 1024.0));
+
+    space->setGoalSetStates(cp.goal_set_search.value_or(false));
+
     auto& actions = space->actions;
     actions.useMultipleIkSolutions(action_params.use_multiple_ik_solutions);
+    actions.useIkCache(action_params.use_ik_cache);
+    if (!actions.setIkSampling(
+            params.compiled().ik_sampling_seeds,
+            params.compiled().ik_sampling_threads))
+    {
+        SMPL_WARN_NAMED(PI_LOGGER, "Failed to enable IK sampling. Using a single IK seed");
+    }
+    actions.setClearanceScaling(
+            params.compiled().clearance_scaling_min,
+            params.compiled().clearance_scaling_max,
+            params.compiled().clearance_scaling_max_scale);
+    if (!actions.useClearanceScaling(params.compiled().use_clearance_scaling)) {
+        SMPL_WARN_NAMED(PI_LOGGER, "Failed to enable clearance scaling of motion primitives");
+    }
     actions.useAmp(MotionPrimitive::SNAP_TO_XYZ, action_params.use_xyz_snap_mprim);
     actions.useAmp(MotionPrimitive::SNAP_TO_RPY, action_params.use_rpy_snap_mprim);
     actions.useAmp(MotionPrimitive::SNAP_TO_XYZ_RPY, action_params.use_xyzrpy_snap_mprim);
@@ -232,12 +269,12 @@ auto MakeManipLatticeEGraph(
 
     std::vector<double> resolutions(robot->jointVariableCount());
 
-    std::string disc_string;
-    if (!params.getParam("discretization", disc_string)) {
+    auto& disc_string = params.compiled().discretization;
+    if (!disc_string) {
         SMPL_ERROR_NAMED(PI_LOGGER, "Parameter 'discretization' not found in planning params");
         return nullptr;
     }
-    auto disc = ParseMapFromString<double>(disc_string);
+    auto disc = ParseMapFromString<double>(*disc_string);
     SMPL_DEBUG_NAMED(PI_LOGGER, "Parsed discretization for %zu joints", disc.size());
 
     for (size_t vidx = 0; vidx < robot->jointVariableCount(); ++vidx) {
@@ -279,6 +316,20 @@ auto MakeManipLatticeEGraph(
 
     auto& actions = space->actions;
     actions.useMultipleIkSolutions(action_params.use_multiple_ik_solutions);
+    actions.useIkCache(action_params.use_ik_cache);
+    if (!actions.setIkSampling(
+            params.compiled().ik_sampling_seeds,
+            params.compiled().ik_sampling_threads))
+    {
+        SMPL_WARN_NAMED(PI_LOGGER, "Failed to enable IK sampling. Using a single IK seed");
+    }
+    actions.setClearanceScaling(
+            params.compiled().clearance_scaling_min,
+            params.compiled().clearance_scaling_max,
+            params.compiled().clearance_scaling_max_scale);
+    if (!actions.useClearanceScaling(params.compiled().use_clearance_scaling)) {
+        SMPL_WARN_NAMED(PI_LOGGER, "Failed to enable clearance scaling of motion primitives");
+    }
     actions.useAmp(MotionPrimitive::SNAP_TO_XYZ, action_params.use_xyz_snap_mprim);
     actions.useAmp(MotionPrimitive::SNAP_TO_RPY, action_params.use_rpy_snap_mprim);
     actions.useAmp(MotionPrimitive::SNAP_TO_XYZ_RPY, action_params.use_xyzrpy_snap_mprim);
@@ -292,10 +343,13 @@ auto MakeManipLatticeEGraph(
         return nullptr;
     }
 
-    std::string egraph_path;
-    if (params.getParam("egraph_path", egraph_path)) {
+    space->setExperienceGraphLoadThreadCount(
+            params.compiled().egraph_load_threads);
+
+    auto& egraph_path = params.compiled().egraph_path;
+    if (egraph_path) {
         // warning printed within, allow to fail silently
-        (void)space->loadExperienceGraph(egraph_path);
+        (void)space->loadExperienceGraph(*egraph_path);
     } else {
         SMPL_WARN("No experience graph file parameter");
     }
@@ -310,13 +364,13 @@ bool GetWorkspaceLatticeParams(
     const RedundantManipulatorInterface* rmi,
     WorkspaceLatticeBase::Params* wsp)
 {
-    std::string disc_string;
-    if (!params.getParam("discretization", disc_string)) {
+    auto& disc_string = params.compiled().discretization;
+    if (!disc_string) {
         SMPL_ERROR_NAMED(PI_LOGGER, "Parameter 'discretization' not found in planning params");
         return false;
     }
 
-    auto disc = ParseMapFromString<double>(disc_string);
+    auto disc = ParseMapFromString<double>(*disc_string);
     SMPL_DEBUG_NAMED(PI_LOGGER, "Parsed discretization for %zu variables", disc.size());
 
     auto extract_disc = [&](const char* name, double* d)
@@ -397,6 +451,14 @@ auto MakeWorkspaceLattice(
         return NULL;
     }
 
+    space->useIkCache(params.compiled().use_ik_cache);
+    if (!space->setIkSampling(
+            params.compiled().ik_sampling_seeds,
+            params.compiled().ik_sampling_threads))
+    {
+        SMPL_WARN_NAMED(PI_LOGGER, "Failed to enable IK sampling. Using a single IK seed");
+    }
+
     space->setVisualizationFrameId(grid->getReferenceFrame());
 
     return std::move(space);
@@ -437,12 +499,20 @@ auto MakeWorkspaceLatticeEGraph(
         return NULL;
     }
 
+    space->useIkCache(params.compiled().use_ik_cache);
+    if (!space->setIkSampling(
+            params.compiled().ik_sampling_seeds,
+            params.compiled().ik_sampling_threads))
+    {
+        SMPL_WARN_NAMED(PI_LOGGER, "Failed to enable IK sampling. Using a single IK seed");
+    }
+
     space->setVisualizationFrameId(grid->getReferenceFrame());
 
-    std::string egraph_path;
-    if (params.getParam("egraph_path", egraph_path)) {
+    auto& egraph_path = params.compiled().egraph_path;
+    if (egraph_path) {
         // warning printed within, allow to fail silently
-        (void)space->loadExperienceGraph(egraph_path);
+        (void)space->loadExperienceGraph(*egraph_path);
     } else {
         SMPL_WARN("No experience graph file parameter");
     }
@@ -490,18 +560,15 @@ auto MakeMultiFrameBFSHeuristic(
 {
     auto h = make_unique<MultiFrameBfsHeuristic>();
     h->setCostPerCell(params.cost_per_cell);
-    double inflation_radius;
-    params.param("bfs_inflation_radius", inflation_radius, 0.0);
-    h->setInflationRadius(inflation_radius);
+    h->setInflationRadius(params.compiled().bfs_inflation_radius);
+    h->setThreadCount(params.compiled().bfs_threads);
+    h->setEeCellScale(params.compiled().mfbfs_ee_cell_scale);
     if (!h->init(space, grid)) {
         return nullptr;
     }
 
-    double offset_x, offset_y, offset_z;
-    params.param("offset_x", offset_x, 0.0);
-    params.param("offset_y", offset_y, 0.0);
-    params.param("offset_z", offset_z, 0.0);
-    h->setOffset(offset_x, offset_y, offset_z);
+    auto& cp = params.compiled();
+    h->setOffset(cp.offset_x, cp.offset_y, cp.offset_z);
 
     return std::move(h);
 }
@@ -514,9 +581,42 @@ auto MakeBFSHeuristic(
 {
     auto h = make_unique<BfsHeuristic>();
     h->setCostPerCell(params.cost_per_cell);
-    double inflation_radius;
-    params.param("bfs_inflation_radius", inflation_radius, 0.0);
-    h->setInflationRadius(inflation_radius);
+    h->setInflationRadius(params.compiled().bfs_inflation_radius);
+    h->setThreadCount(params.compiled().bfs_threads);
+    if (!h->init(space, grid)) {
+        return nullptr;
+    }
+    return std::move(h);
+};
+
+auto MakePoseBFSHeuristic(
+    RobotPlanningSpace* space,
+    const PlanningParams& params,
+    const OccupancyGrid* grid)
+    -> std::unique_ptr<RobotHeuristic>
+{
+    auto h = make_unique<PoseBfsHeuristic>();
+    h->setCostPerCell(params.cost_per_cell);
+    h->setInflationRadius(params.compiled().bfs_inflation_radius);
+    h->setThreadCount(params.compiled().bfs_threads);
+    if (!h->init(space, grid)) {
+        return nullptr;
+    }
+    return std::move(h);
+};
+
+auto MakeSoftBFSHeuristic(
+    RobotPlanningSpace* space,
+    const PlanningParams& params,
+    const OccupancyGrid* grid)
+    -> std::unique_ptr<RobotHeuristic>
+{
+    auto h = make_unique<SoftBfsHeuristic>();
+    h->setCostPerCell(params.cost_per_cell);
+    h->setInflationRadius(params.compiled().bfs_inflation_radius);
+    h->setClearance(params.compiled().soft_bfs_clearance);
+    h->setClearanceWeight(params.compiled().soft_bfs_clearance_weight);
+    h->setThreadCount(params.compiled().bfs_threads);
     if (!h->init(space, grid)) {
         return nullptr;
     }
@@ -534,16 +634,11 @@ auto MakeEuclidDistHeuristic(
         return nullptr;
     }
 
-    double wx, wy, wz, wr;
-    params.param("x_coeff", wx, 1.0);
-    params.param("y_coeff", wy, 1.0);
-    params.param("z_coeff", wz, 1.0);
-    params.param("rot_coeff", wr, 1.0);
-
-    h->setWeightX(wx);
-    h->setWeightY(wy);
-    h->setWeightZ(wz);
-    h->setWeightRot(wr);
+    auto& cp = params.compiled();
+    h->setWeightX(cp.x_coeff);
+    h->setWeightY(cp.y_coeff);
+    h->setWeightZ(cp.z_coeff);
+    h->setWeightRot(cp.rot_coeff);
     return std::move(h);
 };
 
@@ -559,6 +654,31 @@ auto MakeJointDistHeuristic(
     return std::move(h);
 };
 
+auto MakeDubinsHeuristic(
+    RobotPlanningSpace* space,
+    const PlanningParams& params)
+    -> std::unique_ptr<RobotHeuristic>
+{
+    auto h = make_unique<DubinsHeuristic>();
+    if (!h->init(space)) {
+        return nullptr;
+    }
+
+    auto& cp = params.compiled();
+    h->setTurningRadius(cp.turning_radius);
+
+    if (cp.dubins_table_extent > 0.0 &&
+        !h->setLookupTable(
+                cp.dubins_table_extent,
+                cp.dubins_table_res,
+                cp.dubins_table_headings))
+    {
+        return nullptr;
+    }
+
+    return std::move(h);
+};
+
 auto MakeDijkstraEgraphHeuristic3D(
     RobotPlanningSpace* space,
     const PlanningParams& params,
@@ -568,16 +688,13 @@ auto MakeDijkstraEgraphHeuristic3D(
     auto h = make_unique<DijkstraEgraphHeuristic3D>();
 
 //    h->setCostPerCell(params.cost_per_cell);
-    double inflation_radius;
-    params.param("bfs_inflation_radius", inflation_radius, 0.0);
-    h->setInflationRadius(inflation_radius);
+    h->setInflationRadius(params.compiled().bfs_inflation_radius);
+    h->setThreadCount(params.compiled().bfs_threads);
     if (!h->init(space, grid)) {
         return nullptr;
     }
 
-    double egw;
-    params.param("egraph_epsilon", egw, 1.0);
-    h->setWeightEGraph(egw);
+    h->setWeightEGraph(params.compiled().egraph_epsilon);
 
     return std::move(h);
 };
@@ -596,58 +713,85 @@ auto MakeJointDistEGraphHeuristic(
         return nullptr;
     }
 
-    double egw;
-    params.param("egraph_epsilon", egw, 1.0);
-    h->setWeightEGraph(egw);
+    h->setWeightEGraph(params.compiled().egraph_epsilon);
     return std::move(h);
 };
 
-auto MakeARAStar(
-    RobotPlanningSpace* space,
-    RobotHeuristic* heuristic,
-    const PlanningParams& params)
-    -> std::unique_ptr<SBPLPlanner>
+template <class Search>
+static void ConfigureARAStar(Search* search, const PlanningParams& params)
 {
-    auto search = make_unique<ARAStar>(space, heuristic);
+    auto& cp = params.compiled();
 
-    double epsilon;
-    params.param("epsilon", epsilon, 1.0);
-    search->set_initialsolution_eps(epsilon);
+    search->set_initialsolution_eps(cp.epsilon);
+    search->set_search_mode(cp.search_mode);
 
-    bool search_mode;
-    params.param("search_mode", search_mode, false);
-    search->set_search_mode(search_mode);
+    if (cp.allow_partial_solutions) {
+        search->allowPartialSolutions(*cp.allow_partial_solutions);
+    }
 
-    bool allow_partial_solutions;
-    if (params.getParam("allow_partial_solutions", allow_partial_solutions)) {
-        search->allowPartialSolutions(allow_partial_solutions);
+    if (cp.backward_search) {
+        search->setBackwardSearch(*cp.backward_search);
     }
 
-    double target_eps;
-    if (params.getParam("target_epsilon", target_eps)) {
-        search->setTargetEpsilon(target_eps);
+    if (cp.target_epsilon) {
+        search->setTargetEpsilon(*cp.target_epsilon);
     }
 
-    double delta_eps;
-    if (params.getParam("delta_epsilon", delta_eps)) {
-        search->setDeltaEpsilon(delta_eps);
+    if (cp.delta_epsilon) {
+        search->setDeltaEpsilon(*cp.delta_epsilon);
     }
 
-    bool improve_solution;
-    if (params.getParam("improve_solution", improve_solution)) {
-        search->setImproveSolution(improve_solution);
+    if (cp.improve_solution) {
+        search->setImproveSolution(*cp.improve_solution);
     }
 
-    bool bound_expansions;
-    if (params.getParam("bound_expansions", bound_expansions)) {
-        search->setBoundExpansions(bound_expansions);
+    if (cp.bound_expansions) {
+        search->setBoundExpansions(*cp.bound_expansions);
     }
 
-    double repair_time;
-    if (params.getParam("repair_time", repair_time)) {
-        search->setAllowedRepairTime(repair_time);
+    if (cp.repair_time) {
+        search->setAllowedRepairTime(*cp.repair_time);
+    }
+    if (cp.search_memory_limit) {
+        search->setMemoryLimit((std::size_t)(*cp.search_memory_limit * 1024.0 * 1024.0));
     }
 
+    if (cp.goal_set_search) {
+        search->setGoalSetSearch(*cp.goal_set_search);
+    }
+
+    // stop at the first goal reached if goal_set_count is 0, or at the best
+    // goal_set_count goals otherwise
+    if (cp.goal_set_count) {
+        if (*cp.goal_set_count <= 0) {
+            search->setGoalSetTermination(Search::GoalSetTermination::FirstGoal);
+        } else {
+            search->setGoalSetTermination(
+                    Search::GoalSetTermination::BestGoals, *cp.goal_set_count);
+        }
+    }
+}
+
+auto MakeARAStar(
+    RobotPlanningSpace* space,
+    RobotHeuristic* heuristic,
+    const PlanningParams& params)
+    -> std::unique_ptr<SBPLPlanner>
+{
+    auto& open_list = params.compiled().open_list;
+
+    if (open_list == "bucket") {
+        auto search = make_unique<BucketARAStar>(space, heuristic);
+        ConfigureARAStar(search.get(), params);
+        return std::move(search);
+    }
+
+    if (open_list != "heap") {
+        SMPL_WARN_NAMED(PI_LOGGER, "Unrecognized open list type '%s'. Defaulting to 'heap'", open_list.c_str());
+    }
+
+    auto search = make_unique<ARAStar>(space, heuristic);
+    ConfigureARAStar(search.get(), params);
     return std::move(search);
 }
 
@@ -657,10 +801,32 @@ auto MakeAWAStar(
     const PlanningParams& params)
     -> std::unique_ptr<SBPLPlanner>
 {
+    auto& cp = params.compiled();
+
     auto search = make_unique<AWAStar>(space, heuristic);
-    double epsilon;
-    params.param("epsilon", epsilon, 1.0);
-    search->set_initialsolution_eps(epsilon);
+    search->set_initialsolution_eps(cp.epsilon);
+    return std::move(search);
+}
+
+auto MakeANAStar(
+    RobotPlanningSpace* space,
+    RobotHeuristic* heuristic,
+    const PlanningParams& params)
+    -> std::unique_ptr<SBPLPlanner>
+{
+    auto& cp = params.compiled();
+
+    auto search = make_unique<ANAStar>(space, heuristic);
+    search->set_search_mode(cp.search_mode);
+
+    if (cp.improve_solution) {
+        search->setImproveSolution(*cp.improve_solution);
+    }
+
+    if (cp.search_memory_limit) {
+        search->setMemoryLimit((std::size_t)(*cp.search_memory_limit * 1024.0 * 1024.0));
+    }
+
     return std::move(search);
 }
 
@@ -670,6 +836,8 @@ auto MakeMHAStar(
     const PlanningParams& params)
     -> std::unique_ptr<SBPLPlanner>
 {
+    auto& cp = params.compiled();
+
     struct MHAPlannerAdapter : public MHAPlanner {
         std::vector<Heuristic*> heuristics;
 
@@ -691,17 +859,9 @@ auto MakeMHAStar(
 
     search->heuristics = std::move(heuristics);
 
-    double mha_eps;
-    params.param("epsilon_mha", mha_eps, 1.0);
-    search->set_initial_mha_eps(mha_eps);
-
-    double epsilon;
-    params.param("epsilon", epsilon, 1.0);
-    search->set_initialsolution_eps(epsilon);
-
-    bool search_mode;
-    params.param("search_mode", search_mode, false);
-    search->set_search_mode(search_mode);
+    search->set_initial_mha_eps(cp.epsilon_mha);
+    search->set_initialsolution_eps(cp.epsilon);
+    search->set_search_mode(cp.search_mode);
 
     return std::move(search);
 }
@@ -712,14 +872,12 @@ auto MakeLARAStar(
     const PlanningParams& params)
     -> std::unique_ptr<SBPLPlanner>
 {
+    auto& cp = params.compiled();
+
     auto forward_search = true;
     auto search = make_unique<LazyARAPlanner>(space, forward_search);
-    double epsilon;
-    params.param("epsilon", epsilon, 1.0);
-    search->set_initialsolution_eps(epsilon);
-    bool search_mode;
-    params.param("search_mode", search_mode, false);
-    search->set_search_mode(search_mode);
+    search->set_initialsolution_eps(cp.epsilon);
+    search->set_search_mode(cp.search_mode);
     return std::move(search);
 }
 
@@ -729,11 +887,20 @@ auto MakeEGWAStar(
     const PlanningParams& params)
     -> std::unique_ptr<SBPLPlanner>
 {
+    auto& cp = params.compiled();
+
     auto search = make_unique<ExperienceGraphPlanner>(space, heuristic);
 
-    double epsilon;
-    params.param("epsilon", epsilon, 1.0);
-    search->set_initialsolution_eps(epsilon);
+    search->set_initialsolution_eps(cp.epsilon);
+    search->setEGraphSuccessorPeriod(cp.egraph_successor_period);
+
+    if (cp.adaptive_egraph) {
+        search->setWeightEGraphBounds(
+                cp.min_egraph_epsilon, cp.max_egraph_epsilon);
+        search->setAdaptationWindow(cp.egraph_adaptation_window);
+
+        search->setAdaptive(true);
+    }
 
     return std::move(search);
 }
@@ -744,15 +911,13 @@ auto MakePADAStar(
     const PlanningParams& params)
     -> std::unique_ptr<SBPLPlanner>
 {
-    auto search = make_unique<AdaptivePlanner>(space, heuristic);
+    auto& cp = params.compiled();
 
-    double epsilon_plan;
-    params.param("epsilon_plan", epsilon_plan, 1.0);
-    search->set_plan_eps(epsilon_plan);
+    auto search = make_unique<AdaptivePlanner>(space, heuristic);
 
-    double epsilon_track;
-    params.param("epsilon_track", epsilon_track, 1.0);
-    search->set_track_eps(epsilon_track);
+    search->set_plan_eps(cp.epsilon_plan);
+    search->set_track_eps(cp.epsilon_track);
+    search->set_pipelining(cp.pipeline_plan_track);
 
     AdaptivePlanner::TimeParameters tparams;
     tparams.planning.bounded = true;
@@ -772,5 +937,75 @@ auto MakePADAStar(
     return std::move(search);
 }
 
-} // namespace smpl
+auto MakePASE(
+    RobotPlanningSpace* space,
+    RobotHeuristic* heuristic,
+    const PlanningParams& params)
+    -> std::unique_ptr<SBPLPlanner>
+{
+    auto& cp = params.compiled();
+
+    auto search = make_unique<PASE>(space, heuristic);
 
+    search->setThreadCount(cp.thread_count);
+    search->allowConcurrentSuccessors(cp.concurrent_successors);
+
+    search->set_initialsolution_eps(cp.epsilon);
+
+    search->setIndependenceEpsilon(cp.independence_epsilon);
+
+    search->set_search_mode(cp.search_mode);
+
+    if (cp.target_epsilon) {
+        search->setTargetEpsilon(*cp.target_epsilon);
+    }
+
+    if (cp.delta_epsilon) {
+        search->setDeltaEpsilon(*cp.delta_epsilon);
+    }
+
+    if (cp.improve_solution) {
+        search->setImproveSolution(*cp.improve_solution);
+    }
+
+    return std::move(search);
+}
+
+auto MakeLPAStar(
+    RobotPlanningSpace* space,
+    RobotHeuristic* heuristic,
+    const PlanningParams& params)
+    -> std::unique_ptr<SBPLPlanner>
+{
+    auto& cp = params.compiled();
+
+    auto search = make_unique<LPAStar>(space, heuristic);
+
+    search->set_initialsolution_eps(cp.epsilon);
+
+    search->set_search_mode(cp.search_mode);
+
+    return std::move(search);
+}
+
+auto MakeBidirectionalWAStar(
+    RobotPlanningSpace* space,
+    RobotHeuristic* heuristic,
+    const PlanningParams& params)
+    -> std::unique_ptr<SBPLPlanner>
+{
+    auto& cp = params.compiled();
+
+    auto search = make_unique<BidirectionalWAStar>(space, heuristic);
+
+    search->setThreadCount(cp.thread_count);
+    search->allowConcurrentSuccessors(cp.concurrent_successors);
+
+    search->set_initialsolution_eps(cp.epsilon);
+
+    search->set_search_mode(cp.search_mode);
+
+    return std::move(search);
+}
+
+} // namespace smpl
@@ -0,0 +1,417 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+/// \author Andrew Dornbush
+
+#include <smpl/ros/metrics_exporter.h>
+
+// standard includes
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+// system includes
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <smpl/console/console.h>
+
+// project includes
+#include <smpl/telemetry.h>
+
+namespace smpl {
+
+static const char* LOG = "metrics";
+
+const double MetricsExporter::LatencyBounds[MetricsExporter::LatencyBoundCount] = {
+    0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0, 30.0, 60.0
+};
+
+auto to_cstring(MemoryComponent component) -> const char*
+{
+    switch (component) {
+    case MemoryComponent::PlanningSpace:    return "planning_space";
+    case MemoryComponent::Heuristic:        return "heuristic";
+    case MemoryComponent::Search:           return "search";
+    case MemoryComponent::CollisionChecker: return "collision_checker";
+    case MemoryComponent::DistanceMap:      return "distance_map";
+    default:                                return "<unknown>";
+    }
+}
+
+// hot-path events, by label, and whether their durations are recorded
+static const struct
+{
+    TelemetryEvent event;
+    const char* name;
+    bool timed;
+} HotPathEvents[] = {
+    { TelemetryEvent::Expansion,            "expansion",            true },
+    { TelemetryEvent::SuccessorGenerated,   "successor",            false },
+    { TelemetryEvent::StateCheck,           "state_check",          true },
+    { TelemetryEvent::MotionCheck,          "motion_check",         true },
+    { TelemetryEvent::ForwardKinematics,    "forward_kinematics",   true },
+    { TelemetryEvent::HeuristicEvaluation,  "heuristic_evaluation", true },
+};
+
+static const struct
+{
+    TelemetryEvent hit;
+    TelemetryEvent miss;
+    const char* name;
+} CacheEvents[] = {
+    { TelemetryEvent::IkCacheHit,           TelemetryEvent::IkCacheMiss,        "ik" },
+    { TelemetryEvent::HeuristicCacheHit,    TelemetryEvent::HeuristicCacheMiss, "heuristic" },
+    { TelemetryEvent::ResultCacheHit,       TelemetryEvent::ResultCacheMiss,    "result" },
+};
+
+// Return the resident set size of this process, or 0 if it is not available.
+static
+auto ResidentMemoryBytes() -> std::size_t
+{
+    auto* f = std::fopen("/proc/self/statm", "r");
+    if (f == NULL) {
+        return 0;
+    }
+    unsigned long size, resident;
+    auto read = std::fscanf(f, "%lu %lu", &size, &resident);
+    std::fclose(f);
+    if (read != 2) {
+        return 0;
+    }
+    return (std::size_t)resident * (std::size_t)sysconf(_SC_PAGESIZE);
+}
+
+// Escape a label value for the text exposition format.
+static
+auto EscapeLabel(const std::string& value) -> std::string
+{
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (auto c : value) {
+        switch (c) {
+        case '\\':  escaped += "\\\\"; break;
+        case '"':   escaped += "\\\""; break;
+        case '\n':  escaped += "\\n"; break;
+        default:    escaped += c; break;
+        }
+    }
+    return escaped;
+}
+
+static
+void WriteHeader(std::ostream& o, const char* name, const char* type, const char* help)
+{
+    o << "# HELP " << name << ' ' << help << '\n';
+    o << "# TYPE " << name << ' ' << type << '\n';
+}
+
+MetricsExporter::PlannerSeries::PlannerSeries()
+{
+    solved.store(0, std::memory_order_relaxed);
+    failed.store(0, std::memory_order_relaxed);
+    for (auto& c : latency_buckets) {
+        c.store(0, std::memory_order_relaxed);
+    }
+    latency_ns.store(0, std::memory_order_relaxed);
+    for (auto& m : memory) {
+        m.store(0, std::memory_order_relaxed);
+    }
+}
+
+MetricsExporter::MetricsExporter() :
+    m_planner_count(0),
+    m_listen_fd(-1),
+    m_port(0),
+    m_running(false)
+{
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    stop();
+}
+
+bool MetricsExporter::start(int port)
+{
+    stop();
+
+    auto fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        SMPL_ERROR_NAMED(LOG, "Failed to create metrics socket: %s", std::strerror(errno));
+        return false;
+    }
+
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((std::uint16_t)port);
+    if (bind(fd, (const sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, 8) < 0) {
+        SMPL_ERROR_NAMED(LOG, "Failed to serve metrics on port %d: %s", port, std::strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    m_listen_fd = fd;
+    m_port = port;
+    m_running = true;
+    m_server = std::thread([this]() { serve(); });
+    SMPL_INFO_NAMED(LOG, "Serve metrics on port %d", port);
+    return true;
+}
+
+void MetricsExporter::stop()
+{
+    if (!m_server.joinable()) {
+        return;
+    }
+    m_running = false;
+    m_server.join();
+    close(m_listen_fd);
+    m_listen_fd = -1;
+    m_port = 0;
+}
+
+void MetricsExporter::recordRequest(
+    const std::string& planner_id,
+    double seconds,
+    bool solved)
+{
+    auto* series = plannerSeries(planner_id);
+    if (series == NULL) {
+        return;
+    }
+
+    (solved ? series->solved : series->failed).fetch_add(1, std::memory_order_relaxed);
+
+    auto b = 0;
+    while (b < LatencyBoundCount && seconds > LatencyBounds[b]) {
+        ++b;
+    }
+    series->latency_buckets[b].fetch_add(1, std::memory_order_relaxed);
+    series->latency_ns.fetch_add(
+            (std::uint64_t)(std::max(seconds, 0.0) * 1e9),
+            std::memory_order_relaxed);
+}
+
+void MetricsExporter::recordMemoryUsage(
+    const std::string& planner_id,
+    MemoryComponent component,
+    std::size_t bytes)
+{
+    auto* series = plannerSeries(planner_id);
+    if (series == NULL) {
+        return;
+    }
+    series->memory[(int)component].store(bytes, std::memory_order_relaxed);
+}
+
+auto MetricsExporter::render() const -> std::string
+{
+    std::ostringstream o;
+    o << std::setprecision(12);
+
+    auto telemetry = GetTelemetry();
+
+    WriteHeader(o, "smpl_events_total", "counter",
+            "Hot-path events across all planning threads.");
+    for (auto& e : HotPathEvents) {
+        o << "smpl_events_total{event=\"" << e.name << "\"} " << telemetry.count(e.event) << '\n';
+    }
+
+    WriteHeader(o, "smpl_event_seconds_total", "counter",
+            "Time spent in timed hot-path events. Events may nest, so times are not additive across events.");
+    for (auto& e : HotPathEvents) {
+        if (e.timed) {
+            o << "smpl_event_seconds_total{event=\"" << e.name << "\"} " << telemetry.seconds(e.event) << '\n';
+        }
+    }
+
+    WriteHeader(o, "smpl_cache_lookups_total", "counter",
+            "Cache lookups by cache and outcome.");
+    for (auto& c : CacheEvents) {
+        o << "smpl_cache_lookups_total{cache=\"" << c.name << "\",outcome=\"hit\"} " << telemetry.count(c.hit) << '\n';
+        o << "smpl_cache_lookups_total{cache=\"" << c.name << "\",outcome=\"miss\"} " << telemetry.count(c.miss) << '\n';
+    }
+
+    auto planner_count = m_planner_count.load(std::memory_order_acquire);
+
+    WriteHeader(o, "smpl_requests_total", "counter",
+            "Planning requests by planner id and outcome.");
+    for (int i = 0; i < planner_count; ++i) {
+        auto& series = m_planners[i];
+        auto id = EscapeLabel(series.planner_id);
+        o << "smpl_requests_total{planner_id=\"" << id << "\",result=\"solved\"} " << series.solved.load(std::memory_order_relaxed) << '\n';
+        o << "smpl_requests_total{planner_id=\"" << id << "\",result=\"failed\"} " << series.failed.load(std::memory_order_relaxed) << '\n';
+    }
+
+    WriteHeader(o, "smpl_request_latency_seconds", "histogram",
+            "Planning request latency by planner id.");
+    for (int i = 0; i < planner_count; ++i) {
+        auto& series = m_planners[i];
+        auto id = EscapeLabel(series.planner_id);
+        auto cumulative = std::uint64_t(0);
+        for (int b = 0; b <= LatencyBoundCount; ++b) {
+            cumulative += series.latency_buckets[b].load(std::memory_order_relaxed);
+            o << "smpl_request_latency_seconds_bucket{planner_id=\"" << id << "\",le=\"";
+            if (b < LatencyBoundCount) {
+                o << LatencyBounds[b];
+            } else {
+                o << "+Inf";
+            }
+            o << "\"} " << cumulative << '\n';
+        }
+        o << "smpl_request_latency_seconds_sum{planner_id=\"" << id << "\"} " << 1e-9 * (double)series.latency_ns.load(std::memory_order_relaxed) << '\n';
+        o << "smpl_request_latency_seconds_count{planner_id=\"" << id << "\"} " << cumulative << '\n';
+    }
+
+    WriteHeader(o, "smpl_memory_bytes", "gauge",
+            "Bytes held by planner components after the latest request, by planner id.");
+    for (int i = 0; i < planner_count; ++i) {
+        auto& series = m_planners[i];
+        auto id = EscapeLabel(series.planner_id);
+        for (int c = 0; c < MemoryComponentCount; ++c) {
+            o << "smpl_memory_bytes{planner_id=\"" << id << "\",component=\"" << to_cstring((MemoryComponent)c) << "\"} " << series.memory[c].load(std::memory_order_relaxed) << '\n';
+        }
+    }
+
+    WriteHeader(o, "process_resident_memory_bytes", "gauge",
+            "Resident memory size in bytes.");
+    o << "process_resident_memory_bytes " << ResidentMemoryBytes() << '\n';
+
+    return o.str();
+}
+
+// Return the series of a planner id, publishing a new one if needed, or NULL
+// if the maximum number of series has been published.
+auto MetricsExporter::plannerSeries(const std::string& planner_id)
+    -> PlannerSeries*
+{
+    auto count = m_planner_count.load(std::memory_order_acquire);
+    for (int i = 0; i < count; ++i) {
+        if (m_planners[i].planner_id == planner_id) {
+            return &m_planners[i];
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_register_mutex);
+    count = m_planner_count.load(std::memory_order_relaxed);
+    for (int i = 0; i < count; ++i) {
+        if (m_planners[i].planner_id == planner_id) {
+            return &m_planners[i];
+        }
+    }
+
+    if (count == MaxPlannerCount) {
+        SMPL_WARN_ONCE_NAMED(LOG, "Metrics are not reported for more than %d planner ids", MaxPlannerCount);
+        return NULL;
+    }
+
+    m_planners[count].planner_id = planner_id;
+    m_planner_count.store(count + 1, std::memory_order_release);
+    return &m_planners[count];
+}
+
+// Accept and answer scrapes one at a time until stopped. The listening socket
+// is polled with a timeout so that stop() is noticed promptly.
+void MetricsExporter::serve()
+{
+    while (m_running) {
+        pollfd pfd;
+        pfd.fd = m_listen_fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, 100) <= 0) {
+            continue;
+        }
+
+        auto fd = accept(m_listen_fd, NULL, NULL);
+        if (fd < 0) {
+            continue;
+        }
+
+        // a stalled client may hold up later scrapes, but never planning
+        timeval timeout;
+        timeout.tv_sec = 1;
+        timeout.tv_usec = 0;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        respond(fd);
+        close(fd);
+    }
+}
+
+void MetricsExporter::respond(int fd) const
+{
+    // only the request line matters; headers and any body are ignored
+    std::string request;
+    char buf[1024];
+    while (request.find("\r\n") == std::string::npos && request.size() < 8192) {
+        auto n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) {
+            break;
+        }
+        request.append(buf, n);
+    }
+
+    std::string response;
+    if (request.compare(0, 13, "GET /metrics ") == 0 ||
+        request.compare(0, 6, "GET / ") == 0)
+    {
+        auto body = render();
+        response = "HTTP/1.0 200 OK\r\n"
+                "Content-Type: text/plain; version=0.0.4\r\n"
+                "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                "Connection: close\r\n\r\n" + body;
+    } else {
+        response = "HTTP/1.0 404 Not Found\r\n"
+                "Content-Length: 0\r\n"
+                "Connection: close\r\n\r\n";
+    }
+
+    auto sent = std::size_t(0);
+    while (sent < response.size()) {
+        auto n = send(fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            break;
+        }
+        sent += n;
+    }
+}
+
+} // namespace smpl
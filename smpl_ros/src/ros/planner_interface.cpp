@@ -35,8 +35,14 @@
 // standard includes
 #include <assert.h>
 #include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <fstream>
+#include <mutex>
 #include <chrono>
+#include <future>
+#include <sstream>
+#include <thread>
 #include <utility>
 
 // system includes
@@ -45,17 +51,25 @@
 #include <boost/regex.hpp>
 #include <eigen_conversions/eigen_msg.h>
 #include <leatherman/utils.h>
+#include <ros/serialization.h>
 #include <sbpl/planners/mhaplanner.h>
 #include <smpl/angles.h>
 #include <smpl/console/console.h>
 #include <smpl/console/nonstd.h>
 #include <smpl/debug/visualize.h>
+#include <smpl/graph/experience_graph_extension.h>
+#include <smpl/graph/manip_lattice.h>
+#include <smpl/graph/manip_lattice_action_space.h>
+#include <smpl/graph/workspace_lattice.h>
 #include <smpl/heuristic/bfs_heuristic.h>
 #include <smpl/heuristic/egraph_bfs_heuristic.h>
 #include <smpl/heuristic/multi_frame_bfs_heuristic.h>
+#include <smpl/memory_usage.h>
 #include <smpl/post_processing.h>
+#include <smpl/search/arastar.h>
 #include <smpl/stl/memory.h>
 #include <smpl/time.h>
+#include <smpl/tracing.h>
 #include <smpl/types.h>
 #include <trajectory_msgs/JointTrajectory.h>
 
@@ -66,6 +80,9 @@ namespace smpl {
 
 const char* PI_LOGGER = "simple";
 
+// requests with this planner id are planned by the portfolio
+static const char* PORTFOLIO_PLANNER_ID = "portfolio";
+
 static
 bool HasVisibilityConstraints(const moveit_msgs::Constraints& constraints)
 {
@@ -185,6 +202,9 @@ PlannerInterface::PlannerInterface(
     m_robot(robot),
     m_checker(checker),
     m_grid(grid),
+    m_user_checker(checker),
+    m_motion_cache(),
+    m_cached_checker(),
     m_fk_iface(nullptr),
     m_params(),
     m_initialized(false),
@@ -192,7 +212,49 @@ PlannerInterface::PlannerInterface(
     m_heuristics(),
     m_planner(),
     m_sol_cost(INFINITECOST),
-    m_planner_id()
+    m_planner_id(),
+    m_reuse_pipelines(false),
+    m_parallel_setup(false),
+    m_heuristic_updates(),
+    m_share_bfs(false),
+    m_bfs_registry(),
+    m_shortcut_threads(1),
+    m_shortcut_time(0.0),
+    m_anytime_smoothing(false),
+    m_optimize_iterations(0),
+    m_optimize_clearance(0.1),
+    m_start_repair_iterations(0),
+    m_start_repair_clearance(0.05),
+    m_start_repair_step(0.05),
+    m_unrepaired_start(),
+    m_reachability_map(),
+    m_trapezoidal_timing(false),
+    m_junction_deviation(0.01),
+    m_prefix_callback(),
+    m_stream_waypoint_count(0),
+    m_egraph_record(false),
+    m_egraph_merge_radius(0.0),
+    m_warm_start(false),
+    m_warm_start_radius(0.0),
+    m_warm_goal(),
+    m_warm_path(),
+    m_result_cache_size(0),
+    m_result_cache(),
+    m_resume_searches(false),
+    m_resuming(false),
+    m_checkpoint(),
+    m_batch_threads(1),
+    m_batch_pool(),
+    m_batch_mutex(),
+    m_batch_workers(),
+    m_batch_cancelled(false),
+    m_pipelines(),
+    m_portfolio_ids(),
+    m_portfolio_contexts(),
+    m_portfolio(),
+    m_portfolio_active(-1),
+    m_trace_output(),
+    m_metrics()
 {
     if (m_robot) {
         m_fk_iface = m_robot->getExtension<ForwardKinematicsInterface>();
@@ -257,13 +319,37 @@ PlannerInterface::PlannerInterface(
         RobotPlanningSpace* space,
         const PlanningParams& p)
     {
-        return MakeBFSHeuristic(space, p, m_grid);
+        auto h = MakeBFSHeuristic(space, p, m_grid);
+        if (h && m_share_bfs) {
+            static_cast<BfsHeuristic*>(h.get())->setSearchRegistry(&m_bfs_registry);
+        }
+        return h;
+    };
+
+    m_heuristic_factories["pose_bfs"] = [this](
+        RobotPlanningSpace* space,
+        const PlanningParams& p)
+    {
+        auto h = MakePoseBFSHeuristic(space, p, m_grid);
+        if (h && m_share_bfs) {
+            static_cast<BfsHeuristic*>(h.get())->setSearchRegistry(&m_bfs_registry);
+        }
+        return h;
+    };
+
+    m_heuristic_factories["soft_bfs"] = [this](
+        RobotPlanningSpace* space,
+        const PlanningParams& p)
+    {
+        return MakeSoftBFSHeuristic(space, p, m_grid);
     };
 
     m_heuristic_factories["euclid"] = MakeEuclidDistHeuristic;
 
     m_heuristic_factories["joint_distance"] = MakeJointDistHeuristic;
 
+    m_heuristic_factories["dubins"] = MakeDubinsHeuristic;
+
     m_heuristic_factories["bfs_egraph"] = [this](
         RobotPlanningSpace* space,
         const PlanningParams& p)
@@ -279,14 +365,20 @@ PlannerInterface::PlannerInterface(
 
     m_planner_factories["arastar"] = MakeARAStar;
     m_planner_factories["awastar"] = MakeAWAStar;
+    m_planner_factories["anastar"] = MakeANAStar;
     m_planner_factories["mhastar"] = MakeMHAStar;
     m_planner_factories["larastar"] = MakeLARAStar;
     m_planner_factories["egwastar"] = MakeEGWAStar;
     m_planner_factories["padastar"] = MakePADAStar;
+    m_planner_factories["pase"] = MakePASE;
+    m_planner_factories["lpastar"] = MakeLPAStar;
+    m_planner_factories["bwastar"] = MakeBidirectionalWAStar;
 }
 
 PlannerInterface::~PlannerInterface()
 {
+    // destroy the active pipeline before the collision checker it may use
+    restorePortfolioMember();
 }
 
 bool PlannerInterface::init(const PlanningParams& params)
@@ -318,6 +410,140 @@ bool PlannerInterface::init(const PlanningParams& params)
 
     m_params = params;
 
+    m_params.param("reuse_pipelines", m_reuse_pipelines, false);
+    SMPL_INFO_NAMED(PI_LOGGER, "  Reuse Pipelines: %s", m_reuse_pipelines ? "true" : "false");
+
+    m_params.param("parallel_setup", m_parallel_setup, false);
+    SMPL_INFO_NAMED(PI_LOGGER, "  Parallel Setup: %s", m_parallel_setup ? "true" : "false");
+
+    m_params.param("share_bfs", m_share_bfs, false);
+    SMPL_INFO_NAMED(PI_LOGGER, "  Share BFS: %s", m_share_bfs ? "true" : "false");
+
+    // members are rebuilt with the new parameters on the next portfolio
+    // request
+    restorePortfolioMember();
+    m_portfolio.clear();
+    if (m_planner_id == PORTFOLIO_PLANNER_ID) {
+        m_planner_id.clear();
+    }
+
+    std::string portfolio;
+    m_params.param("portfolio", portfolio, std::string());
+    SMPL_INFO_NAMED(PI_LOGGER, "  Portfolio: %s", portfolio.c_str());
+    m_portfolio_ids.clear();
+    std::istringstream portfolio_ss(portfolio);
+    for (std::string planner_id; portfolio_ss >> planner_id; ) {
+        m_portfolio_ids.push_back(planner_id);
+    }
+
+    m_params.param("shortcut_threads", m_shortcut_threads, 1);
+    m_params.param("shortcut_time", m_shortcut_time, 0.0);
+    SMPL_INFO_NAMED(PI_LOGGER, "  Shortcut Threads: %d", m_shortcut_threads);
+    SMPL_INFO_NAMED(PI_LOGGER, "  Shortcut Time: %0.3f", m_shortcut_time);
+    m_params.param("anytime_smoothing", m_anytime_smoothing, false);
+    SMPL_INFO_NAMED(PI_LOGGER, "  Anytime Smoothing: %s", m_anytime_smoothing ? "true" : "false");
+
+    m_params.param("optimize_iterations", m_optimize_iterations, 0);
+    m_params.param("optimize_clearance", m_optimize_clearance, 0.1);
+    SMPL_INFO_NAMED(PI_LOGGER, "  Optimize Iterations: %d", m_optimize_iterations);
+    SMPL_INFO_NAMED(PI_LOGGER, "  Optimize Clearance: %0.3f", m_optimize_clearance);
+
+    m_params.param("start_repair_iterations", m_start_repair_iterations, 0);
+    m_params.param("start_repair_clearance", m_start_repair_clearance, 0.05);
+    m_params.param("start_repair_step", m_start_repair_step, 0.05);
+    SMPL_INFO_NAMED(PI_LOGGER, "  Start Repair Iterations: %d", m_start_repair_iterations);
+    SMPL_INFO_NAMED(PI_LOGGER, "  Start Repair Clearance: %0.3f", m_start_repair_clearance);
+    SMPL_INFO_NAMED(PI_LOGGER, "  Start Repair Step: %0.3f", m_start_repair_step);
+
+    std::string reachability_map;
+    m_params.param("reachability_map", reachability_map, std::string());
+    SMPL_INFO_NAMED(PI_LOGGER, "  Reachability Map: %s", reachability_map.c_str());
+    m_reachability_map.clear();
+    if (!reachability_map.empty()) {
+        if (!m_reachability_map.load(reachability_map)) {
+            SMPL_WARN_NAMED(PI_LOGGER, "Failed to load reachability map. Goals will not be screened");
+        } else if (m_reachability_map.dof() != m_robot->jointVariableCount()) {
+            SMPL_WARN_NAMED(PI_LOGGER, "Reachability map has %zu variables (expected %zu). Goals will not be screened", m_reachability_map.dof(), m_robot->jointVariableCount());
+            m_reachability_map.clear();
+        }
+    }
+
+    m_params.param("trapezoidal_timing", m_trapezoidal_timing, false);
+    m_params.param("junction_deviation", m_junction_deviation, 0.01);
+    SMPL_INFO_NAMED(PI_LOGGER, "  Trapezoidal Timing: %s", m_trapezoidal_timing ? "true" : "false");
+    SMPL_INFO_NAMED(PI_LOGGER, "  Junction Deviation: %0.3f", m_junction_deviation);
+
+    m_params.param("trace_output", m_trace_output, std::string());
+    SMPL_INFO_NAMED(PI_LOGGER, "  Trace Output: %s", m_trace_output.c_str());
+    if (!m_trace_output.empty()) {
+        SetTracingEnabled(true);
+    }
+
+    // port of the metrics endpoint, or 0 for none. a port may be served by
+    // only one interface of a process
+    int metrics_port;
+    m_params.param("metrics_port", metrics_port, 0);
+    SMPL_INFO_NAMED(PI_LOGGER, "  Metrics Port: %d", metrics_port);
+    if (metrics_port <= 0) {
+        m_metrics.reset();
+    } else if (!m_metrics || m_metrics->port() != metrics_port) {
+        m_metrics = std::make_shared<MetricsExporter>();
+        if (!m_metrics->start(metrics_port)) {
+            SMPL_WARN_NAMED(PI_LOGGER, "Failed to start the metrics endpoint");
+            m_metrics.reset();
+        }
+    }
+
+    bool motion_validity_cache;
+    m_params.param("motion_validity_cache", motion_validity_cache, false);
+    SMPL_INFO_NAMED(PI_LOGGER, "  Motion Validity Cache: %s", motion_validity_cache ? "true" : "false");
+    if (motion_validity_cache) {
+        double resolution;
+        m_params.param("motion_validity_cache_resolution", resolution, 1e-6);
+        m_motion_cache.reset(new MotionValidityCache(resolution));
+        m_cached_checker.reset(new CachedCollisionChecker(m_user_checker, m_motion_cache.get()));
+        bool certificates;
+        m_params.param("motion_validity_certificates", certificates, false);
+        SMPL_INFO_NAMED(PI_LOGGER, "  Motion Validity Certificates: %s", certificates ? "true" : "false");
+        m_cached_checker->setCertifyMotions(certificates);
+        m_checker = m_cached_checker.get();
+    } else {
+        m_checker = m_user_checker;
+        m_cached_checker.reset();
+        m_motion_cache.reset();
+    }
+
+    m_params.param("stream_waypoint_count", m_stream_waypoint_count, 0);
+    SMPL_INFO_NAMED(PI_LOGGER, "  Stream Waypoint Count: %d", m_stream_waypoint_count);
+
+    m_params.param("egraph_record", m_egraph_record, false);
+    m_params.param("egraph_merge_radius", m_egraph_merge_radius, 0.0);
+    SMPL_INFO_NAMED(PI_LOGGER, "  Record Experiences: %s", m_egraph_record ? "true" : "false");
+    SMPL_INFO_NAMED(PI_LOGGER, "  Experience Merge Radius: %0.3f", m_egraph_merge_radius);
+
+    m_params.param("warm_start", m_warm_start, false);
+    m_params.param("warm_start_radius", m_warm_start_radius, 0.1);
+    SMPL_INFO_NAMED(PI_LOGGER, "  Warm Start: %s", m_warm_start ? "true" : "false");
+    SMPL_INFO_NAMED(PI_LOGGER, "  Warm Start Radius: %0.3f", m_warm_start_radius);
+    m_warm_path.clear();
+
+    m_params.param("result_cache_size", m_result_cache_size, 0);
+    SMPL_INFO_NAMED(PI_LOGGER, "  Result Cache Size: %d", m_result_cache_size);
+    m_result_cache.clear();
+
+    m_params.param("resume_searches", m_resume_searches, false);
+    SMPL_INFO_NAMED(PI_LOGGER, "  Resume Searches: %s", m_resume_searches ? "true" : "false");
+    m_checkpoint = SearchCheckpoint();
+
+    m_params.param("batch_threads", m_batch_threads, 1);
+    SMPL_INFO_NAMED(PI_LOGGER, "  Batch Threads: %d", m_batch_threads);
+    {
+        // workers are rebuilt with the new parameters on the next batch
+        std::lock_guard<std::mutex> lock(m_batch_mutex);
+        m_batch_pool.reset();
+        m_batch_workers.clear();
+    }
+
     m_initialized = true;
 
     SMPL_INFO_NAMED(PI_LOGGER, "Initialized planner interface");
@@ -348,6 +574,36 @@ void ClearMotionPlanResponse(
     res.error_code.val = moveit_msgs::MoveItErrorCodes::FAILURE;
 }
 
+// Set the cancellation token polled by a pipeline component, if it can be
+// cancelled
+template <class T>
+static
+void SetCancellationToken(T* component, const CancellationToken* token)
+{
+    auto* cancellable = component->template getExtension<CancellationExtension>();
+    if (cancellable != NULL) {
+        cancellable->setCancellationToken(token);
+    }
+}
+
+static
+void SetPipelineCancellationToken(
+    std::map<std::string, std::unique_ptr<RobotHeuristic>>& heuristics,
+    SBPLPlanner* planner,
+    const CancellationToken* token)
+{
+    for (auto& entry : heuristics) {
+        SetCancellationToken(entry.second.get(), token);
+    }
+
+    // SBPLPlanner is not an Extension; planners opt in by also deriving from
+    // CancellationExtension
+    auto* cancellable = dynamic_cast<CancellationExtension*>(planner);
+    if (cancellable != NULL) {
+        cancellable->setCancellationToken(token);
+    }
+}
+
 static
 bool IsPathValid(CollisionChecker* checker, const std::vector<RobotState>& path)
 {
@@ -508,6 +764,37 @@ void ProfilePath(RobotModel* robot, trajectory_msgs::JointTrajectory& traj)
     }
 }
 
+// Time the trajectory with ComputeTrapezoidalTimeParameterization, filling in
+// velocities as well. Falls back to ProfilePath if the trajectory does not
+// match the robot model.
+static
+void ProfilePathTrapezoidal(
+    RobotModel* robot,
+    trajectory_msgs::JointTrajectory& traj,
+    double junction_deviation)
+{
+    std::vector<RobotState> path;
+    path.reserve(traj.points.size());
+    for (auto& point : traj.points) {
+        path.push_back(point.positions);
+    }
+
+    std::vector<double> times;
+    std::vector<RobotState> velocities;
+    if (!ComputeTrapezoidalTimeParameterization(
+            robot, path, times, velocities, junction_deviation))
+    {
+        SMPL_WARN_NAMED(PI_LOGGER, "Failed to time-parameterize trajectory. Fall back to velocity-limited timing");
+        ProfilePath(robot, traj);
+        return;
+    }
+
+    for (size_t i = 0; i < traj.points.size(); ++i) {
+        traj.points[i].time_from_start = ros::Duration(times[i]);
+        traj.points[i].velocities = velocities[i];
+    }
+}
+
 static
 void RemoveZeroDurationSegments(trajectory_msgs::JointTrajectory& traj)
 {
@@ -694,6 +981,154 @@ bool PlannerInterface::solve(
     const moveit_msgs::PlanningScene& planning_scene,
     const moveit_msgs::MotionPlanRequest& req,
     moveit_msgs::MotionPlanResponse& res)
+{
+    bool solved;
+    auto then = clock::now();
+    {
+        SMPL_TRACE_SPAN("solve");
+        solved = solveRequest(planning_scene, req, res);
+    }
+
+    if (m_metrics) {
+        m_metrics->recordRequest(req.planner_id, to_seconds(clock::now() - then), solved);
+        for (int c = 0; c < MemoryComponentCount; ++c) {
+            auto component = (MemoryComponent)c;
+            m_metrics->recordMemoryUsage(req.planner_id, component, memoryUsage(component));
+        }
+    }
+
+    // export every retained span, so each file also covers the requests that
+    // preceded this one
+    if (!m_trace_output.empty() && !WriteChromeTrace(m_trace_output)) {
+        SMPL_WARN_NAMED(PI_LOGGER, "Failed to write trace to '%s'", m_trace_output.c_str());
+    }
+    return solved;
+}
+
+bool PlannerInterface::solveBatch(
+    const moveit_msgs::PlanningScene& planning_scene,
+    const std::vector<moveit_msgs::MotionPlanRequest>& reqs,
+    std::vector<moveit_msgs::MotionPlanResponse>& res,
+    std::vector<std::map<std::string, double>>* stats)
+{
+    res.clear();
+    res.resize(reqs.size());
+    if (stats != nullptr) {
+        stats->clear();
+        stats->resize(reqs.size());
+    }
+
+    m_batch_cancelled = false;
+    if (m_initialized) {
+        initBatchWorkers();
+    }
+
+    // the callback could not tell the requests of the batch apart
+    auto prefix_callback = std::move(m_prefix_callback);
+    m_prefix_callback = nullptr;
+
+    std::vector<char> solved(reqs.size(), 0);
+    auto solve_request = [&](int tid, std::size_t i)
+    {
+        if (m_batch_cancelled.load(std::memory_order_relaxed)) {
+            ClearMotionPlanResponse(reqs[i], res[i]);
+            res[i].error_code.val = moveit_msgs::MoveItErrorCodes::PREEMPTED;
+            return;
+        }
+
+        auto* planner = tid == 0 ? this : m_batch_workers[tid - 1]->planner.get();
+        solved[i] = planner->solve(planning_scene, reqs[i], res[i]);
+        if (stats != nullptr && planner->m_planner) {
+            (*stats)[i] = planner->getPlannerStats();
+        }
+    };
+
+    SMPL_INFO_NAMED(PI_LOGGER, "Solve %zu requests with %zu workers", reqs.size(), m_batch_workers.size() + 1);
+
+    if (m_batch_pool) {
+        m_batch_pool->run(reqs.size(), solve_request);
+    } else {
+        for (size_t i = 0; i < reqs.size(); ++i) {
+            solve_request(0, i);
+        }
+    }
+
+    m_prefix_callback = std::move(prefix_callback);
+
+    return std::all_of(begin(solved), end(solved), [](char s) { return s != 0; });
+}
+
+// Return whether a goal may be reachable according to the reachability map.
+// Tolerances wider than the cells of the map are not screened, since the
+// region they admit is not covered by the neighborhood of a single cell.
+static
+bool IsGoalPlausible(const ReachabilityMap& map, const GoalConstraint& goal)
+{
+    if (map.empty()) {
+        return true;
+    }
+
+    auto res = map.resolution();
+    auto orientation_res = M_PI / map.orientationBins();
+    auto wide_xyz = goal.xyz_tolerance[0] > res ||
+            goal.xyz_tolerance[1] > res ||
+            goal.xyz_tolerance[2] > res;
+    auto wide_rpy = goal.rpy_tolerance[0] > orientation_res ||
+            goal.rpy_tolerance[1] > orientation_res ||
+            goal.rpy_tolerance[2] > orientation_res;
+    if (wide_xyz) {
+        return true;
+    }
+
+    switch (goal.type) {
+    case GoalType::XYZ_GOAL:
+        return map.reachable(Vector3(goal.pose.translation()));
+    case GoalType::XYZ_RPY_GOAL:
+        return wide_rpy ?
+                map.reachable(Vector3(goal.pose.translation())) :
+                map.reachable(goal.pose);
+    case GoalType::MULTIPLE_POSE_GOAL:
+        return std::any_of(
+                begin(goal.poses), end(goal.poses),
+                [&](const Affine3& pose)
+                {
+                    return wide_rpy ?
+                            map.reachable(Vector3(pose.translation())) :
+                            map.reachable(pose);
+                });
+    default:
+        return true;
+    }
+}
+
+// Return the serialized request, with the timestamps of its headers cleared,
+// as the key of its results in the result cache
+static
+auto MakeRequestKey(const moveit_msgs::MotionPlanRequest& req) -> std::string
+{
+    auto key_req = req;
+    key_req.start_state.joint_state.header.stamp = ros::Time();
+    key_req.start_state.multi_dof_joint_state.header.stamp = ros::Time();
+    for (auto& goal : key_req.goal_constraints) {
+        for (auto& constraint : goal.position_constraints) {
+            constraint.header.stamp = ros::Time();
+        }
+        for (auto& constraint : goal.orientation_constraints) {
+            constraint.header.stamp = ros::Time();
+        }
+    }
+
+    auto length = ros::serialization::serializationLength(key_req);
+    std::string key(length, '\0');
+    ros::serialization::OStream stream((uint8_t*)&key[0], length);
+    ros::serialization::serialize(stream, key_req);
+    return key;
+}
+
+bool PlannerInterface::solveRequest(
+    const moveit_msgs::PlanningScene& planning_scene,
+    const moveit_msgs::MotionPlanRequest& req,
+    moveit_msgs::MotionPlanResponse& res)
 {
     ClearMotionPlanResponse(req, res);
 
@@ -712,19 +1147,111 @@ bool PlannerInterface::solve(
         return true;
     }
 
+    // results are only reused while the collision world is known unchanged
+    std::string cache_key;
+    std::uint64_t world_version = 0;
+    auto* wver = m_checker->getExtension<CollisionWorldVersionExtension>();
+
+    if (m_motion_cache) {
+        // the world may have changed since the previous request. certified
+        // valid motions survive changes that stay clear of them
+        if (m_cached_checker->certifyMotions() && wver != NULL) {
+            m_cached_checker->syncWorld();
+            m_motion_cache->removeStale();
+        } else {
+            m_motion_cache->clear();
+        }
+    }
+
+    if (m_result_cache_size > 0 && wver != NULL) {
+        auto then = clock::now();
+        cache_key = MakeRequestKey(req);
+        world_version = wver->worldVersion();
+        if (lookupCachedResult(cache_key, world_version, res.trajectory)) {
+            TelemetryCount(TelemetryEvent::ResultCacheHit);
+            res.trajectory_start = planning_scene.robot_state;
+            res.trajectory.joint_trajectory.header.stamp = ros::Time::now();
+            res.planning_time = to_seconds(clock::now() - then);
+            res.error_code.val = moveit_msgs::MoveItErrorCodes::SUCCESS;
+            return true;
+        }
+        TelemetryCount(TelemetryEvent::ResultCacheMiss);
+    }
+
+    // a retry of the request whose search was checkpointed continues it. the
+    // checkpoint is taken again only if this search also ends without a path
+    m_resuming = false;
+    if (m_resume_searches && wver != NULL) {
+        auto key_req = req;
+        key_req.allowed_planning_time = 0.0;
+        auto key = MakeRequestKey(key_req);
+        m_resuming = m_checkpoint.valid &&
+                m_checkpoint.key == key &&
+                m_checkpoint.world_version == wver->worldVersion() &&
+                req.planner_id == m_planner_id &&
+                m_planner_id != PORTFOLIO_PLANNER_ID;
+        m_checkpoint.key = std::move(key);
+        m_checkpoint.world_version = wver->worldVersion();
+    }
+    m_checkpoint.valid = false;
+    if (m_resuming) {
+        SMPL_INFO_NAMED(PI_LOGGER, "Resume the search of the previous request");
+    }
+
+    m_cancel.reset();
+
     // TODO: lazily reinitialize planner when algorithm changes
     if (!reinitPlanner(req.planner_id)) {
         res.error_code.val = moveit_msgs::MoveItErrorCodes::FAILURE;
         return false;
     }
 
+    applyCancellationToken();
+
+    GoalConstraint goal;
+    if (!makeGoal(req.goal_constraints, goal)) {
+        SMPL_ERROR("Failed to set goal");
+        res.error_code.val = moveit_msgs::MoveItErrorCodes::GOAL_IN_COLLISION;
+        return false;
+    }
+
+    if (!IsGoalPlausible(m_reachability_map, goal)) {
+        SMPL_WARN_NAMED(PI_LOGGER, "Goal is not reachable according to the reachability map");
+        res.error_code.val = moveit_msgs::MoveItErrorCodes::NO_IK_SOLUTION;
+        return false;
+    }
+
+    // the heuristics that need only the goal and the occupancy grid start
+    // their goal updates here, to run alongside the search reset and the
+    // goal and start updates of the graph and search below
+    if (m_parallel_setup) {
+        startHeuristicUpdates(goal);
+    }
+
+    if (m_planner_id == PORTFOLIO_PLANNER_ID) {
+        // portfolio members are always reused
+        for (auto& member : m_portfolio) {
+            member->pipeline.space->clearStates();
+            member->pipeline.planner->force_planning_from_scratch();
+        }
+    } else if (m_reuse_pipelines && !m_resuming) {
+        // discard the states of the previous request, keeping their storage.
+        // state ids are reissued, so the search must start over as well
+        m_pspace->clearStates();
+        m_planner->force_planning_from_scratch();
+    }
+
     res.trajectory_start = planning_scene.robot_state;
     SMPL_INFO_NAMED(PI_LOGGER, "Allowed Time (s): %0.3f", req.allowed_planning_time);
 
     auto then = clock::now();
+    if (req.allowed_planning_time > 0.0) {
+        m_cancel.setDeadline(then + to_duration(req.allowed_planning_time));
+    }
 
-    if (!setGoal(req.goal_constraints)) {
+    if (!setGoal(goal)) {
         SMPL_ERROR("Failed to set goal");
+        finishHeuristicUpdates();
         res.planning_time = to_seconds(clock::now() - then);
         res.error_code.val = moveit_msgs::MoveItErrorCodes::GOAL_IN_COLLISION;
         return false;
@@ -732,19 +1259,39 @@ bool PlannerInterface::solve(
 
     if (!setStart(req.start_state)) {
         SMPL_ERROR("Failed to set initial configuration of robot");
+        finishHeuristicUpdates();
         res.planning_time = to_seconds(clock::now() - then);
         res.error_code.val = moveit_msgs::MoveItErrorCodes::START_STATE_IN_COLLISION;
         return false;
     }
 
+    // the BFS heuristics only seed their searches before returning, so the
+    // search may begin while their propagation is still underway
+    finishHeuristicUpdates();
+
     std::vector<RobotState> path;
-    if (!plan(req.allowed_planning_time, path)) {
-        SMPL_ERROR("Failed to plan within alotted time frame (%0.2f seconds, %d expansions)", req.allowed_planning_time, m_planner->get_n_expands());
+    auto warm = m_warm_start && warmStartPath(path);
+    if (!warm && !plan(req.allowed_planning_time, path)) {
+        m_warm_path.clear();
+        // the states and search of this request are left as they are, for a
+        // retry to continue
+        m_checkpoint.valid = m_resume_searches &&
+                !m_checkpoint.key.empty() &&
+                m_planner_id != PORTFOLIO_PLANNER_ID;
+        SMPL_ERROR("Failed to plan within alotted time frame (%0.2f seconds, %d expansions)", req.allowed_planning_time, m_planner ? m_planner->get_n_expands() : 0);
         res.planning_time = to_seconds(clock::now() - then);
-        res.error_code.val = moveit_msgs::MoveItErrorCodes::PLANNING_FAILED;
+        if (m_cancel.cancelled()) {
+            res.error_code.val = moveit_msgs::MoveItErrorCodes::PREEMPTED;
+        } else {
+            res.error_code.val = moveit_msgs::MoveItErrorCodes::PLANNING_FAILED;
+        }
         return false;
     }
 
+    // post-processing budgets its own time from what the search left over,
+    // and stops early only when the request is cancelled
+    m_cancel.clearDeadline();
+
     res.error_code.val = moveit_msgs::MoveItErrorCodes::SUCCESS;
 
     SMPL_DEBUG_NAMED(PI_LOGGER, "planner path:");
@@ -762,8 +1309,48 @@ bool PlannerInterface::solve(
         SMPL_ERROR("Planned path is invalid");
     }
 
-    postProcessPath(path);
-    SV_SHOW_INFO_NAMED("trajectory", makePathVisualization(path));
+    auto post_time = std::max(0.0, req.allowed_planning_time - to_seconds(clock::now() - then));
+    auto stream_count = (size_t)std::max(m_stream_waypoint_count, 0);
+    if (m_prefix_callback && stream_count > 0 && path.size() > stream_count + 1) {
+        // split the path at a waypoint kept by post-processing, so the
+        // streamed prefix remains the beginning of the final path
+        std::vector<RobotState> prefix(begin(path), begin(path) + stream_count + 1);
+        std::vector<RobotState> tail(begin(path) + stream_count, end(path));
+
+        auto prefix_time = post_time * (double)stream_count / (double)(path.size() - 1);
+        postProcessPath(prefix, prefix_time);
+        prependUnrepairedStart(prefix);
+        SMPL_DEBUG_NAMED(PI_LOGGER, "Stream %zu smoothed waypoints", prefix.size());
+        m_prefix_callback(prefix);
+
+        post_time = std::max(0.0, req.allowed_planning_time - to_seconds(clock::now() - then));
+        postProcessPath(tail, post_time);
+
+        path = std::move(prefix);
+        path.insert(end(path), std::next(begin(tail)), end(tail));
+    } else {
+        postProcessPath(path, post_time);
+        prependUnrepairedStart(path);
+    }
+    {
+        SMPL_TRACE_SPAN("visualization");
+        SV_SHOW_INFO_NAMED("trajectory", makePathVisualization(path));
+    }
+
+    if (m_motion_cache) {
+        SMPL_INFO_NAMED(PI_LOGGER, "Motion validity cache: %zu hits, %zu misses", m_motion_cache->hits(), m_motion_cache->misses());
+    }
+
+    // warm-started paths have been recorded already, and paths from a
+    // repaired start begin in collision
+    if (m_egraph_record && !warm && m_unrepaired_start.empty()) {
+        m_pending_experiences.push_back(path);
+    }
+
+    if (m_warm_start && m_planner_id != PORTFOLIO_PLANNER_ID) {
+        m_warm_goal = m_pspace->goal();
+        m_warm_path = path;
+    }
 
     SMPL_DEBUG_NAMED(PI_LOGGER, "smoothed path:");
     for (size_t pidx = 0; pidx < path.size(); ++pidx) {
@@ -783,9 +1370,20 @@ bool PlannerInterface::solve(
         WritePath(m_robot, res.trajectory_start, res.trajectory, m_params.plan_output_dir);
     }
 
-    ProfilePath(m_robot, res.trajectory.joint_trajectory);
+    {
+        SMPL_TRACE_SPAN("profile");
+        if (m_trapezoidal_timing) {
+            ProfilePathTrapezoidal(m_robot, res.trajectory.joint_trajectory, m_junction_deviation);
+        } else {
+            ProfilePath(m_robot, res.trajectory.joint_trajectory);
+        }
+    }
 //    RemoveZeroDurationSegments(traj);
 
+    if (!cache_key.empty()) {
+        storeCachedResult(cache_key, world_version, path, res.trajectory);
+    }
+
     res.planning_time = to_seconds(clock::now() - then);
     return true;
 }
@@ -1013,11 +1611,63 @@ bool ExtractPosesGoal(
     return true;
 }
 
-// Convert the set of input goal constraints to an SMPL goal type and update
-// the goal within the graph, the heuristic, and the search.
-bool PlannerInterface::setGoal(const GoalConstraints& v_goal_constraints)
+// Return whether the goal update of a heuristic reads only the goal and the
+// occupancy grid, and its start update does nothing, so that its goal update
+// may run concurrently with the goal and start updates of the rest of its
+// pipeline.
+static
+bool IsGridOnlyHeuristic(const RobotHeuristic* h)
+{
+    return dynamic_cast<const BfsHeuristic*>(h) != NULL ||
+            dynamic_cast<const MultiFrameBfsHeuristic*>(h) != NULL;
+}
+
+// Set the goal state in the graph, heuristics, and search of a pipeline. With
+// grid_heuristics false, the goals of the heuristics for which
+// IsGridOnlyHeuristic holds are left to the caller.
+static
+bool SetPipelineGoal(
+    RobotPlanningSpace* space,
+    const std::map<std::string, std::unique_ptr<RobotHeuristic>>& heuristics,
+    SBPLPlanner* planner,
+    const GoalConstraint& goal,
+    bool grid_heuristics = true)
+{
+    // set sbpl environment goal
+    if (!space->setGoal(goal)) {
+        SMPL_ERROR("Failed to set goal");
+        return false;
+    }
+
+    {
+        SMPL_TRACE_SPAN("updateGoal");
+        for (auto& h : heuristics) {
+            if (grid_heuristics || !IsGridOnlyHeuristic(h.second.get())) {
+                h.second->updateGoal(goal);
+            }
+        }
+    }
+
+    // set planner goal
+    auto goal_id = space->getGoalStateID();
+    if (goal_id == -1) {
+        SMPL_ERROR("No goal state has been set");
+        return false;
+    }
+
+    if (planner->set_goal(goal_id) == 0) {
+        SMPL_ERROR("Failed to set planner goal state");
+        return false;
+    }
+
+    return true;
+}
+
+// Convert the set of input goal constraints to an SMPL goal type.
+bool PlannerInterface::makeGoal(
+    const GoalConstraints& v_goal_constraints,
+    GoalConstraint& goal)
 {
-    GoalConstraint goal;
 
     if (IsPoseGoal(v_goal_constraints)) {
         SMPL_INFO_NAMED(PI_LOGGER, "Planning to pose!");
@@ -1058,25 +1708,98 @@ bool PlannerInterface::setGoal(const GoalConstraints& v_goal_constraints)
         return false;
     }
 
-    // set sbpl environment goal
-    if (!m_pspace->setGoal(goal)) {
-        SMPL_ERROR("Failed to set goal");
-        return false;
+    return true;
+}
+
+// Update the goal within the graph, the heuristic, and the search. The goals
+// of heuristics already given to startHeuristicUpdates are not set again.
+bool PlannerInterface::setGoal(const GoalConstraint& goal)
+{
+    SMPL_TRACE_SPAN("setGoal");
+
+    auto grid_heuristics = !m_parallel_setup;
+
+    if (m_planner_id == PORTFOLIO_PLANNER_ID) {
+        for (auto& member : m_portfolio) {
+            auto& p = member->pipeline;
+            if (!SetPipelineGoal(p.space.get(), p.heuristics, p.planner.get(), goal, grid_heuristics)) {
+                return false;
+            }
+        }
+        return true;
     }
 
-    for (auto& h : m_heuristics) {
-        h.second->updateGoal(goal);
+    return SetPipelineGoal(m_pspace.get(), m_heuristics, m_planner.get(), goal, grid_heuristics);
+}
+
+// Start the goal update of each heuristic, of every pipeline used by the
+// request, for which IsGridOnlyHeuristic holds, each on its own thread.
+void PlannerInterface::startHeuristicUpdates(const GoalConstraint& goal)
+{
+    auto start_updates = [&](
+        const std::map<std::string, std::unique_ptr<RobotHeuristic>>& heuristics)
+    {
+        for (auto& h : heuristics) {
+            auto* heuristic = h.second.get();
+            if (!IsGridOnlyHeuristic(heuristic)) {
+                continue;
+            }
+            m_heuristic_updates.push_back(std::async(
+                    std::launch::async,
+                    [heuristic, goal]()
+                    {
+                        SMPL_TRACE_SPAN("updateGoal");
+                        heuristic->updateGoal(goal);
+                    }));
+        }
+    };
+
+    if (m_planner_id == PORTFOLIO_PLANNER_ID) {
+        for (auto& member : m_portfolio) {
+            start_updates(member->pipeline.heuristics);
+        }
+    } else {
+        start_updates(m_heuristics);
     }
+}
 
-    // set planner goal
-    auto goal_id = m_pspace->getGoalStateID();
-    if (goal_id == -1) {
-        SMPL_ERROR("No goal state has been set");
+// Wait for the goal updates begun by startHeuristicUpdates to return.
+void PlannerInterface::finishHeuristicUpdates()
+{
+    for (auto& update : m_heuristic_updates) {
+        update.wait();
+    }
+    m_heuristic_updates.clear();
+}
+
+// Set the start state in the graph, heuristics, and search of a pipeline.
+static
+bool SetPipelineStart(
+    RobotPlanningSpace* space,
+    const std::map<std::string, std::unique_ptr<RobotHeuristic>>& heuristics,
+    SBPLPlanner* planner,
+    const RobotState& start)
+{
+    if (!space->setStart(start)) {
+        SMPL_ERROR("Failed to set start state");
         return false;
     }
 
-    if (m_planner->set_goal(goal_id) == 0) {
-        SMPL_ERROR("Failed to set planner goal state");
+    auto start_id = space->getStartStateID();
+    if (start_id == -1) {
+        SMPL_ERROR("No start state has been set");
+        return false;
+    }
+
+    {
+        SMPL_TRACE_SPAN("updateStart");
+        for (auto& h : heuristics) {
+            h.second->updateStart(start);
+        }
+    }
+
+    if (planner->set_start(start_id) == 0) {
+        SMPL_ERROR("Failed to set start state");
         return false;
     }
 
@@ -1087,6 +1810,8 @@ bool PlannerInterface::setGoal(const GoalConstraints& v_goal_constraints)
 // state in the graph, heuristic, and search.
 bool PlannerInterface::setStart(const moveit_msgs::RobotState& state)
 {
+    SMPL_TRACE_SPAN("setStart");
+
     SMPL_INFO_NAMED(PI_LOGGER, "set start configuration");
 
     // TODO: Ideally, the RobotModel should specify joints rather than variables
@@ -1133,46 +1858,70 @@ bool PlannerInterface::setStart(const moveit_msgs::RobotState& state)
 
     SMPL_INFO_STREAM_NAMED(PI_LOGGER, "  joint variables: " << initial_positions);
 
-    if (!m_pspace->setStart(initial_positions)) {
-        SMPL_ERROR("Failed to set start state");
-        return false;
+    m_unrepaired_start.clear();
+    if (m_start_repair_iterations > 0 && !m_checker->isStateValid(initial_positions)) {
+        RobotState repaired;
+        if (RepairState(
+                m_robot,
+                m_checker,
+                initial_positions,
+                repaired,
+                m_start_repair_iterations,
+                m_start_repair_clearance,
+                m_start_repair_step))
+        {
+            SMPL_INFO_STREAM_NAMED(PI_LOGGER, "  repaired joint variables: " << repaired);
+            m_unrepaired_start = std::move(initial_positions);
+            initial_positions = std::move(repaired);
+        }
     }
 
-    auto start_id = m_pspace->getStartStateID();
-    if (start_id == -1) {
-        SMPL_ERROR("No start state has been set");
-        return false;
+    if (m_planner_id == PORTFOLIO_PLANNER_ID) {
+        for (auto& member : m_portfolio) {
+            auto& p = member->pipeline;
+            if (!SetPipelineStart(p.space.get(), p.heuristics, p.planner.get(), initial_positions)) {
+                return false;
+            }
+        }
+        return true;
     }
 
-    for (auto& h : m_heuristics) {
-        h.second->updateStart(initial_positions);
-    }
-
-    if (m_planner->set_start(start_id) == 0) {
-        SMPL_ERROR("Failed to set start state");
-        return false;
-    }
-
-    return true;
+    return SetPipelineStart(m_pspace.get(), m_heuristics, m_planner.get(), initial_positions);
 }
 
 bool PlannerInterface::plan(double allowed_time, std::vector<RobotState>& path)
 {
+    if (m_planner_id == PORTFOLIO_PLANNER_ID) {
+        return planPortfolio(allowed_time, path);
+    }
+
     // NOTE: this should be done after setting the start/goal in the environment
     // to allow the heuristic to tailor the visualization to the current
     // scenario
-    SV_SHOW_DEBUG_NAMED("bfs_walls", getBfsWallsVisualization());
-    SV_SHOW_DEBUG_NAMED("bfs_values", getBfsValuesVisualization());
+    {
+        SMPL_TRACE_SPAN("visualization");
+        SV_SHOW_DEBUG_NAMED("bfs_walls", getBfsWallsVisualization());
+        SV_SHOW_DEBUG_NAMED("bfs_values", getBfsValuesVisualization());
+    }
 
     SMPL_WARN_NAMED(PI_LOGGER, "Planning!!!!!");
     bool b_ret = false;
     std::vector<int> solution_state_ids;
 
-    // reinitialize the search space
-    m_planner->force_planning_from_scratch();
+    m_telemetry_start = GetTelemetry();
+
+    {
+        SMPL_TRACE_SPAN("search");
+
+        // reinitialize the search space, unless continuing the search of
+        // the previous request
+        if (!m_resuming) {
+            m_planner->force_planning_from_scratch();
+        }
 
-    // plan
-    b_ret = m_planner->replan(allowed_time, &solution_state_ids, &m_sol_cost);
+        // plan
+        b_ret = m_planner->replan(allowed_time, &solution_state_ids, &m_sol_cost);
+    }
 
     // check if an empty plan was received.
     if (b_ret && solution_state_ids.size() <= 0) {
@@ -1263,6 +2012,23 @@ auto PlannerInterface::getPlannerStats() -> std::map<std::string, double>
     stats["solution epsilon"] = m_planner->get_solution_eps();
     stats["expansions"] = m_planner->get_n_expands();
     stats["solution cost"] = m_sol_cost;
+
+    // hot-path counts and times since the start of the last search, including
+    // post-processing
+    auto telemetry = GetTelemetry() - m_telemetry_start;
+    for (int e = 0; e < TelemetryEventCount; ++e) {
+        auto event = (TelemetryEvent)e;
+        std::string name(to_cstring(event));
+        stats[name + " count"] = (double)telemetry.count(event);
+        stats[name + " time"] = telemetry.seconds(event);
+    }
+
+    // bytes held by each component, or 0 if it does not report its usage
+    stats["planning space memory"] = (double)memoryUsage(MemoryComponent::PlanningSpace);
+    stats["heuristic memory"] = (double)memoryUsage(MemoryComponent::Heuristic);
+    stats["search memory"] = (double)memoryUsage(MemoryComponent::Search);
+    stats["collision checker memory"] = (double)memoryUsage(MemoryComponent::CollisionChecker);
+    stats["distance map memory"] = (double)memoryUsage(MemoryComponent::DistanceMap);
     return stats;
 }
 
@@ -1379,16 +2145,31 @@ bool PlannerInterface::parsePlannerID(
     return true;
 }
 
-bool PlannerInterface::reinitPlanner(const std::string& planner_id)
+// Build the planning space, heuristic, and search for a planner id, with the
+// planning space checking states with the given robot model and collision
+// checker.
+// Hand the reachability map to the goal IK of the lattices that solve it.
+static
+void SetPipelineReachabilityMap(
+    RobotPlanningSpace* space,
+    const ReachabilityMap* map)
 {
-    if (planner_id == m_planner_id) {
-        // TODO: check for specification of default planning components when
-        // they may not have been previously specified
-        return true;
+    if (auto* workspace = dynamic_cast<WorkspaceLattice*>(space)) {
+        workspace->setReachabilityMap(map);
+    } else if (auto* manip = dynamic_cast<ManipLattice*>(space)) {
+        auto* actions = dynamic_cast<ManipLatticeActionSpace*>(manip->actionSpace());
+        if (actions) {
+            actions->setReachabilityMap(map);
+        }
     }
+}
 
-    SMPL_INFO_NAMED(PI_LOGGER, "Initialize planner");
-
+bool PlannerInterface::buildPipeline(
+    const std::string& planner_id,
+    RobotModel* robot,
+    CollisionChecker* checker,
+    Pipeline& pipeline)
+{
     std::string search_name;
     std::string heuristic_name;
     std::string space_name;
@@ -1407,30 +2188,34 @@ bool PlannerInterface::reinitPlanner(const std::string& planner_id)
         return false;
     }
 
-    m_pspace = psait->second(m_robot, m_checker, m_params);
-    if (!m_pspace) {
+    pipeline.space = psait->second(robot, checker, m_params);
+    if (!pipeline.space) {
         SMPL_ERROR("Failed to build planning space '%s'", space_name.c_str());
         return false;
     }
 
+    if (!m_reachability_map.empty()) {
+        SetPipelineReachabilityMap(pipeline.space.get(), &m_reachability_map);
+    }
+
     auto hait = m_heuristic_factories.find(heuristic_name);
     if (hait == end(m_heuristic_factories)) {
         SMPL_ERROR("Unrecognized heuristic name '%s'", heuristic_name.c_str());
         return false;
     }
 
-    auto heuristic = hait->second(m_pspace.get(), m_params);
+    auto heuristic = hait->second(pipeline.space.get(), m_params);
     if (!heuristic) {
         SMPL_ERROR("Failed to build heuristic '%s'", heuristic_name.c_str());
         return false;
     }
 
     // initialize heuristics
-    m_heuristics.clear();
-    m_heuristics.insert(std::make_pair(heuristic_name, std::move(heuristic)));
+    pipeline.heuristics.clear();
+    pipeline.heuristics.insert(std::make_pair(heuristic_name, std::move(heuristic)));
 
-    for (auto& entry : m_heuristics) {
-        m_pspace->insertHeuristic(entry.second.get());
+    for (auto& entry : pipeline.heuristics) {
+        pipeline.space->insertHeuristic(entry.second.get());
     }
 
     auto pait = m_planner_factories.find(search_name);
@@ -1439,34 +2224,645 @@ bool PlannerInterface::reinitPlanner(const std::string& planner_id)
         return false;
     }
 
-    auto first_heuristic = begin(m_heuristics);
-    m_planner = pait->second(m_pspace.get(), first_heuristic->second.get(), m_params);
-    if (!m_planner) {
+    auto first_heuristic = begin(pipeline.heuristics);
+    pipeline.planner = pait->second(pipeline.space.get(), first_heuristic->second.get(), m_params);
+    if (!pipeline.planner) {
         SMPL_ERROR("Failed to build planner '%s'", search_name.c_str());
         return false;
     }
+    return true;
+}
+
+bool PlannerInterface::reinitPlanner(const std::string& planner_id)
+{
+    // pending experiences belong to the active planning space, insert them
+    // before it is stashed or replaced
+    insertPendingExperiences();
+
+    // the active pipeline may belong to a member of the portfolio
+    restorePortfolioMember();
+
+    if (planner_id == m_planner_id) {
+        // TODO: check for specification of default planning components when
+        // they may not have been previously specified
+        return true;
+    }
+
+    if (m_reuse_pipelines) {
+        // stash the active pipeline and restore the requested one, if it was
+        // used before
+        if (!m_planner_id.empty() && m_planner_id != PORTFOLIO_PLANNER_ID) {
+            auto& stashed = m_pipelines[m_planner_id];
+            stashed.space = std::move(m_pspace);
+            stashed.heuristics = std::move(m_heuristics);
+            stashed.planner = std::move(m_planner);
+            m_heuristics.clear();
+        }
+        m_planner_id.clear();
+
+        auto pit = m_pipelines.find(planner_id);
+        if (pit != end(m_pipelines)) {
+            SMPL_INFO_NAMED(PI_LOGGER, "Reuse planner '%s'", planner_id.c_str());
+            m_pspace = std::move(pit->second.space);
+            m_heuristics = std::move(pit->second.heuristics);
+            m_planner = std::move(pit->second.planner);
+            m_pipelines.erase(pit);
+            m_planner_id = planner_id;
+            return true;
+        }
+    }
+
+    if (planner_id == PORTFOLIO_PLANNER_ID) {
+        m_planner.reset();
+        m_heuristics.clear();
+        m_pspace.reset();
+        m_planner_id.clear();
+        if (!initPortfolio()) {
+            return false;
+        }
+        m_planner_id = planner_id;
+        return true;
+    }
+
+    SMPL_INFO_NAMED(PI_LOGGER, "Initialize planner");
+
+    Pipeline pipeline;
+    if (!buildPipeline(planner_id, m_robot, m_checker, pipeline)) {
+        return false;
+    }
+
+    m_planner.reset();
+    m_heuristics.clear();
+    m_pspace = std::move(pipeline.space);
+    m_heuristics = std::move(pipeline.heuristics);
+    m_planner = std::move(pipeline.planner);
     m_planner_id = planner_id;
     return true;
 }
 
-void PlannerInterface::postProcessPath(std::vector<RobotState>& path) const
+// Build the pipelines of the portfolio members, if they have not been built
+// since the last call to init().
+bool PlannerInterface::initPortfolio()
+{
+    if (!m_portfolio.empty()) {
+        return true;
+    }
+
+    if (m_portfolio_ids.empty()) {
+        SMPL_ERROR("Portfolio requested, but the portfolio parameter lists no planner ids");
+        return false;
+    }
+
+    for (size_t i = 0; i < m_portfolio_ids.size(); ++i) {
+        auto& planner_id = m_portfolio_ids[i];
+
+        auto member = make_unique<PortfolioMember>();
+        member->planner_id = planner_id;
+        if (i == 0) {
+            member->robot = m_robot;
+            member->checker = m_checker;
+        } else if (i - 1 < m_portfolio_contexts.size()) {
+            auto& context = m_portfolio_contexts[i - 1];
+            member->robot = context.robot;
+            if (context.checker != nullptr) {
+                member->checker = context.checker;
+            } else {
+                auto* clone_ext = m_checker->getExtension<CollisionCheckerCloneExtension>();
+                if (clone_ext == nullptr) {
+                    SMPL_WARN_NAMED(PI_LOGGER, "Drop portfolio member '%s': the collision checker can not be cloned", planner_id.c_str());
+                    continue;
+                }
+                member->checker_clone = clone_ext->clone();
+                member->checker = member->checker_clone.get();
+            }
+        } else {
+            SMPL_WARN_NAMED(PI_LOGGER, "Drop portfolio member '%s': no planning context was added for it", planner_id.c_str());
+            continue;
+        }
+
+        SMPL_INFO_NAMED(PI_LOGGER, "Initialize portfolio member '%s'", planner_id.c_str());
+        if (!buildPipeline(planner_id, member->robot, member->checker, member->pipeline)) {
+            m_portfolio.clear();
+            return false;
+        }
+
+        m_portfolio.push_back(std::move(member));
+    }
+
+    return true;
+}
+
+// Build the workers of solveBatch(), if they have not been built since the
+// last call to init(). Each worker is initialized with the parameters and
+// factories of this interface. If fewer than batch_threads - 1 workers can be
+// built, the batch is planned by those that were.
+// Return the bytes held by a component, or 0 if it does not report its usage.
+auto PlannerInterface::memoryUsage(MemoryComponent component) const
+    -> std::size_t
+{
+    switch (component) {
+    case MemoryComponent::PlanningSpace:
+        return GetMemoryUsage(m_pspace.get());
+    case MemoryComponent::Heuristic:
+    {
+        auto bytes = std::size_t(0);
+        for (auto& entry : m_heuristics) {
+            bytes += GetMemoryUsage(entry.second.get());
+        }
+        return bytes;
+    }
+    case MemoryComponent::Search:
+    {
+        auto* search = dynamic_cast<MemoryUsageExtension*>(m_planner.get());
+        return search != nullptr ? search->memoryUsage() : 0;
+    }
+    case MemoryComponent::CollisionChecker:
+        return GetMemoryUsage(m_checker);
+    case MemoryComponent::DistanceMap:
+        return m_grid != nullptr ? m_grid->getDistanceField()->memoryUsage() : 0;
+    default:
+        return 0;
+    }
+}
+
+bool PlannerInterface::initBatchWorkers()
+{
+    std::lock_guard<std::mutex> lock(m_batch_mutex);
+
+    if (m_batch_threads <= 1 || m_batch_pool) {
+        return true;
+    }
+
+    auto* robot_clone = m_robot->getExtension<RobotModelCloneExtension>();
+    auto* checker_clone = m_user_checker->getExtension<CollisionCheckerCloneExtension>();
+    if (robot_clone == nullptr || checker_clone == nullptr) {
+        SMPL_WARN_ONCE("Solve batches sequentially: the robot model or collision checker can not be cloned");
+        return false;
+    }
+
+    // workers do not batch, and leave exporting traces to this interface
+    auto params = m_params;
+    params.addParam("batch_threads", 1);
+    params.addParam("trace_output", std::string());
+    params.addParam("metrics_port", 0);
+
+    for (int i = 1; i < m_batch_threads; ++i) {
+        auto worker = make_unique<BatchWorker>();
+        worker->robot = robot_clone->clone();
+        worker->checker = checker_clone->clone();
+        worker->planner = make_unique<PlannerInterface>(
+                worker->robot.get(), worker->checker.get(), m_grid);
+        worker->planner->m_space_factories = m_space_factories;
+        worker->planner->m_heuristic_factories = m_heuristic_factories;
+        worker->planner->m_planner_factories = m_planner_factories;
+        if (!worker->planner->init(params)) {
+            SMPL_WARN_NAMED(PI_LOGGER, "Failed to initialize batch worker %d", i);
+            break;
+        }
+        worker->planner->m_metrics = m_metrics;
+        m_batch_workers.push_back(std::move(worker));
+    }
+
+    if (!m_batch_workers.empty()) {
+        m_batch_pool.reset(new WorkerPool((int)m_batch_workers.size() + 1));
+    }
+
+    return (int)m_batch_workers.size() + 1 == m_batch_threads;
+}
+
+// Move the active pipeline back to the portfolio member it was taken from.
+void PlannerInterface::restorePortfolioMember()
+{
+    if (m_portfolio_active < 0) {
+        return;
+    }
+
+    auto& pipeline = m_portfolio[m_portfolio_active]->pipeline;
+    pipeline.space = std::move(m_pspace);
+    pipeline.heuristics = std::move(m_heuristics);
+    pipeline.planner = std::move(m_planner);
+    m_heuristics.clear();
+    m_portfolio_active = -1;
+}
+
+// Point the searches and heuristics of the active pipeline, and of every
+// portfolio member, at the cancellation token of the interface. Pipelines are
+// rebuilt and swapped between requests, so this is repeated for each request.
+void PlannerInterface::applyCancellationToken()
+{
+    if (m_planner_id == PORTFOLIO_PLANNER_ID) {
+        for (auto& member : m_portfolio) {
+            SetPipelineCancellationToken(
+                    member->pipeline.heuristics,
+                    member->pipeline.planner.get(),
+                    &m_cancel);
+        }
+    } else {
+        SetPipelineCancellationToken(m_heuristics, m_planner.get(), &m_cancel);
+    }
+}
+
+// Compare the fields of two goals that are relevant for their type
+static
+bool EqualGoals(const GoalConstraint& a, const GoalConstraint& b)
+{
+    if (a.type != b.type) {
+        return false;
+    }
+
+    auto equal_poses = [](const Affine3& p, const Affine3& q) {
+        return p.matrix() == q.matrix();
+    };
+    auto equal_tolerances = [&]() {
+        return std::equal(a.xyz_tolerance, a.xyz_tolerance + 3, b.xyz_tolerance) &&
+                std::equal(a.rpy_tolerance, a.rpy_tolerance + 3, b.rpy_tolerance);
+    };
+
+    switch (a.type) {
+    case JOINT_STATE_GOAL:
+        return a.angles == b.angles && a.angle_tolerances == b.angle_tolerances;
+    case XYZ_GOAL:
+    case XYZ_RPY_GOAL:
+        return equal_poses(a.pose, b.pose) && equal_tolerances();
+    case MULTIPLE_POSE_GOAL:
+        return a.poses.size() == b.poses.size() &&
+                std::equal(begin(a.poses), end(a.poses), begin(b.poses), equal_poses) &&
+                equal_tolerances();
+    case USER_GOAL_CONSTRAINT_FN:
+        return a.check_goal == b.check_goal &&
+                a.check_goal_user == b.check_goal_user;
+    default:
+        return false;
+    }
+}
+
+// Return the largest displacement of any joint between two states
+static
+double MaxJointDistance(
+    RobotModel* robot,
+    const RobotState& from,
+    const RobotState& to)
+{
+    auto dist = 0.0;
+    for (size_t vidx = 0; vidx < robot->getPlanningJoints().size(); ++vidx) {
+        if (robot->hasPosLimit(vidx)) {
+            dist = std::max(dist, std::fabs(to[vidx] - from[vidx]));
+        } else {
+            dist = std::max(dist, angles::shortest_angle_dist(to[vidx], from[vidx]));
+        }
+    }
+    return dist;
+}
+
+// Build a path for the current request from the path of the previous one.
+// The start is connected to the waypoint, furthest along the previous path,
+// that lies within the warm start radius and can be reached with a valid
+// motion. The rest of the previous path is checked again, since the world may
+// have changed.
+bool PlannerInterface::warmStartPath(std::vector<RobotState>& path) const
+{
+    if (m_warm_path.empty() ||
+        m_planner_id == PORTFOLIO_PLANNER_ID ||
+        !EqualGoals(m_warm_goal, m_pspace->goal()))
+    {
+        return false;
+    }
+
+    SMPL_TRACE_SPAN("warm_start");
+
+    auto& start = m_pspace->startState();
+
+    auto connection = m_warm_path.size();
+    for (auto i = m_warm_path.size(); i-- > 0; ) {
+        auto& wp = m_warm_path[i];
+        if (MaxJointDistance(m_robot, start, wp) <= m_warm_start_radius &&
+            m_checker->isStateToStateValid(start, wp))
+        {
+            connection = i;
+            break;
+        }
+    }
+
+    if (connection == m_warm_path.size()) {
+        SMPL_INFO_NAMED(PI_LOGGER, "Start is not near the previous path. Plan from scratch");
+        return false;
+    }
+
+    for (auto i = connection + 1; i < m_warm_path.size(); ++i) {
+        if (!m_checker->isStateToStateValid(m_warm_path[i - 1], m_warm_path[i])) {
+            SMPL_INFO_NAMED(PI_LOGGER, "Previous path is no longer valid. Plan from scratch");
+            return false;
+        }
+    }
+
+    path.clear();
+    if (MaxJointDistance(m_robot, start, m_warm_path[connection]) > 0.0) {
+        path.push_back(start);
+    }
+    path.insert(end(path), begin(m_warm_path) + connection, end(m_warm_path));
+
+    SMPL_INFO_NAMED(PI_LOGGER, "Warm start from waypoint %zu of the previous path", connection);
+    return true;
+}
+
+// Look up the result of a request in the result cache. Results planned in a
+// different version of the collision world are discarded, and so is a matching
+// result whose path is no longer valid.
+bool PlannerInterface::lookupCachedResult(
+    const std::string& key,
+    std::uint64_t world_version,
+    moveit_msgs::RobotTrajectory& trajectory)
+{
+    m_result_cache.remove_if([&](const CachedResult& result) {
+        return result.world_version != world_version;
+    });
+
+    auto hash = std::hash<std::string>()(key);
+    auto rit = std::find_if(begin(m_result_cache), end(m_result_cache),
+            [&](const CachedResult& result) {
+                return result.hash == hash && result.key == key;
+            });
+    if (rit == end(m_result_cache)) {
+        return false;
+    }
+
+    SMPL_TRACE_SPAN("result_cache");
+
+    for (size_t i = 1; i < rit->path.size(); ++i) {
+        if (!m_checker->isStateToStateValid(rit->path[i - 1], rit->path[i])) {
+            SMPL_INFO_NAMED(PI_LOGGER, "Cached result is no longer valid. Plan from scratch");
+            m_result_cache.erase(rit);
+            return false;
+        }
+    }
+
+    SMPL_INFO_NAMED(PI_LOGGER, "Return cached result of an identical request");
+    m_result_cache.splice(begin(m_result_cache), m_result_cache, rit);
+    trajectory = m_result_cache.front().trajectory;
+    return true;
+}
+
+// Store the result of a request in the result cache, evicting the least
+// recently used result if the cache is full.
+void PlannerInterface::storeCachedResult(
+    const std::string& key,
+    std::uint64_t world_version,
+    const std::vector<RobotState>& path,
+    const moveit_msgs::RobotTrajectory& trajectory)
+{
+    CachedResult result;
+    result.hash = std::hash<std::string>()(key);
+    result.key = key;
+    result.world_version = world_version;
+    result.path = path;
+    result.trajectory = trajectory;
+    m_result_cache.push_front(std::move(result));
+    while (m_result_cache.size() > (size_t)m_result_cache_size) {
+        m_result_cache.pop_back();
+    }
+}
+
+// Replan with an ARA* search until it finishes, runs out of time, or the
+// portfolio is cancelled.
+template <class Search>
+static
+bool ReplanCancellable(
+    Search* search,
+    double allowed_time,
+    const std::atomic<bool>& cancelled,
+    std::vector<int>* solution,
+    int* cost)
+{
+    auto deadline = clock::now() + to_duration(allowed_time);
+    auto bounded = search->boundExpansions();
+
+    typename Search::TimeParameters tparams;
+    tparams.bounded = true;
+    tparams.improve = search->improveSolution();
+    tparams.type = Search::TimeParameters::USER;
+    tparams.max_expansions_init = 0;
+    tparams.max_expansions = 0;
+    tparams.max_allowed_time_init = clock::duration::zero();
+    tparams.max_allowed_time = clock::duration::zero();
+    tparams.timed_out_fun = [&]()
+    {
+        return cancelled.load(std::memory_order_relaxed) ||
+                (bounded && clock::now() >= deadline);
+    };
+    return search->replan(tparams, solution, cost) != 0;
+}
+
+// Replan with the search of a portfolio member. Searches without a
+// cancellation hook run until they finish or their allowed time runs out.
+static
+bool ReplanPortfolioMember(
+    SBPLPlanner* planner,
+    double allowed_time,
+    const std::atomic<bool>& cancelled,
+    std::vector<int>* solution,
+    int* cost)
+{
+    if (auto* search = dynamic_cast<ARAStar*>(planner)) {
+        return ReplanCancellable(search, allowed_time, cancelled, solution, cost);
+    }
+    if (auto* search = dynamic_cast<BucketARAStar*>(planner)) {
+        return ReplanCancellable(search, allowed_time, cancelled, solution, cost);
+    }
+    return planner->replan(allowed_time, solution, cost) != 0;
+}
+
+// Run the searches of all portfolio members concurrently, one on the calling
+// thread and one on a new thread per remaining member, and return the first
+// valid path found. The other searches are cancelled once a path is found.
+bool PlannerInterface::planPortfolio(
+    double allowed_time,
+    std::vector<RobotState>& path)
+{
+    SMPL_INFO_NAMED(PI_LOGGER, "Race %zu portfolio members", m_portfolio.size());
+
+    m_telemetry_start = GetTelemetry();
+
+    std::atomic<bool> cancelled(false);
+    std::atomic<int> winner(-1);
+    std::vector<std::vector<RobotState>> paths(m_portfolio.size());
+    std::vector<int> costs(m_portfolio.size(), INFINITECOST);
+
+    auto run_member = [&](size_t i)
+    {
+        auto& member = *m_portfolio[i];
+        auto& pipeline = member.pipeline;
+
+        pipeline.planner->force_planning_from_scratch();
+
+        std::vector<int> solution_state_ids;
+        if (!ReplanPortfolioMember(
+                pipeline.planner.get(),
+                allowed_time,
+                cancelled,
+                &solution_state_ids,
+                &costs[i]) ||
+            solution_state_ids.empty())
+        {
+            SMPL_INFO_NAMED(PI_LOGGER, "Portfolio member '%s' found no solution", member.planner_id.c_str());
+            return;
+        }
+
+        if (!pipeline.space->extractPath(solution_state_ids, paths[i]) ||
+            !IsPathValid(member.checker, paths[i]))
+        {
+            SMPL_WARN_NAMED(PI_LOGGER, "Portfolio member '%s' found an invalid solution", member.planner_id.c_str());
+            return;
+        }
+
+        auto none = -1;
+        if (winner.compare_exchange_strong(none, (int)i)) {
+            cancelled = true;
+        }
+    };
+
+    {
+        SMPL_TRACE_SPAN("search");
+
+        std::vector<std::thread> threads;
+        threads.reserve(m_portfolio.size() - 1);
+        for (size_t i = 1; i < m_portfolio.size(); ++i) {
+            threads.emplace_back(run_member, i);
+        }
+        run_member(0);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    // report on the winner, or on the first member if there was none
+    auto w = winner.load();
+    m_portfolio_active = std::max(w, 0);
+    auto& active = m_portfolio[m_portfolio_active]->pipeline;
+    m_pspace = std::move(active.space);
+    m_heuristics = std::move(active.heuristics);
+    m_planner = std::move(active.planner);
+    m_sol_cost = costs[m_portfolio_active];
+
+    if (w < 0) {
+        return false;
+    }
+
+    SMPL_INFO_NAMED(PI_LOGGER, "Portfolio member '%s' won", m_portfolio[w]->planner_id.c_str());
+    SMPL_INFO_NAMED(PI_LOGGER, "  Num Expansions (Initial): %d", m_planner->get_n_expands_init_solution());
+    SMPL_INFO_NAMED(PI_LOGGER, "  Path Length (states): %zu", paths[w].size());
+    SMPL_INFO_NAMED(PI_LOGGER, "  Solution Cost: %d", m_sol_cost);
+
+    path = std::move(paths[w]);
+    return true;
+}
+
+void PlannerInterface::setPathPrefixCallback(PathPrefixCallback callback)
+{
+    m_prefix_callback = std::move(callback);
+}
+
+void PlannerInterface::cancel()
+{
+    m_cancel.cancel();
+
+    m_batch_cancelled = true;
+    std::lock_guard<std::mutex> lock(m_batch_mutex);
+    for (auto& worker : m_batch_workers) {
+        worker->planner->cancel();
+    }
+}
+
+void PlannerInterface::addPortfolioContext(
+    RobotModel* robot,
+    CollisionChecker* checker)
+{
+    m_portfolio_contexts.push_back(PortfolioContext{ robot, checker });
+}
+
+// Begin a path planned from a repaired start at the start of the request. The
+// straight motion to the repaired state leaves collision.
+void PlannerInterface::prependUnrepairedStart(std::vector<RobotState>& path) const
+{
+    if (!m_unrepaired_start.empty() && !path.empty()) {
+        path.insert(begin(path), m_unrepaired_start);
+    }
+}
+
+void PlannerInterface::insertPendingExperiences()
+{
+    if (m_pending_experiences.empty()) {
+        return;
+    }
+
+    auto* egraph = m_pspace ?
+            m_pspace->getExtension<ExperienceGraphExtension>() : nullptr;
+    if (egraph) {
+        for (auto& path : m_pending_experiences) {
+            if (!egraph->insertExperienceGraphPath(path, m_egraph_merge_radius)) {
+                SMPL_WARN_NAMED(PI_LOGGER, "Failed to insert path into the experience graph");
+            }
+        }
+    }
+    m_pending_experiences.clear();
+}
+
+void PlannerInterface::postProcessPath(
+    std::vector<RobotState>& path,
+    double allowed_time) const
 {
     // shortcut path
-    if (m_params.shortcut_path) {
+    if (m_params.shortcut_path && m_anytime_smoothing) {
+        SMPL_TRACE_SPAN("shortcut");
+        if (!InterpolatePath(*m_checker, path)) {
+            SMPL_WARN_NAMED(PI_LOGGER, "Failed to interpolate planned path with %zu waypoints before smoothing.", path.size());
+        }
+        std::vector<RobotState> ipath = path;
+        path.clear();
+        SetCancellationToken(m_checker, &m_cancel);
+        AnytimeSmoothPath(
+                m_robot, m_checker, ipath, path,
+                allowed_time, m_shortcut_threads, 20, &m_cancel);
+        SetCancellationToken(m_checker, (const CancellationToken*)nullptr);
+    } else if (m_params.shortcut_path) {
+        SMPL_TRACE_SPAN("shortcut");
         if (!InterpolatePath(*m_checker, path)) {
             SMPL_WARN_NAMED(PI_LOGGER, "Failed to interpolate planned path with %zu waypoints before shortcutting.", path.size());
-            std::vector<RobotState> ipath = path;
-            path.clear();
-            ShortcutPath(m_robot, m_checker, ipath, path, m_params.shortcut_type);
+        }
+        std::vector<RobotState> ipath = path;
+        path.clear();
+        SetCancellationToken(m_checker, &m_cancel);
+        if (m_params.shortcut_type == ShortcutType::JOINT_SPACE &&
+            (m_shortcut_threads > 1 || m_shortcut_time > 0.0))
+        {
+            ParallelShortcutPath(
+                    m_robot, m_checker, ipath, path,
+                    m_shortcut_threads, m_shortcut_time, 0, 10, &m_cancel);
         } else {
-            std::vector<RobotState> ipath = path;
-            path.clear();
-            ShortcutPath(m_robot, m_checker, ipath, path, m_params.shortcut_type);
+            ShortcutPath(
+                    m_robot, m_checker, ipath, path,
+                    m_params.shortcut_type, &m_cancel);
+        }
+        SetCancellationToken(m_checker, (const CancellationToken*)nullptr);
+    }
+
+    // optimize path
+    if (m_optimize_iterations > 0) {
+        SMPL_TRACE_SPAN("optimize");
+        if (!InterpolatePath(*m_checker, path)) {
+            SMPL_WARN_NAMED(PI_LOGGER, "Failed to interpolate planned path with %zu waypoints before optimization.", path.size());
         }
+        std::vector<RobotState> ipath = path;
+        SetCancellationToken(m_checker, &m_cancel);
+        OptimizePath(
+                m_robot, m_checker, ipath, path,
+                m_optimize_iterations, m_optimize_clearance,
+                100.0, 0.2, &m_cancel);
+        SetCancellationToken(m_checker, (const CancellationToken*)nullptr);
     }
 
     // interpolate path
     if (m_params.interpolate_path) {
+        SMPL_TRACE_SPAN("interpolate");
         if (!InterpolatePath(*m_checker, path)) {
             SMPL_WARN_NAMED(PI_LOGGER, "Failed to interpolate trajectory");
         }
@@ -0,0 +1,299 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+/// \author Andrew Dornbush
+
+#include <smpl/ros/request_scheduler.h>
+
+// standard includes
+#include <algorithm>
+#include <utility>
+
+// system includes
+#include <moveit_msgs/MoveItErrorCodes.h>
+#include <smpl/console/console.h>
+#include <smpl/stl/memory.h>
+
+// project includes
+#include <smpl/ros/planner_interface.h>
+
+namespace smpl {
+
+static const char* LOG = "scheduler";
+
+auto to_cstring(RequestPriority priority) -> const char*
+{
+    switch (priority) {
+    case RequestPriority::Urgent:       return "Urgent";
+    case RequestPriority::Normal:       return "Normal";
+    case RequestPriority::Background:   return "Background";
+    default:                            return "Unknown";
+    }
+}
+
+RequestScheduler::RequestScheduler(
+    const std::vector<PlannerInterface*>& planners,
+    std::size_t memory_budget)
+:
+    m_mutex(),
+    m_cond(),
+    m_executors(),
+    m_queues(),
+    m_stats(),
+    m_memory_budget(memory_budget),
+    m_memory_reserved(0),
+    m_shutdown(false)
+{
+    for (auto* planner : planners) {
+        auto executor = make_unique<Executor>();
+        executor->planner = planner;
+        executor->preempting = false;
+        m_executors.push_back(std::move(executor));
+    }
+
+    // start the threads once the executors are no longer moved around
+    for (auto& executor : m_executors) {
+        auto* e = executor.get();
+        e->thread = std::thread([this, e]() { run(e); });
+    }
+}
+
+RequestScheduler::~RequestScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_shutdown = true;
+        for (auto& executor : m_executors) {
+            if (executor->running) {
+                executor->planner->cancel();
+            }
+        }
+    }
+    m_cond.notify_all();
+
+    for (auto& executor : m_executors) {
+        executor->thread.join();
+    }
+
+    for (auto& queue : m_queues) {
+        while (!queue.empty()) {
+            auto request = std::move(queue.front());
+            queue.pop_front();
+            ++m_stats[(int)request->priority].rejected;
+            reject(std::move(request));
+        }
+    }
+}
+
+auto RequestScheduler::submit(
+    const moveit_msgs::PlanningScene& planning_scene,
+    const moveit_msgs::MotionPlanRequest& req,
+    RequestPriority priority,
+    std::size_t memory)
+    -> std::future<moveit_msgs::MotionPlanResponse>
+{
+    auto request = make_unique<Request>();
+    request->planning_scene = planning_scene;
+    request->req = req;
+    request->priority = priority;
+    request->memory = memory;
+    request->submitted = clock::now();
+    auto response = request->response.get_future();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    auto& stats = m_stats[(int)priority];
+    ++stats.submitted;
+
+    if (m_shutdown || (m_memory_budget != 0 && memory > m_memory_budget)) {
+        SMPL_WARN_NAMED(LOG, "Reject %s request: it reserves %zu bytes of a %zu byte budget", to_cstring(priority), memory, m_memory_budget);
+        ++stats.rejected;
+        lock.unlock();
+        reject(std::move(request));
+        return response;
+    }
+
+    // the request starts right away if there are idle executors for it and
+    // for every request queued ahead of it, and its reservation fits
+    auto ahead = std::size_t(0);
+    for (int p = 0; p <= (int)priority; ++p) {
+        ahead += m_queues[p].size();
+    }
+    auto idle = (std::size_t)std::count_if(
+            begin(m_executors), end(m_executors),
+            [](const std::unique_ptr<Executor>& e) { return !e->running; });
+
+    if (idle <= ahead || !admissible(*request)) {
+        preemptFor(*request);
+    }
+
+    m_queues[(int)priority].push_back(std::move(request));
+    lock.unlock();
+    m_cond.notify_all();
+    return response;
+}
+
+auto RequestScheduler::stats(RequestPriority priority) const -> ClassStats
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats[(int)priority];
+}
+
+std::size_t RequestScheduler::queuedCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto count = std::size_t(0);
+    for (auto& queue : m_queues) {
+        count += queue.size();
+    }
+    return count;
+}
+
+void RequestScheduler::run(Executor* executor)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        std::unique_ptr<Request> request;
+        m_cond.wait(lock, [&]()
+        {
+            return m_shutdown || (request = popAdmissible()) != nullptr;
+        });
+        if (!request) {
+            break;
+        }
+
+        m_memory_reserved += request->memory;
+        executor->started = clock::now();
+        executor->preempting = false;
+        executor->running = std::move(request);
+        auto* running = executor->running.get();
+        lock.unlock();
+
+        SMPL_DEBUG_NAMED(LOG, "Start %s request", to_cstring(running->priority));
+        moveit_msgs::MotionPlanResponse res;
+        executor->planner->solve(running->planning_scene, running->req, res);
+        auto finished = clock::now();
+
+        lock.lock();
+        auto done = std::move(executor->running);
+        m_memory_reserved -= done->memory;
+        auto preempted = executor->preempting;
+        executor->preempting = false;
+
+        if (preempted && !m_shutdown &&
+            res.error_code.val != moveit_msgs::MoveItErrorCodes::SUCCESS)
+        {
+            m_queues[(int)done->priority].push_front(std::move(done));
+        } else {
+            auto& stats = m_stats[(int)done->priority];
+            auto wait = to_seconds(executor->started - done->submitted);
+            auto latency = to_seconds(finished - done->submitted);
+            ++stats.completed;
+            stats.total_wait += wait;
+            stats.max_wait = std::max(stats.max_wait, wait);
+            stats.total_latency += latency;
+            stats.max_latency = std::max(stats.max_latency, latency);
+
+            lock.unlock();
+            done->response.set_value(std::move(res));
+            lock.lock();
+        }
+
+        // memory was released and, for preempted requests, queued again
+        m_cond.notify_all();
+    }
+}
+
+// Remove and return the first request of the highest non-empty priority
+// class, if its reservation fits. Requests of lower classes may not start
+// ahead of it, even if theirs would.
+auto RequestScheduler::popAdmissible() -> std::unique_ptr<Request>
+{
+    for (auto& queue : m_queues) {
+        if (queue.empty()) {
+            continue;
+        }
+        if (!admissible(*queue.front())) {
+            return nullptr;
+        }
+        auto request = std::move(queue.front());
+        queue.pop_front();
+        return request;
+    }
+    return nullptr;
+}
+
+bool RequestScheduler::admissible(const Request& request) const
+{
+    return m_memory_budget == 0 ||
+            m_memory_reserved + request.memory <= m_memory_budget;
+}
+
+// Cancel the running request of the lowest class below the class of
+// request, the most recently started within that class, unless it is
+// already being preempted
+void RequestScheduler::preemptFor(const Request& request)
+{
+    Executor* victim = nullptr;
+    for (auto& executor : m_executors) {
+        if (!executor->running || executor->preempting ||
+            executor->running->priority <= request.priority)
+        {
+            continue;
+        }
+        if (victim == nullptr ||
+            executor->running->priority > victim->running->priority ||
+            (executor->running->priority == victim->running->priority &&
+                executor->started > victim->started))
+        {
+            victim = executor.get();
+        }
+    }
+
+    if (victim == nullptr) {
+        return;
+    }
+
+    SMPL_INFO_NAMED(LOG, "Preempt %s request for %s request", to_cstring(victim->running->priority), to_cstring(request.priority));
+    victim->preempting = true;
+    ++m_stats[(int)victim->running->priority].preempted;
+    victim->planner->cancel();
+}
+
+void RequestScheduler::reject(std::unique_ptr<Request> request)
+{
+    moveit_msgs::MotionPlanResponse res;
+    res.trajectory_start = request->planning_scene.robot_state;
+    res.group_name = request->req.group_name;
+    res.error_code.val = moveit_msgs::MoveItErrorCodes::FAILURE;
+    request->response.set_value(std::move(res));
+}
+
+} // namespace smpl
@@ -0,0 +1,113 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+/// \author Andrew Dornbush
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE AnglesTest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <smpl/angles.h>
+
+static auto MakeAngles(int n) -> std::vector<double>
+{
+    std::mt19937 gen(0);
+    std::uniform_real_distribution<double> dist(-20.0, 20.0);
+    std::vector<double> angles(n);
+    for (auto& a : angles) {
+        a = dist(gen);
+    }
+    return angles;
+}
+
+BOOST_AUTO_TEST_CASE(NormalizeAnglesTest)
+{
+    auto angles = MakeAngles(1000);
+    auto normalized = angles;
+    smpl::normalize_angles(normalized.data(), normalized.size());
+    for (size_t i = 0; i < angles.size(); ++i) {
+        BOOST_CHECK_SMALL(
+                smpl::normalize_angle(angles[i] - normalized[i]), 1e-9);
+        BOOST_CHECK_LE(std::fabs(normalized[i]), M_PI);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(NormalizeAnglesPositiveTest)
+{
+    auto angles = MakeAngles(1000);
+    auto normalized = angles;
+    smpl::normalize_angles_positive(normalized.data(), normalized.size());
+    for (size_t i = 0; i < angles.size(); ++i) {
+        BOOST_CHECK_CLOSE(
+                normalized[i],
+                smpl::normalize_angle_positive(angles[i]),
+                1e-9);
+        BOOST_CHECK_GE(normalized[i], 0.0);
+        BOOST_CHECK_LE(normalized[i], 2.0 * M_PI);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ShortestAngleDistsTest)
+{
+    auto af = MakeAngles(1000);
+    auto ai = MakeAngles(1001);
+    ai.erase(ai.begin());
+
+    std::vector<double> diffs(af.size());
+    std::vector<double> dists(af.size());
+    smpl::shortest_angle_diffs(af.data(), ai.data(), diffs.data(), af.size());
+    smpl::shortest_angle_dists(af.data(), ai.data(), dists.data(), af.size());
+    for (size_t i = 0; i < af.size(); ++i) {
+        BOOST_CHECK_SMALL(diffs[i] - smpl::shortest_angle_diff(af[i], ai[i]), 1e-9);
+        BOOST_CHECK_SMALL(dists[i] - smpl::shortest_angle_dist(af[i], ai[i]), 1e-9);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(WithinLimitsTest)
+{
+    auto inf = std::numeric_limits<double>::infinity();
+    std::vector<double> min_limits = { -1.0, 0.0, -inf };
+    std::vector<double> max_limits = { 1.0, 2.0, inf };
+
+    auto within = [&](std::vector<double> values) {
+        return smpl::within_limits(
+                values.data(), min_limits.data(), max_limits.data(), values.size());
+    };
+
+    BOOST_CHECK(within({ 0.0, 1.0, 100.0 }));
+    BOOST_CHECK(within({ -1.0, 2.0, -100.0 }));
+    BOOST_CHECK(!within({ -1.5, 1.0, 0.0 }));
+    BOOST_CHECK(!within({ 0.0, 2.5, 0.0 }));
+    BOOST_CHECK(!within({ 0.0, 1.0, std::numeric_limits<double>::quiet_NaN() }));
+}
@@ -0,0 +1,79 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+/// \author Andrew Dornbush
+
+#include <new>
+
+#define BOOST_TEST_MODULE ArenaTest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <smpl/arena.h>
+
+BOOST_AUTO_TEST_CASE(AllocateTest)
+{
+    smpl::Arena arena(256);
+    auto* a = arena.construct<int>(1);
+    auto* b = arena.construct<int>(2);
+    BOOST_CHECK_EQUAL(*a, 1);
+    BOOST_CHECK_EQUAL(*b, 2);
+    BOOST_CHECK_EQUAL(arena.capacity(), 256);
+
+    arena.reset();
+    BOOST_CHECK_EQUAL(arena.used(), 0);
+    BOOST_CHECK_EQUAL(arena.capacity(), 256);
+
+    arena.release();
+    BOOST_CHECK_EQUAL(arena.capacity(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(CapacityLimitTest)
+{
+    smpl::Arena arena(256);
+    arena.setCapacityLimit(512);
+
+    // fill the two blocks allowed by the limit
+    int count = 0;
+    while (arena.tryConstruct<double>(1.0) != nullptr) {
+        ++count;
+    }
+    BOOST_CHECK_GE(count, 2 * 256 / (int)sizeof(double) - 2);
+    BOOST_CHECK_LE(arena.capacity(), 512);
+    BOOST_CHECK_THROW(arena.allocate(sizeof(double)), std::bad_alloc);
+
+    // memory retained by reset() remains available under the limit
+    arena.reset();
+    BOOST_CHECK(arena.tryConstruct<double>(2.0) != nullptr);
+
+    arena.setCapacityLimit(0);
+    BOOST_CHECK_NO_THROW(arena.allocate(1024));
+    BOOST_CHECK_GT(arena.capacity(), 512);
+}
@@ -0,0 +1,397 @@
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE BFS3DTest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <smpl/bfs3d/bfs3d.h>
+#include <smpl/bfs3d/soft_bfs3d.h>
+#include <smpl/cancellation.h>
+#include <smpl/heuristic/bfs_heuristic.h>
+
+static const int N = 24;
+
+template <typename BFS>
+static void Wait(const BFS& bfs)
+{
+    while (bfs.isRunning());
+}
+
+template <typename BFS>
+static void SetWalls(BFS& bfs, const std::vector<bool>& walls)
+{
+    for (int x = 0; x < N; ++x) {
+    for (int y = 0; y < N; ++y) {
+    for (int z = 0; z < N; ++z) {
+        if (walls[(x * N + y) * N + z]) {
+            bfs.setWall(x, y, z);
+        }
+    }
+    }
+    }
+}
+
+template <typename BFSA, typename BFSB>
+static void CheckSameDistances(const BFSA& a, const BFSB& b)
+{
+    int mismatches = 0;
+    for (int x = 0; x < N; ++x) {
+    for (int y = 0; y < N; ++y) {
+    for (int z = 0; z < N; ++z) {
+        if (a.getDistance(x, y, z) != b.getDistance(x, y, z)) {
+            ++mismatches;
+        }
+    }
+    }
+    }
+    BOOST_CHECK_EQUAL(mismatches, 0);
+}
+
+BOOST_AUTO_TEST_CASE(UpdateWallsBeforeRunTest)
+{
+    smpl::BFS_3D bfs(N, N, N);
+    bfs.updateWalls({ 1, 2, 3, 4, 5, 6 }, { 4, 5, 6 });
+    BOOST_CHECK(bfs.isWall(1, 2, 3));
+    BOOST_CHECK(!bfs.isWall(4, 5, 6));
+}
+
+BOOST_AUTO_TEST_CASE(UpdateWallsMatchesRerunTest)
+{
+    std::default_random_engine rng(7);
+    std::uniform_int_distribution<int> coord(0, N - 1);
+    std::bernoulli_distribution occupied(0.3);
+
+    std::vector<bool> walls(N * N * N, false);
+    for (size_t i = 1; i < walls.size(); ++i) {
+        walls[i] = occupied(rng);
+    }
+
+    smpl::BFS_3D repaired(N, N, N);
+    SetWalls(repaired, walls);
+    repaired.run(0, 0, 0);
+    Wait(repaired);
+
+    for (int round = 0; round < 20; ++round) {
+        std::vector<int> added, removed;
+        for (int change = 0; change < 40; ++change) {
+            int x = coord(rng), y = coord(rng), z = coord(rng);
+            if (x == 0 && y == 0 && z == 0) {
+                continue;
+            }
+            const int i = (x * N + y) * N + z;
+            std::vector<int>& changed = walls[i] ? removed : added;
+            changed.push_back(x);
+            changed.push_back(y);
+            changed.push_back(z);
+            walls[i] = !walls[i];
+        }
+
+        repaired.updateWalls(added, removed);
+
+        smpl::BFS_3D rerun(N, N, N);
+        SetWalls(rerun, walls);
+        rerun.run(0, 0, 0);
+        Wait(rerun);
+
+        CheckSameDistances(repaired, rerun);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(RunMultipleStartCellsTest)
+{
+    smpl::BFS_3D bfs(N, N, N);
+    std::vector<int> starts = { 0, 0, 0, N - 1, N - 1, N - 1 };
+    bfs.run(begin(starts), end(starts));
+    Wait(bfs);
+    BOOST_CHECK_EQUAL(bfs.getDistance(0, 0, 0), 0);
+    BOOST_CHECK_EQUAL(bfs.getDistance(N - 1, N - 1, N - 1), 0);
+    BOOST_CHECK_EQUAL(bfs.getDistance(N - 2, N - 1, N - 1), 1);
+}
+
+BOOST_AUTO_TEST_CASE(RestoreDistancesTest)
+{
+    smpl::BFS_3D bfs(N, N, N);
+    bfs.setWall(5, 5, 5);
+    bfs.run(0, 0, 0);
+    Wait(bfs);
+
+    std::vector<int> distances;
+    bfs.copyDistances(distances);
+
+    smpl::BFS_3D other(N, N, N);
+    other.setWall(5, 5, 5);
+    other.run(N - 1, 0, 0);
+    BOOST_CHECK(other.restoreDistances(distances));
+    CheckSameDistances(bfs, other);
+
+    smpl::BFS_3D smaller(N - 1, N, N);
+    BOOST_CHECK(!smaller.restoreDistances(distances));
+}
+
+BOOST_AUTO_TEST_CASE(LazyMatchesEagerTest)
+{
+    std::default_random_engine rng(11);
+    std::bernoulli_distribution occupied(0.3);
+    std::vector<bool> walls(N * N * N, false);
+    for (size_t i = 1; i < walls.size(); ++i) {
+        walls[i] = occupied(rng);
+    }
+
+    smpl::BFS_3D eager(N, N, N);
+    SetWalls(eager, walls);
+    eager.run(0, 0, 0);
+    Wait(eager);
+
+    smpl::BFS_3D lazy(N, N, N);
+    lazy.setLazy(true);
+    SetWalls(lazy, walls);
+    lazy.run(0, 0, 0);
+    BOOST_CHECK(!lazy.isRunning());
+
+    // the first query only discovers cells near the start cell
+    BOOST_CHECK_EQUAL(lazy.getDistance(1, 1, 1), eager.getDistance(1, 1, 1));
+    BOOST_CHECK_LT(lazy.countDiscovered(), eager.countDiscovered());
+
+    CheckSameDistances(eager, lazy);
+}
+
+BOOST_AUTO_TEST_CASE(CancelledSearchIsResumedTest)
+{
+    std::default_random_engine rng(5);
+    std::bernoulli_distribution occupied(0.3);
+    std::vector<bool> walls(N * N * N, false);
+    for (size_t i = 1; i < walls.size(); ++i) {
+        walls[i] = occupied(rng);
+    }
+
+    smpl::BFS_3D eager(N, N, N);
+    SetWalls(eager, walls);
+    eager.run(0, 0, 0);
+    Wait(eager);
+
+    for (int threads : { 1, 2 }) {
+        smpl::CancellationToken token;
+        token.cancel();
+
+        smpl::BFS_3D cancelled(N, N, N);
+        cancelled.setThreadCount(threads);
+        cancelled.setCancellationToken(&token);
+        SetWalls(cancelled, walls);
+        cancelled.run(0, 0, 0);
+        Wait(cancelled);
+
+        // the search stops before expanding any cells, and queries resume it
+        BOOST_CHECK_LT(cancelled.countDiscovered(), eager.countDiscovered());
+        CheckSameDistances(eager, cancelled);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(LazyUpdateWallsTest)
+{
+    smpl::BFS_3D lazy(N, N, N);
+    lazy.setLazy(true);
+    lazy.run(0, 0, 0);
+    BOOST_CHECK_EQUAL(lazy.getDistance(2, 0, 0), 2);
+
+    std::vector<int> wall;
+    for (int y = 0; y < N; ++y) {
+    for (int z = 0; z < N; ++z) {
+        if (y != N - 1 || z != N - 1) {
+            wall.push_back(1);
+            wall.push_back(y);
+            wall.push_back(z);
+        }
+    }
+    }
+    lazy.updateWalls(wall, { });
+
+    smpl::BFS_3D eager(N, N, N);
+    eager.updateWalls(wall, { });
+    eager.run(0, 0, 0);
+    Wait(eager);
+
+    CheckSameDistances(eager, lazy);
+}
+
+BOOST_AUTO_TEST_CASE(CompactCellsMatchTest)
+{
+    std::default_random_engine rng(3);
+    std::bernoulli_distribution occupied(0.3);
+    std::vector<bool> walls(N * N * N, false);
+    for (size_t i = 1; i < walls.size(); ++i) {
+        walls[i] = occupied(rng);
+    }
+
+    smpl::BFS_3D bfs(N, N, N);
+    SetWalls(bfs, walls);
+    bfs.run(0, 0, 0);
+    Wait(bfs);
+
+    smpl::BFS_3D16 bfs16(N, N, N);
+    SetWalls(bfs16, walls);
+    bfs16.run(0, 0, 0);
+    Wait(bfs16);
+
+    CheckSameDistances(bfs, bfs16);
+    BOOST_CHECK_EQUAL(bfs.countUndiscovered(), bfs16.countUndiscovered());
+    BOOST_CHECK_EQUAL(bfs.countWalls(), bfs16.countWalls());
+}
+
+BOOST_AUTO_TEST_CASE(CompactCellsSaturateTest)
+{
+    // a corridor longer than the largest 8-bit distance
+    const int length = 300;
+    smpl::BFS_3D8 bfs(length, 1, 1);
+    bfs.run(0, 0, 0);
+    Wait(bfs);
+
+    BOOST_CHECK_EQUAL(bfs.getDistance(100, 0, 0), 100);
+    BOOST_CHECK_EQUAL(bfs.getDistance(253, 0, 0), 253);
+    BOOST_CHECK_EQUAL(bfs.getDistance(254, 0, 0), 253);
+    BOOST_CHECK_EQUAL(bfs.getDistance(length - 1, 0, 0), 253);
+    BOOST_CHECK_EQUAL(bfs.countUndiscovered(), 0);
+
+    // cutting the corridor is repaired by rerunning the search
+    bfs.updateWalls({ 200, 0, 0 }, { });
+    BOOST_CHECK_EQUAL(bfs.getDistance(199, 0, 0), 199);
+    BOOST_CHECK_EQUAL(bfs.getDistance(201, 0, 0), smpl::BFS_3D::UNDISCOVERED);
+    BOOST_CHECK_EQUAL(bfs.getDistance(length - 1, 0, 0), smpl::BFS_3D::UNDISCOVERED);
+}
+
+BOOST_AUTO_TEST_CASE(SearchRegistrySharesSearchesTest)
+{
+    smpl::BfsSearchRegistry registry;
+
+    int searches = 0;
+    auto make = [&]() {
+        ++searches;
+        std::shared_ptr<smpl::BFS_3D16> bfs(new smpl::BFS_3D16(N, N, N));
+        bfs->run(0, 0, 0);
+        return bfs;
+    };
+
+    smpl::BfsSearchRegistry::Key key;
+    key.grid = NULL;
+    key.world_version = 1;
+    key.inflation_radius = 0.0;
+    key.goal = { 0, 0, 0 };
+
+    auto a = registry.acquire(key, make);
+    auto b = registry.acquire(key, make);
+    BOOST_CHECK_EQUAL(searches, 1);
+    BOOST_CHECK(a == b);
+    BOOST_CHECK_EQUAL(b->getDistance(N - 1, N - 1, N - 1), N - 1);
+
+    // a change to the world is a different search
+    key.world_version = 2;
+    auto c = registry.acquire(key, make);
+    BOOST_CHECK_EQUAL(searches, 2);
+    BOOST_CHECK(c != a);
+    BOOST_CHECK_EQUAL(registry.size(), 2);
+
+    // searches are freed with their last holder
+    a.reset();
+    BOOST_CHECK_EQUAL(registry.size(), 2);
+    b.reset();
+    BOOST_CHECK_EQUAL(registry.size(), 1);
+    key.world_version = 1;
+    registry.acquire(key, make);
+    BOOST_CHECK_EQUAL(searches, 3);
+}
+
+// Random cell costs in [1, 20], with about a fifth of the cells walls
+static std::vector<int> MakeCellCosts(std::default_random_engine& rng)
+{
+    std::uniform_int_distribution<int> cost(1, 20);
+    std::bernoulli_distribution occupied(0.2);
+    std::vector<int> costs(N * N * N);
+    for (auto& c : costs) {
+        c = occupied(rng) ? smpl::SoftBFS_3D::WALL : cost(rng);
+    }
+    return costs;
+}
+
+static void SetCellCosts(smpl::SoftBFS_3D& bfs, const std::vector<int>& costs)
+{
+    for (int x = 0; x < N; ++x) {
+    for (int y = 0; y < N; ++y) {
+    for (int z = 0; z < N; ++z) {
+        bfs.setCellCost(x, y, z, costs[(x * N + y) * N + z]);
+    }
+    }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(SoftUnitCostsMatchBfsTest)
+{
+    std::default_random_engine rng(3);
+    std::bernoulli_distribution occupied(0.3);
+    std::vector<bool> walls(N * N * N, false);
+    for (size_t i = 1; i < walls.size(); ++i) {
+        walls[i] = occupied(rng);
+    }
+
+    smpl::BFS_3D bfs(N, N, N);
+    SetWalls(bfs, walls);
+    bfs.run(0, 0, 0);
+    Wait(bfs);
+
+    smpl::SoftBFS_3D soft(N, N, N);
+    SetWalls(soft, walls);
+    soft.run(0, 0, 0);
+
+    CheckSameDistances(bfs, soft);
+}
+
+BOOST_AUTO_TEST_CASE(SoftParallelMatchesSerialTest)
+{
+    std::default_random_engine rng(5);
+    auto costs = MakeCellCosts(rng);
+
+    smpl::SoftBFS_3D serial(N, N, N);
+    SetCellCosts(serial, costs);
+    serial.run(N / 2, N / 2, N / 2);
+
+    smpl::SoftBFS_3D parallel(N, N, N);
+    parallel.setThreadCount(4);
+    SetCellCosts(parallel, costs);
+    parallel.run(N / 2, N / 2, N / 2);
+
+    CheckSameDistances(serial, parallel);
+    BOOST_CHECK_EQUAL(serial.getDistance(N / 2, N / 2, N / 2), 0);
+}
+
+BOOST_AUTO_TEST_CASE(SoftUpdateCellCostsMatchesRerunTest)
+{
+    std::default_random_engine rng(11);
+    std::uniform_int_distribution<int> coord(0, N - 1);
+    auto costs = MakeCellCosts(rng);
+    auto new_costs = MakeCellCosts(rng);
+    costs[0] = 1;
+
+    smpl::SoftBFS_3D repaired(N, N, N);
+    SetCellCosts(repaired, costs);
+    repaired.run(0, 0, 0);
+
+    for (int round = 0; round < 20; ++round) {
+        std::vector<int> cells, cell_costs;
+        for (int change = 0; change < 40; ++change) {
+            int x = coord(rng), y = coord(rng), z = coord(rng);
+            const int i = (x * N + y) * N + z;
+            costs[i] = new_costs[(i + round) % new_costs.size()];
+            cells.push_back(x);
+            cells.push_back(y);
+            cells.push_back(z);
+            cell_costs.push_back(costs[i]);
+        }
+
+        repaired.updateCellCosts(cells, cell_costs);
+
+        smpl::SoftBFS_3D rerun(N, N, N);
+        SetCellCosts(rerun, costs);
+        rerun.run(0, 0, 0);
+
+        CheckSameDistances(repaired, rerun);
+    }
+}
@@ -0,0 +1,132 @@
+#include <iostream>
+
+#define BOOST_TEST_MODULE BrickGridTest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <smpl/grid/brick_grid.h>
+
+BOOST_AUTO_TEST_CASE(ValueConstructorTest)
+{
+    smpl::BrickGrid<int> g(20, 10, 5, 8);
+    BOOST_CHECK_EQUAL(g.size(), 20 * 10 * 5);
+    BOOST_CHECK_EQUAL(g.brick_count(), 3 * 2 * 1);
+    BOOST_CHECK_EQUAL(g.allocated_brick_count(), 0);
+    BOOST_CHECK_EQUAL(g.get(19, 9, 4), 8);
+}
+
+BOOST_AUTO_TEST_CASE(SetAllocatesSingleBrickTest)
+{
+    smpl::BrickGrid<int> g(20, 20, 20, 0);
+    g.set(9, 9, 9, 8);
+
+    BOOST_CHECK_EQUAL(g.get(9, 9, 9), 8);
+    BOOST_CHECK_EQUAL(g.get(9, 9, 10), 0);
+    BOOST_CHECK_EQUAL(g.get(8, 9, 9), 0);
+    BOOST_CHECK_EQUAL(g.allocated_brick_count(), 1);
+    BOOST_CHECK(g.allocated(8, 15, 12));
+    BOOST_CHECK(!g.allocated(7, 9, 9));
+}
+
+BOOST_AUTO_TEST_CASE(ReferenceStabilityTest)
+{
+    smpl::BrickGrid<int> g(64, 64, 64, 0);
+    int* p = &g(1, 2, 3);
+    for (int i = 0; i < 64; ++i) {
+        g(i, i, i) = i;
+    }
+    *p = 5;
+    BOOST_CHECK_EQUAL(g.get(1, 2, 3), 5);
+}
+
+BOOST_AUTO_TEST_CASE(NeighborOffsetTest)
+{
+    smpl::BrickGrid<int> g(16, 16, 16, 0);
+    BOOST_CHECK(g.brick_interior(9, 10, 14));
+    BOOST_CHECK(!g.brick_interior(8, 10, 14));
+    BOOST_CHECK(!g.brick_interior(9, 10, 15));
+
+    int* c = &g(9, 10, 14);
+    for (int dx = -1; dx <= 1; ++dx) {
+    for (int dy = -1; dy <= 1; ++dy) {
+    for (int dz = -1; dz <= 1; ++dz) {
+        BOOST_CHECK_EQUAL(
+                c + g.neighbor_offset(dx, dy, dz),
+                &g(9 + dx, 10 + dy, 14 + dz));
+    }
+    }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(CopyConstructorTest)
+{
+    smpl::BrickGrid<int> g(20, 20, 20, 0);
+    g.set(0, 0, 0, 8);
+
+    smpl::BrickGrid<int> cg(g);
+    BOOST_CHECK_EQUAL(cg.get(0, 0, 0), 8);
+    BOOST_CHECK_NE(&cg(0, 0, 0), &g(0, 0, 0));
+
+    cg.set(0, 0, 0, 4);
+    BOOST_CHECK_EQUAL(g.get(0, 0, 0), 8);
+}
+
+BOOST_AUTO_TEST_CASE(CopyOnWriteTest)
+{
+    smpl::BrickGrid<int> g(32, 32, 32, 0);
+    g.set(0, 0, 0, 1);
+    g.set(31, 31, 31, 2);
+
+    smpl::BrickGrid<int> cg(g);
+    BOOST_CHECK_EQUAL(g.shared_brick_count(), 2);
+    BOOST_CHECK_EQUAL(cg.shared_brick_count(), 2);
+    BOOST_CHECK_EQUAL(&cg.get(0, 0, 0), &g.get(0, 0, 0));
+
+    // modifying a cell duplicates only the brick containing it
+    cg.set(1, 1, 1, 3);
+    BOOST_CHECK_EQUAL(cg.shared_brick_count(), 1);
+    BOOST_CHECK_EQUAL(g.get(1, 1, 1), 0);
+    BOOST_CHECK_EQUAL(cg.get(1, 1, 1), 3);
+    BOOST_CHECK_EQUAL(cg.get(0, 0, 0), 1);
+    BOOST_CHECK_EQUAL(&cg.get(31, 31, 31), &g.get(31, 31, 31));
+
+    // the original's copy of the brick is no longer shared
+    g.set(0, 0, 0, 4);
+    BOOST_CHECK_EQUAL(cg.get(0, 0, 0), 1);
+    BOOST_CHECK_EQUAL(g.shared_brick_count(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(PruneTest)
+{
+    smpl::BrickGrid<int> g(20, 20, 20, 0);
+    g.set(0, 0, 0, 8);
+    g.set(15, 15, 15, 0);
+    BOOST_CHECK_EQUAL(g.allocated_brick_count(), 2);
+
+    g.prune();
+    BOOST_CHECK_EQUAL(g.allocated_brick_count(), 1);
+    BOOST_CHECK_EQUAL(g.get(0, 0, 0), 8);
+
+    g.prune([](int v) { return v < 10; });
+    BOOST_CHECK_EQUAL(g.allocated_brick_count(), 0);
+    BOOST_CHECK_EQUAL(g.get(0, 0, 0), 0);
+}
+
+BOOST_AUTO_TEST_CASE(AcceptCoordsTest)
+{
+    smpl::BrickGrid<int> g(12, 12, 12, 0);
+    g.set(10, 10, 10, 1);
+
+    int count = 0;
+    int sum = 0;
+    g.accept_coords([&](
+        int val,
+        int fx, int fy, int fz,
+        int lx, int ly, int lz)
+    {
+        count += (lx - fx) * (ly - fy) * (lz - fz);
+        sum += val;
+    });
+    BOOST_CHECK_EQUAL(count, 12 * 12 * 12);
+    BOOST_CHECK_EQUAL(sum, 1);
+}
@@ -0,0 +1,211 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+/// \author Andrew Dornbush
+
+#include <limits>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE BucketHeapTest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <smpl/heap/bucket_heap.h>
+
+struct open_element : smpl::heap_element
+{
+    int priority;
+
+    open_element() = default;
+    open_element(int p) : priority(p) { }
+};
+
+struct open_element_key
+{
+    int operator()(const open_element& e) const { return e.priority; }
+};
+
+typedef smpl::bucket_heap<open_element, open_element_key> heap_type;
+
+static std::vector<open_element> MakeElements()
+{
+    std::vector<open_element> elements;
+    elements.push_back(open_element(8));
+    elements.push_back(open_element(10));
+    elements.push_back(open_element(4));
+    elements.push_back(open_element(2));
+    elements.push_back(open_element(12));
+    return elements;
+}
+
+BOOST_AUTO_TEST_CASE(PushPopTest)
+{
+    auto elements = MakeElements();
+
+    heap_type h;
+    BOOST_CHECK(h.empty());
+    for (auto& e : elements) {
+        h.push(&e);
+    }
+    BOOST_CHECK(h.size() == 5);
+    BOOST_CHECK(std::distance(h.begin(), h.end()) == 5);
+
+    BOOST_CHECK(h.min() == &elements[3]);
+    BOOST_CHECK(h.min_key() == 2);
+    h.pop();
+    BOOST_CHECK(!h.contains(&elements[3]));
+    BOOST_CHECK(h.min() == &elements[2]);
+    h.pop();
+    BOOST_CHECK(h.min() == &elements[0]);
+    h.pop();
+    BOOST_CHECK(h.min() == &elements[1]);
+    h.pop();
+    BOOST_CHECK(h.min() == &elements[4]);
+    h.pop();
+    BOOST_CHECK(h.empty());
+}
+
+// keys below the current minimum are allowed
+BOOST_AUTO_TEST_CASE(NonMonotoneTest)
+{
+    auto elements = MakeElements();
+
+    heap_type h;
+    h.push(&elements[4]);
+    h.push(&elements[1]);
+    BOOST_CHECK(h.min() == &elements[1]);
+
+    h.push(&elements[3]);
+    BOOST_CHECK(h.min() == &elements[3]);
+
+    elements[4].priority = -5;
+    h.decrease(&elements[4]);
+    BOOST_CHECK(h.min() == &elements[4]);
+
+    elements[4].priority = 20;
+    h.increase(&elements[4]);
+    BOOST_CHECK(h.min() == &elements[3]);
+
+    h.erase(&elements[3]);
+    BOOST_CHECK(h.min() == &elements[1]);
+
+    h.clear();
+    BOOST_CHECK(h.empty());
+    for (auto& e : elements) {
+        BOOST_CHECK(!h.contains(&e));
+    }
+}
+
+// keys are refreshed from the elements when the heap is rebuilt
+BOOST_AUTO_TEST_CASE(MakeTest)
+{
+    auto elements = MakeElements();
+
+    heap_type h;
+    for (auto& e : elements) {
+        h.push(&e);
+    }
+
+    for (auto it = h.begin(); it != h.end(); ++it) {
+        (*it)->priority = 100 - (*it)->priority;
+    }
+    h.make();
+
+    BOOST_CHECK(h.min() == &elements[4]);
+    h.pop();
+    BOOST_CHECK(h.min() == &elements[1]);
+    h.pop();
+    BOOST_CHECK(h.min() == &elements[0]);
+}
+
+// appended elements are ordered by the next make()
+BOOST_AUTO_TEST_CASE(AppendTest)
+{
+    auto elements = MakeElements();
+
+    heap_type h;
+    h.push(&elements[0]);
+    h.push(&elements[1]);
+    for (size_t i = 2; i < elements.size(); ++i) {
+        h.append(&elements[i]);
+        BOOST_CHECK(h.contains(&elements[i]));
+    }
+    BOOST_CHECK_EQUAL(h.size(), elements.size());
+    h.make();
+
+    int prev = -1;
+    while (!h.empty()) {
+        BOOST_CHECK(h.min_key() == h.min()->priority);
+        BOOST_CHECK(h.min()->priority >= prev);
+        prev = h.min()->priority;
+        h.pop();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(RandomOperationsTest)
+{
+    std::mt19937 gen(1);
+
+    std::vector<open_element> elements(1000);
+    heap_type h;
+
+    // keys drift upwards, as the f-values in a best-first search do
+    int lo = 0;
+    auto random_key = [&]() { return lo + (int)(gen() % 500); };
+
+    for (int i = 0; i < 5000; ++i) {
+        auto& e = elements[gen() % elements.size()];
+        if (!h.contains(&e)) {
+            e.priority = random_key();
+            h.push(&e);
+        } else if (i % 3 == 0) {
+            h.erase(&e);
+        } else if (i % 3 == 1) {
+            e.priority = random_key();
+            h.update(&e);
+        } else {
+            auto min = h.min()->priority;
+            for (auto it = h.begin(); it != h.end(); ++it) {
+                BOOST_CHECK((*it)->priority >= min);
+            }
+            h.pop();
+            lo += 5;
+        }
+    }
+
+    int prev = std::numeric_limits<int>::min();
+    while (!h.empty()) {
+        BOOST_CHECK(h.min_key() == h.min()->priority);
+        BOOST_CHECK(h.min()->priority >= prev);
+        prev = h.min()->priority;
+        h.pop();
+    }
+}
@@ -27,6 +27,7 @@
 #include <smpl/debug/visualizer_ros.h>
 #include <smpl/distance_map/euclid_distance_map.h>
 #include <smpl/planning_params.h>
+#include <smpl_ompl_interface/collision_checking.h>
 #include <smpl_ompl_interface/ompl_interface.h>
 #include <urdf_parser/urdf_parser.h>
 
@@ -675,13 +676,10 @@ int main(int argc, char* argv[])
 
     ompl::geometric::SimpleSetup ss(state_space);
 
-    // Use CollisionSpace as the collision checker...
-    ss.setStateValidityChecker([&](const ompl::base::State* state)
-    {
-        std::vector<double> values;
-        state_space->copyToReals(values, state);
-        return cc.isStateValid(values);
-    });
+    // Use CollisionSpace as the collision checker for both states and
+    // motions, validating motions by conservative advancement...
+    cc.setMotionCheckMode(smpl::collision::MotionCheckMode::ConservativeAdvancement);
+    smpl::SetCollisionChecker(ss.getSpaceInformation(), &cc);
 
     // Set up a projection evaluator to provide forward kinematics...
     auto* fk_projection = new ProjectionEvaluatorFK(state_space);
@@ -0,0 +1,117 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+/// \author Andrew Dornbush
+
+#include <map>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE CoordTableTest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <smpl/graph/coord_table.h>
+
+BOOST_AUTO_TEST_CASE(InsertFindTest)
+{
+    smpl::CoordTable table(3);
+    BOOST_CHECK_EQUAL(table.size(), 0);
+
+    int a[] = { 1, 2, 3 };
+    int b[] = { 3, 2, 1 };
+    BOOST_CHECK_EQUAL(table.find(a), -1);
+
+    int aid = table.insert(a);
+    int bid = table.insert(b);
+    BOOST_CHECK_EQUAL(aid, 0);
+    BOOST_CHECK_EQUAL(bid, 1);
+    BOOST_CHECK_EQUAL(table.size(), 2);
+    BOOST_CHECK_EQUAL(table.find(a), aid);
+    BOOST_CHECK_EQUAL(table.find(b), bid);
+    BOOST_CHECK_EQUAL_COLLECTIONS(a, a + 3, table.coord(aid), table.coord(aid) + 3);
+}
+
+BOOST_AUTO_TEST_CASE(ReserveTest)
+{
+    smpl::CoordTable table(2);
+
+    int id = table.reserve();
+    BOOST_CHECK_EQUAL(table.coord(id)[0], 0);
+    BOOST_CHECK_EQUAL(table.coord(id)[1], 0);
+
+    // reserved coordinates are never found by lookup
+    table.coord(id)[0] = 5;
+    int c[] = { 5, 0 };
+    BOOST_CHECK_EQUAL(table.find(c), -1);
+
+    int cid = table.insert(c);
+    BOOST_CHECK_NE(cid, id);
+    BOOST_CHECK_EQUAL(table.find(c), cid);
+}
+
+BOOST_AUTO_TEST_CASE(RandomTest)
+{
+    const int width = 7;
+    smpl::CoordTable table(width);
+
+    std::default_random_engine rng;
+    std::uniform_int_distribution<int> dist(-4, 4);
+
+    std::map<std::vector<int>, int> expected;
+    for (int i = 0; i < 20000; ++i) {
+        std::vector<int> coord(width);
+        for (auto& c : coord) {
+            c = dist(rng);
+        }
+        auto it = expected.find(coord);
+        if (it == expected.end()) {
+            BOOST_REQUIRE_EQUAL(table.find(coord.data()), -1);
+            int id = i % 5 == 0 ? table.reserve() : table.insert(coord.data());
+            if (i % 5 != 0) {
+                expected[coord] = id;
+            }
+        } else {
+            BOOST_REQUIRE_EQUAL(table.find(coord.data()), it->second);
+        }
+    }
+
+    for (auto& entry : expected) {
+        BOOST_REQUIRE_EQUAL(table.find(entry.first.data()), entry.second);
+        auto* coord = table.coord(entry.second);
+        BOOST_REQUIRE(std::equal(entry.first.begin(), entry.first.end(), coord));
+    }
+
+    table.clear();
+    BOOST_CHECK_EQUAL(table.size(), 0);
+    for (auto& entry : expected) {
+        BOOST_REQUIRE_EQUAL(table.find(entry.first.data()), -1);
+    }
+}
@@ -0,0 +1,243 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+/// \author Andrew Dornbush
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE DaryHeapTest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <smpl/heap/dary_heap.h>
+
+struct open_element : smpl::heap_element
+{
+    int priority;
+
+    open_element() = default;
+    open_element(int p) : priority(p) { }
+};
+
+struct open_element_key
+{
+    int operator()(const open_element& e) const { return e.priority; }
+};
+
+typedef smpl::dary_heap<open_element, open_element_key> heap_type;
+
+static std::vector<open_element> MakeElements()
+{
+    std::vector<open_element> elements;
+    elements.push_back(open_element(8));
+    elements.push_back(open_element(10));
+    elements.push_back(open_element(4));
+    elements.push_back(open_element(2));
+    elements.push_back(open_element(12));
+    return elements;
+}
+
+BOOST_AUTO_TEST_CASE(DefaultConstructTest)
+{
+    heap_type h;
+    BOOST_CHECK(h.empty());
+    BOOST_CHECK(h.size() == 0);
+    BOOST_CHECK(h.begin() == h.end());
+}
+
+BOOST_AUTO_TEST_CASE(PushPopTest)
+{
+    auto elements = MakeElements();
+
+    heap_type h;
+    for (auto& e : elements) {
+        h.push(&e);
+    }
+    BOOST_CHECK(h.size() == 5);
+    BOOST_CHECK(std::distance(h.begin(), h.end()) == 5);
+
+    BOOST_CHECK(h.min() == &elements[3]);
+    BOOST_CHECK(h.min_key() == 2);
+    h.pop();
+    BOOST_CHECK(!h.contains(&elements[3]));
+    BOOST_CHECK(h.min() == &elements[2]);
+    h.pop();
+    BOOST_CHECK(h.min() == &elements[0]);
+    h.pop();
+    BOOST_CHECK(h.min() == &elements[1]);
+    h.pop();
+    BOOST_CHECK(h.min() == &elements[4]);
+    h.pop();
+    BOOST_CHECK(h.empty());
+}
+
+BOOST_AUTO_TEST_CASE(EraseTest)
+{
+    auto elements = MakeElements();
+
+    heap_type h;
+    for (auto& e : elements) {
+        h.push(&e);
+    }
+
+    h.erase(&elements[3]);
+    BOOST_CHECK(!h.contains(&elements[3]));
+    BOOST_CHECK(h.min() == &elements[2]);
+
+    h.erase(&elements[1]);
+    BOOST_CHECK(h.size() == 3);
+    BOOST_CHECK(h.min() == &elements[2]);
+
+    h.clear();
+    BOOST_CHECK(h.empty());
+    for (auto& e : elements) {
+        BOOST_CHECK(!h.contains(&e));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(UpdateTest)
+{
+    auto elements = MakeElements();
+
+    heap_type h;
+    for (auto& e : elements) {
+        h.push(&e);
+    }
+
+    elements[3].priority = 6;
+    h.update(&elements[3]);
+    BOOST_CHECK(h.min() == &elements[2]);
+
+    elements[3].priority = 2;
+    h.update(&elements[3]);
+    BOOST_CHECK(h.min() == &elements[3]);
+
+    elements[3].priority = 9;
+    h.increase(&elements[3]);
+    BOOST_CHECK(h.min() == &elements[2]);
+
+    elements[4].priority = 1;
+    h.decrease(&elements[4]);
+    BOOST_CHECK(h.min() == &elements[4]);
+    BOOST_CHECK(h.min_key() == 1);
+}
+
+// keys are refreshed from the elements when the heap is rebuilt
+BOOST_AUTO_TEST_CASE(MakeTest)
+{
+    auto elements = MakeElements();
+
+    heap_type h;
+    for (auto& e : elements) {
+        h.push(&e);
+    }
+
+    for (auto it = h.begin(); it != h.end(); ++it) {
+        (*it)->priority = -(*it)->priority;
+    }
+    h.make();
+
+    BOOST_CHECK(h.min() == &elements[4]);
+    h.pop();
+    BOOST_CHECK(h.min() == &elements[1]);
+    h.pop();
+    BOOST_CHECK(h.min() == &elements[0]);
+}
+
+// appended elements are ordered by the next make()
+BOOST_AUTO_TEST_CASE(AppendTest)
+{
+    auto elements = MakeElements();
+
+    heap_type h;
+    h.push(&elements[0]);
+    h.push(&elements[1]);
+    for (size_t i = 2; i < elements.size(); ++i) {
+        h.append(&elements[i]);
+        BOOST_CHECK(h.contains(&elements[i]));
+    }
+    BOOST_CHECK_EQUAL(h.size(), elements.size());
+    h.make();
+
+    int prev = -1;
+    while (!h.empty()) {
+        BOOST_CHECK(h.min_key() == h.min()->priority);
+        BOOST_CHECK(h.min()->priority >= prev);
+        prev = h.min()->priority;
+        h.pop();
+    }
+}
+
+template <std::size_t D>
+void CheckRandomOperations()
+{
+    typedef smpl::dary_heap<open_element, open_element_key, D> dheap_type;
+
+    std::mt19937 gen(1);
+    std::uniform_int_distribution<int> dist(0, 10000);
+
+    std::vector<open_element> elements(1000);
+    dheap_type h;
+    for (auto& e : elements) {
+        e.priority = dist(gen);
+        h.push(&e);
+    }
+
+    for (int i = 0; i < 2000; ++i) {
+        auto& e = elements[gen() % elements.size()];
+        if (!h.contains(&e)) {
+            e.priority = dist(gen);
+            h.push(&e);
+        } else if (i % 3 == 0) {
+            h.erase(&e);
+        } else {
+            e.priority = dist(gen);
+            h.update(&e);
+        }
+    }
+
+    int prev = -1;
+    while (!h.empty()) {
+        BOOST_CHECK(h.min_key() == h.min()->priority);
+        BOOST_CHECK(h.min()->priority >= prev);
+        prev = h.min()->priority;
+        h.pop();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ArityTest)
+{
+    CheckRandomOperations<2>();
+    CheckRandomOperations<3>();
+    CheckRandomOperations<4>();
+    CheckRandomOperations<8>();
+}
@@ -1,9 +1,18 @@
+#include <algorithm>
+#include <cmath>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <ostream>
+#include <random>
+#include <string>
 #include <utility>
 
+#include <smpl/distance_map/chessboard_distance_map.h>
+#include <smpl/distance_map/edge_euclid_distance_map.h>
 #include <smpl/distance_map/euclid_distance_map.h>
+#include <smpl/distance_map/octree_distance_map.h>
+#include <smpl/distance_map/shared_distance_map.h>
 #include <smpl/distance_map/sparse_distance_map.h>
 
 /*
@@ -153,9 +162,434 @@ void TestSpecialMemberFunctions()
     }
 }
 
+template <class DistanceMap>
+void TestBatchedDistances()
+{
+    DistanceMap d(0.0, 0.0, 0.0, 10.0, 10.0, 10.0, 0.5, 2.0);
+
+    std::vector<Eigen::Vector3d> points;
+    std::default_random_engine rng;
+    std::uniform_real_distribution<double> dist(0.0, 10.0);
+    for (int i = 0; i < 10; ++i) {
+        points.emplace_back(dist(rng), dist(rng), dist(rng));
+    }
+    d.addPointsToMap(points);
+
+    // query points both inside and outside of the map
+    std::uniform_real_distribution<double> qdist(-1.0, 11.0);
+    const int count = 1001;
+    std::vector<double> x(count), y(count), z(count), dists(count);
+    for (int i = 0; i < count; ++i) {
+        x[i] = qdist(rng);
+        y[i] = qdist(rng);
+        z[i] = qdist(rng);
+    }
+
+    d.getMetricSquaredDistances(x.data(), y.data(), z.data(), count, dists.data());
+
+    for (int i = 0; i < count; ++i) {
+        if (dists[i] != d.getMetricSquaredDistance(x[i], y[i], z[i])) {
+            printf("Batched distance at (%f, %f, %f) differs\n", x[i], y[i], z[i]);
+        }
+    }
+
+    std::vector<float> xyz(3 * count), fdists(count);
+    for (int i = 0; i < count; ++i) {
+        xyz[3 * i + 0] = (float)x[i];
+        xyz[3 * i + 1] = (float)y[i];
+        xyz[3 * i + 2] = (float)z[i];
+    }
+    d.getMetricDistances(xyz.data(), count, fdists.data());
+    for (int i = 0; i < count; ++i) {
+        const float expected = (float)d.getMetricDistance(
+                xyz[3 * i + 0], xyz[3 * i + 1], xyz[3 * i + 2]);
+        if (fdists[i] != expected) {
+            printf("Batched float distance at (%f, %f, %f) differs\n", xyz[3 * i + 0], xyz[3 * i + 1], xyz[3 * i + 2]);
+        }
+    }
+
+    std::vector<int> cells;
+    for (int x = -1; x <= d.numCellsX(); ++x) {
+    for (int y = -1; y <= d.numCellsY(); ++y) {
+    for (int z = -1; z <= d.numCellsZ(); ++z) {
+        cells.push_back(x);
+        cells.push_back(y);
+        cells.push_back(z);
+    }
+    }
+    }
+    fdists.resize(cells.size() / 3);
+    d.getCellDistances(cells.data(), fdists.size(), fdists.data());
+    for (size_t i = 0; i < fdists.size(); ++i) {
+        const int* c = &cells[3 * i];
+        if (fdists[i] != (float)d.getCellDistance(c[0], c[1], c[2])) {
+            printf("Batched distance of cell (%d, %d, %d) differs\n", c[0], c[1], c[2]);
+        }
+    }
+}
+
+template <class DistanceMap>
+void TestView()
+{
+    DistanceMap d(0.0, 0.0, 0.0, 4.0, 3.0, 2.0, 0.1, 1.0);
+
+    std::vector<Eigen::Vector3d> points;
+    std::default_random_engine rng;
+    std::uniform_real_distribution<double> dist(0.0, 4.0);
+    for (int i = 0; i < 20; ++i) {
+        points.emplace_back(dist(rng), dist(rng), dist(rng));
+    }
+    d.addPointsToMap(points);
+
+    smpl::DistanceMapView view;
+    if (!d.getView(view)) {
+        printf("Dense distance map does not provide a view\n");
+        return;
+    }
+
+    for (int x = -1; x <= d.numCellsX(); ++x) {
+    for (int y = -1; y <= d.numCellsY(); ++y) {
+    for (int z = -1; z <= d.numCellsZ(); ++z) {
+        if (view.getCellDistance(x, y, z) != d.getCellDistance(x, y, z)) {
+            printf("View distance of cell (%d, %d, %d) differs\n", x, y, z);
+        }
+    }
+    }
+    }
+
+    std::uniform_real_distribution<double> qdist(-1.0, 5.0);
+    for (int i = 0; i < 1000; ++i) {
+        const double x = qdist(rng), y = qdist(rng), z = qdist(rng);
+        if (view.getMetricDistance(x, y, z) != d.getMetricDistance(x, y, z)) {
+            printf("View distance at (%f, %f, %f) differs\n", x, y, z);
+        }
+    }
+}
+
+// Check that the clearance of every cell matches its distance after each kind
+// of modification to the map.
+template <class DistanceMap>
+void TestClearance()
+{
+    DistanceMap d(0.0, 0.0, 0.0, 4.0, 3.0, 2.0, 0.1, 1.0);
+
+    auto check = [&](const char* when) {
+        smpl::DistanceMapView view;
+        if (!d.getView(view)) {
+            printf("Dense distance map does not provide a view\n");
+            return;
+        }
+        for (int x = 0; x < d.numCellsX(); ++x) {
+        for (int y = 0; y < d.numCellsY(); ++y) {
+        for (int z = 0; z < d.numCellsZ(); ++z) {
+            double wx, wy, wz;
+            d.gridToWorld(x, y, z, wx, wy, wz);
+            const double dist = view.getCellDistance(x, y, z);
+            const double clearance = view.getMetricClearance(wx, wy, wz);
+            if (clearance > dist || clearance <= dist - 0.1 - 1e-9) {
+                printf("Clearance of cell (%d, %d, %d) differs %s (%f vs %f)\n", x, y, z, when, clearance, dist);
+                return;
+            }
+        }
+        }
+        }
+    };
+
+    check("after construction");
+
+    std::vector<Eigen::Vector3d> points;
+    std::default_random_engine rng;
+    std::uniform_real_distribution<double> dist(0.0, 4.0);
+    for (int i = 0; i < 20; ++i) {
+        points.emplace_back(dist(rng), dist(rng), dist(rng));
+    }
+    d.addPointsToMap(points);
+    check("after insertion");
+
+    std::vector<Eigen::Vector3d> removed(points.begin(), points.begin() + 10);
+    d.removePointsFromMap(removed);
+    check("after removal");
+
+    std::vector<Eigen::Vector3d> more;
+    for (int i = 0; i < 20000; ++i) {
+        more.emplace_back(dist(rng), dist(rng), dist(rng));
+    }
+    d.setThreadCount(2);
+    d.addPointsToMap(more);
+    check("after bulk insertion");
+
+    d.reset();
+    check("after reset");
+}
+
+void TestParallelInsertion()
+{
+    smpl::EuclidDistanceMap serial(0.0, 0.0, 0.0, 4.0, 4.0, 4.0, 0.1, 1.0);
+    smpl::EuclidDistanceMap parallel(0.0, 0.0, 0.0, 4.0, 4.0, 4.0, 0.1, 1.0);
+    parallel.setThreadCount(4);
+
+    std::vector<Eigen::Vector3d> points;
+    std::default_random_engine rng;
+    std::uniform_real_distribution<double> dist(-0.5, 4.5);
+    for (int i = 0; i < 1000; ++i) {
+        points.emplace_back(dist(rng), dist(rng), dist(rng));
+    }
+
+    serial.addPointsToMap(points);
+    parallel.addPointsToMap(points);
+    if (serial != parallel) {
+        printf("Parallel insertion differs from serial insertion\n");
+    }
+
+    points.resize(points.size() >> 1);
+    serial.removePointsFromMap(points);
+    parallel.removePointsFromMap(points);
+    if (serial != parallel) {
+        printf("Removal after parallel insertion differs from serial\n");
+    }
+}
+
+void TestChessboardFullTransform()
+{
+    smpl::ChessboardDistanceMap incremental(0.0, 0.0, 0.0, 3.0, 3.0, 3.0, 0.1, 0.5);
+    smpl::ChessboardDistanceMap full(0.0, 0.0, 0.0, 3.0, 3.0, 3.0, 0.1, 0.5);
+    full.setThreadCount(4);
+
+    std::vector<Eigen::Vector3d> points;
+    std::default_random_engine rng;
+    std::uniform_real_distribution<double> dist(-0.5, 3.5);
+    for (int i = 0; i < 500; ++i) {
+        points.emplace_back(dist(rng), dist(rng), dist(rng));
+    }
+
+    // one point at a time is always propagated incrementally
+    for (auto& p : points) {
+        incremental.addPointsToMap({ p });
+    }
+    full.addPointsToMap(points);
+    if (incremental != full) {
+        printf("Chessboard full transform differs from incremental insertion\n");
+    }
+
+    points.resize(points.size() >> 1);
+    incremental.removePointsFromMap(points);
+    full.removePointsFromMap(points);
+    if (incremental != full) {
+        printf("Chessboard removal after full transform differs\n");
+    }
+}
+
+void TestEdgeEuclidFullTransform()
+{
+    smpl::EdgeEuclidDistanceMap d(0.0, 0.0, 0.0, 2.0, 2.0, 2.0, 0.1, 0.5);
+    d.setThreadCount(4);
+
+    std::vector<Eigen::Vector3d> points;
+    std::default_random_engine rng;
+    std::uniform_real_distribution<double> dist(0.0, 2.0);
+    for (int i = 0; i < 200; ++i) {
+        points.emplace_back(dist(rng), dist(rng), dist(rng));
+    }
+    d.addPointsToMap(points);
+
+    std::vector<Eigen::Vector3i> cells;
+    for (auto& p : points) {
+        int gx, gy, gz;
+        d.worldToGrid(p.x(), p.y(), p.z(), gx, gy, gz);
+        cells.emplace_back(gx, gy, gz);
+    }
+
+    // squared distance, in cells, to the nearest face of a cell
+    auto edge = [](int d) { d = std::abs(d); return d > 0 ? (d - 1) * (d - 1) : 0; };
+
+    // compare against the brute-force edge distance to the nearest obstacle
+    // cell, including the obstacle border just outside the map
+    const int max_sqrd = (int)std::round(d.maxDistance() / d.resolution());
+    for (int x = 0; x < d.numCellsX(); ++x) {
+    for (int y = 0; y < d.numCellsY(); ++y) {
+    for (int z = 0; z < d.numCellsZ(); ++z) {
+        int best = max_sqrd * max_sqrd;
+        for (auto& c : cells) {
+            best = std::min(best, edge(x - c.x()) + edge(y - c.y()) + edge(z - c.z()));
+        }
+        int b = std::min({
+                x, y, z,
+                d.numCellsX() - 1 - x,
+                d.numCellsY() - 1 - y,
+                d.numCellsZ() - 1 - z });
+        best = std::min(best, b * b);
+        const double expected = d.resolution() * std::sqrt((double)best);
+        if (std::fabs(d.getCellDistance(x, y, z) - expected) > 1e-9) {
+            printf("Edge Euclid distance at (%d, %d, %d) differs\n", x, y, z);
+        }
+    }
+    }
+    }
+}
+
+template <class DistanceMap>
+void TestSnapshot()
+{
+    DistanceMap d1(0.0, 0.0, 0.0, 10.0, 10.0, 10.0, 0.5, 2.0);
+    DistanceMap d2(0.0, 0.0, 0.0, 10.0, 10.0, 10.0, 0.5, 2.0);
+
+    std::vector<Eigen::Vector3d> points;
+    std::default_random_engine rng;
+    std::uniform_real_distribution<double> dist(0.0, 10.0);
+    for (int i = 0; i < 10; ++i) {
+        points.emplace_back(dist(rng), dist(rng), dist(rng));
+    }
+    d1.addPointsToMap(points);
+
+    const std::string path = "/tmp/smpl_distance_map_test.dmap";
+    if (!d1.save(path) || !d2.load(path)) {
+        printf("Failed to save and load distance map snapshot\n");
+        return;
+    }
+    if (d1 != d2) {
+        printf("Loaded distance map differs from saved distance map\n");
+    }
+
+    // loaded maps must remain incrementally updatable
+    points.resize(points.size() >> 1);
+    d1.removePointsFromMap(points);
+    d2.removePointsFromMap(points);
+    if (d1 != d2) {
+        printf("Loaded distance map differs after removal\n");
+    }
+}
+
+// Distances are shared in single precision
+bool SameDistances(
+    const smpl::DistanceMapInterface& d1,
+    const smpl::DistanceMapInterface& d2)
+{
+    for (int z = 0; z < d1.numCellsZ(); ++z) {
+    for (int y = 0; y < d1.numCellsY(); ++y) {
+    for (int x = 0; x < d1.numCellsX(); ++x) {
+        if (std::fabs(d1.getCellDistance(x, y, z) - d2.getCellDistance(x, y, z)) > 1e-6) {
+            return false;
+        }
+    }
+    }
+    }
+    return true;
+}
+
+void TestSharedDistanceMap()
+{
+    smpl::EuclidDistanceMap d(0.0, 0.0, 0.0, 10.0, 10.0, 10.0, 0.5, 2.0);
+
+    std::vector<Eigen::Vector3d> points;
+    std::default_random_engine rng;
+    std::uniform_real_distribution<double> dist(0.0, 10.0);
+    for (int i = 0; i < 10; ++i) {
+        points.emplace_back(dist(rng), dist(rng), dist(rng));
+    }
+    d.addPointsToMap(points);
+
+    const std::string name = "/smpl_distance_map_test";
+    smpl::SharedDistanceMapPublisher publisher;
+    if (!publisher.create(name, d)) {
+        printf("Failed to create shared distance map\n");
+        return;
+    }
+
+    auto shared = smpl::AttachSharedDistanceMap(name);
+    if (!shared) {
+        printf("Failed to attach shared distance map\n");
+        smpl::UnpublishSharedDistanceMap(name);
+        return;
+    }
+
+    if (!SameDistances(d, *shared)) {
+        printf("Shared distance map differs from published distance map\n");
+    }
+
+    // updates are visible to attached maps and their clones
+    std::unique_ptr<smpl::DistanceMapInterface> clone(shared->clone());
+    points.resize(points.size() >> 1);
+    d.removePointsFromMap(points);
+    publisher.publish(d);
+    if (shared->version() != 1 || !SameDistances(d, *clone)) {
+        printf("Shared distance map differs after update\n");
+    }
+
+    smpl::UnpublishSharedDistanceMap(name);
+}
+
+void TestOcTreeDistances()
+{
+    smpl::OcTreeDistanceMap d(0.0, 0.0, 0.0, 3.0, 2.0, 2.5, 0.1, 0.5);
+
+    std::vector<Eigen::Vector3d> points;
+    std::default_random_engine rng;
+    std::uniform_real_distribution<double> dist(-0.2, 3.2);
+    for (int i = 0; i < 200; ++i) {
+        points.emplace_back(dist(rng), dist(rng), dist(rng));
+    }
+
+    // a solid block, so that fully occupied nodes are collapsed and expanded
+    for (int x = 0; x < 8; ++x) {
+    for (int y = 0; y < 8; ++y) {
+    for (int z = 0; z < 8; ++z) {
+        points.emplace_back(0.8 + x * 0.1, 0.8 + y * 0.1, 0.8 + z * 0.1);
+    }
+    }
+    }
+    d.addPointsToMap(points);
+
+    std::vector<Eigen::Vector3d> removed(points.begin(), points.begin() + 100);
+    removed.emplace_back(0.8, 0.8, 0.8);
+    d.removePointsFromMap(removed);
+
+    std::vector<Eigen::Vector3i> occupied;
+    for (int x = 0; x < d.numCellsX(); ++x) {
+    for (int y = 0; y < d.numCellsY(); ++y) {
+    for (int z = 0; z < d.numCellsZ(); ++z) {
+        if (d.isOccupied(x, y, z)) {
+            occupied.emplace_back(x, y, z);
+        }
+    }
+    }
+    }
+
+    // compare against the brute-force distance to the nearest occupied cell
+    for (int x = 0; x < d.numCellsX(); ++x) {
+    for (int y = 0; y < d.numCellsY(); ++y) {
+    for (int z = 0; z < d.numCellsZ(); ++z) {
+        double expected = d.maxDistance();
+        for (auto& c : occupied) {
+            const Eigen::Vector3d diff = (c - Eigen::Vector3i(x, y, z)).cast<double>();
+            expected = std::min(expected, d.resolution() * diff.norm());
+        }
+        if (std::fabs(d.getCellDistance(x, y, z) - expected) > 1e-9) {
+            printf("OcTree distance at (%d, %d, %d) differs\n", x, y, z);
+        }
+    }
+    }
+    }
+}
+
 int main(int argc, char* argv[])
 {
     TestSpecialMemberFunctions<smpl::SparseDistanceMap>();
+    TestBatchedDistances<smpl::SparseDistanceMap>();
+    TestBatchedDistances<smpl::EuclidDistanceMap>();
+    TestView<smpl::EuclidDistanceMap>();
+    TestView<smpl::ChessboardDistanceMap>();
+    TestClearance<smpl::EuclidDistanceMap>();
+    TestClearance<smpl::ChessboardDistanceMap>();
+    TestClearance<smpl::EdgeEuclidDistanceMap>();
+    TestParallelInsertion();
+    TestChessboardFullTransform();
+    TestEdgeEuclidFullTransform();
+    TestSnapshot<smpl::SparseDistanceMap>();
+    TestSnapshot<smpl::EuclidDistanceMap>();
+    TestSharedDistanceMap();
+    TestSpecialMemberFunctions<smpl::OcTreeDistanceMap>();
+    TestBatchedDistances<smpl::OcTreeDistanceMap>();
+    TestOcTreeDistances();
 //    TestSpecialMemberFunctions<smpl::EuclidDistanceMap>();
     return 0;
 }
@@ -0,0 +1,108 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE DubinsTest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <smpl/unicycle/dubins.h>
+
+BOOST_AUTO_TEST_CASE(KnownDistanceTest)
+{
+    // straight ahead
+    auto d = smpl::ComputeDubinsDistance(
+            smpl::Pose2D(0.0, 0.0, 0.0), smpl::Pose2D(5.0, 0.0, 0.0), 1.0);
+    BOOST_CHECK_CLOSE(d, 5.0, 1e-6);
+
+    // half circle to the left
+    d = smpl::ComputeDubinsDistance(
+            smpl::Pose2D(0.0, 0.0, 0.0), smpl::Pose2D(0.0, 2.0, M_PI), 1.0);
+    BOOST_CHECK_CLOSE(d, M_PI, 1e-6);
+
+    // same pose
+    d = smpl::ComputeDubinsDistance(
+            smpl::Pose2D(1.0, 2.0, 0.5), smpl::Pose2D(1.0, 2.0, 0.5), 1.0);
+    BOOST_CHECK_SMALL(d, 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE(MatchesConstructedPathsTest)
+{
+    std::default_random_engine rng(1);
+    std::uniform_real_distribution<double> pos(-10.0, 10.0);
+    std::uniform_real_distribution<double> ang(-M_PI, M_PI);
+
+    const double radius = 1.5;
+
+    const int count = 500;
+    std::vector<double> sx(count), sy(count), sth(count);
+    std::vector<double> gx(count), gy(count), gth(count);
+    std::vector<double> dist(count);
+    for (int i = 0; i < count; ++i) {
+        sx[i] = pos(rng);
+        sy[i] = pos(rng);
+        sth[i] = ang(rng);
+        gx[i] = pos(rng);
+        gy[i] = pos(rng);
+        gth[i] = ang(rng);
+    }
+
+    smpl::ComputeDubinsDistances(
+            sx.data(), sy.data(), sth.data(),
+            gx.data(), gy.data(), gth.data(),
+            radius, count, dist.data());
+
+    for (int i = 0; i < count; ++i) {
+        auto start = smpl::Pose2D(sx[i], sy[i], sth[i]);
+        auto goal = smpl::Pose2D(gx[i], gy[i], gth[i]);
+
+        BOOST_CHECK_CLOSE(
+                dist[i], smpl::ComputeDubinsDistance(start, goal, radius), 1e-9);
+
+        // MakeDubinsPaths only constructs the CSC words, whose shortest
+        // member is optimal when the turning circles are far enough apart
+        smpl::DubinsMotion motions[6];
+        auto n = smpl::MakeDubinsPaths(start, goal, radius, motions);
+        BOOST_REQUIRE(n > 0);
+        auto csc = motions[0].length();
+        for (int j = 1; j < n; ++j) {
+            csc = std::min(csc, motions[j].length());
+        }
+
+        BOOST_CHECK_LE(dist[i], csc + 1e-6);
+        auto sep = std::hypot(gx[i] - sx[i], gy[i] - sy[i]);
+        if (sep > 4.0 * radius) {
+            BOOST_CHECK_CLOSE(dist[i], csc, 1e-4);
+        }
+    }
+}
@@ -31,13 +31,16 @@
 
 // standard includes
 #include <algorithm>
+#include <cstdio>
 
 #define BOOST_TEST_MODULE ExperienceGraphTest
 #define BOOST_TEST_DYN_LINK
 #include <boost/test/unit_test.hpp>
 
 // system includes
+#include <unistd.h>
 #include <smpl/graph/experience_graph.h>
+#include <smpl/graph/experience_graph_file.h>
 
 bool IteratedAllNodes(const smpl::ExperienceGraph& eg)
 {
@@ -371,3 +374,129 @@ BOOST_AUTO_TEST_CASE(ParallelEdgeTest)
 //
 //    BOOST_CHECK_EQUAL(eg.degree(n1), 1);
 }
+
+BOOST_AUTO_TEST_CASE(BinaryFileRoundTripTest)
+{
+    smpl::ExperienceGraph eg;
+    auto n1 = eg.insert_node({ 0.0, 1.0 });
+    auto n2 = eg.insert_node({ 2.0, 3.0 });
+    auto n3 = eg.insert_node({ 4.0, 5.0 });
+    eg.insert_edge(n1, n2, { { 0.5, 1.5 }, { 1.0, 2.0 } });
+    eg.insert_edge(n2, n3);
+
+    auto path = std::string("egraph_test.egraph");
+    BOOST_REQUIRE(smpl::WriteExperienceGraphFile(path, eg));
+    BOOST_CHECK(smpl::IsExperienceGraphFile(path));
+
+    smpl::ExperienceGraphFile file;
+    BOOST_REQUIRE(file.open(path));
+    BOOST_CHECK_EQUAL(file.dof(), 2);
+    BOOST_CHECK_EQUAL(file.num_nodes(), 3);
+    BOOST_CHECK_EQUAL(file.num_edges(), 2);
+    BOOST_CHECK_EQUAL(file.state(n3)[1], 5.0);
+    BOOST_CHECK_EQUAL(std::distance(file.adjacency(n2).first, file.adjacency(n2).second), 2);
+    BOOST_CHECK_EQUAL(file.num_waypoints(0), 2);
+    BOOST_CHECK_EQUAL(file.waypoints(0)[3], 2.0);
+    BOOST_CHECK_EQUAL(file.num_waypoints(1), 0);
+
+    // appended node ids are offset by the existing nodes
+    smpl::ExperienceGraph copy;
+    copy.insert_node({ 9.0, 9.0 });
+    smpl::AppendExperienceGraphFile(file, copy);
+    BOOST_CHECK_EQUAL(copy.num_nodes(), 4);
+    BOOST_CHECK_EQUAL(copy.num_edges(), 2);
+    BOOST_CHECK(copy.state(n2 + 1) == eg.state(n2));
+    BOOST_CHECK_EQUAL(copy.source(0), n1 + 1);
+    BOOST_CHECK_EQUAL(copy.target(0), n2 + 1);
+    BOOST_CHECK(copy.waypoints(0) == eg.waypoints(0));
+    BOOST_CHECK(copy.edge(n2 + 1, n3 + 1));
+
+    file.close();
+    std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(BinaryFileRejectsTruncatedTest)
+{
+    smpl::ExperienceGraph eg;
+    auto n1 = eg.insert_node({ 0.0, 1.0 });
+    auto n2 = eg.insert_node({ 2.0, 3.0 });
+    eg.insert_edge(n1, n2, { { 1.0, 2.0 } });
+
+    auto path = std::string("egraph_test_truncated.egraph");
+    BOOST_REQUIRE(smpl::WriteExperienceGraphFile(path, eg));
+    BOOST_REQUIRE(truncate(path.c_str(), 64) == 0);
+
+    smpl::ExperienceGraphFile file;
+    BOOST_CHECK(!file.open(path));
+    BOOST_CHECK(!file.isOpen());
+
+    std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(SharedMemoryTest)
+{
+    smpl::ExperienceGraph eg;
+    auto n1 = eg.insert_node({ 0.0, 1.0 });
+    auto n2 = eg.insert_node({ 2.0, 3.0 });
+    eg.insert_edge(n1, n2, { { 1.0, 2.0 } });
+
+    auto name = std::string("/smpl_egraph_test");
+    BOOST_REQUIRE(smpl::PublishExperienceGraph(name, eg));
+
+    smpl::ExperienceGraphFile file;
+    BOOST_REQUIRE(file.open(EXPERIENCE_GRAPH_SHARED_PREFIX + name));
+    BOOST_CHECK_EQUAL(file.num_nodes(), 2);
+    BOOST_CHECK_EQUAL(file.num_edges(), 1);
+    BOOST_CHECK_EQUAL(file.waypoints(0)[1], 2.0);
+
+    // republishing leaves the attached graph intact
+    eg.insert_node({ 4.0, 5.0 });
+    BOOST_REQUIRE(smpl::PublishExperienceGraph(name, eg));
+    BOOST_CHECK_EQUAL(file.num_nodes(), 2);
+    BOOST_CHECK_EQUAL(file.state(n2)[1], 3.0);
+
+    smpl::ExperienceGraphFile other;
+    BOOST_REQUIRE(other.openShared(name));
+    BOOST_CHECK_EQUAL(other.num_nodes(), 3);
+
+    BOOST_CHECK(smpl::UnpublishExperienceGraph(name));
+    BOOST_CHECK(!file.openShared(name));
+}
+
+BOOST_AUTO_TEST_CASE(CompactTest)
+{
+    smpl::ExperienceGraph eg;
+    auto n1 = eg.insert_node({ 0.0, 1.0 });
+    auto n2 = eg.insert_node({ 2.0, 3.0 });
+    auto n3 = eg.insert_node({ 4.0, 5.0 });
+    auto e12 = eg.insert_edge(n1, n2, { { 0.5, 1.5 }, { 1.0, 2.0 } });
+    auto e23 = eg.insert_edge(n2, n3);
+
+    eg.compact();
+    BOOST_CHECK(eg.compacted());
+    BOOST_CHECK_EQUAL(eg.degree(n1), 1);
+    BOOST_CHECK_EQUAL(eg.degree(n2), 2);
+    BOOST_CHECK(eg.edge(n1, n2));
+    BOOST_CHECK(eg.edge(n3, n2));
+    BOOST_CHECK(!eg.edge(n1, n3));
+    BOOST_CHECK_EQUAL(*eg.adjacent_nodes(n3).first, n2);
+    BOOST_CHECK_EQUAL(*eg.edges(n3).first, e23);
+    BOOST_CHECK_EQUAL(eg.waypoint_count(e12), 2);
+    BOOST_CHECK_EQUAL(eg.waypoint_count(e23), 0);
+    BOOST_CHECK_EQUAL(eg.waypoint(e12, 1).first[1], 2.0);
+    BOOST_CHECK_EQUAL(eg.waypoint(e12, 1).second - eg.waypoint(e12, 1).first, 2);
+
+    // inserting a node keeps the compact layout
+    auto n4 = eg.insert_node({ 6.0, 7.0 });
+    BOOST_CHECK(eg.compacted());
+    BOOST_CHECK_EQUAL(eg.degree(n4), 0);
+
+    // inserting an edge restores the mutable layout
+    auto e34 = eg.insert_edge(n3, n4);
+    BOOST_CHECK(!eg.compacted());
+    BOOST_CHECK_EQUAL(eg.degree(n3), 2);
+    BOOST_CHECK(eg.edge(n4, n3));
+    BOOST_CHECK_EQUAL(eg.waypoints(e12).size(), 2);
+    BOOST_CHECK(eg.waypoints(e12)[0] == smpl::RobotState({ 0.5, 1.5 }));
+    BOOST_CHECK_EQUAL(eg.waypoint_count(e34), 0);
+}
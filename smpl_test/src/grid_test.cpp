@@ -0,0 +1,66 @@
+#include <set>
+
+#define BOOST_TEST_MODULE GridTest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <smpl/grid/grid.h>
+
+BOOST_AUTO_TEST_CASE(RowMajorLayoutTest)
+{
+    smpl::Grid3<int> g(3, 4, 5, 0);
+    BOOST_CHECK_EQUAL(g.size(), 3 * 4 * 5);
+    BOOST_CHECK_EQUAL(&g(1, 2, 3) - g.data(), (1 * 4 + 2) * 5 + 3);
+}
+
+BOOST_AUTO_TEST_CASE(MortonLayoutPadsToBricksTest)
+{
+    smpl::Grid3<int, smpl::MortonLayout<2>> g(5, 4, 9, 7);
+    BOOST_CHECK_EQUAL(g.xsize(), 5);
+    BOOST_CHECK_EQUAL(g.size(), 2 * 1 * 3 * 64);
+    BOOST_CHECK_EQUAL(g(4, 3, 8), 7);
+
+    // the first brick holds the cells with coordinates in [0, 4)
+    BOOST_CHECK_EQUAL(&g(0, 0, 1) - g.data(), 1);
+    BOOST_CHECK_EQUAL(&g(0, 1, 0) - g.data(), 2);
+    BOOST_CHECK_EQUAL(&g(1, 0, 0) - g.data(), 4);
+    BOOST_CHECK_EQUAL(&g(3, 3, 3) - g.data(), 63);
+    BOOST_CHECK_EQUAL(&g(0, 0, 4) - g.data(), 64);
+}
+
+BOOST_AUTO_TEST_CASE(MortonLayoutRoundTripTest)
+{
+    smpl::Grid3<int, smpl::MortonLayout<2>> g(6, 7, 9);
+
+    std::set<std::size_t> indices;
+    for (std::size_t x = 0; x < g.xsize(); ++x) {
+    for (std::size_t y = 0; y < g.ysize(); ++y) {
+    for (std::size_t z = 0; z < g.zsize(); ++z) {
+        const std::size_t i = g.coord_to_index(x, y, z);
+        BOOST_CHECK_LT(i, g.size());
+        BOOST_CHECK(indices.insert(i).second);
+
+        std::size_t cx, cy, cz;
+        g.index_to_coord(i, cx, cy, cz);
+        BOOST_CHECK_EQUAL(cx, x);
+        BOOST_CHECK_EQUAL(cy, y);
+        BOOST_CHECK_EQUAL(cz, z);
+    }
+    }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(MortonLayoutCopyAndSwapTest)
+{
+    smpl::Grid3<int, smpl::MortonLayout<1>> g(3, 3, 3, 0);
+    g(2, 1, 0) = 5;
+
+    smpl::Grid3<int, smpl::MortonLayout<1>> c(g);
+    BOOST_CHECK_EQUAL(c(2, 1, 0), 5);
+
+    smpl::Grid3<int, smpl::MortonLayout<1>> s;
+    swap(s, c);
+    BOOST_CHECK_EQUAL(s(2, 1, 0), 5);
+    BOOST_CHECK_EQUAL(s.xsize(), 3);
+    BOOST_CHECK_EQUAL(c.size(), 0);
+}
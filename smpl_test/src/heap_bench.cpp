@@ -0,0 +1,466 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+
+// Replay traces of priority queue operations and state table lookups against
+// the data structures available to the searches and graphs, to compare them
+// on realistic workloads.
+//
+// Usage:
+//     heap_bench
+//         Run a weighted A* search on a random 3D grid, recording its OPEN
+//         list operations and the coordinates of the successors it generates,
+//         and replay both traces.
+//     heap_bench synth <heap_trace> <coord_trace>
+//         Record the traces of the same search to files.
+//     heap_bench heap <heap_trace>
+//     heap_bench coords <coord_trace>
+//         Replay traces read from files.
+//
+// A heap trace is a sequence of lines "push <id> <key>", "decrease <id> <key>",
+// and "pop". A coordinate trace is the coordinate width on the first line,
+// followed by one coordinate per line.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <smpl/graph/coord_table.h>
+#include <smpl/heap/bucket_heap.h>
+#include <smpl/heap/dary_heap.h>
+#include <smpl/heap/intrusive_heap.h>
+
+struct HeapOp
+{
+    enum Type { Push, Decrease, Pop } type;
+    int id;
+    int key;
+};
+
+struct CoordTrace
+{
+    int width = 0;
+    std::vector<int> coords; // width integers per lookup
+
+    std::size_t size() const { return width > 0 ? coords.size() / width : 0; }
+};
+
+/////////////////////
+// Trace Recording //
+/////////////////////
+
+// Weighted A* over a 26-connected grid with random obstacles and integer edge
+// costs, mirroring the OPEN list usage of ARA* during its first iteration.
+static void RecordSearchTraces(
+    int size,
+    double obstacle_density,
+    int weight,
+    std::vector<HeapOp>& heap_trace,
+    CoordTrace& coord_trace)
+{
+    std::mt19937 rng(0);
+    std::bernoulli_distribution obstacle(obstacle_density);
+
+    auto index = [size](int x, int y, int z) { return (z * size + y) * size + x; };
+    std::vector<bool> blocked(size * size * size);
+    for (size_t i = 0; i < blocked.size(); ++i) {
+        blocked[i] = obstacle(rng);
+    }
+
+    const int sx = 1, sy = 1, sz = 1;
+    const int gx = size - 2, gy = size - 2, gz = size - 2;
+    blocked[index(sx, sy, sz)] = false;
+    blocked[index(gx, gy, gz)] = false;
+
+    auto h = [&](int x, int y, int z) {
+        const double dx = x - gx, dy = y - gy, dz = z - gz;
+        return (int)(1000.0 * std::sqrt(dx * dx + dy * dy + dz * dz));
+    };
+
+    struct Node : smpl::heap_element
+    {
+        int f;
+        int g = std::numeric_limits<int>::max();
+        int x, y, z;
+        bool closed = false;
+    };
+    struct NodeKey
+    {
+        int operator()(const Node& n) const { return n.f; }
+    };
+
+    // the search's own coordinate lookup, separate from the structures under
+    // test
+    std::unordered_map<int, int> ids;
+    // reserved up front so that pointers held by the heap remain valid
+    std::vector<Node> nodes;
+    nodes.reserve(blocked.size());
+    smpl::dary_heap<Node, NodeKey> open;
+
+    auto get_node = [&](int x, int y, int z) {
+        const int c[3] = { x, y, z };
+        coord_trace.coords.insert(coord_trace.coords.end(), c, c + 3);
+        auto it = ids.find(index(x, y, z));
+        if (it != ids.end()) {
+            return it->second;
+        }
+        const int id = (int)nodes.size();
+        nodes.emplace_back();
+        nodes.back().x = x;
+        nodes.back().y = y;
+        nodes.back().z = z;
+        ids[index(x, y, z)] = id;
+        return id;
+    };
+
+    coord_trace.width = 3;
+
+    const int start = get_node(sx, sy, sz);
+    nodes[start].g = 0;
+    nodes[start].f = weight * h(sx, sy, sz);
+    open.push(&nodes[start]);
+    heap_trace.push_back({ HeapOp::Push, start, nodes[start].f });
+
+    while (!open.empty()) {
+        Node* n = open.min();
+        open.pop();
+        heap_trace.push_back({ HeapOp::Pop, -1, 0 });
+        n->closed = true;
+        if (n->x == gx && n->y == gy && n->z == gz) {
+            break;
+        }
+
+        for (int dz = -1; dz <= 1; ++dz) {
+        for (int dy = -1; dy <= 1; ++dy) {
+        for (int dx = -1; dx <= 1; ++dx) {
+            if (dx == 0 && dy == 0 && dz == 0) {
+                continue;
+            }
+            const int x = n->x + dx, y = n->y + dy, z = n->z + dz;
+            if (x < 0 || y < 0 || z < 0 || x >= size || y >= size || z >= size ||
+                blocked[index(x, y, z)])
+            {
+                continue;
+            }
+
+            const int cost = (int)(1000.0 * std::sqrt((double)(dx * dx + dy * dy + dz * dz)));
+            const int n_g = n->g;
+            const int sid = get_node(x, y, z);
+            Node* s = &nodes[sid];
+            if (s->closed || n_g + cost >= s->g) {
+                continue;
+            }
+            s->g = n_g + cost;
+            s->f = s->g + weight * h(x, y, z);
+            if (open.contains(s)) {
+                open.decrease(s);
+                heap_trace.push_back({ HeapOp::Decrease, sid, s->f });
+            } else {
+                open.push(s);
+                heap_trace.push_back({ HeapOp::Push, sid, s->f });
+            }
+        }
+        }
+        }
+    }
+}
+
+static bool WriteHeapTrace(const char* path, const std::vector<HeapOp>& trace)
+{
+    std::ofstream ofs(path);
+    if (!ofs.is_open()) {
+        return false;
+    }
+    for (auto& op : trace) {
+        switch (op.type) {
+        case HeapOp::Push:      ofs << "push " << op.id << ' ' << op.key << '\n'; break;
+        case HeapOp::Decrease:  ofs << "decrease " << op.id << ' ' << op.key << '\n'; break;
+        case HeapOp::Pop:       ofs << "pop\n"; break;
+        }
+    }
+    return true;
+}
+
+static bool ReadHeapTrace(const char* path, std::vector<HeapOp>& trace)
+{
+    std::ifstream ifs(path);
+    if (!ifs.is_open()) {
+        return false;
+    }
+    std::string type;
+    while (ifs >> type) {
+        HeapOp op;
+        if (type == "push" || type == "decrease") {
+            op.type = type == "push" ? HeapOp::Push : HeapOp::Decrease;
+            if (!(ifs >> op.id >> op.key)) {
+                return false;
+            }
+        } else if (type == "pop") {
+            op.type = HeapOp::Pop;
+            op.id = -1;
+            op.key = 0;
+        } else {
+            return false;
+        }
+        trace.push_back(op);
+    }
+    return true;
+}
+
+static bool WriteCoordTrace(const char* path, const CoordTrace& trace)
+{
+    std::ofstream ofs(path);
+    if (!ofs.is_open()) {
+        return false;
+    }
+    ofs << trace.width << '\n';
+    for (size_t i = 0; i < trace.size(); ++i) {
+        for (int j = 0; j < trace.width; ++j) {
+            ofs << trace.coords[i * trace.width + j] << (j + 1 < trace.width ? ' ' : '\n');
+        }
+    }
+    return true;
+}
+
+static bool ReadCoordTrace(const char* path, CoordTrace& trace)
+{
+    std::ifstream ifs(path);
+    if (!ifs.is_open() || !(ifs >> trace.width) || trace.width <= 0) {
+        return false;
+    }
+    int c;
+    while (ifs >> c) {
+        trace.coords.push_back(c);
+    }
+    return trace.coords.size() % trace.width == 0;
+}
+
+////////////
+// Replay //
+////////////
+
+struct BenchElement : smpl::heap_element
+{
+    int key;
+};
+
+struct BenchElementKey
+{
+    int operator()(const BenchElement& e) const { return e.key; }
+};
+
+struct BenchElementCompare
+{
+    bool operator()(const BenchElement& a, const BenchElement& b) const {
+        return a.key < b.key;
+    }
+};
+
+// Median time of several replays, in seconds
+static double MedianTime(int repetitions, const std::function<void()>& run)
+{
+    std::vector<double> times;
+    for (int i = 0; i < repetitions; ++i) {
+        auto then = std::chrono::steady_clock::now();
+        run();
+        auto now = std::chrono::steady_clock::now();
+        times.push_back(std::chrono::duration<double>(now - then).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+// Replay a heap trace. Elements with equal keys may leave different heaps in
+// different orders, so decreases of elements that this heap has already
+// popped are skipped.
+template <class Heap>
+static void ReplayHeapTrace(
+    const char* name,
+    const std::vector<HeapOp>& trace,
+    int repetitions)
+{
+    int max_id = -1;
+    for (auto& op : trace) {
+        max_id = std::max(max_id, op.id);
+    }
+
+    std::vector<BenchElement> elements(max_id + 1);
+    std::uint64_t checksum = 0;
+    auto secs = MedianTime(repetitions, [&]()
+    {
+        Heap heap;
+        checksum = 0;
+        for (auto& op : trace) {
+            switch (op.type) {
+            case HeapOp::Push:
+                elements[op.id].key = op.key;
+                heap.push(&elements[op.id]);
+                break;
+            case HeapOp::Decrease:
+                if (heap.contains(&elements[op.id])) {
+                    elements[op.id].key = op.key;
+                    heap.decrease(&elements[op.id]);
+                }
+                break;
+            case HeapOp::Pop:
+                if (!heap.empty()) {
+                    checksum += heap.min()->key;
+                    heap.pop();
+                }
+                break;
+            }
+        }
+        heap.clear();
+    });
+
+    printf("%-28s %10zu ops %10.3f ms %8.2f ns/op (key sum %llu)\n",
+            name, trace.size(), 1e3 * secs, 1e9 * secs / trace.size(),
+            (unsigned long long)checksum);
+}
+
+static void ReplayHeapTraces(const std::vector<HeapOp>& trace)
+{
+    const int repetitions = 5;
+    ReplayHeapTrace<smpl::intrusive_heap<BenchElement, BenchElementCompare>>(
+            "intrusive_heap", trace, repetitions);
+    ReplayHeapTrace<smpl::dary_heap<BenchElement, BenchElementKey, 2>>(
+            "dary_heap<2>", trace, repetitions);
+    ReplayHeapTrace<smpl::dary_heap<BenchElement, BenchElementKey, 4>>(
+            "dary_heap<4>", trace, repetitions);
+    ReplayHeapTrace<smpl::dary_heap<BenchElement, BenchElementKey, 8>>(
+            "dary_heap<8>", trace, repetitions);
+    ReplayHeapTrace<smpl::bucket_heap<BenchElement, BenchElementKey>>(
+            "bucket_heap", trace, repetitions);
+}
+
+struct CoordHash
+{
+    std::size_t operator()(const std::vector<int>& coord) const
+    {
+        std::size_t seed = 0;
+        for (int c : coord) {
+            seed ^= std::hash<int>()(c) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        }
+        return seed;
+    }
+};
+
+// Replay a coordinate trace as a sequence of find-or-insert operations, as a
+// graph does when generating successors
+static void ReplayCoordTraces(const CoordTrace& trace)
+{
+    const int repetitions = 5;
+    const size_t n = trace.size();
+
+    int table_size = 0;
+    auto secs = MedianTime(repetitions, [&]()
+    {
+        smpl::CoordTable table(trace.width);
+        for (size_t i = 0; i < n; ++i) {
+            auto* coord = &trace.coords[i * trace.width];
+            if (table.find(coord) < 0) {
+                table.insert(coord);
+            }
+        }
+        table_size = table.size();
+    });
+    printf("%-28s %10zu ops %10.3f ms %8.2f ns/op (%d entries)\n",
+            "CoordTable", n, 1e3 * secs, 1e9 * secs / n, table_size);
+
+    secs = MedianTime(repetitions, [&]()
+    {
+        std::unordered_map<std::vector<int>, int, CoordHash> table;
+        std::vector<int> key(trace.width);
+        for (size_t i = 0; i < n; ++i) {
+            auto* coord = &trace.coords[i * trace.width];
+            std::copy(coord, coord + trace.width, key.begin());
+            auto it = table.find(key);
+            if (it == table.end()) {
+                table.emplace(key, (int)table.size());
+            }
+        }
+        table_size = (int)table.size();
+    });
+    printf("%-28s %10zu ops %10.3f ms %8.2f ns/op (%d entries)\n",
+            "unordered_map<vector<int>>", n, 1e3 * secs, 1e9 * secs / n, table_size);
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc == 1 || (argc == 4 && strcmp(argv[1], "synth") == 0)) {
+        std::vector<HeapOp> heap_trace;
+        CoordTrace coord_trace;
+        RecordSearchTraces(64, 0.3, 1, heap_trace, coord_trace);
+        if (argc == 4) {
+            if (!WriteHeapTrace(argv[2], heap_trace) ||
+                !WriteCoordTrace(argv[3], coord_trace))
+            {
+                fprintf(stderr, "Failed to write traces\n");
+                return 1;
+            }
+            return 0;
+        }
+        ReplayHeapTraces(heap_trace);
+        ReplayCoordTraces(coord_trace);
+        return 0;
+    }
+
+    if (argc == 3 && strcmp(argv[1], "heap") == 0) {
+        std::vector<HeapOp> trace;
+        if (!ReadHeapTrace(argv[2], trace)) {
+            fprintf(stderr, "Failed to read heap trace from %s\n", argv[2]);
+            return 1;
+        }
+        ReplayHeapTraces(trace);
+        return 0;
+    }
+
+    if (argc == 3 && strcmp(argv[1], "coords") == 0) {
+        CoordTrace trace;
+        if (!ReadCoordTrace(argv[2], trace)) {
+            fprintf(stderr, "Failed to read coordinate trace from %s\n", argv[2]);
+            return 1;
+        }
+        ReplayCoordTraces(trace);
+        return 0;
+    }
+
+    fprintf(stderr, "Usage: heap_bench [synth <heap_trace> <coord_trace> | heap <heap_trace> | coords <coord_trace>]\n");
+    return 1;
+}
@@ -0,0 +1,166 @@
+#include <memory>
+#include <vector>
+
+#define BOOST_TEST_MODULE IKSamplerTest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <smpl/collision_checker.h>
+#include <smpl/ik_sampler.h>
+
+// A two joint robot whose IK has one solution per sign of the first joint of
+// the seed: { sign(seed[0]), 0.5 }
+class TestRobotModel :
+    public virtual smpl::InverseKinematicsInterface,
+    public virtual smpl::RobotModelCloneExtension
+{
+public:
+
+    TestRobotModel() { setPlanningJoints({ "j1", "j2" }); }
+
+    double minPosLimit(int jidx) const override { return -2.0; }
+    double maxPosLimit(int jidx) const override { return 2.0; }
+    bool hasPosLimit(int jidx) const override { return true; }
+    bool isContinuous(int jidx) const override { return false; }
+    double velLimit(int jidx) const override { return 0.0; }
+    double accLimit(int jidx) const override { return 0.0; }
+
+    bool checkJointLimits(const smpl::RobotState& state, bool verbose) override
+    {
+        for (auto v : state) {
+            if (v < -2.0 || v > 2.0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool computeIK(
+        const smpl::Affine3& pose,
+        const smpl::RobotState& start,
+        smpl::RobotState& solution,
+        smpl::ik_option::IkOption option) override
+    {
+        solution = { start[0] < 0.0 ? -1.0 : 1.0, 0.5 };
+        return true;
+    }
+
+    bool computeIK(
+        const smpl::Affine3& pose,
+        const smpl::RobotState& start,
+        std::vector<smpl::RobotState>& solutions,
+        smpl::ik_option::IkOption option) override
+    {
+        smpl::RobotState solution;
+        computeIK(pose, start, solution, option);
+        solutions.push_back(solution);
+        return true;
+    }
+
+    auto clone() -> std::unique_ptr<smpl::RobotModel> override
+    {
+        return std::unique_ptr<smpl::RobotModel>(new TestRobotModel);
+    }
+
+    auto getExtension(size_t class_code) -> smpl::Extension* override
+    {
+        if (class_code == smpl::GetClassCode<smpl::RobotModel>() ||
+            class_code == smpl::GetClassCode<smpl::InverseKinematicsInterface>() ||
+            class_code == smpl::GetClassCode<smpl::RobotModelCloneExtension>())
+        {
+            return this;
+        }
+        return nullptr;
+    }
+};
+
+// Reports every state with a negative first joint as in collision
+class TestCollisionChecker :
+    public virtual smpl::CollisionChecker,
+    public virtual smpl::CollisionCheckerCloneExtension
+{
+public:
+
+    bool isStateValid(const smpl::RobotState& state, bool verbose) override
+    {
+        return state[0] >= 0.0;
+    }
+
+    bool isStateToStateValid(
+        const smpl::RobotState& start,
+        const smpl::RobotState& finish,
+        bool verbose) override
+    {
+        return isStateValid(start, verbose) && isStateValid(finish, verbose);
+    }
+
+    bool interpolatePath(
+        const smpl::RobotState& start,
+        const smpl::RobotState& finish,
+        std::vector<smpl::RobotState>& path) override
+    {
+        path = { start, finish };
+        return true;
+    }
+
+    auto clone() -> std::unique_ptr<smpl::CollisionChecker> override
+    {
+        return std::unique_ptr<smpl::CollisionChecker>(new TestCollisionChecker);
+    }
+
+    auto getExtension(size_t class_code) -> smpl::Extension* override
+    {
+        if (class_code == smpl::GetClassCode<smpl::CollisionChecker>() ||
+            class_code == smpl::GetClassCode<smpl::CollisionCheckerCloneExtension>())
+        {
+            return this;
+        }
+        return nullptr;
+    }
+};
+
+BOOST_AUTO_TEST_CASE(SingleSeedTest)
+{
+    TestRobotModel robot;
+    TestCollisionChecker checker;
+
+    smpl::IKSampler sampler;
+    BOOST_REQUIRE(sampler.init(&robot, &checker));
+
+    smpl::RobotState solution;
+    BOOST_CHECK(sampler.solve(smpl::Affine3::Identity(), { 0.3, 0.0 }, solution));
+    BOOST_CHECK_EQUAL(solution[0], 1.0);
+
+    // the only seed leads to a solution in collision
+    BOOST_CHECK(!sampler.solve(smpl::Affine3::Identity(), { -0.3, 0.0 }, solution));
+}
+
+BOOST_AUTO_TEST_CASE(MultiStartTest)
+{
+    TestRobotModel robot;
+    TestCollisionChecker checker;
+
+    for (int threads = 1; threads <= 4; ++threads) {
+        smpl::IKSampler sampler;
+        BOOST_REQUIRE(sampler.init(&robot, &checker, threads));
+        BOOST_CHECK_EQUAL(sampler.threadCount(), threads);
+        sampler.setSeedCount(16);
+
+        smpl::RobotState solution;
+        BOOST_CHECK(sampler.solve(smpl::Affine3::Identity(), { -0.3, 0.0 }, solution));
+        BOOST_CHECK_EQUAL(solution[0], 1.0);
+        BOOST_CHECK_EQUAL(solution[1], 0.5);
+
+        // duplicate solutions are reported once
+        std::vector<smpl::RobotState> solutions;
+        BOOST_CHECK(sampler.solve(smpl::Affine3::Identity(), { -0.3, 0.0 }, 4, solutions));
+        BOOST_CHECK_EQUAL(solutions.size(), 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(UninitializedTest)
+{
+    smpl::IKSampler sampler;
+    smpl::RobotState solution;
+    BOOST_CHECK(!sampler.solve(smpl::Affine3::Identity(), { 0.0, 0.0 }, solution));
+}
@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE KDTreeTest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <smpl/geometry/kd_tree.h>
+
+static std::vector<double> RandomPoints(std::size_t count, std::size_t dim)
+{
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    std::vector<double> points(count * dim);
+    for (auto& p : points) {
+        p = dist(gen);
+    }
+    return points;
+}
+
+static double SquaredDistance(
+    const double* a,
+    const double* b,
+    std::size_t dim)
+{
+    double d2 = 0.0;
+    for (std::size_t d = 0; d < dim; ++d) {
+        d2 += (a[d] - b[d]) * (a[d] - b[d]);
+    }
+    return d2;
+}
+
+BOOST_AUTO_TEST_CASE(NearestMatchesBruteForce)
+{
+    const std::size_t dim = 7;
+    const std::size_t count = 1000;
+    auto points = RandomPoints(count, dim);
+    auto queries = RandomPoints(50, dim);
+
+    smpl::geometry::KDTree tree;
+    tree.build(points.data(), count, dim);
+    BOOST_CHECK_EQUAL(tree.size(), count);
+
+    std::vector<std::size_t> indices;
+    for (std::size_t q = 0; q < 50; ++q) {
+        auto* query = &queries[q * dim];
+
+        std::vector<std::pair<double, std::size_t>> expected;
+        for (std::size_t i = 0; i < count; ++i) {
+            expected.emplace_back(SquaredDistance(query, &points[i * dim], dim), i);
+        }
+        std::sort(expected.begin(), expected.end());
+
+        tree.nearest(query, 5, indices);
+        BOOST_REQUIRE_EQUAL(indices.size(), 5);
+        for (std::size_t i = 0; i < 5; ++i) {
+            BOOST_CHECK_EQUAL(indices[i], expected[i].second);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(RadiusMatchesBruteForce)
+{
+    const std::size_t dim = 3;
+    const std::size_t count = 1000;
+    auto points = RandomPoints(count, dim);
+    auto queries = RandomPoints(50, dim);
+
+    smpl::geometry::KDTree tree;
+    tree.build(points.data(), count, dim);
+
+    std::vector<std::size_t> indices;
+    for (std::size_t q = 0; q < 50; ++q) {
+        auto* query = &queries[q * dim];
+
+        std::vector<std::size_t> expected;
+        for (std::size_t i = 0; i < count; ++i) {
+            if (SquaredDistance(query, &points[i * dim], dim) <= 0.25 * 0.25) {
+                expected.push_back(i);
+            }
+        }
+
+        tree.radius(query, 0.25, indices);
+        std::sort(indices.begin(), indices.end());
+        BOOST_CHECK(indices == expected);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(NearestWithFewPoints)
+{
+    std::vector<double> points = { 0.0, 1.0, 2.0 };
+
+    smpl::geometry::KDTree tree;
+    tree.build(points.data(), 3, 1);
+
+    double query = 1.9;
+    std::vector<std::size_t> indices;
+    tree.nearest(&query, 10, indices);
+    BOOST_REQUIRE_EQUAL(indices.size(), 3);
+    BOOST_CHECK_EQUAL(indices[0], 2);
+    BOOST_CHECK_EQUAL(indices[1], 1);
+    BOOST_CHECK_EQUAL(indices[2], 0);
+
+    tree.clear();
+    tree.nearest(&query, 1, indices);
+    BOOST_CHECK(indices.empty());
+}
@@ -0,0 +1,60 @@
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#define BOOST_TEST_MODULE LargeAllocTest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <smpl/large_alloc.h>
+#include <smpl/grid/grid.h>
+#include <smpl/grid/sparse_grid.h>
+
+BOOST_AUTO_TEST_CASE(SmallAndLargeAllocationsTest)
+{
+    for (std::size_t size : { std::size_t(100), smpl::LargeAllocThreshold + 1 }) {
+        auto* p = static_cast<char*>(smpl::AllocateLarge(size));
+        BOOST_REQUIRE(p != nullptr);
+        std::memset(p, 7, size);
+        BOOST_CHECK_EQUAL(p[size - 1], 7);
+        smpl::DeallocateLarge(p, size);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(HugePageAllocationTest)
+{
+    smpl::LargeAllocOptions options;
+    options.huge_pages = smpl::HugePageMode::Explicit;
+    options.numa_node = smpl::LargeAllocOptions::LocalNode;
+
+    const std::size_t size = 3 * smpl::LargeAllocThreshold;
+    auto* p = static_cast<char*>(smpl::AllocateLarge(size, options));
+    BOOST_REQUIRE(p != nullptr);
+    BOOST_CHECK_EQUAL((std::uintptr_t)p % alignof(std::max_align_t), 0);
+    std::memset(p, 1, size);
+    smpl::DeallocateLarge(p, size);
+}
+
+BOOST_AUTO_TEST_CASE(DefaultOptionsTest)
+{
+    smpl::LargeAllocOptions options;
+    options.huge_pages = smpl::HugePageMode::Transparent;
+    smpl::SetLargeAllocOptions(options);
+    BOOST_CHECK(smpl::GetLargeAllocOptions().huge_pages == smpl::HugePageMode::Transparent);
+
+    smpl::Grid3<int> g(128, 128, 64, 3);
+    BOOST_CHECK_EQUAL(g(127, 127, 63), 3);
+
+    smpl::SetLargeAllocOptions(smpl::LargeAllocOptions());
+}
+
+BOOST_AUTO_TEST_CASE(ContainerAllocatorTest)
+{
+    std::vector<double, smpl::LargeAllocator<double>> v(1 << 18, 1.0);
+    BOOST_CHECK_EQUAL(v.back(), 1.0);
+
+    smpl::SparseGrid<int, smpl::LargeAllocator<int>> g(16, 16, 16, 0);
+    g.set(3, 4, 5, 8);
+    BOOST_CHECK_EQUAL(g.get(3, 4, 5), 8);
+    BOOST_CHECK_EQUAL(g.get(3, 4, 6), 0);
+}
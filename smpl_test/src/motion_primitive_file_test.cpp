@@ -0,0 +1,96 @@
+// standard includes
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#define BOOST_TEST_MODULE MotionPrimitiveFileTest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+// system includes
+#include <unistd.h>
+#include <smpl/graph/motion_primitive_file.h>
+
+static auto MakePrimitives() -> std::vector<smpl::MotionPrimitive>
+{
+    std::vector<smpl::MotionPrimitive> prims(4);
+    prims[0].type = smpl::MotionPrimitive::SNAP_TO_RPY;
+    prims[1].type = smpl::MotionPrimitive::LONG_DISTANCE;
+    prims[1].action = { { 0.3, -0.4 } };
+    prims[2].type = smpl::MotionPrimitive::SHORT_DISTANCE;
+    prims[2].action = { { 0.1, 0.0 }, { 0.1, -0.2 } };
+    prims[3].type = smpl::MotionPrimitive::LONG_DISTANCE;
+    prims[3].action = { { -0.3, 0.4 } };
+    return prims;
+}
+
+BOOST_AUTO_TEST_CASE(MetricsTest)
+{
+    auto prims = MakePrimitives();
+    BOOST_CHECK_CLOSE(smpl::MotionPrimitiveCost(prims[1].action), 0.5, 1e-9);
+    BOOST_CHECK_CLOSE(smpl::MotionPrimitiveCost(prims[2].action), 0.3, 1e-9);
+    BOOST_CHECK_CLOSE(smpl::MotionPrimitiveMaxDisplacement(prims[1].action), 0.4, 1e-9);
+    BOOST_CHECK_CLOSE(smpl::MotionPrimitiveMaxDisplacement(prims[2].action), 0.2, 1e-9);
+    BOOST_CHECK_EQUAL(smpl::MotionPrimitiveCost(prims[0].action), 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(BinaryFileRoundTripTest)
+{
+    auto prims = MakePrimitives();
+    auto path = std::string("mprim_test.mprimb");
+    BOOST_REQUIRE(smpl::WriteMotionPrimitiveFile(path, prims, { 0.1, 0.2 }));
+    BOOST_CHECK(smpl::IsMotionPrimitiveFile(path));
+
+    smpl::MotionPrimitiveFile file;
+    BOOST_REQUIRE(file.open(path));
+    BOOST_CHECK_EQUAL(file.dof(), 2);
+    BOOST_CHECK_EQUAL(file.resolutions()[1], 0.2);
+
+    // adaptive motions are not stored
+    BOOST_REQUIRE_EQUAL(file.num_primitives(), 3);
+    BOOST_CHECK_EQUAL(file.record(0).type, smpl::MotionPrimitive::LONG_DISTANCE);
+    BOOST_CHECK_EQUAL(file.record(1).type, smpl::MotionPrimitive::SHORT_DISTANCE);
+    BOOST_CHECK_EQUAL(file.record(1).waypoint_count, 2);
+    BOOST_CHECK_EQUAL(file.deltas(1)[3], -0.2);
+    BOOST_CHECK_EQUAL(file.deltas(2)[0], -0.3);
+    BOOST_CHECK_CLOSE(file.record(1).cost, 0.3, 1e-9);
+    BOOST_CHECK_CLOSE(file.record(2).max_displacement, 0.4, 1e-9);
+
+    file.close();
+    std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(BinaryFileRejectsMalformedTest)
+{
+    auto prims = MakePrimitives();
+    auto path = std::string("mprim_test_truncated.mprimb");
+    BOOST_REQUIRE(smpl::WriteMotionPrimitiveFile(path, prims, { 0.1, 0.2 }));
+    BOOST_REQUIRE(truncate(path.c_str(), 64) == 0);
+
+    smpl::MotionPrimitiveFile file;
+    BOOST_CHECK(!file.open(path));
+    BOOST_CHECK(!file.isOpen());
+
+    // waypoints must match the number of resolutions
+    BOOST_CHECK(!smpl::WriteMotionPrimitiveFile(path, prims, { 0.1 }));
+
+    std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(SharedMemoryTest)
+{
+    auto prims = MakePrimitives();
+    auto name = std::string("/smpl_mprim_test");
+    BOOST_REQUIRE(smpl::PublishMotionPrimitives(name, prims, { 0.1, 0.2 }));
+
+    smpl::MotionPrimitiveFile file;
+    BOOST_REQUIRE(file.open(MOTION_PRIMITIVE_SHARED_PREFIX + name));
+    BOOST_CHECK_EQUAL(file.num_primitives(), 3);
+
+    smpl::MotionPrimitiveFile other;
+    BOOST_REQUIRE(other.openShared(name));
+    BOOST_CHECK_EQUAL(other.deltas(0)[1], -0.4);
+
+    BOOST_CHECK(smpl::UnpublishMotionPrimitives(name));
+    BOOST_CHECK(!file.openShared(name));
+}
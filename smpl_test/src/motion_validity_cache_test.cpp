@@ -0,0 +1,269 @@
+#include <thread>
+#include <vector>
+
+#define BOOST_TEST_MODULE MotionValidityCacheTest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <smpl/motion_validity_cache.h>
+#include <smpl/post_processing.h>
+
+// Rejects motions that end with the first variable negative, and counts the
+// checks that reach it
+class CountingCollisionChecker :
+    public smpl::CollisionChecker,
+    public smpl::CollisionCheckerCloneExtension
+{
+public:
+
+    int motion_checks = 0;
+    int state_checks = 0;
+
+    bool isStateValid(const smpl::RobotState& state, bool verbose) override
+    {
+        ++state_checks;
+        return state[0] >= 0.0;
+    }
+
+    bool isStateToStateValid(
+        const smpl::RobotState& start,
+        const smpl::RobotState& finish,
+        bool verbose) override
+    {
+        ++motion_checks;
+        return finish[0] >= 0.0;
+    }
+
+    bool interpolatePath(
+        const smpl::RobotState& start,
+        const smpl::RobotState& finish,
+        std::vector<smpl::RobotState>& path) override
+    {
+        path = { start, finish };
+        return true;
+    }
+
+    auto clone() -> std::unique_ptr<smpl::CollisionChecker> override
+    {
+        return std::unique_ptr<smpl::CollisionChecker>(
+                new CountingCollisionChecker);
+    }
+
+    auto getExtension(size_t class_code) -> smpl::Extension* override
+    {
+        if (class_code == smpl::GetClassCode<smpl::CollisionChecker>() ||
+            class_code == smpl::GetClassCode<smpl::CollisionCheckerCloneExtension>())
+        {
+            return this;
+        }
+        return nullptr;
+    }
+};
+
+// A checker whose world version, growth epoch, and growth are set directly,
+// and which certifies every motion with a fixed clearance
+class VersionedCollisionChecker :
+    public CountingCollisionChecker,
+    public smpl::CollisionWorldVersionExtension,
+    public smpl::CollisionClearanceExtension
+{
+public:
+
+    std::uint64_t version = 0;
+    std::uint64_t epoch = 0;
+    double growth = 0.0;
+    double clearance = 0.0;
+
+    auto worldVersion() const -> std::uint64_t override { return version; }
+
+    double motionClearance(
+        const smpl::RobotState& start,
+        const smpl::RobotState& finish) override
+    {
+        return clearance;
+    }
+
+    double worldGrowth() const override { return growth; }
+    auto growthEpoch() const -> std::uint64_t override { return epoch; }
+
+    auto getExtension(size_t class_code) -> smpl::Extension* override
+    {
+        if (class_code == smpl::GetClassCode<smpl::CollisionWorldVersionExtension>() ||
+            class_code == smpl::GetClassCode<smpl::CollisionClearanceExtension>())
+        {
+            return this;
+        }
+        return CountingCollisionChecker::getExtension(class_code);
+    }
+};
+
+BOOST_AUTO_TEST_CASE(LookupInsertTest)
+{
+    smpl::MotionValidityCache cache(1e-3);
+    bool valid = false;
+    BOOST_CHECK(!cache.lookup({ 0.0, 0.0 }, { 1.0, 1.0 }, valid));
+
+    cache.insert({ 0.0, 0.0 }, { 1.0, 1.0 }, true);
+    cache.insert({ 0.0, 0.0 }, { -1.0, 1.0 }, false);
+    BOOST_CHECK_EQUAL(cache.size(), 2);
+
+    BOOST_CHECK(cache.lookup({ 0.0, 0.0 }, { 1.0, 1.0 }, valid));
+    BOOST_CHECK(valid);
+    BOOST_CHECK(cache.lookup({ 0.0, 0.0 }, { -1.0, 1.0 }, valid));
+    BOOST_CHECK(!valid);
+
+    // states within the resolution share an entry
+    BOOST_CHECK(cache.lookup({ 0.0001, 0.0 }, { 1.0, 0.9999 }, valid));
+    BOOST_CHECK(valid);
+
+    // motions are directed
+    BOOST_CHECK(!cache.lookup({ 1.0, 1.0 }, { 0.0, 0.0 }, valid));
+    BOOST_CHECK_EQUAL(cache.hits(), 3);
+    BOOST_CHECK_EQUAL(cache.misses(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(InvalidateTest)
+{
+    smpl::MotionValidityCache cache;
+    cache.insert({ 0.0 }, { 1.0 }, true);
+
+    auto version = cache.worldVersion();
+    cache.invalidate();
+    BOOST_CHECK_NE(cache.worldVersion(), version);
+
+    bool valid;
+    BOOST_CHECK(!cache.lookup({ 0.0 }, { 1.0 }, valid));
+
+    cache.insert({ 0.0 }, { 1.0 }, false);
+    BOOST_CHECK(cache.lookup({ 0.0 }, { 1.0 }, valid));
+    BOOST_CHECK(!valid);
+
+    cache.clear();
+    BOOST_CHECK_EQUAL(cache.size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(CachedCheckerTest)
+{
+    CountingCollisionChecker checker;
+    smpl::MotionValidityCache cache;
+    smpl::CachedCollisionChecker cached(&checker, &cache);
+
+    BOOST_CHECK(cached.isStateToStateValid({ 0.0 }, { 1.0 }));
+    BOOST_CHECK(cached.isStateToStateValid({ 0.0 }, { 1.0 }));
+    BOOST_CHECK(!cached.isStateToStateValid({ 0.0 }, { -1.0 }));
+    BOOST_CHECK(!cached.isStateToStateValid({ 0.0 }, { -1.0 }));
+    BOOST_CHECK_EQUAL(checker.motion_checks, 2);
+
+    cache.invalidate();
+    BOOST_CHECK(cached.isStateToStateValid({ 0.0 }, { 1.0 }));
+    BOOST_CHECK_EQUAL(checker.motion_checks, 3);
+
+    smpl::CollisionChecker* base = &cached;
+    BOOST_CHECK(base->getExtension<smpl::CachedCollisionChecker>() == &cached);
+}
+
+BOOST_AUTO_TEST_CASE(ClonesShareCacheTest)
+{
+    CountingCollisionChecker checker;
+    smpl::MotionValidityCache cache;
+    smpl::CachedCollisionChecker cached(&checker, &cache);
+
+    smpl::CollisionChecker* base = &cached;
+    auto* cloner = base->getExtension<smpl::CollisionCheckerCloneExtension>();
+    BOOST_REQUIRE(cloner);
+
+    std::vector<std::unique_ptr<smpl::CollisionChecker>> clones;
+    for (int i = 0; i < 4; ++i) {
+        clones.push_back(cloner->clone());
+        BOOST_REQUIRE(clones.back());
+    }
+
+    std::vector<std::thread> threads;
+    for (auto& clone : clones) {
+        auto* c = clone.get();
+        threads.emplace_back([c]() {
+            for (int i = 0; i < 1000; ++i) {
+                c->isStateToStateValid({ 0.0 }, { (double)(i % 100) });
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    BOOST_CHECK_EQUAL(cache.size(), 100);
+    BOOST_CHECK_GE(cache.hits(), 4000 - 4 * 100);
+}
+
+BOOST_AUTO_TEST_CASE(InterpolatePathSkipsKnownMotionsTest)
+{
+    CountingCollisionChecker checker;
+    smpl::MotionValidityCache cache;
+    smpl::CachedCollisionChecker cached(&checker, &cache);
+
+    std::vector<smpl::RobotState> path = { { 0.0 }, { 1.0 }, { 2.0 } };
+    BOOST_CHECK(cached.isStateToStateValid(path[0], path[1]));
+
+    BOOST_CHECK(smpl::InterpolatePath(cached, path));
+    BOOST_CHECK_EQUAL(path.size(), 3);
+
+    // only the unknown motion from the second to the third state is checked
+    BOOST_CHECK_EQUAL(checker.state_checks, 2);
+}
+
+BOOST_AUTO_TEST_CASE(CertificateTest)
+{
+    smpl::MotionValidityCache cache;
+    cache.setWorld(1, 0, 0.0);
+    cache.insert({ 0.0 }, { 1.0 }, true, 0.5);
+    cache.insert({ 0.0 }, { 2.0 }, true);
+    cache.insert({ 0.0 }, { -1.0 }, false, 0.5);
+
+    // obstacles added within the clearance of a certified motion leave it
+    // valid; uncertified and invalid motions must be checked again
+    cache.setWorld(2, 0, 0.3);
+    bool valid = false;
+    BOOST_CHECK(cache.lookup({ 0.0 }, { 1.0 }, valid));
+    BOOST_CHECK(valid);
+    BOOST_CHECK(!cache.lookup({ 0.0 }, { 2.0 }, valid));
+    BOOST_CHECK(!cache.lookup({ 0.0 }, { -1.0 }, valid));
+
+    cache.setWorld(3, 0, 0.6);
+    BOOST_CHECK(!cache.lookup({ 0.0 }, { 1.0 }, valid));
+
+    cache.setWorld(2, 1, 0.3);
+    BOOST_CHECK(!cache.lookup({ 0.0 }, { 1.0 }, valid));
+
+    cache.setWorld(2, 0, 0.3);
+    cache.removeStale();
+    BOOST_CHECK_EQUAL(cache.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(CachedCheckerCertificateTest)
+{
+    VersionedCollisionChecker checker;
+    checker.clearance = 0.5;
+    smpl::MotionValidityCache cache;
+    smpl::CachedCollisionChecker cached(&checker, &cache);
+    cached.setCertifyMotions(true);
+
+    BOOST_CHECK(cached.isStateToStateValid({ 0.0 }, { 1.0 }));
+    BOOST_CHECK_EQUAL(checker.motion_checks, 1);
+
+    checker.version = 1;
+    checker.growth = 0.25;
+    BOOST_CHECK(cached.isStateToStateValid({ 0.0 }, { 1.0 }));
+    BOOST_CHECK_EQUAL(checker.motion_checks, 1);
+
+    checker.version = 2;
+    checker.growth = 0.75;
+    BOOST_CHECK(cached.isStateToStateValid({ 0.0 }, { 1.0 }));
+    BOOST_CHECK_EQUAL(checker.motion_checks, 2);
+
+    // without certification, any change to the world invalidates the entry
+    cached.setCertifyMotions(false);
+    BOOST_CHECK(cached.isStateToStateValid({ 0.0 }, { 2.0 }));
+    checker.version = 3;
+    BOOST_CHECK(cached.isStateToStateValid({ 0.0 }, { 2.0 }));
+    BOOST_CHECK_EQUAL(checker.motion_checks, 4);
+}
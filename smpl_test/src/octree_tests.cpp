@@ -7,6 +7,7 @@
 #include <boost/test/unit_test.hpp>
 
 #include <smpl/grid/sparse_grid.h>
+#include <smpl/octree/pool_allocator.h>
 
 struct TrackedInt
 {
@@ -266,3 +267,27 @@ BOOST_AUTO_TEST_CASE(SizeTest)
     BOOST_CHECK_EQUAL(
             sizeof(smpl::OcTree<int>), sizeof(smpl::detail::OcTreeNode<int>));
 }
+
+BOOST_AUTO_TEST_CASE(PoolAllocatorTest)
+{
+    using Alloc = smpl::OcTreePoolAllocator<int>;
+    smpl::OcTree<int, Alloc> tree(10);
+
+    tree.expand_node(tree.root());
+    auto* children = tree.root()->children;
+
+    // collapsed children are recycled by the next expansion
+    tree.collapse_node(tree.root(), 5);
+    tree.expand_node(tree.root());
+    BOOST_CHECK_EQUAL(tree.root()->children, children);
+    BOOST_CHECK_EQUAL(tree.root()->child(7)->value, 5);
+
+    // a moved-from tree may still be expanded
+    smpl::OcTree<int, Alloc> tree2(std::move(tree));
+    tree.expand_node(tree.root());
+    BOOST_CHECK_EQUAL(tree.num_nodes(), 9);
+    BOOST_CHECK_EQUAL(tree2.num_nodes(), 9);
+
+    smpl::OcTree<int, Alloc> tree3(tree2);
+    BOOST_CHECK_EQUAL(tree3.num_nodes(), 9);
+}
@@ -0,0 +1,169 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+/// \author Andrew Dornbush
+
+#include <limits>
+#include <map>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE PackedCoordTableTest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <smpl/graph/packed_coord_table.h>
+
+BOOST_AUTO_TEST_CASE(InsertFindTest)
+{
+    smpl::PackedCoordTable table;
+    table.setRanges({ 0, 0, -2 }, { 255, 1023, 1 });
+    BOOST_CHECK_EQUAL(table.width(), 3);
+    BOOST_CHECK_EQUAL(table.wordCount(), 1);
+    BOOST_CHECK_EQUAL(table.size(), 0);
+
+    int a[] = { 1, 2, -2 };
+    int b[] = { 255, 1023, 1 };
+    BOOST_CHECK_EQUAL(table.find(a), -1);
+
+    int aid = table.insert(a);
+    int bid = table.insert(b);
+    BOOST_CHECK_EQUAL(aid, 0);
+    BOOST_CHECK_EQUAL(bid, 1);
+    BOOST_CHECK_EQUAL(table.size(), 2);
+    BOOST_CHECK_EQUAL(table.find(a), aid);
+    BOOST_CHECK_EQUAL(table.find(b), bid);
+
+    int c[3];
+    table.get(aid, c);
+    BOOST_CHECK_EQUAL_COLLECTIONS(a, a + 3, c, c + 3);
+    table.get(bid, c);
+    BOOST_CHECK_EQUAL_COLLECTIONS(b, b + 3, c, c + 3);
+}
+
+BOOST_AUTO_TEST_CASE(ReserveTest)
+{
+    smpl::PackedCoordTable table;
+    table.setRanges({ 0, 0 }, { 15, 15 });
+
+    int id = table.reserve();
+    int c[2];
+    table.get(id, c);
+    BOOST_CHECK_EQUAL(c[0], 0);
+    BOOST_CHECK_EQUAL(c[1], 0);
+
+    // reserved coordinates are never found by lookup
+    int d[] = { 5, 0 };
+    table.set(id, d);
+    table.get(id, c);
+    BOOST_CHECK_EQUAL(c[0], 5);
+    BOOST_CHECK_EQUAL(table.find(d), -1);
+
+    int did = table.insert(d);
+    BOOST_CHECK_NE(did, id);
+    BOOST_CHECK_EQUAL(table.find(d), did);
+}
+
+BOOST_AUTO_TEST_CASE(WidenTest)
+{
+    smpl::PackedCoordTable table;
+    table.setRanges({ 0, 0 }, { 7, 7 });
+
+    int a[] = { 3, 4 };
+    int aid = table.insert(a);
+
+    // a value outside its column's range is never found, but may be inserted
+    int b[] = { -100, 4 };
+    BOOST_CHECK_EQUAL(table.find(b), -1);
+    int bid = table.insert(b);
+    BOOST_CHECK_EQUAL(table.find(a), aid);
+    BOOST_CHECK_EQUAL(table.find(b), bid);
+
+    int c[2];
+    table.get(aid, c);
+    BOOST_CHECK_EQUAL_COLLECTIONS(a, a + 2, c, c + 2);
+    table.get(bid, c);
+    BOOST_CHECK_EQUAL_COLLECTIONS(b, b + 2, c, c + 2);
+
+    // clearing restores the original ranges
+    table.clear();
+    BOOST_CHECK_EQUAL(table.find(a), -1);
+    BOOST_CHECK_EQUAL(table.insert(a), 0);
+    BOOST_CHECK_EQUAL(table.find(a), 0);
+}
+
+BOOST_AUTO_TEST_CASE(RandomTest)
+{
+    // columns spanning several words, with the last column unbounded
+    const int width = 7;
+    std::vector<int> min = { 0, 0, 0, 0, 0, 0, std::numeric_limits<int>::min() };
+    std::vector<int> max = { 8, 30000, 30000, 30000, 8, 8, std::numeric_limits<int>::max() };
+    smpl::PackedCoordTable table;
+    table.setRanges(min, max);
+    BOOST_CHECK_EQUAL(table.wordCount(), 2);
+
+    std::default_random_engine rng;
+    std::uniform_int_distribution<int> dist(-1, 8);
+
+    std::map<std::vector<int>, int> expected;
+    for (int i = 0; i < 20000; ++i) {
+        std::vector<int> coord(width);
+        for (auto& c : coord) {
+            c = dist(rng);
+        }
+        if (i < 10000) {
+            // stay in range for the first half, before any column widens
+            coord[0] = std::max(coord[0], 0);
+        }
+        auto it = expected.find(coord);
+        if (it == expected.end()) {
+            BOOST_REQUIRE_EQUAL(table.find(coord.data()), -1);
+            int id = i % 5 == 0 ? table.reserve() : table.insert(coord.data());
+            if (i % 5 != 0) {
+                expected[coord] = id;
+            }
+        } else {
+            BOOST_REQUIRE_EQUAL(table.find(coord.data()), it->second);
+        }
+    }
+
+    std::vector<int> coord(width);
+    for (auto& entry : expected) {
+        BOOST_REQUIRE_EQUAL(table.find(entry.first.data()), entry.second);
+        table.get(entry.second, coord.data());
+        BOOST_REQUIRE(coord == entry.first);
+    }
+
+    table.clear();
+    BOOST_CHECK_EQUAL(table.size(), 0);
+    for (auto& entry : expected) {
+        BOOST_REQUIRE_EQUAL(table.find(entry.first.data()), -1);
+    }
+}
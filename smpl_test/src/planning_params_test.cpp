@@ -0,0 +1,67 @@
+#include <string>
+
+#define BOOST_TEST_MODULE PlanningParamsTest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <smpl/planning_params.h>
+
+BOOST_AUTO_TEST_CASE(CompiledDefaultsTest)
+{
+    smpl::PlanningParams params;
+    auto& cp = params.compiled();
+    BOOST_CHECK_EQUAL(cp.epsilon, 1.0);
+    BOOST_CHECK_EQUAL(cp.bfs_threads, 1);
+    BOOST_CHECK_EQUAL(cp.open_list, "heap");
+    BOOST_CHECK(!cp.mprim_filename);
+    BOOST_CHECK(!cp.target_epsilon);
+}
+
+BOOST_AUTO_TEST_CASE(CompiledConversionTest)
+{
+    smpl::PlanningParams params;
+    params.addParam("epsilon", std::string("5.0"));
+    params.addParam("bfs_threads", 4.0);
+    params.addParam("search_mode", std::string("true"));
+    params.addParam("target_epsilon", 2);
+    params.addParam("mprim_filename", std::string("arm.mprim"));
+    params.addParam("not_compiled", 3);
+
+    auto& cp = params.compiled();
+    BOOST_CHECK_EQUAL(cp.epsilon, 5.0);
+    BOOST_CHECK_EQUAL(cp.bfs_threads, 4);
+    BOOST_CHECK(cp.search_mode);
+    BOOST_REQUIRE(cp.target_epsilon);
+    BOOST_CHECK_EQUAL(*cp.target_epsilon, 2.0);
+    BOOST_REQUIRE(cp.mprim_filename);
+    BOOST_CHECK_EQUAL(*cp.mprim_filename, "arm.mprim");
+
+    // compiled and by-name lookups agree
+    double epsilon;
+    BOOST_CHECK(params.getParam("epsilon", epsilon));
+    BOOST_CHECK_EQUAL(epsilon, cp.epsilon);
+    BOOST_CHECK(params.hasParam("not_compiled"));
+
+    // later values replace earlier ones
+    params.addParam("epsilon", 3.0);
+    BOOST_CHECK_EQUAL(cp.epsilon, 3.0);
+}
+
+BOOST_AUTO_TEST_CASE(CompiledValidationTest)
+{
+    smpl::PlanningParams params;
+    BOOST_CHECK_THROW(
+            params.addParam("bfs_threads", std::string("four")),
+            smpl::ParameterException);
+    BOOST_CHECK_THROW(
+            params.addParam("epsilon", std::string("")),
+            smpl::ParameterException);
+
+    // malformed values of uncompiled parameters are reported on lookup
+    BOOST_CHECK_NO_THROW(params.addParam("other", std::string("four")));
+
+    // copies keep the compiled parameters
+    params.addParam("epsilon", 2.5);
+    smpl::PlanningParams copy = params;
+    BOOST_CHECK_EQUAL(copy.compiled().epsilon, 2.5);
+}
@@ -0,0 +1,116 @@
+#include <cmath>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE PoseGoalSetTest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <smpl/angles.h>
+#include <smpl/graph/pose_goal_set.h>
+
+using Affine3Vector =
+        std::vector<smpl::Affine3, Eigen::aligned_allocator<smpl::Affine3>>;
+
+// The tolerance test used by ManipLattice before PoseGoalSet, clamping the dot
+// product so that identical orientations compare as equal
+static
+bool WithinTolerance(
+    const smpl::Affine3& A,
+    const smpl::Affine3& B,
+    const double xyz_tolerance[3],
+    const double rpy_tolerance[3])
+{
+    auto dx = std::fabs(A.translation()[0] - B.translation()[0]);
+    auto dy = std::fabs(A.translation()[1] - B.translation()[1]);
+    auto dz = std::fabs(A.translation()[2] - B.translation()[2]);
+    if (dx > xyz_tolerance[0] || dy > xyz_tolerance[1] || dz > xyz_tolerance[2]) {
+        return false;
+    }
+
+    smpl::Quaternion qa(A.rotation());
+    smpl::Quaternion qb(B.rotation());
+    auto dot = std::min(1.0, std::fabs(qa.dot(qb)));
+    return smpl::normalize_angle(2.0 * std::acos(dot)) < rpy_tolerance[0];
+}
+
+BOOST_AUTO_TEST_CASE(ExactGoalTest)
+{
+    smpl::Affine3 goal(
+            smpl::Translation3(0.5, -0.2, 1.0) *
+            smpl::AngleAxis(0.3, smpl::Vector3::UnitZ()));
+    double xyz_tol[3] = { 0.01, 0.01, 0.01 };
+    double rpy_tol[3] = { 0.05, 0.05, 0.05 };
+
+    smpl::PoseGoalSet goals;
+    goals.assign(&goal, 1, xyz_tol, rpy_tol);
+    BOOST_CHECK_EQUAL(goals.size(), 1);
+
+    BOOST_CHECK(goals.contains(goal));
+
+    smpl::Affine3 moved(smpl::Translation3(0.02, 0.0, 0.0) * goal);
+    BOOST_CHECK(!goals.contains(moved));
+
+    smpl::Affine3 turned(goal * smpl::AngleAxis(0.1, smpl::Vector3::UnitX()));
+    BOOST_CHECK(!goals.contains(turned));
+
+    // q and -q represent the same orientation
+    smpl::Quaternion q(goal.rotation());
+    smpl::Quaternion nq(-q.w(), -q.x(), -q.y(), -q.z());
+    smpl::Affine3 flipped(smpl::Translation3(goal.translation()) * nq);
+    BOOST_CHECK(goals.contains(flipped));
+
+    goals.clear();
+    BOOST_CHECK(goals.empty());
+    BOOST_CHECK(!goals.contains(goal));
+}
+
+BOOST_AUTO_TEST_CASE(MatchesBruteForceTest)
+{
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    auto random_pose = [&]() {
+        smpl::Quaternion q(u(rng), u(rng), u(rng), u(rng));
+        q.normalize();
+        return smpl::Affine3(
+                smpl::Translation3(u(rng), u(rng), u(rng)) * q);
+    };
+
+    for (int trial = 0; trial < 50; ++trial) {
+        Affine3Vector poses(1 + rng() % 300);
+        for (auto& pose : poses) {
+            pose = random_pose();
+        }
+        double xyz_tol[3] = {
+            0.3 * std::fabs(u(rng)),
+            0.3 * std::fabs(u(rng)),
+            0.3 * std::fabs(u(rng))
+        };
+        double rpy_tol[3] = { 2.0 * std::fabs(u(rng)), 0.0, 0.0 };
+
+        smpl::PoseGoalSet goals;
+        goals.assign(poses.data(), poses.size(), xyz_tol, rpy_tol);
+
+        for (int i = 0; i < 200; ++i) {
+            // half of the queries are perturbations of goal poses
+            auto pose = (i % 2 == 0)
+                    ? smpl::Affine3(
+                            smpl::Translation3(0.01 * u(rng), 0.01 * u(rng), 0.0) *
+                            poses[rng() % poses.size()] *
+                            smpl::AngleAxis(0.05 * u(rng), smpl::Vector3::UnitZ()))
+                    : random_pose();
+
+            auto expected = false;
+            for (auto& goal : poses) {
+                expected |= WithinTolerance(pose, goal, xyz_tol, rpy_tol);
+            }
+            BOOST_CHECK_EQUAL(goals.contains(pose), expected);
+
+            // the goal found is one the pose is within tolerance of
+            auto index = goals.find(pose);
+            if (index >= 0) {
+                BOOST_CHECK(WithinTolerance(pose, poses[index], xyz_tol, rpy_tol));
+            }
+        }
+    }
+}
@@ -0,0 +1,496 @@
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#define BOOST_TEST_MODULE PostProcessingTest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <smpl/collision_checker.h>
+#include <smpl/post_processing.h>
+#include <smpl/robot_model.h>
+
+// A point robot in the plane
+class PointRobotModel : public smpl::RobotModel
+{
+public:
+
+    PointRobotModel() { setPlanningJoints({ "x", "y" }); }
+
+    double minPosLimit(int jidx) const override { return -10.0; }
+    double maxPosLimit(int jidx) const override { return 10.0; }
+    bool hasPosLimit(int jidx) const override { return true; }
+    bool isContinuous(int jidx) const override { return false; }
+    double velLimit(int jidx) const override { return 1.0; }
+    double accLimit(int jidx) const override { return 1.0; }
+
+    bool checkJointLimits(const smpl::RobotState& state, bool verbose) override
+    {
+        return true;
+    }
+
+    auto getExtension(size_t class_code) -> smpl::Extension* override
+    {
+        if (class_code == smpl::GetClassCode<smpl::RobotModel>()) {
+            return this;
+        }
+        return nullptr;
+    }
+};
+
+// Rejects states inside the square [1, 3] x [1, 3]
+class BoxCollisionChecker :
+    public smpl::CollisionChecker,
+    public smpl::CollisionCheckerCloneExtension
+{
+public:
+
+    explicit BoxCollisionChecker(std::atomic<int>* checks) : m_checks(checks) { }
+
+    bool isStateValid(const smpl::RobotState& state, bool verbose) override
+    {
+        return !(state[0] > 1.0 && state[0] < 3.0 &&
+                state[1] > 1.0 && state[1] < 3.0);
+    }
+
+    bool isStateToStateValid(
+        const smpl::RobotState& start,
+        const smpl::RobotState& finish,
+        bool verbose) override
+    {
+        ++*m_checks;
+        std::vector<smpl::RobotState> path;
+        interpolatePath(start, finish, path);
+        for (auto& state : path) {
+            if (!isStateValid(state, verbose)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool interpolatePath(
+        const smpl::RobotState& start,
+        const smpl::RobotState& finish,
+        std::vector<smpl::RobotState>& path) override
+    {
+        const double res = 0.01;
+        auto dx = finish[0] - start[0];
+        auto dy = finish[1] - start[1];
+        auto steps = std::max(1, (int)std::ceil(std::hypot(dx, dy) / res));
+        path.clear();
+        for (int i = 0; i <= steps; ++i) {
+            auto alpha = (double)i / (double)steps;
+            path.push_back({ start[0] + alpha * dx, start[1] + alpha * dy });
+        }
+        return true;
+    }
+
+    auto clone() -> std::unique_ptr<smpl::CollisionChecker> override
+    {
+        return std::unique_ptr<smpl::CollisionChecker>(
+                new BoxCollisionChecker(m_checks));
+    }
+
+    auto getExtension(size_t class_code) -> smpl::Extension* override
+    {
+        if (class_code == smpl::GetClassCode<smpl::CollisionChecker>() ||
+            class_code == smpl::GetClassCode<smpl::CollisionCheckerCloneExtension>())
+        {
+            return this;
+        }
+        return nullptr;
+    }
+
+private:
+
+    std::atomic<int>* m_checks;
+};
+
+// Adds the obstacle cost of the box, measured from its signed distance
+class BoxDistanceChecker :
+    public BoxCollisionChecker,
+    public smpl::CollisionDistanceExtension
+{
+public:
+
+    explicit BoxDistanceChecker(std::atomic<int>* checks) :
+        BoxCollisionChecker(checks)
+    { }
+
+    static double signedDistance(double x, double y)
+    {
+        auto dx = std::max(std::fabs(x - 2.0) - 1.0, 0.0);
+        auto dy = std::max(std::fabs(y - 2.0) - 1.0, 0.0);
+        if (dx > 0.0 || dy > 0.0) {
+            return std::hypot(dx, dy);
+        }
+        return std::max(std::fabs(x - 2.0), std::fabs(y - 2.0)) - 1.0;
+    }
+
+    static double cost(double d, double clearance)
+    {
+        if (d < 0.0) {
+            return 0.5 * clearance - d;
+        }
+        if (d < clearance) {
+            return (clearance - d) * (clearance - d) / (2.0 * clearance);
+        }
+        return 0.0;
+    }
+
+    double distanceToCollision(const smpl::RobotState& state) override
+    {
+        return signedDistance(state[0], state[1]);
+    }
+
+    double distanceToCollision(
+        const smpl::RobotState& start,
+        const smpl::RobotState& finish) override
+    {
+        return std::min(distanceToCollision(start), distanceToCollision(finish));
+    }
+
+    bool collisionCostGradient(
+        const smpl::RobotState& state,
+        double clearance,
+        double& c,
+        std::vector<double>& gradient) override
+    {
+        const double h = 1e-6;
+        auto x = state[0], y = state[1];
+        c = cost(signedDistance(x, y), clearance);
+        gradient = {
+            (cost(signedDistance(x + h, y), clearance) - cost(signedDistance(x - h, y), clearance)) / (2.0 * h),
+            (cost(signedDistance(x, y + h), clearance) - cost(signedDistance(x, y - h), clearance)) / (2.0 * h),
+        };
+        return true;
+    }
+
+    auto getExtension(size_t class_code) -> smpl::Extension* override
+    {
+        if (class_code == smpl::GetClassCode<smpl::CollisionDistanceExtension>()) {
+            return this;
+        }
+        return BoxCollisionChecker::getExtension(class_code);
+    }
+};
+
+// A detour below and around the box from (0, 0) to (4, 4)
+static std::vector<smpl::RobotState> MakeDetourPath()
+{
+    std::vector<smpl::RobotState> path;
+    for (int i = 0; i < 10; ++i) {
+        path.push_back({ 0.0, -0.1 * i });
+    }
+    for (int i = 0; i < 40; ++i) {
+        path.push_back({ 0.1 * i, -1.0 });
+    }
+    for (int i = 0; i <= 50; ++i) {
+        path.push_back({ 4.0, -1.0 + 0.1 * i });
+    }
+    return path;
+}
+
+static double PathLength(const std::vector<smpl::RobotState>& path)
+{
+    double length = 0.0;
+    for (size_t i = 1; i < path.size(); ++i) {
+        length += std::fabs(path[i][0] - path[i - 1][0]);
+        length += std::fabs(path[i][1] - path[i - 1][1]);
+    }
+    return length;
+}
+
+static void CheckShortcutPath(int thread_count)
+{
+    PointRobotModel robot;
+    std::atomic<int> checks(0);
+    BoxCollisionChecker checker(&checks);
+
+    auto path = MakeDetourPath();
+    std::vector<smpl::RobotState> shortcut;
+    smpl::ParallelShortcutPath(&robot, &checker, path, shortcut, thread_count, 0.0);
+
+    BOOST_REQUIRE_GE(shortcut.size(), 2);
+    BOOST_CHECK(shortcut.front() == path.front());
+    BOOST_CHECK(shortcut.back() == path.back());
+    BOOST_CHECK_LT(shortcut.size(), path.size());
+    BOOST_CHECK_LT(PathLength(shortcut), PathLength(path));
+    BOOST_CHECK_GT(checks.load(), 0);
+
+    for (size_t i = 1; i < shortcut.size(); ++i) {
+        BOOST_CHECK(checker.isStateToStateValid(shortcut[i - 1], shortcut[i], false));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ShortcutSerialTest)
+{
+    CheckShortcutPath(1);
+}
+
+BOOST_AUTO_TEST_CASE(ShortcutParallelTest)
+{
+    CheckShortcutPath(4);
+}
+
+BOOST_AUTO_TEST_CASE(ShortcutTinyPathTest)
+{
+    PointRobotModel robot;
+    std::atomic<int> checks(0);
+    BoxCollisionChecker checker(&checks);
+
+    std::vector<smpl::RobotState> path = { { 0.0, 0.0 }, { 1.0, 0.0 } };
+    std::vector<smpl::RobotState> shortcut;
+    smpl::ParallelShortcutPath(&robot, &checker, path, shortcut, 2, 0.0);
+    BOOST_CHECK(shortcut == path);
+    BOOST_CHECK_EQUAL(checks.load(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(AnytimeSmoothTest)
+{
+    PointRobotModel robot;
+    std::atomic<int> checks(0);
+    BoxCollisionChecker checker(&checks);
+
+    auto path = MakeDetourPath();
+    std::vector<smpl::RobotState> smoothed;
+    auto then = std::chrono::steady_clock::now();
+    smpl::AnytimeSmoothPath(&robot, &checker, path, smoothed, 0.05, 2);
+    auto elapsed = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - then).count();
+
+    // one round may finish after the deadline
+    BOOST_CHECK_LT(elapsed, 0.5);
+
+    BOOST_REQUIRE_GE(smoothed.size(), 2);
+    BOOST_CHECK(smoothed.front() == path.front());
+    BOOST_CHECK(smoothed.back() == path.back());
+    BOOST_CHECK_LT(PathLength(smoothed), PathLength(path));
+    for (size_t i = 1; i < smoothed.size(); ++i) {
+        BOOST_CHECK(checker.isStateToStateValid(smoothed[i - 1], smoothed[i], false));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(AnytimeSmoothNoTimeTest)
+{
+    PointRobotModel robot;
+    std::atomic<int> checks(0);
+    BoxCollisionChecker checker(&checks);
+
+    auto path = MakeDetourPath();
+    std::vector<smpl::RobotState> smoothed;
+    smpl::AnytimeSmoothPath(&robot, &checker, path, smoothed, 0.0);
+    BOOST_CHECK(smoothed == path);
+    BOOST_CHECK_EQUAL(checks.load(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(TrapezoidalStraightLineTest)
+{
+    PointRobotModel robot;
+
+    // collinear waypoints are passed at speed: accelerate for 1 s over 0.5,
+    // cruise for 3 s over 3.0, and decelerate for 1 s over 0.5
+    std::vector<smpl::RobotState> path;
+    for (int i = 0; i <= 40; ++i) {
+        path.push_back({ 0.1 * i, 0.0 });
+    }
+
+    std::vector<double> times;
+    std::vector<smpl::RobotState> velocities;
+    BOOST_REQUIRE(smpl::ComputeTrapezoidalTimeParameterization(
+            &robot, path, times, velocities));
+    BOOST_REQUIRE_EQUAL(times.size(), path.size());
+    BOOST_REQUIRE_EQUAL(velocities.size(), path.size());
+
+    BOOST_CHECK_EQUAL(times.front(), 0.0);
+    BOOST_CHECK_CLOSE(times.back(), 5.0, 1e-6);
+    BOOST_CHECK_CLOSE(times[20], 2.5, 1e-6);
+    for (size_t i = 1; i < times.size(); ++i) {
+        BOOST_CHECK_GT(times[i], times[i - 1]);
+    }
+    BOOST_CHECK_CLOSE(velocities[20][0], 1.0, 1e-6);
+    BOOST_CHECK_EQUAL(velocities.back()[0], 0.0);
+    for (auto& v : velocities) {
+        BOOST_CHECK_LE(v[0], 1.0 + 1e-9);
+        BOOST_CHECK_EQUAL(v[1], 0.0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TrapezoidalCornerTest)
+{
+    PointRobotModel robot;
+
+    // a right angle corner must be rounded well below the cruise speed
+    std::vector<smpl::RobotState> path = {
+        { 0.0, 0.0 }, { 2.0, 0.0 }, { 2.0, 2.0 }
+    };
+
+    std::vector<double> times;
+    std::vector<smpl::RobotState> velocities;
+    BOOST_REQUIRE(smpl::ComputeTrapezoidalTimeParameterization(
+            &robot, path, times, velocities, 0.0));
+
+    // with no allowed deviation, the robot stops at the corner
+    BOOST_CHECK_CLOSE(times[1], 3.0, 1e-6);
+    BOOST_CHECK_CLOSE(times[2], 6.0, 1e-6);
+    BOOST_CHECK_EQUAL(velocities[1][0], 0.0);
+    BOOST_CHECK_EQUAL(velocities[1][1], 0.0);
+
+    BOOST_REQUIRE(smpl::ComputeTrapezoidalTimeParameterization(
+            &robot, path, times, velocities, 0.1));
+    BOOST_CHECK_LT(times[2], 6.0);
+    BOOST_CHECK_GT(velocities[1][1], 0.0);
+    BOOST_CHECK_LT(velocities[1][1], 1.0);
+}
+
+BOOST_AUTO_TEST_CASE(TrapezoidalMalformedPathTest)
+{
+    PointRobotModel robot;
+    std::vector<smpl::RobotState> path = { { 0.0, 0.0 }, { 1.0 } };
+    std::vector<double> times;
+    std::vector<smpl::RobotState> velocities;
+    BOOST_CHECK(!smpl::ComputeTrapezoidalTimeParameterization(
+            &robot, path, times, velocities));
+}
+
+BOOST_AUTO_TEST_CASE(OptimizePathTest)
+{
+    PointRobotModel robot;
+    std::atomic<int> checks(0);
+    BoxDistanceChecker checker(&checks);
+
+    auto path = MakeDetourPath();
+    std::vector<smpl::RobotState> optimized;
+    BOOST_REQUIRE(smpl::OptimizePath(
+            &robot, &checker, path, optimized, 20, 0.3, 300.0, 0.2));
+
+    BOOST_REQUIRE_EQUAL(optimized.size(), path.size());
+    BOOST_CHECK(optimized.front() == path.front());
+    BOOST_CHECK(optimized.back() == path.back());
+    BOOST_CHECK_LT(PathLength(optimized), PathLength(path));
+
+    // the path is validated once, not per iteration
+    BOOST_CHECK_LT(checks.load(), 2 * (int)path.size());
+    for (size_t i = 1; i < optimized.size(); ++i) {
+        BOOST_CHECK(checker.isStateToStateValid(optimized[i - 1], optimized[i], false));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(OptimizePathUnsupportedTest)
+{
+    PointRobotModel robot;
+    std::atomic<int> checks(0);
+    BoxCollisionChecker checker(&checks);
+
+    auto path = MakeDetourPath();
+    std::vector<smpl::RobotState> optimized;
+    BOOST_CHECK(!smpl::OptimizePath(&robot, &checker, path, optimized));
+    BOOST_CHECK(optimized == path);
+    BOOST_CHECK_EQUAL(checks.load(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(RepairStateTest)
+{
+    PointRobotModel robot;
+    std::atomic<int> checks(0);
+    BoxDistanceChecker checker(&checks);
+
+    // just inside the right edge of the box
+    smpl::RobotState state = { 2.93, 2.2 };
+    smpl::RobotState repaired;
+    BOOST_REQUIRE(smpl::RepairState(&robot, &checker, state, repaired, 10, 0.05, 0.05));
+    BOOST_CHECK(checker.isStateValid(repaired, false));
+    BOOST_CHECK_GT(repaired[0], state[0]);
+    BOOST_CHECK_LT(std::fabs(repaired[0] - state[0]), 0.15);
+    BOOST_CHECK_LT(std::fabs(repaired[1] - state[1]), 1e-6);
+
+    // valid states are left as they are
+    smpl::RobotState valid = { 0.0, 0.0 };
+    BOOST_REQUIRE(smpl::RepairState(&robot, &checker, valid, repaired));
+    BOOST_CHECK(repaired == valid);
+
+    // too deep to escape within the iteration limit
+    smpl::RobotState deep = { 2.5, 2.2 };
+    BOOST_CHECK(!smpl::RepairState(&robot, &checker, deep, repaired, 3, 0.05, 0.05));
+    BOOST_CHECK(repaired == deep);
+}
+
+BOOST_AUTO_TEST_CASE(RepairStateUnsupportedTest)
+{
+    PointRobotModel robot;
+    std::atomic<int> checks(0);
+    BoxCollisionChecker checker(&checks);
+
+    smpl::RobotState state = { 2.93, 2.2 };
+    smpl::RobotState repaired;
+    BOOST_CHECK(!smpl::RepairState(&robot, &checker, state, repaired));
+    BOOST_CHECK(repaired == state);
+}
+
+BOOST_AUTO_TEST_CASE(InterpolatePathTest)
+{
+    std::atomic<int> checks(0);
+    BoxCollisionChecker checker(&checks);
+
+    // the second segment crosses the box and is left as it is
+    std::vector<smpl::RobotState> path = {
+        { 0.0, 2.0 }, { 0.5, 2.0 }, { 3.5, 2.0 }, { 4.0, 2.0 }
+    };
+
+    std::vector<double> flat;
+    BOOST_REQUIRE(smpl::InterpolatePath(checker, path, flat));
+    BOOST_REQUIRE_EQUAL(flat.size(), 2 * (1 + 50 + 1 + 50));
+    BOOST_CHECK_EQUAL(flat[0], 0.0);
+    BOOST_CHECK_CLOSE(flat[2 * 25], 0.25, 1e-6);
+    BOOST_CHECK_EQUAL(flat[2 * 51], 3.5);
+    BOOST_CHECK_EQUAL(flat[flat.size() - 2], 4.0);
+
+    // the buffer is reused by later calls
+    auto capacity = flat.capacity();
+    BOOST_REQUIRE(smpl::InterpolatePath(checker, path, flat));
+    BOOST_CHECK_EQUAL(flat.capacity(), capacity);
+
+    auto interpolated = path;
+    BOOST_REQUIRE(smpl::InterpolatePath(checker, interpolated));
+    BOOST_REQUIRE_EQUAL(interpolated.size(), flat.size() / 2);
+    for (size_t i = 0; i < interpolated.size(); ++i) {
+        BOOST_CHECK_EQUAL(interpolated[i][0], flat[2 * i]);
+        BOOST_CHECK_EQUAL(interpolated[i][1], flat[2 * i + 1]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(CreatePositionVelocityPathTest)
+{
+    PointRobotModel robot;
+    std::vector<smpl::RobotState> path = {
+        { 0.0, 0.0 }, { 1.0, -1.0 }, { 0.5, 2.0 }
+    };
+
+    std::vector<smpl::RobotState> pv_path;
+    BOOST_REQUIRE(smpl::CreatePositionVelocityPath(&robot, path, pv_path));
+    BOOST_REQUIRE_EQUAL(pv_path.size(), 3);
+    BOOST_CHECK(pv_path[0] == smpl::RobotState({ 0.0, 0.0, 0.0, 0.0 }));
+    BOOST_CHECK(pv_path[1] == smpl::RobotState({ 1.0, -1.0, 1.0, -1.0 }));
+    BOOST_CHECK(pv_path[2] == smpl::RobotState({ 0.5, 2.0, -1.0, 1.0 }));
+
+    std::vector<double> flat_path;
+    for (auto& point : path) {
+        flat_path.insert(flat_path.end(), point.begin(), point.end());
+    }
+    std::vector<double> flat_pv_path;
+    BOOST_REQUIRE(smpl::CreatePositionVelocityPath(
+            &robot, flat_path.data(), path.size(), flat_pv_path));
+    BOOST_REQUIRE_EQUAL(flat_pv_path.size(), 12);
+    for (size_t i = 0; i < pv_path.size(); ++i) {
+        for (size_t j = 0; j < 4; ++j) {
+            BOOST_CHECK_EQUAL(flat_pv_path[4 * i + j], pv_path[i][j]);
+        }
+    }
+
+    // a path may be converted in place
+    BOOST_REQUIRE(smpl::CreatePositionVelocityPath(&robot, path, path));
+    BOOST_CHECK(path == pv_path);
+}
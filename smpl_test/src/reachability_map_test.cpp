@@ -0,0 +1,137 @@
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+#include <unistd.h>
+
+#define BOOST_TEST_MODULE ReachabilityMapTest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <smpl/angles.h>
+#include <smpl/reachability_map.h>
+#include <smpl/robot_model.h>
+
+// A two joint robot whose planning link sits at { q0, q1, 0 }, rotated about
+// the z axis by q0, with both joints limited to [0, 1]
+class TestRobotModel : public virtual smpl::ForwardKinematicsInterface
+{
+public:
+
+    TestRobotModel() { setPlanningJoints({ "j1", "j2" }); }
+
+    double minPosLimit(int jidx) const override { return 0.0; }
+    double maxPosLimit(int jidx) const override { return 1.0; }
+    bool hasPosLimit(int jidx) const override { return true; }
+    bool isContinuous(int jidx) const override { return false; }
+    double velLimit(int jidx) const override { return 0.0; }
+    double accLimit(int jidx) const override { return 0.0; }
+
+    bool checkJointLimits(const smpl::RobotState& state, bool verbose) override
+    {
+        return true;
+    }
+
+    auto computeFK(const smpl::RobotState& state) -> smpl::Affine3 override
+    {
+        return Pose(state[0], state[1], state[0]);
+    }
+
+    auto getExtension(size_t class_code) -> smpl::Extension* override
+    {
+        if (class_code == smpl::GetClassCode<smpl::RobotModel>() ||
+            class_code == smpl::GetClassCode<smpl::ForwardKinematicsInterface>())
+        {
+            return this;
+        }
+        return nullptr;
+    }
+
+    static auto Pose(double x, double y, double yaw) -> smpl::Affine3
+    {
+        return smpl::Translation3(x, y, 0.0) *
+                smpl::AngleAxis(yaw, smpl::Vector3::UnitZ());
+    }
+};
+
+static void BuildTestMap(smpl::ReachabilityMap& map)
+{
+    TestRobotModel robot;
+    BOOST_REQUIRE(map.build(
+            &robot, nullptr,
+            smpl::Vector3(-1.0, -1.0, -0.05),
+            smpl::Vector3(1.0, 1.0, 0.05),
+            0.1, 4, 4000));
+}
+
+BOOST_AUTO_TEST_CASE(ReachableTest)
+{
+    smpl::ReachabilityMap map;
+    BOOST_CHECK(map.empty());
+    BOOST_CHECK(!map.reachable(TestRobotModel::Pose(0.5, 0.5, 0.5)));
+
+    BuildTestMap(map);
+    BOOST_CHECK(!map.empty());
+    BOOST_CHECK_EQUAL(map.dof(), 2);
+    BOOST_CHECK(map.seedCount() > 0);
+
+    BOOST_CHECK(map.reachable(TestRobotModel::Pose(0.5, 0.5, 0.5)));
+    BOOST_CHECK(map.reachable(smpl::Vector3(0.5, 0.5, 0.0)));
+    BOOST_CHECK(map.capability(smpl::Vector3(0.5, 0.5, 0.0)) > 0.0);
+
+    // positions that no configuration reaches, inside and outside the map
+    BOOST_CHECK(!map.reachable(TestRobotModel::Pose(-0.8, -0.8, 0.5)));
+    BOOST_CHECK(!map.reachable(smpl::Vector3(-0.8, -0.8, 0.0)));
+    BOOST_CHECK(!map.reachable(TestRobotModel::Pose(3.0, 3.0, 0.5)));
+    BOOST_CHECK_EQUAL(map.capability(smpl::Vector3(-0.8, -0.8, 0.0)), 0.0);
+
+    // yaw in [0, 1] falls into the third of four bins, and queries accept the
+    // neighboring bins
+    BOOST_CHECK(map.reachable(TestRobotModel::Pose(0.5, 0.5, M_PI - 0.1)));
+    BOOST_CHECK(!map.reachable(TestRobotModel::Pose(0.5, 0.5, -0.5 * M_PI - 0.1)));
+}
+
+BOOST_AUTO_TEST_CASE(SeedTest)
+{
+    smpl::ReachabilityMap map;
+    BuildTestMap(map);
+
+    smpl::RobotState seed;
+    BOOST_REQUIRE(map.seed(TestRobotModel::Pose(0.45, 0.55, 0.45), seed));
+    BOOST_REQUIRE_EQUAL(seed.size(), 2);
+    BOOST_CHECK_SMALL(seed[0] - 0.45, 0.2);
+    BOOST_CHECK_SMALL(seed[1] - 0.55, 0.2);
+
+    BOOST_CHECK(!map.seed(TestRobotModel::Pose(-0.8, -0.8, 0.5), seed));
+}
+
+BOOST_AUTO_TEST_CASE(FileTest)
+{
+    smpl::ReachabilityMap map;
+    BuildTestMap(map);
+
+    auto path = std::string("reachability_map_test.rmap");
+    BOOST_REQUIRE(map.save(path));
+
+    smpl::ReachabilityMap loaded;
+    BOOST_REQUIRE(loaded.load(path));
+    BOOST_CHECK_EQUAL(loaded.dof(), map.dof());
+    BOOST_CHECK_EQUAL(loaded.seedCount(), map.seedCount());
+    BOOST_CHECK_EQUAL(loaded.resolution(), map.resolution());
+    BOOST_CHECK_EQUAL(loaded.orientationBins(), map.orientationBins());
+
+    auto pose = TestRobotModel::Pose(0.45, 0.55, 0.45);
+    smpl::RobotState seed, loaded_seed;
+    BOOST_REQUIRE(map.seed(pose, seed));
+    BOOST_REQUIRE(loaded.seed(pose, loaded_seed));
+    BOOST_CHECK(seed == loaded_seed);
+    BOOST_CHECK(!loaded.reachable(TestRobotModel::Pose(-0.8, -0.8, 0.5)));
+
+    // a truncated file is rejected
+    BOOST_REQUIRE(truncate(path.c_str(), 256) == 0);
+    smpl::ReachabilityMap truncated;
+    BOOST_CHECK(!truncated.load(path));
+    BOOST_CHECK(truncated.empty());
+
+    std::remove(path.c_str());
+}
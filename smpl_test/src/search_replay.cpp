@@ -0,0 +1,132 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+
+// Re-run a search recorded with SearchTraceRecorder against the recorded
+// graph and heuristic values, with no collision checker or robot model
+// attached, to measure the cost of the search itself separately from the
+// cost of generating its successors.
+//
+// Usage:
+//     search_replay <trace> [eps]
+//
+// Traces with a single recorded heuristic are replayed with ARA*; traces
+// with more are replayed with MHA*++, using the first as the anchor.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include <smpl/search/arastar.h>
+#include <smpl/search/mhastarpp.h>
+#include <smpl/search/search_trace.h>
+#include <smpl/time.h>
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        std::fprintf(stderr, "Usage: search_replay <trace> [eps]\n");
+        return 1;
+    }
+
+    smpl::SearchTrace trace;
+    if (!smpl::ReadSearchTrace(argv[1], trace)) {
+        std::fprintf(stderr, "Failed to read search trace '%s'\n", argv[1]);
+        return 1;
+    }
+
+    double eps = trace.eps;
+    if (argc > 2) {
+        eps = std::atof(argv[2]);
+    }
+
+    std::printf("trace: %zu expansions, %zu heuristics, start %d, goal %d, eps %0.3f\n",
+            trace.expansions.size(),
+            trace.heuristics.size(),
+            trace.start_id,
+            trace.goal_id,
+            trace.eps);
+
+    smpl::SearchTraceSpace space(&trace);
+
+    std::vector<std::unique_ptr<smpl::SearchTraceHeuristic>> heuristics;
+    auto hcount = std::max<size_t>(1, trace.heuristics.size());
+    for (size_t i = 0; i < hcount; ++i) {
+        heuristics.emplace_back(new smpl::SearchTraceHeuristic(&trace, (int)i));
+    }
+
+    std::unique_ptr<SBPLPlanner> search;
+    if (hcount == 1) {
+        auto arastar = new smpl::ARAStar(&space, heuristics[0].get());
+        arastar->set_initialsolution_eps(eps);
+        arastar->setTargetEpsilon(eps);
+        search.reset(arastar);
+    } else {
+        std::vector<Heuristic*> inads;
+        for (size_t i = 1; i < hcount; ++i) {
+            inads.push_back(heuristics[i].get());
+        }
+        auto mhastar = new smpl::MHAStarPP(
+                &space, heuristics[0].get(), inads.data(), (int)inads.size());
+        mhastar->set_initial_eps(eps);
+        mhastar->set_final_eps(eps);
+        search.reset(mhastar);
+    }
+
+    search->set_start(trace.start_id);
+    search->set_goal(trace.goal_id);
+
+    std::vector<int> solution;
+    int cost;
+    auto then = smpl::clock::now();
+    auto found = search->replan(1e6, &solution, &cost);
+    auto search_time = smpl::to_seconds(smpl::clock::now() - then);
+
+    auto graph_time = trace.graphTime();
+    int missing_values = 0;
+    for (auto& h : heuristics) {
+        missing_values += h->missingValues();
+    }
+
+    std::printf("solution found: %s\n", found ? "true" : "false");
+    std::printf("solution cost: %d\n", found ? cost : -1);
+    std::printf("solution length: %zu\n", solution.size());
+    std::printf("expansions: %d (recorded %zu)\n", search->get_n_expands(), trace.expansions.size());
+    std::printf("search time: %0.6f s\n", search_time);
+    std::printf("recorded graph time: %0.6f s\n", graph_time);
+    if (search_time + graph_time > 0.0) {
+        std::printf("search fraction of recorded planning time: %0.3f\n",
+                search_time / (search_time + graph_time));
+    }
+    std::printf("unrecorded expansions: %d\n", space.missingExpansions());
+    std::printf("unrecorded heuristic values: %d\n", missing_values);
+    return 0;
+}
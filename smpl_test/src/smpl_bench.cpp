@@ -0,0 +1,931 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+
+// standard includes
+#include <dirent.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// system includes
+#include <eigen_conversions/eigen_msg.h>
+#include <moveit_msgs/PlanningScene.h>
+#include <ros/ros.h>
+#include <sbpl_collision_checking/collision_space.h>
+#include <sbpl_kdl_robot_model/kdl_robot_model.h>
+#include <smpl/angles.h>
+#include <smpl/distance_map/euclid_distance_map.h>
+#include <smpl/ros/planner_interface.h>
+
+#include "collision_space_scene.h"
+#include "pr2_allowed_collision_pairs.h"
+
+// Run every planner on every combination of scene and experiment a fixed
+// number of times and report aggregate statistics.
+//
+// Scenes are the object files (*.env) in ~scene_directory. Experiments are
+// the namespaces under ~experiments, each holding the initial_configuration
+// and goal of one request in the format of the files in experiments/. Planner
+// ids (e.g. "arastar.bfs.manip") are listed in ~planner_ids. Results are
+// written to <~output_prefix>.csv and <~output_prefix>.json.
+//
+// The samples of every run are written to ~save_baseline, if set. If
+// ~baseline names such a file, the samples of each planner, scene, and
+// experiment are compared against it: a metric regressed if the bootstrap
+// confidence interval (~confidence, from ~bootstrap_resamples resamples) of
+// the ratio of its mean to the baseline mean lies entirely beyond
+// ~regression_tolerance in the worse direction. The comparison is written to
+// <~output_prefix>_comparison.csv, and the exit status is 2 if any metric
+// regressed. With ~perf_counters, cache misses and instructions per expansion
+// are also measured, on the planning thread and the threads it starts.
+
+auto GetCollisionObjects(
+    const std::string& filename,
+    const std::string& frame_id)
+    -> std::vector<moveit_msgs::CollisionObject>
+{
+    std::vector<moveit_msgs::CollisionObject> objects;
+
+    std::ifstream fin(filename);
+    if (!fin.is_open()) {
+        ROS_ERROR("Failed to open objects file '%s'", filename.c_str());
+        return objects;
+    }
+
+    int num_obs;
+    if (!(fin >> num_obs)) {
+        ROS_ERROR("Failed to read object count from '%s'", filename.c_str());
+        return objects;
+    }
+
+    for (int i = 0; i < num_obs; ++i) {
+        std::string id;
+        double x, y, z, dx, dy, dz;
+        if (!(fin >> id >> x >> y >> z >> dx >> dy >> dz)) {
+            ROS_ERROR("Failed to read object %d from '%s'", i, filename.c_str());
+            break;
+        }
+
+        moveit_msgs::CollisionObject object;
+        object.id = id;
+        object.operation = moveit_msgs::CollisionObject::ADD;
+        object.header.frame_id = frame_id;
+        object.header.stamp = ros::Time::now();
+
+        shape_msgs::SolidPrimitive box;
+        box.type = shape_msgs::SolidPrimitive::BOX;
+        box.dimensions = { dx, dy, dz };
+
+        geometry_msgs::Pose pose;
+        pose.position.x = x;
+        pose.position.y = y;
+        pose.position.z = z;
+        pose.orientation.w = 1.0;
+
+        object.primitives.push_back(box);
+        object.primitive_poses.push_back(pose);
+        objects.push_back(std::move(object));
+    }
+
+    return objects;
+}
+
+bool ReadInitialConfiguration(
+    ros::NodeHandle& nh,
+    moveit_msgs::RobotState& state)
+{
+    XmlRpc::XmlRpcValue xlist;
+    if (!nh.getParam("initial_configuration/joint_state", xlist) ||
+        xlist.getType() != XmlRpc::XmlRpcValue::TypeArray)
+    {
+        ROS_ERROR("'%s/initial_configuration/joint_state' is missing or not an array", nh.getNamespace().c_str());
+        return false;
+    }
+
+    for (int i = 0; i < xlist.size(); ++i) {
+        state.joint_state.name.push_back(std::string(xlist[i]["name"]));
+        auto& position = xlist[i]["position"];
+        if (position.getType() == XmlRpc::XmlRpcValue::TypeInt) {
+            state.joint_state.position.push_back((double)(int)position);
+        } else {
+            state.joint_state.position.push_back((double)position);
+        }
+    }
+
+    return true;
+}
+
+void FillGoalConstraint(
+    const std::vector<double>& pose,
+    const std::string& frame_id,
+    moveit_msgs::Constraints& goals)
+{
+    goals.position_constraints.resize(1);
+    goals.orientation_constraints.resize(1);
+    goals.position_constraints[0].header.frame_id = frame_id;
+
+    auto& region = goals.position_constraints[0].constraint_region;
+    region.primitives.resize(1);
+    region.primitive_poses.resize(1);
+    region.primitives[0].type = shape_msgs::SolidPrimitive::BOX;
+    region.primitives[0].dimensions.resize(3, 0.015);
+    region.primitive_poses[0].position.x = pose[0];
+    region.primitive_poses[0].position.y = pose[1];
+    region.primitive_poses[0].position.z = pose[2];
+
+    Eigen::Quaterniond q;
+    smpl::angles::from_euler_zyx(pose[5], pose[4], pose[3], q);
+    tf::quaternionEigenToMsg(q, goals.orientation_constraints[0].orientation);
+    goals.orientation_constraints[0].absolute_x_axis_tolerance = 0.05;
+    goals.orientation_constraints[0].absolute_y_axis_tolerance = 0.05;
+    goals.orientation_constraints[0].absolute_z_axis_tolerance = 0.05;
+}
+
+struct Experiment
+{
+    std::string name;
+    moveit_msgs::RobotState start_state;
+    std::vector<double> goal;
+};
+
+bool ReadExperiment(
+    const ros::NodeHandle& ph,
+    const std::string& name,
+    Experiment& experiment)
+{
+    ros::NodeHandle nh(ph, "experiments/" + name);
+    experiment.name = name;
+    if (!ReadInitialConfiguration(nh, experiment.start_state)) {
+        return false;
+    }
+
+    experiment.goal.resize(6);
+    nh.param("goal/x", experiment.goal[0], 0.0);
+    nh.param("goal/y", experiment.goal[1], 0.0);
+    nh.param("goal/z", experiment.goal[2], 0.0);
+    nh.param("goal/roll", experiment.goal[3], 0.0);
+    nh.param("goal/pitch", experiment.goal[4], 0.0);
+    nh.param("goal/yaw", experiment.goal[5], 0.0);
+    return true;
+}
+
+auto ListSceneFiles(const std::string& directory) -> std::vector<std::string>
+{
+    std::vector<std::string> files;
+    DIR* dir = opendir(directory.c_str());
+    if (dir == NULL) {
+        ROS_ERROR("Failed to open scene directory '%s'", directory.c_str());
+        return files;
+    }
+
+    const std::string ext(".env");
+    while (struct dirent* entry = readdir(dir)) {
+        std::string name(entry->d_name);
+        if (name.size() > ext.size() &&
+            name.compare(name.size() - ext.size(), ext.size(), ext) == 0)
+        {
+            files.push_back(directory + "/" + name);
+        }
+    }
+    closedir(dir);
+
+    // stable order so that runs are comparable
+    std::sort(begin(files), end(files));
+    return files;
+}
+
+auto ReadPlannerParams(const ros::NodeHandle& nh, smpl::PlanningParams& params)
+    -> bool
+{
+    // same parameters as callPlanner reads from ~planning
+    const char* string_params[] = { "discretization", "mprim_filename" };
+    for (auto* name : string_params) {
+        std::string value;
+        if (!nh.getParam(name, value)) {
+            ROS_ERROR("Failed to read param '%s' from the param server", name);
+            return false;
+        }
+        params.addParam(name, value);
+    }
+
+    const char* bool_params[] = {
+        "use_xyz_snap_mprim",
+        "use_rpy_snap_mprim",
+        "use_xyzrpy_snap_mprim",
+        "use_short_dist_mprims",
+    };
+    for (auto* name : bool_params) {
+        bool value;
+        if (!nh.getParam(name, value)) {
+            ROS_ERROR("Failed to read param '%s' from the param server", name);
+            return false;
+        }
+        params.addParam(name, value);
+    }
+
+    const char* double_params[] = {
+        "xyz_snap_dist_thresh",
+        "rpy_snap_dist_thresh",
+        "xyzrpy_snap_dist_thresh",
+        "short_dist_mprims_thresh",
+    };
+    for (auto* name : double_params) {
+        double value;
+        if (!nh.getParam(name, value)) {
+            ROS_ERROR("Failed to read param '%s' from the param server", name);
+            return false;
+        }
+        params.addParam(name, value);
+    }
+
+    params.addParam("epsilon", 100.0);
+    params.addParam("search_mode", false);
+    params.addParam("allow_partial_solutions", false);
+    params.addParam("target_epsilon", 1.0);
+    params.addParam("delta_epsilon", 1.0);
+    params.addParam("improve_solution", false);
+    params.addParam("bound_expansions", true);
+    params.addParam("repair_time", 1.0);
+    params.addParam("bfs_inflation_radius", 0.02);
+    params.addParam("bfs_cost_per_cell", 100);
+    return true;
+}
+
+// Peak resident set size of the process, in kilobytes
+long PeakMemoryKB()
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return usage.ru_maxrss;
+}
+
+// Nearest-rank percentile of a sorted sequence
+double Percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    auto rank = (size_t)std::ceil(p * (double)sorted.size());
+    rank = std::max(rank, (size_t)1);
+    return sorted[std::min(rank, sorted.size()) - 1];
+}
+
+// Counts a hardware event on the calling thread, and the threads it starts
+// while counting, via perf_event_open.
+class PerfCounter
+{
+public:
+
+    PerfCounter(std::uint64_t config)
+    {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        m_fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+
+    ~PerfCounter()
+    {
+        if (m_fd >= 0) {
+            close(m_fd);
+        }
+    }
+
+    PerfCounter(const PerfCounter&) = delete;
+    PerfCounter& operator=(const PerfCounter&) = delete;
+
+    bool valid() const { return m_fd >= 0; }
+
+    void start()
+    {
+        ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    auto stop() -> std::uint64_t
+    {
+        ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+        std::uint64_t count = 0;
+        if (read(m_fd, &count, sizeof(count)) != sizeof(count)) {
+            return 0;
+        }
+        return count;
+    }
+
+private:
+
+    int m_fd;
+};
+
+struct BenchmarkResult
+{
+    std::string scene;
+    std::string experiment;
+    std::string planner_id;
+    int runs = 0;
+    int successes = 0;
+
+    // times to the first solution of successful runs
+    std::vector<double> first_solution_times;
+
+    // samples of each run
+    std::vector<double> expansion_rates;
+    std::vector<double> memory_bytes;
+    std::vector<double> cache_misses_per_expansion;
+    std::vector<double> instructions_per_expansion;
+
+    double planning_time = 0.0;
+    double expansions = 0.0;
+    double collision_checks = 0.0;
+    long peak_memory_kb = 0;
+
+    double successRate() const {
+        return runs > 0 ? (double)successes / (double)runs : 0.0;
+    }
+    double expansionRate() const {
+        return planning_time > 0.0 ? expansions / planning_time : 0.0;
+    }
+    double collisionCheckRate() const {
+        return planning_time > 0.0 ? collision_checks / planning_time : 0.0;
+    }
+};
+
+// metrics compared against the baseline
+static const struct
+{
+    const char* name;
+    bool lower_is_better;
+    std::vector<double> BenchmarkResult::*samples;
+} Metrics[] = {
+    { "expansions_per_second",      false,  &BenchmarkResult::expansion_rates },
+    { "first_solution_time",        true,   &BenchmarkResult::first_solution_times },
+    { "memory_bytes",               true,   &BenchmarkResult::memory_bytes },
+    { "cache_misses_per_expansion", true,   &BenchmarkResult::cache_misses_per_expansion },
+    { "instructions_per_expansion", true,   &BenchmarkResult::instructions_per_expansion },
+};
+
+auto BaselineKey(const BenchmarkResult& r, const char* metric) -> std::string
+{
+    return r.scene + ' ' + r.experiment + ' ' + r.planner_id + ' ' + metric;
+}
+
+// Baseline samples, keyed by scene, experiment, planner id, and metric. Each
+// line of the file holds the four keys, the sample count, and the samples.
+using Baseline = std::map<std::string, std::vector<double>>;
+
+bool ReadBaseline(const std::string& path, Baseline& baseline)
+{
+    std::ifstream ifs(path);
+    if (!ifs.is_open()) {
+        ROS_ERROR("Failed to open baseline '%s'", path.c_str());
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(ifs, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream iss(line);
+        std::string scene, experiment, planner_id, metric;
+        size_t count;
+        if (!(iss >> scene >> experiment >> planner_id >> metric >> count)) {
+            ROS_ERROR("Malformed baseline line '%s'", line.c_str());
+            return false;
+        }
+        auto& samples = baseline[scene + ' ' + experiment + ' ' + planner_id + ' ' + metric];
+        samples.resize(count);
+        for (auto& sample : samples) {
+            if (!(iss >> sample)) {
+                ROS_ERROR("Malformed baseline line '%s'", line.c_str());
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void WriteBaseline(const std::string& path, const std::vector<BenchmarkResult>& results)
+{
+    std::ofstream ofs(path);
+    ofs.precision(17);
+    ofs << "# scene experiment planner_id metric count samples...\n";
+    for (auto& r : results) {
+        for (auto& metric : Metrics) {
+            auto& samples = r.*metric.samples;
+            ofs << BaselineKey(r, metric.name) << ' ' << samples.size();
+            for (auto sample : samples) {
+                ofs << ' ' << sample;
+            }
+            ofs << '\n';
+        }
+    }
+}
+
+double Mean(const std::vector<double>& v)
+{
+    auto sum = 0.0;
+    for (auto x : v) {
+        sum += x;
+    }
+    return v.empty() ? 0.0 : sum / (double)v.size();
+}
+
+// Percentile bootstrap confidence interval of mean(current) / mean(baseline).
+// Both sets of samples are resampled independently; resamples with a zero
+// baseline mean are discarded.
+bool BootstrapRatioInterval(
+    const std::vector<double>& baseline,
+    const std::vector<double>& current,
+    int resamples,
+    double confidence,
+    std::default_random_engine& rng,
+    double& lo,
+    double& hi)
+{
+    std::uniform_int_distribution<size_t> pick_baseline(0, baseline.size() - 1);
+    std::uniform_int_distribution<size_t> pick_current(0, current.size() - 1);
+
+    std::vector<double> ratios;
+    ratios.reserve(resamples);
+    for (int i = 0; i < resamples; ++i) {
+        auto baseline_sum = 0.0;
+        for (size_t j = 0; j < baseline.size(); ++j) {
+            baseline_sum += baseline[pick_baseline(rng)];
+        }
+        auto current_sum = 0.0;
+        for (size_t j = 0; j < current.size(); ++j) {
+            current_sum += current[pick_current(rng)];
+        }
+        if (baseline_sum == 0.0) {
+            continue;
+        }
+        ratios.push_back(
+                (current_sum / (double)current.size()) /
+                (baseline_sum / (double)baseline.size()));
+    }
+
+    if (ratios.empty()) {
+        return false;
+    }
+
+    std::sort(begin(ratios), end(ratios));
+    auto alpha = 0.5 * (1.0 - confidence);
+    lo = Percentile(ratios, alpha);
+    hi = Percentile(ratios, 1.0 - alpha);
+    return true;
+}
+
+// Compare every metric with at least two samples in both the results and the
+// baseline, and return the number of regressions.
+int CompareWithBaseline(
+    const Baseline& baseline,
+    const std::vector<BenchmarkResult>& results,
+    double tolerance,
+    int resamples,
+    double confidence,
+    const std::string& path)
+{
+    std::ofstream ofs(path);
+    ofs << "scene,experiment,planner_id,metric,baseline_mean,current_mean,"
+            "ratio_low,ratio_high,verdict\n";
+
+    // fixed seed so that repeated comparisons of the same runs agree
+    std::default_random_engine rng(0);
+
+    auto regressions = 0;
+    for (auto& r : results) {
+        for (auto& metric : Metrics) {
+            auto& current = r.*metric.samples;
+            auto bit = baseline.find(BaselineKey(r, metric.name));
+            if (bit == end(baseline) ||
+                bit->second.size() < 2 ||
+                current.size() < 2)
+            {
+                continue;
+            }
+
+            double lo, hi;
+            if (!BootstrapRatioInterval(bit->second, current, resamples, confidence, rng, lo, hi)) {
+                continue;
+            }
+
+            auto worse = metric.lower_is_better ?
+                    lo > 1.0 + tolerance : hi < 1.0 - tolerance;
+            auto better = metric.lower_is_better ?
+                    hi < 1.0 - tolerance : lo > 1.0 + tolerance;
+            auto verdict = worse ? "regression" : better ? "improvement" : "unchanged";
+            if (worse) {
+                ++regressions;
+                ROS_WARN("%s / %s / %s: %s regressed, ratio to baseline in [%0.3f, %0.3f]",
+                        r.scene.c_str(),
+                        r.experiment.c_str(),
+                        r.planner_id.c_str(),
+                        metric.name,
+                        lo,
+                        hi);
+            }
+
+            ofs << r.scene << ',' << r.experiment << ',' << r.planner_id << ','
+                << metric.name << ',' << Mean(bit->second) << ','
+                << Mean(current) << ',' << lo << ',' << hi << ','
+                << verdict << '\n';
+        }
+    }
+    return regressions;
+}
+
+void WriteCSV(const std::string& path, const std::vector<BenchmarkResult>& results)
+{
+    std::ofstream ofs(path);
+    ofs << "scene,experiment,planner_id,runs,success_rate,"
+            "first_solution_time_p50,first_solution_time_p90,"
+            "first_solution_time_p99,expansions_per_second,"
+            "collision_checks_per_second,peak_memory_kb,"
+            "cache_misses_per_expansion,instructions_per_expansion\n";
+    for (auto& r : results) {
+        ofs << r.scene << ',' << r.experiment << ',' << r.planner_id << ','
+            << r.runs << ',' << r.successRate() << ','
+            << Percentile(r.first_solution_times, 0.5) << ','
+            << Percentile(r.first_solution_times, 0.9) << ','
+            << Percentile(r.first_solution_times, 0.99) << ','
+            << r.expansionRate() << ',' << r.collisionCheckRate() << ','
+            << r.peak_memory_kb << ','
+            << Mean(r.cache_misses_per_expansion) << ','
+            << Mean(r.instructions_per_expansion) << '\n';
+    }
+}
+
+void WriteJSON(const std::string& path, const std::vector<BenchmarkResult>& results)
+{
+    std::ofstream ofs(path);
+    ofs << "[\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        auto& r = results[i];
+        ofs << "  {"
+            << "\"scene\": \"" << r.scene << "\", "
+            << "\"experiment\": \"" << r.experiment << "\", "
+            << "\"planner_id\": \"" << r.planner_id << "\", "
+            << "\"runs\": " << r.runs << ", "
+            << "\"success_rate\": " << r.successRate() << ", "
+            << "\"first_solution_time\": {"
+                << "\"p50\": " << Percentile(r.first_solution_times, 0.5) << ", "
+                << "\"p90\": " << Percentile(r.first_solution_times, 0.9) << ", "
+                << "\"p99\": " << Percentile(r.first_solution_times, 0.99) << "}, "
+            << "\"expansions_per_second\": " << r.expansionRate() << ", "
+            << "\"collision_checks_per_second\": " << r.collisionCheckRate() << ", "
+            << "\"peak_memory_kb\": " << r.peak_memory_kb << ", "
+            << "\"cache_misses_per_expansion\": " << Mean(r.cache_misses_per_expansion) << ", "
+            << "\"instructions_per_expansion\": " << Mean(r.instructions_per_expansion)
+            << "}" << (i + 1 < results.size() ? "," : "") << '\n';
+    }
+    ofs << "]\n";
+}
+
+auto BaseName(const std::string& path) -> std::string
+{
+    auto slash = path.find_last_of('/');
+    auto name = slash == std::string::npos ? path : path.substr(slash + 1);
+    return name.substr(0, name.find_last_of('.'));
+}
+
+int main(int argc, char* argv[])
+{
+    ros::init(argc, argv, "smpl_bench");
+    ros::NodeHandle nh;
+    ros::NodeHandle ph("~");
+
+    std::string robot_description;
+    std::string robot_description_param;
+    if (!nh.searchParam("robot_description", robot_description_param) ||
+        !nh.getParam(robot_description_param, robot_description))
+    {
+        ROS_ERROR("Failed to retrieve param 'robot_description' from the param server");
+        return 1;
+    }
+
+    std::string planning_frame;
+    if (!ph.getParam("planning_frame", planning_frame)) {
+        ROS_ERROR("Failed to retrieve param 'planning_frame' from the param server");
+        return 1;
+    }
+
+    std::string group_name;
+    std::string planning_joint_list;
+    std::string kinematics_frame;
+    std::string chain_tip_link;
+    ros::NodeHandle rh(ph, "robot_model");
+    if (!rh.getParam("group_name", group_name) ||
+        !rh.getParam("planning_joints", planning_joint_list) ||
+        !rh.getParam("kinematics_frame", kinematics_frame) ||
+        !rh.getParam("chain_tip_link", chain_tip_link))
+    {
+        ROS_ERROR("Failed to read robot model config from param server");
+        return 1;
+    }
+    std::vector<std::string> planning_joints;
+    std::stringstream joint_name_stream(planning_joint_list);
+    std::string jname;
+    while (joint_name_stream >> jname) {
+        planning_joints.push_back(jname);
+    }
+
+    smpl::PlanningParams params;
+    if (!ReadPlannerParams(ros::NodeHandle(ph, "planning"), params)) {
+        return 1;
+    }
+
+    smpl::collision::CollisionModelConfig cc_conf;
+    if (!smpl::collision::CollisionModelConfig::Load(ph, cc_conf)) {
+        ROS_ERROR("Failed to load Collision Model Config");
+        return 1;
+    }
+
+    std::string scene_directory;
+    ph.param<std::string>("scene_directory", scene_directory, "");
+    auto scene_files = ListSceneFiles(scene_directory);
+    if (scene_files.empty()) {
+        ROS_ERROR("No scenes found in '%s'", scene_directory.c_str());
+        return 1;
+    }
+
+    std::vector<Experiment> experiments;
+    XmlRpc::XmlRpcValue xexperiments;
+    if (ph.getParam("experiments", xexperiments) &&
+        xexperiments.getType() == XmlRpc::XmlRpcValue::TypeStruct)
+    {
+        for (auto it = xexperiments.begin(); it != xexperiments.end(); ++it) {
+            Experiment experiment;
+            if (!ReadExperiment(ph, it->first, experiment)) {
+                return 1;
+            }
+            experiments.push_back(std::move(experiment));
+        }
+    }
+    if (experiments.empty()) {
+        ROS_ERROR("No experiments found under '%s/experiments'", ph.getNamespace().c_str());
+        return 1;
+    }
+
+    std::vector<std::string> planner_ids;
+    ph.param(
+            "planner_ids",
+            planner_ids,
+            std::vector<std::string>{ "arastar.bfs.manip" });
+
+    int repetitions;
+    double allowed_planning_time;
+    std::string output_prefix;
+    ph.param("repetitions", repetitions, 10);
+    ph.param("allowed_planning_time", allowed_planning_time, 10.0);
+    ph.param<std::string>("output_prefix", output_prefix, "smpl_bench");
+
+    std::string baseline_path;
+    std::string save_baseline_path;
+    double regression_tolerance;
+    int bootstrap_resamples;
+    double confidence;
+    bool perf_counters;
+    ph.param<std::string>("baseline", baseline_path, "");
+    ph.param<std::string>("save_baseline", save_baseline_path, "");
+    ph.param("regression_tolerance", regression_tolerance, 0.05);
+    ph.param("bootstrap_resamples", bootstrap_resamples, 2000);
+    ph.param("confidence", confidence, 0.95);
+    ph.param("perf_counters", perf_counters, false);
+
+    Baseline baseline;
+    if (!baseline_path.empty() && !ReadBaseline(baseline_path, baseline)) {
+        return 1;
+    }
+
+    std::unique_ptr<PerfCounter> cache_misses;
+    std::unique_ptr<PerfCounter> instructions;
+    if (perf_counters) {
+        cache_misses.reset(new PerfCounter(PERF_COUNT_HW_CACHE_MISSES));
+        instructions.reset(new PerfCounter(PERF_COUNT_HW_INSTRUCTIONS));
+        if (!cache_misses->valid() || !instructions->valid()) {
+            ROS_WARN("Hardware counters are not available (check perf_event_paranoid)");
+            cache_misses.reset();
+            instructions.reset();
+        }
+    }
+
+    std::unique_ptr<smpl::KDLRobotModel> rm(new smpl::KDLRobotModel);
+    if (!rm->init(robot_description, kinematics_frame, chain_tip_link)) {
+        ROS_ERROR("Failed to initialize robot model.");
+        return 1;
+    }
+
+    std::vector<BenchmarkResult> results;
+
+    for (auto& scene_file : scene_files) {
+        // rebuild the world for each scene so that scenes do not leak into
+        // one another
+        auto df = std::make_shared<smpl::EuclidDistanceMap>(
+                -0.75, -1.5, 0.0, 3.0, 3.0, 3.0, 0.02, 1.8);
+        smpl::OccupancyGrid grid(df, false);
+        grid.setReferenceFrame(planning_frame);
+
+        CollisionSpaceScene scene;
+        smpl::collision::CollisionSpace cc;
+        if (!cc.init(&grid, robot_description, cc_conf, group_name, planning_joints)) {
+            ROS_ERROR("Failed to initialize Collision Space");
+            return 1;
+        }
+
+        if (cc.robotCollisionModel()->name() == "pr2") {
+            smpl::collision::AllowedCollisionMatrix acm;
+            for (auto& pair : PR2AllowedCollisionPairs) {
+                acm.setEntry(pair.first, pair.second, true);
+            }
+            cc.setAllowedCollisionMatrix(acm);
+        }
+
+        scene.SetCollisionSpace(&cc);
+        for (auto& object : GetCollisionObjects(scene_file, planning_frame)) {
+            scene.ProcessCollisionObjectMsg(object);
+        }
+
+        for (auto& experiment : experiments) {
+            if (!scene.SetRobotState(experiment.start_state)) {
+                ROS_ERROR("Failed to set start state of experiment '%s'", experiment.name.c_str());
+                continue;
+            }
+            cc.setWorldToModelTransform(Eigen::Affine3d::Identity());
+
+            smpl::urdf::RobotState reference_state;
+            InitRobotState(&reference_state, &rm->m_robot_model);
+            auto& joint_state = experiment.start_state.joint_state;
+            for (size_t i = 0; i < joint_state.name.size(); ++i) {
+                auto* var = GetVariable(&rm->m_robot_model, &joint_state.name[i]);
+                if (var != NULL) {
+                    SetVariablePosition(&reference_state, var, joint_state.position[i]);
+                }
+            }
+            SetReferenceState(rm.get(), GetVariablePositions(&reference_state));
+
+            moveit_msgs::MotionPlanRequest req;
+            req.allowed_planning_time = allowed_planning_time;
+            req.goal_constraints.resize(1);
+            FillGoalConstraint(experiment.goal, planning_frame, req.goal_constraints[0]);
+            req.group_name = group_name;
+            req.max_acceleration_scaling_factor = 1.0;
+            req.max_velocity_scaling_factor = 1.0;
+            req.num_planning_attempts = 1;
+            req.start_state = experiment.start_state;
+
+            moveit_msgs::PlanningScene planning_scene;
+            planning_scene.robot_state = experiment.start_state;
+
+            for (auto& planner_id : planner_ids) {
+                BenchmarkResult result;
+                result.scene = BaseName(scene_file);
+                result.experiment = experiment.name;
+                result.planner_id = planner_id;
+
+                smpl::PlannerInterface planner(rm.get(), &cc, &grid);
+                if (!planner.init(params)) {
+                    ROS_ERROR("Failed to initialize Planner Interface");
+                    return 1;
+                }
+
+                req.planner_id = planner_id;
+                for (int i = 0; i < repetitions && ros::ok(); ++i) {
+                    moveit_msgs::MotionPlanResponse res;
+                    if (cache_misses) {
+                        cache_misses->start();
+                        instructions->start();
+                    }
+                    auto then = std::chrono::steady_clock::now();
+                    bool solved = planner.solve(planning_scene, req, res);
+                    auto now = std::chrono::steady_clock::now();
+                    std::uint64_t miss_count = 0, instruction_count = 0;
+                    if (cache_misses) {
+                        miss_count = cache_misses->stop();
+                        instruction_count = instructions->stop();
+                    }
+
+                    auto stats = planner.getPlannerStats();
+                    auto run_time = std::chrono::duration<double>(now - then).count();
+                    auto expansions = stats["expansions"];
+                    ++result.runs;
+                    result.planning_time += run_time;
+                    result.expansions += expansions;
+                    if (run_time > 0.0) {
+                        result.expansion_rates.push_back(expansions / run_time);
+                    }
+                    result.memory_bytes.push_back(
+                            stats["planning space memory"] +
+                            stats["heuristic memory"] +
+                            stats["search memory"]);
+                    if (cache_misses && expansions > 0.0) {
+                        result.cache_misses_per_expansion.push_back(
+                                (double)miss_count / expansions);
+                        result.instructions_per_expansion.push_back(
+                                (double)instruction_count / expansions);
+                    }
+                    result.collision_checks +=
+                            stats["state check count"] +
+                            stats["motion check count"];
+                    if (solved) {
+                        ++result.successes;
+                        result.first_solution_times.push_back(
+                                stats["initial solution planning time"]);
+                    }
+                }
+
+                std::sort(
+                        begin(result.first_solution_times),
+                        end(result.first_solution_times));
+                result.peak_memory_kb = PeakMemoryKB();
+
+                ROS_INFO("%s / %s / %s: %d/%d solved, p50 %0.3fs, %0.0f expansions/s, %0.0f checks/s",
+                        result.scene.c_str(),
+                        result.experiment.c_str(),
+                        result.planner_id.c_str(),
+                        result.successes,
+                        result.runs,
+                        Percentile(result.first_solution_times, 0.5),
+                        result.expansionRate(),
+                        result.collisionCheckRate());
+                results.push_back(std::move(result));
+            }
+        }
+    }
+
+    WriteCSV(output_prefix + ".csv", results);
+    WriteJSON(output_prefix + ".json", results);
+    ROS_INFO("Wrote results to %s.csv and %s.json", output_prefix.c_str(), output_prefix.c_str());
+
+    if (!save_baseline_path.empty()) {
+        WriteBaseline(save_baseline_path, results);
+        ROS_INFO("Wrote baseline to %s", save_baseline_path.c_str());
+    }
+
+    if (!baseline_path.empty()) {
+        auto regressions = CompareWithBaseline(
+                baseline,
+                results,
+                regression_tolerance,
+                bootstrap_resamples,
+                confidence,
+                output_prefix + "_comparison.csv");
+        ROS_INFO("Wrote comparison to %s_comparison.csv", output_prefix.c_str());
+        if (regressions > 0) {
+            ROS_ERROR("%d metrics regressed against baseline %s", regressions, baseline_path.c_str());
+            return 2;
+        }
+    }
+
+    return 0;
+}
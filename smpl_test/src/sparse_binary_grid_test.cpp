@@ -1,4 +1,6 @@
+#include <array>
 #include <iostream>
+#include <vector>
 
 #define BOOST_TEST_MODULE BinaryGridTest
 #define BOOST_TEST_DYN_LINK
@@ -304,4 +306,71 @@ BOOST_AUTO_TEST_CASE(ResizeTest)
     BOOST_CHECK_EQUAL(g.max_depth(), 2);
 }
 
+BOOST_AUTO_TEST_CASE(SetCellsTest)
+{
+    smpl::SparseBinaryGrid<> g(16, 16, 16, false);
+    std::vector<std::array<int, 3>> cells = {
+        {{ 0, 0, 0 }}, {{ 1, 0, 0 }}, {{ 15, 15, 15 }}
+    };
+    g.set_cells(cells.begin(), cells.end(), true);
+
+    BOOST_CHECK_EQUAL(g.get(0, 0, 0), true);
+    BOOST_CHECK_EQUAL(g.get(1, 0, 0), true);
+    BOOST_CHECK_EQUAL(g.get(15, 15, 15), true);
+    BOOST_CHECK_EQUAL(g.count(0, 0, 0, 16, 16, 16), 3);
+}
+
+BOOST_AUTO_TEST_CASE(SetOperationsTest)
+{
+    smpl::SparseBinaryGrid<> a(16, 16, 16, false);
+    smpl::SparseBinaryGrid<> b(16, 16, 16, false);
+    for (int x = 0; x < 8; ++x) {
+    for (int y = 0; y < 16; ++y) {
+    for (int z = 0; z < 16; ++z) {
+        a.set(x, y, z, true);
+        b.set(x + 5, y, z, true);
+    }
+    }
+    }
+
+    smpl::SparseBinaryGrid<> u(a);
+    u.set_union(b);
+    BOOST_CHECK_EQUAL(u.count(0, 0, 0, 16, 16, 16), 13 * 16 * 16);
+
+    smpl::SparseBinaryGrid<> i(a);
+    i.set_intersection(b);
+    BOOST_CHECK_EQUAL(i.count(0, 0, 0, 16, 16, 16), 3 * 16 * 16);
+    BOOST_CHECK_EQUAL(i.get(4, 0, 0), false);
+    BOOST_CHECK_EQUAL(i.get(5, 0, 0), true);
+
+    smpl::SparseBinaryGrid<> d(a);
+    d.set_difference(a);
+    BOOST_CHECK_EQUAL(d.count(0, 0, 0, 16, 16, 16), 0);
+    BOOST_CHECK_EQUAL(d.tree().num_leaves(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(CountBoxTest)
+{
+    smpl::SparseBinaryGrid<> g(16, 16, 16, true);
+    BOOST_CHECK_EQUAL(g.count(1, 2, 3, 4, 6, 9), 3 * 4 * 6);
+    BOOST_CHECK_EQUAL(g.count(-4, -4, -4, 20, 20, 20), 16 * 16 * 16);
+
+    g.set(2, 3, 4, false);
+    BOOST_CHECK_EQUAL(g.count(1, 2, 3, 4, 6, 9), 3 * 4 * 6 - 1);
+}
+
+BOOST_AUTO_TEST_CASE(FindFirstTest)
+{
+    smpl::SparseBinaryGrid<> g(16, 16, 16, false);
+    int x, y, z;
+    BOOST_CHECK(!g.find_first(0, 0, 0, 16, 16, 16, x, y, z));
+
+    g.set(9, 3, 12, true);
+    BOOST_CHECK(!g.find_first(0, 0, 0, 9, 16, 16, x, y, z));
+    BOOST_CHECK(g.find_first(8, 2, 10, 12, 4, 13, x, y, z));
+    BOOST_CHECK_EQUAL(x, 9);
+    BOOST_CHECK_EQUAL(y, 3);
+    BOOST_CHECK_EQUAL(z, 12);
+}
+
 // TODO: Test throwing constructor/destructor
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 #include <unordered_map>
 
@@ -355,4 +356,69 @@ BOOST_AUTO_TEST_CASE(ResizeTest)
     BOOST_CHECK_EQUAL(g.max_depth(), 3);
 }
 
+BOOST_AUTO_TEST_CASE(BlockTest)
+{
+    const int bs = smpl::SparseGrid<int>::block_size;
+    smpl::SparseGrid<int> g(64, 64, 64, 0);
+    smpl::SparseGrid<int> expected(64, 64, 64, 0);
+
+    // a block that is uniform except for one octant and one cell
+    std::vector<int> values(bs * bs * bs, 5);
+    for (int x = 0; x < bs; ++x) {
+    for (int y = 0; y < bs; ++y) {
+    for (int z = 0; z < bs; ++z) {
+        auto& v = values[(x * bs + y) * bs + z];
+        if (x >= 4 && y < 4 && z >= 4) {
+            v = 7;
+        }
+        if (x == 1 && y == 2 && z == 3) {
+            v = 9;
+        }
+        expected.set(16 + x, 8 + y, 24 + z, v);
+    }
+    }
+    }
+
+    g.set_block(16, 8, 24, values.data());
+    BOOST_CHECK_EQUAL(g.tree().num_nodes(), expected.tree().num_nodes());
+    BOOST_CHECK_EQUAL(g.tree().num_leaves(), expected.tree().num_leaves());
+
+    std::vector<int> out(bs * bs * bs);
+    g.get_block(16, 8, 24, out.data());
+    BOOST_CHECK(out == values);
+
+    g.get_block(0, 0, 0, out.data());
+    BOOST_CHECK(std::all_of(begin(out), end(out), [](int v) { return v == 0; }));
+
+    // overwriting with a uniform block collapses the tree
+    std::fill(begin(values), end(values), 0);
+    g.set_block(16, 8, 24, values.data());
+    BOOST_CHECK_EQUAL(g.tree().num_nodes(), 1);
+    BOOST_CHECK_EQUAL(g.get(17, 10, 27), 0);
+}
+
+BOOST_AUTO_TEST_CASE(LeafIteratorTest)
+{
+    smpl::SparseGrid<int> g(16, 16, 16, 0);
+    g.set(0, 0, 0, 1);
+    g.set(15, 3, 8, 2);
+
+    std::size_t count = 0;
+    std::size_t volume = 0;
+    for (auto it = g.leaves().first; it != g.leaves().second; ++it) {
+        for (std::size_t x = it->x; x < it->x + it->size; ++x) {
+        for (std::size_t y = it->y; y < it->y + it->size; ++y) {
+        for (std::size_t z = it->z; z < it->z + it->size; ++z) {
+            BOOST_CHECK_EQUAL(g.get(x, y, z), *it->value);
+        }
+        }
+        }
+        volume += it->size * it->size * it->size;
+        ++count;
+    }
+
+    BOOST_CHECK_EQUAL(count, g.tree().num_leaves());
+    BOOST_CHECK_EQUAL(volume, 16 * 16 * 16);
+}
+
 // TODO: Test throwing constructor/destructor
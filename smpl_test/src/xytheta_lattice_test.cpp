@@ -0,0 +1,295 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/// \author Andrew Dornbush
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE XYThetaLatticeTest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <smpl/collision_checker.h>
+#include <smpl/occupancy_grid.h>
+#include <smpl/robot_model.h>
+#include <smpl/graph/xytheta_lattice.h>
+#include <smpl/heuristic/dubins_heuristic.h>
+#include <smpl/steer/swept_footprint.h>
+#include <smpl/steer/steer.h>
+
+class BaseModel : public smpl::RobotModel
+{
+public:
+
+    BaseModel() { setPlanningJoints({ "x", "y", "theta" }); }
+
+    double minPosLimit(int jidx) const override { return 0.0; }
+    double maxPosLimit(int jidx) const override { return 0.0; }
+    bool hasPosLimit(int jidx) const override { return false; }
+    bool isContinuous(int jidx) const override { return jidx == 2; }
+    double velLimit(int jidx) const override { return 0.0; }
+    double accLimit(int jidx) const override { return 0.0; }
+
+    bool checkJointLimits(const smpl::RobotState&, bool) override { return true; }
+
+    Extension* getExtension(size_t class_code) override
+    {
+        return class_code == smpl::GetClassCode<smpl::RobotModel>() ? this : nullptr;
+    }
+};
+
+class NullChecker : public smpl::CollisionChecker
+{
+public:
+
+    Extension* getExtension(size_t class_code) override { return nullptr; }
+
+    bool isStateValid(const smpl::RobotState&, bool) override { return true; }
+
+    bool isStateToStateValid(
+        const smpl::RobotState&, const smpl::RobotState&, bool) override
+    { return true; }
+
+    bool interpolatePath(
+        const smpl::RobotState&, const smpl::RobotState&,
+        std::vector<smpl::RobotState>&) override
+    { return true; }
+};
+
+struct LatticeFixture
+{
+    smpl::OccupancyGrid grid;
+    BaseModel model;
+    NullChecker checker;
+    smpl::XYThetaLattice space;
+    smpl::XYThetaLattice::Params params;
+
+    LatticeFixture() : grid(10.0, 10.0, 0.5, 0.1, 0.0, 0.0, 0.0, 0.5, false)
+    {
+        params.turning_radius = 0.5;
+        params.long_primitive_cells = 6;
+        params.backward_cost_mult = 2.0;
+        params.turn_in_place_cost = 500;
+        params.footprint = { { 0.2, 0.1 }, { -0.2, 0.1 }, { -0.2, -0.1 }, { 0.2, -0.1 } };
+        params.height = 0.25;
+    }
+};
+
+BOOST_FIXTURE_TEST_CASE(PrimitiveTableTest, LatticeFixture)
+{
+    BOOST_REQUIRE(space.init(&model, &checker, &grid, params));
+
+    auto res = grid.resolution();
+    for (int h = 0; h < space.numHeadings(); ++h) {
+        BOOST_CHECK(!space.primitives(h).empty());
+        for (auto& prim : space.primitives(h)) {
+            BOOST_CHECK_EQUAL(prim.start_heading, h);
+            BOOST_REQUIRE(!prim.poses.empty());
+
+            // the last pose is exactly the lattice pose the primitive ends at
+            auto& end = prim.poses.back();
+            BOOST_CHECK_CLOSE_FRACTION(end.x + 1.0, prim.dx * res + 1.0, 1e-9);
+            BOOST_CHECK_CLOSE_FRACTION(end.y + 1.0, prim.dy * res + 1.0, 1e-9);
+            BOOST_CHECK_CLOSE_FRACTION(end.theta + 1.0, space.headingAngle(prim.end_heading) + 1.0, 1e-9);
+            BOOST_CHECK_GT(prim.cost, 0);
+
+            // the swept cells cover the footprint at both ends
+            for (auto& cell : space.footprintCells(h)) {
+                BOOST_CHECK(std::binary_search(prim.cells.begin(), prim.cells.end(), cell));
+            }
+            for (auto& cell : space.footprintCells(prim.end_heading)) {
+                auto shifted = std::make_pair(cell.first + prim.dx, cell.second + prim.dy);
+                BOOST_CHECK(std::binary_search(prim.cells.begin(), prim.cells.end(), shifted));
+            }
+        }
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(SweptCellLookupTest, LatticeFixture)
+{
+    BOOST_REQUIRE(space.init(&model, &checker, &grid, params));
+
+    smpl::GoalConstraint goal;
+    goal.type = smpl::GoalType::JOINT_STATE_GOAL;
+    goal.angles = { 9.0, 9.0, 0.0 };
+    goal.angle_tolerances = { 0.05, 0.05, 0.05 };
+    BOOST_REQUIRE(space.setGoal(goal));
+    BOOST_REQUIRE(space.setStart({ 5.0, 5.0, 0.0 }));
+
+    std::vector<int> succs, costs;
+    space.GetSuccs(space.getStartStateID(), &succs, &costs);
+    auto free_count = succs.size();
+    BOOST_CHECK_EQUAL(free_count, space.primitives(0).size());
+
+    // a wall just ahead of the robot blocks the forward primitives
+    std::vector<Eigen::Vector3d> points;
+    for (auto y = 4.0; y < 6.0; y += 0.05) {
+        for (auto z = 0.0; z < 0.5; z += 0.05) {
+            points.emplace_back(5.45, y, z);
+        }
+    }
+    grid.addPointsToField(points);
+    space.updateOccupancySlice();
+
+    succs.clear();
+    costs.clear();
+    space.GetSuccs(space.getStartStateID(), &succs, &costs);
+    BOOST_CHECK_LT(succs.size(), free_count);
+    BOOST_CHECK_GT(succs.size(), 0);
+
+    // exactly the primitives that sweep the wall column are blocked
+    int sx, sy, wx, wy, wz;
+    grid.worldToGrid(5.0, 5.0, 0.25, sx, sy, wz);
+    grid.worldToGrid(5.45, 5.0, 0.25, wx, wy, wz);
+    for (auto& prim : space.primitives(0)) {
+        auto blocked = !space.cellsFree(sx, sy, prim.cells);
+        auto sweeps_wall = std::any_of(prim.cells.begin(), prim.cells.end(),
+                [&](const std::pair<int, int>& cell) {
+                    return sx + cell.first == wx && std::abs(sy + cell.second - wy) < 10;
+                });
+        BOOST_CHECK_EQUAL(blocked, sweeps_wall);
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(OccupancySliceTest, LatticeFixture)
+{
+    BOOST_REQUIRE(space.init(&model, &checker, &grid, params));
+
+    std::default_random_engine rng(1);
+    std::uniform_real_distribution<double> coord(0.0, 10.0);
+    std::vector<Eigen::Vector3d> points;
+    for (int i = 0; i < 300; ++i) {
+        points.emplace_back(coord(rng), coord(rng), 0.25);
+    }
+    grid.addPointsToField(points);
+    space.updateOccupancySlice();
+
+    // the bitmap test agrees with the cell-by-cell test everywhere, including
+    // near and beyond the grid boundary
+    std::uniform_int_distribution<int> cell(-5, grid.numCellsX() + 5);
+    for (int i = 0; i < 2000; ++i) {
+        auto x = cell(rng);
+        auto y = cell(rng);
+        for (int h = 0; h < space.numHeadings(); ++h) {
+            for (auto& prim : space.primitives(h)) {
+                BOOST_CHECK_EQUAL(
+                        space.sweptFree(x, y, prim.swept),
+                        space.cellsFree(x, y, prim.cells));
+            }
+        }
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(BodyVelocityPrimitiveTest, LatticeFixture)
+{
+    // an omnidirectional base driving sideways and diagonally
+    auto fws = smpl::MakeFourWheelSteerModel(0.2, 0.2, 0.0, 0.05);
+    smpl::FourWheelSteerState state;
+    state.vtheta = 0.0;
+    for (int i = 0; i < 4; ++i) {
+        state.st[i] = 0.5 * M_PI;
+        state.sr[i] = 0.5 / fws.r;
+        state.vst[i] = 0.0;
+    }
+    double vx, vy, vtheta;
+    smpl::WheelToBody(&fws, &state, &vx, &vy, &vtheta);
+    BOOST_REQUIRE_SMALL(vx, 1e-9);
+    BOOST_REQUIRE_CLOSE(vy, 0.5, 1e-6);
+
+    params.backward_cost_mult = 0.0;
+    params.turn_in_place_cost = 0;
+    params.body_velocities = { { vx, vy, vtheta }, { 0.3, 0.3, 0.0 } };
+    params.body_velocity_duration = 1.0;
+    BOOST_REQUIRE(space.init(&model, &checker, &grid, params));
+
+    auto res = grid.resolution();
+    for (int h = 0; h < space.numHeadings(); ++h) {
+        auto& prims = space.primitives(h);
+        BOOST_REQUIRE_GE(prims.size(), 2);
+        auto& side = prims[prims.size() - 2];
+        auto theta = space.headingAngle(h);
+
+        // 0.5 m to the left of the heading, without turning
+        BOOST_CHECK_EQUAL(side.end_heading, h);
+        BOOST_CHECK_EQUAL(side.dx, (int)std::round(-0.5 * std::sin(theta) / res));
+        BOOST_CHECK_EQUAL(side.dy, (int)std::round(0.5 * std::cos(theta) / res));
+        BOOST_CHECK_CLOSE_FRACTION(side.poses.back().x + 1.0, side.dx * res + 1.0, 1e-9);
+        BOOST_CHECK_CLOSE_FRACTION(side.poses.back().y + 1.0, side.dy * res + 1.0, 1e-9);
+        for (auto& cell : space.footprintCells(h)) {
+            BOOST_CHECK(std::binary_search(side.cells.begin(), side.cells.end(), cell));
+        }
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(DubinsHeuristicTest, LatticeFixture)
+{
+    params.backward_cost_mult = 0.0;
+    params.turn_in_place_cost = 0;
+    BOOST_REQUIRE(space.init(&model, &checker, &grid, params));
+
+    smpl::GoalConstraint goal;
+    goal.type = smpl::GoalType::JOINT_STATE_GOAL;
+    goal.angles = { 8.0, 3.0, 0.5 * M_PI };
+    goal.angle_tolerances = { 0.05, 0.05, 0.05 };
+    BOOST_REQUIRE(space.setGoal(goal));
+    BOOST_REQUIRE(space.setStart({ 2.0, 5.0, 0.0 }));
+
+    smpl::DubinsHeuristic h;
+    BOOST_REQUIRE(h.init(&space));
+    h.setTurningRadius(params.turning_radius);
+
+    std::vector<int> succs, costs;
+    space.GetSuccs(space.getStartStateID(), &succs, &costs);
+    BOOST_REQUIRE(!succs.empty());
+
+    // the batched evaluation agrees with the per-state evaluation
+    std::vector<int> values(succs.size());
+    h.getGoalHeuristics(succs.data(), succs.size(), values.data());
+    for (size_t i = 0; i < succs.size(); ++i) {
+        BOOST_CHECK_EQUAL(values[i], h.GetGoalHeuristic(succs[i]));
+    }
+
+    // forward-only primitives follow Dubins curves with the same turning
+    // radius, so the heuristic is consistent across them
+    auto hs = h.GetGoalHeuristic(space.getStartStateID());
+    for (size_t i = 0; i < succs.size(); ++i) {
+        BOOST_CHECK_LE(hs, costs[i] + h.GetGoalHeuristic(succs[i]) + 1);
+    }
+
+    // the lookup table, sampled at the lattice resolution, reproduces the
+    // exact values for lattice-aligned states up to float rounding
+    BOOST_REQUIRE(h.setLookupTable(8.0, grid.resolution(), space.numHeadings()));
+    std::vector<int> table_values(succs.size());
+    h.getGoalHeuristics(succs.data(), succs.size(), table_values.data());
+    for (size_t i = 0; i < succs.size(); ++i) {
+        BOOST_CHECK_LE(std::abs(table_values[i] - values[i]), 1);
+    }
+}
@@ -3,8 +3,11 @@
 
 // standard includes
 #include <cstddef>
+#include <string>
+#include <vector>
 
 // system includes
+#include <Eigen/StdVector>
 #include <smpl/spatial.h>
 
 // project includes
@@ -224,6 +227,34 @@ struct JointVariable
     Joint* joint = NULL;
 };
 
+// A joint flattened for forward kinematics. The joints of a model are compiled
+// into an array sorted so that each joint follows the joint of its parent
+// link, so all link transforms can be computed in one linear pass. Since the
+// order is depth-first, the descendants of each joint occupy a contiguous
+// range of the array directly after it.
+struct FKJoint
+{
+    Affine3 origin;
+    Vector3 axis;
+    JointType type;
+
+    // index of the principal axis the joint axis lies along (with sign
+    // axis_sign), or -1
+    int axis_index = -1;
+    double axis_sign = 1.0;
+
+    int joint = -1;             // index of the joint in the model
+    int parent_link = -1;       // index of the parent link, or -1 for the root
+    int child_link = -1;        // index of the child link
+    int first_variable = 0;     // index of the joint's first variable
+    int subtree_end = 0;        // one past the last descendant in fk order
+
+    int collision_begin = 0;    // collision bodies of the child link
+    int collision_end = 0;
+    int visual_begin = 0;       // visual bodies of the child link
+    int visual_end = 0;
+};
+
 // A robot is described as a set of links, rigid bodies in space, constrained
 // to one another by joints, which specify the allowable relative motion between
 // them. The position of each joint is parameterized by one or more variables
@@ -250,6 +281,9 @@ struct RobotModel
 
     std::vector<const Joint*> ancestor_map;
 
+    std::vector<FKJoint, Eigen::aligned_allocator<FKJoint>> fk_joints;
+    std::vector<int> fk_order; // position in fk_joints of each joint
+
     // self-references => non-copyable
     RobotModel() = default;
     RobotModel(const RobotModel&) = delete;
@@ -147,6 +147,18 @@ bool IsCollisionBodyTransformDirty(const RobotState* state, const LinkCollision*
 bool IsVisualBodyTransformDirty(const RobotState* state, const LinkVisual* visual);
 bool IsDirty(const RobotState* state);
 
+// A range [begin, end) of joints, in forward kinematics order. Setting a
+// variable marks the subtree of its joint, which is contiguous in that order,
+// so the joints that need updating are always covered by a single range.
+struct DirtyRange
+{
+    int begin = 0;
+    int end = 0;
+
+    bool empty() const { return begin >= end; }
+    bool contains(int i) const { return begin <= i && i < end; }
+};
+
 struct RobotState
 {
     const RobotModel*       model = NULL;
@@ -162,9 +174,11 @@ struct RobotState
     Affine3*                link_collision_transforms = NULL;
     Affine3*                link_visual_transforms = NULL;
 
-    const Joint*            dirty_links_joint = NULL;
-    const Joint*            dirty_collisions_joint = NULL;
-    const Joint*            dirty_visuals_joint = NULL;
+    // ranges of RobotModel::fk_joints whose link, collision body, and visual
+    // body transforms are out of date
+    DirtyRange              dirty_links;
+    DirtyRange              dirty_collisions;
+    DirtyRange              dirty_visuals;
 
     // self-references => non-copyable
     RobotState() = default;
@@ -32,11 +32,18 @@ struct URDFRobotModel :
     RobotState robot_state;
 
     std::vector<VariableProperties> vprops;
+
+    // limits checked by checkJointLimits, infinite for unbounded variables
+    std::vector<double> check_min_positions;
+    std::vector<double> check_max_positions;
     std::vector<int> planning_to_state_variable;
     const Link* planning_link = NULL;
 
     auto computeFK(const smpl::RobotState& state)
         -> Eigen::Affine3d override;
+    auto computeFK(smpl::RobotStateView state)
+        -> Eigen::Affine3d override;
+    void computeFKBatch(const double* states, int n, Eigen::Affine3d* poses) override;
 
     double minPosLimit(int jidx) const override;
     double maxPosLimit(int jidx) const override;
@@ -47,6 +54,9 @@ struct URDFRobotModel :
     bool checkJointLimits(
         const smpl::RobotState& state,
         bool verbose = false) override;
+    bool checkJointLimits(
+        smpl::RobotStateView state,
+        bool verbose = false) override;
 
     auto getExtension(size_t class_code) -> smpl::Extension* override;
 };
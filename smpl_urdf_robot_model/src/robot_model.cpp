@@ -1,5 +1,9 @@
 #include <smpl_urdf_robot_model/robot_model.h>
 
+// standard includes
+#include <math.h>
+#include <algorithm>
+
 #include <urdf_model/model.h>
 
 namespace smpl {
@@ -75,6 +79,67 @@ void AddFloatingJointVariables(
     variables->push_back(v);
 }
 
+// Flatten the kinematic tree into an array of joints in depth-first order from
+// the root joint, with everything needed to compute each link transform from
+// its parent's.
+static
+void CompileFKJoints(RobotModel* model)
+{
+    model->fk_joints.clear();
+    model->fk_joints.reserve(model->joints.size());
+    model->fk_order.assign(model->joints.size(), -1);
+
+    std::vector<const Joint*> q;
+    q.push_back(model->root_joint);
+    while (!q.empty()) {
+        auto* joint = q.back();
+        q.pop_back();
+
+        FKJoint fj;
+        fj.origin = joint->origin;
+        fj.axis = joint->axis;
+        fj.type = joint->type;
+        for (int i = 0; i < 3; ++i) {
+            auto j = (i + 1) % 3;
+            auto k = (i + 2) % 3;
+            if (fj.axis[j] == 0.0 && fj.axis[k] == 0.0 && fabs(fj.axis[i]) == 1.0) {
+                fj.axis_index = i;
+                fj.axis_sign = fj.axis[i];
+            }
+        }
+        fj.joint = (int)GetJointIndex(model, joint);
+        fj.parent_link = joint->parent != NULL ? (int)GetLinkIndex(model, joint->parent) : -1;
+        fj.child_link = (int)GetLinkIndex(model, joint->child);
+        fj.first_variable = (int)(joint->vfirst - model->variables.data());
+        fj.collision_begin = (int)(joint->child->collision.p.first - model->collisions.data());
+        fj.collision_end = (int)(joint->child->collision.p.second - model->collisions.data());
+        fj.visual_begin = (int)(joint->child->visual.p.first - model->visuals.data());
+        fj.visual_end = (int)(joint->child->visual.p.second - model->visuals.data());
+
+        model->fk_order[fj.joint] = (int)model->fk_joints.size();
+        model->fk_joints.push_back(fj);
+
+        for (auto* child = joint->child->children; child != NULL; child = child->sibling) {
+            q.push_back(child);
+        }
+    }
+
+    // with a pre-order traversal, the subtree of a joint ends where the next
+    // joint that is not its descendant begins; walk backwards, extending each
+    // joint's subtree by those of its children
+    for (auto& fj : model->fk_joints) {
+        fj.subtree_end = (int)(&fj - model->fk_joints.data()) + 1;
+    }
+    for (auto i = (int)model->fk_joints.size() - 1; i > 0; --i) {
+        auto& fj = model->fk_joints[i];
+        if (fj.parent_link < 0) continue;
+        auto* parent_joint = model->links[fj.parent_link].parent;
+        if (parent_joint == NULL) continue;
+        auto& pj = model->fk_joints[model->fk_order[GetJointIndex(model, parent_joint)]];
+        pj.subtree_end = std::max(pj.subtree_end, fj.subtree_end);
+    }
+}
+
 bool InitRobotModel(
     RobotModel* out,
     const ::urdf::ModelInterface* urdf,
@@ -523,6 +588,8 @@ bool InitRobotModel(
         }
     }
 
+    CompileFKJoints(&robot_model);
+
     *out = std::move(robot_model);
     return true;
 }
@@ -13,16 +13,41 @@
 namespace smpl {
 namespace urdf {
 
+// Nearly every revolute joint rotates about a principal axis of its frame, in
+// which case the rotation matrix is written out directly rather than going
+// through the general angle-axis conversion. The axis is classified once,
+// when the model is compiled.
 static
-Affine3 ComputeJointTransform(const Joint* joint, const double* variables)
+Affine3 ComputeRevoluteJointTransform(const FKJoint& joint, double angle)
 {
-    switch (joint->type) {
+    auto idx = joint.axis_index;
+    if (idx < 0) {
+        return Affine3(AngleAxis(angle, joint.axis));
+    }
+
+    auto c = cos(angle);
+    auto s = joint.axis_sign * sin(angle);
+
+    Affine3 t(Affine3::Identity());
+    auto i = (idx + 1) % 3;
+    auto j = (idx + 2) % 3;
+    t(i, i) = c;
+    t(i, j) = -s;
+    t(j, i) = s;
+    t(j, j) = c;
+    return t;
+}
+
+static
+Affine3 ComputeJointTransform(const FKJoint& joint, const double* variables)
+{
+    switch (joint.type) {
     case JointType::Fixed:
         return Affine3::Identity();
     case JointType::Revolute:
-        return Affine3(AngleAxis(variables[0], joint->axis));
+        return ComputeRevoluteJointTransform(joint, variables[0]);
     case JointType::Prismatic:
-        return Affine3(Translation3(variables[0] * joint->axis));
+        return Affine3(Translation3(variables[0] * joint.axis));
     case JointType::Planar:
         return Translation3(variables[0], variables[1], 0.0) *
                 AngleAxis(variables[2], Vector3::UnitZ());
@@ -31,9 +56,36 @@ Affine3 ComputeJointTransform(const Joint* joint, const double* variables)
                 Quaternion(variables[6], variables[3], variables[4], variables[5]);
     default:
         assert(0);
+        return Affine3::Identity();
     }
 }
 
+// Extend a dirty range to cover the subtree of a joint.
+static
+void MarkDirty(DirtyRange* range, const FKJoint& joint, int index)
+{
+    if (range->empty()) {
+        range->begin = index;
+        range->end = joint.subtree_end;
+    } else {
+        range->begin = std::min(range->begin, index);
+        range->end = std::max(range->end, joint.subtree_end);
+    }
+}
+
+static
+bool Intersects(const DirtyRange& a, const DirtyRange& b)
+{
+    return !a.empty() && !b.empty() && a.begin < b.end && b.begin < a.end;
+}
+
+// Return the position, in forward kinematics order, of the joint of a link.
+static
+int GetFKIndex(const RobotModel* model, const Link* link)
+{
+    return model->fk_order[GetJointIndex(model, link->parent)];
+}
+
 static
 void GetTransformVariables(
     const Joint* joint,
@@ -135,9 +187,12 @@ bool InitRobotState(
     out->link_collision_transforms = out->joint_transforms + GetJointCount(model);
     out->link_visual_transforms = out->link_collision_transforms + GetCollisionBodyCount(model);
 
-    out->dirty_links_joint = model->root_joint;
-    out->dirty_collisions_joint = model->root_joint;
-    out->dirty_visuals_joint = model->root_joint;
+    DirtyRange all;
+    all.begin = 0;
+    all.end = (int)model->fk_joints.size();
+    out->dirty_links = all;
+    out->dirty_collisions = all;
+    out->dirty_visuals = all;
 
     return true;
 }
@@ -155,10 +210,6 @@ void SetToDefaultValues(RobotState* state)
     }
 }
 
-// Avoid setting all per-joint descendant bodies as dirty here => flag the
-// most descendant dirty joint.
-// Remove dependency on link transform for collision bodies and visual bodies.
-// 3 dirty joints...for collision bodies, visual bodies, and links.
 void SetVariablePositions(RobotState* state, const double* positions)
 {
     for (int i = 0; i < GetVariableCount(state->model); ++i) {
@@ -187,22 +238,12 @@ void SetVariablePosition(
 
         auto* v = GetVariable(state->model, index);
         auto* vj = GetJointOfVariable(v);
+        auto fi = state->model->fk_order[GetJointIndex(state->model, vj)];
+        auto& fj = state->model->fk_joints[fi];
 
-        if (state->dirty_links_joint == NULL) {
-            state->dirty_links_joint = vj;
-        } else {
-            state->dirty_links_joint = GetCommonRoot(state->model, state->dirty_links_joint, vj);
-        }
-        if (state->dirty_collisions_joint == NULL) {
-            state->dirty_collisions_joint = vj;
-        } else {
-            state->dirty_collisions_joint = GetCommonRoot(state->model, state->dirty_collisions_joint, vj);
-        }
-        if (state->dirty_visuals_joint == NULL) {
-            state->dirty_visuals_joint = vj;
-        } else {
-            state->dirty_visuals_joint = GetCommonRoot(state->model, state->dirty_visuals_joint, vj);
-        }
+        MarkDirty(&state->dirty_links, fj, fi);
+        MarkDirty(&state->dirty_collisions, fj, fi);
+        MarkDirty(&state->dirty_visuals, fj, fi);
     }
 }
 
@@ -414,130 +455,96 @@ auto GetJointAccelerations(const RobotState* state, int index) -> const double*
 
 /////////////////////////// DANGER ZONE ///////////////////////////
 
+// Recompute the joint and link transforms of the dirty joints in one pass
+// over the compiled joints. Each joint's parent link precedes it, so its
+// transform is already up to date.
 static
-void UpdateLinkTransforms(RobotState* state, std::vector<const Joint*>* q)
+void UpdateOnlyLinkTransforms(RobotState* state)
 {
-    assert(state->dirty_links_joint != NULL);
-
-    q->push_back(state->dirty_links_joint);
-
-    while (!q->empty()) {
-        auto* joint = q->back();
-        q->pop_back();
+    assert(!state->dirty_links.empty());
 
-        auto* child_link = joint->child;
+    auto* fk_joints = state->model->fk_joints.data();
+    for (auto i = state->dirty_links.begin; i != state->dirty_links.end; ++i) {
+        auto& joint = fk_joints[i];
 
-        // update the joint transform
-        auto& joint_transform =
-                state->joint_transforms[GetJointIndex(state->model, joint)];
-        joint_transform =
-                ComputeJointTransform(joint, GetJointPositions(state, joint));
+        auto& joint_transform = state->joint_transforms[joint.joint];
+        joint_transform = ComputeJointTransform(
+                joint, state->positions + joint.first_variable);
 
-        // update the child link transform
-        auto& link_transform =
-                state->link_transforms[GetLinkIndex(state->model, child_link)];
-        if (joint->parent != NULL) {
-            // parent_link * origin * joint transform
-            auto& parent_transform =
-                    state->link_transforms[
-                            GetLinkIndex(state->model, joint->parent)];
-            link_transform = parent_transform * joint->origin * joint_transform;
+        // parent_link * origin * joint transform
+        auto& link_transform = state->link_transforms[joint.child_link];
+        if (joint.parent_link >= 0) {
+            link_transform = state->link_transforms[joint.parent_link] *
+                    joint.origin * joint_transform;
         } else {
-            link_transform = joint->origin * joint_transform;
-        }
-
-        // recurse on children
-        for (auto* child = child_link->children; child != NULL; child = child->sibling) {
-            q->push_back(child);
+            link_transform = joint.origin * joint_transform;
         }
     }
 
-    state->dirty_links_joint = NULL;
+    state->dirty_links = DirtyRange();
 }
 
 static
-void UpdateOnlyCollisionBodyTransforms(
-    RobotState* state,
-    std::vector<const Joint*>* q)
-{
-    assert(state->dirty_collisions_joint != NULL);
-    q->push_back(state->dirty_collisions_joint);
-    while (!q->empty()) {
-        auto* joint = q->back();
-        q->pop_back();
-
-        auto* child_link = joint->child;
-
-        auto& link_transform =
-                state->link_transforms[GetLinkIndex(state->model, child_link)];
-        for (auto& collision : CollisionBodies(child_link)) {
-            auto& collision_transform =
-                    state->link_collision_transforms[
-                            GetCollisionBodyIndex(state->model, &collision)];
-            collision_transform = link_transform * collision.origin;
-        }
-        for (auto* child = child_link->children; child != NULL; child = child->sibling) {
-            q->push_back(child);
+void UpdateOnlyCollisionBodyTransforms(RobotState* state)
+{
+    assert(!state->dirty_collisions.empty());
+
+    auto* fk_joints = state->model->fk_joints.data();
+    auto* collisions = state->model->collisions.data();
+    for (auto i = state->dirty_collisions.begin; i != state->dirty_collisions.end; ++i) {
+        auto& joint = fk_joints[i];
+        auto& link_transform = state->link_transforms[joint.child_link];
+        for (auto c = joint.collision_begin; c != joint.collision_end; ++c) {
+            state->link_collision_transforms[c] =
+                    link_transform * collisions[c].origin;
         }
     }
-    state->dirty_collisions_joint = NULL;
+
+    state->dirty_collisions = DirtyRange();
 }
 
 static
-void UpdateOnlyVisualBodyTransforms(
-    RobotState* state,
-    std::vector<const Joint*>* q)
-{
-    assert(state->dirty_visuals_joint != NULL);
-    q->push_back(state->dirty_visuals_joint);
-    while (!q->empty()) {
-        auto* joint = q->back();
-        q->pop_back();
-
-        auto* child_link = joint->child;
-
-        auto& link_transform =
-                state->link_transforms[GetLinkIndex(state->model, child_link)];
-        for (auto& visual : VisualBodies(child_link)) {
-            auto& visual_transform =
-                    state->link_visual_transforms[
-                            GetVisualBodyIndex(state->model, &visual)];
-            visual_transform = link_transform * visual.origin;
-        }
-        for (auto* child = child_link->children; child != NULL; child = child->sibling) {
-            q->push_back(child);
+void UpdateOnlyVisualBodyTransforms(RobotState* state)
+{
+    assert(!state->dirty_visuals.empty());
+
+    auto* fk_joints = state->model->fk_joints.data();
+    auto* visuals = state->model->visuals.data();
+    for (auto i = state->dirty_visuals.begin; i != state->dirty_visuals.end; ++i) {
+        auto& joint = fk_joints[i];
+        auto& link_transform = state->link_transforms[joint.child_link];
+        for (auto v = joint.visual_begin; v != joint.visual_end; ++v) {
+            state->link_visual_transforms[v] = link_transform * visuals[v].origin;
         }
     }
-    state->dirty_visuals_joint = NULL;
+
+    state->dirty_visuals = DirtyRange();
 }
 
 void UpdateTransforms(RobotState* state)
 {
-    std::vector<const Joint*> q;
-    if (state->dirty_links_joint != NULL) {
-        UpdateLinkTransforms(state, &q);
+    if (!state->dirty_links.empty()) {
+        UpdateOnlyLinkTransforms(state);
     }
-    if (state->dirty_collisions_joint != NULL) {
-        UpdateOnlyCollisionBodyTransforms(state, &q);
+    if (!state->dirty_collisions.empty()) {
+        UpdateOnlyCollisionBodyTransforms(state);
     }
-    if (state->dirty_visuals_joint != NULL) {
-        UpdateOnlyVisualBodyTransforms(state, &q);
+    if (!state->dirty_visuals.empty()) {
+        UpdateOnlyVisualBodyTransforms(state);
     }
 }
 
 void UpdateLinkTransforms(RobotState* state)
 {
-    if (state->dirty_links_joint != NULL) {
-        std::vector<const Joint*> q;
-        UpdateLinkTransforms(state, &q);
+    if (!state->dirty_links.empty()) {
+        UpdateOnlyLinkTransforms(state);
     }
 }
 
 void UpdateLinkTransform(RobotState* state, const Link* link)
 {
     if (IsLinkTransformDirty(state, link)) {
-        std::vector<const Joint*> q;
-        UpdateLinkTransforms(state, &q);
+        UpdateOnlyLinkTransforms(state);
     }
 }
 
@@ -548,18 +555,13 @@ void UpdateLinkTransform(RobotState* state, int index)
 
 void UpdateCollisionBodyTransforms(RobotState* state)
 {
-    if (state->dirty_collisions_joint != NULL) {
-        std::vector<const Joint*> q;
-        if (state->dirty_links_joint != NULL) {
-            // supertree or subtree => update
-            if (IsAncestor(state->model, state->dirty_collisions_joint, state->dirty_links_joint) |
-                IsAncestor(state->model, state->dirty_links_joint, state->dirty_collisions_joint))
-            {
-                UpdateLinkTransforms(state, &q);
-            }
-            // ...otherwise, sibling tree
+    if (!state->dirty_collisions.empty()) {
+        // the links of the dirty bodies must be up to date; links outside the
+        // range of dirty bodies do not matter
+        if (Intersects(state->dirty_links, state->dirty_collisions)) {
+            UpdateOnlyLinkTransforms(state);
         }
-        UpdateOnlyCollisionBodyTransforms(state, &q);
+        UpdateOnlyCollisionBodyTransforms(state);
     }
 }
 
@@ -568,11 +570,7 @@ void UpdateCollisionBodyTransform(
     const LinkCollision* collision)
 {
     if (IsCollisionBodyTransformDirty(state, collision)) {
-        std::vector<const Joint*> q;
-        if (IsLinkTransformDirty(state, collision->link)) {
-            UpdateLinkTransforms(state, &q);
-        }
-        UpdateOnlyCollisionBodyTransforms(state, &q);
+        UpdateCollisionBodyTransforms(state);
     }
 }
 
@@ -583,29 +581,18 @@ void UpdateCollisionBodyTransform(RobotState* state, int index)
 
 void UpdateVisualBodyTransforms(RobotState* state)
 {
-    if (state->dirty_visuals_joint != NULL) {
-        std::vector<const Joint*> q;
-        if (state->dirty_links_joint != NULL) {
-            // supertree or subtree => update
-            if (IsAncestor(state->model, state->dirty_visuals_joint, state->dirty_links_joint) |
-                IsAncestor(state->model, state->dirty_links_joint, state->dirty_visuals_joint))
-            {
-                UpdateLinkTransforms(state, &q);
-            }
-            // ...otherwise, sibling tree
+    if (!state->dirty_visuals.empty()) {
+        if (Intersects(state->dirty_links, state->dirty_visuals)) {
+            UpdateOnlyLinkTransforms(state);
         }
-        UpdateOnlyVisualBodyTransforms(state, &q);
+        UpdateOnlyVisualBodyTransforms(state);
     }
 }
 
 void UpdateVisualBodyTransform(RobotState* state, const LinkVisual* visual)
 {
     if (IsVisualBodyTransformDirty(state, visual)) {
-        std::vector<const Joint*> q;
-        if (IsLinkTransformDirty(state, visual->link)) {
-            UpdateLinkTransforms(state, &q);
-        }
-        UpdateOnlyVisualBodyTransforms(state, &q);
+        UpdateVisualBodyTransforms(state);
     }
 }
 
@@ -707,28 +694,24 @@ bool IsJointTransformDirty(const RobotState* state, const Joint* joint)
 
 bool IsLinkTransformDirty(const RobotState* state, const Link* link)
 {
-    return state->dirty_links_joint != NULL &&
-            IsAncestor(state->model, state->dirty_links_joint, link->parent);
+    return state->dirty_links.contains(GetFKIndex(state->model, link));
 }
 
 bool IsCollisionBodyTransformDirty(const RobotState* state, const LinkCollision* collision)
 {
-    // TODO: review
-    return state->dirty_collisions_joint != NULL &&
-            IsAncestor(state->model, state->dirty_collisions_joint, collision->link->parent);
+    return state->dirty_collisions.contains(GetFKIndex(state->model, collision->link));
 }
 
 bool IsVisualBodyTransformDirty(const RobotState* state, const LinkVisual* visual)
 {
-    return state->dirty_visuals_joint != NULL &&
-            IsAncestor(state->model, state->dirty_visuals_joint, visual->link->parent);
+    return state->dirty_visuals.contains(GetFKIndex(state->model, visual->link));
 }
 
 bool IsDirty(const RobotState* state)
 {
-    return state->dirty_links_joint != NULL |
-            state->dirty_visuals_joint != NULL |
-            state->dirty_collisions_joint != NULL;
+    return !state->dirty_links.empty() |
+            !state->dirty_visuals.empty() |
+            !state->dirty_collisions.empty();
 }
 
 } // namespace urdf
@@ -1,5 +1,11 @@
 #include <smpl_urdf_robot_model/urdf_robot_model.h>
 
+// standard includes
+#include <limits>
+
+// system includes
+#include <smpl/angles.h>
+
 // project includes
 #include <smpl_urdf_robot_model/robot_state_bounds.h>
 #include <smpl_urdf_robot_model/robot_model.h>
@@ -42,6 +48,10 @@ bool Init(
             props.acc_limit = limits->max_effort; // TODO: hmm...
             model->vprops.push_back(props);
 
+            auto inf = std::numeric_limits<double>::infinity();
+            model->check_min_positions.push_back(props.bounded ? props.min_position : -inf);
+            model->check_max_positions.push_back(props.bounded ? props.max_position : inf);
+
             // initialize mapping from planning group variable to state variable
             auto index = GetVariableIndex(robot_model, &variable);
             model->planning_to_state_variable.push_back(index);
@@ -82,7 +92,7 @@ void SetReferenceState(URDFRobotModel* model, const double* positions)
 }
 
 static
-void UpdateState(URDFRobotModel* model, const smpl::RobotState* state)
+void UpdateState(URDFRobotModel* model, const smpl::RobotStateView* state)
 {
     for (auto i = 0; i < model->jointVariableCount(); ++i) {
         SetVariablePosition(
@@ -94,12 +104,39 @@ void UpdateState(URDFRobotModel* model, const smpl::RobotState* state)
 
 auto URDFRobotModel::computeFK(const smpl::RobotState& state)
     -> Eigen::Affine3d
+{
+    return computeFK(smpl::RobotStateView(state));
+}
+
+auto URDFRobotModel::computeFK(smpl::RobotStateView state)
+    -> Eigen::Affine3d
 {
     UpdateState(this, &state);
     UpdateLinkTransform(&this->robot_state, this->planning_link);
     return *GetLinkTransform(&this->robot_state, this->planning_link);
 }
 
+void URDFRobotModel::computeFKBatch(
+    const double* states,
+    int n,
+    Eigen::Affine3d* poses)
+{
+    // write variables straight from the batch, avoiding a temporary
+    // smpl::RobotState per state
+    auto dim = (int)jointVariableCount();
+    for (auto i = 0; i < n; ++i) {
+        auto* state = states + i * dim;
+        for (auto j = 0; j < dim; ++j) {
+            SetVariablePosition(
+                    &this->robot_state,
+                    this->planning_to_state_variable[j],
+                    state[j]);
+        }
+        UpdateLinkTransform(&this->robot_state, this->planning_link);
+        poses[i] = *GetLinkTransform(&this->robot_state, this->planning_link);
+    }
+}
+
 double URDFRobotModel::minPosLimit(int jidx) const
 {
     return this->vprops[jidx].min_position;
@@ -134,13 +171,18 @@ bool URDFRobotModel::checkJointLimits(
     const smpl::RobotState& state,
     bool verbose)
 {
-    for (auto i = 0; i < this->jointVariableCount(); ++i) {
-        auto* var = GetVariable(this->robot_model, this->planning_to_state_variable[i]);
-        if (!SatisfiesBounds(&this->robot_state, var)) {
-            return false;
-        }
-    }
-    return true;
+    return checkJointLimits(smpl::RobotStateView(state), verbose);
+}
+
+bool URDFRobotModel::checkJointLimits(
+    smpl::RobotStateView state,
+    bool verbose)
+{
+    return smpl::within_limits(
+            state.data(),
+            this->check_min_positions.data(),
+            this->check_max_positions.data(),
+            this->jointVariableCount());
 }
 
 auto URDFRobotModel::getExtension(size_t class_code) -> smpl::Extension*